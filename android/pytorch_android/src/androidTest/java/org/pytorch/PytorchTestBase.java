@@ -4,6 +4,7 @@ import org.junit.Before;
 import org.junit.Test;
 
 import java.io.IOException;
+import java.nio.FloatBuffer;
 import java.util.HashMap;
 import java.util.Map;
 
@@ -108,6 +109,31 @@ public abstract class PytorchTestBase {
     }
   }
 
+  @Test
+  public void testEqTensorInto() throws IOException {
+    final long[] shape = new long[] {1, 3, 224, 224};
+    final int numElements = (int) Tensor.numel(shape);
+    final FloatBuffer inputBuffer = Tensor.allocateFloatBuffer(numElements);
+    for (int i = 0; i < numElements; ++i) {
+      inputBuffer.put(i, i);
+    }
+    final Tensor inputTensor = Tensor.fromBlob(inputBuffer, shape);
+    final Tensor outputTensor = Tensor.fromBlob(Tensor.allocateFloatBuffer(numElements), shape);
+
+    final Module module = Module.load(assetFilePath(TEST_MODULE_ASSET_NAME));
+    for (int run = 0; run < 2; run++) {
+      final Tensor result = module.runMethodInto("eqTensor", outputTensor, IValue.from(inputTensor));
+      assertTrue(outputTensor == result);
+      final float[] outputData = outputTensor.getDataAsFloatArray();
+      for (int i = 0; i < numElements; i++) {
+        assertTrue(inputBuffer.get(i) == outputData[i]);
+      }
+      for (int i = 0; i < numElements; ++i) {
+        inputBuffer.put(i, i + run + 1);
+      }
+    }
+  }
+
   @Test
   public void testEqDictIntKeyIntValue() throws IOException {
     final Module module = Module.load(assetFilePath(TEST_MODULE_ASSET_NAME));
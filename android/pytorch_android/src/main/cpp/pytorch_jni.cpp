@@ -153,16 +153,41 @@ class JTensor : public facebook::jni::JavaClass<JTensor> {
 
     jTensorShape->setRegion(0, tensorShapeVec.size(), tensorShapeVec.data());
 
+    // The storage of a view may be larger than the tensor or start before it.
+    const auto contiguousTensor = tensor.contiguous();
     facebook::jni::local_ref<facebook::jni::JByteBuffer> jTensorBuffer =
-        facebook::jni::JByteBuffer::allocateDirect(tensor.nbytes());
+        facebook::jni::JByteBuffer::allocateDirect(contiguousTensor.nbytes());
     jTensorBuffer->order(facebook::jni::JByteOrder::nativeOrder());
     std::memcpy(
         jTensorBuffer->getDirectBytes(),
-        tensor.storage().data(),
-        tensor.nbytes());
+        contiguousTensor.data_ptr(),
+        contiguousTensor.nbytes());
     return JTensor::newJTensor(jTensorBuffer, jTensorShape, jdtype);
   }
 
+  // Writes tensor into the direct buffer of jtensor, which must have its dtype
+  // and shape. Nothing is copied if tensor already is a view of that buffer.
+  static void copyAtTensorToJTensor(
+      const at::Tensor& tensor,
+      facebook::jni::alias_ref<JTensor> jtensor) {
+    auto jtensorAlias = newAtTensorFromJTensor(jtensor);
+    if (tensor.scalar_type() != jtensorAlias.scalar_type() ||
+        tensor.sizes() != jtensorAlias.sizes()) {
+      facebook::jni::throwNewJavaException(
+          facebook::jni::gJavaLangIllegalArgumentException,
+          "Output tensor (dtype %s, shape %s) doesn't match the preallocated "
+          "tensor (dtype %s, shape %s)",
+          c10::toString(tensor.scalar_type()),
+          c10::str(tensor.sizes()).c_str(),
+          c10::toString(jtensorAlias.scalar_type()),
+          c10::str(jtensorAlias.sizes()).c_str());
+    }
+    if (tensor.data_ptr() != jtensorAlias.data_ptr() ||
+        !tensor.is_contiguous()) {
+      jtensorAlias.copy_(tensor);
+    }
+  }
+
   static at::Tensor newAtTensorFromJTensor(
       facebook::jni::alias_ref<JTensor> jtensor) {
     static const auto dtypeMethod =
@@ -599,9 +624,22 @@ class PytorchJni : public facebook::jni::HybridClass<PytorchJni> {
         makeNativeMethod("initHybrid", PytorchJni::initHybrid),
         makeNativeMethod("forward", PytorchJni::forward),
         makeNativeMethod("runMethod", PytorchJni::runMethod),
+        makeNativeMethod("forwardInto", PytorchJni::forwardInto),
+        makeNativeMethod("runMethodInto", PytorchJni::runMethodInto),
     });
   }
 
+  static at::Tensor toOutputTensor(const at::IValue& output) {
+    if (!output.isTensor()) {
+      facebook::jni::throwNewJavaException(
+          facebook::jni::gJavaLangIllegalArgumentException,
+          "Method returned %s, expected a Tensor to write into the "
+          "preallocated output",
+          output.tagKind().c_str());
+    }
+    return output.toTensor();
+  }
+
   facebook::jni::local_ref<JIValue> forward(
       facebook::jni::alias_ref<
           facebook::jni::JArrayClass<JIValue::javaobject>::javaobject>
@@ -647,6 +685,51 @@ class PytorchJni : public facebook::jni::HybridClass<PytorchJni> {
         "Undefined method %s",
         methodName.c_str());
   }
+
+  void forwardInto(
+      facebook::jni::alias_ref<JTensor> joutput,
+      facebook::jni::alias_ref<
+          facebook::jni::JArrayClass<JIValue::javaobject>::javaobject>
+          jinputs) {
+    std::vector<at::IValue> inputs{};
+    size_t n = jinputs->size();
+    inputs.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      at::IValue atIValue = JIValue::JIValueToAtIValue(jinputs->getElement(i));
+      inputs.push_back(std::move(atIValue));
+    }
+    torch::autograd::AutoGradMode guard(false);
+    auto output = module_.forward(std::move(inputs));
+    JTensor::copyAtTensorToJTensor(toOutputTensor(output), joutput);
+  }
+
+  void runMethodInto(
+      facebook::jni::alias_ref<facebook::jni::JString::javaobject> jmethodName,
+      facebook::jni::alias_ref<JTensor> joutput,
+      facebook::jni::alias_ref<
+          facebook::jni::JArrayClass<JIValue::javaobject>::javaobject>
+          jinputs) {
+    std::string methodName = jmethodName->toStdString();
+
+    std::vector<at::IValue> inputs{};
+    size_t n = jinputs->size();
+    inputs.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      at::IValue atIValue = JIValue::JIValueToAtIValue(jinputs->getElement(i));
+      inputs.push_back(std::move(atIValue));
+    }
+    if (auto method = module_.find_method(methodName)) {
+      torch::autograd::AutoGradMode guard(false);
+      auto output = (*method)(std::move(inputs));
+      JTensor::copyAtTensorToJTensor(toOutputTensor(output), joutput);
+      return;
+    }
+
+    facebook::jni::throwNewJavaException(
+        facebook::jni::gJavaLangIllegalArgumentException,
+        "Undefined method %s",
+        methodName.c_str());
+  }
 };
 
 } // namespace pytorch_jni
@@ -46,6 +46,44 @@ public class Module {
     return mNativePeer.runMethod(methodName, inputs);
   }
 
+  /**
+   * Runs the 'forward' method of this module with the specified arguments and writes
+   * the tensor it returns into {@code output}, instead of allocating a new tensor
+   * on every call.
+   *
+   * <p>Inputs and {@code output} backed by direct buffers (see
+   * {@link Tensor#fromBlob(java.nio.FloatBuffer, long[])}) are used in place by the
+   * native side, so reusing the same tensors for every call, e.g. for the frames of a
+   * camera stream, runs the module without any allocation or copy of tensor data
+   * across the JNI boundary but the one into {@code output}.
+   *
+   * @param output tensor of the dtype and shape returned by 'forward'.
+   * @param inputs arguments for the TorchScript module's 'forward' method.
+   * @return {@code output}.
+   * @throws IllegalArgumentException if 'forward' doesn't return a tensor of the
+   *                                  dtype and shape of {@code output}.
+   */
+  public Tensor forwardInto(Tensor output, IValue... inputs) {
+    mNativePeer.forwardInto(output, inputs);
+    return output;
+  }
+
+  /**
+   * Runs the specified method of this module with the specified arguments and writes
+   * the tensor it returns into {@code output}. See {@link #forwardInto(Tensor, IValue...)}.
+   *
+   * @param methodName name of the TorchScript method to run.
+   * @param output     tensor of the dtype and shape returned by the method.
+   * @param inputs     arguments that will be passed to TorchScript method.
+   * @return {@code output}.
+   * @throws IllegalArgumentException if the method doesn't return a tensor of the
+   *                                  dtype and shape of {@code output}.
+   */
+  public Tensor runMethodInto(String methodName, Tensor output, IValue... inputs) {
+    mNativePeer.runMethodInto(methodName, output, inputs);
+    return output;
+  }
+
   /**
    * Explicitly destroys the native torch::jit::script::Module.
    * Calling this method is not required, as the native object will be destroyed
@@ -73,5 +111,9 @@ public class Module {
     private native IValue forward(IValue... inputs);
 
     private native IValue runMethod(String methodName, IValue... inputs);
+
+    private native void forwardInto(Tensor output, IValue... inputs);
+
+    private native void runMethodInto(String methodName, Tensor output, IValue... inputs);
   }
 }
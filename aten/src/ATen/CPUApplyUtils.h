@@ -2,6 +2,7 @@
 
 #include <ATen/Parallel.h>
 #include <ATen/TensorUtils.h>
+#include <c10/util/C++17.h>
 #include <limits>
 #include <utility>
 #include <cstring>
@@ -331,6 +332,153 @@ apply_op(int64_t numel, int64_t offset, const Op& op, Args... iters) {
   }
 }
 
+/*
+ * [specialized apply] When all the tensors have the same sizes, their
+ * dimensions are collapsed jointly: two adjacent dimensions are merged when
+ * they are contiguous with each other in every tensor. If at most
+ * kMaxSpecializedApplyRank dimensions are left, the elements are visited by
+ * loops nested at compile time, the innermost one with a unit stride when
+ * every tensor is contiguous along it, so that the compiler can vectorize
+ * it. The elements are visited in the same order as by apply_op, which
+ * matters to the kernels drawing random numbers.
+ */
+
+constexpr int64_t kMaxSpecializedApplyRank = 4;
+
+template <size_t N>
+struct apply_shape {
+  int64_t dim = 0;
+  int64_t sizes[kMaxSpecializedApplyRank];
+  // in elements, by tensor
+  int64_t strides[N][kMaxSpecializedApplyRank];
+};
+
+// Returns false if the tensors don't have the same sizes or if they don't
+// collapse to at most kMaxSpecializedApplyRank dimensions.
+template <size_t N>
+inline bool collapse_dims_jointly(ArrayRef<Tensor> tensors, apply_shape<N>& shape) {
+  IntArrayRef sizes = tensors[0].sizes();
+  for (size_t t = 1; t < N; t++) {
+    if (tensors[t].sizes() != sizes) {
+      return false;
+    }
+  }
+  shape.dim = 0;
+  for (int64_t d = 0; d < static_cast<int64_t>(sizes.size()); d++) {
+    if (sizes[d] == 1) {
+      continue;
+    }
+    const int64_t last = shape.dim - 1;
+    bool mergeable = last >= 0;
+    for (size_t t = 0; t < N && mergeable; t++) {
+      mergeable = shape.strides[t][last] == sizes[d] * tensors[t].strides()[d];
+    }
+    if (mergeable) {
+      shape.sizes[last] *= sizes[d];
+      for (size_t t = 0; t < N; t++) {
+        shape.strides[t][last] = tensors[t].strides()[d];
+      }
+    } else {
+      if (shape.dim == kMaxSpecializedApplyRank) {
+        return false;
+      }
+      shape.sizes[shape.dim] = sizes[d];
+      for (size_t t = 0; t < N; t++) {
+        shape.strides[t][shape.dim] = tensors[t].strides()[d];
+      }
+      shape.dim++;
+    }
+  }
+  // a single element
+  if (shape.dim == 0) {
+    shape.dim = 1;
+    shape.sizes[0] = 1;
+    for (size_t t = 0; t < N; t++) {
+      shape.strides[t][0] = 1;
+    }
+  }
+  return true;
+}
+
+// Loops over the dimension Rank - Remaining of the collapsed shape.
+template <int Rank, int Remaining, bool InnerContiguous>
+struct apply_loop {
+  template <size_t N, size_t... Is, typename Op, typename... Ts>
+  static inline void run(
+      const apply_shape<N>& shape,
+      c10::guts::index_sequence<Is...> indices,
+      const Op& op,
+      Ts*... data) {
+    constexpr int level = Rank - Remaining;
+    const int64_t size = shape.sizes[level];
+    for (int64_t i = 0; i < size; i++) {
+      apply_loop<Rank, Remaining - 1, InnerContiguous>::run(
+          shape, indices, op, (data + i * shape.strides[Is][level])...);
+    }
+  }
+};
+
+template <int Rank, bool InnerContiguous>
+struct apply_loop<Rank, 1, InnerContiguous> {
+  template <size_t N, size_t... Is, typename Op, typename... Ts>
+  static inline void run(
+      const apply_shape<N>& shape,
+      c10::guts::index_sequence<Is...> /* indices */,
+      const Op& op,
+      Ts*... data) {
+    const int64_t size = shape.sizes[Rank - 1];
+    if (InnerContiguous) {
+      for (int64_t i = 0; i < size; i++) {
+        op(data[i]...);
+      }
+    } else {
+      for (int64_t i = 0; i < size; i++) {
+        op(data[i * shape.strides[Is][Rank - 1]]...);
+      }
+    }
+  }
+};
+
+template <int Rank, size_t N, typename Op, typename... Ts>
+inline void apply_loops(const apply_shape<N>& shape, bool inner_contiguous, const Op& op, Ts*... data) {
+  auto indices = c10::guts::make_index_sequence<N>();
+  if (inner_contiguous) {
+    apply_loop<Rank, Rank, true>::run(shape, indices, op, data...);
+  } else {
+    apply_loop<Rank, Rank, false>::run(shape, indices, op, data...);
+  }
+}
+
+// Returns false, without applying op, if the tensors aren't suitable, see
+// [specialized apply].
+template <typename Op, typename... Ts>
+inline bool specialized_apply(ArrayRef<Tensor> tensors, const Op& op, Ts*... data) {
+  constexpr size_t N = sizeof...(Ts);
+  apply_shape<N> shape;
+  if (!collapse_dims_jointly(tensors, shape)) {
+    return false;
+  }
+  bool inner_contiguous = true;
+  for (size_t t = 0; t < N; t++) {
+    inner_contiguous = inner_contiguous && shape.strides[t][shape.dim - 1] == 1;
+  }
+  switch (shape.dim) {
+    case 1:
+      apply_loops<1>(shape, inner_contiguous, op, data...);
+      break;
+    case 2:
+      apply_loops<2>(shape, inner_contiguous, op, data...);
+      break;
+    case 3:
+      apply_loops<3>(shape, inner_contiguous, op, data...);
+      break;
+    default:
+      apply_loops<kMaxSpecializedApplyRank>(shape, inner_contiguous, op, data...);
+      break;
+  }
+  return true;
+}
+
 /*
   Apply a pointwise operator to sequence of tensors
 
@@ -345,6 +493,8 @@ template <typename scalar1, typename Op>
 inline void CPU_tensor_apply1(Tensor tensor1, const Op op) {
   if (!_apply_preamble({tensor1}))
     return;
+  if (specialized_apply({tensor1}, op, tensor1.data_ptr<scalar1>()))
+    return;
   if (tensor1.ndimension() < 8) {
     apply_op(
         tensor1.numel(),
@@ -360,6 +510,12 @@ template <typename scalar1, typename scalar2, typename Op>
 inline void CPU_tensor_apply2(Tensor tensor1, Tensor tensor2, const Op op) {
   if (!_apply_preamble({tensor1, tensor2}))
     return;
+  if (specialized_apply(
+          {tensor1, tensor2},
+          op,
+          tensor1.data_ptr<scalar1>(),
+          tensor2.data_ptr<scalar2>()))
+    return;
   if (_max_dim_tensors({tensor1, tensor2}) <= 8) {
     apply_op(
         tensor1.numel(),
@@ -382,6 +538,13 @@ inline void
 CPU_tensor_apply3(Tensor tensor1, Tensor tensor2, Tensor tensor3, const Op op) {
   if (!_apply_preamble({tensor1, tensor2, tensor3}))
     return;
+  if (specialized_apply(
+          {tensor1, tensor2, tensor3},
+          op,
+          tensor1.data_ptr<scalar1>(),
+          tensor2.data_ptr<scalar2>(),
+          tensor3.data_ptr<scalar3>()))
+    return;
   if (_max_dim_tensors({tensor1, tensor2, tensor3}) <= 8) {
     apply_op(
         tensor1.numel(),
@@ -415,6 +578,14 @@ inline void CPU_tensor_apply4(
     const Op op) {
   if (!_apply_preamble({tensor1, tensor2, tensor3, tensor4}))
     return;
+  if (specialized_apply(
+          {tensor1, tensor2, tensor3, tensor4},
+          op,
+          tensor1.data_ptr<scalar1>(),
+          tensor2.data_ptr<scalar2>(),
+          tensor3.data_ptr<scalar3>(),
+          tensor4.data_ptr<scalar4>()))
+    return;
   if (_max_dim_tensors({tensor1, tensor2, tensor3, tensor4}) <= 8) {
     apply_op(
         tensor1.numel(),
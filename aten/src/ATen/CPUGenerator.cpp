@@ -61,6 +61,7 @@ void CPUGenerator::set_current_seed(uint64_t seed) {
   next_float_normal_sample_.reset();
   next_double_normal_sample_.reset();
   engine_ = mt19937(seed);
+  philox_offset_ = 0;
 }
 
 /**
@@ -159,6 +160,68 @@ void CPUGenerator::set_engine(at::mt19937 engine) {
   engine_ = engine;
 }
 
+/**
+ * Note [Philox mode of CPUGenerator]
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * By default a CPUGenerator draws from its mt19937 engine, one number after
+ * the other, which has to happen on one thread under the generator lock.
+ * In Philox mode, the kernels that support it (uniform_, normal_ and
+ * bernoulli_ with a scalar p on floating point tensors) instead split their
+ * output into fixed blocks and generate block i from a philox_engine with the
+ * seed of the generator, subsequence i and the current philox offset, in
+ * parallel. Every kernel then advances the offset past what its blocks
+ * consumed, exactly as philox_engine_inputs does on CUDAGenerator. Since the
+ * blocks don't depend on the number of threads, neither do the results.
+ *
+ * The mode is off by default, so that manual_seed keeps reproducing the
+ * numbers it always has. Seeding the generator resets the offset.
+ */
+
+/**
+ * Whether the kernels that support it generate with Philox
+ */
+bool CPUGenerator::philox_mode() const {
+  return philox_mode_;
+}
+
+/**
+ * Makes the kernels that support it generate with Philox
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+void CPUGenerator::set_philox_mode(bool philox_mode) {
+  philox_mode_ = philox_mode;
+}
+
+/**
+ * Gets the offset of the philox engines of the next kernel
+ */
+uint64_t CPUGenerator::philox_offset() const {
+  return philox_offset_;
+}
+
+/**
+ * Sets the offset of the philox engines of the next kernel
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+void CPUGenerator::set_philox_offset(uint64_t offset) {
+  philox_offset_ = offset;
+}
+
+/**
+ * Gets the seed and offset for the philox engines of a kernel that consumes
+ * `increment` 128 bit numbers of each subsequence, and advances the offset
+ * past them.
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+std::pair<uint64_t, uint64_t> CPUGenerator::philox_engine_inputs(uint64_t increment) {
+  uint64_t offset = philox_offset_;
+  philox_offset_ += increment;
+  return std::make_pair(current_seed(), offset);
+}
+
 /**
  * Public clone method implementation
  * 
@@ -178,6 +241,8 @@ CPUGenerator* CPUGenerator::clone_impl() const {
   gen->set_engine(engine_);
   gen->set_next_float_normal_sample(next_float_normal_sample_);
   gen->set_next_double_normal_sample(next_double_normal_sample_);
+  gen->set_philox_mode(philox_mode_);
+  gen->set_philox_offset(philox_offset_);
   return gen;
 }
 
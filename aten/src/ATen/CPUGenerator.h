@@ -5,6 +5,8 @@
 #include <ATen/core/PhiloxRNGEngine.h>
 #include <c10/util/Optional.h>
 
+#include <utility>
+
 namespace at {
 
 struct CAFFE2_API CPUGenerator : public Generator {
@@ -26,12 +28,20 @@ struct CAFFE2_API CPUGenerator : public Generator {
   void set_next_double_normal_sample(c10::optional<double> randn);
   at::mt19937 engine();
   void set_engine(at::mt19937 engine);
+  // See Note [Philox mode of CPUGenerator]
+  bool philox_mode() const;
+  void set_philox_mode(bool philox_mode);
+  uint64_t philox_offset() const;
+  void set_philox_offset(uint64_t offset);
+  std::pair<uint64_t, uint64_t> philox_engine_inputs(uint64_t increment);
 
 private:
   CPUGenerator* clone_impl() const override;
   at::mt19937 engine_;
   c10::optional<float> next_float_normal_sample_;
   c10::optional<double> next_double_normal_sample_;
+  bool philox_mode_ = false;
+  uint64_t philox_offset_ = 0;
 };
 
 namespace detail {
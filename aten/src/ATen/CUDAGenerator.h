@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ATen/core/Generator.h>
+#include <ATen/cuda/PhiloxCudaState.h>
 
 namespace at {
 
@@ -17,12 +18,21 @@ struct CAFFE2_API CUDAGenerator : public Generator {
   void set_philox_offset_per_thread(uint64_t offset);
   uint64_t philox_offset_per_thread();
   std::pair<uint64_t, uint64_t> philox_engine_inputs(uint64_t increment);
+  PhiloxCudaState philox_cuda_state(uint64_t increment);
+  // See Note [CUDA graphs and random numbers]
+  void capture_prologue(int64_t* seed_extragraph, int64_t* offset_extragraph);
+  uint64_t capture_epilogue();
   static DeviceType device_type();
 
 private:
   CUDAGenerator* clone_impl() const override;
   uint64_t seed_ = default_rng_seed_val;
   uint64_t philox_offset_per_thread_ = 0;
+  // set while a CUDA graph using this generator is being captured
+  int64_t* seed_extragraph_ = nullptr;
+  int64_t* offset_extragraph_ = nullptr;
+  uint64_t offset_intragraph_ = 0;
+  bool graph_expects_this_gen_ = false;
 };
 
 namespace cuda {
@@ -59,6 +59,14 @@ void Context::setDeterministicCuDNN(bool b) {
   deterministic_cudnn = b;
 }
 
+bool Context::lazyClone() const {
+  return lazy_clone;
+}
+
+void Context::setLazyClone(bool b) {
+  lazy_clone = b;
+}
+
 bool Context::benchmarkCuDNN() const {
   return benchmark_cudnn;
 }
@@ -0,0 +1,82 @@
+#include <ATen/PTThreadPool.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <new>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+namespace at {
+
+namespace {
+
+// All the PTThreadPools of the process, to reset them in a forked child
+std::mutex& instances_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<PTThreadPools*>& instances() {
+  static std::vector<PTThreadPools*> instances;
+  return instances;
+}
+
+#ifndef _WIN32
+// The handlers hold instances_mutex() across the fork, so that the list is
+// consistent in the child, where only the forking thread runs.
+void prepare_fork() {
+  instances_mutex().lock();
+}
+
+void parent_after_fork() {
+  instances_mutex().unlock();
+}
+
+void child_after_fork() {
+  for (auto* pools : instances()) {
+    pools->resetAfterFork();
+  }
+  instances_mutex().unlock();
+}
+#endif
+
+void register_instance(PTThreadPools* pools) {
+#ifndef _WIN32
+  static const int registered =
+      pthread_atfork(prepare_fork, parent_after_fork, child_after_fork);
+  TORCH_CHECK(registered == 0, "unable to set pthread_atfork handler");
+#endif
+  std::lock_guard<std::mutex> lock(instances_mutex());
+  instances().push_back(pools);
+}
+
+} // namespace
+
+PTThreadPools::PTThreadPools(Factory factory) : factory_(std::move(factory)) {
+  for (auto& pool : pools_) {
+    pool = nullptr;
+  }
+  register_instance(this);
+}
+
+PTThreadPools::~PTThreadPools() {
+  std::lock_guard<std::mutex> lock(instances_mutex());
+  auto& all = instances();
+  all.erase(std::remove(all.begin(), all.end(), this), all.end());
+}
+
+void PTThreadPools::resetAfterFork() {
+  for (auto& pool : owned_) {
+    new std::shared_ptr<TaskThreadPoolBase>(std::move(pool));
+  }
+  owned_.clear();
+  for (auto& slot : pools_) {
+    slot.store(nullptr, std::memory_order_relaxed);
+  }
+  new (&mutex_) std::mutex();
+}
+
+} // namespace at
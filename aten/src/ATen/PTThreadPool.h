@@ -2,6 +2,14 @@
 
 #include <ATen/Parallel.h>
 #include <c10/core/thread_pool.h>
+#include <c10/util/numa.h>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace at {
 
@@ -10,10 +18,74 @@ public:
   explicit PTThreadPool(
       int pool_size,
       int numa_node_id = -1)
-    : c10::ThreadPool(pool_size, numa_node_id, [](){
+    : c10::ThreadPool(pool_size, numa_node_id, [numa_node_id](){
         c10::setThreadName("PTThreadPool");
+        c10::NUMABind(numa_node_id);
         at::init_num_threads();
       }) {}
 };
 
+// Thread pools of one kind, one per NUMA node. The pool of a node is created
+// the first time a thread running on that node asks for one, so that the
+// parallel work of a thread stays on its node and the memory its tasks touch
+// first is allocated there. When NUMA is disabled there is a single pool.
+//
+// The threads of the pools don't survive a fork(): in the child process, the
+// pools are dropped and new ones are created on first use, see
+// resetAfterFork().
+class CAFFE2_API PTThreadPools {
+public:
+  // Creates the pool of a NUMA node, -1 being no node
+  using Factory = std::function<std::shared_ptr<TaskThreadPoolBase>(int)>;
+
+  explicit PTThreadPools(Factory factory);
+  ~PTThreadPools();
+
+  // The pool of the NUMA node the calling thread runs on
+  TaskThreadPoolBase& get() {
+    int numa_node_id = c10::GetCurrentNUMANode();
+    if (numa_node_id < -1 || numa_node_id >= kMaxNUMANodes) {
+      numa_node_id = -1;
+    }
+    TaskThreadPoolBase* pool = pools_[numa_node_id + 1].load(std::memory_order_acquire);
+    if (pool) {
+      return *pool;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool = pools_[numa_node_id + 1].load(std::memory_order_relaxed);
+    if (!pool) {
+      owned_.push_back(factory_(numa_node_id));
+      pool = owned_.back().get();
+      pools_[numa_node_id + 1].store(pool, std::memory_order_release);
+    }
+    return *pool;
+  }
+
+  // Whether the calling thread belongs to one of the pools
+  bool inThreadPool() const {
+    for (const auto& slot : pools_) {
+      TaskThreadPoolBase* pool = slot.load(std::memory_order_acquire);
+      if (pool && pool->inThreadPool()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Called in the child process of a fork. The pools are leaked rather than
+  // destroyed, since their threads are gone and their mutexes may have been
+  // held by threads of the parent.
+  void resetAfterFork();
+
+private:
+  // NUMAMove supports the same number of nodes
+  static constexpr int kMaxNUMANodes = 64;
+
+  Factory factory_;
+  std::mutex mutex_;
+  // by NUMA node id + 1
+  std::array<std::atomic<TaskThreadPoolBase*>, kMaxNUMANodes + 1> pools_;
+  std::vector<std::shared_ptr<TaskThreadPoolBase>> owned_;
+};
+
 } // namespace at
@@ -2,6 +2,9 @@
 #include <ATen/ATen.h>
 #include <ATen/core/ivalue.h>
 
+#include <atomic>
+#include <chrono>
+
 namespace at {
 namespace internal {
 // This parameter is heuristically chosen to determine the minimum number of
@@ -10,6 +13,135 @@ namespace internal {
 // no parallel algorithm (such as parallel_reduce) should split work into
 // smaller than GRAIN_SIZE chunks.
 constexpr int64_t GRAIN_SIZE = 32768;
+
+// Counts a parallel_for or parallel_reduce split into num_tasks tasks in the
+// metrics registry, num_tasks being 1 when it runs on the calling thread only.
+CAFFE2_API void record_parallel_fanout(int64_t num_tasks);
+
+CAFFE2_API bool is_parallel_profiling_enabled();
+
+// Attributes the parallel regions the calling thread starts from now on to
+// the operator `name`, which must outlive them; nullptr for none.
+CAFFE2_API void set_parallel_profile_op(const char* name);
+CAFFE2_API const char* get_parallel_profile_op();
+
+CAFFE2_API bool is_adaptive_grain_size_enabled();
+
+// Learns the cost per element of the loops of a parallel_for or
+// parallel_reduce call site from timed calls, to choose their grain size in
+// the adaptive mode (see set_adaptive_grain_size_enabled). Every parallel
+// backend keeps one as a static of its parallel_for and parallel_reduce,
+// that is one for every type of loop body and so for every call site.
+class CAFFE2_API GrainSizeEstimator {
+ public:
+  constexpr GrainSizeEstimator() {}
+
+  GrainSizeEstimator(const GrainSizeEstimator&) = delete;
+  GrainSizeEstimator& operator=(const GrainSizeEstimator&) = delete;
+
+  // The grain size of a loop over n elements whose caller asks for
+  // grain_size. In the adaptive mode, once the cost of the elements is
+  // known, it is the number of elements that take long enough for a task
+  // to pay the wakeup of a thread, and no less than n over the number of
+  // threads. Sets sample when the call is to be timed and recorded.
+  int64_t grain_size(int64_t n, int64_t grain_size, bool& sample);
+
+  // Records that a sampled call ran n elements in busy_ns, summed over its
+  // tasks
+  void record(int64_t n, int64_t busy_ns);
+
+ private:
+  std::atomic<int64_t> calls_{0};
+  // 0 until the first sampled call
+  std::atomic<int64_t> ps_per_element_{0};
+};
+
+// Times a parallel_for or parallel_reduce, from its start to the join of its
+// tasks, and each of its tasks. The calls split into num_tasks > 1 tasks are
+// added to the parallel profile when it is enabled (see
+// set_parallel_profiling_enabled), and sampled calls to the estimator of
+// their call site. Does nothing otherwise.
+class CAFFE2_API ParallelRegionProfile {
+ public:
+  ParallelRegionProfile(
+      int64_t grain_size,
+      int64_t num_tasks,
+      GrainSizeEstimator* estimator = nullptr,
+      int64_t numel = 0)
+      : profiled_(num_tasks > 1 && is_parallel_profiling_enabled()),
+        active_(profiled_ || estimator != nullptr) {
+    if (active_) {
+      grain_size_ = grain_size;
+      estimator_ = estimator;
+      numel_ = numel;
+      op_ = get_parallel_profile_op();
+      start_ns_ = now_ns();
+    }
+  }
+
+  ParallelRegionProfile(const ParallelRegionProfile&) = delete;
+  ParallelRegionProfile& operator=(const ParallelRegionProfile&) = delete;
+
+  // Runs f(args...) as a task of the region
+  template <class F, class... Args>
+  auto run_task(const F& f, Args... args) const -> decltype(f(args...)) {
+    TaskTimer timer(active_ ? this : nullptr);
+    return f(args...);
+  }
+
+  // Records the region once its tasks have completed
+  void join() {
+    if (active_) {
+      record(now_ns() - start_ns_);
+      active_ = false;
+    }
+  }
+
+ private:
+  // The regions nested in a task are attributed to the op of the region
+  // whatever thread runs it
+  struct TaskTimer {
+    explicit TaskTimer(const ParallelRegionProfile* profile)
+        : profile_(profile) {
+      if (profile_) {
+        prev_op_ = get_parallel_profile_op();
+        set_parallel_profile_op(profile_->op_);
+        start_ns_ = now_ns();
+      }
+    }
+    ~TaskTimer() {
+      if (profile_) {
+        profile_->add_task(
+            start_ns_ - profile_->start_ns_, now_ns() - start_ns_);
+        set_parallel_profile_op(prev_op_);
+      }
+    }
+    const ParallelRegionProfile* profile_;
+    const char* prev_op_ = nullptr;
+    int64_t start_ns_ = 0;
+  };
+
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  void add_task(int64_t start_delay_ns, int64_t ns) const;
+  void record(int64_t wall_ns);
+
+  const bool profiled_;
+  bool active_;
+  GrainSizeEstimator* estimator_ = nullptr;
+  int64_t numel_ = 0;
+  const char* op_ = nullptr;
+  int64_t grain_size_ = 0;
+  int64_t start_ns_ = 0;
+  mutable std::atomic<int64_t> tasks_{0};
+  mutable std::atomic<int64_t> busy_ns_{0};
+  mutable std::atomic<int64_t> max_task_ns_{0};
+  mutable std::atomic<int64_t> start_delay_ns_{0};
+};
+
 } // namespace internal
 
 inline int64_t divup(int64_t x, int64_t y) {
@@ -96,6 +228,62 @@ inline scalar_t parallel_reduce(
 // Returns a detailed string describing parallelization settings
 CAFFE2_API std::string get_parallel_info();
 
+// Enables or disables the adaptive grain size, in which parallel_for and
+// parallel_reduce ignore the grain size of their callers once they have
+// timed a few of their calls: they then split a loop into tasks that take
+// long enough to pay the wakeup of a thread, measured as well, or run it on
+// the calling thread. A call of every 64 goes on being timed, to follow
+// changes of the cost of the elements. It can also be enabled by setting
+// ATEN_ADAPTIVE_GRAIN_SIZE=1 in the environment.
+CAFFE2_API void set_adaptive_grain_size_enabled(bool enabled);
+
+// The parallel regions (parallel_for and parallel_reduce calls split into
+// several tasks) of an operator, summed over its calls. Regions are
+// attributed to the innermost operator running on the thread that starts
+// them, as set by internal::set_parallel_profile_op; the op of the regions
+// started outside of any operator is empty.
+struct ParallelProfileEntry {
+  std::string op;
+  // parallel regions, and calls run on the calling thread only
+  int64_t calls = 0;
+  int64_t inline_calls = 0;
+  int64_t grain_size_sum = 0;
+  int64_t tasks = 0;
+  // from the start of the regions to the join of their tasks
+  int64_t wall_ns = 0;
+  // time spent running the tasks, summed over the tasks
+  int64_t busy_ns = 0;
+  // time the threads of the regions spent idle, most of it waiting at the
+  // join for the slowest task, summed over the threads
+  int64_t join_wait_ns = 0;
+  // sum over the regions of the time of their longest task over the mean
+  double imbalance_sum = 0;
+
+  // The time the regions would take on a single thread over the time they
+  // took, assuming their tasks would run as fast there. Below 1, running
+  // them in parallel costs more than it saves.
+  double speedup() const {
+    return wall_ns == 0 ? 0.0 : static_cast<double>(busy_ns) / wall_ns;
+  }
+  double imbalance() const {
+    return calls == 0 ? 0.0 : imbalance_sum / calls;
+  }
+};
+
+// Enables or disables the profiling of the parallel regions. It costs two
+// clock reads per task and a lock per region, so it is off by default.
+CAFFE2_API void set_parallel_profiling_enabled(bool enabled);
+
+// The profile of the parallel regions since the last reset, by operator
+CAFFE2_API std::vector<ParallelProfileEntry> parallel_profile();
+
+CAFFE2_API void reset_parallel_profile();
+
+// A table of the parallel profile, by decreasing wall time, in which the
+// operators whose parallel regions are slower than running them on a single
+// thread would be are flagged
+CAFFE2_API std::string parallel_profile_report();
+
 // Sets number of threads used for inter-op parallelism
 CAFFE2_API void set_num_interop_threads(int);
 
@@ -115,6 +303,13 @@ CAFFE2_API std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
 // Returns number of intra-op threads used by default
 CAFFE2_API int intraop_default_num_threads();
 
+// Binds the calling thread and the memory it allocates to a NUMA node, and
+// enables NUMA awareness: the intra-op and inter-op work launched by a thread
+// runs in pools of its node (with the native parallel backend). Running a
+// model replica per socket from a thread bound to each keeps all of its
+// computation and memory on the socket.
+CAFFE2_API void bind_to_numa_node(int numa_node_id);
+
 } // namespace at
 
 #if AT_PARALLEL_OPENMP
@@ -123,4 +318,6 @@ CAFFE2_API int intraop_default_num_threads();
 #include <ATen/ParallelNative.h>
 #elif AT_PARALLEL_NATIVE_TBB
 #include <ATen/ParallelNativeTBB.h>
+#elif AT_PARALLEL_NATIVE_WS
+#include <ATen/ParallelNativeWS.h>
 #endif
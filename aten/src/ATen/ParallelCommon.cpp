@@ -3,9 +3,15 @@
 #include <ATen/Config.h>
 #include <ATen/PTThreadPool.h>
 #include <ATen/Version.h>
+#include <c10/util/Metrics.h>
+#include <c10/util/numa.h>
 
+#include <algorithm>
+#include <iomanip>
+#include <mutex>
 #include <sstream>
 #include <thread>
+#include <unordered_map>
 
 #ifdef TH_BLAS_MKL
 #include <mkl.h>
@@ -40,8 +46,247 @@ size_t get_env_num_threads(const char* var_name, size_t def_value = 0) {
   return def_value;
 }
 
+c10::metrics::Counter parallel_calls(
+    "torch_parallel_for_calls_total",
+    "parallel_for and parallel_reduce calls split into several tasks");
+c10::metrics::Counter parallel_tasks(
+    "torch_parallel_for_tasks_total",
+    "Tasks the parallel_for and parallel_reduce calls were split into");
+c10::metrics::Counter parallel_inline_calls(
+    "torch_parallel_for_inline_total",
+    "parallel_for and parallel_reduce calls run on the calling thread only");
+
+std::atomic<bool> parallel_profiling_enabled{false};
+
+std::atomic<bool> adaptive_grain_size_enabled{
+    std::string(get_env_var("ATEN_ADAPTIVE_GRAIN_SIZE", "")) == "1"};
+
+// Calls of a call site timed before its grain size is adapted, and the
+// interval of the calls timed afterwards
+constexpr int64_t kGrainSizeWarmupCalls = 4;
+constexpr int64_t kGrainSizeSamplingInterval = 64;
+
+// A task runs for at least kMinTaskWakeups times the wakeup latency of a
+// thread, and for at least kMinTaskNs, so that splitting a loop into tasks
+// costs at most a fraction of the work
+constexpr int64_t kMinTaskWakeups = 4;
+constexpr int64_t kMinTaskNs = 5000;
+
+// Mean delay between the start of a parallel region and the start of its
+// tasks, measured by the sampled calls
+std::atomic<int64_t> task_wakeup_ns{10000};
+
+int64_t exponential_average(int64_t average, int64_t sample) {
+  return average == 0 ? sample : (3 * average + sample) / 4;
+}
+
+// The innermost operator running on the thread
+thread_local const char* parallel_profile_op = nullptr;
+
+std::mutex parallel_profile_mutex;
+
+std::unordered_map<std::string, ParallelProfileEntry>& parallel_profile_entries() {
+  static std::unordered_map<std::string, ParallelProfileEntry> entries;
+  return entries;
+}
+
+// Must be called with parallel_profile_mutex held
+ParallelProfileEntry& get_parallel_profile_entry(const char* name) {
+  std::string op = name ? name : "";
+  auto& entry = parallel_profile_entries()[op];
+  if (entry.op.empty()) {
+    entry.op = std::move(op);
+  }
+  return entry;
+}
+
 } // namespace
 
+namespace internal {
+
+void record_parallel_fanout(int64_t num_tasks) {
+  if (num_tasks > 1) {
+    parallel_calls.add();
+    parallel_tasks.add(num_tasks);
+  } else {
+    parallel_inline_calls.add();
+    if (is_parallel_profiling_enabled()) {
+      std::lock_guard<std::mutex> guard(parallel_profile_mutex);
+      get_parallel_profile_entry(parallel_profile_op).inline_calls++;
+    }
+  }
+}
+
+bool is_parallel_profiling_enabled() {
+  return parallel_profiling_enabled.load(std::memory_order_relaxed);
+}
+
+void set_parallel_profile_op(const char* name) {
+  parallel_profile_op = name;
+}
+
+const char* get_parallel_profile_op() {
+  return parallel_profile_op;
+}
+
+bool is_adaptive_grain_size_enabled() {
+  return adaptive_grain_size_enabled.load(std::memory_order_relaxed);
+}
+
+int64_t GrainSizeEstimator::grain_size(
+    int64_t n, int64_t grain_size, bool& sample) {
+  sample = false;
+  if (!is_adaptive_grain_size_enabled()) {
+    return grain_size;
+  }
+  const int64_t calls = calls_.fetch_add(1, std::memory_order_relaxed);
+  sample = calls < kGrainSizeWarmupCalls ||
+      calls % kGrainSizeSamplingInterval == 0;
+  const int64_t ps_per_element =
+      ps_per_element_.load(std::memory_order_relaxed);
+  if (ps_per_element == 0) {
+    return grain_size;
+  }
+  const int64_t min_task_ns = std::max(
+      kMinTaskNs,
+      kMinTaskWakeups * task_wakeup_ns.load(std::memory_order_relaxed));
+  const int64_t adaptive_grain_size =
+      std::max<int64_t>(1, min_task_ns * 1000 / ps_per_element);
+  // More tasks than threads would only add wakeups
+  return std::max(adaptive_grain_size, divup(n, get_num_threads()));
+}
+
+void GrainSizeEstimator::record(int64_t n, int64_t busy_ns) {
+  if (n <= 0) {
+    return;
+  }
+  // Races between threads lose a sample at worst
+  const int64_t sample = std::max<int64_t>(1, busy_ns * 1000 / n);
+  ps_per_element_.store(
+      exponential_average(
+          ps_per_element_.load(std::memory_order_relaxed), sample),
+      std::memory_order_relaxed);
+}
+
+void ParallelRegionProfile::add_task(int64_t start_delay_ns, int64_t ns) const {
+  tasks_.fetch_add(1, std::memory_order_relaxed);
+  busy_ns_.fetch_add(ns, std::memory_order_relaxed);
+  start_delay_ns_.fetch_add(start_delay_ns, std::memory_order_relaxed);
+  int64_t max_ns = max_task_ns_.load(std::memory_order_relaxed);
+  while (ns > max_ns &&
+         !max_task_ns_.compare_exchange_weak(
+             max_ns, ns, std::memory_order_relaxed)) {
+  }
+}
+
+void ParallelRegionProfile::record(int64_t wall_ns) {
+  // The tasks have been joined, so their updates are visible
+  const int64_t tasks = tasks_.load(std::memory_order_relaxed);
+  const int64_t busy_ns = busy_ns_.load(std::memory_order_relaxed);
+  const int64_t max_task_ns = max_task_ns_.load(std::memory_order_relaxed);
+  const int64_t threads =
+      std::max<int64_t>(1, std::min<int64_t>(tasks, get_num_threads()));
+
+  if (estimator_) {
+    estimator_->record(numel_, busy_ns);
+    // With more tasks than threads, tasks also wait for the previous ones
+    if (tasks > 1 && tasks <= get_num_threads()) {
+      const int64_t start_delay_ns =
+          start_delay_ns_.load(std::memory_order_relaxed);
+      task_wakeup_ns.store(
+          exponential_average(
+              task_wakeup_ns.load(std::memory_order_relaxed),
+              std::max<int64_t>(1, start_delay_ns / tasks)),
+          std::memory_order_relaxed);
+    }
+  }
+  if (!profiled_) {
+    return;
+  }
+
+  std::lock_guard<std::mutex> guard(parallel_profile_mutex);
+  auto& entry = get_parallel_profile_entry(op_);
+  entry.calls++;
+  entry.grain_size_sum += grain_size_;
+  entry.tasks += tasks;
+  entry.wall_ns += wall_ns;
+  entry.busy_ns += busy_ns;
+  entry.join_wait_ns += std::max<int64_t>(0, threads * wall_ns - busy_ns);
+  if (busy_ns > 0) {
+    entry.imbalance_sum +=
+        static_cast<double>(max_task_ns) * tasks / busy_ns;
+  }
+}
+
+} // namespace internal
+
+void set_adaptive_grain_size_enabled(bool enabled) {
+  adaptive_grain_size_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void set_parallel_profiling_enabled(bool enabled) {
+  parallel_profiling_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+std::vector<ParallelProfileEntry> parallel_profile() {
+  std::vector<ParallelProfileEntry> profile;
+  {
+    std::lock_guard<std::mutex> guard(parallel_profile_mutex);
+    for (const auto& entry : parallel_profile_entries()) {
+      profile.push_back(entry.second);
+    }
+  }
+  std::sort(
+      profile.begin(),
+      profile.end(),
+      [](const ParallelProfileEntry& a, const ParallelProfileEntry& b) {
+        return a.wall_ns > b.wall_ns;
+      });
+  return profile;
+}
+
+void reset_parallel_profile() {
+  std::lock_guard<std::mutex> guard(parallel_profile_mutex);
+  parallel_profile_entries().clear();
+}
+
+std::string parallel_profile_report() {
+  const auto profile = parallel_profile();
+  std::ostringstream ss;
+  ss << std::left << std::setw(32) << "op" << std::right
+     << std::setw(10) << "regions" << std::setw(10) << "inline"
+     << std::setw(12) << "avg grain" << std::setw(10) << "avg tasks"
+     << std::setw(12) << "wall ms" << std::setw(12) << "busy ms"
+     << std::setw(10) << "speedup" << std::setw(11) << "imbalance"
+     << std::setw(12) << "join wait %" << std::endl;
+  bool flagged = false;
+  for (const auto& entry : profile) {
+    const double calls = std::max<int64_t>(entry.calls, 1);
+    const int64_t thread_ns = entry.busy_ns + entry.join_wait_ns;
+    const bool slower = entry.calls > 0 && entry.speedup() < 1.0;
+    flagged = flagged || slower;
+    ss << std::left << std::setw(32)
+       << ((slower ? "* " : "  ") + (entry.op.empty() ? "[no op]" : entry.op))
+       << std::right << std::fixed
+       << std::setw(10) << entry.calls << std::setw(10) << entry.inline_calls
+       << std::setprecision(0) << std::setw(12) << entry.grain_size_sum / calls
+       << std::setprecision(1) << std::setw(10) << entry.tasks / calls
+       << std::setprecision(3) << std::setw(12) << entry.wall_ns / 1e6
+       << std::setw(12) << entry.busy_ns / 1e6
+       << std::setprecision(2) << std::setw(10) << entry.speedup()
+       << std::setw(11) << entry.imbalance()
+       << std::setprecision(1) << std::setw(12)
+       << (thread_ns == 0 ? 0.0 : 100.0 * entry.join_wait_ns / thread_ns)
+       << std::endl;
+  }
+  if (flagged) {
+    ss << "* the parallel regions of the op take longer than their tasks "
+       << "would on a single thread: a larger grain size or fewer threads "
+       << "would make it faster" << std::endl;
+  }
+  return ss.str();
+}
+
 std::string get_parallel_info() {
   std::ostringstream ss;
 
@@ -78,19 +323,39 @@ std::string get_parallel_info() {
   ss << "native thread pool";
   #elif AT_PARALLEL_NATIVE_TBB
   ss << "native thread pool and TBB";
+  #elif AT_PARALLEL_NATIVE_WS
+  ss << "work-stealing thread pool";
   #endif
   #ifdef C10_MOBILE
   ss << " [mobile]";
   #endif
   ss << std::endl;
 
+  ss << "Adaptive grain size : "
+     << (internal::is_adaptive_grain_size_enabled() ? "on" : "off")
+     << std::endl;
+
   #if AT_EXPERIMENTAL_SINGLE_THREAD_POOL
   ss << "Experimental: single thread pool" << std::endl;
   #endif
 
+  if (c10::IsNUMAEnabled()) {
+    ss << "NUMA nodes : " << c10::GetNumNUMANodes()
+       << ", current node : " << c10::GetCurrentNUMANode() << std::endl;
+  }
+
   return ss.str();
 }
 
+void bind_to_numa_node(int numa_node_id) {
+  FLAGS_caffe2_cpu_numa_enabled = true;
+  TORCH_CHECK(c10::IsNUMAEnabled(), "NUMA is not available on this system");
+  TORCH_CHECK(numa_node_id >= 0 && numa_node_id < c10::GetNumNUMANodes(),
+      "NUMA node id ", numa_node_id, " is unavailable, expected a value in [0, ",
+      c10::GetNumNUMANodes(), ")");
+  c10::NUMABind(numa_node_id);
+}
+
 int intraop_default_num_threads() {
 #ifdef C10_MOBILE
   // Intraop thread pool size should be determined by mobile cpuinfo.
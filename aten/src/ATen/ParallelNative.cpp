@@ -9,7 +9,9 @@
 #include <caffe2/utils/threadpool/ThreadPoolMobile.h>
 #endif // C10_MOBILE
 
+#include <algorithm>
 #include <atomic>
+#include <cstdlib>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -55,9 +57,19 @@ const int CONSUMED = -2;
 //  - CONSUMED - pool is initialized
 std::atomic<int> num_intraop_threads{NOT_SET};
 
+// With NUMA enabled every node gets its own intra-op pool, so unless the
+// number of threads is given a parallel region uses the cores of one node.
+int _default_num_threads() {
+  int num_nodes = c10::GetNumNUMANodes();
+  if (num_nodes > 1 && !std::getenv("OMP_NUM_THREADS") && !std::getenv("MKL_NUM_THREADS")) {
+    return std::max(1, intraop_default_num_threads() / num_nodes);
+  }
+  return intraop_default_num_threads();
+}
+
 int _num_pool_threads(int nthreads) {
   if (nthreads == NOT_SET) {
-    nthreads = intraop_default_num_threads();
+    nthreads = _default_num_threads();
   } else {
     TORCH_INTERNAL_ASSERT(nthreads > 0);
   }
@@ -65,14 +77,26 @@ int _num_pool_threads(int nthreads) {
   return nthreads - 1;
 }
 
+// Size of every intra-op pool, fixed by the first parallel work
+int _intraop_pool_size() {
+  static const int pool_size = _num_pool_threads(num_intraop_threads.exchange(CONSUMED));
+  return pool_size;
+}
+
+PTThreadPools& _get_intraop_pools() {
+  static PTThreadPools pools([](int numa_node_id) {
+    return ThreadPoolRegistry()->Create(
+        "C10",
+        /* device_id */ numa_node_id,
+        /* pool_size */ _intraop_pool_size(),
+        /* create_new */ true); // create a separate thread pool for intra-op
+  });
+  return pools;
+}
+
+// The intra-op pool of the NUMA node of the calling thread
 TaskThreadPoolBase& _get_intraop_pool() {
-  static std::shared_ptr<TaskThreadPoolBase> pool =
-      ThreadPoolRegistry()->Create(
-          "C10",
-          /* device_id */ 0,
-          /* pool_size */ _num_pool_threads(num_intraop_threads.exchange(CONSUMED)),
-          /* create_new */ true); // create a separate thread pool for intra-op
-  return *pool;
+  return _get_intraop_pools().get();
 }
 
 #endif // C10_MOBILE
@@ -81,8 +105,9 @@ TaskThreadPoolBase& _get_intraop_pool() {
 // `fn` will be called with params: (thread_pool_task_id, task_id).
 void _run_with_pool(const std::function<void(int, size_t)>& fn, size_t range) {
 #ifndef C10_MOBILE
+  TaskThreadPoolBase& pool = _get_intraop_pool();
   for (size_t i = 1; i < range; ++i) {
-    _get_intraop_pool().run([fn, i]() { fn((int)i, i); });
+    pool.run([fn, i]() { fn((int)i, i); });
   }
   // Run the first task on the current thread directly.
   fn(0, 0);
@@ -120,10 +145,14 @@ void _parallel_run(
   const int64_t begin,
   const int64_t end,
   const int64_t grain_size,
-  const std::function<void(int64_t, int64_t, size_t)>& f) {
+  const std::function<void(int64_t, int64_t, size_t)>& f,
+  GrainSizeEstimator* estimator) {
   size_t num_tasks, chunk_size;
   std::tie(num_tasks, chunk_size) =
       internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
+  internal::record_parallel_fanout(num_tasks);
+  internal::ParallelRegionProfile profile(
+      grain_size, num_tasks, estimator, end - begin);
 
   std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
   std::exception_ptr eptr;
@@ -131,14 +160,14 @@ void _parallel_run(
   for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
     futures[task_id] = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
   }
-  auto task = [f, &eptr, &err_flag, &futures, begin, end, chunk_size]
+  auto task = [f, &eptr, &err_flag, &futures, &profile, begin, end, chunk_size]
       (int /* unused */, size_t task_id) {
     int64_t local_start = begin + task_id * chunk_size;
     if (local_start < end) {
       int64_t local_end = std::min(end, (int64_t)(chunk_size + local_start));
       try {
         ParallelRegionGuard guard(task_id);
-        f(local_start, local_end, task_id);
+        profile.run_task(f, local_start, local_end, task_id);
       } catch (...) {
         if (!err_flag.test_and_set()) {
           eptr = std::current_exception();
@@ -153,6 +182,7 @@ void _parallel_run(
   for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
     futures[task_id]->wait();
   }
+  profile.join();
   if (eptr) {
     std::rethrow_exception(eptr);
   }
@@ -184,7 +214,7 @@ void set_num_threads(int nthreads) {
     int stored_nthreads = num_intraop_threads.load();
     if (stored_nthreads <= 0) {
       // plus one because of master thread
-      stored_nthreads = _get_intraop_pool().size() + 1;
+      stored_nthreads = _intraop_pool_size() + 1;
     }
     if (stored_nthreads != nthreads) {
       TORCH_WARN(
@@ -206,10 +236,10 @@ int get_num_threads() {
   if (nthreads > 0) {
     return nthreads;
   } else if (nthreads == NOT_SET) {
-    return intraop_default_num_threads();
+    return _default_num_threads();
   } else {
     TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
-    return _get_intraop_pool().size() + 1;
+    return _intraop_pool_size() + 1;
   }
 #else
   caffe2::ThreadPool* pool = caffe2::mobile_threadpool();
@@ -227,7 +257,7 @@ bool in_parallel_region() {
   return in_parallel_region_ || (
     num_intraop_threads.load() == CONSUMED &&
     // Needed as intraop_launch() doesn't set in_parallel_region().
-    _get_intraop_pool().inThreadPool()
+    _get_intraop_pools().inThreadPool()
   );
 #else
   return in_parallel_region_;
@@ -26,7 +26,8 @@ CAFFE2_API void _parallel_run(
   const int64_t begin,
   const int64_t end,
   const int64_t grain_size,
-  const std::function<void(int64_t, int64_t, size_t)>& f);
+  const std::function<void(int64_t, int64_t, size_t)>& f,
+  GrainSizeEstimator* estimator = nullptr);
 
 } // namespace internal
 
@@ -40,17 +41,26 @@ inline void parallel_for(
   if (begin >= end) {
     return;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
-    f(begin, end);
+  static internal::GrainSizeEstimator estimator;
+  bool sample;
+  const int64_t adapted_grain_size =
+      estimator.grain_size(end - begin, grain_size, sample);
+  if ((end - begin) < adapted_grain_size || in_parallel_region()) {
+    internal::record_parallel_fanout(1);
+    internal::ParallelRegionProfile profile(
+        adapted_grain_size, 1, sample ? &estimator : nullptr, end - begin);
+    profile.run_task(f, begin, end);
+    profile.join();
     return;
   }
   internal::_parallel_run(
       begin,
       end,
-      grain_size,
+      adapted_grain_size,
       [f](int64_t start, int64_t end, size_t /* unused */) {
         f(start, end);
-      }
+      },
+      sample ? &estimator : nullptr
   );
 }
 
@@ -66,21 +76,31 @@ inline scalar_t parallel_reduce(
   if (begin >= end) {
     return ident;
   }
-  if ((end - begin) < grain_size || in_parallel_region()) {
-    return f(begin, end, ident);
+  static internal::GrainSizeEstimator estimator;
+  bool sample;
+  const int64_t adapted_grain_size =
+      estimator.grain_size(end - begin, grain_size, sample);
+  if ((end - begin) < adapted_grain_size || in_parallel_region()) {
+    internal::record_parallel_fanout(1);
+    internal::ParallelRegionProfile profile(
+        adapted_grain_size, 1, sample ? &estimator : nullptr, end - begin);
+    auto result = profile.run_task(f, begin, end, ident);
+    profile.join();
+    return result;
   }
   size_t num_tasks, chunk_size;
   std::tie(num_tasks, chunk_size) =
-      internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
+      internal::calc_num_tasks_and_chunk_size(begin, end, adapted_grain_size);
   std::vector<scalar_t> results(num_tasks);
   scalar_t* results_data = results.data();
   internal::_parallel_run(
       begin,
       end,
-      grain_size,
+      adapted_grain_size,
       [f, ident, results_data](int64_t start, int64_t end, size_t task_id) {
         results_data[task_id] = f(start, end, ident);
-      }
+      },
+      sample ? &estimator : nullptr
   );
   scalar_t result = ident;
   for (auto partial_result : results) {
@@ -23,22 +23,38 @@ inline void parallel_for(
   if (begin >= end) {
     return;
   }
-  if ((end - begin) < grain_size || get_num_threads() == 1) {
-    f(begin, end);
+  static internal::GrainSizeEstimator estimator;
+  bool sample;
+  const int64_t adapted_grain_size =
+      estimator.grain_size(end - begin, grain_size, sample);
+  if ((end - begin) < adapted_grain_size || get_num_threads() == 1) {
+    internal::record_parallel_fanout(1);
+    internal::ParallelRegionProfile profile(
+        adapted_grain_size, 1, sample ? &estimator : nullptr, end - begin);
+    profile.run_task(f, begin, end);
+    profile.join();
     return;
   }
+  // TBB splits the range as it sees fit, count the largest useful split
+  const int64_t num_tasks = std::min<int64_t>(
+      get_num_threads(),
+      divup(end - begin, std::max<int64_t>(adapted_grain_size, 1)));
+  internal::record_parallel_fanout(num_tasks);
+  internal::ParallelRegionProfile profile(
+      adapted_grain_size, num_tasks, sample ? &estimator : nullptr, end - begin);
   std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
   std::exception_ptr eptr;
-  tbb::parallel_for(tbb::blocked_range<int64_t>(begin, end, grain_size),
-    [&eptr, &err_flag, f](const tbb::blocked_range<int64_t>& r) {
+  tbb::parallel_for(tbb::blocked_range<int64_t>(begin, end, adapted_grain_size),
+    [&eptr, &err_flag, &profile, f](const tbb::blocked_range<int64_t>& r) {
       try {
-        f(r.begin(), r.end());
+        profile.run_task(f, r.begin(), r.end());
       } catch (...) {
         if (!err_flag.test_and_set()) {
           eptr = std::current_exception();
         }
       }
     });
+  profile.join();
   if (eptr) {
     std::rethrow_exception(eptr);
   }
@@ -56,18 +72,33 @@ inline scalar_t parallel_reduce(
   if (begin >= end) {
     return ident;
   }
-  if ((end - begin) < grain_size || get_num_threads() == 1) {
-    return f(begin, end, ident);
+  static internal::GrainSizeEstimator estimator;
+  bool sample;
+  const int64_t adapted_grain_size =
+      estimator.grain_size(end - begin, grain_size, sample);
+  if ((end - begin) < adapted_grain_size || get_num_threads() == 1) {
+    internal::record_parallel_fanout(1);
+    internal::ParallelRegionProfile profile(
+        adapted_grain_size, 1, sample ? &estimator : nullptr, end - begin);
+    auto result = profile.run_task(f, begin, end, ident);
+    profile.join();
+    return result;
   }
+  const int64_t num_tasks = std::min<int64_t>(
+      get_num_threads(),
+      divup(end - begin, std::max<int64_t>(adapted_grain_size, 1)));
+  internal::record_parallel_fanout(num_tasks);
+  internal::ParallelRegionProfile profile(
+      adapted_grain_size, num_tasks, sample ? &estimator : nullptr, end - begin);
   scalar_t result;
   std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
   std::exception_ptr eptr;
   result = tbb::parallel_reduce(
-    tbb::blocked_range<int64_t>(begin, end, grain_size), ident,
-    [&eptr, &err_flag, f, ident]
+    tbb::blocked_range<int64_t>(begin, end, adapted_grain_size), ident,
+    [&eptr, &err_flag, &profile, f, ident]
         (const tbb::blocked_range<int64_t>& r, scalar_t ident) {
       try {
-        return f(r.begin(), r.end(), ident);
+        return profile.run_task(f, r.begin(), r.end(), ident);
       } catch (...) {
         if (!err_flag.test_and_set()) {
           eptr = std::current_exception();
@@ -77,6 +108,7 @@ inline scalar_t parallel_reduce(
     },
     sf
   );
+  profile.join();
   if (eptr) {
     std::rethrow_exception(eptr);
   }
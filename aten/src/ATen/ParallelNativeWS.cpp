@@ -0,0 +1,577 @@
+#if AT_PARALLEL_NATIVE_WS
+#include <ATen/Parallel.h>
+#include <ATen/PTThreadPool.h>
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef TH_BLAS_MKL
+#include <mkl.h>
+#endif
+
+namespace at {
+namespace {
+
+// used with ParallelRegionGuard to mark threads executing parallel tasks
+thread_local bool in_parallel_region_ = false;
+
+// thread number (task_id) set by parallel primitive
+thread_local size_t thread_num_ = 0;
+
+// RAII guard helps to support in_parallel_region() and get_thread_num() API.
+// Tasks may nest, so the previous values are restored on exit.
+struct ParallelRegionGuard {
+  ParallelRegionGuard(size_t task_id)
+      : prev_in_region_(in_parallel_region_), prev_thread_num_(thread_num_) {
+    thread_num_ = task_id;
+    in_parallel_region_ = true;
+  }
+
+  ~ParallelRegionGuard() {
+    in_parallel_region_ = prev_in_region_;
+    thread_num_ = prev_thread_num_;
+  }
+
+ private:
+  bool prev_in_region_;
+  size_t prev_thread_num_;
+};
+
+inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+  _mm_pause();
+#else
+  std::this_thread::yield();
+#endif
+}
+
+struct Task {
+  virtual ~Task() = default;
+  virtual void run() = 0;
+};
+
+// Fixed capacity Chase-Lev deque ("Dynamic Circular Work-Stealing Deque",
+// SPAA'05), with the memory orderings from "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP'13). The owning thread pushes
+// and pops at the bottom; other threads steal from the top. Pushing onto a
+// full deque fails, and the caller runs the task inline instead.
+class TaskDeque {
+ public:
+  static constexpr int64_t kCapacity = 1024;
+
+  TaskDeque() {
+    for (auto& slot : buffer_) {
+      slot.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  // Owner only.
+  bool push(Task* task) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t >= kCapacity) {
+      return false;
+    }
+    buffer_[b & (kCapacity - 1)].store(task, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Owner only.
+  Task* pop() {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    Task* task = nullptr;
+    if (t <= b) {
+      task = buffer_[b & (kCapacity - 1)].load(std::memory_order_relaxed);
+      if (t == b) {
+        // Last task; race against thieves for it.
+        if (!top_.compare_exchange_strong(
+                t, t + 1, std::memory_order_seq_cst,
+                std::memory_order_relaxed)) {
+          task = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+  }
+
+  // Any thread. May spuriously fail under contention.
+  Task* steal() {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    Task* task = buffer_[t & (kCapacity - 1)].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return task;
+  }
+
+ private:
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  alignas(64) std::array<std::atomic<Task*>, kCapacity> buffer_;
+};
+
+// Number of threads outside of the pool (the main thread, inter-op threads,
+// ...) that may submit tasks at the same time. Each of them gets a deque on
+// first use; once all are taken, further threads run their work inline.
+constexpr int kMaxExternalThreads = 64;
+
+// Number of failed attempts to find work before an idle worker parks.
+constexpr int kSpinCount = 1 << 14;
+
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(int num_workers)
+      : num_workers_(num_workers),
+        deques_(num_workers + kMaxExternalThreads),
+        external_in_use_(kMaxExternalThreads) {
+    for (auto& deque : deques_) {
+      deque.reset(new TaskDeque());
+    }
+    for (auto& in_use : external_in_use_) {
+      in_use.store(false);
+    }
+    threads_.reserve(num_workers_);
+    for (int i = 0; i < num_workers_; ++i) {
+      threads_.emplace_back([this, i]() { worker_loop(i); });
+    }
+  }
+
+  int size() const {
+    return num_workers_;
+  }
+
+  bool in_pool() const {
+    return worker_id_ >= 0;
+  }
+
+  // Returns the calling thread's deque, or nullptr if it can't get one.
+  TaskDeque* local_deque() {
+    if (worker_id_ >= 0) {
+      return deques_[worker_id_].get();
+    }
+    auto& slot = external_slot_;
+    if (slot.index < 0 && !slot.exhausted) {
+      for (int i = 0; i < kMaxExternalThreads; ++i) {
+        bool expected = false;
+        if (external_in_use_[i].compare_exchange_strong(expected, true)) {
+          slot.index = i;
+          slot.pool = this;
+          int high_water = num_external_.load();
+          while (high_water < i + 1 &&
+                 !num_external_.compare_exchange_weak(high_water, i + 1)) {
+          }
+          break;
+        }
+      }
+      slot.exhausted = slot.index < 0;
+    }
+    if (slot.index < 0) {
+      return nullptr;
+    }
+    return deques_[num_workers_ + slot.index].get();
+  }
+
+  // Makes `count` newly pushed tasks visible to parked workers.
+  void wake(size_t count) {
+    // Pairs with the increment of num_sleeping_ in worker_loop, so that
+    // either we see the sleeper or it sees the pushed tasks.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (num_sleeping_.load() == 0) {
+      return;
+    }
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      ++wake_epoch_;
+    }
+    if (count > 1) {
+      sleep_cv_.notify_all();
+    } else {
+      sleep_cv_.notify_one();
+    }
+  }
+
+  // Runs one task from the local deque or stolen from another thread.
+  bool run_one() {
+    Task* task = find_task();
+    if (!task) {
+      return false;
+    }
+    task->run();
+    return true;
+  }
+
+ private:
+  struct ExternalSlot {
+    int index = -1;
+    bool exhausted = false;
+    WorkStealingPool* pool = nullptr;
+
+    ~ExternalSlot() {
+      if (pool) {
+        pool->external_in_use_[index].store(false);
+      }
+    }
+  };
+
+  Task* find_task() {
+    TaskDeque* own = local_deque();
+    if (own) {
+      if (Task* task = own->pop()) {
+        return task;
+      }
+    }
+    const int num_deques = num_workers_ + num_external_.load();
+    if (num_deques == 0) {
+      return nullptr;
+    }
+    // xorshift to pick a random first victim
+    auto& seed = steal_seed_;
+    seed ^= seed << 13;
+    seed ^= seed >> 7;
+    seed ^= seed << 17;
+    const int start = seed % num_deques;
+    for (int i = 0; i < num_deques; ++i) {
+      TaskDeque* victim = deques_[(start + i) % num_deques].get();
+      if (victim == own) {
+        continue;
+      }
+      if (Task* task = victim->steal()) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  void worker_loop(int id) {
+    worker_id_ = id;
+    steal_seed_ += id;
+    while (true) {
+      bool found = false;
+      for (int spin = 0; spin < kSpinCount; ++spin) {
+        if (run_one()) {
+          found = true;
+          break;
+        }
+        cpu_relax();
+      }
+      if (found) {
+        continue;
+      }
+
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      if (stop_) {
+        return;
+      }
+      const uint64_t epoch = wake_epoch_;
+      num_sleeping_.fetch_add(1);
+      // Check once more after announcing that we're about to sleep, so a
+      // task pushed in the meantime can't be missed.
+      lock.unlock();
+      Task* task = find_task();
+      lock.lock();
+      if (!task) {
+        sleep_cv_.wait(lock, [&] { return stop_ || wake_epoch_ != epoch; });
+      }
+      num_sleeping_.fetch_sub(1);
+      lock.unlock();
+      if (task) {
+        task->run();
+      }
+    }
+  }
+
+  const int num_workers_;
+  std::vector<std::unique_ptr<TaskDeque>> deques_;
+  std::vector<std::atomic<bool>> external_in_use_;
+  std::atomic<int> num_external_{0};
+  std::vector<std::thread> threads_;
+
+  std::mutex sleep_mutex_;
+  std::condition_variable sleep_cv_;
+  std::atomic<int> num_sleeping_{0};
+  uint64_t wake_epoch_ = 0;
+  bool stop_ = false;
+
+  static thread_local int worker_id_;
+  static thread_local uint32_t steal_seed_;
+  static thread_local ExternalSlot external_slot_;
+};
+
+thread_local int WorkStealingPool::worker_id_ = -1;
+thread_local uint32_t WorkStealingPool::steal_seed_ = 2463534242u;
+thread_local WorkStealingPool::ExternalSlot WorkStealingPool::external_slot_;
+
+const int NOT_SET = -1;
+const int CONSUMED = -2;
+
+// Number of threads set by the user
+// NOT_SET -> positive value -> CONSUMED
+// or
+// NOT_SET -> CONSUMED
+// Meaning:
+//  - NOT_SET - pool not initialized, user value is not set
+//  - positive value - pool not initialized, user value set
+//  - CONSUMED - pool is initialized
+std::atomic<int> num_intraop_threads{NOT_SET};
+
+int _num_pool_threads(int nthreads) {
+  if (nthreads == NOT_SET) {
+    nthreads = intraop_default_num_threads();
+  } else {
+    TORCH_INTERNAL_ASSERT(nthreads > 0);
+  }
+  // minus one because of the master thread
+  return nthreads - 1;
+}
+
+// The pool is intentionally leaked: its workers may still be parked when
+// static destructors run at exit.
+WorkStealingPool& _get_intraop_pool() {
+  static WorkStealingPool* pool = new WorkStealingPool(
+      _num_pool_threads(num_intraop_threads.exchange(CONSUMED)));
+  return *pool;
+}
+
+// Shared state of the tasks created by a single _parallel_run call.
+struct ParallelRunState {
+  const std::function<void(int64_t, int64_t, size_t)>* f;
+  internal::ParallelRegionProfile* profile;
+  int64_t begin;
+  int64_t end;
+  size_t chunk_size;
+  std::atomic<size_t> pending;
+  std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
+  std::exception_ptr eptr;
+};
+
+struct RangeTask : public Task {
+  ParallelRunState* state = nullptr;
+  size_t task_id = 0;
+
+  void run() override {
+    auto* s = state;
+    int64_t local_start = s->begin + task_id * s->chunk_size;
+    if (local_start < s->end) {
+      int64_t local_end =
+          std::min(s->end, (int64_t)(s->chunk_size + local_start));
+      try {
+        ParallelRegionGuard guard(task_id);
+        s->profile->run_task(*s->f, local_start, local_end, task_id);
+      } catch (...) {
+        if (!s->err_flag.test_and_set()) {
+          s->eptr = std::current_exception();
+        }
+      }
+    }
+    // The submitting thread may return (and free this task) as soon as
+    // the counter drops to zero, so this must be the last access.
+    s->pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+};
+
+struct FunctionTask : public Task {
+  explicit FunctionTask(std::function<void()> fn) : fn_(std::move(fn)) {}
+
+  void run() override {
+    std::unique_ptr<FunctionTask> self(this);
+    ParallelRegionGuard guard(0);
+    fn_();
+  }
+
+ private:
+  std::function<void()> fn_;
+};
+
+// Pushes a heap allocated task onto the calling thread's deque. Returns
+// false if the task should be run inline instead.
+bool _submit(std::function<void()>& func) {
+  if (get_num_threads() <= 1) {
+    return false;
+  }
+  auto& pool = _get_intraop_pool();
+  TaskDeque* deque = pool.local_deque();
+  if (!deque) {
+    return false;
+  }
+  auto* task = new FunctionTask(std::move(func));
+  if (!deque->push(task)) {
+    task->run();
+    return true;
+  }
+  pool.wake(1);
+  return true;
+}
+
+} // namespace
+
+namespace internal {
+
+void _parallel_run(
+  const int64_t begin,
+  const int64_t end,
+  const int64_t grain_size,
+  const std::function<void(int64_t, int64_t, size_t)>& f,
+  GrainSizeEstimator* estimator) {
+  size_t num_tasks, chunk_size;
+  std::tie(num_tasks, chunk_size) =
+      internal::calc_num_tasks_and_chunk_size(begin, end, grain_size);
+  internal::record_parallel_fanout(num_tasks);
+  internal::ParallelRegionProfile profile(
+      grain_size, num_tasks, estimator, end - begin);
+
+  ParallelRunState state;
+  state.f = &f;
+  state.profile = &profile;
+  state.begin = begin;
+  state.end = end;
+  state.chunk_size = chunk_size;
+  state.pending.store(num_tasks);
+
+  std::vector<RangeTask> tasks(num_tasks);
+  for (size_t task_id = 0; task_id < num_tasks; ++task_id) {
+    tasks[task_id].state = &state;
+    tasks[task_id].task_id = task_id;
+  }
+
+  auto& pool = _get_intraop_pool();
+  TaskDeque* deque = num_tasks > 1 && pool.size() > 0
+      ? pool.local_deque() : nullptr;
+  if (!deque) {
+    for (auto& task : tasks) {
+      task.run();
+    }
+  } else {
+    // Push in reverse so that thieves, which take from the top, start with
+    // the tasks this thread would get to last.
+    size_t pushed = 0;
+    for (size_t task_id = num_tasks - 1; task_id > 0; --task_id) {
+      if (deque->push(&tasks[task_id])) {
+        ++pushed;
+      } else {
+        tasks[task_id].run();
+      }
+    }
+    pool.wake(pushed);
+    tasks[0].run();
+
+    // Help out until all of our tasks are done. This may run tasks of other
+    // parallel regions, which is what makes nested parallelism work.
+    while (state.pending.load(std::memory_order_acquire) > 0) {
+      if (!pool.run_one()) {
+        cpu_relax();
+      }
+    }
+  }
+  profile.join();
+
+  if (state.eptr) {
+    std::rethrow_exception(state.eptr);
+  }
+}
+
+} // namespace internal
+
+void init_num_threads() {
+#ifdef _OPENMP
+  omp_set_num_threads(1);
+#endif
+
+#ifdef TH_BLAS_MKL
+  mkl_set_num_threads(1);
+#endif
+}
+
+void set_num_threads(int nthreads) {
+  TORCH_CHECK(nthreads > 0, "Expected positive number of threads");
+  int no_value = NOT_SET;
+  if (!num_intraop_threads.compare_exchange_strong(no_value, nthreads)) {
+    // num_intraop_threads either stores a positive integer or CONSUMED,
+    // check that requested size is the same as the current one
+    int stored_nthreads = num_intraop_threads.load();
+    if (stored_nthreads <= 0) {
+      // plus one because of master thread
+      stored_nthreads = _get_intraop_pool().size() + 1;
+    }
+    if (stored_nthreads != nthreads) {
+      TORCH_WARN(
+        "Cannot set number of intraop threads "
+        "after parallel work has started or after set_num_threads call "
+        "when using work-stealing parallel backend");
+    }
+  }
+}
+
+int get_num_threads() {
+  // not initializing pool unnecessarily,
+  // because pool cannot be resized after initialization
+  int nthreads = num_intraop_threads.load();
+  if (nthreads > 0) {
+    return nthreads;
+  } else if (nthreads == NOT_SET) {
+    return intraop_default_num_threads();
+  } else {
+    TORCH_INTERNAL_ASSERT(nthreads == CONSUMED);
+    return _get_intraop_pool().size() + 1;
+  }
+}
+
+int get_thread_num() {
+  return thread_num_;
+}
+
+bool in_parallel_region() {
+  return in_parallel_region_ || (
+    num_intraop_threads.load() == CONSUMED &&
+    // Needed as intraop_launch() tasks don't run inside _parallel_run.
+    _get_intraop_pool().in_pool()
+  );
+}
+
+void intraop_launch(std::function<void()> func) {
+  if (!_submit(func)) {
+    func();
+  }
+}
+
+std::shared_ptr<c10::ivalue::Future> intraop_launch_future(
+    std::function<void()> func) {
+  auto future = std::make_shared<c10::ivalue::Future>(c10::NoneType::get());
+  std::function<void()> task = [func, future]() {
+    func();
+    future->markCompleted();
+  };
+  if (!_submit(task)) {
+    task();
+  }
+  return future;
+}
+
+} // namespace at
+#endif
@@ -25,11 +25,18 @@ inline void parallel_for(
 #ifdef _OPENMP
   std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
   std::exception_ptr eptr;
+  static internal::GrainSizeEstimator estimator;
+  bool sample;
+  const int64_t adapted_grain_size =
+      estimator.grain_size(end - begin, grain_size, sample);
   // choose number of tasks based on grain size and number of threads
   int64_t num_threads = omp_in_parallel() ? 1 : omp_get_max_threads();
-  if (grain_size > 0) {
-    num_threads = std::min(num_threads, divup((end - begin), grain_size));
+  if (adapted_grain_size > 0) {
+    num_threads = std::min(num_threads, divup((end - begin), adapted_grain_size));
   }
+  internal::record_parallel_fanout(num_threads);
+  internal::ParallelRegionProfile profile(
+      adapted_grain_size, num_threads, sample ? &estimator : nullptr, end - begin);
 
 #pragma omp parallel num_threads(num_threads)
   {
@@ -39,7 +46,7 @@ inline void parallel_for(
     int64_t begin_tid = begin + tid * chunk_size;
     if (begin_tid < end) {
       try {
-        f(begin_tid, std::min(end, chunk_size + begin_tid));
+        profile.run_task(f, begin_tid, std::min(end, chunk_size + begin_tid));
       } catch (...) {
         if (!err_flag.test_and_set()) {
           eptr = std::current_exception();
@@ -47,10 +54,12 @@ inline void parallel_for(
       }
     }
   }
+  profile.join();
   if (eptr) {
     std::rethrow_exception(eptr);
   }
 #else
+  internal::record_parallel_fanout(1);
   f(begin, end);
 #endif
 }
@@ -67,24 +76,38 @@ inline scalar_t parallel_reduce(
   if (begin >= end) {
     return ident;
   } else if (in_parallel_region() || get_num_threads() == 1) {
+    internal::record_parallel_fanout(1);
     return f(begin, end, ident);
   } else {
-    const int64_t num_results = divup((end - begin), grain_size);
+    static internal::GrainSizeEstimator estimator;
+    bool sample;
+    const int64_t adapted_grain_size =
+        estimator.grain_size(end - begin, grain_size, sample);
+    const bool split = (end - begin) >= adapted_grain_size;
+    const int64_t num_results = divup((end - begin), adapted_grain_size);
+    internal::record_parallel_fanout(split ? num_results : 1);
+    internal::ParallelRegionProfile profile(
+        adapted_grain_size,
+        split ? num_results : 1,
+        sample ? &estimator : nullptr,
+        end - begin);
     std::vector<scalar_t> results(num_results);
     scalar_t* results_data = results.data();
     std::atomic_flag err_flag = ATOMIC_FLAG_INIT;
     std::exception_ptr eptr;
-#pragma omp parallel for if ((end - begin) >= grain_size)
+#pragma omp parallel for if (split)
     for (int64_t id = 0; id < num_results; id++) {
-      int64_t i = begin + id * grain_size;
+      int64_t i = begin + id * adapted_grain_size;
       try {
-        results_data[id] = f(i, i + std::min(end - i, grain_size), ident);
+        results_data[id] = profile.run_task(
+            f, i, i + std::min(end - i, adapted_grain_size), ident);
       } catch (...) {
         if (!err_flag.test_and_set()) {
           eptr = std::current_exception();
         }
       }
     }
+    profile.join();
     if (eptr) {
       std::rethrow_exception(eptr);
     }
@@ -1,4 +1,4 @@
-#if AT_PARALLEL_OPENMP || AT_PARALLEL_NATIVE || AT_PARALLEL_NATIVE_TBB
+#if AT_PARALLEL_OPENMP || AT_PARALLEL_NATIVE || AT_PARALLEL_NATIVE_TBB || AT_PARALLEL_NATIVE_WS
 #include <ATen/Parallel.h>
 #include <ATen/PTThreadPool.h>
 #include <ATen/ThreadLocalDebugInfo.h>
@@ -18,16 +18,19 @@ const int CONSUMED = -2;
 // NOT_SET -> CONSUMED
 std::atomic<int> num_interop_threads{NOT_SET};
 
-// thread pool global instance is hidden,
-// users should use at::launch and get/set_num_interop_threads interface
+// thread pool global instances are hidden,
+// users should use at::launch and get/set_num_interop_threads interface;
+// with NUMA enabled there is one pool per node, see PTThreadPools
 TaskThreadPoolBase& get_pool() {
-  static std::shared_ptr<TaskThreadPoolBase> pool =
-      ThreadPoolRegistry()->Create(
-          "C10",
-          /* device_id */ 0,
-          /* pool_size */ num_interop_threads.exchange(CONSUMED),
-          /* create_new */ true);
-  return *pool;
+  static const int pool_size = num_interop_threads.exchange(CONSUMED);
+  static PTThreadPools pools([](int numa_node_id) {
+    return ThreadPoolRegistry()->Create(
+        "C10",
+        /* device_id */ numa_node_id,
+        /* pool_size */ pool_size,
+        /* create_new */ true);
+  });
+  return pools.get();
 }
 
 // Factory function for ThreadPoolRegistry
@@ -35,11 +38,14 @@ std::shared_ptr<TaskThreadPoolBase> create_c10_threadpool(
     int device_id,
     int pool_size,
     bool create_new) {
-  // For now, the only accepted device id is 0
-  TORCH_CHECK(device_id == 0);
+  // The device id is the NUMA node the threads are bound to, -1 being any,
+  // and 0 is also accepted when NUMA is disabled
+  TORCH_CHECK(device_id >= -1 &&
+              (device_id == 0 || device_id < c10::GetNumNUMANodes()),
+              "invalid NUMA node ", device_id, " for a thread pool");
   // Create new thread pool
   TORCH_CHECK(create_new);
-  return std::make_shared<PTThreadPool>(pool_size);
+  return std::make_shared<PTThreadPool>(pool_size, device_id);
 }
 
 } // namespace
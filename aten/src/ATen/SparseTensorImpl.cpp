@@ -123,6 +123,7 @@ void SparseTensorImpl::set_indices_and_values_unsafe(const Tensor& indices, cons
   AT_ASSERT(values_.device() == indices_.device());
 
   coalesced_ = false;
+  clear_csr_indices();
 }
 
 
@@ -4,6 +4,9 @@
 #include <c10/core/TensorImpl.h>
 #include <c10/util/Exception.h>
 
+#include <mutex>
+#include <utility>
+
 namespace at {
 struct CAFFE2_API SparseTensorImpl : public TensorImpl {
   // Stored in COO format, indices + values.
@@ -29,6 +32,17 @@ struct CAFFE2_API SparseTensorImpl : public TensorImpl {
   // because many algorithms proceed by merging two sorted lists (of indices).
   bool coalesced_ = false;
 
+  // The compressed sparse row (CSR) form of a coalesced tensor with two sparse
+  // dimensions, cached by the matrix products using it so that a
+  // matrix multiplied many times is only converted once.  crow_indices holds
+  // the offset of the first entry of every row followed by nnz, col_indices
+  // the column of every entry; their integer type is the one the kernels of
+  // the device use.  The cache is dropped whenever the sizes, the indices or
+  // the coalesced flag change.
+  mutable std::mutex csr_mutex_;
+  mutable Tensor csr_crow_indices_;
+  mutable Tensor csr_col_indices_;
+
 public:
   // Public for now...
   explicit SparseTensorImpl(at::TensorTypeSet, const caffe2::TypeMeta&);
@@ -40,6 +54,21 @@ public:
   Tensor indices() const { return indices_; }
   Tensor values() const { return values_; }
 
+  // Returns the cached CSR form as (crow_indices, col_indices), or undefined
+  // tensors if there is none.
+  std::pair<Tensor, Tensor> csr_indices() const {
+    std::lock_guard<std::mutex> guard(csr_mutex_);
+    return std::make_pair(csr_crow_indices_, csr_col_indices_);
+  }
+
+  // Caches the CSR form of this tensor, which must be a coalesced matrix.
+  void set_csr_indices(Tensor crow_indices, Tensor col_indices) const {
+    AT_ASSERT(coalesced_ && sparse_dim_ == 2);
+    std::lock_guard<std::mutex> guard(csr_mutex_);
+    csr_crow_indices_ = std::move(crow_indices);
+    csr_col_indices_ = std::move(col_indices);
+  }
+
   IntArrayRef strides() const override;
   bool is_contiguous(at::MemoryFormat memory_format=at::MemoryFormat::Contiguous) const override;
   int64_t stride(int64_t d) const override;
@@ -62,6 +91,7 @@ public:
     sparse_dim_ = sparse_dim;
     dense_dim_ = dense_dim;
     refresh_numel();
+    clear_csr_indices();
   }
 
   // NOTE: This function preserves invariants of sparse_dim/dense_dim with respect to
@@ -141,6 +171,7 @@ public:
     sparse_dim_ = sparse_dim;
     dense_dim_ = dense_dim;
     refresh_numel();
+    clear_csr_indices();
   }
 
   // NOTE: this function will resize the sparse tensor and also set `indices` and `values` to empty.
@@ -164,6 +195,7 @@ public:
   void set_coalesced(bool coalesced) {
     TORCH_CHECK(allow_tensor_metadata_change(), "set_coalesced ", err_msg_tensor_metadata_change_not_allowed);
     coalesced_ = coalesced;
+    clear_csr_indices();
   }
 
   // NOTE: this function is only used internally and not exposed to Python frontend
@@ -172,6 +204,7 @@ public:
     AT_ASSERT(new_nnz <= nnz());
     indices_ = indices_.narrow(1, 0, new_nnz);
     values_ = values_.narrow(0, 0, new_nnz);
+    clear_csr_indices();
   }
 
   // Takes indices and values and directly puts them into the sparse tensor, no copy.
@@ -221,6 +254,12 @@ public:
 private:
     explicit SparseTensorImpl(at::TensorTypeSet, const caffe2::TypeMeta&, at::Tensor indices, at::Tensor values);
 
+  void clear_csr_indices() {
+    std::lock_guard<std::mutex> guard(csr_mutex_);
+    csr_crow_indices_.reset();
+    csr_col_indices_.reset();
+  }
+
   /**
    * Copy the tensor metadata fields (e.g. sizes / strides / storage pointer / storage_offset)
    * from one TensorImpl to another TensorImpl.
@@ -240,6 +279,10 @@ private:
     dest_sparse_impl->indices_ = src_sparse_impl->indices();
     dest_sparse_impl->values_ = src_sparse_impl->values();
     dest_sparse_impl->coalesced_ = src_sparse_impl->coalesced();
+    auto csr = src_sparse_impl->csr_indices();
+    std::lock_guard<std::mutex> guard(dest_sparse_impl->csr_mutex_);
+    dest_sparse_impl->csr_crow_indices_ = std::move(csr.first);
+    dest_sparse_impl->csr_col_indices_ = std::move(csr.second);
   }
 };
 
@@ -0,0 +1,280 @@
+#include <ATen/autocast_mode.h>
+
+#include <ATen/core/op_registration/op_registration.h>
+#include <c10/core/impl/LocalTensorTypeSet.h>
+#include <c10/util/Metaprogramming.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Note [Autocast]
+// ~~~~~~~~~~~~~~~
+// While autocast is enabled, AutocastTensorId is in the thread local included
+// type set, so that the ops with an autocast kernel dispatch to it before
+// anything else. The kernel casts the fp32 and fp16 CUDA tensors among the
+// inputs to the dtype of the policy of the op, then calls the op again with
+// autocast excluded:
+//
+//  - fp16: the ops that run on tensor cores, i.e. matmuls and convolutions.
+//  - fp32: the ops that lose too much precision or overflow in fp16, i.e.
+//    reductions, softmax, norms, losses and pointwise ops like exp or pow.
+//  - promote: the ops whose inputs must share a dtype, which all get the
+//    widest dtype among them.
+//
+// The ops without an autocast kernel skip the key and run in the dtype of
+// their inputs. Autocast dispatches before variable, so autograd records the
+// casts and the gradients flow back in the dtype of the original tensors.
+// CPU tensors and doubles are never cast.
+//
+// The fp16 copies of the leaves requiring grad, i.e. the weights, are cached
+// until clear_cache(), so that a weight used several times is only cast once.
+// torch.cuda.amp.autocast clears the cache when it exits its outermost
+// region, which means that a weight updated in place within a region is used
+// with its stale copy until then.
+
+namespace at {
+namespace autocast {
+
+bool is_enabled() {
+  return c10::impl::tls_is_tensor_type_id_included(TensorTypeId::AutocastTensorId);
+}
+
+void set_enabled(bool enabled) {
+  c10::impl::tls_set_tensor_type_id_included(TensorTypeId::AutocastTensorId, enabled);
+}
+
+namespace {
+
+// The source tensors are kept alive so that no other tensor reuses their
+// TensorImpl meanwhile.
+thread_local std::unordered_map<TensorImpl*, std::pair<Tensor, Tensor>> cached_casts;
+
+bool is_eligible(const Tensor& arg) {
+  return arg.defined() && arg.is_cuda() &&
+      (arg.scalar_type() == at::kFloat || arg.scalar_type() == at::kHalf);
+}
+
+Tensor cached_cast(ScalarType to_type, const Tensor& arg) {
+  if (!is_eligible(arg) || arg.scalar_type() == to_type) {
+    return arg;
+  }
+  if (to_type == at::kHalf && arg.requires_grad() && arg.is_leaf()) {
+    auto it = cached_casts.find(arg.unsafeGetTensorImpl());
+    if (it != cached_casts.end()) {
+      return it->second.second;
+    }
+    Tensor casted = arg.to(to_type);
+    cached_casts.emplace(arg.unsafeGetTensorImpl(), std::make_pair(arg, casted));
+    return casted;
+  }
+  return arg.to(to_type);
+}
+
+std::vector<Tensor> cached_cast(ScalarType to_type, TensorList args) {
+  std::vector<Tensor> casted;
+  casted.reserve(args.size());
+  for (const Tensor& arg : args) {
+    casted.push_back(cached_cast(to_type, arg));
+  }
+  return casted;
+}
+
+// Everything but tensors is passed through.
+template <class T>
+T cached_cast(ScalarType /*to_type*/, T arg) {
+  return arg;
+}
+
+ScalarType widest_type(ScalarType current, const Tensor& arg) {
+  return is_eligible(arg) && arg.scalar_type() == at::kFloat ? at::kFloat : current;
+}
+
+ScalarType widest_type(ScalarType current, TensorList args) {
+  for (const Tensor& arg : args) {
+    current = widest_type(current, arg);
+  }
+  return current;
+}
+
+template <class T>
+ScalarType widest_type(ScalarType current, const T& /*arg*/) {
+  return current;
+}
+
+ScalarType promote_type(ScalarType current) {
+  return current;
+}
+
+template <class Arg, class... Args>
+ScalarType promote_type(ScalarType current, const Arg& arg, const Args&... args) {
+  return promote_type(widest_type(current, arg), args...);
+}
+
+enum class CastPolicy { fp16, fp32, promote };
+
+template <CastPolicy policy, class FuncType, FuncType* F, class Ret, class ArgList>
+struct WrapFunction_ {};
+
+template <CastPolicy policy, class FuncType, FuncType* F, class Ret, class... Args>
+struct WrapFunction_<policy, FuncType, F, Ret, guts::typelist::typelist<Args...>> {
+  static Ret call(Args... args) {
+    c10::impl::ExcludeTensorTypeIdGuard no_autocast(TensorTypeId::AutocastTensorId);
+    const ScalarType to_type = policy == CastPolicy::fp16
+        ? at::kHalf
+        : policy == CastPolicy::fp32 ? at::kFloat : promote_type(at::kHalf, args...);
+    return (*F)(cached_cast(to_type, args)...);
+  }
+};
+
+// The autocast kernel of the op F, which has the signature FuncType
+template <CastPolicy policy, class FuncType, FuncType* F>
+struct WrapFunction final {
+  using type = WrapFunction_<
+      policy,
+      FuncType,
+      F,
+      typename guts::function_traits<FuncType>::return_type,
+      typename guts::function_traits<FuncType>::parameter_types>;
+};
+
+#define KERNEL(FUNC, SCHEMA, POLICY, ...)                               \
+  .op(torch::RegisterOperators::options()                               \
+          .schema(SCHEMA)                                               \
+          .impl_unboxedOnlyC10Kernel<                                   \
+              __VA_ARGS__,                                              \
+              &WrapFunction<CastPolicy::POLICY, __VA_ARGS__, &FUNC>::   \
+                  type::call>(TensorTypeId::AutocastTensorId)           \
+          .aliasAnalysis(c10::AliasAnalysisKind::FROM_SCHEMA))
+
+auto registerer = torch::RegisterOperators()
+  // fp16
+  KERNEL(at::conv1d, "aten::conv1d(Tensor input, Tensor weight, Tensor? bias=None, int[1] stride=1, int[1] padding=0, int[1] dilation=1, int groups=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t))
+  KERNEL(at::conv2d, "aten::conv2d(Tensor input, Tensor weight, Tensor? bias=None, int[2] stride=1, int[2] padding=0, int[2] dilation=1, int groups=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t))
+  KERNEL(at::conv3d, "aten::conv3d(Tensor input, Tensor weight, Tensor? bias=None, int[3] stride=1, int[3] padding=0, int[3] dilation=1, int groups=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t))
+  KERNEL(at::conv_transpose1d, "aten::conv_transpose1d(Tensor input, Tensor weight, Tensor? bias=None, int[1] stride=1, int[1] padding=0, int[1] output_padding=0, int groups=1, int[1] dilation=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t, IntArrayRef))
+  KERNEL(at::conv_transpose2d, "aten::conv_transpose2d.input(Tensor input, Tensor weight, Tensor? bias=None, int[2] stride=1, int[2] padding=0, int[2] output_padding=0, int groups=1, int[2] dilation=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t, IntArrayRef))
+  KERNEL(at::conv_transpose3d, "aten::conv_transpose3d.input(Tensor input, Tensor weight, Tensor? bias=None, int[3] stride=1, int[3] padding=0, int[3] output_padding=0, int groups=1, int[3] dilation=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, IntArrayRef, IntArrayRef, IntArrayRef, int64_t, IntArrayRef))
+  KERNEL(at::prelu, "aten::prelu(Tensor self, Tensor weight) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::addmm, "aten::addmm(Tensor self, Tensor mat1, Tensor mat2, *, Scalar beta=1, Scalar alpha=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar, Scalar))
+  KERNEL(at::addmv, "aten::addmv(Tensor self, Tensor mat, Tensor vec, *, Scalar beta=1, Scalar alpha=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar, Scalar))
+  KERNEL(at::addr, "aten::addr(Tensor self, Tensor vec1, Tensor vec2, *, Scalar beta=1, Scalar alpha=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar, Scalar))
+  KERNEL(at::matmul, "aten::matmul(Tensor self, Tensor other) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::mm, "aten::mm(Tensor self, Tensor mat2) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::mv, "aten::mv(Tensor self, Tensor vec) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::addbmm, "aten::addbmm(Tensor self, Tensor batch1, Tensor batch2, *, Scalar beta=1, Scalar alpha=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar, Scalar))
+  KERNEL(at::baddbmm, "aten::baddbmm(Tensor self, Tensor batch1, Tensor batch2, *, Scalar beta=1, Scalar alpha=1) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar, Scalar))
+  KERNEL(at::bmm, "aten::bmm(Tensor self, Tensor mat2) -> Tensor", fp16,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::chain_matmul, "aten::chain_matmul(Tensor[] matrices) -> Tensor", fp16,
+         Tensor (TensorList))
+  // fp32
+  KERNEL(at::softmax, "aten::softmax.int(Tensor self, int dim, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, int64_t, c10::optional<ScalarType>))
+  KERNEL(at::log_softmax, "aten::log_softmax.int(Tensor self, int dim, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, int64_t, c10::optional<ScalarType>))
+  KERNEL(at::sum, "aten::sum(Tensor self, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, c10::optional<ScalarType>))
+  KERNEL(at::sum, "aten::sum.dim_IntList(Tensor self, int[1] dim, bool keepdim=False, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, IntArrayRef, bool, c10::optional<ScalarType>))
+  KERNEL(at::mean, "aten::mean(Tensor self, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, c10::optional<ScalarType>))
+  KERNEL(at::mean, "aten::mean.dim(Tensor self, int[1] dim, bool keepdim=False, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, IntArrayRef, bool, c10::optional<ScalarType>))
+  KERNEL(at::prod, "aten::prod(Tensor self, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, c10::optional<ScalarType>))
+  KERNEL(at::cumsum, "aten::cumsum(Tensor self, int dim, *, ScalarType? dtype=None) -> Tensor", fp32,
+         Tensor (const Tensor&, int64_t, c10::optional<ScalarType>))
+  KERNEL(at::exp, "aten::exp(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::log, "aten::log(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::log10, "aten::log10(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::log2, "aten::log2(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::log1p, "aten::log1p(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::reciprocal, "aten::reciprocal(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::rsqrt, "aten::rsqrt(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::pow, "aten::pow.Tensor_Scalar(Tensor self, Scalar exponent) -> Tensor", fp32,
+         Tensor (const Tensor&, Scalar))
+  KERNEL(at::pow, "aten::pow.Tensor_Tensor(Tensor self, Tensor exponent) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::layer_norm, "aten::layer_norm(Tensor input, int[] normalized_shape, Tensor? weight=None, Tensor? bias=None, float eps=1e-05, bool cudnn_enable=True) -> Tensor", fp32,
+         Tensor (const Tensor&, IntArrayRef, const Tensor&, const Tensor&, double, bool))
+  KERNEL(at::group_norm, "aten::group_norm(Tensor input, int num_groups, Tensor? weight=None, Tensor? bias=None, float eps=1e-05, bool cudnn_enabled=True) -> Tensor", fp32,
+         Tensor (const Tensor&, int64_t, const Tensor&, const Tensor&, double, bool))
+  KERNEL(at::norm, "aten::norm.Scalar(Tensor self, Scalar p=2) -> Tensor", fp32,
+         Tensor (const Tensor&, Scalar))
+  KERNEL(at::frobenius_norm, "aten::frobenius_norm(Tensor self) -> Tensor", fp32,
+         Tensor (const Tensor&))
+  KERNEL(at::cosine_similarity, "aten::cosine_similarity(Tensor x1, Tensor x2, int dim=1, float eps=1e-08) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, int64_t, double))
+  KERNEL(at::dist, "aten::dist(Tensor self, Tensor other, Scalar p=2) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, Scalar))
+  KERNEL(at::cdist, "aten::cdist(Tensor x1, Tensor x2, float p=2, int? compute_mode=None) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, double, c10::optional<int64_t>))
+  KERNEL(at::pdist, "aten::pdist(Tensor self, float p=2) -> Tensor", fp32,
+         Tensor (const Tensor&, double))
+  KERNEL(at::binary_cross_entropy_with_logits, "aten::binary_cross_entropy_with_logits(Tensor self, Tensor target, Tensor? weight=None, Tensor? pos_weight=None, int reduction=Mean) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, const Tensor&, int64_t))
+  KERNEL(at::mse_loss, "aten::mse_loss(Tensor self, Tensor target, int reduction=Mean) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, int64_t))
+  KERNEL(at::l1_loss, "aten::l1_loss(Tensor self, Tensor target, int reduction=Mean) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, int64_t))
+  KERNEL(at::smooth_l1_loss, "aten::smooth_l1_loss(Tensor self, Tensor target, int reduction=Mean) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, int64_t))
+  KERNEL(at::kl_div, "aten::kl_div(Tensor self, Tensor target, int reduction=Mean) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, int64_t))
+  KERNEL(at::nll_loss, "aten::nll_loss(Tensor self, Tensor target, Tensor? weight=None, int reduction=Mean, int ignore_index=-100) -> Tensor", fp32,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, int64_t, int64_t))
+  KERNEL(at::softplus, "aten::softplus(Tensor self, Scalar beta=1, Scalar threshold=20) -> Tensor", fp32,
+         Tensor (const Tensor&, Scalar, Scalar))
+  // promote
+  KERNEL(at::cat, "aten::cat(Tensor[] tensors, int dim=0) -> Tensor", promote,
+         Tensor (TensorList, int64_t))
+  KERNEL(at::stack, "aten::stack(Tensor[] tensors, int dim=0) -> Tensor", promote,
+         Tensor (TensorList, int64_t))
+  KERNEL(at::addcmul, "aten::addcmul(Tensor self, Tensor tensor1, Tensor tensor2, *, Scalar value=1) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar))
+  KERNEL(at::addcdiv, "aten::addcdiv(Tensor self, Tensor tensor1, Tensor tensor2, *, Scalar value=1) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, Scalar))
+  KERNEL(at::atan2, "aten::atan2(Tensor self, Tensor other) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::cross, "aten::cross(Tensor self, Tensor other, int? dim=None) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&, c10::optional<int64_t>))
+  KERNEL(at::dot, "aten::dot(Tensor self, Tensor tensor) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&))
+  KERNEL(at::bilinear, "aten::bilinear(Tensor input1, Tensor input2, Tensor weight, Tensor? bias) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&, const Tensor&, const Tensor&))
+  KERNEL(at::tensordot, "aten::tensordot(Tensor self, Tensor other, int[] dims_self, int[] dims_other) -> Tensor", promote,
+         Tensor (const Tensor&, const Tensor&, IntArrayRef, IntArrayRef));
+
+#undef KERNEL
+
+} // namespace
+
+void clear_cache() {
+  cached_casts.clear();
+}
+
+} // namespace autocast
+} // namespace at
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+namespace at {
+namespace autocast {
+
+// Whether the ops of this thread run in the dtypes of the autocast policy,
+// see Note [Autocast]
+CAFFE2_API bool is_enabled();
+CAFFE2_API void set_enabled(bool enabled);
+
+// Drops the fp16 copies of the weights this thread cast since the last call
+CAFFE2_API void clear_cache();
+
+} // namespace autocast
+} // namespace at
@@ -45,6 +45,15 @@ static inline TensorTypeId dispatchTypeId(TensorTypeSet ts) {
   return ((ts | local.included_) - local.excluded_).highestPriorityTypeId();
 }
 
+// The dispatch id of an op that has no autocast kernel while autocast is
+// enabled, see Note [Autocast]
+static inline TensorTypeId dispatchTypeIdSkippingAutocast(TensorTypeSet ts) {
+  c10::impl::LocalTensorTypeSet local = c10::impl::tls_local_tensor_type_set();
+  return ((ts | local.included_) - local.excluded_)
+      .remove(TensorTypeId::AutocastTensorId)
+      .highestPriorityTypeId();
+}
+
 }
 
 namespace detail {
@@ -219,6 +228,10 @@ Result ATenOpTable::callUnboxed(Args... args) const {
   // NB: No universal forwarding (takes const& only)
   TensorTypeSet ts = detail::multi_dispatch_tensor_type_set(args...);
   TensorTypeId tid = impl::dispatchTypeId(ts);
+  if (C10_UNLIKELY(tid == TensorTypeId::AutocastTensorId) &&
+      function_table_[static_cast<int64_t>(tid)] == nullptr) {
+    tid = impl::dispatchTypeIdSkippingAutocast(ts);
+  }
 
   // You might think we can eliminate the second branch by maintaining a
   // bitmask of registered operator keys, so we don't select dispatch ids
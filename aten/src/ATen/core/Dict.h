@@ -6,6 +6,7 @@
 #include <c10/util/intrusive_ptr.h>
 #include <c10/util/order_preserving_flat_hash_map.h>
 #include <c10/util/Optional.h>
+#include <c10/util/PoolAllocated.h>
 #include <ATen/core/TensorBody.h>
 
 namespace c10 {
@@ -38,7 +39,8 @@ struct DictKeyEqualTo {
   }
 };
 
-struct DictImpl final : public c10::intrusive_ptr_target {
+struct DictImpl final : public c10::intrusive_ptr_target,
+                        public c10::PoolAllocated<DictImpl> {
   using dict_map_type = ska_ordered::order_preserving_flat_hash_map<IValue, IValue, DictKeyHash, DictKeyEqualTo>;
   struct DictElementTypes final {
     TypePtr keyType;
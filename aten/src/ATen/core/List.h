@@ -6,6 +6,7 @@
 #include <c10/util/intrusive_ptr.h>
 #include <c10/util/ArrayRef.h>
 #include <c10/util/Optional.h>
+#include <c10/util/PoolAllocated.h>
 #include <vector>
 
 namespace at {
@@ -20,7 +21,8 @@ using TypePtr = std::shared_ptr<Type>;
 namespace detail {
 
 template<class StorageT>
-struct ListImpl final : public c10::intrusive_ptr_target {
+struct ListImpl final : public c10::intrusive_ptr_target,
+                        public c10::PoolAllocated<ListImpl<StorageT>> {
   using list_type = std::vector<StorageT>;
 
   explicit ListImpl(list_type list_, TypePtr elementType_)
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <ATen/core/boxing/KernelFunction.h>
+#include <c10/core/TensorTypeId.h>
+
+#include <atomic>
+#include <cstdint>
+
+namespace c10 {
+
+namespace impl {
+class OperatorEntry;
+}
+
+/**
+ * An inline cache for the calls of one operator from one call site, e.g. an
+ * instruction of the JIT interpreter. It remembers the dispatch key of the
+ * last call and the kernel it resolved to, so that the next call with the
+ * same dispatch key skips the dispatch table.
+ *
+ * Any kernel registration or deregistration for the operator invalidates the
+ * cache. It can be used from several threads at once, an update that races
+ * with another one is dropped. Copies of a cache start empty, so that copies
+ * of a call site don't share it.
+ *
+ * Usage:
+ *
+ * > c10::DispatchCache cache;
+ * > c10::Dispatcher::singleton().callBoxed(op, &stack, &cache);
+ */
+class CAFFE2_API DispatchCache final {
+public:
+  DispatchCache() = default;
+  DispatchCache(const DispatchCache&) {}
+  DispatchCache& operator=(const DispatchCache&) {
+    return *this;
+  }
+
+private:
+  friend class impl::OperatorEntry;
+
+  // Returns the cached kernel, or nullptr if the cache holds another
+  // dispatch key, an older version of the dispatch table or is being updated.
+  const KernelFunction* lookup(TensorTypeId dispatch_key, uint64_t version) const {
+    // a seqlock: the fields are consistent if seq_ is even and didn't change
+    // while reading them
+    uint64_t seq = seq_.load(std::memory_order_acquire);
+    if (seq & 1) {
+      return nullptr;
+    }
+    auto cached_key = dispatch_key_.load(std::memory_order_relaxed);
+    auto cached_version = version_.load(std::memory_order_relaxed);
+    auto kernel = kernel_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq_.load(std::memory_order_relaxed) != seq ||
+        cached_key != dispatch_key || cached_version != version) {
+      return nullptr;
+    }
+    return kernel;
+  }
+
+  void update(TensorTypeId dispatch_key, uint64_t version, const KernelFunction* kernel) {
+    uint64_t seq = seq_.load(std::memory_order_relaxed);
+    if ((seq & 1) || !seq_.compare_exchange_strong(seq, seq + 1, std::memory_order_relaxed)) {
+      return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+    dispatch_key_.store(dispatch_key, std::memory_order_relaxed);
+    version_.store(version, std::memory_order_relaxed);
+    kernel_.store(kernel, std::memory_order_relaxed);
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  std::atomic<uint64_t> seq_{0};
+  std::atomic<TensorTypeId> dispatch_key_{TensorTypeId::UndefinedTensorId};
+  // dispatch table versions start at 1, an empty cache never matches
+  std::atomic<uint64_t> version_{0};
+  std::atomic<const KernelFunction*> kernel_{nullptr};
+};
+
+} // namespace c10
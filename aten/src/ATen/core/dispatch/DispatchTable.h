@@ -68,6 +68,59 @@ class KernelTable_ final {
  private:
    ska::flat_hash_map<TensorTypeId, KernelFunction> map_;
 };
+
+struct DispatchStrategy final {
+  // this is caching the index so we don't have to parse the schema inputs
+  // again and again for each dispatcher lookup.
+  // num_args_ is allowed to be zero; that just means you must do the
+  // fallthrough
+  // TODO: a potential optimization is to store a bitfield of arg locations,
+  size_t num_args_;
+
+  // An invalid dispatch strategy means we can't dispatch any kernels.
+  // You're able to create a dispatch table with an invalid dispatch strategy,
+  // but adding kernels to it will fail.
+  // This is used to allow creating operators with empty argument lists
+  // as long as they only have fallback kernels and no dispatched kernels.
+  bool is_valid_;
+
+  TensorTypeId get_dispatch_key(const Stack* stack, const std::string& operator_name) const {
+
+    TensorTypeSet ts;
+    for (const auto& ivalue : torch::jit::last(*stack, num_args_)) {
+      if (C10_LIKELY(ivalue.isTensor())) {
+        // NB: Take care not to introduce a refcount bump (there's
+        // no safe toTensorRef method, alas)
+        ts = ts | ivalue.unsafeToTensorImpl()->type_set();
+      } else if (C10_UNLIKELY(ivalue.isTensorList())) {
+        for (const auto& tensor : ivalue.toTensorListRef()) {
+          ts = ts | tensor.type_set();
+        }
+      }
+    }
+    // TODO: Don't use legacy extractor; blocked on c10 understanding
+    // variable
+    return c10::legacyExtractTypeId(ts);
+  }
+};
+
+inline DispatchStrategy get_dispatch_strategy(const FunctionSchema& schema) {
+  bool is_valid = false;
+  for (size_t i = 0; i < schema.arguments().size(); ++i) {
+    const auto& type = schema.arguments()[i].type();
+    if (type->isSubtypeOf(TensorType::get())) {
+      is_valid = true;
+      break;
+    }
+    if (type->isSubtypeOf(ListType::ofTensors())) {
+      is_valid = true;
+      break;
+    }
+  }
+
+  return {schema.arguments().size(), is_valid};
+}
+
 } // namespace detail
 
 /**
@@ -84,7 +137,7 @@ class DispatchTable final {
   DispatchTable(const FunctionSchema& schema)
   : kernels_()
   , catchall_kernel_(c10::nullopt)
-  , dispatch_strategy_(get_dispatch_strategy_(schema))
+  , dispatch_strategy_(detail::get_dispatch_strategy(schema))
   , operator_name_(schema.name()) {}
 
   /**
@@ -155,6 +208,11 @@ class DispatchTable final {
      return lookup_([=] () -> c10::optional<TensorTypeId> { return dispatchKey;});
    }
 
+   // Only looks for a kernel registered for `dispatchKey`, not the catch-all one
+   bool hasKernelFor(TensorTypeId dispatchKey) const {
+     return kernels_.lookup(dispatchKey) != nullptr;
+   }
+
    bool isEmpty() const {
      return !catchall_kernel_.has_value() && kernels_.size() == 0;
    }
@@ -168,58 +226,6 @@ class DispatchTable final {
    }
 
 private:
-  struct DispatchStrategy final {
-    // this is caching the index so we don't have to parse the schema inputs
-    // again and again for each dispatcher lookup.
-    // num_args_ is allowed to be zero; that just means you must do the
-    // fallthrough
-    // TODO: a potential optimization is to store a bitfield of arg locations,
-    size_t num_args_;
-
-    // An invalid dispatch strategy means we can't dispatch any kernels.
-    // You're able to create a dispatch table with an invalid dispatch strategy,
-    // but adding kernels to it will fail.
-    // This is used to allow creating operators with empty argument lists
-    // as long as they only have fallback kernels and no dispatched kernels.
-    bool is_valid_;
-
-    TensorTypeId get_dispatch_key(const Stack* stack, const std::string& operator_name) const {
-
-      TensorTypeSet ts;
-      for (const auto& ivalue : torch::jit::last(*stack, num_args_)) {
-        if (C10_LIKELY(ivalue.isTensor())) {
-          // NB: Take care not to introduce a refcount bump (there's
-          // no safe toTensorRef method, alas)
-          ts = ts | ivalue.unsafeToTensorImpl()->type_set();
-        } else if (C10_UNLIKELY(ivalue.isTensorList())) {
-          for (const auto& tensor : ivalue.toTensorListRef()) {
-            ts = ts | tensor.type_set();
-          }
-        }
-      }
-      // TODO: Don't use legacy extractor; blocked on c10 understanding
-      // variable
-      return c10::legacyExtractTypeId(ts);
-    }
-  };
-
-  static DispatchStrategy get_dispatch_strategy_(const FunctionSchema& schema) {
-    bool is_valid = false;
-    for (size_t i = 0; i < schema.arguments().size(); ++i) {
-      const auto& type = schema.arguments()[i].type();
-      if (type->isSubtypeOf(TensorType::get())) {
-        is_valid = true;
-        break;
-      }
-      if (type->isSubtypeOf(ListType::ofTensors())) {
-        is_valid = true;
-        break;
-      }
-    }
-
-    return {schema.arguments().size(), is_valid};
-  }
-
   template<class GetDispatchKeyFunc>
   const KernelFunction& lookup_(const GetDispatchKeyFunc& getDispatchKey) const {
       c10::optional<TensorTypeId> dispatch_key = getDispatchKey();
@@ -251,7 +257,7 @@ private:
 
   detail::KernelTable_ kernels_;
   c10::optional<KernelFunction> catchall_kernel_;
-  DispatchStrategy dispatch_strategy_;
+  detail::DispatchStrategy dispatch_strategy_;
   std::string operator_name_;
 };
 
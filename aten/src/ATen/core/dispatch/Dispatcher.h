@@ -98,6 +98,15 @@ public:
 
   void callBoxed(const OperatorHandle& op, Stack* stack) const;
 
+  /**
+   * Like callBoxed(op, stack), but skips the dispatch table lookup if the
+   * call has the same dispatch key as the last one made with `cache`.
+   * `cache` must only be used for calls of `op`.
+   *
+   * Kernels must not be deregistered while such a call runs them.
+   */
+  void callBoxed(const OperatorHandle& op, Stack* stack, DispatchCache* cache) const;
+
   /**
    * Add a listener that gets called whenever a new op is registered or an existing
    * op is deregistered. Immediately after registering, this listener gets called
@@ -181,4 +190,9 @@ inline void Dispatcher::callBoxed(const OperatorHandle& op, Stack* stack) const
   return op.operatorIterator_->op.callBoxed(stack);
 }
 
+inline void Dispatcher::callBoxed(const OperatorHandle& op, Stack* stack, DispatchCache* cache) const {
+  // note: this doesn't need the mutex because write operations on the list keep iterators intact.
+  return op.operatorIterator_->op.callBoxed(stack, cache);
+}
+
 } // namespace c10
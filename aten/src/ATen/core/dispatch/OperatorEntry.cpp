@@ -22,7 +22,9 @@ OperatorEntry::OperatorEntry(FunctionSchema&& schema, OperatorOptions&& options)
 , dispatchTable_(schema_)
 , kernels_()
 , catchAllKernels_()
-, options_(std::move(options)) {
+, options_(std::move(options))
+, dispatchStrategy_(detail::get_dispatch_strategy(schema_))
+, version_(1) {
 }
 
 void OperatorEntry::prepareForDeregistration() {
@@ -78,6 +80,8 @@ void OperatorEntry::deregisterKernel_(TensorTypeId dispatch_key, std::list<Kerne
   auto found = kernels_.find(dispatch_key);
   TORCH_INTERNAL_ASSERT(found != kernels_.end(), "Tried to deregister a kernel for dispatch key ", toString(dispatch_key), " but there are no kernels registered for this dispatch key. The operator schema is ", toString(schema_));
   auto& k = found->second;
+  // DispatchCaches may point to the erased kernel
+  ++version_;
   k.erase(kernel);
   if (k.empty()) {
     // the invariant says we don't want empty lists but instead remove the list from the map
@@ -90,14 +94,33 @@ void OperatorEntry::deregisterKernel_(TensorTypeId dispatch_key, std::list<Kerne
 void OperatorEntry::deregisterCatchallKernel_(std::list<KernelFunction>::iterator kernel) {
   std::unique_lock<std::mutex> lock(kernelsMutex_);
 
+  // DispatchCaches may point to the erased kernel
+  ++version_;
   catchAllKernels_.erase(kernel);
 
   updateCatchallDispatchTable_();
 }
 
+const KernelFunction* OperatorEntry::lookupRegisteredKernel_(TensorTypeId dispatch_key, uint64_t* version) const {
+  std::unique_lock<std::mutex> lock(kernelsMutex_);
+  *version = version_.load();
+
+  // same order as DispatchTable::lookup()
+  auto k = kernels_.find(dispatch_key);
+  if (k != kernels_.end()) {
+    return &k->second.front();
+  }
+  if (!catchAllKernels_.empty()) {
+    return &catchAllKernels_.front();
+  }
+  return nullptr;
+}
+
 void OperatorEntry::updateDispatchTable_(TensorTypeId dispatch_key) {
   // precondition: kernelsMutex_ is locked
 
+  ++version_;
+
   auto k = kernels_.find(dispatch_key);
 
   if (k == kernels_.end()) {
@@ -114,6 +137,8 @@ void OperatorEntry::updateDispatchTable_(TensorTypeId dispatch_key) {
 void OperatorEntry::updateCatchallDispatchTable_() {
   // precondition: kernelsMutex_ is locked
 
+  ++version_;
+
   if (catchAllKernels_.size() == 0) {
     dispatchTable_.write([&] (DispatchTable& dispatchTable) {
       dispatchTable.removeCatchallKernel();
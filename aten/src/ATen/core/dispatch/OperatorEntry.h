@@ -1,5 +1,6 @@
 #pragma once
 
+#include <ATen/core/dispatch/DispatchCache.h>
 #include <ATen/core/dispatch/DispatchTable.h>
 #include <ATen/core/dispatch/OperatorOptions.h>
 #include <ATen/core/dispatch/RegistrationHandleRAII.h>
@@ -30,6 +31,7 @@ public:
   template<class Return, class... Args>
   Return callUnboxed(TensorTypeId dispatchKey, Args... args) const {
     // TODO Remove dispatchKey argument and instead infer dispatchKey from args...
+    dispatchKey = skipAutocastIfUnregistered_(dispatchKey, args...);
     #if !defined(__clang__) && !defined(_MSC_VER) && defined(__GNUC__) && __GNUC__ < 5
       // GCC 4 has issues with parameter packs inside lambdas, let's instead
       // return the KernelFunction from the lambda. Note: This copies the
@@ -51,6 +53,7 @@ public:
   template<class Return, class... Args>
   Return callUnboxedOnly(TensorTypeId dispatchKey, Args... args) const {
     // TODO Remove dispatchKey argument and instead infer dispatchKey from args...
+    dispatchKey = skipAutocastIfUnregistered_(dispatchKey, args...);
     #if !defined(__clang__) && !defined(_MSC_VER) && defined(__GNUC__) && __GNUC__ < 5
       // GCC 4 has issues with parameter packs inside lambdas, let's instead
       // return the KernelFunction from the lambda. Note: This copies the
@@ -69,12 +72,44 @@ public:
     #endif
   }
 
+  // Ops without an autocast kernel dispatch to the key below autocast, see
+  // Note [Autocast]
+  template<class... Args>
+  TensorTypeId skipAutocastIfUnregistered_(TensorTypeId dispatchKey, const Args&... args) const {
+    if (C10_LIKELY(dispatchKey != TensorTypeId::AutocastTensorId)) {
+      return dispatchKey;
+    }
+    bool registered = dispatchTable_.read([&] (const DispatchTable& dispatchTable) -> bool {
+      return dispatchTable.hasKernelFor(dispatchKey);
+    });
+    return registered
+        ? dispatchKey
+        : at::impl::dispatchTypeIdSkippingAutocast(at::detail::multi_dispatch_tensor_type_set(args...));
+  }
+
   void callBoxed(Stack* stack) const {
     return dispatchTable_.read([&] (const DispatchTable& dispatchTable) {
         dispatchTable.lookup(stack).callBoxed(stack);
     });
   }
 
+  void callBoxed(Stack* stack, DispatchCache* cache) const {
+    TensorTypeId dispatch_key = dispatchStrategy_.is_valid_
+        ? dispatchStrategy_.get_dispatch_key(stack, schema_.name())
+        : TensorTypeId::UndefinedTensorId;
+    uint64_t version = version_.load(std::memory_order_acquire);
+    const KernelFunction* kernel = cache->lookup(dispatch_key, version);
+    if (C10_UNLIKELY(kernel == nullptr)) {
+      kernel = lookupRegisteredKernel_(dispatch_key, &version);
+      if (kernel == nullptr) {
+        // let the dispatch table report the missing kernel
+        return callBoxed(stack);
+      }
+      cache->update(dispatch_key, version, kernel);
+    }
+    kernel->callBoxed(stack);
+  }
+
   void prepareForDeregistration();
 
   RegistrationHandleRAII registerKernel(TensorTypeId dispatch_key, KernelFunction kernel);
@@ -86,6 +121,10 @@ public:
 
 private:
   void deregisterKernel_(TensorTypeId dispatch_key, std::list<KernelFunction>::iterator kernel);
+  // Returns the kernel the dispatch table holds for dispatch_key, from the
+  // kernel lists, whose elements keep their address until they are
+  // deregistered. Sets *version to the version of the dispatch table read.
+  const KernelFunction* lookupRegisteredKernel_(TensorTypeId dispatch_key, uint64_t* version) const;
   void deregisterCatchallKernel_(std::list<KernelFunction>::iterator kernel);
 
   FunctionSchema schema_;
@@ -131,7 +170,15 @@ private:
   // Some metadata about the operator
   OperatorOptions options_;
 
-  std::mutex kernelsMutex_; // protects kernels_
+  mutable std::mutex kernelsMutex_; // protects kernels_
+
+  // Used by callBoxed() with a DispatchCache, which needs the dispatch key
+  // without reading the dispatch table.
+  const detail::DispatchStrategy dispatchStrategy_;
+
+  // Incremented before any change to the dispatch table or the kernel lists,
+  // invalidates the DispatchCaches of the operator. Starts at 1.
+  std::atomic<uint64_t> version_;
 
   // This function re-establishes the invariant that dispatchTable
   // contains the front element from the kernels list for a given dispatch key.
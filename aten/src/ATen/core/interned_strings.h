@@ -85,6 +85,7 @@ namespace c10 {
   _(prim, ConstantChunk)             \
   _(prim, MMTreeReduce)              \
   _(prim, MMBatchSide)               \
+  _(prim, MMBatchIndependent)        \
   _(prim, min)                       \
   _(prim, max)                       \
   _(prim, abs)                       \
@@ -164,6 +165,8 @@ namespace c10 {
   _(prim, unchecked_unwrap_optional) \
   _(aten, __contains__)              \
   _(prim, BailoutTemplate)           \
+  _(prim, MemoryArena)               \
+  _(prim, ArenaTensor)               \
   FORALL_ATEN_BASE_SYMBOLS(_)        \
   _(onnx, Add)                       \
   _(onnx, Concat)                    \
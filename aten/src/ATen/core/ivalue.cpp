@@ -223,6 +223,7 @@ static bool CompareKeys(const std::pair<IValue, IValue>& aWrap,
 
 std::vector<std::pair<IValue, IValue>> iterationOrder(const c10::Dict<IValue, IValue>& dict) {
   std::vector<std::pair<IValue, IValue>> ordered;
+  ordered.reserve(dict.size());
   for (auto& element : dict) {
     ordered.emplace_back(element.key(), element.value());
   }
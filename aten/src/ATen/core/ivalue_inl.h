@@ -8,6 +8,7 @@
 #include <c10/core/Scalar.h>
 #include <c10/core/TensorImpl.h>
 #include <c10/core/UndefinedTensorImpl.h>
+#include <c10/util/PoolAllocated.h>
 #include <ATen/core/Dict.h>
 #include <ATen/core/List.h>
 
@@ -113,7 +114,9 @@ template <typename T>
 using Shared = c10::intrusive_ptr<T>;
 
 // string
-struct CAFFE2_API ConstantString final : c10::intrusive_ptr_target {
+struct CAFFE2_API ConstantString final
+    : c10::intrusive_ptr_target,
+      c10::PoolAllocated<ConstantString> {
  private:
   const std::string str_;
  public:
@@ -133,7 +136,8 @@ struct CAFFE2_API ConstantString final : c10::intrusive_ptr_target {
 
 struct Future;
 
-struct CAFFE2_API Tuple : c10::intrusive_ptr_target {
+struct CAFFE2_API Tuple : c10::intrusive_ptr_target,
+                          c10::PoolAllocated<Tuple> {
  private:
   std::vector<IValue> elements_;
   mutable std::shared_ptr<TupleType> type_; // lazily computed for unnamed tuples
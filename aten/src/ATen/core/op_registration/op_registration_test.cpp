@@ -279,6 +279,78 @@ TEST(OperatorRegistrationTest, givenMultipleKernelsWithSameDispatchKey_whenCalle
   EXPECT_TRUE(called_kernel2);
 }
 
+void callOpWithCache(const c10::OperatorHandle& op, c10::DispatchCache* cache, Tensor dummy) {
+  auto stack = makeStack(std::move(dummy));
+  Dispatcher::singleton().callBoxed(op, &stack, cache);
+}
+
+TEST(OperatorRegistrationTest, givenDispatchCache_whenCallingWithDifferentDispatchKeys_thenCallsMatchingKernels) {
+  bool called_cpu = false;
+  bool called_cuda = false;
+  auto registrar = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options()
+      .kernel<MockKernel>(c10::TensorTypeId::CPUTensorId, &called_cpu)
+      .kernel<MockKernel>(c10::TensorTypeId::CUDATensorId, &called_cuda));
+
+  auto op = Dispatcher::singleton().findSchema({"_test::dummy", ""});
+  ASSERT_TRUE(op.has_value());
+
+  c10::DispatchCache cache;
+  for (int i = 0; i < 2; ++i) {
+    called_cpu = called_cuda = false;
+    callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+    EXPECT_TRUE(called_cpu);
+    EXPECT_FALSE(called_cuda);
+
+    called_cpu = called_cuda = false;
+    callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CUDATensorId));
+    EXPECT_FALSE(called_cpu);
+    EXPECT_TRUE(called_cuda);
+  }
+}
+
+TEST(OperatorRegistrationTest, givenDispatchCache_whenRegisteringNewerKernel_thenCallsNewerKernel) {
+  bool called_kernel1 = false;
+  bool called_kernel2 = false;
+  auto registrar1 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().kernel<MockKernel>(c10::TensorTypeId::CPUTensorId, &called_kernel1));
+
+  auto op = Dispatcher::singleton().findSchema({"_test::dummy", ""});
+  ASSERT_TRUE(op.has_value());
+
+  c10::DispatchCache cache;
+  callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+  EXPECT_TRUE(called_kernel1);
+
+  auto registrar2 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().kernel<MockKernel>(c10::TensorTypeId::CPUTensorId, &called_kernel2));
+  called_kernel1 = false;
+  callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+  EXPECT_FALSE(called_kernel1);
+  EXPECT_TRUE(called_kernel2);
+
+  registrar2 = c10::RegisterOperators(); // destruct the registrar
+  called_kernel2 = false;
+  callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+  EXPECT_TRUE(called_kernel1);
+  EXPECT_FALSE(called_kernel2);
+}
+
+TEST(OperatorRegistrationTest, givenDispatchCache_whenKernelDeletedAndOpCalled_thenFails) {
+  bool called = false;
+  auto registrar1 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()");
+  auto registrar2 = c10::RegisterOperators().op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().catchAllKernel<MockKernel>(&called));
+
+  auto op = Dispatcher::singleton().findSchema({"_test::dummy", ""});
+  ASSERT_TRUE(op.has_value());
+
+  c10::DispatchCache cache;
+  callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+  EXPECT_TRUE(called);
+
+  registrar2 = c10::RegisterOperators(); // destruct the registrar
+  expectThrows<c10::Error>([&] {
+    callOpWithCache(*op, &cache, dummyTensor(c10::TensorTypeId::CPUTensorId));
+  }, "Didn't find kernel to dispatch to for operator '_test::dummy'");
+}
+
 TEST(OperatorRegistrationTest, givenMultipleCatchallKernels_whenRegistering_thenShowsWarning) {
   auto registrar = c10::RegisterOperators()
       .op("_test::dummy(Tensor dummy) -> ()", c10::RegisterOperators::options().catchAllKernel<DummyKernel>());
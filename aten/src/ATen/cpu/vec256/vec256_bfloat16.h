@@ -0,0 +1,553 @@
+#pragma once
+
+#include <ATen/cpu/vec256/intrinsics.h>
+#include <ATen/cpu/vec256/vec256_base.h>
+#include <ATen/cpu/vec256/vec256_float.h>
+#include <tuple>
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+#if defined(__AVX2__) && !defined(_MSC_VER)
+
+// Note [BFloat16 in Vec256]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// AVX2 has no bfloat16 arithmetic, so Vec256<BFloat16> holds 16 packed
+// bfloat16 values and computes on them as two Vec256<float>: the loads widen
+// each value by shifting it into the upper half of a float, and the stores
+// round back to nearest even like c10::BFloat16(float) does. Kernels that
+// accumulate over many values should convert with convert_bfloat16_float once
+// and stay in float rather than rounding after each step.
+
+static inline void cvtbf16_fp32(const __m128i& a, __m256& o) {
+  o = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(a), 16));
+}
+
+static inline void cvtbf16_fp32(const __m256i& a, __m256& o1, __m256& o2) {
+  cvtbf16_fp32(_mm256_extractf128_si256(a, 0), o1);
+  cvtbf16_fp32(_mm256_extractf128_si256(a, 1), o2);
+}
+
+static inline __m256i cvtfp32_bf16(const __m256& a, const __m256& b) {
+  __m256i lo = _mm256_castps_si256(a);
+  __m256i hi = _mm256_castps_si256(b);
+  __m256i nan = _mm256_set1_epi32(0x7fc0);
+  __m256i mask_lo = _mm256_castps_si256(_mm256_cmp_ps(a, a, _CMP_ORD_Q));
+  __m256i mask_hi = _mm256_castps_si256(_mm256_cmp_ps(b, b, _CMP_ORD_Q));
+  __m256i ones = _mm256_set1_epi32(0x1);
+  __m256i vec_bias = _mm256_set1_epi32(0x7fff);
+  // uint32_t lsb = (input >> 16) & 1;
+  auto t_lo = _mm256_and_si256(_mm256_srli_epi32(lo, 16), ones);
+  auto t_hi = _mm256_and_si256(_mm256_srli_epi32(hi, 16), ones);
+  // uint32_t rounding_bias = 0x7fff + lsb;
+  t_lo = _mm256_add_epi32(t_lo, vec_bias);
+  t_hi = _mm256_add_epi32(t_hi, vec_bias);
+  // input += rounding_bias;
+  t_lo = _mm256_add_epi32(t_lo, lo);
+  t_hi = _mm256_add_epi32(t_hi, hi);
+  // input = input >> 16;
+  t_lo = _mm256_srli_epi32(t_lo, 16);
+  t_hi = _mm256_srli_epi32(t_hi, 16);
+  // Check NaN before converting back to bf16
+  t_lo = _mm256_blendv_epi8(nan, t_lo, mask_lo);
+  t_hi = _mm256_blendv_epi8(nan, t_hi, mask_hi);
+
+  t_lo = _mm256_packus_epi32(t_lo, t_hi);      // t_hi[4-7] t_lo[4-7] t_hi[0-4] t_lo[0-4]
+  return _mm256_permute4x64_epi64(t_lo, 0xd8); // 11        01        10        00
+}
+
+// Packs the all-ones or all-zeros float masks of a comparison into 16-bit
+// masks, which must not go through the rounding of cvtfp32_bf16.
+static inline __m256i merge_compare_result(const __m256& a, const __m256& b) {
+  __m256i lo = _mm256_srli_epi32(_mm256_castps_si256(a), 16);
+  __m256i hi = _mm256_srli_epi32(_mm256_castps_si256(b), 16);
+  auto out = _mm256_packus_epi32(lo, hi);
+  return _mm256_permute4x64_epi64(out, 0xd8);
+}
+
+template <> class Vec256<BFloat16> {
+private:
+  __m256i values;
+
+  Vec256<BFloat16> map_as_float(Vec256<float> (Vec256<float>::*op)() const) const {
+    __m256 lo, hi;
+    cvtbf16_fp32(values, lo, hi);
+    const auto o1 = (Vec256<float>(lo).*op)();
+    const auto o2 = (Vec256<float>(hi).*op)();
+    return cvtfp32_bf16(o1, o2);
+  }
+  Vec256<BFloat16> map2_as_float(
+      const Vec256<BFloat16>& b,
+      Vec256<float> (Vec256<float>::*op)(const Vec256<float>&) const) const {
+    __m256 lo, hi;
+    __m256 b1, b2;
+    cvtbf16_fp32(values, lo, hi);
+    cvtbf16_fp32(b.values, b1, b2);
+    const auto o1 = (Vec256<float>(lo).*op)(b1);
+    const auto o2 = (Vec256<float>(hi).*op)(b2);
+    return cvtfp32_bf16(o1, o2);
+  }
+  Vec256<BFloat16> compare_as_float(
+      const Vec256<BFloat16>& b,
+      Vec256<float> (Vec256<float>::*op)(const Vec256<float>&) const) const {
+    __m256 lo, hi;
+    __m256 b1, b2;
+    cvtbf16_fp32(values, lo, hi);
+    cvtbf16_fp32(b.values, b1, b2);
+    const auto o1 = (Vec256<float>(lo).*op)(b1);
+    const auto o2 = (Vec256<float>(hi).*op)(b2);
+    return merge_compare_result(o1, o2);
+  }
+public:
+  using value_type = uint16_t;
+  static constexpr int size() {
+    return 16;
+  }
+  Vec256() {}
+  Vec256(__m256i v) : values(v) {}
+  Vec256(BFloat16 val) {
+    value_type uw = val.x;
+    values = _mm256_set1_epi16(uw);
+  }
+  Vec256(BFloat16 val1, BFloat16 val2, BFloat16 val3, BFloat16 val4,
+         BFloat16 val5, BFloat16 val6, BFloat16 val7, BFloat16 val8,
+         BFloat16 val9, BFloat16 val10, BFloat16 val11, BFloat16 val12,
+         BFloat16 val13, BFloat16 val14, BFloat16 val15, BFloat16 val16) {
+    values = _mm256_setr_epi16(
+        val1.x, val2.x, val3.x, val4.x, val5.x, val6.x, val7.x, val8.x,
+        val9.x, val10.x, val11.x, val12.x, val13.x, val14.x, val15.x, val16.x);
+  }
+  operator __m256i() const {
+    return values;
+  }
+  BFloat16& operator[](int idx) = delete;
+  const BFloat16& operator[](int idx) const  = delete;
+  template <int64_t mask>
+  static Vec256<BFloat16> blend(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+    __at_align32__ int16_t tmp_values[size()];
+    a.store(tmp_values);
+    if (mask & 0x01)
+      tmp_values[0] = _mm256_extract_epi16(b.values, 0);
+    if (mask & 0x02)
+      tmp_values[1] = _mm256_extract_epi16(b.values, 1);
+    if (mask & 0x04)
+      tmp_values[2] = _mm256_extract_epi16(b.values, 2);
+    if (mask & 0x08)
+      tmp_values[3] = _mm256_extract_epi16(b.values, 3);
+    if (mask & 0x10)
+      tmp_values[4] = _mm256_extract_epi16(b.values, 4);
+    if (mask & 0x20)
+      tmp_values[5] = _mm256_extract_epi16(b.values, 5);
+    if (mask & 0x40)
+      tmp_values[6] = _mm256_extract_epi16(b.values, 6);
+    if (mask & 0x80)
+      tmp_values[7] = _mm256_extract_epi16(b.values, 7);
+    if (mask & 0x100)
+      tmp_values[8] = _mm256_extract_epi16(b.values, 8);
+    if (mask & 0x200)
+      tmp_values[9] = _mm256_extract_epi16(b.values, 9);
+    if (mask & 0x400)
+      tmp_values[10] = _mm256_extract_epi16(b.values, 10);
+    if (mask & 0x800)
+      tmp_values[11] = _mm256_extract_epi16(b.values, 11);
+    if (mask & 0x1000)
+      tmp_values[12] = _mm256_extract_epi16(b.values, 12);
+    if (mask & 0x2000)
+      tmp_values[13] = _mm256_extract_epi16(b.values, 13);
+    if (mask & 0x4000)
+      tmp_values[14] = _mm256_extract_epi16(b.values, 14);
+    if (mask & 0x8000)
+      tmp_values[15] = _mm256_extract_epi16(b.values, 15);
+    return loadu(tmp_values);
+  }
+  static Vec256<BFloat16> blendv(const Vec256<BFloat16>& a,
+      const Vec256<BFloat16>& b, const Vec256<BFloat16>& mask) {
+    return _mm256_blendv_epi8(a.values, b.values, mask.values);
+  }
+  static Vec256<BFloat16> arange(BFloat16 base = 0.f, BFloat16 step = 1.f) {
+    return Vec256<BFloat16>(
+      base,             base +      step, base +  2 * step, base +  3 * step,
+      base +  4 * step, base +  5 * step, base +  6 * step, base +  7 * step,
+      base +  8 * step, base +  9 * step, base + 10 * step, base + 11 * step,
+      base + 12 * step, base + 13 * step, base + 14 * step, base + 15 * step);
+  }
+  static Vec256<BFloat16> set(const Vec256<BFloat16>& a,
+      const Vec256<BFloat16>& b, int64_t count = size()) {
+    switch (count) {
+      case 0:
+        return a;
+      case 1:
+        return blend<1>(a, b);
+      case 2:
+        return blend<3>(a, b);
+      case 3:
+        return blend<7>(a, b);
+      case 4:
+        return blend<15>(a, b);
+      case 5:
+        return blend<31>(a, b);
+      case 6:
+        return blend<63>(a, b);
+      case 7:
+        return blend<127>(a, b);
+      case 8:
+        return blend<255>(a, b);
+      case 9:
+        return blend<511>(a, b);
+      case 10:
+        return blend<1023>(a, b);
+      case 11:
+        return blend<2047>(a, b);
+      case 12:
+        return blend<4095>(a, b);
+      case 13:
+        return blend<8191>(a, b);
+      case 14:
+        return blend<16383>(a, b);
+      case 15:
+        return blend<32767>(a, b);
+    }
+    return b;
+  }
+  static Vec256<BFloat16> loadu(const void* ptr) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ptr));
+  }
+  static Vec256<BFloat16> loadu(const void* ptr, int16_t count) {
+    __at_align32__ int16_t tmp_values[size()];
+    std::memcpy(tmp_values, ptr, count * sizeof(int16_t));
+    return loadu(tmp_values);
+  }
+  void store(void* ptr, int count = size()) const {
+    if (count == size()) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), values);
+    } else if (count > 0) {
+      __at_align32__ int16_t tmp_values[size()];
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(tmp_values), values);
+      std::memcpy(ptr, tmp_values, count * sizeof(int16_t));
+    }
+  }
+  Vec256<BFloat16> map(BFloat16 (*const f)(BFloat16)) const {
+    __at_align32__ BFloat16 tmp[size()];
+    store(tmp);
+    for (int64_t i = 0; i < size(); i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return loadu(tmp);
+  }
+  Vec256<BFloat16> abs() const {
+    // clears the sign bit, no need to widen
+    return _mm256_andnot_si256(_mm256_set1_epi16(0x8000), values);
+  }
+  Vec256<BFloat16> angle() const {
+    return _mm256_set1_epi16(0);
+  }
+  Vec256<BFloat16> real() const {
+    return *this;
+  }
+  Vec256<BFloat16> imag() const {
+    return _mm256_set1_epi16(0);
+  }
+  Vec256<BFloat16> conj() const {
+    return *this;
+  }
+  Vec256<BFloat16> acos() const {
+    return map_as_float(&Vec256<float>::acos);
+  }
+  Vec256<BFloat16> asin() const {
+    return map_as_float(&Vec256<float>::asin);
+  }
+  Vec256<BFloat16> atan() const {
+    return map_as_float(&Vec256<float>::atan);
+  }
+  Vec256<BFloat16> atan2(const Vec256<BFloat16> &b) const {
+    return map2_as_float(b, &Vec256<float>::atan2);
+  }
+  Vec256<BFloat16> erf() const {
+    return map_as_float(&Vec256<float>::erf);
+  }
+  Vec256<BFloat16> erfc() const {
+    return map_as_float(&Vec256<float>::erfc);
+  }
+  Vec256<BFloat16> erfinv() const {
+    return map_as_float(&Vec256<float>::erfinv);
+  }
+  Vec256<BFloat16> exp() const {
+    return map_as_float(&Vec256<float>::exp);
+  }
+  Vec256<BFloat16> expm1() const {
+    return map_as_float(&Vec256<float>::expm1);
+  }
+  Vec256<BFloat16> frac() const {
+    return map_as_float(&Vec256<float>::frac);
+  }
+  Vec256<BFloat16> log() const {
+    return map_as_float(&Vec256<float>::log);
+  }
+  Vec256<BFloat16> log2() const {
+    return map_as_float(&Vec256<float>::log2);
+  }
+  Vec256<BFloat16> log10() const {
+    return map_as_float(&Vec256<float>::log10);
+  }
+  Vec256<BFloat16> log1p() const {
+    return map_as_float(&Vec256<float>::log1p);
+  }
+  Vec256<BFloat16> sin() const {
+    return map_as_float(&Vec256<float>::sin);
+  }
+  Vec256<BFloat16> sinh() const {
+    return map_as_float(&Vec256<float>::sinh);
+  }
+  Vec256<BFloat16> cos() const {
+    return map_as_float(&Vec256<float>::cos);
+  }
+  Vec256<BFloat16> cosh() const {
+    return map_as_float(&Vec256<float>::cosh);
+  }
+  Vec256<BFloat16> ceil() const {
+    return map_as_float(&Vec256<float>::ceil);
+  }
+  Vec256<BFloat16> floor() const {
+    return map_as_float(&Vec256<float>::floor);
+  }
+  Vec256<BFloat16> neg() const {
+    // flips the sign bit, no need to widen
+    return _mm256_xor_si256(_mm256_set1_epi16(0x8000), values);
+  }
+  Vec256<BFloat16> round() const {
+    return map_as_float(&Vec256<float>::round);
+  }
+  Vec256<BFloat16> tan() const {
+    return map_as_float(&Vec256<float>::tan);
+  }
+  Vec256<BFloat16> tanh() const {
+    return map_as_float(&Vec256<float>::tanh);
+  }
+  Vec256<BFloat16> trunc() const {
+    return map_as_float(&Vec256<float>::trunc);
+  }
+  Vec256<BFloat16> lgamma() const {
+    return map_as_float(&Vec256<float>::lgamma);
+  }
+  Vec256<BFloat16> sqrt() const {
+    return map_as_float(&Vec256<float>::sqrt);
+  }
+  Vec256<BFloat16> reciprocal() const {
+    return map_as_float(&Vec256<float>::reciprocal);
+  }
+  Vec256<BFloat16> rsqrt() const {
+    return map_as_float(&Vec256<float>::rsqrt);
+  }
+  Vec256<BFloat16> pow(const Vec256<BFloat16> &b) const {
+    return map2_as_float(b, &Vec256<float>::pow);
+  }
+
+  Vec256<BFloat16> operator==(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator==);
+  }
+  Vec256<BFloat16> operator!=(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator!=);
+  }
+  Vec256<BFloat16> operator<(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator<);
+  }
+  Vec256<BFloat16> operator<=(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator<=);
+  }
+  Vec256<BFloat16> operator>(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator>);
+  }
+  Vec256<BFloat16> operator>=(const Vec256<BFloat16>& other) const {
+    return compare_as_float(other, &Vec256<float>::operator>=);
+  }
+};
+
+template<typename Op>
+Vec256<BFloat16> static inline binary_op_as_fp32(const Vec256<BFloat16>& a,
+    const Vec256<BFloat16>& b, const Op& op) {
+  __m256 a_lo, a_hi;
+  __m256 b_lo, b_hi;
+  cvtbf16_fp32(__m256i(a), a_lo, a_hi);
+  cvtbf16_fp32(__m256i(b), b_lo, b_hi);
+  auto o1 = op(a_lo, b_lo);
+  auto o2 = op(a_hi, b_hi);
+  return cvtfp32_bf16(o1, o2);
+}
+
+template <>
+Vec256<BFloat16> inline operator+(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) { return _mm256_add_ps(x, y); });
+}
+
+template <>
+Vec256<BFloat16> inline operator-(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) { return _mm256_sub_ps(x, y); });
+}
+
+template <>
+Vec256<BFloat16> inline operator*(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) { return _mm256_mul_ps(x, y); });
+}
+
+template <>
+Vec256<BFloat16> inline operator/(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) { return _mm256_div_ps(x, y); });
+}
+
+template <>
+Vec256<BFloat16> inline operator&(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return _mm256_and_si256(a, b);
+}
+
+template <>
+Vec256<BFloat16> inline operator|(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return _mm256_or_si256(a, b);
+}
+
+template <>
+Vec256<BFloat16> inline operator^(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return _mm256_xor_si256(a, b);
+}
+
+// Implements the IEEE 754 201X `maximum` operation, which propagates NaN if
+// either input is a NaN.
+template <>
+Vec256<BFloat16> inline maximum(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {
+    auto max = _mm256_max_ps(x, y);
+    auto isnan = _mm256_cmp_ps(x, y, _CMP_UNORD_Q);
+    // Exploit the fact that all-ones is a NaN.
+    return _mm256_or_ps(max, isnan);
+  });
+}
+
+// Implements the IEEE 754 201X `minimum` operation, which propagates NaN if
+// either input is a NaN.
+template <>
+Vec256<BFloat16> inline minimum(const Vec256<BFloat16>& a, const Vec256<BFloat16>& b) {
+  return binary_op_as_fp32(a, b, [](const __m256& x, const __m256& y) {
+    auto min = _mm256_min_ps(x, y);
+    auto isnan = _mm256_cmp_ps(x, y, _CMP_UNORD_Q);
+    // Exploit the fact that all-ones is a NaN.
+    return _mm256_or_ps(min, isnan);
+  });
+}
+
+template <>
+Vec256<BFloat16> inline clamp(const Vec256<BFloat16>& a,
+    const Vec256<BFloat16>& min, const Vec256<BFloat16>& max) {
+  __m256 a_lo, a_hi;
+  __m256 min_lo, min_hi;
+  __m256 max_lo, max_hi;
+  cvtbf16_fp32(__m256i(a), a_lo, a_hi);
+  cvtbf16_fp32(__m256i(min), min_lo, min_hi);
+  cvtbf16_fp32(__m256i(max), max_lo, max_hi);
+  auto o1 = _mm256_min_ps(max_lo, _mm256_max_ps(min_lo, a_lo));
+  auto o2 = _mm256_min_ps(max_hi, _mm256_max_ps(min_hi, a_hi));
+  return cvtfp32_bf16(o1, o2);
+}
+
+template <>
+Vec256<BFloat16> inline clamp_max(const Vec256<BFloat16>& a, const Vec256<BFloat16>& max) {
+  return binary_op_as_fp32(a, max, [](const __m256& x, const __m256& y) { return _mm256_min_ps(y, x); });
+}
+
+template <>
+Vec256<BFloat16> inline clamp_min(const Vec256<BFloat16>& a, const Vec256<BFloat16>& min) {
+  return binary_op_as_fp32(a, min, [](const __m256& x, const __m256& y) { return _mm256_max_ps(y, x); });
+}
+
+// Rounds once, after the fused multiply-add in float.
+template <>
+Vec256<BFloat16> inline fmadd(const Vec256<BFloat16>& a,
+    const Vec256<BFloat16>& b, const Vec256<BFloat16>& c) {
+  __m256 a_lo, a_hi;
+  __m256 b_lo, b_hi;
+  __m256 c_lo, c_hi;
+  cvtbf16_fp32(__m256i(a), a_lo, a_hi);
+  cvtbf16_fp32(__m256i(b), b_lo, b_hi);
+  cvtbf16_fp32(__m256i(c), c_lo, c_hi);
+  auto o1 = _mm256_fmadd_ps(a_lo, b_lo, c_lo);
+  auto o2 = _mm256_fmadd_ps(a_hi, b_hi, c_hi);
+  return cvtfp32_bf16(o1, o2);
+}
+
+template <>
+inline void convert(const BFloat16* src, BFloat16* dst, int64_t n) {
+  int64_t i;
+#pragma unroll
+  for (i = 0; i <= (n - Vec256<BFloat16>::size()); i += Vec256<BFloat16>::size()) {
+    auto vsrc = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), vsrc);
+  }
+#pragma unroll
+  for (; i < n; i++) {
+    dst[i] = src[i];
+  }
+}
+
+template <>
+inline void convert(const BFloat16* src, float* dst, int64_t n) {
+  int64_t i;
+  for (i = 0; i <= (n - Vec256<BFloat16>::size()); i += Vec256<BFloat16>::size()) {
+    __m256 o1, o2;
+    cvtbf16_fp32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i)), o1, o2);
+    _mm256_storeu_ps(dst + i, o1);
+    _mm256_storeu_ps(dst + i + Vec256<float>::size(), o2);
+  }
+  for (; i < n; i++) {
+    dst[i] = static_cast<float>(src[i]);
+  }
+}
+
+template <>
+inline void convert(const float* src, BFloat16* dst, int64_t n) {
+  int64_t i;
+  for (i = 0; i <= (n - Vec256<BFloat16>::size()); i += Vec256<BFloat16>::size()) {
+    __m256 a = _mm256_loadu_ps(src + i);
+    __m256 b = _mm256_loadu_ps(src + i + Vec256<float>::size());
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), cvtfp32_bf16(a, b));
+  }
+  for (; i < n; i++) {
+    dst[i] = c10::BFloat16(src[i]);
+  }
+}
+
+inline std::tuple<Vec256<float>, Vec256<float>> convert_bfloat16_float(const Vec256<BFloat16>& a) {
+  __m256 o1, o2;
+  cvtbf16_fp32(__m256i(a), o1, o2);
+  return std::make_tuple(o1, o2);
+}
+
+inline Vec256<BFloat16> convert_float_bfloat16(const Vec256<float>& a, const Vec256<float>& b) {
+  return cvtfp32_bf16(__m256(a), __m256(b));
+}
+
+#else // defined(__AVX2__) && !defined(_MSC_VER)
+
+inline std::tuple<Vec256<float>, Vec256<float>> convert_bfloat16_float(const Vec256<BFloat16>& a) {
+  constexpr int64_t K = Vec256<BFloat16>::size();
+  __at_align32__ float arr[K];
+  __at_align32__ BFloat16 arr2[K];
+  a.store(arr2);
+  convert(arr2, arr, K);
+  return std::make_tuple(
+      Vec256<float>::loadu(arr),
+      Vec256<float>::loadu(arr + Vec256<float>::size()));
+}
+
+inline Vec256<BFloat16> convert_float_bfloat16(const Vec256<float>& a, const Vec256<float>& b) {
+  constexpr int64_t K = Vec256<BFloat16>::size();
+  __at_align32__ float arr[K];
+  __at_align32__ BFloat16 arr2[K];
+  a.store(arr);
+  b.store(arr + Vec256<float>::size());
+  convert(arr, arr2, K);
+  return Vec256<BFloat16>::loadu(arr2);
+}
+
+#endif // defined(__AVX2__) && !defined(_MSC_VER)
+
+}}}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/cpu/vec512/vec512_base.h>
+#include <ATen/cpu/vec512/vec512_float.h>
+#include <ATen/cpu/vec512/vec512_double.h>
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+// The widest vector type for the CPU capability a kernel is compiled for.
+// Kernels written against Vectorized<T> get compiled to Vec512 for the
+// AVX512 capability and to Vec256 everywhere else; Loops.h and Reduce.h
+// accept either.
+#if defined(CPU_CAPABILITY_AVX512)
+template <typename T>
+using Vectorized = Vec512<T>;
+#else
+template <typename T>
+using Vectorized = Vec256<T>;
+#endif
+
+}}}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__GNUC__)
+#define __at_align64__ __attribute__((aligned(64)))
+#elif defined(_WIN32)
+#define __at_align64__ __declspec(align(64))
+#else
+#define __at_align64__
+#endif
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+// Vec512<T> has the same interface as Vec256<T>, but holds 64 bytes worth of
+// elements. Types without a native AVX-512 implementation (and all types on
+// builds without AVX-512) are emulated with a pair of Vec256<T>, so kernels
+// can be written against Vec512 without caring for which instruction set
+// they are compiled.
+//
+// NOTE: If you specialize on a type, you must define all operations!
+template <class T>
+struct Vec512 {
+private:
+  Vec256<T> lo_;
+  Vec256<T> hi_;
+  static constexpr int half_size() {
+    return Vec256<T>::size();
+  }
+public:
+  using value_type = T;
+  // See Note [constexpr static function to avoid odr-usage compiler bug]
+  static constexpr int size() {
+    return 2 * Vec256<T>::size();
+  }
+  Vec512() {}
+  Vec512(T val) : lo_(val), hi_(val) {}
+  Vec512(const Vec256<T>& lo, const Vec256<T>& hi) : lo_(lo), hi_(hi) {}
+  const Vec256<T>& lo() const {
+    return lo_;
+  }
+  const Vec256<T>& hi() const {
+    return hi_;
+  }
+  template <int64_t mask_>
+  static Vec512<T> blend(const Vec512<T>& a, const Vec512<T>& b) {
+    constexpr int64_t lo_mask = mask_ & ((int64_t(1) << half_size()) - 1);
+    constexpr int64_t hi_mask = mask_ >> half_size();
+    return Vec512<T>(
+        Vec256<T>::template blend<lo_mask>(a.lo_, b.lo_),
+        Vec256<T>::template blend<hi_mask>(a.hi_, b.hi_));
+  }
+  static Vec512<T> blendv(const Vec512<T>& a, const Vec512<T>& b,
+                          const Vec512<T>& mask) {
+    return Vec512<T>(
+        Vec256<T>::blendv(a.lo_, b.lo_, mask.lo_),
+        Vec256<T>::blendv(a.hi_, b.hi_, mask.hi_));
+  }
+  static Vec512<T> arange(T base = static_cast<T>(0), T step = static_cast<T>(1)) {
+    return Vec512<T>(
+        Vec256<T>::arange(base, step),
+        Vec256<T>::arange(base + half_size() * step, step));
+  }
+  static Vec512<T> set(const Vec512<T>& a, const Vec512<T>& b, int64_t count = size()) {
+    if (count <= half_size()) {
+      return Vec512<T>(Vec256<T>::set(a.lo_, b.lo_, count), a.hi_);
+    }
+    return Vec512<T>(b.lo_, Vec256<T>::set(a.hi_, b.hi_, count - half_size()));
+  }
+  static Vec512<T> loadu(const void* ptr) {
+    auto hi_ptr = reinterpret_cast<const char*>(ptr) + half_size() * sizeof(T);
+    return Vec512<T>(Vec256<T>::loadu(ptr), Vec256<T>::loadu(hi_ptr));
+  }
+  static Vec512<T> loadu(const void* ptr, int64_t count) {
+    if (count <= half_size()) {
+      return Vec512<T>(Vec256<T>::loadu(ptr, count), Vec256<T>(static_cast<T>(0)));
+    }
+    auto hi_ptr = reinterpret_cast<const char*>(ptr) + half_size() * sizeof(T);
+    return Vec512<T>(
+        Vec256<T>::loadu(ptr), Vec256<T>::loadu(hi_ptr, count - half_size()));
+  }
+  void store(void* ptr, int count = size()) const {
+    if (count <= half_size()) {
+      if (count > 0) {
+        lo_.store(ptr, count);
+      }
+      return;
+    }
+    lo_.store(ptr);
+    hi_.store(reinterpret_cast<char*>(ptr) + half_size() * sizeof(T),
+              count - half_size());
+  }
+  Vec512<T> map(T (*f)(T)) const {
+    return Vec512<T>(lo_.map(f), hi_.map(f));
+  }
+  Vec512<T> map(T (*f)(const T &)) const {
+    return Vec512<T>(lo_.map(f), hi_.map(f));
+  }
+#define DEFINE_VEC512_UNARY_OP(op)            \
+  Vec512<T> op() const {                      \
+    return Vec512<T>(lo_.op(), hi_.op());     \
+  }
+  DEFINE_VEC512_UNARY_OP(abs)
+  DEFINE_VEC512_UNARY_OP(angle)
+  DEFINE_VEC512_UNARY_OP(real)
+  DEFINE_VEC512_UNARY_OP(imag)
+  DEFINE_VEC512_UNARY_OP(conj)
+  DEFINE_VEC512_UNARY_OP(acos)
+  DEFINE_VEC512_UNARY_OP(asin)
+  DEFINE_VEC512_UNARY_OP(atan)
+  DEFINE_VEC512_UNARY_OP(erf)
+  DEFINE_VEC512_UNARY_OP(erfc)
+  DEFINE_VEC512_UNARY_OP(erfinv)
+  DEFINE_VEC512_UNARY_OP(exp)
+  DEFINE_VEC512_UNARY_OP(expm1)
+  DEFINE_VEC512_UNARY_OP(frac)
+  DEFINE_VEC512_UNARY_OP(log)
+  DEFINE_VEC512_UNARY_OP(log10)
+  DEFINE_VEC512_UNARY_OP(log1p)
+  DEFINE_VEC512_UNARY_OP(log2)
+  DEFINE_VEC512_UNARY_OP(ceil)
+  DEFINE_VEC512_UNARY_OP(cos)
+  DEFINE_VEC512_UNARY_OP(cosh)
+  DEFINE_VEC512_UNARY_OP(floor)
+  DEFINE_VEC512_UNARY_OP(neg)
+  DEFINE_VEC512_UNARY_OP(round)
+  DEFINE_VEC512_UNARY_OP(sin)
+  DEFINE_VEC512_UNARY_OP(sinh)
+  DEFINE_VEC512_UNARY_OP(tan)
+  DEFINE_VEC512_UNARY_OP(tanh)
+  DEFINE_VEC512_UNARY_OP(trunc)
+  DEFINE_VEC512_UNARY_OP(lgamma)
+  DEFINE_VEC512_UNARY_OP(sqrt)
+  DEFINE_VEC512_UNARY_OP(reciprocal)
+  DEFINE_VEC512_UNARY_OP(rsqrt)
+#undef DEFINE_VEC512_UNARY_OP
+  Vec512<T> atan2(const Vec512<T>& b) const {
+    return Vec512<T>(lo_.atan2(b.lo_), hi_.atan2(b.hi_));
+  }
+  Vec512<T> pow(const Vec512<T>& b) const {
+    return Vec512<T>(lo_.pow(b.lo_), hi_.pow(b.hi_));
+  }
+#define DEFINE_VEC512_COMPARISON(binary_pred)                               \
+  Vec512<T> operator binary_pred(const Vec512<T>& other) const {            \
+    return Vec512<T>(lo_ binary_pred other.lo_, hi_ binary_pred other.hi_); \
+  }
+  DEFINE_VEC512_COMPARISON(==)
+  DEFINE_VEC512_COMPARISON(!=)
+  DEFINE_VEC512_COMPARISON(>=)
+  DEFINE_VEC512_COMPARISON(<=)
+  DEFINE_VEC512_COMPARISON(>)
+  DEFINE_VEC512_COMPARISON(<)
+#undef DEFINE_VEC512_COMPARISON
+};
+
+#define DEFINE_VEC512_BINARY_OP(op)                                         \
+template <class T>                                                          \
+Vec512<T> inline operator op(const Vec512<T>& a, const Vec512<T>& b) {      \
+  return Vec512<T>(a.lo() op b.lo(), a.hi() op b.hi());                     \
+}
+DEFINE_VEC512_BINARY_OP(+)
+DEFINE_VEC512_BINARY_OP(-)
+DEFINE_VEC512_BINARY_OP(*)
+DEFINE_VEC512_BINARY_OP(/)
+DEFINE_VEC512_BINARY_OP(&)
+DEFINE_VEC512_BINARY_OP(|)
+DEFINE_VEC512_BINARY_OP(^)
+#undef DEFINE_VEC512_BINARY_OP
+
+template <class T>
+Vec512<T> inline maximum(const Vec512<T>& a, const Vec512<T>& b) {
+  return Vec512<T>(maximum(a.lo(), b.lo()), maximum(a.hi(), b.hi()));
+}
+
+template <class T>
+Vec512<T> inline minimum(const Vec512<T>& a, const Vec512<T>& b) {
+  return Vec512<T>(minimum(a.lo(), b.lo()), minimum(a.hi(), b.hi()));
+}
+
+template <class T>
+Vec512<T> inline clamp(const Vec512<T>& a, const Vec512<T>& min_vec, const Vec512<T>& max_vec) {
+  return Vec512<T>(
+      clamp(a.lo(), min_vec.lo(), max_vec.lo()),
+      clamp(a.hi(), min_vec.hi(), max_vec.hi()));
+}
+
+template <class T>
+Vec512<T> inline clamp_max(const Vec512<T>& a, const Vec512<T>& max_vec) {
+  return Vec512<T>(clamp_max(a.lo(), max_vec.lo()), clamp_max(a.hi(), max_vec.hi()));
+}
+
+template <class T>
+Vec512<T> inline clamp_min(const Vec512<T>& a, const Vec512<T>& min_vec) {
+  return Vec512<T>(clamp_min(a.lo(), min_vec.lo()), clamp_min(a.hi(), min_vec.hi()));
+}
+
+template <class T>
+Vec512<T> inline fmadd(const Vec512<T>& a, const Vec512<T>& b, const Vec512<T>& c) {
+  return Vec512<T>(fmadd(a.lo(), b.lo(), c.lo()), fmadd(a.hi(), b.hi(), c.hi()));
+}
+
+template<typename dst_t, typename src_t>
+inline Vec512<dst_t> cast(const Vec512<src_t>& src) {
+  return Vec512<dst_t>(
+      cast<dst_t, src_t>(src.lo()), cast<dst_t, src_t>(src.hi()));
+}
+
+template <typename T>
+inline Vec512<int_same_size_t<T>> convert_to_int_of_same_size(const Vec512<T>& src) {
+  return Vec512<int_same_size_t<T>>(
+      convert_to_int_of_same_size(src.lo()), convert_to_int_of_same_size(src.hi()));
+}
+
+template <typename T>
+std::ostream& operator<<(std::ostream& stream, const Vec512<T>& vec) {
+  T buf[Vec512<T>::size()];
+  vec.store(buf);
+  stream << "vec[";
+  for (int i = 0; i != Vec512<T>::size(); i++) {
+    if (i != 0) {
+      stream << ", ";
+    }
+    stream << buf[i];
+  }
+  stream << "]";
+  return stream;
+}
+
+}}}
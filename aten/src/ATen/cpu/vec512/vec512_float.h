@@ -0,0 +1,304 @@
+#pragma once
+
+#include <ATen/cpu/vec256/intrinsics.h>
+#include <ATen/cpu/vec512/vec512_base.h>
+#if defined(__AVX512F__) && !defined(_MSC_VER)
+#include <sleef.h>
+#endif
+
+namespace at {
+namespace vec256 {
+// See Note [Acceptable use of anonymous namespace in header]
+namespace {
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__) && !defined(_MSC_VER)
+
+template <> class Vec512<float> {
+private:
+  __m512 values;
+  static __m512 mask_to_vec(__mmask16 mask) {
+    return _mm512_castsi512_ps(
+        _mm512_maskz_set1_epi32(mask, -1));
+  }
+  static __mmask16 count_to_mask(int64_t count) {
+    return static_cast<__mmask16>((1u << count) - 1);
+  }
+public:
+  using value_type = float;
+  static constexpr int size() {
+    return 16;
+  }
+  Vec512() {}
+  Vec512(__m512 v) : values(v) {}
+  Vec512(float val) {
+    values = _mm512_set1_ps(val);
+  }
+  Vec512(const Vec256<float>& lo, const Vec256<float>& hi) {
+    values = _mm512_insertf32x8(_mm512_castps256_ps512(lo), hi, 1);
+  }
+  operator __m512() const {
+    return values;
+  }
+  Vec256<float> lo() const {
+    return _mm512_castps512_ps256(values);
+  }
+  Vec256<float> hi() const {
+    return _mm512_extractf32x8_ps(values, 1);
+  }
+  template <int64_t mask>
+  static Vec512<float> blend(const Vec512<float>& a, const Vec512<float>& b) {
+    return _mm512_mask_blend_ps(static_cast<__mmask16>(mask), a.values, b.values);
+  }
+  static Vec512<float> blendv(const Vec512<float>& a, const Vec512<float>& b,
+                              const Vec512<float>& mask) {
+    auto m = _mm512_movepi32_mask(_mm512_castps_si512(mask.values));
+    return _mm512_mask_blend_ps(m, a.values, b.values);
+  }
+  static Vec512<float> arange(float base = 0.f, float step = 1.f) {
+    return _mm512_fmadd_ps(
+        _mm512_setr_ps(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm512_set1_ps(step),
+        _mm512_set1_ps(base));
+  }
+  static Vec512<float> set(const Vec512<float>& a, const Vec512<float>& b,
+                           int64_t count = size()) {
+    if (count >= size()) {
+      return b;
+    }
+    return _mm512_mask_blend_ps(count_to_mask(count), a.values, b.values);
+  }
+  // Masked loads and stores don't touch (or fault on) the inactive lanes.
+  static Vec512<float> loadu(const void* ptr, int64_t count = size()) {
+    if (count == size())
+      return _mm512_loadu_ps(reinterpret_cast<const float*>(ptr));
+    return _mm512_maskz_loadu_ps(count_to_mask(count), ptr);
+  }
+  void store(void* ptr, int64_t count = size()) const {
+    if (count == size()) {
+      _mm512_storeu_ps(reinterpret_cast<float*>(ptr), values);
+    } else if (count > 0) {
+      _mm512_mask_storeu_ps(ptr, count_to_mask(count), values);
+    }
+  }
+  const float& operator[](int idx) const  = delete;
+  float& operator[](int idx) = delete;
+  Vec512<float> map(float (*f)(float)) const {
+    __at_align64__ float tmp[16];
+    store(tmp);
+    for (int64_t i = 0; i < 16; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return loadu(tmp);
+  }
+  Vec512<float> abs() const {
+    return _mm512_andnot_ps(_mm512_set1_ps(-0.f), values);
+  }
+  Vec512<float> angle() const {
+    return _mm512_set1_ps(0);
+  }
+  Vec512<float> real() const {
+    return *this;
+  }
+  Vec512<float> imag() const {
+    return _mm512_set1_ps(0);
+  }
+  Vec512<float> conj() const {
+    return *this;
+  }
+  Vec512<float> acos() const {
+    return Vec512<float>(Sleef_acosf16_u10(values));
+  }
+  Vec512<float> asin() const {
+    return Vec512<float>(Sleef_asinf16_u10(values));
+  }
+  Vec512<float> atan() const {
+    return Vec512<float>(Sleef_atanf16_u10(values));
+  }
+  Vec512<float> atan2(const Vec512<float> &b) const {
+    return Vec512<float>(Sleef_atan2f16_u10(values, b));
+  }
+  Vec512<float> erf() const {
+    return Vec512<float>(Sleef_erff16_u10(values));
+  }
+  Vec512<float> erfc() const {
+    return Vec512<float>(Sleef_erfcf16_u15(values));
+  }
+  Vec512<float> erfinv() const {
+    return map(calc_erfinv);
+  }
+  Vec512<float> exp() const {
+    return Vec512<float>(Sleef_expf16_u10(values));
+  }
+  Vec512<float> expm1() const {
+    return Vec512<float>(Sleef_expm1f16_u10(values));
+  }
+  Vec512<float> log() const {
+    return Vec512<float>(Sleef_logf16_u10(values));
+  }
+  Vec512<float> log2() const {
+    return Vec512<float>(Sleef_log2f16_u10(values));
+  }
+  Vec512<float> log10() const {
+    return Vec512<float>(Sleef_log10f16_u10(values));
+  }
+  Vec512<float> log1p() const {
+    return Vec512<float>(Sleef_log1pf16_u10(values));
+  }
+  Vec512<float> frac() const;
+  Vec512<float> sin() const {
+    return Vec512<float>(Sleef_sinf16_u10(values));
+  }
+  Vec512<float> sinh() const {
+    return Vec512<float>(Sleef_sinhf16_u10(values));
+  }
+  Vec512<float> cos() const {
+    return Vec512<float>(Sleef_cosf16_u10(values));
+  }
+  Vec512<float> cosh() const {
+    return Vec512<float>(Sleef_coshf16_u10(values));
+  }
+  Vec512<float> ceil() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> floor() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> neg() const {
+    return _mm512_xor_ps(_mm512_set1_ps(-0.f), values);
+  }
+  Vec512<float> round() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> tan() const {
+    return Vec512<float>(Sleef_tanf16_u10(values));
+  }
+  Vec512<float> tanh() const {
+    return Vec512<float>(Sleef_tanhf16_u10(values));
+  }
+  Vec512<float> trunc() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> lgamma() const {
+    return Vec512<float>(Sleef_lgammaf16_u10(values));
+  }
+  Vec512<float> sqrt() const {
+    return _mm512_sqrt_ps(values);
+  }
+  Vec512<float> reciprocal() const {
+    return _mm512_div_ps(_mm512_set1_ps(1), values);
+  }
+  Vec512<float> rsqrt() const {
+    return _mm512_div_ps(_mm512_set1_ps(1), _mm512_sqrt_ps(values));
+  }
+  Vec512<float> pow(const Vec512<float> &b) const {
+    return Vec512<float>(Sleef_powf16_u10(values, b));
+  }
+  // Comparison using the _CMP_**_OQ predicate.
+  //   `O`: get false if an operand is NaN
+  //   `Q`: do not raise if an operand is NaN
+  Vec512<float> operator==(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_EQ_OQ));
+  }
+
+  Vec512<float> operator!=(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_NEQ_OQ));
+  }
+
+  Vec512<float> operator<(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_LT_OQ));
+  }
+
+  Vec512<float> operator<=(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_LE_OQ));
+  }
+
+  Vec512<float> operator>(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_GT_OQ));
+  }
+
+  Vec512<float> operator>=(const Vec512<float>& other) const {
+    return mask_to_vec(_mm512_cmp_ps_mask(values, other.values, _CMP_GE_OQ));
+  }
+};
+
+template <>
+Vec512<float> inline operator+(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_add_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator-(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_sub_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator*(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_mul_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator/(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_div_ps(a, b);
+}
+
+// frac. Implement this here so we can use subtraction
+Vec512<float> Vec512<float>::frac() const {
+  return *this - this->trunc();
+}
+
+// Implements the IEEE 754 201X `maximum` operation, which propagates NaN if
+// either input is a NaN.
+template <>
+Vec512<float> inline maximum(const Vec512<float>& a, const Vec512<float>& b) {
+  auto isnan = _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_mov_ps(
+      _mm512_max_ps(a, b), isnan, _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+}
+
+// Implements the IEEE 754 201X `minimum` operation, which propagates NaN if
+// either input is a NaN.
+template <>
+Vec512<float> inline minimum(const Vec512<float>& a, const Vec512<float>& b) {
+  auto isnan = _mm512_cmp_ps_mask(a, b, _CMP_UNORD_Q);
+  return _mm512_mask_mov_ps(
+      _mm512_min_ps(a, b), isnan, _mm512_set1_ps(std::numeric_limits<float>::quiet_NaN()));
+}
+
+template <>
+Vec512<float> inline clamp(const Vec512<float>& a, const Vec512<float>& min, const Vec512<float>& max) {
+  return _mm512_min_ps(max, _mm512_max_ps(min, a));
+}
+
+template <>
+Vec512<float> inline clamp_max(const Vec512<float>& a, const Vec512<float>& max) {
+  return _mm512_min_ps(max, a);
+}
+
+template <>
+Vec512<float> inline clamp_min(const Vec512<float>& a, const Vec512<float>& min) {
+  return _mm512_max_ps(min, a);
+}
+
+template <>
+Vec512<float> inline operator&(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_and_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator|(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_or_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator^(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_xor_ps(a, b);
+}
+
+template <>
+Vec512<float> inline fmadd(const Vec512<float>& a, const Vec512<float>& b, const Vec512<float>& c) {
+  return _mm512_fmadd_ps(a, b, c);
+}
+
+#endif
+
+}}}
@@ -106,6 +106,8 @@ struct AT_CUDA_API CUDAEvent {
 
   // Note: cudaEventRecord must be called on the same device as the event.
   void record(const CUDAStream& stream) {
+    // The event must come after the work the thread deferred
+    c10::cuda::impl::flushDeferredWork();
     if (!is_created_) {
       createEvent(stream.device_index());
     }
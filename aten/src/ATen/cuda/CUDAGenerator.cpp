@@ -141,11 +141,69 @@ uint64_t CUDAGenerator::philox_offset_per_thread() {
  * See Note [Acquire lock when using random generators]
  */
 std::pair<uint64_t, uint64_t> CUDAGenerator::philox_engine_inputs(uint64_t increment) {
+  TORCH_CHECK(!graph_expects_this_gen_,
+              "This random operator can't be captured in a CUDA graph, since "
+              "it passes the philox seed and offset to its kernel by value");
   uint64_t offset = this->philox_offset_per_thread_;
   this->philox_offset_per_thread_ += increment;
   return std::make_pair(this->seed_, offset);
 }
 
+/**
+ * Like philox_engine_inputs, but the kernel unpacks the seed and offset with
+ * at::cuda::philox::unpack, which lets it be captured in a CUDA graph.
+ *
+ * Note [CUDA graphs and random numbers]
+ * ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+ * A captured kernel would see the seed and the offset of the capture on every
+ * replay, and so generate the same numbers. While a graph is captured, the
+ * kernels get pointers to a seed and an offset in device memory instead,
+ * plus their own offset from the start of the graph. Before each replay the
+ * graph writes the current seed and offset of the generator there and then
+ * advances the offset of the generator by what the whole graph consumes, so
+ * that replays generate the same numbers as running the kernels eagerly.
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+PhiloxCudaState CUDAGenerator::philox_cuda_state(uint64_t increment) {
+  if (graph_expects_this_gen_) {
+    uint64_t offset = this->offset_intragraph_;
+    this->offset_intragraph_ += increment;
+    return PhiloxCudaState(seed_extragraph_, offset_extragraph_, offset);
+  }
+  uint64_t offset = this->philox_offset_per_thread_;
+  this->philox_offset_per_thread_ += increment;
+  return PhiloxCudaState(this->seed_, offset);
+}
+
+/**
+ * Called by CUDAGraph before capturing, with the device memory the captured
+ * kernels read the seed and the offset of each replay from.
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+void CUDAGenerator::capture_prologue(int64_t* seed_extragraph, int64_t* offset_extragraph) {
+  TORCH_CHECK(!graph_expects_this_gen_,
+              "The CUDA generator is already used by a graph being captured");
+  seed_extragraph_ = seed_extragraph;
+  offset_extragraph_ = offset_extragraph;
+  offset_intragraph_ = 0;
+  graph_expects_this_gen_ = true;
+}
+
+/**
+ * Called by CUDAGraph after capturing, returns the offset increment of
+ * a replay of the whole graph.
+ *
+ * See Note [Acquire lock when using random generators]
+ */
+uint64_t CUDAGenerator::capture_epilogue() {
+  graph_expects_this_gen_ = false;
+  seed_extragraph_ = nullptr;
+  offset_extragraph_ = nullptr;
+  return offset_intragraph_;
+}
+
 /*
  * Gets the DeviceType of CUDAGenerator.
  * Used for type checking during run time.
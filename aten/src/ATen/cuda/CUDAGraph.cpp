@@ -0,0 +1,174 @@
+#include <ATen/cuda/CUDAGraph.h>
+
+#include <ATen/CUDAGenerator.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/Exceptions.h>
+#include <c10/cuda/CUDAFunctions.h>
+#include <c10/cuda/CUDAGuard.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace at {
+namespace cuda {
+
+#if defined(CUDART_VERSION) && CUDART_VERSION >= 10010
+
+namespace {
+
+c10::cuda::CUDACachingAllocator::MempoolId_t new_mempool_id() {
+  static std::atomic<uint64_t> next_id{1};
+  return next_id++;
+}
+
+} // namespace
+
+CUDAGraph::CUDAGraph() {}
+
+CUDAGraph::~CUDAGraph() {
+  try {
+    reset();
+  } catch (const c10::Error& e) {
+    TORCH_WARN("Failed to release a CUDA graph: ", e.what());
+  }
+}
+
+void CUDAGraph::capture_begin(
+    c10::optional<c10::cuda::CUDACachingAllocator::MempoolId_t> pool) {
+  TORCH_CHECK(
+      !has_graph_exec_ && !capturing_,
+      "This CUDAGraph was already captured, call reset() before capturing it again");
+
+  capture_device_ = c10::cuda::current_device();
+  auto options = at::TensorOptions().dtype(at::kLong).device(at::kCUDA, capture_device_);
+  seed_extragraph_ = at::empty({1}, options);
+  offset_extragraph_ = at::empty({1}, options);
+  capture_gen_ = at::cuda::detail::getDefaultCUDAGenerator(capture_device_);
+  {
+    // See Note [Acquire lock when using random generators]
+    std::lock_guard<std::mutex> lock(capture_gen_->mutex_);
+    capture_gen_->capture_prologue(
+        seed_extragraph_.data_ptr<int64_t>(), offset_extragraph_.data_ptr<int64_t>());
+  }
+
+  // The capture stream starts after the work queued on the current stream.
+  previous_stream_ = getCurrentCUDAStream(capture_device_);
+  capture_stream_ = getStreamFromPool(/*isHighPriority=*/false, capture_device_);
+  CUDAEvent ready;
+  ready.record(*previous_stream_);
+  ready.block(*capture_stream_);
+  setCurrentCUDAStream(*capture_stream_);
+
+  mempool_id_ = pool ? *pool : new_mempool_id();
+  c10::cuda::CUDACachingAllocator::notifyCaptureBegin(capture_stream_->stream(), mempool_id_);
+  holds_pool_ = true;
+
+  // Other threads keep running their work eagerly. If the capture can't
+  // start, reset() undoes the above.
+  capturing_ = true;
+  AT_CUDA_CHECK(cudaStreamBeginCapture(capture_stream_->stream(), cudaStreamCaptureModeThreadLocal));
+}
+
+void CUDAGraph::capture_end() {
+  TORCH_CHECK(capturing_, "CUDAGraph::capture_end() called without capture_begin()");
+  capturing_ = false;
+
+  cudaError_t err = cudaStreamEndCapture(capture_stream_->stream(), &graph_);
+  c10::cuda::CUDACachingAllocator::notifyCaptureEnd(capture_stream_->stream());
+  {
+    // See Note [Acquire lock when using random generators]
+    std::lock_guard<std::mutex> lock(capture_gen_->mutex_);
+    wholegraph_increment_ = capture_gen_->capture_epilogue();
+  }
+  setCurrentCUDAStream(*previous_stream_);
+  AT_CUDA_CHECK(err);
+  TORCH_CHECK(graph_ != nullptr, "CUDA graph capture produced no graph");
+
+  // The executable graph doesn't need the graph it was instantiated from.
+  AT_CUDA_CHECK(cudaGraphInstantiate(&graph_exec_, graph_, nullptr, nullptr, 0));
+  AT_CUDA_CHECK(cudaGraphDestroy(graph_));
+  graph_ = nullptr;
+  has_graph_exec_ = true;
+}
+
+void CUDAGraph::replay() {
+  TORCH_CHECK(has_graph_exec_, "CUDAGraph::replay() called without a successful capture");
+  CUDAGuard device_guard(capture_device_);
+  if (wholegraph_increment_ > 0) {
+    // See Note [CUDA graphs and random numbers]
+    std::lock_guard<std::mutex> lock(capture_gen_->mutex_);
+    const uint64_t offset = capture_gen_->philox_offset_per_thread();
+    seed_extragraph_.fill_(static_cast<int64_t>(capture_gen_->current_seed()));
+    offset_extragraph_.fill_(static_cast<int64_t>(offset));
+    capture_gen_->set_philox_offset_per_thread(offset + wholegraph_increment_);
+  }
+  AT_CUDA_CHECK(cudaGraphLaunch(graph_exec_, getCurrentCUDAStream()));
+}
+
+void CUDAGraph::reset() {
+  if (capturing_) {
+    // The capture failed midway, e.g. with an exception in the captured code.
+    capturing_ = false;
+    cudaGraph_t graph = nullptr;
+    cudaStreamEndCapture(capture_stream_->stream(), &graph);
+    cudaGetLastError();
+    if (graph) {
+      cudaGraphDestroy(graph);
+    }
+    c10::cuda::CUDACachingAllocator::notifyCaptureEnd(capture_stream_->stream());
+    {
+      std::lock_guard<std::mutex> lock(capture_gen_->mutex_);
+      capture_gen_->capture_epilogue();
+    }
+    setCurrentCUDAStream(*previous_stream_);
+  }
+  if (has_graph_exec_) {
+    has_graph_exec_ = false;
+    AT_CUDA_CHECK(cudaGraphExecDestroy(graph_exec_));
+    graph_exec_ = nullptr;
+  }
+  if (holds_pool_) {
+    // The allocator frees the cached segments of the pool, and cudaFree waits
+    // for any replay still running.
+    holds_pool_ = false;
+    c10::cuda::CUDACachingAllocator::releasePool(mempool_id_);
+  }
+  wholegraph_increment_ = 0;
+}
+
+c10::cuda::CUDACachingAllocator::MempoolId_t CUDAGraph::pool() const {
+  TORCH_CHECK(holds_pool_, "CUDAGraph::pool() called on a graph that wasn't captured");
+  return mempool_id_;
+}
+
+#else
+
+CUDAGraph::CUDAGraph() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+CUDAGraph::~CUDAGraph() {}
+
+void CUDAGraph::capture_begin(
+    c10::optional<c10::cuda::CUDACachingAllocator::MempoolId_t> /*pool*/) {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::capture_end() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::replay() {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+void CUDAGraph::reset() {}
+
+c10::cuda::CUDACachingAllocator::MempoolId_t CUDAGraph::pool() const {
+  AT_ERROR("CUDA graphs require CUDA 10.1 or later");
+}
+
+#endif
+
+} // namespace cuda
+} // namespace at
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/cuda/ATenCUDAGeneral.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <c10/cuda/CUDACachingAllocator.h>
+#include <c10/util/Optional.h>
+
+#include <cstdint>
+
+namespace at {
+
+struct CUDAGenerator;
+
+namespace cuda {
+
+// Captures the kernels one thread launches on a stream into a CUDA graph, and
+// replays them all with a single launch, which saves the CPU side cost of
+// dispatching and launching each of them.
+//
+// The graph replays each kernel on the addresses it used during capture, so
+// the tensors the captured work reads or writes must outlive the graph and
+// new inputs must be copied into the tensors used during capture. The memory
+// allocated during capture comes from a private pool of the caching
+// allocator and stays reserved for the graph until reset() or its
+// destruction. Random kernels using CUDAGenerator::philox_cuda_state draw
+// new numbers on every replay, see Note [CUDA graphs and random numbers].
+//
+// Capture requires CUDA 10.1 and can't happen on the default stream, so
+// capture_begin() makes a stream from the pool current until capture_end().
+// Work that synchronizes with the host, such as copies to the CPU or .item(),
+// can't be captured.
+struct AT_CUDA_API CUDAGraph {
+  CUDAGraph();
+  ~CUDAGraph();
+
+  CUDAGraph(const CUDAGraph&) = delete;
+  CUDAGraph& operator=(const CUDAGraph&) = delete;
+
+  // Captures into the private pool of another graph if `pool` is the pool()
+  // of one, which is safe when the graphs are replayed in the order they were
+  // captured
+  void capture_begin(c10::optional<c10::cuda::CUDACachingAllocator::MempoolId_t> pool = c10::nullopt);
+  void capture_end();
+  // Launches the graph on the current stream
+  void replay();
+  void reset();
+
+  c10::cuda::CUDACachingAllocator::MempoolId_t pool() const;
+
+ private:
+#if defined(CUDART_VERSION) && CUDART_VERSION >= 10010
+  cudaGraph_t graph_ = nullptr;
+  cudaGraphExec_t graph_exec_ = nullptr;
+#endif
+  bool has_graph_exec_ = false;
+  bool capturing_ = false;
+
+  c10::cuda::CUDACachingAllocator::MempoolId_t mempool_id_ = 0;
+  bool holds_pool_ = false;
+
+  // the stream made current for the capture, and the one it replaced
+  c10::optional<CUDAStream> capture_stream_;
+  c10::optional<CUDAStream> previous_stream_;
+  int capture_device_ = -1;
+
+  // the philox seed and offset the captured kernels read on each replay
+  CUDAGenerator* capture_gen_ = nullptr;
+  at::Tensor seed_extragraph_;
+  at::Tensor offset_extragraph_;
+  uint64_t wholegraph_increment_ = 0;
+};
+
+} // namespace cuda
+} // namespace at
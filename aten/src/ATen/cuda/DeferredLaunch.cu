@@ -0,0 +1,333 @@
+#include <ATen/cuda/DeferredLaunch.h>
+
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/Exceptions.h>
+#include <ATen/cuda/PinnedMemoryAllocator.h>
+#include <ATen/native/TensorIterator.h>
+#include <THC/THCCachingHostAllocator.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <c10/util/Metrics.h>
+#include <c10/util/Optional.h>
+
+#include <cstring>
+
+namespace at {
+namespace cuda {
+namespace detail {
+
+namespace {
+
+c10::metrics::Counter deferred_ops(
+    "torch_cuda_deferred_launch_ops_total",
+    "Elementwise CUDA ops queued instead of launched by deferred launches");
+c10::metrics::Counter deferred_flushes(
+    "torch_cuda_deferred_launch_flushes_total",
+    "Kernels launched to run the ops queued by deferred launches");
+
+enum class DeferredDtype : int32_t { Float, Double, Long };
+
+union DeferredValue {
+  double f;
+  int64_t i;
+};
+
+struct DeferredOp {
+  DeferredOpKind kind;
+  DeferredDtype dtype;
+  int32_t numel;
+  void* out;
+  // nullptr for the operand that is `scalar`
+  const void* a;
+  const void* b;
+  DeferredValue scalar;
+  DeferredValue alpha;
+};
+
+constexpr int kDeferredThreads = 512;
+
+template <typename scalar_t>
+__device__ scalar_t deferred_value(DeferredValue v) {
+  return static_cast<scalar_t>(v.f);
+}
+
+template <>
+__device__ int64_t deferred_value<int64_t>(DeferredValue v) {
+  return v.i;
+}
+
+template <typename scalar_t>
+__device__ void run_deferred_op(const DeferredOp& op) {
+  auto out = static_cast<scalar_t*>(op.out);
+  auto a = static_cast<const scalar_t*>(op.a);
+  auto b = static_cast<const scalar_t*>(op.b);
+  const scalar_t scalar = deferred_value<scalar_t>(op.scalar);
+  const scalar_t alpha = deferred_value<scalar_t>(op.alpha);
+  for (int i = threadIdx.x; i < op.numel; i += blockDim.x) {
+    const scalar_t x = a ? a[i] : scalar;
+    const scalar_t y = b ? b[i] : scalar;
+    switch (op.kind) {
+      case DeferredOpKind::Add:
+        out[i] = x + alpha * y;
+        break;
+      case DeferredOpKind::Mul:
+        out[i] = x * y;
+        break;
+      case DeferredOpKind::Div:
+        out[i] = x / y;
+        break;
+      case DeferredOpKind::Fill:
+        out[i] = scalar;
+        break;
+    }
+  }
+}
+
+// A single block runs the ops in the order they were queued, so that each op
+// sees the results of the previous ones
+__global__ void deferred_ops_kernel(const DeferredOp* ops, int num_ops) {
+  __shared__ DeferredOp shared_ops[kMaxDeferredOps];
+  for (int i = threadIdx.x; i < num_ops; i += blockDim.x) {
+    shared_ops[i] = ops[i];
+  }
+  __syncthreads();
+  for (int i = 0; i < num_ops; i++) {
+    switch (shared_ops[i].dtype) {
+      case DeferredDtype::Float:
+        run_deferred_op<float>(shared_ops[i]);
+        break;
+      case DeferredDtype::Double:
+        run_deferred_op<double>(shared_ops[i]);
+        break;
+      case DeferredDtype::Long:
+        run_deferred_op<int64_t>(shared_ops[i]);
+        break;
+    }
+    __syncthreads();
+  }
+}
+
+struct DeferredQueue {
+  bool enabled = false;
+  c10::optional<CUDAStream> stream;
+  int num_ops = 0;
+  DeferredOp ops[kMaxDeferredOps];
+};
+
+thread_local DeferredQueue queue;
+
+void flush_queue() {
+  if (queue.num_ops == 0) {
+    return;
+  }
+  const int num_ops = queue.num_ops;
+  queue.num_ops = 0;
+  c10::cuda::impl::setDeferredWorkFlush(nullptr);
+
+  const CUDAStream stream = *queue.stream;
+  CUDAGuard guard(stream.device_index());
+  // The kernel reads the ops from pinned memory, which stays reserved until
+  // the kernel is done with it
+  const size_t size = num_ops * sizeof(DeferredOp);
+  auto buffer = getPinnedMemoryAllocator()->allocate(size);
+  std::memcpy(buffer.get(), queue.ops, size);
+  deferred_ops_kernel<<<1, kDeferredThreads, 0, stream>>>(
+      static_cast<const DeferredOp*>(buffer.get()), num_ops);
+  AT_CUDA_CHECK(cudaGetLastError());
+  AT_CUDA_CHECK(THCCachingHostAllocator_recordEvent(buffer.get(), stream));
+  deferred_flushes.add();
+}
+
+void enqueue(const DeferredOp& op, CUDAStream stream) {
+  if (queue.num_ops > 0 && *queue.stream != stream) {
+    flush_queue();
+  }
+  if (queue.num_ops == 0) {
+    queue.stream = stream;
+    c10::cuda::impl::setDeferredWorkFlush(&flush_queue);
+  }
+  queue.ops[queue.num_ops++] = op;
+  deferred_ops.add();
+  if (queue.num_ops == kMaxDeferredOps) {
+    flush_queue();
+  }
+}
+
+DeferredValue make_value(ScalarType dtype, Scalar value) {
+  DeferredValue v;
+  if (dtype == kLong) {
+    v.i = value.to<int64_t>();
+  } else if (dtype == kFloat) {
+    v.f = value.to<float>();
+  } else {
+    v.f = value.to<double>();
+  }
+  return v;
+}
+
+// The CPU scalar operand `arg` of `iter` converted to `dtype`, as
+// gpu_kernel_with_scalars does
+DeferredValue scalar_operand(TensorIterator& iter, int arg, ScalarType dtype) {
+  DeferredValue v;
+  if (dtype == kLong) {
+    v.i = iter.scalar_value<int64_t>(arg);
+  } else if (dtype == kFloat) {
+    v.f = iter.scalar_value<float>(arg);
+  } else {
+    v.f = iter.scalar_value<double>(arg);
+  }
+  return v;
+}
+
+// Fills the dtype, size and operands of `op` with those of `iter`, whose
+// output is operand 0, if the op can be deferred
+bool make_deferred_op(TensorIterator& iter, DeferredOp& op) {
+  const auto numel = iter.numel();
+  if (numel == 0 || numel > kMaxDeferredNumel) {
+    return false;
+  }
+  const ScalarType dtype = iter.dtype(0);
+  switch (dtype) {
+    case kFloat:
+      op.dtype = DeferredDtype::Float;
+      break;
+    case kDouble:
+      op.dtype = DeferredDtype::Double;
+      break;
+    case kLong:
+      op.dtype = DeferredDtype::Long;
+      break;
+    default:
+      return false;
+  }
+  op.numel = static_cast<int32_t>(numel);
+  op.a = nullptr;
+  op.b = nullptr;
+  op.scalar.i = 0;
+  op.alpha.i = 0;
+
+  const Device device = iter.device(0);
+  bool has_scalar = false;
+  for (int i = 0; i < iter.ntensors(); i++) {
+    const Tensor& t = iter.tensor(i);
+    if (i > 0 && iter.is_cpu_scalar(i)) {
+      if (has_scalar) {
+        return false;
+      }
+      has_scalar = true;
+      op.scalar = scalar_operand(iter, i, dtype);
+      continue;
+    }
+    // Broadcast operands have fewer elements than the op
+    if (iter.device(i) != device || iter.dtype(i) != dtype ||
+        t.numel() != numel || !t.is_contiguous()) {
+      return false;
+    }
+    void* data = iter.data_ptr(i);
+    if (i == 0) {
+      op.out = data;
+    } else if (i == 1) {
+      op.a = data;
+    } else {
+      op.b = data;
+    }
+  }
+  return true;
+}
+
+// The stream the op would be launched on, unless it is being captured into a
+// CUDA graph, whose replays must not read the queue from pinned memory
+c10::optional<CUDAStream> deferred_stream(const TensorIterator& iter) {
+  const auto stream = c10::cuda::impl::getCurrentCUDAStreamNoFlush(
+      iter.device(0).index());
+#if defined(CUDART_VERSION) && CUDART_VERSION >= 10000
+  cudaStreamCaptureStatus status;
+  AT_CUDA_CHECK(cudaStreamIsCapturing(stream, &status));
+  if (status != cudaStreamCaptureStatusNone) {
+    return c10::nullopt;
+  }
+#endif
+  return stream;
+}
+
+} // namespace
+
+bool defer_binary_op(TensorIterator& iter, DeferredOpKind kind, Scalar alpha) {
+  if (!queue.enabled || iter.ntensors() != 3) {
+    return false;
+  }
+  DeferredOp op;
+  if (!make_deferred_op(iter, op) ||
+      (kind == DeferredOpKind::Div && op.dtype == DeferredDtype::Long)) {
+    return false;
+  }
+  const auto stream = deferred_stream(iter);
+  if (!stream) {
+    return false;
+  }
+  op.kind = kind;
+  op.alpha = make_value(iter.dtype(0), alpha);
+  if (kind == DeferredOpKind::Div && !op.b) {
+    // As div_kernel_cuda, multiply by the reciprocal of a scalar divisor
+    op.kind = DeferredOpKind::Mul;
+    if (op.dtype == DeferredDtype::Float) {
+      op.scalar.f = static_cast<float>(1.0 / static_cast<float>(op.scalar.f));
+    } else {
+      op.scalar.f = 1.0 / op.scalar.f;
+    }
+  }
+  enqueue(op, *stream);
+  iter.cast_outputs();
+  return true;
+}
+
+bool defer_fill(TensorIterator& iter, Scalar value) {
+  if (!queue.enabled || iter.ntensors() != 1) {
+    return false;
+  }
+  DeferredOp op;
+  if (!make_deferred_op(iter, op)) {
+    return false;
+  }
+  const auto stream = deferred_stream(iter);
+  if (!stream) {
+    return false;
+  }
+  op.kind = DeferredOpKind::Fill;
+  op.scalar = make_value(iter.dtype(0), value);
+  enqueue(op, *stream);
+  return true;
+}
+
+} // namespace detail
+
+void set_deferred_launch_enabled(bool enabled) {
+  if (!enabled) {
+    detail::flush_queue();
+  }
+  detail::queue.enabled = enabled;
+}
+
+bool is_deferred_launch_enabled() {
+  return detail::queue.enabled;
+}
+
+void flush_deferred_launches() {
+  detail::flush_queue();
+}
+
+DeferredLaunchGuard::DeferredLaunchGuard(bool enabled)
+    : prev_enabled_(is_deferred_launch_enabled()) {
+  set_deferred_launch_enabled(enabled);
+}
+
+DeferredLaunchGuard::~DeferredLaunchGuard() {
+  try {
+    flush_deferred_launches();
+  } catch (const c10::Error& e) {
+    TORCH_WARN("Failed to flush the deferred CUDA launches: ", e.what());
+  }
+  detail::queue.enabled = prev_enabled_;
+}
+
+} // namespace cuda
+} // namespace at
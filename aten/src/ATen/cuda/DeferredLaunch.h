@@ -0,0 +1,67 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/cuda/ATenCUDAGeneral.h>
+
+#include <cstdint>
+
+namespace at {
+
+struct TensorIterator;
+
+namespace cuda {
+
+// Deferred launches batch the elementwise ops of a thread on small tensors,
+// whose cost is the launch of their kernel rather than its work, e.g. the
+// bookkeeping of metrics and losses in a training loop.
+//
+// While enabled, add, sub, mul, div and fill of contiguous float, double and
+// int64 CUDA tensors of at most kMaxDeferredNumel elements, one of their
+// operands possibly a CPU scalar, aren't launched but queued. The queue runs
+// in order, as a single kernel on its stream, when:
+//
+//   - it is full, or an op is queued on another stream,
+//   - the thread is handed a stream (getCurrentCUDAStream and friends), which
+//     every other kernel launch and copy does, or synchronizes one,
+//   - the caching allocator releases memory to the system,
+//   - flush_deferred_launches() is called or the mode is disabled.
+//
+// The queue belongs to the thread: another thread using the results must
+// synchronize with this one, which should flush first. Ops queued during a
+// CUDA graph capture are launched right away.
+AT_CUDA_API void set_deferred_launch_enabled(bool enabled);
+AT_CUDA_API bool is_deferred_launch_enabled();
+AT_CUDA_API void flush_deferred_launches();
+
+// Enables or disables deferred launches in a scope, flushing the queue on
+// exit
+struct AT_CUDA_API DeferredLaunchGuard {
+  explicit DeferredLaunchGuard(bool enabled = true);
+  ~DeferredLaunchGuard();
+
+  DeferredLaunchGuard(const DeferredLaunchGuard&) = delete;
+  DeferredLaunchGuard& operator=(const DeferredLaunchGuard&) = delete;
+
+ private:
+  bool prev_enabled_;
+};
+
+namespace detail {
+
+constexpr int64_t kMaxDeferredNumel = 4096;
+constexpr int kMaxDeferredOps = 64;
+
+enum class DeferredOpKind : int32_t { Add, Mul, Div, Fill };
+
+// Queues out = a + alpha * b, a * b or a / b, for the add, mul and div of
+// `iter`, if deferred launches are enabled and the op is eligible. Returns
+// whether it was queued, otherwise the caller launches its kernel.
+AT_CUDA_API bool defer_binary_op(
+    TensorIterator& iter,
+    DeferredOpKind kind,
+    Scalar alpha = 1);
+AT_CUDA_API bool defer_fill(TensorIterator& iter, Scalar value);
+
+} // namespace detail
+} // namespace cuda
+} // namespace at
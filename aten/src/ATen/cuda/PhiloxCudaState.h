@@ -0,0 +1,53 @@
+#pragma once
+
+#include <c10/macros/Macros.h>
+
+#include <cstdint>
+#include <utility>
+
+namespace at {
+
+// The arguments of the Philox engine of a kernel launch, as returned by
+// CUDAGenerator::philox_cuda_state. Outside of graph capture they hold the
+// seed and the offset the kernel starts from. A kernel captured in a CUDA
+// graph instead reads the seed and the offset of each replay from device
+// memory, which CUDAGraph::replay fills in, and adds its own offset within
+// the graph. See Note [CUDA graphs and random numbers]
+struct PhiloxCudaState {
+  PhiloxCudaState() = default;
+  PhiloxCudaState(uint64_t seed, uint64_t offset)
+      : seed_(seed), offset_(offset) {}
+  PhiloxCudaState(
+      const int64_t* seed_extragraph,
+      const int64_t* offset_extragraph,
+      uint64_t offset_intragraph)
+      : offset_(offset_intragraph),
+        seed_extragraph_(seed_extragraph),
+        offset_extragraph_(offset_extragraph),
+        captured_(true) {}
+
+  uint64_t seed_ = 0;
+  // relative to the offset of the replay when captured
+  uint64_t offset_ = 0;
+  const int64_t* seed_extragraph_ = nullptr;
+  const int64_t* offset_extragraph_ = nullptr;
+  bool captured_ = false;
+};
+
+namespace cuda {
+namespace philox {
+
+// The seed and the offset to initialize curand with, in device code
+C10_HOST_DEVICE inline std::pair<uint64_t, uint64_t> unpack(
+    const PhiloxCudaState& state) {
+  if (state.captured_) {
+    return std::pair<uint64_t, uint64_t>(
+        static_cast<uint64_t>(*state.seed_extragraph_),
+        static_cast<uint64_t>(*state.offset_extragraph_) + state.offset_);
+  }
+  return std::pair<uint64_t, uint64_t>(state.seed_, state.offset_);
+}
+
+} // namespace philox
+} // namespace cuda
+} // namespace at
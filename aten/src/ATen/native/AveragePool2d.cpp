@@ -87,6 +87,76 @@ static void avg_pool2d_out_frame(
   });
 }
 
+// Channels last version of avg_pool2d_out_frame, summing all the channels
+// of a pixel at once.
+template <typename scalar_t>
+static void avg_pool2d_out_frame_channels_last(
+          scalar_t *input_data,
+          scalar_t *output_data,
+          int64_t nbatch,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t outputWidth,
+          int64_t outputHeight,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          bool count_include_pad,
+          c10::optional<int64_t> divisor_override)
+{
+  at::parallel_for(0, nbatch * outputHeight * outputWidth, 0, [&](int64_t start, int64_t end) {
+    for (auto p = start; p < end; p++)
+    {
+      const int64_t b = p / (outputHeight * outputWidth);
+      const int64_t yy = (p / outputWidth) % outputHeight;
+      const int64_t xx = p % outputWidth;
+
+      int64_t hstart = yy * dH - padH;
+      int64_t wstart = xx * dW - padW;
+      int64_t hend = std::min(hstart + kH, inputHeight + padH);
+      int64_t wend = std::min(wstart + kW, inputWidth + padW);
+      int pool_size = (hend - hstart) * (wend - wstart);
+      hstart = std::max(hstart, (int64_t) 0);
+      wstart = std::max(wstart, (int64_t) 0);
+      hend = std::min(hend, inputHeight);
+      wend = std::min(wend, inputWidth);
+
+      int divide_factor;
+      if (divisor_override.has_value()) {
+        divide_factor = divisor_override.value();
+      } else {
+        if(count_include_pad) {
+          divide_factor = pool_size;
+        } else {
+          divide_factor = (hend - hstart) * (wend - wstart);
+        }
+      }
+
+      const scalar_t *ptr_input = input_data + b*inputHeight*inputWidth*nInputPlane;
+      scalar_t *ptr_output = output_data + p*nInputPlane;
+      for (int64_t c = 0; c < nInputPlane; c++)
+        ptr_output[c] = 0;
+
+      for(int64_t ky = hstart; ky < hend; ky++)
+      {
+        for(int64_t kx = wstart; kx < wend; kx++)
+        {
+          const scalar_t *vals = ptr_input + (ky*inputWidth + kx)*nInputPlane;
+          for (int64_t c = 0; c < nInputPlane; c++)
+            ptr_output[c] += vals[c];
+        }
+      }
+      /* Update output */
+      for (int64_t c = 0; c < nInputPlane; c++)
+        ptr_output[c] /= divide_factor;
+    }
+  });
+}
+
 void avg_pool2d_out_cpu_template(
           Tensor &output,
           const Tensor &input_,
@@ -136,16 +206,23 @@ void avg_pool2d_out_cpu_template(
     inputHeight, inputWidth,
     outputHeight, outputWidth);
 
+  /* channels last inputs give channels last outputs */
+  const auto memory_format = input_.ndimension() == 4 &&
+      input_.suggest_memory_format() == MemoryFormat::ChannelsLast
+      ? MemoryFormat::ChannelsLast
+      : MemoryFormat::Contiguous;
+
   if (input_.ndimension() == 3) {
     output.resize_({nInputPlane, outputHeight, outputWidth});
   }
   else {
     output.resize_({nbatch, nInputPlane, outputHeight, outputWidth});
+    restride_output(output, memory_format);
   }
 
-  TORCH_CHECK(output.is_contiguous(), "avg_pool2d: output must be contiguous");
+  TORCH_CHECK(output.is_contiguous(memory_format), "avg_pool2d: output must be contiguous");
 
-  Tensor input = input_.contiguous();
+  Tensor input = input_.contiguous(memory_format);
 
   AT_DISPATCH_FLOATING_TYPES_AND(at::ScalarType::Long, input.scalar_type(),
     "avg_pool2d_out_frame",
@@ -153,6 +230,22 @@ void avg_pool2d_out_cpu_template(
       scalar_t *input_data = input.data_ptr<scalar_t>();
       scalar_t *output_data = output.data_ptr<scalar_t>();
 
+      if (memory_format == MemoryFormat::ChannelsLast) {
+        avg_pool2d_out_frame_channels_last(
+          input_data,
+          output_data,
+          nbatch,
+          nInputPlane,
+          inputWidth, inputHeight,
+          outputWidth, outputHeight,
+          kW, kH,
+          dW, dH,
+          padW, padH,
+          count_include_pad,
+          divisor_override);
+        return;
+      }
+
       avg_pool2d_out_frame(
         input_data,
         output_data,
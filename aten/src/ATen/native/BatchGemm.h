@@ -0,0 +1,25 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// result[b] = beta * result[b] + alpha * batch1[b] @ batch2[b] for every
+// matrix of a batch of small float or double matrices, parallel over the
+// batch. result and batch2 need unit column strides, but any batch and row
+// strides, and batch1 may have any strides, so strided batches (e.g. views
+// into the heads of an attention layer) need no copies. result is not read
+// when beta is 0.
+using baddbmm_small_fn = void(*)(
+    const Tensor& result, const Tensor& batch1, const Tensor& batch2,
+    Scalar beta, Scalar alpha);
+
+DECLARE_DISPATCH(baddbmm_small_fn, baddbmm_small_stub);
+
+// The largest size of any of the dimensions of the matrices the small kernel
+// is used for. Beyond it, the rows of batch2 it streams through for every
+// block of rows of the result don't fit in the cache any more.
+constexpr int64_t kBaddbmmSmallMaxSize = 128;
+
+}} // namespace at::native
@@ -1,5 +1,7 @@
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/core/grad_mode.h>
+#include <ATen/native/cpu/ConvolutionKernel.h>
 #include <ATen/native/cpu/DepthwiseConvKernel.h>
 #include <ATen/native/utils/ParamUtils.h>
 
@@ -13,6 +15,12 @@ static const int MIOPEN_DIM_MAX = 4;
 namespace at { namespace native {
 
 DEFINE_DISPATCH(convolution_depthwise3x3_winograd_stub);
+DEFINE_DISPATCH(convolution_winograd3x3_stub);
+DEFINE_DISPATCH(convolution_implicit_gemm_stub);
+
+// The full-batch column buffer of thnn_conv2d above which the implicit GEMM,
+// which only unfolds a band of output rows at a time, is used instead.
+static const int64_t CPU_CONV_MAX_COLUMNS_BYTES = 64 * 1024 * 1024;
 
 struct ConvParams {
   std::vector<int64_t> stride;
@@ -39,6 +47,10 @@ struct ConvParams {
   bool use_miopen(const at::Tensor& input) const;
   bool use_mkldnn(const at::Tensor& input) const;
   bool use_nnpack(const at::Tensor& input) const;
+  bool use_cpu_channels_last(const at::Tensor& input) const;
+  bool use_cpu_winograd3x3(const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias) const;
+  int64_t cpu_winograd3x3_output_tile(const at::Tensor& input) const;
+  bool use_cpu_implicit_gemm(const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias) const;
   bool is_depthwise(const at::Tensor& input, const at::Tensor& weight) const;
 };
 
@@ -205,6 +217,87 @@ auto ConvParams::use_nnpack(const at::Tensor& input) const -> bool {
   return false;
 }
 
+auto ConvParams::use_cpu_channels_last(const at::Tensor& input) const -> bool {
+  return input.device().type() == c10::DeviceType::CPU &&
+         !input.is_mkldnn() &&
+         (input.scalar_type() == kFloat || input.scalar_type() == kDouble) &&
+         input.ndimension() == 4 &&
+         input.suggest_memory_format() == at::MemoryFormat::ChannelsLast &&
+         !is_dilated() && // the im2col below doesn't support dilation
+         !transposed;
+}
+
+// The Winograd and implicit GEMM kernels have no backward, so they are only
+// used when no gradient is needed.
+static bool cpu_conv_requires_grad(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias) {
+  auto requires_grad = [](const at::Tensor& t) {
+    return t.defined() && t.is_variable() && t.requires_grad();
+  };
+  return at::GradMode::is_enabled() &&
+         (requires_grad(input) || requires_grad(weight) || requires_grad(bias));
+}
+
+static bool is_cpu_strided_conv2d(const at::Tensor& input, const at::Tensor& weight) {
+  return input.device().type() == c10::DeviceType::CPU &&
+         input.layout() == at::kStrided &&
+         !input.is_mkldnn() &&
+         input.ndimension() == 4 &&
+         weight.device().type() == c10::DeviceType::CPU &&
+         weight.layout() == at::kStrided &&
+         weight.scalar_type() == input.scalar_type();
+}
+
+// F(4x4, 3x3) and F(2x2, 3x3) need 4x and 2.25x fewer multiplies than the
+// direct 3x3 convolution, which only pays off for the transforms when there
+// are enough channels to amortize them over.
+auto ConvParams::use_cpu_winograd3x3(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias) const -> bool {
+  return is_cpu_strided_conv2d(input, weight) &&
+         input.scalar_type() == kFloat &&
+         weight.size(2) == 3 &&
+         weight.size(3) == 3 &&
+         input.size(1) >= 16 &&
+         weight.size(0) >= 16 &&
+         !is_strided() &&
+         !is_dilated() &&
+         !transposed &&
+         cpu_winograd3x3_output_tile(input) > 0 &&
+         !cpu_conv_requires_grad(input, weight, bias);
+}
+
+// 4x4 output tiles for outputs of at least 8x8, 2x2 tiles for outputs down to
+// 4x4, where fewer, larger tiles would mostly compute padding. Returns 0 when
+// the output is too small for either.
+auto ConvParams::cpu_winograd3x3_output_tile(const at::Tensor& input) const -> int64_t {
+  const int64_t out_h = input.size(2) + 2 * padding[0] - 2;
+  const int64_t out_w = input.size(3) + 2 * padding[1] - 2;
+  if (out_h >= 8 && out_w >= 8) {
+    return 4;
+  }
+  if (out_h >= 4 && out_w >= 4) {
+    return 2;
+  }
+  return 0;
+}
+
+// thnn_conv2d unfolds the whole batch before a single GEMM; when that buffer
+// gets large, tiling the unfold over bands of output rows keeps it in cache.
+auto ConvParams::use_cpu_implicit_gemm(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias) const -> bool {
+  if (!is_cpu_strided_conv2d(input, weight) ||
+      (input.scalar_type() != kFloat && input.scalar_type() != kDouble) ||
+      transposed ||
+      cpu_conv_requires_grad(input, weight, bias)) {
+    return false;
+  }
+  int64_t columns = input.size(0) * input.size(1) * weight.size(2) * weight.size(3);
+  for (int64_t d = 0; d < 2; ++d) {
+    columns *= (input.size(d + 2) + 2 * padding[d] - dilation[d] * (weight.size(d + 2) - 1) - 1) / stride[d] + 1;
+  }
+  return columns * static_cast<int64_t>(input.element_size()) > CPU_CONV_MAX_COLUMNS_BYTES;
+}
+
 // We currently only have depthwise support for the case where groups ==
 // nInputPlane and nInputPlane == nOutputPlane (the latter due to the lack of
 // a depthwise multiplier)
@@ -532,6 +625,58 @@ at::Tensor convolution_overrideable(
   AT_ERROR("You are likely triggering this with tensor backend other than CPU/CUDA/MKLDNN, if this is intended, please use torch::RegisterOperators() to override this function ");
 }
 
+// Convolution of a channels last CPU input, computed on its NHWC view so that
+// the output is channels last too, instead of going through the NCHW kernels
+// and transposing twice. A 1x1 convolution is a single GEMM over the pixels,
+// a general one a GEMM with the NHWC im2col of the padded input, whose
+// (channel, kernel row, kernel column) order matches that of the weight.
+// Being made of differentiable ops, it doesn't need a backward of its own.
+static at::Tensor convolution_channels_last_cpu(
+    const Tensor& input, const Tensor& weight, const Tensor& bias,
+    IntArrayRef stride, IntArrayRef padding, int64_t groups) {
+  const int64_t batch_size = input.size(0);
+  const int64_t out_channels_g = weight.size(0) / groups;
+  const int64_t in_channels_g = weight.size(1);
+  const int64_t kernel_h = weight.size(2);
+  const int64_t kernel_w = weight.size(3);
+  const int64_t out_h = (input.size(2) + 2 * padding[0] - kernel_h) / stride[0] + 1;
+  const int64_t out_w = (input.size(3) + 2 * padding[1] - kernel_w) / stride[1] + 1;
+
+  // the NHWC view of a channels last input is (usually) contiguous
+  Tensor input_nhwc = input.permute({0, 2, 3, 1});
+  if (padding[0] != 0 || padding[1] != 0) {
+    input_nhwc = at::constant_pad_nd(
+        input_nhwc, {0, 0, padding[1], padding[1], padding[0], padding[0]});
+  }
+
+  std::vector<Tensor> outputs(groups);
+  for (int64_t g = 0; g < groups; ++g) {
+    Tensor input_g = groups == 1
+        ? input_nhwc : input_nhwc.narrow(3, g * in_channels_g, in_channels_g);
+    Tensor weight_g = weight.narrow(0, g * out_channels_g, out_channels_g)
+        .reshape({out_channels_g, in_channels_g * kernel_h * kernel_w});
+    Tensor columns;
+    if (kernel_h == 1 && kernel_w == 1) {
+      if (stride[0] != 1 || stride[1] != 1) {
+        input_g = input_g.slice(1, 0, input_g.size(1), stride[0])
+                      .slice(2, 0, input_g.size(2), stride[1]);
+      }
+      columns = input_g.reshape({-1, in_channels_g});
+    } else {
+      // (N, out_h, out_w, C, kernel_h, kernel_w)
+      columns = input_g.unfold(1, kernel_h, stride[0])
+                    .unfold(2, kernel_w, stride[1])
+                    .reshape({-1, in_channels_g * kernel_h * kernel_w});
+    }
+    Tensor output_g = bias.defined()
+        ? at::addmm(bias.narrow(0, g * out_channels_g, out_channels_g), columns, weight_g.t())
+        : at::mm(columns, weight_g.t());
+    outputs[g] = output_g.view({batch_size, out_h, out_w, out_channels_g});
+  }
+  Tensor output_nhwc = groups == 1 ? outputs[0] : at::cat(outputs, 3);
+  return output_nhwc.permute({0, 3, 1, 2});
+}
+
 at::Tensor _convolution(
     const Tensor& input_r, const Tensor& weight_r, const Tensor& bias_r,
     IntArrayRef stride_, IntArrayRef padding_, IntArrayRef dilation_,
@@ -540,9 +685,6 @@ at::Tensor _convolution(
 
   const bool input_is_mkldnn = input_r.is_mkldnn();
   auto input = input_r;
-  if (!input_is_mkldnn) {
-    input = input.contiguous();
-  }
   auto weight = weight_r;
   auto bias = bias_r;
   auto k = weight.ndimension();
@@ -568,6 +710,15 @@ at::Tensor _convolution(
 
   check_shape_forward(input, weight, bias, params, input_is_mkldnn);
 
+  if (params.use_cpu_channels_last(input)) {
+    return convolution_channels_last_cpu(
+        input, weight, bias, params.stride, params.padding, params.groups);
+  }
+
+  if (!input_is_mkldnn) {
+    input = input.contiguous();
+  }
+
   if (k == 3) {
     params.view1d_as_2d();
     input = view4d(input);
@@ -719,6 +870,14 @@ at::Tensor _convolution_nogroup(
           return at::_nnpack_spatial_convolution(
               input, weight, bias, padding);
 #endif
+        } else if (params.use_cpu_winograd3x3(input, weight, bias)) {
+          return convolution_winograd3x3_stub(
+              input.device().type(), input, weight, bias, padding,
+              params.cpu_winograd3x3_output_tile(input));
+        } else if (params.use_cpu_implicit_gemm(input, weight, bias)) {
+          return convolution_implicit_gemm_stub(
+              input.device().type(), input, weight, bias,
+              stride, padding, dilation);
         } else {
           /* CPU implementation has specialized MM kernels
              for non-dilated case here */
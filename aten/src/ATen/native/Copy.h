@@ -51,5 +51,12 @@ using copy_fn = void (*)(TensorIterator&, bool non_blocking);
 
 DECLARE_DISPATCH(copy_fn, copy_stub);
 
+// Copies src into the contiguous tensor self of the same sizes and dtype,
+// whatever the strides of src, by tiles of the innermost dimensions of self
+// and src. See copy_permute_kernel in cpu/CopyKernel.cpp.
+using copy_permute_fn = void (*)(Tensor& self, const Tensor& src);
+
+DECLARE_DISPATCH(copy_permute_fn, copy_permute_stub);
+
 } // namespace native
 } // namespace at
@@ -117,6 +117,76 @@ static void max_pool2d_with_indices_out_frame(
   });
 }
 
+// Channels last version of max_pool2d_with_indices_out_frame, with the
+// channels innermost in input, output and indices. The indices still point
+// into the (height, width) plane of each channel.
+template <typename scalar_t>
+static void max_pool2d_with_indices_out_frame_channels_last(
+          scalar_t *input_data,
+          scalar_t *output_data,
+          int64_t *indices_data,
+          int64_t nbatch,
+          int64_t nInputPlane,
+          int64_t inputWidth,
+          int64_t inputHeight,
+          int64_t outputWidth,
+          int64_t outputHeight,
+          int kW,
+          int kH,
+          int dW,
+          int dH,
+          int padW,
+          int padH,
+          int dilationW,
+          int dilationH)
+{
+  at::parallel_for(0, nbatch * outputHeight * outputWidth, 0, [&](int64_t start, int64_t end) {
+    for (auto p = start; p < end; p++)
+    {
+      const int64_t b = p / (outputHeight * outputWidth);
+      const int64_t i = (p / outputWidth) % outputHeight;
+      const int64_t j = p % outputWidth;
+
+      int64_t hstart = i * dH - padH;
+      int64_t wstart = j * dW - padW;
+      int64_t hend = std::min(hstart + (kH - 1) * dilationH + 1, inputHeight);
+      int64_t wend = std::min(wstart + (kW - 1) * dilationW + 1, inputWidth);
+      while(hstart < 0)
+        hstart += dilationH;
+      while(wstart < 0)
+        wstart += dilationW;
+
+      /* local pointers */
+      scalar_t *ip = input_data + b*inputHeight*inputWidth*nInputPlane;
+      scalar_t *op = output_data + p*nInputPlane;
+      int64_t *indp = indices_data + p*nInputPlane;
+
+      for (int64_t c = 0; c < nInputPlane; c++) {
+        op[c] = -std::numeric_limits<scalar_t>::infinity();
+        indp[c] = hstart*inputWidth + wstart;
+      }
+
+      /* compute local max over all channels at once: */
+      for(int64_t y = hstart; y < hend; y += dilationH)
+      {
+        for(int64_t x = wstart; x < wend; x += dilationW)
+        {
+          const int64_t tcntr = y*inputWidth + x;
+          const scalar_t *vals = ip + tcntr*nInputPlane;
+          for (int64_t c = 0; c < nInputPlane; c++) {
+            const scalar_t val = vals[c];
+            if ((val > op[c]) || std::isnan(val))
+            {
+              op[c] = val;
+              indp[c] = tcntr;
+            }
+          }
+        }
+      }
+    }
+  });
+}
+
 void max_pool2d_with_indices_out_cpu_template(
           Tensor& output,
           Tensor& indices,
@@ -170,8 +240,11 @@ void max_pool2d_with_indices_out_cpu_template(
     inputHeight, inputWidth,
     outputHeight, outputWidth);
 
-  /* get contiguous input */
-  Tensor input = input_.contiguous();
+  /* get contiguous input, keeping channels last inputs channels last */
+  const bool channels_last = input_.ndimension() == 4 &&
+      input_.suggest_memory_format() == MemoryFormat::ChannelsLast;
+  Tensor input = input_.contiguous(
+      channels_last ? MemoryFormat::ChannelsLast : MemoryFormat::Contiguous);
 
   /* resize output */
   if (input.ndimension() == 3)
@@ -206,6 +279,30 @@ void max_pool2d_with_indices_out_cpu_template(
     /* indices will contain the locations for each output point */
     indices.resize_({nbatch, nInputPlane, outputHeight, outputWidth});
 
+    if (channels_last) {
+      restride_output(output, MemoryFormat::ChannelsLast);
+      restride_output(indices, MemoryFormat::ChannelsLast);
+      AT_DISPATCH_FLOATING_TYPES(input.scalar_type(),
+        "max_pool2d_with_indices_cpu",
+        [&] {
+          max_pool2d_with_indices_out_frame_channels_last(
+            input.data_ptr<scalar_t>(),
+            output.data_ptr<scalar_t>(),
+            indices.data_ptr<int64_t>(),
+            nbatch,
+            nInputPlane,
+            inputWidth, inputHeight,
+            outputWidth, outputHeight,
+            kW, kH, dW, dH,
+            padW, padH,
+            dilationW, dilationH);
+        }
+      );
+      return;
+    }
+
+    restride_output(output, MemoryFormat::Contiguous);
+    restride_output(indices, MemoryFormat::Contiguous);
     AT_DISPATCH_FLOATING_TYPES(input.scalar_type(),
       "max_pool2d_with_indices_cpu",
       [&] {
@@ -298,7 +395,7 @@ Tensor& max_pool2d_with_indices_backward_out_cpu_template(
           Tensor& gradInput,
           const Tensor& gradOutput_,
           const Tensor& input,
-          const Tensor& indices,
+          const Tensor& indices_,
           IntArrayRef kernel_size,
           IntArrayRef stride,
           IntArrayRef padding,
@@ -332,8 +429,9 @@ Tensor& max_pool2d_with_indices_backward_out_cpu_template(
   TORCH_CHECK((input.ndimension() == 3 || input.ndimension() == 4),
     "non-empty 3D or 4D (batch mode) tensor expected for input");
 
-  /* get contiguous gradOutput */
+  /* get contiguous gradOutput and indices */
   const Tensor gradOutput = gradOutput_.contiguous();
+  const Tensor indices = indices_.contiguous();
 
   /* resize */
   gradInput.resize_as_(input);
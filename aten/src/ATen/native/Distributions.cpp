@@ -4,6 +4,7 @@
 #include <ATen/Dispatch.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/LegacyTHFunctionsCPU.h>
 #include <c10/util/Exception.h>
 #include <ATen/core/EnableNamedTensor.h>
 
@@ -12,6 +13,8 @@
 #include <ATen/core/DistributionsHelper.h>
 #include <ATen/native/Distributions.h>
 #include <ATen/native/DispatchStub.h>
+#include <ATen/native/TensorIterator.h>
+#include <ATen/native/cpu/Loops.h>
 #include <ATen/native/UnaryOps.h>
 #include <ATen/NamedTensorUtils.h>
 
@@ -163,9 +166,50 @@ Tensor& bernoulli_tensor_cpu_(Tensor& self, const Tensor& p_, Generator* gen) {
 }
 
 DEFINE_DISPATCH(bernoulli_mkl_stub);
+DEFINE_DISPATCH(uniform_philox_stub);
+DEFINE_DISPATCH(normal_philox_stub);
+DEFINE_DISPATCH(bernoulli_philox_stub);
+
+namespace {
+
+// See Note [Philox mode of CPUGenerator]
+bool cpu_philox_mode(Generator* gen) {
+  CPUGenerator* generator = get_generator_or_default<CPUGenerator>(gen, detail::getDefaultCPUGenerator());
+  // See Note [Acquire lock when using random generators]
+  std::lock_guard<std::mutex> lock(generator->mutex_);
+  return generator->philox_mode();
+}
+
+bool is_floating_philox_type(const Tensor& self) {
+  return self.scalar_type() == kFloat || self.scalar_type() == kDouble;
+}
+
+} // namespace
+
+Tensor& uniform_cpu_(Tensor& self, double from, double to, Generator* gen) {
+  if (is_floating_philox_type(self) && cpu_philox_mode(gen)) {
+    TORCH_CHECK(from <= to, "uniform_ expects to return a [from, to) range, but found from=", from, " > to=", to);
+    uniform_philox_stub(kCPU, self, from, to, gen);
+    return self;
+  }
+  return legacy::cpu::_th_uniform_(self, from, to, gen);
+}
+
+Tensor& normal_cpu_(Tensor& self, double mean, double std, Generator* gen) {
+  if (is_floating_philox_type(self) && cpu_philox_mode(gen)) {
+    TORCH_CHECK(std > 0.0, "normal_ expects std > 0.0, but found std=", std);
+    normal_philox_stub(kCPU, self, mean, std, gen);
+    return self;
+  }
+  return legacy::cpu::_th_normal_(self, mean, std, gen);
+}
 
 Tensor& bernoulli_scalar_cpu_(Tensor& self, double p, Generator* gen) {
   TORCH_CHECK(0 <= p && p <= 1, "bernoulli_ expects p to be in [0, 1], but got p=", p);
+  if (cpu_philox_mode(gen)) {
+    bernoulli_philox_stub(kCPU, self, p, gen);
+    return self;
+  }
 #if AT_MKL_ENABLED()
   if (cpuinfo_initialize() && cpuinfo_vendor_intel == cpuinfo_get_processor(0)->core->vendor) {
     bernoulli_mkl_stub(kCPU, self, p, gen);
@@ -188,24 +232,31 @@ Tensor& bernoulli_scalar_cpu_(Tensor& self, double p, Generator* gen) {
 
 Tensor _standard_gamma_grad_cpu(const Tensor& self, const Tensor& output) {
   Tensor ret = at::empty(self.sizes(), self.options());
+  auto iter = TensorIterator();
+  iter.add_output(ret);
+  iter.add_input(self);
+  iter.add_input(output);
+  iter.build();
   AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "_standard_gamma_grad_cpu", [&] {
-    CPU_tensor_apply3<scalar_t, scalar_t, scalar_t>(ret, self, output,
-      [](scalar_t& ret_val, const scalar_t& self_val, const scalar_t &output_val) {
-        ret_val = standard_gamma_grad_one<scalar_t, double>(self_val, output_val);
-      }
-    );
+    cpu_kernel(iter, [](scalar_t self_val, scalar_t output_val) -> scalar_t {
+      return standard_gamma_grad_one<scalar_t, double>(self_val, output_val);
+    });
   });
   return ret;
 }
 
 Tensor _dirichlet_grad_cpu(const Tensor& x, const Tensor& alpha, const Tensor& total) {
   Tensor ret = at::empty(x.sizes(), x.options());
+  auto iter = TensorIterator();
+  iter.add_output(ret);
+  iter.add_input(x);
+  iter.add_input(alpha);
+  iter.add_input(total);
+  iter.build();
   AT_DISPATCH_FLOATING_TYPES(x.scalar_type(), "_dirichlet_grad_cpu", [&] {
-    CPU_tensor_apply4<scalar_t, scalar_t, scalar_t, scalar_t>(ret, x, alpha, total,
-      [](scalar_t& ret_val, const scalar_t& x_val, const scalar_t& alpha_val, const scalar_t& total_val) {
-        ret_val = dirichlet_grad_one<scalar_t, double>(x_val, alpha_val, total_val);
-      }
-    );
+    cpu_kernel(iter, [](scalar_t x_val, scalar_t alpha_val, scalar_t total_val) -> scalar_t {
+      return dirichlet_grad_one<scalar_t, double>(x_val, alpha_val, total_val);
+    });
   });
   return ret;
 }
@@ -332,6 +383,94 @@ Tensor multinomial(const Tensor& self, int64_t n_sample, bool with_replacement,
   return result;
 }
 
+std::tuple<Tensor, Tensor> _multinomial_alias_setup_cpu(const Tensor& probs_) {
+  TORCH_CHECK(probs_.dim() == 1,
+      "expected 1-D probability tensor, got ", probs_.dim(), "-D probability tensor instead");
+  auto probs = probs_.contiguous();
+  int64_t n_categories = probs.numel();
+  Tensor J = at::empty({n_categories}, probs.options().dtype(kLong));
+  Tensor q = at::empty({n_categories}, probs.options());
+
+  // Vose's alias method: every outcome i owns an equal 1 / n_categories
+  // share of the probability mass. It keeps the fraction q[i] of it and
+  // gives the rest to its alias J[i], so that a draw only needs a uniform
+  // index and a biased coin.
+  AT_DISPATCH_FLOATING_TYPES(probs.scalar_type(), "_multinomial_alias_setup", [&] {
+    const scalar_t* probs_data = probs.data_ptr<scalar_t>();
+    int64_t* J_data = J.data_ptr<int64_t>();
+    scalar_t* q_data = q.data_ptr<scalar_t>();
+
+    std::vector<int64_t> smaller, larger;
+    smaller.reserve(n_categories);
+    larger.reserve(n_categories);
+    for (int64_t i = 0; i < n_categories; i++) {
+      J_data[i] = -1;
+      q_data[i] = n_categories * probs_data[i];
+      if (q_data[i] < 1.0) {
+        smaller.push_back(i);
+      } else {
+        larger.push_back(i);
+      }
+    }
+
+    // Loop through and create little binary mixtures that
+    // appropriately allocate the larger outcomes over the
+    // overall uniform mixture.
+    while (!smaller.empty() && !larger.empty()) {
+      int64_t large = larger.back();
+      int64_t small = smaller.back();
+
+      J_data[small] = large;
+      q_data[large] -= 1.0 - q_data[small];
+
+      if (q_data[large] < 1.0) {
+        smaller.back() = large;
+        larger.pop_back();
+      } else {
+        smaller.pop_back();
+      }
+    }
+
+    scalar_t q_min = q_data[n_categories - 1];
+    scalar_t q_max = q_min;
+    for (int64_t i = 0; i < n_categories; i++) {
+      q_min = std::min(q_min, q_data[i]);
+      q_max = std::max(q_max, q_data[i]);
+    }
+    TORCH_CHECK(q_min >= 0, "q_min is less than 0");
+
+    if (q_max > 1) {
+      for (int64_t i = 0; i < n_categories; i++) {
+        q_data[i] /= q_max;
+      }
+    }
+    for (int64_t i = 0; i < n_categories; i++) {
+      // sometimes an large index isn't added to J.
+      // fix it by making the probability 1 so that J isn't indexed.
+      if (J_data[i] < 0) {
+        q_data[i] = 1.0;
+      }
+    }
+  });
+  return std::make_tuple(J, q);
+}
+
+// Note that the tables are passed in the order (q, J), the reverse of the
+// order _multinomial_alias_setup returns them in.
+Tensor _multinomial_alias_draw_cpu(const Tensor& q, const Tensor& J, int64_t n_sample, Generator* gen) {
+  TORCH_CHECK(q.dim() == 1,
+      "expected 1-D probability table, got ", q.dim(), "-D probability table instead");
+  TORCH_CHECK(J.dim() == 1,
+      "expected 1-D alias table, got ", J.dim(), "-D alias table instead");
+  TORCH_CHECK(n_sample > 0, "cannot sample <= 0 samples");
+  TORCH_CHECK(q.numel() == J.numel(),
+      "expected probability and alias tables of the same size, got ", q.numel(), " and ", J.numel());
+  Tensor result = at::empty({n_sample}, J.options());
+  multinomial_alias_draw_stub(kCPU, result, q.contiguous(), J.contiguous(), gen);
+  return result;
+}
+
 DEFINE_DISPATCH(multinomial_stub);
+DEFINE_DISPATCH(multinomial_alias_draw_stub);
 
 }} // namespace at::native
@@ -2,6 +2,7 @@
 #include <ATen/NativeFunctions.h>
 #include <ATen/Parallel.h>
 #include <ATen/TensorUtils.h>
+#include <ATen/native/EmbeddingBag.h>
 
 #include <TH/THBlasUtils.h>
 
@@ -11,6 +12,7 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <utility>
 #include <vector>
 #include <algorithm>
 
@@ -41,157 +43,149 @@ bool isFastPathIndexSelectScale(const Tensor& src, const Tensor& scale, Tensor&
   return src.scalar_type() == kFloat && src.stride(1) == 1 && output.stride(1) == 1 && scale.stride(0) == 1;
 }
 
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
+// Returns the range of `indices` making up bag `bag`.
+inline std::pair<int64_t, int64_t> bag_range(
+    const int64_t* offsets_data, int64_t num_bags, int64_t numel, int64_t bag) {
+  const int64_t start = offsets_data[bag];
+  const int64_t end = bag + 1 < num_bags ? offsets_data[bag + 1] : numel;
+  return std::make_pair(start, std::min(end, numel));
+}
+
+// Sums the rows of `src` selected by `select_indices` into the row of
+// `output` of their bag, scaling each by its entry in `scale` if that is
+// defined. The bags are split between threads, so every output row is
+// written by a single one, and the rows a few indices ahead are prefetched
+// since for large tables the lookup is bound by the latency of cache misses.
 template<typename T>
-void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output,
-                             const Tensor& /*offsets*/) {
-  AT_ASSERT(select_indices.numel() == add_indices.numel());
-  auto add_indices_data = add_indices.data_ptr<int64_t>();
+void index_select_add_bags(const Tensor &select_indices,
+                           const Tensor &offsets,
+                           const Tensor &src,
+                           const Tensor &scale,
+                           Tensor &output) {
   auto select_indices_data = select_indices.data_ptr<int64_t>();
+  auto offsets_data = offsets.data_ptr<int64_t>();
   auto src_data = src.data_ptr<T>();
   auto output_data = output.data_ptr<T>();
-  auto numel = add_indices.numel();
+  auto scale_data = scale.defined() ? scale.data_ptr<T>() : nullptr;
+  auto scale_stride = scale.defined() ? scale.stride(0) : 0;
+  int64_t num_bags = offsets.numel();
+  int64_t numel = select_indices.numel();
+  int64_t num_weights = src.size(0);
   int64_t ddim = src.size(1);
   auto src_stride0 = src.stride(0);
   auto src_stride1 = src.stride(1);
   auto output_stride0 = output.stride(0);
   auto output_stride1 = output.stride(1);
 
-  for (int64_t i = 0; i < numel; i++) {
-    THBlas_axpy<T>(ddim, 1,
-            src_data + src_stride0 * select_indices_data[i], src_stride1,
-            output_data + output_stride0 * add_indices_data[i], output_stride1);
-  }
+  at::parallel_for(0, num_bags, embedding_bag_grain_size(num_bags, numel, ddim),
+                   [&](int64_t bag_begin, int64_t bag_end) {
+    for (int64_t bag = bag_begin; bag < bag_end; bag++) {
+      auto range = bag_range(offsets_data, num_bags, numel, bag);
+      auto* output_base = output_data + output_stride0 * bag;
+      for (int64_t i = range.first; i < range.second; i++) {
+        auto idx = select_indices_data[i];
+        TORCH_CHECK(idx >= 0 && idx < num_weights,
+            "embedding_bag: index ", idx, " is out of bounds for a weight with ",
+            num_weights, " rows");
+#ifdef __GNUC__
+        if (i + kEmbeddingBagPrefetchDistance < range.second) {
+          __builtin_prefetch(
+              src_data + src_stride0 * select_indices_data[i + kEmbeddingBagPrefetchDistance], 0, 1);
+        }
+#endif // __GNUC__
+        T w = scale_data ? scale_data[i * scale_stride] : static_cast<T>(1);
+        THBlas_axpy<T>(ddim, w,
+                src_data + src_stride0 * idx, src_stride1,
+                output_base, output_stride1);
+      }
+    }
+  });
 }
 
-template<>
-void index_select_add<float>(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output,
-                             const Tensor& offsets) {
-  int64_t ddim = src.size(1);
-  auto src_data = src.data_ptr<float>();
+// Runs caffe2::EmbeddingLookupIdx (which is vectorized and prefetches on its
+// own) on chunks of bags in parallel. It expects the offsets of the bags it
+// is given to be relative to the first one.
+void embedding_lookup_bags(const Tensor &select_indices,
+                           const Tensor &offsets,
+                           const Tensor &src,
+                           const float* scale_data,
+                           Tensor &output) {
   auto select_indices_data = select_indices.data_ptr<int64_t>();
+  auto offsets_data = offsets.data_ptr<int64_t>();
+  auto src_data = src.data_ptr<float>();
   auto output_data = output.data_ptr<float>();
+  int64_t num_bags = offsets.numel();
+  int64_t numel = select_indices.numel();
+  int64_t ddim = src.size(1);
 
-  if (isFastPathIndexSelect(src, output)) {
+  at::parallel_for(0, num_bags, embedding_bag_grain_size(num_bags, numel, ddim),
+                   [&](int64_t bag_begin, int64_t bag_end) {
+    int64_t first = offsets_data[bag_begin];
+    int64_t last = bag_end < num_bags ? offsets_data[bag_end] : numel;
+    std::vector<int64_t> chunk_offsets(bag_end - bag_begin);
+    for (int64_t bag = bag_begin; bag < bag_end; bag++) {
+      chunk_offsets[bag - bag_begin] = offsets_data[bag] - first;
+    }
     caffe2::EmbeddingLookupIdx(
       /*block_size=*/ddim,
-      /*output_size=*/offsets.numel(),
-      /*index_size=*/select_indices.numel(),
+      /*output_size=*/bag_end - bag_begin,
+      /*index_size=*/last - first,
       /*data_size=*/src.size(0),
       /*input=*/src_data,
-      /*indices=*/select_indices_data,
-      /*offsets=*/offsets.data_ptr<int64_t>(),
-      /*weights=*/nullptr,
+      /*indices=*/select_indices_data + first,
+      /*offsets=*/chunk_offsets.data(),
+      /*weights=*/scale_data ? scale_data + first : nullptr,
       /*scale_bias=*/nullptr,
       /*normalize_by_lengths=*/false,
-      /*out=*/output_data
+      /*out=*/output_data + ddim * bag_begin
     );
+  });
+}
+
+template<typename T>
+void index_select_add(const Tensor &select_indices,
+                      const Tensor &src,
+                      Tensor &output,
+                      const Tensor& offsets) {
+  index_select_add_bags<T>(select_indices, offsets, src, Tensor(), output);
+}
+
+template<>
+void index_select_add<float>(const Tensor &select_indices,
+                             const Tensor &src,
+                             Tensor &output,
+                             const Tensor& offsets) {
+  if (isFastPathIndexSelect(src, output)) {
+    embedding_lookup_bags(select_indices, offsets, src, nullptr, output);
   } else {
-    AT_ASSERT(select_indices.numel() == add_indices.numel());
-    auto add_indices_data = add_indices.data_ptr<int64_t>();
-    auto src_stride0 = src.stride(0);
-    auto src_stride1 = src.stride(1);
-    auto output_stride0 = output.stride(0);
-    auto output_stride1 = output.stride(1);
-    auto numel = add_indices.numel();
-    for (int64_t i = 0; i < numel; i++) {
-      THBlas_axpy<float>(ddim, 1,
-              src_data + src_stride0 * select_indices_data[i], src_stride1,
-              output_data + output_stride0 * add_indices_data[i], output_stride1);
-    }
+    index_select_add_bags<float>(select_indices, offsets, src, Tensor(), output);
   }
 }
 
 // This function fuses the following three fns:
 // index_select (using select_indices as the index)
 // mul (scaling by per_sample_weights)
-// index_add (using add_indices as the index)
+// index_add (into the bag given by offsets)
 template<typename T>
 static void index_select_scale_add(const Tensor &select_indices,
-                                   const Tensor &add_indices,
                                    const Tensor &scale,
                                    const Tensor &src,
                                    Tensor &output,
-                                   const Tensor& /*offsets*/) {
-  AT_ASSERT(select_indices.numel() == add_indices.numel());
-  auto add_indices_data = add_indices.data_ptr<int64_t>();
-  auto select_indices_data = select_indices.data_ptr<int64_t>();
-  auto src_data = src.data_ptr<T>();
-  auto output_data = output.data_ptr<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.size(1);
-  auto src_stride0 = src.stride(0);
-  auto src_stride1 = src.stride(1);
-  auto output_stride0 = output.stride(0);
-  auto output_stride1 = output.stride(1);
-
-  auto* scale_data = scale.data_ptr<T>();
-  auto scale_stride = scale.stride(0);
-
-  for (int64_t i = 0; i < numel; i++) {
-    auto* src_base = src_data + src_stride0 * select_indices_data[i];
-    auto* output_base = output_data + output_stride0 * add_indices_data[i];
-    auto scale = scale_data[i * scale_stride];
-    for (int64_t j = 0; j < ddim; j++) {
-      output_base[j * output_stride1] += src_base[j * src_stride1] * scale;
-    }
-  }
+                                   const Tensor& offsets) {
+  index_select_add_bags<T>(select_indices, offsets, src, scale, output);
 }
 
 template<>
 void index_select_scale_add<float>(const Tensor &select_indices,
-                                          const Tensor &add_indices,
-                                          const Tensor &scale,
-                                          const Tensor &src,
-                                          Tensor &output,
-                                          const Tensor& offsets) {
-  int64_t ddim = src.size(1);
-  auto* scale_data = scale.data_ptr<float>();
-  auto select_indices_data = select_indices.data_ptr<int64_t>();
-  auto src_data = src.data_ptr<float>();
-  auto output_data = output.data_ptr<float>();
-
+                                   const Tensor &scale,
+                                   const Tensor &src,
+                                   Tensor &output,
+                                   const Tensor& offsets) {
   if (isFastPathIndexSelectScale(src, scale, output)) {
-    caffe2::EmbeddingLookupIdx(
-      /*block_size=*/ddim,
-      /*output_size=*/offsets.numel(),
-      /*index_size=*/select_indices.numel(),
-      /*data_size=*/src.size(0),
-      /*input=*/src_data,
-      /*indices=*/select_indices_data,
-      /*offsets=*/offsets.data_ptr<int64_t>(),
-      /*weights=*/scale_data,
-      /*scale_bias=*/nullptr,
-      /*normalize_by_lengths=*/false,
-      /*out=*/output_data
-    );
+    embedding_lookup_bags(
+        select_indices, offsets, src, scale.data_ptr<float>(), output);
   } else {
-    AT_ASSERT(select_indices.numel() == add_indices.numel());
-    auto add_indices_data = add_indices.data_ptr<int64_t>();
-    auto src_stride0 = src.stride(0);
-    auto src_stride1 = src.stride(1);
-    auto output_stride0 = output.stride(0);
-    auto output_stride1 = output.stride(1);
-    auto scale_stride = scale.stride(0);
-    auto numel = add_indices.numel();
-
-
-    for (int64_t i = 0; i < numel; i++) {
-      auto* src_base = src_data + src_stride0 * select_indices_data[i];
-      auto* output_base = output_data + output_stride0 * add_indices_data[i];
-      auto scale = scale_data[i * scale_stride];
-      for (int64_t j = 0; j < ddim; j++) {
-        output_base[j * output_stride1] += src_base[j * src_stride1] * scale;
-      }
-    }
+    index_select_add_bags<float>(select_indices, offsets, src, scale, output);
   }
 }
 
@@ -248,50 +242,7 @@ static Tensor apply_bag_size_backward(const Tensor &offsets,
   return output;
 }
 
-
-template <typename scalar_t>
-std::tuple<Tensor, Tensor, Tensor, Tensor> embedding_bag_cpu_max(
-    const Tensor& weight,
-    const Tensor& indices,
-    const Tensor& offset2bag,
-    const Tensor& output,
-    const Tensor& bag_size,
-    const Tensor& offsets) {
-
-    auto max_indices = at::zeros({offsets.size(0), weight.size(1)}, indices.options());
-
-    int64_t numel = indices.numel();
-    int64_t dims = weight.size(1);
-    auto indices_data = indices.data_ptr<int64_t>();
-    auto offset2bag_data = offset2bag.data_ptr<int64_t>();
-
-    auto max_indices_data = max_indices.data_ptr<int64_t>();
-    auto max_indices_stride = max_indices.stride(0);
-
-    auto weight_data = weight.data_ptr<scalar_t>();
-    auto output_data = output.data_ptr<scalar_t>();
-    auto weight_stride0 = weight.stride(0);
-    auto weight_stride1 = weight.stride(1);
-    auto output_stride = output.stride(0);
-
-    for (int i = 0; i < numel; i++) {
-      auto bag = offset2bag_data[i];
-      auto word_idx = indices_data[i];
-
-      for (int dim = 0; dim < dims; dim++) {
-        auto& current_item = output_data[output_stride * bag + dim];
-        auto weight_item = weight_data[weight_stride0 * word_idx + dim * weight_stride1];
-        bool is_first_for_bag = (i == 0) || offset2bag_data[i - 1] != bag;
-
-        if (is_first_for_bag || weight_item > current_item) {
-          current_item = weight_item;
-          max_indices_data[max_indices_stride * bag + dim] = word_idx;
-        }
-      }
-    }
-
-    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
-}
+DEFINE_DISPATCH(embedding_bag_max_stub);
 
 // embedding_bag wrapper to enforce contiguity in tensors other than `weight`.
 // This is created to save extra `.contiguous()` call in backward.
@@ -305,6 +256,44 @@ embedding_bag(const Tensor &weight, const Tensor &indices,
                             scale_grad_by_freq, mode, sparse, per_sample_weights);
   };
 
+// The segment reductions of caffe2 (SparseLengthsSum, SparseLengthsMean,
+// SparseLengthsMax and SparseLengthsWeightedSum) run the kernels of
+// embedding_bag, which are the caffe2 perfkernels on CPU and a segmented
+// reduction on CUDA. Their indices, offsets and lengths may be int32, as
+// those of caffe2 models usually are.
+Tensor segment_reduce(const Tensor &data, const Tensor &indices,
+                      const Tensor &offsets, int64_t mode,
+                      const Tensor &weights) {
+  TORCH_CHECK(data.dim() == 2,
+      "segment_reduce: data must be 2D, got ", data.dim(), "D");
+  TORCH_CHECK(indices.dim() == 1 && offsets.dim() == 1,
+      "segment_reduce: indices and offsets must be 1D");
+  TORCH_CHECK(mode == MODE_SUM || mode == MODE_MEAN || mode == MODE_MAX,
+      "segment_reduce: unknown mode ", mode);
+  TORCH_CHECK(!weights.defined() || mode == MODE_SUM,
+      "segment_reduce: weights are only supported with the sum mode");
+  if (offsets.numel() == 0) {
+    return at::zeros({0, data.size(1)}, data.options());
+  }
+  return std::get<0>(at::embedding_bag(
+      data, indices.to(kLong), offsets.to(kLong),
+      /*scale_grad_by_freq=*/false, mode, /*sparse=*/false, weights));
+}
+
+Tensor sparse_lengths_reduce(const Tensor &data, const Tensor &indices,
+                             const Tensor &lengths, int64_t mode,
+                             const Tensor &weights) {
+  TORCH_CHECK(lengths.dim() == 1,
+      "sparse_lengths_reduce: lengths must be 1D");
+  auto lengths_long = lengths.to(kLong);
+  // The offset of a segment is the sum of the lengths of the previous ones
+  auto offsets = lengths_long.cumsum(0) - lengths_long;
+  TORCH_CHECK(lengths_long.sum().item<int64_t>() == indices.numel(),
+      "sparse_lengths_reduce: the lengths must sum to the number of indices, ",
+      indices.numel());
+  return at::segment_reduce(data, indices, offsets, mode, weights);
+}
+
 // Assumes all input tensors except for `weight` are contiguous.
 // See NOTE [ embedding_bag Native Functions ] in native_functions.yaml for details
 std::tuple<Tensor, Tensor, Tensor, Tensor>
@@ -334,56 +323,29 @@ _embedding_bag_cpu(const Tensor &weight, const Tensor &indices,
 
   auto output = at::zeros({offsets.size(0), weight.size(1)}, weight.options());
 
-  // To save compute, if we are going to go down the fast path case for the 'sum'
-  // mode, we skip calculating offset2bag, since it is not going to be used.
-  auto fast_path_sum = [&weight, &per_sample_weights, &output]() {
-    if (per_sample_weights.defined()) {
-      return isFastPathIndexSelectScale(weight, per_sample_weights, output);
-    } else {
-      return isFastPathIndexSelect(weight, output);
-    }
-  };
-
-  // Use an empty 0-element tensor as a sentinel that we have skipped the
-  // creation of offset2bag because autograd chokes when trying to use an
-  // undefined tensor as an input to a backward op.
+  // None of the modes needs offset2bag, since the bags are split between
+  // threads by their offsets. Use an empty 0-element tensor as a sentinel
+  // that we have skipped its creation (the backward functions create it when
+  // they need it) because autograd chokes when trying to use an undefined
+  // tensor as an input to a backward op.
   Tensor offset2bag = at::empty({0}, offsets.options());
-  if (mode == MODE_MEAN || mode == MODE_MAX || !fast_path_sum()) {
-    // If the last entries are empty, that the last offsets are irrelevant as they
-    // won't change anything in the assignment of ID -> bag, but index_add would
-    // throw out of bounds error. So to keep it simple we just add one more
-    // entry to the end then get rid of it after make_offset2bag.
-    offset2bag = at::zeros(
-       {indices.sizes()[0] + 1}, indices.options()); // offset2bag = [0 0 0 0 0]
-
-    make_offset2bag(offsets, indices, offset2bag);
-
-    offset2bag.resize_({indices.sizes()[0]});
-  }
 
   if (mode == MODE_MEAN || mode == MODE_SUM) {
     AT_DISPATCH_FLOATING_TYPES(weight.scalar_type(), "embedding_bag_cpu", [&]() {
       if (per_sample_weights.defined()) {
         AT_ASSERT(mode == MODE_SUM);
         index_select_scale_add<scalar_t>(
-            indices, offset2bag, per_sample_weights, weight, output, offsets);
+            indices, per_sample_weights, weight, output, offsets);
       } else {
-        index_select_add<scalar_t>(indices, offset2bag, weight, output, offsets);
+        index_select_add<scalar_t>(indices, weight, output, offsets);
       }
     });
     auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
     return std::tuple<Tensor, Tensor, Tensor, Tensor>(ret, offset2bag, bag_size, bag_size);
   } else { // MODE_MAX
-    at::optional<Tensor> maybe_per_sample_weights;
-    if (per_sample_weights.defined()) {
-      maybe_per_sample_weights = per_sample_weights;
-    }
-    return AT_DISPATCH_FLOATING_TYPES_AND_HALF(
-      weight.scalar_type(), "embedding_bag_cpu_max", [&]() {
-        return embedding_bag_cpu_max<scalar_t>(
-            weight, indices, offset2bag, output, bag_size, offsets);
-      }
-    );
+    auto max_indices = at::zeros({offsets.size(0), weight.size(1)}, indices.options());
+    embedding_bag_max_stub(kCPU, weight, indices, offsets, output, max_indices);
+    return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag, bag_size, max_indices);
   }
 }
 
@@ -703,5 +665,110 @@ Tensor _embedding_bag_sparse_backward(
   return native::embedding_backward(index_grad, indices, num_weights, -1,
                                     scale_grad_by_freq, true);
 }
+
+// Accumulates the gradient of every index straight into one row per unique
+// index of the values of a coalesced sparse gradient, rather than first
+// gathering a (num_indices x embedding_dim) gradient like the generic
+// _embedding_bag_sparse_backward does and leaving the duplicates to be summed
+// when the result is coalesced.
+template <typename scalar_t>
+Tensor _embedding_bag_sparse_backward_cpu_sum_mean(
+    const Tensor &grad, const Tensor &indices, const Tensor &offsets,
+    const Tensor &offset2bag, const Tensor &bag_size, int64_t num_weights,
+    int64_t mode, const Tensor& per_sample_weights) {
+  int64_t numel = indices.numel();
+  int64_t ddim = grad.size(1);
+
+  auto ind_sort = indices.sort();
+  auto sorted_indices = std::get<0>(ind_sort);
+  auto sort_perm = std::get<1>(ind_sort);
+  auto sorted_indices_data = sorted_indices.data_ptr<int64_t>();
+  auto sort_perm_data = sort_perm.data_ptr<int64_t>();
+
+  // segment_starts[u] is the position of the first occurrence of the u-th
+  // unique index in sorted_indices, with numel appended.
+  std::vector<int64_t> segment_starts;
+  for (int64_t i = 0; i < numel; i++) {
+    if (i == 0 || sorted_indices_data[i] != sorted_indices_data[i - 1]) {
+      segment_starts.push_back(i);
+    }
+  }
+  int64_t num_unique = segment_starts.size();
+  segment_starts.push_back(numel);
+
+  auto unique_indices = at::empty({1, num_unique}, indices.options());
+  auto values = at::zeros({num_unique, ddim}, grad.options());
+  auto unique_indices_data = unique_indices.data_ptr<int64_t>();
+  auto values_data = values.data_ptr<scalar_t>();
+  auto grad_data = grad.data_ptr<scalar_t>();
+  auto offset2bag_data = offset2bag.data_ptr<int64_t>();
+  auto bag_size_data = bag_size.data_ptr<int64_t>();
+  auto per_sample_weights_data = per_sample_weights.defined()
+      ? per_sample_weights.data_ptr<scalar_t>() : nullptr;
+  auto per_sample_weights_stride = per_sample_weights.defined()
+      ? per_sample_weights.stride(0) : 0;
+  bool single_bag = offsets.size(0) == 1;
+
+  at::parallel_for(0, num_unique,
+                   embedding_bag_grain_size(num_unique, numel, ddim),
+                   [&](int64_t begin, int64_t end) {
+    for (int64_t u = begin; u < end; u++) {
+      unique_indices_data[u] = sorted_indices_data[segment_starts[u]];
+      auto* values_row = values_data + ddim * u;
+      for (int64_t j = segment_starts[u]; j < segment_starts[u + 1]; j++) {
+        int64_t sample = sort_perm_data[j];
+        int64_t bag = offset2bag_data[sample];
+#ifdef __GNUC__
+        if (j + kEmbeddingBagPrefetchDistance < numel) {
+          __builtin_prefetch(
+              grad_data + ddim * offset2bag_data[sort_perm_data[j + kEmbeddingBagPrefetchDistance]], 0, 1);
+        }
+#endif // __GNUC__
+        scalar_t scale = 1;
+        if (per_sample_weights_data) {
+          AT_ASSERT(mode == MODE_SUM);
+          scale = per_sample_weights_data[per_sample_weights_stride * sample];
+        }
+        if (mode == MODE_MEAN) {
+          scale /= single_bag ? numel : bag_size_data[bag];
+        }
+        THBlas_axpy<scalar_t>(ddim, scale, grad_data + ddim * bag, 1,
+                              values_row, 1);
+      }
+    }
+  });
+
+  return at::_sparse_coo_tensor_unsafe(
+      unique_indices, values, {num_weights, ddim})._coalesced_(true);
+}
+
+Tensor _embedding_bag_sparse_backward_cpu(
+    const Tensor &grad_, const Tensor &indices, const Tensor &offsets,
+    const Tensor &offset2bag, const Tensor &bag_size_, int64_t num_weights,
+    bool scale_grad_by_freq, int64_t mode, const Tensor& per_sample_weights) {
+  // indices, offsets and offset2bag are assumed having correct dtypes and
+  // contiguous here due to the checks in _embedding_bag_backward above.
+  // Also see NOTE [ embedding_bag Native Functions ] in native_functions.yaml
+  // for more details.
+  if (mode == MODE_MAX) {
+    return at::native::_embedding_bag_sparse_backward(
+        grad_, indices, offsets, offset2bag, bag_size_, num_weights,
+        scale_grad_by_freq, mode, per_sample_weights);
+  }
+  TORCH_CHECK(!scale_grad_by_freq,
+      "embedding_backward: scale_grad_by_freq not supported with sparse gradients");
+
+  auto grad = grad_.contiguous();
+  auto grad_arg = TensorArg(grad, "grad_", 1);
+  checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
+
+  return AT_DISPATCH_FLOATING_TYPES(
+    grad.scalar_type(), "embedding_bag_sparse_backward", [&]() {
+      return _embedding_bag_sparse_backward_cpu_sum_mean<scalar_t>(
+          grad, indices, offsets, offset2bag, bag_size_, num_weights, mode,
+          per_sample_weights);
+    }
+  );
+}
 }
 } // namespace at::native
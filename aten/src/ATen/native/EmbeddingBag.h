@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <algorithm>
+
+namespace at {
+namespace native {
+
+// Number of rows ahead of the current one the embedding_bag CPU kernels
+// prefetch, the same distance as the caffe2 perfkernels
+// (caffe2/perfkernels/hp_emblookup_codegen.py) use.
+constexpr int64_t kEmbeddingBagPrefetchDistance = 16;
+
+// Returns the number of bags each thread should at least process so a chunk
+// of bags touches about GRAIN_SIZE elements of the embedding table.
+inline int64_t embedding_bag_grain_size(
+    int64_t num_bags,
+    int64_t num_indices,
+    int64_t embedding_dim) {
+  const int64_t bag_numel =
+      std::max<int64_t>(1, num_indices / std::max<int64_t>(1, num_bags)) *
+      std::max<int64_t>(1, embedding_dim);
+  return std::max<int64_t>(1, at::internal::GRAIN_SIZE / bag_numel);
+}
+
+// Computes the 'max' mode of embedding_bag for the bags given by `offsets`,
+// writing the maximum of every dimension in `output` and the index of the
+// row it came from in `max_indices`. Both are expected to be contiguous and
+// zero-filled, which is what empty bags are left as.
+using embedding_bag_max_fn = void (*)(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    Tensor& output,
+    Tensor& max_indices);
+
+DECLARE_DISPATCH(embedding_bag_max_fn, embedding_bag_max_stub);
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,111 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/native/ForeachUtils.h>
+
+#include <cmath>
+
+namespace at {
+namespace native {
+
+// The implementations of the _foreach_* and _fused_* ops running one op per
+// tensor, for CPU tensors and for the tensor lists the CUDA kernels can't
+// process in one launch.
+
+void foreach_tensor_add_scalar_kernel_slow_(TensorList tensors, Scalar scalar) {
+  check_foreach_api_restrictions("_foreach_add_", {tensors});
+  for (const Tensor& t : tensors) {
+    t.add_(scalar);
+  }
+}
+
+void foreach_tensor_add_list_kernel_slow_(TensorList tensors, TensorList other, Scalar alpha) {
+  check_foreach_api_restrictions("_foreach_add_", {tensors, other});
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].add_(other[i], alpha);
+  }
+}
+
+void foreach_tensor_mul_scalar_kernel_slow_(TensorList tensors, Scalar scalar) {
+  check_foreach_api_restrictions("_foreach_mul_", {tensors});
+  for (const Tensor& t : tensors) {
+    t.mul_(scalar);
+  }
+}
+
+void foreach_tensor_addcmul_kernel_slow_(TensorList tensors, TensorList tensors1, TensorList tensors2, Scalar value) {
+  check_foreach_api_restrictions("_foreach_addcmul_", {tensors, tensors1, tensors2});
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].addcmul_(tensors1[i], tensors2[i], value);
+  }
+}
+
+void foreach_tensor_addcdiv_kernel_slow_(TensorList tensors, TensorList tensors1, TensorList tensors2, Scalar value) {
+  check_foreach_api_restrictions("_foreach_addcdiv_", {tensors, tensors1, tensors2});
+  for (size_t i = 0; i < tensors.size(); i++) {
+    tensors[i].addcdiv_(tensors1[i], tensors2[i], value);
+  }
+}
+
+std::vector<Tensor> foreach_tensor_sqrt_kernel_slow(TensorList tensors) {
+  check_foreach_api_restrictions("_foreach_sqrt", {tensors});
+  std::vector<Tensor> result;
+  result.reserve(tensors.size());
+  for (const Tensor& t : tensors) {
+    result.push_back(t.sqrt());
+  }
+  return result;
+}
+
+void fused_adam_kernel_slow_(
+    TensorList params,
+    TensorList grads,
+    TensorList exp_avgs,
+    TensorList exp_avg_sqs,
+    double lr,
+    double beta1,
+    double beta2,
+    double eps,
+    double weight_decay,
+    int64_t step) {
+  check_foreach_api_restrictions("_fused_adam_", {params, grads, exp_avgs, exp_avg_sqs});
+  TORCH_CHECK(step > 0, "_fused_adam_: expected a positive step, but got ", step);
+  const double bias_correction1 = 1 - std::pow(beta1, step);
+  const double bias_correction2 = 1 - std::pow(beta2, step);
+  for (size_t i = 0; i < params.size(); i++) {
+    const Tensor& p = params[i];
+    Tensor grad = weight_decay > 0 ? grads[i] + weight_decay * p : grads[i];
+    exp_avgs[i].mul_(beta1).add_(grad, 1 - beta1);
+    exp_avg_sqs[i].mul_(beta2).addcmul_(grad, grad, 1 - beta2);
+    Tensor denom = exp_avg_sqs[i] / bias_correction2;
+    p.addcdiv_(exp_avgs[i], denom.sqrt() + eps, -lr / bias_correction1);
+  }
+}
+
+void fused_sgd_kernel_slow_(
+    TensorList params,
+    TensorList grads,
+    TensorList momentum_buffers,
+    double lr,
+    double momentum,
+    double dampening,
+    double weight_decay,
+    bool nesterov) {
+  if (momentum != 0) {
+    check_foreach_api_restrictions("_fused_sgd_", {params, grads, momentum_buffers});
+  } else {
+    check_foreach_api_restrictions("_fused_sgd_", {params, grads});
+  }
+  for (size_t i = 0; i < params.size(); i++) {
+    const Tensor& p = params[i];
+    Tensor update = weight_decay > 0 ? grads[i] + weight_decay * p : grads[i];
+    if (momentum != 0) {
+      const Tensor& buffer = momentum_buffers[i];
+      buffer.mul_(momentum).add_(update, dampening);
+      update = nesterov ? update + momentum * buffer : buffer;
+    }
+    p.add_(update, -lr);
+  }
+}
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <ATen/ATen.h>
+
+#include <vector>
+
+namespace at {
+namespace native {
+
+// The _foreach_* and _fused_* ops apply a pointwise op to the tensors at the
+// same position of several tensor lists, which must have the same length.
+static inline void check_foreach_api_restrictions(const char* name, std::vector<TensorList> lists) {
+  for (size_t i = 1; i < lists.size(); i++) {
+    TORCH_CHECK(lists[i].size() == lists[0].size(), name,
+                ": expected tensor lists of the same length, but got lists of ",
+                lists[0].size(), " and ", lists[i].size(), " tensors");
+  }
+  for (size_t t = 0; t < lists[0].size(); t++) {
+    for (size_t i = 1; i < lists.size(); i++) {
+      TORCH_CHECK(lists[i][t].sizes() == lists[0][t].sizes(), name,
+                  ": expected the tensors at position ", t, " to have the same size, but got ",
+                  lists[0][t].sizes(), " and ", lists[i][t].sizes());
+    }
+  }
+}
+
+// Whether several tensors can be processed by one kernel launch: all of them
+// dense and contiguous, on the same device and of the same floating type.
+static inline bool can_use_fast_route(std::vector<TensorList> lists) {
+  if (lists[0].empty()) {
+    return false;
+  }
+  const Tensor& first = lists[0][0];
+  if (!first.is_cuda() || !at::isFloatingType(first.scalar_type())) {
+    return false;
+  }
+  for (TensorList list : lists) {
+    for (const Tensor& t : list) {
+      if (t.layout() != kStrided || t.device() != first.device() ||
+          t.scalar_type() != first.scalar_type() || !t.is_contiguous()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace native
+} // namespace at
@@ -53,11 +53,17 @@
 
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/Dispatch.h>
 #include <ATen/ExpandUtils.h>
+#include <ATen/NamedTensorUtils.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/BinaryOps.h>
+#include <ATen/native/Fill.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/core/EnableNamedTensor.h>
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <numeric>
 #include <vector>
@@ -326,6 +332,235 @@ Tensor index_fill(const Tensor & self, int64_t dim, const Tensor & index, const
   return self.clone().index_fill_(dim, index, source);
 }
 
+// The offset in elements of the element at `linear_index` in a tensor
+// traversed in row-major order.
+static inline int64_t linear_index_offset(int64_t linear_index, IntArrayRef sizes, IntArrayRef strides) {
+  int64_t offset = 0;
+  for (int64_t dim = sizes.size() - 1; dim >= 0; dim--) {
+    offset += (linear_index % sizes[dim]) * strides[dim];
+    linear_index /= sizes[dim];
+  }
+  return offset;
+}
+
+Tensor & index_add_cpu_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
+  dim = maybe_wrap_dim(dim, self.dim());
+
+  auto numel = index.numel();
+  if (index.dim() >= 2) {
+    AT_INDEX_ERROR("index_add_(): Index is supposed to be a vector (got ", index.dim(), " dimensions)");
+  }
+  if (index.scalar_type() != ScalarType::Long) {
+    AT_INDEX_ERROR("index_add_(): Expected LongTensor for index");
+  }
+  TORCH_CHECK(self.scalar_type() == source.scalar_type(),
+              "index_add_(): self and source must have the same scalar type");
+  TORCH_CHECK(source.dim() == 0 || dim < source.dim(),
+              "index_add_(): Indexing dim ", dim, " is out of bounds of source");
+  if (numel != (source.dim() == 0 ? 1 : source.size(dim))) {
+    AT_INDEX_ERROR("index_add_(): Number of indices (", numel, ") should be equal to source.size(dim)");
+  }
+
+  auto index_contig = index.contiguous();
+  auto index_data = index_contig.data_ptr<int64_t>();
+  auto self_dim_size = self.dim() == 0 ? 1 : self.size(dim);
+
+  if (self.dim() > 1) {
+    if (numel == 0) {
+      return self;
+    }
+    // All slices of self and of source have the same shape and strides, so
+    // one iterator is built for the first slices and pointed at the others.
+    // Every slice is then added with the vectorized add kernel.
+    auto self_slice = self.select(dim, 0);
+    auto source_slice = source.select(dim, 0);
+    auto self_stride_bytes = self.stride(dim) * self.element_size();
+    auto source_stride_bytes = source.stride(dim) * source.element_size();
+    auto iter = TensorIterator::binary_op(self_slice, self_slice, source_slice);
+    for (int64_t i = 0; i < numel; i++) {
+      auto self_i = index_data[i];
+      if (self_i < 0 || self_i >= self_dim_size) {
+        AT_INDEX_ERROR("index_add_(): index ", self_i, " is out of bounds for dimension ", dim,
+                       " with size ", self_dim_size);
+      }
+      auto self_data = static_cast<char*>(self_slice.data_ptr()) + self_i * self_stride_bytes;
+      auto source_data = static_cast<char*>(source_slice.data_ptr()) + i * source_stride_bytes;
+      iter.unsafe_replace_operand(0, self_data);
+      iter.unsafe_replace_operand(1, self_data);
+      iter.unsafe_replace_operand(2, source_data);
+      add_stub(iter.device_type(), iter, 1);
+    }
+  } else {
+    TORCH_CHECK(source.dim() <= 1, "index_add_(): source.dim() (", source.dim(),
+                ") must be one or zero for self.dim() (", self.dim(), ")");
+    AT_DISPATCH_ALL_TYPES(self.scalar_type(), "index_add_cpu_", [&] {
+      auto self_stride = self.dim() == 0 ? 1 : self.stride(dim);
+      auto source_stride = source.dim() == 0 ? 1 : source.stride(dim);
+      auto self_ptr = self.data_ptr<scalar_t>();
+      auto source_ptr = source.data_ptr<scalar_t>();
+      for (int64_t i = 0; i < numel; i++) {
+        auto self_i = index_data[i];
+        if (self_i < 0 || self_i >= self_dim_size) {
+          AT_INDEX_ERROR("index_add_(): index ", self_i, " is out of bounds for dimension ", dim,
+                         " with size ", self_dim_size);
+        }
+        self_ptr[self_i * self_stride] += source_ptr[i * source_stride];
+      }
+    });
+  }
+  return self;
+}
+
+Tensor & index_fill_cpu_(Tensor & self, int64_t dim, const Tensor & index, Scalar source) {
+#ifdef BUILD_NAMEDTENSOR
+  NoNamesGuard guard;
+#endif
+  dim = maybe_wrap_dim(dim, self.dim());
+
+  if (index.dim() >= 2) {
+    AT_INDEX_ERROR("index_fill_(): Index is supposed to be a vector (got ", index.dim(), " dimensions)");
+  }
+  if (index.scalar_type() != ScalarType::Long) {
+    AT_INDEX_ERROR("index_fill_(): Expected LongTensor for index");
+  }
+
+  auto numel = index.numel();
+  auto index_contig = index.contiguous();
+  auto index_data = index_contig.data_ptr<int64_t>();
+  auto self_dim_size = self.dim() == 0 ? 1 : self.size(dim);
+
+  if (self.dim() > 1) {
+    if (numel == 0) {
+      return self;
+    }
+    // Like index_add_, one iterator over the first slice fills all slices.
+    auto self_slice = self.select(dim, 0);
+    auto self_stride_bytes = self.stride(dim) * self.element_size();
+    auto iter = TensorIterator::nullary_op(self_slice);
+    for (int64_t i = 0; i < numel; i++) {
+      auto self_i = index_data[i];
+      if (self_i < 0 || self_i >= self_dim_size) {
+        AT_INDEX_ERROR("index_fill_(): index ", self_i, " is out of bounds for dimension ", dim,
+                       " with size ", self_dim_size);
+      }
+      iter.unsafe_replace_operand(
+          0, static_cast<char*>(self_slice.data_ptr()) + self_i * self_stride_bytes);
+      fill_stub(iter.device_type(), iter, source);
+    }
+  } else {
+    AT_DISPATCH_ALL_TYPES_AND(ScalarType::Bool, self.scalar_type(), "index_fill_cpu_", [&] {
+      auto value = source.to<scalar_t>();
+      auto self_stride = self.dim() == 0 ? 1 : self.stride(dim);
+      auto self_ptr = self.data_ptr<scalar_t>();
+      for (int64_t i = 0; i < numel; i++) {
+        auto self_i = index_data[i];
+        if (self_i < 0 || self_i >= self_dim_size) {
+          AT_INDEX_ERROR("index_fill_(): index ", self_i, " is out of bounds for dimension ", dim,
+                         " with size ", self_dim_size);
+        }
+        self_ptr[self_i * self_stride] = value;
+      }
+    });
+  }
+  return self;
+}
+
+Tensor & index_fill_cpu_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
+  TORCH_CHECK(source.dim() == 0, "index_fill_ only supports a 0-dimensional value tensor, but got tensor "
+              "with ", source.dim(), " dimension(s).");
+  return index_fill_cpu_(self, dim, index, source.item());
+}
+
+Tensor & take_out_cpu(Tensor & result, const Tensor & self, const Tensor & index) {
+  if (index.scalar_type() != ScalarType::Long) {
+    AT_INDEX_ERROR("take(): Expected LongTensor for index");
+  }
+  TORCH_CHECK(result.scalar_type() == self.scalar_type(),
+              "take(): self and result must have the same scalar type");
+  result.resize_(index.sizes());
+
+  auto index_contig = index.contiguous();
+  Tensor dst = result.is_contiguous() ? result : at::empty(index.sizes(), result.options());
+  AT_DISPATCH_ALL_TYPES_AND(ScalarType::Bool, self.scalar_type(), "take_cpu", [&] {
+    auto index_data = index_contig.data_ptr<int64_t>();
+    auto src_data = self.data_ptr<scalar_t>();
+    auto dst_data = dst.data_ptr<scalar_t>();
+    auto src_numel = self.numel();
+    bool is_contiguous = self.is_contiguous();
+
+    // Exceptions must not be thrown across parallel sections, so we record
+    // the position of an invalid index and throw after the loop.
+    std::atomic<int64_t> invalid_pos(-1);
+    at::parallel_for(0, index.numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        auto idx = index_data[i];
+        if (idx < -src_numel || idx >= src_numel) {
+          int64_t expected = -1;
+          invalid_pos.compare_exchange_strong(expected, i);
+          continue;
+        }
+        if (idx < 0) {
+          idx += src_numel;
+        }
+        dst_data[i] = is_contiguous
+            ? src_data[idx]
+            : src_data[linear_index_offset(idx, self.sizes(), self.strides())];
+      }
+    });
+    if (invalid_pos >= 0) {
+      AT_INDEX_ERROR("take(): index ", index_data[invalid_pos], " is out of range for tensor with ",
+                     src_numel, " elements");
+    }
+  });
+  if (!dst.is_same(result)) {
+    result.copy_(dst);
+  }
+  return result;
+}
+
+Tensor take_cpu(const Tensor & self, const Tensor & index) {
+  auto result = at::empty({0}, self.options());
+  return take_out_cpu(result, self, index);
+}
+
+Tensor & put_cpu_(Tensor & self, const Tensor & index, const Tensor & source, bool accumulate) {
+  if (index.scalar_type() != ScalarType::Long) {
+    AT_INDEX_ERROR("put_(): Expected LongTensor for index");
+  }
+  TORCH_CHECK(self.scalar_type() == source.scalar_type(),
+              "put_(): self and source must have the same scalar type");
+  TORCH_CHECK(index.numel() == source.numel(), "put_(): source should have the same number of "
+              "elements as index (got ", source.numel(), " and ", index.numel(), ")");
+
+  auto index_contig = index.contiguous();
+  auto source_contig = source.contiguous();
+  // Duplicate indices make the writes depend on their order, so this loop is
+  // not parallelized.
+  AT_DISPATCH_ALL_TYPES_AND(ScalarType::Bool, self.scalar_type(), "put_cpu_", [&] {
+    auto index_data = index_contig.data_ptr<int64_t>();
+    auto source_data = source_contig.data_ptr<scalar_t>();
+    auto self_data = self.data_ptr<scalar_t>();
+    auto self_numel = self.numel();
+    bool is_contiguous = self.is_contiguous();
+    for (int64_t i = 0; i < index_contig.numel(); i++) {
+      auto idx = index_data[i];
+      if (idx < -self_numel || idx >= self_numel) {
+        AT_INDEX_ERROR("put_(): index ", idx, " is out of range for tensor with ", self_numel, " elements");
+      }
+      if (idx < 0) {
+        idx += self_numel;
+      }
+      auto offset = is_contiguous ? idx : linear_index_offset(idx, self.sizes(), self.strides());
+      if (accumulate) {
+        self_data[offset] += source_data[i];
+      } else {
+        self_data[offset] = source_data[i];
+      }
+    }
+  });
+  return self;
+}
+
 Tensor scatter(const Tensor & self, int64_t dim, const Tensor & index, const Tensor & source) {
   return self.clone().scatter_(dim, index, source);
 }
@@ -380,6 +615,84 @@ Tensor masked_fill(const Tensor & self, const Tensor & mask, const Tensor & sour
   return result;
 }
 
+static Tensor & masked_select_out_impl_cpu(Tensor & result, const Tensor & self, const Tensor & mask) {
+#ifdef BUILD_NAMEDTENSOR
+  NoNamesGuard guard;
+#endif
+  TORCH_CHECK(mask.scalar_type() == ScalarType::Byte || mask.scalar_type() == ScalarType::Bool,
+              "masked_select: expected BoolTensor or ByteTensor for mask");
+  TORCH_CHECK(self.scalar_type() == result.scalar_type(),
+              "masked_select(): self and result must have the same scalar type");
+
+  Tensor _mask, _self;
+  std::tie(_mask, _self) = expand_outplace(mask, self);
+  auto shape = _self.sizes();
+  if (mask.scalar_type() == ScalarType::Byte && _mask.numel() > 0) {
+    TORCH_CHECK(_mask.max().item<uint8_t>() <= 1, "Mask tensor can take 0 and 1 values only");
+  }
+
+  // The position of every selected element in the result is the running count
+  // of the mask in row-major order, which lets the elements be copied in
+  // parallel and in any order.
+  auto mask_prefix_sum = at::empty({_mask.numel()}, self.options().dtype(kLong));
+  at::cumsum_out(mask_prefix_sum, _mask.reshape(-1), 0, kLong);
+  int64_t numel = _mask.numel() == 0 ? 0 : mask_prefix_sum[-1].item<int64_t>();
+  result.resize_({numel});
+  if (numel == 0) {
+    return result;
+  }
+
+  // The result is restrided to the shape of self with stride 0, and written
+  // at the offsets given by the prefix sum.
+  auto result_strided = result.as_strided(shape, DimVector(shape.size(), 0));
+  auto iter = TensorIterator();
+  iter.dont_compute_common_dtype();
+  iter.dont_resize_outputs();
+  iter.add_output(result_strided);
+  iter.add_input(_self);
+  iter.add_input(_mask);
+  iter.add_input(mask_prefix_sum.view(shape));
+  iter.build();
+
+  AT_DISPATCH_ALL_TYPES_AND2(ScalarType::Bool, ScalarType::BFloat16, self.scalar_type(), "masked_select_cpu", [&] {
+    auto result_stride_bytes = result.stride(0) * sizeof(scalar_t);
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      char* dst = data[0];
+      char* src = data[1];
+      char* mask_data = data[2];
+      char* prefix_sum = data[3];
+      for (int64_t i = 0; i < n; i++) {
+        // Bool and Byte masks are both one byte that is 0 or 1.
+        if (*reinterpret_cast<uint8_t*>(mask_data + strides[2] * i)) {
+          auto offset = *reinterpret_cast<int64_t*>(prefix_sum + strides[3] * i) - 1;
+          *reinterpret_cast<scalar_t*>(dst + offset * result_stride_bytes) =
+              *reinterpret_cast<scalar_t*>(src + strides[1] * i);
+        }
+      }
+    });
+  });
+  return result;
+}
+
+Tensor masked_select_cpu(const Tensor & self, const Tensor & mask) {
+#ifdef BUILD_NAMEDTENSOR
+  namedinference::compute_broadcast_outnames(self, mask);
+#endif
+  if (mask.dtype() == at::ScalarType::Byte) {
+    AT_WARN("masked_select received a mask with dtype torch.uint8, this behavior is now deprecated," \
+            "please use a mask with dtype torch.bool instead.");
+  }
+  Tensor result = at::empty({0}, self.options());
+  return masked_select_out_impl_cpu(result, self, mask);
+}
+
+Tensor & masked_select_out_cpu(Tensor & result, const Tensor & self, const Tensor & mask) {
+#ifdef BUILD_NAMEDTENSOR
+  namedinference::compute_broadcast_outnames(self, mask);
+#endif
+  return masked_select_out_impl_cpu(result, self, mask);
+}
+
 Tensor _gather_sparse_backward(const Tensor& self, int64_t dim, const Tensor& index, const Tensor& grad){
 // special case scalar input and/or index
     if (self.ndimension() == 0) return at::_sparse_coo_tensor_unsafe(at::empty({0,grad.numel()}, index.options()), grad, self.sizes());
@@ -58,40 +58,8 @@ Tensor & masked_scatter__cpu(Tensor& self, const Tensor & mask, const Tensor & s
   }
 }
 
-Tensor masked_select_cpu(const Tensor & self, const Tensor & mask) {
-#ifdef BUILD_NAMEDTENSOR
-  namedinference::compute_broadcast_outnames(self, mask);
-#endif
-  if (mask.dtype() == at::ScalarType::Byte) {
-    AT_WARN("masked_select received a mask with dtype torch.uint8, this behavior is now deprecated," \
-            "please use a mask with dtype torch.bool instead.");
-    return legacy::cpu::_th_masked_select(self, mask);
-  } else {
-    return legacy::cpu::_th_masked_select_bool(self, mask);
-  }
-}
-
-Tensor & masked_select_out_cpu(Tensor & result, const Tensor & self, const Tensor & mask) {
-#ifdef BUILD_NAMEDTENSOR
-  namedinference::compute_broadcast_outnames(self, mask);
-#endif
-  if (mask.dtype() == at::ScalarType::Bool) {
-    return legacy::cpu::_th_masked_select_bool_out(result, self, mask);
-  } else {
-    return legacy::cpu::_th_masked_select_out(result, self, mask);
-  }
-}
-
 Tensor argsort(const Tensor & self, int64_t dim, bool descending) {
   return std::get<1>(at::sort(self, dim, descending));
 }
 
-Tensor & gather_out_cpu(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
-  return legacy::cpu::_th_gather_out(result, self, dim, index);
-}
-
-Tensor gather_cpu(const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
-  return legacy::cpu::_th_gather(self, dim, index);
-}
-
 }} // namespace at::native
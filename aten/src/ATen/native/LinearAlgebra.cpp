@@ -2,11 +2,13 @@
 #include <ATen/ExpandUtils.h>
 #include <ATen/Dispatch.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/native/BatchGemm.h>
 #include <ATen/native/LinearAlgebraUtils.h>
 #include <ATen/TensorUtils.h>
 #include <ATen/Parallel.h>
 #include <ATen/LegacyTHFunctionsCPU.h>
 #include <ATen/core/grad_mode.h>
+#include <algorithm>
 #include <functional>
 #include <numeric>
 #include <vector>
@@ -171,7 +173,7 @@ inline void baddbmm_cpu_kernel(const Tensor& result, const Tensor& self, const T
   auto s0 = self.accessor<scalar_t, 3>();
   auto m0 = mat2.accessor<scalar_t, 3>();
 
-  int64_t grain_size = std::min(internal::GRAIN_SIZE / (is * js * ks), (int64_t)1);
+  int64_t grain_size = std::max(internal::GRAIN_SIZE / (is * js * ks), (int64_t)1);
   parallel_for(0, bs, grain_size, [&](int64_t b_begin, int64_t b_end) {
       for (int64_t b = b_begin; b < b_end; b++) {
         auto r1 = r0[b];
@@ -200,8 +202,12 @@ inline void baddbmm_cpu_kernel(const Tensor& result, const Tensor& self, const T
 }
 
 // This tries to apply some optimizations to bmm/baddbmm:
-// - When the operand size is small, computation are parallelized over the batch
-//   dimension using OMP and naive matrix multiplication is applied.
+// - When the matrices are small floating point ones with unit column strides
+//   in the result and batch2, the register blocked baddbmm_small_stub kernel
+//   is used, parallelized over the batch dimension. Unlike a GEMM call per
+//   matrix, it has next to no per matrix overhead.
+// - Other small operands are also parallelized over the batch dimension, with
+//   a naive matrix multiplication.
 // - When the operand size is larger than the threshold, if compiled with MKL, MKL's batch gemm is used.
 // - Otherwise, we use a series of matrix multiplications.
 // The threshold of 400 for the first has not been thoroughly benchmarked yet and may have room for further
@@ -241,6 +247,15 @@ static inline Tensor& bmm_out_or_baddbmm_(Tensor& self_or_result, const Tensor&
     return self_or_result.zero_();
   }
 
+  const bool result_and_batch2_unit_column_stride =
+      (self_or_result.stride(2) == 1 && batch2.stride(2) == 1) || res_cols == 1;
+  if ((self_or_result.scalar_type() == kFloat || self_or_result.scalar_type() == kDouble)
+      && std::max({contraction_size, res_rows, res_cols}) <= kBaddbmmSmallMaxSize
+      && result_and_batch2_unit_column_stride) {
+    baddbmm_small_stub(kCPU, self_or_result, batch1, batch2, beta, alpha);
+    return self_or_result;
+  }
+
   auto batch_items_contiguous_or_transposed = [&](const Tensor& t) {
     return (t.stride(2) == 1 && t.stride(1) >= t.size(2))
             || (t.stride(1) == 1 && t.stride(2) >= t.size(1));
@@ -277,6 +292,8 @@ static inline Tensor& bmm_out_or_baddbmm_(Tensor& self_or_result, const Tensor&
 }
 
 
+DEFINE_DISPATCH(baddbmm_small_stub);
+
 Tensor baddbmm_cpu(const Tensor& self, const Tensor& batch1, const Tensor& batch2, Scalar beta, Scalar alpha) {
   Tensor result = at::empty({0}, self.options());
   return at::native::baddbmm_out_cpu(result, self, batch1, batch2, beta, alpha);
@@ -6,10 +6,10 @@
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/Dispatch.h>
-#include <ATen/CPUApplyUtils.h>
 #include <ATen/native/BinaryOps.h>
 #include <ATen/native/PointwiseOps.h>
 #include <ATen/native/TensorIterator.h>
+#include <ATen/native/cpu/Loops.h>
 
 #define EPSILON 1e-12
 #define _USE_MATH_DEFINES
@@ -82,18 +82,16 @@ Tensor kl_div(const Tensor& input, const Tensor& target, int64_t reduction) {
 }
 
 Tensor kl_div_backward_cpu(const Tensor& grad, const Tensor& input, const Tensor& target, int64_t reduction) {
-  auto grad_input = at::zeros_like(input);
-  auto grad_expand = grad.expand_as(input);
+  auto grad_input = at::empty_like(input);
+  auto iter = TensorIterator();
+  iter.add_output(grad_input);
+  iter.add_input(target);
+  iter.add_input(grad.expand_as(input));
+  iter.build();
   AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "kl_div_backward_cpu", [&]() {
-    at::CPU_tensor_apply3<scalar_t, scalar_t, scalar_t>(
-        grad_input,
-        target,
-        grad_expand,
-        [] (scalar_t& grad_input_val, const scalar_t& target_val, const scalar_t& grad_val) {
-          if (target_val > 0) {
-            grad_input_val = -target_val * grad_val;
-          }
-        });
+    cpu_kernel(iter, [](scalar_t target_val, scalar_t grad_val) -> scalar_t {
+      return target_val > 0 ? -target_val * grad_val : scalar_t(0);
+    });
   });
   if (reduction == at::Reduction::Mean) {
     return grad_input / input.numel();
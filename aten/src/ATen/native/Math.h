@@ -4,6 +4,7 @@
 #include <cmath>
 #include <limits>
 #include <type_traits>
+#include <c10/util/BFloat16.h>
 
 #ifndef M_PIf
 #define M_PIf 3.1415926535f
@@ -100,6 +101,10 @@ Date:  February 1996
 
 #undef CENTRAL_RANGE
 
+static inline c10::BFloat16 calc_erfinv(c10::BFloat16 a) {
+  return calc_erfinv(float(a));
+}
+
 static inline double polevl(double x, double *A, size_t len) {
   double result = 0;
   for (size_t i = 0; i <= len; i++) {
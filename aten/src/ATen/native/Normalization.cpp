@@ -7,6 +7,7 @@
 
 #include <ATen/detail/CUDAHooksInterface.h>
 #include <ATen/native/TensorIterator.h>
+#include <ATen/native/batch_norm.h>
 #include <ATen/native/cpu/Loops.h>
 
 #include <vector>
@@ -127,6 +128,43 @@ void batch_norm_cpu_inference_contiguous(Tensor& output, const Tensor& input,
   }
 }
 
+/// The same as batch_norm_cpu_inference_contiguous for a channels last 4-d
+/// input, where the channels are the innermost dimension.
+template<typename scalar_t>
+void batch_norm_cpu_inference_channels_last(Tensor& output, const Tensor& input,
+    const Tensor& weight /* optional */, const Tensor& bias /* optional */,
+    const Tensor& mean, const Tensor& variance, double eps) {
+  int64_t n_channel = input.size(1);
+  int64_t n_pixel = input.numel() / n_channel;
+
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const scalar_t* weight_data = weight.defined() ? weight.data_ptr<scalar_t>() : nullptr;
+  const scalar_t* bias_data = bias.defined() ? bias.data_ptr<scalar_t>() : nullptr;
+  const scalar_t* mean_data = mean.data_ptr<scalar_t>();
+  const scalar_t* var_data = variance.data_ptr<scalar_t>();
+
+  std::vector<scalar_t> alpha(n_channel);
+  std::vector<scalar_t> beta(n_channel);
+  for (int64_t c = 0; c < n_channel; c++) {
+    scalar_t inv_var = 1 / std::sqrt(var_data[c] + static_cast<scalar_t>(eps));
+    scalar_t weight_v = weight_data ? weight_data[c] : 1;
+    scalar_t bias_v = bias_data ? bias_data[c] : 0;
+    alpha[c] = inv_var * weight_v;
+    beta[c] = bias_v - mean_data[c] * inv_var * weight_v;
+  }
+
+  // output(n, h, w, c) = input(n, h, w, c) * alpha(c) + beta(c), with the
+  // inner loop running over the channels of one pixel.
+  for (int64_t p = 0; p < n_pixel; ++p) {
+    const scalar_t* in = input_data + p * n_channel;
+    scalar_t* out = output_data + p * n_channel;
+    for (int64_t c = 0; c < n_channel; ++c) {
+      out[c] = in[c] * alpha[c] + beta[c];
+    }
+  }
+}
+
 template<typename scalar_t>
 std::tuple<Tensor,Tensor,Tensor> batch_norm_cpu_transform_input_template(
     const Tensor& input, const Tensor& weight, const Tensor& bias,
@@ -134,17 +172,26 @@ std::tuple<Tensor,Tensor,Tensor> batch_norm_cpu_transform_input_template(
     const Tensor& running_mean /* optional */, const Tensor& running_var /* optional */,
     bool train, double eps) {
 
-  Tensor output = at::empty_like(input);
+  // Channels last inputs give channels last outputs, so networks can stay
+  // channels last from one layer to the next.
+  Tensor output = at::empty_like(input, input.options(), input.suggest_memory_format());
 
   // Check if we should use the fast path.
-  if (!train && input.is_contiguous()
+  if (!train
       && (!weight.defined() || weight.is_contiguous())
       && (!bias.defined() || bias.is_contiguous())
       && running_mean.is_contiguous()
       && running_var.is_contiguous()) {
-    batch_norm_cpu_inference_contiguous<scalar_t>(output, input, weight, bias,
-      running_mean, running_var, eps);
-    return std::make_tuple(output, save_mean, save_invstd);
+    if (input.is_contiguous()) {
+      batch_norm_cpu_inference_contiguous<scalar_t>(output, input, weight, bias,
+        running_mean, running_var, eps);
+      return std::make_tuple(output, save_mean, save_invstd);
+    }
+    if (input.is_contiguous(MemoryFormat::ChannelsLast)) {
+      batch_norm_cpu_inference_channels_last<scalar_t>(output, input, weight, bias,
+        running_mean, running_var, eps);
+      return std::make_tuple(output, save_mean, save_invstd);
+    }
   }
   int64_t n_input = input.size(1);
 
@@ -193,47 +240,29 @@ std::tuple<Tensor,Tensor> batch_norm_cpu_update_stats_template(
 
   Tensor save_mean = at::empty({n_input}, input.options());
   Tensor save_var_transform = at::empty({n_input}, input.options());
+  Tensor var_sum = at::empty({n_input}, input.options());
+  BatchNormCollectStatsKernel(kCPU, input, &save_mean, &var_sum);
   auto save_mean_a = save_mean.accessor<scalar_t, 1>();
   auto save_var_transform_a = save_var_transform.accessor<scalar_t, 1>();
+  auto var_sum_a = var_sum.accessor<scalar_t, 1>();
 
   auto running_mean_a = conditional_accessor_1d<scalar_t>(running_mean);
   auto running_var_a = conditional_accessor_1d<scalar_t>(running_var);
 
-  parallel_for(0, n_input, 1, [&](int64_t b_begin, int64_t b_end) {
-    for (int64_t f = b_begin; f < b_end; ++f) {
-      Tensor in = input.select(1, f);
-      
-      // compute mean per input
-      auto iter = TensorIterator();
-      iter.add_input(in);
-      iter.build();
-      accscalar_t sum = 0;
-      cpu_serial_kernel(iter, [&](const scalar_t i) -> void {
-        sum += i;
-      });
-      scalar_t mean = sum / n;
-      save_mean_a[f] = mean;
-
-      // compute variance per input
-      iter = TensorIterator();
-      iter.add_input(in);
-      iter.build();
-      accscalar_t var_sum = 0;
-      cpu_serial_kernel(iter, [&](const scalar_t i) -> void {
-        var_sum += (i - mean) * (i - mean);
-      });
-      save_var_transform_a[f] = VarTransform<accscalar_t>{}(var_sum / n, eps);
+  for (int64_t f = 0; f < n_input; ++f) {
+    accscalar_t mean = save_mean_a[f];
+    accscalar_t var_sum_f = var_sum_a[f];
+    save_var_transform_a[f] = VarTransform<accscalar_t>{}(var_sum_f / n, eps);
 
-      // update running averages
-      if (running_mean.defined()) {
-        running_mean_a[f] = momentum * mean + (1 - momentum) * running_mean_a[f];
-      }
-      if (running_var.defined()) {
-        accscalar_t unbiased_var = var_sum / (n - 1);
-        running_var_a[f] = momentum * unbiased_var + (1 - momentum) * running_var_a[f];
-      }
+    // update running averages
+    if (running_mean.defined()) {
+      running_mean_a[f] = momentum * mean + (1 - momentum) * running_mean_a[f];
     }
-  });
+    if (running_var.defined()) {
+      accscalar_t unbiased_var = var_sum_f / (n - 1);
+      running_var_a[f] = momentum * unbiased_var + (1 - momentum) * running_var_a[f];
+    }
+  }
   return std::make_tuple(save_mean, save_var_transform);
 }
 
@@ -525,6 +554,8 @@ Tensor group_norm(const Tensor& input, int64_t num_groups,
     }
 }
 
+DEFINE_DISPATCH(BatchNormCollectStatsKernel);
+
 std::tuple<Tensor, Tensor> batch_norm_update_stats_cpu(
         const Tensor& self, const Tensor& running_mean, const Tensor& running_var, double momentum) {
   return AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "batch_norm_update_stats_cpu", [&] {
@@ -0,0 +1,178 @@
+#include <ATen/native/PointwiseChain.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/TensorIterator.h>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(fused_pointwise_stub);
+
+using Kind = PointwiseStep::Kind;
+
+PointwiseChain::PointwiseChain(Tensor input) : value_(std::move(input)) {}
+
+bool PointwiseChain::fusible() const {
+  return value_.device().is_cpu() && value_.layout() == kStrided &&
+      isFloatingType(value_.scalar_type()) &&
+      value_.scalar_type() != kHalf && value_.scalar_type() != kBFloat16 &&
+      !value_.requires_grad();
+}
+
+bool PointwiseChain::fusible(const Tensor& other) const {
+  return other.device() == value_.device() && other.layout() == kStrided &&
+      other.scalar_type() == value_.scalar_type() && !other.requires_grad();
+}
+
+bool PointwiseChain::record(Kind kind, double scalar) {
+  if (!fusible()) {
+    return false;
+  }
+  if (steps_.size() == kMaxSteps) {
+    flush();
+  }
+  steps_.push_back({kind, -1, scalar});
+  return true;
+}
+
+bool PointwiseChain::record(Kind kind, const Tensor& other, double scalar) {
+  if (!fusible() || !fusible(other)) {
+    return false;
+  }
+  if (steps_.size() == kMaxSteps || operands_.size() == kMaxOperands) {
+    flush();
+  }
+  steps_.push_back({kind, static_cast<int>(operands_.size()), scalar});
+  operands_.push_back(other);
+  return true;
+}
+
+void PointwiseChain::flush() {
+  if (steps_.empty()) {
+    return;
+  }
+  Tensor result;
+  auto iter = TensorIterator();
+  iter.add_output(result);
+  iter.add_input(value_);
+  for (const auto& operand : operands_) {
+    iter.add_input(operand);
+  }
+  iter.build();
+  fused_pointwise_stub(iter.device_type(), iter, steps_);
+  value_ = iter.output();
+  operands_.clear();
+  steps_.clear();
+}
+
+Tensor PointwiseChain::materialize() {
+  flush();
+  return value_;
+}
+
+PointwiseChain& PointwiseChain::add(const Tensor& other, Scalar alpha) {
+  if (!record(Kind::Add, other, alpha.to<double>())) {
+    flush();
+    value_ = value_.add(other, alpha);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::add(Scalar other) {
+  if (!record(Kind::Add, other.to<double>())) {
+    flush();
+    value_ = value_.add(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::sub(const Tensor& other, Scalar alpha) {
+  if (!record(Kind::Add, other, -alpha.to<double>())) {
+    flush();
+    value_ = value_.sub(other, alpha);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::sub(Scalar other) {
+  if (!record(Kind::Add, -other.to<double>())) {
+    flush();
+    value_ = value_.sub(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::mul(const Tensor& other) {
+  if (!record(Kind::Mul, other, 1)) {
+    flush();
+    value_ = value_.mul(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::mul(Scalar other) {
+  if (!record(Kind::Mul, other.to<double>())) {
+    flush();
+    value_ = value_.mul(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::div(const Tensor& other) {
+  if (!record(Kind::Div, other, 1)) {
+    flush();
+    value_ = value_.div(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::div(Scalar other) {
+  if (!record(Kind::Div, other.to<double>())) {
+    flush();
+    value_ = value_.div(other);
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::relu() {
+  if (!record(Kind::Relu, 0)) {
+    flush();
+    value_ = value_.relu();
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::neg() {
+  if (!record(Kind::Neg, 0)) {
+    flush();
+    value_ = value_.neg();
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::exp() {
+  if (!record(Kind::Exp, 0)) {
+    flush();
+    value_ = value_.exp();
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::tanh() {
+  if (!record(Kind::Tanh, 0)) {
+    flush();
+    value_ = value_.tanh();
+  }
+  return *this;
+}
+
+PointwiseChain& PointwiseChain::sigmoid() {
+  if (!record(Kind::Sigmoid, 0)) {
+    flush();
+    value_ = value_.sigmoid();
+  }
+  return *this;
+}
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,95 @@
+// Fusion of chained elementwise operations
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+#include <vector>
+
+namespace at {
+
+struct TensorIterator;
+
+namespace native {
+
+// One step of a fused pointwise program. The program keeps a running value
+// that starts out as the first input of the iterator; every step combines it
+// with a scalar, with one of the other inputs, or transforms it in place.
+struct PointwiseStep {
+  enum class Kind : uint8_t {
+    Add, // value + scalar * operand, or value + scalar
+    Mul,
+    Div,
+    Relu,
+    Neg,
+    Exp,
+    Tanh,
+    Sigmoid,
+  };
+
+  Kind kind;
+  // Index of the tensor operand (the iterator input is `operand + 1`), or -1
+  // if the step uses `scalar` instead.
+  int operand;
+  double scalar;
+};
+
+using fused_pointwise_fn =
+    void (*)(TensorIterator&, const std::vector<PointwiseStep>&);
+
+DECLARE_DISPATCH(fused_pointwise_fn, fused_pointwise_stub);
+
+// Records a chain of elementwise operations and runs it as a single loop, so
+// that an expression such as
+//
+//   auto y = PointwiseChain(x).mul(a).add(b).relu().materialize();
+//
+// reads x, a and b and writes y once, instead of allocating and making a
+// pass over memory for every intermediate result. Operations that can't be
+// fused (a tensor of another dtype or device, a tensor requiring grad, or a
+// chain grown past kMaxSteps or kMaxOperands) materialize the steps recorded
+// so far and are then executed eagerly, so the result always matches the
+// unfused expression.
+class CAFFE2_API PointwiseChain {
+ public:
+  static constexpr size_t kMaxSteps = 16;
+  static constexpr size_t kMaxOperands = 4;
+
+  explicit PointwiseChain(Tensor input);
+
+  PointwiseChain& add(const Tensor& other, Scalar alpha = 1);
+  PointwiseChain& add(Scalar other);
+  PointwiseChain& sub(const Tensor& other, Scalar alpha = 1);
+  PointwiseChain& sub(Scalar other);
+  PointwiseChain& mul(const Tensor& other);
+  PointwiseChain& mul(Scalar other);
+  PointwiseChain& div(const Tensor& other);
+  PointwiseChain& div(Scalar other);
+  PointwiseChain& relu();
+  PointwiseChain& neg();
+  PointwiseChain& exp();
+  PointwiseChain& tanh();
+  PointwiseChain& sigmoid();
+
+  // Number of steps recorded but not executed yet.
+  size_t pending() const {
+    return steps_.size();
+  }
+
+  // Executes the pending steps and returns the result.
+  Tensor materialize();
+
+ private:
+  bool fusible() const;
+  bool fusible(const Tensor& other) const;
+  bool record(PointwiseStep::Kind kind, double scalar);
+  bool record(PointwiseStep::Kind kind, const Tensor& other, double scalar);
+  void flush();
+
+  Tensor value_;
+  std::vector<Tensor> operands_;
+  std::vector<PointwiseStep> steps_;
+};
+
+} // namespace native
+} // namespace at
@@ -44,6 +44,18 @@ static inline T pooling_output_shape(
         inputSize, kernelSize, pad, pad, stride, dilation, ceil_mode);
 }
 
+// Gives an output just resized by the pooling kernels the strides of the
+// memory format they write it in, if it has those of the other one. resize_
+// keeps the strides of an output that already has the right size, e.g. one
+// left channels last by a previous call.
+static inline void restride_output(Tensor& output, MemoryFormat memory_format) {
+  const auto other_format = memory_format == MemoryFormat::ChannelsLast
+      ? MemoryFormat::Contiguous
+      : MemoryFormat::ChannelsLast;
+  if (!output.is_contiguous(memory_format) && output.is_contiguous(other_format)) {
+    output.unsafeGetTensorImpl()->empty_tensor_restride(memory_format);
+  }
+}
 
 // AveragePool2d/DilatedMaxPool2d (forward)
 static inline void
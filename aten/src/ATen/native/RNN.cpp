@@ -2,11 +2,14 @@
 
 #include <ATen/ATen.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/core/grad_mode.h>
 #include <ATen/cpp_custom_type_hack.h>
 #include <ATen/native/quantized/cpu/fbgemm_utils.h>
 
 #include <ATen/native/c10_utils.h>
 
+#include <numeric>
+
 namespace at { namespace native {
 
 namespace {
@@ -346,6 +349,168 @@ tpair_of<Tensor> hidden_slice(const tpair_of<Tensor>& t, int64_t start, int64_t
                          hidden_slice(std::get<1>(t), start, end));
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// FUSED CPU CELL HELPERS
+//
+// On CPU, LSTM and GRU layers that don't need to record anything for autograd
+// run all their steps in a single loop: the hidden GEMM of every step writes
+// into a buffer allocated once for the layer (when the weights are float), and
+// a fused, vectorized kernel computes all the gate nonlinearities and the state
+// update from it, writing the new hidden state straight into the output.
+// Packed sequences run the same way, over the shrinking batch of every step,
+// writing their outputs packed, without padding or slicing the hidden state.
+
+bool requires_grad(const Tensor& t) {
+  return t.defined() && t.is_variable() && t.requires_grad();
+}
+
+template <typename cell_params>
+bool hidden_params_require_grad(const cell_params& params) {
+  return requires_grad(params.b_hh);
+}
+
+bool hidden_params_require_grad(const CellParams& params) {
+  return requires_grad(params.w_hh) || requires_grad(params.b_hh);
+}
+
+template <typename cell_params>
+bool use_fused_cell(const Tensor& input_w, TensorList hiddens, const cell_params& params) {
+  if (!input_w.device().is_cpu() ||
+      (input_w.scalar_type() != kFloat && input_w.scalar_type() != kDouble)) {
+    return false;
+  }
+  for (const auto& hidden : hiddens) {
+    if (hidden.scalar_type() != input_w.scalar_type()) {
+      return false;
+    }
+  }
+  if (!at::GradMode::is_enabled()) {
+    return true;
+  }
+  if (requires_grad(input_w) || hidden_params_require_grad(params)) {
+    return false;
+  }
+  for (const auto& hidden : hiddens) {
+    if (requires_grad(hidden)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// With the autograd disabled, as for inference, the layers keep the buffers
+// of their input projections and hidden gates in a workspace of the thread
+// across calls, like caffe2's InferenceLSTM, so that a model run over and
+// over doesn't allocate them again. The buffers never escape a layer, which
+// is done with them before the next one starts.
+struct FusedLayerWorkspace {
+  Tensor input_gates;
+  Tensor hidden_gates;
+};
+
+FusedLayerWorkspace& fused_layer_workspace() {
+  static thread_local FusedLayerWorkspace workspace;
+  return workspace;
+}
+
+bool use_workspace(const Tensor& input) {
+  return !at::GradMode::is_enabled() && input.device().is_cpu() &&
+      (input.scalar_type() == kFloat || input.scalar_type() == kDouble);
+}
+
+// Returns `buffer` with the given sizes and options, reusing its memory if
+// they allow it.
+Tensor& workspace_buffer(Tensor& buffer, IntArrayRef sizes, const TensorOptions& options) {
+  if (!buffer.defined() || buffer.options().dtype() != options.dtype()) {
+    buffer = at::empty(sizes, options);
+  } else {
+    buffer.resize_(sizes);
+  }
+  return buffer;
+}
+
+// Returns the input projections of all the steps of `inputs`, padded or
+// packed, computed with a single GEMM, into the workspace when it is used.
+Tensor input_gates(const CellParams& params, const Tensor& inputs) {
+  if (!use_workspace(inputs) || inputs.dim() < 2 ||
+      params.w_ih.scalar_type() != inputs.scalar_type()) {
+    return params.linear_ih(inputs);
+  }
+  const auto flat_inputs = inputs.contiguous().view({-1, inputs.size(-1)});
+  auto& buffer = workspace_buffer(
+      fused_layer_workspace().input_gates,
+      {flat_inputs.size(0), params.w_ih.size(0)},
+      inputs.options());
+  if (params.b_ih.defined()) {
+    at::addmm_out(buffer, params.b_ih, flat_inputs, params.w_ih.t());
+  } else {
+    at::mm_out(buffer, flat_inputs, params.w_ih.t());
+  }
+  auto sizes = inputs.sizes().vec();
+  sizes.back() = params.w_ih.size(0);
+  return buffer.view(sizes);
+}
+
+template <typename cell_params>
+Tensor input_gates(const cell_params& params, const Tensor& inputs) {
+  return params.linear_ih(inputs);
+}
+
+// The buffer the hidden gates of every step of a fused layer are written to.
+Tensor hidden_gates_buffer(IntArrayRef sizes, const Tensor& igates) {
+  if (use_workspace(igates)) {
+    return workspace_buffer(
+        fused_layer_workspace().hidden_gates, sizes, igates.options());
+  }
+  return at::empty(sizes, igates.options());
+}
+
+// Returns the hidden gates of a step without their bias, which is returned
+// by hidden_bias() and added by the fused kernels. For float weights, they
+// are written into `buffer`; quantized weights go through their own linear
+// ops, which add the bias themselves.
+Tensor hidden_gates(const CellParams& params, const Tensor& h, Tensor& buffer) {
+  at::mm_out(buffer, h, params.w_hh.t());
+  return buffer;
+}
+
+template <typename cell_params>
+Tensor hidden_gates(const cell_params& params, const Tensor& h, Tensor& /*buffer*/) {
+  return params.linear_hh(h);
+}
+
+// Calls fn(offset, batch_size) for every step of a packed sequence with the
+// given batch sizes, from the last step to the first if `reverse` is set.
+// The sequences are sorted by decreasing length, so the batch of every step
+// is a prefix of the batch of the step before it.
+template <typename F>
+void for_each_packed_step(IntArrayRef batch_sizes, bool reverse, const F& fn) {
+  const int64_t num_steps = batch_sizes.size();
+  int64_t offset = reverse
+      ? std::accumulate(batch_sizes.begin(), batch_sizes.end(), int64_t(0))
+      : 0;
+  for (int64_t i = 0; i < num_steps; ++i) {
+    const int64_t batch_size = batch_sizes[reverse ? num_steps - 1 - i : i];
+    if (reverse) {
+      offset -= batch_size;
+    }
+    fn(offset, batch_size);
+    if (!reverse) {
+      offset += batch_size;
+    }
+  }
+}
+
+const Tensor& hidden_bias(const CellParams& params) {
+  return params.b_hh;
+}
+
+template <typename cell_params>
+const Tensor& hidden_bias(const cell_params& /*params*/) {
+  static Tensor undefined;
+  return undefined;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // CELL IMPLEMENTATIONS
 //
@@ -371,6 +536,36 @@ struct Cell {
       const hidden_type& hidden,
       const cell_params& params,
       bool pre_compute_input = false) const = 0;
+
+  // Runs the cell over all the steps of `input_w`, the inputs already
+  // multiplied by w_ih (with b_ih added), going backwards if `reverse` is
+  // set. Cells with a fused implementation return true after writing the
+  // stacked outputs and the final hidden state; others return false, and so
+  // do fused ones when the fused path doesn't apply.
+  virtual bool fused_layer(
+      const Tensor& input_w,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const {
+    return false;
+  }
+
+  // The same for the steps of a packed sequence, whose input projections
+  // `input_w` and `outputs` are packed as its data. The states of all the
+  // sequences are kept in buffers, whose prefix of running sequences every
+  // step updates in place, so that they end up as the final hidden state.
+  virtual bool fused_packed_layer(
+      const Tensor& input_w,
+      IntArrayRef batch_sizes,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const {
+    return false;
+  }
 };
 
 template<typename nonlinearity, typename cell_params>
@@ -421,6 +616,69 @@ struct LSTMCell : Cell<std::tuple<Tensor, Tensor>, cell_params> {
     return std::make_tuple(hy, cy);
   }
 
+  bool fused_layer(
+      const Tensor& input_w,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const override {
+    const auto& hx = std::get<0>(hidden);
+    const auto& cx = std::get<1>(hidden);
+    if (!use_fused_cell(input_w, {hx, cx}, params)) {
+      return false;
+    }
+    const auto igates = input_w.contiguous();
+    const int64_t num_steps = igates.size(0);
+    outputs = at::empty({num_steps, hx.size(0), hx.size(1)}, hx.options());
+    // Updated in place by every step.
+    auto cy = cx.clone();
+    auto hgates_buffer = hidden_gates_buffer({hx.size(0), igates.size(2)}, igates);
+    Tensor h = hx;
+    for (int64_t i = 0; i < num_steps; ++i) {
+      const int64_t t = reverse ? num_steps - 1 - i : i;
+      auto hgates = hidden_gates(params, h, hgates_buffer);
+      auto hy = outputs[t];
+      lstm_cell_pointwise_stub(
+          kCPU, hy, cy, igates[t], hgates, hidden_bias(params), cy);
+      h = hy;
+    }
+    final_hidden = std::make_tuple(h, cy);
+    return true;
+  }
+
+  bool fused_packed_layer(
+      const Tensor& input_w,
+      IntArrayRef batch_sizes,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const override {
+    const auto& hx = std::get<0>(hidden);
+    const auto& cx = std::get<1>(hidden);
+    if (!use_fused_cell(input_w, {hx, cx}, params)) {
+      return false;
+    }
+    const auto igates = input_w.contiguous();
+    outputs = at::empty({igates.size(0), hx.size(1)}, hx.options());
+    auto hy = hx.contiguous().clone();
+    auto cy = cx.contiguous().clone();
+    auto hgates_buffer = hidden_gates_buffer({hx.size(0), igates.size(1)}, igates);
+    for_each_packed_step(batch_sizes, reverse, [&](int64_t offset, int64_t batch_size) {
+      auto h = hy.narrow(0, 0, batch_size);
+      auto c = cy.narrow(0, 0, batch_size);
+      auto buffer = hgates_buffer.narrow(0, 0, batch_size);
+      auto hgates = hidden_gates(params, h, buffer);
+      auto step_output = outputs.narrow(0, offset, batch_size);
+      lstm_cell_pointwise_stub(
+          kCPU, step_output, c, igates.narrow(0, offset, batch_size), hgates,
+          hidden_bias(params), c);
+      h.copy_(step_output);
+    });
+    final_hidden = std::make_tuple(hy, cy);
+    return true;
+  }
 };
 
 template <typename cell_params>
@@ -453,6 +711,62 @@ struct GRUCell : Cell<Tensor, cell_params> {
         chunked_igates[2].add(chunked_hgates[2].mul_(reset_gate)).tanh_();
     return (hidden - new_gate).mul_(input_gate).add_(new_gate);
   }
+
+  bool fused_layer(
+      const Tensor& input_w,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const override {
+    if (!use_fused_cell(input_w, {hidden}, params)) {
+      return false;
+    }
+    const auto igates = input_w.contiguous();
+    const int64_t num_steps = igates.size(0);
+    outputs = at::empty({num_steps, hidden.size(0), hidden.size(1)}, hidden.options());
+    auto hgates_buffer = hidden_gates_buffer({hidden.size(0), igates.size(2)}, igates);
+    Tensor h = hidden;
+    for (int64_t i = 0; i < num_steps; ++i) {
+      const int64_t t = reverse ? num_steps - 1 - i : i;
+      auto hgates = hidden_gates(params, h, hgates_buffer);
+      auto hy = outputs[t];
+      gru_cell_pointwise_stub(
+          kCPU, hy, igates[t], hgates, hidden_bias(params), h);
+      h = hy;
+    }
+    final_hidden = h;
+    return true;
+  }
+
+  bool fused_packed_layer(
+      const Tensor& input_w,
+      IntArrayRef batch_sizes,
+      const hidden_type& hidden,
+      const cell_params& params,
+      bool reverse,
+      Tensor& outputs,
+      hidden_type& final_hidden) const override {
+    if (!use_fused_cell(input_w, {hidden}, params)) {
+      return false;
+    }
+    const auto igates = input_w.contiguous();
+    outputs = at::empty({igates.size(0), hidden.size(1)}, hidden.options());
+    auto hy = hidden.contiguous().clone();
+    auto hgates_buffer = hidden_gates_buffer({hidden.size(0), igates.size(1)}, igates);
+    for_each_packed_step(batch_sizes, reverse, [&](int64_t offset, int64_t batch_size) {
+      auto h = hy.narrow(0, 0, batch_size);
+      auto buffer = hgates_buffer.narrow(0, 0, batch_size);
+      auto hgates = hidden_gates(params, h, buffer);
+      auto step_output = outputs.narrow(0, offset, batch_size);
+      gru_cell_pointwise_stub(
+          kCPU, step_output, igates.narrow(0, offset, batch_size), hgates,
+          hidden_bias(params), h);
+      h.copy_(step_output);
+    });
+    final_hidden = hy;
+    return true;
+  }
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -507,16 +821,36 @@ struct FullLayer : Layer<Tensor, hidden_type, cell_params> {
     return {step_outputs, hidden};
   }
 
+  // Runs the layer over `inputs_w`, the inputs already multiplied by w_ih,
+  // going backwards if `reverse` is set.
+  output_type run_pre_computed(
+      const Tensor& inputs_w,
+      const hidden_type& input_hidden,
+      const cell_params& params,
+      bool reverse = false) const {
+    output_type fused_output;
+    if (cell_.fused_layer(inputs_w, input_hidden, params, reverse,
+                          fused_output.outputs, fused_output.final_hidden)) {
+      return fused_output;
+    }
+    auto step_inputs = inputs_w.unbind(0);
+    if (reverse) {
+      std::reverse(step_inputs.begin(), step_inputs.end());
+    }
+    auto unstacked_output = (*this)(step_inputs, input_hidden, params, true);
+    if (reverse) {
+      std::reverse(unstacked_output.outputs.begin(), unstacked_output.outputs.end());
+    }
+    return {at::stack(unstacked_output.outputs, 0),
+            unstacked_output.final_hidden};
+  }
+
   output_type operator()(
       const Tensor& inputs,
       const hidden_type& input_hidden,
       const cell_params& params) const override {
     if (inputs.device().is_cpu()) {
-      const auto inputs_w = params.linear_ih(inputs);
-      auto unstacked_output =
-          (*this)(inputs_w.unbind(0), input_hidden, params, true);
-      return {at::stack(unstacked_output.outputs, 0),
-              unstacked_output.final_hidden};
+      return run_pre_computed(input_gates(params, inputs), input_hidden, params);
     }
     auto unstacked_output = (*this)(inputs.unbind(0), input_hidden, params);
     return {at::stack(unstacked_output.outputs, 0),
@@ -540,25 +874,18 @@ struct FullBidirectionalLayer
       const Tensor& input,
       const hidden_type& input_hidden,
       const param_type& params) const override {
-    std::vector<Tensor> step_inputs;
     if (input.device().is_cpu()) {
-      auto input_w = params.first.linear_ih(input);
-      step_inputs = input_w.unbind(0);
-      auto fw_result = layer_(
-          step_inputs, input_hidden.first, params.first, true);
-      auto fw_output = at::stack(fw_result.outputs, 0);
-      input_w = params.second.linear_ih(input);
-      step_inputs = input_w.unbind(0);
-      auto rev_step_inputs = reverse(std::move(step_inputs));
-      auto rev_result =
-          layer_(rev_step_inputs, input_hidden.second, params.second, true);
-      std::reverse(rev_result.outputs.begin(), rev_result.outputs.end());
-      auto rev_output = at::stack(rev_result.outputs, 0);
-      return {at::cat({fw_output, rev_output}, fw_output.dim() - 1),
+      auto fw_result = layer_.run_pre_computed(
+          input_gates(params.first, input), input_hidden.first, params.first);
+      auto rev_result = layer_.run_pre_computed(
+          input_gates(params.second, input), input_hidden.second, params.second,
+          /*reverse=*/true);
+      return {at::cat({fw_result.outputs, rev_result.outputs},
+                      fw_result.outputs.dim() - 1),
               std::make_pair(fw_result.final_hidden, rev_result.final_hidden)};
     }
 
-    step_inputs = input.unbind(0);
+    auto step_inputs = input.unbind(0);
     auto fw_result = layer_(step_inputs, input_hidden.first, params.first);
     auto fw_output = at::stack(fw_result.outputs, 0);
     auto rev_step_inputs = reverse(std::move(step_inputs));
@@ -602,9 +929,16 @@ struct PackedLayer : Layer<PackedSequence, hidden_type, cell_params> {
     bool pre_compute_input = false;
     Tensor input_w;
     if (input.data.device().is_cpu()) {
-      input_w = params.linear_ih(input.data);
+      input_w = input_gates(params, input.data);
       input_ptr = &input_w;
       pre_compute_input = true;
+      output_type fused_output{PackedSequence{Tensor(), input.batch_sizes}, {}};
+      if (cell_.fused_packed_layer(
+              input_w, IntArrayRef(batch_sizes, num_steps), input_hidden,
+              params, /*reverse=*/false, fused_output.outputs.data,
+              fused_output.final_hidden)) {
+        return fused_output;
+      }
     }
 
     // Batch sizes is a sequence of decreasing lengths, which are offsets
@@ -661,9 +995,16 @@ struct ReversedPackedLayer : Layer<PackedSequence, hidden_type, cell_params> {
     bool pre_compute_input = false;
     Tensor input_w;
     if (input.data.device().is_cpu()) {
-      input_w = params.linear_ih(input.data);
+      input_w = input_gates(params, input.data);
       input_ptr = &input_w;
       pre_compute_input = true;
+      output_type fused_output{PackedSequence{Tensor(), input.batch_sizes}, {}};
+      if (cell_.fused_packed_layer(
+              input_w, IntArrayRef(batch_sizes, num_steps), input_hidden,
+              params, /*reverse=*/true, fused_output.outputs.data,
+              fused_output.final_hidden)) {
+        return fused_output;
+      }
     }
 
     // Here the situation is similar to that above, except we start out with
@@ -960,6 +1301,8 @@ ONE_HIDDEN_RNN(rnn_tanh, tanf_cell_type)
 using relu_cell_type = SimpleCell<relu_f, CellParams>;
 ONE_HIDDEN_RNN(rnn_relu, relu_cell_type);
 
+DEFINE_DISPATCH(lstm_cell_pointwise_stub);
+DEFINE_DISPATCH(gru_cell_pointwise_stub);
 DEFINE_DISPATCH(lstm_cudnn_stub);
 DEFINE_DISPATCH(lstm_packed_cudnn_stub);
 DEFINE_DISPATCH(lstm_miopen_stub);
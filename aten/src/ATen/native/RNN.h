@@ -27,6 +27,20 @@ DECLARE_DISPATCH(rnn_packed_fn, rnn_tanh_packed_miopen_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_cudnn_stub);
 DECLARE_DISPATCH(rnn_packed_fn, rnn_relu_packed_miopen_stub);
 
+// Fused pointwise parts of the LSTM and GRU cells on CPU, used once the input
+// and hidden gates of a step were computed. `hidden_bias` may be undefined,
+// when it is already part of `hgates`. The LSTM kernel may be called with cy
+// and cx referring to the same (contiguous) tensor.
+using lstm_cell_pointwise_fn = void(*)(
+    Tensor& hy, Tensor& cy, const Tensor& igates, const Tensor& hgates,
+    const Tensor& hidden_bias, const Tensor& cx);
+using gru_cell_pointwise_fn = void(*)(
+    Tensor& hy, const Tensor& igates, const Tensor& hgates,
+    const Tensor& hidden_bias, const Tensor& hx);
+
+DECLARE_DISPATCH(lstm_cell_pointwise_fn, lstm_cell_pointwise_stub);
+DECLARE_DISPATCH(gru_cell_pointwise_fn, gru_cell_pointwise_stub);
+
 inline void check_device(const Tensor& input, const TensorList& params, const TensorList& hiddens) {
   auto input_device = input.device();
 
@@ -32,6 +32,11 @@ DEFINE_DISPATCH(min_values_stub);
 DEFINE_DISPATCH(max_values_stub);
 DEFINE_DISPATCH(argmax_stub);
 DEFINE_DISPATCH(argmin_stub);
+DEFINE_DISPATCH(cumsum_stub);
+DEFINE_DISPATCH(cumprod_stub);
+DEFINE_DISPATCH(logcumsumexp_stub);
+DEFINE_DISPATCH(cummax_stub);
+DEFINE_DISPATCH(cummin_stub);
 
 static inline Tensor integer_upcast(const Tensor& self, optional<ScalarType> dtype) {
   ScalarType scalarType = self.scalar_type();
@@ -236,6 +241,89 @@ Tensor& cumprod_out(Tensor& result, const Tensor& self, int64_t dim, c10::option
   return result;
 }
 
+static void cum_out_check(const char* name, const Tensor& result, const Tensor& self) {
+  TORCH_CHECK(result.scalar_type() == self.scalar_type(), name,
+      ": expected out to have dtype ", self.scalar_type(), " but got ", result.scalar_type());
+  TORCH_CHECK(result.device() == self.device(), name,
+      ": expected out to be on device ", self.device(), " but got ", result.device());
+}
+
+Tensor _cumsum_cpu(const Tensor& self, int64_t dim) {
+  Tensor result = at::empty_like(self);
+  return at::native::_cumsum_out_cpu(result, self, dim);
+}
+
+Tensor& _cumsum_out_cpu(Tensor& result, const Tensor& self, int64_t dim) {
+  cum_out_check("cumsum", result, self);
+  dim = maybe_wrap_dim(dim, self.dim());
+  result.resize_(self.sizes());
+  cumsum_stub(self.device().type(), result, self, dim);
+  return result;
+}
+
+Tensor _cumprod_cpu(const Tensor& self, int64_t dim) {
+  Tensor result = at::empty_like(self);
+  return at::native::_cumprod_out_cpu(result, self, dim);
+}
+
+Tensor& _cumprod_out_cpu(Tensor& result, const Tensor& self, int64_t dim) {
+  cum_out_check("cumprod", result, self);
+  dim = maybe_wrap_dim(dim, self.dim());
+  result.resize_(self.sizes());
+  cumprod_stub(self.device().type(), result, self, dim);
+  return result;
+}
+
+Tensor logcumsumexp(const Tensor& self, int64_t dim) {
+  Tensor result = at::empty({0}, self.options());
+  return at::logcumsumexp_out(result, self, dim);
+}
+
+Tensor& logcumsumexp_out_cpu(Tensor& result, const Tensor& self, int64_t dim) {
+  TORCH_CHECK(at::isFloatingType(self.scalar_type()),
+      "logcumsumexp only supports floating-point dtypes, got: ", self.scalar_type());
+  cum_out_check("logcumsumexp", result, self);
+  dim = maybe_wrap_dim(dim, self.dim());
+  result.resize_(self.sizes());
+  logcumsumexp_stub(self.device().type(), result, self, dim);
+  return result;
+}
+
+std::tuple<Tensor, Tensor> cummax(const Tensor& self, int64_t dim) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  at::cummax_out(values, indices, self, dim);
+  return std::make_tuple(values, indices);
+}
+
+std::tuple<Tensor&, Tensor&> cummax_out_cpu(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim) {
+  cum_out_check("cummax", values, self);
+  TORCH_CHECK(indices.scalar_type() == kLong,
+      "cummax: expected indices to have dtype Long but got ", indices.scalar_type());
+  dim = maybe_wrap_dim(dim, self.dim());
+  values.resize_(self.sizes());
+  indices.resize_(self.sizes());
+  cummax_stub(self.device().type(), values, indices, self, dim);
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> cummin(const Tensor& self, int64_t dim) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  at::cummin_out(values, indices, self, dim);
+  return std::make_tuple(values, indices);
+}
+
+std::tuple<Tensor&, Tensor&> cummin_out_cpu(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim) {
+  cum_out_check("cummin", values, self);
+  TORCH_CHECK(indices.scalar_type() == kLong,
+      "cummin: expected indices to have dtype Long but got ", indices.scalar_type());
+  dim = maybe_wrap_dim(dim, self.dim());
+  values.resize_(self.sizes());
+  indices.resize_(self.sizes());
+  cummin_stub(self.device().type(), values, indices, self, dim);
+  return std::forward_as_tuple(values, indices);
+}
 
 // ALL REDUCE #################################################################
 
@@ -499,6 +587,36 @@ Tensor norm(const Tensor& self, Scalar p) {
   return at::native::_norm(self, p);
 }
 
+Tensor& renorm_out_cpu(Tensor& result, const Tensor& self, Scalar p, int64_t dim, Scalar maxnorm) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  TORCH_CHECK(at::isFloatingType(self.scalar_type()),
+      "renorm: expected a floating point tensor, but got ", self.scalar_type());
+  TORCH_CHECK(p.toDouble() > 0, "renorm: non-positive-norm not supported");
+  TORCH_CHECK(self.dim() > 1, "renorm: need at least 2 dimensions, got ", self.dim(), " dimensions");
+
+  // The norms of all slices along dim are computed in one reduction, and the
+  // slices are rescaled in one multiplication.
+  DimVector reduce_dims;
+  for (int64_t d = 0; d < self.dim(); d++) {
+    if (d != dim) {
+      reduce_dims.push_back(d);
+    }
+  }
+  auto norm = at::norm(self, p, reduce_dims, /*keepdim=*/true);
+  auto factor = at::where(
+      norm > maxnorm, norm.add(1e-7).reciprocal_().mul_(maxnorm), at::ones_like(norm));
+  return at::mul_out(result, self, factor);
+}
+
+Tensor renorm_cpu(const Tensor& self, Scalar p, int64_t dim, Scalar maxnorm) {
+  Tensor result = at::empty({0}, self.options());
+  return at::native::renorm_out_cpu(result, self, p, dim, maxnorm);
+}
+
+Tensor& renorm_cpu_(Tensor& self, Scalar p, int64_t dim, Scalar maxnorm) {
+  return at::native::renorm_out_cpu(self, self, p, dim, maxnorm);
+}
+
 inline Tensor & _all(Tensor & result, TensorIterator & iter) {
   if (iter.numel() == 0) {
     result.fill_(1);
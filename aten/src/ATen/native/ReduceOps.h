@@ -33,4 +33,16 @@ DECLARE_DISPATCH(reduce_norm_fn, norm_kernel);
 using reduce_fn_flag = void(*)(TensorIterator &, Scalar);
 DECLARE_DISPATCH(reduce_fn_flag, norm_stub);
 
+// Inclusive scans of `self` along `dim` into `result`, which has the size of
+// `self`.
+using cum_fn = void (*)(Tensor& result, const Tensor& self, int64_t dim);
+DECLARE_DISPATCH(cum_fn, cumsum_stub);
+DECLARE_DISPATCH(cum_fn, cumprod_stub);
+DECLARE_DISPATCH(cum_fn, logcumsumexp_stub);
+
+using cum_indices_fn =
+    void (*)(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim);
+DECLARE_DISPATCH(cum_indices_fn, cummax_stub);
+DECLARE_DISPATCH(cum_indices_fn, cummin_stub);
+
 }} // namespace at::native
@@ -0,0 +1,166 @@
+#include <ATen/native/ScatterGather.h>
+
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
+#include <ATen/WrapDimUtils.h>
+
+#include <cstring>
+
+namespace at { namespace native {
+
+DEFINE_DISPATCH(gather_stub);
+DEFINE_DISPATCH(scatter_stub);
+DEFINE_DISPATCH(scatter_add_stub);
+
+namespace {
+
+// As in TH, zero-dimensional tensors are treated as tensors of one element.
+int64_t legacy_dim(const Tensor& t) {
+  return std::max<int64_t>(t.dim(), 1);
+}
+
+int64_t legacy_size(const Tensor& t, int64_t dim) {
+  return t.dim() == 0 ? 1 : t.size(dim);
+}
+
+void check_index(const char* name, const Tensor& self, const Tensor& index) {
+  TORCH_CHECK(index.scalar_type() == kLong,
+      name, "(): Expected dtype int64 for index, but got ", index.scalar_type());
+  TORCH_CHECK(index.device() == self.device(),
+      name, "(): Expected index on ", self.device(), ", but got it on ", index.device());
+}
+
+void check_same_type(const char* name, const Tensor& self, const char* other_name, const Tensor& other) {
+  TORCH_CHECK(other.scalar_type() == self.scalar_type(),
+      name, "(): Expected ", other_name, " of dtype ", self.scalar_type(), ", but got ", other.scalar_type());
+  TORCH_CHECK(other.device() == self.device(),
+      name, "(): Expected ", other_name, " on ", self.device(), ", but got it on ", other.device());
+}
+
+// index and src along the other dimensions than dim must fit in self, and
+// index in src along all of them.
+void check_scatter_shapes(const char* name, const Tensor& self, int64_t dim,
+                          const Tensor& index, const Tensor& src) {
+  TORCH_CHECK(legacy_dim(index) == legacy_dim(self),
+      name, "(): Index tensor must have the same number of dimensions as self tensor");
+  TORCH_CHECK(legacy_dim(src) == legacy_dim(self),
+      name, "(): Src tensor must have the same number of dimensions as self tensor");
+  for (int64_t d = 0; d < legacy_dim(index); d++) {
+    const int64_t index_size = legacy_size(index, d);
+    TORCH_CHECK(index_size <= legacy_size(src, d) && (d == dim || index_size <= legacy_size(self, d)),
+        "Expected index ", index.sizes(), " to be smaller size than src ", src.sizes(),
+        " and to be smaller than self ", self.sizes(), " apart from dimension ", dim);
+  }
+}
+
+} // namespace
+
+Tensor & gather_out_cpu(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  check_index("gather", self, index);
+  check_same_type("gather", self, "out", result);
+  TORCH_CHECK(legacy_dim(index) == legacy_dim(self),
+      "gather(): Index tensor must have the same number of dimensions as input tensor");
+  for (int64_t d = 0; d < legacy_dim(index); d++) {
+    TORCH_CHECK(d == dim || legacy_size(index, d) == legacy_size(self, d),
+        "Expected index ", index.sizes(), " and input ", self.sizes(),
+        " to have the same size apart from dimension ", dim);
+  }
+  result.resize_(index.sizes());
+  if (index.numel() != 0) {
+    gather_stub(kCPU, result, self, dim, index);
+  }
+  return result;
+}
+
+Tensor gather_cpu(const Tensor & self, int64_t dim, const Tensor & index, bool sparse_grad) {
+  Tensor result = at::empty({0}, self.options());
+  return gather_out_cpu(result, self, dim, index, sparse_grad);
+}
+
+Tensor & scatter_cpu_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & src) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  check_index("scatter_", self, index);
+  check_same_type("scatter_", self, "src", src);
+  if (index.numel() == 0) {
+    return self;
+  }
+  check_scatter_shapes("scatter_", self, dim, index, src);
+  scatter_stub(kCPU, self, dim, index, src);
+  return self;
+}
+
+Tensor & scatter_add_cpu_(Tensor & self, int64_t dim, const Tensor & index, const Tensor & src) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  check_index("scatter_add_", self, index);
+  check_same_type("scatter_add_", self, "src", src);
+  if (index.numel() == 0) {
+    return self;
+  }
+  check_scatter_shapes("scatter_add_", self, dim, index, src);
+  scatter_add_stub(kCPU, self, dim, index, src);
+  return self;
+}
+
+// Rows of contiguous tensors are copied with memcpy, in parallel over the
+// (outer index, selected index) rows. Anything else is a gather with index
+// expanded along the other dimensions.
+Tensor & index_select_out_cpu(Tensor & result, const Tensor & self, int64_t dim, const Tensor & index) {
+  dim = maybe_wrap_dim(dim, self.dim());
+  TORCH_CHECK(index.dim() <= 1, "index_select(): Index is supposed to be a vector");
+  check_index("index_select", self, index);
+  check_same_type("index_select", self, "out", result);
+
+  const Tensor src = self.dim() == 0 ? self.view({1}) : self;
+  const int64_t numel = index.numel();
+  auto sizes = src.sizes().vec();
+  sizes[dim] = numel;
+  result.resize_(sizes);
+  if (result.numel() == 0) {
+    return result;
+  }
+
+  const Tensor index_contig = index.contiguous();
+  if (!src.is_contiguous() || !result.is_contiguous()) {
+    std::vector<int64_t> index_shape(src.dim(), 1);
+    index_shape[dim] = numel;
+    Tensor expanded_index = index_contig.view(index_shape).expand(sizes);
+    gather_stub(kCPU, result, src, dim, expanded_index);
+    return result;
+  }
+
+  const int64_t* index_data = index_contig.data_ptr<int64_t>();
+  const int64_t src_size = src.size(dim);
+  for (int64_t i = 0; i < numel; i++) {
+    TORCH_CHECK_INDEX(index_data[i] >= 0 && index_data[i] < src_size,
+        "index_select(): index ", index_data[i], " is out of bounds for dimension ", dim,
+        " with size ", src_size);
+  }
+  int64_t outer = 1;
+  for (int64_t d = 0; d < dim; d++) {
+    outer *= sizes[d];
+  }
+  const int64_t inner = result.numel() / (outer * numel);
+  const int64_t row_bytes = inner * src.element_size();
+  const char* src_data = static_cast<const char*>(src.data_ptr());
+  char* result_data = static_cast<char*>(result.data_ptr());
+  at::parallel_for(0, outer * numel, std::max<int64_t>(1, internal::GRAIN_SIZE / inner),
+      [&](int64_t begin, int64_t end) {
+    for (int64_t row = begin; row < end; row++) {
+      const int64_t o = row / numel;
+      const int64_t i = row % numel;
+      std::memcpy(result_data + row * row_bytes,
+                  src_data + (o * src_size + index_data[i]) * row_bytes,
+                  row_bytes);
+    }
+  });
+  return result;
+}
+
+Tensor index_select_cpu(const Tensor & self, int64_t dim, const Tensor & index) {
+  Tensor result = at::empty({0}, self.options());
+  return index_select_out_cpu(result, self, dim, index);
+}
+
+}} // namespace at::native
@@ -0,0 +1,20 @@
+#pragma once
+
+// gather, scatter_ and scatter_add_ along a dimension, and index_select
+// through gather.
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at { namespace native {
+
+// (result, self, dim, index): result[...][i][...] = self[...][index[...][i][...]][...]
+using gather_fn = void(*)(Tensor& result, const Tensor& self, int64_t dim, const Tensor& index);
+// (self, dim, index, src): self[...][index[...][i][...]][...] = (or +=) src[...][i][...]
+using scatter_fn = void(*)(Tensor& self, int64_t dim, const Tensor& index, const Tensor& src);
+
+DECLARE_DISPATCH(gather_fn, gather_stub);
+DECLARE_DISPATCH(scatter_fn, scatter_stub);
+DECLARE_DISPATCH(scatter_fn, scatter_add_stub);
+
+}} // namespace at::native
@@ -225,6 +225,40 @@ std::tuple<Tensor, Tensor> topk(
   return std::make_tuple(values, indices);
 }
 
+std::tuple<Tensor&, Tensor&> sort_out_cpu(
+    Tensor& values,
+    Tensor& indices,
+    const Tensor& self,
+    int64_t dim_,
+    bool descending) {
+  int64_t dim = maybe_wrap_dim(dim_, self.dim(), /*wrap_scalar=*/true);
+  values.resize_as_(self);
+  indices.resize_(self.sizes());
+  if (self.dim() == 0 && self.numel() == 1) {
+    values.copy_(self);
+    indices.zero_();
+    return std::forward_as_tuple(values, indices);
+  }
+
+  // The kernel sorts `values` in place along `dim` and fills `indices` with
+  // the positions the sorted elements came from.
+  values.copy_(self);
+  if (self.numel() > 0) {
+    sort_stub(kCPU, values, indices, dim, descending);
+  }
+
+  return std::forward_as_tuple(values, indices);
+}
+
+std::tuple<Tensor, Tensor> sort_cpu(
+    const Tensor& self,
+    int64_t dim,
+    bool descending) {
+  Tensor values = at::empty({0}, self.options());
+  Tensor indices = at::empty({0}, self.options().dtype(kLong));
+  return sort_out_cpu(values, indices, self, dim, descending);
+}
+
 std::tuple<Tensor&, Tensor&> median_out(
     Tensor& values,
     Tensor& indices,
@@ -312,6 +346,7 @@ Tensor median_cpu(const Tensor& self) {
   return result.view({});
 }
 
+DEFINE_DISPATCH(sort_stub);
 DEFINE_DISPATCH(topk_stub);
 
 } // namespace native
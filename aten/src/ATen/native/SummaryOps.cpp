@@ -1,9 +1,14 @@
-// Returns the frequency of elements of input non-negative integer tensor.
+// Returns the frequency of elements of input non-negative integer tensor, and
+// the histogram of a floating point tensor.
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 
+#include <cmath>
+#include <mutex>
 #include <tuple>
+#include <vector>
 
 namespace at { namespace native {
 
@@ -64,4 +69,75 @@ _bincount_cpu(const Tensor& self, const Tensor& weights, int64_t minlength) {
   });
 }
 
+///////////////// histc /////////////////
+namespace {
+
+template <typename input_t>
+Tensor _histc_cpu_template(
+    const Tensor& self,
+    int64_t nbins,
+    input_t min,
+    input_t max) {
+  if (nbins <= 0) {
+    AT_ERROR("bins must be > 0");
+  }
+  Tensor output = native::zeros({nbins}, self.options());
+  input_t minvalue = min;
+  input_t maxvalue = max;
+  if (min == max) {
+    minvalue = *self.min().data_ptr<input_t>();
+    maxvalue = *self.max().data_ptr<input_t>();
+  }
+  if (minvalue == maxvalue) {
+    minvalue = minvalue - 1;
+    maxvalue = maxvalue + 1;
+  }
+
+  TORCH_CHECK(
+      !(std::isinf(minvalue) || std::isinf(maxvalue) ||
+        std::isnan(minvalue) || std::isnan(maxvalue)),
+      "range of [", minvalue, ", ", maxvalue, "] is not finite");
+  TORCH_CHECK(minvalue < maxvalue, "max must be larger than min");
+
+  const auto self_contig = self.contiguous();
+  const input_t* self_p = self_contig.data_ptr<input_t>();
+  input_t* output_p = output.data_ptr<input_t>();
+  std::mutex output_mutex;
+  // Every chunk counts into its own histogram, which is added to the output
+  // when the chunk is done.
+  at::parallel_for(0, self.numel(), internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    std::vector<int64_t> counts(nbins, 0);
+    for (int64_t i = begin; i < end; i++) {
+      const input_t value = self_p[i];
+      if (value >= minvalue && value <= maxvalue) {
+        const int64_t bin = static_cast<int64_t>((value - minvalue) / (maxvalue - minvalue) * nbins);
+        counts[std::min(bin, nbins - 1)] += 1;
+      }
+    }
+    std::lock_guard<std::mutex> lock(output_mutex);
+    for (int64_t bin = 0; bin < nbins; bin++) {
+      output_p[bin] += counts[bin];
+    }
+  });
+  return output;
+}
+} // namespace
+
+Tensor _histc_cpu(
+    const Tensor& self,
+    int64_t nbins,
+    Scalar min,
+    Scalar max) {
+  return AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "histc_cpu", [&] {
+    return _histc_cpu_template<scalar_t>(self, nbins, min.to<scalar_t>(), max.to<scalar_t>());
+  });
+}
+
+Tensor& _histc_out_cpu(Tensor& result, const Tensor& self, int64_t bins, Scalar min, Scalar max) {
+  auto ret = _histc_cpu(self, bins, min, max);
+  result.resize_as_(ret);
+  result.copy_(ret);
+  return result;
+}
+
 }} // namespace at::native
@@ -9,6 +9,7 @@
 #include <ATen/Utils.h>
 #include <ATen/Dispatch.h>
 #include <ATen/NativeFunctions.h>
+#include <c10/core/CPUAllocator.h>
 #include <c10/core/ScalarType.h>
 #include <c10/util/Deprecated.h>
 #include <ATen/native/Resize.h>
@@ -98,12 +99,25 @@ Tensor empty_cpu(IntArrayRef size, const TensorOptions& options, c10::optional<c
 
   int64_t nelements = prod_intlist(size);
   auto dtype = options.dtype();
-  auto storage_impl = c10::make_intrusive<StorageImpl>(
-    dtype,
-    nelements,
-    allocator->allocate(nelements * dtype.itemsize()),
-    allocator,
-    /*resizeable=*/true);
+  const size_t nbytes = nelements * dtype.itemsize();
+  c10::intrusive_ptr<StorageImpl> storage_impl;
+  if (nbytes > 0 && nbytes <= StorageImpl::kSmallBufferBytes &&
+      c10::IsPlainDefaultCPUAllocator(allocator)) {
+    // Scalars and other tiny tensors keep their data inside the StorageImpl
+    storage_impl = c10::make_intrusive<StorageImpl>(
+      dtype,
+      nelements,
+      allocator,
+      /*resizeable=*/true,
+      StorageImpl::use_small_buffer_t());
+  } else {
+    storage_impl = c10::make_intrusive<StorageImpl>(
+      dtype,
+      nelements,
+      allocator->allocate(nbytes),
+      allocator,
+      /*resizeable=*/true);
+  }
 
   auto tensor = detail::make_tensor<TensorImpl>(std::move(storage_impl), at::TensorTypeId::CPUTensorId);
   // Default TensorImpl has size [0]
@@ -876,9 +890,43 @@ Tensor from_file(std::string filename, c10::optional<bool> shared, c10::optional
 
 // ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~ clone ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 
+namespace {
+
+// Shares the storage of src until either tensor is accessed if the clone has
+// the layout of src and src covers its whole storage, so that no memory is
+// held for nothing, see Note [Copy-on-write storage].
+c10::optional<Tensor> lazy_clone(const Tensor& src, MemoryFormat memory_format) {
+  if (!at::globalContext().lazyClone() || src.device().type() != kCPU ||
+      !src.has_storage() || src.storage_offset() != 0 ||
+      src.storage().numel() != src.numel()) {
+    return c10::nullopt;
+  }
+  const bool same_layout = memory_format == MemoryFormat::Preserve
+      ? src.is_non_overlapping_and_dense()
+      : src.is_contiguous(memory_format);
+  if (!same_layout) {
+    return c10::nullopt;
+  }
+  auto storage = src.storage().unsafeGetStorageImpl()->lazy_clone();
+  if (!storage) {
+    return c10::nullopt;
+  }
+  auto self = at::empty({0}, src.options());
+  self.set_(Storage(std::move(storage)), 0, src.sizes(), src.strides());
+#ifdef BUILD_NAMEDTENSOR
+  namedinference::propagate_names(self, src);
+#endif
+  return self;
+}
+
+} // namespace
+
 Tensor clone(const Tensor& src, c10::optional<c10::MemoryFormat> optional_memory_format) {
   auto memory_format =
       optional_memory_format.value_or(MemoryFormat::Contiguous);
+  if (auto self = lazy_clone(src, memory_format)) {
+    return *self;
+  }
   if (memory_format == MemoryFormat::Preserve) {
     if (src.is_non_overlapping_and_dense()) {
       // Copy all strides
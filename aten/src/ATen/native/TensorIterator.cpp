@@ -1,6 +1,8 @@
 #include <ATen/native/TensorIterator.h>
 
 #include <array>
+#include <atomic>
+#include <unordered_map>
 #include <ATen/ExpandUtils.h>
 #include <ATen/Parallel.h>
 #include <ATen/core/EnableNamedTensor.h>
@@ -14,6 +16,28 @@ using loop_t = TensorIterator::loop_t;
 using loop2d_t = TensorIterator::loop2d_t;
 using StrideVector = TensorIterator::StrideVector;
 
+namespace {
+
+struct PlanKeyHash {
+  size_t operator()(const TensorIteratorPlan::Key& key) const {
+    return key.hash;
+  }
+};
+
+using PlanCache = std::unordered_map<
+    TensorIteratorPlan::Key,
+    std::shared_ptr<const TensorIteratorPlan>,
+    PlanKeyHash>;
+
+std::atomic<size_t> plan_cache_capacity{256};
+
+PlanCache& plan_cache() {
+  static thread_local PlanCache cache;
+  return cache;
+}
+
+} // namespace
+
 void TensorIterator::reorder_dimensions() {
   // Sort the dimensions based on strides in ascending order with reduced dims
   // at the front. NOTE: that this inverts the order of C-contiguous tensors.
@@ -486,18 +510,18 @@ int TensorIterator::num_reduce_dims() const {
     }                                                                     \
   }
 
-void TensorIterator::for_each(loop_t loop) {
-  for_each(LOOP_WRAPPER(ntensors(), loop));
+void TensorIterator::for_each(loop_t loop, int64_t grain_size) {
+  for_each(LOOP_WRAPPER(ntensors(), loop), grain_size);
 }
 
-void TensorIterator::for_each(loop2d_t loop) {
+void TensorIterator::for_each(loop2d_t loop, int64_t grain_size) {
   int64_t numel = this->numel();
   if (numel == 0) {
     return;
-  } else if (numel < internal::GRAIN_SIZE || at::get_num_threads() == 1) {
+  } else if (numel < grain_size || at::get_num_threads() == 1) {
     return serial_for_each(loop, {0, numel});
   } else {
-    at::parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+    at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
       serial_for_each(loop, {begin, end});
     });
   }
@@ -590,6 +614,10 @@ void TensorIterator::replace_operand(int arg, void* data, IntArrayRef stride) {
   operands_[arg].stride_bytes = stride;
 }
 
+void TensorIterator::unsafe_replace_operand(int arg, void* data) {
+  operands_[arg].data = data;
+}
+
 void TensorIterator::remove_dimension(int dim) {
   AT_ASSERT(dim >= 0 && dim < ndim());
   shape_.erase(shape_.begin() + dim);
@@ -844,11 +872,62 @@ int TensorIterator::get_dim_to_split() const {
 }
 
 void TensorIterator::build() {
+  build(nullptr);
+}
+
+void TensorIterator::build(const std::shared_ptr<const TensorIteratorPlan>& plan) {
   // set is_output and is_read_write flags on appropriate tensors
   mark_outputs();
   // Check that the outputs have no internal overlap
   // and do not share memory with inputs.
   check_mem_overlaps();
+
+  // See Note [TensorIterator plans]
+  plan_.reset();
+  const size_t capacity = plan_cache_capacity.load(std::memory_order_relaxed);
+  TensorIteratorPlan::Key key;
+  if ((!plan && capacity == 0) || !compute_plan_key(key)) {
+    compute_geometry();
+    return;
+  }
+
+  if (plan && plan->key == key) {
+    apply_plan(*plan);
+    plan_ = plan;
+    return;
+  }
+  auto& cache = plan_cache();
+  if (capacity > 0) {
+    auto it = cache.find(key);
+    if (it != cache.end()) {
+      apply_plan(*it->second);
+      plan_ = it->second;
+      return;
+    }
+  }
+
+  SmallVector<Tensor, 4> original_operands;
+  SmallVector<DimVector, 1> original_output_sizes;
+  for (int i = 0; i < ntensors(); i++) {
+    const auto& tensor = operands_[i].tensor;
+    original_operands.push_back(tensor);
+    if (i < num_outputs_) {
+      original_output_sizes.emplace_back(
+          tensor.defined() ? tensor.sizes() : IntArrayRef());
+    }
+  }
+  compute_geometry();
+  auto made = make_plan(std::move(key), original_operands, original_output_sizes);
+  if (made && capacity > 0) {
+    if (cache.size() >= capacity) {
+      cache.clear();
+    }
+    cache.emplace(made->key, made);
+  }
+  plan_ = std::move(made);
+}
+
+void TensorIterator::compute_geometry() {
 #ifdef BUILD_NAMEDTENSOR
   // Check that input dimensions are aligned correctly & compute outnames.
   compute_names();
@@ -876,6 +955,113 @@ void TensorIterator::build() {
   }
 }
 
+bool TensorIterator::compute_plan_key(TensorIteratorPlan::Key& key) const {
+  auto& values = key.values;
+  values.push_back(static_cast<int64_t>(common_dtype_strategy_));
+  values.push_back(resize_outputs_ | is_reduction_ << 1 |
+                   allow_cpu_scalars_ << 2 | promote_gpu_output_dtypes_ << 3);
+  values.push_back(num_outputs_);
+  values.push_back(ntensors());
+  for (int i = 0; i < ntensors(); i++) {
+    const auto& op = operands_[i];
+    const auto& tensor = op.tensor;
+    values.push_back(static_cast<int64_t>(op.dtype));
+    values.push_back(static_cast<int64_t>(op.device.type()));
+    values.push_back(op.device.index());
+    values.push_back(tensor.defined());
+    if (!tensor.defined()) {
+      continue;
+    }
+#ifdef BUILD_NAMEDTENSOR
+    if (tensor.has_names()) {
+      return false;
+    }
+#endif
+    // the output this input is also, if any
+    int64_t output = -1;
+    for (int j = 0; i >= num_outputs_ && j < num_outputs_; j++) {
+      if (tensor.is_same(operands_[j].tensor)) {
+        output = j;
+        break;
+      }
+    }
+    values.push_back(output);
+    values.push_back(static_cast<int64_t>(tensor.scalar_type()));
+    values.push_back(static_cast<int64_t>(tensor.device().type()));
+    values.push_back(tensor.device().index());
+    values.push_back(tensor.unsafeGetTensorImpl()->is_wrapped_number());
+    values.push_back(tensor.dim());
+    values.append(tensor.sizes().begin(), tensor.sizes().end());
+    values.append(tensor.strides().begin(), tensor.strides().end());
+  }
+
+  size_t hash = 0;
+  for (int64_t value : values) {
+    hash ^= std::hash<int64_t>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  key.hash = hash;
+  return true;
+}
+
+std::shared_ptr<TensorIteratorPlan> TensorIterator::make_plan(
+    TensorIteratorPlan::Key key,
+    ArrayRef<Tensor> original_operands,
+    ArrayRef<DimVector> original_output_sizes) const {
+  auto plan = std::make_shared<TensorIteratorPlan>();
+  plan->key = std::move(key);
+  plan->shape = shape_;
+  plan->perm = perm_;
+  plan->has_coalesced_dimensions = has_coalesced_dimensions_;
+  for (int i = 0; i < ntensors(); i++) {
+    const auto& op = operands_[i];
+    const auto& original = original_operands[i];
+    // Conversions to another dtype or device depend on the values of the
+    // operands, so they can't be replayed.
+    if (op.original_tensor.defined() ||
+        (original.defined() && !original.is_same(op.tensor))) {
+      return nullptr;
+    }
+    TensorIteratorPlan::Operand planned;
+    planned.device = op.device;
+    planned.dtype = op.dtype;
+    planned.stride_bytes = op.stride_bytes;
+    if (!original.defined()) {
+      planned.allocate = true;
+      planned.sizes = op.tensor.sizes();
+      planned.strides = op.tensor.strides();
+    } else if (i < num_outputs_ &&
+               !op.tensor.sizes().equals(original_output_sizes[i])) {
+      planned.resize = true;
+      planned.sizes = op.tensor.sizes();
+    }
+    plan->operands.push_back(std::move(planned));
+  }
+  return plan;
+}
+
+void TensorIterator::apply_plan(const TensorIteratorPlan& plan) {
+  shape_ = plan.shape;
+  perm_ = plan.perm;
+  has_coalesced_dimensions_ = plan.has_coalesced_dimensions;
+  for (int i = 0; i < ntensors(); i++) {
+    auto& op = operands_[i];
+    const auto& planned = plan.operands[i];
+    op.device = planned.device;
+    op.dtype = planned.dtype;
+    if (planned.allocate) {
+      op.tensor = at::empty_strided(planned.sizes, planned.strides, op.options());
+    } else if (planned.resize) {
+      op.tensor.resize_(planned.sizes);
+    }
+    op.stride_bytes = planned.stride_bytes;
+    op.data = op.tensor.data_ptr();
+  }
+}
+
+void TensorIterator::set_plan_cache_capacity(size_t capacity) {
+  plan_cache_capacity.store(capacity, std::memory_order_relaxed);
+}
+
 SplitUntil32Bit TensorIterator::with_32bit_indexing() const {
   return SplitUntil32Bit(*this);
 }
@@ -1,11 +1,13 @@
 #pragma once
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 #include <c10/util/FunctionRef.h>
 #include <c10/util/SmallVector.h>
 #include <ATen/core/Range.h>
 #include <ATen/detail/ScalarTypeConversions.h>
 #include <bitset>
+#include <memory>
 #include <c10/util/Optional.h>
 #include <ATen/MemoryOverlap.h>
 #include <ATen/NamedTensorUtils.h>
@@ -54,6 +56,23 @@
 // Note that TensorIterator currently supports type conversions on 0-dim
 // tensors and arithmetic operators. Other type conversions will raise an
 // exception.
+//
+// Note [TensorIterator plans]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Apart from the memory overlap checks, what build() computes (the broadcast
+// shape, the types, the permuted and coalesced strides, and the shape of
+// the outputs it allocates or resizes) only depends on the metadata of the
+// operands: their dtypes, devices, sizes and strides, and which inputs are
+// also outputs. build() saves it in a TensorIteratorPlan, keyed by that
+// metadata and by the configuration of the iterator, in a small per-thread
+// cache. When a later build has the same key, the plan is replayed instead
+// of recomputing everything. For small tensors, that replay is much cheaper
+// than a full build.
+//
+// Builds that convert an operand to another dtype or device, or whose
+// operands have names, are not planned. Callers that run the same op over
+// and over, like interpreters, can also keep the plan() of an iterator and
+// pass it to the next build(plan), which skips the cache lookup.
 
 namespace at {
 
@@ -126,6 +145,37 @@ struct CAFFE2_API OperandInfo {
 
 struct SplitUntil32Bit;
 
+/// What TensorIterator::build() computed for operands with the metadata in
+/// `key`. See Note [TensorIterator plans].
+struct CAFFE2_API TensorIteratorPlan {
+  struct Key {
+    SmallVector<int64_t, 32> values;
+    size_t hash = 0;
+
+    bool operator==(const Key& other) const {
+      return hash == other.hash && values == other.values;
+    }
+  };
+
+  struct Operand {
+    Device device = kCPU;
+    ScalarType dtype = ScalarType::Undefined;
+    SmallVector<int64_t, 6> stride_bytes;
+    /// Whether build() allocates the output with `sizes` and `strides`
+    bool allocate = false;
+    /// Whether build() resizes the output to `sizes`
+    bool resize = false;
+    DimVector sizes;
+    DimVector strides;
+  };
+
+  Key key;
+  DimVector shape;
+  DimVector perm;
+  bool has_coalesced_dimensions = false;
+  SmallVector<Operand, 4> operands;
+};
+
 enum class CommonDTypeStrategy : uint8_t {
   NONE, // Do not compute a common dtype
   CHECK, // Compute and validate a common dtype but don't promote.
@@ -232,6 +282,9 @@ struct CAFFE2_API TensorIterator {
   void select_all_keeping_dim(int start_dim, IntArrayRef starts);
   /// Replaces the data pointer and strides for the operand at index `arg`
   void replace_operand(int arg, void* data, IntArrayRef stride);
+  /// Replaces the data pointer for the operand at index `arg`, keeping its
+  /// strides. The new data must have the same shape and strides.
+  void unsafe_replace_operand(int arg, void* data);
 
   /// Splits this TensorIterator into two iterators. Together they iterate over
   /// the entire operation. Used by `with_32bit_indexing()`.
@@ -246,11 +299,21 @@ struct CAFFE2_API TensorIterator {
     return at::detail::load<T>(op.data, op.tensor.scalar_type());
   }
 
-  void for_each(loop_t loop);
-  void for_each(loop2d_t loop);
+  void for_each(loop_t loop, int64_t grain_size = at::internal::GRAIN_SIZE);
+  void for_each(loop2d_t loop, int64_t grain_size = at::internal::GRAIN_SIZE);
 
+  /// Runs a reduction that accumulates into its output with `loop`, in
+  /// parallel over either the outputs or the input, whichever splits into
+  /// enough work for every thread. Calls reorder_for_reduction() first.
   void parallel_reduce(loop2d_t loop);
 
+  /// Moves a dimension in which both the input and output are contiguous
+  /// to dim 1 if the inner loop (dim 0) is a reduction over a non-contiguous
+  /// input and dim 1 isn't such a dimension already, so that the 2-D loop of
+  /// a reduction can be vectorized along dim 1. The reduced dimensions are no
+  /// longer all in front afterwards.
+  void reorder_for_reduction();
+
   void serial_for_each(loop_t loop, Range range) const;
   void serial_for_each(loop2d_t loop, Range range) const;
 
@@ -327,6 +390,18 @@ struct CAFFE2_API TensorIterator {
 
   void build();
 
+  /// Same as build(), but replays `plan` if it has the same key as this
+  /// iterator instead of looking up the plan cache.
+  void build(const std::shared_ptr<const TensorIteratorPlan>& plan);
+
+  /// The plan used or made by the last build, or nullptr if it couldn't be
+  /// planned.
+  const std::shared_ptr<const TensorIteratorPlan>& plan() const { return plan_; }
+
+  /// Sets the number of plans each thread caches (256 by default). 0 disables
+  /// the cache.
+  static void set_plan_cache_capacity(size_t capacity);
+
 protected:
   void mark_outputs();
   void check_mem_overlaps();
@@ -342,6 +417,13 @@ protected:
   void propagate_names_to_outputs();
 #endif
   void coalesce_dimensions();
+  void compute_geometry();
+  bool compute_plan_key(TensorIteratorPlan::Key& key) const;
+  std::shared_ptr<TensorIteratorPlan> make_plan(
+      TensorIteratorPlan::Key key,
+      ArrayRef<Tensor> original_operands,
+      ArrayRef<DimVector> original_output_sizes) const;
+  void apply_plan(const TensorIteratorPlan& plan);
 
 protected:
   DimVector shape_;
@@ -360,6 +442,7 @@ protected:
   bool promote_gpu_output_dtypes_ = false;
   bool final_output_ = true;
   bool check_mem_overlap_ = false;
+  std::shared_ptr<const TensorIteratorPlan> plan_;
 };
 /// A container-like struct that acts as if it contains splits of a
 /// TensorIterator that can use 32-bit indexing. Taken together the splits cover
@@ -2,6 +2,7 @@
 #include <ATen/Parallel.h>
 #include <algorithm>
 #include <memory>
+#include <numeric>
 
 /// Contains the implementation of parallel reductions in TensorIterator.
 
@@ -13,8 +14,44 @@ static bool use_two_pass_reduction(TensorIterator& iter);
 static void two_pass_reduction(TensorIterator& iter, loop2d_t loop);
 static void parallel_dim_reduction(TensorIterator& iter, loop2d_t loop);
 
+// Two-pass reductions over several outputs are only used when the input has
+// at least this many elements per element of the per-thread buffers.
+constexpr int64_t kTwoPassInputPerBufferElement = 8;
+
+void TensorIterator::reorder_for_reduction() {
+  if (ndim() < 2 || ntensors() != 2 || !is_dim_reduced(0)) {
+    return;
+  }
+  auto out_strides = strides(0);
+  auto in_strides = strides(1);
+  int64_t out_size = element_size(0);
+  int64_t in_size = element_size(1);
+  auto is_contiguous_column = [&](int dim) {
+    return out_strides[dim] == out_size && in_strides[dim] == in_size;
+  };
+  // The inner loop already reduces a contiguous input, or the outer loop
+  // already walks contiguous columns of the input and output.
+  if (in_strides[0] == in_size || is_contiguous_column(1)) {
+    return;
+  }
+  // Otherwise (several reduced dims that don't coalesce, such as sum over
+  // dims 0 and 2 of an NCHW tensor) the loop over a column that is contiguous
+  // in both becomes the outer loop, so that the other reduced dims are
+  // iterated around it by serial_for_each.
+  for (int dim = 2; dim < ndim(); dim++) {
+    if (shape_[dim] > 1 && is_contiguous_column(dim)) {
+      DimVector perm(ndim());
+      std::iota(perm.begin(), perm.end(), 0);
+      std::rotate(perm.begin() + 1, perm.begin() + dim, perm.begin() + dim + 1);
+      permute_dimensions(perm);
+      return;
+    }
+  }
+}
+
 void TensorIterator::parallel_reduce(loop2d_t loop) {
   TORCH_CHECK(ntensors() == 2, "parallel_reduce only supports one input and one output");
+  reorder_for_reduction();
   int64_t numel = this->numel();
   if (numel < at::internal::GRAIN_SIZE || at::get_num_threads() == 1 ||
       at::in_parallel_region()) {
@@ -26,8 +63,20 @@ void TensorIterator::parallel_reduce(loop2d_t loop) {
   }
 }
 
+static int find_split_dim(TensorIterator& iter);
+
 static bool use_two_pass_reduction(TensorIterator& iter) {
-  return iter.output(0).numel() == 1;
+  if (iter.output(0).numel() == 1) {
+    return true;
+  }
+  // Splitting the outputs leaves threads idle when no output dimension has a
+  // column per thread, e.g. mean over H and W of an NCHW tensor with small N
+  // and C. Splitting the input instead costs a copy of the output per thread,
+  // which is worth it when these copies are small next to the input.
+  int num_threads = at::get_num_threads();
+  return iter.shape()[find_split_dim(iter)] < num_threads &&
+      iter.num_output_elements() * num_threads * kTwoPassInputPerBufferElement <=
+      iter.numel();
 }
 
 static void two_pass_reduction(TensorIterator& iter, loop2d_t loop) {
@@ -48,6 +97,7 @@ static void two_pass_reduction(TensorIterator& iter, loop2d_t loop) {
     slice.copy_(dst);
 
     auto sub_iter = TensorIterator::reduce_op(slice, iter.input(0));
+    sub_iter.reorder_for_reduction();
     sub_iter.serial_for_each(loop, {begin, end});
   });
 
@@ -60,26 +110,33 @@ static void two_pass_reduction(TensorIterator& iter, loop2d_t loop) {
 
   auto unsqueezed = dst.unsqueeze(0);
   auto final_reduce = TensorIterator::reduce_op(unsqueezed, buffer);
-  final_reduce.for_each(loop);
+  final_reduce.reorder_for_reduction();
+  // for_each() could split the buffer of an output between threads
+  final_reduce.serial_for_each(loop, {0, final_reduce.numel()});
 }
 
-/// Chooses a dimension over which to parallelize. Prefers the outer-most
-/// dimension thats larger than the number of available threads.
+/// Chooses a non-reduced dimension over which to parallelize. Prefers the
+/// outer-most dimension thats larger than the number of available threads.
+/// The non-reduced dimensions aren't necessarily the outer-most ones after
+/// reorder_for_reduction().
 static int find_split_dim(TensorIterator& iter) {
   int num_threads = at::get_num_threads();
   auto shape = iter.shape();
 
   // start with the outer-most dimension
-  int best_dim = iter.ndim() - 1;
-  for (int dim = best_dim; dim >= 0 && !iter.is_dim_reduced(dim); dim--) {
+  int best_dim = -1;
+  for (int dim = iter.ndim() - 1; dim >= 0; dim--) {
+    if (iter.is_dim_reduced(dim)) {
+      continue;
+    }
     if (shape[dim] >= num_threads) {
       return dim;
-    } else if (shape[dim] > shape[best_dim]) {
+    } else if (best_dim == -1 || shape[dim] > shape[best_dim]) {
       best_dim = dim;
     }
   }
 
-  AT_ASSERT(!iter.is_dim_reduced(best_dim));
+  AT_ASSERT(best_dim != -1);
   return best_dim;
 }
 
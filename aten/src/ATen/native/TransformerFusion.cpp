@@ -0,0 +1,131 @@
+#include <ATen/native/TransformerFusion.h>
+
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/core/grad_mode.h>
+
+namespace at {
+namespace native {
+
+// Note [Transformer fusion]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// The fused ops compute exactly what the graphs they replace compute, so the
+// FuseTransformerOps JIT pass can rewrite those graphs without knowing shapes
+// or devices:
+//
+//   _fused_bias_gelu(x, b)                 = gelu(x + b)
+//   _fused_add_layer_norm(x, r, ...)       = layer_norm(x + r, ...)
+//   _fused_bias_dropout_add(x, b, r, p, t) = dropout(x + b, p, t) + r
+//
+// They run a single CPU kernel, parallel over the rows of `x`, for float and
+// double tensors on the CPU whose bias is a vector over the last dimension of
+// `x` and whose residual has the shape of `x`, when no gradient is needed and
+// dropout is a no-op. Otherwise they run the unfused ops, so autograd, other
+// devices and dtypes, and broadcasting behave as before.
+
+namespace {
+
+bool requires_grad(const Tensor& t) {
+  return t.defined() && t.is_variable() && t.requires_grad();
+}
+
+bool use_fused_kernel(TensorList tensors) {
+  const auto dtype = tensors[0].scalar_type();
+  if (dtype != kFloat && dtype != kDouble) {
+    return false;
+  }
+  const bool grad_enabled = at::GradMode::is_enabled();
+  for (const auto& tensor : tensors) {
+    if (!tensor.defined()) {
+      continue;
+    }
+    if (!tensor.device().is_cpu() || tensor.layout() != kStrided ||
+        tensor.scalar_type() != dtype ||
+        (grad_enabled && requires_grad(tensor))) {
+      return false;
+    }
+  }
+  return tensors[0].numel() > 0;
+}
+
+bool is_row_vector(const Tensor& bias, const Tensor& self) {
+  return self.dim() >= 1 && bias.dim() == 1 && bias.size(0) == self.size(-1);
+}
+
+} // namespace
+
+Tensor _fused_bias_gelu(const Tensor& self, const Tensor& bias) {
+  if (!use_fused_kernel({self, bias}) || !is_row_vector(bias, self)) {
+    return at::gelu(self + bias);
+  }
+  const auto X = self.contiguous();
+  const int64_t N = X.size(-1);
+  Tensor Y = at::empty_like(X);
+  FusedBiasGeluKernel(kCPU, X, bias.contiguous(), X.numel() / N, N, &Y);
+  return Y;
+}
+
+Tensor _fused_add_layer_norm(
+    const Tensor& input,
+    const Tensor& residual,
+    IntArrayRef normalized_shape,
+    const Tensor& weight /* optional */,
+    const Tensor& bias /* optional */,
+    double eps) {
+  const int64_t normalized_ndim = normalized_shape.size();
+  const bool fusable = use_fused_kernel({input, residual, weight, bias}) &&
+      residual.sizes() == input.sizes() && normalized_ndim >= 1 &&
+      input.dim() >= normalized_ndim &&
+      input.sizes().slice(input.dim() - normalized_ndim) == normalized_shape &&
+      (!weight.defined() || weight.sizes() == normalized_shape) &&
+      (!bias.defined() || bias.sizes() == normalized_shape);
+  if (!fusable) {
+    return at::layer_norm(
+        input + residual, normalized_shape, weight, bias, eps);
+  }
+  const auto X = input.contiguous();
+  const auto R = residual.contiguous();
+  int64_t N = 1;
+  for (const auto size : normalized_shape) {
+    N *= size;
+  }
+  Tensor Y = at::empty_like(X);
+  FusedAddLayerNormKernel(
+      kCPU,
+      X,
+      R,
+      weight.defined() ? weight.contiguous() : weight,
+      bias.defined() ? bias.contiguous() : bias,
+      X.numel() / N,
+      N,
+      eps,
+      &Y);
+  return Y;
+}
+
+Tensor _fused_bias_dropout_add(
+    const Tensor& self,
+    const Tensor& bias,
+    const Tensor& residual,
+    double p,
+    bool train) {
+  const bool fusable = (!train || p == 0) &&
+      use_fused_kernel({self, bias, residual}) && is_row_vector(bias, self) &&
+      residual.sizes() == self.sizes();
+  if (!fusable) {
+    return at::dropout(self + bias, p, train) + residual;
+  }
+  const auto X = self.contiguous();
+  const int64_t N = X.size(-1);
+  Tensor Y = at::empty_like(X);
+  FusedBiasAddKernel(
+      kCPU, X, bias.contiguous(), residual.contiguous(), X.numel() / N, N, &Y);
+  return Y;
+}
+
+DEFINE_DISPATCH(FusedBiasGeluKernel);
+DEFINE_DISPATCH(FusedAddLayerNormKernel);
+DEFINE_DISPATCH(FusedBiasAddKernel);
+
+} // namespace native
+} // namespace at
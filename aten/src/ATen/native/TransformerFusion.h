@@ -0,0 +1,42 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at {
+namespace native {
+
+// Kernels of the fused ops of transformer layers, see Note [Transformer
+// fusion]. X, the residual and Y are contiguous M x N matrices, bias, gamma
+// and beta contiguous vectors of size N, and all have the same dtype.
+using bias_gelu_fn = void (*)(
+    const Tensor& /* X */,
+    const Tensor& /* bias */,
+    int64_t /* M */,
+    int64_t /* N */,
+    Tensor* /* Y */);
+
+using add_layer_norm_fn = void (*)(
+    const Tensor& /* X */,
+    const Tensor& /* residual */,
+    const Tensor& /* gamma */,
+    const Tensor& /* beta */,
+    int64_t /* M */,
+    int64_t /* N */,
+    double /* eps */,
+    Tensor* /* Y */);
+
+using bias_add_fn = void (*)(
+    const Tensor& /* X */,
+    const Tensor& /* bias */,
+    const Tensor& /* residual */,
+    int64_t /* M */,
+    int64_t /* N */,
+    Tensor* /* Y */);
+
+DECLARE_DISPATCH(bias_gelu_fn, FusedBiasGeluKernel);
+DECLARE_DISPATCH(add_layer_norm_fn, FusedAddLayerNormKernel);
+DECLARE_DISPATCH(bias_add_fn, FusedBiasAddKernel);
+
+} // namespace native
+} // namespace at
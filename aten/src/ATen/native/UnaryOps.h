@@ -55,9 +55,14 @@ DECLARE_DISPATCH(unary_fn, trunc_stub);
 DECLARE_DISPATCH(unary_fn, lgamma_stub);
 
 DECLARE_DISPATCH(void(*)(Tensor&, const double, Generator *), bernoulli_mkl_stub);
+// See Note [Philox mode of CPUGenerator]
+DECLARE_DISPATCH(void(*)(Tensor&, const double, const double, Generator *), uniform_philox_stub);
+DECLARE_DISPATCH(void(*)(Tensor&, const double, const double, Generator *), normal_philox_stub);
+DECLARE_DISPATCH(void(*)(Tensor&, const double, Generator *), bernoulli_philox_stub);
 DECLARE_DISPATCH(void(*)(TensorIterator&, const int64_t), polygamma_stub);
 DECLARE_DISPATCH(void(*)(TensorIterator&, Scalar a, Scalar b), clamp_stub);
 DECLARE_DISPATCH(void(*)(Tensor&, const Tensor&, int64_t, bool, Generator *), multinomial_stub);
+DECLARE_DISPATCH(void(*)(Tensor&, const Tensor&, const Tensor&, Generator *), multinomial_alias_draw_stub);
 
 // Missing unary functions
 // digamma
@@ -2,17 +2,274 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <c10/util/flat_hash_map.h>
 
+#include <algorithm>
+#include <functional>
+#include <numeric>
 #include <set>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace at {
 namespace native{
 
 namespace {
 
+// Inputs from this size on are deduplicated in parallel, by
+// unique_cpu_parallel and unique_consecutive_cpu_parallel.
+constexpr int64_t kUniqueParallelMinNumel = 1 << 16;
+
+// The number of elements one task of the parallel versions goes over.
+constexpr int64_t kUniqueChunk = 1 << 14;
+
+// unique_cpu_parallel splits the values into partitions by their hash and
+// deduplicates each partition in a hash table of its own. The partitions are
+// fixed, so the output doesn't depend on the number of threads.
+constexpr int kUniquePartitionBits = 6;
+constexpr int64_t kUniquePartitions = 1 << kUniquePartitionBits;
+
+template <typename scalar_t>
+bool use_unique_cpu_parallel(const Tensor& input) {
+  return !std::is_same<scalar_t, bool>::value &&
+      input.numel() >= kUniqueParallelMinNumel && at::get_num_threads() > 1;
+}
+
+template <typename scalar_t>
+uint8_t unique_partition(const scalar_t& value) {
+  // std::hash of an integer is usually the integer itself, so the bits are
+  // mixed before the top ones are taken. Hashing with std::hash keeps the
+  // values that compare equal, like 0.0 and -0.0, in the same partition.
+  const uint64_t hash = static_cast<uint64_t>(std::hash<scalar_t>()(value)) * 0x9E3779B97F4A7C15ULL;
+  return static_cast<uint8_t>(hash >> (64 - kUniquePartitionBits));
+}
+
+// The element indices are bucketed by partition, each partition is
+// deduplicated by one thread, in the order of first appearance, and the
+// partitions are concatenated. With sorted, the partitions are sorted in
+// parallel and merged pairwise. Matches unique_cpu_template up to the order
+// of the output when it isn't sorted.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> unique_cpu_parallel(
+    const Tensor& input,
+    const bool sorted,
+    const bool return_inverse,
+    const bool return_counts) {
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const int64_t numel = input.numel();
+  const int64_t chunks = (numel + kUniqueChunk - 1) / kUniqueChunk;
+  const bool need_inverse = return_inverse || return_counts;
+
+  // The partition of every element and, per chunk, where its elements of
+  // each partition go in order, partition-major.
+  std::vector<uint8_t> partition(numel);
+  std::vector<int64_t> chunk_offsets(chunks * kUniquePartitions, 0);
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t* histogram = chunk_offsets.data() + c * kUniquePartitions;
+      for (int64_t i = c * kUniqueChunk; i < std::min(numel, (c + 1) * kUniqueChunk); i++) {
+        partition[i] = unique_partition(input_data[i]);
+        histogram[partition[i]]++;
+      }
+    }
+  });
+  std::vector<int64_t> partition_begin(kUniquePartitions + 1);
+  int64_t offset = 0;
+  for (int64_t p = 0; p < kUniquePartitions; p++) {
+    partition_begin[p] = offset;
+    for (int64_t c = 0; c < chunks; c++) {
+      const int64_t count = chunk_offsets[c * kUniquePartitions + p];
+      chunk_offsets[c * kUniquePartitions + p] = offset;
+      offset += count;
+    }
+  }
+  partition_begin[kUniquePartitions] = numel;
+
+  std::vector<int64_t> order(numel);
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t* next = chunk_offsets.data() + c * kUniquePartitions;
+      for (int64_t i = c * kUniqueChunk; i < std::min(numel, (c + 1) * kUniqueChunk); i++) {
+        order[next[partition[i]]++] = i;
+      }
+    }
+  });
+
+  // Deduplicate the partitions. Until the ids are made global, the inverse
+  // holds the id of every element within its partition.
+  Tensor inverse_indices = at::empty({0}, input.options().dtype(kLong));
+  int64_t* inverse_data = nullptr;
+  if (need_inverse) {
+    inverse_indices.resize_(input.sizes());
+    inverse_data = inverse_indices.data_ptr<int64_t>();
+  }
+  std::vector<std::vector<scalar_t>> values(kUniquePartitions);
+  std::vector<std::vector<int64_t>> value_counts(kUniquePartitions);
+  at::parallel_for(0, kUniquePartitions, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t p = begin; p < end; p++) {
+      ska::flat_hash_map<scalar_t, int64_t> ids;
+      for (int64_t k = partition_begin[p]; k < partition_begin[p + 1]; k++) {
+        const int64_t i = order[k];
+        auto it = ids.find(input_data[i]);
+        int64_t id;
+        if (it == ids.end()) {
+          id = values[p].size();
+          ids.emplace(input_data[i], id);
+          values[p].push_back(input_data[i]);
+          value_counts[p].push_back(0);
+        } else {
+          id = it->second;
+        }
+        value_counts[p][id]++;
+        if (need_inverse) {
+          inverse_data[i] = id;
+        }
+      }
+    }
+  });
+
+  std::vector<int64_t> unique_begin(kUniquePartitions + 1, 0);
+  for (int64_t p = 0; p < kUniquePartitions; p++) {
+    unique_begin[p + 1] = unique_begin[p] + values[p].size();
+  }
+  const int64_t num_unique = unique_begin[kUniquePartitions];
+  Tensor output = at::empty({num_unique}, input.options());
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+
+  // rank[g] is where the g-th value of the concatenated partitions goes.
+  std::vector<int64_t> rank;
+  if (sorted) {
+    using entry_t = std::pair<scalar_t, int64_t>;
+    auto less = [](const entry_t& a, const entry_t& b) { return a.first < b.first; };
+    std::vector<entry_t> entries(num_unique);
+    at::parallel_for(0, kUniquePartitions, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t p = begin; p < end; p++) {
+        for (size_t j = 0; j < values[p].size(); j++) {
+          entries[unique_begin[p] + j] = entry_t(values[p][j], unique_begin[p] + j);
+        }
+        std::sort(entries.begin() + unique_begin[p], entries.begin() + unique_begin[p + 1], less);
+      }
+    });
+    for (int64_t width = 1; width < kUniquePartitions; width *= 2) {
+      at::parallel_for(0, kUniquePartitions / (2 * width), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t pair = begin; pair < end; pair++) {
+          const int64_t p = 2 * width * pair;
+          std::inplace_merge(entries.begin() + unique_begin[p],
+                             entries.begin() + unique_begin[p + width],
+                             entries.begin() + unique_begin[p + 2 * width], less);
+        }
+      });
+    }
+    rank.resize(num_unique);
+    at::parallel_for(0, num_unique, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t j = begin; j < end; j++) {
+        output_data[j] = entries[j].first;
+        rank[entries[j].second] = j;
+      }
+    });
+  } else {
+    at::parallel_for(0, kUniquePartitions, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t p = begin; p < end; p++) {
+        std::copy(values[p].begin(), values[p].end(), output_data + unique_begin[p]);
+      }
+    });
+  }
+  auto global_id = [&](int64_t p, int64_t id) {
+    return sorted ? rank[unique_begin[p] + id] : unique_begin[p] + id;
+  };
+
+  if (need_inverse) {
+    at::parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        inverse_data[i] = global_id(partition[i], inverse_data[i]);
+      }
+    });
+  }
+  Tensor counts = at::empty({0}, input.options().dtype(kLong));
+  if (return_counts) {
+    counts.resize_({num_unique});
+    int64_t* counts_data = counts.data_ptr<int64_t>();
+    at::parallel_for(0, kUniquePartitions, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t p = begin; p < end; p++) {
+        for (size_t j = 0; j < value_counts[p].size(); j++) {
+          counts_data[global_id(p, j)] = value_counts[p][j];
+        }
+      }
+    });
+  }
+  return std::make_tuple(output, inverse_indices, counts);
+}
+
+// Each chunk counts the runs that start in it, and then writes them from
+// the total of the chunks before.
+template <typename scalar_t>
+std::tuple<Tensor, Tensor, Tensor> unique_consecutive_cpu_parallel(
+    const Tensor& input,
+    const bool return_inverse,
+    const bool return_counts) {
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const int64_t numel = input.numel();
+  const int64_t chunks = (numel + kUniqueChunk - 1) / kUniqueChunk;
+  auto starts_run = [&](int64_t i) {
+    return i == 0 || input_data[i] != input_data[i - 1];
+  };
+
+  std::vector<int64_t> chunk_begin(chunks + 1, 0);
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t runs = 0;
+      for (int64_t i = c * kUniqueChunk; i < std::min(numel, (c + 1) * kUniqueChunk); i++) {
+        runs += starts_run(i);
+      }
+      chunk_begin[c + 1] = runs;
+    }
+  });
+  std::partial_sum(chunk_begin.begin(), chunk_begin.end(), chunk_begin.begin());
+  const int64_t num_unique = chunk_begin[chunks];
+
+  Tensor output = at::empty({num_unique}, input.options());
+  Tensor inverse_indices = at::empty({0}, input.options().dtype(kLong));
+  Tensor counts = at::empty({0}, input.options().dtype(kLong));
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  int64_t* inverse_data = nullptr;
+  if (return_inverse) {
+    inverse_indices.resize_(input.sizes());
+    inverse_data = inverse_indices.data_ptr<int64_t>();
+  }
+  std::vector<int64_t> run_begin(return_counts ? num_unique + 1 : 0);
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t run = chunk_begin[c] - 1;
+      for (int64_t i = c * kUniqueChunk; i < std::min(numel, (c + 1) * kUniqueChunk); i++) {
+        if (starts_run(i)) {
+          output_data[++run] = input_data[i];
+          if (return_counts) {
+            run_begin[run] = i;
+          }
+        }
+        if (return_inverse) {
+          inverse_data[i] = run;
+        }
+      }
+    }
+  });
+  if (return_counts) {
+    run_begin[num_unique] = numel;
+    counts.resize_({num_unique});
+    int64_t* counts_data = counts.data_ptr<int64_t>();
+    at::parallel_for(0, num_unique, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+      for (int64_t k = begin; k < end; k++) {
+        counts_data[k] = run_begin[k + 1] - run_begin[k];
+      }
+    });
+  }
+  return std::make_tuple(output, inverse_indices, counts);
+}
+
 template <typename scalar_t>
 std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
     const Tensor& self,
@@ -20,6 +277,9 @@ std::tuple<Tensor, Tensor, Tensor> unique_cpu_template(
     const bool return_inverse,
     const bool return_counts) {
   const Tensor& input = self.contiguous();
+  if (use_unique_cpu_parallel<scalar_t>(input)) {
+    return unique_cpu_parallel<scalar_t>(input, sorted, return_inverse, return_counts);
+  }
   const scalar_t* input_data = input.data_ptr<scalar_t>();
   int64_t numel = input.numel();
   Tensor output;
@@ -75,6 +335,9 @@ std::tuple<Tensor, Tensor, Tensor> unique_consecutive_cpu_template(
     const bool return_inverse,
     const bool return_counts) {
   const Tensor& input = self.contiguous();
+  if (use_unique_cpu_parallel<scalar_t>(input)) {
+    return unique_consecutive_cpu_parallel<scalar_t>(input, return_inverse, return_counts);
+  }
   const scalar_t* input_data = input.data_ptr<scalar_t>();
   int64_t numel = input.numel();
   Tensor output = at::empty({numel}, input.options());
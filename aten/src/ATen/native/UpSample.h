@@ -1,11 +1,23 @@
+#pragma once
+
 #include <math.h>
 
 #include <ATen/ATen.h>
 #include <ATen/TensorUtils.h>
+#include <ATen/native/DispatchStub.h>
 
 namespace at {
 namespace native {
 
+// The CPU kernels of the backward of the 2d upsampling ops, in
+// cpu/UpSampleKernel.cpp. They take a zeroed grad_input of the size of the
+// input and a contiguous grad_output.
+using upsample_nearest2d_backward_fn = void(*)(Tensor& grad_input, const Tensor& grad_output);
+using upsample_linear2d_backward_fn = void(*)(Tensor& grad_input, const Tensor& grad_output, bool align_corners);
+DECLARE_DISPATCH(upsample_nearest2d_backward_fn, upsample_nearest2d_backward_kernel);
+DECLARE_DISPATCH(upsample_linear2d_backward_fn, upsample_bilinear2d_backward_kernel);
+DECLARE_DISPATCH(upsample_linear2d_backward_fn, upsample_bicubic2d_backward_kernel);
+
 static inline void upsample_1d_shape_check(
     const Tensor& input,
     const Tensor& grad_output,
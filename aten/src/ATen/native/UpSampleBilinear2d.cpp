@@ -81,79 +81,6 @@ static void upsample_bilinear2d_out_frame(
   }
 }
 
-template <typename scalar_t>
-static void upsample_bilinear2d_backward_out_frame(
-    scalar_t* odata,
-    scalar_t* idata,
-    int64_t input_height,
-    int64_t input_width,
-    int64_t output_height,
-    int64_t output_width,
-    int64_t nbatch,
-    int64_t channels,
-    bool align_corners) {
-  channels = channels * nbatch;
-
-  // special case: same-size matching grids
-  if (input_height == output_height && input_width == output_width) {
-    for (int64_t h2 = 0; h2 < output_height; ++h2) {
-      const int64_t h1 = h2;
-      for (int64_t w2 = 0; w2 < output_width; ++w2) {
-        const int64_t w1 = w2;
-        scalar_t* pos1 = &idata[h1 * input_width + w1];
-        const scalar_t* pos2 = &odata[h2 * output_width + w2];
-
-        for (int64_t c = 0; c < channels; ++c) {
-          pos1[0] += pos2[0];
-          pos1 += input_width * input_height;
-          pos2 += output_width * output_height;
-        }
-      }
-    }
-    return;
-  }
-
-  const scalar_t rheight = area_pixel_compute_scale<scalar_t>(
-      input_height, output_height, align_corners);
-  const scalar_t rwidth = area_pixel_compute_scale<scalar_t>(
-      input_width, output_width, align_corners);
-
-  for (int64_t h2 = 0; h2 < output_height; ++h2) {
-    const scalar_t h1r = area_pixel_compute_source_index<scalar_t>(
-        rheight, h2, align_corners, /*cubic=*/false);
-
-    const int64_t h1 = h1r;
-    const int64_t h1p = (h1 < input_height - 1) ? 1 : 0;
-
-    const scalar_t h1lambda = h1r - h1;
-    const scalar_t h0lambda = static_cast<scalar_t>(1.) - h1lambda;
-
-    for (int64_t w2 = 0; w2 < output_width; ++w2) {
-      const scalar_t w1r = area_pixel_compute_source_index<scalar_t>(
-          rwidth, w2, align_corners, /*cubic=*/false);
-
-      const int64_t w1 = w1r;
-      const int64_t w1p = (w1 < input_width - 1) ? 1 : 0;
-
-      const scalar_t w1lambda = w1r - w1;
-      const scalar_t w0lambda = static_cast<scalar_t>(1.) - w1lambda;
-
-      scalar_t* pos1 = &idata[h1 * input_width + w1];
-
-      const scalar_t* pos2 = &odata[h2 * output_width + w2];
-
-      for (int64_t c = 0; c < channels; ++c) {
-        pos1[0] += h0lambda * w0lambda * pos2[0];
-        pos1[w1p] += h0lambda * w1lambda * pos2[0];
-        pos1[h1p * input_width] += h1lambda * w0lambda * pos2[0];
-        pos1[h1p * input_width + w1p] += h1lambda * w1lambda * pos2[0];
-        pos1 += input_width * input_height;
-        pos2 += output_width * output_height;
-      }
-    }
-  }
-}
-
 static void upsample_bilinear2d_out_cpu_template(
     Tensor& output,
     const Tensor& input_,
@@ -247,22 +174,7 @@ static void upsample_bilinear2d_backward_out_cpu_template(
   grad_input.resize_({nbatch, channels, input_height, input_width});
   grad_input.zero_();
 
-  AT_DISPATCH_FLOATING_TYPES_AND_HALF(
-      grad_output.scalar_type(), "upsample_bilinear2d_backward", [&] {
-        scalar_t* idata = grad_input.data_ptr<scalar_t>();
-        scalar_t* odata = grad_output.data_ptr<scalar_t>();
-
-        upsample_bilinear2d_backward_out_frame<scalar_t>(
-            odata,
-            idata,
-            input_height,
-            input_width,
-            output_height,
-            output_width,
-            nbatch,
-            channels,
-            align_corners);
-      });
+  upsample_bilinear2d_backward_kernel(kCPU, grad_input, grad_output, align_corners);
 }
 } // namespace
 
@@ -308,5 +220,7 @@ Tensor upsample_bilinear2d_backward_cpu(
   return grad_input;
 }
 
+DEFINE_DISPATCH(upsample_bilinear2d_backward_kernel);
+
 } // namespace native
 } // namespace at
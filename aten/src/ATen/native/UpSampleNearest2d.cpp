@@ -61,60 +61,6 @@ static void upsample_nearest2d_out_frame(
   }
 }
 
-template <typename scalar_t>
-static void upsample_nearest2d_backward_out_frame(
-    scalar_t* odata,
-    scalar_t* idata,
-    int64_t input_height,
-    int64_t input_width,
-    int64_t output_height,
-    int64_t output_width,
-    int64_t nbatch,
-    int64_t channels) {
-  const float height_scale = (float)input_height / (float)output_height;
-  const float width_scale = (float)input_width / (float)output_width;
-
-  channels = channels * nbatch;
-
-  // special case: just copy
-  if (input_height == output_height && input_width == output_width) {
-    for (int64_t h2 = 0; h2 < output_height; ++h2) {
-      const int64_t h1 = h2;
-
-      for (int64_t w2 = 0; w2 < output_width; ++w2) {
-        const int64_t w1 = w2;
-        scalar_t* pos1 = &idata[h1 * input_width + w1];
-        const scalar_t* pos2 = &odata[h2 * output_width + w2];
-
-        for (int64_t c = 0; c < channels; ++c) {
-          pos1[0] = pos2[0];
-          pos1 += input_height * input_width;
-          pos2 += output_height * output_width;
-        }
-      }
-    }
-    return;
-  }
-
-  for (int64_t h2 = 0; h2 < output_height; ++h2) {
-    const int64_t h1 =
-        nearest_neighbor_compute_source_index(height_scale, h2, input_height);
-
-    for (int64_t w2 = 0; w2 < output_width; ++w2) {
-      const int64_t w1 =
-          nearest_neighbor_compute_source_index(width_scale, w2, input_width);
-      scalar_t* pos1 = &idata[h1 * input_width + w1];
-      const scalar_t* pos2 = &odata[h2 * output_width + w2];
-
-      for (int64_t c = 0; c < channels; ++c) {
-        pos1[0] += pos2[0];
-        pos1 += input_height * input_width;
-        pos2 += output_height * output_width;
-      }
-    }
-  }
-}
-
 static void upsample_nearest2d_out_cpu_template(
     Tensor& output,
     const Tensor& input_,
@@ -203,21 +149,7 @@ static void upsample_nearest2d_backward_out_cpu_template(
 
   auto grad_output = grad_output_.contiguous();
 
-  AT_DISPATCH_FLOATING_TYPES_AND_HALF(
-      grad_output.scalar_type(), "upsample_nearest2d_backward", [&] {
-        scalar_t* idata = grad_input.data_ptr<scalar_t>();
-        scalar_t* odata = grad_output.data_ptr<scalar_t>();
-
-        upsample_nearest2d_backward_out_frame<scalar_t>(
-            odata,
-            idata,
-            input_height,
-            input_width,
-            output_height,
-            output_width,
-            nbatch,
-            channels);
-      });
+  upsample_nearest2d_backward_kernel(kCPU, grad_input, grad_output);
 }
 } // namespace
 
@@ -255,5 +187,7 @@ Tensor upsample_nearest2d_backward_cpu(
   return grad_input;
 }
 
+DEFINE_DISPATCH(upsample_nearest2d_backward_kernel);
+
 } // namespace native
 } // namespace at
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+namespace at {
+namespace native {
+
+// Computes the mean of every channel (dim 1) of the input, and the sum of the
+// squared differences from that mean, in a single pass.
+using batch_norm_collect_stats_fn = void (*)(
+    const Tensor& /* input */,
+    Tensor* /* mean */,
+    Tensor* /* var_sum */);
+
+DECLARE_DISPATCH(batch_norm_collect_stats_fn, BatchNormCollectStatsKernel);
+
+} // namespace native
+} // namespace at
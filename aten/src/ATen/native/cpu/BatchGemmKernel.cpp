@@ -0,0 +1,105 @@
+#include <ATen/native/BatchGemm.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+
+namespace at { namespace native {
+namespace {
+
+using namespace vec256;
+
+// Computes kRows rows of a block of up to Vec::size() columns of one
+// result matrix, keeping the kRows accumulators in registers over the whole
+// contraction: every row of b is loaded once per block of kRows rows.
+template <typename scalar_t, int kRows>
+inline void gemm_block(
+    scalar_t* c, int64_t ldc,
+    const scalar_t* a, int64_t a_row_stride, int64_t a_col_stride,
+    const scalar_t* b, int64_t ldb,
+    int64_t k, int64_t n, scalar_t alpha, scalar_t beta) {
+  using Vec = Vec256<scalar_t>;
+  Vec acc[kRows];
+  for (int r = 0; r < kRows; r++) {
+    acc[r] = Vec(0);
+  }
+  for (int64_t l = 0; l < k; l++) {
+    const Vec b_vec = n == Vec::size() ? Vec::loadu(b + l * ldb)
+                                       : Vec::loadu(b + l * ldb, n);
+    for (int r = 0; r < kRows; r++) {
+      acc[r] = fmadd(Vec(a[r * a_row_stride + l * a_col_stride]), b_vec, acc[r]);
+    }
+  }
+  for (int r = 0; r < kRows; r++) {
+    Vec out = acc[r] * Vec(alpha);
+    if (beta != scalar_t(0)) {
+      const Vec c_vec = n == Vec::size() ? Vec::loadu(c + r * ldc)
+                                         : Vec::loadu(c + r * ldc, n);
+      out = fmadd(c_vec, Vec(beta), out);
+    }
+    if (n == Vec::size()) {
+      out.store(c + r * ldc);
+    } else {
+      out.store(c + r * ldc, n);
+    }
+  }
+}
+
+template <typename scalar_t>
+void gemm_small(
+    scalar_t* c, int64_t ldc,
+    const scalar_t* a, int64_t a_row_stride, int64_t a_col_stride,
+    const scalar_t* b, int64_t ldb,
+    int64_t m, int64_t k, int64_t n, scalar_t alpha, scalar_t beta) {
+  using Vec = Vec256<scalar_t>;
+  constexpr int kRows = 4;
+  for (int64_t j = 0; j < n; j += Vec::size()) {
+    const int64_t cols = std::min<int64_t>(Vec::size(), n - j);
+    int64_t i = 0;
+    for (; i + kRows <= m; i += kRows) {
+      gemm_block<scalar_t, kRows>(
+          c + i * ldc + j, ldc, a + i * a_row_stride, a_row_stride,
+          a_col_stride, b + j, ldb, k, cols, alpha, beta);
+    }
+    for (; i < m; i++) {
+      gemm_block<scalar_t, 1>(
+          c + i * ldc + j, ldc, a + i * a_row_stride, a_row_stride,
+          a_col_stride, b + j, ldb, k, cols, alpha, beta);
+    }
+  }
+}
+
+void baddbmm_small_kernel(
+    const Tensor& result, const Tensor& batch1, const Tensor& batch2,
+    Scalar beta_, Scalar alpha_) {
+  const int64_t bs = result.size(0);
+  const int64_t m = result.size(1);
+  const int64_t n = result.size(2);
+  const int64_t k = batch1.size(2);
+  const int64_t grain_size =
+      std::max<int64_t>(internal::GRAIN_SIZE / std::max<int64_t>(m * n * k, 1), 1);
+  AT_DISPATCH_FLOATING_TYPES(result.scalar_type(), "baddbmm_small", [&] {
+    const scalar_t alpha = alpha_.to<scalar_t>();
+    const scalar_t beta = beta_.to<scalar_t>();
+    scalar_t* c = result.data_ptr<scalar_t>();
+    const scalar_t* a = batch1.data_ptr<scalar_t>();
+    const scalar_t* b = batch2.data_ptr<scalar_t>();
+    parallel_for(0, bs, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t batch = begin; batch < end; batch++) {
+        gemm_small<scalar_t>(
+            c + batch * result.stride(0), result.stride(1),
+            a + batch * batch1.stride(0), batch1.stride(1), batch1.stride(2),
+            b + batch * batch2.stride(0), batch2.stride(1),
+            m, k, n, alpha, beta);
+      }
+    });
+  });
+}
+
+} // namespace
+
+REGISTER_DISPATCH(baddbmm_small_stub, &baddbmm_small_kernel);
+
+}} // namespace at::native
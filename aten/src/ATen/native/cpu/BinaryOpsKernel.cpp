@@ -4,6 +4,7 @@
 #include <ATen/Parallel.h>
 #include <ATen/cpu/vec256/vec256.h>
 #include <ATen/cpu/vec256/functional.h>
+#include <ATen/cpu/vec512/vec512.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/BinaryOps.h>
 #include <ATen/native/cpu/Loops.h>
@@ -22,10 +23,10 @@ void add_kernel(TensorIterator& iter, Scalar alpha_scalar) {
   } else {
     AT_DISPATCH_ALL_TYPES_AND_COMPLEX_AND(kBFloat16, iter.dtype(), "add_cpu/sub_cpu", [&]() {
       auto alpha = alpha_scalar.to<scalar_t>();
-      auto alpha_vec = Vec256<scalar_t>(alpha);
+      auto alpha_vec = Vectorized<scalar_t>(alpha);
       cpu_kernel_vec(iter,
         [=](scalar_t a, scalar_t b) -> scalar_t { return a + alpha * b; },
-        [=](Vec256<scalar_t> a, Vec256<scalar_t> b) {
+        [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) {
           return vec256::fmadd(b, alpha_vec, a);
         });
       });
@@ -54,7 +55,7 @@ void mul_kernel(TensorIterator& iter) {
     AT_DISPATCH_ALL_TYPES_AND_COMPLEX_AND(kBFloat16, iter.dtype(), "mul_cpu", [&]() {
       cpu_kernel_vec(iter,
         [=](scalar_t a, scalar_t b) -> scalar_t { return a * b; },
-        [=](Vec256<scalar_t> a, Vec256<scalar_t> b) {
+        [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) {
           return a * b;
         });
     });
@@ -86,7 +87,7 @@ void div_kernel(TensorIterator& iter) {
         [=](scalar_t a, scalar_t b) __ubsan_ignore_float_divide_by_zero__ -> scalar_t {
            return a / b;
         },
-        [=](Vec256<scalar_t> a, Vec256<scalar_t> b) {
+        [=](Vectorized<scalar_t> a, Vectorized<scalar_t> b) {
           return a / b;
         });
     });
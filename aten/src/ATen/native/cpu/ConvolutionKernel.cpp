@@ -0,0 +1,400 @@
+#include <ATen/native/cpu/ConvolutionKernel.h>
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+
+namespace at {
+namespace native {
+namespace {
+
+// The working set of a block of tiles (or of output rows, for the implicit
+// GEMM) is kept around this size, so that it stays in the cache between the
+// transforms and the GEMMs that consume them.
+constexpr int64_t kBlockBytes = 512 * 1024;
+
+// Winograd transforms F(m x m, 3 x 3), from Lavin & Gray, "Fast Algorithms
+// for Convolutional Neural Networks": Y = A^T [(G g G^T) . (B^T d B)] A for
+// an alpha x alpha input tile d, alpha = m + 2.
+template <int m>
+struct Winograd;
+
+template <>
+struct Winograd<2> {
+  static constexpr int alpha = 4;
+  static constexpr float BT[4][4] = {
+      {1, 0, -1, 0},
+      {0, 1, 1, 0},
+      {0, -1, 1, 0},
+      {0, 1, 0, -1}};
+  static constexpr float G[4][3] = {
+      {1, 0, 0},
+      {0.5f, 0.5f, 0.5f},
+      {0.5f, -0.5f, 0.5f},
+      {0, 0, 1}};
+  static constexpr float AT[2][4] = {
+      {1, 1, 1, 0},
+      {0, 1, -1, -1}};
+};
+
+constexpr float Winograd<2>::BT[4][4];
+constexpr float Winograd<2>::G[4][3];
+constexpr float Winograd<2>::AT[2][4];
+
+template <>
+struct Winograd<4> {
+  static constexpr int alpha = 6;
+  static constexpr float BT[6][6] = {
+      {4, 0, -5, 0, 1, 0},
+      {0, -4, -4, 1, 1, 0},
+      {0, 4, -4, -1, 1, 0},
+      {0, -2, -1, 2, 1, 0},
+      {0, 2, -1, -2, 1, 0},
+      {0, 4, 0, -5, 0, 1}};
+  static constexpr float G[6][3] = {
+      {1.f / 4, 0, 0},
+      {-1.f / 6, -1.f / 6, -1.f / 6},
+      {-1.f / 6, 1.f / 6, -1.f / 6},
+      {1.f / 24, 1.f / 12, 1.f / 6},
+      {1.f / 24, -1.f / 12, 1.f / 6},
+      {0, 0, 1}};
+  static constexpr float AT[4][6] = {
+      {1, 1, 1, 1, 1, 0},
+      {0, 1, -1, 2, -2, 0},
+      {0, 1, 1, 4, 4, 0},
+      {0, 1, -1, 8, -8, 1}};
+};
+
+constexpr float Winograd<4>::BT[6][6];
+constexpr float Winograd<4>::G[6][3];
+constexpr float Winograd<4>::AT[4][6];
+
+// u = G g G^T, for a 3x3 filter g.
+template <int m>
+void winograd_transform_weight(const float* g, float* u) {
+  using W = Winograd<m>;
+  constexpr int alpha = W::alpha;
+  float tmp[alpha][3];
+  for (int i = 0; i < alpha; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      tmp[i][j] = W::G[i][0] * g[j] + W::G[i][1] * g[3 + j] + W::G[i][2] * g[6 + j];
+    }
+  }
+  for (int i = 0; i < alpha; ++i) {
+    for (int j = 0; j < alpha; ++j) {
+      u[i * alpha + j] = tmp[i][0] * W::G[j][0] + tmp[i][1] * W::G[j][1] + tmp[i][2] * W::G[j][2];
+    }
+  }
+}
+
+// v = B^T d B
+template <int m>
+void winograd_transform_input(
+    const float (&d)[Winograd<m>::alpha][Winograd<m>::alpha],
+    float (&v)[Winograd<m>::alpha][Winograd<m>::alpha]) {
+  using W = Winograd<m>;
+  constexpr int alpha = W::alpha;
+  float tmp[alpha][alpha];
+  for (int i = 0; i < alpha; ++i) {
+    for (int j = 0; j < alpha; ++j) {
+      float sum = 0;
+      for (int k = 0; k < alpha; ++k) {
+        sum += W::BT[i][k] * d[k][j];
+      }
+      tmp[i][j] = sum;
+    }
+  }
+  for (int i = 0; i < alpha; ++i) {
+    for (int j = 0; j < alpha; ++j) {
+      float sum = 0;
+      for (int k = 0; k < alpha; ++k) {
+        sum += tmp[i][k] * W::BT[j][k];
+      }
+      v[i][j] = sum;
+    }
+  }
+}
+
+// y = A^T x A
+template <int m>
+void winograd_transform_output(
+    const float (&x)[Winograd<m>::alpha][Winograd<m>::alpha],
+    float (&y)[m][m]) {
+  using W = Winograd<m>;
+  constexpr int alpha = W::alpha;
+  float tmp[m][alpha];
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < alpha; ++j) {
+      float sum = 0;
+      for (int k = 0; k < alpha; ++k) {
+        sum += W::AT[i][k] * x[k][j];
+      }
+      tmp[i][j] = sum;
+    }
+  }
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < m; ++j) {
+      float sum = 0;
+      for (int k = 0; k < alpha; ++k) {
+        sum += tmp[i][k] * W::AT[j][k];
+      }
+      y[i][j] = sum;
+    }
+  }
+}
+
+// The output is computed in blocks of output tiles per sample. For each block,
+// the transformed input tiles of all channels are gathered into V, of shape
+// (alpha * alpha, channels, tiles). The elementwise products with the
+// transformed filters U then become alpha * alpha independent GEMMs,
+// (out_channels, channels) x (channels, tiles), done as one bmm, whose results
+// are transformed back into the output.
+template <int m>
+Tensor winograd3x3(
+    const Tensor& input_,
+    const Tensor& weight_,
+    const Tensor& bias,
+    IntArrayRef padding) {
+  constexpr int alpha = Winograd<m>::alpha;
+  constexpr int tile_elements = alpha * alpha;
+  const Tensor input = input_.contiguous();
+  const Tensor weight = weight_.contiguous();
+
+  const int64_t batch = input.size(0);
+  const int64_t channels = input.size(1);
+  const int64_t in_h = input.size(2);
+  const int64_t in_w = input.size(3);
+  const int64_t out_channels = weight.size(0);
+  const int64_t pad_h = padding[0];
+  const int64_t pad_w = padding[1];
+  const int64_t out_h = in_h + 2 * pad_h - 2;
+  const int64_t out_w = in_w + 2 * pad_w - 2;
+
+  Tensor output = at::empty({batch, out_channels, out_h, out_w}, input.options());
+  if (output.numel() == 0) {
+    return output;
+  }
+
+  // U: (alpha * alpha, out_channels, channels)
+  Tensor transformed_weight =
+      at::empty({tile_elements, out_channels, channels}, input.options());
+  {
+    const float* w = weight.data_ptr<float>();
+    float* u = transformed_weight.data_ptr<float>();
+    const int64_t filters = out_channels * channels;
+    at::parallel_for(0, filters, 0, [&](int64_t begin, int64_t end) {
+      float tile[tile_elements];
+      for (int64_t f = begin; f < end; ++f) {
+        winograd_transform_weight<m>(w + f * 9, tile);
+        for (int e = 0; e < tile_elements; ++e) {
+          u[e * filters + f] = tile[e];
+        }
+      }
+    });
+  }
+
+  const int64_t tiles_w = (out_w + m - 1) / m;
+  const int64_t tiles = ((out_h + m - 1) / m) * tiles_w;
+  const int64_t block_tiles = std::max<int64_t>(1, std::min<int64_t>(
+      tiles,
+      kBlockBytes / (tile_elements * (channels + out_channels) * sizeof(float))));
+  const int64_t blocks = (tiles + block_tiles - 1) / block_tiles;
+
+  const Tensor bias_contig = bias.defined() ? bias.contiguous() : bias;
+  const float* in = input.data_ptr<float>();
+  const float* b = bias.defined() ? bias_contig.data_ptr<float>() : nullptr;
+  float* out = output.data_ptr<float>();
+
+  at::parallel_for(0, batch * blocks, 1, [&](int64_t begin, int64_t end) {
+    Tensor transformed_input =
+        at::empty({tile_elements, channels, block_tiles}, input.options());
+    Tensor products =
+        at::empty({tile_elements, out_channels, block_tiles}, input.options());
+    float* v = transformed_input.data_ptr<float>();
+    const float* p = products.data_ptr<float>();
+
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t n = task / blocks;
+      const int64_t first_tile = (task % blocks) * block_tiles;
+      const int64_t num_tiles = std::min(block_tiles, tiles - first_tile);
+
+      for (int64_t c = 0; c < channels; ++c) {
+        const float* in_c = in + (n * channels + c) * in_h * in_w;
+        for (int64_t t = 0; t < num_tiles; ++t) {
+          const int64_t tile = first_tile + t;
+          const int64_t h0 = (tile / tiles_w) * m - pad_h;
+          const int64_t w0 = (tile % tiles_w) * m - pad_w;
+          float d[alpha][alpha];
+          for (int i = 0; i < alpha; ++i) {
+            for (int j = 0; j < alpha; ++j) {
+              const int64_t h = h0 + i;
+              const int64_t w = w0 + j;
+              d[i][j] = (h >= 0 && h < in_h && w >= 0 && w < in_w)
+                  ? in_c[h * in_w + w] : 0;
+            }
+          }
+          float transformed[alpha][alpha];
+          winograd_transform_input<m>(d, transformed);
+          for (int i = 0; i < alpha; ++i) {
+            for (int j = 0; j < alpha; ++j) {
+              v[((i * alpha + j) * channels + c) * block_tiles + t] = transformed[i][j];
+            }
+          }
+        }
+      }
+
+      // In a partial last block, the columns past num_tiles hold stale values,
+      // whose products are never read.
+      at::bmm_out(products, transformed_weight, transformed_input);
+
+      for (int64_t k = 0; k < out_channels; ++k) {
+        const float bias_k = b ? b[k] : 0;
+        float* out_k = out + (n * out_channels + k) * out_h * out_w;
+        for (int64_t t = 0; t < num_tiles; ++t) {
+          const int64_t tile = first_tile + t;
+          const int64_t h0 = (tile / tiles_w) * m;
+          const int64_t w0 = (tile % tiles_w) * m;
+          float x[alpha][alpha];
+          for (int i = 0; i < alpha; ++i) {
+            for (int j = 0; j < alpha; ++j) {
+              x[i][j] = p[((i * alpha + j) * out_channels + k) * block_tiles + t];
+            }
+          }
+          float y[m][m];
+          winograd_transform_output<m>(x, y);
+          for (int i = 0; i < m && h0 + i < out_h; ++i) {
+            for (int j = 0; j < m && w0 + j < out_w; ++j) {
+              out_k[(h0 + i) * out_w + w0 + j] = y[i][j] + bias_k;
+            }
+          }
+        }
+      }
+    }
+  });
+  return output;
+}
+
+Tensor _convolution_winograd3x3(
+    const Tensor& input,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef padding,
+    int64_t output_tile) {
+  TORCH_CHECK(
+      output_tile == 2 || output_tile == 4,
+      "Winograd convolutions have 2x2 or 4x4 output tiles, but got ", output_tile);
+  return output_tile == 4 ? winograd3x3<4>(input, weight, bias, padding)
+                          : winograd3x3<2>(input, weight, bias, padding);
+}
+
+// Lowers the convolution to GEMMs over bands of output rows: the columns of a
+// band (the input patches of its output pixels) are gathered into a buffer of
+// about kBlockBytes, and multiplied by the filters straight into the output,
+// instead of unfolding the whole input at once.
+template <typename scalar_t>
+void implicit_gemm_conv2d(
+    const Tensor& input,
+    const Tensor& weight_2d,
+    const Tensor& bias,
+    Tensor& output,
+    int64_t kernel_h,
+    int64_t kernel_w,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation) {
+  const int64_t batch = input.size(0);
+  const int64_t channels = input.size(1);
+  const int64_t in_h = input.size(2);
+  const int64_t in_w = input.size(3);
+  const int64_t out_channels = output.size(1);
+  const int64_t out_h = output.size(2);
+  const int64_t out_w = output.size(3);
+  const int64_t patch = channels * kernel_h * kernel_w;
+
+  const int64_t band_rows = std::max<int64_t>(1, std::min<int64_t>(
+      out_h, kBlockBytes / (patch * out_w * sizeof(scalar_t))));
+  const int64_t bands = (out_h + band_rows - 1) / band_rows;
+  const Tensor bias_column = bias.defined() ? bias.unsqueeze(1) : bias;
+  const scalar_t* in = input.data_ptr<scalar_t>();
+
+  at::parallel_for(0, batch * bands, 1, [&](int64_t begin, int64_t end) {
+    Tensor columns = at::empty({patch, band_rows * out_w}, input.options());
+    scalar_t* col = columns.data_ptr<scalar_t>();
+    const int64_t ld = band_rows * out_w;
+
+    for (int64_t task = begin; task < end; ++task) {
+      const int64_t n = task / bands;
+      const int64_t first_row = (task % bands) * band_rows;
+      const int64_t rows = std::min(band_rows, out_h - first_row);
+
+      for (int64_t c = 0; c < channels; ++c) {
+        const scalar_t* in_c = in + (n * channels + c) * in_h * in_w;
+        for (int64_t ki = 0; ki < kernel_h; ++ki) {
+          for (int64_t kj = 0; kj < kernel_w; ++kj) {
+            scalar_t* dst = col + ((c * kernel_h + ki) * kernel_w + kj) * ld;
+            for (int64_t r = 0; r < rows; ++r) {
+              const int64_t h = (first_row + r) * stride[0] - padding[0] + ki * dilation[0];
+              scalar_t* dst_r = dst + r * out_w;
+              if (h < 0 || h >= in_h) {
+                std::fill(dst_r, dst_r + out_w, scalar_t(0));
+                continue;
+              }
+              const scalar_t* src = in_c + h * in_w;
+              for (int64_t ow = 0; ow < out_w; ++ow) {
+                const int64_t w = ow * stride[1] - padding[1] + kj * dilation[1];
+                dst_r[ow] = (w >= 0 && w < in_w) ? src[w] : scalar_t(0);
+              }
+            }
+          }
+        }
+      }
+
+      // The band of the output is a (out_channels, rows * out_w) matrix with
+      // a leading dimension of out_h * out_w, which the GEMM writes in place.
+      Tensor out_band = output.select(0, n).narrow(1, first_row, rows)
+                            .view({out_channels, rows * out_w});
+      Tensor band_columns = columns.narrow(1, 0, rows * out_w);
+      if (bias.defined()) {
+        at::addmm_out(out_band, bias_column, weight_2d, band_columns);
+      } else {
+        at::mm_out(out_band, weight_2d, band_columns);
+      }
+    }
+  });
+}
+
+Tensor _convolution_implicit_gemm(
+    const Tensor& input_,
+    const Tensor& weight,
+    const Tensor& bias,
+    IntArrayRef stride,
+    IntArrayRef padding,
+    IntArrayRef dilation) {
+  const Tensor input = input_.contiguous();
+  const int64_t kernel_h = weight.size(2);
+  const int64_t kernel_w = weight.size(3);
+  const int64_t out_h =
+      (input.size(2) + 2 * padding[0] - dilation[0] * (kernel_h - 1) - 1) / stride[0] + 1;
+  const int64_t out_w =
+      (input.size(3) + 2 * padding[1] - dilation[1] * (kernel_w - 1) - 1) / stride[1] + 1;
+  Tensor output = at::empty(
+      {input.size(0), weight.size(0), out_h, out_w}, input.options());
+  if (output.numel() == 0) {
+    return output;
+  }
+  const Tensor weight_2d = weight.reshape({weight.size(0), -1}).contiguous();
+  AT_DISPATCH_FLOATING_TYPES(input.scalar_type(), "convolution_implicit_gemm", [&] {
+    implicit_gemm_conv2d<scalar_t>(
+        input, weight_2d, bias, output, kernel_h, kernel_w, stride, padding, dilation);
+  });
+  return output;
+}
+
+}  // namespace
+
+REGISTER_DISPATCH(convolution_winograd3x3_stub, &_convolution_winograd3x3);
+REGISTER_DISPATCH(convolution_implicit_gemm_stub, &_convolution_implicit_gemm);
+
+}  // namespace native
+}  // namespace at
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/native/DispatchStub.h>
+
+/*
+  Winograd 3x3 and tiled implicit-GEMM 2d convolutions on CPU. Neither is
+  differentiable: they are only used when no gradient is needed.
+*/
+
+namespace at {
+namespace native {
+
+// (input, weight, bias, padding, output_tile): output_tile is 2 or 4, for
+// F(2x2, 3x3) or F(4x4, 3x3). Stride and dilation are 1.
+using convolution_winograd3x3_fn =
+    Tensor (*)(const Tensor &, const Tensor &, const Tensor &, IntArrayRef, int64_t);
+
+// (input, weight, bias, stride, padding, dilation)
+using convolution_implicit_gemm_fn =
+    Tensor (*)(const Tensor &, const Tensor &, const Tensor &, IntArrayRef, IntArrayRef, IntArrayRef);
+
+DECLARE_DISPATCH(convolution_winograd3x3_fn, convolution_winograd3x3_stub);
+DECLARE_DISPATCH(convolution_implicit_gemm_fn, convolution_implicit_gemm_stub);
+
+}  // namespace native
+}  // namespace at
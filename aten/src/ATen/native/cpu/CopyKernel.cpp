@@ -4,6 +4,10 @@
 #include <ATen/native/Copy.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/cpu/Loops.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <vector>
 
 namespace at {
 namespace native {
@@ -70,9 +74,252 @@ static void copy_kernel(TensorIterator& iter, bool non_blocking) {
   }
 }
 
+// Elements of a tile of copy_permute_kernel along each of its dimensions: a
+// tile of 64 x 64 elements reads and writes 64 cache lines, which stay in L1.
+constexpr int64_t kPermuteTile = 64;
+// Elements copied by each task of parallel_for.
+constexpr int64_t kPermuteGrain = 32768;
+
+// dst[i * ld_dst + j] = src[i * stride_i + j * stride_j] for a tile of
+// ni x nj elements. Inside a tile, src is read along i, which is the
+// dimension it walks fastest.
+template <typename scalar_t>
+void copy_tile_scalar(
+    scalar_t* dst, int64_t ld_dst,
+    const scalar_t* src, int64_t stride_i, int64_t stride_j,
+    int64_t ni, int64_t nj) {
+  for (int64_t j = 0; j < nj; j++) {
+    for (int64_t i = 0; i < ni; i++) {
+      dst[i * ld_dst + j] = src[i * stride_i + j * stride_j];
+    }
+  }
+}
+
+template <typename scalar_t>
+void copy_tile(
+    scalar_t* dst, int64_t ld_dst,
+    const scalar_t* src, int64_t stride_i, int64_t stride_j,
+    int64_t ni, int64_t nj) {
+  copy_tile_scalar(dst, ld_dst, src, stride_i, stride_j, ni, nj);
+}
+
+#if defined(__AVX__) && !defined(_MSC_VER)
+
+// Transposes the 8 x 8 block of 32 bit elements at src, whose rows are ld_src
+// elements apart, into dst.
+inline void transpose_8x8(const float* src, int64_t ld_src, float* dst, int64_t ld_dst) {
+  __m256 r0 = Vec256<float>::loadu(src + 0 * ld_src);
+  __m256 r1 = Vec256<float>::loadu(src + 1 * ld_src);
+  __m256 r2 = Vec256<float>::loadu(src + 2 * ld_src);
+  __m256 r3 = Vec256<float>::loadu(src + 3 * ld_src);
+  __m256 r4 = Vec256<float>::loadu(src + 4 * ld_src);
+  __m256 r5 = Vec256<float>::loadu(src + 5 * ld_src);
+  __m256 r6 = Vec256<float>::loadu(src + 6 * ld_src);
+  __m256 r7 = Vec256<float>::loadu(src + 7 * ld_src);
+
+  __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+  __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+  __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+  __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+  __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+  __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+  __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+  __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+  __m256 u0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+  __m256 u6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+  __m256 u7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+  Vec256<float>(_mm256_permute2f128_ps(u0, u4, 0x20)).store(dst + 0 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u1, u5, 0x20)).store(dst + 1 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u2, u6, 0x20)).store(dst + 2 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u3, u7, 0x20)).store(dst + 3 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u0, u4, 0x31)).store(dst + 4 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u1, u5, 0x31)).store(dst + 5 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u2, u6, 0x31)).store(dst + 6 * ld_dst);
+  Vec256<float>(_mm256_permute2f128_ps(u3, u7, 0x31)).store(dst + 7 * ld_dst);
+}
+
+// Transposes the 4 x 4 block of 64 bit elements at src into dst.
+inline void transpose_4x4(const double* src, int64_t ld_src, double* dst, int64_t ld_dst) {
+  __m256d r0 = Vec256<double>::loadu(src + 0 * ld_src);
+  __m256d r1 = Vec256<double>::loadu(src + 1 * ld_src);
+  __m256d r2 = Vec256<double>::loadu(src + 2 * ld_src);
+  __m256d r3 = Vec256<double>::loadu(src + 3 * ld_src);
+
+  __m256d t0 = _mm256_unpacklo_pd(r0, r1);
+  __m256d t1 = _mm256_unpackhi_pd(r0, r1);
+  __m256d t2 = _mm256_unpacklo_pd(r2, r3);
+  __m256d t3 = _mm256_unpackhi_pd(r2, r3);
+
+  Vec256<double>(_mm256_permute2f128_pd(t0, t2, 0x20)).store(dst + 0 * ld_dst);
+  Vec256<double>(_mm256_permute2f128_pd(t1, t3, 0x20)).store(dst + 1 * ld_dst);
+  Vec256<double>(_mm256_permute2f128_pd(t0, t2, 0x31)).store(dst + 2 * ld_dst);
+  Vec256<double>(_mm256_permute2f128_pd(t1, t3, 0x31)).store(dst + 3 * ld_dst);
+}
+
+// When src is contiguous along i, the tile is a transpose, done by blocks in
+// registers. The elements are only moved around, so 32 and 64 bit types are
+// shuffled as float and double.
+template <typename vec_t, typename scalar_t, int block, typename transpose_t>
+void copy_tile_transpose(
+    scalar_t* dst, int64_t ld_dst,
+    const scalar_t* src, int64_t stride_i, int64_t stride_j,
+    int64_t ni, int64_t nj, const transpose_t& transpose) {
+  if (stride_i != 1) {
+    copy_tile_scalar(dst, ld_dst, src, stride_i, stride_j, ni, nj);
+    return;
+  }
+  const int64_t bi = ni - ni % block;
+  const int64_t bj = nj - nj % block;
+  for (int64_t i = 0; i < bi; i += block) {
+    for (int64_t j = 0; j < bj; j += block) {
+      transpose(reinterpret_cast<const vec_t*>(src + i + j * stride_j), stride_j,
+                reinterpret_cast<vec_t*>(dst + i * ld_dst + j), ld_dst);
+    }
+  }
+  copy_tile_scalar(dst + bj, ld_dst, src + bj * stride_j, 1, stride_j, ni, nj - bj);
+  copy_tile_scalar(dst + bi * ld_dst, ld_dst, src + bi, 1, stride_j, ni - bi, bj);
+}
+
+template <>
+void copy_tile<int32_t>(
+    int32_t* dst, int64_t ld_dst,
+    const int32_t* src, int64_t stride_i, int64_t stride_j,
+    int64_t ni, int64_t nj) {
+  copy_tile_transpose<float, int32_t, 8>(
+      dst, ld_dst, src, stride_i, stride_j, ni, nj, transpose_8x8);
+}
+
+template <>
+void copy_tile<int64_t>(
+    int64_t* dst, int64_t ld_dst,
+    const int64_t* src, int64_t stride_i, int64_t stride_j,
+    int64_t ni, int64_t nj) {
+  copy_tile_transpose<double, int64_t, 4>(
+      dst, ld_dst, src, stride_i, stride_j, ni, nj, transpose_4x4);
+}
+
+#endif
+
+// Copies the strided src into the contiguous dst of the given sizes. After
+// merging the dimensions that src walks in order, dst is tiled along its last
+// dimension and along the dimension that src walks fastest, so that both are
+// accessed a cache line at a time.
+template <typename scalar_t>
+void copy_permute(scalar_t* dst, const scalar_t* src, IntArrayRef src_sizes, IntArrayRef src_strides) {
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+  for (size_t i = 0; i < src_sizes.size(); i++) {
+    if (src_sizes[i] == 1) {
+      continue;
+    }
+    if (!sizes.empty() && strides.back() == src_strides[i] * src_sizes[i]) {
+      sizes.back() *= src_sizes[i];
+      strides.back() = src_strides[i];
+    } else {
+      sizes.push_back(src_sizes[i]);
+      strides.push_back(src_strides[i]);
+    }
+  }
+  if (sizes.empty()) {
+    dst[0] = src[0];
+    return;
+  }
+
+  const int64_t ndim = sizes.size();
+  const int64_t inner = ndim - 1;
+  std::vector<int64_t> dst_strides(ndim, 1);
+  for (int64_t i = ndim - 2; i >= 0; i--) {
+    dst_strides[i] = dst_strides[i + 1] * sizes[i + 1];
+  }
+  // The other tiled dimension; without one that src walks faster than the
+  // last, the tiles are just runs of the last dimension.
+  int64_t fast = -1;
+  for (int64_t i = 0; i < inner; i++) {
+    if (strides[i] < strides[inner] && (fast < 0 || strides[i] < strides[fast])) {
+      fast = i;
+    }
+  }
+
+  const int64_t tile_i = fast >= 0 ? kPermuteTile : 1;
+  const int64_t size_i = fast >= 0 ? sizes[fast] : 1;
+  const int64_t stride_i = fast >= 0 ? strides[fast] : 0;
+  const int64_t ld_dst = fast >= 0 ? dst_strides[fast] : 0;
+  const int64_t blocks_i = (size_i + tile_i - 1) / tile_i;
+  const int64_t blocks_j = (sizes[inner] + kPermuteTile - 1) / kPermuteTile;
+  int64_t outer = 1;
+  for (int64_t i = 0; i < inner; i++) {
+    if (i != fast) {
+      outer *= sizes[i];
+    }
+  }
+
+  const int64_t tasks = outer * blocks_i * blocks_j;
+  const int64_t grain = std::max<int64_t>(1, kPermuteGrain / (tile_i * kPermuteTile));
+  at::parallel_for(0, tasks, grain, [&](int64_t begin, int64_t end) {
+    for (int64_t task = begin; task < end; task++) {
+      const int64_t block_j = task % blocks_j;
+      const int64_t block_i = (task / blocks_j) % blocks_i;
+      int64_t index = task / (blocks_j * blocks_i);
+      int64_t src_offset = 0;
+      int64_t dst_offset = 0;
+      for (int64_t i = inner - 1; i >= 0; i--) {
+        if (i == fast) {
+          continue;
+        }
+        const int64_t idx = index % sizes[i];
+        index /= sizes[i];
+        src_offset += idx * strides[i];
+        dst_offset += idx * dst_strides[i];
+      }
+      const int64_t i0 = block_i * tile_i;
+      const int64_t j0 = block_j * kPermuteTile;
+      copy_tile(
+          dst + dst_offset + i0 * ld_dst + j0, ld_dst,
+          src + src_offset + i0 * stride_i + j0 * strides[inner], stride_i, strides[inner],
+          std::min(tile_i, size_i - i0), std::min(kPermuteTile, sizes[inner] - j0));
+    }
+  });
+}
+
+template <typename scalar_t>
+void copy_permute_as(Tensor& self, const Tensor& src) {
+  copy_permute(
+      static_cast<scalar_t*>(self.data_ptr()),
+      static_cast<const scalar_t*>(src.data_ptr()),
+      src.sizes(), src.strides());
+}
+
+// The copy only moves elements, so it is dispatched on their size.
+static void copy_permute_kernel(Tensor& self, const Tensor& src) {
+  switch (self.element_size()) {
+    case 1:
+      copy_permute_as<uint8_t>(self, src);
+      break;
+    case 2:
+      copy_permute_as<int16_t>(self, src);
+      break;
+    case 4:
+      copy_permute_as<int32_t>(self, src);
+      break;
+    case 8:
+      copy_permute_as<int64_t>(self, src);
+      break;
+    default:
+      TORCH_INTERNAL_ASSERT(false, "copy_permute_kernel: unsupported element size ", self.element_size());
+  }
+}
+
 } // anonymous namespace
 
 REGISTER_DISPATCH(copy_stub, &copy_kernel);
+REGISTER_DISPATCH(copy_permute_stub, &copy_permute_kernel);
 
 } // namespace native
 } // namespace at
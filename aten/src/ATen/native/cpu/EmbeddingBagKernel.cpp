@@ -0,0 +1,135 @@
+#include <ATen/native/EmbeddingBag.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+
+namespace at {
+namespace native {
+namespace {
+
+using namespace vec256;
+
+// out = max(out, row), keeping out where row isn't strictly greater (so a NaN
+// in a later row never replaces the running maximum).
+template <typename scalar_t>
+void max_row(scalar_t* out, const scalar_t* row, int64_t n) {
+  using Vec = Vec256<scalar_t>;
+  int64_t i = 0;
+  for (; i <= n - Vec::size(); i += Vec::size()) {
+    Vec o = Vec::loadu(out + i);
+    Vec r = Vec::loadu(row + i);
+    Vec::blendv(o, r, r > o).store(out + i);
+  }
+  for (; i < n; i++) {
+    if (row[i] > out[i]) {
+      out[i] = row[i];
+    }
+  }
+}
+
+template <typename scalar_t>
+void embedding_bag_max_impl(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    Tensor& output,
+    Tensor& max_indices) {
+  const int64_t num_bags = offsets.numel();
+  const int64_t numel = indices.numel();
+  const int64_t num_weights = weight.size(0);
+  const int64_t ddim = weight.size(1);
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const scalar_t* weight_data = weight.data_ptr<scalar_t>();
+  const int64_t weight_stride0 = weight.stride(0);
+  const int64_t weight_stride1 = weight.stride(1);
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  int64_t* max_indices_data = max_indices.data_ptr<int64_t>();
+
+  parallel_for(
+      0,
+      num_bags,
+      embedding_bag_grain_size(num_bags, numel, ddim),
+      [&](int64_t bag_begin, int64_t bag_end) {
+        for (int64_t bag = bag_begin; bag < bag_end; bag++) {
+          const int64_t start = offsets_data[bag];
+          const int64_t end = std::min(
+              numel, bag + 1 < num_bags ? offsets_data[bag + 1] : numel);
+          if (start >= end) {
+            continue;
+          }
+          scalar_t* out = output_data + bag * ddim;
+          int64_t* out_indices = max_indices_data + bag * ddim;
+
+          // First pass: the maximum of every dimension, one row at a time.
+          for (int64_t i = start; i < end; i++) {
+            const int64_t idx = indices_data[i];
+            TORCH_CHECK(
+                idx >= 0 && idx < num_weights,
+                "embedding_bag: index ", idx,
+                " is out of bounds for a weight with ", num_weights, " rows");
+#ifdef __GNUC__
+            if (i + kEmbeddingBagPrefetchDistance < end) {
+              __builtin_prefetch(
+                  weight_data + weight_stride0 *
+                      indices_data[i + kEmbeddingBagPrefetchDistance],
+                  0,
+                  1);
+            }
+#endif // __GNUC__
+            const scalar_t* row = weight_data + weight_stride0 * idx;
+            if (i == start) {
+              for (int64_t d = 0; d < ddim; d++) {
+                out[d] = row[d * weight_stride1];
+              }
+            } else if (weight_stride1 == 1) {
+              max_row(out, row, ddim);
+            } else {
+              for (int64_t d = 0; d < ddim; d++) {
+                const scalar_t value = row[d * weight_stride1];
+                if (value > out[d]) {
+                  out[d] = value;
+                }
+              }
+            }
+          }
+
+          // Second pass, over rows that are in cache now: the first row each
+          // maximum was found in, which is the one a running "strictly
+          // greater" comparison would have kept. Going backwards, earlier
+          // rows overwrite later ones. A bag whose first row is NaN keeps it.
+          std::fill(out_indices, out_indices + ddim, indices_data[start]);
+          for (int64_t i = end - 1; i >= start; i--) {
+            const int64_t idx = indices_data[i];
+            const scalar_t* row = weight_data + weight_stride0 * idx;
+            for (int64_t d = 0; d < ddim; d++) {
+              if (row[d * weight_stride1] == out[d]) {
+                out_indices[d] = idx;
+              }
+            }
+          }
+        }
+      });
+}
+
+void embedding_bag_max_kernel(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    Tensor& output,
+    Tensor& max_indices) {
+  AT_DISPATCH_FLOATING_TYPES(weight.scalar_type(), "embedding_bag_max", [&] {
+    embedding_bag_max_impl<scalar_t>(
+        weight, indices, offsets, output, max_indices);
+  });
+}
+
+} // namespace
+
+REGISTER_DISPATCH(embedding_bag_max_stub, &embedding_bag_max_kernel);
+
+} // namespace native
+} // namespace at
@@ -884,6 +884,27 @@ static inline void grid_sample_2d_grid_slice_iterator(
   }
 }
 
+// Like `grid_sample_2d_grid_slice_iterator`, but only iterates over the rows
+// [h_begin, h_end) of the grid slice. `spatial_offset` passed to `apply_fn` is
+// still the offset from the beginning of the whole slice, so that several
+// threads can process the rows of a same slice.
+template<typename scalar_t, typename ApplyFn>
+static inline void grid_sample_2d_grid_rows_iterator(
+    const TensorAccessor<scalar_t, 3>& grid_slice, int64_t h_begin,
+    int64_t h_end, const ApplyFn &apply_fn) {
+  int64_t sizes[3] = {h_end - h_begin, grid_slice.size(1), grid_slice.size(2)};
+  int64_t strides[3] = {grid_slice.stride(0), grid_slice.stride(1), grid_slice.stride(2)};
+  const TensorAccessor<scalar_t, 3> grid_rows(
+      grid_slice.data() + h_begin * strides[0], sizes, strides);
+  const int64_t base_offset = h_begin * grid_slice.size(1);
+  grid_sample_2d_grid_slice_iterator(
+    grid_rows,
+    [&](const Vec256<scalar_t>& grid_x, const Vec256<scalar_t>& grid_y,
+        int64_t spatial_offset, int64_t len) {
+      apply_fn(grid_x, grid_y, base_offset + spatial_offset, len);
+    });
+}
+
 // ~~~~~~~~~~~~~~~~~~~~~~~~~ Grid Sample Kernels ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // Use the structs & functions defined above to calculate grid sample forward
 // and backward.
@@ -966,14 +987,57 @@ grid_sampler_2d_backward_cpu_kernel_impl(const Tensor& grad_output_,
   auto grad_input = at::zeros_like(input);
   auto grad_grid = at::empty_like(grid);
   auto N = input.size(0);
+  auto out_H = grid.size(1);
   auto spatial_size = grid.size(1) * grid.size(2);
   auto grain_size = spatial_size == 0 ? (N + 1)
                                       : at::divup(at::internal::GRAIN_SIZE, spatial_size * 10 /* 2d * 5 tensors*/);
 
+  // When there are fewer samples than threads, also split the rows of the
+  // grid slices into chunks. The chunks of a same sample scatter into the
+  // same grad_input slice, so every chunk accumulates into its own zeroed
+  // buffer, and the buffers are summed at the end. grad_grid is written once
+  // per grid location, so it needs no buffer.
+  int64_t num_chunks = 1;
+  if (N < at::get_num_threads() && spatial_size * 10 >= at::internal::GRAIN_SIZE) {
+    num_chunks = std::min(at::divup(at::get_num_threads(), N), out_H);
+  }
+  const int64_t rows_per_chunk = num_chunks > 1 ? at::divup(out_H, num_chunks) : out_H;
+  Tensor grad_input_buffers;
+  if (num_chunks > 1) {
+    num_chunks = at::divup(out_H, rows_per_chunk);
+    auto buffer_sizes = input.sizes().vec();
+    buffer_sizes.insert(buffer_sizes.begin(), num_chunks);
+    grad_input_buffers = at::zeros(buffer_sizes, input.options());
+  }
+
 #define HANDLE_CASE(interp, padding, align_corners)                              \
   case padding: {                                                                \
     ApplyGridSample<scalar_t, 2, interp, padding, align_corners>                 \
     grid_sample(inp_acc);                                                        \
+    if (num_chunks > 1) {                                                        \
+      auto gInp_buf_acc = grad_input_buffers.accessor<scalar_t, 5>();            \
+      parallel_for(0, N * num_chunks, 1, [&](int64_t begin, int64_t end) {       \
+        for (int64_t i = begin; i < end; i++) {                                  \
+          auto n = i / num_chunks;                                               \
+          auto chunk = i % num_chunks;                                           \
+          auto gInp_slice = gInp_buf_acc[chunk][n];                              \
+          auto gGrid_slice = gGrid_acc[n];                                       \
+          auto gOut_slice = gOut_acc[n];                                         \
+          auto inp_slice = inp_acc[n];                                           \
+          auto h_begin = chunk * rows_per_chunk;                                 \
+          auto h_end = std::min(out_H, h_begin + rows_per_chunk);                \
+          grid_sample_2d_grid_rows_iterator(                                     \
+            grid_acc[n], h_begin, h_end,                                         \
+            [&](const Vec256<scalar_t>& grid_x, const Vec256<scalar_t>& grid_y,  \
+                int64_t spatial_offset, int64_t len) {                           \
+              grid_sample.backward(gInp_slice, gGrid_slice, gOut_slice,          \
+                                   inp_slice, spatial_offset, grid_x, grid_y,    \
+                                   len);                                         \
+            });                                                                  \
+        }                                                                        \
+      });                                                                        \
+      return;                                                                    \
+    }                                                                            \
     parallel_for(0, N, grain_size, [&](int64_t begin, int64_t end) {             \
       for (int64_t n = begin; n < end; n++) {                                    \
         auto gInp_slice = gInp_acc[n];                                           \
@@ -1023,6 +1087,9 @@ grid_sampler_2d_backward_cpu_kernel_impl(const Tensor& grad_output_,
 #undef HANDLE_CASE
 #undef HANDLE_INTERP
 
+  if (num_chunks > 1) {
+    at::sum_out(grad_input, grad_input_buffers, 0);
+  }
   return std::make_tuple(grad_input, grad_grid);
 }
 
@@ -22,6 +22,9 @@
 //     [](float a, float b) { return a * b; },
 //     [](Vec256<float> a, Vec256<float> b) { return a * b; });
 //
+// The vectorized lambda may also take Vec512, or Vectorized<T> to use the
+// widest vector type of the CPU capability the kernel is compiled for.
+//
 // See BinaryOpsKernel.cpp for the complete implementation
 //
 //
@@ -32,6 +35,7 @@
 #include <ATen/native/cpu/IsContiguous.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/cpu/vec256/vec256.h>
+#include <ATen/cpu/vec512/vec512.h>
 
 #ifndef _MSC_VER
 #pragma GCC diagnostic push
@@ -135,7 +139,8 @@ static inline void
 vectorized_loop(char** C10_RESTRICT data_, int64_t n, int64_t S, func_t op, vec_func_t vop) {
   using traits = function_traits<vec_func_t>;
   using scalar_t = typename function_traits<func_t>::result_type;
-  using Vec = Vec256<scalar_t>;
+  // Vec256 or Vec512, whichever the vectorized op was written for
+  using Vec = typename traits::result_type;
   constexpr int ntensors = traits::arity + 1;
 
   char* C10_RESTRICT data[ntensors];
@@ -1,10 +1,14 @@
 #include <ATen/ATen.h>
 
+#include <ATen/CPUGenerator.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 #include <ATen/native/Copy.h>
 #include <ATen/native/TensorIterator.h>
+#include <ATen/native/UnaryOps.h>
 #include <ATen/native/cpu/Loops.h>
 #include <ATen/core/DistributionsHelper.h>
+#include <ATen/core/PhiloxRNGEngine.h>
 
 namespace at {
 namespace native {
@@ -127,9 +131,59 @@ static void multinomial_kernel_impl(Tensor& result, const Tensor& self, const in
   });
 }
 
+// The draws are split into chunks of a fixed number of samples, and every
+// chunk draws from its own subsequence of a Philox engine seeded once from the
+// generator. The chunks can then be drawn in parallel, and the samples only
+// depend on the state of the generator, not on the number of threads.
+constexpr int64_t ALIAS_DRAW_CHUNK_SIZE = 4096;
+
+// Uniform double in [0, 1) from 53 random bits
+inline double philox_uniform(at::philox_engine& engine) {
+  uint64_t bits = (static_cast<uint64_t>(engine()) << 32) | engine();
+  return (bits >> 11) * (1.0 / (static_cast<uint64_t>(1) << 53));
+}
+
+template<typename scalar_t>
+void multinomial_alias_draw_apply(Tensor& result, const Tensor& q, const Tensor& J, Generator* generator) {
+  uint64_t seed;
+  {
+    auto gen = get_generator_or_default<CPUGenerator>(generator, detail::getDefaultCPUGenerator());
+    // See Note [Acquire lock when using random generators]
+    std::lock_guard<std::mutex> lock(gen->mutex_);
+    seed = gen->random64();
+  }
+
+  int64_t n_categories = J.numel();
+  int64_t n_sample = result.numel();
+  const scalar_t* q_data = q.data_ptr<scalar_t>();
+  const int64_t* J_data = J.data_ptr<int64_t>();
+  int64_t* result_data = result.data_ptr<int64_t>();
+
+  int64_t n_chunks = at::divup(n_sample, ALIAS_DRAW_CHUNK_SIZE);
+  at::parallel_for(0, n_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t chunk = begin; chunk < end; chunk++) {
+      at::philox_engine engine(seed, chunk, 0);
+      int64_t chunk_end = std::min(n_sample, (chunk + 1) * ALIAS_DRAW_CHUNK_SIZE);
+      for (int64_t i = chunk * ALIAS_DRAW_CHUNK_SIZE; i < chunk_end; i++) {
+        int64_t rand_ind = std::min(
+            static_cast<int64_t>(philox_uniform(engine) * n_categories), n_categories - 1);
+        bool keep = philox_uniform(engine) < q_data[rand_ind];
+        result_data[i] = keep ? rand_ind : J_data[rand_ind];
+      }
+    }
+  });
+}
+
+static void multinomial_alias_draw_kernel_impl(Tensor& result, const Tensor& q, const Tensor& J, Generator *gen) {
+  AT_DISPATCH_FLOATING_TYPES(q.scalar_type(), "multinomial_alias_draw", [&] {
+    multinomial_alias_draw_apply<scalar_t>(result, q, J, gen);
+  });
+}
+
 }
 
 REGISTER_DISPATCH(multinomial_stub, &multinomial_kernel_impl);
+REGISTER_DISPATCH(multinomial_alias_draw_stub, &multinomial_alias_draw_kernel_impl);
 
 }
 }
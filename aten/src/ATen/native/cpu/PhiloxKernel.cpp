@@ -0,0 +1,198 @@
+#include <ATen/ATen.h>
+#include <ATen/CPUGenerator.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/Utils.h>
+#include <ATen/core/DistributionsHelper.h>
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/native/UnaryOps.h>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace at { namespace native {
+namespace {
+
+using namespace vec256;
+
+// See Note [Philox mode of CPUGenerator]
+//
+// The number of elements generated from one subsequence. It only depends on
+// the kernel, never on the number of threads, and is a multiple of the
+// 2 * Vec256<scalar_t>::size() numbers the Box-Muller transform takes at once.
+constexpr int64_t kPhiloxBlock = 4096;
+
+constexpr uint32_t kPhilox10A = 0x9E3779B9;
+constexpr uint32_t kPhilox10B = 0xBB67AE85;
+constexpr uint32_t kPhiloxSA = 0xD2511F53;
+constexpr uint32_t kPhiloxSB = 0xCD9E8D57;
+
+// Fills words with the 4 * n numbers that philox_engine(seed, subsequence,
+// offset) returns first. philox_engine computes one counter at a time; here
+// the rounds run over kLanes counters at once, which the compiler turns into
+// vector multiplies.
+void philox_fill(uint64_t seed, uint64_t subsequence, uint64_t offset,
+                 uint32_t* words, int64_t n) {
+  constexpr int64_t kLanes = 8;
+  for (int64_t base = 0; base < n; base += kLanes) {
+    uint32_t c0[kLanes], c1[kLanes], c2[kLanes], c3[kLanes];
+    for (int64_t j = 0; j < kLanes; j++) {
+      // The counter is the 128 bit number (subsequence, offset + base + j).
+      const uint64_t low = offset + base + j;
+      const uint64_t high = subsequence + (low < offset ? 1 : 0);
+      c0[j] = static_cast<uint32_t>(low);
+      c1[j] = static_cast<uint32_t>(low >> 32);
+      c2[j] = static_cast<uint32_t>(high);
+      c3[j] = static_cast<uint32_t>(high >> 32);
+    }
+    uint32_t k0 = static_cast<uint32_t>(seed);
+    uint32_t k1 = static_cast<uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; round++) {
+      for (int64_t j = 0; j < kLanes; j++) {
+        const uint64_t p0 = static_cast<uint64_t>(kPhiloxSA) * c0[j];
+        const uint64_t p1 = static_cast<uint64_t>(kPhiloxSB) * c2[j];
+        const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1[j] ^ k0;
+        const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3[j] ^ k1;
+        c0[j] = n0;
+        c1[j] = static_cast<uint32_t>(p1);
+        c2[j] = n2;
+        c3[j] = static_cast<uint32_t>(p0);
+      }
+      k0 += kPhilox10A;
+      k1 += kPhilox10B;
+    }
+    const int64_t lanes = std::min(kLanes, n - base);
+    for (int64_t j = 0; j < lanes; j++) {
+      uint32_t* out = words + 4 * (base + j);
+      out[0] = c0[j];
+      out[1] = c1[j];
+      out[2] = c2[j];
+      out[3] = c3[j];
+    }
+  }
+}
+
+inline uint64_t make64BitsFrom32Bits(uint32_t hi, uint32_t lo) {
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+}
+
+// kPhiloxBlock numbers in [0, 1), from the same bits as
+// uniform_real_distribution takes from the mt19937 engine.
+void uniform_from_words(const uint32_t* words, float* out) {
+  for (int64_t i = 0; i < kPhiloxBlock; i++) {
+    out[i] = static_cast<int32_t>(words[i] & FLOAT_MASK) * FLOAT_DIVISOR;
+  }
+}
+
+void uniform_from_words(const uint32_t* words, double* out) {
+  for (int64_t i = 0; i < kPhiloxBlock; i++) {
+    const uint64_t bits = make64BitsFrom32Bits(words[2 * i], words[2 * i + 1]) & DOUBLE_MASK;
+    out[i] = static_cast<int64_t>(bits) * DOUBLE_DIVISOR;
+  }
+}
+
+// Generates the kPhiloxBlock elements of block b of self, b in parallel,
+// with fill(words, out), which turns words_per_element * kPhiloxBlock 32 bit
+// numbers into kPhiloxBlock elements.
+template <typename scalar_t, typename fill_t>
+void philox_kernel(Tensor& self, Generator* gen, int64_t words_per_element, const fill_t& fill) {
+  const int64_t numel = self.numel();
+  if (numel == 0) {
+    return;
+  }
+  const int64_t counters = kPhiloxBlock * words_per_element / 4;
+  CPUGenerator* generator = get_generator_or_default<CPUGenerator>(gen, detail::getDefaultCPUGenerator());
+  std::pair<uint64_t, uint64_t> inputs;
+  {
+    // See Note [Acquire lock when using random generators]
+    std::lock_guard<std::mutex> lock(generator->mutex_);
+    inputs = generator->philox_engine_inputs(counters);
+  }
+
+  Tensor result = self.is_contiguous() ? self : at::empty(self.sizes(), self.options());
+  scalar_t* data = result.data_ptr<scalar_t>();
+  const int64_t blocks = (numel + kPhiloxBlock - 1) / kPhiloxBlock;
+  const int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / kPhiloxBlock);
+  at::parallel_for(0, blocks, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<uint32_t> words(4 * counters);
+    std::unique_ptr<scalar_t[]> buffer;
+    for (int64_t b = begin; b < end; b++) {
+      philox_fill(inputs.first, b, inputs.second, words.data(), counters);
+      const int64_t first = b * kPhiloxBlock;
+      const int64_t size = std::min(kPhiloxBlock, numel - first);
+      if (size == kPhiloxBlock) {
+        fill(words.data(), data + first);
+      } else {
+        if (!buffer) {
+          buffer.reset(new scalar_t[kPhiloxBlock]);
+        }
+        fill(words.data(), buffer.get());
+        std::copy(buffer.get(), buffer.get() + size, data + first);
+      }
+    }
+  });
+  if (!result.is_same(self)) {
+    self.copy_(result);
+  }
+}
+
+void uniform_philox_kernel(Tensor& self, const double from, const double to, Generator* gen) {
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "uniform_philox_cpu_", [&] {
+    using Vec = Vec256<scalar_t>;
+    const Vec range(static_cast<scalar_t>(to - from));
+    const Vec low(static_cast<scalar_t>(from));
+    philox_kernel<scalar_t>(self, gen, sizeof(scalar_t) / sizeof(uint32_t),
+        [&](const uint32_t* words, scalar_t* out) {
+      uniform_from_words(words, out);
+      for (int64_t i = 0; i < kPhiloxBlock; i += Vec::size()) {
+        fmadd(Vec::loadu(out + i), range, low).store(out + i);
+      }
+    });
+  });
+}
+
+// Box-Muller on Vec256s: every 2 * Vec::size() uniforms u1, u2 become as many
+// normals, r * cos(theta) followed by r * sin(theta).
+void normal_philox_kernel(Tensor& self, const double mean, const double std, Generator* gen) {
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "normal_philox_cpu_", [&] {
+    using Vec = Vec256<scalar_t>;
+    const Vec mean_vec(static_cast<scalar_t>(mean));
+    const Vec std_vec(static_cast<scalar_t>(std));
+    const Vec one(1);
+    const Vec minus_two(-2);
+    const Vec two_pi(static_cast<scalar_t>(2.0 * M_PI));
+    philox_kernel<scalar_t>(self, gen, sizeof(scalar_t) / sizeof(uint32_t),
+        [&](const uint32_t* words, scalar_t* out) {
+      uniform_from_words(words, out);
+      for (int64_t i = 0; i < kPhiloxBlock; i += 2 * Vec::size()) {
+        const Vec theta = two_pi * Vec::loadu(out + i);
+        // 1 - u2 is in (0, 1], so that the log is finite.
+        const Vec radius = (minus_two * (one - Vec::loadu(out + i + Vec::size())).log()).sqrt();
+        fmadd(radius * theta.cos(), std_vec, mean_vec).store(out + i);
+        fmadd(radius * theta.sin(), std_vec, mean_vec).store(out + i + Vec::size());
+      }
+    });
+  });
+}
+
+void bernoulli_philox_kernel(Tensor& self, const double p, Generator* gen) {
+  AT_DISPATCH_ALL_TYPES_AND(at::ScalarType::Bool, self.scalar_type(), "bernoulli_philox_cpu_", [&] {
+    philox_kernel<scalar_t>(self, gen, 2, [&](const uint32_t* words, scalar_t* out) {
+      for (int64_t i = 0; i < kPhiloxBlock; i++) {
+        const uint64_t bits = make64BitsFrom32Bits(words[2 * i], words[2 * i + 1]) & DOUBLE_MASK;
+        out[i] = static_cast<scalar_t>(static_cast<int64_t>(bits) * DOUBLE_DIVISOR < p);
+      }
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(uniform_philox_stub, &uniform_philox_kernel);
+REGISTER_DISPATCH(normal_philox_stub, &normal_philox_kernel);
+REGISTER_DISPATCH(bernoulli_philox_stub, &bernoulli_philox_kernel);
+
+}} // namespace at::native
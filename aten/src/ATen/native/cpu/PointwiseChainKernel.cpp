@@ -0,0 +1,180 @@
+#include <ATen/native/PointwiseChain.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/cpu/vec512/vec512.h>
+#include <ATen/native/TensorIterator.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace at {
+namespace native {
+namespace {
+
+using namespace vec256;
+
+// Number of elements processed by every step before moving on to the next
+// one. The running values and the gathered operands of one chunk stay in L1.
+constexpr int64_t kChunkSize = 512;
+
+template <typename scalar_t, typename Op>
+inline void map_inplace(scalar_t* value, int64_t n, const Op& op) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t i = 0;
+  for (; i + Vec::size() <= n; i += Vec::size()) {
+    op(Vec::loadu(value + i)).store(value + i);
+  }
+  if (i < n) {
+    op(Vec::loadu(value + i, n - i)).store(value + i, n - i);
+  }
+}
+
+template <typename scalar_t, typename Op>
+inline void map2_inplace(
+    scalar_t* value, const scalar_t* other, int64_t n, const Op& op) {
+  using Vec = Vectorized<scalar_t>;
+  int64_t i = 0;
+  for (; i + Vec::size() <= n; i += Vec::size()) {
+    op(Vec::loadu(value + i), Vec::loadu(other + i)).store(value + i);
+  }
+  if (i < n) {
+    op(Vec::loadu(value + i, n - i), Vec::loadu(other + i, n - i))
+        .store(value + i, n - i);
+  }
+}
+
+template <typename scalar_t>
+void run_steps(
+    scalar_t* value,
+    const scalar_t* const* operands,
+    int64_t n,
+    const std::vector<PointwiseStep>& steps) {
+  using Vec = Vectorized<scalar_t>;
+  using Kind = PointwiseStep::Kind;
+  for (const auto& step : steps) {
+    const Vec s(static_cast<scalar_t>(step.scalar));
+    const scalar_t* other = step.operand >= 0 ? operands[step.operand] : nullptr;
+    switch (step.kind) {
+      case Kind::Add:
+        if (!other) {
+          map_inplace(value, n, [&](Vec a) { return a + s; });
+        } else if (step.scalar == 1) {
+          map2_inplace(value, other, n, [&](Vec a, Vec b) { return a + b; });
+        } else {
+          map2_inplace(value, other, n, [&](Vec a, Vec b) { return a + s * b; });
+        }
+        break;
+      case Kind::Mul:
+        if (!other) {
+          map_inplace(value, n, [&](Vec a) { return a * s; });
+        } else {
+          map2_inplace(value, other, n, [&](Vec a, Vec b) { return a * b; });
+        }
+        break;
+      case Kind::Div:
+        if (!other) {
+          map_inplace(value, n, [&](Vec a) { return a / s; });
+        } else {
+          map2_inplace(value, other, n, [&](Vec a, Vec b) { return a / b; });
+        }
+        break;
+      case Kind::Relu: {
+        const Vec zero(static_cast<scalar_t>(0));
+        map_inplace(value, n, [&](Vec a) { return maximum(a, zero); });
+        break;
+      }
+      case Kind::Neg:
+        map_inplace(value, n, [&](Vec a) { return a.neg(); });
+        break;
+      case Kind::Exp:
+        map_inplace(value, n, [&](Vec a) { return a.exp(); });
+        break;
+      case Kind::Tanh:
+        map_inplace(value, n, [&](Vec a) { return a.tanh(); });
+        break;
+      case Kind::Sigmoid: {
+        const Vec one(static_cast<scalar_t>(1));
+        map_inplace(value, n, [&](Vec a) { return one / (one + a.neg().exp()); });
+        break;
+      }
+    }
+  }
+}
+
+// Runs the program over one buffer of `n` elements. Operands that are not
+// contiguous (including broadcasted ones) are gathered into local buffers
+// first, so that every step can use full-width vector loads.
+template <typename scalar_t>
+void fused_pointwise_loop(
+    char** data,
+    const int64_t* strides,
+    int64_t n,
+    int num_operands,
+    const std::vector<PointwiseStep>& steps) {
+  constexpr int64_t kSize = sizeof(scalar_t);
+  alignas(64) scalar_t value_buffer[kChunkSize];
+  alignas(64) scalar_t operand_buffers[PointwiseChain::kMaxOperands][kChunkSize];
+  const scalar_t* operands[PointwiseChain::kMaxOperands];
+
+  for (int64_t begin = 0; begin < n; begin += kChunkSize) {
+    const int64_t len = std::min(kChunkSize, n - begin);
+
+    // data[0] is the output and data[1] the input of the chain.
+    const bool out_contiguous = strides[0] == kSize;
+    scalar_t* value = out_contiguous
+        ? reinterpret_cast<scalar_t*>(data[0] + begin * kSize)
+        : value_buffer;
+    const char* in = data[1] + begin * strides[1];
+    if (strides[1] == kSize) {
+      std::memmove(value, in, len * kSize);
+    } else {
+      for (int64_t i = 0; i < len; i++) {
+        value[i] = *reinterpret_cast<const scalar_t*>(in + i * strides[1]);
+      }
+    }
+
+    for (int k = 0; k < num_operands; k++) {
+      const int64_t stride = strides[k + 2];
+      const char* ptr = data[k + 2] + begin * stride;
+      if (stride == kSize) {
+        operands[k] = reinterpret_cast<const scalar_t*>(ptr);
+      } else {
+        for (int64_t i = 0; i < len; i++) {
+          operand_buffers[k][i] =
+              *reinterpret_cast<const scalar_t*>(ptr + i * stride);
+        }
+        operands[k] = operand_buffers[k];
+      }
+    }
+
+    run_steps(value, operands, len, steps);
+
+    if (!out_contiguous) {
+      char* out = data[0] + begin * strides[0];
+      for (int64_t i = 0; i < len; i++) {
+        *reinterpret_cast<scalar_t*>(out + i * strides[0]) = value[i];
+      }
+    }
+  }
+}
+
+static void fused_pointwise_kernel(
+    TensorIterator& iter,
+    const std::vector<PointwiseStep>& steps) {
+  const int num_operands = iter.ninputs() - 1;
+  TORCH_INTERNAL_ASSERT(
+      num_operands >= 0 &&
+      num_operands <= static_cast<int>(PointwiseChain::kMaxOperands));
+  AT_DISPATCH_FLOATING_TYPES(iter.dtype(), "fused_pointwise_cpu", [&] {
+    iter.for_each([&](char** data, const int64_t* strides, int64_t n) {
+      fused_pointwise_loop<scalar_t>(data, strides, n, num_operands, steps);
+    });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(fused_pointwise_stub, &fused_pointwise_kernel);
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,154 @@
+#include <ATen/native/RNN.h>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+#include <algorithm>
+
+namespace at { namespace native {
+namespace {
+
+using namespace vec256;
+
+template <typename scalar_t>
+inline Vec256<scalar_t> load(const scalar_t* ptr, int64_t n) {
+  using Vec = Vec256<scalar_t>;
+  return n == Vec::size() ? Vec::loadu(ptr) : Vec::loadu(ptr, n);
+}
+
+template <typename scalar_t>
+inline void store(const Vec256<scalar_t>& v, scalar_t* ptr, int64_t n) {
+  using Vec = Vec256<scalar_t>;
+  if (n == Vec::size()) {
+    v.store(ptr);
+  } else {
+    v.store(ptr, n);
+  }
+}
+
+template <typename scalar_t>
+inline Vec256<scalar_t> sigmoid(const Vec256<scalar_t>& v) {
+  using Vec = Vec256<scalar_t>;
+  return (Vec(1) + v.neg().exp()).reciprocal();
+}
+
+// input gate + hidden gate (+ hidden bias) for the n elements at `offset`
+template <typename scalar_t>
+inline Vec256<scalar_t> gate(
+    const scalar_t* igates,
+    const scalar_t* hgates,
+    const scalar_t* hidden_bias,
+    int64_t offset,
+    int64_t n) {
+  auto g = load(igates + offset, n) + load(hgates + offset, n);
+  if (hidden_bias) {
+    g = g + load(hidden_bias + offset, n);
+  }
+  return g;
+}
+
+// Batch rows every thread should at least compute.
+int64_t rows_grain_size(int64_t gates_per_row) {
+  return std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE / std::max<int64_t>(1, gates_per_row));
+}
+
+template <typename scalar_t>
+void lstm_cell_pointwise_impl(
+    Tensor& hy, Tensor& cy, const Tensor& igates_, const Tensor& hgates_,
+    const Tensor& hidden_bias, const Tensor& cx_) {
+  using Vec = Vec256<scalar_t>;
+  const auto igates = igates_.contiguous();
+  const auto hgates = hgates_.contiguous();
+  const auto cx = cx_.contiguous();
+  TORCH_INTERNAL_ASSERT(hy.is_contiguous() && cy.is_contiguous());
+  const int64_t batch = cx.size(0);
+  const int64_t hidden = cx.size(1);
+  const scalar_t* igates_data = igates.data_ptr<scalar_t>();
+  const scalar_t* hgates_data = hgates.data_ptr<scalar_t>();
+  const scalar_t* bias_data =
+      hidden_bias.defined() ? hidden_bias.data_ptr<scalar_t>() : nullptr;
+  const scalar_t* cx_data = cx.data_ptr<scalar_t>();
+  scalar_t* hy_data = hy.data_ptr<scalar_t>();
+  scalar_t* cy_data = cy.data_ptr<scalar_t>();
+
+  parallel_for(0, batch, rows_grain_size(4 * hidden), [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ig = igates_data + b * 4 * hidden;
+      const scalar_t* hg = hgates_data + b * 4 * hidden;
+      for (int64_t j = 0; j < hidden; j += Vec::size()) {
+        const int64_t n = std::min<int64_t>(Vec::size(), hidden - j);
+        auto ingate = sigmoid(gate(ig, hg, bias_data, j, n));
+        auto forgetgate = sigmoid(gate(ig, hg, bias_data, hidden + j, n));
+        auto cellgate = gate(ig, hg, bias_data, 2 * hidden + j, n).tanh();
+        auto outgate = sigmoid(gate(ig, hg, bias_data, 3 * hidden + j, n));
+        auto c = forgetgate * load(cx_data + b * hidden + j, n) + ingate * cellgate;
+        store(c, cy_data + b * hidden + j, n);
+        store(outgate * c.tanh(), hy_data + b * hidden + j, n);
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+void gru_cell_pointwise_impl(
+    Tensor& hy, const Tensor& igates_, const Tensor& hgates_,
+    const Tensor& hidden_bias, const Tensor& hx_) {
+  using Vec = Vec256<scalar_t>;
+  const auto igates = igates_.contiguous();
+  const auto hgates = hgates_.contiguous();
+  const auto hx = hx_.contiguous();
+  TORCH_INTERNAL_ASSERT(hy.is_contiguous());
+  const int64_t batch = hx.size(0);
+  const int64_t hidden = hx.size(1);
+  const scalar_t* igates_data = igates.data_ptr<scalar_t>();
+  const scalar_t* hgates_data = hgates.data_ptr<scalar_t>();
+  const scalar_t* bias_data =
+      hidden_bias.defined() ? hidden_bias.data_ptr<scalar_t>() : nullptr;
+  const scalar_t* hx_data = hx.data_ptr<scalar_t>();
+  scalar_t* hy_data = hy.data_ptr<scalar_t>();
+
+  parallel_for(0, batch, rows_grain_size(3 * hidden), [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      const scalar_t* ig = igates_data + b * 3 * hidden;
+      const scalar_t* hg = hgates_data + b * 3 * hidden;
+      for (int64_t j = 0; j < hidden; j += Vec::size()) {
+        const int64_t n = std::min<int64_t>(Vec::size(), hidden - j);
+        auto resetgate = sigmoid(gate(ig, hg, bias_data, j, n));
+        auto inputgate = sigmoid(gate(ig, hg, bias_data, hidden + j, n));
+        auto hidden_newgate = load(hg + 2 * hidden + j, n);
+        if (bias_data) {
+          hidden_newgate = hidden_newgate + load(bias_data + 2 * hidden + j, n);
+        }
+        auto newgate =
+            (load(ig + 2 * hidden + j, n) + resetgate * hidden_newgate).tanh();
+        auto h = load(hx_data + b * hidden + j, n);
+        store((h - newgate) * inputgate + newgate, hy_data + b * hidden + j, n);
+      }
+    }
+  });
+}
+
+void lstm_cell_pointwise_kernel(
+    Tensor& hy, Tensor& cy, const Tensor& igates, const Tensor& hgates,
+    const Tensor& hidden_bias, const Tensor& cx) {
+  AT_DISPATCH_FLOATING_TYPES(igates.scalar_type(), "lstm_cell_pointwise", [&] {
+    lstm_cell_pointwise_impl<scalar_t>(hy, cy, igates, hgates, hidden_bias, cx);
+  });
+}
+
+void gru_cell_pointwise_kernel(
+    Tensor& hy, const Tensor& igates, const Tensor& hgates,
+    const Tensor& hidden_bias, const Tensor& hx) {
+  AT_DISPATCH_FLOATING_TYPES(igates.scalar_type(), "gru_cell_pointwise", [&] {
+    gru_cell_pointwise_impl<scalar_t>(hy, igates, hgates, hidden_bias, hx);
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(lstm_cell_pointwise_stub, &lstm_cell_pointwise_kernel);
+REGISTER_DISPATCH(gru_cell_pointwise_stub, &gru_cell_pointwise_kernel);
+
+}} // namespace at::native
@@ -0,0 +1,260 @@
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/NumericUtils.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/ReduceOps.h>
+#include <ATen/native/TensorIterator.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace at { namespace native {
+
+namespace {
+
+// Slices at least two blocks long are scanned block-wise, in parallel when
+// there are fewer slices than threads. Neither the block size nor the choice
+// of the blocked scan depend on the number of threads, so the floating point
+// results don't either.
+constexpr int64_t kScanBlockSize = 16384;
+
+// bool has no accumulate type; sums and products of bools saturate.
+template <typename scalar_t>
+struct ScanAccType { using type = at::acc_type<scalar_t, /*is_cuda=*/false>; };
+template <>
+struct ScanAccType<bool> { using type = bool; };
+
+// Runs loop(data, strides, n) over the first elements of the 1-d slices of
+// `self` along `dim`, with the outputs first as in TensorIterator. Each
+// element of the iteration is a whole slice, so the grain size is scaled
+// down by the slice length. With parallelize_within_slices, few slices are
+// visited serially and the loop is expected to parallelize each of them.
+template <typename loop_t>
+void scan_slices_apply(TensorList outputs, const Tensor& self, int64_t dim, const loop_t& loop,
+                       bool parallelize_within_slices = false) {
+  TensorIterator iter;
+  iter.dont_compute_common_dtype();
+  iter.dont_resize_outputs();
+  for (const Tensor& output : outputs) {
+    iter.add_output(output.narrow(dim, 0, 1));
+  }
+  iter.add_input(self.narrow(dim, 0, 1));
+  iter.build();
+  const int64_t dim_size = self.size(dim);
+  const int64_t grain_size = std::max<int64_t>(1, divup(internal::GRAIN_SIZE, dim_size));
+  if (parallelize_within_slices && iter.numel() < at::get_num_threads()) {
+    iter.serial_for_each(loop, {0, iter.numel()});
+  } else {
+    iter.for_each(loop, grain_size);
+  }
+}
+
+template <typename scalar_t, typename acc_t, typename op_t>
+inline acc_t scan_slice(scalar_t* result, int64_t result_stride,
+                        const scalar_t* self, int64_t self_stride,
+                        int64_t begin, int64_t end, acc_t acc, const op_t& op) {
+  for (int64_t k = begin; k < end; k++) {
+    acc = op(acc, static_cast<acc_t>(self[k * self_stride]));
+    result[k * result_stride] = static_cast<scalar_t>(acc);
+  }
+  return acc;
+}
+
+template <typename scalar_t, typename acc_t, typename op_t>
+inline acc_t reduce_slice(const scalar_t* self, int64_t self_stride,
+                          int64_t begin, int64_t end, acc_t acc, const op_t& op) {
+  for (int64_t k = begin; k < end; k++) {
+    acc = op(acc, static_cast<acc_t>(self[k * self_stride]));
+  }
+  return acc;
+}
+
+// Inclusive scan of a single long slice: the totals of the blocks are
+// reduced in parallel, turned into per-block carries and every block is then
+// rescanned in parallel starting from its carry.
+template <typename scalar_t, typename acc_t, typename op_t>
+void blocked_scan_slice(scalar_t* result, int64_t result_stride,
+                        const scalar_t* self, int64_t self_stride,
+                        int64_t dim_size, acc_t init, const op_t& op) {
+  const int64_t num_blocks = divup(dim_size, kScanBlockSize);
+  std::vector<acc_t> carries(num_blocks, init);
+  at::parallel_for(0, num_blocks - 1, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      carries[b + 1] = reduce_slice(self, self_stride, b * kScanBlockSize,
+                                    (b + 1) * kScanBlockSize, init, op);
+    }
+  });
+  for (int64_t b = 1; b < num_blocks; b++) {
+    carries[b] = op(carries[b - 1], carries[b]);
+  }
+  at::parallel_for(0, num_blocks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t b = begin; b < end; b++) {
+      scan_slice(result, result_stride, self, self_stride, b * kScanBlockSize,
+                 std::min((b + 1) * kScanBlockSize, dim_size), carries[b], op);
+    }
+  });
+}
+
+template <typename scalar_t, typename op_t>
+void cpu_cum_base_kernel(Tensor& result, const Tensor& self, int64_t dim,
+                         typename ScanAccType<scalar_t>::type init, const op_t& op) {
+  using acc_t = typename ScanAccType<scalar_t>::type;
+  if (self.dim() == 0) {
+    result.copy_(self);
+    return;
+  }
+  const int64_t dim_size = self.size(dim);
+  const int64_t result_dim_stride = result.stride(dim);
+  const int64_t self_dim_stride = self.stride(dim);
+  const bool blocked = dim_size >= 2 * kScanBlockSize;
+  auto loop = [&](char** data, const int64_t* strides, int64_t n) {
+    char* result_data = data[0];
+    const char* self_data = data[1];
+    if (blocked) {
+      for (int64_t i = 0; i < n; i++) {
+        blocked_scan_slice(
+            reinterpret_cast<scalar_t*>(result_data + i * strides[0]), result_dim_stride,
+            reinterpret_cast<const scalar_t*>(self_data + i * strides[1]), self_dim_stride,
+            dim_size, init, op);
+      }
+    } else if (n > 1 && strides[0] == sizeof(scalar_t) && strides[1] == sizeof(scalar_t)) {
+      // The slices are adjacent in memory: advance all of them one step at a
+      // time so that the inner loop runs over contiguous elements.
+      auto result_ptr = reinterpret_cast<scalar_t*>(result_data);
+      auto self_ptr = reinterpret_cast<const scalar_t*>(self_data);
+      std::vector<acc_t> acc(n, init);
+      for (int64_t k = 0; k < dim_size; k++) {
+        scalar_t* out = result_ptr + k * result_dim_stride;
+        const scalar_t* in = self_ptr + k * self_dim_stride;
+        for (int64_t i = 0; i < n; i++) {
+          acc[i] = op(acc[i], static_cast<acc_t>(in[i]));
+          out[i] = static_cast<scalar_t>(acc[i]);
+        }
+      }
+    } else {
+      for (int64_t i = 0; i < n; i++) {
+        scan_slice(
+            reinterpret_cast<scalar_t*>(result_data + i * strides[0]), result_dim_stride,
+            reinterpret_cast<const scalar_t*>(self_data + i * strides[1]), self_dim_stride,
+            0, dim_size, init, op);
+      }
+    }
+  };
+  scan_slices_apply({result}, self, dim, loop, /*parallelize_within_slices=*/blocked);
+}
+
+template <typename T>
+inline T log_add_exp(T x, T y) {
+  if (at::_isnan(x) || at::_isnan(y)) {
+    return std::numeric_limits<T>::quiet_NaN();
+  }
+  T max = std::max(x, y);
+  T min = std::min(x, y);
+  if (std::isinf(max)) {
+    // either +inf, or both arguments are -inf
+    return max;
+  }
+  return max + std::log1p(std::exp(min - max));
+}
+
+static void cumsum_cpu_kernel(Tensor& result, const Tensor& self, int64_t dim) {
+  if (self.numel() == 0) {
+    return;
+  }
+  AT_DISPATCH_ALL_TYPES_AND(kBool, self.scalar_type(), "cumsum_cpu", [&] {
+    using acc_t = typename ScanAccType<scalar_t>::type;
+    cpu_cum_base_kernel<scalar_t>(result, self, dim, acc_t(0),
+        [](acc_t a, acc_t b) -> acc_t { return a + b; });
+  });
+}
+
+static void cumprod_cpu_kernel(Tensor& result, const Tensor& self, int64_t dim) {
+  if (self.numel() == 0) {
+    return;
+  }
+  AT_DISPATCH_ALL_TYPES_AND(kBool, self.scalar_type(), "cumprod_cpu", [&] {
+    using acc_t = typename ScanAccType<scalar_t>::type;
+    cpu_cum_base_kernel<scalar_t>(result, self, dim, acc_t(1),
+        [](acc_t a, acc_t b) -> acc_t { return a * b; });
+  });
+}
+
+static void logcumsumexp_cpu_kernel(Tensor& result, const Tensor& self, int64_t dim) {
+  if (self.numel() == 0) {
+    return;
+  }
+  AT_DISPATCH_FLOATING_TYPES(self.scalar_type(), "logcumsumexp_cpu", [&] {
+    using acc_t = typename ScanAccType<scalar_t>::type;
+    cpu_cum_base_kernel<scalar_t>(result, self, dim, -std::numeric_limits<acc_t>::infinity(),
+        [](acc_t a, acc_t b) -> acc_t { return log_add_exp(a, b); });
+  });
+}
+
+// The running extremum and its index along `dim`. A NaN is propagated from
+// the first position it appears at; ties move the index to the latest
+// position.
+template <typename scalar_t, typename cmp_t>
+void cpu_cummax_cummin_kernel(Tensor& values, Tensor& indices, const Tensor& self,
+                              int64_t dim, const cmp_t& cmp) {
+  if (self.dim() == 0) {
+    values.copy_(self);
+    indices.fill_(0);
+    return;
+  }
+  const int64_t dim_size = self.size(dim);
+  const int64_t values_dim_stride = values.stride(dim);
+  const int64_t indices_dim_stride = indices.stride(dim);
+  const int64_t self_dim_stride = self.stride(dim);
+  auto loop = [&](char** data, const int64_t* strides, int64_t n) {
+    for (int64_t i = 0; i < n; i++) {
+      auto values_ptr = reinterpret_cast<scalar_t*>(data[0] + i * strides[0]);
+      auto indices_ptr = reinterpret_cast<int64_t*>(data[1] + i * strides[1]);
+      auto self_ptr = reinterpret_cast<const scalar_t*>(data[2] + i * strides[2]);
+      scalar_t best = self_ptr[0];
+      int64_t best_idx = 0;
+      for (int64_t k = 0; k < dim_size; k++) {
+        const scalar_t x = self_ptr[k * self_dim_stride];
+        if (!at::_isnan(best) && (at::_isnan(x) || cmp(x, best))) {
+          best = x;
+          best_idx = k;
+        }
+        values_ptr[k * values_dim_stride] = best;
+        indices_ptr[k * indices_dim_stride] = best_idx;
+      }
+    }
+  };
+  scan_slices_apply({values, indices}, self, dim, loop);
+}
+
+static void cummax_cpu_kernel(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim) {
+  if (self.numel() == 0) {
+    return;
+  }
+  AT_DISPATCH_ALL_TYPES_AND(kBool, self.scalar_type(), "cummax_cpu", [&] {
+    cpu_cummax_cummin_kernel<scalar_t>(values, indices, self, dim,
+        [](scalar_t a, scalar_t b) { return a >= b; });
+  });
+}
+
+static void cummin_cpu_kernel(Tensor& values, Tensor& indices, const Tensor& self, int64_t dim) {
+  if (self.numel() == 0) {
+    return;
+  }
+  AT_DISPATCH_ALL_TYPES_AND(kBool, self.scalar_type(), "cummin_cpu", [&] {
+    cpu_cummax_cummin_kernel<scalar_t>(values, indices, self, dim,
+        [](scalar_t a, scalar_t b) { return a <= b; });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(cumsum_stub, &cumsum_cpu_kernel);
+REGISTER_DISPATCH(cumprod_stub, &cumprod_cpu_kernel);
+REGISTER_DISPATCH(logcumsumexp_stub, &logcumsumexp_cpu_kernel);
+REGISTER_DISPATCH(cummax_stub, &cummax_cpu_kernel);
+REGISTER_DISPATCH(cummin_stub, &cummin_cpu_kernel);
+
+}} // namespace at::native
@@ -0,0 +1,257 @@
+#include <ATen/native/ScatterGather.h>
+
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+namespace at { namespace native {
+namespace {
+
+// The ops go over the rows along dim of index, one per position in its other
+// dimensions. A row of the tensor written to is only ever written from the
+// matching row of index, so tasks made of whole rows never race, even for
+// scatter_add_ with duplicate indices, and every element is updated in the
+// order of its row: the results are the same as a serial loop.
+
+int64_t legacy_stride(const Tensor& t, int64_t dim) {
+  return t.dim() == 0 ? 1 : t.stride(dim);
+}
+
+// The positions of the rows of index, as the sizes of its other dimensions,
+// and the strides of dst, index and src along them.
+struct RowLayout {
+  RowLayout(const Tensor& dst, const Tensor& index, const Tensor& src, int64_t dim) {
+    for (int64_t d = 0; d < std::max<int64_t>(index.dim(), 1); d++) {
+      if (d == dim) {
+        continue;
+      }
+      sizes.push_back(index.size(d));
+      dst_strides.push_back(dst.stride(d));
+      index_strides.push_back(index.stride(d));
+      src_strides.push_back(src.stride(d));
+    }
+    if (sizes.empty()) {
+      sizes.push_back(1);
+      dst_strides.push_back(0);
+      index_strides.push_back(0);
+      src_strides.push_back(0);
+    }
+    rows = 1;
+    for (auto size : sizes) {
+      rows *= size;
+    }
+  }
+
+  // The offsets of the row at `position`.
+  void offsets(int64_t position, int64_t& dst, int64_t& index, int64_t& src) const {
+    dst = index = src = 0;
+    for (int64_t d = sizes.size() - 1; d >= 0; d--) {
+      const int64_t idx = position % sizes[d];
+      position /= sizes[d];
+      dst += idx * dst_strides[d];
+      index += idx * index_strides[d];
+      src += idx * src_strides[d];
+    }
+  }
+
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> dst_strides;
+  std::vector<int64_t> index_strides;
+  std::vector<int64_t> src_strides;
+  int64_t rows;
+};
+
+// With indexes_dst, op(dst[...][index[...][i][...]][...], src[...][i][...])
+// (scatter); otherwise op(dst[...][i][...], src[...][index[...][i][...]][...])
+// (gather). Tasks are blocks of consecutive rows, and runs of rows along the
+// innermost of the other dimensions are walked together, along the rows or
+// across them, whichever index is more contiguous along.
+template <typename scalar_t, bool indexes_dst, typename op_t>
+void scatter_gather_loop(
+    const char* name, const Tensor& dst, int64_t dim, const Tensor& index,
+    const Tensor& src, const op_t& op) {
+  const RowLayout layout(dst, index, src, dim);
+  const int64_t row_size = index.dim() == 0 ? 1 : index.size(dim);
+  const int64_t indexed_size = indexes_dst
+      ? (dst.dim() == 0 ? 1 : dst.size(dim))
+      : (src.dim() == 0 ? 1 : src.size(dim));
+  const int64_t dst_dim_stride = legacy_stride(dst, dim);
+  const int64_t index_dim_stride = legacy_stride(index, dim);
+  const int64_t src_dim_stride = legacy_stride(src, dim);
+
+  const int64_t run_size = layout.sizes.back();
+  const int64_t dst_run_stride = layout.dst_strides.back();
+  const int64_t index_run_stride = layout.index_strides.back();
+  const int64_t src_run_stride = layout.src_strides.back();
+  const bool along_rows = std::abs(index_dim_stride) <= std::abs(index_run_stride);
+
+  scalar_t* dst_data = dst.data_ptr<scalar_t>();
+  const int64_t* index_data = index.data_ptr<int64_t>();
+  const scalar_t* src_data = src.data_ptr<scalar_t>();
+
+  const int64_t grain_size = std::max<int64_t>(1, internal::GRAIN_SIZE / row_size);
+  at::parallel_for(0, layout.rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t position = begin; position < end;) {
+      const int64_t first = position % run_size;
+      const int64_t runs = std::min(run_size - first, end - position);
+      int64_t dst_offset, index_offset, src_offset;
+      layout.offsets(position, dst_offset, index_offset, src_offset);
+      scalar_t* dst_run = dst_data + dst_offset;
+      const int64_t* index_run = index_data + index_offset;
+      const scalar_t* src_run = src_data + src_offset;
+
+      auto element = [&](int64_t r, int64_t i) {
+        const int64_t idx = index_run[r * index_run_stride + i * index_dim_stride];
+        TORCH_CHECK_INDEX(idx >= 0 && idx < indexed_size,
+            name, "(): index ", idx, " is out of bounds for dimension ", dim,
+            " with size ", indexed_size);
+        if (indexes_dst) {
+          op(dst_run[r * dst_run_stride + idx * dst_dim_stride],
+             src_run[r * src_run_stride + i * src_dim_stride]);
+        } else {
+          op(dst_run[r * dst_run_stride + i * dst_dim_stride],
+             src_run[r * src_run_stride + idx * src_dim_stride]);
+        }
+      };
+      if (along_rows) {
+        for (int64_t r = 0; r < runs; r++) {
+          for (int64_t i = 0; i < row_size; i++) {
+            element(r, i);
+          }
+        }
+      } else {
+        for (int64_t i = 0; i < row_size; i++) {
+          for (int64_t r = 0; r < runs; r++) {
+            element(r, i);
+          }
+        }
+      }
+      position += runs;
+    }
+  });
+}
+
+// The number of chunks a row of scatter_add_ is split into when there are too
+// few rows to keep the threads busy. Each chunk accumulates into a buffer of
+// its own, and the buffers are summed in chunk order. The chunks only depend
+// on the size of the rows, so the results don't depend on the number of threads.
+constexpr int64_t kMaxScatterAddChunks = 16;
+
+template <typename scalar_t>
+int64_t scatter_add_chunks(const Tensor& self, int64_t dim, const Tensor& index) {
+  // Half, BFloat16 and bool accumulate in scalar_t in the serial loop too,
+  // but not associatively enough to split.
+  if (!std::is_arithmetic<scalar_t>::value || std::is_same<scalar_t, bool>::value) {
+    return 1;
+  }
+  const int64_t row_size = index.dim() == 0 ? 1 : index.size(dim);
+  const int64_t dst_size = self.dim() == 0 ? 1 : self.size(dim);
+  const int64_t rows = index.numel() / row_size;
+  if (rows >= at::get_num_threads()) {
+    return 1;
+  }
+  // The buffers are only worth it when they are smaller than the rows.
+  int64_t chunks = std::min(kMaxScatterAddChunks, row_size / internal::GRAIN_SIZE);
+  while (chunks > 1 && chunks * dst_size > row_size) {
+    chunks--;
+  }
+  return std::max<int64_t>(chunks, 1);
+}
+
+template <typename scalar_t>
+void scatter_add_chunked(const Tensor& self, int64_t dim, const Tensor& index,
+                         const Tensor& src, int64_t chunks) {
+  const RowLayout layout(self, index, src, dim);
+  const int64_t rows = layout.rows;
+  const int64_t row_size = index.dim() == 0 ? 1 : index.size(dim);
+  const int64_t dst_size = self.dim() == 0 ? 1 : self.size(dim);
+  const int64_t dst_dim_stride = legacy_stride(self, dim);
+  const int64_t index_dim_stride = legacy_stride(index, dim);
+  const int64_t src_dim_stride = legacy_stride(src, dim);
+
+  std::vector<int64_t> dst_offsets(rows), index_offsets(rows), src_offsets(rows);
+  for (int64_t r = 0; r < rows; r++) {
+    layout.offsets(r, dst_offsets[r], index_offsets[r], src_offsets[r]);
+  }
+
+  scalar_t* dst_data = self.data_ptr<scalar_t>();
+  const int64_t* index_data = index.data_ptr<int64_t>();
+  const scalar_t* src_data = src.data_ptr<scalar_t>();
+  Tensor buffer_tensor = at::zeros({chunks * rows * dst_size}, self.options());
+  scalar_t* buffers = buffer_tensor.data_ptr<scalar_t>();
+
+  at::parallel_for(0, chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      const int64_t first = row_size * c / chunks;
+      const int64_t last = row_size * (c + 1) / chunks;
+      for (int64_t r = 0; r < rows; r++) {
+        scalar_t* buffer = buffers + (c * rows + r) * dst_size;
+        const int64_t* index_row = index_data + index_offsets[r];
+        const scalar_t* src_row = src_data + src_offsets[r];
+        for (int64_t i = first; i < last; i++) {
+          const int64_t idx = index_row[i * index_dim_stride];
+          TORCH_CHECK_INDEX(idx >= 0 && idx < dst_size,
+              "scatter_add_(): index ", idx, " is out of bounds for dimension ", dim,
+              " with size ", dst_size);
+          buffer[idx] += src_row[i * src_dim_stride];
+        }
+      }
+    }
+  });
+
+  const int64_t elements = rows * dst_size;
+  at::parallel_for(0, elements, internal::GRAIN_SIZE / chunks, [&](int64_t begin, int64_t end) {
+    for (int64_t e = begin; e < end; e++) {
+      scalar_t sum = buffers[e];
+      for (int64_t c = 1; c < chunks; c++) {
+        sum += buffers[c * elements + e];
+      }
+      const int64_t r = e / dst_size;
+      dst_data[dst_offsets[r] + (e % dst_size) * dst_dim_stride] += sum;
+    }
+  });
+}
+
+void gather_kernel(Tensor& result, const Tensor& self, int64_t dim, const Tensor& index) {
+  AT_DISPATCH_ALL_TYPES_AND3(ScalarType::Bool, ScalarType::Half, ScalarType::BFloat16,
+      self.scalar_type(), "gather_cpu", [&] {
+    scatter_gather_loop<scalar_t, /*indexes_dst=*/false>(
+        "gather", result, dim, index, self,
+        [](scalar_t& dst, const scalar_t& src) { dst = src; });
+  });
+}
+
+void scatter_kernel(Tensor& self, int64_t dim, const Tensor& index, const Tensor& src) {
+  AT_DISPATCH_ALL_TYPES_AND3(ScalarType::Bool, ScalarType::Half, ScalarType::BFloat16,
+      self.scalar_type(), "scatter_cpu_", [&] {
+    scatter_gather_loop<scalar_t, /*indexes_dst=*/true>(
+        "scatter_", self, dim, index, src,
+        [](scalar_t& dst, const scalar_t& src) { dst = src; });
+  });
+}
+
+void scatter_add_kernel(Tensor& self, int64_t dim, const Tensor& index, const Tensor& src) {
+  AT_DISPATCH_ALL_TYPES_AND3(ScalarType::Bool, ScalarType::Half, ScalarType::BFloat16,
+      self.scalar_type(), "scatter_add_cpu_", [&] {
+    const int64_t chunks = scatter_add_chunks<scalar_t>(self, dim, index);
+    if (chunks > 1) {
+      scatter_add_chunked<scalar_t>(self, dim, index, src, chunks);
+      return;
+    }
+    scatter_gather_loop<scalar_t, /*indexes_dst=*/true>(
+        "scatter_add_", self, dim, index, src,
+        [](scalar_t& dst, const scalar_t& src) { dst += src; });
+  });
+}
+
+} // anonymous namespace
+
+REGISTER_DISPATCH(gather_stub, &gather_kernel);
+REGISTER_DISPATCH(scatter_stub, &scatter_kernel);
+REGISTER_DISPATCH(scatter_add_stub, &scatter_add_kernel);
+
+}} // namespace at::native
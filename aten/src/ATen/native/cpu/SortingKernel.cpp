@@ -5,10 +5,282 @@
 #include <ATen/native/Sorting.h>
 #include <ATen/native/SortingUtils.h>
 
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
 namespace at { namespace native {
 
 namespace {
 
+// Slices shorter than this are sorted with std::sort; the fixed cost of the
+// per-pass histograms makes radix sort lose on short inputs.
+constexpr int64_t kRadixSortThreshold = 512;
+
+// Calls f(offsets, scratch) for every 1-d slice along `dim`, where offsets[i]
+// is the element offset of the slice start in tensors[i]. Unlike dim_apply
+// this never materializes a narrowed Tensor per slice, and the slices are
+// split across threads in chunks of roughly GRAIN_SIZE elements. Each chunk
+// gets its own default-constructed Scratch so that slice buffers can be
+// reused without locking.
+template <typename Scratch, typename Fn>
+void parallel_slice_apply(TensorList tensors, int64_t dim, Fn f) {
+  const Tensor& t = tensors[0];
+  int64_t ndim = t.dim();
+  int64_t dim_size = t.size(dim);
+  if (dim_size == 0) {
+    return;
+  }
+  int64_t num_slices = t.numel() / dim_size;
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / dim_size);
+  parallel_for(0, num_slices, grain_size, [&](int64_t begin, int64_t end) {
+    Scratch scratch;
+    std::vector<int64_t> offsets(tensors.size());
+    for (int64_t slice = begin; slice < end; slice++) {
+      std::fill(offsets.begin(), offsets.end(), 0);
+      int64_t linear = slice;
+      for (int64_t d = ndim - 1; d >= 0; d--) {
+        if (d == dim) {
+          continue;
+        }
+        int64_t idx = linear % t.size(d);
+        linear /= t.size(d);
+        for (size_t i = 0; i < tensors.size(); i++) {
+          offsets[i] += idx * tensors[i].stride(d);
+        }
+      }
+      f(offsets.data(), scratch);
+    }
+  });
+}
+
+// Maps a value to an unsigned key whose natural ordering matches the
+// ascending order of the value, with NaN ordered above everything else to
+// match the comparison based paths.
+template <typename scalar_t, typename Enable = void>
+struct RadixKey;
+
+template <typename scalar_t>
+struct RadixKey<scalar_t, typename std::enable_if<std::is_integral<scalar_t>::value>::type> {
+  using type = typename std::make_unsigned<scalar_t>::type;
+  static type encode(scalar_t value) {
+    type key = static_cast<type>(value);
+    if (std::is_signed<scalar_t>::value) {
+      key ^= type(1) << (sizeof(type) * 8 - 1);
+    }
+    return key;
+  }
+};
+
+template <typename scalar_t>
+struct RadixKey<scalar_t, typename std::enable_if<std::is_floating_point<scalar_t>::value>::type> {
+  using type = typename std::conditional<sizeof(scalar_t) == 4, uint32_t, uint64_t>::type;
+  static type encode(scalar_t value) {
+    if (_isnan<scalar_t>(value)) {
+      return ~type(0);
+    }
+    type key;
+    std::memcpy(&key, &value, sizeof(key));
+    constexpr type sign_bit = type(1) << (sizeof(type) * 8 - 1);
+    // Negative values have their order reversed by flipping every bit;
+    // positive values only need to move above the negative ones.
+    return (key & sign_bit) ? ~key : (key | sign_bit);
+  }
+};
+
+template <typename scalar_t>
+struct SortScratch {
+  using key_t = typename RadixKey<scalar_t>::type;
+  std::vector<scalar_t> values;
+  std::vector<key_t> keys;
+  std::vector<key_t> keys_tmp;
+  std::vector<int64_t> indices;
+  std::vector<int64_t> indices_tmp;
+  std::vector<std::pair<scalar_t, int64_t>> pairs;
+};
+
+// Stable LSD radix sort of (keys, indices) on 8-bit digits. Passes where every
+// key shares the same digit are skipped, which makes small-range integer
+// keys cost a single histogram per byte. The sorted result is left in
+// `keys` / `indices`; the *_tmp vectors are clobbered.
+template <typename key_t>
+void radix_sort_pairs(
+    std::vector<key_t>& keys,
+    std::vector<int64_t>& indices,
+    std::vector<key_t>& keys_tmp,
+    std::vector<int64_t>& indices_tmp) {
+  constexpr int kRadixBits = 8;
+  constexpr int kRadixSize = 1 << kRadixBits;
+  const int64_t n = keys.size();
+  keys_tmp.resize(n);
+  indices_tmp.resize(n);
+  for (size_t shift = 0; shift < sizeof(key_t) * 8; shift += kRadixBits) {
+    int64_t counts[kRadixSize] = {0};
+    for (int64_t i = 0; i < n; i++) {
+      counts[(static_cast<uint64_t>(keys[i]) >> shift) & (kRadixSize - 1)]++;
+    }
+    if (counts[(static_cast<uint64_t>(keys[0]) >> shift) & (kRadixSize - 1)] == n) {
+      continue;
+    }
+    int64_t offset = 0;
+    for (int b = 0; b < kRadixSize; b++) {
+      int64_t count = counts[b];
+      counts[b] = offset;
+      offset += count;
+    }
+    for (int64_t i = 0; i < n; i++) {
+      int64_t pos = counts[(static_cast<uint64_t>(keys[i]) >> shift) & (kRadixSize - 1)]++;
+      keys_tmp[pos] = keys[i];
+      indices_tmp[pos] = indices[i];
+    }
+    std::swap(keys, keys_tmp);
+    std::swap(indices, indices_tmp);
+  }
+}
+
+template <typename scalar_t>
+void sort_slice(
+    scalar_t* values,
+    int64_t values_stride,
+    int64_t* indices,
+    int64_t indices_stride,
+    int64_t n,
+    bool descending,
+    SortScratch<scalar_t>& scratch) {
+  using key_t = typename RadixKey<scalar_t>::type;
+  if (n < kRadixSortThreshold) {
+    auto& pairs = scratch.pairs;
+    pairs.resize(n);
+    for (int64_t i = 0; i < n; i++) {
+      pairs[i].first = values[i * values_stride];
+      pairs[i].second = i;
+    }
+    using elem_t = std::pair<scalar_t, int64_t>;
+    // NaN is sorted as the largest value for numpy compatibility
+    if (descending) {
+      std::sort(pairs.begin(), pairs.end(),
+        [](const elem_t& x, const elem_t& y) -> bool {
+          return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
+        });
+    } else {
+      std::sort(pairs.begin(), pairs.end(),
+        [](const elem_t& x, const elem_t& y) -> bool {
+          return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
+        });
+    }
+    for (int64_t i = 0; i < n; i++) {
+      values[i * values_stride] = pairs[i].first;
+      indices[i * indices_stride] = pairs[i].second;
+    }
+    return;
+  }
+
+  auto& src = scratch.values;
+  auto& keys = scratch.keys;
+  auto& perm = scratch.indices;
+  src.resize(n);
+  keys.resize(n);
+  perm.resize(n);
+  for (int64_t i = 0; i < n; i++) {
+    src[i] = values[i * values_stride];
+    key_t key = RadixKey<scalar_t>::encode(src[i]);
+    keys[i] = descending ? static_cast<key_t>(~key) : key;
+    perm[i] = i;
+  }
+  radix_sort_pairs(keys, perm, scratch.keys_tmp, scratch.indices_tmp);
+  for (int64_t i = 0; i < n; i++) {
+    values[i * values_stride] = src[perm[i]];
+    indices[i * indices_stride] = perm[i];
+  }
+}
+
+static void sort_kernel(
+    Tensor& values,
+    Tensor& indices,
+    int64_t dim,
+    bool descending) {
+  AT_DISPATCH_ALL_TYPES(values.scalar_type(), "sort_cpu", [&] {
+    scalar_t* values_data = values.data_ptr<scalar_t>();
+    int64_t* indices_data = indices.data_ptr<int64_t>();
+    int64_t n = values.size(dim);
+    int64_t values_stride = values.stride(dim);
+    int64_t indices_stride = indices.stride(dim);
+    parallel_slice_apply<SortScratch<scalar_t>>(
+        {values, indices},
+        dim,
+        [&](const int64_t* offsets, SortScratch<scalar_t>& scratch) {
+          sort_slice<scalar_t>(
+              values_data + offsets[0],
+              values_stride,
+              indices_data + offsets[1],
+              indices_stride,
+              n,
+              descending,
+              scratch);
+        });
+  });
+}
+
+template <typename scalar_t>
+struct TopkScratch {
+  std::vector<std::pair<scalar_t, int64_t>> queue;
+};
+
+template <typename scalar_t, typename Comp>
+void topk_slice(
+    const scalar_t* self,
+    int64_t self_stride,
+    int64_t n,
+    scalar_t* values,
+    int64_t values_stride,
+    int64_t* indices,
+    int64_t indices_stride,
+    int64_t k,
+    bool sorted,
+    Comp comes_before,
+    std::vector<std::pair<scalar_t, int64_t>>& queue) {
+  auto use_partial_selection = k * 64 <= n;
+
+  if (use_partial_selection) {
+    // Keep a heap of the best k elements seen so far with the worst of them
+    // on top, so that most elements are rejected by a single comparison
+    // instead of being copied into an n element buffer.
+    queue.resize(k);
+    for (int64_t j = 0; j < k; j++) {
+      queue[j].first = self[j * self_stride];
+      queue[j].second = j;
+    }
+    std::make_heap(queue.begin(), queue.end(), comes_before);
+    for (int64_t j = k; j < n; j++) {
+      std::pair<scalar_t, int64_t> elem(self[j * self_stride], j);
+      if (comes_before(elem, queue.front())) {
+        std::pop_heap(queue.begin(), queue.end(), comes_before);
+        queue.back() = elem;
+        std::push_heap(queue.begin(), queue.end(), comes_before);
+      }
+    }
+    if (sorted) {
+      std::sort_heap(queue.begin(), queue.end(), comes_before);
+    }
+  } else {
+    queue.resize(n);
+    for (int64_t j = 0; j < n; j++) {
+      queue[j].first = self[j * self_stride];
+      queue[j].second = j;
+    }
+    std::nth_element(queue.begin(), queue.begin() + k - 1, queue.end(), comes_before);
+    if (sorted) {
+      std::sort(queue.begin(), queue.begin() + k - 1, comes_before);
+    }
+  }
+
+  for (int64_t j = 0; j < k; j++) {
+    values[j * values_stride] = queue[j].first;
+    indices[j * indices_stride] = queue[j].second;
+  }
+}
+
 static void topk_kernel(
     Tensor& values,
     Tensor& indices,
@@ -17,67 +289,44 @@ static void topk_kernel(
     int64_t dim,
     bool largest,
     bool sorted) {
+  if (k == 0) {
+    return;
+  }
   AT_DISPATCH_ALL_TYPES(self.scalar_type(), "topk_cpu", [&] {
-    dim_apply(
+    const scalar_t* self_data = self.data_ptr<scalar_t>();
+    scalar_t* values_data = values.data_ptr<scalar_t>();
+    int64_t* indices_data = indices.data_ptr<int64_t>();
+    int64_t n = self.size(dim);
+    int64_t self_stride = self.stride(dim);
+    int64_t values_stride = values.stride(dim);
+    int64_t indices_stride = indices.stride(dim);
+
+    using elem_t = std::pair<scalar_t, int64_t>;
+    parallel_slice_apply<TopkScratch<scalar_t>>(
         {self, values, indices},
         dim,
-        [&](int64_t i, TensorList tl) {
-          auto tmp_values = tl[0].accessor<scalar_t, 1>();
-          auto mode_values = tl[1].accessor<scalar_t, 1>();
-          auto mode_indices = tl[2].accessor<int64_t, 1>();
-
-          auto n = tmp_values.size(0);
-          auto use_partial_sort = k * 64 <= n;
-
-          using elem_t = std::pair<scalar_t, int64_t>;
-          std::vector<elem_t> queue(n);
-          for (int64_t j = 0; j < n; j++) {
-            queue[j].first = tmp_values[j];
-            queue[j].second = j;
-          }
-
+        [&](const int64_t* offsets, TopkScratch<scalar_t>& scratch) {
           // we want NaN to be sorted as top for numpy compatibility
-          if (use_partial_sort) {
-            if (largest) {
-              std::partial_sort(queue.begin(), queue.begin() + k, queue.end(),
+          if (largest) {
+            topk_slice<scalar_t>(
+                self_data + offsets[0], self_stride, n,
+                values_data + offsets[1], values_stride,
+                indices_data + offsets[2], indices_stride,
+                k, sorted,
                 [](const elem_t& x, const elem_t& y) -> bool {
                   return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                });
-            } else {
-              std::partial_sort(queue.begin(), queue.begin() + k, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                });
-            }
+                },
+                scratch.queue);
           } else {
-            if (largest) {
-              std::nth_element(queue.begin(), queue.begin() + k - 1, queue.end(),
-                [](const elem_t& x, const elem_t& y) -> bool {
-                  return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                });
-              if (sorted) {
-                std::sort(queue.begin(), queue.begin() + k - 1,
-                  [](const elem_t& x, const elem_t& y) -> bool {
-                    return ((_isnan<scalar_t>(x.first) && !_isnan<scalar_t>(y.first)) || (x.first > y.first));
-                  });
-              }
-            } else {
-              std::nth_element(queue.begin(), queue.begin() + k -1, queue.end(),
+            topk_slice<scalar_t>(
+                self_data + offsets[0], self_stride, n,
+                values_data + offsets[1], values_stride,
+                indices_data + offsets[2], indices_stride,
+                k, sorted,
                 [](const elem_t& x, const elem_t& y) -> bool {
                   return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                });
-              if (sorted) {
-                std::sort(queue.begin(), queue.begin() + k -1,
-                  [](const elem_t& x, const elem_t& y) -> bool {
-                    return ((!_isnan<scalar_t>(x.first) && _isnan<scalar_t>(y.first)) || (x.first < y.first));
-                  });
-              }
-            }
-          }
-
-          for (int64_t j = 0; j < k; j++) {
-            mode_values[j] = queue[j].first;
-            mode_indices[j] = queue[j].second;
+                },
+                scratch.queue);
           }
         });
   });
@@ -85,6 +334,7 @@ static void topk_kernel(
 
 } // anonymous namespace
 
+REGISTER_DISPATCH(sort_stub, &sort_kernel);
 REGISTER_DISPATCH(topk_stub, &topk_kernel);
 
 }} //at::native
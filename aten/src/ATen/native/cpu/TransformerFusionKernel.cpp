@@ -0,0 +1,196 @@
+#define _USE_MATH_DEFINES
+
+#include <ATen/native/TransformerFusion.h>
+
+#include <math.h>
+
+#include <algorithm>
+
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+namespace at {
+namespace native {
+
+namespace {
+
+// Every task gets about GRAIN_SIZE elements, in whole rows.
+int64_t RowGrainSize(int64_t N) {
+  return std::max<int64_t>(1, internal::GRAIN_SIZE / N);
+}
+
+template <typename T>
+void FusedBiasGeluKernelImplInternal(
+    const Tensor& X,
+    const Tensor& bias,
+    int64_t M,
+    int64_t N,
+    Tensor* Y) {
+  using Vec = vec256::Vec256<T>;
+  const T* X_data = X.data_ptr<T>();
+  const T* bias_data = bias.data_ptr<T>();
+  T* Y_data = Y->data_ptr<T>();
+  const Vec kAlpha(static_cast<T>(M_SQRT1_2));
+  const Vec kHalf(static_cast<T>(0.5));
+  const Vec kOne(static_cast<T>(1));
+  parallel_for(0, M, RowGrainSize(N), [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const T* X_ptr = X_data + i * N;
+      T* Y_ptr = Y_data + i * N;
+      for (int64_t j = 0; j < N; j += Vec::size()) {
+        const int64_t count = std::min<int64_t>(Vec::size(), N - j);
+        const Vec x =
+            Vec::loadu(X_ptr + j, count) + Vec::loadu(bias_data + j, count);
+        const Vec y = x * kHalf * (kOne + (x * kAlpha).erf());
+        y.store(Y_ptr + j, count);
+      }
+    }
+  });
+}
+
+template <typename T>
+void FusedAddLayerNormKernelImplInternal(
+    const Tensor& X,
+    const Tensor& residual,
+    const Tensor& gamma,
+    const Tensor& beta,
+    int64_t M,
+    int64_t N,
+    double eps,
+    Tensor* Y) {
+  using Vec = vec256::Vec256<T>;
+  const T* X_data = X.data_ptr<T>();
+  const T* R_data = residual.data_ptr<T>();
+  const T* gamma_data = gamma.defined() ? gamma.data_ptr<T>() : nullptr;
+  const T* beta_data = beta.defined() ? beta.data_ptr<T>() : nullptr;
+  T* Y_data = Y->data_ptr<T>();
+  const T c = T(1) / static_cast<T>(N);
+  parallel_for(0, M, RowGrainSize(N), [&](int64_t begin, int64_t end) {
+    __at_align32__ T sum_arr[Vec::size()];
+    __at_align32__ T sq_arr[Vec::size()];
+    for (int64_t i = begin; i < end; ++i) {
+      const T* X_ptr = X_data + i * N;
+      const T* R_ptr = R_data + i * N;
+      T* Y_ptr = Y_data + i * N;
+      // The sums go to Y, which the second sweep normalizes in place while
+      // the row is still in cache.
+      Vec sum_vec(T(0));
+      Vec sq_vec(T(0));
+      int64_t j = 0;
+      for (; j + Vec::size() <= N; j += Vec::size()) {
+        const Vec s = Vec::loadu(X_ptr + j) + Vec::loadu(R_ptr + j);
+        s.store(Y_ptr + j);
+        sum_vec = sum_vec + s;
+        sq_vec = vec256::fmadd(s, s, sq_vec);
+      }
+      sum_vec.store(sum_arr);
+      sq_vec.store(sq_arr);
+      T sum = T(0);
+      T sq = T(0);
+      for (int64_t k = 0; k < Vec::size(); ++k) {
+        sum += sum_arr[k];
+        sq += sq_arr[k];
+      }
+      for (; j < N; ++j) {
+        const T s = X_ptr[j] + R_ptr[j];
+        Y_ptr[j] = s;
+        sum += s;
+        sq += s * s;
+      }
+      const T mean = sum * c;
+      const T var = std::max(sq * c - mean * mean, T(0));
+      const T rstd = T(1) / std::sqrt(var + static_cast<T>(eps));
+      const Vec scale(rstd);
+      const Vec shift(-rstd * mean);
+      for (j = 0; j < N; j += Vec::size()) {
+        const int64_t count = std::min<int64_t>(Vec::size(), N - j);
+        Vec y = vec256::fmadd(Vec::loadu(Y_ptr + j, count), scale, shift);
+        if (gamma_data != nullptr) {
+          y = y * Vec::loadu(gamma_data + j, count);
+        }
+        if (beta_data != nullptr) {
+          y = y + Vec::loadu(beta_data + j, count);
+        }
+        y.store(Y_ptr + j, count);
+      }
+    }
+  });
+}
+
+template <typename T>
+void FusedBiasAddKernelImplInternal(
+    const Tensor& X,
+    const Tensor& bias,
+    const Tensor& residual,
+    int64_t M,
+    int64_t N,
+    Tensor* Y) {
+  using Vec = vec256::Vec256<T>;
+  const T* X_data = X.data_ptr<T>();
+  const T* bias_data = bias.data_ptr<T>();
+  const T* R_data = residual.data_ptr<T>();
+  T* Y_data = Y->data_ptr<T>();
+  parallel_for(0, M, RowGrainSize(N), [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      const T* X_ptr = X_data + i * N;
+      const T* R_ptr = R_data + i * N;
+      T* Y_ptr = Y_data + i * N;
+      for (int64_t j = 0; j < N; j += Vec::size()) {
+        const int64_t count = std::min<int64_t>(Vec::size(), N - j);
+        const Vec y = Vec::loadu(X_ptr + j, count) +
+            Vec::loadu(bias_data + j, count) + Vec::loadu(R_ptr + j, count);
+        y.store(Y_ptr + j, count);
+      }
+    }
+  });
+}
+
+void FusedBiasGeluKernelImpl(
+    const Tensor& X,
+    const Tensor& bias,
+    int64_t M,
+    int64_t N,
+    Tensor* Y) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "FusedBiasGeluKernelImpl", [&]() {
+    FusedBiasGeluKernelImplInternal<scalar_t>(X, bias, M, N, Y);
+  });
+}
+
+void FusedAddLayerNormKernelImpl(
+    const Tensor& X,
+    const Tensor& residual,
+    const Tensor& gamma,
+    const Tensor& beta,
+    int64_t M,
+    int64_t N,
+    double eps,
+    Tensor* Y) {
+  AT_DISPATCH_FLOATING_TYPES(
+      X.scalar_type(), "FusedAddLayerNormKernelImpl", [&]() {
+        FusedAddLayerNormKernelImplInternal<scalar_t>(
+            X, residual, gamma, beta, M, N, eps, Y);
+      });
+}
+
+void FusedBiasAddKernelImpl(
+    const Tensor& X,
+    const Tensor& bias,
+    const Tensor& residual,
+    int64_t M,
+    int64_t N,
+    Tensor* Y) {
+  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "FusedBiasAddKernelImpl", [&]() {
+    FusedBiasAddKernelImplInternal<scalar_t>(X, bias, residual, M, N, Y);
+  });
+}
+
+} // namespace
+
+REGISTER_DISPATCH(FusedBiasGeluKernel, &FusedBiasGeluKernelImpl);
+REGISTER_DISPATCH(FusedAddLayerNormKernel, &FusedAddLayerNormKernelImpl);
+REGISTER_DISPATCH(FusedBiasAddKernel, &FusedBiasAddKernelImpl);
+
+} // namespace native
+} // namespace at
@@ -0,0 +1,311 @@
+#include <ATen/native/UpSample.h>
+
+#include <algorithm>
+#include <vector>
+
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+
+// The backward kernels of the 2d upsampling ops scatter every element of
+// grad_output into a few elements of grad_input. They work on one
+// (batch, channel) plane of grad_input at a time, so the planes are processed
+// in parallel without any synchronization. Inside a plane, the scatter is
+// separable: every row of grad_output is first scattered along the width into
+// a temporary row of the width of grad_input, which is then added with
+// vectorized loops into the rows of grad_input it contributes to.
+
+namespace at { namespace native {
+namespace {
+
+// dst[i] += src[i] for i in [0, size)
+template <typename scalar_t>
+inline void vec_add_row(scalar_t* dst, const scalar_t* src, int64_t size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec out = Vec::loadu(dst + d) + Vec::loadu(src + d);
+    out.store(dst + d);
+  }
+  for (; d < size; d++) {
+    dst[d] += src[d];
+  }
+}
+
+// dst[i] += alpha * src[i] for i in [0, size)
+template <typename scalar_t>
+inline void vec_add_scaled_row(
+    scalar_t* dst,
+    const scalar_t* src,
+    scalar_t alpha,
+    int64_t size) {
+  using Vec = vec256::Vec256<scalar_t>;
+  const Vec alpha_vec(alpha);
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec out = Vec::loadu(dst + d) + alpha_vec * Vec::loadu(src + d);
+    out.store(dst + d);
+  }
+  for (; d < size; d++) {
+    dst[d] += alpha * src[d];
+  }
+}
+
+template <typename scalar_t>
+void cpu_upsample_nearest2d_backward(
+    Tensor& grad_input,
+    const Tensor& grad_output) {
+  const int64_t channels = grad_input.size(0) * grad_input.size(1);
+  const int64_t input_height = grad_input.size(2);
+  const int64_t input_width = grad_input.size(3);
+  const int64_t output_height = grad_output.size(2);
+  const int64_t output_width = grad_output.size(3);
+
+  const float height_scale = (float)input_height / (float)output_height;
+  const float width_scale = (float)input_width / (float)output_width;
+
+  std::vector<int64_t> h1s(output_height);
+  for (int64_t h2 = 0; h2 < output_height; ++h2) {
+    h1s[h2] =
+        nearest_neighbor_compute_source_index(height_scale, h2, input_height);
+  }
+  std::vector<int64_t> w1s(output_width);
+  for (int64_t w2 = 0; w2 < output_width; ++w2) {
+    w1s[w2] =
+        nearest_neighbor_compute_source_index(width_scale, w2, input_width);
+  }
+
+  scalar_t* idata = grad_input.data_ptr<scalar_t>();
+  const scalar_t* odata = grad_output.data_ptr<scalar_t>();
+  const int64_t grain_size =
+      at::divup(at::internal::GRAIN_SIZE, output_height * output_width);
+
+  at::parallel_for(0, channels, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> row(output_width);
+    for (int64_t c = begin; c < end; ++c) {
+      scalar_t* iplane = idata + c * input_height * input_width;
+      const scalar_t* oplane = odata + c * output_height * output_width;
+
+      // The source index is nondecreasing, so the output rows read from a
+      // same input row are consecutive: sum them before the scatter.
+      int64_t h2 = 0;
+      while (h2 < output_height) {
+        const int64_t h1 = h1s[h2];
+        const scalar_t* orow = oplane + h2 * output_width;
+        std::copy(orow, orow + output_width, row.begin());
+        for (++h2; h2 < output_height && h1s[h2] == h1; ++h2) {
+          vec_add_row(row.data(), oplane + h2 * output_width, output_width);
+        }
+
+        scalar_t* irow = iplane + h1 * input_width;
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          irow[w1s[w2]] += row[w2];
+        }
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+void cpu_upsample_bilinear2d_backward(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    bool align_corners) {
+  const int64_t channels = grad_input.size(0) * grad_input.size(1);
+  const int64_t input_height = grad_input.size(2);
+  const int64_t input_width = grad_input.size(3);
+  const int64_t output_height = grad_output.size(2);
+  const int64_t output_width = grad_output.size(3);
+
+  const scalar_t rheight = area_pixel_compute_scale<scalar_t>(
+      input_height, output_height, align_corners);
+  const scalar_t rwidth = area_pixel_compute_scale<scalar_t>(
+      input_width, output_width, align_corners);
+
+  std::vector<int64_t> h1s(output_height), h1ps(output_height);
+  std::vector<scalar_t> h0lambdas(output_height), h1lambdas(output_height);
+  for (int64_t h2 = 0; h2 < output_height; ++h2) {
+    const scalar_t h1r = area_pixel_compute_source_index<scalar_t>(
+        rheight, h2, align_corners, /*cubic=*/false);
+    h1s[h2] = h1r;
+    h1ps[h2] = (h1s[h2] < input_height - 1) ? 1 : 0;
+    h1lambdas[h2] = h1r - h1s[h2];
+    h0lambdas[h2] = static_cast<scalar_t>(1.) - h1lambdas[h2];
+  }
+  std::vector<int64_t> w1s(output_width), w1ps(output_width);
+  std::vector<scalar_t> w0lambdas(output_width), w1lambdas(output_width);
+  for (int64_t w2 = 0; w2 < output_width; ++w2) {
+    const scalar_t w1r = area_pixel_compute_source_index<scalar_t>(
+        rwidth, w2, align_corners, /*cubic=*/false);
+    w1s[w2] = w1r;
+    w1ps[w2] = (w1s[w2] < input_width - 1) ? 1 : 0;
+    w1lambdas[w2] = w1r - w1s[w2];
+    w0lambdas[w2] = static_cast<scalar_t>(1.) - w1lambdas[w2];
+  }
+
+  scalar_t* idata = grad_input.data_ptr<scalar_t>();
+  const scalar_t* odata = grad_output.data_ptr<scalar_t>();
+  const int64_t grain_size =
+      at::divup(at::internal::GRAIN_SIZE, output_height * output_width * 4);
+
+  at::parallel_for(0, channels, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> row(input_width);
+    for (int64_t c = begin; c < end; ++c) {
+      scalar_t* iplane = idata + c * input_height * input_width;
+      const scalar_t* oplane = odata + c * output_height * output_width;
+
+      for (int64_t h2 = 0; h2 < output_height; ++h2) {
+        const scalar_t* orow = oplane + h2 * output_width;
+        std::fill(row.begin(), row.end(), scalar_t(0));
+        for (int64_t w2 = 0; w2 < output_width; ++w2) {
+          row[w1s[w2]] += w0lambdas[w2] * orow[w2];
+          row[w1s[w2] + w1ps[w2]] += w1lambdas[w2] * orow[w2];
+        }
+
+        const int64_t h1 = h1s[h2];
+        vec_add_scaled_row(
+            iplane + h1 * input_width, row.data(), h0lambdas[h2], input_width);
+        vec_add_scaled_row(
+            iplane + (h1 + h1ps[h2]) * input_width,
+            row.data(),
+            h1lambdas[h2],
+            input_width);
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+void cpu_upsample_bicubic2d_backward(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    bool align_corners) {
+  const int64_t channels = grad_input.size(0) * grad_input.size(1);
+  const int64_t input_height = grad_input.size(2);
+  const int64_t input_width = grad_input.size(3);
+  const int64_t output_height = grad_output.size(2);
+  const int64_t output_width = grad_output.size(3);
+
+  const scalar_t height_scale = area_pixel_compute_scale<scalar_t>(
+      input_height, output_height, align_corners);
+  const scalar_t width_scale = area_pixel_compute_scale<scalar_t>(
+      input_width, output_width, align_corners);
+
+  // The 4 input rows and columns every output location reads from, clamped
+  // to the input, and their coefficients.
+  std::vector<int64_t> ys(output_height * 4);
+  std::vector<scalar_t> y_coeffs(output_height * 4);
+  for (int64_t output_y = 0; output_y < output_height; output_y++) {
+    const scalar_t real_y = area_pixel_compute_source_index(
+        height_scale, output_y, align_corners, /*cubic=*/true);
+    const int64_t input_y = floorf(real_y);
+    get_cubic_upsample_coefficients<scalar_t>(
+        &y_coeffs[output_y * 4], real_y - input_y);
+    for (int64_t j = 0; j < 4; j++) {
+      ys[output_y * 4 + j] = std::max(
+          std::min(input_y - 1 + j, input_height - 1), static_cast<int64_t>(0));
+    }
+  }
+  std::vector<int64_t> xs(output_width * 4);
+  std::vector<scalar_t> x_coeffs(output_width * 4);
+  for (int64_t output_x = 0; output_x < output_width; output_x++) {
+    const scalar_t real_x = area_pixel_compute_source_index(
+        width_scale, output_x, align_corners, /*cubic=*/true);
+    const int64_t input_x = floorf(real_x);
+    get_cubic_upsample_coefficients<scalar_t>(
+        &x_coeffs[output_x * 4], real_x - input_x);
+    for (int64_t i = 0; i < 4; i++) {
+      xs[output_x * 4 + i] = std::max(
+          std::min(input_x - 1 + i, input_width - 1), static_cast<int64_t>(0));
+    }
+  }
+
+  scalar_t* idata = grad_input.data_ptr<scalar_t>();
+  const scalar_t* odata = grad_output.data_ptr<scalar_t>();
+  const int64_t grain_size =
+      at::divup(at::internal::GRAIN_SIZE, output_height * output_width * 16);
+
+  at::parallel_for(0, channels, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> row(input_width);
+    for (int64_t c = begin; c < end; ++c) {
+      scalar_t* iplane = idata + c * input_height * input_width;
+      const scalar_t* oplane = odata + c * output_height * output_width;
+
+      for (int64_t output_y = 0; output_y < output_height; output_y++) {
+        const scalar_t* orow = oplane + output_y * output_width;
+        std::fill(row.begin(), row.end(), scalar_t(0));
+        for (int64_t output_x = 0; output_x < output_width; output_x++) {
+          for (int64_t i = 0; i < 4; i++) {
+            row[xs[output_x * 4 + i]] +=
+                x_coeffs[output_x * 4 + i] * orow[output_x];
+          }
+        }
+
+        for (int64_t j = 0; j < 4; j++) {
+          vec_add_scaled_row(
+              iplane + ys[output_y * 4 + j] * input_width,
+              row.data(),
+              y_coeffs[output_y * 4 + j],
+              input_width);
+        }
+      }
+    }
+  });
+}
+
+void upsample_nearest2d_backward_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& grad_output) {
+  if (grad_input.sizes() == grad_output.sizes()) {
+    grad_input.copy_(grad_output);
+    return;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+      grad_output.scalar_type(), "upsample_nearest2d_backward", [&] {
+        cpu_upsample_nearest2d_backward<scalar_t>(grad_input, grad_output);
+      });
+}
+
+void upsample_bilinear2d_backward_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    bool align_corners) {
+  if (grad_input.sizes() == grad_output.sizes()) {
+    grad_input.copy_(grad_output);
+    return;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+      grad_output.scalar_type(), "upsample_bilinear2d_backward", [&] {
+        cpu_upsample_bilinear2d_backward<scalar_t>(
+            grad_input, grad_output, align_corners);
+      });
+}
+
+void upsample_bicubic2d_backward_kernel_impl(
+    Tensor& grad_input,
+    const Tensor& grad_output,
+    bool align_corners) {
+  if (grad_input.sizes() == grad_output.sizes()) {
+    grad_input.copy_(grad_output);
+    return;
+  }
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(
+      grad_output.scalar_type(), "upsample_bicubic2d_backward", [&] {
+        cpu_upsample_bicubic2d_backward<scalar_t>(
+            grad_input, grad_output, align_corners);
+      });
+}
+
+} // namespace
+
+REGISTER_DISPATCH(
+    upsample_nearest2d_backward_kernel,
+    &upsample_nearest2d_backward_kernel_impl);
+REGISTER_DISPATCH(
+    upsample_bilinear2d_backward_kernel,
+    &upsample_bilinear2d_backward_kernel_impl);
+REGISTER_DISPATCH(
+    upsample_bicubic2d_backward_kernel,
+    &upsample_bicubic2d_backward_kernel_impl);
+
+}} // namespace at::native
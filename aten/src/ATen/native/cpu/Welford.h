@@ -0,0 +1,230 @@
+#pragma once
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec256/vec256.h>
+#include <ATen/native/SharedReduceOps.h>
+#include <ATen/native/TensorIterator.h>
+#include <ATen/native/cpu/Reduce.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace at { namespace native { namespace {
+
+// Note [Vectorized Welford]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// The mean and the variance are computed in a single pass with Welford's
+// algorithm. Each lane of a Vec256 runs its own Welford update in scalar_t
+// over a block of at most kWelfordBlockSize elements, and the lanes of a block
+// are then combined into an accumulator of WelfordOps (in double) with
+// ops.combine(). Every lane of a block has seen the same number of elements,
+// so the count isn't vectorized. Blocks keep the error of the scalar_t part
+// bounded by the block size, however long the reduction is.
+//
+// A parallel reduction has one accumulator per thread, which are combined
+// pairwise rather than one after the other.
+constexpr int64_t kWelfordBlockSize = 64;
+
+// Combines `num_partials` rows of `cols` accumulators pairwise into the first
+// row.
+template <typename ops_t, typename acc_t>
+inline void welford_merge_pairwise(const ops_t& ops, acc_t* accs, int64_t num_partials, int64_t cols) {
+  for (int64_t step = 1; step < num_partials; step *= 2) {
+    for (int64_t i = 0; i + step < num_partials; i += 2 * step) {
+      acc_t* dst = accs + i * cols;
+      const acc_t* src = accs + (i + step) * cols;
+      for (int64_t c = 0; c < cols; c++) {
+        dst[c] = ops.combine(dst[c], src[c]);
+      }
+    }
+  }
+}
+
+// Adds the `n` contiguous elements at `data` to `acc`.
+template <typename scalar_t, typename ops_t, typename acc_t = typename ops_t::acc_t>
+inline acc_t welford_reduce_contiguous(const ops_t& ops, const scalar_t* data, int64_t n, acc_t acc) {
+  using Vec = vec256::Vec256<scalar_t>;
+  int64_t i = 0;
+  while (i + Vec::size() <= n) {
+    const int64_t steps = std::min<int64_t>(kWelfordBlockSize, (n - i) / Vec::size());
+    const scalar_t* block = data + i;
+    Vec mean = Vec::loadu(block);
+    Vec m2(scalar_t(0));
+    for (int64_t k = 1; k < steps; k++) {
+      const Vec x = Vec::loadu(block + k * Vec::size());
+      const Vec delta = x - mean;
+      mean = vec256::fmadd(delta, Vec(scalar_t(1) / scalar_t(k + 1)), mean);
+      m2 = vec256::fmadd(delta, x - mean, m2);
+    }
+    __at_align32__ scalar_t mean_arr[Vec::size()];
+    __at_align32__ scalar_t m2_arr[Vec::size()];
+    mean.store(mean_arr);
+    m2.store(m2_arr);
+    for (int64_t j = 0; j < Vec::size(); j++) {
+      acc = ops.combine(acc, acc_t(mean_arr[j], m2_arr[j], steps, steps));
+    }
+    i += steps * Vec::size();
+  }
+  for (; i < n; i++) {
+    acc = ops.reduce(acc, data[i], i);
+  }
+  return acc;
+}
+
+// Adds column c of the `rows` x `cols` matrix at `data`, whose rows are
+// `row_stride` elements apart and whose columns are contiguous, to accs[c].
+// `mean_buf` and `m2_buf` hold `cols` elements each.
+template <typename scalar_t, typename ops_t, typename acc_t = typename ops_t::acc_t>
+inline void welford_reduce_columns(
+    const ops_t& ops, const scalar_t* data, int64_t rows, int64_t cols, int64_t row_stride,
+    acc_t* accs, scalar_t* mean_buf, scalar_t* m2_buf) {
+  using Vec = vec256::Vec256<scalar_t>;
+  for (int64_t r = 0; r < rows; r += kWelfordBlockSize) {
+    const int64_t steps = std::min<int64_t>(kWelfordBlockSize, rows - r);
+    const scalar_t* block = data + r * row_stride;
+    std::copy(block, block + cols, mean_buf);
+    std::fill(m2_buf, m2_buf + cols, scalar_t(0));
+    for (int64_t k = 1; k < steps; k++) {
+      const scalar_t* row = block + k * row_stride;
+      const scalar_t inv = scalar_t(1) / scalar_t(k + 1);
+      const Vec inv_vec(inv);
+      int64_t c = 0;
+      for (; c + Vec::size() <= cols; c += Vec::size()) {
+        const Vec x = Vec::loadu(row + c);
+        Vec mean = Vec::loadu(mean_buf + c);
+        const Vec delta = x - mean;
+        mean = vec256::fmadd(delta, inv_vec, mean);
+        const Vec m2 = vec256::fmadd(delta, x - mean, Vec::loadu(m2_buf + c));
+        mean.store(mean_buf + c);
+        m2.store(m2_buf + c);
+      }
+      for (; c < cols; c++) {
+        const scalar_t delta = row[c] - mean_buf[c];
+        mean_buf[c] += delta * inv;
+        m2_buf[c] += delta * (row[c] - mean_buf[c]);
+      }
+    }
+    for (int64_t c = 0; c < cols; c++) {
+      accs[c] = ops.combine(accs[c], acc_t(mean_buf[c], m2_buf[c], steps, steps));
+    }
+  }
+}
+
+// Computes the accumulators of the `cols` columns of a `rows` x `cols` matrix
+// as in welford_reduce_columns(), in parallel over the columns if there are
+// at least as many columns as rows and over the rows otherwise.
+template <typename scalar_t, typename ops_t, typename acc_t = typename ops_t::acc_t>
+inline std::vector<acc_t> welford_reduce_2d(
+    const ops_t& ops, const scalar_t* data, int64_t rows, int64_t cols, int64_t row_stride) {
+  using Vec = vec256::Vec256<scalar_t>;
+  const bool serial = rows * cols < internal::GRAIN_SIZE ||
+      get_num_threads() == 1 || in_parallel_region();
+  if (serial || cols >= rows) {
+    std::vector<acc_t> accs(cols);
+    auto reduce_columns = [&](int64_t begin, int64_t end) {
+      std::vector<scalar_t> mean_buf(end - begin);
+      std::vector<scalar_t> m2_buf(end - begin);
+      welford_reduce_columns(
+          ops, data + begin, rows, end - begin, row_stride, accs.data() + begin,
+          mean_buf.data(), m2_buf.data());
+    };
+    if (serial) {
+      reduce_columns(0, cols);
+    } else {
+      parallel_for(
+          0, cols, std::max<int64_t>(Vec::size(), internal::GRAIN_SIZE / rows),
+          reduce_columns);
+    }
+    return accs;
+  }
+  const int num_threads = get_num_threads();
+  std::vector<acc_t> buffer(num_threads * cols);
+  parallel_for(0, rows, std::max<int64_t>(1, internal::GRAIN_SIZE / cols),
+                [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> mean_buf(cols);
+    std::vector<scalar_t> m2_buf(cols);
+    welford_reduce_columns(
+        ops, data + begin * row_stride, end - begin, cols, row_stride,
+        buffer.data() + get_thread_num() * cols, mean_buf.data(), m2_buf.data());
+  });
+  welford_merge_pairwise(ops, buffer.data(), num_threads, cols);
+  buffer.resize(cols);
+  return buffer;
+}
+
+// A reduction over dim 0 of a 2-d iterator whose input and outputs are
+// contiguous in dim 1, e.g. over the N, H and W of a channels last tensor.
+template <typename scalar_t>
+static inline bool is_outer_welford_reduction(const TensorIterator& iter) {
+  if (iter.ndim() != 2 || !iter.is_dim_reduced(0) || iter.is_dim_reduced(1)) {
+    return false;
+  }
+  for (int arg = 0; arg < iter.ntensors(); arg++) {
+    if (iter.strides(arg)[1] != sizeof(scalar_t)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Like binary_kernel_reduce() with WelfordOps, but vectorized over contiguous
+// inputs and over contiguous columns of outer reductions, see
+// Note [Vectorized Welford].
+template <typename scalar_t, typename ops_t>
+void welford_kernel_reduce_vec(TensorIterator& iter, const ops_t& ops) {
+  using acc_t = typename ops_t::acc_t;
+  using r_traits = binary_function_traits<decltype(&ops_t::reduce)>;
+  const int num_outputs = iter.noutputs();
+  AT_ASSERT(iter.ninputs() == 1);
+
+  if (is_outer_welford_reduction<scalar_t>(iter)) {
+    const int64_t cols = iter.shape()[1];
+    const auto accs = welford_reduce_2d(
+        ops, static_cast<const scalar_t*>(iter.data_ptr(num_outputs)),
+        iter.shape()[0], cols,
+        iter.strides(num_outputs)[0] / static_cast<int64_t>(sizeof(scalar_t)));
+    for (int64_t c = 0; c < cols; c++) {
+      const auto results = ops.project(accs[c]);
+      static_cast<scalar_t*>(iter.data_ptr(0))[c] = std::get<0>(results);
+      if (num_outputs > 1) {
+        static_cast<scalar_t*>(iter.data_ptr(1))[c] = std::get<1>(results);
+      }
+    }
+    return;
+  }
+
+  iter.foreach_reduced_elt([&ops, num_outputs](TensorIterator& sub_iter) {
+    auto reduction_body = [&ops, &sub_iter, num_outputs](acc_t acc, int64_t begin, int64_t end) -> acc_t {
+      sub_iter.serial_for_each([&acc, &ops, num_outputs, begin](char** data, const int64_t* strides, int64_t size) {
+        const char* in = data[num_outputs];
+        const int64_t stride = strides[num_outputs];
+        if (stride == sizeof(scalar_t)) {
+          acc = welford_reduce_contiguous(ops, reinterpret_cast<const scalar_t*>(in), size, acc);
+          return;
+        }
+        for (int64_t i = 0; i < size; ++i) {
+          acc = ops.reduce(acc, *reinterpret_cast<const scalar_t*>(in), begin + i);
+          in += stride;
+        }
+      }, {begin, end});
+      return acc;
+    };
+    acc_t total_acc;
+    const int64_t numel = sub_iter.numel();
+    if (numel < internal::GRAIN_SIZE || get_num_threads() == 1 || in_parallel_region()) {
+      total_acc = reduction_body(total_acc, 0, numel);
+    } else {
+      const int max_threads = get_num_threads();
+      std::vector<acc_t> buffer(max_threads);
+      parallel_for(0, numel, internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        auto& acc = buffer[get_thread_num()];
+        acc = reduction_body(acc, begin, end);
+      });
+      welford_merge_pairwise(ops, buffer.data(), max_threads, 1);
+      total_acc = buffer[0];
+    }
+    set_results<r_traits>(ops.project(total_acc), sub_iter, num_outputs);
+  });
+}
+
+}}}  // namespace at::native::<anonymous>
@@ -0,0 +1,124 @@
+#include <ATen/native/batch_norm.h>
+
+#include <cmath>
+#include <limits>
+#include <tuple>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/native/SharedReduceOps.h>
+#include <ATen/native/cpu/Welford.h>
+
+namespace at {
+namespace native {
+
+namespace {
+
+template <typename T>
+using BatchNormStatsOps =
+    WelfordOps<T, double, int64_t, double, std::tuple<T, T>>;
+
+template <typename T>
+void WriteStats(
+    const std::vector<typename BatchNormStatsOps<T>::acc_t>& accs,
+    Tensor* mean,
+    Tensor* var_sum) {
+  T* mean_data = mean->data_ptr<T>();
+  T* var_sum_data = var_sum->data_ptr<T>();
+  for (size_t c = 0; c < accs.size(); ++c) {
+    // The mean of no element is NaN, as for sum / n.
+    mean_data[c] = accs[c].nf > 0 ? static_cast<T>(accs[c].mean)
+                                  : std::numeric_limits<T>::quiet_NaN();
+    var_sum_data[c] = static_cast<T>(accs[c].m2);
+  }
+}
+
+// Each (n, c) plane of a contiguous input is reduced into the accumulator of
+// channel c of the thread, and the accumulators of the threads are merged
+// pairwise.
+template <typename T>
+void BatchNormCollectStatsContiguousImpl(
+    const Tensor& X,
+    Tensor* mean,
+    Tensor* var_sum) {
+  using acc_t = typename BatchNormStatsOps<T>::acc_t;
+  const BatchNormStatsOps<T> ops(/*unbiased=*/false, /*take_sqrt=*/false);
+  const int64_t N = X.size(0);
+  const int64_t C = X.size(1);
+  const int64_t HxW = X.numel() / (N * C);
+  const T* X_data = X.data_ptr<T>();
+  const bool serial = X.numel() < internal::GRAIN_SIZE ||
+      get_num_threads() == 1 || in_parallel_region();
+  const int num_threads = serial ? 1 : get_num_threads();
+  std::vector<acc_t> accs(num_threads * C);
+  auto reduce_planes = [&](int64_t begin, int64_t end) {
+    acc_t* thread_accs = accs.data() + (serial ? 0 : get_thread_num()) * C;
+    for (int64_t i = begin; i < end; ++i) {
+      const int64_t c = i % C;
+      thread_accs[c] =
+          welford_reduce_contiguous(ops, X_data + i * HxW, HxW, thread_accs[c]);
+    }
+  };
+  if (serial) {
+    reduce_planes(0, N * C);
+  } else {
+    parallel_for(
+        0,
+        N * C,
+        std::max<int64_t>(1, internal::GRAIN_SIZE / HxW),
+        reduce_planes);
+  }
+  welford_merge_pairwise(ops, accs.data(), num_threads, C);
+  accs.resize(C);
+  WriteStats<T>(accs, mean, var_sum);
+}
+
+// A channels last input, or a contiguous (N, C, 1, ...) input, is an
+// (N * H * W) x C matrix with contiguous rows, whose columns are reduced with
+// vectors of channels.
+template <typename T>
+void BatchNormCollectStatsChannelsLastImpl(
+    const Tensor& X,
+    Tensor* mean,
+    Tensor* var_sum) {
+  const BatchNormStatsOps<T> ops(/*unbiased=*/false, /*take_sqrt=*/false);
+  const int64_t C = X.size(1);
+  WriteStats<T>(
+      welford_reduce_2d(ops, X.data_ptr<T>(), X.numel() / C, C, C),
+      mean,
+      var_sum);
+}
+
+void BatchNormCollectStatsKernelImpl(
+    const Tensor& X,
+    Tensor* mean,
+    Tensor* var_sum) {
+  if (X.numel() == 0) {
+    mean->fill_(std::numeric_limits<double>::quiet_NaN());
+    var_sum->zero_();
+    return;
+  }
+  // A contiguous input with one element per plane is a contiguous (N, C)
+  // matrix as well.
+  const bool channels_last = X.is_contiguous()
+      ? X.numel() == X.size(0) * X.size(1)
+      : X.is_contiguous(MemoryFormat::ChannelsLast);
+  AT_DISPATCH_FLOATING_TYPES(
+      X.scalar_type(), "BatchNormCollectStatsKernelImpl", [&]() {
+        if (channels_last) {
+          BatchNormCollectStatsChannelsLastImpl<scalar_t>(X, mean, var_sum);
+        } else {
+          BatchNormCollectStatsContiguousImpl<scalar_t>(
+              X.contiguous(), mean, var_sum);
+        }
+      });
+}
+
+} // namespace
+
+REGISTER_DISPATCH(BatchNormCollectStatsKernel, &BatchNormCollectStatsKernelImpl);
+
+} // namespace native
+} // namespace at
@@ -1,6 +1,8 @@
 #include <ATen/native/layer_norm.h>
 
 #include <cmath>
+#include <type_traits>
+#include <vector>
 
 #include <ATen/ATen.h>
 #include <ATen/CPUApplyUtils.h>
@@ -11,6 +13,11 @@ namespace native {
 
 namespace {
 
+// BFloat16 inputs are normalized in float, the other types in their own type.
+template <typename T>
+using LayerNormAccType =
+    typename std::conditional<std::is_same<T, BFloat16>::value, float, T>::type;
+
 template <typename T>
 void LayerNormKernelImplInternal(
     const Tensor& X,
@@ -18,7 +25,7 @@ void LayerNormKernelImplInternal(
     const Tensor& beta,
     int64_t M,
     int64_t N,
-    T eps,
+    double eps,
     Tensor* Y,
     Tensor* mean,
     Tensor* rstd) {
@@ -31,30 +38,35 @@ void LayerNormKernelImplInternal(
   T* Y_data = Y->data_ptr<T>();
   T* mean_data = mean->data_ptr<T>();
   T* rstd_data = rstd->data_ptr<T>();
-  const T c = T(1) / static_cast<T>(N);
+  using T_ACC = LayerNormAccType<T>;
+  const T_ACC c = T_ACC(1) / static_cast<T_ACC>(N);
   const bool gamma_null = gamma_data == nullptr;
   const bool beta_null = beta_data == nullptr;
   for (int64_t i = 0; i < M; ++i) {
     const T* X_ptr = X_data + i * N;
     T* Y_ptr = Y_data + i * N;
-    T mean_val = T(0);
-    T rstd_val = T(0);
+    T_ACC mean_val = T_ACC(0);
+    T_ACC rstd_val = T_ACC(0);
     for (int64_t j = 0; j < N; ++j) {
-      mean_val += X_ptr[j];
-      rstd_val += X_ptr[j] * X_ptr[j];
+      const T_ACC x = static_cast<T_ACC>(X_ptr[j]);
+      mean_val += x;
+      rstd_val += x * x;
     }
     mean_val *= c;
-    rstd_val = std::max(rstd_val * c - mean_val * mean_val, T(0));
-    rstd_val = T(1) / std::sqrt(rstd_val + eps);
-    const T scale = rstd_val;
-    const T bias = -rstd_val * mean_val;
+    rstd_val = std::max(rstd_val * c - mean_val * mean_val, T_ACC(0));
+    rstd_val = T_ACC(1) / std::sqrt(rstd_val + static_cast<T_ACC>(eps));
+    const T_ACC scale = rstd_val;
+    const T_ACC bias = -rstd_val * mean_val;
     for (int64_t j = 0; j < N; ++j) {
-      const T gamma_v = gamma_null ? T(1) : gamma_data[j];
-      const T beta_v = beta_null ? T(0) : beta_data[j];
-      Y_ptr[j] = (X_ptr[j] * scale + bias) * gamma_v + beta_v;
+      const T_ACC gamma_v =
+          gamma_null ? T_ACC(1) : static_cast<T_ACC>(gamma_data[j]);
+      const T_ACC beta_v =
+          beta_null ? T_ACC(0) : static_cast<T_ACC>(beta_data[j]);
+      Y_ptr[j] = static_cast<T>(
+          (static_cast<T_ACC>(X_ptr[j]) * scale + bias) * gamma_v + beta_v);
     }
-    mean_data[i] = mean_val;
-    rstd_data[i] = rstd_val;
+    mean_data[i] = static_cast<T>(mean_val);
+    rstd_data[i] = static_cast<T>(rstd_val);
   }
 }
 
@@ -68,10 +80,11 @@ void LayerNormKernelImpl(
     Tensor* Y,
     Tensor* mean,
     Tensor* rstd) {
-  AT_DISPATCH_FLOATING_TYPES(X.scalar_type(), "LayerNormKernelImpl", [&]() {
-    LayerNormKernelImplInternal<scalar_t>(
-        X, gamma, beta, M, N, static_cast<scalar_t>(eps), Y, mean, rstd);
-  });
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      ScalarType::BFloat16, X.scalar_type(), "LayerNormKernelImpl", [&]() {
+        LayerNormKernelImplInternal<scalar_t>(
+            X, gamma, beta, M, N, eps, Y, mean, rstd);
+      });
 }
 
 template <typename T>
@@ -99,48 +112,65 @@ void LayerNormBackwardKernelImplInternal(
       gamma.defined() ? gamma.template data_ptr<T>() : nullptr;
   T* dX_data = dX->defined() ? dX->template data_ptr<T>() : nullptr;
   T* dgamma_data = dgamma->defined() ? dgamma->template data_ptr<T>() : nullptr;
-  if (dgamma_data != nullptr) {
-    std::memset(dgamma_data, 0, N * sizeof(T));
-  }
   T* dbeta_data = dbeta->defined() ? dbeta->template data_ptr<T>() : nullptr;
-  if (dbeta_data != nullptr) {
-    std::memset(dbeta_data, 0, N * sizeof(T));
-  }
-  const T scale = T(1) / static_cast<T>(N);
+  // dgamma and dbeta sum over the M rows, so they accumulate in T_ACC and are
+  // written back at the end.
+  using T_ACC = LayerNormAccType<T>;
+  std::vector<T_ACC> dgamma_acc(dgamma_data != nullptr ? N : 0, T_ACC(0));
+  std::vector<T_ACC> dbeta_acc(dbeta_data != nullptr ? N : 0, T_ACC(0));
+  const T_ACC scale = T_ACC(1) / static_cast<T_ACC>(N);
   const bool gamma_null = gamma_data == nullptr;
   for (int64_t i = 0; i < M; ++i) {
     const T* dY_ptr = dY_data + i * N;
     const T* X_ptr = X_data + i * N;
+    const T_ACC mean_v = static_cast<T_ACC>(mean_data[i]);
+    const T_ACC rstd_v = static_cast<T_ACC>(rstd_data[i]);
     if (dX_data != nullptr) {
       T* dX_ptr = dX_data + i * N;
-      T ds = 0;
-      T db = 0;
+      T_ACC ds = 0;
+      T_ACC db = 0;
       for (int64_t j = 0; j < N; ++j) {
-        const T gamma_v = gamma_null ? T(1) : gamma_data[j];
-        ds += dY_ptr[j] * X_ptr[j] * gamma_v;
-        db += dY_ptr[j] * gamma_v;
+        const T_ACC gamma_v =
+            gamma_null ? T_ACC(1) : static_cast<T_ACC>(gamma_data[j]);
+        const T_ACC dy = static_cast<T_ACC>(dY_ptr[j]);
+        ds += dy * static_cast<T_ACC>(X_ptr[j]) * gamma_v;
+        db += dy * gamma_v;
       }
-      const T a = rstd_data[i];
-      const T b = (db * mean_data[i] - ds) * a * a * a * scale;
-      const T c = -b * mean_data[i] - db * a * scale;
+      const T_ACC a = rstd_v;
+      const T_ACC b = (db * mean_v - ds) * a * a * a * scale;
+      const T_ACC c = -b * mean_v - db * a * scale;
       for (int64_t j = 0; j < N; ++j) {
-        const T gamma_v = gamma_null ? T(1) : gamma_data[j];
-        dX_ptr[j] = a * dY_ptr[j] * gamma_v + b * X_ptr[j] + c;
+        const T_ACC gamma_v =
+            gamma_null ? T_ACC(1) : static_cast<T_ACC>(gamma_data[j]);
+        dX_ptr[j] = static_cast<T>(
+            a * static_cast<T_ACC>(dY_ptr[j]) * gamma_v +
+            b * static_cast<T_ACC>(X_ptr[j]) + c);
       }
     }
     if (dgamma_data != nullptr) {
-      const T a = rstd_data[i];
-      const T b = -a * mean_data[i];
+      const T_ACC a = rstd_v;
+      const T_ACC b = -a * mean_v;
       for (int64_t j = 0; j < N; ++j) {
-        dgamma_data[j] += dY_ptr[j] * (a * X_ptr[j] + b);
+        dgamma_acc[j] += static_cast<T_ACC>(dY_ptr[j]) *
+            (a * static_cast<T_ACC>(X_ptr[j]) + b);
       }
     }
     if (dbeta_data != nullptr) {
       for (int64_t j = 0; j < N; ++j) {
-        dbeta_data[j] += dY_ptr[j];
+        dbeta_acc[j] += static_cast<T_ACC>(dY_ptr[j]);
       }
     }
   }
+  if (dgamma_data != nullptr) {
+    for (int64_t j = 0; j < N; ++j) {
+      dgamma_data[j] = static_cast<T>(dgamma_acc[j]);
+    }
+  }
+  if (dbeta_data != nullptr) {
+    for (int64_t j = 0; j < N; ++j) {
+      dbeta_data[j] = static_cast<T>(dbeta_acc[j]);
+    }
+  }
 }
 
 void LayerNormBackwardKernelImpl(
@@ -154,8 +184,8 @@ void LayerNormBackwardKernelImpl(
     Tensor* dX,
     Tensor* dgamma,
     Tensor* dbeta) {
-  AT_DISPATCH_FLOATING_TYPES(
-      X.scalar_type(), "LayerNormBackwardKernelImpl", [&]() {
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      ScalarType::BFloat16, X.scalar_type(), "LayerNormBackwardKernelImpl", [&]() {
         LayerNormBackwardKernelImplInternal<scalar_t>(
             dY, X, mean, rstd, gamma, M, N, dX, dgamma, dbeta);
       });
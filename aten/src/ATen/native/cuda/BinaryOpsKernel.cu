@@ -1,5 +1,6 @@
 #include <ATen/Context.h>
 #include <ATen/Dispatch.h>
+#include <ATen/cuda/DeferredLaunch.h>
 #include <ATen/native/cuda/Loops.cuh>
 #include <ATen/native/DispatchStub.h>
 #include <ATen/native/TensorIterator.h>
@@ -13,6 +14,10 @@
 namespace at { namespace native {
 
 void add_kernel_cuda(TensorIterator& iter, Scalar alpha_scalar) {
+  if (at::cuda::detail::defer_binary_op(
+          iter, at::cuda::detail::DeferredOpKind::Add, alpha_scalar)) {
+    return;
+  }
   AT_DISPATCH_ALL_TYPES_AND2(kHalf, kBool, iter.dtype(), "add_cuda/sub_cuda", [&]() {
     auto alpha = alpha_scalar.to<scalar_t>();
     gpu_kernel_with_scalars(iter, [alpha]GPU_LAMBDA(scalar_t a, scalar_t b) -> scalar_t {
@@ -26,6 +31,10 @@ static void sub_kernel_cuda(TensorIterator& iter, Scalar alpha_scalar) {
 }
 
 void div_kernel_cuda(TensorIterator& iter) {
+  if (at::cuda::detail::defer_binary_op(
+          iter, at::cuda::detail::DeferredOpKind::Div)) {
+    return;
+  }
   if (!isIntegralType(iter.dtype(), /*includeBool*/ false) && iter.is_cpu_scalar(2)) {
     // optimization for floating-point types: if the second operand is a CPU
     // scalar, compute a * reciprocal(b). Note that this may lose one bit of
@@ -47,6 +56,10 @@ void div_kernel_cuda(TensorIterator& iter) {
 }
 
 void mul_kernel_cuda(TensorIterator& iter) {
+  if (at::cuda::detail::defer_binary_op(
+          iter, at::cuda::detail::DeferredOpKind::Mul)) {
+    return;
+  }
   if (iter.dtype() == ScalarType::Bool) {
     // Workaround for the error: '*' in boolean context, suggest '&&' instead [-Werror=int-in-bool-context]
     gpu_kernel_with_scalars(iter, []GPU_LAMBDA(bool a, bool b) -> bool {
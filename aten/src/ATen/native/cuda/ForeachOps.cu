@@ -0,0 +1,286 @@
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/Dispatch.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/native/ForeachUtils.h>
+#include <ATen/native/cuda/MultiTensorApply.cuh>
+
+#include <cmath>
+
+namespace at {
+namespace native {
+
+namespace {
+
+// The pointers to the chunk of the lists' tensors that this block processes,
+// and the number of its elements.
+template <int depth, typename scalar_t>
+__device__ __forceinline__ int64_t chunk_pointers(TensorListMetadata<depth>& tl, scalar_t** ptrs) {
+  const int tensor_loc = tl.block_to_tensor[blockIdx.x];
+  const int64_t chunk_idx = tl.block_to_chunk[blockIdx.x];
+  for (int d = 0; d < depth; d++) {
+    ptrs[d] = static_cast<scalar_t*>(tl.addresses[d][tensor_loc]) + chunk_idx * kChunkSize;
+  }
+  const int64_t n = tl.numel[tensor_loc] - chunk_idx * kChunkSize;
+  return n < kChunkSize ? n : kChunkSize;
+}
+
+template <typename scalar_t>
+struct AddScalarFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(TensorListMetadata<1>& tl, acc_t scalar) {
+    scalar_t* ptrs[1];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      ptrs[0][i] = static_cast<acc_t>(ptrs[0][i]) + scalar;
+    }
+  }
+};
+
+template <typename scalar_t>
+struct AddListFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(TensorListMetadata<2>& tl, acc_t alpha) {
+    scalar_t* ptrs[2];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      ptrs[0][i] = static_cast<acc_t>(ptrs[0][i]) + alpha * static_cast<acc_t>(ptrs[1][i]);
+    }
+  }
+};
+
+template <typename scalar_t>
+struct MulScalarFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(TensorListMetadata<1>& tl, acc_t scalar) {
+    scalar_t* ptrs[1];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      ptrs[0][i] = static_cast<acc_t>(ptrs[0][i]) * scalar;
+    }
+  }
+};
+
+template <typename scalar_t, bool divide>
+struct PointwiseFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(TensorListMetadata<3>& tl, acc_t value) {
+    scalar_t* ptrs[3];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      const acc_t a = ptrs[1][i];
+      const acc_t b = ptrs[2][i];
+      ptrs[0][i] = static_cast<acc_t>(ptrs[0][i]) + value * (divide ? a / b : a * b);
+    }
+  }
+};
+
+template <typename scalar_t>
+struct SqrtFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(TensorListMetadata<2>& tl) {
+    scalar_t* ptrs[2];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      ptrs[1][i] = ::sqrt(static_cast<acc_t>(ptrs[0][i]));
+    }
+  }
+};
+
+// params, grads, exp_avgs, exp_avg_sqs
+template <typename scalar_t>
+struct AdamFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(
+      TensorListMetadata<4>& tl, acc_t lr, acc_t beta1, acc_t beta2, acc_t eps,
+      acc_t weight_decay, acc_t bias_correction1, acc_t bias_correction2) {
+    scalar_t* ptrs[4];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      const acc_t p = ptrs[0][i];
+      const acc_t grad = static_cast<acc_t>(ptrs[1][i]) + weight_decay * p;
+      const acc_t exp_avg = beta1 * static_cast<acc_t>(ptrs[2][i]) + (1 - beta1) * grad;
+      const acc_t exp_avg_sq = beta2 * static_cast<acc_t>(ptrs[3][i]) + (1 - beta2) * grad * grad;
+      const acc_t denom = ::sqrt(exp_avg_sq / bias_correction2) + eps;
+      ptrs[0][i] = p - (lr / bias_correction1) * exp_avg / denom;
+      ptrs[2][i] = exp_avg;
+      ptrs[3][i] = exp_avg_sq;
+    }
+  }
+};
+
+// params, grads and, with momentum, momentum_buffers
+template <typename scalar_t, int depth>
+struct SGDFunctor {
+  using acc_t = acc_type<scalar_t, true>;
+  __device__ void operator()(
+      TensorListMetadata<depth>& tl, acc_t lr, acc_t momentum, acc_t dampening,
+      acc_t weight_decay, bool nesterov) {
+    scalar_t* ptrs[depth];
+    const int64_t n = chunk_pointers(tl, ptrs);
+    for (int64_t i = threadIdx.x; i < n; i += blockDim.x) {
+      const acc_t p = ptrs[0][i];
+      acc_t update = static_cast<acc_t>(ptrs[1][i]) + weight_decay * p;
+      if (depth == 3) {
+        const acc_t buffer = momentum * static_cast<acc_t>(ptrs[depth - 1][i]) + dampening * update;
+        ptrs[depth - 1][i] = buffer;
+        update = nesterov ? update + momentum * buffer : buffer;
+      }
+      ptrs[0][i] = p - lr * update;
+    }
+  }
+};
+
+std::vector<std::vector<Tensor>> to_tensor_lists(std::vector<TensorList> lists) {
+  std::vector<std::vector<Tensor>> tensor_lists;
+  tensor_lists.reserve(lists.size());
+  for (TensorList list : lists) {
+    tensor_lists.emplace_back(list.vec());
+  }
+  return tensor_lists;
+}
+
+} // namespace
+
+void foreach_tensor_add_scalar_kernel_cuda_(TensorList tensors, Scalar scalar) {
+  check_foreach_api_restrictions("_foreach_add_", {tensors});
+  if (!can_use_fast_route({tensors})) {
+    return at::native::foreach_tensor_add_scalar_kernel_slow_(tensors, scalar);
+  }
+  auto tensor_lists = to_tensor_lists({tensors});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_add_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<1>(tensor_lists, AddScalarFunctor<scalar_t>(), scalar.to<acc_t>());
+  });
+}
+
+void foreach_tensor_add_list_kernel_cuda_(TensorList tensors, TensorList other, Scalar alpha) {
+  check_foreach_api_restrictions("_foreach_add_", {tensors, other});
+  if (!can_use_fast_route({tensors, other})) {
+    return at::native::foreach_tensor_add_list_kernel_slow_(tensors, other, alpha);
+  }
+  auto tensor_lists = to_tensor_lists({tensors, other});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_add_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<2>(tensor_lists, AddListFunctor<scalar_t>(), alpha.to<acc_t>());
+  });
+}
+
+void foreach_tensor_mul_scalar_kernel_cuda_(TensorList tensors, Scalar scalar) {
+  check_foreach_api_restrictions("_foreach_mul_", {tensors});
+  if (!can_use_fast_route({tensors})) {
+    return at::native::foreach_tensor_mul_scalar_kernel_slow_(tensors, scalar);
+  }
+  auto tensor_lists = to_tensor_lists({tensors});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_mul_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<1>(tensor_lists, MulScalarFunctor<scalar_t>(), scalar.to<acc_t>());
+  });
+}
+
+void foreach_tensor_addcmul_kernel_cuda_(TensorList tensors, TensorList tensors1, TensorList tensors2, Scalar value) {
+  check_foreach_api_restrictions("_foreach_addcmul_", {tensors, tensors1, tensors2});
+  if (!can_use_fast_route({tensors, tensors1, tensors2})) {
+    return at::native::foreach_tensor_addcmul_kernel_slow_(tensors, tensors1, tensors2, value);
+  }
+  auto tensor_lists = to_tensor_lists({tensors, tensors1, tensors2});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_addcmul_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<3>(tensor_lists, PointwiseFunctor<scalar_t, false>(), value.to<acc_t>());
+  });
+}
+
+void foreach_tensor_addcdiv_kernel_cuda_(TensorList tensors, TensorList tensors1, TensorList tensors2, Scalar value) {
+  check_foreach_api_restrictions("_foreach_addcdiv_", {tensors, tensors1, tensors2});
+  if (!can_use_fast_route({tensors, tensors1, tensors2})) {
+    return at::native::foreach_tensor_addcdiv_kernel_slow_(tensors, tensors1, tensors2, value);
+  }
+  auto tensor_lists = to_tensor_lists({tensors, tensors1, tensors2});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_addcdiv_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<3>(tensor_lists, PointwiseFunctor<scalar_t, true>(), value.to<acc_t>());
+  });
+}
+
+std::vector<Tensor> foreach_tensor_sqrt_kernel_cuda(TensorList tensors) {
+  check_foreach_api_restrictions("_foreach_sqrt", {tensors});
+  if (!can_use_fast_route({tensors})) {
+    return at::native::foreach_tensor_sqrt_kernel_slow(tensors);
+  }
+  std::vector<Tensor> result;
+  result.reserve(tensors.size());
+  for (const Tensor& t : tensors) {
+    result.push_back(at::empty_like(t));
+  }
+  auto tensor_lists = to_tensor_lists({tensors, result});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(tensors[0].scalar_type(), "_foreach_sqrt", [&] {
+    multi_tensor_apply<2>(tensor_lists, SqrtFunctor<scalar_t>());
+  });
+  return result;
+}
+
+void fused_adam_kernel_cuda_(
+    TensorList params,
+    TensorList grads,
+    TensorList exp_avgs,
+    TensorList exp_avg_sqs,
+    double lr,
+    double beta1,
+    double beta2,
+    double eps,
+    double weight_decay,
+    int64_t step) {
+  check_foreach_api_restrictions("_fused_adam_", {params, grads, exp_avgs, exp_avg_sqs});
+  if (!can_use_fast_route({params, grads, exp_avgs, exp_avg_sqs})) {
+    return at::native::fused_adam_kernel_slow_(
+        params, grads, exp_avgs, exp_avg_sqs, lr, beta1, beta2, eps, weight_decay, step);
+  }
+  TORCH_CHECK(step > 0, "_fused_adam_: expected a positive step, but got ", step);
+  const double bias_correction1 = 1 - std::pow(beta1, step);
+  const double bias_correction2 = 1 - std::pow(beta2, step);
+  auto tensor_lists = to_tensor_lists({params, grads, exp_avgs, exp_avg_sqs});
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].scalar_type(), "_fused_adam_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    multi_tensor_apply<4>(
+        tensor_lists, AdamFunctor<scalar_t>(),
+        static_cast<acc_t>(lr), static_cast<acc_t>(beta1), static_cast<acc_t>(beta2),
+        static_cast<acc_t>(eps), static_cast<acc_t>(weight_decay),
+        static_cast<acc_t>(bias_correction1), static_cast<acc_t>(bias_correction2));
+  });
+}
+
+void fused_sgd_kernel_cuda_(
+    TensorList params,
+    TensorList grads,
+    TensorList momentum_buffers,
+    double lr,
+    double momentum,
+    double dampening,
+    double weight_decay,
+    bool nesterov) {
+  std::vector<TensorList> lists = {params, grads};
+  if (momentum != 0) {
+    lists.push_back(momentum_buffers);
+  }
+  check_foreach_api_restrictions("_fused_sgd_", lists);
+  if (!can_use_fast_route(lists)) {
+    return at::native::fused_sgd_kernel_slow_(
+        params, grads, momentum_buffers, lr, momentum, dampening, weight_decay, nesterov);
+  }
+  auto tensor_lists = to_tensor_lists(lists);
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(params[0].scalar_type(), "_fused_sgd_", [&] {
+    using acc_t = acc_type<scalar_t, true>;
+    if (momentum != 0) {
+      multi_tensor_apply<3>(
+          tensor_lists, SGDFunctor<scalar_t, 3>(), static_cast<acc_t>(lr), static_cast<acc_t>(momentum),
+          static_cast<acc_t>(dampening), static_cast<acc_t>(weight_decay), nesterov);
+    } else {
+      multi_tensor_apply<2>(
+          tensor_lists, SGDFunctor<scalar_t, 2>(), static_cast<acc_t>(lr), static_cast<acc_t>(momentum),
+          static_cast<acc_t>(dampening), static_cast<acc_t>(weight_decay), nesterov);
+    }
+  });
+}
+
+} // namespace native
+} // namespace at
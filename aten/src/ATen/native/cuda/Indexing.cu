@@ -19,73 +19,171 @@
 
 namespace {
 
-template <typename scalar_t, int SZ>
-__global__ void indexing_backward_kernel(
-  int64_t* sorted_indices, int64_t* indices, scalar_t* grad_output, scalar_t* grad_weight,
-  int64_t numel, int64_t stride, int64_t stride_before, int64_t outer_dim) {
-//numel is total number of flattened indices, not expanded to dimensions that are not indexed.
-//stride is the cumulative size of the not-indexed last dimensions
-//stride_before is the stride of the dimension immediately preceding first indexed dimension
-//if indexing starts from the 0th dimension, stride_before does not matter because blockIdx.z will be 0 in this case
-//outer_dim is number of elements in the first unindexed dimensions
+// index_put_ with accumulate sums the value rows of every destination
+// index with a segmented reduction over the indices sorted by destination:
+// a segment holds the entries of one destination and is cut into partial
+// segments of at most NROWS_PER_PARTIAL entries, which are summed in parallel.
+// A segment made of a single partial segment is written by it, the partial
+// sums of the others are written to a buffer and summed in order by
+// index_put_accum_segments_kernel. Every element of self is written once and
+// the order of the additions doesn't depend on scheduling, so the result is
+// deterministic.
+//
+// numel is the number of flattened indices, stride the number of elements of
+// the not-indexed last dimensions, stride_before the stride of the dimension
+// preceding the first indexed one and outer_dim the number of elements of the
+// first not-indexed dimensions. Offsets are computed with index_t, int64_t
+// for tensors with INT_MAX or more elements.
+constexpr int64_t NROWS_PER_PARTIAL = 32;
+
+__global__ void index_put_accum_num_partials_kernel(
+  const int64_t* segment_sizes, int64_t num_segments,
+  int64_t* num_partials, int64_t* num_slots) {
+  int64_t s = blockIdx.x * static_cast<int64_t>(blockDim.x) + threadIdx.x;
+  if (s < num_segments) {
+    int64_t partials = (segment_sizes[s] + NROWS_PER_PARTIAL - 1) / NROWS_PER_PARTIAL;
+    num_partials[s] = partials;
+    num_slots[s] = partials > 1 ? partials : 0;
+  }
+}
+
+__global__ void index_put_accum_partial_segments_kernel(
+  const int64_t* partial_ends, int64_t num_segments, int64_t* partial_segments) {
+  int64_t s = blockIdx.x * static_cast<int64_t>(blockDim.x) + threadIdx.x;
+  if (s < num_segments) {
+    for (int64_t p = s == 0 ? 0 : partial_ends[s - 1]; p < partial_ends[s]; p++) {
+      partial_segments[p] = s;
+    }
+  }
+}
+
+template <typename scalar_t, typename index_t>
+__global__ void index_put_accum_partials_kernel(
+  const int64_t* sorted_indices, const int64_t* orig_indices,
+  const scalar_t* values, scalar_t* self,
+  at::acc_type<scalar_t, true>* partial_sums, const int64_t* partial_segments,
+  const int64_t* segment_ends, const int64_t* partial_ends, const int64_t* slot_ends,
+  int64_t num_partials, int64_t numel, int64_t stride, int64_t stride_before, int64_t outer_dim) {
   using accscalar_t = at::acc_type<scalar_t, true>;
 
-  // Each warp is responsible for an input into the LookupTable.
-  // If the preceding input has the same destination index as this input, then the warp
-  // exits immediately. The warp also processes subsequent inputs with the
-  // same value.
-  //
-  // Input Warp
-  // 1     <warp 1>
-  // 1     <warp 1> (<warp 2> exits without doing any work)
-  // 5     <warp 3>
-  // 8     <warp 4>
-
-  // Number of values processed by each thread (grain size)
-  for (int z = blockIdx.z; z < outer_dim; z += gridDim.z){
-    int idx = blockIdx.x * blockDim.y + threadIdx.y;
-    if (idx < numel
-        && (idx == 0 || sorted_indices[idx] != sorted_indices[idx - 1])){
-      do {
-        int start_feature = threadIdx.x + blockIdx.y * blockDim.x * SZ;
-        const int weight_row = ((int) sorted_indices[idx]) * stride + z * stride_before;
-        const int grad_row = ((int) indices[idx]) * stride + z * numel * stride;
-        const accscalar_t scale = (accscalar_t)1.0;
-
-        accscalar_t gradient[SZ];
-        accscalar_t weight[SZ];
-
-        while (start_feature < stride) {
-          #pragma unroll
-          for (int ii = 0; ii < SZ; ii++) {
-            int feature_dim = start_feature + ii * C10_WARP_SIZE;
-            if (feature_dim < stride) {
-              gradient[ii] = static_cast<accscalar_t>(grad_output[grad_row + feature_dim]);
-              weight[ii] = static_cast<accscalar_t>(grad_weight[weight_row + feature_dim]);
-            }
-          }
-
-          #pragma unroll
-          for (int ii = 0; ii < SZ; ii++) {
-            weight[ii] += gradient[ii] * scale;
-          }
-
-          #pragma unroll
-          for (int ii = 0; ii < SZ; ii++) {
-            int feature_dim = start_feature + ii * C10_WARP_SIZE;
-            if (feature_dim < stride) {
-                grad_weight[weight_row + feature_dim] = static_cast<scalar_t>(weight[ii]);
-            }
-          }
-          start_feature += gridDim.y * blockDim.x * SZ;
-        }
+  int64_t p = blockIdx.x * static_cast<int64_t>(blockDim.y) + threadIdx.y;
+  if (p >= num_partials) {
+    return;
+  }
+  int64_t s = partial_segments[p];
+  int64_t first_partial = s == 0 ? 0 : partial_ends[s - 1];
+  int64_t begin = (s == 0 ? 0 : segment_ends[s - 1]) + (p - first_partial) * NROWS_PER_PARTIAL;
+  int64_t end = min(begin + NROWS_PER_PARTIAL, segment_ends[s]);
+  bool single = partial_ends[s] - first_partial == 1;
+  int64_t slot = (s == 0 ? 0 : slot_ends[s - 1]) + (p - first_partial);
+
+  for (int64_t z = blockIdx.z; z < outer_dim; z += gridDim.z) {
+    for (int64_t f = threadIdx.x + blockIdx.y * static_cast<int64_t>(blockDim.x);
+         f < stride; f += gridDim.y * static_cast<int64_t>(blockDim.x)) {
+      accscalar_t sum = 0;
+      for (int64_t i = begin; i < end; i++) {
+        index_t value_idx = (static_cast<index_t>(orig_indices[i]) + static_cast<index_t>(z * numel)) *
+            static_cast<index_t>(stride) + static_cast<index_t>(f);
+        sum += static_cast<accscalar_t>(values[value_idx]);
+      }
+      if (single) {
+        index_t self_idx = static_cast<index_t>(sorted_indices[begin]) * static_cast<index_t>(stride) +
+            static_cast<index_t>(z * stride_before + f);
+        self[self_idx] = static_cast<scalar_t>(static_cast<accscalar_t>(self[self_idx]) + sum);
+      } else {
+        partial_sums[(slot * outer_dim + z) * stride + f] = sum;
+      }
+    }
+  }
+}
 
-        idx++;
-      } while (idx < numel && sorted_indices[idx] == sorted_indices[idx - 1]);
+template <typename scalar_t, typename index_t>
+__global__ void index_put_accum_segments_kernel(
+  const int64_t* sorted_indices, scalar_t* self,
+  const at::acc_type<scalar_t, true>* partial_sums,
+  const int64_t* segment_ends, const int64_t* slot_ends,
+  int64_t num_segments, int64_t stride, int64_t stride_before, int64_t outer_dim) {
+  using accscalar_t = at::acc_type<scalar_t, true>;
+
+  int64_t s = blockIdx.x * static_cast<int64_t>(blockDim.y) + threadIdx.y;
+  if (s >= num_segments) {
+    return;
+  }
+  int64_t first_slot = s == 0 ? 0 : slot_ends[s - 1];
+  if (first_slot == slot_ends[s]) {
+    // a single partial segment, already written
+    return;
+  }
+  int64_t segment_begin = s == 0 ? 0 : segment_ends[s - 1];
+
+  for (int64_t z = blockIdx.z; z < outer_dim; z += gridDim.z) {
+    for (int64_t f = threadIdx.x + blockIdx.y * static_cast<int64_t>(blockDim.x);
+         f < stride; f += gridDim.y * static_cast<int64_t>(blockDim.x)) {
+      accscalar_t sum = 0;
+      for (int64_t slot = first_slot; slot < slot_ends[s]; slot++) {
+        sum += partial_sums[(slot * outer_dim + z) * stride + f];
+      }
+      index_t self_idx = static_cast<index_t>(sorted_indices[segment_begin]) * static_cast<index_t>(stride) +
+          static_cast<index_t>(z * stride_before + f);
+      self[self_idx] = static_cast<scalar_t>(static_cast<accscalar_t>(self[self_idx]) + sum);
     }
   }
 }
 
+template <typename scalar_t, typename index_t>
+void index_put_accum_launch(
+  const at::Tensor& sorted_indices, const at::Tensor& orig_indices,
+  const at::Tensor& values, at::Tensor& self, const at::Tensor& partial_segments,
+  const at::Tensor& segment_ends, const at::Tensor& partial_ends, const at::Tensor& slot_ends,
+  int64_t num_slots, int64_t numel, int64_t stride, int64_t stride_before, int64_t outer_dim) {
+  using accscalar_t = at::acc_type<scalar_t, true>;
+  const cudaStream_t stream = at::cuda::getCurrentCUDAStream();
+  int64_t num_partials = partial_segments.numel();
+  int64_t num_segments = segment_ends.numel();
+
+  const int rows_per_block = 4;
+  auto max_grid = at::cuda::getCurrentDeviceProperties()->maxGridSize;
+  int64_t feature_blocks = std::min<int64_t>(max_grid[1], THCCeilDiv(stride, (int64_t) C10_WARP_SIZE));
+  int64_t outer_blocks = std::min<int64_t>(std::max<int64_t>(1, outer_dim), max_grid[2]);
+  dim3 partial_grid(THCCeilDiv(num_partials, (int64_t) rows_per_block), feature_blocks, outer_blocks);
+  dim3 block(C10_WARP_SIZE, rows_per_block);
+
+  // the partial sums of the segments with several partial segments, at most
+  // 2 / NROWS_PER_PARTIAL of the size of values
+  at::Tensor partial_sums = at::empty(
+      {num_slots, std::max<int64_t>(1, outer_dim), stride},
+      values.options().dtype(std::is_same<accscalar_t, double>::value ? at::kDouble : at::kFloat));
+  index_put_accum_partials_kernel<scalar_t, index_t><<<partial_grid, block, 0, stream>>>(
+    sorted_indices.data_ptr<int64_t>(),
+    orig_indices.data_ptr<int64_t>(),
+    values.data_ptr<scalar_t>(),
+    self.data_ptr<scalar_t>(),
+    partial_sums.data_ptr<accscalar_t>(),
+    partial_segments.data_ptr<int64_t>(),
+    segment_ends.data_ptr<int64_t>(),
+    partial_ends.data_ptr<int64_t>(),
+    slot_ends.data_ptr<int64_t>(),
+    num_partials,
+    numel,
+    stride,
+    stride_before,
+    outer_dim);
+  THCudaCheck(cudaGetLastError());
+  if (num_slots > 0) {
+    dim3 segment_grid(THCCeilDiv(num_segments, (int64_t) rows_per_block), feature_blocks, outer_blocks);
+    index_put_accum_segments_kernel<scalar_t, index_t><<<segment_grid, block, 0, stream>>>(
+      sorted_indices.data_ptr<int64_t>(),
+      self.data_ptr<scalar_t>(),
+      partial_sums.data_ptr<accscalar_t>(),
+      segment_ends.data_ptr<int64_t>(),
+      slot_ends.data_ptr<int64_t>(),
+      num_segments,
+      stride,
+      stride_before,
+      outer_dim);
+    THCudaCheck(cudaGetLastError());
+  }
+}
 
 }    
 
@@ -216,25 +314,43 @@ void index_put_accum_kernel(Tensor & self, TensorList indices, const Tensor & va
       thrust::sort_by_key(policy, sorted_data, sorted_data + num_indices, orig_data, ThrustLTOp<int64_t>());
       }
       TORCH_INTERNAL_ASSERT(linearIndex.numel()*sliceSize*nElemBefore == value.numel(), "number of flattened indices did not match number of elements in the value tensor", linearIndex.numel()*sliceSize*nElemBefore, value.numel());
-      TORCH_CHECK(self.numel() < std::numeric_limits<int>::max(), "index_put_ with accumulation is not supported on large tensors, number of source elements =", self.numel(), "file a support request on github");
-      TORCH_CHECK(value.numel() < std::numeric_limits<int>::max(), "index_put_ with accumulation is not supported on large tensors, number of source elements =", value.numel(), "file a support request on github");
-      const int UNROLL = 4;
-      const int indices_per_block = 4;
-      dim3 grid(THCCeilDiv(num_indices, (int64_t) indices_per_block),
-           std::min<int>(at::cuda::getCurrentDeviceProperties()->maxGridSize[1], THCCeilDiv(sliceSize, (int64_t) (C10_WARP_SIZE*UNROLL))),
-           std::min(std::max<int>(1,nElemBefore), at::cuda::getCurrentDeviceProperties()->maxGridSize[2]));
-      dim3 block(C10_WARP_SIZE, indices_per_block);
-  
-      AT_DISPATCH_FLOATING_TYPES_AND_HALF(value_.scalar_type(), "embedding_backward", [&] {
-      indexing_backward_kernel<scalar_t, UNROLL><<<grid, block, 0, stream>>>(
-        sorted_indices.data_ptr<int64_t>(),
-        orig_indices.data_ptr<int64_t>(),
-        value_.data_ptr<scalar_t>(),
-        src_.data_ptr<scalar_t>(),
-        num_indices,
-        sliceSize,
-        strideBefore,
-        nElemBefore);
+      const bool use_32bit_indexing =
+          src_.numel() < std::numeric_limits<int>::max() &&
+          value_.numel() < std::numeric_limits<int>::max();
+
+      // segments of equal destination indices
+      Tensor segment_ends = std::get<2>(at::unique_consecutive(
+          sorted_indices, /*return_inverse=*/false, /*return_counts=*/true));
+      int64_t num_segments = segment_ends.numel();
+      Tensor partial_ends = at::empty_like(segment_ends);
+      Tensor slot_ends = at::empty_like(segment_ends);
+      const int threads = 256;
+      dim3 segment_grid(THCCeilDiv(num_segments, (int64_t) threads));
+      index_put_accum_num_partials_kernel<<<segment_grid, threads, 0, stream>>>(
+        segment_ends.data_ptr<int64_t>(), num_segments,
+        partial_ends.data_ptr<int64_t>(), slot_ends.data_ptr<int64_t>());
+      THCudaCheck(cudaGetLastError());
+      segment_ends.cumsum_(0);
+      partial_ends.cumsum_(0);
+      slot_ends.cumsum_(0);
+      int64_t num_partials = partial_ends[-1].item<int64_t>();
+      int64_t num_slots = slot_ends[-1].item<int64_t>();
+
+      Tensor partial_segments = at::empty({num_partials}, segment_ends.options());
+      index_put_accum_partial_segments_kernel<<<segment_grid, threads, 0, stream>>>(
+        partial_ends.data_ptr<int64_t>(), num_segments, partial_segments.data_ptr<int64_t>());
+      THCudaCheck(cudaGetLastError());
+
+      AT_DISPATCH_FLOATING_TYPES_AND_HALF(value_.scalar_type(), "index_put_accum", [&] {
+        if (use_32bit_indexing) {
+          index_put_accum_launch<scalar_t, int>(
+            sorted_indices, orig_indices, value_, src_, partial_segments, segment_ends,
+            partial_ends, slot_ends, num_slots, num_indices, sliceSize, strideBefore, nElemBefore);
+        } else {
+          index_put_accum_launch<scalar_t, int64_t>(
+            sorted_indices, orig_indices, value_, src_, partial_segments, segment_ends,
+            partial_ends, slot_ends, num_slots, num_indices, sliceSize, strideBefore, nElemBefore);
+        }
       });
       THCudaCheck(cudaGetLastError());
       if (permuted)
@@ -34,6 +34,7 @@
 #include <ATen/cuda/detail/OffsetCalculator.cuh>
 #include <ATen/detail/FunctionTraits.h>
 #include <ATen/native/TensorIterator.h>
+#include <ATen/native/cuda/MemoryAccess.cuh>
 #include <c10/macros/Macros.h>
 
 // Marks a lambda as executable on both the host and device. The __host__
@@ -102,6 +103,72 @@ static void launch_kernel(int64_t N, const func_t& f) {
   AT_CUDA_CHECK(cudaGetLastError());
 }
 
+// Each thread loads, computes and stores vec_size consecutive elements, with
+// one vectorized access per operand. The N % vec_size trailing elements are
+// handled one per thread by the first threads.
+template<int vec_size, typename func_t, typename array_t>
+C10_LAUNCH_BOUNDS_1(launch_size_1d)
+__global__ void vectorized_elementwise_kernel(int N, func_t f, array_t data) {
+  using traits = function_traits<func_t>;
+  using return_t = typename traits::result_type;
+  using vectors_t =
+      typename memory::vectors_of<vec_size, typename traits::ArgsTuple>::type;
+  using Indices = c10::guts::make_index_sequence<traits::arity>;
+
+  int vec_idx = blockIdx.x * blockDim.x + threadIdx.x;
+  int num_vecs = N / vec_size;
+  if (vec_idx < num_vecs) {
+    vectors_t args;
+    args.load(&data.data[1], vec_idx);
+    memory::aligned_vector<return_t, vec_size> out;
+    #pragma unroll
+    for (int lane = 0; lane < vec_size; lane++) {
+      out.val[lane] = memory::apply_lane<traits>(f, args, lane, Indices{});
+    }
+    reinterpret_cast<memory::aligned_vector<return_t, vec_size>*>(data[0])[vec_idx] = out;
+  }
+  int idx = num_vecs * vec_size + vec_idx;
+  if (idx < N) {
+    reinterpret_cast<return_t*>(data[0])[idx] =
+        memory::apply_contiguous<traits>(f, &data.data[1], idx, Indices{});
+  }
+}
+
+template<int vec_size, typename func_t, typename array_t>
+static void launch_vectorized_kernel(int64_t N, const func_t& f, array_t data) {
+  TORCH_INTERNAL_ASSERT(N > 0 && N <= std::numeric_limits<int32_t>::max());
+  int64_t threads = std::max<int64_t>(N / vec_size, N % vec_size);
+  dim3 block(launch_size_1d);
+  dim3 grid((threads + block.x - 1) / block.x);
+  auto stream = at::cuda::getCurrentCUDAStream();
+  vectorized_elementwise_kernel<vec_size, func_t, array_t>
+      <<<grid, block, 0, stream>>>(N, f, data);
+  AT_CUDA_CHECK(cudaGetLastError());
+}
+
+// Launches the vectorized kernel with the widest vectors the operands are
+// aligned for: 128 bits, or half as wide. Returns false if they are aligned
+// for neither.
+template<typename func_t, typename array_t>
+static bool try_launch_vectorized_kernel(int64_t N, const func_t& f, array_t data) {
+  using traits = function_traits<func_t>;
+  constexpr int wide_vec_size = memory::vec_size_of<traits>::value;
+  constexpr int narrow_vec_size = wide_vec_size > 2 ? wide_vec_size / 2 : 2;
+  if (wide_vec_size < 2) {
+    return false;
+  }
+  if (memory::can_vectorize<traits>(data, wide_vec_size)) {
+    launch_vectorized_kernel<wide_vec_size>(N, f, data);
+    return true;
+  }
+  if (narrow_vec_size < wide_vec_size &&
+      memory::can_vectorize<traits>(data, narrow_vec_size)) {
+    launch_vectorized_kernel<narrow_vec_size>(N, f, data);
+    return true;
+  }
+  return false;
+}
+
 template <typename traits, typename func_t, typename index_t, size_t... INDEX>
 C10_HOST_DEVICE typename traits::result_type
 invoke_impl(const func_t &f, char *const C10_RESTRICT data[], const index_t strides[], int i,
@@ -138,7 +205,13 @@ void gpu_kernel_impl(TensorIterator& iter, const func_t& f) {
     for (int i = 0; i < ntensors; i++) {
       strides[i] = inner_strides[i];
     }
-   
+
+    // Contiguous operands aligned to a vector of their type are accessed
+    // several elements at a time.
+    if (memory::is_contiguous<traits>(strides) &&
+        try_launch_vectorized_kernel(numel, f, data)) {
+      return;
+    }
 
     launch_kernel<launch_size_1d, 1>(numel, [=]GPU_LAMBDA(int idx) {
       arg0_t* out = (arg0_t*)(data[0] + strides[0] * idx);
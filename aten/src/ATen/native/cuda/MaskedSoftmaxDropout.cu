@@ -0,0 +1,352 @@
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/CUDAGenerator.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/detail/IndexUtils.cuh>
+#include <ATen/cuda/detail/TensorInfo.cuh>
+#include <ATen/native/cuda/PersistentSoftmax.cuh>
+#include <c10/macros/Macros.h>
+#include <curand_kernel.h>
+
+#include <THC/THCDeviceUtils.cuh>
+#include <THC/THCGeneral.h>
+
+namespace at {
+namespace native {
+
+namespace {
+
+// _masked_softmax_dropout computes dropout(softmax(self + mask, -1), p) with
+// one warp per row of self, like softmax_warp_forward, reading self and the
+// mask once and writing the result and the softmax once. The dropout mask
+// isn't stored: every thread draws it from its own philox subsequence, given
+// by its row and lane, so the backward pass regenerates it from the seed and
+// offset returned by the forward pass.
+//
+// A boolean mask is true for the elements to leave out. The elements of rows
+// left out entirely are all 0.
+
+// The keep mask of the elements lane + it * WARP_SIZE of row, the same in the
+// forward and the backward pass.
+template <int WARP_ITERATIONS, int WARP_SIZE, typename acc_t>
+__device__ __forceinline__ void dropout_keep_mask(
+    bool* keep, int64_t row, int lane, acc_t keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  curandStatePhilox4_32_10_t state;
+  curand_init(seeds.first, row * WARP_SIZE + lane, seeds.second, &state);
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; it += 4) {
+    float4 rand = curand_uniform4(&state);
+    #pragma unroll
+    for (int ii = 0; ii < 4; ii++) {
+      if (it + ii < WARP_ITERATIONS) {
+        keep[it + ii] = (&rand.x)[ii] < keep_prob;
+      }
+    }
+  }
+}
+
+template <typename scalar_t, typename mask_t, typename acc_t, int log2_elements>
+__global__ void masked_softmax_dropout_warp_forward(
+    scalar_t* dst, scalar_t* softmax, const scalar_t* src,
+    cuda::detail::TensorInfo<mask_t, int64_t> mask_rows, int64_t mask_stride,
+    int64_t rows, int element_count, acc_t keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  constexpr int next_power_of_two = 1 << log2_elements;
+  constexpr int WARP_SIZE = (next_power_of_two < C10_WARP_SIZE) ? next_power_of_two : C10_WARP_SIZE;
+  constexpr int WARP_ITERATIONS = next_power_of_two / WARP_SIZE;
+
+  int64_t row = blockDim.y * static_cast<int64_t>(blockIdx.x) + threadIdx.y;
+  if (row >= rows) {
+    return;
+  }
+  int lane = threadIdx.x;
+  src += row * element_count + lane;
+  dst += row * element_count + lane;
+  softmax += row * element_count + lane;
+  const mask_t* mask = mask_rows.data +
+      cuda::detail::IndexToOffset<mask_t, int64_t, -1>::get(row, mask_rows) + lane * mask_stride;
+
+  acc_t elements[WARP_ITERATIONS];
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; ++it) {
+    int element_index = lane + it * WARP_SIZE;
+    elements[it] = -std::numeric_limits<acc_t>::infinity();
+    if (element_index < element_count) {
+      mask_t m = mask[it * WARP_SIZE * mask_stride];
+      if (std::is_same<mask_t, bool>::value) {
+        if (!m) {
+          elements[it] = src[it * WARP_SIZE];
+        }
+      } else {
+        elements[it] = static_cast<acc_t>(src[it * WARP_SIZE]) + static_cast<acc_t>(m);
+      }
+    }
+  }
+
+  acc_t max_value[1] = {elements[0]};
+  #pragma unroll
+  for (int it = 1; it < WARP_ITERATIONS; ++it) {
+    max_value[0] = (max_value[0] > elements[it]) ? max_value[0] : elements[it];
+  }
+  warp_reduce<acc_t, 1, WARP_SIZE, Max>(max_value);
+  if (max_value[0] == -std::numeric_limits<acc_t>::infinity()) {
+    // every element is left out, avoid computing exp(-inf + inf)
+    max_value[0] = 0;
+  }
+
+  acc_t sum[1] = {0};
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; ++it) {
+    elements[it] = std::exp(elements[it] - max_value[0]);
+    sum[0] += elements[it];
+  }
+  warp_reduce<acc_t, 1, WARP_SIZE, Add>(sum);
+  acc_t scale = sum[0] > 0 ? acc_t(1) / sum[0] : acc_t(0);
+
+  bool keep[WARP_ITERATIONS];
+  if (keep_prob < 1) {
+    dropout_keep_mask<WARP_ITERATIONS, WARP_SIZE>(keep, row, lane, keep_prob, seeds);
+  }
+  acc_t pinv = acc_t(1) / keep_prob;
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; ++it) {
+    int element_index = lane + it * WARP_SIZE;
+    if (element_index < element_count) {
+      acc_t y = elements[it] * scale;
+      softmax[it * WARP_SIZE] = y;
+      dst[it * WARP_SIZE] = (keep_prob < 1 && !keep[it]) ? acc_t(0) : y * pinv;
+    }
+  }
+}
+
+template <typename scalar_t, typename acc_t, int log2_elements>
+__global__ void masked_softmax_dropout_warp_backward(
+    scalar_t* grad_input, const scalar_t* grad, const scalar_t* softmax,
+    int64_t rows, int element_count, acc_t keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  constexpr int next_power_of_two = 1 << log2_elements;
+  constexpr int WARP_SIZE = (next_power_of_two < C10_WARP_SIZE) ? next_power_of_two : C10_WARP_SIZE;
+  constexpr int WARP_ITERATIONS = next_power_of_two / WARP_SIZE;
+
+  int64_t row = blockDim.y * static_cast<int64_t>(blockIdx.x) + threadIdx.y;
+  if (row >= rows) {
+    return;
+  }
+  int lane = threadIdx.x;
+  grad_input += row * element_count + lane;
+  grad += row * element_count + lane;
+  softmax += row * element_count + lane;
+
+  bool keep[WARP_ITERATIONS];
+  if (keep_prob < 1) {
+    dropout_keep_mask<WARP_ITERATIONS, WARP_SIZE>(keep, row, lane, keep_prob, seeds);
+  }
+  acc_t pinv = acc_t(1) / keep_prob;
+
+  // the gradient of the softmax, and its dot product with the softmax
+  acc_t grad_reg[WARP_ITERATIONS];
+  acc_t softmax_reg[WARP_ITERATIONS];
+  acc_t sum[1] = {0};
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; ++it) {
+    int element_index = lane + it * WARP_SIZE;
+    grad_reg[it] = 0;
+    softmax_reg[it] = 0;
+    if (element_index < element_count) {
+      softmax_reg[it] = softmax[it * WARP_SIZE];
+      if (keep_prob == 1 || keep[it]) {
+        grad_reg[it] = static_cast<acc_t>(grad[it * WARP_SIZE]) * pinv;
+      }
+    }
+    sum[0] += grad_reg[it] * softmax_reg[it];
+  }
+  warp_reduce<acc_t, 1, WARP_SIZE, Add>(sum);
+
+  #pragma unroll
+  for (int it = 0; it < WARP_ITERATIONS; ++it) {
+    int element_index = lane + it * WARP_SIZE;
+    if (element_index < element_count) {
+      grad_input[it * WARP_SIZE] = softmax_reg[it] * (grad_reg[it] - sum[0]);
+    }
+  }
+}
+
+// The launch configuration of the warp kernels for rows of element_count
+// elements: the block size, the grid size and the number of 32-bit random
+// values every thread draws.
+struct WarpLaunch {
+  dim3 threads;
+  dim3 blocks;
+  int64_t counter_offset;
+};
+
+WarpLaunch warp_launch(int log2_elements, int64_t rows) {
+  const int next_power_of_two = 1 << log2_elements;
+  // This value must match the WARP_SIZE constexpr value computed inside the kernels.
+  int warp_size = (next_power_of_two < C10_WARP_SIZE) ? next_power_of_two : C10_WARP_SIZE;
+  constexpr int threads_per_block = 128;
+  int warps_per_block = threads_per_block / warp_size;
+  int warp_iterations = next_power_of_two / warp_size;
+  WarpLaunch launch;
+  launch.threads = dim3(warp_size, warps_per_block, 1);
+  launch.blocks = dim3((rows + warps_per_block - 1) / warps_per_block);
+  launch.counter_offset = (warp_iterations + 3) / 4 * 4;
+  return launch;
+}
+
+template <typename scalar_t, typename mask_t, typename acc_t, int log2_elements>
+void launch_masked_softmax_dropout_forward(
+    Tensor& output, Tensor& softmax, const Tensor& self, const Tensor& mask,
+    int64_t rows, int element_count, acc_t keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  WarpLaunch launch = warp_launch(log2_elements, rows);
+  // the offsets of the rows of the mask, broadcasted to self
+  auto mask_rows = cuda::detail::getTensorInfo<mask_t, int64_t>(mask.select(-1, 0));
+  mask_rows.collapseDims();
+  masked_softmax_dropout_warp_forward<scalar_t, mask_t, acc_t, log2_elements>
+    <<<launch.blocks, launch.threads, 0, at::cuda::getCurrentCUDAStream()>>>(
+      output.data_ptr<scalar_t>(), softmax.data_ptr<scalar_t>(), self.data_ptr<scalar_t>(),
+      mask_rows, mask.stride(-1), rows, element_count, keep_prob, seeds);
+}
+
+template <typename scalar_t, typename mask_t>
+void dispatch_masked_softmax_dropout_forward(
+    Tensor& output, Tensor& softmax, const Tensor& self, const Tensor& mask,
+    int64_t rows, int element_count, double keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  using acc_t = acc_type<scalar_t, true>;
+  acc_t keep = static_cast<acc_t>(keep_prob);
+  // Launch code would be more elegant if C++ supported FOR CONSTEXPR
+  switch (log2_ceil(element_count)) {
+    case 0: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 0>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 1: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 1>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 2: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 2>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 3: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 3>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 4: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 4>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 5: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 5>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 6: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 6>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 7: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 7>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 8: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 8>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 9: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 9>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    case 10: launch_masked_softmax_dropout_forward<scalar_t, mask_t, acc_t, 10>(output, softmax, self, mask, rows, element_count, keep, seeds); break;
+    default: break;
+  }
+}
+
+template <typename scalar_t, typename acc_t, int log2_elements>
+void launch_masked_softmax_dropout_backward(
+    Tensor& grad_input, const Tensor& grad, const Tensor& softmax,
+    int64_t rows, int element_count, acc_t keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  WarpLaunch launch = warp_launch(log2_elements, rows);
+  masked_softmax_dropout_warp_backward<scalar_t, acc_t, log2_elements>
+    <<<launch.blocks, launch.threads, 0, at::cuda::getCurrentCUDAStream()>>>(
+      grad_input.data_ptr<scalar_t>(), grad.data_ptr<scalar_t>(), softmax.data_ptr<scalar_t>(),
+      rows, element_count, keep_prob, seeds);
+}
+
+template <typename scalar_t>
+void dispatch_masked_softmax_dropout_backward(
+    Tensor& grad_input, const Tensor& grad, const Tensor& softmax,
+    int64_t rows, int element_count, double keep_prob, std::pair<uint64_t, uint64_t> seeds) {
+  using acc_t = acc_type<scalar_t, true>;
+  acc_t keep = static_cast<acc_t>(keep_prob);
+  // Launch code would be more elegant if C++ supported FOR CONSTEXPR
+  switch (log2_ceil(element_count)) {
+    case 0: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 0>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 1: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 1>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 2: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 2>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 3: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 3>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 4: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 4>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 5: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 5>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 6: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 6>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 7: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 7>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 8: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 8>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 9: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 9>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    case 10: launch_masked_softmax_dropout_backward<scalar_t, acc_t, 10>(grad_input, grad, softmax, rows, element_count, keep, seeds); break;
+    default: break;
+  }
+}
+
+constexpr int64_t kMaxSoftmaxElements = 1024;
+
+} // anonymous namespace
+
+std::tuple<Tensor, Tensor, Tensor> masked_softmax_dropout_cuda(
+    const Tensor& self_, const Tensor& mask_, double p, Generator* gen_) {
+  TORCH_CHECK(self_.dim() > 0, "masked_softmax_dropout: expected a tensor with at least one dimension");
+  TORCH_CHECK(p >= 0 && p < 1, "masked_softmax_dropout: dropout probability has to be in [0, 1), but got ", p);
+  TORCH_CHECK(mask_.scalar_type() == kBool || mask_.scalar_type() == self_.scalar_type(),
+              "masked_softmax_dropout: expected a boolean mask or a mask of the type of self, but got ",
+              mask_.scalar_type());
+  TORCH_CHECK(mask_.device() == self_.device(),
+              "masked_softmax_dropout: expected the mask on the device of self, ", self_.device(),
+              ", but got ", mask_.device());
+  int64_t element_count = self_.size(-1);
+  TORCH_CHECK(element_count <= kMaxSoftmaxElements,
+              "masked_softmax_dropout: only supports rows of at most ", kMaxSoftmaxElements,
+              " elements, but got ", element_count);
+
+  Tensor self = self_.contiguous();
+  Tensor mask = mask_.expand(self.sizes());
+  if (mask.dim() == 1) {
+    // a single row, give the offsets of the rows a dimension
+    mask = mask.unsqueeze(0);
+  }
+  Tensor output = at::empty_like(self);
+  Tensor softmax = at::empty_like(self);
+  // the philox seed and offset of the dropout mask
+  Tensor rng_state = at::zeros({2}, self.options().dtype(kLong).device(kCPU));
+  int64_t rows = element_count == 0 ? 0 : self.numel() / element_count;
+  if (rows == 0) {
+    return std::make_tuple(output, softmax, rng_state);
+  }
+
+  std::pair<uint64_t, uint64_t> rng_engine_inputs(0, 0);
+  if (p > 0) {
+    auto gen = get_generator_or_default<CUDAGenerator>(gen_, cuda::detail::getDefaultCUDAGenerator());
+    int64_t counter_offset = warp_launch(log2_ceil(element_count), rows).counter_offset;
+    {
+      // See Note [Acquire lock when using random generators]
+      std::lock_guard<std::mutex> lock(gen->mutex_);
+      rng_engine_inputs = gen->philox_engine_inputs(counter_offset);
+    }
+    auto rng_state_data = rng_state.data_ptr<int64_t>();
+    rng_state_data[0] = static_cast<int64_t>(rng_engine_inputs.first);
+    rng_state_data[1] = static_cast<int64_t>(rng_engine_inputs.second);
+  }
+
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(self.scalar_type(), "masked_softmax_dropout", [&] {
+    if (mask.scalar_type() == kBool) {
+      dispatch_masked_softmax_dropout_forward<scalar_t, bool>(
+        output, softmax, self, mask, rows, element_count, 1 - p, rng_engine_inputs);
+    } else {
+      dispatch_masked_softmax_dropout_forward<scalar_t, scalar_t>(
+        output, softmax, self, mask, rows, element_count, 1 - p, rng_engine_inputs);
+    }
+  });
+  THCudaCheck(cudaGetLastError());
+  return std::make_tuple(output, softmax, rng_state);
+}
+
+Tensor masked_softmax_dropout_backward_cuda(
+    const Tensor& grad_, const Tensor& softmax, const Tensor& rng_state, double p) {
+  TORCH_CHECK(softmax.is_contiguous(), "masked_softmax_dropout_backward: expected a contiguous softmax");
+  TORCH_CHECK(rng_state.device().is_cpu() && rng_state.scalar_type() == kLong && rng_state.numel() == 2,
+              "masked_softmax_dropout_backward: expected the random state returned by masked_softmax_dropout");
+  Tensor grad = grad_.contiguous();
+  Tensor grad_input = at::empty_like(softmax);
+  int64_t element_count = softmax.size(-1);
+  int64_t rows = element_count == 0 ? 0 : softmax.numel() / element_count;
+  if (rows == 0) {
+    return grad_input;
+  }
+  auto rng_state_data = rng_state.data_ptr<int64_t>();
+  std::pair<uint64_t, uint64_t> rng_engine_inputs(
+      static_cast<uint64_t>(rng_state_data[0]), static_cast<uint64_t>(rng_state_data[1]));
+
+  AT_DISPATCH_FLOATING_TYPES_AND_HALF(softmax.scalar_type(), "masked_softmax_dropout_backward", [&] {
+    dispatch_masked_softmax_dropout_backward<scalar_t>(
+      grad_input, grad, softmax, rows, element_count, 1 - p, rng_engine_inputs);
+  });
+  THCudaCheck(cudaGetLastError());
+  return grad_input;
+}
+
+} // namespace native
+} // namespace at
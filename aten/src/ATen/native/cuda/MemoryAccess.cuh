@@ -0,0 +1,148 @@
+#pragma once
+
+// Helpers for elementwise kernels that load and store several consecutive
+// elements of their operands with a single vectorized memory access, e.g.
+// float4 or 8 halves in 128 bits. See the vectorized path of gpu_kernel in
+// Loops.cuh.
+
+#include <ATen/detail/FunctionTraits.h>
+#include <c10/macros/Macros.h>
+#include <c10/util/C++17.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+namespace at { namespace native { namespace memory {
+
+// Vectorized accesses load and store at most 128 bits.
+static constexpr int max_access_bytes = 16;
+static constexpr int max_vec_size = 8;
+
+template <typename scalar_t, int vec_size>
+struct alignas(sizeof(scalar_t) * vec_size) aligned_vector {
+  scalar_t val[vec_size];
+};
+
+template <typename T>
+constexpr int max_element_size() {
+  return static_cast<int>(sizeof(T));
+}
+
+template <typename T, typename U, typename... Ts>
+constexpr int max_element_size() {
+  return max_element_size<T>() > max_element_size<U, Ts...>()
+      ? max_element_size<T>() : max_element_size<U, Ts...>();
+}
+
+template <typename traits, typename args_t = typename traits::ArgsTuple>
+struct vec_size_of;
+
+// The number of elements of every operand of a functor that fit in one
+// access, for its largest operand type.
+template <typename traits, typename... args_t>
+struct vec_size_of<traits, std::tuple<args_t...>> {
+  static constexpr int element_size = max_element_size<
+      typename traits::result_type, typename std::decay<args_t>::type...>();
+  static constexpr int value = max_access_bytes / element_size > max_vec_size
+      ? max_vec_size : max_access_bytes / element_size;
+};
+
+// The vectors a thread loads for the arguments of a functor.
+template <int vec_size, typename... args_t>
+struct vectors;
+
+template <int vec_size>
+struct vectors<vec_size> {
+  C10_DEVICE void load(char* const C10_RESTRICT data[], int vec_idx) {}
+};
+
+template <int vec_size, typename arg_t, typename... args_t>
+struct vectors<vec_size, arg_t, args_t...> {
+  aligned_vector<arg_t, vec_size> head;
+  vectors<vec_size, args_t...> tail;
+
+  C10_DEVICE void load(char* const C10_RESTRICT data[], int vec_idx) {
+    head = reinterpret_cast<const aligned_vector<arg_t, vec_size>*>(data[0])[vec_idx];
+    tail.load(data + 1, vec_idx);
+  }
+};
+
+template <int vec_size, typename args_t>
+struct vectors_of;
+
+template <int vec_size, typename... args_t>
+struct vectors_of<vec_size, std::tuple<args_t...>> {
+  using type = vectors<vec_size, typename std::decay<args_t>::type...>;
+};
+
+template <size_t i>
+struct vector_element {
+  template <typename scalar_t, typename vectors_t>
+  static C10_DEVICE scalar_t get(const vectors_t& v, int lane) {
+    return vector_element<i - 1>::template get<scalar_t>(v.tail, lane);
+  }
+};
+
+template <>
+struct vector_element<0> {
+  template <typename scalar_t, typename vectors_t>
+  static C10_DEVICE scalar_t get(const vectors_t& v, int lane) {
+    return v.head.val[lane];
+  }
+};
+
+template <typename traits, typename func_t, typename vectors_t, size_t... INDEX>
+C10_DEVICE typename traits::result_type
+apply_lane(const func_t& f, const vectors_t& args, int lane,
+           c10::guts::index_sequence<INDEX...>) {
+  return f(vector_element<INDEX>::template get<
+      typename std::decay<typename traits::template arg<INDEX>::type>::type>(args, lane)...);
+}
+
+template <typename traits, typename func_t, size_t... INDEX>
+C10_DEVICE typename traits::result_type
+apply_contiguous(const func_t& f, char* const C10_RESTRICT data[], int idx,
+                 c10::guts::index_sequence<INDEX...>) {
+  return f(reinterpret_cast<const typename std::decay<
+      typename traits::template arg<INDEX>::type>::type*>(data[INDEX])[idx]...);
+}
+
+template <typename traits, size_t... INDEX>
+std::array<int, sizeof...(INDEX) + 1> element_sizes(c10::guts::index_sequence<INDEX...>) {
+  return {{static_cast<int>(sizeof(typename traits::result_type)),
+           static_cast<int>(sizeof(typename std::decay<
+               typename traits::template arg<INDEX>::type>::type))...}};
+}
+
+// Returns whether the contiguous operands at `data`, the output first, can be
+// accessed `vec_size` elements at a time, i.e. they are all aligned to a
+// vector of their type.
+template <typename traits, typename array_t>
+bool can_vectorize(const array_t& data, int vec_size) {
+  using Indices = c10::guts::make_index_sequence<traits::arity>;
+  auto sizes = element_sizes<traits>(Indices{});
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (reinterpret_cast<uintptr_t>(data[i]) % (sizes[i] * vec_size) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns whether every operand, the output first, is contiguous.
+template <typename traits, typename array_t>
+bool is_contiguous(const array_t& strides) {
+  using Indices = c10::guts::make_index_sequence<traits::arity>;
+  auto sizes = element_sizes<traits>(Indices{});
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (strides[i] != sizes[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}}} // namespace at::native::memory
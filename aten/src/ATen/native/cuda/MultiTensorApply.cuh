@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <c10/cuda/CUDAGuard.h>
+
+#include <THC/THCGeneral.h>
+
+#include <vector>
+
+namespace at {
+namespace native {
+
+namespace {
+
+// multi_tensor_apply runs a pointwise functor over the tensors of several
+// tensor lists with one kernel launch per batch of tensors instead of one
+// per tensor. The tensors are cut into chunks of kChunkSize elements, every
+// block processes one chunk, and the addresses and sizes of the tensors of a
+// batch and the chunk of every block are passed as a kernel argument, which
+// is limited to 4kB. The number of tensors of a batch depends on the number
+// of lists, the depth.
+constexpr int64_t kChunkSize = 65536;
+constexpr int kBlockSize = 512;
+constexpr int kMaxBlocks = 320;
+constexpr int kDepthToMaxTensors[5] = {0, 110, 64, 48, 36};
+
+template <int depth>
+struct TensorListMetadata {
+  void* addresses[depth][kDepthToMaxTensors[depth]];
+  int64_t numel[kDepthToMaxTensors[depth]];
+  unsigned char block_to_tensor[kMaxBlocks];
+  int block_to_chunk[kMaxBlocks];
+};
+
+template <typename T, typename U, typename... ArgTypes>
+C10_LAUNCH_BOUNDS_1(kBlockSize)
+__global__ void multi_tensor_apply_kernel(T tensor_lists, U callable, ArgTypes... args) {
+  callable(tensor_lists, args...);
+}
+
+// Calls callable(metadata, args...) in a kernel for every batch of the
+// tensors of `tensor_lists`, which must be contiguous tensors of the same
+// device with the same sizes at the same position.
+template <int depth, typename T, typename... ArgTypes>
+void multi_tensor_apply(
+    std::vector<std::vector<Tensor>>& tensor_lists,
+    T callable,
+    ArgTypes... args) {
+  TORCH_CHECK(tensor_lists.size() == depth, "multi_tensor_apply: expected ", depth,
+              " tensor lists, but got ", tensor_lists.size());
+  const size_t n_tensors = tensor_lists[0].size();
+  const c10::cuda::CUDAGuard device_guard(tensor_lists[0][0].device());
+  auto stream = at::cuda::getCurrentCUDAStream();
+
+  TensorListMetadata<depth> tl;
+  int loc_block_info = 0;
+  int loc_tensor_info = 0;
+  for (size_t t = 0; t < n_tensors; t++) {
+    const int64_t numel = tensor_lists[0][t].numel();
+    if (numel == 0) {
+      continue;
+    }
+    tl.numel[loc_tensor_info] = numel;
+    for (int d = 0; d < depth; d++) {
+      tl.addresses[d][loc_tensor_info] = tensor_lists[d][t].data_ptr();
+    }
+    loc_tensor_info++;
+
+    const int64_t chunks = (numel + kChunkSize - 1) / kChunkSize;
+    for (int64_t chunk = 0; chunk < chunks; chunk++) {
+      tl.block_to_tensor[loc_block_info] = loc_tensor_info - 1;
+      tl.block_to_chunk[loc_block_info] = chunk;
+      loc_block_info++;
+
+      const bool tensors_full = loc_tensor_info == kDepthToMaxTensors[depth] && chunk == chunks - 1;
+      const bool blocks_full = loc_block_info == kMaxBlocks;
+      const bool last_chunk = t == n_tensors - 1 && chunk == chunks - 1;
+      if (tensors_full || blocks_full || last_chunk) {
+        multi_tensor_apply_kernel<<<loc_block_info, kBlockSize, 0, stream>>>(tl, callable, args...);
+        THCudaCheck(cudaGetLastError());
+
+        loc_block_info = 0;
+        if (chunk == chunks - 1) {
+          loc_tensor_info = 0;
+        } else {
+          // the next batch starts with the rest of this tensor
+          tl.numel[0] = tl.numel[loc_tensor_info - 1];
+          for (int d = 0; d < depth; d++) {
+            tl.addresses[d][0] = tl.addresses[d][loc_tensor_info - 1];
+          }
+          loc_tensor_info = 1;
+        }
+      }
+    }
+  }
+  if (loc_block_info > 0) {
+    // the last tensors are empty
+    multi_tensor_apply_kernel<<<loc_block_info, kBlockSize, 0, stream>>>(tl, callable, args...);
+    THCudaCheck(cudaGetLastError());
+  }
+}
+
+} // namespace
+} // namespace native
+} // namespace at
@@ -113,7 +113,7 @@ __device__ int binarySearchForMultinomial(scalar_t* cumdist,
 
 template <typename scalar_t>
 __global__ void
-sampleMultinomialWithReplacement(std::pair<uint64_t, uint64_t> seeds,
+sampleMultinomialWithReplacement(at::PhiloxCudaState philox_args,
                                  int totalSamples,
                                  int64_t* dest,
                                  int64_t distributions,
@@ -128,6 +128,7 @@ sampleMultinomialWithReplacement(std::pair<uint64_t, uint64_t> seeds,
   int idx = blockIdx.x * blockDim.x * blockDim.y + threadIdx.y * blockDim.x + threadIdx.x;
 
   curandStatePhilox4_32_10_t state;
+  auto seeds = at::cuda::philox::unpack(philox_args);
   curand_init(seeds.first, idx, seeds.second, &state);
 
   // The block determines the distribution for which we generate a point
@@ -160,7 +161,7 @@ sampleMultinomialWithReplacement(std::pair<uint64_t, uint64_t> seeds,
 
 template <typename scalar_t>
 __global__ void
-sampleMultinomialWithoutReplacement(std::pair<uint64_t, uint64_t> seeds,
+sampleMultinomialWithoutReplacement(at::PhiloxCudaState philox_args,
                                     int totalSamples,
                                     int sample,
                                     int64_t* dest,
@@ -176,6 +177,7 @@ sampleMultinomialWithoutReplacement(std::pair<uint64_t, uint64_t> seeds,
   int idx = blockIdx.x * blockDim.x * blockDim.y + threadIdx.y * blockDim.x + threadIdx.x;
 
   curandStatePhilox4_32_10_t state;
+  auto seeds = at::cuda::philox::unpack(philox_args);
   curand_init(seeds.first, idx, seeds.second, &state);
 
   // The block and warp determines the distribution for which we
@@ -412,7 +414,7 @@ void multinomial_kernel_impl(Tensor& result, const Tensor& self, const int64_t n
       // Prefix sum along rows
       legacy::cuda::_th_cumsum_out(prefixSum, normDist, 1);
 
-      std::pair<uint64_t, uint64_t> rng_engine_inputs;
+      at::PhiloxCudaState rng_engine_inputs;
 
       if (with_replacement) {
         {
@@ -422,7 +424,7 @@ void multinomial_kernel_impl(Tensor& result, const Tensor& self, const int64_t n
           // each thread will utilize one random, however, since we have to use
           // curand_uniform4 (See Note [Register spilling in curand call for CUDA < 10]),
           // offset is 4.
-          rng_engine_inputs = gen->philox_engine_inputs(4);
+          rng_engine_inputs = gen->philox_cuda_state(4);
         }
         // Sample with replacement
 
@@ -473,7 +475,7 @@ void multinomial_kernel_impl(Tensor& result, const Tensor& self, const int64_t n
             // each thread will utilize one random, however, since we have to use
             // curand_uniform4 (See Note [Register spilling in curand call for CUDA < 10]),
             // offset is 4.
-            rng_engine_inputs = gen->philox_engine_inputs(4);
+            rng_engine_inputs = gen->philox_cuda_state(4);
           }
 
           // The kernel can only draw one sample before we have to
@@ -23,6 +23,7 @@ std::ostream& operator<<(std::ostream& out, const ReduceConfig& config) {
   out << "step_input=" << config.step_input << ", ";
   out << "step_output=" << config.step_output << ", ";
   out << "ctas_per_output=" << config.ctas_per_output << ", ";
+  out << "vectorize_input=" << config.vectorize_input << ", ";
   out << "input_mult=[";
   for (int i = 0; i < 3; i++) {
     if (i != 0) {
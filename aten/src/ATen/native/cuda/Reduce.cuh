@@ -10,6 +10,7 @@
 #include <THC/THCGeneral.hpp>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/cuda/Loops.cuh>
+#include <ATen/native/cuda/MemoryAccess.cuh>
 #include <c10/macros/Macros.h>
 #include <functional>
 #include <iosfwd>
@@ -75,6 +76,9 @@ struct ReduceConfig {
   int ctas_per_output = 1;
   int input_mult[3] = {0, 0, 0};
   int output_mult[2] = {0, 0};
+  // Whether each thread loads `vt0` consecutive inputs at once, in which
+  // case the input is split in vectors rather than in elements.
+  bool vectorize_input = false;
 
   int block_width;
   int block_height;
@@ -369,6 +373,9 @@ struct ReduceOp {
   }
 
   C10_DEVICE arg_t thread_reduce(const scalar_t* data) const {
+    if (config.vectorize_input) {
+      return input_vectorized_thread_reduce(data);
+    }
     index_t idx = config.input_idx();
     // Multiple accumulators to remove dependency between unrolled loops.
     arg_t value_list[vt0];
@@ -408,6 +415,40 @@ struct ReduceOp {
     return value_list[0];
   }
 
+  // Reduces a contiguous slice starting at a multiple of vt0 elements, with
+  // one load per vt0 inputs. Only the thread reaching the end of the
+  // slice may have a partial vector left, which it reads element by element.
+  C10_DEVICE arg_t input_vectorized_thread_reduce(const scalar_t* data) const {
+    using load_t = memory::aligned_vector<scalar_t, vt0>;
+    arg_t value_list[vt0];
+    #pragma unroll
+    for (int i = 0; i < vt0; i++) {
+      value_list[i] = ident;
+    }
+    index_t end = config.num_inputs;
+    index_t idx = config.input_idx() * vt0;
+    index_t stride = config.step_input * vt0;
+    while (idx + vt0 <= end) {
+      load_t values = *reinterpret_cast<const load_t*>(data + idx);
+      #pragma unroll
+      for (int i = 0; i < vt0; i++) {
+        value_list[i] = ops.reduce(value_list[i], values.val[i], idx + i);
+      }
+      idx += stride;
+    }
+    #pragma unroll
+    for (int i = 0; i < vt0; i++) {
+      if (idx + i < end) {
+        value_list[i] = ops.reduce(value_list[i], data[idx + i], idx + i);
+      }
+    }
+    #pragma unroll
+    for (int i = 1; i < vt0; i++) {
+      value_list[0] = ops.combine(value_list[0], value_list[i]);
+    }
+    return value_list[0];
+  }
+
   C10_DEVICE arg_t block_x_reduce(arg_t value, char* shared_memory) const {
     int dim_x = blockDim.x;
     arg_t* shared = (arg_t*)shared_memory;
@@ -640,57 +681,41 @@ struct AccumulationBuffer {
   at::DataPtr buffer_;
 };
 
-template <typename scalar_t, typename out_scalar_t, int vt0=4, typename ops_t, typename ident_t=double>
-inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t ident=0,
-                              AccumulationBuffer* acc_buf_ptr=nullptr) {
-  AT_ASSERT(iter.numel() > 0 && iter.ntensors() - iter.noutputs() == 1 && iter.noutputs() >= 1);
-
-  using traits = function_traits<decltype(&ops_t::reduce)>;
-  using arg_t = typename traits::template arg<0>::type;
-  static constexpr bool can_accumulate_in_output =
-    std::is_convertible<arg_t, out_scalar_t>::value;
-
-  bool can_use_32bit_indexing = iter.can_use_32bit_indexing();
-  std::unique_ptr<AccumulationBuffer> owned_buf_ptr;
-
-  // The acc_buf_ptr is a shared pointer. It is create at the first entrance and
-  // reused by all recursive function calls.
-  if (acc_buf_ptr == NULL) {
-    // acc_buf_ptr holds buffer used for accumulation among multiple sub_iter
-    // when accumulation in output is not possible.
-    if (!can_accumulate_in_output && !can_use_32bit_indexing) {
-      int64_t output_memory_size = 1;
-      for (int dim = 0; dim < iter.ndim(); dim++) {
-        output_memory_size = std::max(output_memory_size, iter.shape()[dim] * iter.strides(0)[dim]);
-      }
-      owned_buf_ptr.reset(new AccumulationBuffer(sizeof(arg_t),
-                                                 sizeof(out_scalar_t),
-                                                 (char*) iter.data_ptr(0),
-                                                 output_memory_size * sizeof(arg_t)));
-    } else {
-      owned_buf_ptr.reset(new AccumulationBuffer());
-    }
-    acc_buf_ptr = owned_buf_ptr.get();
-  }
-
-  if (!can_use_32bit_indexing) {
-    for (auto& sub_iter : iter.with_32bit_indexing()) {
-      gpu_reduce_kernel<scalar_t, out_scalar_t, vt0>(sub_iter, ops, ident, acc_buf_ptr);
+// Minimum number of inputs each thread reduces when the input is split across
+// thread-blocks, below which the global combine costs more than it saves.
+static constexpr int kMinValuesPerThreadForGlobalReduce = 16;
+
+// Number of full waves of blocks the planner aims for when it splits inputs
+// across thread-blocks.
+static constexpr int kTargetWaves = 2;
+
+// Whether the reduced dimension of `iter` can be read with aligned vectors of
+// `vec_size` elements: it must be the only reduced dimension, contiguous, and
+// every slice must start at a multiple of the vector size. Vectors wider than
+// the widest load instruction, 16 bytes, are not used.
+template <typename scalar_t, int vec_size>
+static bool can_vectorize_reduce_input(const TensorIterator& iter) {
+  constexpr int vec_bytes = sizeof(scalar_t) * vec_size;
+  int input_index = iter.ntensors() - 1;
+  auto strides = iter.strides(input_index);
+  if (vec_size <= 1 || vec_bytes > 16 || iter.num_reduce_dims() != 1 ||
+      strides[0] != sizeof(scalar_t) || iter.shape()[0] < 2 * vec_size ||
+      reinterpret_cast<uintptr_t>(iter.data_ptr(input_index)) % vec_bytes != 0) {
+    return false;
+  }
+  for (int dim = 1; dim < iter.ndim(); dim++) {
+    if (strides[dim] % vec_bytes != 0) {
+      return false;
     }
-    return;
-  }
-
-  const char* in_data = (char*)iter.data_ptr(iter.ntensors() - 1);
-  char* out_data = (char*)iter.data_ptr(0);
-  const auto noutputs = iter.noutputs();
-  optional<char*> out_data_extra;
-  if (noutputs > 1) {
-    out_data_extra = (char*)iter.data_ptr(1);
-  } else {
-    out_data_extra = nullopt;
   }
-  char* acc_data = acc_buf_ptr->get_acc_slice(out_data);
+  return true;
+}
 
+// Picks the launch configuration of a reduction: how the inputs and outputs
+// are split across the lanes of a warp, the warps of a block, and the blocks
+// of the grid.
+template <typename arg_t, typename scalar_t, int vt0>
+ReduceConfig setReduceConfig(const TensorIterator& iter) {
   // Start by assuming that each thread handles a single output and all
   // the inputs for that output.
   int64_t num_outputs = iter.num_output_elements();
@@ -722,6 +747,13 @@ inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t id
     //   2. block.y now max out to num_outputs.
     dim0 = iter.shape()[0];
     dim1 = num_outputs;
+    // Lanes load vectors of vt0 inputs, so a short reduced dimension takes
+    // fewer lanes and leaves more warps for other outputs.
+    config.vectorize_input = iter.ndim() > 0 &&
+        can_vectorize_reduce_input<scalar_t, vt0>(iter);
+    if (config.vectorize_input) {
+      dim0 = div_up(dim0, vt0);
+    }
   } else {
     // Map block.x to the fastest non reducing dimension. It implies:
     //   1. block_x_reduce is turned off.
@@ -756,17 +788,84 @@ inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t id
     config.output_mult[1] = config.split_output(block_height);
   }
 
-  if (config.input_mult[1] != 0 && config.values_per_thread() >= 256 && num_outputs <= 4096) {
-    // Divide the input across thread-blocks if the amount of work per-thread
-    // is large enough and the size of the output is small enough. This will
-    // require a reduction using global memory.
-    config.ctas_per_output = div_up(config.values_per_thread(), 16);
-    if (config.ctas_per_output > 65535) {
-      config.ctas_per_output = 65535;
+  // Divide the input across thread-blocks if the outputs alone don't make
+  // enough blocks to fill the device and there is enough work per thread.
+  // The partial results are combined by the last block to finish, through
+  // global memory. Splitting into just enough blocks for a few waves, rather
+  // than into as many as the input allows, keeps that combine short for
+  // skinny shapes such as column sums over millions of rows.
+  const cudaDeviceProp* prop = at::cuda::getCurrentDeviceProperties();
+  const int blocks_per_sm =
+      std::max(1, prop->maxThreadsPerMultiProcessor / config.num_threads);
+  const int64_t target_grid_size =
+      int64_t(prop->multiProcessorCount) * blocks_per_sm * kTargetWaves;
+  const int64_t grid_width = config.grid().x;
+  if (config.input_mult[1] != 0 && grid_width < target_grid_size &&
+      config.values_per_thread() >= 2 * kMinValuesPerThreadForGlobalReduce) {
+    int64_t ctas_per_output = std::min(
+        div_up(target_grid_size, grid_width),
+        div_up(config.values_per_thread(), kMinValuesPerThreadForGlobalReduce));
+    config.ctas_per_output = static_cast<int>(std::min<int64_t>(ctas_per_output, 65535));
+    if (config.ctas_per_output > 1) {
+      config.input_mult[2] = config.split_input(config.ctas_per_output);
+    }
+  }
+  return config;
+}
+
+template <typename scalar_t, typename out_scalar_t, int vt0=4, typename ops_t, typename ident_t=double>
+inline void gpu_reduce_kernel(TensorIterator& iter, const ops_t& ops, ident_t ident=0,
+                              AccumulationBuffer* acc_buf_ptr=nullptr) {
+  AT_ASSERT(iter.numel() > 0 && iter.ntensors() - iter.noutputs() == 1 && iter.noutputs() >= 1);
+
+  using traits = function_traits<decltype(&ops_t::reduce)>;
+  using arg_t = typename traits::template arg<0>::type;
+  static constexpr bool can_accumulate_in_output =
+    std::is_convertible<arg_t, out_scalar_t>::value;
+
+  bool can_use_32bit_indexing = iter.can_use_32bit_indexing();
+  std::unique_ptr<AccumulationBuffer> owned_buf_ptr;
+
+  // The acc_buf_ptr is a shared pointer. It is create at the first entrance and
+  // reused by all recursive function calls.
+  if (acc_buf_ptr == NULL) {
+    // acc_buf_ptr holds buffer used for accumulation among multiple sub_iter
+    // when accumulation in output is not possible.
+    if (!can_accumulate_in_output && !can_use_32bit_indexing) {
+      int64_t output_memory_size = 1;
+      for (int dim = 0; dim < iter.ndim(); dim++) {
+        output_memory_size = std::max(output_memory_size, iter.shape()[dim] * iter.strides(0)[dim]);
+      }
+      owned_buf_ptr.reset(new AccumulationBuffer(sizeof(arg_t),
+                                                 sizeof(out_scalar_t),
+                                                 (char*) iter.data_ptr(0),
+                                                 output_memory_size * sizeof(arg_t)));
+    } else {
+      owned_buf_ptr.reset(new AccumulationBuffer());
+    }
+    acc_buf_ptr = owned_buf_ptr.get();
+  }
+
+  if (!can_use_32bit_indexing) {
+    for (auto& sub_iter : iter.with_32bit_indexing()) {
+      gpu_reduce_kernel<scalar_t, out_scalar_t, vt0>(sub_iter, ops, ident, acc_buf_ptr);
     }
-    config.input_mult[2] = config.split_input(config.ctas_per_output);
+    return;
   }
 
+  const char* in_data = (char*)iter.data_ptr(iter.ntensors() - 1);
+  char* out_data = (char*)iter.data_ptr(0);
+  const auto noutputs = iter.noutputs();
+  optional<char*> out_data_extra;
+  if (noutputs > 1) {
+    out_data_extra = (char*)iter.data_ptr(1);
+  } else {
+    out_data_extra = nullopt;
+  }
+  char* acc_data = acc_buf_ptr->get_acc_slice(out_data);
+
+  auto config = setReduceConfig<arg_t, scalar_t, vt0>(iter);
+
   at::DataPtr buffer;
   at::DataPtr semaphores;
   if (config.should_global_reduce()) {
@@ -3,6 +3,7 @@
 #include <ATen/Config.h>
 #include <ATen/cuda/CUDAConfig.h>
 #include <ATen/cuda/Exceptions.h>
+#include <ATen/native/cudnn/ConvAlgorithmCache.h>
 
 #if !AT_CUDNN_ENABLED()
 
@@ -71,12 +72,21 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
   AT_ERROR("cudnn_convolution_transpose_backward: ATen not compiled with cuDNN support");
 }
 
+int64_t cudnn_save_convolution_algorithms(const std::string& path) {
+  AT_ERROR("cudnn_save_convolution_algorithms: ATen not compiled with cuDNN support");
+}
+
+int64_t cudnn_load_convolution_algorithms(const std::string& path) {
+  AT_ERROR("cudnn_load_convolution_algorithms: ATen not compiled with cuDNN support");
+}
+
 }}
 
 #else  // AT_CUDNN_ENABLED
 
 #include <THC/THC.h>
 
+#include <ATen/cuda/CUDAContext.h>
 #include <ATen/cudnn/cudnn-wrapper.h>
 #include <ATen/cudnn/Descriptors.h>
 #include <ATen/cudnn/Types.h>
@@ -85,6 +95,7 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 
 #include <ATen/TensorUtils.h>
 
+#include <fstream>
 #include <functional>
 #include <iterator>
 #include <sstream>
@@ -93,6 +104,8 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> cudnn_convolution_transpose_backwar
 #include <mutex>
 #include <stdint.h>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 // Note [behavior of cudnnFind and cudnnGet]
 // You'll notice that by default, in the ConvolutionDescriptor, we do the following:
@@ -361,12 +374,167 @@ struct BenchmarkCache {
     std::lock_guard<std::mutex> guard(mutex);
     map[params] = results;
   }
+
+  // Unlike insert, keeps the results already there for the same params.
+  void insertIfAbsent(const ConvolutionParams& params, const T& results) {
+    std::lock_guard<std::mutex> guard(mutex);
+    map.emplace(params, results);
+  }
+
+  std::vector<std::pair<ConvolutionParams, T>> entries() {
+    std::lock_guard<std::mutex> guard(mutex);
+    return std::vector<std::pair<ConvolutionParams, T>>(map.begin(), map.end());
+  }
 };
 
 BenchmarkCache<cudnnConvolutionFwdAlgoPerf_t> fwd_algos;
 BenchmarkCache<cudnnConvolutionBwdDataAlgoPerf_t> bwd_data_algos;
 BenchmarkCache<cudnnConvolutionBwdFilterAlgoPerf_t> bwd_filter_algos;
 
+// ---------------------------------------------------------------------
+//
+// Persisting the benchmark caches
+//
+// ---------------------------------------------------------------------
+
+// The file starts with a header line
+//
+//     cudnn_convolution_algorithms <format> <cuDNN version> <device>
+//
+// followed by one line per cache entry, with the cache it belongs to, all
+// the fields of its ConvolutionParams and the algorithm found for them.
+
+constexpr const char* algorithm_cache_magic = "cudnn_convolution_algorithms";
+constexpr int algorithm_cache_format = 1;
+
+static std::string algorithmCacheDevice() {
+  auto* prop = at::cuda::getCurrentDeviceProperties();
+  std::ostringstream ss;
+  ss << "sm_" << prop->major << prop->minor << " " << prop->name;
+  return ss.str();
+}
+
+static void writeParams(std::ostream& os, const ConvolutionParams& params) {
+  os << static_cast<int>(params.dataType);
+  for (int v : params.input_size) os << ' ' << v;
+  for (int v : params.input_stride) os << ' ' << v;
+  for (int v : params.weight_size) os << ' ' << v;
+  for (int v : params.padding) os << ' ' << v;
+  for (int v : params.stride) os << ' ' << v;
+  for (int v : params.dilation) os << ' ' << v;
+  os << ' ' << params.groups << ' ' << params.deterministic;
+}
+
+static void readParams(std::istream& is, ConvolutionParams* params) {
+  // Zero the padding bytes as well, since ParamsHash and ParamsEqual look at
+  // the raw bytes.
+  memset(params, 0, sizeof(ConvolutionParams));
+  int dataType = 0;
+  is >> dataType;
+  params->dataType = static_cast<cudnnDataType_t>(dataType);
+  for (int& v : params->input_size) is >> v;
+  for (int& v : params->input_stride) is >> v;
+  for (int& v : params->weight_size) is >> v;
+  for (int& v : params->padding) is >> v;
+  for (int& v : params->stride) is >> v;
+  for (int& v : params->dilation) is >> v;
+  is >> params->groups >> params->deterministic;
+}
+
+template <typename perf_t>
+static int64_t saveAlgorithms(std::ostream& os, const char* kind, BenchmarkCache<perf_t>& cache) {
+  auto entries = cache.entries();
+  for (const auto& entry : entries) {
+    const perf_t& perf = entry.second;
+    os << kind << ' ';
+    writeParams(os, entry.first);
+    os << ' ' << static_cast<int>(perf.algo)
+       << ' ' << static_cast<int>(perf.mathType)
+       << ' ' << perf.memory
+       << ' ' << static_cast<int>(perf.determinism)
+       << ' ' << perf.time << '\n';
+  }
+  return entries.size();
+}
+
+template <typename perf_t>
+static void loadAlgorithm(std::istream& is, BenchmarkCache<perf_t>& cache) {
+  using algo_t = decltype(perf_t::algo);
+  ConvolutionParams params;
+  readParams(is, &params);
+  perf_t perf;
+  memset(&perf, 0, sizeof(perf_t));
+  int algo = 0, mathType = 0, determinism = 0;
+  is >> algo >> mathType >> perf.memory >> determinism >> perf.time;
+  if (!is.fail()) {
+    perf.algo = static_cast<algo_t>(algo);
+    perf.mathType = static_cast<cudnnMathType_t>(mathType);
+    perf.determinism = static_cast<cudnnDeterminism_t>(determinism);
+    perf.status = CUDNN_STATUS_SUCCESS;
+    cache.insertIfAbsent(params, perf);
+  }
+}
+
+int64_t cudnn_save_convolution_algorithms(const std::string& path) {
+  std::ofstream os(path);
+  TORCH_CHECK(os, "cudnn_save_convolution_algorithms: could not open ", path);
+  os << algorithm_cache_magic << ' ' << algorithm_cache_format << ' '
+     << cudnnGetVersion() << ' ' << algorithmCacheDevice() << '\n';
+  int64_t count = saveAlgorithms(os, "fwd", fwd_algos);
+  count += saveAlgorithms(os, "bwd_data", bwd_data_algos);
+  count += saveAlgorithms(os, "bwd_filter", bwd_filter_algos);
+  os.close();
+  TORCH_CHECK(os, "cudnn_save_convolution_algorithms: failed writing ", path);
+  return count;
+}
+
+int64_t cudnn_load_convolution_algorithms(const std::string& path) {
+  std::ifstream is(path);
+  TORCH_CHECK(is, "cudnn_load_convolution_algorithms: could not open ", path);
+
+  std::string line;
+  std::getline(is, line);
+  std::istringstream header(line);
+  std::string magic, device;
+  int format = 0;
+  size_t version = 0;
+  header >> magic >> format >> version;
+  std::getline(header >> std::ws, device);
+  TORCH_CHECK(magic == algorithm_cache_magic && format == algorithm_cache_format,
+              "cudnn_load_convolution_algorithms: ", path,
+              " is not a cuDNN convolution algorithm file");
+  if (version != cudnnGetVersion() || device != algorithmCacheDevice()) {
+    TORCH_WARN("cudnn_load_convolution_algorithms: ignoring ", path,
+               ", which was written for cuDNN ", version, " on ", device,
+               ", but this is cuDNN ", cudnnGetVersion(), " on ",
+               algorithmCacheDevice());
+    return 0;
+  }
+
+  int64_t count = 0;
+  while (std::getline(is, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream entry(line);
+    std::string kind;
+    entry >> kind;
+    if (kind == "fwd") {
+      loadAlgorithm(entry, fwd_algos);
+    } else if (kind == "bwd_data") {
+      loadAlgorithm(entry, bwd_data_algos);
+    } else if (kind == "bwd_filter") {
+      loadAlgorithm(entry, bwd_filter_algos);
+    } else {
+      entry.setstate(std::ios::failbit);
+    }
+    TORCH_CHECK(!entry.fail(), "cudnn_load_convolution_algorithms: malformed entry in ",
+                path, ": ", line);
+    count++;
+  }
+  return count;
+}
+
 // TODO: Stop manually allocating CUDA memory; allocate an ATen byte
 // tensor instead.
 struct Workspace {
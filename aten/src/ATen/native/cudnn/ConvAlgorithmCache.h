@@ -0,0 +1,31 @@
+#pragma once
+
+#include <c10/macros/Export.h>
+
+#include <cstdint>
+#include <string>
+
+namespace at { namespace native {
+
+// The convolution algorithms picked by cudnnFind when benchmarking
+// (torch.backends.cudnn.benchmark = True) are kept in memory, so every new
+// process benchmarks all of its convolution shapes again. These functions let
+// a process export them after warming up, and later processes load them at
+// startup. Convolutions whose parameters aren't in the loaded file still go
+// through cudnnFind.
+//
+// The file records the cuDNN version and the name and compute capability of
+// the current device, since the best algorithm depends on both; a file written
+// for a different one is ignored with a warning.
+
+// Writes all the algorithms benchmarked (or loaded) so far to `path`, and
+// returns how many there were.
+CAFFE2_API int64_t cudnn_save_convolution_algorithms(const std::string& path);
+
+// Adds the algorithms in the file at `path` to the ones benchmarked so far,
+// where those don't already have one for the same parameters, and returns how
+// many entries the file had (0 if it was written for another cuDNN version or
+// device).
+CAFFE2_API int64_t cudnn_load_convolution_algorithms(const std::string& path);
+
+}} // namespace at::native
@@ -15,6 +15,22 @@ Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
   AT_ERROR("fft: ATen not compiled with MKL support");
 }
 
+int64_t _mkl_fft_get_plan_cache_size() {
+  AT_ERROR("_mkl_fft_get_plan_cache_size: ATen not compiled with MKL support");
+}
+
+int64_t _mkl_fft_get_plan_cache_max_size() {
+  AT_ERROR("_mkl_fft_get_plan_cache_max_size: ATen not compiled with MKL support");
+}
+
+void _mkl_fft_set_plan_cache_max_size(int64_t max_size) {
+  AT_ERROR("_mkl_fft_set_plan_cache_max_size: ATen not compiled with MKL support");
+}
+
+void _mkl_fft_clear_plan_cache() {
+  AT_ERROR("_mkl_fft_clear_plan_cache: ATen not compiled with MKL support");
+}
+
 }}
 
 #else // AT_MKL_ENABLED
@@ -25,11 +41,17 @@ Tensor _fft_mkl(const Tensor& input, int64_t signal_ndim,
 #include <ATen/NativeFunctions.h>
 #include <ATen/Parallel.h>
 #include <ATen/Utils.h>
+#include <ATen/native/utils/ParamsHash.h>
 
 #include <algorithm>
 #include <vector>
 #include <numeric>
 #include <cmath>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <mkl_dfti.h>
 #include <ATen/mkl/Exceptions.h>
@@ -144,13 +166,169 @@ static inline void _fft_fill_with_conjugate_symmetry_(Tensor& input,
   });
 }
 
-// MKL DFTI
-Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
+// Committing a DFTI descriptor precomputes the twiddle factors and picks the
+// kernels, which can cost more than the transform itself for small signals.
+// Committed descriptors are kept in a process-wide LRU cache, keyed like the
+// cuFFT plans (see native/cuda/CuFFTPlanCache.h) by the geometry and the
+// configuration of the transform.
+namespace {
+
+constexpr int kMaxSignalNdim = 3;
+constexpr size_t kMklFFTDefaultCacheSize = 4096;
+
+// This POD struct is used to let us easily compute hashes of the parameters.
+// It is the **key** to the descriptor cache.
+struct MklFFTParams {
+  ScalarType scalar_type_;
+  int64_t input_sizes_[kMaxSignalNdim + 2];
+  int64_t input_strides_[kMaxSignalNdim + 2];
+  int64_t output_sizes_[kMaxSignalNdim + 2];
+  uint8_t signal_ndim_;
+  bool complex_input_;
+  bool complex_output_;
+  bool inverse_;
+  bool normalized_;
+  int64_t signal_sizes_[kMaxSignalNdim];
+};
+
+// NB: This can't be a constructor, because then MklFFTParams would not be a
+// POD anymore.
+void setMklFFTParams(MklFFTParams* params, const Tensor& input,
+    int64_t signal_ndim, bool complex_input, bool complex_output, bool inverse,
+    IntArrayRef checked_signal_sizes, bool normalized, IntArrayRef output_sizes) {
+  memset(params, 0, sizeof(MklFFTParams));
+  params->scalar_type_ = input.scalar_type();
+  for (int64_t i = 0; i != input.dim(); ++i) {
+    params->input_sizes_[i] = input.size(i);
+    params->input_strides_[i] = input.stride(i);
+  }
+  for (size_t i = 0; i != output_sizes.size(); ++i) {
+    params->output_sizes_[i] = output_sizes[i];
+  }
+  params->signal_ndim_ = static_cast<uint8_t>(signal_ndim);
+  params->complex_input_ = complex_input;
+  params->complex_output_ = complex_output;
+  params->inverse_ = inverse;
+  params->normalized_ = normalized;
+  for (size_t i = 0; i != checked_signal_sizes.size(); ++i) {
+    params->signal_sizes_[i] = checked_signal_sizes[i];
+  }
+}
+
+// A thread-safe LRU cache of committed descriptors. Descriptors are handed out
+// as shared pointers and used without holding the lock: a committed
+// descriptor can compute transforms from several threads at once, and one
+// that is evicted while in use is freed by its last user.
+class MklFFTPlanCache {
+public:
+  using descriptor_t = std::shared_ptr<DftiDescriptor>;
+
+  // Returns the cached descriptor for params, or the one created by
+  // make_descriptor() if there is none. The descriptor is created without
+  // holding the lock, so that a miss doesn't block the other threads.
+  template <typename F>
+  descriptor_t get_or_create(const MklFFTParams& params, F make_descriptor) {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = cache_map_.find(params);
+      if (it != cache_map_.end()) {
+        usage_list_.splice(usage_list_.begin(), usage_list_, it->second);
+        return it->second->second;
+      }
+    }
+    descriptor_t descriptor = make_descriptor();
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (max_size_ == 0) {
+      return descriptor;
+    }
+    auto it = cache_map_.find(params);
+    if (it != cache_map_.end()) {
+      // another thread created it meanwhile
+      usage_list_.splice(usage_list_.begin(), usage_list_, it->second);
+      return it->second->second;
+    }
+    if (usage_list_.size() >= max_size_) {
+      cache_map_.erase(usage_list_.back().first);
+      usage_list_.pop_back();
+    }
+    usage_list_.emplace_front(params, descriptor);
+    cache_map_.emplace(params, usage_list_.begin());
+    return descriptor;
+  }
+
+  void clear() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    cache_map_.clear();
+    usage_list_.clear();
+  }
+
+  void resize(int64_t new_size) {
+    TORCH_CHECK(new_size >= 0,
+             "MKL FFT plan cache size must be non-negative, but got ", new_size);
+    std::lock_guard<std::mutex> guard(mutex_);
+    max_size_ = static_cast<size_t>(new_size);
+    while (usage_list_.size() > max_size_) {
+      cache_map_.erase(usage_list_.back().first);
+      usage_list_.pop_back();
+    }
+  }
+
+  int64_t size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return cache_map_.size();
+  }
+
+  int64_t max_size() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    return max_size_;
+  }
+
+private:
+  using kv_t = std::pair<MklFFTParams, descriptor_t>;
+
+  std::mutex mutex_;
+  std::list<kv_t> usage_list_;
+  std::unordered_map<MklFFTParams,
+                     std::list<kv_t>::iterator,
+                     ParamsHash<MklFFTParams>,
+                     ParamsEqual<MklFFTParams>> cache_map_;
+  size_t max_size_ = kMklFFTDefaultCacheSize;
+};
+
+MklFFTPlanCache& mkl_fft_plan_cache() {
+  static MklFFTPlanCache cache;
+  return cache;
+}
+
+} // namespace
+
+int64_t _mkl_fft_get_plan_cache_size() {
+  return mkl_fft_plan_cache().size();
+}
+
+int64_t _mkl_fft_get_plan_cache_max_size() {
+  return mkl_fft_plan_cache().max_size();
+}
+
+void _mkl_fft_set_plan_cache_max_size(int64_t max_size) {
+  mkl_fft_plan_cache().resize(max_size);
+}
+
+void _mkl_fft_clear_plan_cache() {
+  mkl_fft_plan_cache().clear();
+}
+
+// Creates and commits the descriptor of a transform from input to output.
+static std::shared_ptr<DftiDescriptor> _fft_mkl_descriptor(
+    const Tensor& input, const Tensor& output, int64_t signal_ndim,
+    bool complex_input, bool complex_output, bool inverse,
+    IntArrayRef checked_signal_sizes, bool normalized) {
+  int64_t batch = input.size(0);
+const Tensor& self, int64_t signal_ndim,
                 bool complex_input, bool complex_output,
                 bool inverse, IntArrayRef checked_signal_sizes,
                 bool normalized, bool onesided,
                 IntArrayRef output_sizes) {
-  int64_t batch = self.size(0);
   Tensor input = self;
   // real/imag dimension must aligned when viewed as of complex type
   if (complex_input) {
@@ -194,75 +372,19 @@ Tensor _fft_mkl(const Tensor& self, int64_t signal_ndim,
   }
   Tensor output = at::empty(output_sizes, input.options());
 
-  // precision
-  DFTI_CONFIG_VALUE prec;
-  if (input.scalar_type() == ScalarType::Float) {
-    prec = DFTI_SINGLE;
-  } else if (input.scalar_type() == ScalarType::Double) {
-    prec = DFTI_DOUBLE;
-  } else {
-    std::ostringstream ss;
-    ss << "MKL FFT doesn't support tensor of type: "
-       << toString(input.scalar_type());
-    AT_ERROR(ss.str());
-  }
-  // signal type
-  DFTI_CONFIG_VALUE signal_type;
-  if (!inverse) {
-    signal_type = complex_input ? DFTI_COMPLEX : DFTI_REAL;
-  } else {
-    signal_type = complex_output ? DFTI_COMPLEX : DFTI_REAL;
-  }
-  // create descriptor with signal size
-  std::vector<MKL_LONG> mkl_signal_sizes(checked_signal_sizes.begin(), checked_signal_sizes.end());
-  DftiDescriptor descriptor;
-  descriptor.init(prec, signal_type, signal_ndim, mkl_signal_sizes.data());
-  // out of place FFT
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_PLACEMENT, DFTI_NOT_INPLACE));
-  // batch mode
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_NUMBER_OF_TRANSFORMS, batch));
-
-  auto istrides = input.strides();
-  auto ostrides = output.strides();
-  // batch dim stride, i.e., dist between each data
-  MKL_LONG idist = complex_input ? istrides[0] >> 1 : istrides[0];
-  MKL_LONG odist = complex_output ? ostrides[0] >> 1 : ostrides[0];
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_DISTANCE, idist));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_DISTANCE, odist));
-  // signal strides
-  // first val is offset, set to zero (ignored)
-  std::vector<MKL_LONG> mkl_istrides(1 + signal_ndim, 0), mkl_ostrides(1 + signal_ndim, 0);
-  for (int64_t i = 1; i <= signal_ndim; i++) {
-    mkl_istrides[i] = complex_input ? istrides[i] >> 1 : istrides[i];
-    mkl_ostrides[i] = complex_output ? ostrides[i] >> 1 : ostrides[i];
-  }
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_INPUT_STRIDES, mkl_istrides.data()));
-  MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_OUTPUT_STRIDES, mkl_ostrides.data()));
-  // if conjugate domain of real is involved, set standard CCE storage type
-  // this will become default in MKL in future
-  if (!complex_input || !complex_output) {
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(), DFTI_CONJUGATE_EVEN_STORAGE, DFTI_COMPLEX_COMPLEX));
-  }
-  // rescale if needed by normalized flag or inverse transform
-  if (normalized || inverse) {
-    auto signal_numel = at::prod_intlist(checked_signal_sizes);
-    double double_scale;
-    if (normalized) {
-      double_scale = 1.0 / std::sqrt(static_cast<double>(signal_numel));
-    } else {
-      double_scale = 1.0 / static_cast<double>(signal_numel);
-    }
-    MKL_DFTI_CHECK(DftiSetValue(descriptor.get(),
-      inverse ? DFTI_BACKWARD_SCALE : DFTI_FORWARD_SCALE,
-      prec == DFTI_DOUBLE ? double_scale : static_cast<float>(double_scale)));
-  }
-  // finalize
-  MKL_DFTI_CHECK(DftiCommitDescriptor(descriptor.get()));
+  MklFFTParams params;
+  setMklFFTParams(&params, input, signal_ndim, complex_input, complex_output,
+                  inverse, checked_signal_sizes, normalized, output_sizes);
+  auto descriptor = mkl_fft_plan_cache().get_or_create(params, [&]() {
+    return _fft_mkl_descriptor(input, output, signal_ndim, complex_input,
+                               complex_output, inverse, checked_signal_sizes,
+                               normalized);
+  });
   // run
   if (!inverse) {
-    MKL_DFTI_CHECK(DftiComputeForward(descriptor.get(), input.data_ptr(), output.data_ptr()));
+    MKL_DFTI_CHECK(DftiComputeForward(descriptor->get(), input.data_ptr(), output.data_ptr()));
   } else {
-    MKL_DFTI_CHECK(DftiComputeBackward(descriptor.get(), input.data_ptr(), output.data_ptr()));
+    MKL_DFTI_CHECK(DftiComputeBackward(descriptor->get(), input.data_ptr(), output.data_ptr()));
   }
   // now if needed, fill out the other half using Hermitian symmetry dim
   if (!complex_input && complex_output && !onesided) {
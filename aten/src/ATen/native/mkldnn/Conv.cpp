@@ -12,6 +12,13 @@ at::Tensor mkldnn_convolution(
   AT_ERROR("mkldnn_convolution_forward: ATen not compiled with MKLDNN support");
 }
 
+at::Tensor mkldnn_convolution_fused(
+    const at::Tensor& input, const at::Tensor& weight, const at::Tensor& bias,
+    IntArrayRef padding, IntArrayRef stride, IntArrayRef dilation, int64_t groups,
+    const at::Tensor& other, bool fuse_relu) {
+  AT_ERROR("mkldnn_convolution_fused: ATen not compiled with MKLDNN support");
+}
+
 at::Tensor mkldnn_convolution_backward_input(
     IntArrayRef input_size, const at::Tensor& grad_output, const at::Tensor& weight,
     IntArrayRef padding, IntArrayRef stride, IntArrayRef dilation, int64_t groups, bool bias_defined) {
@@ -34,6 +41,7 @@ std::tuple<at::Tensor,at::Tensor,at::Tensor> mkldnn_convolution_backward(
 
 #else // AT_MKLDNN_EBABLED
 
+#include <ATen/core/grad_mode.h>
 #include <ATen/mkldnn/Runtime.h>
 #include <ATen/native/mkldnn/MKLDNNCommon.h>
 #include <ATen/native/mkldnn/Utils.h>
@@ -53,6 +61,44 @@ inline ideep::tensor get_mkldnn_tensor(const at::Tensor& tensor) {
     return at::native::itensor_view_from_dense(tensor);
   }
 }
+
+// The weight of a convolution in the format MKL-DNN prefers, which is
+// cached across calls in inference. Weights already reordered by
+// mkldnn_reorder_conv2d_weight are used as they are.
+ideep::tensor get_mkldnn_conv2d_weight(
+    const at::Tensor& weight,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    int64_t groups) {
+  const ideep::tensor w = get_mkldnn_tensor(weight);
+  if (at::GradMode::is_enabled() || !w.is_public_format()) {
+    return w;
+  }
+  std::vector<int64_t> key;
+  for (const auto& param : {padding, stride, dilation}) {
+    key.insert(key.end(), param.begin(), param.end());
+  }
+  key.push_back(groups);
+  return at::native::get_packed_weight(weight, key, [&]() {
+    ideep::tensor grouped = w.as_weights();
+    grouped.make_group(groups);
+    const ideep::tensor::descriptor desc =
+        ideep::convolution_forward::expected_weights_descriptor(
+            grouped.get_dims(),
+            grouped.get_data_type(),
+            {stride.begin(), stride.end()},
+            {padding.begin(), padding.end()},
+            {padding.begin(), padding.end()},
+            {dilation.begin(), dilation.end()},
+            groups,
+            ideep::algorithm::convolution_direct);
+    ideep::tensor packed;
+    packed.init<at::native::AllocForMKLDNN>(desc);
+    packed.feed_from(grouped);
+    return packed;
+  });
+}
 }
 
 namespace at { namespace native {
@@ -64,7 +110,11 @@ ideep::tensor _mkldnn_conv2d(
     at::IntArrayRef padding,
     at::IntArrayRef stride,
     at::IntArrayRef dilation,
-    int64_t groups) {
+    int64_t groups,
+    const ideep::descriptor_group::attr_t& attr =
+        ideep::descriptor_group::attr_t{},
+    ideep::tensor y = ideep::tensor{}) {
+  // With a sum post-op, `y` holds the tensor the output is added to.
   std::vector<int64_t> kernel_size(x.ndims());
   // mkldnn conv2d weights could have been re-ordered to 5d by
   // mkldnn_reorder_conv2d_weight
@@ -84,7 +134,6 @@ ideep::tensor _mkldnn_conv2d(
   std::vector<int64_t> output_sizes =
       conv_output_size(input_size, kernel_size, padding, stride, dilation);
 
-  ideep::tensor y;
   if (b.has_value()) {
     ideep::convolution_forward::compute<AllocForMKLDNN>(
         x,
@@ -97,7 +146,7 @@ ideep::tensor _mkldnn_conv2d(
         {padding.begin(), padding.end()},
         {padding.begin(), padding.end()},
         groups,
-        ideep::descriptor_group::attr_t{},
+        attr,
         ideep::algorithm::convolution_direct,
         ideep::prop_kind::forward);
   } else {
@@ -111,7 +160,7 @@ ideep::tensor _mkldnn_conv2d(
       {padding.begin(), padding.end()},
       {padding.begin(), padding.end()},
       groups,
-      ideep::descriptor_group::attr_t{},
+      attr,
       ideep::algorithm::convolution_direct,
       ideep::prop_kind::forward);
   }
@@ -127,7 +176,8 @@ at::Tensor mkldnn_convolution(
     IntArrayRef dilation,
     int64_t groups) {
   const ideep::tensor mkldnn_input = get_mkldnn_tensor(input);
-  const ideep::tensor mkldnn_weight = get_mkldnn_tensor(weight);
+  const ideep::tensor mkldnn_weight =
+      get_mkldnn_conv2d_weight(weight, padding, stride, dilation, groups);
   c10::optional<ideep::tensor> mkldnn_bias{c10::nullopt};
   if (bias.defined()) {
     mkldnn_bias = get_mkldnn_tensor(bias);
@@ -150,6 +200,57 @@ at::Tensor mkldnn_convolution(
   }
 }
 
+at::Tensor mkldnn_convolution_fused(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    IntArrayRef padding,
+    IntArrayRef stride,
+    IntArrayRef dilation,
+    int64_t groups,
+    const at::Tensor& other,
+    bool fuse_relu) {
+  const ideep::tensor mkldnn_input = get_mkldnn_tensor(input);
+  const ideep::tensor mkldnn_weight =
+      get_mkldnn_conv2d_weight(weight, padding, stride, dilation, groups);
+  c10::optional<ideep::tensor> mkldnn_bias{c10::nullopt};
+  if (bias.defined()) {
+    mkldnn_bias = get_mkldnn_tensor(bias);
+  }
+
+  // The sum post-op accumulates into the output, so it starts as a copy of
+  // `other`.
+  using attr_t = ideep::descriptor_group::attr_t;
+  attr_t attr;
+  ideep::tensor mkldnn_output;
+  if (other.defined()) {
+    const ideep::tensor mkldnn_other = get_mkldnn_tensor(other);
+    mkldnn_output.init<AllocForMKLDNN>(mkldnn_other.get_descriptor());
+    mkldnn_output.feed_from(mkldnn_other);
+    attr = fuse_relu ? attr_t::residual() : attr_t::fuse_sum();
+  } else if (fuse_relu) {
+    attr = attr_t::fuse_relu();
+  }
+
+  mkldnn_output = _mkldnn_conv2d(
+      mkldnn_input,
+      mkldnn_weight,
+      mkldnn_bias,
+      padding,
+      stride,
+      dilation,
+      groups,
+      attr,
+      std::move(mkldnn_output));
+
+  if (input.is_mkldnn()) {
+    return new_with_itensor_mkldnn(std::move(mkldnn_output), input.options());
+  } else {
+    return mkldnn_to_dense(
+        new_with_itensor_mkldnn(std::move(mkldnn_output), input.options()));
+  }
+}
+
 Tensor mkldnn_convolution_backward_input(
     IntArrayRef input_size, const at::Tensor& grad_output, const at::Tensor& weight,
     IntArrayRef padding, IntArrayRef stride, IntArrayRef dilation, int64_t groups, bool bias_defined)
@@ -19,11 +19,29 @@ Tensor mkldnn_linear(
 
 #else // AT_MKLDNN_EBABLED
 
+#include <ATen/core/grad_mode.h>
 #include <ATen/native/mkldnn/MKLDNNCommon.h>
 
 namespace at {
 namespace native {
 
+namespace {
+
+// The weight of mkldnn_linear in the format MKL-DNN prefers, which is cached
+// across calls in inference. Weights already reordered by
+// mkldnn_reorder_linear_weight are used as they are.
+ideep::tensor get_mkldnn_linear_weight(const Tensor& weight) {
+  const ideep::tensor& w = itensor_from_mkldnn(weight);
+  if (GradMode::is_enabled() || !w.is_public_format()) {
+    return w;
+  }
+  return get_packed_weight(weight, {}, [&]() {
+    return itensor_from_mkldnn(mkldnn_reorder_linear_weight(weight));
+  });
+}
+
+} // namespace
+
 Tensor mkldnn_linear(
     const Tensor& self,
     const Tensor& weight,
@@ -38,7 +56,7 @@ Tensor mkldnn_linear(
   // reshape first if input dim is greater than 2 and the reshape will cost a memory copy.
   auto self_reshaped = self.dim() > 2 ? self.reshape({-1, self.size(self.dim() - 1)}) : self;
   const ideep::tensor x = itensor_from_mkldnn(self_reshaped);
-  const ideep::tensor w = itensor_from_mkldnn(weight);
+  const ideep::tensor w = get_mkldnn_linear_weight(weight);
 
   ideep::tensor y;
   if (bias.defined()) {
@@ -1,11 +1,15 @@
 #include <ATen/native/mkldnn/MKLDNNCommon.h>
 #include <ATen/OpaqueTensorImpl.h>
+#include <ATen/core/grad_mode.h>
 #include <c10/core/Allocator.h>
 
 #if AT_MKLDNN_ENABLED()
 
 #include <ideep.hpp>
 
+#include <list>
+#include <mutex>
+
 namespace at { namespace native {
 
 /**
@@ -75,6 +79,64 @@ ideep::tensor itensor_view_from_dense(const Tensor& tensor) {
            ideep::tensor::data_type::f32},
           tensor.template data_ptr<float>()};
 }
+
+namespace {
+
+struct PackedWeight {
+  // Keeps the TensorImpl from being reused by another weight while the entry
+  // exists, so entries can be matched by address.
+  c10::weak_intrusive_ptr<TensorImpl, UndefinedTensorImpl> weight;
+  uint32_t version;
+  std::vector<int64_t> key;
+  ideep::tensor packed;
+};
+
+// The most recently used packed weights first.
+constexpr size_t kMaxPackedWeights = 256;
+std::mutex packed_weights_mutex;
+std::list<PackedWeight> packed_weights;
+
+} // namespace
+
+ideep::tensor get_packed_weight(
+    const Tensor& weight,
+    std::vector<int64_t> key,
+    const std::function<ideep::tensor()>& pack) {
+  if (GradMode::is_enabled()) {
+    // The weights change every step in training.
+    return pack();
+  }
+  TensorImpl* impl = weight.unsafeGetTensorImpl();
+  const uint32_t version = impl->version_counter().current_version();
+  key.insert(key.end(), weight.sizes().begin(), weight.sizes().end());
+  {
+    std::lock_guard<std::mutex> guard(packed_weights_mutex);
+    for (auto it = packed_weights.begin(); it != packed_weights.end();) {
+      if (it->weight.expired() ||
+          (it->weight._unsafe_get_target() == impl && it->version != version)) {
+        it = packed_weights.erase(it);
+      } else if (it->weight._unsafe_get_target() == impl && it->key == key) {
+        packed_weights.splice(packed_weights.begin(), packed_weights, it);
+        return it->packed;
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  ideep::tensor packed = pack();
+  std::lock_guard<std::mutex> guard(packed_weights_mutex);
+  packed_weights.push_front(PackedWeight{
+      c10::weak_intrusive_ptr<TensorImpl, UndefinedTensorImpl>(
+          weight.getIntrusivePtr()),
+      version,
+      std::move(key),
+      packed});
+  if (packed_weights.size() > kMaxPackedWeights) {
+    packed_weights.pop_back();
+  }
+  return packed;
+}
 }}
 
 #endif // AT_MKLDNN_ENABLED()
@@ -6,6 +6,9 @@
 #if AT_MKLDNN_ENABLED()
 #include <ideep.hpp>
 
+#include <functional>
+#include <vector>
+
 namespace at { namespace native {
 
 // Custom allocator using c10 CPU allocator for `ideep::tensor`
@@ -30,6 +33,15 @@ ideep::tensor& itensor_from_mkldnn(const Tensor& mkldnn_tensor);
 // Construct an `ideep::tensor` "view" from dense tensor, note the
 // ideep::tensor will share the underlying buffer
 ideep::tensor itensor_view_from_dense(const Tensor& tensor);
+
+// Returns `pack()`, the weight `weight` reordered into the format MKL-DNN
+// prefers for an op with the arguments `key`. With grad mode disabled the
+// result is cached until the weight is modified in place or freed, so that
+// repeated inference reorders the weight only once.
+ideep::tensor get_packed_weight(
+    const Tensor& weight,
+    std::vector<int64_t> key,
+    const std::function<ideep::tensor()>& pack);
 }}
 
 #endif // AT_MKLDNN_ENABLED
@@ -74,6 +74,19 @@ Tensor mkldnn_reorder_conv2d_weight(
   return new_with_itensor_mkldnn(std::move(result), self.options());
 }
 
+// Like mkldnn_reorder_conv2d_weight, for the weight of mkldnn_linear.
+Tensor mkldnn_reorder_linear_weight(const Tensor& self) {
+  ideep::tensor w = itensor_from_mkldnn(self).as_weights();
+  ideep::tensor::descriptor desc =
+      ideep::inner_product_forward::expected_weights_descriptor(
+          w.get_dims(), w.get_data_type());
+  ideep::tensor result;
+  result.init<AllocForMKLDNN>(desc);
+  result.feed_from(w);
+
+  return new_with_itensor_mkldnn(std::move(result), self.options());
+}
+
 #else
 
 Tensor mkldnn_to_dense(const Tensor& mkldnn_tensor) {
@@ -93,6 +106,10 @@ Tensor mkldnn_reorder_conv2d_weight(
   AT_ERROR("mkldnn_reorder_conv2d_weight: MKL-DNN build is disabled");
 }
 
+Tensor mkldnn_reorder_linear_weight(const Tensor& self) {
+  AT_ERROR("mkldnn_reorder_linear_weight: MKL-DNN build is disabled");
+}
+
 #endif // AT_MKLDNN_ENABLED()
 
 }}
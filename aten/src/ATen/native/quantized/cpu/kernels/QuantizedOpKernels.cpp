@@ -1,5 +1,6 @@
 #include <ATen/ATen.h>
 #include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
 #include <ATen/native/TensorIterator.h>
 #include <ATen/native/UpSample.h>
 #include <ATen/native/cpu/Loops.h>
@@ -7,6 +8,10 @@
 #include <ATen/quantized/Quantizer.h>
 #include <ATen/native/SortingUtils.h>
 
+#include <climits>
+#include <type_traits>
+#include <vector>
+
 
 namespace at {
 namespace native {
@@ -808,6 +813,368 @@ void qtopk_kernel(Tensor& values,
   });
 }
 
+template <typename IndexType>
+void qembedding_bag_4bit_impl(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    bool normalize_by_lengths,
+    Tensor& output) {
+  const int64_t block_size = output.size(1);
+  const int64_t fused_block_size = weight.size(1);
+  const int64_t num_bags = offsets.numel();
+  const int64_t num_indices = indices.numel();
+  const uint8_t* weight_data = weight.data_ptr<uint8_t>();
+  const IndexType* indices_data = indices.data_ptr<IndexType>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const float* weights_data = per_sample_weights.defined()
+      ? per_sample_weights.data_ptr<float>()
+      : nullptr;
+  float* output_data = output.data_ptr<float>();
+
+  // Bags are independent, and each one reads a contiguous range of indices.
+  at::parallel_for(0, num_bags, 1, [&](int64_t start, int64_t end) {
+    for (int64_t bag = start; bag < end; ++bag) {
+      float* out = output_data + bag * block_size;
+      std::fill(out, out + block_size, 0.f);
+      const int64_t begin = offsets_data[bag];
+      const int64_t stop =
+          bag == num_bags - 1 ? num_indices : offsets_data[bag + 1];
+      for (int64_t i = begin; i < stop; ++i) {
+        const uint8_t* row = weight_data + indices_data[i] * fused_block_size;
+#ifdef __GNUC__
+        if (i + 1 < stop) {
+          __builtin_prefetch(
+              weight_data + indices_data[i + 1] * fused_block_size, 0, 1);
+        }
+#endif // __GNUC__
+        const at::Half* scale_bias =
+            reinterpret_cast<const at::Half*>(row + block_size / 2);
+        const float weight = weights_data ? weights_data[i] : 1.f;
+        const float scale = weight * float(scale_bias[0]);
+        const float bias = weight * float(scale_bias[1]);
+        // Written as plain loops over contiguous data, which the compiler
+        // vectorizes for the instruction set this file is built for.
+        for (int64_t j = 0; j < block_size / 2; ++j) {
+          out[2 * j] += scale * (row[j] & 0xf) + bias;
+          out[2 * j + 1] += scale * (row[j] >> 4) + bias;
+        }
+      }
+      if (normalize_by_lengths && stop > begin) {
+        const float inverse_length = 1.f / (stop - begin);
+        for (int64_t j = 0; j < block_size; ++j) {
+          out[j] *= inverse_length;
+        }
+      }
+    }
+  });
+}
+
+void qembedding_bag_4bit_kernel(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    bool normalize_by_lengths,
+    Tensor& output) {
+  if (indices.scalar_type() == kInt) {
+    qembedding_bag_4bit_impl<int32_t>(
+        weight, indices, offsets, per_sample_weights, normalize_by_lengths,
+        output);
+  } else {
+    qembedding_bag_4bit_impl<int64_t>(
+        weight, indices, offsets, per_sample_weights, normalize_by_lengths,
+        output);
+  }
+}
+
+// Dequantizes one rowwise quantized row of block_size values into out.
+template <int bits>
+inline void dequantize_row(const uint8_t* row, int64_t block_size, float* out);
+
+template <>
+inline void dequantize_row<8>(
+    const uint8_t* row,
+    int64_t block_size,
+    float* out) {
+  const float* scale_bias = reinterpret_cast<const float*>(row + block_size);
+  const float scale = scale_bias[0];
+  const float bias = scale_bias[1];
+  for (int64_t j = 0; j < block_size; ++j) {
+    out[j] = scale * row[j] + bias;
+  }
+}
+
+template <>
+inline void dequantize_row<4>(
+    const uint8_t* row,
+    int64_t block_size,
+    float* out) {
+  const at::Half* scale_bias =
+      reinterpret_cast<const at::Half*>(row + block_size / 2);
+  const float scale = scale_bias[0];
+  const float bias = scale_bias[1];
+  for (int64_t j = 0; j < block_size / 2; ++j) {
+    out[2 * j] = scale * (row[j] & 0xf) + bias;
+    out[2 * j + 1] = scale * (row[j] >> 4) + bias;
+  }
+}
+
+template <int bits, typename IndexType, typename OutType>
+void qembedding_lookup_impl(
+    const Tensor& weight,
+    const Tensor& indices,
+    Tensor& output) {
+  const int64_t block_size = output.size(-1);
+  const int64_t fused_block_size = weight.size(1);
+  const int64_t num_indices = indices.numel();
+  const uint8_t* weight_data = weight.data_ptr<uint8_t>();
+  const IndexType* indices_data = indices.data_ptr<IndexType>();
+  OutType* output_data = output.data_ptr<OutType>();
+
+  // Every index writes its own output row, so the indices are split between
+  // threads in chunks of about GRAIN_SIZE output values.
+  const int64_t grain_size = std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE / std::max<int64_t>(1, block_size));
+  at::parallel_for(0, num_indices, grain_size, [&](int64_t start, int64_t end) {
+    // Half outputs are dequantized in float first.
+    std::vector<float> buffer(
+        std::is_same<OutType, float>::value ? 0 : block_size);
+    for (int64_t i = start; i < end; ++i) {
+      const uint8_t* row = weight_data + indices_data[i] * fused_block_size;
+#ifdef __GNUC__
+      if (i + 1 < end) {
+        __builtin_prefetch(
+            weight_data + indices_data[i + 1] * fused_block_size, 0, 1);
+      }
+#endif // __GNUC__
+      OutType* out = output_data + i * block_size;
+      // Written as plain loops over contiguous data, which the compiler
+      // vectorizes for the instruction set this file is built for.
+      if (std::is_same<OutType, float>::value) {
+        dequantize_row<bits>(row, block_size, reinterpret_cast<float*>(out));
+      } else {
+        dequantize_row<bits>(row, block_size, buffer.data());
+        for (int64_t j = 0; j < block_size; ++j) {
+          out[j] = static_cast<OutType>(buffer[j]);
+        }
+      }
+    }
+  });
+}
+
+template <int bits, typename IndexType>
+void qembedding_lookup_dispatch_output(
+    const Tensor& weight,
+    const Tensor& indices,
+    Tensor& output) {
+  if (output.scalar_type() == kHalf) {
+    qembedding_lookup_impl<bits, IndexType, at::Half>(weight, indices, output);
+  } else {
+    qembedding_lookup_impl<bits, IndexType, float>(weight, indices, output);
+  }
+}
+
+void qembedding_lookup_kernel(
+    const Tensor& weight,
+    const Tensor& indices,
+    int64_t bits,
+    Tensor& output) {
+  const bool int_indices = indices.scalar_type() == kInt;
+  if (bits == 8) {
+    if (int_indices) {
+      qembedding_lookup_dispatch_output<8, int32_t>(weight, indices, output);
+    } else {
+      qembedding_lookup_dispatch_output<8, int64_t>(weight, indices, output);
+    }
+  } else {
+    if (int_indices) {
+      qembedding_lookup_dispatch_output<4, int32_t>(weight, indices, output);
+    } else {
+      qembedding_lookup_dispatch_output<4, int64_t>(weight, indices, output);
+    }
+  }
+}
+
+void qlut_kernel(const Tensor& qx, Tensor& qy, const uint8_t* table) {
+  AT_DISPATCH_QINT_TYPES(qx.scalar_type(), "qlut", [&]() {
+    auto iter = TensorIterator::unary_op(qy, qx);
+    cpu_kernel(iter, [&](scalar_t value) -> scalar_t {
+      return scalar_t(static_cast<underlying_t>(
+          table[static_cast<uint8_t>(value.val_)]));
+    });
+  });
+}
+
+void qbatch_norm_kernel(
+    const Tensor& qx,
+    const float* alpha,
+    const float* beta,
+    Tensor& qy) {
+  const int64_t N = qx.size(0);
+  const int64_t C = qx.size(1);
+  const int64_t inner_size = qx.numel() / std::max<int64_t>(N * C, 1);
+  const int64_t input_zero_point = qx.q_zero_point();
+  const int64_t grain_size = std::max<int64_t>(
+      at::internal::GRAIN_SIZE / std::max<int64_t>(inner_size, 1), 1);
+  AT_DISPATCH_QINT_TYPES(qx.scalar_type(), "qbatch_norm", [&]() {
+    const auto qmin = std::numeric_limits<underlying_t>::min();
+    const auto qmax = std::numeric_limits<underlying_t>::max();
+    const auto* x_data =
+        reinterpret_cast<const underlying_t*>(qx.data_ptr<scalar_t>());
+    auto* y_data = reinterpret_cast<underlying_t*>(qy.data_ptr<scalar_t>());
+    at::parallel_for(0, N * C, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t plane = begin; plane < end; ++plane) {
+        const int64_t c = plane % C;
+        // y = alpha * (x - input_zero_point) + beta, with the output scale
+        // and zero point already folded into alpha and beta.
+        const float a = alpha[c];
+        const float b = beta[c] - a * input_zero_point;
+        const underlying_t* x = x_data + plane * inner_size;
+        underlying_t* y = y_data + plane * inner_size;
+        for (int64_t i = 0; i < inner_size; ++i) {
+          const int32_t q = static_cast<int32_t>(std::nearbyint(a * x[i] + b));
+          y[i] = static_cast<underlying_t>(
+              std::min<int32_t>(std::max<int32_t>(q, qmin), qmax));
+        }
+      }
+    });
+  });
+}
+
+// The channel axis of a per channel quantized tensor is innermost in memory
+// for a channels last 4-d tensor quantized along dim 1.
+bool is_channels_last_along_axis(const Tensor& tensor, int64_t axis) {
+  return axis == 1 && tensor.dim() == 4 && !tensor.is_contiguous() &&
+      tensor.is_contiguous(MemoryFormat::ChannelsLast);
+}
+
+void quantize_tensor_per_channel_affine_kernel(
+    const Tensor& rtensor,
+    Tensor& qtensor,
+    const std::vector<double>& scales,
+    const std::vector<int64_t>& zero_points,
+    int64_t axis) {
+  const int64_t channels = rtensor.size(axis);
+  const float* rdata = rtensor.data_ptr<float>();
+  AT_DISPATCH_QINT_TYPES(
+      qtensor.scalar_type(), "quantize_tensor_per_channel_affine", [&]() {
+        auto* qdata = qtensor.data_ptr<scalar_t>();
+        if (is_channels_last_along_axis(qtensor, axis)) {
+          const auto qmin = std::numeric_limits<underlying_t>::min();
+          const auto qmax = std::numeric_limits<underlying_t>::max();
+          const std::vector<float> fscales(scales.begin(), scales.end());
+          const std::vector<float> fzero_points(
+              zero_points.begin(), zero_points.end());
+          auto* qvalues = reinterpret_cast<underlying_t*>(qdata);
+          const int64_t pixels = rtensor.numel() / channels;
+          at::parallel_for(
+              0,
+              pixels,
+              std::max<int64_t>(at::internal::GRAIN_SIZE / channels, 1),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t p = begin; p < end; ++p) {
+                  const float* r = rdata + p * channels;
+                  underlying_t* q = qvalues + p * channels;
+                  // Same rounding as quantize_val, over the channels of one
+                  // pixel, with the scales and zero points loaded per lane.
+                  for (int64_t c = 0; c < channels; ++c) {
+                    const float v = std::nearbyint(
+                        fzero_points[c] + r[c] / fscales[c]);
+                    q[c] = static_cast<underlying_t>(std::min<float>(
+                        std::max<float>(v, qmin), qmax));
+                  }
+                }
+              });
+        } else {
+          const int64_t elements_per_channel =
+              size_from_dim_(axis + 1, rtensor.sizes());
+          const int64_t planes = size_to_dim_(axis + 1, rtensor.sizes());
+          at::parallel_for(
+              0,
+              planes,
+              std::max<int64_t>(
+                  at::internal::GRAIN_SIZE /
+                      std::max<int64_t>(elements_per_channel, 1),
+                  1),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t plane = begin; plane < end; ++plane) {
+                  const int64_t c = plane % channels;
+                  // A contiguous run with a single scale and zero point,
+                  // which the vectorized per tensor routine handles.
+                  quantize_vec<scalar_t, CHAR_BIT * sizeof(underlying_t)>(
+                      scales[c],
+                      zero_points[c],
+                      rdata + plane * elements_per_channel,
+                      qdata + plane * elements_per_channel,
+                      elements_per_channel);
+                }
+              });
+        }
+      });
+}
+
+void dequantize_tensor_per_channel_affine_kernel(
+    const Tensor& qtensor,
+    Tensor& rtensor,
+    const std::vector<double>& scales,
+    const std::vector<int64_t>& zero_points,
+    int64_t axis) {
+  const int64_t channels = qtensor.size(axis);
+  const std::vector<float> fscales(scales.begin(), scales.end());
+  const std::vector<float> fzero_points(zero_points.begin(), zero_points.end());
+  float* rdata = rtensor.data_ptr<float>();
+  AT_DISPATCH_QINT_TYPES(
+      qtensor.scalar_type(), "dequantize_tensor_per_channel_affine", [&]() {
+        const auto* qvalues =
+            reinterpret_cast<const underlying_t*>(qtensor.data_ptr<scalar_t>());
+        // Written as plain loops over contiguous data, which the compiler
+        // vectorizes for the instruction set this file is built for.
+        if (is_channels_last_along_axis(qtensor, axis)) {
+          const int64_t pixels = qtensor.numel() / channels;
+          at::parallel_for(
+              0,
+              pixels,
+              std::max<int64_t>(at::internal::GRAIN_SIZE / channels, 1),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t p = begin; p < end; ++p) {
+                  const underlying_t* q = qvalues + p * channels;
+                  float* r = rdata + p * channels;
+                  for (int64_t c = 0; c < channels; ++c) {
+                    r[c] = (static_cast<float>(q[c]) - fzero_points[c]) *
+                        fscales[c];
+                  }
+                }
+              });
+        } else {
+          const int64_t elements_per_channel =
+              size_from_dim_(axis + 1, qtensor.sizes());
+          const int64_t planes = size_to_dim_(axis + 1, qtensor.sizes());
+          at::parallel_for(
+              0,
+              planes,
+              std::max<int64_t>(
+                  at::internal::GRAIN_SIZE /
+                      std::max<int64_t>(elements_per_channel, 1),
+                  1),
+              [&](int64_t begin, int64_t end) {
+                for (int64_t plane = begin; plane < end; ++plane) {
+                  const int64_t c = plane % channels;
+                  const float scale = fscales[c];
+                  const float zero_point = fzero_points[c];
+                  const underlying_t* q =
+                      qvalues + plane * elements_per_channel;
+                  float* r = rdata + plane * elements_per_channel;
+                  for (int64_t e = 0; e < elements_per_channel; ++e) {
+                    r[e] = (static_cast<float>(q[e]) - zero_point) * scale;
+                  }
+                }
+              });
+        }
+      });
+}
+
 } // namespace
 
 REGISTER_DISPATCH(qrelu_stub, &qrelu_kernel);
@@ -825,6 +1192,16 @@ REGISTER_DISPATCH(
 REGISTER_DISPATCH(qcat_nhwc_stub, &qcat_nhwc_kernel<false>);
 REGISTER_DISPATCH(qcat_relu_nhwc_stub, &qcat_nhwc_kernel<true>);
 REGISTER_DISPATCH(qtopk_stub, &qtopk_kernel);
+REGISTER_DISPATCH(qembedding_bag_4bit_stub, &qembedding_bag_4bit_kernel);
+REGISTER_DISPATCH(qembedding_lookup_stub, &qembedding_lookup_kernel);
+REGISTER_DISPATCH(qlut_stub, &qlut_kernel);
+REGISTER_DISPATCH(qbatch_norm_stub, &qbatch_norm_kernel);
+REGISTER_DISPATCH(
+    quantize_tensor_per_channel_affine_stub,
+    &quantize_tensor_per_channel_affine_kernel);
+REGISTER_DISPATCH(
+    dequantize_tensor_per_channel_affine_stub,
+    &dequantize_tensor_per_channel_affine_kernel);
 
 } // namespace native
 } // namespace at
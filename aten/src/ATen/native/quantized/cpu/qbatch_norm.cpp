@@ -0,0 +1,97 @@
+#include <ATen/ATen.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <cmath>
+#include <vector>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qbatch_norm_stub);
+
+namespace {
+
+// Inference batch norm over the channels (dim 1) of a quantized tensor. The
+// normalization and the affine transform are folded into a single scale and
+// shift per channel, which are applied directly to the quantized values, so
+// the input never gets dequantized.
+class QBatchNorm final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(
+      Tensor qx,
+      c10::optional<Tensor> weight,
+      c10::optional<Tensor> bias,
+      Tensor mean,
+      Tensor var,
+      double eps,
+      double output_scale,
+      int64_t output_zero_point) {
+    TORCH_CHECK(
+        qx.dim() >= 2,
+        "quantized::batch_norm: expected an input with at least 2 dimensions, got ",
+        qx.dim());
+    TORCH_CHECK(
+        qx.qscheme() == kPerTensorAffine,
+        "quantized::batch_norm: only per tensor affine quantized inputs are supported");
+    const int64_t C = qx.size(1);
+    TORCH_CHECK(
+        mean.numel() == C && var.numel() == C,
+        "quantized::batch_norm: expected running mean and variance with ",
+        C,
+        " elements");
+    TORCH_CHECK(
+        !weight.has_value() || weight->numel() == C,
+        "quantized::batch_norm: expected a weight with ", C, " elements");
+    TORCH_CHECK(
+        !bias.has_value() || bias->numel() == C,
+        "quantized::batch_norm: expected a bias with ", C, " elements");
+
+    const auto mean_contig = mean.to(kFloat).contiguous();
+    const auto var_contig = var.to(kFloat).contiguous();
+    const float* mean_data = mean_contig.data_ptr<float>();
+    const float* var_data = var_contig.data_ptr<float>();
+    Tensor weight_contig, bias_contig;
+    const float* weight_data = nullptr;
+    const float* bias_data = nullptr;
+    if (weight.has_value()) {
+      weight_contig = weight->to(kFloat).contiguous();
+      weight_data = weight_contig.data_ptr<float>();
+    }
+    if (bias.has_value()) {
+      bias_contig = bias->to(kFloat).contiguous();
+      bias_data = bias_contig.data_ptr<float>();
+    }
+
+    // y = (x - mean) / sqrt(var + eps) * weight + bias, in units of the
+    // output scale and with x = input_scale * (qx - input_zero_point).
+    const double input_scale = qx.q_scale();
+    std::vector<float> alpha(C), beta(C);
+    for (int64_t c = 0; c < C; ++c) {
+      const double inv_std = 1.0 / std::sqrt(var_data[c] + eps);
+      const double w = weight_data ? weight_data[c] : 1.0;
+      const double b = bias_data ? bias_data[c] : 0.0;
+      alpha[c] = w * inv_std * input_scale / output_scale;
+      beta[c] = (b - mean_data[c] * w * inv_std) / output_scale +
+          output_zero_point;
+    }
+
+    const auto qx_contig = qx.contiguous();
+    Tensor qy = at::_empty_affine_quantized(
+        qx_contig.sizes(), qx.options(), output_scale, output_zero_point);
+    qbatch_norm_stub(
+        qx.device().type(), qx_contig, alpha.data(), beta.data(), qy);
+    return qy;
+  }
+};
+
+static auto registry = c10::RegisterOperators().op(
+    "quantized::batch_norm(Tensor qx, Tensor? weight, Tensor? bias, "
+    "Tensor mean, Tensor var, float eps, float output_scale, "
+    "int output_zero_point) -> Tensor",
+    c10::RegisterOperators::options().kernel<QBatchNorm>(
+        TensorTypeId::QuantizedCPUTensorId));
+
+} // namespace
+} // namespace native
+} // namespace at
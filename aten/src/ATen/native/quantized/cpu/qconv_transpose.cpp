@@ -0,0 +1,230 @@
+#include <ATen/ATen.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/init_qnnpack.h>
+#include <ATen/native/quantized/cpu/qnnpack_utils.h>
+#include <caffe2/utils/threadpool/ThreadPoolMobile.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace at {
+namespace native {
+namespace {
+
+class QConvTranspose2dInt8 final : public c10::OperatorKernel {
+ public:
+#ifdef USE_PYTORCH_QNNPACK
+  // Unlike quantized::conv2d, this takes the unpacked weight: QNNPACK packs
+  // the weight of a deconvolution when creating the operator, with the bias
+  // requantized for the scale of the input.
+  Tensor qnnpack_conv_transpose2d(
+      Tensor act,
+      Tensor weight,
+      c10::optional<Tensor> bias,
+      torch::List<int64_t> stride,
+      torch::List<int64_t> padding,
+      torch::List<int64_t> output_padding,
+      torch::List<int64_t> dilation,
+      int64_t groups,
+      double output_scale,
+      int64_t output_zero_point) {
+    TORCH_CHECK(
+        act.ndimension() == 4,
+        "quantized::conv_transpose2d (qnnpack): Expected activation tensor to "
+        "be 4-dimensional");
+    TORCH_CHECK(
+        weight.ndimension() == 4,
+        "quantized::conv_transpose2d (qnnpack): Expected weight tensor to be "
+        "4-dimensional");
+    TORCH_CHECK(
+        stride.size() == 2 && padding.size() == 2 &&
+            output_padding.size() == 2 && dilation.size() == 2,
+        "quantized::conv_transpose2d (qnnpack): stride, padding, "
+        "output_padding and dilation should contain 2 elements");
+    TORCH_CHECK(
+        act.scalar_type() == kQUInt8,
+        "quantized::conv_transpose2d (qnnpack): Expected activation data type ",
+        toString(kQUInt8),
+        " but got ",
+        toString(act.scalar_type()));
+    TORCH_CHECK(
+        weight.scalar_type() == kQInt8 &&
+            weight.qscheme() == kPerTensorAffine,
+        "quantized::conv_transpose2d (qnnpack): Expected a per tensor "
+        "quantized qint8 weight");
+
+    // The weight is (in_ch, out_ch / groups, kernel_h, kernel_w).
+    const int64_t N = act.size(0);
+    const int64_t in_ch = act.size(1);
+    const int64_t H = act.size(2);
+    const int64_t W = act.size(3);
+    const int64_t kernel_h = weight.size(2);
+    const int64_t kernel_w = weight.size(3);
+    const int64_t out_ch = weight.size(1) * groups;
+    TORCH_CHECK(
+        weight.size(0) == in_ch && in_ch % groups == 0,
+        "quantized::conv_transpose2d (qnnpack): Expected a weight with ",
+        in_ch,
+        " input channels, divisible by the ",
+        groups,
+        " groups");
+
+    const int64_t out_h = (H - 1) * stride[0] - 2 * padding[0] +
+        dilation[0] * (kernel_h - 1) + output_padding[0] + 1;
+    const int64_t out_w = (W - 1) * stride[1] - 2 * padding[1] +
+        dilation[1] * (kernel_w - 1) + output_padding[1] + 1;
+    TORCH_CHECK(
+        out_h > 0 && out_w > 0,
+        "quantized::conv_transpose2d (qnnpack): each dimension of output "
+        "tensor should be greater than 0");
+
+    // TODO: change it to contiguous(MemoryFormat::ChannelsLast) once a perf
+    // regression of it is fixed, like for quantized::conv2d.
+    Tensor input_contig = act.permute({0, 2, 3, 1}).contiguous();
+    const double input_scale = act.q_scale();
+
+    // QNNPACK expects the kernel of every group as
+    // (in_ch / groups, kernel_h, kernel_w, out_ch / groups), in uint8.
+    Tensor weight_contig = weight.permute({0, 2, 3, 1}).contiguous();
+    const int8_t* w_data = (int8_t*)weight_contig.data_ptr<c10::qint8>();
+    std::vector<uint8_t> qnnp_w_data(weight_contig.numel());
+    for (size_t i = 0; i < qnnp_w_data.size(); ++i) {
+      qnnp_w_data[i] = static_cast<uint8_t>(w_data[i] + 128);
+    }
+    const double kernel_scale = weight.q_scale();
+    const int64_t kernel_zp = weight.q_zero_point() + 128;
+
+    Tensor bias_fp32;
+    if (bias.has_value()) {
+      TORCH_CHECK(
+          bias->dim() == 1 && bias->size(0) == out_ch,
+          "quantized::conv_transpose2d (qnnpack): Expected a bias with ",
+          out_ch,
+          " elements");
+      bias_fp32 = bias->to(kFloat).contiguous();
+    } else {
+      bias_fp32 = at::zeros({out_ch}, at::device(kCPU).dtype(kFloat));
+    }
+    // Original bias was float, so we requantize it here.
+    Tensor qbias = at::quantize_per_tensor(
+        bias_fp32, kernel_scale * input_scale, 0, kQInt32);
+
+    initQNNPACK();
+
+    pytorch_qnnp_operator_t qnnpack_operator{nullptr};
+    const pytorch_qnnp_status createStatus =
+        pytorch_qnnp_create_deconvolution2d_nhwc_q8(
+            padding[0] /* input_padding_top */,
+            padding[1] /* input_padding_right */,
+            padding[0] /* input_padding_bottom */,
+            padding[1] /* input_padding_left */,
+            output_padding[0] /* adjustment_height */,
+            output_padding[1] /* adjustment_width */,
+            kernel_h,
+            kernel_w,
+            stride[0],
+            stride[1],
+            dilation[0],
+            dilation[1],
+            groups,
+            in_ch / groups /* group_input_channels */,
+            out_ch / groups /* group_output_channels */,
+            act.q_zero_point(),
+            input_scale,
+            kernel_zp,
+            kernel_scale,
+            qnnp_w_data.data(),
+            (int32_t*)qbias.data_ptr<c10::qint32>(),
+            output_zero_point,
+            output_scale,
+            std::numeric_limits<uint8_t>::min() /* output min */,
+            std::numeric_limits<uint8_t>::max() /* output max */,
+            0 /* flags */,
+            &qnnpack_operator);
+
+    std::unique_ptr<pytorch_qnnp_operator, QnnpackOperatorDeleter>
+        qnnpack_uniq_ptr(qnnpack_operator);
+
+    TORCH_CHECK(
+        createStatus == pytorch_qnnp_status_success,
+        "failed to create QNNPACK ConvTranspose2d operator; note that QNNPACK "
+        "requires input_scale * weight_scale < output_scale");
+
+    Tensor output = at::_empty_affine_quantized(
+        {N, out_h, out_w, out_ch},
+        at::device(kCPU).dtype(kQUInt8),
+        output_scale,
+        output_zero_point);
+
+    pthreadpool_t threadpool = caffe2::mobile_pthreadpool();
+
+    const pytorch_qnnp_status setupStatus =
+        pytorch_qnnp_setup_deconvolution2d_nhwc_q8(
+            qnnpack_operator,
+            N,
+            H,
+            W,
+            (uint8_t*)input_contig.data_ptr<c10::quint8>(),
+            in_ch /* input_pixel_stride */,
+            (uint8_t*)output.data_ptr<c10::quint8>(),
+            out_ch /* output_pixel_stride */,
+            threadpool);
+    TORCH_INTERNAL_ASSERT(
+        setupStatus == pytorch_qnnp_status_success,
+        "failed to setup QNNPACK ConvTranspose2d operator");
+
+    const pytorch_qnnp_status runStatus =
+        pytorch_qnnp_run_operator(qnnpack_operator, threadpool);
+    TORCH_INTERNAL_ASSERT(
+        runStatus == pytorch_qnnp_status_success,
+        "failed to run QNNPACK ConvTranspose2d operator");
+
+    // TODO: remove permute once MemoryLayout is added above
+    return output.permute({0, 3, 1, 2});
+  }
+#endif // USE_PYTORCH_QNNPACK
+
+  Tensor operator()(
+      Tensor act,
+      Tensor weight,
+      c10::optional<Tensor> bias,
+      torch::List<int64_t> stride,
+      torch::List<int64_t> padding,
+      torch::List<int64_t> output_padding,
+      torch::List<int64_t> dilation,
+      int64_t groups,
+      double output_scale,
+      int64_t output_zero_point) {
+    auto& ctx = at::globalContext();
+#ifdef USE_PYTORCH_QNNPACK
+    if (ctx.qEngine() == at::QEngine::QNNPACK) {
+      return qnnpack_conv_transpose2d(
+          act,
+          weight,
+          bias,
+          stride,
+          padding,
+          output_padding,
+          dilation,
+          groups,
+          output_scale,
+          output_zero_point);
+    }
+#endif // USE_PYTORCH_QNNPACK
+    TORCH_CHECK(
+        false,
+        "Didn't find engine for operation quantized::conv_transpose2d ",
+        toString(ctx.qEngine()));
+  }
+};
+
+static auto registry = c10::RegisterOperators().op(
+    "quantized::conv_transpose2d(Tensor qx, Tensor weight, Tensor? bias, "
+    "int[] stride, int[] padding, int[] output_padding, int[] dilation, "
+    "int groups, float output_scale, int output_zero_point) -> Tensor",
+    c10::RegisterOperators::options().kernel<QConvTranspose2dInt8>(
+        TensorTypeId::QuantizedCPUTensorId));
+
+} // namespace
+} // namespace native
+} // namespace at
@@ -0,0 +1,504 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <caffe2/perfkernels/fused_8bit_rowwise_embedding_lookup_idx.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qembedding_bag_4bit_stub);
+DEFINE_DISPATCH(qembedding_lookup_stub);
+
+namespace {
+
+// Rowwise quantized embedding tables store every row as its quantized values,
+// followed by the scale and bias to dequantize them with, `value * scale +
+// bias`:
+//
+//  - 8-bit: | D uint8 values | float scale | float bias |, the layout of the
+//    caffe2 Fused8BitRowwise operators and perfkernels.
+//  - 4-bit: | D / 2 uint8, two values each | half scale | half bias |, with
+//    value 2 * i in the low and value 2 * i + 1 in the high nibble of byte i.
+constexpr int64_t kByteScaleBiasBytes = 2 * sizeof(float);
+constexpr int64_t k4BitScaleBiasBytes = 2 * sizeof(at::Half);
+
+constexpr int64_t MODE_SUM = 0;
+constexpr int64_t MODE_MEAN = 1;
+
+void check_prepack_input(const Tensor& weight, const char* op) {
+  TORCH_CHECK(
+      weight.dim() == 2 && weight.scalar_type() == kFloat,
+      op,
+      " expects a 2-dimensional float weight, but got a ",
+      weight.dim(),
+      "-dimensional ",
+      weight.scalar_type(),
+      " tensor");
+}
+
+void check_packed_weight(
+    const Tensor& weight,
+    int64_t scale_bias_bytes,
+    const char* op) {
+  TORCH_CHECK(
+      weight.dim() == 2 && weight.scalar_type() == kByte &&
+          weight.size(1) >= scale_bias_bytes && weight.is_contiguous(),
+      op,
+      " expects a contiguous 2-dimensional uint8 weight as returned by its "
+      "prepack op, but got a ",
+      weight.dim(),
+      "-dimensional ",
+      weight.scalar_type(),
+      " tensor of size ",
+      weight.sizes());
+}
+
+// Computes the scale and bias that map the range of `row` onto
+// [0, 2^bits - 1], like caffe2's FloatToFused8BitRowwiseQuantized.
+std::pair<float, float> rowwise_scale_bias(
+    const float* row,
+    int64_t size,
+    int bits) {
+  float minimum = 0;
+  float maximum = 0;
+  if (size > 0) {
+    const auto range = std::minmax_element(row, row + size);
+    minimum = *range.first;
+    maximum = *range.second;
+  }
+  return {(maximum - minimum) / ((1 << bits) - 1), minimum};
+}
+
+uint8_t quantize_value(
+    float value,
+    float minimum,
+    float inverse_scale,
+    int bits) {
+  const float quantized = std::nearbyint((value - minimum) * inverse_scale);
+  return static_cast<uint8_t>(
+      std::max(0.f, std::min(quantized, float((1 << bits) - 1))));
+}
+
+Tensor embedding_bag_byte_prepack(const Tensor& weight) {
+  check_prepack_input(weight, "quantized::embedding_bag_byte_prepack");
+  const auto weight_contig = weight.contiguous();
+  const int64_t rows = weight_contig.size(0);
+  const int64_t cols = weight_contig.size(1);
+  auto packed = at::empty(
+      {rows, cols + kByteScaleBiasBytes}, weight.options().dtype(kByte));
+  const float* weight_data = weight_contig.data_ptr<float>();
+  uint8_t* packed_data = packed.data_ptr<uint8_t>();
+
+  at::parallel_for(0, rows, 1, [&](int64_t start, int64_t end) {
+    for (int64_t row = start; row < end; ++row) {
+      const float* input_row = weight_data + row * cols;
+      uint8_t* output_row = packed_data + row * (cols + kByteScaleBiasBytes);
+      const auto scale_bias = rowwise_scale_bias(input_row, cols, 8);
+      float* output_scale_bias = reinterpret_cast<float*>(output_row + cols);
+      output_scale_bias[0] = scale_bias.first;
+      output_scale_bias[1] = scale_bias.second;
+      // 255 / (range + epsilon) like caffe2, so that rows of equal values
+      // quantize to 0.
+      const float inverse_scale = 1.f / (scale_bias.first + 1e-8f / 255);
+      for (int64_t col = 0; col < cols; ++col) {
+        output_row[col] = quantize_value(
+            input_row[col], scale_bias.second, inverse_scale, 8);
+      }
+    }
+  });
+  return packed;
+}
+
+Tensor embedding_bag_byte_unpack(const Tensor& packed) {
+  check_packed_weight(
+      packed, kByteScaleBiasBytes, "quantized::embedding_bag_byte_unpack");
+  const int64_t rows = packed.size(0);
+  const int64_t cols = packed.size(1) - kByteScaleBiasBytes;
+  auto weight = at::empty({rows, cols}, packed.options().dtype(kFloat));
+  const uint8_t* packed_data = packed.data_ptr<uint8_t>();
+  float* weight_data = weight.data_ptr<float>();
+
+  at::parallel_for(0, rows, 1, [&](int64_t start, int64_t end) {
+    for (int64_t row = start; row < end; ++row) {
+      const uint8_t* input_row = packed_data + row * packed.size(1);
+      const float* scale_bias =
+          reinterpret_cast<const float*>(input_row + cols);
+      for (int64_t col = 0; col < cols; ++col) {
+        weight_data[row * cols + col] =
+            input_row[col] * scale_bias[0] + scale_bias[1];
+      }
+    }
+  });
+  return weight;
+}
+
+Tensor embedding_bag_4bit_prepack(const Tensor& weight) {
+  check_prepack_input(weight, "quantized::embedding_bag_4bit_prepack");
+  const auto weight_contig = weight.contiguous();
+  const int64_t rows = weight_contig.size(0);
+  const int64_t cols = weight_contig.size(1);
+  TORCH_CHECK(
+      cols % 2 == 0,
+      "quantized::embedding_bag_4bit_prepack expects an even embedding "
+      "dimension, but got ",
+      cols);
+  const int64_t packed_cols = cols / 2 + k4BitScaleBiasBytes;
+  auto packed = at::empty({rows, packed_cols}, weight.options().dtype(kByte));
+  const float* weight_data = weight_contig.data_ptr<float>();
+  uint8_t* packed_data = packed.data_ptr<uint8_t>();
+
+  at::parallel_for(0, rows, 1, [&](int64_t start, int64_t end) {
+    for (int64_t row = start; row < end; ++row) {
+      const float* input_row = weight_data + row * cols;
+      uint8_t* output_row = packed_data + row * packed_cols;
+      auto scale_bias = rowwise_scale_bias(input_row, cols, 4);
+      // Quantize with the scale and bias as they are stored, in half
+      // precision, so that dequantization matches.
+      const at::Half scale = scale_bias.first;
+      const at::Half bias = scale_bias.second;
+      at::Half* output_scale_bias =
+          reinterpret_cast<at::Half*>(output_row + cols / 2);
+      output_scale_bias[0] = scale;
+      output_scale_bias[1] = bias;
+      const float inverse_scale =
+          float(scale) == 0 ? 0.f : 1.f / float(scale);
+      for (int64_t col = 0; col < cols; col += 2) {
+        const uint8_t low =
+            quantize_value(input_row[col], bias, inverse_scale, 4);
+        const uint8_t high =
+            quantize_value(input_row[col + 1], bias, inverse_scale, 4);
+        output_row[col / 2] = low | (high << 4);
+      }
+    }
+  });
+  return packed;
+}
+
+Tensor embedding_bag_4bit_unpack(const Tensor& packed) {
+  check_packed_weight(
+      packed, k4BitScaleBiasBytes, "quantized::embedding_bag_4bit_unpack");
+  const int64_t rows = packed.size(0);
+  const int64_t cols = 2 * (packed.size(1) - k4BitScaleBiasBytes);
+  auto weight = at::empty({rows, cols}, packed.options().dtype(kFloat));
+  const uint8_t* packed_data = packed.data_ptr<uint8_t>();
+  float* weight_data = weight.data_ptr<float>();
+
+  at::parallel_for(0, rows, 1, [&](int64_t start, int64_t end) {
+    for (int64_t row = start; row < end; ++row) {
+      const uint8_t* input_row = packed_data + row * packed.size(1);
+      const at::Half* scale_bias =
+          reinterpret_cast<const at::Half*>(input_row + cols / 2);
+      const float scale = scale_bias[0];
+      const float bias = scale_bias[1];
+      for (int64_t col = 0; col < cols; ++col) {
+        const uint8_t value = (input_row[col / 2] >> ((col % 2) * 4)) & 0xf;
+        weight_data[row * cols + col] = value * scale + bias;
+      }
+    }
+  });
+  return weight;
+}
+
+// Validates the arguments of a quantized embedding_bag and returns the
+// contiguous indices and offsets to run it with.
+std::pair<Tensor, Tensor> check_embedding_bag_inputs(
+    const Tensor& indices,
+    const Tensor& offsets,
+    int64_t mode,
+    const c10::optional<Tensor>& per_sample_weights,
+    const char* op) {
+  TORCH_CHECK(
+      indices.dim() == 1 && offsets.dim() == 1,
+      op,
+      " expects 1-dimensional indices and offsets");
+  TORCH_CHECK(
+      offsets.scalar_type() == kLong,
+      op,
+      " expects int64 offsets, but got ",
+      offsets.scalar_type());
+  TORCH_CHECK(
+      indices.scalar_type() == kLong || indices.scalar_type() == kInt,
+      op,
+      " expects int32 or int64 indices, but got ",
+      indices.scalar_type());
+  TORCH_CHECK(
+      mode == MODE_SUM || mode == MODE_MEAN,
+      op,
+      " supports the sum (0) and mean (1) modes, but got mode ",
+      mode);
+  if (per_sample_weights.has_value()) {
+    TORCH_CHECK(
+        mode == MODE_SUM,
+        op,
+        ": per_sample_weights is only supported for mode='sum' (mode 0)");
+    TORCH_CHECK(
+        per_sample_weights->scalar_type() == kFloat &&
+            per_sample_weights->sizes() == indices.sizes(),
+        op,
+        " expects float per_sample_weights of the same shape as indices");
+  }
+  auto offsets_contig = offsets.contiguous();
+  TORCH_CHECK(
+      offsets_contig.numel() == 0 ||
+          offsets_contig.data_ptr<int64_t>()[0] == 0,
+      op,
+      " expects offsets to start at 0");
+  return {indices.contiguous(), offsets_contig};
+}
+
+void check_indices_in_range(
+    const Tensor& indices,
+    int64_t num_rows,
+    const char* op) {
+  if (indices.numel() > 0) {
+    const auto min = indices.min().item<int64_t>();
+    const auto max = indices.max().item<int64_t>();
+    TORCH_CHECK(
+        min >= 0 && max < num_rows,
+        op,
+        ": indices must be in [0, ",
+        num_rows,
+        "), but got indices in [",
+        min,
+        ", ",
+        max,
+        "]");
+  }
+}
+
+// The perfkernel dispatches to an AVX2 and FMA implementation at runtime,
+// where the CPU supports it, and checks the indices and offsets.
+template <typename IndexType>
+void fused_8bit_embedding_bag(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const Tensor& per_sample_weights,
+    int64_t mode,
+    Tensor& output) {
+  caffe2::Fused8BitRowwiseEmbeddingLookupIdx<IndexType, uint8_t, float>(
+      /*block_size=*/output.size(1),
+      /*output_size=*/offsets.numel(),
+      /*index_size=*/indices.numel(),
+      /*data_size=*/weight.size(0),
+      /*input=*/weight.data_ptr<uint8_t>(),
+      /*indices=*/indices.data_ptr<IndexType>(),
+      /*offsets=*/offsets.data_ptr<int64_t>(),
+      /*weights=*/
+      per_sample_weights.defined() ? per_sample_weights.data_ptr<float>()
+                                   : nullptr,
+      /*normalize_by_lengths=*/mode == MODE_MEAN,
+      /*out=*/output.data_ptr<float>());
+}
+
+Tensor embedding_bag_byte(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    int64_t mode,
+    c10::optional<Tensor> per_sample_weights) {
+  const char* op = "quantized::embedding_bag_byte";
+  check_packed_weight(weight, kByteScaleBiasBytes, op);
+  Tensor indices_contig, offsets_contig;
+  std::tie(indices_contig, offsets_contig) = check_embedding_bag_inputs(
+      indices, offsets, mode, per_sample_weights, op);
+  Tensor weights_contig;
+  if (per_sample_weights.has_value()) {
+    weights_contig = per_sample_weights->contiguous();
+  }
+
+  const int64_t block_size = weight.size(1) - kByteScaleBiasBytes;
+  auto output = at::empty(
+      {offsets_contig.numel(), block_size}, weight.options().dtype(kFloat));
+  if (indices_contig.scalar_type() == kInt) {
+    fused_8bit_embedding_bag<int32_t>(
+        weight, indices_contig, offsets_contig, weights_contig, mode, output);
+  } else {
+    fused_8bit_embedding_bag<int64_t>(
+        weight, indices_contig, offsets_contig, weights_contig, mode, output);
+  }
+  return output;
+}
+
+Tensor embedding_bag_4bit(
+    const Tensor& weight,
+    const Tensor& indices,
+    const Tensor& offsets,
+    int64_t mode,
+    c10::optional<Tensor> per_sample_weights) {
+  const char* op = "quantized::embedding_bag_4bit";
+  check_packed_weight(weight, k4BitScaleBiasBytes, op);
+  Tensor indices_contig, offsets_contig;
+  std::tie(indices_contig, offsets_contig) = check_embedding_bag_inputs(
+      indices, offsets, mode, per_sample_weights, op);
+  Tensor weights_contig;
+  if (per_sample_weights.has_value()) {
+    weights_contig = per_sample_weights->contiguous();
+  }
+  // Unlike the perfkernel, the kernel doesn't check the indices itself.
+  check_indices_in_range(indices_contig, weight.size(0), op);
+  const int64_t* offsets_data = offsets_contig.data_ptr<int64_t>();
+  for (int64_t i = 1; i < offsets_contig.numel(); ++i) {
+    TORCH_CHECK(
+        offsets_data[i - 1] <= offsets_data[i] &&
+            offsets_data[i] <= indices_contig.numel(),
+        op,
+        " expects non-decreasing offsets within the number of indices");
+  }
+
+  auto output = at::empty(
+      {offsets_contig.numel(), 2 * (weight.size(1) - k4BitScaleBiasBytes)},
+      weight.options().dtype(kFloat));
+  qembedding_bag_4bit_stub(
+      kCPU,
+      weight,
+      indices_contig,
+      offsets_contig,
+      weights_contig,
+      mode == MODE_MEAN,
+      output);
+  return output;
+}
+
+// Gathers the rows of a rowwise quantized weight, dequantized, into an output
+// of the sizes of indices followed by the embedding dimension, as embedding
+// does for a float weight.
+Tensor embedding_lookup(
+    const Tensor& weight,
+    const Tensor& indices,
+    bool half_output,
+    int64_t bits,
+    const char* op) {
+  const int64_t scale_bias_bytes =
+      bits == 8 ? kByteScaleBiasBytes : k4BitScaleBiasBytes;
+  check_packed_weight(weight, scale_bias_bytes, op);
+  TORCH_CHECK(
+      indices.scalar_type() == kLong || indices.scalar_type() == kInt,
+      op,
+      " expects int32 or int64 indices, but got ",
+      indices.scalar_type());
+  const auto indices_contig = indices.contiguous();
+  check_indices_in_range(indices_contig, weight.size(0), op);
+
+  const int64_t packed_cols = weight.size(1) - scale_bias_bytes;
+  const int64_t block_size = bits == 8 ? packed_cols : 2 * packed_cols;
+  auto sizes = indices.sizes().vec();
+  sizes.push_back(block_size);
+  auto output = at::empty(
+      sizes, weight.options().dtype(half_output ? kHalf : kFloat));
+  auto output_rows = output.view({indices.numel(), block_size});
+  qembedding_lookup_stub(kCPU, weight, indices_contig, bits, output_rows);
+  return output;
+}
+
+class QEmbeddingBagPrepack final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor weight) {
+    return embedding_bag_byte_prepack(weight);
+  }
+};
+
+class QEmbeddingBagUnpack final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor packed) {
+    return embedding_bag_byte_unpack(packed);
+  }
+};
+
+class QEmbeddingBag4BitPrepack final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor weight) {
+    return embedding_bag_4bit_prepack(weight);
+  }
+};
+
+class QEmbeddingBag4BitUnpack final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor packed) {
+    return embedding_bag_4bit_unpack(packed);
+  }
+};
+
+class QEmbeddingBag final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(
+      Tensor weight,
+      Tensor indices,
+      Tensor offsets,
+      int64_t mode,
+      c10::optional<Tensor> per_sample_weights) {
+    return embedding_bag_byte(
+        weight, indices, offsets, mode, std::move(per_sample_weights));
+  }
+};
+
+class QEmbeddingBag4Bit final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(
+      Tensor weight,
+      Tensor indices,
+      Tensor offsets,
+      int64_t mode,
+      c10::optional<Tensor> per_sample_weights) {
+    return embedding_bag_4bit(
+        weight, indices, offsets, mode, std::move(per_sample_weights));
+  }
+};
+
+class QEmbeddingLookup final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor weight, Tensor indices, bool half_output) {
+    return embedding_lookup(
+        weight, indices, half_output, 8, "quantized::embedding_byte");
+  }
+};
+
+class QEmbeddingLookup4Bit final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor weight, Tensor indices, bool half_output) {
+    return embedding_lookup(
+        weight, indices, half_output, 4, "quantized::embedding_4bit");
+  }
+};
+
+static auto registry =
+    c10::RegisterOperators()
+        .op("quantized::embedding_bag_byte_prepack(Tensor weight) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBagPrepack>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_bag_byte_unpack(Tensor weight) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBagUnpack>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_bag_4bit_prepack(Tensor weight) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBag4BitPrepack>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_bag_4bit_unpack(Tensor weight) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBag4BitUnpack>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_bag_byte(Tensor weight, Tensor indices, "
+            "Tensor offsets, int mode=0, Tensor? per_sample_weights=None) "
+            "-> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBag>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_bag_4bit(Tensor weight, Tensor indices, "
+            "Tensor offsets, int mode=0, Tensor? per_sample_weights=None) "
+            "-> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingBag4Bit>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_byte(Tensor weight, Tensor indices, "
+            "bool half_output=False) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingLookup>(
+                TensorTypeId::CPUTensorId))
+        .op("quantized::embedding_4bit(Tensor weight, Tensor indices, "
+            "bool half_output=False) -> Tensor",
+            c10::RegisterOperators::options().kernel<QEmbeddingLookup4Bit>(
+                TensorTypeId::CPUTensorId));
+
+} // namespace
+} // namespace native
+} // namespace at
@@ -0,0 +1,30 @@
+#include <ATen/ATen.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+
+#include <algorithm>
+
+namespace at {
+namespace native {
+namespace {
+
+// hardswish(x) = x * relu6(x + 3) / 6, as used by MobileNetV3. There is no
+// floating point op for it, so it is only available as a quantized op for now.
+class QHardswish final : public c10::OperatorKernel {
+ public:
+  Tensor operator()(Tensor qx, double output_scale, int64_t output_zero_point) {
+    return quantized_lut_op(
+        qx, output_scale, output_zero_point, [](float x) {
+          return x * std::min(std::max(x + 3.f, 0.f), 6.f) / 6.f;
+        });
+  }
+};
+
+static auto registry = c10::RegisterOperators().op(
+    "quantized::hardswish(Tensor qx, float output_scale, int output_zero_point) -> Tensor",
+    c10::RegisterOperators::options().kernel<QHardswish>(
+        TensorTypeId::QuantizedCPUTensorId));
+
+} // namespace
+} // namespace native
+} // namespace at
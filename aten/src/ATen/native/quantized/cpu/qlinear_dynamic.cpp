@@ -1,4 +1,5 @@
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 #include <ATen/core/op_registration/op_registration.h>
 #include <ATen/cpp_custom_type_hack.h>
 #include <ATen/native/quantized/cpu/fbgemm_utils.h>
@@ -12,8 +13,55 @@ namespace {
 
 template <bool ReluFused>
 class QLinearDynamicInt8 final : public torch::OperatorKernel {
- public:
 #ifdef USE_FBGEMM
+  // Runs the part of the GEMM of `task_id` and, in the same pass over its
+  // tiles, does the following with the uint8 * int8 result:
+  //  1) Add in row and column offsets to the rows and columns, respectively
+  //  2) Dequantize the results into floating point, with a single weight
+  //     scale and zero point or one per output channel
+  //  3) Add in the bias term
+  //  4) Apply the ReLU, if fused
+  template <fbgemm::QuantizationGranularity Granularity>
+  static void run_gemm(
+      fbgemm::PackAWithQuantRowOffset<uint8_t>& packA,
+      PackedLinearWeight& pack_ptr,
+      const fbgemm::TensorQuantizationParams& q_params,
+      const float* bias_ptr,
+      int64_t N,
+      at::Tensor& output,
+      at::Tensor& buffer,
+      int task_id,
+      int num_tasks) {
+    // This is the end of the pipeline, pass the resulting matrix through.
+    fbgemm::DoNothing<float, float> doNothingObj{};
+
+    // ReQuantizeForFloat requires pointers to the weight scales and zero
+    // points, since in the case of rowwise quantization these are arrays; for
+    // whole-tensor quantization it won't index past 0.
+    fbgemm::ReQuantizeForFloat<ReluFused, Granularity> outputProcObj(
+        /*nextop=*/doNothingObj,
+        /*Aq_scale=*/q_params.scale,
+        /*Bq_scale=*/pack_ptr.w_scale.data(),
+        /*Aq_zero_point=*/q_params.zero_point,
+        /*Bq_zero_point=*/pack_ptr.w_zp.data(),
+        /*row_offsets=*/packA.getRowOffsetBuffer(),
+        /*col_offsets=*/pack_ptr.col_offsets.data(),
+        /*bias=*/bias_ptr,
+        /*nCol=*/N);
+
+    // Do the GEMM
+    fbgemm::fbgemmPacked(
+        /*packA=*/packA,
+        /*packB=*/*pack_ptr.w,
+        /*C=*/output.data_ptr<float>(),
+        /*C_buffer=*/buffer.data_ptr<int32_t>(),
+        /*ldc=*/N,
+        /*outProcess=*/outputProcObj,
+        /*thread_id=*/task_id,
+        /*num_threads=*/num_tasks);
+  }
+
+ public:
   at::Tensor operator()(
       at::Tensor input,
       at::Tensor packed_weight) {
@@ -43,8 +91,6 @@ class QLinearDynamicInt8 final : public torch::OperatorKernel {
     auto packB = pack_ptr.w.get();
     // packB->printPackedMatrix("packedB inside fbgemm_linear_dynamic
     // (QLinearDynamicInt8): ");
-    auto& col_offsets = pack_ptr.col_offsets;
-
     int64_t N = static_cast<int64_t>(packB->numCols());
     int64_t K = input.size(input.dim() - 1);
     TORCH_CHECK(
@@ -75,39 +121,6 @@ class QLinearDynamicInt8 final : public torch::OperatorKernel {
 
     q_params.precision = precision;
 
-    // This operation does the following:
-    // 1) Quantizes the input matrix given the statistics we've calculated above
-    // 2) Creates a "row buffer" vector with offset values that must be added
-    //    to the integer matrix multiplication operation to ensure correctness.
-    //    This "row buffer" is also called the row offset, and it is needed when
-    //    we use affine quantization for weights.
-    // 3) Packs the resulting quantized matrix into vector-register and cache
-    //    friendly tiles.
-    //
-    //  Note this is not executed eagerly, but rather within the fbgemmPacked
-    //  call below.
-
-    fbgemm::PackAWithQuantRowOffset<uint8_t> packA(
-        /*trans=*/fbgemm::matrix_op_t::NoTranspose,
-        /*nRow=*/M,
-        /*nCol=*/K,
-        /*smat=*/input_ptr,
-        /*ld=*/K,
-        /*pmat=*/nullptr, // Currently, packA manages ownership of `pmat`.
-        /*scale=*/q_params.scale,
-        /*zero_pt=*/q_params.zero_point);
-    // TODO: Consider a way to pre-allocate and reuse
-    // pmat buffer.
-
-    // ReQuantizeForFloat requires pointers to the zero point values,
-    // since in the case of rowwise quantization these will be arrays rather
-    // than scalars. But in this case, we're doing whole-tensor quantization so
-    // we just pass a pointer to the scale values (and internally
-    // ReQuantizeForFloat won't index past 0.
-
-    // This is the end of the pipeline, pass the resulting matrix through.
-    fbgemm::DoNothing<float, float> doNothingObj{};
-
     const float* bias_ptr = nullptr;
     at::Tensor bias_vec;
     if (pack_ptr.bias.has_value()) {
@@ -117,8 +130,8 @@ class QLinearDynamicInt8 final : public torch::OperatorKernel {
           bias_vec.size(0) == N,
           "bias should have N elements: " + std::to_string(N));
       // TODO: contiguous is called for further jit optimizations.
-      auto bias_contig = bias_vec.contiguous();
-      bias_ptr = bias_contig.data_ptr<float>();
+      bias_vec = bias_vec.contiguous();
+      bias_ptr = bias_vec.data_ptr<float>();
     }
     // The resulting matrix here is 2-D, let's view it with the original
     // left hand dimensions of the input. Here are two examples:
@@ -130,73 +143,49 @@ class QLinearDynamicInt8 final : public torch::OperatorKernel {
     auto output = at::empty(out_sizes, input.options().dtype(at::kFloat));
     auto buffer = at::empty_like(output, output.options().dtype(at::kInt));
 
-    if (pack_ptr.q_scheme == kPerTensorAffine) {
-      // Process the per tensor quantization.
-      //
-      // After the uint8 * int8 matrix multiplication is performed, this
-      // operation does:
-      //  1) Add in row and column offsets to the rows and columns, respectively
-      //  2) Dequantize the results into floating point
-      //  3) Add in the bias term.
-      fbgemm::ReQuantizeForFloat<ReluFused> outputProcObj(
-          /*nextop=*/doNothingObj,
-          /*Aq_scale=*/q_params.scale,
-          /*Bq_scale=*/pack_ptr.w_scale.data(),
-          /*Aq_zero_point=*/q_params.zero_point,
-          /*Bq_zero_point=*/pack_ptr.w_zp.data(),
-          /*row_offsets=*/packA.getRowOffsetBuffer(),
-          /*col_offsets=*/col_offsets.data(),
-          /*bias=*/bias_ptr,
-          /*nCol=*/N);
-
-      // Do the GEMM
-      fbgemm::fbgemmPacked(
-          /*packA=*/packA,
-          /*packB=*/*packB,
-          /*C=*/output.data_ptr<float>(),
-          /*C_buffer=*/buffer.data_ptr<int32_t>(),
-          /*ldc=*/N,
-          /*outProcess=*/outputProcObj,
-          /*thread_id=*/0,
-          /*num_threads=*/1);
-
-    } else if (pack_ptr.q_scheme == kPerChannelAffine) {
-      // Process the per channel quantization.
-      //
-      // After the uint8 * int8 matrix multiplication is performed, this
-      // operation does:
-      //  1) Add in row and column offsets to the rows and columns, respectively
-      //  2) Dequantize the results into floating point
-      //  3) Add in the bias term.
-      fbgemm::ReQuantizeForFloat<
-          ReluFused,
-          fbgemm::QuantizationGranularity::OUT_CHANNEL>
-          outputProcObj(
-              /*nextop=*/doNothingObj,
-              /*Aq_scale=*/q_params.scale,
-              /*Bq_scale=*/pack_ptr.w_scale.data(),
-              /*Aq_zero_point=*/q_params.zero_point,
-              /*Bq_zero_point=*/pack_ptr.w_zp.data(),
-              /*row_offsets=*/packA.getRowOffsetBuffer(),
-              /*col_offsets=*/col_offsets.data(),
-              /*bias=*/bias_ptr,
-              /*nCol=*/N);
-
-      // Do the GEMM
-      fbgemm::fbgemmPacked(
-          /*packA=*/packA,
-          /*packB=*/*packB,
-          /*C=*/output.data_ptr<float>(),
-          /*C_buffer=*/buffer.data_ptr<int32_t>(),
-          /*ldc=*/N,
-          /*outProcess=*/outputProcObj,
-          /*thread_id=*/0,
-          /*num_threads=*/1);
-    }
+    int num_tasks = at::get_num_threads();
+    at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+      for (int task_id = begin; task_id < end; ++task_id) {
+        // This operation does the following:
+        // 1) Quantizes the input matrix given the statistics we've calculated
+        //    above
+        // 2) Creates a "row buffer" vector with offset values that must be
+        //    added to the integer matrix multiplication operation to ensure
+        //    correctness. This "row buffer" is also called the row offset, and
+        //    it is needed when we use affine quantization for weights.
+        // 3) Packs the resulting quantized matrix into vector-register and
+        //    cache friendly tiles.
+        //
+        //  Note this is not executed eagerly, but rather within the
+        //  fbgemmPacked call below, and only for the rows of this task.
+        fbgemm::PackAWithQuantRowOffset<uint8_t> packA(
+            /*trans=*/fbgemm::matrix_op_t::NoTranspose,
+            /*nRow=*/M,
+            /*nCol=*/K,
+            /*smat=*/input_ptr,
+            /*ld=*/K,
+            /*pmat=*/nullptr, // Currently, packA manages ownership of `pmat`.
+            /*scale=*/q_params.scale,
+            /*zero_pt=*/q_params.zero_point);
+        // TODO: Consider a way to pre-allocate and reuse
+        // pmat buffer.
+
+        if (pack_ptr.q_scheme == kPerTensorAffine) {
+          run_gemm<fbgemm::QuantizationGranularity::TENSOR>(
+              packA, pack_ptr, q_params, bias_ptr, N, output, buffer, task_id,
+              num_tasks);
+        } else if (pack_ptr.q_scheme == kPerChannelAffine) {
+          run_gemm<fbgemm::QuantizationGranularity::OUT_CHANNEL>(
+              packA, pack_ptr, q_params, bias_ptr, N, output, buffer, task_id,
+              num_tasks);
+        }
+      }
+    });
 
     return output;
   }
 #else // USE_FBGEMM
+ public:
   at::Tensor operator()(
       at::Tensor /* input */,
       at::Tensor /* packed_weight */) {
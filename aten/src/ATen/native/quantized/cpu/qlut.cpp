@@ -0,0 +1,47 @@
+#include <ATen/ATen.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+#include <ATen/quantized/Quantizer.h>
+
+#include <array>
+
+namespace at {
+namespace native {
+
+DEFINE_DISPATCH(qlut_stub);
+
+Tensor quantized_lut_op(
+    const Tensor& qx,
+    double output_scale,
+    int64_t output_zero_point,
+    const std::function<float(float)>& fn) {
+  TORCH_CHECK(
+      qx.scalar_type() == kQUInt8 || qx.scalar_type() == kQInt8,
+      "Only 8-bit quantized tensors are supported, got ",
+      toString(qx.scalar_type()));
+  TORCH_CHECK(
+      qx.qscheme() == kPerTensorAffine,
+      "Only per tensor affine quantized tensors are supported");
+  const auto input_scale = qx.q_scale();
+  const auto input_zero_point = qx.q_zero_point();
+  Tensor qy = at::_empty_affine_quantized(
+      qx.sizes(),
+      qx.options(),
+      output_scale,
+      output_zero_point,
+      qx.suggest_memory_format());
+  std::array<uint8_t, 256> table;
+  AT_DISPATCH_QINT_TYPES(qx.scalar_type(), "quantized_lut_op", [&]() {
+    for (int i = 0; i < 256; ++i) {
+      // The raw value whose bits, read as uint8_t, are i.
+      const auto value = static_cast<underlying_t>(static_cast<uint8_t>(i));
+      const float x = (static_cast<int64_t>(value) - input_zero_point) * input_scale;
+      table[i] = static_cast<uint8_t>(
+          quantize_val<scalar_t>(output_scale, output_zero_point, fn(x)).val_);
+    }
+  });
+  qlut_stub(qx.device().type(), qx, qy, table.data());
+  return qy;
+}
+
+} // namespace native
+} // namespace at
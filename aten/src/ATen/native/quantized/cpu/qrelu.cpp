@@ -109,6 +109,86 @@ Tensor& quantized_relu_(Tensor& qx) {
   return qx;
 }
 
+#ifdef USE_PYTORCH_QNNPACK
+Tensor qnnpack_leaky_relu(Tensor input, double negative_slope) {
+  TORCH_CHECK(
+      input.ndimension() > 0, "qnnpack_leaky_relu(): Got empty input tensor");
+
+  Tensor input_contig = input.contiguous();
+
+  initQNNPACK();
+
+  size_t num_elems = 1;
+  for (int i = 1; i < input_contig.ndimension(); ++i) {
+    num_elems *= input_contig.size(i);
+  }
+
+  pytorch_qnnp_operator_t qnnpack_operator{nullptr};
+  const pytorch_qnnp_status createStatus =
+      pytorch_qnnp_create_leaky_relu_nc_q8(
+          num_elems /* channels */,
+          negative_slope,
+          input_contig.q_zero_point() /* input zero point */,
+          input_contig.q_scale() /* input scale */,
+          input_contig.q_zero_point() /* output zero point */,
+          input_contig.q_scale() /* output scale */,
+          std::numeric_limits<uint8_t>::min() /* output min */,
+          std::numeric_limits<uint8_t>::max() /* output max */,
+          0 /* flags */,
+          &qnnpack_operator);
+
+  std::unique_ptr<pytorch_qnnp_operator, QnnpackOperatorDeleter>
+      qnnpack_uniq_ptr(qnnpack_operator);
+
+  TORCH_INTERNAL_ASSERT(
+      createStatus == pytorch_qnnp_status_success,
+      "failed to create QNNPACK LeakyRelu operator");
+
+  Tensor qy = at::_empty_affine_quantized(
+      input_contig.sizes(),
+      input.options(),
+      input_contig.q_scale(),
+      input_contig.q_zero_point());
+
+  const pytorch_qnnp_status setupStatus = pytorch_qnnp_setup_leaky_relu_nc_q8(
+      qnnpack_operator,
+      input_contig.size(0) /* batch size */,
+      (uint8_t*)input_contig.data_ptr<c10::quint8>() /* input data */,
+      num_elems /* input stride */,
+      (uint8_t*)qy.data_ptr<c10::quint8>() /* output data */,
+      num_elems /* output stride */);
+  TORCH_INTERNAL_ASSERT(
+      setupStatus == pytorch_qnnp_status_success,
+      "failed to setup QNNPACK LeakyRelu operator");
+
+  pthreadpool_t threadpool = caffe2::mobile_pthreadpool();
+
+  const pytorch_qnnp_status runStatus =
+      pytorch_qnnp_run_operator(qnnpack_operator, threadpool);
+
+  TORCH_INTERNAL_ASSERT(
+      runStatus == pytorch_qnnp_status_success,
+      "failed to run QNNPACK LeakyRelu operator");
+  return qy;
+}
+#endif
+
+Tensor quantized_leaky_relu(const Tensor& qx, Scalar negative_slope) {
+  const auto slope = negative_slope.to<double>();
+  #ifdef USE_PYTORCH_QNNPACK
+  // QNNPACK only handles slopes in (0, 1].
+  if (at::globalContext().qEngine() == at::QEngine::QNNPACK &&
+      qx.scalar_type() == kQUInt8 && slope > 0 && slope <= 1) {
+    return qnnpack_leaky_relu(qx, slope);
+  }
+  #endif
+  // The output keeps the quantization parameters of the input, like relu.
+  return quantized_lut_op(
+      qx, qx.q_scale(), qx.q_zero_point(), [slope](float x) {
+        return x > 0 ? x : static_cast<float>(x * slope);
+      });
+}
+
 namespace {
 Tensor quantized_relu6(const Tensor& qx) {
   Tensor qy;
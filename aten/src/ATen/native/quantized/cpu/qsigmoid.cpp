@@ -0,0 +1,101 @@
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/native/quantized/cpu/init_qnnpack.h>
+#include <ATen/native/quantized/cpu/qnnpack_utils.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
+#include <caffe2/utils/threadpool/ThreadPoolMobile.h>
+
+#include <cmath>
+
+namespace at {
+namespace native {
+
+namespace {
+// The output of sigmoid is in [0, 1], so its quantization parameters are
+// fixed instead of depending on those of the input. QNNPACK requires these for
+// quint8.
+constexpr double kSigmoidOutputScale = 1.0 / 256;
+constexpr int64_t kSigmoidOutputZeroPointQUInt8 = 0;
+constexpr int64_t kSigmoidOutputZeroPointQInt8 = -128;
+} // namespace
+
+#ifdef USE_PYTORCH_QNNPACK
+Tensor qnnpack_sigmoid(Tensor input) {
+  TORCH_CHECK(
+      input.ndimension() > 0, "qnnpack_sigmoid(): Got empty input tensor");
+
+  Tensor input_contig = input.contiguous();
+
+  initQNNPACK();
+
+  size_t num_elems = 1;
+  for (int i = 1; i < input_contig.ndimension(); ++i) {
+    num_elems *= input_contig.size(i);
+  }
+
+  pytorch_qnnp_operator_t qnnpack_operator{nullptr};
+  const pytorch_qnnp_status createStatus = pytorch_qnnp_create_sigmoid_nc_q8(
+      num_elems /* channels */,
+      input_contig.q_zero_point() /* input zero point */,
+      input_contig.q_scale() /* input scale */,
+      kSigmoidOutputZeroPointQUInt8 /* output zero point */,
+      kSigmoidOutputScale /* output scale */,
+      std::numeric_limits<uint8_t>::min() /* output min */,
+      std::numeric_limits<uint8_t>::max() /* output max */,
+      0 /* flags */,
+      &qnnpack_operator);
+
+  std::unique_ptr<pytorch_qnnp_operator, QnnpackOperatorDeleter>
+      qnnpack_uniq_ptr(qnnpack_operator);
+
+  TORCH_INTERNAL_ASSERT(
+      createStatus == pytorch_qnnp_status_success,
+      "failed to create QNNPACK Sigmoid operator");
+
+  Tensor qy = at::_empty_affine_quantized(
+      input_contig.sizes(),
+      input.options(),
+      kSigmoidOutputScale,
+      kSigmoidOutputZeroPointQUInt8);
+
+  const pytorch_qnnp_status setupStatus = pytorch_qnnp_setup_sigmoid_nc_q8(
+      qnnpack_operator,
+      input_contig.size(0) /* batch size */,
+      (uint8_t*)input_contig.data_ptr<c10::quint8>() /* input data */,
+      num_elems /* input stride */,
+      (uint8_t*)qy.data_ptr<c10::quint8>() /* output data */,
+      num_elems /* output stride */);
+  TORCH_INTERNAL_ASSERT(
+      setupStatus == pytorch_qnnp_status_success,
+      "failed to setup QNNPACK Sigmoid operator");
+
+  pthreadpool_t threadpool = caffe2::mobile_pthreadpool();
+
+  const pytorch_qnnp_status runStatus =
+      pytorch_qnnp_run_operator(qnnpack_operator, threadpool);
+
+  TORCH_INTERNAL_ASSERT(
+      runStatus == pytorch_qnnp_status_success,
+      "failed to run QNNPACK Sigmoid operator");
+  return qy;
+}
+#endif // USE_PYTORCH_QNNPACK
+
+Tensor quantized_sigmoid(const Tensor& qx) {
+#ifdef USE_PYTORCH_QNNPACK
+  if (at::globalContext().qEngine() == at::QEngine::QNNPACK &&
+      qx.scalar_type() == kQUInt8) {
+    return qnnpack_sigmoid(qx);
+  }
+#endif // USE_PYTORCH_QNNPACK
+  const int64_t output_zero_point = qx.scalar_type() == kQInt8
+      ? kSigmoidOutputZeroPointQInt8
+      : kSigmoidOutputZeroPointQUInt8;
+  return quantized_lut_op(
+      qx, kSigmoidOutputScale, output_zero_point, [](float x) {
+        return 1.f / (1.f + std::exp(-x));
+      });
+}
+
+} // namespace native
+} // namespace at
@@ -2,6 +2,9 @@
 #include <ATen/native/DispatchStub.h>
 #include <ATen/native/TensorIterator.h>
 
+#include <functional>
+#include <vector>
+
 namespace at {
 namespace native {
 
@@ -73,6 +76,46 @@ using qcat_nhwc_fn = Tensor (*)(
     double scale,
     int64_t zero_point);
 using qtopk_fn = void(*)(Tensor&, Tensor&, const Tensor&, int64_t, int64_t, bool, bool);
+using qembedding_bag_4bit_fn = void (*)(
+    const Tensor& weight, // 4-bit rowwise quantized, see qembeddingbag.cpp
+    const Tensor& indices, // contiguous int32 or int64, checked
+    const Tensor& offsets, // contiguous int64, checked
+    const Tensor& per_sample_weights, // contiguous float, or undefined
+    bool normalize_by_lengths,
+    Tensor& output);
+// Dequantizes the rows of the `bits` (8 or 4) rowwise quantized weight selected
+// by indices into the rows of the contiguous float or half output.
+using qembedding_lookup_fn = void (*)(
+    const Tensor& weight, // rowwise quantized, see qembeddingbag.cpp
+    const Tensor& indices, // contiguous int32 or int64, checked
+    int64_t bits,
+    Tensor& output);
+// Maps every element of an 8-bit qx through a table indexed by its raw value,
+// writing into the preallocated qy.
+using qlut_fn =
+    void (*)(const Tensor& qx, Tensor& qy, const uint8_t* table);
+// qy = alpha[c] * (qx - zero_point(qx)) + beta[c] over the channels (dim 1) of
+// the contiguous qx, with alpha and beta in units of the output scale.
+using qbatch_norm_fn = void (*)(
+    const Tensor& qx,
+    const float* alpha,
+    const float* beta,
+    Tensor& qy);
+// Per channel affine (de)quantization along `axis` between rtensor and the
+// preallocated qtensor of the same sizes, both either contiguous or, for axis 1
+// of a 4-d tensor, both channels last.
+using quantize_tensor_per_channel_affine_fn = void (*)(
+    const Tensor& rtensor,
+    Tensor& qtensor,
+    const std::vector<double>& scales,
+    const std::vector<int64_t>& zero_points,
+    int64_t axis);
+using dequantize_tensor_per_channel_affine_fn = void (*)(
+    const Tensor& qtensor,
+    Tensor& rtensor,
+    const std::vector<double>& scales,
+    const std::vector<int64_t>& zero_points,
+    int64_t axis);
 
 // using qavg_pool2d_fn
 DECLARE_DISPATCH(qrelu_fn, qrelu_stub);
@@ -86,6 +129,25 @@ DECLARE_DISPATCH(qupsample_bilinear2d_fn, qupsample_bilinear2d_nhwc_stub);
 DECLARE_DISPATCH(qcat_nhwc_fn, qcat_nhwc_stub);
 DECLARE_DISPATCH(qcat_nhwc_fn, qcat_relu_nhwc_stub);
 DECLARE_DISPATCH(qtopk_fn, qtopk_stub);
+DECLARE_DISPATCH(qembedding_bag_4bit_fn, qembedding_bag_4bit_stub);
+DECLARE_DISPATCH(qembedding_lookup_fn, qembedding_lookup_stub);
+DECLARE_DISPATCH(qlut_fn, qlut_stub);
+DECLARE_DISPATCH(qbatch_norm_fn, qbatch_norm_stub);
+DECLARE_DISPATCH(
+    quantize_tensor_per_channel_affine_fn,
+    quantize_tensor_per_channel_affine_stub);
+DECLARE_DISPATCH(
+    dequantize_tensor_per_channel_affine_fn,
+    dequantize_tensor_per_channel_affine_stub);
+
+// Returns fn applied to every element of the 8-bit quantized qx, quantized
+// with the given output scale and zero point. Since qx has at most 256
+// distinct values, fn is evaluated once per value to build a lookup table.
+Tensor quantized_lut_op(
+    const Tensor& qx,
+    double output_scale,
+    int64_t output_zero_point,
+    const std::function<float(float)>& fn);
 
 } // namespace native
 } // namespace at
@@ -352,6 +352,82 @@ SparseTensor& copy_sparse_(SparseTensor& self, const SparseTensor& src, bool non
   return self._coalesced_(src.is_coalesced());
 }
 
+namespace {
+
+// Splits [0, n) into chunks of at least grain_size elements, at most one per
+// thread, so that the chunks of a parallel pass can be processed in the same
+// order by a later pass.
+int64_t num_chunks_for(int64_t n, int64_t grain_size) {
+  int64_t max_chunks = (n + grain_size - 1) / grain_size;
+  return std::max<int64_t>(1, std::min<int64_t>(at::get_num_threads(), max_chunks));
+}
+
+// Sorts keys in [0, max_key) with a parallel least significant digit radix
+// sort: every pass counts the digits of each chunk, computes where each chunk
+// writes each digit and scatters the chunks in parallel.  The sort is stable.
+// Returns the sorted keys and the permutation that sorts them, like sort(0).
+std::tuple<LongTensor, LongTensor> radix_sort_parallel(const LongTensor& keys_, int64_t max_key) {
+  constexpr int64_t kRadixBits = 8;
+  constexpr int64_t kRadix = 1 << kRadixBits;
+  int64_t n = keys_.numel();
+  LongTensor keys = keys_.contiguous();
+  LongTensor permutation = at::empty({n}, keys.options());
+  LongTensor keys_buffer = at::empty({n}, keys.options());
+  LongTensor permutation_buffer = at::empty({n}, keys.options());
+
+  int64_t num_chunks = num_chunks_for(n, at::internal::GRAIN_SIZE);
+  int64_t chunk_size = (n + num_chunks - 1) / num_chunks;
+
+  int64_t* permutation_ptr = permutation.data_ptr<int64_t>();
+  at::parallel_for(0, n, at::internal::GRAIN_SIZE, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
+      permutation_ptr[i] = i;
+    }
+  });
+
+  std::vector<int64_t> offsets(num_chunks * kRadix);
+  for (int64_t shift = 0; shift < 63 && (max_key - 1) >> shift > 0; shift += kRadixBits) {
+    const int64_t* keys_in = keys.data_ptr<int64_t>();
+    const int64_t* permutation_in = permutation.data_ptr<int64_t>();
+    int64_t* keys_out = keys_buffer.data_ptr<int64_t>();
+    int64_t* permutation_out = permutation_buffer.data_ptr<int64_t>();
+
+    at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+      for (int64_t c = start; c < end; c++) {
+        int64_t* counts = offsets.data() + c * kRadix;
+        std::fill(counts, counts + kRadix, 0);
+        for (int64_t i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); i++) {
+          counts[(keys_in[i] >> shift) & (kRadix - 1)]++;
+        }
+      }
+    });
+    // the elements of a digit are written chunk after chunk
+    int64_t offset = 0;
+    for (int64_t digit = 0; digit < kRadix; digit++) {
+      for (int64_t c = 0; c < num_chunks; c++) {
+        int64_t count = offsets[c * kRadix + digit];
+        offsets[c * kRadix + digit] = offset;
+        offset += count;
+      }
+    }
+    at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+      for (int64_t c = start; c < end; c++) {
+        int64_t* chunk_offsets = offsets.data() + c * kRadix;
+        for (int64_t i = c * chunk_size; i < std::min(n, (c + 1) * chunk_size); i++) {
+          int64_t pos = chunk_offsets[(keys_in[i] >> shift) & (kRadix - 1)]++;
+          keys_out[pos] = keys_in[i];
+          permutation_out[pos] = permutation_in[i];
+        }
+      }
+    });
+    std::swap(keys, keys_buffer);
+    std::swap(permutation, permutation_buffer);
+  }
+  return std::make_tuple(keys, permutation);
+}
+
+} // namespace
+
 SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   AT_ASSERT(self.defined());
   AT_ASSERT(!self.is_variable());  // TODO: change this to check `.requires_grad()` and `GradMode::is_enabled()` when Variable and Tensor are merged
@@ -375,6 +451,10 @@ SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
   int64_t nnz = self._nnz();
 
   LongTensor indices_scalar = flatten_indices(indices, self.sizes());
+  int64_t max_key = 1;
+  for (int64_t d = 0; d < sparse_dim; d++) {
+    max_key *= self.size(d);
+  }
 
   SparseTensor dst = new_sparse(self.options());
   get_sparse_impl(dst)->resize_(sparse_dim, dense_dim, self.sizes());
@@ -385,42 +465,64 @@ SparseTensor coalesce_sparse_cpu(const SparseTensor& self) {
 
   LongTensor indicesBuffer;
   LongTensor indicesPermutation;
-  std::tie(indicesBuffer, indicesPermutation) = indices_scalar.sort(0);
+  std::tie(indicesBuffer, indicesPermutation) = radix_sort_parallel(indices_scalar, max_key);
   // NB: The accessor accesses here rely on self._nnz() > 0 (tested earlier in this function)
   auto newIndicesAccessor = newIndices.accessor<int64_t, 2>();
   auto indicesAccessor = indices.accessor<int64_t, 2>();
-  auto indicesPermutationAccessor = indicesPermutation.accessor<int64_t, 1>();
-  auto indicesBufferAccessor = indicesBuffer.accessor<int64_t, 1>();
+  const int64_t* permutation = indicesPermutation.data_ptr<int64_t>();
+  const int64_t* sorted = indicesBuffer.data_ptr<int64_t>();
+
+  // Segmented reduction of the sorted values: every chunk sums the runs of
+  // equal indices starting in it into their output positions, found by a
+  // prefix sum of the number of runs starting in each chunk.
+  int64_t num_chunks = num_chunks_for(nnz, at::internal::GRAIN_SIZE);
+  int64_t chunk_size = (nnz + num_chunks - 1) / num_chunks;
+  std::vector<int64_t> chunk_offsets(num_chunks + 1, 0);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+    for (int64_t c = start; c < end; c++) {
+      int64_t runs = 0;
+      for (int64_t j = c * chunk_size; j < std::min(nnz, (c + 1) * chunk_size); j++) {
+        runs += (j == 0 || sorted[j] != sorted[j - 1]);
+      }
+      chunk_offsets[c + 1] = runs;
+    }
+  });
+  for (int64_t c = 0; c < num_chunks; c++) {
+    chunk_offsets[c + 1] += chunk_offsets[c];
+  }
+  int64_t newNnz = chunk_offsets[num_chunks];
 
-  int64_t i = -1;
   AT_DISPATCH_ALL_TYPES(
       values.scalar_type(), "coalesce", [&] {
-        int64_t prev = -1;
         int64_t blockSize = values.stride(0);
         scalar_t* values_ptr = values.data_ptr<scalar_t>();
         scalar_t* newValues_ptr = newValues.data_ptr<scalar_t>();
-        for (int64_t j = 0; j < nnz; j++) {
-          int64_t pos = indicesPermutationAccessor[j];
-          int64_t curr = indicesBufferAccessor[j];
-          if (curr == prev) {
-            if (values.numel() > 0) {  // if values is an empty tensor, there are no elements to copy
-              THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
-            }
-          } else {
-            ++i;
-            for (int64_t d = 0; d < sparse_dim; d++) {
-              newIndicesAccessor[d][i] = indicesAccessor[d][pos];
-            }
-            if (values.numel() > 0) {  // if values is an empty tensor, there are no elements to copy
-              THBlas_copy<scalar_t>(blockSize, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
+        at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+          for (int64_t c = start; c < end; c++) {
+            int64_t i = chunk_offsets[c] - 1;
+            for (int64_t j = c * chunk_size; j < std::min(nnz, (c + 1) * chunk_size); j++) {
+              if (j > 0 && sorted[j] == sorted[j - 1]) {
+                continue;
+              }
+              ++i;
+              int64_t pos = permutation[j];
+              for (int64_t d = 0; d < sparse_dim; d++) {
+                newIndicesAccessor[d][i] = indicesAccessor[d][pos];
+              }
+              if (values.numel() > 0) {  // if values is an empty tensor, there are no elements to copy
+                THBlas_copy<scalar_t>(blockSize, values_ptr + pos * blockSize, 1, newValues_ptr + i * blockSize, 1);
+                // the run may continue past the end of the chunk
+                for (int64_t k = j + 1; k < nnz && sorted[k] == sorted[j]; k++) {
+                  THBlas_axpy<scalar_t>(blockSize, 1, values_ptr + permutation[k] * blockSize, 1, newValues_ptr + i * blockSize, 1);
+                }
+              }
             }
           }
-          prev = curr;
-        }
+        });
     });
 
   dst._coalesced_(true);
-  get_sparse_impl(dst)->set_nnz_and_narrow(i + 1);
+  get_sparse_impl(dst)->set_nnz_and_narrow(newNnz);
 
   return dst;
 }
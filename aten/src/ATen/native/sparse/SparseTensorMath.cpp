@@ -230,6 +230,102 @@ Tensor& sub_out_sparse(Tensor& r, const Tensor& self, const Tensor& other, Scala
 
 Tensor& add_out_dense_sparse_cpu(Tensor& r, const Tensor& dense, const SparseTensor& sparse_, Scalar value);
 
+// Adds value * s to t, both coalesced, into the zero-initialized r_values
+// (and r_indices) in parallel, returning the number of entries of the
+// (coalesced) result.  The entries of the larger tensor are split into a chunk
+// per thread and the other tensor into the same ranges of flattened indices by
+// binary search, so that equal indices fall in the same chunk and the chunks
+// are merged independently.  A first pass counts the entries of every chunk
+// to find where the second one writes them.
+static int64_t add_out_sparse_coalesced_cpu(const LongTensor& r_indices, const Tensor& r_values, const LongTensor& t_indices, const Tensor& t_values, const LongTensor& s_indices, const Tensor& s_values, Scalar value, IntArrayRef sizes) {
+  int64_t sparse_dim = t_indices.size(0);
+  int64_t t_nnz = t_indices.size(1), s_nnz = s_indices.size(1);
+  LongTensor t_keys_tensor = flatten_indices(t_indices, sizes).contiguous();
+  LongTensor s_keys_tensor = flatten_indices(s_indices, sizes).contiguous();
+  const int64_t* t_keys = t_keys_tensor.data_ptr<int64_t>();
+  const int64_t* s_keys = s_keys_tensor.data_ptr<int64_t>();
+
+  int64_t max_chunks = (t_nnz + s_nnz + at::internal::GRAIN_SIZE - 1) / at::internal::GRAIN_SIZE;
+  int64_t num_chunks = std::max<int64_t>(1, std::min<int64_t>(at::get_num_threads(), max_chunks));
+  std::vector<int64_t> t_splits(num_chunks + 1, 0), s_splits(num_chunks + 1, 0);
+  t_splits[num_chunks] = t_nnz;
+  s_splits[num_chunks] = s_nnz;
+  for (int64_t c = 1; c < num_chunks; c++) {
+    if (t_nnz >= s_nnz) {
+      t_splits[c] = c * t_nnz / num_chunks;
+      s_splits[c] = std::lower_bound(s_keys, s_keys + s_nnz, t_keys[t_splits[c]]) - s_keys;
+    } else {
+      s_splits[c] = c * s_nnz / num_chunks;
+      t_splits[c] = std::lower_bound(t_keys, t_keys + t_nnz, s_keys[s_splits[c]]) - t_keys;
+    }
+  }
+
+  std::vector<int64_t> r_offsets(num_chunks + 1, 0);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+    for (int64_t c = start; c < end; c++) {
+      int64_t t_i = t_splits[c], s_i = s_splits[c], count = 0;
+      while (t_i < t_splits[c + 1] && s_i < s_splits[c + 1]) {
+        int64_t t_key = t_keys[t_i], s_key = s_keys[s_i];
+        t_i += t_key <= s_key;
+        s_i += s_key <= t_key;
+        count++;
+      }
+      r_offsets[c + 1] = count + (t_splits[c + 1] - t_i) + (s_splits[c + 1] - s_i);
+    }
+  });
+  for (int64_t c = 0; c < num_chunks; c++) {
+    r_offsets[c + 1] += r_offsets[c];
+  }
+
+  auto t_indices_accessor = t_indices.accessor<int64_t, 2>();
+  auto s_indices_accessor = s_indices.accessor<int64_t, 2>();
+  auto r_indices_accessor = r_indices.accessor<int64_t, 2>();
+  AT_DISPATCH_ALL_TYPES(
+      t_values.scalar_type(), "cadd_sparse", [&] {
+        int64_t blockSize = r_values.stride(0);
+        scalar_t* t_values_ptr = t_values.data_ptr<scalar_t>();
+        scalar_t* s_values_ptr = s_values.data_ptr<scalar_t>();
+        scalar_t* r_values_ptr = r_values.data_ptr<scalar_t>();
+        scalar_t cast_value = value.to<scalar_t>();
+        at::parallel_for(0, num_chunks, 1, [&](int64_t start, int64_t end) {
+          for (int64_t c = start; c < end; c++) {
+            int64_t t_i = t_splits[c], s_i = s_splits[c], r_i = r_offsets[c];
+            while (t_i < t_splits[c + 1] || s_i < s_splits[c + 1]) {
+              bool take_t = s_i >= s_splits[c + 1] ||
+                  (t_i < t_splits[c + 1] && t_keys[t_i] <= s_keys[s_i]);
+              bool take_s = t_i >= t_splits[c + 1] ||
+                  (s_i < s_splits[c + 1] && s_keys[s_i] <= t_keys[t_i]);
+              if (take_t) {
+                for (int64_t d = 0; d < sparse_dim; d++) {
+                  r_indices_accessor[d][r_i] = t_indices_accessor[d][t_i];
+                }
+                if (t_values.numel() > 0) {
+                  THBlas_axpy<scalar_t>(blockSize, 1,
+                    t_values_ptr + t_i * blockSize, 1,
+                    r_values_ptr + r_i * blockSize, 1);
+                }
+                t_i++;
+              }
+              if (take_s) {
+                for (int64_t d = 0; d < sparse_dim; d++) {
+                  r_indices_accessor[d][r_i] = s_indices_accessor[d][s_i];
+                }
+                if (s_values.numel() > 0) {
+                  THBlas_axpy<scalar_t>(blockSize, cast_value,
+                    s_values_ptr + s_i * blockSize, 1,
+                    r_values_ptr + r_i * blockSize, 1);
+                }
+                s_i++;
+              }
+              r_i++;
+            }
+          }
+        });
+      }
+  );
+  return r_offsets[num_chunks];
+}
+
 SparseTensor& add_out_sparse_cpu(SparseTensor& r, const SparseTensor& t, const SparseTensor& src, Scalar value) {
   if (!t.is_sparse()) {
     return add_out_dense_sparse_cpu(r, t, src, value);
@@ -266,6 +362,12 @@ SparseTensor& add_out_sparse_cpu(SparseTensor& r, const SparseTensor& t, const S
     Tensor r_values = new_values_with_size_of(s_values, max_nnz).zero_();
     get_sparse_impl(r)->set_indices_and_values_unsafe(r_indices, r_values);
 
+    if (t_coalesced && s_coalesced) {
+      get_sparse_impl(r)->set_nnz_and_narrow(add_out_sparse_coalesced_cpu(
+          r_indices, r_values, t_indices, t_values, src_indices, s_values, value, src.sizes()));
+      return r._coalesced_(true);
+    }
+
     int64_t blockSize = r_values.stride(0);
     int64_t cmp, d;
     int64_t r_i = 0, t_i = 0, s_i = 0;
@@ -534,11 +636,7 @@ SparseTensor& mul_out_sparse_cpu(SparseTensor& r, const Tensor& t_, const Tensor
 // --------------------------------------------------------------------
 
 template <typename scalar_t>
-void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& indices, const Tensor& values, const Tensor& dense) {
-  int64_t i;
-
-  // r_ = alpha * sparse * dense
-  scalar_t cast_alpha = alpha.to<scalar_t>();
+void s_addmm_scale_result(Tensor& r, Scalar beta, const Tensor& t) {
   scalar_t cast_beta = beta.to<scalar_t>();
   if (cast_beta == 0) {
     r.zero_();
@@ -549,6 +647,15 @@ void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j,
   } else {
     at::mul_out(r, t, scalar_to_tensor(beta));
   }
+}
+
+template <typename scalar_t>
+void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& indices, const Tensor& values, const Tensor& dense) {
+  int64_t i;
+
+  // r_ = alpha * sparse * dense
+  scalar_t cast_alpha = alpha.to<scalar_t>();
+  s_addmm_scale_result<scalar_t>(r, beta, t);
 
   auto indices_accessor = indices.accessor<int64_t, 2>();
 
@@ -579,6 +686,81 @@ void s_addmm_out_sparse_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_j,
   }
 };
 
+// Returns the CSR row offsets of a coalesced matrix, computing them on first
+// use and caching them on the tensor.  The indices are bounds checked when
+// computing them, so the kernels reading the cached ones don't have to.
+static LongTensor csr_crow_indices_cpu(const SparseTensor& sparse) {
+  auto impl = get_sparse_impl(sparse);
+  LongTensor crow_indices = impl->csr_indices().first;
+  if (crow_indices.defined()) {
+    return crow_indices;
+  }
+
+  int64_t dim_i = sparse.size(0);
+  int64_t dim_j = sparse.size(1);
+  int64_t nnz = sparse._nnz();
+  LongTensor indices = sparse._indices();
+  auto indices_accessor = indices.accessor<int64_t, 2>();
+  crow_indices = at::zeros({dim_i + 1}, indices.options());
+  auto crow_accessor = crow_indices.accessor<int64_t, 1>();
+  for (int64_t i = 0; i < nnz; i++) {
+    int64_t row = indices_accessor[0][i];
+    int64_t col = indices_accessor[1][i];
+    if (col < 0 || col >= dim_j) {
+      AT_ERROR("addmm: index out of column bound: ", col, " not between 1 and ", dim_j);
+    } else if (row < 0 || row >= dim_i) {
+      AT_ERROR("addmm: index out of row bound: ", row, " not between 1 and ", dim_i);
+    }
+    crow_accessor[row + 1]++;
+  }
+  for (int64_t row = 0; row < dim_i; row++) {
+    crow_accessor[row + 1] += crow_accessor[row];
+  }
+  impl->set_csr_indices(crow_indices, indices.select(0, 1));
+  return crow_indices;
+}
+
+// Row-parallel product of a coalesced matrix in CSR form, every thread writes
+// its own rows of r.  A dense matrix with a single column (a matrix-vector
+// product) is handled by a dot product per row.
+template <typename scalar_t>
+void s_addmm_out_sparse_csr_dense_worker(int64_t nnz, int64_t dim_i, int64_t dim_k, Tensor& r, Scalar beta, const Tensor& t, Scalar alpha, const Tensor& crow_indices, const Tensor& indices, const Tensor& values, const Tensor& dense) {
+  scalar_t cast_alpha = alpha.to<scalar_t>();
+  s_addmm_scale_result<scalar_t>(r, beta, t);
+
+  auto crow_accessor = crow_indices.accessor<int64_t, 1>();
+  auto indices_accessor = indices.accessor<int64_t, 2>();
+  auto values_accessor = values.accessor<scalar_t, 1>();
+  scalar_t* dense_ptr = dense.data_ptr<scalar_t>();
+  scalar_t* r_ptr = r.data_ptr<scalar_t>();
+
+  int64_t dense_stride0 = dense.stride(0);
+  int64_t dense_stride1 = dense.stride(1);
+  int64_t r_stride0 = r.stride(0);
+  int64_t r_stride1 = r.stride(1);
+  int64_t row_work = std::max<int64_t>(1, nnz / std::max<int64_t>(1, dim_i) * dim_k);
+  int64_t grain_size = std::max<int64_t>(1, at::internal::GRAIN_SIZE / row_work);
+  at::parallel_for(0, dim_i, grain_size, [&](int64_t start, int64_t end) {
+    for (int64_t row = start; row < end; row++) {
+      scalar_t* r_row = r_ptr + row * r_stride0;
+      if (dim_k == 1) {
+        scalar_t sum = 0;
+        for (int64_t i = crow_accessor[row]; i < crow_accessor[row + 1]; i++) {
+          sum += values_accessor[i] * dense_ptr[indices_accessor[1][i] * dense_stride0];
+        }
+        *r_row += cast_alpha * sum;
+        continue;
+      }
+      for (int64_t i = crow_accessor[row]; i < crow_accessor[row + 1]; i++) {
+        THBlas_axpy<scalar_t>(dim_k,
+              cast_alpha * values_accessor[i],
+              dense_ptr + indices_accessor[1][i] * dense_stride0, dense_stride1,
+              r_row, r_stride1);
+      }
+    }
+  });
+}
+
 Tensor& s_addmm_out_sparse_dense_cpu(
     Tensor& r,
     const Tensor& t,
@@ -621,11 +803,22 @@ Tensor& s_addmm_out_sparse_dense_cpu(
   LongTensor indices = sparse_._indices();
   Tensor values      = sparse_._values();
 
-  AT_DISPATCH_ALL_TYPES(
-      values.scalar_type(), "addmm_sparse_dense", [&] {
-        s_addmm_out_sparse_dense_worker<scalar_t>(nnz, dim_i, dim_j, dim_k, r, beta, t, alpha, indices, values, dense);
-      }
-  );
+  // Coalesced matrices are multiplied in CSR form, the uncoalesced ones entry
+  // by entry (their duplicate entries are summed into the same rows of r).
+  if (sparse_.is_coalesced()) {
+    LongTensor crow_indices = csr_crow_indices_cpu(sparse_);
+    AT_DISPATCH_ALL_TYPES(
+        values.scalar_type(), "addmm_sparse_dense", [&] {
+          s_addmm_out_sparse_csr_dense_worker<scalar_t>(nnz, dim_i, dim_k, r, beta, t, alpha, crow_indices, indices, values, dense);
+        }
+    );
+  } else {
+    AT_DISPATCH_ALL_TYPES(
+        values.scalar_type(), "addmm_sparse_dense", [&] {
+          s_addmm_out_sparse_dense_worker<scalar_t>(nnz, dim_i, dim_j, dim_k, r, beta, t, alpha, indices, values, dense);
+        }
+    );
+  }
 
   return r;
 
@@ -84,11 +84,19 @@ Tensor& s_addmm_out_sparse_dense_cuda(Tensor& r_, const Tensor& t, const SparseT
   LongTensor indices = sparse._indices();
   Tensor values = sparse._values();
 
-  LongTensor rowIndices = indices.select(0, 0);
-  LongTensor colIndices = indices.select(0, 1);
-  IntTensor csr = _to_csr_int(rowIndices, m, nnz);
-  IntTensor colIndicesInt = at::empty({colIndices.size(0)}, indices.options().dtype(kInt));
-  colIndicesInt.copy_(colIndices);
+  // The CSR form is cached on the coalesced tensor, so multiplying the same
+  // matrix again doesn't convert its indices again.
+  IntTensor csr;
+  IntTensor colIndicesInt;
+  std::tie(csr, colIndicesInt) = get_sparse_impl(sparse)->csr_indices();
+  if (!csr.defined()) {
+    LongTensor rowIndices = indices.select(0, 0);
+    LongTensor colIndices = indices.select(0, 1);
+    csr = _to_csr_int(rowIndices, m, nnz);
+    colIndicesInt = at::empty({colIndices.size(0)}, indices.options().dtype(kInt));
+    colIndicesInt.copy_(colIndices);
+    get_sparse_impl(sparse)->set_csr_indices(csr, colIndicesInt);
+  }
 
   // No half support, so we don't have to use CUDATypeConversion
   Tensor r__;
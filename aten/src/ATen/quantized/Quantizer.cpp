@@ -4,6 +4,7 @@
 #include <ATen/Dispatch.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/native/TensorFactories.h>
+#include <ATen/native/quantized/cpu/quantized_ops.h>
 #include <ATen/quantized/QTensorImpl.h>
 #include <ATen/core/Tensor.h>
 #include <typeinfo>
@@ -17,6 +18,11 @@
 
 namespace at {
 
+namespace native {
+DEFINE_DISPATCH(quantize_tensor_per_channel_affine_stub);
+DEFINE_DISPATCH(dequantize_tensor_per_channel_affine_stub);
+} // namespace native
+
 // Note: this is not a native function as Quantizer is not exposed to python yet
 QuantizerPtr Tensor::quantizer() const {
   // This is a terrible hack to emulate what VariableType is doing
@@ -362,7 +368,6 @@ template CAFFE2_API qint8 requantize_val<qint32, qint8>(double, int64_t, double,
 template CAFFE2_API quint8 requantize_val<qint32, quint8>(double, int64_t, double, int64_t, qint32);
 template CAFFE2_API qint32 requantize_val<qint32, qint32>(double, int64_t, double, int64_t, qint32);
 
-// TODO: add fbgemm for per channel
 template <typename T>
 Tensor quantize_tensor_per_channel_affine(Tensor rtensor,
                                           Tensor qtensor,
@@ -374,23 +379,13 @@ Tensor quantize_tensor_per_channel_affine(Tensor rtensor,
   checkQuantizedCPUTensor<T>(fn_name, qtensor);
   checkZeroPoints<typename T::underlying>(fn_name, zero_points);
   TORCH_CHECK(0 <= axis && axis < rtensor.dim(), "Channel axis out of range in per channel affine quantization.");
-  int64_t batches = size_to_dim_(axis, rtensor.sizes());
-  int64_t elements_per_channel = size_from_dim_(axis + 1, rtensor.sizes());
   int64_t channel = rtensor.size(axis);
   TORCH_CHECK(channel == int64_t(scales.size()),
               "length of scales must equal to channel");
   TORCH_CHECK(channel == int64_t(zero_points.size()),
               "length of zero_points must equal to channel");
-  const float* rdata = rtensor.data_ptr<float>();
-  auto qdata = qtensor.data_ptr<T>();
-  for (auto b = 0; b < batches; ++b) {
-    for (auto c = 0; c < channel; ++c) {
-      for (auto e = 0; e < elements_per_channel; ++e) {
-        auto i = b * channel * elements_per_channel + c * elements_per_channel + e;
-        qdata[i] = quantize_val<T>(scales[c], zero_points[c], rdata[i]);
-      }
-    }
-  }
+  native::quantize_tensor_per_channel_affine_stub(
+      rtensor.device().type(), rtensor, qtensor, scales, zero_points, axis);
   return qtensor;
 }
 
@@ -406,25 +401,13 @@ Tensor dequantize_tensor_per_channel_affine(Tensor qtensor,
   checkZeroPoints<typename T::underlying>(fn_name, zero_points);
   TORCH_CHECK(0 <= axis && axis < qtensor.dim(),
               "Channel axis out of range in per channel affine dequantization.");
-  int64_t batches = size_to_dim_(axis, rtensor.sizes());
-  int64_t elements_per_channel = size_from_dim_(axis + 1, rtensor.sizes());
   int64_t channel = rtensor.size(axis);
   TORCH_CHECK(channel == int64_t(scales.size()),
               "length of scales must equal to channel");
   TORCH_CHECK(channel == int64_t(zero_points.size()),
               "length of zero_points must equal to channel");
-  const auto* qd = qtensor.data_ptr<T>();
-  float* rd = rtensor.data_ptr<float>();
-  for (auto b = 0; b < batches; ++b) {
-    for (auto c = 0; c < channel; ++c) {
-      for (auto e = 0; e < elements_per_channel; ++e) {
-        auto i = b * channel * elements_per_channel + c * elements_per_channel + e;
-        // We need to convert the qint8 value to float to ensure the subtraction
-        // subexpression returns a float
-        rd[i] = (static_cast<float>(qd[i].val_) - zero_points[c]) * scales[c];
-      }
-    }
-  }
+  native::dequantize_tensor_per_channel_affine_stub(
+      qtensor.device().type(), qtensor, rtensor, scales, zero_points, axis);
   return rtensor;
 }
 
@@ -545,6 +528,16 @@ Tensor PerTensorAffineQuantizer::dequantize(Tensor qtensor) {
   return rtensor;
 }
 
+namespace {
+MemoryFormat per_channel_memory_format(const Tensor& tensor, int64_t axis) {
+  if (axis == 1 && tensor.dim() == 4 &&
+      tensor.suggest_memory_format() == MemoryFormat::ChannelsLast) {
+    return MemoryFormat::ChannelsLast;
+  }
+  return MemoryFormat::Contiguous;
+}
+} // namespace
+
 Tensor PerChannelAffineQuantizer::quantize(Tensor rtensor) {
   TORCH_CHECK(
       rtensor.scalar_type() == kFloat,
@@ -554,12 +547,16 @@ Tensor PerChannelAffineQuantizer::quantize(Tensor rtensor) {
       "quantize only works for CPU backend right now.");
   // Here we need a std::intrusive_ptr<Quantizer>.. but actually "this" is the
   // quantizer that can be reused, so I'm using intrusive_from_this here
+  // Channels last tensors quantized along the channels stay channels last,
+  // the kernels handle both layouts.
+  const auto memory_format = per_channel_memory_format(rtensor, axis_);
   Tensor qtensor = new_qtensor_cpu(
       rtensor.sizes(),
       rtensor.options().dtype(scalar_type_),
-      intrusive_from_this());
+      intrusive_from_this(),
+      memory_format);
 
-  rtensor = rtensor.contiguous();
+  rtensor = rtensor.contiguous(memory_format);
   AT_DISPATCH_QINT_TYPES(qtensor.scalar_type(),
                          "quantize_tensor_per_channel_affine",
                          [&]() {
@@ -575,8 +572,12 @@ Tensor PerChannelAffineQuantizer::dequantize(Tensor qtensor) {
   TORCH_CHECK(
       qtensor.device() == kCPU,
       "dequantize only works for CPU backend right now.");
-  Tensor rtensor = at::empty(qtensor.sizes(), qtensor.options().dtype(at::kFloat));
-  qtensor = qtensor.contiguous();
+  const auto memory_format = per_channel_memory_format(qtensor, axis_);
+  Tensor rtensor = at::empty(
+      qtensor.sizes(),
+      qtensor.options().dtype(at::kFloat),
+      memory_format);
+  qtensor = qtensor.contiguous(memory_format);
 
   AT_DISPATCH_QINT_TYPES(qtensor.scalar_type(),
                          "dequantize_tensor_per_channel_affine",
@@ -141,3 +141,25 @@ TEST(ApplyUtilsTest, _10D) {
   manual_seed(123);
   test(CPU(kDouble), {3, 4, 2, 5, 2, 1, 3, 4, 2, 3});
 }
+
+// The elements are visited in the logical order of the tensors, whether the
+// specialized loops or the strided iterators visit them.
+TEST(ApplyUtilsTest, LogicalOrder) {
+  std::vector<Tensor> tensors({
+      at::empty({2, 3, 4}, kDouble),
+      at::empty({2, 3, 4}, kDouble).permute({2, 0, 1}),
+      at::empty({4, 6}, kDouble).narrow(1, 1, 3),
+      // doesn't collapse to at most 4 dimensions
+      at::empty({3, 2, 3, 2, 3, 2}, kDouble).transpose(0, 5).transpose(1, 3),
+  });
+  for (auto& t : tensors) {
+    double next = 0;
+    CPU_tensor_apply1<double>(t, [&next](double& x) { x = next++; });
+    ASSERT_TRUE(t.contiguous().view(-1).equal(at::arange(t.numel(), kDouble)));
+
+    // tensors of different sizes use the strided iterators
+    auto other = at::empty({t.numel()}, kDouble);
+    CPU_tensor_apply2<double, double>(other, t, [](double& y, const double& x) { y = x; });
+    ASSERT_TRUE(other.equal(at::arange(t.numel(), kDouble)));
+  }
+}
@@ -2,6 +2,7 @@
 
 #include <ATen/ATen.h>
 #include <ATen/Utils.h>
+#include <ATen/Parallel.h>
 #include <ATen/CPUGenerator.h>
 #include <ATen/core/PhiloxRNGEngine.h>
 #include <thread>
@@ -196,6 +197,77 @@ TEST(CPUGenerator, TestPhiloxEngineIndex) {
   ASSERT_NE(engine1(), engine2());
 }
 
+TEST(CPUGenerator, TestPhiloxModeUniform) {
+  // Test Description:
+  //   Check that uniform_ in Philox mode takes the bits of a float from
+  //   philox_engine(seed, block, offset), and that the offset of the
+  //   generator then moves past the numbers the blocks consumed.
+  auto gen = at::detail::createCPUGenerator(123);
+  gen->set_philox_mode(true);
+  auto t = at::empty({5000}, at::kFloat).uniform_(0, 1, gen.get());
+  auto offset = gen->philox_offset();
+  ASSERT_GT(offset, 0);
+  auto data = t.data_ptr<float>();
+  at::Philox4_32_10 engine0(123, 0, 0);
+  for (int64_t i = 0; i < 16; i++) {
+    ASSERT_EQ(data[i], (engine0() & ((1 << 24) - 1)) * (1.0f / (1 << 24)));
+  }
+
+  at::Philox4_32_10 engine1(123, 1, 0);
+  ASSERT_EQ(data[offset * 4], (engine1() & ((1 << 24) - 1)) * (1.0f / (1 << 24)));
+
+  t.uniform_(0, 1, gen.get());
+  ASSERT_EQ(gen->philox_offset(), 2 * offset);
+  at::Philox4_32_10 engine2(123, 0, offset);
+  ASSERT_EQ(data[0], (engine2() & ((1 << 24) - 1)) * (1.0f / (1 << 24)));
+}
+
+TEST(CPUGenerator, TestPhiloxModeNumThreads) {
+  // Test Description:
+  //   Check that the numbers of the Philox mode don't depend on the number
+  //   of threads, for contiguous and strided tensors.
+  auto num_threads = at::get_num_threads();
+  std::vector<at::Tensor> results;
+  for (int threads : {1, 4}) {
+    at::set_num_threads(threads);
+    auto gen = at::detail::createCPUGenerator(42);
+    gen->set_philox_mode(true);
+    auto uniform = at::empty({100003}, at::kDouble).uniform_(-2, 3, gen.get());
+    auto normal = at::empty({300, 700}, at::kFloat).t().normal_(1, 2, gen.get());
+    auto bernoulli = at::empty({100003}, at::kByte).bernoulli_(0.3, gen.get());
+    results.push_back(uniform);
+    results.push_back(normal);
+    results.push_back(bernoulli);
+  }
+  at::set_num_threads(num_threads);
+  for (size_t i = 0; i < 3; i++) {
+    ASSERT_TRUE(results[i].equal(results[i + 3]));
+  }
+  ASSERT_GE(results[0].min().item<double>(), -2);
+  ASSERT_LT(results[0].max().item<double>(), 3);
+  ASSERT_NEAR(results[1].mean().item<double>(), 1, 0.05);
+  ASSERT_NEAR(results[1].std().item<double>(), 2, 0.05);
+  ASSERT_NEAR(results[2].to(at::kDouble).mean().item<double>(), 0.3, 0.01);
+}
+
+TEST(CPUGenerator, TestPhiloxModeSeedAndClone) {
+  // Test Description:
+  //   Check that seeding resets the offset and that clones continue with
+  //   the same numbers.
+  auto gen1 = at::detail::createCPUGenerator(7);
+  gen1->set_philox_mode(true);
+  auto a = at::empty({1000}, at::kFloat).normal_(0, 1, gen1.get());
+  auto gen2 = gen1->clone();
+  ASSERT_TRUE(gen2->philox_mode());
+  auto b1 = at::empty({1000}, at::kFloat).normal_(0, 1, gen1.get());
+  auto b2 = at::empty({1000}, at::kFloat).normal_(0, 1, gen2.get());
+  ASSERT_TRUE(b1.equal(b2));
+  ASSERT_FALSE(a.equal(b1));
+  gen1->set_current_seed(7);
+  ASSERT_EQ(gen1->philox_offset(), 0);
+  ASSERT_TRUE(at::empty({1000}, at::kFloat).normal_(0, 1, gen1.get()).equal(a));
+}
+
 /**
  * MT19937 CPU Engine Tests
  */
@@ -0,0 +1,67 @@
+#include <gtest/gtest.h>
+
+#include <ATen/ATen.h>
+#include <ATen/native/PointwiseChain.h>
+
+using namespace at;
+using at::native::PointwiseChain;
+
+TEST(PointwiseChainTest, MatchesEager) {
+  for (auto dtype : {kFloat, kDouble}) {
+    auto x = at::randn({37, 19}, dtype);
+    auto a = at::randn({37, 19}, dtype);
+    auto b = at::randn({19}, dtype);
+    auto expected = (x * a + b * 2).relu().sub(0.5).div(3).sigmoid();
+    auto chain = PointwiseChain(x);
+    chain.mul(a).add(b, 2).relu().sub(0.5).div(3).sigmoid();
+    ASSERT_EQ(chain.pending(), 6u);
+    auto result = chain.materialize();
+    ASSERT_EQ(chain.pending(), 0u);
+    ASSERT_TRUE(result.allclose(expected));
+  }
+}
+
+TEST(PointwiseChainTest, NonContiguous) {
+  auto x = at::randn({64, 33}).t();
+  auto a = at::randn({33, 64});
+  auto expected = (x.exp() - a).tanh().neg();
+  auto result = PointwiseChain(x).exp().sub(a).tanh().neg().materialize();
+  ASSERT_TRUE(result.allclose(expected));
+  // the input is left untouched
+  ASSERT_TRUE(x.exp().allclose(x.clone().exp()));
+}
+
+TEST(PointwiseChainTest, Broadcast) {
+  auto x = at::randn({1, 1000});
+  auto a = at::randn({3, 1});
+  auto result = PointwiseChain(x).mul(a).add(1).materialize();
+  ASSERT_EQ(result.sizes(), IntArrayRef({3, 1000}));
+  ASSERT_TRUE(result.allclose(x * a + 1));
+}
+
+TEST(PointwiseChainTest, LongChain) {
+  // more steps and operands than a single fused loop handles
+  auto x = at::randn({128});
+  auto expected = x.clone();
+  auto chain = PointwiseChain(x);
+  for (int i = 0; i < 40; i++) {
+    auto other = at::rand({128}) + 0.5;
+    chain.mul(other).div(other).add(other).sub(other);
+    expected = expected * other / other + other - other;
+  }
+  ASSERT_TRUE(chain.materialize().allclose(expected, 1e-4, 1e-5));
+}
+
+TEST(PointwiseChainTest, Fallback) {
+  // operations that can't be fused are executed eagerly
+  auto x = at::randn({10}, kDouble);
+  auto i = at::arange(10, kLong);
+  auto y = at::randn({10}, kFloat);
+  auto chain = PointwiseChain(x);
+  chain.add(1).mul(i);
+  ASSERT_EQ(chain.pending(), 0u);
+  chain.mul(2).mul(y);
+  ASSERT_EQ(chain.pending(), 0u);
+  auto result = chain.materialize();
+  ASSERT_TRUE(result.allclose((x + 1) * i * 2 * y));
+}
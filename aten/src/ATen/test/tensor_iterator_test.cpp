@@ -223,3 +223,82 @@ TEST(TensorIteratorTest, FailNonPromotingBinaryOp) {
   iter.add_input(at::ones({1,1}, at::dtype(at::kInt)));
   ASSERT_ANY_THROW(iter.build());
 }
+
+TEST(TensorIteratorTest, PlanIsReused) {
+  auto a = at::randn({4, 1, 3}).transpose(0, 2);
+  auto b = at::randn({3, 2, 1});
+  Tensor out1;
+  auto iter1 = TensorIterator::binary_op(out1, a, b);
+  ASSERT_TRUE(iter1.plan() != nullptr);
+
+  auto c = at::randn({4, 1, 3}).transpose(0, 2);
+  auto d = at::randn({3, 2, 1});
+  Tensor out2;
+  auto iter2 = TensorIterator::binary_op(out2, c, d);
+  EXPECT_TRUE(iter2.plan() == iter1.plan());
+  EXPECT_TRUE(iter2.shape().equals(iter1.shape()));
+  for (int arg = 0; arg < iter1.ntensors(); arg++) {
+    EXPECT_TRUE(iter2.strides(arg).equals(iter1.strides(arg)));
+  }
+  EXPECT_TRUE(out2.sizes().equals(out1.sizes()));
+  EXPECT_TRUE(out2.strides().equals(out1.strides()));
+  EXPECT_TRUE(iter2.data_ptr(0) == out2.data_ptr());
+  EXPECT_TRUE(iter2.data_ptr(1) == c.data_ptr());
+
+  at::native::cpu_serial_kernel(iter2, [](float x, float y) -> float { return x + y; });
+  EXPECT_TRUE(out2.equal(c + d));
+
+  // other strides get another plan
+  Tensor out3;
+  auto iter3 = TensorIterator::binary_op(out3, c.contiguous(), d);
+  EXPECT_TRUE(iter3.plan() != iter1.plan());
+}
+
+TEST(TensorIteratorTest, PlanResizesOutputs) {
+  auto a = at::randn({2, 3});
+  for (int i = 0; i < 2; i++) {
+    auto out = at::empty({5});
+    auto iter = TensorIterator::unary_op(out, a);
+    ASSERT_TRUE(iter.plan() != nullptr);
+    EXPECT_TRUE(out.sizes().equals({2, 3}));
+    EXPECT_TRUE(iter.data_ptr(0) == out.data_ptr());
+  }
+}
+
+TEST(TensorIteratorTest, ExplicitPlan) {
+  TensorIterator::set_plan_cache_capacity(0);
+  Tensor out;
+  auto a = at::randn({2, 3});
+  auto iter = TensorIterator::unary_op(out, a);
+  EXPECT_TRUE(iter.plan() == nullptr);
+
+  auto planned = at::TensorIterator();
+  planned.add_output(Tensor());
+  planned.add_input(a);
+  planned.build(nullptr);
+  auto plan = planned.plan();
+  ASSERT_TRUE(plan != nullptr);
+
+  auto reused = at::TensorIterator();
+  reused.add_output(Tensor());
+  reused.add_input(at::randn({2, 3}));
+  reused.build(plan);
+  EXPECT_TRUE(reused.plan() == plan);
+
+  // a plan made for other operands is not used
+  auto mismatched = at::TensorIterator();
+  mismatched.add_output(Tensor());
+  mismatched.add_input(at::randn({3, 2}));
+  mismatched.build(plan);
+  EXPECT_TRUE(mismatched.plan() != plan);
+  EXPECT_TRUE(mismatched.output().sizes().equals({3, 2}));
+  TensorIterator::set_plan_cache_capacity(256);
+}
+
+TEST(TensorIteratorTest, ConversionsAreNotPlanned) {
+  Tensor out;
+  auto a = at::randn({2, 3}, at::kFloat);
+  auto b = at::randn({2, 3}, at::kDouble);
+  auto iter = TensorIterator::binary_op(out, a, b);
+  EXPECT_TRUE(iter.plan() == nullptr);
+}
@@ -4,9 +4,12 @@
 #include <ATen/DLConvertor.h>
 #include <ATen/Parallel.h>
 
+#include <atomic>
+#include <chrono>
 #include <iostream>
 #include <string.h>
 #include <sstream>
+#include <vector>
 
 using namespace at;
 
@@ -36,6 +39,29 @@ TEST(TestParallel, NestedParallel) {
   });
 }
 
+TEST(TestParallel, NestedParallelFor) {
+  // every element must be visited exactly once, whether or not the backend
+  // runs the inner loops in parallel
+  const int64_t outer = 16;
+  const int64_t inner = 1000;
+  std::vector<std::atomic<int>> visited(outer * inner);
+  for (auto& v : visited) {
+    v = 0;
+  }
+  at::parallel_for(0, outer, 1, [&](int64_t begin, int64_t end) {
+    for (auto i = begin; i < end; ++i) {
+      at::parallel_for(0, inner, 10, [&](int64_t inner_begin, int64_t inner_end) {
+        for (auto j = inner_begin; j < inner_end; ++j) {
+          visited[i * inner + j]++;
+        }
+      });
+    }
+  });
+  for (const auto& v : visited) {
+    ASSERT_EQ(v.load(), 1);
+  }
+}
+
 TEST(TestParallel, Exceptions) {
   // parallel case
   ASSERT_THROW(
@@ -69,3 +95,54 @@ TEST(TestParallel, IntraOpLaunchFuture) {
 
   ASSERT_TRUE(v1 == 1 && v2 == 2);
 }
+
+namespace {
+
+// Runs a loop of `n` elements that each take `element_ns` and returns the
+// number of chunks it was split into
+int64_t run_adaptive_loop(int64_t n, int64_t grain_size, int64_t element_ns) {
+  std::vector<std::atomic<int>> visited(n);
+  std::atomic<int64_t> chunks{0};
+  at::parallel_for(0, n, grain_size, [&](int64_t begin, int64_t end) {
+    chunks++;
+    for (auto i = begin; i < end; ++i) {
+      if (element_ns > 0) {
+        const auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start <
+               std::chrono::nanoseconds(element_ns)) {
+        }
+      }
+      visited[i]++;
+    }
+  });
+  for (const auto& v : visited) {
+    EXPECT_EQ(v.load(), 1);
+  }
+  return chunks.load();
+}
+
+} // namespace
+
+TEST(TestParallel, AdaptiveGrainSize) {
+  at::set_adaptive_grain_size_enabled(true);
+  const int64_t num_threads = at::get_num_threads();
+
+  // Cheap elements: the loop isn't worth more than one task
+  int64_t chunks = 0;
+  for (int i = 0; i < 10; ++i) {
+    chunks = run_adaptive_loop(1000, 1, 0);
+  }
+  ASSERT_EQ(chunks, 1);
+
+  // Expensive elements: the loop is split even though its grain size is
+  // larger than the range, but never into more tasks than threads
+  for (int i = 0; i < 10; ++i) {
+    chunks = run_adaptive_loop(16, 1000, 1000000);
+  }
+  ASSERT_LE(chunks, num_threads);
+  if (num_threads > 1 && !at::in_parallel_region()) {
+    ASSERT_GT(chunks, 1);
+  }
+
+  at::set_adaptive_grain_size_enabled(false);
+}
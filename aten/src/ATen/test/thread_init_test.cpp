@@ -29,7 +29,7 @@ int main() {
   });
   t1.join();
 
-  #if !AT_PARALLEL_NATIVE
+  #if !AT_PARALLEL_NATIVE && !AT_PARALLEL_NATIVE_WS
   at::set_num_threads(5);
   ASSERT_TRUE(at::get_num_threads() == 5);
   #endif
@@ -312,6 +312,21 @@ void THBlas_(ger)(
   }
 }
 
+#if defined(USE_BLAS) && defined(TH_REAL_IS_BFLOAT16)
+// Copies the column major rows x cols matrix at src, with leading dimension
+// ld, into a dense float buffer with leading dimension rows.
+static float* THBlas_bfloat16_gemm_operand(const scalar_t *src, int64_t rows, int64_t cols, int64_t ld)
+{
+  float *dst = (float*)THAlloc(sizeof(float) * rows * cols);
+  for (int64_t j = 0; j < cols; j++) {
+    for (int64_t i = 0; i < rows; i++) {
+      dst[j * rows + i] = static_cast<float>(src[j * ld + i]);
+    }
+  }
+  return dst;
+}
+#endif
+
 void THBlas_(gemm)(
   char transa,
   char transb,
@@ -379,6 +394,37 @@ void THBlas_(gemm)(
 #endif
     return;
   }
+#endif
+#if defined(USE_BLAS) && defined(TH_REAL_IS_BFLOAT16)
+  // There is no BFloat16 GEMM to call, so multiply float copies with sgemm,
+  // which also accumulates in float rather than rounding after each step.
+  if( (m <= INT_MAX) && (n <= INT_MAX) && (k <= INT_MAX) && (m > 0) && (n > 0) )
+  {
+    const int64_t a_rows = transa_ ? k : m;
+    const int64_t b_rows = transb_ ? n : k;
+    float *a_f = THBlas_bfloat16_gemm_operand(a, a_rows, transa_ ? m : k, lda);
+    float *b_f = THBlas_bfloat16_gemm_operand(b, b_rows, transb_ ? k : n, ldb);
+    float *c_f = THBlas_bfloat16_gemm_operand(c, m, n, ldc);
+    float alpha_f = static_cast<float>(alpha);
+    float beta_f = static_cast<float>(beta);
+    int i_m = (int)m;
+    int i_n = (int)n;
+    int i_k = (int)k;
+    int i_lda = (int)THMax(1, a_rows);
+    int i_ldb = (int)THMax(1, b_rows);
+    int i_ldc = (int)m;
+
+    sgemm_(&transa, &transb, &i_m, &i_n, &i_k, &alpha_f, a_f, &i_lda, b_f, &i_ldb, &beta_f, c_f, &i_ldc);
+    for (int64_t j = 0; j < n; j++) {
+      for (int64_t i = 0; i < m; i++) {
+        c[j * ldc + i] = c_f[j * m + i];
+      }
+    }
+    THFree(a_f);
+    THFree(b_f);
+    THFree(c_f);
+    return;
+  }
 #endif
   {
     if(!transa_ && !transb_)
@@ -4,6 +4,7 @@
 
 #include <ATen/InferSize.h>
 #include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
 #include <new>
 #include <ATen/NamedTensorUtils.h>
 
@@ -729,21 +730,40 @@ void THTensor_(catArray)(THTensor *result, THTensor **inputs, int numInputs, int
       inner *= size[i];
     }
 
-    scalar_t* result_data = THStorage_(data)(THTensor_getStoragePtr(result)) + result->storage_offset();
+    // Each input is copied as one memcpy per outer index. The offsets of its
+    // chunks in a row of the result are computed once, so that all the
+    // (outer index, input) chunks can be copied in parallel: with many small
+    // inputs, the per-input work is what dominates.
+    std::vector<scalar_t*> input_data(numInputs, nullptr);
+    std::vector<int64_t> local_inner(numInputs, 0);
+    std::vector<int64_t> row_offset(numInputs, 0);
     offset = 0;
-    for (int o = 0; o < outer; ++o) {
-      for (int j = 0; j < numInputs; ++j) {
-        if (!should_skip(inputs[j])) {
-          THTensor* input0 = inputs[j];
-          scalar_t* input0_data = THStorage_(data)(THTensor_getStoragePtr(input0)) + input0->storage_offset();
-          int64_t local_inner = inner * input0->size(dimension);
-          if (local_inner != 0) {
-            memcpy(result_data + offset, input0_data + o*local_inner, local_inner*sizeof(scalar_t));
-          } // input0_size != 0
-          offset += local_inner;
-        }  // should_skip
-      } // for j
-    } // for i
+    for (int j = 0; j < numInputs; ++j) {
+      row_offset[j] = offset;
+      if (!should_skip(inputs[j])) {
+        THTensor* input0 = inputs[j];
+        input_data[j] = THStorage_(data)(THTensor_getStoragePtr(input0)) + input0->storage_offset();
+        local_inner[j] = inner * input0->size(dimension);
+        offset += local_inner[j];
+      }
+    }
+    const int64_t row_size = offset;
+
+    scalar_t* result_data = THStorage_(data)(THTensor_getStoragePtr(result)) + result->storage_offset();
+    const int64_t chunks = outer * numInputs;
+    const int64_t grain_size = std::max<int64_t>(
+        1, at::internal::GRAIN_SIZE * chunks / std::max<int64_t>(1, outer * row_size));
+    at::parallel_for(0, chunks, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t chunk = begin; chunk < end; ++chunk) {
+        const int64_t o = chunk / numInputs;
+        const int j = chunk % numInputs;
+        if (local_inner[j] != 0) {
+          memcpy(result_data + o * row_size + row_offset[j],
+                 input_data[j] + o * local_inner[j],
+                 local_inner[j] * sizeof(scalar_t));
+        }
+      }
+    });
   } else {
     offset = 0;
     for (int j = 0; j < numInputs; j++) {
@@ -4,124 +4,209 @@
 
 
 #include <cuda_runtime_api.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <stdint.h>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
-#include <set>
 #include <utility>
+#include <vector>
 
 namespace {
 
-struct BlockSize
+using c10::cuda::CUDACachingAllocator::Stat;
+using c10::cuda::CUDACachingAllocator::StatArray;
+using c10::cuda::CUDACachingAllocator::StatType;
+
+// Blocks are rounded up to a power of two, from 512 bytes, and a freed block
+// is only reused for allocations of the same size class.
+constexpr size_t kMinBlockSize = 512;
+constexpr int kNumSizeClasses = 64;
+// Largest "small" allocation in the stats, as for the device allocator
+constexpr size_t kSmallSize = 1048576;
+// The blocks are spread over shards that each have their own lock
+constexpr size_t kNumShards = 8;
+// How often the reclamation thread queries the outstanding events
+constexpr auto kReclaimInterval = std::chrono::microseconds(100);
+
+int sizeClass(size_t size)
 {
-  size_t  size; // allocation size
-  void*   ptr;  // host memory pointer
-
-  BlockSize(size_t size, void* ptr=NULL) : size(size), ptr(ptr) {}
-};
+  int size_class = 0;
+  while ((kMinBlockSize << size_class) < size) {
+    size_class++;
+  }
+  return size_class;
+}
 
-struct Block : public BlockSize
+size_t shardOf(void* ptr)
 {
-  bool  allocated;    // true if the block is currently allocated
-  int   event_count;  // number of outstanding cuda events
-  std::unordered_set<at::cuda::CUDAStream> streams;
-
-  Block(size_t size, void* ptr, bool allocated) :
-      BlockSize(size, ptr), allocated(allocated), event_count(0), streams() {}
-};
+  // the low bits of the pointers are zero, use the high bits of a hash
+  return (static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr)) *
+          0x9E3779B97F4A7C15ull) >> (64 - 3);
+}
+static_assert(kNumShards == 8, "shardOf() takes the 3 high bits of the hash");
 
-static bool BlockComparator(const BlockSize& a, const BlockSize& b)
+void updateStat(Stat& stat, int64_t amount)
 {
-  // sort by size, break ties with pointer
-  if (a.size != b.size) {
-    return a.size < b.size;
+  stat.current += amount;
+  stat.peak = std::max(stat.current, stat.peak);
+  if (amount > 0) {
+    stat.allocated += amount;
+  }
+  if (amount < 0) {
+    stat.freed += -amount;
   }
-  return (uintptr_t)a.ptr < (uintptr_t)b.ptr;
 }
 
-struct HostAllocator
+void updateStatArray(StatArray& stat_array, int64_t amount, size_t block_size)
+{
+  updateStat(stat_array[static_cast<size_t>(StatType::AGGREGATE)], amount);
+  updateStat(
+      stat_array[static_cast<size_t>(
+          block_size <= kSmallSize ? StatType::SMALL_POOL
+                                   : StatType::LARGE_POOL)],
+      amount);
+}
+
+struct Block
 {
-  typedef bool (*Comparison)(const BlockSize&, const BlockSize&);
+  size_t size;          // allocation size, a power of two
+  size_t requested;     // size asked for by the last allocation
+  bool   allocated;     // true if the block is currently allocated
+  bool   from_pool;     // true if carved from the preallocated pool
+  int    event_count;   // number of outstanding cuda events
+  std::unordered_set<at::cuda::CUDAStream> streams;
+
+  Block(size_t size, size_t requested, bool from_pool) :
+      size(size), requested(requested), allocated(true),
+      from_pool(from_pool), event_count(0), streams() {}
+};
 
-  // lock around all operations
+struct Shard
+{
+  // lock around all the operations on the blocks of this shard
   std::mutex mutex;
 
   // blocks by pointer
   std::unordered_map<void*, Block> blocks;
 
-  // pointers that are ready to be allocated (event_count=0)
-  std::set<BlockSize, Comparison> available;
+  // pointers that are ready to be allocated (event_count=0), by size class
+  std::array<std::vector<void*>, kNumSizeClasses> available;
 
-  // outstanding cuda events
-  std::deque<std::pair<cudaEvent_t, void*>> cuda_events;
+  // outstanding cuda events, by stream. The events of a stream complete in
+  // order, so each queue is only processed up to its first pending event.
+  std::unordered_map<
+      at::cuda::CUDAStream,
+      std::deque<std::pair<cudaEvent_t, void*>>> cuda_events;
+};
 
-  HostAllocator() : available(BlockComparator) {}
+struct HostAllocator
+{
+  std::array<Shard, kNumShards> shards;
+
+  // lock around stats
+  std::mutex stats_mutex;
+  THCCachingHostAllocatorStats stats;
+
+  // lock around the preallocated pool, which blocks are carved from until
+  // it is exhausted. Its blocks are never released.
+  std::mutex pool_mutex;
+  char*  pool = nullptr;
+  size_t pool_size = 0;
+  size_t pool_used = 0;
+  std::once_flag pool_from_env;
+
+  // wakes up the reclamation thread when events are outstanding
+  std::mutex reclaim_mutex;
+  std::condition_variable reclaim_cv;
+  bool reclaim_started = false;
+  size_t reclaim_pending = 0;
 
   cudaError_t malloc(void** ptr, size_t size)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-
-    // process outstanding cuda events which may have occurred
-    cudaError_t err = processEvents();
-    if (err != cudaSuccess) {
-      return err;
-    }
+    std::call_once(pool_from_env, [this]() { reserveFromEnv(); });
 
-    // search for the smallest block which can hold this allocation
-    BlockSize search_key(size);
-    auto it = available.lower_bound(search_key);
-    if (it != available.end()) {
-      Block& block = blocks.at(it->ptr);
-      THAssert(!block.allocated && block.event_count == 0);
-      block.allocated = true;
-      *ptr = block.ptr;
-      available.erase(it);
+    // note that cudaHostAlloc may not touch pointer if size is 0
+    *ptr = 0;
+    if (size == 0) {
       return cudaSuccess;
     }
-
-    // Pinned memory pointers allocated by any device can be directly used by any
-    // other device, regardless of the current device at the time of allocation,
-    // since we assume unified addressing.
-    // So we grab any existing primary context, if available.
-    // See pytorch/pytorch#21081.
-    at::OptionalDeviceGuard device_guard;
-    auto primary_ctx_device_index = at::detail::getCUDAHooks().getDevceIndexWithPrimaryContext();
-    if (primary_ctx_device_index.has_value()) {
-      device_guard.reset_device(at::Device(at::DeviceType::CUDA, *primary_ctx_device_index));
+    const int size_class = sizeClass(size);
+    const size_t block_size = kMinBlockSize << size_class;
+
+    // the shard of the calling thread first, so that threads don't contend
+    // for the same blocks
+    const size_t first =
+        std::hash<std::thread::id>()(std::this_thread::get_id()) % kNumShards;
+    for (size_t i = 0; i < kNumShards; ++i) {
+      Shard& shard = shards[(first + i) % kNumShards];
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto& available = shard.available[size_class];
+      if (i == 0 && available.empty()) {
+        // process outstanding cuda events which may have occurred
+        cudaError_t err = processEvents(shard);
+        if (err != cudaSuccess) {
+          return err;
+        }
+      }
+      if (!available.empty()) {
+        *ptr = available.back();
+        available.pop_back();
+        Block& block = shard.blocks.at(*ptr);
+        THAssert(!block.allocated && block.event_count == 0);
+        block.allocated = true;
+        block.requested = size;
+        std::lock_guard<std::mutex> stats_lock(stats_mutex);
+        updateStatArray(stats.allocation, 1, block_size);
+        updateStatArray(stats.allocated_bytes, size, block_size);
+        updateStatArray(stats.active, 1, block_size);
+        updateStatArray(stats.active_bytes, block_size, block_size);
+        return cudaSuccess;
+      }
     }
 
-    // note that cudaHostAlloc may not touch pointer if size is 0
-    *ptr = 0;
-
     // allocate a new block if no cached allocation is found
-    err = cudaHostAlloc(ptr, size, cudaHostAllocDefault);
+    bool from_pool = false;
+    cudaError_t err = allocateBlock(ptr, block_size, &from_pool);
     if (err != cudaSuccess) {
       return err;
     }
-
-    blocks.insert({*ptr, Block(size, *ptr, true)});
+    Shard& shard = shards[shardOf(*ptr)];
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      shard.blocks.emplace(*ptr, Block(block_size, size, from_pool));
+    }
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    if (!from_pool) {
+      updateStatArray(stats.segment, 1, block_size);
+      updateStatArray(stats.reserved_bytes, block_size, block_size);
+    }
+    updateStatArray(stats.allocation, 1, block_size);
+    updateStatArray(stats.allocated_bytes, size, block_size);
+    updateStatArray(stats.active, 1, block_size);
+    updateStatArray(stats.active_bytes, block_size, block_size);
     return cudaSuccess;
   }
 
   cudaError_t free(void* ptr)
   {
-    std::lock_guard<std::mutex> lock(mutex);
-
     if (!ptr) {
       return cudaSuccess;
     }
 
-    // process outstanding cuda events which may have occurred
-    cudaError_t err = processEvents();
-    if (err != cudaSuccess) {
-      return err;
-    }
+    Shard& shard = shards[shardOf(ptr)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
 
-    auto it = blocks.find(ptr);
-    THAssert(it != blocks.end());
+    auto it = shard.blocks.find(ptr);
+    THAssert(it != shard.blocks.end());
 
     Block& block = it->second;
     THAssert(block.allocated);
@@ -129,26 +214,34 @@ struct HostAllocator
     // free (on valid memory) shouldn't fail, so mark unallocated before
     // we process the streams.
     block.allocated = false;
+    {
+      std::lock_guard<std::mutex> stats_lock(stats_mutex);
+      updateStatArray(stats.allocation, -1, block.size);
+      updateStatArray(
+          stats.allocated_bytes, -static_cast<int64_t>(block.requested),
+          block.size);
+    }
 
     // insert CUDA events for each stream on which this block was used. This
-    err = insertEvents(block);
+    cudaError_t err = insertEvents(shard, ptr, block);
     if (err != cudaSuccess) {
       return err;
     }
 
     if (block.event_count == 0) {
       // the block can be re-used if there are no outstanding cuda events
-      available.insert(block);
+      makeAvailable(shard, ptr, block);
     }
     return cudaSuccess;
   }
 
   cudaError_t recordEvent(void* ptr, at::cuda::CUDAStream stream)
   {
-    std::lock_guard<std::mutex> lock(mutex);
+    Shard& shard = shards[shardOf(ptr)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
 
-    auto it = blocks.find(ptr);
-    if (it == blocks.end()) {
+    auto it = shard.blocks.find(ptr);
+    if (it == shard.blocks.end()) {
       // ignore events for untracked pointers
       return cudaSuccess;
     }
@@ -160,71 +253,140 @@ struct HostAllocator
     return cudaSuccess;
   }
 
-  cudaError_t processEvents()
+  void makeAvailable(Shard& shard, void* ptr, Block& block)
+  {
+    shard.available[sizeClass(block.size)].push_back(ptr);
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    updateStatArray(stats.active, -1, block.size);
+    updateStatArray(
+        stats.active_bytes, -static_cast<int64_t>(block.size), block.size);
+  }
+
+  cudaError_t processEvents(Shard& shard)
   {
     // Process outstanding cudaEvents. Events that are completed are removed
-    // from the queue, and the 'event_count' for the corresponding allocation
-    // is decremented. Stops at the first event which has not been completed.
-    // Since events on different devices or streams may occur out of order,
-    // the processing of some events may be delayed.
-    while (!cuda_events.empty()) {
-      auto& e = cuda_events.front();
-      cudaEvent_t event = e.first;
-
-      cudaError_t err = cudaEventQuery(event);
-      if (err == cudaErrorNotReady) {
-        break;
-      } else if (err != cudaSuccess) {
-        return err;
+    // from the queues, and the 'event_count' for the corresponding allocation
+    // is decremented. Stops at the first event of each stream which has not
+    // been completed.
+    size_t processed = 0;
+    cudaError_t err = cudaSuccess;
+    for (auto it = shard.cuda_events.begin(); it != shard.cuda_events.end();) {
+      auto& events = it->second;
+      while (!events.empty()) {
+        auto& e = events.front();
+        cudaEvent_t event = e.first;
+
+        err = cudaEventQuery(event);
+        if (err == cudaErrorNotReady) {
+          // ignore and clear the error if not ready
+          cudaGetLastError();
+          err = cudaSuccess;
+          break;
+        } else if (err != cudaSuccess) {
+          break;
+        }
+        err = cudaEventDestroy(event);
+        if (err != cudaSuccess) {
+          break;
+        }
+
+        Block& block = shard.blocks.at(e.second);
+        block.event_count--;
+        if (block.event_count == 0 && !block.allocated) {
+          makeAvailable(shard, e.second, block);
+        }
+        events.pop_front();
+        processed++;
       }
-      err = cudaEventDestroy(event);
       if (err != cudaSuccess) {
-        return err;
+        break;
       }
+      if (events.empty()) {
+        it = shard.cuda_events.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    if (processed > 0) {
+      std::lock_guard<std::mutex> lock(reclaim_mutex);
+      reclaim_pending -= processed;
+    }
+    return err;
+  }
 
-      Block& block = blocks.at(e.second);
-      block.event_count--;
-      if (block.event_count == 0 && !block.allocated) {
-        available.insert(block);
+  // Polls the outstanding events of all the shards in the background, so
+  // that malloc and free rarely have to.
+  void reclaimLoop()
+  {
+    std::unique_lock<std::mutex> lock(reclaim_mutex);
+    while (true) {
+      reclaim_cv.wait(lock, [this] { return reclaim_pending > 0; });
+      lock.unlock();
+      std::this_thread::sleep_for(kReclaimInterval);
+      for (auto& shard : shards) {
+        std::lock_guard<std::mutex> shard_lock(shard.mutex);
+        THCudaCheckWarn(processEvents(shard));
       }
-      cuda_events.pop_front();
+      lock.lock();
     }
-    return cudaSuccess;
   }
 
   void emptyCache()
   {
-    std::lock_guard<std::mutex> lock(mutex);
-
-    // remove events for freed blocks
-    for (auto it = cuda_events.begin(); it != cuda_events.end(); ++it) {
-      cudaEvent_t event = it->first;
-      Block& block = blocks.at(it->second);
-      if (!block.allocated) {
-        THCudaCheckWarn(cudaEventDestroy(event));
-        block.event_count--;
+    size_t destroyed = 0;
+    for (auto& shard : shards) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+
+      // remove events for freed blocks
+      for (auto& stream_events : shard.cuda_events) {
+        for (auto& e : stream_events.second) {
+          Block& block = shard.blocks.at(e.second);
+          if (!block.allocated) {
+            THCudaCheckWarn(cudaEventDestroy(e.first));
+            if (--block.event_count == 0) {
+              makeAvailable(shard, e.second, block);
+            }
+          }
+        }
+        destroyed += stream_events.second.size();
       }
-    }
 
-    // all cuda_events have been processed
-    cuda_events.clear();
+      // all cuda_events have been processed
+      shard.cuda_events.clear();
 
-    // clear list of available blocks
-    available.clear();
+      // clear list of available blocks
+      for (auto& available : shard.available) {
+        available.clear();
+      }
 
-    // free and erase non-allocated blocks
-    for (auto it = blocks.begin(); it != blocks.end();) {
-      Block& block = it->second;
-      if (!block.allocated) {
-        THCudaCheckWarn(cudaFreeHost(block.ptr));
-        it = blocks.erase(it);
-      } else {
-        ++it;
+      // free and erase non-allocated blocks, the blocks of the pool are kept
+      for (auto it = shard.blocks.begin(); it != shard.blocks.end();) {
+        Block& block = it->second;
+        if (block.allocated) {
+          ++it;
+          continue;
+        }
+        if (block.from_pool) {
+          shard.available[sizeClass(block.size)].push_back(it->first);
+          ++it;
+          continue;
+        }
+        THCudaCheckWarn(cudaFreeHost(it->first));
+        {
+          std::lock_guard<std::mutex> stats_lock(stats_mutex);
+          updateStatArray(stats.segment, -1, block.size);
+          updateStatArray(
+              stats.reserved_bytes, -static_cast<int64_t>(block.size),
+              block.size);
+        }
+        it = shard.blocks.erase(it);
       }
     }
+    std::lock_guard<std::mutex> lock(reclaim_mutex);
+    reclaim_pending -= destroyed;
   }
 
-  cudaError_t insertEvents(Block& block)
+  cudaError_t insertEvents(Shard& shard, void* ptr, Block& block)
   {
     cudaError_t err;
 
@@ -232,6 +394,7 @@ struct HostAllocator
     err = cudaGetDevice(&prev_device);
     if (err != cudaSuccess) return err;
 
+    size_t inserted = 0;
     std::unordered_set<at::cuda::CUDAStream> streams(std::move(block.streams));
     for (auto it = streams.begin(); it != streams.end(); ++it) {
       err = cudaSetDevice(it->device_index());
@@ -245,37 +408,143 @@ struct HostAllocator
       if (err != cudaSuccess) break;
 
       block.event_count++;
-      cuda_events.emplace_back(event, block.ptr);
+      shard.cuda_events[*it].emplace_back(event, ptr);
+      inserted++;
     }
 
     cudaSetDevice(prev_device);
+
+    if (inserted > 0) {
+      std::lock_guard<std::mutex> lock(reclaim_mutex);
+      if (!reclaim_started) {
+        // the allocator is never destroyed, see getHostAllocator()
+        std::thread(&HostAllocator::reclaimLoop, this).detach();
+        reclaim_started = true;
+      }
+      reclaim_pending += inserted;
+      reclaim_cv.notify_one();
+    }
     return err;
   }
+
+  cudaError_t allocateBlock(void** ptr, size_t size, bool* from_pool)
+  {
+    {
+      std::lock_guard<std::mutex> lock(pool_mutex);
+      if (pool && pool_size - pool_used >= size) {
+        *ptr = pool + pool_used;
+        pool_used += size;
+        *from_pool = true;
+        return cudaSuccess;
+      }
+    }
+
+    cudaError_t err = hostAlloc(ptr, size);
+    if (err != cudaSuccess) {
+      // free the cached blocks and retry
+      cudaGetLastError();
+      {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex);
+        stats.num_alloc_retries++;
+      }
+      emptyCache();
+      err = hostAlloc(ptr, size);
+      if (err != cudaSuccess) {
+        std::lock_guard<std::mutex> stats_lock(stats_mutex);
+        stats.num_ooms++;
+      }
+    }
+    return err;
+  }
+
+  cudaError_t hostAlloc(void** ptr, size_t size)
+  {
+    // Pinned memory pointers allocated by any device can be directly used by any
+    // other device, regardless of the current device at the time of allocation,
+    // since we assume unified addressing.
+    // So we grab any existing primary context, if available.
+    // See pytorch/pytorch#21081.
+    at::OptionalDeviceGuard device_guard;
+    auto primary_ctx_device_index = at::detail::getCUDAHooks().getDevceIndexWithPrimaryContext();
+    if (primary_ctx_device_index.has_value()) {
+      device_guard.reset_device(at::Device(at::DeviceType::CUDA, *primary_ctx_device_index));
+    }
+    return cudaHostAlloc(ptr, size, cudaHostAllocDefault);
+  }
+
+  cudaError_t reserve(size_t size)
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if (pool || size == 0) {
+      // only one pool, the memory of the next allocations is not released
+      return cudaSuccess;
+    }
+    void* ptr = nullptr;
+    cudaError_t err = hostAlloc(&ptr, size);
+    if (err != cudaSuccess) {
+      return err;
+    }
+    pool = static_cast<char*>(ptr);
+    pool_size = size;
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    updateStatArray(stats.segment, 1, size);
+    updateStatArray(stats.reserved_bytes, size, size);
+    return cudaSuccess;
+  }
+
+  void reserveFromEnv()
+  {
+    const char* env = std::getenv("PYTORCH_CUDA_HOST_POOL_MB");
+    if (env) {
+      THCudaCheckWarn(reserve(std::strtoull(env, nullptr, 10) << 20));
+    }
+  }
+
+  THCCachingHostAllocatorStats getStats()
+  {
+    std::lock_guard<std::mutex> stats_lock(stats_mutex);
+    return stats;
+  }
 };
 
-}  // namespace
+HostAllocator& getHostAllocator()
+{
+  // leaked, so that the reclamation thread never sees it destroyed
+  static HostAllocator* allocator = new HostAllocator();
+  return *allocator;
+}
 
-static HostAllocator allocator;
+}  // namespace
 
 cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, at::cuda::CUDAStream stream)
 {
-  return allocator.recordEvent(ptr, stream);
+  return getHostAllocator().recordEvent(ptr, stream);
 }
 
 void THCCachingHostAllocator_emptyCache()
 {
-  allocator.emptyCache();
+  getHostAllocator().emptyCache();
+}
+
+cudaError_t THCCachingHostAllocator_reserve(size_t size)
+{
+  return getHostAllocator().reserve(size);
+}
+
+THCCachingHostAllocatorStats THCCachingHostAllocator_getStats()
+{
+  return getHostAllocator().getStats();
 }
 
 static void THCCachingHostDeleter(void* ptr) {
-  allocator.free(ptr);
+  getHostAllocator().free(ptr);
 }
 
 struct THCCachingHostAllocator final : public at::Allocator {
   at::DataPtr allocate(size_t size) const override {
     THAssert(size >= 0);
     void *ptr;
-    THCudaCheck(allocator.malloc(&ptr, size));
+    THCudaCheck(getHostAllocator().malloc(&ptr, size));
     return {ptr, ptr, &THCCachingHostDeleter, at::DeviceType::CPU};
   }
   at::DeleterFnPtr raw_deleter() const override {
@@ -4,6 +4,7 @@
 #include <THC/THCGeneral.h>
 
 
+#include <c10/cuda/CUDACachingAllocator.h>
 #include <c10/cuda/CUDAStream.h>
 
 //
@@ -19,7 +20,17 @@
 // copy_from_cpu_async_ and copy_to_cpu_async_.
 //
 // Note that this allocator does not split larger allocations into smaller
-// blocks, unlike the caching device allocator.
+// blocks, unlike the caching device allocator. Allocations are rounded up to
+// a power of two, and a freed block is only reused for the same size class.
+//
+// The blocks are spread over shards with their own lock by address, and the
+// freed blocks that wait for their events are reclaimed by a background
+// thread, so concurrent allocations and frees don't contend on a single lock
+// or on polling the events.
+//
+// Setting PYTORCH_CUDA_HOST_POOL_MB preallocates a pool of that many MiB with
+// a single cudaHostAlloc at the first allocation, see
+// THCCachingHostAllocator_reserve.
 //
 THC_API c10::Allocator* getTHCCachingHostAllocator(void);
 
@@ -30,4 +41,25 @@ THC_API cudaError_t THCCachingHostAllocator_recordEvent(void *ptr, at::cuda::CUD
 // Releases cached pinned memory allocations via cudaHostFree
 THC_API void THCCachingHostAllocator_emptyCache(void);
 
+// Allocates a pool of `size` bytes that the blocks are carved from, before
+// allocating more. The pool is never released, emptyCache only releases the
+// blocks allocated after it was exhausted. Only the first call has an effect.
+THC_API cudaError_t THCCachingHostAllocator_reserve(size_t size);
+
+// Statistics of the allocator, with the meaning of the same fields of the
+// device allocator's DeviceStats. A segment is a cudaHostAlloc allocation,
+// the preallocated pool being a single one.
+struct THCCachingHostAllocatorStats {
+  c10::cuda::CUDACachingAllocator::StatArray allocation;
+  c10::cuda::CUDACachingAllocator::StatArray segment;
+  c10::cuda::CUDACachingAllocator::StatArray active;
+  c10::cuda::CUDACachingAllocator::StatArray allocated_bytes;
+  c10::cuda::CUDACachingAllocator::StatArray reserved_bytes;
+  c10::cuda::CUDACachingAllocator::StatArray active_bytes;
+  int64_t num_alloc_retries = 0;
+  int64_t num_ooms = 0;
+};
+
+THC_API THCCachingHostAllocatorStats THCCachingHostAllocator_getStats(void);
+
 #endif
@@ -144,9 +144,14 @@ __device__ inline void bitonicSortKeys(K keys[Power2SortSize],
 
 // Sorts (key, value) pairs (in different tensors) in-place; i.e.,
 // modifies the input `keys` and `values`
+//
+// Every block sorts `SlicesPerBlock` slices, one per threadIdx.y, so that
+// short slices still fill the blocks: the blocks sorting slices of a small
+// Power2SortSize would otherwise have very few threads.
 template <typename K, typename V,
           int KeyDims, int ValueDims,
-          typename Comparator, typename IndexType, int Power2SortSize>
+          typename Comparator, typename IndexType, int Power2SortSize,
+          int SlicesPerBlock = 1>
 C10_LAUNCH_BOUNDS_1(1024)
 __global__ void
 bitonicSortKVInPlace(TensorInfo<K, IndexType> keys,
@@ -157,21 +162,25 @@ bitonicSortKVInPlace(TensorInfo<K, IndexType> keys,
                      IndexType valueSliceStride,
                      Comparator comp) {
   // Find the slice of the tensor that we are sorting
-  const IndexType linearIndex = getLinearBlockId<IndexType>();
+  const IndexType linearIndex =
+    getLinearBlockId<IndexType>() * SlicesPerBlock + threadIdx.y;
   // Tiling the slices could have us be out of bounds, if there are a
-  // lot of slices to sort
-  if (linearIndex >= keySlices) {
+  // lot of slices to sort. The threads of such slices still have to take
+  // part in the synchronization of the block, so they sort invalid entries
+  // instead of returning.
+  const bool inRange = linearIndex < keySlices;
+  if (getLinearBlockId<IndexType>() * SlicesPerBlock >= keySlices) {
     return;
   }
 
-  __shared__ K sharedKeys[Power2SortSize];
-  __shared__ V sharedValues[Power2SortSize];
-  __shared__ bool sharedValid[Power2SortSize];
+  __shared__ K sharedKeys[SlicesPerBlock][Power2SortSize];
+  __shared__ V sharedValues[SlicesPerBlock][Power2SortSize];
+  __shared__ bool sharedValid[SlicesPerBlock][Power2SortSize];
 
-  const IndexType keyStartOffset =
-    IndexToOffset<K, IndexType, KeyDims>::get(linearIndex, keys);
-  const IndexType valueStartOffset =
-    IndexToOffset<V, IndexType, ValueDims>::get(linearIndex, values);
+  const IndexType keyStartOffset = inRange ?
+    IndexToOffset<K, IndexType, KeyDims>::get(linearIndex, keys) : 0;
+  const IndexType valueStartOffset = inRange ?
+    IndexToOffset<V, IndexType, ValueDims>::get(linearIndex, values) : 0;
 
   // If the sort size is 1, the data is already sorted
   if (Power2SortSize == 1) {
@@ -181,45 +190,48 @@ bitonicSortKVInPlace(TensorInfo<K, IndexType> keys,
     // elements. The sort size is guaranteed to be >= 2
     const int elem1 = threadIdx.x;
     const int elem2 = threadIdx.x + (Power2SortSize / 2);
+    K* sliceKeys = sharedKeys[threadIdx.y];
+    V* sliceValues = sharedValues[threadIdx.y];
+    bool* sliceValid = sharedValid[threadIdx.y];
 
-    bool valid1 = (elem1 < keySliceSize);
+    bool valid1 = inRange && (elem1 < keySliceSize);
     K k1 = valid1 ?
       keys.data[keyStartOffset + elem1 * keySliceStride] : ScalarConvert<int, K>::to(0);
     V v1 = valid1 ?
       values.data[valueStartOffset + elem1 * valueSliceStride] : ScalarConvert<int, V>::to(0);
 
-    sharedKeys[elem1] = k1;
-    sharedValues[elem1] = v1;
-    sharedValid[elem1] = valid1;
+    sliceKeys[elem1] = k1;
+    sliceValues[elem1] = v1;
+    sliceValid[elem1] = valid1;
 
-    bool valid2 = (elem2 < keySliceSize);
+    bool valid2 = inRange && (elem2 < keySliceSize);
     K k2 = valid2 ?
       keys.data[keyStartOffset + elem2 * keySliceStride] : ScalarConvert<int, K>::to(0);
     V v2 = valid2 ?
       values.data[valueStartOffset + elem2 * valueSliceStride] : ScalarConvert<int, V>::to(0);
 
-    sharedKeys[elem2] = k2;
-    sharedValues[elem2] = v2;
-    sharedValid[elem2] = valid2;
+    sliceKeys[elem2] = k2;
+    sliceValues[elem2] = v2;
+    sliceValid[elem2] = valid2;
 
     // Sort!
     bitonicSort<Comparator, K, V, IndexType, Power2SortSize>(
-      sharedKeys, sharedValues, sharedValid, comp);
+      sliceKeys, sliceValues, sliceValid, comp);
 
     // elem1 and elem2 values might be out-of-range, if the data size we are
     // sorting is smaller than half the power2 size
     if (valid1) {
       keys.data[keyStartOffset + elem1 * keySliceStride] =
-        sharedKeys[elem1];
+        sliceKeys[elem1];
       values.data[valueStartOffset + elem1 * valueSliceStride] =
-        sharedValues[elem1];
+        sliceValues[elem1];
     }
 
     if (valid2) {
       keys.data[keyStartOffset + elem2 * keySliceStride] =
-        sharedKeys[elem2];
+        sliceKeys[elem2];
       values.data[valueStartOffset + elem2 * valueSliceStride] =
-        sharedValues[elem2];
+        sliceValues[elem2];
     }
   }
 }
@@ -2,6 +2,7 @@
 #define THC_TENSORMATH_CUH
 
 #include "ATen/cuda/CUDAContext.h"
+#include <algorithm>
 
 // Copy the kth diagonal of a matrix B to a vector A.
 template <typename T>
@@ -34,7 +35,8 @@ __global__ void THCTensor_copyToDiagonal(T* a, T* b, ptrdiff_t start, ptrdiff_t
 #define CAT_ARRAY_BATCH_SIZE 1024
 #define CAT_ARRAY_MAX_INPUT_DIMS 4
 
-inline bool getCatGrid(THCState* state, ptrdiff_t nTensors, dim3& grid) {
+inline bool getCatGrid(THCState* state, ptrdiff_t nTensors, ptrdiff_t maxElements,
+                       const dim3& block, dim3& grid) {
   int curDevice = -1;
   cudaGetDevice(&curDevice);
 
@@ -46,9 +48,14 @@ inline bool getCatGrid(THCState* state, ptrdiff_t nTensors, dim3& grid) {
   int numSM =
         state ? at::cuda::getCurrentDeviceProperties()->multiProcessorCount : 15;
   //X dim of grid for cat array cooperates on a single tensor in the cat.
-  //Given half of the GPU, full utilization will always occur.
-  grid = dim3( 2LL * numSM, (long long) nTensors );
-             
+  //Given half of the GPU, full utilization will always occur. When all the
+  //tensors are small, only as many blocks as the largest one needs are
+  //launched, so that a cat of many small tensors doesn't mostly launch
+  //blocks that exit right away.
+  long long blocksPerTensor = (maxElements + block.x - 1) / block.x;
+  blocksPerTensor = std::max(1LL, std::min(2LL * numSM, blocksPerTensor));
+  grid = dim3( blocksPerTensor, (long long) nTensors );
+
   return true;
 }
 
@@ -1,6 +1,8 @@
 #ifndef THC_TENSORSORT_CUH
 #define THC_TENSORSORT_CUH
 
+#include <cmath>
+
 #include <THC/THCTensorMath.h>
 #include <THC/THCGeneral.h>
 #include <THC/THCReduceApplyUtils.cuh>
@@ -10,11 +12,17 @@
 
 #include <THC/THCThrustAllocator.cuh>
 #include <thrust/device_ptr.h>
+#include <thrust/sequence.h>
 #include <thrust/sort.h>
+#include <thrust/transform.h>
 #if CUDA_VERSION >= 7000 || defined(__HIP_PLATFORM_HCC__)
 #include <thrust/system/cuda/execution_policy.h>
 #endif
 
+#ifndef __HIP_PLATFORM_HCC__
+#include <cub/device/device_segmented_radix_sort.cuh>
+#endif
+
 template <typename T, bool handleNaN = false>
 struct ThrustGTOp {
   __device__ bool operator()(const T& lhs, const T& rhs) const {
@@ -60,6 +68,40 @@ ThrustSliceLTOp(int64_t size) : sliceSize(size) {}
 
 
 
+// For the segmented radix sort; replaces every NaN by the positive quiet NaN
+template <typename T>
+struct ThrustCanonicalizeNaNOp {
+  __device__ T operator()(const T& v) const {
+    return THCNumerics<T>::isnan(v) ? static_cast<T>(NAN) : v;
+  }
+};
+
+#ifndef __HIP_PLATFORM_HCC__
+// Sorts the (key, value) pairs of every segment [offsets[i], offsets[i + 1])
+// of `keys` and `values`. With `temp` NULL, only sets `tempBytes` to the
+// size of the temporary storage the sort needs.
+template <typename K>
+void segmentedRadixSortPairs(void* temp,
+                             size_t& tempBytes,
+                             cub::DoubleBuffer<K>& keys,
+                             cub::DoubleBuffer<int64_t>& values,
+                             int numItems,
+                             int numSegments,
+                             const int* offsets,
+                             bool descending,
+                             cudaStream_t stream) {
+  if (descending) {
+    THCudaCheck(cub::DeviceSegmentedRadixSort::SortPairsDescending(
+      temp, tempBytes, keys, values, numItems, numSegments,
+      offsets, offsets + 1, 0, sizeof(K) * 8, stream));
+  } else {
+    THCudaCheck(cub::DeviceSegmentedRadixSort::SortPairs(
+      temp, tempBytes, keys, values, numItems, numSegments,
+      offsets, offsets + 1, 0, sizeof(K) * 8, stream));
+  }
+}
+#endif
+
 // `base` is the base address of a tensor
 // For each slice (defined as a linear point of `out`, from 0 ->
 // (sliceSize - 1) * sliceStride, we fill that slice from `0` to
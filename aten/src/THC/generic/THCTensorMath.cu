@@ -206,7 +206,7 @@ void THCTensor_(catArray)(THCState *state, THCTensor *result,
       //This will have cating two tensors fill the entire grid, but prevent
       //many threads from needlessly load meta data if their sizes is small.
       dim3 catGrid;
-      getCatGrid(state, j, catGrid);
+      getCatGrid(state, j, cohortMax, applyBlock, catGrid);
 
 
       switch (nDims) {
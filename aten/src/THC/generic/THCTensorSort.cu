@@ -36,24 +36,20 @@ void THCTensor_(sortKeyValueInplace)(THCState* state,
     THError("sortKeyValueInplace only works for sizes <= 2048 at present");
   }
 
-  // The grid is based on the number of independent slices that we
-  // have to sort; one block per slice
-  dim3 grid;
-  if (!THC_getGridFromTiles(keySlices, grid)) {
-    THError("Slice to sort is too large");
-  }
-
-#define HANDLE_CASE(TYPE, A, SIZE)                                      \
+  // Short slices are sorted several per block, so that every block has at
+  // least 256 threads; the grid is based on the number of blocks of
+  // independent slices that we have to sort
+#define HANDLE_CASE(TYPE, A, SIZE, SLICES)                              \
   do {                                                                  \
-    int blockSize = SIZE / 2;                                           \
-    if (blockSize < 1) {                                                \
-      blockSize = 1;                                                    \
+    dim3 grid;                                                          \
+    if (!THC_getGridFromTiles(THCCeilDiv(keySlices, (ptrdiff_t) SLICES), grid)) { \
+      THError("Slice to sort is too large");                            \
     }                                                                   \
                                                                         \
-    dim3 block(blockSize);                                              \
+    dim3 block(SIZE / 2, SLICES);                                       \
                                                                         \
     if (dir) {                                                          \
-      bitonicSortKVInPlace<scalar_t, int64_t, A, -1, GTComp<scalar_t, true>, TYPE, SIZE> \
+      bitonicSortKVInPlace<scalar_t, int64_t, A, -1, GTComp<scalar_t, true>, TYPE, SIZE, SLICES> \
         <<<grid, block, 0, THCState_getCurrentStream(state)>>>(         \
           keyInfo,                                                      \
           keySlices,                                                    \
@@ -63,7 +59,7 @@ void THCTensor_(sortKeyValueInplace)(THCState* state,
           (TYPE) valueInfo.strides[collapseValueDim],                   \
           GTComp<scalar_t, true>());                                    \
     } else {                                                            \
-      bitonicSortKVInPlace<scalar_t, int64_t, A, -1, LTComp<scalar_t, true>, TYPE, SIZE> \
+      bitonicSortKVInPlace<scalar_t, int64_t, A, -1, LTComp<scalar_t, true>, TYPE, SIZE, SLICES> \
         <<<grid, block, 0, THCState_getCurrentStream(state)>>>(         \
           keyInfo,                                                      \
           keySlices,                                                    \
@@ -71,7 +67,7 @@ void THCTensor_(sortKeyValueInplace)(THCState* state,
           (TYPE) keyInfo.strides[collapseKeyDim],                       \
           valueInfo,                                                    \
           (TYPE) valueInfo.strides[collapseValueDim],                   \
-          LTComp<scalar_t, true>());                                              \
+          LTComp<scalar_t, true>());                                    \
     }                                                                   \
   } while (0)
 
@@ -79,23 +75,31 @@ void THCTensor_(sortKeyValueInplace)(THCState* state,
   {                                                     \
     switch (ceilPowerOf2) {                             \
       case 2048:                                        \
-      HANDLE_CASE(TYPE, A, 2048);                       \
+      HANDLE_CASE(TYPE, A, 2048, 1);                    \
       break;                                            \
       case 1024:                                        \
+      HANDLE_CASE(TYPE, A, 1024, 1);                    \
+      break;                                            \
       case 512:                                         \
+      HANDLE_CASE(TYPE, A, 512, 1);                     \
+      break;                                            \
       case 256:                                         \
-      HANDLE_CASE(TYPE, A, 1024);                       \
+      HANDLE_CASE(TYPE, A, 256, 2);                     \
       break;                                            \
       case 128:                                         \
+      HANDLE_CASE(TYPE, A, 128, 4);                     \
+      break;                                            \
       case 64:                                          \
-      HANDLE_CASE(TYPE, A, 128);                        \
+      HANDLE_CASE(TYPE, A, 64, 8);                      \
       break;                                            \
       case 32:                                          \
+      HANDLE_CASE(TYPE, A, 32, 16);                     \
+      break;                                            \
       case 16:                                          \
       case 8:                                           \
       case 4:                                           \
       case 2:                                           \
-      HANDLE_CASE(TYPE, A, 32);                         \
+      HANDLE_CASE(TYPE, A, 16, 32);                     \
       break;                                            \
       case 1:                                           \
       /* Nothing to do, data already sorted */          \
@@ -272,6 +276,115 @@ void THCTensor_(sortViaThrust)(THCState* state,
   THCudaLongTensor_freeCopyTo(state, trContigIndices, indices);
 }
 
+#if !defined(__HIP_PLATFORM_HCC__) && !defined(THC_REAL_IS_HALF)
+void THCTensor_(sortViaSegmentedRadixSort)(THCState* state,
+                                           THCTensor* sorted,
+                                           THCudaLongTensor* indices,
+                                           THCTensor* input,
+                                           int dim, bool dir) {
+  int nDims = THCTensor_(nDimensionLegacyAll)(state, input);
+
+  ptrdiff_t totalElements = THCTensor_(nElement)(state, input);
+  int64_t sliceSize = THCTensor_(sizeLegacyNoScalars)(state, input, dim);
+  int numSlices = totalElements / sliceSize;
+
+  // Every slice is a segment of a device-wide segmented radix sort, which
+  // sorts all the slices at once without the two global sorts of
+  // sortViaThrust. Like there the segments have to be contiguous, so the
+  // slices are moved to the innermost dimension and made contiguous.
+  THCTensor_(copy)(state, sorted, input);
+  THCTensor* trKeys = THCTensor_(newWithTensor)(state, sorted);
+  THCudaLongTensor* trIndices = THCudaLongTensor_newWithTensor(state, indices);
+
+  // Transpose dim to innermost
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, trKeys, NULL, dim, nDims - 1);
+    THCudaLongTensor_transpose(state, trIndices, NULL, dim, nDims - 1);
+  }
+
+  THCTensor* trContigKey = THCTensor_(newContiguous)(state, trKeys);
+  THCudaLongTensor* trContigIndices = THCudaLongTensor_newContiguous(state, trIndices);
+
+  THCTensor_(free)(state, trKeys);
+  THCudaLongTensor_free(state, trIndices);
+
+  THCThrustAllocator thrustAlloc(state);
+  cudaStream_t stream = THCState_getCurrentStream(state);
+
+  scalar_t* keys = THCTensor_(data)(state, trContigKey);
+  int64_t* values = THCudaLongTensor_data(state, trContigIndices);
+  thrust::device_ptr<scalar_t> keyIter(keys);
+  thrust::device_ptr<int64_t> indexIter(values);
+
+#if defined(THC_REAL_IS_FLOAT) || defined(THC_REAL_IS_DOUBLE)
+  // The radix sort orders NaNs by their bits, so that NaNs with the sign
+  // bit set would come before -inf. Make them all positive NaNs, which sort
+  // as the largest values like in the comparison based sorts.
+  thrust::transform(
+    thrust::cuda::par(thrustAlloc).on(stream),
+    keyIter, keyIter + totalElements, keyIter,
+    ThrustCanonicalizeNaNOp<scalar_t>());
+#endif
+
+  // Fill the indices with the slice-relative index
+  thrust::counting_iterator<int64_t> countIter(0);
+  thrust::copy(
+    thrust::cuda::par(thrustAlloc).on(stream),
+    countIter, countIter + totalElements, indexIter);
+  thrust::for_each(
+    thrust::cuda::par(thrustAlloc).on(stream),
+    indexIter, indexIter + totalElements,
+    GlobalIndexToPerSliceIndex(sliceSize));
+
+  // Segment i is [offsets[i], offsets[i + 1])
+  int* offsets = (int*) THCudaMalloc(state, (numSlices + 1) * sizeof(int));
+  thrust::device_ptr<int> offsetIter(offsets);
+  thrust::sequence(
+    thrust::cuda::par(thrustAlloc).on(stream),
+    offsetIter, offsetIter + numSlices + 1, 0, (int) sliceSize);
+
+  scalar_t* keysAlt = (scalar_t*) THCudaMalloc(state, totalElements * sizeof(scalar_t));
+  int64_t* valuesAlt = (int64_t*) THCudaMalloc(state, totalElements * sizeof(int64_t));
+  cub::DoubleBuffer<scalar_t> keyBuffer(keys, keysAlt);
+  cub::DoubleBuffer<int64_t> valueBuffer(values, valuesAlt);
+
+  size_t tempBytes = 0;
+  segmentedRadixSortPairs<scalar_t>(
+    NULL, tempBytes, keyBuffer, valueBuffer, totalElements, numSlices,
+    offsets, dir, stream);
+  void* temp = THCudaMalloc(state, tempBytes);
+  segmentedRadixSortPairs<scalar_t>(
+    temp, tempBytes, keyBuffer, valueBuffer, totalElements, numSlices,
+    offsets, dir, stream);
+
+  // The sorted pairs end up in either buffer
+  if (keyBuffer.Current() != keys) {
+    THCudaCheck(cudaMemcpyAsync(keys, keyBuffer.Current(),
+                                totalElements * sizeof(scalar_t),
+                                cudaMemcpyDeviceToDevice, stream));
+  }
+  if (valueBuffer.Current() != values) {
+    THCudaCheck(cudaMemcpyAsync(values, valueBuffer.Current(),
+                                totalElements * sizeof(int64_t),
+                                cudaMemcpyDeviceToDevice, stream));
+  }
+
+  THCudaFree(state, temp);
+  THCudaFree(state, valuesAlt);
+  THCudaFree(state, keysAlt);
+  THCudaFree(state, offsets);
+
+  // Reverse the transposition as needed
+  if (dim != nDims - 1) {
+    THCTensor_(transpose)(state, trContigKey, NULL, dim, nDims - 1);
+    THCudaLongTensor_transpose(state, trContigIndices, NULL, dim, nDims - 1);
+  }
+  // Then copy back to the expected output
+  THCTensor_(freeCopyTo)(state, trContigKey, sorted);
+  THCudaLongTensor_freeCopyTo(state, trContigIndices, indices);
+}
+#endif
+
 void THCTensor_(sort)(THCState* state,
                       THCTensor *sorted,
                       THCudaLongTensor *indices,
@@ -319,6 +432,15 @@ void THCTensor_(sort)(THCState* state,
     // layout
     THCTensor_(sortKeyValueInplace)(state, sorted, indices, dim, order);
   } else {
+#if !defined(__HIP_PLATFORM_HCC__) && !defined(THC_REAL_IS_HALF)
+    // Sort all the slices with one segmented radix sort, as long as the
+    // number of elements fits in its int sizes
+    if (THCTensor_(nElement)(state, input) < INT_MAX) {
+      THCTensor_(sortViaSegmentedRadixSort)(state, sorted, indices, input, dim, (bool) order);
+      THCudaCheck(cudaGetLastError());
+      return;
+    }
+#endif
     // Otherwise, fall back upon Thrust, which handles all other cases
     // (potentially slowly, with extra copies/memory allocations)
     THCTensor_(sortViaThrust)(state, sorted, indices, input, dim, (bool) order);
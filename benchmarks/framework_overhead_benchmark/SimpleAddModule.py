@@ -15,3 +15,17 @@ class SimpleAddModule(torch.nn.Module):
 
     def forward(self, x, y):
         return self.add_op(x, y)
+
+def quantized_add_tensors_loop(x, y):
+    z = torch.ops.quantized.add(x, y, 0.1, 0)
+    for i in range(NUM_LOOP_ITERS):
+        z = torch.ops.quantized.add(z, x, 0.1, 0)
+    return z
+
+class SimpleQuantizedAddModule(SimpleAddModule):
+    """ Same as SimpleAddModule with quantized inputs, for ops dispatched by the
+    c10 dispatcher rather than the ATen one.
+    """
+    @staticmethod
+    def make_input():
+        return torch.quantize_per_tensor(torch.randn(1), 0.1, 0, torch.quint8)
@@ -0,0 +1,64 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+import argparse
+import time
+
+import torch
+from utils import secs_to_us
+
+""" Autograd engine overhead benchmark script.
+Measures the per-node cost of backward for graphs made of many tiny CPU
+functions, with the backward pass handed over to the engine's CPU worker
+thread (the default) and run inline on the calling thread.
+Example run:
+python autograd_overhead_benchmark.py --num_nodes 1000 --num_iters 100
+"""
+
+def build_chain(x, num_nodes):
+    """ A chain of num_nodes dependent additions. """
+    y = x
+    for _ in range(num_nodes):
+        y = y + 1
+    return y.sum()
+
+def build_fan_in(x, num_nodes):
+    """ num_nodes independent lookups summed together, like an embedding bag. """
+    return torch.stack([x[i % x.size(0)] for i in range(num_nodes)]).sum()
+
+GRAPHS = {"chain": build_chain, "fan_in": build_fan_in}
+
+def benchmark_backward(build_graph, num_nodes, num_warmup_iters, num_iters):
+    x = torch.randn(4, requires_grad=True)
+    for _ in range(num_warmup_iters):
+        build_graph(x, num_nodes).backward()
+    elapsed_s = 0.
+    for _ in range(num_iters):
+        out = build_graph(x, num_nodes)
+        start = time.time()
+        out.backward()
+        elapsed_s += time.time() - start
+    return secs_to_us(elapsed_s) / num_iters / num_nodes
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--graph", default="chain,fan_in", type=str)
+    parser.add_argument("--num_nodes", type=int, default=1000)
+    parser.add_argument("--num_warmup_iters", type=int, default=10)
+    parser.add_argument("--num_iters", type=int, default=100)
+    args = parser.parse_args()
+
+    prev = torch._C._is_inline_cpu_backward_enabled()
+    print("===================================")
+    try:
+        for graph in args.graph.split(","):
+            for inline in (False, True):
+                torch._C._set_inline_cpu_backward_enabled(inline)
+                latency_us = benchmark_backward(
+                    GRAPHS[graph], args.num_nodes, args.num_warmup_iters, args.num_iters)
+                print("{}, inline CPU backward:{}, latency per node (us):{}".format(
+                    graph, inline, latency_us))
+    finally:
+        torch._C._set_inline_cpu_backward_enabled(prev)
+    print("===================================")
+
+if __name__ == "__main__":
+    main()
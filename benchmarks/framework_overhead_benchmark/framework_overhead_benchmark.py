@@ -4,11 +4,12 @@ import argparse
 from C2Module import C2SimpleNet
 
 from SimpleAddModule import SimpleAddModule, add_tensors_loop
+from SimpleAddModule import SimpleQuantizedAddModule, quantized_add_tensors_loop
 from pt_wrapper_module import WrapperModule
 
 """ Framework overhead benchmark script.
 Benchmark framework overhead.
-Currently supported ops: add.
+Currently supported ops: add, quantized add (dispatched by the c10 dispatcher).
 As of now runs only forward pass.
 Supports both graph mode and eager mode. In graph mode the module is traced via JIT tracing.
 Debug option prints the traced graph is graph_mode is enabled.
@@ -24,7 +25,7 @@ buck run @mode/opt <path-to-framework_overhead_benchmark>:framework_overhead_ben
  --add_op --benchmark_c2_net
 """
 
-SUPPORTED_OPS = {"add_op"}
+SUPPORTED_OPS = {"add_op", "quantized_add_op"}
 
 def parse_op_args(op):
     op_list = ops.split(",")
@@ -94,6 +95,11 @@ def main():
         else:
             module_config = ModuleConfig(add_tensors_loop, None, num_params, graph_mode)
         benchmark_simple_fn(args, config, module_config, SimpleAddModule, result)
+    elif args.op == "quantized_add_op":
+        assert not args.benchmark_c2_net, "quantized_add_op has no C2 counterpart"
+        num_params = 2
+        module_config = ModuleConfig(quantized_add_tensors_loop, None, num_params, graph_mode)
+        benchmark_simple_fn(args, config, module_config, SimpleQuantizedAddModule, result)
     print_results(result)
 
 if __name__ == "__main__":
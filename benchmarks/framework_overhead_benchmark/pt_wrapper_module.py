@@ -4,7 +4,8 @@ import torch
 class WrapperModule(object):
     """ Wraps the instance of wrapped_type.
     For graph_mode traces the instance of wrapped_type.
-    Randomaly initializes num_params tensors with single float element.
+    Randomaly initializes num_params tensors with single float element, or with
+    wrapped_type.make_input() if wrapped_type defines it.
     Args:
         wrapped_type:
             - Object type to be wrapped.
@@ -25,8 +26,9 @@ class WrapperModule(object):
         self.module = wrapped_type(pt_fn)
         self.tensor_inputs = []
         self.module_name = wrapped_type.__name__
+        make_input = getattr(wrapped_type, 'make_input', lambda: torch.randn(1))
         for _ in range(module_config.num_params):
-            self.tensor_inputs.append(torch.randn(1))
+            self.tensor_inputs.append(make_input())
         if module_config.graph_mode:
             self.module = torch.jit.trace(self.module, self.tensor_inputs)
             if save:
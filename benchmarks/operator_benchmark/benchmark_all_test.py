@@ -6,8 +6,9 @@ from __future__ import unicode_literals
 import operator_benchmark as op_bench
 from pt import ( # noqa
     add_test, batchnorm_test, cat_test, chunk_test, conv_test, # noqa
-    gather_test, linear_test, matmul_test, pool_test, # noqa
-    softmax_test, split_test, unary_test, qconv_test, qlinear_test # noqa
+    gather_test, histc_renorm_test, index_ops_test, linear_test, # noqa
+    matmul_test, pool_test, # noqa
+    softmax_test, split_test, sum_test, unary_test, qconv_test, qlinear_test # noqa
 )
 
 
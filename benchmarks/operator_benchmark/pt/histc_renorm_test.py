@@ -0,0 +1,50 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import operator_benchmark as op_bench
+import torch
+
+
+"""Microbenchmarks for histc and renorm operators."""
+
+histc_renorm_configs_short = op_bench.config_list(
+    attrs=[
+        [512, 512],
+    ],
+    attr_names=["M", "N"],
+    tags=["short"]
+)
+
+histc_renorm_configs_long = op_bench.cross_product_configs(
+    M=[64, 1024],
+    N=[64, 4096],
+    tags=["long"]
+)
+
+
+class HistcBenchmark(op_bench.TorchBenchmarkBase):
+    def init(self, M, N):
+        self.input_one = torch.randn(M, N)
+        self.set_module_name("histc")
+
+    def forward(self):
+        return torch.histc(self.input_one, bins=100, min=-3, max=3)
+
+
+class RenormBenchmark(op_bench.TorchBenchmarkBase):
+    def init(self, M, N):
+        self.input_one = torch.randn(M, N)
+        self.set_module_name("renorm")
+
+    def forward(self):
+        return torch.renorm(self.input_one, p=2, dim=0, maxnorm=1)
+
+
+op_bench.generate_pt_test(histc_renorm_configs_short + histc_renorm_configs_long, HistcBenchmark)
+op_bench.generate_pt_test(histc_renorm_configs_short + histc_renorm_configs_long, RenormBenchmark)
+
+
+if __name__ == "__main__":
+    op_bench.benchmark_runner.main()
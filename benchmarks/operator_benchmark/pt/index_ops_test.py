@@ -0,0 +1,100 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+import operator_benchmark as op_bench
+import torch
+
+
+"""Microbenchmarks for index_add_, index_fill_, take, put_ and masked_select operators."""
+
+# An example input from this configuration is M=256, N=512, dim=0.
+index_ops_configs_short = op_bench.config_list(
+    attrs=[
+        [256, 512, 0],
+        [256, 512, 1],
+    ],
+    attr_names=["M", "N", "dim"],
+    tags=["short"]
+)
+
+index_ops_configs_long = op_bench.cross_product_configs(
+    M=[64, 1024],
+    N=[64, 1024],
+    dim=[0, 1],
+    tags=["long"]
+)
+
+
+class IndexAddBenchmark(op_bench.TorchBenchmarkBase):
+    def init(self, M, N, dim):
+        self.input_one = torch.rand(M, N)
+        self.dim = dim
+        size = M if dim == 0 else N
+        torch.manual_seed(42)
+        self.index = torch.randint(0, size, (size,))
+        self.source = torch.rand(M, N)
+        self.set_module_name("index_add_")
+
+    def forward(self):
+        return self.input_one.index_add_(self.dim, self.index, self.source)
+
+
+class IndexFillBenchmark(op_bench.TorchBenchmarkBase):
+    def init(self, M, N, dim):
+        self.input_one = torch.rand(M, N)
+        self.dim = dim
+        size = M if dim == 0 else N
+        torch.manual_seed(42)
+        self.index = torch.randint(0, size, (size // 2,))
+        self.set_module_name("index_fill_")
+
+    def forward(self):
+        return self.input_one.index_fill_(self.dim, self.index, 1.0)
+
+
+class TakeBenchmark(op_bench.TorchBenchmarkBase):
+    # dim selects a contiguous (0) or a transposed (1) input
+    def init(self, M, N, dim):
+        self.input_one = torch.rand(M, N) if dim == 0 else torch.rand(N, M).t()
+        torch.manual_seed(42)
+        self.index = torch.randint(0, M * N, (M, N))
+        self.set_module_name("take")
+
+    def forward(self):
+        return torch.take(self.input_one, self.index)
+
+
+class PutBenchmark(op_bench.TorchBenchmarkBase):
+    # dim selects a contiguous (0) or a transposed (1) input
+    def init(self, M, N, dim):
+        self.input_one = torch.rand(M, N) if dim == 0 else torch.rand(N, M).t()
+        torch.manual_seed(42)
+        self.index = torch.randint(0, M * N, (M * N // 2,))
+        self.source = torch.rand(M * N // 2)
+        self.set_module_name("put_")
+
+    def forward(self):
+        return self.input_one.put_(self.index, self.source, accumulate=True)
+
+
+class MaskedSelectBenchmark(op_bench.TorchBenchmarkBase):
+    # dim selects a contiguous (0) or a transposed (1) input
+    def init(self, M, N, dim):
+        self.input_one = torch.rand(M, N) if dim == 0 else torch.rand(N, M).t()
+        torch.manual_seed(42)
+        self.mask = torch.rand(M, N) > 0.5
+        self.set_module_name("masked_select")
+
+    def forward(self):
+        return torch.masked_select(self.input_one, self.mask)
+
+
+for benchmark in [IndexAddBenchmark, IndexFillBenchmark, TakeBenchmark,
+                  PutBenchmark, MaskedSelectBenchmark]:
+    op_bench.generate_pt_test(index_ops_configs_short + index_ops_configs_long, benchmark)
+
+
+if __name__ == "__main__":
+    op_bench.benchmark_runner.main()
@@ -0,0 +1,39 @@
+import operator_benchmark as op_bench
+import torch
+
+"""Microbenchmarks for sum reductions on skinny shapes."""
+
+
+# Few outputs with many inputs each, and many outputs with few inputs each,
+# reduced along the contiguous dimension or across it.
+sum_configs = op_bench.config_list(
+    attr_names=["R", "C"],
+    attrs=[
+        [1 << 20, 64],
+        [64, 1 << 20],
+        [1 << 16, 16],
+        [16, 1 << 16],
+    ],
+    cross_product_configs={
+        'dim': [0, 1],
+        'device': torch.testing.get_all_device_types(),
+    },
+    tags=["short"],
+)
+
+
+class SumBenchmark(op_bench.TorchBenchmarkBase):
+    def init(self, R, C, dim, device):
+        self.input_one = torch.rand(R, C, device=device)
+        self.dim = dim
+        self.set_module_name("sum")
+
+    def forward(self):
+        return self.input_one.sum(self.dim)
+
+
+op_bench.generate_pt_test(sum_configs, SumBenchmark)
+
+
+if __name__ == "__main__":
+    op_bench.benchmark_runner.main()
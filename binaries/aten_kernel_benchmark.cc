@@ -0,0 +1,461 @@
+// Microbenchmarks of the ATen CPU kernels, without the Python and autograd
+// overhead of benchmarks/operator_benchmark.
+//
+// Every benchmark sweeps the shapes, dtypes, memory formats and intra-op
+// thread counts of one kernel, and reports the memory traffic and the
+// arithmetic of the kernel as GB/s and GFLOP/s. The "roofline" counter is the
+// fraction of the roofline bound of the machine the kernel attains, where the
+// bound is the time to move the bytes at the peak bandwidth, or to do the
+// flops at the peak compute if that takes longer. The peaks are given with
+// --peak_gbps and --peak_gflops; without --peak_gbps the bandwidth of a
+// parallel memcpy is measured at startup, and without --peak_gflops the bound
+// only accounts for memory.
+//
+// The usual Google Benchmark flags apply, e.g. to produce JSON that can be
+// compared across commits with third_party/benchmark/tools/compare.py:
+//
+//   aten_kernel_benchmark --benchmark_format=json --benchmark_out=base.json
+//   aten_kernel_benchmark --benchmark_filter=BM_Sum --benchmark_repetitions=5
+
+#include "benchmark/benchmark.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+
+#include "c10/util/Flags.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+C10_DEFINE_double(peak_gbps, 0, "Peak memory bandwidth in GB/s, measured if 0");
+C10_DEFINE_double(peak_gflops, 0, "Peak compute in GFLOP/s, ignored if 0");
+
+namespace {
+
+double peak_bytes_per_second = 0;
+double peak_flops_per_second = 0;
+
+const std::vector<at::ScalarType>& dtypes() {
+  static const std::vector<at::ScalarType> types = {
+      at::kFloat, at::kDouble, at::kLong};
+  return types;
+}
+
+// The memory formats of the operands of the 4-d benchmarks.
+enum Format {
+  kContiguous = 0,
+  kChannelsLast = 1,
+  // The first operand is contiguous and the others are channels last, so the
+  // kernel iterates over operands with different strides.
+  kMixed = 2,
+};
+
+const char* formatName(int format) {
+  switch (format) {
+    case kContiguous:
+      return "contiguous";
+    case kChannelsLast:
+      return "channels_last";
+    default:
+      return "mixed";
+  }
+}
+
+at::Tensor makeTensor(
+    at::IntArrayRef sizes,
+    at::ScalarType dtype,
+    at::MemoryFormat format = at::MemoryFormat::Contiguous) {
+  auto tensor = at::isFloatingType(dtype)
+      ? at::rand(sizes, at::dtype(dtype))
+      : at::randint(1, 100, sizes, at::dtype(dtype));
+  return tensor.contiguous(format);
+}
+
+at::Tensor makeOperand(
+    at::IntArrayRef sizes,
+    at::ScalarType dtype,
+    int format,
+    bool first) {
+  const bool channels_last =
+      format == kChannelsLast || (format == kMixed && !first);
+  return makeTensor(
+      sizes,
+      dtype,
+      channels_last ? at::MemoryFormat::ChannelsLast
+                    : at::MemoryFormat::Contiguous);
+}
+
+std::vector<int64_t> threadCounts() {
+  const int64_t max_threads =
+      std::max(1u, std::thread::hardware_concurrency());
+  std::vector<int64_t> counts = {1};
+  if (max_threads > 1) {
+    counts.push_back(max_threads);
+  }
+  return counts;
+}
+
+// Sets the intra-op thread count for the duration of a benchmark.
+class ThreadsGuard {
+ public:
+  explicit ThreadsGuard(int64_t threads) : prev_(at::get_num_threads()) {
+    at::set_num_threads(threads);
+  }
+  ~ThreadsGuard() {
+    at::set_num_threads(prev_);
+  }
+
+ private:
+  int prev_;
+};
+
+// Reports the rates of a kernel that moves `bytes` and does `flops` per
+// iteration. Rate counters are divided by the elapsed time, so the roofline
+// counter, the time the roofline allows for all iterations, becomes the
+// fraction of the roofline attained.
+void setCounters(benchmark::State& state, double bytes, double flops) {
+  const double iterations = state.iterations();
+  state.counters["GB/s"] = benchmark::Counter(
+      iterations * bytes / 1e9, benchmark::Counter::kIsRate);
+  if (flops > 0) {
+    state.counters["GFLOP/s"] = benchmark::Counter(
+        iterations * flops / 1e9, benchmark::Counter::kIsRate);
+  }
+  double bound = bytes / peak_bytes_per_second;
+  if (peak_flops_per_second > 0) {
+    bound = std::max(bound, flops / peak_flops_per_second);
+  }
+  state.counters["roofline"] =
+      benchmark::Counter(iterations * bound, benchmark::Counter::kIsRate);
+  // The native parallel backend can't change its thread count, so the count
+  // the kernel actually ran with is reported too.
+  state.counters["threads"] = at::get_num_threads();
+}
+
+// Measures the memory bandwidth of a memcpy on all threads, counting the
+// bytes read and written.
+double measureBandwidth() {
+  const int64_t size = int64_t(256) << 20;
+  std::vector<char> src(size, 1);
+  std::vector<char> dst(size, 0);
+  const int64_t grain_size = size / std::max(1, at::get_num_threads());
+  auto copy = [&]() {
+    at::parallel_for(0, size, grain_size, [&](int64_t begin, int64_t end) {
+      std::memcpy(dst.data() + begin, src.data() + begin, end - begin);
+    });
+  };
+  copy();
+  double best = 0;
+  for (int i = 0; i < 5; ++i) {
+    const auto start = std::chrono::steady_clock::now();
+    copy();
+    const std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    best = std::max(best, 2.0 * size / elapsed.count());
+  }
+  benchmark::DoNotOptimize(dst.data());
+  return best;
+}
+
+///////////////// elementwise /////////////////
+
+// Args: dtype, memory format, spatial size, threads.
+void elementwiseArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"dtype", "format", "size", "threads"});
+  for (int64_t dtype = 0; dtype < int64_t(dtypes().size()); ++dtype) {
+    for (int64_t format : {kContiguous, kChannelsLast, kMixed}) {
+      for (int64_t size : {7, 28, 56}) {
+        for (int64_t threads : threadCounts()) {
+          b->Args({dtype, format, size, threads});
+        }
+      }
+    }
+  }
+}
+
+template <at::Tensor& (*Op)(at::Tensor&, const at::Tensor&, const at::Tensor&)>
+void BM_Binary(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int format = state.range(1);
+  const std::vector<int64_t> sizes = {8, 64, state.range(2), state.range(2)};
+  ThreadsGuard threads(state.range(3));
+  auto a = makeOperand(sizes, dtype, format, /*first=*/true);
+  auto b = makeOperand(sizes, dtype, format, /*first=*/false);
+  auto out = makeOperand(sizes, dtype, format, /*first=*/true);
+
+  for (auto _ : state) {
+    Op(out, a, b);
+  }
+  setCounters(state, 3.0 * a.numel() * a.element_size(), a.numel());
+  state.SetLabel(std::string(at::toString(dtype)) + "/" + formatName(format));
+}
+
+at::Tensor& add(at::Tensor& out, const at::Tensor& a, const at::Tensor& b) {
+  return at::add_out(out, a, b);
+}
+
+at::Tensor& mul(at::Tensor& out, const at::Tensor& a, const at::Tensor& b) {
+  return at::mul_out(out, a, b);
+}
+
+BENCHMARK_TEMPLATE(BM_Binary, add)->Apply(elementwiseArgs);
+BENCHMARK_TEMPLATE(BM_Binary, mul)->Apply(elementwiseArgs);
+
+void BM_Exp(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int format = state.range(1);
+  const std::vector<int64_t> sizes = {8, 64, state.range(2), state.range(2)};
+  if (!at::isFloatingType(dtype)) {
+    state.SkipWithError("exp needs a floating point dtype");
+    return;
+  }
+  ThreadsGuard threads(state.range(3));
+  auto a = makeOperand(sizes, dtype, format, /*first=*/true);
+  auto out = makeOperand(sizes, dtype, format, /*first=*/false);
+
+  for (auto _ : state) {
+    at::exp_out(out, a);
+  }
+  setCounters(state, 2.0 * a.numel() * a.element_size(), a.numel());
+  state.SetLabel(std::string(at::toString(dtype)) + "/" + formatName(format));
+}
+BENCHMARK(BM_Exp)->Apply(elementwiseArgs);
+
+// Copies to a float tensor, converting the dtype and the memory format.
+void BM_Copy(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int format = state.range(1);
+  const std::vector<int64_t> sizes = {8, 64, state.range(2), state.range(2)};
+  ThreadsGuard threads(state.range(3));
+  auto src = makeOperand(sizes, dtype, format, /*first=*/false);
+  auto dst = makeOperand(sizes, at::kFloat, format, /*first=*/true);
+
+  for (auto _ : state) {
+    dst.copy_(src);
+  }
+  setCounters(
+      state, src.numel() * double(src.element_size() + dst.element_size()), 0);
+  state.SetLabel(std::string(at::toString(dtype)) + "/" + formatName(format));
+}
+BENCHMARK(BM_Copy)->Apply(elementwiseArgs);
+
+///////////////// reductions /////////////////
+
+// Args: dtype, rows, columns, reduced dim (-1 for all), threads.
+void reductionArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"dtype", "M", "N", "dim", "threads"});
+  for (int64_t dtype = 0; dtype < int64_t(dtypes().size()); ++dtype) {
+    for (const auto& shape : std::vector<std::vector<int64_t>>{
+             {64, 65536}, {65536, 64}, {2048, 2048}}) {
+      for (int64_t dim : {-1, 0, 1}) {
+        for (int64_t threads : threadCounts()) {
+          b->Args({dtype, shape[0], shape[1], dim, threads});
+        }
+      }
+    }
+  }
+}
+
+void BM_Sum(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int64_t dim = state.range(3);
+  ThreadsGuard threads(state.range(4));
+  auto a = makeTensor({state.range(1), state.range(2)}, dtype);
+  auto out = at::empty({0}, a.options());
+
+  for (auto _ : state) {
+    if (dim == -1) {
+      at::sum_out(out, a, {0, 1});
+    } else {
+      at::sum_out(out, a, {dim});
+    }
+  }
+  setCounters(state, a.numel() * a.element_size(), a.numel());
+  state.SetLabel(at::toString(dtype));
+}
+BENCHMARK(BM_Sum)->Apply(reductionArgs);
+
+void BM_Norm(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int64_t dim = state.range(3);
+  if (!at::isFloatingType(dtype)) {
+    state.SkipWithError("norm needs a floating point dtype");
+    return;
+  }
+  ThreadsGuard threads(state.range(4));
+  auto a = makeTensor({state.range(1), state.range(2)}, dtype);
+  auto out = at::empty({0}, a.options());
+
+  for (auto _ : state) {
+    if (dim == -1) {
+      at::norm_out(out, a, 2, {0, 1});
+    } else {
+      at::norm_out(out, a, 2, {dim});
+    }
+  }
+  setCounters(state, a.numel() * a.element_size(), 2.0 * a.numel());
+  state.SetLabel(at::toString(dtype));
+}
+BENCHMARK(BM_Norm)->Apply(reductionArgs);
+
+///////////////// indexing /////////////////
+
+// Args: rows, columns, indexed dim, threads. The index has as many entries as
+// the indexed dim.
+void indexingArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"M", "N", "dim", "threads"});
+  for (const auto& shape :
+       std::vector<std::vector<int64_t>>{{256, 512}, {4096, 1024}}) {
+    for (int64_t dim : {0, 1}) {
+      for (int64_t threads : threadCounts()) {
+        b->Args({shape[0], shape[1], dim, threads});
+      }
+    }
+  }
+}
+
+at::Tensor makeIndex(int64_t size, int64_t numel) {
+  return at::randint(0, size, {numel}, at::dtype(at::kLong));
+}
+
+void BM_IndexSelect(benchmark::State& state) {
+  const int64_t dim = state.range(2);
+  ThreadsGuard threads(state.range(3));
+  auto a = makeTensor({state.range(0), state.range(1)}, at::kFloat);
+  auto index = makeIndex(a.size(dim), a.size(dim));
+  auto out = at::empty_like(a);
+
+  for (auto _ : state) {
+    at::index_select_out(out, a, dim, index);
+  }
+  setCounters(
+      state,
+      2.0 * a.numel() * a.element_size() + index.numel() * index.element_size(),
+      0);
+}
+BENCHMARK(BM_IndexSelect)->Apply(indexingArgs);
+
+void BM_IndexAdd(benchmark::State& state) {
+  const int64_t dim = state.range(2);
+  ThreadsGuard threads(state.range(3));
+  auto a = makeTensor({state.range(0), state.range(1)}, at::kFloat);
+  auto source = makeTensor({state.range(0), state.range(1)}, at::kFloat);
+  auto index = makeIndex(a.size(dim), a.size(dim));
+
+  for (auto _ : state) {
+    a.index_add_(dim, index, source);
+  }
+  setCounters(
+      state,
+      3.0 * a.numel() * a.element_size() + index.numel() * index.element_size(),
+      a.numel());
+}
+BENCHMARK(BM_IndexAdd)->Apply(indexingArgs);
+
+void BM_Gather(benchmark::State& state) {
+  const int64_t dim = state.range(2);
+  ThreadsGuard threads(state.range(3));
+  auto a = makeTensor({state.range(0), state.range(1)}, at::kFloat);
+  auto index = at::randint(0, a.size(dim), a.sizes(), at::dtype(at::kLong));
+  auto out = at::empty_like(a);
+
+  for (auto _ : state) {
+    at::gather_out(out, a, dim, index);
+  }
+  setCounters(
+      state,
+      2.0 * a.numel() * a.element_size() + index.numel() * index.element_size(),
+      0);
+}
+BENCHMARK(BM_Gather)->Apply(indexingArgs);
+
+///////////////// conv and matmul /////////////////
+
+// Args: batch, channels, spatial size, memory format, threads. The conv is a
+// 3x3 conv with padding 1 and as many output as input channels.
+void convArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"N", "C", "size", "format", "threads"});
+  for (const auto& shape : std::vector<std::vector<int64_t>>{
+           {1, 64, 56}, {8, 64, 56}, {8, 256, 14}}) {
+    for (int64_t format : {kContiguous, kChannelsLast}) {
+      for (int64_t threads : threadCounts()) {
+        b->Args({shape[0], shape[1], shape[2], format, threads});
+      }
+    }
+  }
+}
+
+void BM_Conv2d(benchmark::State& state) {
+  const int64_t N = state.range(0);
+  const int64_t C = state.range(1);
+  const int64_t size = state.range(2);
+  const int format = state.range(3);
+  ThreadsGuard threads(state.range(4));
+  auto input = makeOperand({N, C, size, size}, at::kFloat, format, false);
+  auto weight = makeOperand({C, C, 3, 3}, at::kFloat, format, false);
+
+  for (auto _ : state) {
+    auto out = at::conv2d(input, weight, {}, 1, 1);
+    benchmark::DoNotOptimize(out.data_ptr());
+  }
+  const double flops = 2.0 * N * C * size * size * C * 9;
+  setCounters(
+      state,
+      (2.0 * input.numel() + weight.numel()) * input.element_size(),
+      flops);
+  state.SetLabel(formatName(format));
+}
+BENCHMARK(BM_Conv2d)->Apply(convArgs);
+
+// Args: dtype, M, N, K, threads.
+void matmulArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"dtype", "M", "N", "K", "threads"});
+  for (int64_t dtype = 0; dtype < 2; ++dtype) {
+    for (const auto& shape : std::vector<std::vector<int64_t>>{
+             {64, 64, 64}, {512, 512, 512}, {2048, 64, 2048}}) {
+      for (int64_t threads : threadCounts()) {
+        b->Args({dtype, shape[0], shape[1], shape[2], threads});
+      }
+    }
+  }
+}
+
+void BM_Mm(benchmark::State& state) {
+  const auto dtype = dtypes()[state.range(0)];
+  const int64_t M = state.range(1);
+  const int64_t N = state.range(2);
+  const int64_t K = state.range(3);
+  ThreadsGuard threads(state.range(4));
+  auto a = makeTensor({M, K}, dtype);
+  auto b = makeTensor({K, N}, dtype);
+  auto out = at::empty({M, N}, a.options());
+
+  for (auto _ : state) {
+    at::mm_out(out, a, b);
+  }
+  setCounters(
+      state, double(M * K + K * N + M * N) * a.element_size(), 2.0 * M * N * K);
+  state.SetLabel(at::toString(dtype));
+}
+BENCHMARK(BM_Mm)->Apply(matmulArgs);
+
+} // namespace
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    return 1;
+  }
+  peak_bytes_per_second =
+      FLAGS_peak_gbps > 0 ? FLAGS_peak_gbps * 1e9 : measureBandwidth();
+  peak_flops_per_second = FLAGS_peak_gflops * 1e9;
+  std::cerr << "Roofline peaks: " << peak_bytes_per_second / 1e9 << " GB/s, "
+            << peak_flops_per_second / 1e9 << " GFLOP/s" << std::endl;
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,165 @@
+// Microbenchmarks of the fixed cost of an op in the C++ layers of the
+// framework, on tensors of one element so that the kernels take no time.
+//
+// Every benchmark adds one layer to the call of the one before it, so the
+// cost of a layer is the difference of two benchmarks:
+//
+//   BM_Empty                    output allocation
+//   BM_TensorIteratorBinaryOp   TensorIterator construction
+//   BM_NativeAddOut             the add kernel on its own
+//   BM_NativeAdd                ... with the allocation of the output
+//   BM_DispatcherFindSchema     looking up an op in the c10 dispatcher
+//   BM_DispatcherCallAdd        ... calling the kernel through the dispatcher
+//   BM_AtenAdd                  ... with the dispatch key computed from the
+//                               arguments, as in at::add
+//   BM_VariableAdd              ... through VariableType, without recording
+//   BM_VariableAddRequiresGrad  ... recording the autograd graph
+//   BM_InterpreterAdd/N         a TorchScript function of N adds, with the
+//                               adds per second as items; /0 is the cost of
+//                               the call alone
+//
+// The Python layers above these are measured by
+// benchmarks/framework_overhead_benchmark. To catch regressions, compare
+// runs across commits with third_party/benchmark/tools/compare.py, e.g.:
+//
+//   framework_overhead_benchmark --benchmark_repetitions=10 \
+//     --benchmark_report_aggregates_only=true --benchmark_format=json \
+//     --benchmark_out=base.json
+
+#include "benchmark/benchmark.h"
+
+#include <ATen/ATen.h>
+#include <ATen/NativeFunctions.h>
+#include <ATen/core/dispatch/Dispatcher.h>
+#include <ATen/native/TensorIterator.h>
+
+#include "torch/csrc/api/include/torch/jit.h"
+#include "torch/script.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+at::Tensor tinyTensor() {
+  return at::ones({1});
+}
+
+// A TorchScript function of `num_adds` adds of its input.
+std::string addChainSource(int64_t num_adds) {
+  std::string source = "def add_chain(x):\n";
+  for (int64_t i = 0; i < num_adds; ++i) {
+    source += "    x = x + x\n";
+  }
+  source += "    return x\n";
+  return source;
+}
+
+} // namespace
+
+static void BM_Empty(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::empty({1}));
+  }
+}
+BENCHMARK(BM_Empty);
+
+static void BM_TensorIteratorBinaryOp(benchmark::State& state) {
+  auto a = tinyTensor();
+  auto b = tinyTensor();
+  auto out = tinyTensor();
+  for (auto _ : state) {
+    auto iter = at::TensorIterator::binary_op(out, a, b);
+    benchmark::DoNotOptimize(iter.numel());
+  }
+}
+BENCHMARK(BM_TensorIteratorBinaryOp);
+
+static void BM_NativeAddOut(benchmark::State& state) {
+  auto a = tinyTensor();
+  auto b = tinyTensor();
+  auto out = tinyTensor();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::native::add_out(out, a, b, 1));
+  }
+}
+BENCHMARK(BM_NativeAddOut);
+
+static void BM_NativeAdd(benchmark::State& state) {
+  auto a = tinyTensor();
+  auto b = tinyTensor();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::native::add(a, b, 1));
+  }
+}
+BENCHMARK(BM_NativeAdd);
+
+static void BM_DispatcherFindSchema(benchmark::State& state) {
+  auto& dispatcher = c10::Dispatcher::singleton();
+  const c10::OperatorName name{"aten::add", "Tensor"};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(dispatcher.findSchema(name));
+  }
+}
+BENCHMARK(BM_DispatcherFindSchema);
+
+static void BM_DispatcherCallAdd(benchmark::State& state) {
+  auto& dispatcher = c10::Dispatcher::singleton();
+  const auto op = dispatcher.findSchema({"aten::add", "Tensor"}).value();
+  auto a = tinyTensor();
+  auto b = tinyTensor();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        dispatcher.callUnboxed<at::Tensor, const at::Tensor&, const at::Tensor&, at::Scalar>(
+            op, c10::TensorTypeId::CPUTensorId, a, b, 1));
+  }
+}
+BENCHMARK(BM_DispatcherCallAdd);
+
+static void BM_AtenAdd(benchmark::State& state) {
+  auto a = tinyTensor();
+  auto b = tinyTensor();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::add(a, b));
+  }
+}
+BENCHMARK(BM_AtenAdd);
+
+static void BM_VariableAdd(benchmark::State& state) {
+  auto a = torch::ones({1});
+  auto b = torch::ones({1});
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::add(a, b));
+  }
+}
+BENCHMARK(BM_VariableAdd);
+
+static void BM_VariableAddRequiresGrad(benchmark::State& state) {
+  auto a = torch::ones({1}, torch::requires_grad());
+  auto b = torch::ones({1}, torch::requires_grad());
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::add(a, b));
+  }
+}
+BENCHMARK(BM_VariableAddRequiresGrad);
+
+static void BM_InterpreterAdd(benchmark::State& state) {
+  torch::autograd::AutoGradMode grad_mode(false);
+  const int64_t num_adds = state.range(0);
+  auto cu = torch::jit::compile(addChainSource(num_adds));
+  auto& fn = cu->get_function("add_chain");
+  const std::vector<c10::IValue> inputs = {torch::ones({1})};
+  // The first runs optimize the graph.
+  for (int i = 0; i < 10; ++i) {
+    fn(inputs);
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(fn(inputs));
+  }
+  if (num_adds > 0) {
+    state.SetItemsProcessed(state.iterations() * num_adds);
+  }
+}
+BENCHMARK(BM_InterpreterAdd)->Arg(0)->Arg(1)->Arg(10)->Arg(100);
+
+BENCHMARK_MAIN();
@@ -14,13 +14,24 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include "c10/core/CPUAllocator.h"
 #include "caffe2/core/timer.h"
 #include "caffe2/utils/string_utils.h"
 #include "torch/csrc/autograd/grad_mode.h"
+#include "torch/csrc/autograd/record_function.h"
 #include "torch/csrc/jit/import.h"
 #include "torch/script.h"
 
@@ -37,6 +48,12 @@ C10_DEFINE_string(
     "semicolon to separate the dimension of different "
     "tensors.");
 C10_DEFINE_string(input_type, "", "Input type (uint8_t/float)");
+C10_DEFINE_string(
+    input_shape_file,
+    "",
+    "A file of input dims to replay instead of --input_dims, one request "
+    "per line in the format of --input_dims. The requests cycle through "
+    "the lines; empty lines and lines starting with # are skipped.");
 C10_DEFINE_bool(
   print_output,
   false,
@@ -47,6 +64,30 @@ C10_DEFINE_bool(
   report_pep,
   false,
   "Whether to print performance stats for AI-PEP.");
+C10_DEFINE_int(
+    request_threads,
+    1,
+    "The number of threads sending requests concurrently, which share the "
+    "--iter requests.");
+C10_DEFINE_int(
+    intra_op_threads,
+    0,
+    "The number of intra-op threads, the default of ATen if 0.");
+C10_DEFINE_int(
+    inter_op_threads,
+    0,
+    "The number of inter-op threads, the default of ATen if 0.");
+C10_DEFINE_bool(
+    profile_ops,
+    false,
+    "Whether to time every operator with RecordFunction and print the time "
+    "per operator of the main runs.");
+C10_DEFINE_int(
+    profile_top_ops,
+    30,
+    "The number of operators printed by --profile_ops, all if 0.");
+
+namespace {
 
 std::vector<std::string>
 split(char separator, const std::string& string, bool ignore_empty = true) {
@@ -61,26 +102,10 @@ split(char separator, const std::string& string, bool ignore_empty = true) {
   return pieces;
 }
 
-int main(int argc, char** argv) {
-  c10::SetUsageMessage(
-    "Run speed benchmark for pytorch model.\n"
-    "Example usage:\n"
-    "./speed_benchmark_torch"
-    " --model=<model_file>"
-    " --input_dims=\"1,3,224,224\""
-    " --input_type=float"
-    " --warmup=5"
-    " --iter=20");
-  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
-    std::cerr << "Failed to parse command line flags!" << std::endl;
-    return 1;
-  }
-
-  CAFFE_ENFORCE_GE(FLAGS_input_dims.size(), 0, "Input dims must be specified.");
-  CAFFE_ENFORCE_GE(FLAGS_input_type.size(), 0, "Input type must be specified.");
-
-  std::vector<std::string> input_dims_list = split(';', FLAGS_input_dims);
-  std::vector<std::string> input_type_list = split(';', FLAGS_input_type);
+std::vector<c10::IValue> makeInputs(
+    const std::string& input_dims,
+    const std::vector<std::string>& input_type_list) {
+  std::vector<std::string> input_dims_list = split(';', input_dims);
   CAFFE_ENFORCE_EQ(
       input_dims_list.size(),
       input_type_list.size(),
@@ -101,6 +126,253 @@ int main(int argc, char** argv) {
       CAFFE_THROW("Unsupported input type: ", input_type_list[i]);
     }
   }
+  return inputs;
+}
+
+// The inputs of every request to replay: the lines of --input_shape_file, or
+// --input_dims.
+std::vector<std::vector<c10::IValue>> makeRequests() {
+  std::vector<std::string> input_type_list = split(';', FLAGS_input_type);
+  std::vector<std::vector<c10::IValue>> requests;
+  if (FLAGS_input_shape_file.empty()) {
+    requests.push_back(makeInputs(FLAGS_input_dims, input_type_list));
+    return requests;
+  }
+  std::ifstream file(FLAGS_input_shape_file);
+  CAFFE_ENFORCE(
+      file.good(), "Can't open input shape file ", FLAGS_input_shape_file);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    requests.push_back(makeInputs(line, input_type_list));
+  }
+  CAFFE_ENFORCE(
+      !requests.empty(), "No input dims in ", FLAGS_input_shape_file);
+  return requests;
+}
+
+// Wraps the CPU allocator to track the bytes allocated and their high-water
+// mark.
+class TrackingCPUAllocator final : public at::Allocator {
+ public:
+  explicit TrackingCPUAllocator(at::Allocator* base) : base_(base) {}
+
+  at::DataPtr allocate(size_t nbytes) const override {
+    auto* allocation = new Allocation{base_->allocate(nbytes), nbytes, this};
+    const int64_t current = current_ += nbytes;
+    int64_t peak = peak_.load();
+    while (current > peak && !peak_.compare_exchange_weak(peak, current)) {
+    }
+    void* data = allocation->data_ptr.get();
+    return {data, allocation, &deleteAllocation, at::Device(at::DeviceType::CPU)};
+  }
+
+  int64_t currentBytes() const {
+    return current_;
+  }
+
+  int64_t peakBytes() const {
+    return peak_;
+  }
+
+  void resetPeak() {
+    peak_ = current_.load();
+  }
+
+ private:
+  struct Allocation {
+    at::DataPtr data_ptr;
+    size_t nbytes;
+    const TrackingCPUAllocator* owner;
+  };
+
+  static void deleteAllocation(void* ctx) {
+    auto* allocation = static_cast<Allocation*>(ctx);
+    allocation->owner->current_ -= allocation->nbytes;
+    delete allocation;
+  }
+
+  at::Allocator* base_;
+  mutable std::atomic<int64_t> current_{0};
+  mutable std::atomic<int64_t> peak_{0};
+};
+
+// The time spent in every operator, aggregated from RecordFunction callbacks
+// on all threads. The self time of an operator excludes the operators it
+// calls.
+class OpProfiler {
+ public:
+  struct OpTime {
+    int64_t calls = 0;
+    int64_t total_ns = 0;
+    int64_t self_ns = 0;
+  };
+
+  void start() {
+    torch::autograd::profiler::pushCallback(
+        [this](const torch::autograd::profiler::RecordFunction& /* fn */) {
+          threadState().stack.push_back({nowNs(), 0});
+        },
+        [this](const torch::autograd::profiler::RecordFunction& fn) {
+          auto& state = threadState();
+          if (state.stack.empty()) {
+            // the op started before the callback was pushed
+            return;
+          }
+          const auto frame = state.stack.back();
+          state.stack.pop_back();
+          const int64_t elapsed = nowNs() - frame.start_ns;
+          if (!state.stack.empty()) {
+            state.stack.back().children_ns += elapsed;
+          }
+          std::lock_guard<std::mutex> guard(state.mutex);
+          auto& time = state.ops[fn.name().str()];
+          time.calls++;
+          time.total_ns += elapsed;
+          time.self_ns += elapsed - frame.children_ns;
+        });
+  }
+
+  void stop() {
+    torch::autograd::profiler::popCallback();
+  }
+
+  std::map<std::string, OpTime> ops() {
+    std::map<std::string, OpTime> ops;
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& state : states_) {
+      std::lock_guard<std::mutex> state_guard(state->mutex);
+      for (const auto& op : state->ops) {
+        auto& time = ops[op.first];
+        time.calls += op.second.calls;
+        time.total_ns += op.second.total_ns;
+        time.self_ns += op.second.self_ns;
+      }
+    }
+    return ops;
+  }
+
+ private:
+  struct Frame {
+    int64_t start_ns;
+    int64_t children_ns;
+  };
+
+  struct ThreadState {
+    std::vector<Frame> stack;
+    // guards ops, which is read by ops() while the thread may still record
+    std::mutex mutex;
+    std::map<std::string, OpTime> ops;
+  };
+
+  static int64_t nowNs() {
+    return duration_cast<nanoseconds>(
+               steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // The state of the calling thread, which is kept alive by states_ after
+  // the thread exits.
+  ThreadState& threadState() {
+    thread_local std::shared_ptr<ThreadState> state;
+    if (!state) {
+      state = std::make_shared<ThreadState>();
+      std::lock_guard<std::mutex> guard(mutex_);
+      states_.push_back(state);
+    }
+    return *state;
+  }
+
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadState>> states_;
+};
+
+void printOpProfile(OpProfiler& profiler, int64_t iters) {
+  auto ops = profiler.ops();
+  std::vector<std::pair<std::string, OpProfiler::OpTime>> sorted(
+      ops.begin(), ops.end());
+  std::sort(
+      sorted.begin(),
+      sorted.end(),
+      [](const std::pair<std::string, OpProfiler::OpTime>& a,
+         const std::pair<std::string, OpProfiler::OpTime>& b) {
+        return a.second.self_ns > b.second.self_ns;
+      });
+  int64_t self_ns = 0;
+  for (const auto& op : sorted) {
+    self_ns += op.second.self_ns;
+  }
+  if (FLAGS_profile_top_ops > 0 &&
+      sorted.size() > static_cast<size_t>(FLAGS_profile_top_ops)) {
+    sorted.resize(FLAGS_profile_top_ops);
+  }
+
+  std::cout << "Time per operator, per iter:" << std::endl;
+  std::cout << std::setw(40) << std::left << "Operator" << std::right
+            << std::setw(12) << "Calls" << std::setw(14) << "Self (ms)"
+            << std::setw(14) << "Total (ms)" << std::setw(10) << "Self %"
+            << std::endl;
+  for (const auto& op : sorted) {
+    const auto& time = op.second;
+    std::cout << std::setw(40) << std::left << op.first << std::right
+              << std::setw(12) << static_cast<double>(time.calls) / iters
+              << std::fixed << std::setprecision(3) << std::setw(14)
+              << 1e-6 * time.self_ns / iters << std::setw(14)
+              << 1e-6 * time.total_ns / iters << std::setprecision(1)
+              << std::setw(10)
+              << (self_ns == 0 ? 0.0 : 100.0 * time.self_ns / self_ns)
+              << std::defaultfloat << std::endl;
+  }
+}
+
+float percentile(const std::vector<float>& sorted_times, double p) {
+  if (sorted_times.empty()) {
+    return 0;
+  }
+  size_t index = static_cast<size_t>(p / 100.0 * (sorted_times.size() - 1));
+  return sorted_times[index];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  c10::SetUsageMessage(
+    "Run speed benchmark for pytorch model.\n"
+    "Example usage:\n"
+    "./speed_benchmark_torch"
+    " --model=<model_file>"
+    " --input_dims=\"1,3,224,224\""
+    " --input_type=float"
+    " --warmup=5"
+    " --iter=20");
+  if (!c10::ParseCommandLineFlags(&argc, &argv)) {
+    std::cerr << "Failed to parse command line flags!" << std::endl;
+    return 1;
+  }
+
+  CAFFE_ENFORCE_GE(FLAGS_input_dims.size(), 0, "Input dims must be specified.");
+  CAFFE_ENFORCE_GE(FLAGS_input_type.size(), 0, "Input type must be specified.");
+  CAFFE_ENFORCE_GE(
+      FLAGS_request_threads, 1, "At least one request thread is needed.");
+
+  if (FLAGS_inter_op_threads > 0) {
+    at::set_num_interop_threads(FLAGS_inter_op_threads);
+  }
+  if (FLAGS_intra_op_threads > 0) {
+    at::set_num_threads(FLAGS_intra_op_threads);
+  }
+
+  // Installed before anything is allocated, so that the high-water mark
+  // covers the model and the inputs. Leaked, as tensors that outlive main
+  // still call back into it when they are freed.
+  auto& allocator =
+      *new TrackingCPUAllocator(c10::GetDefaultCPUAllocator());
+  c10::SetCPUAllocator(&allocator);
+
+  const auto requests = makeRequests();
+  const auto& inputs = requests.front();
 
   auto qengines = at::globalContext().supportedQEngines();
   if (std::find(qengines.begin(), qengines.end(), at::QEngine::QNNPACK) != qengines.end()) {
@@ -113,6 +385,7 @@ int main(int argc, char** argv) {
   if (FLAGS_print_output) {
     std::cout << module.forward(inputs) << std::endl;
   }
+  const int64_t model_bytes = allocator.currentBytes();
 
   std::cout << "Starting benchmark." << std::endl;
   std::cout << "Running warmup runs." << std::endl;
@@ -122,7 +395,7 @@ int main(int argc, char** argv) {
       FLAGS_warmup,
       ".");
   for (int i = 0; i < FLAGS_warmup; ++i) {
-    module.forward(inputs);
+    module.forward(requests[i % requests.size()]);
   }
 
   std::cout << "Main runs." << std::endl;
@@ -131,17 +404,52 @@ int main(int argc, char** argv) {
       "Number of main runs should be non negative, provided ",
       FLAGS_iter,
       ".");
-  caffe2::Timer timer;
+  OpProfiler profiler;
+  if (FLAGS_profile_ops) {
+    profiler.start();
+  }
+  allocator.resetPeak();
+
+  // Every request thread takes the next request until --iter are done.
+  std::atomic<int> next_request{0};
+  std::mutex times_mutex;
   std::vector<float> times;
+  auto run_requests = [&]() {
+    std::vector<float> thread_times;
+    for (int i = next_request++; i < FLAGS_iter; i = next_request++) {
+      auto start = high_resolution_clock::now();
+      module.forward(requests[i % requests.size()]);
+      auto stop = high_resolution_clock::now();
+      auto duration = duration_cast<microseconds>(stop - start);
+      thread_times.push_back(duration.count());
+    }
+    std::lock_guard<std::mutex> lock(times_mutex);
+    times.insert(times.end(), thread_times.begin(), thread_times.end());
+  };
+
+  caffe2::Timer timer;
   auto millis = timer.MilliSeconds();
-  for (int i = 0; i < FLAGS_iter; ++i) {
-    auto start = high_resolution_clock::now();
-    module.forward(inputs);
-    auto stop = high_resolution_clock::now();
-    auto duration = duration_cast<microseconds>(stop - start);
-    times.push_back(duration.count());
+  if (FLAGS_request_threads == 1) {
+    run_requests();
+  } else {
+    std::vector<std::thread> threads;
+    for (int i = 0; i < FLAGS_request_threads; ++i) {
+      threads.emplace_back([&]() {
+        // grad mode and the OpenMP thread count are thread local
+        torch::autograd::AutoGradMode thread_guard(false);
+        at::init_num_threads();
+        run_requests();
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
   }
   millis = timer.MilliSeconds();
+  if (FLAGS_profile_ops) {
+    profiler.stop();
+  }
+
   if (FLAGS_report_pep) {
     for (auto t : times) {
       std::cout << "PyTorchObserver {\"type\": \"NET\", \"unit\": \"us\", \"metric\": \"latency\", \"value\": \"" << t << "\"}" << std::endl;
@@ -152,5 +460,17 @@ int main(int argc, char** argv) {
             << ". Iters per second: " << 1000.0 * FLAGS_iter / millis
             << std::endl;
 
+  std::sort(times.begin(), times.end());
+  std::cout << "Latency (ms): p50 " << percentile(times, 50) / 1000
+            << ", p90 " << percentile(times, 90) / 1000 << ", p99 "
+            << percentile(times, 99) / 1000 << ", max "
+            << percentile(times, 100) / 1000 << std::endl;
+  std::cout << "CPU memory (MB): model and inputs " << model_bytes / 1e6
+            << ", high-water mark of the main runs "
+            << allocator.peakBytes() / 1e6 << std::endl;
+  if (FLAGS_profile_ops && FLAGS_iter > 0) {
+    printOpProfile(profiler, FLAGS_iter);
+  }
+
   return 0;
 }
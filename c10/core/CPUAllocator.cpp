@@ -1,4 +1,5 @@
 #include <c10/core/CPUAllocator.h>
+#include <c10/core/CPUCachingAllocator.h>
 #include <c10/core/DeviceType.h>
 
 // TODO: rename flags to C10
@@ -112,6 +113,9 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
   DefaultCPUAllocator() {}
   ~DefaultCPUAllocator() override {}
   at::DataPtr allocate(size_t nbytes) const override {
+    if (FLAGS_caffe2_cpu_allocator_use_caching) {
+      return CPUCachingAllocator::get()->allocate(nbytes);
+    }
     void* data = alloc_cpu(nbytes);
     if (FLAGS_caffe2_report_cpu_memory_usage && nbytes > 0) {
       getMemoryAllocationReporter().New(data, nbytes);
@@ -129,6 +133,9 @@ struct C10_API DefaultCPUAllocator final : at::Allocator {
   }
 
   at::DeleterFnPtr raw_deleter() const override {
+    if (FLAGS_caffe2_cpu_allocator_use_caching) {
+      return CPUCachingAllocator::get()->raw_deleter();
+    }
     if (FLAGS_caffe2_report_cpu_memory_usage) {
       return &ReportAndDelete;
     }
@@ -160,6 +167,14 @@ at::Allocator* GetDefaultCPUAllocator() {
   return &g_cpu_alloc;
 }
 
+bool IsPlainDefaultCPUAllocator(at::Allocator* allocator) {
+  return allocator == &g_cpu_alloc &&
+      !FLAGS_caffe2_cpu_allocator_use_caching &&
+      !FLAGS_caffe2_report_cpu_memory_usage &&
+      !FLAGS_caffe2_cpu_allocator_do_zero_fill &&
+      !FLAGS_caffe2_cpu_allocator_do_junk_fill;
+}
+
 REGISTER_ALLOCATOR(DeviceType::CPU, &g_cpu_alloc);
 
 void MemoryAllocationReporter::New(void* ptr, size_t nbytes) {
@@ -39,4 +39,9 @@ C10_API void SetCPUAllocator(at::Allocator* alloc);
 // Get the Default CPU Allocator
 C10_API at::Allocator* GetDefaultCPUAllocator();
 
+// Whether allocations from `allocator` are plain blocks of the default CPU
+// allocator, with no caching, reporting or fill flags that small buffers
+// bypassing the allocator would skip.
+C10_API bool IsPlainDefaultCPUAllocator(at::Allocator* allocator);
+
 } // namespace c10
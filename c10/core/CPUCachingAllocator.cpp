@@ -0,0 +1,387 @@
+#include <c10/core/CPUCachingAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/Exception.h>
+#include <c10/util/numa.h>
+
+C10_DEFINE_bool(
+    caffe2_cpu_allocator_use_caching,
+    false,
+    "If set, the default CPU allocator caches freed blocks for reuse "
+    "instead of returning them to the system allocator");
+
+namespace c10 {
+namespace CPUCachingAllocator {
+
+namespace {
+
+// Every block is preceded by a header recording its rounded size, so that
+// raw_delete can find its pool without a pointer lookup table. The header
+// takes a whole alignment unit to keep the payload gAlignment aligned.
+struct BlockHeader {
+  size_t size;
+};
+constexpr size_t kHeaderSize = gAlignment;
+static_assert(sizeof(BlockHeader) <= kHeaderSize, "block header too large");
+
+constexpr size_t kMinBlockSize = 64;          // smallest size class
+constexpr size_t kSmallSize = 262144;         // largest "small" size class (256 KiB)
+constexpr int kNumSizeClasses = 13;           // 64 B, 128 B, ..., 256 KiB
+constexpr size_t kThreadCacheClassBytes = 1048576; // per-class cap of each thread cache (1 MiB)
+constexpr size_t kRoundLarge = 65536;         // round up large allocs to 64 KiB
+
+struct AtomicStat {
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+  std::atomic<int64_t> allocated{0};
+  std::atomic<int64_t> freed{0};
+
+  void update(int64_t amount) {
+    int64_t now = current.fetch_add(amount) + amount;
+    if (amount > 0) {
+      allocated += amount;
+      int64_t old_peak = peak.load();
+      while (now > old_peak && !peak.compare_exchange_weak(old_peak, now)) {
+      }
+    } else {
+      freed += -amount;
+    }
+  }
+
+  Stat load() const {
+    Stat stat;
+    stat.current = current.load();
+    stat.peak = peak.load();
+    stat.allocated = allocated.load();
+    stat.freed = freed.load();
+    return stat;
+  }
+};
+
+typedef std::array<AtomicStat, static_cast<size_t>(StatType::NUM_TYPES)> AtomicStatArray;
+
+struct AtomicAllocatorStats {
+  AtomicStatArray allocation;
+  AtomicStatArray segment;
+  AtomicStatArray allocated_bytes;
+  AtomicStatArray reserved_bytes;
+  std::atomic<int64_t> num_cache_hits{0};
+  std::atomic<int64_t> num_cache_misses{0};
+  std::atomic<int64_t> num_alloc_retries{0};
+};
+
+AtomicAllocatorStats& stats() {
+  static AtomicAllocatorStats* stats_ = new AtomicAllocatorStats();
+  return *stats_;
+}
+
+void update_stat_array(AtomicStatArray& stat_array, int64_t amount, size_t size) {
+  stat_array[static_cast<size_t>(StatType::AGGREGATE)].update(amount);
+  auto pool = size <= kSmallSize ? StatType::SMALL_POOL : StatType::LARGE_POOL;
+  stat_array[static_cast<size_t>(pool)].update(amount);
+}
+
+StatArray load_stat_array(const AtomicStatArray& stat_array) {
+  StatArray result;
+  for (size_t i = 0; i < stat_array.size(); ++i) {
+    result[i] = stat_array[i].load();
+  }
+  return result;
+}
+
+BlockHeader* header_of(void* ptr) {
+  return reinterpret_cast<BlockHeader*>(static_cast<char*>(ptr) - kHeaderSize);
+}
+
+int size_class(size_t size) {
+  int cls = 0;
+  for (size_t s = kMinBlockSize; s < size; s <<= 1) {
+    cls++;
+  }
+  return cls;
+}
+
+size_t round_size(size_t size) {
+  if (size <= kSmallSize) {
+    return kMinBlockSize << size_class(size);
+  }
+  return kRoundLarge * ((size + kRoundLarge - 1) / kRoundLarge);
+}
+
+// Applies the zero-fill / junk-fill debugging flags to a reused block; fresh
+// blocks already had them applied by alloc_cpu.
+void fill_reused_block(void* ptr, size_t size) {
+  if (FLAGS_caffe2_cpu_allocator_do_zero_fill) {
+    memset(ptr, 0, size);
+  } else if (FLAGS_caffe2_cpu_allocator_do_junk_fill) {
+    memset_junk(ptr, size);
+  }
+}
+
+void* alloc_block(size_t size) {
+  void* base;
+  try {
+    base = alloc_cpu(size + kHeaderSize);
+  } catch (const c10::Error&) {
+    // Release everything we cache back to the system and retry once.
+    stats().num_alloc_retries++;
+    emptyCache();
+    base = alloc_cpu(size + kHeaderSize);
+  }
+  reinterpret_cast<BlockHeader*>(base)->size = size;
+  update_stat_array(stats().segment, 1, size);
+  update_stat_array(stats().reserved_bytes, size, size);
+  return static_cast<char*>(base) + kHeaderSize;
+}
+
+void release_block(void* ptr) {
+  size_t size = header_of(ptr)->size;
+  free_cpu(header_of(ptr));
+  update_stat_array(stats().segment, -1, size);
+  update_stat_array(stats().reserved_bytes, -static_cast<int64_t>(size), size);
+}
+
+// Per-thread free lists of small blocks. The mutex is only contended when
+// emptyCache() runs on another thread.
+struct ThreadCache;
+
+struct ThreadCacheRegistry {
+  std::mutex mutex;
+  std::unordered_set<ThreadCache*> caches;
+};
+
+ThreadCacheRegistry& registry() {
+  static ThreadCacheRegistry* registry_ = new ThreadCacheRegistry();
+  return *registry_;
+}
+
+// Set once the calling thread's cache has been destroyed, so that frees
+// running later in thread teardown go straight to the system allocator.
+thread_local bool t_thread_cache_destroyed = false;
+
+struct ThreadCache {
+  std::mutex mutex;
+  std::array<std::vector<void*>, kNumSizeClasses> blocks;
+
+  ThreadCache() {
+    std::lock_guard<std::mutex> lock(registry().mutex);
+    registry().caches.insert(this);
+  }
+
+  ~ThreadCache() {
+    {
+      std::lock_guard<std::mutex> lock(registry().mutex);
+      registry().caches.erase(this);
+    }
+    release();
+    t_thread_cache_destroyed = true;
+  }
+
+  void* pop(int cls) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& list = blocks[cls];
+    if (list.empty()) {
+      return nullptr;
+    }
+    void* ptr = list.back();
+    list.pop_back();
+    return ptr;
+  }
+
+  bool push(int cls, void* ptr) {
+    size_t max_blocks = std::max<size_t>(
+        1, kThreadCacheClassBytes / (kMinBlockSize << cls));
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& list = blocks[cls];
+    if (list.size() >= max_blocks) {
+      return false;
+    }
+    list.push_back(ptr);
+    return true;
+  }
+
+  void release() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto& list : blocks) {
+      for (void* ptr : list) {
+        release_block(ptr);
+      }
+      list.clear();
+    }
+  }
+};
+
+ThreadCache* thread_cache() {
+  if (t_thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+// Free large blocks, shared by all threads and ordered by size for best fit.
+struct LargePool {
+  std::mutex mutex;
+  std::multimap<size_t, void*> blocks;
+};
+
+LargePool& large_pool() {
+  static LargePool* pool_ = new LargePool();
+  return *pool_;
+}
+
+void* alloc_small(size_t size) {
+  int cls = size_class(size);
+  ThreadCache* cache = thread_cache();
+  void* ptr = cache ? cache->pop(cls) : nullptr;
+  if (ptr) {
+    stats().num_cache_hits++;
+    fill_reused_block(ptr, size);
+    return ptr;
+  }
+  stats().num_cache_misses++;
+  return alloc_block(size);
+}
+
+void* alloc_large(size_t size) {
+  // A cached block is reused if it wastes at most a quarter of the request;
+  // otherwise a large cached buffer could pin memory for a much smaller one.
+  size_t max_size = size + size / 4;
+  void* ptr = nullptr;
+  size_t block_size = 0;
+  {
+    auto& pool = large_pool();
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    auto it = pool.blocks.lower_bound(size);
+    if (it != pool.blocks.end() && it->first <= max_size) {
+      block_size = it->first;
+      ptr = it->second;
+      pool.blocks.erase(it);
+    }
+  }
+  if (ptr) {
+    stats().num_cache_hits++;
+    // Cached blocks may have been touched by a thread on another node, so
+    // keep the alloc_cpu guarantee that memory lives on the caller's node.
+    NUMAMove(ptr, block_size, GetCurrentNUMANode());
+    fill_reused_block(ptr, block_size);
+    return ptr;
+  }
+  stats().num_cache_misses++;
+  return alloc_block(size);
+}
+
+struct CachingCPUAllocator final : public at::Allocator {
+  at::DataPtr allocate(size_t nbytes) const override {
+    void* data = raw_alloc(nbytes);
+    return {data, data, &raw_delete, at::Device(at::DeviceType::CPU)};
+  }
+
+  at::DeleterFnPtr raw_deleter() const override {
+    return &raw_delete;
+  }
+};
+
+CachingCPUAllocator caching_cpu_allocator;
+
+} // namespace
+
+void* raw_alloc(size_t nbytes) {
+  if (nbytes == 0) {
+    return nullptr;
+  }
+  CAFFE_ENFORCE(
+      ((ptrdiff_t)nbytes) >= 0,
+      "CPUCachingAllocator: raw_alloc() called with negative number: ", nbytes);
+  size_t size = round_size(nbytes);
+  void* ptr = size <= kSmallSize ? alloc_small(size) : alloc_large(size);
+  update_stat_array(stats().allocation, 1, size);
+  update_stat_array(stats().allocated_bytes, size, size);
+  return ptr;
+}
+
+void raw_delete(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  size_t size = header_of(ptr)->size;
+  update_stat_array(stats().allocation, -1, size);
+  update_stat_array(stats().allocated_bytes, -static_cast<int64_t>(size), size);
+  if (size <= kSmallSize) {
+    ThreadCache* cache = thread_cache();
+    if (!cache || !cache->push(size_class(size), ptr)) {
+      release_block(ptr);
+    }
+    return;
+  }
+  auto& pool = large_pool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  pool.blocks.emplace(size, ptr);
+}
+
+at::Allocator* get() {
+  return &caching_cpu_allocator;
+}
+
+void emptyCache() {
+  {
+    auto& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.mutex);
+    for (ThreadCache* cache : reg.caches) {
+      cache->release();
+    }
+  }
+  auto& pool = large_pool();
+  std::lock_guard<std::mutex> lock(pool.mutex);
+  for (auto& entry : pool.blocks) {
+    release_block(entry.second);
+  }
+  pool.blocks.clear();
+}
+
+AllocatorStats getStats() {
+  auto& s = stats();
+  AllocatorStats result;
+  result.allocation = load_stat_array(s.allocation);
+  result.segment = load_stat_array(s.segment);
+  result.allocated_bytes = load_stat_array(s.allocated_bytes);
+  result.reserved_bytes = load_stat_array(s.reserved_bytes);
+  result.num_cache_hits = s.num_cache_hits.load();
+  result.num_cache_misses = s.num_cache_misses.load();
+  result.num_alloc_retries = s.num_alloc_retries.load();
+  return result;
+}
+
+void resetAccumulatedStats() {
+  auto& s = stats();
+  for (AtomicStatArray* stat_array :
+       {&s.allocation, &s.segment, &s.allocated_bytes, &s.reserved_bytes}) {
+    for (auto& stat : *stat_array) {
+      stat.allocated = 0;
+      stat.freed = 0;
+    }
+  }
+  s.num_cache_hits = 0;
+  s.num_cache_misses = 0;
+  s.num_alloc_retries = 0;
+}
+
+void resetPeakStats() {
+  auto& s = stats();
+  for (AtomicStatArray* stat_array :
+       {&s.allocation, &s.segment, &s.allocated_bytes, &s.reserved_bytes}) {
+    for (auto& stat : *stat_array) {
+      stat.peak = stat.current.load();
+    }
+  }
+}
+
+} // namespace CPUCachingAllocator
+} // namespace c10
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <c10/core/Allocator.h>
+#include <c10/util/Flags.h>
+
+C10_DECLARE_bool(caffe2_cpu_allocator_use_caching);
+
+namespace c10 {
+
+// An opt-in caching allocator for CPU memory, modeled after the CUDA caching
+// allocator in c10/cuda/CUDACachingAllocator.h.
+//
+// Small requests (up to 256 KiB) are rounded up to a power of two and served
+// from per-thread free lists, so the common alloc/free pair never takes a
+// lock. Larger requests are rounded to a multiple of 64 KiB and served
+// best-fit from a block pool shared by all threads, which avoids repeatedly
+// mmapping and page faulting large buffers. Blocks are only returned to the
+// system by emptyCache() or when their owning thread exits.
+//
+// The allocator is used by the default CPU allocator when the
+// caffe2_cpu_allocator_use_caching flag is set, or it can be installed
+// directly with SetCPUAllocator(CPUCachingAllocator::get()).
+namespace CPUCachingAllocator {
+
+struct Stat {
+  int64_t current = 0;
+  int64_t peak = 0;
+  int64_t allocated = 0;
+  int64_t freed = 0;
+};
+
+enum struct StatType : uint64_t {
+  AGGREGATE = 0,
+  SMALL_POOL = 1,
+  LARGE_POOL = 2,
+  NUM_TYPES = 3  // remember to update this whenever a new stat type is added
+};
+
+typedef std::array<Stat, static_cast<size_t>(StatType::NUM_TYPES)> StatArray;
+
+// Struct containing memory allocator summary statistics.
+struct AllocatorStats {
+  // COUNT: allocations requested by client code
+  StatArray allocation;
+  // COUNT: number of blocks obtained from the system allocator
+  StatArray segment;
+
+  // SUM: bytes handed out to client code (after rounding)
+  StatArray allocated_bytes;
+  // SUM: bytes held by this allocator (both free and used)
+  StatArray reserved_bytes;
+
+  // COUNT: allocations served from a cached block
+  int64_t num_cache_hits = 0;
+  // COUNT: allocations that had to go to the system allocator
+  int64_t num_cache_misses = 0;
+  // COUNT: failed system allocations retried after a cache flush
+  int64_t num_alloc_retries = 0;
+};
+
+C10_API void* raw_alloc(size_t nbytes);
+C10_API void raw_delete(void* ptr);
+
+C10_API at::Allocator* get();
+C10_API void emptyCache();
+C10_API AllocatorStats getStats();
+C10_API void resetAccumulatedStats();
+C10_API void resetPeakStats();
+
+} // namespace CPUCachingAllocator
+
+} // namespace c10
@@ -1 +1,106 @@
 #include <c10/core/StorageImpl.h>
+
+#include <c10/core/CPUAllocator.h>
+
+#include <mutex>
+
+namespace c10 {
+
+constexpr size_t StorageImpl::kSmallBufferBytes;
+
+// Note [Copy-on-write storage]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A lazy clone moves the buffer of a storage into a reference counted
+// CopyOnWriteContext and gives both the storage and its clone a data pointer
+// holding a reference to it. Nothing in this tree tells reading the data of a
+// storage from writing it, so the first access to the data of either storage
+// through any accessor of StorageImpl gives it a buffer of its own: the
+// buffer itself if no other storage shares it anymore, a copy of it
+// otherwise. A clone dropped, or outliving its source, unused since it was
+// made thus never copies anything, and a clone used while its source is
+// still alive copies once, just later than an eager clone would.
+//
+// The raw pointers handed out before a storage is cloned stay valid but
+// writes through them after the clone are seen by the clone too, which is
+// why lazy clones are opt-in, see Context::lazyClone.
+
+namespace {
+
+struct CopyOnWriteContext {
+  explicit CopyOnWriteContext(at::DataPtr data) : data(std::move(data)) {}
+
+  at::DataPtr data;
+  std::atomic<int64_t> refcount{1};
+};
+
+void deleteCopyOnWriteContext(void* ptr) {
+  auto ctx = static_cast<CopyOnWriteContext*>(ptr);
+  if (--ctx->refcount == 0) {
+    delete ctx;
+  }
+}
+
+at::DataPtr makeCopyOnWriteDataPtr(CopyOnWriteContext* ctx) {
+  return at::DataPtr(
+      ctx->data.get(), ctx, &deleteCopyOnWriteContext, ctx->data.device());
+}
+
+// Serializes the transitions of all the copy-on-write storages, which are
+// rare compared to the accesses checking for them.
+std::mutex& copy_on_write_mutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+} // namespace
+
+c10::intrusive_ptr<StorageImpl> StorageImpl::lazy_clone() {
+  std::lock_guard<std::mutex> lock(copy_on_write_mutex());
+  CopyOnWriteContext* ctx;
+  if (copy_on_write_.load(std::memory_order_relaxed)) {
+    ctx = static_cast<CopyOnWriteContext*>(data_ptr_.get_context());
+  } else {
+    // Only the buffers of the CPU allocator, whose owners don't look for
+    // them in their data pointers, can be moved into a context.
+    if (data_ptr_.get() == nullptr || uses_small_buffer() ||
+        data_ptr_.device().type() != DeviceType::CPU || allocator_ == nullptr ||
+        allocator_->raw_deleter() == nullptr ||
+        data_ptr_.get_deleter() != allocator_->raw_deleter()) {
+      return c10::intrusive_ptr<StorageImpl>();
+    }
+    ctx = new CopyOnWriteContext(std::move(data_ptr_));
+    data_ptr_ = makeCopyOnWriteDataPtr(ctx);
+    copy_on_write_.store(true, std::memory_order_release);
+  }
+  ctx->refcount++;
+  auto clone = c10::make_intrusive<StorageImpl>(
+      data_type_, numel_, makeCopyOnWriteDataPtr(ctx), allocator_, resizable_);
+  clone->copy_on_write_.store(true, std::memory_order_release);
+  return clone;
+}
+
+void StorageImpl::materialize() const {
+  std::lock_guard<std::mutex> lock(copy_on_write_mutex());
+  if (!copy_on_write_.load(std::memory_order_relaxed)) {
+    return;
+  }
+  auto self = const_cast<StorageImpl*>(this);
+  auto ctx = static_cast<CopyOnWriteContext*>(data_ptr_.get_context());
+  if (ctx->refcount.load() == 1) {
+    // The other storages only drop their references, so this one owns the
+    // buffer now.
+    at::DataPtr data = std::move(ctx->data);
+    self->data_ptr_ = std::move(data);
+  } else {
+    const size_t nbytes = capacity();
+    at::Allocator* allocator = allocator_ ? allocator_ : GetCPUAllocator();
+    at::DataPtr data = allocator->allocate(nbytes);
+    if (nbytes > 0) {
+      std::memcpy(data.get(), data_ptr_.get(), nbytes);
+    }
+    self->data_ptr_ = std::move(data);
+  }
+  self->copy_on_write_.store(false, std::memory_order_release);
+}
+
+} // namespace c10
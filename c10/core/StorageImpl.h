@@ -5,10 +5,20 @@
 
 #include <c10/util/intrusive_ptr.h>
 
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+
 namespace c10 {
 
 struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
  public:
+  // CPU storages of at most this many bytes can keep their data in a buffer
+  // inside the StorageImpl, which saves the separate data allocation for
+  // scalars and other tiny tensors.
+  static constexpr size_t kSmallBufferBytes = 64;
+  struct use_small_buffer_t {};
+
   StorageImpl(
       caffe2::TypeMeta data_type,
       int64_t numel,
@@ -45,15 +55,49 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
             allocator,
             resizable) {}
 
-  StorageImpl& operator=(StorageImpl&& other) = default;
+  // A CPU storage whose data lives in its small buffer. The data pointer
+  // doesn't own anything, so resizing the storage or replacing its data
+  // pointer simply stops using the buffer.
+  StorageImpl(
+      caffe2::TypeMeta data_type,
+      int64_t numel,
+      at::Allocator* allocator,
+      bool resizable,
+      use_small_buffer_t)
+      : StorageImpl(data_type, numel, at::DataPtr(), allocator, resizable) {
+    AT_ASSERT(data_type.itemsize() * numel <= kSmallBufferBytes);
+    data_ptr_ = at::DataPtr(small_buffer_, at::Device(at::DeviceType::CPU));
+  }
+
+  StorageImpl& operator=(StorageImpl&& other) {
+    data_type_ = other.data_type_;
+    data_ptr_ = std::move(other.data_ptr_);
+    copy_on_write_ = other.copy_on_write_.exchange(false);
+    numel_ = other.numel_;
+    resizable_ = other.resizable_;
+    received_cuda_ = other.received_cuda_;
+    allocator_ = other.allocator_;
+    take_small_buffer(other);
+    return *this;
+  }
   StorageImpl& operator=(const StorageImpl&) = delete;
   StorageImpl() = delete;
-  StorageImpl(StorageImpl&& other) = default;
+  StorageImpl(StorageImpl&& other)
+      : data_type_(other.data_type_),
+        data_ptr_(std::move(other.data_ptr_)),
+        copy_on_write_(other.copy_on_write_.exchange(false)),
+        numel_(other.numel_),
+        resizable_(other.resizable_),
+        received_cuda_(other.received_cuda_),
+        allocator_(other.allocator_) {
+    take_small_buffer(other);
+  }
   StorageImpl(const StorageImpl&) = delete;
   ~StorageImpl() = default;
 
   void reset() {
     data_ptr_.clear();
+    copy_on_write_ = false;
     numel_ = 0;
   }
 
@@ -77,11 +121,13 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
 
   template <typename T>
   inline T* unsafe_data() const {
+    maybe_materialize();
     return static_cast<T*>(this->data_ptr_.get());
   }
 
   void release_resources() override {
     data_ptr_.clear();
+    copy_on_write_ = false;
   }
 
   size_t itemsize() const {
@@ -106,16 +152,19 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
   };
 
   at::DataPtr& data_ptr() {
+    maybe_materialize();
     return data_ptr_;
   };
 
   const at::DataPtr& data_ptr() const {
+    maybe_materialize();
     return data_ptr_;
   };
 
   // Returns the previous data_ptr
   at::DataPtr set_data_ptr(at::DataPtr&& data_ptr) {
     std::swap(data_ptr_, data_ptr);
+    copy_on_write_ = false;
     return std::move(data_ptr);
   };
 
@@ -130,10 +179,12 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
 
   // TODO: Return const ptr eventually if possible
   void* data() {
+    maybe_materialize();
     return data_ptr_.get();
   }
 
   void* data() const {
+    maybe_materialize();
     return data_ptr_.get();
   }
 
@@ -201,6 +252,7 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
           "already set.");
     }
     data_ptr_ = std::move(data_ptr);
+    copy_on_write_ = false;
     // NOTE: data_type might change and so it's also possible that capacity
     // might not be divisible by itemsize. There is no way for us to keep track
     // of the exact capacity if we're not explicity storing is. More conrectely
@@ -221,14 +273,53 @@ struct C10_API StorageImpl final : public c10::intrusive_ptr_target {
     return received_cuda_;
   }
 
+  bool uses_small_buffer() const {
+    return data_ptr_.get() == small_buffer_;
+  }
+
+  /**
+   * Returns a storage with the same data as this one which shares its buffer
+   * until either storage is accessed, see Note [Copy-on-write storage].
+   * Returns an undefined pointer if the buffer of this storage can't be
+   * shared, in which case the caller copies it.
+   */
+  c10::intrusive_ptr<StorageImpl> lazy_clone();
+
+  // Whether the buffer may be shared with another storage
+  bool is_copy_on_write() const {
+    return copy_on_write_.load(std::memory_order_acquire);
+  }
+
  private:
+  void maybe_materialize() const {
+    if (C10_UNLIKELY(copy_on_write_.load(std::memory_order_acquire))) {
+      materialize();
+    }
+  }
+
+  // Gives this storage a buffer of its own
+  void materialize() const;
+
+  // After data_ptr_ was moved from `other`, makes it point into this
+  // storage's own buffer if it pointed into the buffer of `other`.
+  void take_small_buffer(const StorageImpl& other) {
+    if (data_ptr_.get() == other.small_buffer_ && this != &other) {
+      std::memcpy(small_buffer_, other.small_buffer_, kSmallBufferBytes);
+      data_ptr_ = at::DataPtr(small_buffer_, data_ptr_.device());
+    }
+  }
+
+
   caffe2::TypeMeta data_type_;
   DataPtr data_ptr_;
+  // data_ptr_ is a reference to a buffer shared with other storages
+  std::atomic<bool> copy_on_write_{false};
   int64_t numel_;
   bool resizable_;
   // Identifies that Storage was received from another process and doesn't have
   // local to process cuda memory allocation
   bool received_cuda_;
   Allocator* allocator_;
+  alignas(alignof(std::max_align_t)) char small_buffer_[kSmallBufferBytes];
 };
 } // namespace c10
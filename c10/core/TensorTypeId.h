@@ -49,6 +49,12 @@ enum class TensorTypeId : uint8_t {
 
   VariableTensorId,
 
+  // Autocast has no tensors of its own: it is included in the thread local
+  // type set by at::autocast::set_enabled, dispatches before variable so
+  // that autograd records the casts it adds, and only has kernels for the
+  // ops it casts the inputs of. Other ops skip it, see Note [Autocast].
+  AutocastTensorId,
+
   // TESTING: This is intended to be a generic testing tensor type id.
   // Don't use it for anything real; its only acceptible use is within a single
   // process test.  Use it by creating a TensorImpl with this TensorTypeId, and
@@ -26,6 +26,19 @@ LocalTensorTypeSet tls_local_tensor_type_set() {
   return raw_local_tensor_type_set;
 }
 
+bool tls_is_tensor_type_id_included(TensorTypeId x) {
+  return raw_local_tensor_type_set.included().has(x);
+}
+
+void tls_set_tensor_type_id_included(TensorTypeId x, bool desired_state) {
+  auto* tls = &raw_local_tensor_type_set;
+  if (desired_state) {
+    tls->set_included(tls->included().add(x));
+  } else {
+    tls->set_included(tls->included().remove(x));
+  }
+}
+
 // We could have also just snapshotted the entire state.  I'm not sure which is
 // better; but right now only the guard API is allowed so the two cases are
 // not distinguishable.
@@ -53,6 +53,11 @@ struct C10_API LocalTensorTypeSet {
 
 C10_API LocalTensorTypeSet tls_local_tensor_type_set();
 
+// Non-RAII API for modes that stay on across calls, like autocast.  Prefer
+// the guards below when the mode has a scope.
+C10_API bool tls_is_tensor_type_id_included(TensorTypeId x);
+C10_API void tls_set_tensor_type_id_included(TensorTypeId x, bool desired_state);
+
 class C10_API IncludeTensorTypeIdGuard {
 public:
   IncludeTensorTypeIdGuard(TensorTypeId);
@@ -3,11 +3,15 @@
 #include <c10/cuda/CUDAGuard.h>
 #include <c10/cuda/CUDAException.h>
 #include <c10/cuda/CUDAFunctions.h>
+#include <c10/util/Backtrace.h>
+#include <c10/util/Metrics.h>
 #include <c10/util/UniqueVoidPtr.h>
 
 #include <cuda_runtime_api.h>
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <cstdlib>
 #include <deque>
 #include <iterator>
 #include <map>
@@ -18,6 +22,15 @@
 #include <unordered_set>
 #include <vector>
 
+// The virtual memory management driver APIs used by expandable segments
+// were added in CUDA 10.2.
+#if !defined(_WIN32) && !defined(__HIP_PLATFORM_HCC__) && \
+    defined(CUDART_VERSION) && CUDART_VERSION >= 10020
+#define C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+#include <cuda.h>
+#include <dlfcn.h>
+#endif
+
 namespace c10 {
 
 C10_DEFINE_REGISTRY(FreeCudaMemoryCallbacksRegistry, FreeMemoryCallback);
@@ -51,6 +64,58 @@ namespace CUDACachingAllocator {
 // ensure that the block is not reused before each recorded stream completes
 // work.
 //
+// Expandable segments (PYTORCH_CUDA_EXPANDABLE_SEGMENTS=1):
+//
+// - Instead of allocating a new cudaMalloc segment whenever no cached large
+//   block fits, the allocator reserves a virtual address range as large as
+//   the device memory for each (device, stream) and maps physical memory
+//   onto its end on demand with the CUDA VMM driver APIs.
+// - New memory is appended to the last block of the segment, so a request
+//   too big for the trailing free block grows that block in place rather
+//   than leaving it stranded next to a fresh segment.
+// - emptyCache() and out-of-memory retries unmap the physical memory behind
+//   a free trailing block, shrinking the segment in place.
+// - Small allocations are not affected, and memory in expandable segments
+//   cannot be shared through CUDA IPC.
+//
+// Allocation history (recordHistory()):
+//
+// - Each allocation records the backtrace of the caller, which snapshot()
+//   reports for live blocks.
+// - Allocations, frees and segment (un)mappings are kept in a fixed size
+//   ring buffer returned by allocationTrace(), so that the events leading up
+//   to an OOM can be inspected after the fact.
+//
+// CUDA graph private pools (notifyCaptureBegin()):
+//
+// - A captured graph replays its kernels on the addresses they used during
+//   capture, so the memory allocated while a stream is captured must not be
+//   handed to anyone else until the graph is gone. Those allocations come
+//   from a private pool whose blocks are only reused by the later
+//   allocations of the same capture (whose replays happen in the same order)
+//   or of the graphs sharing the pool.
+// - Once every graph using a pool is released, its cached segments are
+//   freed, and its still allocated blocks are freed by emptyCache() or an
+//   out-of-memory retry after their tensors are.
+// - Events aren't queried while a capture is underway, since that isn't
+//   allowed during capture.
+//
+// Stream-ordered reuse (setStreamGroup() and
+// PYTORCH_CUDA_STREAM_ORDERED_REUSE=1):
+//
+// - Free blocks are cached by "pool stream", which is the stream the block
+//   was allocated on unless that stream is in a stream group. The streams of
+//   a group share their cached blocks.
+// - A block freed on a grouped stream gets an event recorded on that stream.
+//   A stream of the group that reuses the block issues a cudaStreamWaitEvent
+//   on it, so the reuse is ordered on the GPU and the host doesn't wait.
+// - With PYTORCH_CUDA_STREAM_ORDERED_REUSE=1, a block used on other streams
+//   through recordStream() is also cached right away when it is freed. It gets
+//   an event on each of those streams, and is not held back until they are
+//   queried complete. The events are waited on in the same way.
+// - Neither applies to private pools or to streams being captured. Those
+//   keep the host-side events.
+//
 
 
 namespace {
@@ -66,6 +131,100 @@ constexpr size_t kRoundLarge = 2097152;     // round up large allocs to 2 MiB
 
 typedef std::bitset<static_cast<size_t>(StatType::NUM_TYPES)> StatTypes;
 
+c10::metrics::Counter cache_hits(
+    "torch_cuda_caching_allocator_hits_total",
+    "Allocations served from the blocks cached by the CUDA caching allocator");
+c10::metrics::Counter cache_misses(
+    "torch_cuda_caching_allocator_misses_total",
+    "Allocations the CUDA caching allocator had no cached block for");
+
+bool stream_ordered_reuse_enabled() {
+  static const bool enabled = []() {
+    const char* env = std::getenv("PYTORCH_CUDA_STREAM_ORDERED_REUSE");
+    return env != nullptr && std::string(env) == "1";
+  }();
+  return enabled;
+}
+
+bool expandable_segments_enabled() {
+  static const bool enabled = []() {
+    const char* env = std::getenv("PYTORCH_CUDA_EXPANDABLE_SEGMENTS");
+    if (env == nullptr || std::string(env) != "1") {
+      return false;
+    }
+#ifdef C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+    return true;
+#else
+    TORCH_WARN(
+        "PYTORCH_CUDA_EXPANDABLE_SEGMENTS is set, but expandable segments "
+        "are not supported by this build; ignoring it.");
+    return false;
+#endif
+  }();
+  return enabled;
+}
+
+#ifdef C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+
+#define C10_FORALL_CUDA_VMM_FUNCTIONS(_) \
+  _(cuMemAddressReserve)                 \
+  _(cuMemCreate)                         \
+  _(cuMemRelease)                        \
+  _(cuMemMap)                            \
+  _(cuMemUnmap)                          \
+  _(cuMemSetAccess)                      \
+  _(cuMemGetAllocationGranularity)
+
+// c10_cuda only links the runtime library, so the VMM entry points are looked
+// up in the driver library the first time an expandable segment is created.
+struct DriverAPI {
+#define CREATE_MEMBER(name) decltype(&name) name##_ = nullptr;
+  C10_FORALL_CUDA_VMM_FUNCTIONS(CREATE_MEMBER)
+#undef CREATE_MEMBER
+
+  // Returns nullptr if the driver library does not provide the VMM APIs.
+  static const DriverAPI* get() {
+    static const DriverAPI* api = load();
+    return api;
+  }
+
+ private:
+  static DriverAPI* load() {
+    void* handle = dlopen("libcuda.so.1", RTLD_LAZY);
+    if (!handle) {
+      return nullptr;
+    }
+    std::unique_ptr<DriverAPI> api(new DriverAPI());
+#define LOOKUP_ENTRY(name)                                                 \
+    api->name##_ = reinterpret_cast<decltype(&name)>(dlsym(handle, #name)); \
+    if (!api->name##_) {                                                   \
+      return nullptr;                                                      \
+    }
+    C10_FORALL_CUDA_VMM_FUNCTIONS(LOOKUP_ENTRY)
+#undef LOOKUP_ENTRY
+    return api.release();
+  }
+};
+
+#undef C10_FORALL_CUDA_VMM_FUNCTIONS
+
+#define C10_CUDA_DRIVER_CHECK(EXPR)                               \
+  do {                                                            \
+    CUresult __err = EXPR;                                        \
+    TORCH_CHECK(__err == CUDA_SUCCESS, "CUDA driver error ", __err, \
+                " when calling `" #EXPR "`");                      \
+  } while (0)
+
+CUmemAllocationProp device_allocation_prop(int device) {
+  CUmemAllocationProp prop = {};
+  prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+  prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  prop.location.id = device;
+  return prop;
+}
+
+#endif // C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+
 void update_stat(Stat& stat, int64_t amount) {
   stat.current += amount;
 
@@ -98,12 +257,58 @@ void update_stat_array(StatArray& stat_array, int64_t amount, const StatTypes& s
 }
 
 struct Block;
+struct PrivatePool;
 typedef bool (*Comparison)(const Block*, const Block*);
-typedef std::set<Block*, Comparison> BlockPool;
+
+struct BlockPool : public std::set<Block*, Comparison> {
+  BlockPool(Comparison comparator, bool small, PrivatePool* private_pool = nullptr) :
+    std::set<Block*, Comparison>(comparator), is_small(small),
+    owner_PrivatePool(private_pool) { }
+
+  const bool is_small;
+  PrivatePool* const owner_PrivatePool; // nullptr for the global pools
+};
+
+// A reserved virtual address range whose prefix [ptr, ptr + mapped_size) is
+// backed by physical memory. Each call to grow the segment creates one
+// physical allocation ("chunk"), and shrinking releases whole chunks from the
+// end of the range.
+struct ExpandableSegment {
+  int           device;
+  cudaStream_t  stream;
+  uintptr_t     ptr;          // start of the reserved range
+  size_t        max_size;     // size of the reserved range
+  size_t        granularity;  // mapping granularity of the device
+  size_t        mapped_size;  // bytes currently backed by physical memory
+  std::vector<std::pair<size_t, unsigned long long>> chunks; // (size, handle)
+  Block*        tail;         // block ending at ptr + mapped_size, if any
+
+  ExpandableSegment(int device, cudaStream_t stream, uintptr_t ptr,
+                    size_t max_size, size_t granularity) :
+    device(device), stream(stream), ptr(ptr), max_size(max_size),
+    granularity(granularity), mapped_size(0), tail(nullptr) { }
+};
+
+struct EventDeleter {
+  void operator()(cudaEvent_t event) const {
+    cudaEventDestroy(event);
+  }
+};
+
+// Event recorded on `stream` after the last use of a free block. A stream
+// other than `stream` waits on it before reusing the block.
+struct ReadyEvent {
+  ReadyEvent(cudaStream_t stream, cudaEvent_t event) :
+    stream(stream), event(event) { }
+
+  cudaStream_t stream;
+  std::unique_ptr<CUevent_st, EventDeleter> event;
+};
 
 struct Block {
   int           device;      // gpu
   cudaStream_t  stream;      // allocation stream
+  cudaStream_t  pool_stream; // stream (group) whose cache holds the free block
   stream_set    stream_uses; // streams on which the block was used
   size_t        size;        // block size in bytes
   BlockPool*    pool;        // owning memory pool
@@ -112,15 +317,20 @@ struct Block {
   Block*        prev;        // prev block if split from a larger allocation
   Block*        next;        // next block if split from a larger allocation
   int           event_count; // number of outstanding CUDA events
+  ExpandableSegment* expandable_segment; // owning segment, if expandable
+  std::shared_ptr<std::string> history; // allocation backtrace, if recorded
+  std::vector<ReadyEvent> ready_events; // to wait on before reuse, if free
 
   Block(int device, cudaStream_t stream, size_t size, BlockPool* pool, void* ptr) :
-    device(device), stream(stream), stream_uses(), size(size), pool(pool),
-    ptr(ptr), allocated(0), prev(nullptr), next(nullptr), event_count(0) { }
+    device(device), stream(stream), pool_stream(stream), stream_uses(), size(size), pool(pool),
+    ptr(ptr), allocated(0), prev(nullptr), next(nullptr), event_count(0),
+    expandable_segment(nullptr) { }
 
   // constructor for search key
   Block(int device, cudaStream_t stream, size_t size) :
-    device(device), stream(stream), stream_uses(), size(size), pool(nullptr),
-    ptr(nullptr), allocated(0), prev(nullptr), next(nullptr), event_count(0) { }
+    device(device), stream(stream), pool_stream(stream), stream_uses(), size(size), pool(nullptr),
+    ptr(nullptr), allocated(0), prev(nullptr), next(nullptr), event_count(0),
+    expandable_segment(nullptr) { }
 
   bool is_split() const {
     return (prev != nullptr) || (next != nullptr);
@@ -132,8 +342,8 @@ static bool BlockComparator(const Block* a, const Block* b)
   if (a->device != b->device) {
     return a->device < b->device;
   }
-  if (a->stream != b->stream) {
-    return (uintptr_t)a->stream < (uintptr_t)b->stream;
+  if (a->pool_stream != b->pool_stream) {
+    return (uintptr_t)a->pool_stream < (uintptr_t)b->pool_stream;
   }
   if (a->size != b->size) {
     return a->size < b->size;
@@ -141,6 +351,31 @@ static bool BlockComparator(const Block* a, const Block* b)
   return (uintptr_t)a->ptr < (uintptr_t)b->ptr;
 }
 
+// Cached blocks of the CUDA graphs sharing a pool; see the notes above.
+struct PrivatePool {
+  PrivatePool() :
+    use_count(1), cudaMalloc_count(0),
+    large_blocks(BlockComparator, /*small=*/false, this),
+    small_blocks(BlockComparator, /*small=*/true, this) { }
+  PrivatePool(const PrivatePool&) = delete;
+  PrivatePool& operator=(const PrivatePool&) = delete;
+
+  int use_count;        // graphs that haven't released the pool yet
+  int cudaMalloc_count; // segments allocated for the pool and not freed yet
+  BlockPool large_blocks;
+  BlockPool small_blocks;
+};
+
+// Streams sharing their cached blocks. The address of the group is the pool
+// stream of its streams, so it can't collide with the key of another stream.
+struct StreamGroup {
+  explicit StreamGroup(int64_t id) : id(id) { }
+  StreamGroup(const StreamGroup&) = delete;
+  StreamGroup& operator=(const StreamGroup&) = delete;
+
+  const int64_t id;
+};
+
 static std::string format_size(uint64_t size) {
   std::ostringstream os;
   os.precision(2);
@@ -184,14 +419,46 @@ class THCCachingAllocator {
   // allocated blocks by device pointer
   std::unordered_map<void*, Block*> allocated_blocks;
 
+  // private pools of the CUDA graphs, by id
+  std::map<MempoolId_t, std::unique_ptr<PrivatePool>> graph_pools;
+
+  // private pools all of whose graphs were released
+  std::map<MempoolId_t, PrivatePool*> graph_pools_freeable;
+
+  // streams being captured, with the pools their allocations come from
+  std::vector<std::pair<cudaStream_t, PrivatePool*>> captures_underway;
+
+  // stream groups by id, and the group of each grouped stream
+  std::map<int64_t, std::unique_ptr<StreamGroup>> stream_groups;
+  std::unordered_map<cudaStream_t, StreamGroup*> stream_group_of;
+
   // outstanding cuda events
   std::deque<std::pair<cudaEvent_t, Block*>> cuda_events;
 
+  // expandable segments by (device, stream)
+  std::map<std::pair<int, cudaStream_t>, std::unique_ptr<ExpandableSegment>> expandable_segments;
+
+  // cudaIpcMemHandle_t of the segments shared through CUDA IPC, by segment
+  // address; an entry lives as long as the cudaMalloc of its segment
+  std::unordered_map<void*, std::string> ipc_mem_handles;
+
+  // whether allocation backtraces and events are recorded; read without the
+  // lock so that malloc can capture the backtrace before taking it
+  std::atomic<bool> record_history;
+
+  // ring buffer of the last trace_max_entries allocator events
+  size_t trace_max_entries;
+  std::vector<TraceEntry> alloc_trace;
+  size_t alloc_trace_next;
+
  public:
 
   THCCachingAllocator() :
-      large_blocks(BlockComparator),
-      small_blocks(BlockComparator) {}
+      large_blocks(BlockComparator, /*small=*/false),
+      small_blocks(BlockComparator, /*small=*/true),
+      record_history(false),
+      trace_max_entries(0),
+      alloc_trace_next(0) {}
 
   std::mutex* getCudaFreeMutex() const {
     return &cuda_free_mutex;
@@ -203,18 +470,27 @@ class THCCachingAllocator {
   /** allocates a block which is safe to use from the provided stream */
   void malloc(void** devPtr, size_t size, cudaStream_t stream)
   {
+    // Symbolizing the backtrace is slow, so do it before taking the lock.
+    std::shared_ptr<std::string> history;
+    if (record_history) {
+      history = std::make_shared<std::string>(c10::get_backtrace(/*frames_to_skip=*/1));
+    }
+
     std::lock_guard<std::recursive_mutex> lock(mutex);
 
     int device;
     C10_CUDA_CHECK(cudaGetDevice(&device));
 
-    // process outstanding cudaEvents
-    process_events();
+    // process outstanding cudaEvents, which can't be queried during capture
+    if (captures_underway.empty()) {
+      process_events();
+    }
 
     size = round_size(size);
 
-    Block search_key(device, stream, size);
-    auto& pool = get_pool(size);
+    auto& pool = get_pool(size, stream);
+    const cudaStream_t pool_stream = get_pool_stream(stream, pool);
+    Block search_key(device, pool_stream, size);
 
     DeviceStats& stats = get_stats_for_device(device);
     StatTypes stat_types;
@@ -224,7 +500,7 @@ class THCCachingAllocator {
     auto find_free_block = [&]()->Block*{
       auto it = pool.lower_bound(&search_key);
       if (it != pool.end() && (*it)->device == device &&
-          (*it)->stream == stream) {
+          (*it)->pool_stream == pool_stream) {
         Block* block = *it;
         pool.erase(it);
         return block;
@@ -243,6 +519,15 @@ class THCCachingAllocator {
         block = find_free_block();
       }
     }
+    if (block != nullptr) {
+      cache_hits.add();
+    } else {
+      cache_misses.add();
+    }
+    if (block == nullptr && &pool == &large_blocks &&
+        expandable_segments_enabled()) {
+      block = try_expand_segment(device, stream, size, stat_types);
+    }
     if (block == nullptr) {
       void* ptr;
       size_t alloc_size = get_allocation_size(size);
@@ -250,6 +535,11 @@ class THCCachingAllocator {
 
       if (err == cudaSuccess) {
         block = new Block(device, stream, alloc_size, &pool, ptr);
+        block->pool_stream = pool_stream;
+        if (pool.owner_PrivatePool) {
+          pool.owner_PrivatePool->cudaMalloc_count++;
+        }
+        record_trace(TraceEntry::SEGMENT_ALLOC, device, ptr, alloc_size, stream, nullptr);
         update_stat_array(stats.segment, 1, stat_types);
         update_stat_array(stats.reserved_bytes, alloc_size, stat_types);
       } else if (err == cudaErrorMemoryAllocation) {
@@ -295,11 +585,20 @@ class THCCachingAllocator {
     Block* remaining = nullptr;
     AT_ASSERT(block);
 
+    // Order the reuse after the last uses of the block on other streams. The
+    // remaining part of a split block keeps its events for its next reuse.
+    for (const ReadyEvent& ready : block->ready_events) {
+      if (ready.stream != stream) {
+        C10_CUDA_CHECK(cudaStreamWaitEvent(stream, ready.event.get(), 0));
+      }
+    }
+
     const bool already_split = block->is_split();
     if (should_split(block, size)) {
       remaining = block;
 
       block = new Block(device, stream, size, &pool, block->ptr);
+      block->expandable_segment = remaining->expandable_segment;
       block->prev = remaining->prev;
       if (block->prev) {
         block->prev->next = block;
@@ -326,8 +625,12 @@ class THCCachingAllocator {
       update_stat_array(stats.inactive_split, -1, stat_types);
     }
 
+    block->stream = stream;
+    block->ready_events.clear();
     block->allocated = true;
+    block->history = std::move(history);
     allocated_blocks[block->ptr] = block;
+    record_trace(TraceEntry::ALLOC, device, block->ptr, block->size, stream, block->history);
 
     *devPtr = block->ptr;
 
@@ -352,6 +655,8 @@ class THCCachingAllocator {
     Block* block = it->second;
     allocated_blocks.erase(it);
     block->allocated = false;
+    record_trace(TraceEntry::FREE, block->device, block->ptr, block->size, block->stream, block->history);
+    block->history.reset();
 
     DeviceStats& stats = get_stats_for_device(block->device);
     StatTypes stat_types;
@@ -361,7 +666,17 @@ class THCCachingAllocator {
     update_stat_array(stats.allocated_bytes, -block->size, {stat_types});
 
     if (!block->stream_uses.empty()) {
-      insert_events(block);
+      if (stream_ordered_reuse_enabled() && !block->pool->owner_PrivatePool &&
+          captures_underway.empty()) {
+        stream_set streams(std::move(block->stream_uses));
+        block->stream_uses.clear();
+        for (const cuda::CUDAStream& use : streams) {
+          record_ready_event(block, use.device_index(), use.stream());
+        }
+        free_block(block);
+      } else {
+        insert_events(block);
+      }
     } else {
       free_block(block);
     }
@@ -388,6 +703,34 @@ class THCCachingAllocator {
     return basePtr;
   }
 
+  std::string getIpcMemHandle(void* ptr, size_t* outOffset) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    Block* block = find_allocated_block(ptr);
+    if (!block) {
+      AT_ERROR("invalid device pointer: ", ptr);
+    }
+    const bool expandable = block->expandable_segment != nullptr;
+    while (block->prev) {
+      block = block->prev;
+    }
+    if (outOffset) {
+      *outOffset = static_cast<char*>(ptr) - static_cast<char*>(block->ptr);
+    }
+    auto it = ipc_mem_handles.find(block->ptr);
+    if (it != ipc_mem_handles.end()) {
+      return it->second;
+    }
+    cudaIpcMemHandle_t handle;
+    C10_CUDA_CHECK(cudaIpcGetMemHandle(&handle, block->ptr));
+    std::string result(reinterpret_cast<const char*>(&handle), sizeof(handle));
+    // The memory of expandable segments is remapped without a cudaFree, so
+    // their handles are not cached.
+    if (!expandable) {
+      ipc_mem_handles.emplace(block->ptr, result);
+    }
+    return result;
+  }
+
   void recordStream(void* ptr, cuda::CUDAStream stream) {
     // Empty tensor's storage().data() might be a null ptr. As there is no
     // blocks associated with those tensors, it is fine to do nothing here.
@@ -409,12 +752,67 @@ class THCCachingAllocator {
     }
   }
 
+  /** streams of the same group share their cached blocks; see the notes above **/
+  void setStreamGroup(cudaStream_t stream, int64_t group) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    // The blocks already cached for the old pool stream stay there; they have
+    // the events needed to be reused by the streams still using it.
+    stream_group_of.erase(stream);
+    if (group < 0) {
+      return;
+    }
+    auto it = stream_groups.find(group);
+    if (it == stream_groups.end()) {
+      it = stream_groups.emplace(group, std::unique_ptr<StreamGroup>(new StreamGroup(group))).first;
+    }
+    stream_group_of[stream] = it->second.get();
+  }
+
   /** returns cached blocks to the system allocator **/
   void emptyCache() {
     std::lock_guard<std::recursive_mutex> lock(mutex);
+    // Deferred launches may still read the blocks about to be released
+    cuda::impl::flushDeferredWork();
     synchronize_and_free_events(nullopt);
     free_blocks(large_blocks, large_blocks.begin(), large_blocks.end());
     free_blocks(small_blocks, small_blocks.begin(), small_blocks.end());
+    free_released_private_pools();
+    shrink_expandable_segments(nullopt);
+  }
+
+  /** allocations on `stream` come from the private pool `mempool_id` until notifyCaptureEnd **/
+  void notifyCaptureBegin(cudaStream_t stream, MempoolId_t mempool_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto it = graph_pools.find(mempool_id);
+    if (it == graph_pools.end()) {
+      it = graph_pools.emplace(mempool_id, std::unique_ptr<PrivatePool>(new PrivatePool())).first;
+    } else {
+      // another graph shares the pool
+      TORCH_INTERNAL_ASSERT(it->second->use_count > 0);
+      it->second->use_count++;
+    }
+    captures_underway.emplace_back(stream, it->second.get());
+  }
+
+  void notifyCaptureEnd(cudaStream_t stream) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto it = std::find_if(captures_underway.begin(), captures_underway.end(),
+        [stream](const std::pair<cudaStream_t, PrivatePool*>& capture) {
+          return capture.first == stream;
+        });
+    TORCH_INTERNAL_ASSERT(it != captures_underway.end());
+    captures_underway.erase(it);
+  }
+
+  /** called by each graph using the pool once it no longer replays **/
+  void releasePool(MempoolId_t mempool_id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    auto it = graph_pools.find(mempool_id);
+    TORCH_INTERNAL_ASSERT(it != graph_pools.end());
+    if (--it->second->use_count == 0) {
+      graph_pools_freeable.emplace(mempool_id, it->second.get());
+      free_released_private_pools();
+    }
   }
 
   /** Retrieves info (total size + largest block) of the memory cache **/
@@ -427,7 +825,13 @@ class THCCachingAllocator {
   /** Returns a copy of the memory allocator stats for the device **/
   DeviceStats getStatsForDevice(int dev_id) {
     std::lock_guard<std::recursive_mutex> lock(mutex);
-    return get_stats_for_device(dev_id);
+    DeviceStats stats = get_stats_for_device(dev_id);
+    size_t total = 0;
+    size_t largest = 0;
+    cache_info_aux(large_blocks, dev_id, &total, &largest);
+    cache_info_aux(small_blocks, dev_id, &total, &largest);
+    stats.largest_free_block_bytes = largest;
+    return stats;
   }
 
   /** Resets the historical accumulation stats for the device **/
@@ -482,7 +886,8 @@ class THCCachingAllocator {
       SegmentInfo& segment_info = result.back();
       segment_info.device = head_block->device;
       segment_info.address = reinterpret_cast<int64_t>(head_block->ptr);
-      segment_info.is_large = (head_block->pool == &large_blocks);
+      segment_info.stream = reinterpret_cast<int64_t>(head_block->stream);
+      segment_info.is_large = !head_block->pool->is_small;
 
       const Block* block = head_block;
       while (block != nullptr) {
@@ -492,6 +897,7 @@ class THCCachingAllocator {
         block_info.size = block->size;
         block_info.allocated = block->allocated;
         block_info.active = block->allocated || (block->event_count > 0);
+        block_info.history = block->history;
 
         segment_info.total_size += block_info.size;
         if (block_info.allocated) {
@@ -515,8 +921,51 @@ class THCCachingAllocator {
     return result;
   }
 
+  void recordHistory(bool enabled, size_t max_entries) {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    // Restart the trace when recording is (re)enabled, but keep it around
+    // after recording stops so that it can still be inspected.
+    if (enabled) {
+      trace_max_entries = max_entries;
+      alloc_trace.clear();
+      alloc_trace.reserve(max_entries);
+      alloc_trace_next = 0;
+    }
+    record_history = enabled;
+  }
+
+  /** Returns the recorded allocator events, oldest first **/
+  std::vector<TraceEntry> allocationTrace() const {
+    std::lock_guard<std::recursive_mutex> lock(mutex);
+    std::vector<TraceEntry> result;
+    result.reserve(alloc_trace.size());
+    result.insert(result.end(), alloc_trace.begin() + alloc_trace_next, alloc_trace.end());
+    result.insert(result.end(), alloc_trace.begin(), alloc_trace.begin() + alloc_trace_next);
+    return result;
+  }
+
  private:
 
+  void record_trace(TraceEntry::Action action, int device, void* ptr, size_t size,
+                    cudaStream_t stream, std::shared_ptr<std::string> history) {
+    if (!record_history || trace_max_entries == 0) {
+      return;
+    }
+    TraceEntry entry;
+    entry.action = action;
+    entry.device = device;
+    entry.address = reinterpret_cast<int64_t>(ptr);
+    entry.size = size;
+    entry.stream = reinterpret_cast<int64_t>(stream);
+    entry.history = std::move(history);
+    if (alloc_trace.size() < trace_max_entries) {
+      alloc_trace.push_back(std::move(entry));
+    } else {
+      alloc_trace[alloc_trace_next] = std::move(entry);
+      alloc_trace_next = (alloc_trace_next + 1) % trace_max_entries;
+    }
+  }
+
   // All private methods do not acquire the allocator mutex.
 
   DeviceStats& get_stats_for_device(int device) {
@@ -531,6 +980,11 @@ class THCCachingAllocator {
     std::vector<const Block*> blocks;
     blocks.insert(blocks.end(), small_blocks.begin(), small_blocks.end());
     blocks.insert(blocks.end(), large_blocks.begin(), large_blocks.end());
+    for (const auto& entry : graph_pools) {
+      const PrivatePool* pool = entry.second.get();
+      blocks.insert(blocks.end(), pool->small_blocks.begin(), pool->small_blocks.end());
+      blocks.insert(blocks.end(), pool->large_blocks.begin(), pool->large_blocks.end());
+    }
     for (const auto& item : allocated_blocks) {
       blocks.push_back(item.second);
     }
@@ -545,6 +999,18 @@ class THCCachingAllocator {
     size_t original_block_size = block->size;
 
     auto& pool = *block->pool;
+
+    // A block freed on a grouped stream is cached for the whole group, which
+    // waits on an event recorded now before reusing it.
+    block->pool_stream = block->stream;
+    if (!pool.owner_PrivatePool && !is_capturing(block->stream)) {
+      auto it = stream_group_of.find(block->stream);
+      if (it != stream_group_of.end()) {
+        record_ready_event(block, block->device, block->stream);
+        block->pool_stream = reinterpret_cast<cudaStream_t>(it->second);
+      }
+    }
+
     int64_t net_change_inactive_split_blocks = 0;
     int64_t net_change_inactive_split_size = 0;
 
@@ -577,7 +1043,8 @@ class THCCachingAllocator {
   /** combine previously split blocks. returns the size of the subsumed block, or 0 on failure. */
   size_t try_merge_blocks(Block* dst, Block* src, BlockPool& pool)
   {
-    if (!src || src->allocated || src->event_count > 0) {
+    if (!src || src->allocated || src->event_count > 0 ||
+        src->pool_stream != dst->pool_stream) {
       return 0;
     }
 
@@ -596,15 +1063,61 @@ class THCCachingAllocator {
       }
     }
 
+    for (ReadyEvent& ready : src->ready_events) {
+      // Drop the events that already completed, so that a block merged over
+      // and over doesn't accumulate them.
+      if (captures_underway.empty()) {
+        cudaError_t err = cudaEventQuery(ready.event.get());
+        if (err == cudaSuccess) {
+          continue;
+        } else if (err == cudaErrorNotReady) {
+          cudaGetLastError();
+        } else {
+          C10_CUDA_CHECK(err);
+        }
+      }
+      dst->ready_events.push_back(std::move(ready));
+    }
+
     const size_t subsumed_size = src->size;
     dst->size += subsumed_size;
+    if (src->expandable_segment && src->expandable_segment->tail == src) {
+      src->expandable_segment->tail = dst;
+    }
     pool.erase(src);
     delete src;
 
     return subsumed_size;
   }
 
-  BlockPool& get_pool(size_t size) {
+  bool is_capturing(cudaStream_t stream) const {
+    for (const auto& capture : captures_underway) {
+      if (capture.first == stream) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /** the key under which the blocks that `stream` may reuse are cached */
+  cudaStream_t get_pool_stream(cudaStream_t stream, const BlockPool& pool) const {
+    if (pool.owner_PrivatePool) {
+      return stream;
+    }
+    auto it = stream_group_of.find(stream);
+    if (it == stream_group_of.end()) {
+      return stream;
+    }
+    return reinterpret_cast<cudaStream_t>(it->second);
+  }
+
+  BlockPool& get_pool(size_t size, cudaStream_t stream) {
+    for (const auto& capture : captures_underway) {
+      if (capture.first == stream) {
+        PrivatePool* pool = capture.second;
+        return size <= kSmallSize ? pool->small_blocks : pool->large_blocks;
+      }
+    }
     if (size <= kSmallSize) {
       return small_blocks;
     } else {
@@ -613,23 +1126,15 @@ class THCCachingAllocator {
   }
 
   StatType get_stat_type_for_pool(const BlockPool& pool) {
-    if (&pool == &small_blocks) {
-      return StatType::SMALL_POOL;
-    } else if (&pool == &large_blocks) {
-      return StatType::LARGE_POOL;
-    } else {
-      AT_ERROR("get_stat_type_for_pool: invalid pool");
-    }
+    return pool.is_small ? StatType::SMALL_POOL : StatType::LARGE_POOL;
   }
 
   bool should_split(const Block* block, size_t size) {
     size_t remaining = block->size - size;
-    if (block->pool == &small_blocks) {
+    if (block->pool->is_small) {
       return remaining >= kMinBlockSize;
-    } else if (block->pool == &large_blocks) {
-      return remaining > kSmallSize;
     } else {
-      AT_ERROR("should_split: invalid pool");
+      return remaining > kSmallSize;
     }
   }
 
@@ -673,6 +1178,7 @@ class THCCachingAllocator {
 
   void free_cached_blocks(int device)
   {
+    cuda::impl::flushDeferredWork();
     // First ensure that all blocks that can't currently be allocated due to
     // outstanding events are returned to the pool.
     synchronize_and_free_events(device);
@@ -689,15 +1195,37 @@ class THCCachingAllocator {
         small_blocks,
         small_blocks.lower_bound(&lower_bound),
         small_blocks.lower_bound(&upper_bound));
+
+    free_released_private_pools();
+    shrink_expandable_segments(device);
+  }
+
+  /** frees the cached segments of the released private pools, and the pools once empty */
+  void free_released_private_pools()
+  {
+    for (auto it = graph_pools_freeable.begin(); it != graph_pools_freeable.end();) {
+      PrivatePool* pool = it->second;
+      free_blocks(pool->large_blocks, pool->large_blocks.begin(), pool->large_blocks.end());
+      free_blocks(pool->small_blocks, pool->small_blocks.begin(), pool->small_blocks.end());
+      if (pool->cudaMalloc_count == 0) {
+        graph_pools.erase(it->first);
+        it = graph_pools_freeable.erase(it);
+      } else {
+        ++it;
+      }
+    }
   }
 
   void free_blocks(BlockPool& blocks, BlockPool::iterator it, BlockPool::iterator end)
   {
-    // Frees all non-split blocks between `it` and `end`
+    // Frees all non-split blocks between `it` and `end`. Blocks in
+    // expandable segments are released by shrink_expandable_segments.
     while (it != end) {
       Block* block = *it;
-      if (!block->prev && !block->next) {
+      if (!block->prev && !block->next && !block->expandable_segment) {
         C10_CUDA_CHECK(cudaFree((void*)block->ptr));
+        ipc_mem_handles.erase(block->ptr);
+        record_trace(TraceEntry::SEGMENT_FREE, block->device, block->ptr, block->size, block->stream, nullptr);
 
         DeviceStats& stats = get_stats_for_device(block->device);
         StatTypes stat_types;
@@ -705,6 +1233,9 @@ class THCCachingAllocator {
         stat_types[static_cast<size_t>(get_stat_type_for_pool(*(block->pool)))] = true;
         update_stat_array(stats.segment, -1, stat_types);
         update_stat_array(stats.reserved_bytes, -block->size, stat_types);
+        if (block->pool->owner_PrivatePool) {
+          block->pool->owner_PrivatePool->cudaMalloc_count--;
+        }
 
         auto cur = it;
         ++it;
@@ -716,6 +1247,218 @@ class THCCachingAllocator {
     }
   }
 
+  ExpandableSegment* get_expandable_segment(int device, cudaStream_t stream) {
+    const auto key = std::make_pair(device, stream);
+    auto it = expandable_segments.find(key);
+    if (it != expandable_segments.end()) {
+      return it->second.get();
+    }
+#ifdef C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+    const DriverAPI* api = DriverAPI::get();
+    if (!api) {
+      TORCH_WARN_ONCE(
+          "PYTORCH_CUDA_EXPANDABLE_SEGMENTS is set, but the CUDA driver does "
+          "not provide the virtual memory management APIs; falling back to "
+          "cudaMalloc segments.");
+      return nullptr;
+    }
+    const CUmemAllocationProp prop = device_allocation_prop(device);
+    size_t granularity;
+    C10_CUDA_DRIVER_CHECK(api->cuMemGetAllocationGranularity_(
+        &granularity, &prop, CU_MEM_ALLOC_GRANULARITY_MINIMUM));
+    size_t device_free;
+    size_t device_total;
+    C10_CUDA_CHECK(cudaMemGetInfo(&device_free, &device_total));
+    const size_t max_size =
+        granularity * ((device_total + granularity - 1) / granularity);
+    CUdeviceptr ptr;
+    C10_CUDA_DRIVER_CHECK(api->cuMemAddressReserve_(&ptr, max_size, 0, 0, 0));
+    auto& segment = expandable_segments[key];
+    segment.reset(new ExpandableSegment(device, stream, ptr, max_size, granularity));
+    return segment.get();
+#else
+    return nullptr;
+#endif
+  }
+
+  /** backs `size` more bytes at the end of the segment; false if out of memory */
+  bool map_segment_chunk(ExpandableSegment* segment, size_t size) {
+#ifdef C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+    if (segment->mapped_size + size > segment->max_size) {
+      return false;
+    }
+    const DriverAPI* api = DriverAPI::get();
+    const CUmemAllocationProp prop = device_allocation_prop(segment->device);
+    CUmemGenericAllocationHandle handle;
+    CUresult err = api->cuMemCreate_(&handle, size, &prop, 0);
+    if (err == CUDA_ERROR_OUT_OF_MEMORY) {
+      return false;
+    }
+    C10_CUDA_DRIVER_CHECK(err);
+    const CUdeviceptr addr = segment->ptr + segment->mapped_size;
+    C10_CUDA_DRIVER_CHECK(api->cuMemMap_(addr, size, 0, handle, 0));
+    CUmemAccessDesc desc = {};
+    desc.location = prop.location;
+    desc.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+    C10_CUDA_DRIVER_CHECK(api->cuMemSetAccess_(addr, size, &desc, 1));
+    segment->chunks.emplace_back(size, handle);
+    segment->mapped_size += size;
+    record_trace(TraceEntry::SEGMENT_MAP, segment->device, reinterpret_cast<void*>(addr),
+                 size, segment->stream, nullptr);
+    return true;
+#else
+    return false;
+#endif
+  }
+
+  /** releases the last physical chunk of the segment, returns its size */
+  size_t unmap_segment_chunk(ExpandableSegment* segment) {
+#ifdef C10_CUDA_EXPANDABLE_SEGMENTS_SUPPORTED
+    const DriverAPI* api = DriverAPI::get();
+    const auto chunk = segment->chunks.back();
+    segment->chunks.pop_back();
+    segment->mapped_size -= chunk.first;
+    C10_CUDA_DRIVER_CHECK(api->cuMemUnmap_(segment->ptr + segment->mapped_size, chunk.first));
+    C10_CUDA_DRIVER_CHECK(api->cuMemRelease_(chunk.second));
+    record_trace(TraceEntry::SEGMENT_UNMAP, segment->device,
+                 reinterpret_cast<void*>(segment->ptr + segment->mapped_size),
+                 chunk.first, segment->stream, nullptr);
+    return chunk.first;
+#else
+    AT_ERROR("unmap_segment_chunk: expandable segments are not supported");
+#endif
+  }
+
+  /**
+   * Grows the expandable segment of (device, stream) so that it ends in a free
+   * block of at least `size` bytes, and returns that block (removed from the
+   * pool). Returns nullptr if the segment can't be created or grown.
+   */
+  Block* try_expand_segment(int device, cudaStream_t stream, size_t size, const StatTypes& stat_types) {
+    ExpandableSegment* segment = get_expandable_segment(device, stream);
+    if (!segment) {
+      return nullptr;
+    }
+    DeviceStats& stats = get_stats_for_device(device);
+
+    for (int attempt = 0; attempt < 2; ++attempt) {
+      Block* tail = segment->tail;
+      // A free tail is in the pool; find_free_block already rejected it, so
+      // it is smaller than `size`.
+      const bool extend_tail = tail && !tail->allocated && tail->event_count == 0;
+      const size_t needed = size - (extend_tail ? tail->size : 0);
+      const size_t grow = segment->granularity *
+          ((needed + segment->granularity - 1) / segment->granularity);
+
+      if (!map_segment_chunk(segment, grow)) {
+        if (attempt == 0) {
+          // Release cached memory (which may shrink this segment too) and
+          // try once more.
+          stats.num_alloc_retries += 1;
+          free_cached_blocks(device);
+        }
+        continue;
+      }
+
+      if (segment->mapped_size == grow) {
+        update_stat_array(stats.segment, 1, stat_types);
+      }
+      update_stat_array(stats.reserved_bytes, grow, stat_types);
+
+      Block* block;
+      if (extend_tail) {
+        block = tail;
+        large_blocks.erase(block);
+        block->size += grow;
+        if (block->is_split()) {
+          update_stat_array(stats.inactive_split_bytes, grow, stat_types);
+        }
+      } else {
+        void* ptr = reinterpret_cast<void*>(segment->ptr + segment->mapped_size - grow);
+        block = new Block(device, stream, grow, &large_blocks, ptr);
+        block->pool_stream = get_pool_stream(stream, large_blocks);
+        block->expandable_segment = segment;
+        block->prev = tail;
+        if (tail) {
+          tail->next = block;
+          update_stat_array(stats.inactive_split, 1, stat_types);
+          update_stat_array(stats.inactive_split_bytes, grow, stat_types);
+        }
+        segment->tail = block;
+      }
+      return block;
+    }
+    return nullptr;
+  }
+
+  /** unmaps physical memory behind free blocks at the end of expandable segments */
+  void shrink_expandable_segments(optional<int> device) {
+    for (auto& entry : expandable_segments) {
+      ExpandableSegment* segment = entry.second.get();
+      if (device.has_value() && segment->device != *device) {
+        continue;
+      }
+      Block* tail = segment->tail;
+      if (!tail || tail->allocated || tail->event_count > 0) {
+        continue;
+      }
+      const size_t tail_offset = reinterpret_cast<uintptr_t>(tail->ptr) - segment->ptr;
+      auto last_chunk_fits = [&]() {
+        return !segment->chunks.empty() &&
+            segment->mapped_size - segment->chunks.back().first >= tail_offset;
+      };
+      if (!last_chunk_fits()) {
+        continue;
+      }
+
+      // cuMemUnmap does not wait for kernels still using the memory the
+      // way cudaFree does.
+      cuda::CUDAGuard device_guard(segment->device);
+      C10_CUDA_CHECK(cudaStreamSynchronize(segment->stream));
+      // The tail may have last been used on another stream of a group.
+      if (tail->stream != segment->stream) {
+        C10_CUDA_CHECK(cudaStreamSynchronize(tail->stream));
+      }
+      for (const ReadyEvent& ready : tail->ready_events) {
+        C10_CUDA_CHECK(cudaEventSynchronize(ready.event.get()));
+      }
+
+      size_t released = 0;
+      while (last_chunk_fits()) {
+        released += unmap_segment_chunk(segment);
+      }
+
+      DeviceStats& stats = get_stats_for_device(segment->device);
+      StatTypes stat_types;
+      stat_types[static_cast<size_t>(StatType::AGGREGATE)] = true;
+      stat_types[static_cast<size_t>(StatType::LARGE_POOL)] = true;
+      update_stat_array(stats.reserved_bytes, -released, stat_types);
+      if (segment->mapped_size == 0) {
+        update_stat_array(stats.segment, -1, stat_types);
+      }
+
+      const bool was_split = tail->is_split();
+      large_blocks.erase(tail);
+      if (tail->size == released) {
+        if (tail->prev) {
+          tail->prev->next = nullptr;
+        }
+        segment->tail = tail->prev;
+        if (was_split) {
+          update_stat_array(stats.inactive_split, -1, stat_types);
+          update_stat_array(stats.inactive_split_bytes, -released, stat_types);
+        }
+        delete tail;
+      } else {
+        tail->size -= released;
+        if (was_split) {
+          update_stat_array(stats.inactive_split_bytes, -released, stat_types);
+        }
+        large_blocks.insert(tail);
+      }
+    }
+  }
+
   void synchronize_and_free_events(optional<int> device) {
     // Synchronize on outstanding events and then free associated blocks.
     // Limited to blocks on the given device if specified.
@@ -750,6 +1493,15 @@ class THCCachingAllocator {
     return it->second;
   }
 
+  void record_ready_event(Block* block, int device, cudaStream_t stream)
+  {
+    cuda::CUDAGuard device_guard(device);
+    cudaEvent_t event;
+    C10_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    block->ready_events.emplace_back(stream, event);
+    C10_CUDA_CHECK(cudaEventRecord(event, stream));
+  }
+
   void insert_events(Block* block)
   {
     int prev_device;
@@ -832,7 +1584,7 @@ struct CudaCachingAllocator : public Allocator {
     C10_CUDA_CHECK(cudaGetDevice(&device));
     void* r = nullptr;
     if (size != 0) {
-      caching_allocator.malloc(&r, size, cuda::getCurrentCUDAStream(device));
+      caching_allocator.malloc(&r, size, cuda::impl::getCurrentCUDAStreamNoFlush(device));
     }
     return {r, r, &CudaCachingDeleter, Device(DeviceType::CUDA, device)};
   }
@@ -861,11 +1613,21 @@ void* getBaseAllocation(void *ptr, size_t *size)
   return caching_allocator.getBaseAllocation(ptr, size);
 }
 
+std::string getIpcMemHandle(void *ptr, size_t *offset)
+{
+  return caching_allocator.getIpcMemHandle(ptr, offset);
+}
+
 void recordStream(void *ptr, cuda::CUDAStream stream)
 {
   caching_allocator.recordStream(ptr, stream);
 }
 
+void setStreamGroup(cudaStream_t stream, int64_t group)
+{
+  caching_allocator.setStreamGroup(stream, group);
+}
+
 std::mutex* getFreeMutex()
 {
   return caching_allocator.getCudaFreeMutex();
@@ -895,6 +1657,26 @@ std::vector<SegmentInfo> snapshot() {
   return caching_allocator.snapshot();
 }
 
+void recordHistory(bool enabled, size_t trace_max_entries) {
+  caching_allocator.recordHistory(enabled, trace_max_entries);
+}
+
+std::vector<TraceEntry> allocationTrace() {
+  return caching_allocator.allocationTrace();
+}
+
+void notifyCaptureBegin(cudaStream_t stream, MempoolId_t mempool_id) {
+  caching_allocator.notifyCaptureBegin(stream, mempool_id);
+}
+
+void notifyCaptureEnd(cudaStream_t stream) {
+  caching_allocator.notifyCaptureEnd(stream);
+}
+
+void releasePool(MempoolId_t mempool_id) {
+  caching_allocator.releasePool(mempool_id);
+}
+
 //
 // In CUDA IPC, sender sends a tensor to receiver, getIpcDevPtr
 // is called by the receiving process to map the CUDA memory from the sending
@@ -956,7 +1738,7 @@ void* raw_alloc(size_t nbytes) {
   int device;
   C10_CUDA_CHECK(cudaGetDevice(&device));
   void* r = nullptr;
-  caching_allocator.malloc(&r, nbytes, cuda::getCurrentCUDAStream(device));
+  caching_allocator.malloc(&r, nbytes, cuda::impl::getCurrentCUDAStreamNoFlush(device));
   return r;
 }
 
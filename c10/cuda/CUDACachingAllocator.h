@@ -7,7 +7,10 @@
 #include <c10/util/Registry.h>
 
 #include <array>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace c10 {
 
@@ -81,6 +84,11 @@ struct DeviceStats {
 
   // COUNT: total number of OOMs (i.e. failed calls to CUDA after cache flush)
   int64_t num_ooms = 0;
+
+  // SUM: size of the largest cached free block, computed when the stats are
+  // queried. Together with reserved_bytes - active_bytes (all cached free
+  // memory) this shows how fragmented the cache is.
+  int64_t largest_free_block_bytes = 0;
 };
 
 // Struct containing info of an allocation block (i.e. a fractional part of a cudaMalloc)..
@@ -88,12 +96,16 @@ struct BlockInfo {
   int64_t size = 0;
   bool allocated = false;
   bool active = false;
+  // Backtrace of the allocation, if it was made while recordHistory() was
+  // enabled and the block is still allocated.
+  std::shared_ptr<std::string> history;
 };
 
 // Struct containing info of a memory segment (i.e. one contiguous cudaMalloc).
 struct SegmentInfo {
   int64_t device = 0;
   int64_t address = 0;
+  int64_t stream = 0;
   int64_t total_size = 0;
   int64_t allocated_size = 0;
   int64_t active_size = 0;
@@ -101,6 +113,25 @@ struct SegmentInfo {
   std::vector<BlockInfo> blocks;
 };
 
+// Entry in the ring buffer of allocator events kept by recordHistory().
+struct TraceEntry {
+  enum Action {
+    ALLOC,          // client allocation of a block
+    FREE,           // client free of a block
+    SEGMENT_ALLOC,  // cudaMalloc of a new segment
+    SEGMENT_FREE,   // cudaFree of a segment
+    SEGMENT_MAP,    // physical memory mapped onto an expandable segment
+    SEGMENT_UNMAP   // physical memory unmapped from an expandable segment
+  };
+  Action action;
+  int64_t device = 0;
+  int64_t address = 0;
+  int64_t size = 0;
+  int64_t stream = 0;
+  // Backtrace of the allocation for ALLOC and FREE entries.
+  std::shared_ptr<std::string> history;
+};
+
 C10_CUDA_API void* raw_alloc(size_t nbytes);
 C10_CUDA_API void raw_delete(void* ptr);
 
@@ -108,11 +139,38 @@ C10_CUDA_API Allocator* get();
 C10_CUDA_API void emptyCache();
 C10_CUDA_API void cacheInfo(int dev_id, size_t* cachedAndFree, size_t* largestBlock);
 C10_CUDA_API void* getBaseAllocation(void *ptr, size_t *size);
+// Returns the cudaIpcMemHandle_t of the segment containing ptr, as a string
+// of CUDA_IPC_HANDLE_SIZE bytes, and the offset of ptr in the segment. The
+// handle is computed once per segment and cached until the segment is freed.
+C10_CUDA_API std::string getIpcMemHandle(void *ptr, size_t *offset);
 C10_CUDA_API void recordStream(void *ptr, CUDAStream stream);
+// Puts `stream` in the stream group `group`, or removes it from its group if
+// `group` is negative. The streams of a group share their cached blocks: a
+// block freed on one of them can be reused by the others right away, with a
+// cudaStreamWaitEvent on an event recorded when it was freed instead of a
+// host-side wait.
+C10_CUDA_API void setStreamGroup(cudaStream_t stream, int64_t group);
 C10_CUDA_API DeviceStats getDeviceStats(int device);
 C10_CUDA_API void resetAccumulatedStats(int device);
 C10_CUDA_API void resetPeakStats(int device);
 C10_CUDA_API std::vector<SegmentInfo> snapshot();
+// Starts (or stops) recording a backtrace for each allocation and keeping the
+// last trace_max_entries allocator events. Capturing backtraces is expensive,
+// so this is intended for debugging memory usage.
+C10_CUDA_API void recordHistory(bool enabled, size_t trace_max_entries);
+// Returns the recorded allocator events, oldest first.
+C10_CUDA_API std::vector<TraceEntry> allocationTrace();
+
+// Id of the private memory pool of one or more CUDA graphs.
+using MempoolId_t = uint64_t;
+
+// While `stream` is captured into a CUDA graph, allocations on it come from
+// the private pool `mempool_id`, which is created by its first capture. Each
+// capture of a graph into the pool must be matched by a releasePool once the
+// graph no longer replays.
+C10_CUDA_API void notifyCaptureBegin(cudaStream_t stream, MempoolId_t mempool_id);
+C10_CUDA_API void notifyCaptureEnd(cudaStream_t stream);
+C10_CUDA_API void releasePool(MempoolId_t mempool_id);
 
 C10_CUDA_API std::mutex* getFreeMutex();
 
@@ -190,6 +190,10 @@ static StreamId CUDAStream_getStreamId(const LeakyStreamInternals* ptr) {
 // Thread-local current streams
 static thread_local LeakyStreamInternals** current_streams = nullptr;
 
+// Thread-local flush of the work the thread holds back, see
+// impl::setDeferredWorkFlush
+static thread_local void (*deferred_work_flush)() = nullptr;
+
 // Populates global values and creates a default stream for each device.
 // Note: the default stream on each device is signified by a nullptr,
 // and so is not created as usual.
@@ -327,6 +331,7 @@ cudaStream_t CUDAStream::stream() const {
 CUDAStream getStreamFromPool(
     const bool isHighPriority,
     DeviceIndex device_index) {
+  impl::flushDeferredWork();
   initCUDAStreamsOnce();
   if (device_index == -1)
     device_index = current_device();
@@ -346,6 +351,7 @@ CUDAStream getStreamFromPool(
 }
 
 CUDAStream getDefaultCUDAStream(DeviceIndex device_index) {
+  impl::flushDeferredWork();
   initCUDAStreamsOnce();
   if (device_index == -1) {
     device_index = current_device();
@@ -354,6 +360,26 @@ CUDAStream getDefaultCUDAStream(DeviceIndex device_index) {
   return CUDAStream_fromInternals(&default_streams[device_index]);
 }
 CUDAStream getCurrentCUDAStream(DeviceIndex device_index) {
+  impl::flushDeferredWork();
+  return impl::getCurrentCUDAStreamNoFlush(device_index);
+}
+
+namespace impl {
+
+void setDeferredWorkFlush(void (*flush)()) {
+  deferred_work_flush = flush;
+}
+
+void flushDeferredWork() {
+  if (C10_UNLIKELY(deferred_work_flush)) {
+    // Cleared first, the flush itself asks for streams
+    auto flush = deferred_work_flush;
+    deferred_work_flush = nullptr;
+    flush();
+  }
+}
+
+CUDAStream getCurrentCUDAStreamNoFlush(DeviceIndex device_index) {
   initCUDAStreamsOnce();
   if (device_index == -1) {
     device_index = current_device();
@@ -362,6 +388,8 @@ CUDAStream getCurrentCUDAStream(DeviceIndex device_index) {
   return CUDAStream_fromInternals(current_streams[device_index]);
 }
 
+} // namespace impl
+
 void setCurrentCUDAStream(CUDAStream stream) {
   initCUDAStreamsOnce();
   auto ptr = CUDAStream_internals(stream);
@@ -56,6 +56,30 @@
 namespace c10 {
 namespace cuda {
 
+class CUDAStream;
+
+namespace impl {
+
+/**
+ * Work a thread holds back from its streams, such as the launches queued by
+ * at::cuda::DeferredLaunchGuard, registers a function that queues it.  The
+ * function runs, once, the next time the thread is handed a stream, or
+ * synchronizes one, so that the work is queued before whatever the caller
+ * does with the stream.
+ */
+C10_CUDA_API void setDeferredWorkFlush(void (*flush)());
+C10_CUDA_API void flushDeferredWork();
+
+/**
+ * getCurrentCUDAStream, without flushing the deferred work of the thread,
+ * for callers that only need to know the stream and queue nothing on it,
+ * such as the caching allocator.
+ */
+C10_CUDA_API CUDAStream
+getCurrentCUDAStreamNoFlush(DeviceIndex device_index = -1);
+
+} // namespace impl
+
 // Value object representing a CUDA stream.  This is just a wrapper
 // around c10::Stream, but it comes with a little extra CUDA-specific
 // functionality (conversion to cudaStream_t), and a guarantee that
@@ -115,6 +139,7 @@ public:
   }
 
   void synchronize() const {
+    impl::flushDeferredWork();
     DeviceGuard guard{stream_.device()};
     C10_CUDA_CHECK(cudaStreamSynchronize(stream()));
   }
@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/core/CPUCachingAllocator.h>
+
+using namespace c10;
+
+namespace {
+
+int64_t aggregate(const CPUCachingAllocator::StatArray& stat_array) {
+  return stat_array[static_cast<size_t>(CPUCachingAllocator::StatType::AGGREGATE)].current;
+}
+
+} // namespace
+
+TEST(CPUCachingAllocatorTest, ReusesSmallBlocks) {
+  CPUCachingAllocator::emptyCache();
+  auto* allocator = CPUCachingAllocator::get();
+  void* first;
+  {
+    auto ptr = allocator->allocate(1000);
+    first = ptr.get();
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(first) % gAlignment, 0);
+  }
+  auto hits = CPUCachingAllocator::getStats().num_cache_hits;
+  // 1000 and 900 bytes round up to the same 1 KiB size class
+  auto ptr = allocator->allocate(900);
+  EXPECT_EQ(ptr.get(), first);
+  EXPECT_EQ(CPUCachingAllocator::getStats().num_cache_hits, hits + 1);
+}
+
+TEST(CPUCachingAllocatorTest, ReusesLargeBlocksAcrossThreads) {
+  CPUCachingAllocator::emptyCache();
+  auto* allocator = CPUCachingAllocator::get();
+  void* first;
+  {
+    auto ptr = allocator->allocate(4 << 20);
+    first = ptr.get();
+  }
+  void* second = nullptr;
+  std::thread t([&]() {
+    auto ptr = allocator->allocate((4 << 20) - 100);
+    second = ptr.get();
+  });
+  t.join();
+  EXPECT_EQ(first, second);
+}
+
+TEST(CPUCachingAllocatorTest, EmptyCacheReleasesMemory) {
+  CPUCachingAllocator::emptyCache();
+  auto* allocator = CPUCachingAllocator::get();
+  int64_t reserved_before =
+      aggregate(CPUCachingAllocator::getStats().reserved_bytes);
+  {
+    auto small = allocator->allocate(100);
+    auto large = allocator->allocate(1 << 20);
+    auto stats = CPUCachingAllocator::getStats();
+    EXPECT_EQ(aggregate(stats.allocation), 2);
+    EXPECT_GE(aggregate(stats.allocated_bytes), 100 + (1 << 20));
+  }
+  auto stats = CPUCachingAllocator::getStats();
+  EXPECT_EQ(aggregate(stats.allocation), 0);
+  EXPECT_EQ(aggregate(stats.allocated_bytes), 0);
+  EXPECT_GT(aggregate(stats.reserved_bytes), reserved_before);
+
+  CPUCachingAllocator::emptyCache();
+  stats = CPUCachingAllocator::getStats();
+  EXPECT_EQ(aggregate(stats.reserved_bytes), 0);
+  EXPECT_EQ(aggregate(stats.segment), 0);
+}
+
+TEST(CPUCachingAllocatorTest, DefaultAllocatorOptIn) {
+  FLAGS_caffe2_cpu_allocator_use_caching = true;
+  auto ptr = GetDefaultCPUAllocator()->allocate(64);
+  EXPECT_EQ(ptr.get_deleter(), &CPUCachingAllocator::raw_delete);
+  FLAGS_caffe2_cpu_allocator_use_caching = false;
+}
@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+
+#include <c10/core/CPUAllocator.h>
+#include <c10/core/StorageImpl.h>
+
+using namespace c10;
+
+namespace {
+
+c10::intrusive_ptr<StorageImpl> make_storage(int64_t numel) {
+  auto storage = c10::make_intrusive<StorageImpl>(
+      caffe2::TypeMeta::Make<float>(), numel, GetCPUAllocator(), true);
+  for (int64_t i = 0; i < numel; i++) {
+    storage->data<float>()[i] = i;
+  }
+  return storage;
+}
+
+TEST(StorageImplTest, LazyCloneCopiesOnAccess) {
+  auto source = make_storage(100);
+  const void* data = source->data();
+  auto clone = source->lazy_clone();
+  ASSERT_TRUE(clone);
+  EXPECT_TRUE(source->is_copy_on_write());
+  EXPECT_TRUE(clone->is_copy_on_write());
+
+  clone->data<float>()[0] = 42;
+  EXPECT_FALSE(clone->is_copy_on_write());
+  EXPECT_NE(clone->data(), data);
+  EXPECT_EQ(source->data<float>()[0], 0);
+  // the source was the last one sharing the buffer
+  EXPECT_EQ(source->data(), data);
+  EXPECT_EQ(clone->data<float>()[99], 99);
+}
+
+TEST(StorageImplTest, LazyCloneTakesBufferOfDroppedSource) {
+  auto source = make_storage(100);
+  const void* data = source->data();
+  auto clone = source->lazy_clone();
+  auto clone_of_clone = clone->lazy_clone();
+  source.reset();
+  clone.reset();
+  EXPECT_EQ(clone_of_clone->data(), data);
+  EXPECT_EQ(clone_of_clone->data<float>()[7], 7);
+}
+
+TEST(StorageImplTest, LazyCloneOfUnsharableBuffer) {
+  float external[100];
+  auto storage = c10::make_intrusive<StorageImpl>(
+      caffe2::TypeMeta::Make<float>(),
+      100,
+      at::DataPtr(external, at::Device(DeviceType::CPU)),
+      nullptr,
+      false);
+  EXPECT_FALSE(storage->lazy_clone());
+  EXPECT_FALSE(storage->is_copy_on_write());
+}
+
+} // namespace
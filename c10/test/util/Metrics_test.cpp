@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <c10/util/Metrics.h>
+
+#include <string>
+#include <thread>
+
+namespace {
+
+c10::metrics::Counter test_counter(
+    "c10_metrics_test_total", "Only used in test.");
+
+int64_t counter_value(const char* name) {
+  for (const auto& counter : c10::metrics::snapshot().counters) {
+    if (counter.name == name) {
+      return counter.value;
+    }
+  }
+  return -1;
+}
+
+c10::metrics::OpMetrics op_metrics(const char* name) {
+  for (const auto& op : c10::metrics::snapshot().ops) {
+    if (op.name == name) {
+      return op;
+    }
+  }
+  return c10::metrics::OpMetrics();
+}
+
+TEST(MetricsTest, CountersAreSummedOverThreads) {
+  const int64_t before = counter_value("c10_metrics_test_total");
+  ASSERT_GE(before, 0);
+  test_counter.add(2);
+  std::thread t([] {
+    for (int i = 0; i < 10; i++) {
+      test_counter.add();
+    }
+  });
+  t.join();
+  EXPECT_EQ(counter_value("c10_metrics_test_total"), before + 12);
+}
+
+TEST(MetricsTest, OpCallsAreCountedAndTimed) {
+  const int64_t interval = c10::metrics::getTimeSamplingInterval();
+  c10::metrics::setTimeSamplingInterval(1);
+  for (int64_t i = 0; i < interval + 4; i++) {
+    c10::metrics::OpScope scope("c10_metrics_test_op");
+  }
+  c10::metrics::setTimeSamplingInterval(interval);
+  {
+    // not a static string
+    c10::metrics::OpScope scope(std::string("c10_metrics_test_op"));
+  }
+  auto op = op_metrics("c10_metrics_test_op");
+  EXPECT_EQ(op.calls, interval + 4);
+  EXPECT_GE(op.sampled_calls, 4);
+  EXPECT_LE(op.sampled_calls, op.calls);
+}
+
+TEST(MetricsTest, Disabled) {
+  const int64_t before = counter_value("c10_metrics_test_total");
+  c10::metrics::setEnabled(false);
+  test_counter.add();
+  {
+    c10::metrics::OpScope scope("c10_metrics_test_disabled_op");
+  }
+  c10::metrics::setEnabled(true);
+  EXPECT_EQ(counter_value("c10_metrics_test_total"), before);
+  EXPECT_EQ(op_metrics("c10_metrics_test_disabled_op").calls, 0);
+}
+
+TEST(MetricsTest, PrometheusText) {
+  {
+    c10::metrics::OpScope scope("c10_metrics_test_\"quoted\"_op");
+  }
+  const std::string text = c10::metrics::prometheusText();
+  EXPECT_NE(text.find("# HELP c10_metrics_test_total Only used in test.\n"
+                      "# TYPE c10_metrics_test_total counter\n"
+                      "c10_metrics_test_total "),
+            std::string::npos);
+  EXPECT_NE(text.find("torch_op_calls_total{op=\"c10_metrics_test_\\\"quoted\\\"_op\"} 1\n"),
+            std::string::npos);
+}
+
+} // namespace
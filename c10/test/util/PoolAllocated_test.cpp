@@ -0,0 +1,79 @@
+#include <gtest/gtest.h>
+
+#include <c10/util/PoolAllocated.h>
+#include <c10/util/intrusive_ptr.h>
+
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Pooled final : c10::intrusive_ptr_target, c10::PoolAllocated<Pooled> {
+  explicit Pooled(int value) : value(value) {}
+  int value;
+};
+
+struct PooledBase : c10::intrusive_ptr_target, c10::PoolAllocated<PooledBase> {
+  int value = 0;
+};
+
+struct Larger : PooledBase {
+  char payload[128] = {0};
+};
+
+TEST(PoolAllocatedTest, FreedObjectsAreReused) {
+  Pooled* first = new Pooled(1);
+  delete first;
+  Pooled* second = new Pooled(2);
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(2, second->value);
+  delete second;
+}
+
+TEST(PoolAllocatedTest, WorksWithIntrusivePtr) {
+  std::set<Pooled*> freed;
+  {
+    std::vector<c10::intrusive_ptr<Pooled>> objects;
+    for (int i = 0; i < 8; i++) {
+      objects.push_back(c10::make_intrusive<Pooled>(i));
+    }
+    for (const auto& object : objects) {
+      freed.insert(object.get());
+    }
+  }
+  std::vector<c10::intrusive_ptr<Pooled>> objects;
+  for (int i = 0; i < 8; i++) {
+    objects.push_back(c10::make_intrusive<Pooled>(i));
+    EXPECT_EQ(1, freed.count(objects.back().get()));
+    EXPECT_EQ(i, objects.back()->value);
+  }
+}
+
+TEST(PoolAllocatedTest, SubclassesAreNotPooled) {
+  PooledBase* base = new Larger();
+  delete base;
+  PooledBase* other = new PooledBase();
+  other->value = 3;
+  EXPECT_EQ(3, other->value);
+  delete other;
+}
+
+TEST(PoolAllocatedTest, ObjectsCanBeFreedOnOtherThreads) {
+  std::vector<Pooled*> objects;
+  for (int i = 0; i < 32; i++) {
+    objects.push_back(new Pooled(i));
+  }
+  std::thread t([&] {
+    for (Pooled* object : objects) {
+      delete object;
+    }
+    // Reused on the thread that freed them.
+    Pooled* object = new Pooled(0);
+    EXPECT_EQ(objects.back(), object);
+    delete object;
+  });
+  t.join();
+}
+
+} // namespace
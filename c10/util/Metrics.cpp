@@ -0,0 +1,318 @@
+#include <c10/util/Metrics.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
+
+// Note [Metrics registry]
+// ~~~~~~~~~~~~~~~~~~~~~~~
+// Every thread owns a ThreadMetrics block holding its counters and the stats
+// of the operators it called. Only the owning thread writes to its block, so
+// an increment is a relaxed load and store of a thread local atomic: no lock,
+// no read-modify-write and no cache line shared with another thread. Readers
+// sum the blocks of the live threads under the registry mutex, together with
+// the totals the exited threads folded into the registry.
+//
+// An operator is looked up by the address of its name in a small direct
+// mapped cache before the per-thread map, which the owner only locks to
+// insert a new operator, so that a reader can walk it meanwhile. Timing one
+// call takes two clock reads, so every thread only times one of
+// time_sampling_interval calls and the time of the others is extrapolated.
+// Nested operators are counted and timed too, so the time of an operator
+// includes the one of the operators it calls.
+
+namespace c10 {
+namespace metrics {
+
+namespace detail {
+
+struct OpStats {
+  explicit OpStats(const char* name) : name(name) {}
+
+  const char* name;
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> sampled_calls{0};
+  std::atomic<int64_t> sampled_ns{0};
+};
+
+} // namespace detail
+
+namespace {
+
+using detail::OpStats;
+
+constexpr size_t kMaxCounters = 128;
+constexpr size_t kOpCacheSize = 64;
+
+// In the CAFFE2_FB_LIMITED_MOBILE_CAPABILITY build setting thread_local is
+// not supported, so nothing is collected.
+#ifndef CAFFE2_FB_LIMITED_MOBILE_CAPABILITY
+constexpr bool kSupported = true;
+#else
+constexpr bool kSupported = false;
+#endif
+
+std::atomic<bool> enabled{kSupported};
+std::atomic<int64_t> time_sampling_interval{16};
+
+// Only called by the thread owning `value`
+inline void bump(std::atomic<int64_t>& value, int64_t delta) {
+  value.store(value.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+int64_t now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+struct OpTotals {
+  int64_t calls = 0;
+  int64_t sampled_calls = 0;
+  int64_t sampled_ns = 0;
+
+  void add(const OpStats& stats) {
+    calls += stats.calls.load(std::memory_order_relaxed);
+    sampled_calls += stats.sampled_calls.load(std::memory_order_relaxed);
+    sampled_ns += stats.sampled_ns.load(std::memory_order_relaxed);
+  }
+};
+
+struct ThreadMetrics;
+
+class Registry {
+ public:
+  size_t add_counter(const char* name, const char* help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    TORCH_CHECK(counter_names_.size() < kMaxCounters,
+                "too many metrics counters, the limit is ", kMaxCounters);
+    counter_names_.emplace_back(name, help);
+    return counter_names_.size() - 1;
+  }
+
+  void add_thread(ThreadMetrics* thread) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    threads_.insert(thread);
+  }
+
+  void remove_thread(ThreadMetrics* thread);
+
+  Snapshot snapshot();
+
+ private:
+  // Must be called with mutex_ held.
+  void collect(ThreadMetrics& thread, std::array<int64_t, kMaxCounters>& counters,
+               std::map<std::string, OpTotals>& ops);
+
+  std::mutex mutex_;
+  std::vector<std::pair<std::string, std::string>> counter_names_;
+  std::unordered_set<ThreadMetrics*> threads_;
+  // of the exited threads
+  std::array<int64_t, kMaxCounters> retired_counters_{};
+  std::map<std::string, OpTotals> retired_ops_;
+};
+
+// Never destroyed, so that threads exiting after the static destructors
+// still find it.
+Registry& registry() {
+  static Registry* registry = new Registry();
+  return *registry;
+}
+
+struct ThreadMetrics {
+  ThreadMetrics() {
+    for (auto& counter : counters) {
+      counter.store(0, std::memory_order_relaxed);
+    }
+    op_cache.fill(nullptr);
+    registry().add_thread(this);
+  }
+
+  ~ThreadMetrics() {
+    registry().remove_thread(this);
+  }
+
+  OpStats* op(const char* name) {
+    OpStats*& cached = op_cache[(reinterpret_cast<uintptr_t>(name) >> 3) % kOpCacheSize];
+    if (C10_LIKELY(cached && cached->name == name)) {
+      return cached;
+    }
+    auto it = ops.find(name);
+    if (it == ops.end()) {
+      std::unique_ptr<OpStats> stats(new OpStats(name));
+      std::lock_guard<std::mutex> lock(ops_mutex);
+      it = ops.emplace(name, std::move(stats)).first;
+    }
+    cached = it->second.get();
+    return cached;
+  }
+
+  std::array<std::atomic<int64_t>, kMaxCounters> counters;
+  std::array<OpStats*, kOpCacheSize> op_cache;
+  // calls left until the next timed one
+  int64_t until_sampled = 0;
+  // taken by the owner to insert and by readers
+  std::mutex ops_mutex;
+  std::unordered_map<const char*, std::unique_ptr<OpStats>> ops;
+};
+
+void Registry::collect(ThreadMetrics& thread, std::array<int64_t, kMaxCounters>& counters,
+                       std::map<std::string, OpTotals>& ops) {
+  for (size_t i = 0; i < kMaxCounters; i++) {
+    counters[i] += thread.counters[i].load(std::memory_order_relaxed);
+  }
+  std::lock_guard<std::mutex> lock(thread.ops_mutex);
+  for (const auto& entry : thread.ops) {
+    ops[entry.first].add(*entry.second);
+  }
+}
+
+void Registry::remove_thread(ThreadMetrics* thread) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  collect(*thread, retired_counters_, retired_ops_);
+  threads_.erase(thread);
+}
+
+Snapshot Registry::snapshot() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::array<int64_t, kMaxCounters> counters = retired_counters_;
+  std::map<std::string, OpTotals> ops = retired_ops_;
+  for (ThreadMetrics* thread : threads_) {
+    collect(*thread, counters, ops);
+  }
+  Snapshot result;
+  result.counters.reserve(counter_names_.size());
+  for (size_t i = 0; i < counter_names_.size(); i++) {
+    CounterMetrics counter;
+    counter.name = counter_names_[i].first;
+    counter.help = counter_names_[i].second;
+    counter.value = counters[i];
+    result.counters.push_back(std::move(counter));
+  }
+  result.ops.reserve(ops.size());
+  for (const auto& entry : ops) {
+    OpMetrics op;
+    op.name = entry.first;
+    op.calls = entry.second.calls;
+    op.sampled_calls = entry.second.sampled_calls;
+    op.sampled_ns = entry.second.sampled_ns;
+    result.ops.push_back(std::move(op));
+  }
+  return result;
+}
+
+ThreadMetrics& thread_metrics() {
+#ifndef CAFFE2_FB_LIMITED_MOBILE_CAPABILITY
+  static thread_local ThreadMetrics metrics;
+#else
+  // unreachable, enabled is never set
+  static ThreadMetrics metrics;
+#endif
+  return metrics;
+}
+
+// Escapes a label value of the text exposition format
+std::string escape_label(const std::string& value) {
+  std::string result;
+  result.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      result += '\\';
+      result += c;
+    } else if (c == '\n') {
+      result += "\\n";
+    } else {
+      result += c;
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+Counter::Counter(const char* name, const char* help)
+    : index_(registry().add_counter(name, help)) {}
+
+void Counter::add(int64_t value) {
+  if (C10_LIKELY(enabled.load(std::memory_order_relaxed))) {
+    bump(thread_metrics().counters[index_], value);
+  }
+}
+
+void OpScope::start(const char* name) {
+  if (C10_UNLIKELY(!enabled.load(std::memory_order_relaxed) || name == nullptr)) {
+    return;
+  }
+  ThreadMetrics& metrics = thread_metrics();
+  stats_ = metrics.op(name);
+  bump(stats_->calls, 1);
+  if (--metrics.until_sampled <= 0) {
+    const int64_t interval = time_sampling_interval.load(std::memory_order_relaxed);
+    if (interval > 0) {
+      metrics.until_sampled = interval;
+      start_ns_ = now_ns();
+    }
+  }
+}
+
+void OpScope::finish() {
+  bump(stats_->sampled_calls, 1);
+  bump(stats_->sampled_ns, now_ns() - start_ns_);
+}
+
+bool isEnabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void setEnabled(bool value) {
+  enabled.store(value && kSupported, std::memory_order_relaxed);
+}
+
+void setTimeSamplingInterval(int64_t interval) {
+  TORCH_CHECK(interval >= 0, "the time sampling interval must be non-negative, got ", interval);
+  time_sampling_interval.store(interval, std::memory_order_relaxed);
+}
+
+int64_t getTimeSamplingInterval() {
+  return time_sampling_interval.load(std::memory_order_relaxed);
+}
+
+Snapshot snapshot() {
+  return registry().snapshot();
+}
+
+std::string prometheusText() {
+  Snapshot metrics = snapshot();
+  std::ostringstream out;
+  for (const auto& counter : metrics.counters) {
+    out << "# HELP " << counter.name << " " << counter.help << "\n";
+    out << "# TYPE " << counter.name << " counter\n";
+    out << counter.name << " " << counter.value << "\n";
+  }
+  if (!metrics.ops.empty()) {
+    out << "# HELP torch_op_calls_total Number of calls of an operator\n";
+    out << "# TYPE torch_op_calls_total counter\n";
+    for (const auto& op : metrics.ops) {
+      out << "torch_op_calls_total{op=\"" << escape_label(op.name) << "\"} " << op.calls << "\n";
+    }
+    out << "# HELP torch_op_seconds_total Time spent in an operator, estimated from the timed calls\n";
+    out << "# TYPE torch_op_seconds_total counter\n";
+    for (const auto& op : metrics.ops) {
+      out << "torch_op_seconds_total{op=\"" << escape_label(op.name) << "\"} "
+          << op.estimated_seconds() << "\n";
+    }
+  }
+  return out.str();
+}
+
+} // namespace metrics
+} // namespace c10
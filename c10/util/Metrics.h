@@ -0,0 +1,122 @@
+#pragma once
+
+#include <c10/macros/Macros.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Always-on process metrics: monotonic counters and the number of calls and
+ * time spent per operator, cheap enough to be left enabled in production and
+ * scraped periodically. See Note [Metrics registry].
+ */
+
+namespace c10 {
+namespace metrics {
+
+namespace detail {
+struct OpStats;
+} // namespace detail
+
+/**
+ * A monotonic counter named after the Prometheus conventions, e.g.
+ * `torch_foo_total`. Counters are declared with static storage duration; the
+ * value read is the sum of the increments of all the threads.
+ */
+class C10_API Counter {
+ public:
+  Counter(const char* name, const char* help);
+
+  Counter(const Counter&) = delete;
+  Counter& operator=(const Counter&) = delete;
+
+  void add(int64_t value = 1);
+
+ private:
+  size_t index_;
+};
+
+/**
+ * Counts a call of the operator `name`, which must be a string of static
+ * storage duration, and times it if the calling thread samples this call.
+ * Names that aren't static strings aren't counted.
+ */
+class C10_API OpScope {
+ public:
+  explicit OpScope(const char* name) {
+    start(name);
+  }
+  explicit OpScope(const std::string& /* name */) {}
+  explicit OpScope(const void* /* fn */) {}
+
+  OpScope(const OpScope&) = delete;
+  OpScope& operator=(const OpScope&) = delete;
+
+  ~OpScope() {
+    if (start_ns_ != 0) {
+      finish();
+    }
+  }
+
+ private:
+  void start(const char* name);
+  void finish();
+
+  detail::OpStats* stats_ = nullptr;
+  int64_t start_ns_ = 0;
+};
+
+struct OpMetrics {
+  std::string name;
+  int64_t calls = 0;
+  // calls that were timed, and the time they took
+  int64_t sampled_calls = 0;
+  int64_t sampled_ns = 0;
+
+  // Time spent in all the calls, extrapolated from the sampled ones
+  double estimated_seconds() const {
+    return sampled_calls == 0
+        ? 0.0
+        : 1e-9 * static_cast<double>(sampled_ns) * calls / sampled_calls;
+  }
+};
+
+struct CounterMetrics {
+  std::string name;
+  std::string help;
+  int64_t value = 0;
+};
+
+struct Snapshot {
+  // in the order the counters were created
+  std::vector<CounterMetrics> counters;
+  // sorted by name
+  std::vector<OpMetrics> ops;
+};
+
+/**
+ * Whether the counters and operator metrics are collected (on by default)
+ */
+C10_API bool isEnabled();
+C10_API void setEnabled(bool enabled);
+
+/**
+ * Every thread times one of `interval` operator calls; 0 disables timing
+ */
+C10_API void setTimeSamplingInterval(int64_t interval);
+C10_API int64_t getTimeSamplingInterval();
+
+/**
+ * Sums the metrics of all the threads, the ones that exited included
+ */
+C10_API Snapshot snapshot();
+
+/**
+ * Snapshot in the Prometheus text exposition format
+ */
+C10_API std::string prometheusText();
+
+} // namespace metrics
+} // namespace c10
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace c10 {
+
+/**
+ * Base class giving T a class-specific operator new/delete that recycles
+ * freed objects through a small thread-local free list, so short-lived
+ * objects created on hot paths (e.g. IValue payloads built by the
+ * interpreter) don't go back to the system allocator every time.
+ *
+ *   struct Foo final : c10::intrusive_ptr_target, c10::PoolAllocated<Foo> {};
+ *
+ * Only allocations of exactly sizeof(T) are pooled; anything else (e.g. a
+ * subclass) is forwarded to the global operator new/delete. An object freed
+ * on a different thread than it was allocated on joins the free list of the
+ * freeing thread. At most Capacity blocks are kept per thread, and they are
+ * released when the thread exits.
+ */
+template <class T, size_t Capacity = 64>
+class PoolAllocated {
+ public:
+  static void* operator new(size_t size) {
+    static_assert(sizeof(T) >= sizeof(Block), "T is too small to be pooled");
+    if (size == sizeof(T) && !freeListDestroyed()) {
+      FreeList& list = freeList();
+      if (list.head != nullptr) {
+        Block* block = list.head;
+        list.head = block->next;
+        --list.size;
+        return block;
+      }
+    }
+    return ::operator new(size);
+  }
+
+  static void operator delete(void* ptr, size_t size) {
+    if (ptr == nullptr) {
+      return;
+    }
+    // The free list of this thread may already be gone if objects are
+    // freed during thread or static teardown.
+    if (size == sizeof(T) && !freeListDestroyed()) {
+      FreeList& list = freeList();
+      if (list.size < Capacity) {
+        Block* block = static_cast<Block*>(ptr);
+        block->next = list.head;
+        list.head = block;
+        ++list.size;
+        return;
+      }
+    }
+    ::operator delete(ptr);
+  }
+
+  // The class-specific operator new hides placement new, so forward it.
+  static void* operator new(size_t /*size*/, void* ptr) noexcept {
+    return ptr;
+  }
+
+  static void operator delete(void* /*ptr*/, void* /*place*/) noexcept {}
+
+ protected:
+  PoolAllocated() = default;
+
+ private:
+  struct Block {
+    Block* next;
+  };
+
+  struct FreeList {
+    Block* head = nullptr;
+    size_t size = 0;
+
+    ~FreeList() {
+      while (head != nullptr) {
+        Block* next = head->next;
+        ::operator delete(head);
+        head = next;
+      }
+      size = 0;
+      freeListDestroyed() = true;
+    }
+  };
+
+  static FreeList& freeList() {
+    static thread_local FreeList list;
+    return list;
+  }
+
+  // Trivially destructible, so it can still be read after freeList() is
+  // destroyed.
+  static bool& freeListDestroyed() {
+    static thread_local bool destroyed = false;
+    return destroyed;
+  }
+};
+
+} // namespace c10
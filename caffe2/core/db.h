@@ -51,6 +51,14 @@ class CAFFE2_API Cursor {
    * reached the end of the database, return false.
    */
   virtual bool Valid() = 0;
+  /**
+   * Parses the current value as TensorProtos. Cursors that decode values
+   * ahead of time override this to hand out the decoded protos.
+   */
+  virtual void ParseValue(TensorProtos* protos) {
+    CAFFE_ENFORCE(
+        protos->ParseFromString(value()), "Cannot parse value as TensorProtos");
+  }
 
   C10_DISABLE_COPY_AND_ASSIGN(Cursor);
 };
@@ -108,6 +116,20 @@ C10_DECLARE_REGISTRY(Caffe2DBRegistry, DB, const string&, Mode);
 #define REGISTER_CAFFE2_DB(name, ...) \
   C10_REGISTER_CLASS(Caffe2DBRegistry, name, __VA_ARGS__)
 
+/**
+ * Prefixing any registered database type with "prefetch_", e.g.
+ * "prefetch_leveldb", reads the database ahead of the caller on background
+ * threads. See caffe2/db/prefetch_db.cc.
+ */
+constexpr char kPrefetchDBPrefix[] = "prefetch_";
+
+/**
+ * Returns a database of the given type whose cursors read ahead, or a nullptr
+ * if the database type is not supported.
+ */
+CAFFE2_API unique_ptr<DB>
+CreatePrefetchDB(const string& db_type, const string& source, Mode mode);
+
 /**
  * Returns a database object of the given database type, source and mode. The
  * caller takes the ownership of the pointer. If the database type is not
@@ -117,6 +139,10 @@ C10_DECLARE_REGISTRY(Caffe2DBRegistry, DB, const string&, Mode);
 inline unique_ptr<DB> CreateDB(
     const string& db_type, const string& source, Mode mode) {
   auto result = Caffe2DBRegistry()->Create(db_type, source, mode);
+  const string prefix = kPrefetchDBPrefix;
+  if (!result && db_type.compare(0, prefix.size(), prefix) == 0) {
+    result = CreatePrefetchDB(db_type.substr(prefix.size()), source, mode);
+  }
   VLOG(1) << ((!result) ? "not found db " : "found db ") << db_type;
   return result;
 }
@@ -230,15 +256,21 @@ class CAFFE2_API DBReader {
     std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
     *key = cursor_->key();
     *value = cursor_->value();
+    MoveToNext();
+  }
 
-    // In sharded mode, each read skips num_shards_ records
-    for (uint32_t s = 0; s < num_shards_; s++) {
-      cursor_->Next();
-      if (!cursor_->Valid()) {
-        MoveToBeginning();
-        break;
-      }
-    }
+  /**
+   * Same as Read() above, but parses the value as TensorProtos. Thread safe.
+   *
+   * Cursors that decode ahead, like the ones of "prefetch_" dbs, skip the
+   * parsing on the calling thread.
+   */
+  void Read(string* key, TensorProtos* protos) const {
+    CAFFE_ENFORCE(cursor_ != nullptr, "Reader not initialized.");
+    std::unique_lock<std::mutex> mutex_lock(reader_mutex_);
+    *key = cursor_->key();
+    cursor_->ParseValue(protos);
+    MoveToNext();
   }
 
   /**
@@ -274,6 +306,17 @@ class CAFFE2_API DBReader {
     SeekToFirst();
   }
 
+  void MoveToNext() const {
+    // In sharded mode, each read skips num_shards_ records
+    for (uint32_t s = 0; s < num_shards_; s++) {
+      cursor_->Next();
+      if (!cursor_->Valid()) {
+        MoveToBeginning();
+        break;
+      }
+    }
+  }
+
   void MoveToBeginning() const {
     cursor_->SeekToFirst();
     for (uint32_t s = 0; s < shard_id_; s++) {
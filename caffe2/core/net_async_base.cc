@@ -3,6 +3,7 @@
 #include "caffe2/core/net_async_tracing.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/timer.h"
+#include "caffe2/core/work_stealing_thread_pool.h"
 
 // experimental support for multiple streams per worker per GPU
 C10_DEFINE_int(
@@ -56,6 +57,22 @@ C10_DEFINE_bool(
     false,
     "Run root tasks in current thread instread of scheduling to threadpool");
 
+C10_DEFINE_bool(
+    caffe2_net_async_critical_path_scheduling,
+    false,
+    "Dispatch ready tasks by the cost of their longest remaining path");
+
+C10_DEFINE_bool(
+    caffe2_net_async_use_work_stealing_pool,
+    false,
+    "Use work stealing thread pools for CPU tasks");
+
+C10_DEFINE_int(
+    caffe2_net_async_pool_quota,
+    0,
+    "Soft limit on the tasks of a net running at once on a shared pool, "
+    "0 for no limit");
+
 namespace caffe2 {
 
 std::vector<int>& AsyncNetBase::getStreamCounters() {
@@ -156,11 +173,19 @@ TaskThreadPoolBase* AsyncNetBase::poolGetter(
   std::unique_lock<std::mutex> pools_lock(pools_mutex_);
   auto pool = pools[device_id][pool_size];
   if (!pool) {
-    pool = c10::ThreadPoolRegistry()->Create(
-        DeviceTypeName(device_type),
-        device_id,
-        pool_size,
-        options_.use_per_net_pools_);
+    if (options_.use_work_stealing_pool_ && IsCPUDeviceType(device_type)) {
+      pool = GetAsyncNetThreadPool<WorkStealingThreadPool, PROTO_CPU>(
+          device_id, pool_size, options_.use_per_net_pools_);
+    } else {
+      pool = c10::ThreadPoolRegistry()->Create(
+          DeviceTypeName(device_type),
+          device_id,
+          pool_size,
+          options_.use_per_net_pools_);
+    }
+    if (options_.pool_quota_ > 0 && !options_.use_per_net_pools_) {
+      pool = std::make_shared<QuotaThreadPool>(pool, options_.pool_quota_);
+    }
     pools[device_id][pool_size] = pool;
   }
   return pool.get();
@@ -532,6 +557,10 @@ ExecutionOptions::ExecutionOptions(
   }
 
   use_dfs_scheduling_ = false;
+  use_critical_path_scheduling_ =
+      FLAGS_caffe2_net_async_critical_path_scheduling;
+  use_work_stealing_pool_ = FLAGS_caffe2_net_async_use_work_stealing_pool;
+  pool_quota_ = FLAGS_caffe2_net_async_pool_quota;
 
   for (int arg_idx = 0; arg_idx < net_def->arg_size(); ++arg_idx) {
     auto& arg = net_def->arg(arg_idx);
@@ -543,6 +572,18 @@ ExecutionOptions::ExecutionOptions(
       CAFFE_ENFORCE(arg.has_i(), "deferrable_mode should be an int");
       use_dfs_scheduling_ = arg.i() == 1; // corr. to DFS scheduling
     }
+    if (arg.has_name() && arg.name() == "critical_path_scheduling") {
+      CAFFE_ENFORCE(arg.has_i(), "critical_path_scheduling should be an int");
+      use_critical_path_scheduling_ = arg.i() == 1;
+    }
+    if (arg.has_name() && arg.name() == "work_stealing_pool") {
+      CAFFE_ENFORCE(arg.has_i(), "work_stealing_pool should be an int");
+      use_work_stealing_pool_ = arg.i() == 1;
+    }
+    if (arg.has_name() && arg.name() == "pool_quota") {
+      CAFFE_ENFORCE(arg.has_i(), "pool_quota should be an int");
+      pool_quota_ = arg.i();
+    }
   }
 
   if (FLAGS_caffe2_net_async_profile_operators) {
@@ -24,6 +24,9 @@ C10_DECLARE_bool(caffe2_net_async_use_single_pool);
 C10_DECLARE_bool(caffe2_net_async_use_per_net_pools);
 C10_DECLARE_bool(caffe2_net_async_run_root_tasks_inline);
 C10_DECLARE_bool(caffe2_net_async_profile_operators);
+C10_DECLARE_bool(caffe2_net_async_critical_path_scheduling);
+C10_DECLARE_bool(caffe2_net_async_use_work_stealing_pool);
+C10_DECLARE_int(caffe2_net_async_pool_quota);
 
 namespace caffe2 {
 
@@ -55,6 +58,13 @@ struct ExecutionOptions {
   bool use_dfs_scheduling_ = false;
   // run net's root tasks in RunAsync thread instead of in thread pool
   bool run_root_tasks_inline_ = false;
+  // dispatch ready tasks by their longest remaining path instead of FIFO
+  bool use_critical_path_scheduling_ = false;
+  // use work stealing pools for CPU tasks
+  bool use_work_stealing_pool_ = false;
+  // soft limit on the tasks of the net running at once on a shared pool,
+  // no limit if 0
+  int pool_quota_ = 0;
 };
 
 class CAFFE2_API AsyncNetBase : public NetBase {
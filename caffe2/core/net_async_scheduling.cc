@@ -1,13 +1,118 @@
 #include "caffe2/core/net_async_scheduling.h"
 
+#include <algorithm>
+
 #include "caffe2/core/net_async_tracing.h"
+#include "caffe2/core/operator_schema.h"
 
 namespace caffe2 {
 
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false) {}
+    : AsyncNetBase(net_def, ws), running_(false), running_tasks_num_(0) {
+  if (options_.use_critical_path_scheduling_) {
+    initTaskCosts(ws);
+  }
+}
+
+void AsyncSchedulingNet::initTaskCosts(Workspace* ws) {
+  task_costs_.assign(tasksNum(), 0);
+  task_run_times_.assign(tasksNum(), 0);
+
+  // Shapes of the blobs known before the first run, e.g. of the parameters
+  // and the ones inferred from them
+  std::unordered_map<std::string, TensorShape> shapes;
+  try {
+    NetDef net_def = debug_def();
+    auto inferred = InferBlobShapesAndTypesFromWorkspace(ws, {&net_def});
+    for (const auto& shape : inferred.shapes()) {
+      if (!shape.unknown_shape()) {
+        shapes[shape.name()] = shape;
+      }
+    }
+  } catch (const std::exception& e) {
+    VLOG(1) << "Failed to infer blob shapes for task costs: " << e.what();
+  }
+
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    for (auto op_id : chains_[task_id]) {
+      // ops without cost inference or known input shapes count as one unit
+      float cost = 1;
+      const auto* op = operators_[op_id];
+      const auto* schema =
+          op->has_debug_def() ? OpSchemaRegistry::Schema(op->type()) : nullptr;
+      if (schema && schema->HasCostInferenceFunction()) {
+        std::vector<TensorShape> input_shapes;
+        for (const auto& input : op->debug_def().input()) {
+          auto it = shapes.find(input);
+          if (it == shapes.end()) {
+            break;
+          }
+          input_shapes.push_back(it->second);
+        }
+        if (input_shapes.size() ==
+            static_cast<size_t>(op->debug_def().input_size())) {
+          try {
+            auto c = schema->InferCost(op->debug_def(), input_shapes);
+            cost = std::max<float>(
+                {cost,
+                 static_cast<float>(c.flops),
+                 static_cast<float>(c.bytes_read + c.bytes_written)});
+          } catch (const std::exception& e) {
+            VLOG(1) << "Failed to infer the cost of " << op->type() << ": "
+                    << e.what();
+          }
+        }
+      }
+      task_costs_[task_id] += cost;
+    }
+  }
+  updateTaskPriorities();
+}
+
+void AsyncSchedulingNet::updateTaskPriorities() {
+  // Longest path from every task to the end of the net, in reverse
+  // topological order
+  task_priorities_.assign(tasksNum(), 0);
+  std::vector<int> children_left(tasksNum());
+  std::vector<int> done;
+  for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+    children_left[task_id] = children(task_id).size();
+    if (children_left[task_id] == 0) {
+      done.push_back(task_id);
+    }
+  }
+  while (!done.empty()) {
+    auto task_id = done.back();
+    done.pop_back();
+    float longest_child_path = 0;
+    for (auto child_id : children(task_id)) {
+      longest_child_path =
+          std::max(longest_child_path, task_priorities_[child_id]);
+    }
+    task_priorities_[task_id] = task_costs_[task_id] + longest_child_path;
+    for (auto parent_id : parents(task_id)) {
+      if (--children_left[parent_id] == 0) {
+        done.push_back(parent_id);
+      }
+    }
+  }
+}
+
+void AsyncSchedulingNet::runReadyTask(TaskThreadPoolBase* task_pool) {
+  std::function<void()> func;
+  {
+    std::lock_guard<std::mutex> lock(ready_tasks_mutex_);
+    auto& ready = ready_tasks_[task_pool];
+    // every job of the pool is queued after its task, so there is one
+    CAFFE_ENFORCE(!ready.empty());
+    std::pop_heap(ready.begin(), ready.end());
+    func = std::move(ready.back().func);
+    ready.pop_back();
+  }
+  func();
+}
 
 void AsyncSchedulingNet::reset() {
   AsyncNetBase::reset();
@@ -41,6 +146,11 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) noexcept {
   }
   auto schedule_func = [this, task_id]() {
     try {
+      // number of tasks running at once, the achieved parallelism
+      auto running_tasks = ++running_tasks_num_;
+      if (tracer_ && tracer_->isEnabled()) {
+        tracer_->recordCounter("running_tasks", running_tasks);
+      }
       if (success_) {
         int stream_id = 0;
         if (options_.streams_per_gpu_ > 1) {
@@ -51,9 +161,17 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) noexcept {
                 << "Failed to select a stream: " << e.what();
           }
         }
+        Timer timer;
         if (!run(task_id, stream_id)) {
           success_ = false;
         }
+        if (options_.use_critical_path_scheduling_) {
+          task_run_times_[task_id] = timer.MicroSeconds();
+        }
+      }
+      running_tasks = --running_tasks_num_;
+      if (tracer_ && tracer_->isEnabled()) {
+        tracer_->recordCounter("running_tasks", running_tasks);
       }
 
       if (options_.report_stats_) {
@@ -185,6 +303,17 @@ void AsyncSchedulingNet::schedule(int task_id, bool run_inline) noexcept {
 
   if (run_inline) {
     schedule_func();
+  } else if (options_.use_critical_path_scheduling_) {
+    auto* task_pool = pool(event(task_id).GetDeviceOption());
+    {
+      std::lock_guard<std::mutex> lock(ready_tasks_mutex_);
+      auto& ready = ready_tasks_[task_pool];
+      ready.push_back(
+          ReadyTask{task_priorities_[task_id], task_id, schedule_func});
+      std::push_heap(ready.begin(), ready.end());
+    }
+    task_pool->run(
+        std::bind(&AsyncSchedulingNet::runReadyTask, this, task_pool));
   } else {
     const auto& device_option = event(task_id).GetDeviceOption();
     pool(device_option)->run(schedule_func);
@@ -231,6 +360,16 @@ void AsyncSchedulingNet::finishRun() {
   if (options_.report_stats_) {
     counters_.ReportRunEnd();
   }
+  if (options_.use_critical_path_scheduling_ && success_) {
+    // move the costs towards the measured run times, in microseconds
+    for (auto task_id = 0; task_id < tasksNum(); ++task_id) {
+      task_costs_[task_id] = has_measured_costs_
+          ? 0.8f * task_costs_[task_id] + 0.2f * task_run_times_[task_id]
+          : task_run_times_[task_id];
+    }
+    has_measured_costs_ = true;
+    updateTaskPriorities();
+  }
   // notify observers and waiters
   StopAllObservers();
   running_ = false;
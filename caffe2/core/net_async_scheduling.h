@@ -1,6 +1,9 @@
 #ifndef CAFFE2_CORE_NET_ASYNC_SCHEDULING_H_
 #define CAFFE2_CORE_NET_ASYNC_SCHEDULING_H_
 
+#include <functional>
+#include <unordered_map>
+
 #include "caffe2/core/net_async_base.h"
 
 namespace caffe2 {
@@ -24,6 +27,34 @@ class CAFFE2_API AsyncSchedulingNet : public AsyncNetBase {
   void parentCallback(int parent_id);
   bool isInlineTask(int parent_id, int child_id) const;
 
+  // Critical path scheduling: ready tasks of a pool are dispatched by the
+  // cost of the longest path from them to the end of the net, their priority.
+  // Task costs start out as estimated by the ops' cost inference and follow
+  // the measured run times of the tasks after the first successful run.
+  void initTaskCosts(Workspace* ws);
+  void updateTaskPriorities();
+  void runReadyTask(TaskThreadPoolBase* task_pool);
+
+  struct ReadyTask {
+    float priority;
+    int task_id;
+    std::function<void()> func;
+
+    bool operator<(const ReadyTask& other) const {
+      return priority < other.priority ||
+          (priority == other.priority && task_id > other.task_id);
+    }
+  };
+
+  std::vector<float> task_costs_;
+  std::vector<float> task_priorities_;
+  std::vector<float> task_run_times_;
+  bool has_measured_costs_ = false;
+  // max-heaps of ready tasks per pool
+  std::mutex ready_tasks_mutex_;
+  std::unordered_map<TaskThreadPoolBase*, std::vector<ReadyTask>> ready_tasks_;
+  std::atomic<int> running_tasks_num_;
+
   std::mutex running_mutex_;
   std::condition_variable running_cv_;
   std::atomic<bool> running_;
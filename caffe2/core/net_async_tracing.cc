@@ -73,6 +73,18 @@ void Tracer::recordEvent(const TracerEvent& event) {
   events_.push_back(event);
 }
 
+void Tracer::recordCounter(const char* name, int value) {
+  TracerEvent event;
+  event.name_ = name;
+  event.is_counter_ = true;
+  event.counter_value_ = value;
+  event.tid_ = std::this_thread::get_id();
+  std::lock_guard<std::mutex> lock(tracer_mutex_);
+  // take the timestamp under the lock, so counter values stay ordered
+  event.timestamp_ = (long)caffe2::round(timer_.MicroSeconds());
+  events_.push_back(event);
+}
+
 // Forward
 int getUniqueShardId(const OperatorDef& op_def);
 
@@ -115,7 +127,12 @@ std::string Tracer::serializeEvent(const TracerEvent& event) {
     serialized_event << " \"tid\": " << event.tid_ << ",\n";
   }
 
-  if (event.is_beginning_) {
+  if (event.is_counter_) {
+    serialized_event << " \"name\": \"" << event.name_ << "\",\n";
+    serialized_event << " \"ph\": \"C\",\n";
+    serialized_event << " \"args\": {\n  \"" << event.name_
+                     << "\": " << event.counter_value_ << "\n }";
+  } else if (event.is_beginning_) {
     std::unordered_map<std::string, int> int_args;
     std::unordered_map<std::string, std::string> string_args;
     if (event.name_) {
@@ -40,6 +40,9 @@ struct CAFFE2_API TracerEvent {
   long thread_label_ = -1;
   std::thread::id tid_;
   int iter_ = -1;
+  // counter events ("C" phase) carry a value instead of a begin/end pair
+  bool is_counter_ = false;
+  int counter_value_ = 0;
 };
 
 enum TracingField {
@@ -78,6 +81,9 @@ class CAFFE2_API Tracer {
       TracingConfig = TracingConfig{});
 
   void recordEvent(const TracerEvent& event);
+  // Records the current value of the counter `name`, e.g. the number of
+  // tasks running at once
+  void recordCounter(const char* name, int value);
   std::string opTraceName(const OperatorBase* op);
   std::string opBlobsInfo(const OperatorBase& op);
   std::string serializeEvent(const TracerEvent& event);
@@ -704,6 +704,62 @@ TEST(NetTest, AsyncEmptyNet) {
   }
 }
 
+TEST(NetTest, AsyncCriticalPathScheduling) {
+  // A long chain next to cheap side branches, all ready at once
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        num_workers: 2
+        arg {
+          name: "critical_path_scheduling"
+          i: 1
+        }
+        external_input: "in"
+        op {
+          input: "in"
+          output: "chain1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "chain1"
+          output: "chain2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "chain2"
+          output: "chain3"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "in"
+          output: "side1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "in"
+          output: "side2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "chain3"
+          input: "side1"
+          input: "side2"
+          output: "out"
+          type: "NetTestDummy"
+        }
+  )DOC";
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  Workspace ws;
+  ws.CreateBlob("in");
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  ASSERT_TRUE(
+      caffe2::dynamic_cast_if_rtti<AsyncSchedulingNet*>(net.get()) != nullptr);
+  // later runs are scheduled by the measured task times
+  testExecution(net, 6);
+}
+
 TEST(NetTest, DISABLED_RunAsyncFailure) {
   const auto spec = R"DOC(
         name: "example"
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <iterator>
 #include <list>
+#include <unordered_map>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -257,15 +258,11 @@ class Graph {
   // Move a node from this graph to the destGraph
   void moveNode(NodeRef node, Graph<T, U...>* destGraph) {
     assert(hasNode(node));
-    for (auto it = nodes_.begin(); it != nodes_.end(); ++it) {
-      if (&(*it) == node) {
-        std::list<Node<T, U...>>& destNodes = destGraph->nodes_;
-        destNodes.splice(destNodes.end(), nodes_, it);
-        nodeRefs_.erase(node);
-        destGraph->nodeRefs_.insert(node);
-        break;
-      }
-    }
+    auto it = nodeRefs_.at(node);
+    std::list<Node<T, U...>>& destNodes = destGraph->nodes_;
+    destNodes.splice(destNodes.end(), nodes_, it);
+    nodeRefs_.erase(node);
+    destGraph->nodeRefs_[node] = it;
   }
 
   // Move an edge from this graph to the destGraph
@@ -273,13 +270,11 @@ class Graph {
     assert(hasEdge(edge));
     assert(destGraph->hasNode(edge->tail()));
     assert(destGraph->hasNode(edge->head()));
+    auto it = edgeRefs_.at(edge);
     std::list<Edge<T, U...>>& destEdges = destGraph->edges_;
-    for (auto it = edges_.begin(); it != edges_.end(); ++it) {
-      if (&(*it) == edge) {
-        destEdges.splice(destEdges.end(), edges_, it);
-        break;
-      }
-    }
+    destEdges.splice(destEdges.end(), edges_, it);
+    edgeRefs_.erase(edge);
+    destGraph->edgeRefs_[edge] = it;
   }
 
   // Move entire subgraph to destGraph.
@@ -293,9 +288,9 @@ class Graph {
       auto node = &(*it);
       if (sg.hasNode(node)) {
         std::list<Node<T, U...>>& destNodes = destGraph->nodes_;
-        destNodes.splice(destNodes.end(), nodes_, it--);
         nodeRefs_.erase(node);
-        destGraph->nodeRefs_.insert(node);
+        destGraph->nodeRefs_[node] = it;
+        destNodes.splice(destNodes.end(), nodes_, it--);
         sg.removeNode(node);
       }
     }
@@ -304,6 +299,8 @@ class Graph {
       if (sg.hasEdge(edge)) {
         assert(destGraph->hasNode(edge->tail()));
         assert(destGraph->hasNode(edge->head()));
+        edgeRefs_.erase(edge);
+        destGraph->edgeRefs_[edge] = it;
         destEdges.splice(destEdges.end(), edges_, it--);
         sg.removeEdge(edge);
       }
@@ -417,6 +414,7 @@ class Graph {
     this->edges_.emplace_back(
         Edge<T, U...>(tail, head, std::forward<U...>(data)...));
     EdgeRef e = &this->edges_.back();
+    edgeRefs_[e] = std::prev(this->edges_.end());
     head->addInEdge(e);
     tail->addOutEdge(e);
     return e;
@@ -439,12 +437,7 @@ class Graph {
   }
 
   bool hasEdge(EdgeRef e) const {
-    for (auto& edge : edges_) {
-      if (e == &edge) {
-        return true;
-      }
-    }
-    return false;
+    return edgeRefs_.find(e) != edgeRefs_.end();
   }
 
   /// \brief Get a reference to the edge between two nodes if it exists.
@@ -471,13 +464,9 @@ class Graph {
       deleteEdge(edge);
     }
 
-    for (auto i = nodes_.begin(); i != nodes_.end(); ++i) {
-      if (&*i == n) {
-        nodeRefs_.erase(n);
-        nodes_.erase(i);
-        break;
-      }
-    }
+    auto it = nodeRefs_.find(n);
+    nodes_.erase(it->second);
+    nodeRefs_.erase(it);
   }
 
   // Delete all nodes in the set.
@@ -496,11 +485,10 @@ class Graph {
   void deleteEdge(EdgeRef e) {
     e->tail_->removeOutEdge(e);
     e->head_->removeInEdge(e);
-    for (auto i = edges_.begin(); i != edges_.end(); ++i) {
-      if (&*i == e) {
-        edges_.erase(i);
-        break;
-      }
+    auto it = edgeRefs_.find(e);
+    if (it != edgeRefs_.end()) {
+      edges_.erase(it->second);
+      edgeRefs_.erase(it);
     }
   }
 
@@ -533,13 +521,20 @@ class Graph {
  private:
   std::list<Node<T, U...>> nodes_;
   std::list<Edge<T, U...>> edges_;
-  std::unordered_set<NodeRef> nodeRefs_;
+  // The position of every node and edge in the lists above, so that they
+  // can be found, deleted and moved in constant time. Nets from the
+  // predictor can have tens of thousands of ops, and passes delete nodes
+  // one at a time.
+  std::unordered_map<NodeRef, typename std::list<Node<T, U...>>::iterator>
+      nodeRefs_;
+  std::unordered_map<EdgeRef, typename std::list<Edge<T, U...>>::iterator>
+      edgeRefs_;
 
   NodeRef createNodeInternal(Node<T, U...>&& node) {
     nodes_.emplace_back(std::move(node));
     NodeRef nodeRef = &nodes_.back();
     DEBUG_PRINT("Creating node (%p)\n", nodeRef);
-    nodeRefs_.insert(nodeRef);
+    nodeRefs_[nodeRef] = std::prev(nodes_.end());
     return nodeRef;
   }
 
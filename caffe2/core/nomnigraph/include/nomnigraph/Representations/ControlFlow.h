@@ -7,6 +7,7 @@
 #include "nomnigraph/Support/Pointer.h"
 
 #include <unordered_map>
+#include <unordered_set>
 
 namespace nom {
 namespace repr {
@@ -47,13 +48,16 @@ class BasicBlock {
     assert(
         isa<Instruction>(node->data()) &&
         "Cannot push non-instruction node to basic block.");
+    removeDeletedInstructions();
     instructions_.emplace_back(node);
     trackNode(node);
   }
   const std::vector<NodeRef>& getInstructions() const {
+    removeDeletedInstructions();
     return instructions_;
   }
   std::vector<NodeRef>* getMutableInstructions() {
+    removeDeletedInstructions();
     return &instructions_;
   }
 
@@ -62,6 +66,7 @@ class BasicBlock {
   }
 
   void insertInstructionBefore(NodeRef newInstr, NodeRef instr) {
+    removeDeletedInstructions();
     auto it =
         std::find(std::begin(instructions_), std::end(instructions_), instr);
     instructions_.insert(it, newInstr);
@@ -71,6 +76,7 @@ class BasicBlock {
   void moveInstructionBefore(NodeRef instr1, NodeRef instr2) {
     assert(hasInstruction(instr1) && "Instruction not in basic block.");
     assert(hasInstruction(instr2) && "Instruction not in basic block.");
+    removeDeletedInstructions();
     auto it1 =
         std::find(std::begin(instructions_), std::end(instructions_), instr1);
     auto it2 =
@@ -84,17 +90,35 @@ class BasicBlock {
     instructions_.insert(it2, instr1);
   }
 
+  // Instructions are removed from the ordering lazily, the next time it is
+  // read or added to: passes delete nodes one at a time, and erasing each of
+  // them from the vector right away is quadratic in the size of the block.
   void deleteInstruction(NodeRef instr) {
     assert(hasInstruction(instr) && "Instruction not in basic block.");
-    instructions_.erase(
-        std::remove(instructions_.begin(), instructions_.end(), instr),
-        instructions_.end());
+    deletedInstructions_.insert(instr);
     untrackNode(instr);
   }
 
  private:
+  void removeDeletedInstructions() const {
+    if (deletedInstructions_.empty()) {
+      return;
+    }
+    instructions_.erase(
+        std::remove_if(
+            instructions_.begin(),
+            instructions_.end(),
+            [this](NodeRef n) { return deletedInstructions_.count(n) != 0; }),
+        instructions_.end());
+    deletedInstructions_.clear();
+  }
+
   Subgraph<T, U...> nodes_;
-  std::vector<NodeRef> instructions_;
+  mutable std::vector<NodeRef> instructions_;
+  // Deleted instructions still in `instructions_`. Their addresses can't be
+  // reused by a new instruction before they are removed, as instructions
+  // are only added after removeDeletedInstructions().
+  mutable std::unordered_set<NodeRef> deletedInstructions_;
   // Because we reference a dataflow graph, we need to register callbacks
   // for when the dataflow graph is modified.
   std::unordered_map<NodeRef, typename Notifier<Node<T, U...>>::Callback*>
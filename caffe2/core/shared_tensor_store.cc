@@ -0,0 +1,118 @@
+#include "caffe2/core/shared_tensor_store.h"
+
+#include <cstring>
+#include <unordered_set>
+
+#include "caffe2/core/blob.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+// FNV-1a, over the bytes of the data first and then over the sizes.
+constexpr uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime = 1099511628211ULL;
+
+uint64_t fnv1a(uint64_t hash, const void* data, size_t nbytes) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < nbytes; ++i) {
+    hash = (hash ^ bytes[i]) * kFnvPrime;
+  }
+  return hash;
+}
+
+} // namespace
+
+bool SharedTensorStore::IsShareable(const Tensor& tensor) {
+  // Types with a copy function (std::string, ...) own memory outside of the
+  // tensor data and can't be compared by bytes.
+  return tensor && tensor.GetDeviceType() == CPU &&
+      tensor.storage_initialized() && tensor.is_contiguous() &&
+      !tensor.dtype().copy();
+}
+
+size_t SharedTensorStore::Hash(const Tensor& tensor) {
+  uint64_t hash = fnv1a(kFnvOffset, tensor.raw_data(), tensor.nbytes());
+  for (const auto size : tensor.sizes()) {
+    hash = fnv1a(hash, &size, sizeof(size));
+  }
+  return static_cast<size_t>(hash);
+}
+
+bool SharedTensorStore::Equal(const Tensor& a, const Tensor& b) {
+  return a.dtype() == b.dtype() && a.sizes() == b.sizes() &&
+      std::memcmp(a.raw_data(), b.raw_data(), a.nbytes()) == 0;
+}
+
+Tensor SharedTensorStore::Intern(const Tensor& tensor) {
+  if (!IsShareable(tensor)) {
+    return tensor.UnsafeSharedInstance();
+  }
+  const size_t hash = Hash(tensor);
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto range = tensors_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second.is_same(tensor) || Equal(it->second, tensor)) {
+      return it->second.UnsafeSharedInstance();
+    }
+  }
+  tensors_.emplace(hash, tensor.UnsafeSharedInstance());
+  return tensor.UnsafeSharedInstance();
+}
+
+size_t SharedTensorStore::ShareBlobs(
+    Workspace* ws,
+    const std::vector<std::string>& names) {
+  CAFFE_ENFORCE(ws);
+  const auto local_vec = ws->LocalBlobs();
+  const std::unordered_set<std::string> local{local_vec.begin(),
+                                              local_vec.end()};
+  size_t shared_bytes = 0;
+  for (const auto& name : names) {
+    if (!local.count(name)) {
+      continue;
+    }
+    auto* blob = ws->GetBlob(name);
+    if (!BlobIsTensorType(*blob, CPU)) {
+      continue;
+    }
+    const auto& tensor = blob->Get<Tensor>();
+    Tensor stored = Intern(tensor);
+    if (!stored.is_same(tensor)) {
+      shared_bytes += stored.nbytes();
+      BlobSetTensor(blob, std::move(stored));
+    }
+  }
+  return shared_bytes;
+}
+
+size_t SharedTensorStore::Prune() {
+  std::lock_guard<std::mutex> guard(mutex_);
+  size_t released = 0;
+  for (auto it = tensors_.begin(); it != tensors_.end();) {
+    if (it->second.getIntrusivePtr().use_count() == 1) {
+      it = tensors_.erase(it);
+      ++released;
+    } else {
+      ++it;
+    }
+  }
+  return released;
+}
+
+size_t SharedTensorStore::size() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  return tensors_.size();
+}
+
+size_t SharedTensorStore::nbytes() const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  size_t total = 0;
+  for (const auto& entry : tensors_) {
+    total += entry.second.nbytes();
+  }
+  return total;
+}
+
+} // namespace caffe2
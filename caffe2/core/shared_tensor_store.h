@@ -0,0 +1,74 @@
+#ifndef CAFFE2_CORE_SHARED_TENSOR_STORE_H_
+#define CAFFE2_CORE_SHARED_TENSOR_STORE_H_
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/tensor.h"
+
+namespace caffe2 {
+
+class Workspace;
+
+/**
+ * A store of read-only CPU tensors indexed by their contents.
+ *
+ * Workspaces loaded from model variants that only differ in a few layers
+ * hold mostly identical weights. Sharing the blobs of such workspaces through
+ * the store leaves a single copy of every distinct weight tensor in memory,
+ * whichever workspace or predictor it was first loaded in.
+ *
+ * The stored tensors are shared, not copied: they must not be written to once
+ * they are in the store, which is what Predictor already guarantees for its
+ * parameters. The store keeps a reference to each of them until Prune() finds
+ * it is the only one left. The store is thread safe.
+ */
+class CAFFE2_API SharedTensorStore {
+ public:
+  SharedTensorStore() = default;
+  SharedTensorStore(const SharedTensorStore&) = delete;
+  SharedTensorStore& operator=(const SharedTensorStore&) = delete;
+
+  /**
+   * Returns the stored tensor that has the same type, shape and contents as
+   * `tensor`, after adding `tensor` to the store if there is none. Tensors
+   * that are not CPU tensors of a fundamental type are returned as they are
+   * and not stored.
+   */
+  Tensor Intern(const Tensor& tensor);
+
+  /**
+   * Replaces the CPU tensors in the given local blobs of `ws` by the ones in
+   * the store, see Intern(). Blobs that don't exist or are not tensors are
+   * skipped. Returns the number of bytes of tensor data that are no longer
+   * held by `ws` alone.
+   */
+  size_t ShareBlobs(Workspace* ws, const std::vector<std::string>& names);
+
+  /**
+   * Releases the stored tensors that are not used outside the store anymore.
+   * Returns the number of tensors released.
+   */
+  size_t Prune();
+
+  /**
+   * The number of tensors, and the total bytes of their data, in the store.
+   */
+  size_t size() const;
+  size_t nbytes() const;
+
+ private:
+  static bool IsShareable(const Tensor& tensor);
+  static size_t Hash(const Tensor& tensor);
+  static bool Equal(const Tensor& a, const Tensor& b);
+
+  mutable std::mutex mutex_;
+  std::unordered_multimap<size_t, Tensor> tensors_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_SHARED_TENSOR_STORE_H_
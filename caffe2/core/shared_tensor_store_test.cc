@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include "caffe2/core/shared_tensor_store.h"
+#include "caffe2/core/workspace.h"
+
+namespace caffe2 {
+
+namespace {
+
+void fillBlob(Workspace* ws, const std::string& name, float value) {
+  auto* tensor =
+      BlobGetMutableTensor(ws->CreateBlob(name), {2, 3}, at::dtype<float>());
+  auto* data = tensor->mutable_data<float>();
+  for (int i = 0; i < tensor->numel(); ++i) {
+    data[i] = value + i;
+  }
+}
+
+const Tensor& blobTensor(Workspace* ws, const std::string& name) {
+  return ws->GetBlob(name)->Get<Tensor>();
+}
+
+} // namespace
+
+TEST(SharedTensorStoreTest, SharesIdenticalTensors) {
+  SharedTensorStore store;
+  Workspace ws1, ws2;
+  fillBlob(&ws1, "w", 1);
+  fillBlob(&ws1, "b", 2);
+  fillBlob(&ws2, "w", 1);
+  fillBlob(&ws2, "b", 3);
+
+  EXPECT_EQ(store.ShareBlobs(&ws1, {"w", "b", "missing"}), 0);
+  EXPECT_EQ(store.size(), 2);
+  EXPECT_EQ(store.ShareBlobs(&ws2, {"w", "b"}), 6 * sizeof(float));
+  EXPECT_EQ(store.size(), 3);
+  EXPECT_EQ(store.nbytes(), 3 * 6 * sizeof(float));
+
+  EXPECT_TRUE(blobTensor(&ws1, "w").is_same(blobTensor(&ws2, "w")));
+  EXPECT_FALSE(blobTensor(&ws1, "b").is_same(blobTensor(&ws2, "b")));
+  EXPECT_EQ(blobTensor(&ws2, "b").data<float>()[0], 3);
+}
+
+TEST(SharedTensorStoreTest, DoesNotShareDifferentShapes) {
+  SharedTensorStore store;
+  Tensor a(std::vector<int64_t>{2, 3}, CPU);
+  Tensor b(std::vector<int64_t>{3, 2}, CPU);
+  a.mutable_data<float>();
+  b.mutable_data<float>();
+  for (int i = 0; i < 6; ++i) {
+    a.mutable_data<float>()[i] = b.mutable_data<float>()[i] = i;
+  }
+  EXPECT_TRUE(store.Intern(a).is_same(a));
+  EXPECT_TRUE(store.Intern(b).is_same(b));
+  EXPECT_EQ(store.size(), 2);
+}
+
+TEST(SharedTensorStoreTest, PruneReleasesUnusedTensors) {
+  SharedTensorStore store;
+  {
+    Workspace ws;
+    fillBlob(&ws, "w", 1);
+    store.ShareBlobs(&ws, {"w"});
+    EXPECT_EQ(store.Prune(), 0);
+  }
+  EXPECT_EQ(store.Prune(), 1);
+  EXPECT_EQ(store.size(), 0);
+}
+
+} // namespace caffe2
@@ -0,0 +1,183 @@
+#include "caffe2/core/work_stealing_thread_pool.h"
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+namespace {
+
+// The pool and queue of the worker running on this thread, if any
+thread_local const WorkStealingThreadPool* current_pool = nullptr;
+thread_local size_t current_worker = 0;
+
+} // namespace
+
+WorkStealingThreadPool::WorkStealingThreadPool(int pool_size, int numa_node_id)
+    : running_(true), pending_(0), available_(0), next_worker_(0) {
+  if (pool_size < 0) {
+    pool_size = defaultNumThreads();
+  }
+  for (int i = 0; i < pool_size; ++i) {
+    workers_.push_back(caffe2::make_unique<Worker>());
+  }
+  available_ = pool_size;
+  for (int i = 0; i < pool_size; ++i) {
+    threads_.emplace_back([this, i, numa_node_id]() {
+      c10::setThreadName("CaffeTaskThread");
+      c10::NUMABind(numa_node_id);
+      current_pool = this;
+      current_worker = i;
+      main_loop(i);
+    });
+  }
+}
+
+WorkStealingThreadPool::~WorkStealingThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  condition_.notify_all();
+  for (auto& thread : threads_) {
+    try {
+      thread.join();
+    } catch (const std::exception&) {
+    }
+  }
+}
+
+size_t WorkStealingThreadPool::size() const {
+  return threads_.size();
+}
+
+size_t WorkStealingThreadPool::numAvailable() const {
+  return available_;
+}
+
+bool WorkStealingThreadPool::inThreadPool() const {
+  return current_pool == this;
+}
+
+void WorkStealingThreadPool::run(const std::function<void()>& func) {
+  if (workers_.empty()) {
+    throw std::runtime_error("No threads to run a task");
+  }
+  size_t index = inThreadPool() ? current_worker
+                                : next_worker_++ % workers_.size();
+  {
+    std::lock_guard<std::mutex> lock(workers_[index]->mutex);
+    workers_[index]->tasks.push_back(func);
+  }
+  {
+    // counted under mutex_, so a worker going to sleep can't miss the task
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++pending_;
+  }
+  condition_.notify_one();
+}
+
+bool WorkStealingThreadPool::tryPop(size_t index, std::function<void()>* task) {
+  {
+    auto& own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      *task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      --pending_;
+      return true;
+    }
+  }
+  for (size_t offset = 1; offset < workers_.size(); ++offset) {
+    auto& victim = *workers_[(index + offset) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      *task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      --pending_;
+      return true;
+    }
+  }
+  return false;
+}
+
+void WorkStealingThreadPool::main_loop(size_t index) {
+  while (true) {
+    std::function<void()> task;
+    if (tryPop(index, &task)) {
+      --available_;
+      try {
+        task();
+      } catch (const std::exception&) {
+      }
+      // destroy the task before becoming available, like ThreadPool does
+      task = nullptr;
+      ++available_;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    condition_.wait(lock, [this] { return !running_ || pending_ > 0; });
+    if (!running_) {
+      return;
+    }
+  }
+}
+
+QuotaThreadPool::QuotaThreadPool(
+    std::shared_ptr<c10::TaskThreadPoolBase> pool,
+    size_t quota)
+    : state_(std::make_shared<State>()) {
+  CAFFE_ENFORCE(pool);
+  CAFFE_ENFORCE_GT(quota, 0);
+  state_->pool = std::move(pool);
+  state_->quota = quota;
+}
+
+void QuotaThreadPool::run(const std::function<void()>& func) {
+  {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->running >= state_->quota && !state_->pool->numAvailable()) {
+      state_->waiting.push_back(func);
+      return;
+    }
+    ++state_->running;
+  }
+  submit(state_, func);
+}
+
+void QuotaThreadPool::submit(
+    const std::shared_ptr<State>& state,
+    std::function<void()> func) {
+  state->pool->run([state, func]() {
+    try {
+      func();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Exception in a task: " << e.what();
+    }
+    std::function<void()> next;
+    {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (state->waiting.empty()) {
+        --state->running;
+        return;
+      }
+      next = std::move(state->waiting.front());
+      state->waiting.pop_front();
+    }
+    // the waiting task takes over the slot of the finished one
+    submit(state, std::move(next));
+  });
+}
+
+size_t QuotaThreadPool::size() const {
+  return state_->pool->size();
+}
+
+size_t QuotaThreadPool::numAvailable() const {
+  return state_->pool->numAvailable();
+}
+
+bool QuotaThreadPool::inThreadPool() const {
+  return state_->pool->inThreadPool();
+}
+
+} // namespace caffe2
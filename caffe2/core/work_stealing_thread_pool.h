@@ -0,0 +1,104 @@
+#ifndef CAFFE2_CORE_WORK_STEALING_THREAD_POOL_H_
+#define CAFFE2_CORE_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "c10/core/thread_pool.h"
+#include "caffe2/core/common.h"
+
+namespace caffe2 {
+
+/**
+ * A thread pool with a task queue per worker.
+ *
+ * Tasks run from a worker of the pool, e.g. the children of a finished task
+ * of an async net, go to the queue of that worker, which runs its own
+ * queue last in, first out to keep their data in its cache. Other tasks are
+ * spread over the queues round robin. Idle workers steal the oldest tasks of
+ * the other queues, so workers don't contend on a single queue when many nets
+ * share the pool. All workers are bound to the NUMA node of the pool.
+ */
+class CAFFE2_API WorkStealingThreadPool : public c10::TaskThreadPoolBase {
+ public:
+  explicit WorkStealingThreadPool(int pool_size, int numa_node_id = -1);
+  ~WorkStealingThreadPool() override;
+
+  void run(const std::function<void()>& func) override;
+
+  size_t size() const override;
+
+  size_t numAvailable() const override;
+
+  bool inThreadPool() const override;
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void main_loop(size_t index);
+  bool tryPop(size_t index, std::function<void()>* task);
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // guards sleeping and waking up of the workers
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  bool running_;
+  // tasks queued and not taken by a worker yet
+  std::atomic<size_t> pending_;
+  std::atomic<size_t> available_;
+  std::atomic<size_t> next_worker_;
+};
+
+/**
+ * Runs the tasks of one net on a pool shared with other nets, with a soft
+ * limit on how many of them run at once.
+ *
+ * Up to `quota` tasks are run on the pool right away, more only while the
+ * pool has idle threads. The others wait until a running task of the net
+ * finishes, so a net with many ready tasks doesn't crowd the other nets out
+ * of the pool.
+ */
+class CAFFE2_API QuotaThreadPool : public c10::TaskThreadPoolBase {
+ public:
+  QuotaThreadPool(std::shared_ptr<c10::TaskThreadPoolBase> pool, size_t quota);
+
+  void run(const std::function<void()>& func) override;
+
+  size_t size() const override;
+
+  size_t numAvailable() const override;
+
+  bool inThreadPool() const override;
+
+ private:
+  // Shared with the tasks on the pool, which may still finish up after the
+  // net and this wrapper are gone.
+  struct State {
+    std::shared_ptr<c10::TaskThreadPoolBase> pool;
+    size_t quota;
+    std::mutex mutex;
+    size_t running = 0;
+    std::deque<std::function<void()>> waiting;
+  };
+
+  static void submit(
+      const std::shared_ptr<State>& state,
+      std::function<void()> func);
+
+  std::shared_ptr<State> state_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_CORE_WORK_STEALING_THREAD_POOL_H_
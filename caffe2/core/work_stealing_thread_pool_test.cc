@@ -0,0 +1,133 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "caffe2/core/work_stealing_thread_pool.h"
+
+namespace caffe2 {
+
+namespace {
+
+// Blocks until `count` calls to done()
+class Latch {
+ public:
+  explicit Latch(int count) : count_(count) {}
+
+  void done() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--count_ == 0) {
+      cv_.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return count_ == 0; });
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int count_;
+};
+
+} // namespace
+
+TEST(WorkStealingThreadPoolTest, RunsAllTasks) {
+  WorkStealingThreadPool pool(4);
+  EXPECT_EQ(pool.size(), 4);
+  EXPECT_FALSE(pool.inThreadPool());
+
+  // every task runs two more from inside the pool
+  const int kRoots = 100;
+  std::atomic<int> count{0};
+  Latch latch(3 * kRoots);
+  for (int i = 0; i < kRoots; ++i) {
+    pool.run([&]() {
+      EXPECT_TRUE(pool.inThreadPool());
+      for (int j = 0; j < 2; ++j) {
+        pool.run([&]() {
+          ++count;
+          latch.done();
+        });
+      }
+      ++count;
+      latch.done();
+    });
+  }
+  latch.wait();
+  EXPECT_EQ(count, 3 * kRoots);
+}
+
+TEST(WorkStealingThreadPoolTest, IdleWorkersSteal) {
+  WorkStealingThreadPool pool(2);
+  std::atomic<int> count{0};
+  Latch latch(2);
+  // the second task is queued on the worker blocked by the first one, and
+  // can only run if the other worker steals it
+  pool.run([&]() {
+    Latch inner(1);
+    pool.run([&]() {
+      ++count;
+      inner.done();
+    });
+    inner.wait();
+    ++count;
+    latch.done();
+  });
+  latch.wait();
+  EXPECT_EQ(count, 2);
+}
+
+TEST(QuotaThreadPoolTest, LimitsRunningTasksOfBusyPool) {
+  auto shared = std::make_shared<WorkStealingThreadPool>(4);
+
+  // occupy all threads of the shared pool
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool release = false;
+  Latch blockers_started(4);
+  Latch blockers_done(4);
+  for (int i = 0; i < 4; ++i) {
+    shared->run([&]() {
+      blockers_started.done();
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [&] { return release; });
+      blockers_done.done();
+    });
+  }
+  blockers_started.wait();
+
+  QuotaThreadPool pool(shared, 2);
+  std::atomic<int> running{0};
+  std::atomic<int> max_running{0};
+  const int kTasks = 20;
+  Latch latch(kTasks);
+  for (int i = 0; i < kTasks; ++i) {
+    pool.run([&]() {
+      int now = ++running;
+      int max = max_running;
+      while (now > max && !max_running.compare_exchange_weak(max, now)) {
+      }
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      --running;
+      latch.done();
+    });
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  latch.wait();
+  blockers_done.wait();
+  // no thread was idle when the tasks were queued, so no more than the quota
+  // ran at once
+  EXPECT_LE(max_running, 2);
+}
+
+} // namespace caffe2
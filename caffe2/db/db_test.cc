@@ -5,10 +5,14 @@
 
 #include "caffe2/core/blob_serialization.h"
 #include "caffe2/core/db.h"
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/proto/caffe2_pb.h"
 #include <gtest/gtest.h>
 
+C10_DECLARE_int(caffe2_db_prefetch_size);
+C10_DECLARE_int(caffe2_db_prefetch_decode_threads);
+
 namespace caffe2 {
 namespace db {
 
@@ -86,6 +90,42 @@ TEST(DBSeekTest, LMDB) {
   DBSeekTestWrapper("lmdb");
 }
 
+TEST(DBSeekTest, PrefetchLevelDB) {
+  DBSeekTestWrapper("prefetch_leveldb");
+}
+
+TEST(DBReaderTest, PrefetchDecode) {
+  std::string name = std::tmpnam(nullptr);
+  {
+    std::unique_ptr<DB> db(CreateDB("minidb", name, NEW));
+    std::unique_ptr<Transaction> trans(db->NewTransaction());
+    for (int i = 0; i < kMaxItems; ++i) {
+      TensorProtos protos;
+      protos.add_protos()->add_int32_data(i);
+      trans->Put(c10::to_string(i), protos.SerializeAsString());
+    }
+    trans->Commit();
+  }
+  const int old_size = FLAGS_caffe2_db_prefetch_size;
+  const int old_threads = FLAGS_caffe2_db_prefetch_decode_threads;
+  FLAGS_caffe2_db_prefetch_size = 3;
+  FLAGS_caffe2_db_prefetch_decode_threads = 2;
+  {
+    DBReader reader("prefetch_minidb", name);
+    // wraps around the end of the db, which reads it again from the start
+    for (int i = 0; i < 2 * kMaxItems; ++i) {
+      string key;
+      TensorProtos protos;
+      reader.Read(&key, &protos);
+      EXPECT_EQ(key, c10::to_string(i % kMaxItems));
+      ASSERT_EQ(protos.protos_size(), 1);
+      EXPECT_EQ(protos.protos(0).int32_data(0), i % kMaxItems);
+    }
+  }
+  FLAGS_caffe2_db_prefetch_size = old_size;
+  FLAGS_caffe2_db_prefetch_decode_threads = old_threads;
+}
+
 TEST(DBReaderTest, Reader) {
   std::string name = std::tmpnam(nullptr);
   CreateAndFill("leveldb", name);
@@ -0,0 +1,296 @@
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "caffe2/core/db.h"
+#include "caffe2/core/flags.h"
+#include "caffe2/core/logging.h"
+
+C10_DEFINE_int(
+    caffe2_db_prefetch_size,
+    64,
+    "The number of records that the cursors of prefetch_ dbs read ahead.");
+C10_DEFINE_int(
+    caffe2_db_prefetch_decode_threads,
+    0,
+    "The number of threads that parse the records of prefetch_ dbs as "
+    "TensorProtos ahead of time. 0 leaves the parsing to the reader.");
+
+namespace caffe2 {
+namespace db {
+
+/**
+ * A cursor that reads the records of another cursor ahead, on a background
+ * thread, into a buffer of a bounded size.
+ *
+ * With decode threads, the buffered records are also parsed as TensorProtos
+ * in parallel, and handed out by ParseValue(), so that I/O, parsing and the
+ * consumer of the records all overlap.
+ */
+class PrefetchCursor : public Cursor {
+ public:
+  PrefetchCursor(
+      std::unique_ptr<Cursor> cursor,
+      int buffer_size,
+      int num_decode_threads)
+      : cursor_(std::move(cursor)), buffer_size_(buffer_size) {
+    CAFFE_ENFORCE(cursor_);
+    CAFFE_ENFORCE_GT(buffer_size, 0);
+    CAFFE_ENFORCE_GE(num_decode_threads, 0);
+    for (int i = 0; i < num_decode_threads; ++i) {
+      decoders_.emplace_back([this]() { DecodeLoop(); });
+    }
+    // started last, it looks at decoders_
+    reader_ = std::thread([this]() { ReadLoop(); });
+  }
+
+  ~PrefetchCursor() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    space_cv_.notify_all();
+    records_cv_.notify_all();
+    decode_cv_.notify_all();
+    reader_.join();
+    for (auto& decoder : decoders_) {
+      decoder.join();
+    }
+  }
+
+  void Seek(const string& key) override {
+    Reset([this, &key]() { cursor_->Seek(key); });
+  }
+  bool SupportsSeek() override {
+    return cursor_->SupportsSeek();
+  }
+  void SeekToFirst() override {
+    Reset([this]() { cursor_->SeekToFirst(); });
+  }
+
+  void Next() override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      WaitForRecord(&lock);
+      CAFFE_ENFORCE(!buffer_.empty(), "Next() past the end of the db");
+      buffer_.pop_front();
+    }
+    space_cv_.notify_one();
+  }
+
+  string key() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return Front(&lock)->key;
+  }
+
+  string value() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return Front(&lock)->value;
+  }
+
+  void ParseValue(TensorProtos* protos) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto record = Front(&lock);
+    records_cv_.wait(lock, [&record]() { return record->state != PENDING; });
+    if (record->state == DECODED) {
+      // The decoded protos are handed out only once, a second call on the
+      // same record parses the value again.
+      protos->Swap(&record->protos);
+      record->state = CONSUMED;
+      return;
+    }
+    lock.unlock();
+    Cursor::ParseValue(protos);
+  }
+
+  bool Valid() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    WaitForRecord(&lock);
+    return !buffer_.empty();
+  }
+
+ private:
+  enum State {
+    // waiting for a decode thread
+    PENDING,
+    DECODED,
+    // not decoded ahead, or the decoded protos were handed out
+    CONSUMED,
+  };
+
+  struct Record {
+    string key;
+    string value;
+    TensorProtos protos;
+    State state;
+  };
+
+  // Waits until the front record is read, or the end of the db is reached.
+  // Rethrows errors of the reader thread once the records read before are
+  // consumed.
+  void WaitForRecord(std::unique_lock<std::mutex>* lock) {
+    records_cv_.wait(*lock, [this]() { return !buffer_.empty() || end_; });
+    if (buffer_.empty() && error_) {
+      std::rethrow_exception(error_);
+    }
+  }
+
+  std::shared_ptr<Record> Front(std::unique_lock<std::mutex>* lock) {
+    WaitForRecord(lock);
+    CAFFE_ENFORCE(!buffer_.empty(), "Reading past the end of the db");
+    return buffer_.front();
+  }
+
+  // Drops the records read ahead and moves the underlying cursor.
+  void Reset(const std::function<void()>& seek) {
+    // The reader holds cursor_mutex_ from reading a record to buffering it,
+    // so no record of the old position is buffered after this.
+    std::lock_guard<std::mutex> cursor_lock(cursor_mutex_);
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      buffer_.clear();
+      for (auto& record : to_decode_) {
+        record->state = CONSUMED;
+      }
+      to_decode_.clear();
+      end_ = false;
+      error_ = nullptr;
+    }
+    seek();
+    space_cv_.notify_one();
+    records_cv_.notify_all();
+  }
+
+  void ReadLoop() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this]() {
+          return stop_ || (!end_ && buffer_.size() < buffer_size_);
+        });
+        if (stop_) {
+          return;
+        }
+      }
+      std::lock_guard<std::mutex> cursor_lock(cursor_mutex_);
+      std::shared_ptr<Record> record;
+      std::exception_ptr error;
+      bool end = false;
+      try {
+        if (cursor_->Valid()) {
+          record = std::make_shared<Record>();
+          record->key = cursor_->key();
+          record->value = cursor_->value();
+          record->state = decoders_.empty() ? CONSUMED : PENDING;
+          cursor_->Next();
+        } else {
+          end = true;
+        }
+      } catch (...) {
+        error = std::current_exception();
+        end = true;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (record) {
+          buffer_.push_back(record);
+          if (record->state == PENDING) {
+            to_decode_.push_back(record);
+          }
+        }
+        end_ = end;
+        error_ = error;
+      }
+      records_cv_.notify_all();
+      if (record && record->state == PENDING) {
+        decode_cv_.notify_one();
+      }
+    }
+  }
+
+  void DecodeLoop() {
+    while (true) {
+      std::shared_ptr<Record> record;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        decode_cv_.wait(
+            lock, [this]() { return stop_ || !to_decode_.empty(); });
+        if (stop_) {
+          return;
+        }
+        record = to_decode_.front();
+        to_decode_.pop_front();
+      }
+      // Values that don't parse are left to the reader, which parses them
+      // again and reports the error.
+      bool decoded = record->protos.ParseFromString(record->value);
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        record->state = decoded ? DECODED : CONSUMED;
+      }
+      records_cv_.notify_all();
+    }
+  }
+
+  std::unique_ptr<Cursor> cursor_;
+  const size_t buffer_size_;
+
+  // guards cursor_ against seeks while the reader thread reads it
+  std::mutex cursor_mutex_;
+  // guards all members below
+  std::mutex mutex_;
+  std::condition_variable space_cv_;
+  std::condition_variable records_cv_;
+  std::condition_variable decode_cv_;
+  std::deque<std::shared_ptr<Record>> buffer_;
+  std::deque<std::shared_ptr<Record>> to_decode_;
+  // whether the reader reached the end of the db
+  bool end_ = false;
+  std::exception_ptr error_;
+  bool stop_ = false;
+
+  std::thread reader_;
+  std::vector<std::thread> decoders_;
+};
+
+/**
+ * Wraps a database of any registered type. Only the cursors read ahead,
+ * transactions are those of the wrapped database.
+ */
+class PrefetchDB : public DB {
+ public:
+  PrefetchDB(std::unique_ptr<DB> db, const string& source, Mode mode)
+      : DB(source, mode), db_(std::move(db)) {}
+
+  void Close() override {
+    db_->Close();
+  }
+  unique_ptr<Cursor> NewCursor() override {
+    return caffe2::make_unique<PrefetchCursor>(
+        db_->NewCursor(),
+        FLAGS_caffe2_db_prefetch_size,
+        FLAGS_caffe2_db_prefetch_decode_threads);
+  }
+  unique_ptr<Transaction> NewTransaction() override {
+    return db_->NewTransaction();
+  }
+
+ private:
+  std::unique_ptr<DB> db_;
+};
+
+unique_ptr<DB>
+CreatePrefetchDB(const string& db_type, const string& source, Mode mode) {
+  auto db = CreateDB(db_type, source, mode);
+  if (!db) {
+    return nullptr;
+  }
+  return caffe2::make_unique<PrefetchDB>(std::move(db), source, mode);
+}
+
+} // namespace db
+} // namespace caffe2
@@ -0,0 +1,38 @@
+#include <caffe2/ideep/operators/conv_pool_base_op.h>
+
+using namespace caffe2;
+
+namespace {
+
+class IDEEPInt8ChannelShuffleOp final : public IDEEPConvPoolOpBase {
+ public:
+  USE_IDEEP_DEF_ALIASES();
+  USE_IDEEP_CONV_POOL_BASE_FUNCTIONS();
+
+  IDEEPInt8ChannelShuffleOp(const OperatorDef& operator_def, Workspace* ws)
+      : IDEEPConvPoolOpBase(operator_def, ws) {}
+  ~IDEEPInt8ChannelShuffleOp() override {}
+
+  bool RunOnDeviceWithOrderNCHW() override {
+    const auto& X = Input(INPUT);
+    auto* Y = Output(OUTPUT);
+    CAFFE_ENFORCE(X.get_data_type() == idtype::s8
+        || X.get_data_type() == idtype::u8);
+
+    ideep::channel_shuffle_forward::compute(X, *Y, group_);
+    Y->set_scale(X.get_scale());
+
+    return true;
+  }
+
+ private:
+  INPUT_TAGS(INPUT);
+  OUTPUT_TAGS(OUTPUT);
+};
+
+REGISTER_IDEEP_OPERATOR_WITH_ENGINE(
+    Int8ChannelShuffle,
+    DNNLOWP,
+    IDEEPInt8ChannelShuffleOp);
+
+} // namespace
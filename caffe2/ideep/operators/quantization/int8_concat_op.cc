@@ -0,0 +1,93 @@
+#include <caffe2/ideep/ideep_utils.h>
+
+using namespace caffe2;
+
+namespace {
+
+class IDEEPInt8ConcatOp final : public IDEEPOperator {
+ public:
+  USE_IDEEP_DEF_ALIASES();
+  USE_IDEEP_OPERATOR_FUNCTIONS();
+
+  IDEEPInt8ConcatOp(const OperatorDef& operator_def, Workspace* ws)
+      : IDEEPOperator(operator_def, ws),
+        nhwc_(OperatorBase::GetSingleArgument<string>("order", "") == "NHWC"),
+        add_axis_(OperatorBase::GetSingleArgument<int>("add_axis", 0)) {
+    axis_ = OperatorBase::GetSingleArgument<int>("axis", nhwc_ ? 3 : 1);
+    if (HasArgument("Y_scale")) {
+      Y_scales_ = ConvertScales(
+          {this->template GetSingleArgument<float>("Y_scale", 1.0)});
+    }
+    if (HasArgument("Y_zero_point")) {
+      auto zero_point =
+          this->template GetSingleArgument<int32_t>("Y_zero_point", 0);
+      CAFFE_ENFORCE(zero_point == 0 || zero_point == 128,
+          "Not support this zero point");
+      Y_data_type_ = zero_point == 0 ? idtype::u8 : idtype::s8;
+    }
+  }
+  ~IDEEPInt8ConcatOp() override {}
+
+  bool RunOnDevice() override {
+    const auto& X0 = Input(INPUT0);
+    const auto Y_data_type = Y_data_type_ != idtype::data_undef
+        ? Y_data_type_ : X0.get_data_type();
+    const auto Y_scales = !Y_scales_.empty() ? Y_scales_ : X0.get_scale();
+
+    // Inputs that are not quantized as the output are requantized first,
+    // the concat itself only copies data.
+    vector<itensor> inputs_itensor;
+    for (int i = 0; i < InputSize(); ++i) {
+      const auto& Xi = Input(i);
+      CAFFE_ENFORCE(Xi.get_data_type() == idtype::s8
+          || Xi.get_data_type() == idtype::u8);
+      if (Xi.get_data_type() == Y_data_type && Xi.get_scale() == Y_scales) {
+        inputs_itensor.emplace_back(Xi);
+        continue;
+      }
+      itensor Xi_q;
+      Xi_q.init({Xi.get_dims(), Y_data_type, iformat::nhwc});
+      Xi_q.set_scale(Y_scales);
+      Xi_q.feed_from(Xi);
+      inputs_itensor.emplace_back(std::move(Xi_q));
+    }
+
+    int adj_size = X0.ndims() + (add_axis_ ? 1 : 0);
+    int canonical_axis = canonical_axis_index_(axis_, adj_size);
+    // The dims of an itensor are in NCHW order whatever its format, so the
+    // axis of NHWC images is moved to the place of its dim in NCHW.
+    if (nhwc_ && adj_size == 4 && !add_axis_) {
+      static const int nchw_axis[] = {0, 2, 3, 1};
+      canonical_axis = nchw_axis[canonical_axis];
+    }
+
+    auto* Y = Output(OUTPUT);
+    auto axis_vdata =
+        ideep::concat::compute(inputs_itensor, canonical_axis, add_axis_, *Y);
+    Y->set_scale(Y_scales);
+
+    if (OutputSize() > 1) {
+      Tensor* axis_info = OutputTensor(AXIS_INFO,
+        vector<int64_t>(1, InputSize()), at::dtype<int>().device(CPU));
+      auto* axis_data = axis_info->template mutable_data<int>();
+      for (int i = 0; i < axis_vdata.size(); i++) {
+        axis_data[i] = axis_vdata[i];
+      }
+    }
+    return true;
+  }
+
+ private:
+  bool nhwc_;
+  int axis_;
+  int add_axis_;
+  iscale Y_scales_;
+  idtype Y_data_type_ {idtype::data_undef};
+
+  INPUT_TAGS(INPUT0);
+  OUTPUT_TAGS(OUTPUT, AXIS_INFO);
+};
+
+REGISTER_IDEEP_OPERATOR_WITH_ENGINE(Int8Concat, DNNLOWP, IDEEPInt8ConcatOp);
+
+} // namespace
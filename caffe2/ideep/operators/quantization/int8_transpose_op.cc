@@ -0,0 +1,40 @@
+#include <caffe2/ideep/ideep_utils.h>
+
+using namespace caffe2;
+
+namespace {
+
+// The axes are those of the dims of the itensor, which are in NCHW order
+// whatever its format, as for the FP32 Transpose.
+class IDEEPInt8TransposeOp final : public IDEEPOperator {
+ public:
+  USE_IDEEP_DEF_ALIASES();
+  USE_IDEEP_OPERATOR_FUNCTIONS();
+
+  IDEEPInt8TransposeOp(const OperatorDef& operator_def, Workspace* ws)
+      : IDEEPOperator(operator_def, ws),
+        axes_(this->template GetRepeatedArgument<int>("axes")) {}
+  ~IDEEPInt8TransposeOp() override {}
+
+  bool RunOnDevice() override {
+    const auto& X = Input(INPUT);
+    auto* Y = Output(OUTPUT);
+    CAFFE_ENFORCE(X.get_data_type() == idtype::s8
+        || X.get_data_type() == idtype::u8);
+
+    Y->transpose_from(X, axes_);
+    Y->set_scale(X.get_scale());
+
+    return true;
+  }
+
+ private:
+  std::vector<int> axes_;
+
+  INPUT_TAGS(INPUT);
+  OUTPUT_TAGS(OUTPUT);
+};
+
+REGISTER_IDEEP_OPERATOR_WITH_ENGINE(Int8Transpose, DNNLOWP, IDEEPInt8TransposeOp);
+
+} // namespace
@@ -149,6 +149,17 @@ The dimension of the output image will always be cropxcrop
         "random_scale",
         "[min, max] shortest-side desired for image resize. "
         "Defaults to [-1, -1] or no random resize desired.")
+    .Arg(
+        "prefetch_depth",
+        "Number of batches read and decoded ahead of the one being output, "
+        "at the same time. Defaults to 1")
+    .Arg(
+        "dct_scaled_decode",
+        "If 1, JPEG images are decoded at 1/2, 1/4 or 1/8 of their size when "
+        "they are scaled down (with the scale argument) or random sized "
+        "cropped (with scale_jitter_type 1) to at most that size anyway, which "
+        "is much faster. Not applied to images with a bounding box. "
+        "Defaults to 0")
     .Input(0, "reader", "The input reader (a db::DBReader)")
     .Output(0, "data", "Tensor containing the images")
     .Output(1, "label", "Tensor containing the labels")
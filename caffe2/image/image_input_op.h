@@ -5,7 +5,9 @@
 #include <opencv2/opencv.hpp>
 
 #include <algorithm>
+#include <condition_variable>
 #include <iostream>
+#include <mutex>
 
 #include "c10/core/thread_pool.h"
 #include "caffe2/core/common.h"
@@ -55,6 +57,8 @@ class ImageInputOp final : public PrefetchOperator<Context> {
   explicit ImageInputOp(const OperatorDef& operator_def, Workspace* ws);
   ~ImageInputOp() {
     PrefetchOperator<Context>::Finalize();
+    // The batches after the last prefetched one may still be decoding.
+    thread_pool_->waitWorkComplete();
   }
 
   bool Prefetch() override;
@@ -74,24 +78,56 @@ class ImageInputOp final : public PrefetchOperator<Context> {
   // to be privatized per launch.
   using PerImageArg = struct { BoundingBox bounding_params; };
 
+  // A batch decoded by the thread pool. With a prefetch_depth of N, the
+  // images of the next N batches are read and decoded at the same time.
+  struct PrefetchedBatch {
+    Tensor image;
+    Tensor label;
+    vector<Tensor> additional_outputs;
+    // number of exceptions produced by opencv while reading image data
+    std::atomic<long> num_decode_errors{0};
+    // number of images of the batch that are still being decoded
+    int num_pending = 0;
+    std::mutex mutex;
+    std::condition_variable done;
+  };
+
   bool GetImageAndLabelAndInfoFromDBValue(
       const string& value,
       cv::Mat* img,
       PerImageArg& info,
       int item_id,
+      PrefetchedBatch* batch,
       std::mt19937* randgen);
+  // Decodes an encoded image, at 1/2, 1/4 or 1/8 of its size if
+  // dct_scaled_decode is set and the rest of the transformation allows it.
+  // With INCEPTION_STYLE jittering, the random crop may then be chosen
+  // before decoding, which sets crop_chosen, and applied to the decoded
+  // image, which sets inception_scale_jitter if one was found.
+  cv::Mat DecodeImage(
+      const char* data,
+      int size,
+      const PerImageArg& info,
+      std::mt19937* randgen,
+      bool* crop_chosen,
+      bool* inception_scale_jitter,
+      PrefetchedBatch* batch);
   void DecodeAndTransform(
       const std::string& value,
       float* image_data,
       int item_id,
       const int channels,
+      PrefetchedBatch* batch,
       std::size_t thread_index);
   void DecodeAndTransposeOnly(
       const std::string& value,
       uint8_t* image_data,
       int item_id,
       const int channels,
+      PrefetchedBatch* batch,
       std::size_t thread_index);
+  // Reads a batch from the db and starts decoding it on the thread pool.
+  void StartBatch(PrefetchedBatch* batch);
   bool ApplyTransformOnGPU(
       const std::vector<std::int64_t>& dims,
       const c10::Device& type);
@@ -154,10 +190,18 @@ class ImageInputOp final : public PrefetchOperator<Context> {
   // Working variables
   std::vector<std::mt19937> randgen_per_thread_;
 
-  // number of exceptions produced by opencv while reading image data
-  std::atomic<long> num_decode_errors_in_batch_{0};
   // opencv exceptions tolerance
   float max_decode_error_ratio_;
+
+  // decode JPEG images at a reduced scale where possible
+  bool dct_scaled_decode_;
+
+  // The batches being decoded, in a ring: the batch Prefetch() returns next
+  // is batches_[next_batch_], followed by the others in flight.
+  int prefetch_depth_;
+  std::vector<std::unique_ptr<PrefetchedBatch>> batches_;
+  int next_batch_ = 0;
+  int num_batches_in_flight_ = 0;
 };
 
 template <class Context>
@@ -218,7 +262,12 @@ ImageInputOp<Context>::ImageInputOp(
           {-1, -1})),
       max_decode_error_ratio_(OperatorBase::template GetSingleArgument<float>(
           "max_decode_error_ratio",
-          1.0)) {
+          1.0)),
+      dct_scaled_decode_(OperatorBase::template GetSingleArgument<int>(
+          "dct_scaled_decode",
+          0)),
+      prefetch_depth_(
+          OperatorBase::template GetSingleArgument<int>("prefetch_depth", 1)) {
   if ((random_scale_[0] == -1) || (random_scale_[1] == -1)) {
     random_scaling_ = false;
   } else {
@@ -312,6 +361,7 @@ ImageInputOp<Context>::ImageInputOp(
       !use_caffe_datum_ || OutputSize() == 2,
       "There can only be 2 outputs if the Caffe datum format is used");
 
+  CAFFE_ENFORCE_GE(prefetch_depth_, 1, "prefetch_depth must be at least 1");
   CAFFE_ENFORCE(
       random_scale_.size() == 2, "Must provide [scale_min, scale_max]");
   CAFFE_ENFORCE_GE(
@@ -336,6 +386,10 @@ ImageInputOp<Context>::ImageInputOp(
 
   LOG(INFO) << "Creating an image input op with the following setting: ";
   LOG(INFO) << "    Using " << num_decode_threads_ << " CPU threads;";
+  LOG(INFO) << "    Decoding " << prefetch_depth_ << " batches ahead;";
+  if (dct_scaled_decode_) {
+    LOG(INFO) << "    Decoding JPEG images at a reduced scale where possible;";
+  }
   if (gpu_transform_) {
     LOG(INFO) << "    Performing transformation on GPU";
   }
@@ -390,39 +444,28 @@ ImageInputOp<Context>::ImageInputOp(
   for (int i = 0; i < num_decode_threads_; ++i) {
     randgen_per_thread_.emplace_back(meta_randgen());
   }
-  ReinitializeTensor(
-      &prefetched_image_,
-      {int64_t(batch_size_),
-       int64_t(crop_),
-       int64_t(crop_),
-       int64_t(color_ ? 3 : 1)},
-      at::dtype<uint8_t>().device(CPU));
-  std::vector<int64_t> sizes;
-  if (label_type_ != SINGLE_LABEL && label_type_ != SINGLE_LABEL_WEIGHTED) {
-    sizes = std::vector<int64_t>{int64_t(batch_size_), int64_t(num_labels_)};
-  } else {
-    sizes = std::vector<int64_t>{batch_size_};
-  }
-  // data type for prefetched_label_ is actually not known here..
-  ReinitializeTensor(&prefetched_label_, sizes, at::dtype<int>().device(CPU));
-
   for (int i = 0; i < additional_output_sizes_.size(); ++i) {
     prefetched_additional_outputs_on_device_.emplace_back();
     prefetched_additional_outputs_.emplace_back();
   }
+  for (int i = 0; i < prefetch_depth_; ++i) {
+    batches_.emplace_back(new PrefetchedBatch());
+    batches_.back()->additional_outputs.resize(additional_output_sizes_.size());
+  }
 }
 
-// Inception-stype scale jittering
+// Picks the region of an Inception-style random crop of an image of
+// im_height x im_width. Returns false if none was found.
 template <class Context>
-bool RandomSizedCropping(cv::Mat* img, const int crop, std::mt19937* randgen) {
-  cv::Mat scaled_img;
-  bool inception_scale_jitter = false;
-  int im_height = img->rows, im_width = img->cols;
+bool RandomSizedCrop(
+    const int im_height,
+    const int im_width,
+    std::mt19937* randgen,
+    cv::Rect* roi) {
   int area = im_height * im_width;
   std::uniform_real_distribution<> area_dis(0.08, 1.0);
   std::uniform_real_distribution<> aspect_ratio_dis(3.0 / 4.0, 4.0 / 3.0);
 
-  cv::Mat cropping;
   for (int i = 0; i < 10; ++i) {
     int target_area = int(ceil(area_dis(*randgen) * area));
     float aspect_ratio = aspect_ratio_dis(*randgen);
@@ -433,16 +476,166 @@ bool RandomSizedCropping(cv::Mat* img, const int crop, std::mt19937* randgen) {
           std::uniform_int_distribution<>(0, im_height - nh)(*randgen);
       int width_offset =
           std::uniform_int_distribution<>(0, im_width - nw)(*randgen);
-      cv::Rect ROI(width_offset, height_offset, nw, nh);
-      cropping = (*img)(ROI);
-      cv::resize(
-          cropping, scaled_img, cv::Size(crop, crop), 0, 0, cv::INTER_AREA);
-      *img = scaled_img;
-      inception_scale_jitter = true;
-      break;
+      *roi = cv::Rect(width_offset, height_offset, nw, nh);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Inception-stype scale jittering
+template <class Context>
+bool RandomSizedCropping(cv::Mat* img, const int crop, std::mt19937* randgen) {
+  cv::Rect roi;
+  if (!RandomSizedCrop<Context>(img->rows, img->cols, randgen, &roi)) {
+    return false;
+  }
+  cv::Mat scaled_img;
+  cv::resize((*img)(roi), scaled_img, cv::Size(crop, crop), 0, 0, cv::INTER_AREA);
+  *img = scaled_img;
+  return true;
+}
+
+// Reads the size of a JPEG image from its frame header, without decoding it.
+// Returns false if data isn't a JPEG image.
+inline bool GetJpegSize(const char* data, int size, int* height, int* width) {
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(data);
+  if (size < 4 || p[0] != 0xFF || p[1] != 0xD8) {
+    return false;
+  }
+  int pos = 2;
+  while (pos + 4 <= size) {
+    if (p[pos] != 0xFF) {
+      return false;
+    }
+    const uint8_t marker = p[pos + 1];
+    if (marker == 0xFF) {
+      // fill byte
+      pos++;
+      continue;
+    }
+    if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD8)) {
+      // markers without a segment
+      pos += 2;
+      continue;
+    }
+    if (marker == 0xD9 || marker == 0xDA) {
+      // end of image or start of scan before any frame header
+      return false;
+    }
+    // start of frame markers, except DHT (C4), JPG (C8) and DAC (CC)
+    if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 &&
+        marker != 0xC8 && marker != 0xCC) {
+      if (pos + 9 > size) {
+        return false;
+      }
+      *height = (p[pos + 5] << 8) | p[pos + 6];
+      *width = (p[pos + 7] << 8) | p[pos + 8];
+      return *height > 0 && *width > 0;
+    }
+    pos += 2 + ((p[pos + 2] << 8) | p[pos + 3]);
+  }
+  return false;
+}
+
+// The largest factor by which cv::imdecode can scale down a JPEG image while
+// decoding it, in the DCT domain, which OpenCV supports since 3.2.
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 2)
+constexpr int kMaxDecodeReduction = 8;
+#else
+constexpr int kMaxDecodeReduction = 1;
+#endif
+
+// The cv::imdecode flags that decode an image at 1 / reduction of its size.
+inline int DecodeFlags(const bool color, const int reduction) {
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && CV_VERSION_MINOR >= 2)
+  switch (reduction) {
+    case 2:
+      return color ? cv::IMREAD_REDUCED_COLOR_2
+                   : cv::IMREAD_REDUCED_GRAYSCALE_2;
+    case 4:
+      return color ? cv::IMREAD_REDUCED_COLOR_4
+                   : cv::IMREAD_REDUCED_GRAYSCALE_4;
+    case 8:
+      return color ? cv::IMREAD_REDUCED_COLOR_8
+                   : cv::IMREAD_REDUCED_GRAYSCALE_8;
+  }
+#endif
+  return color ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE;
+}
+
+template <class Context>
+cv::Mat ImageInputOp<Context>::DecodeImage(
+    const char* data,
+    int size,
+    const PerImageArg& info,
+    std::mt19937* randgen,
+    bool* crop_chosen,
+    bool* inception_scale_jitter,
+    PrefetchedBatch* batch) {
+  int reduction = 1;
+  cv::Rect roi;
+  bool has_roi = false;
+  int height, width;
+  // The size the image is decoded at only changes the result when the
+  // image would be scaled down anyway, i.e. with scale, or with the crop of
+  // INCEPTION_STYLE jittering. Bounding boxes are in the coordinates of the
+  // full image, so images with one are decoded in full.
+  if (dct_scaled_decode_ && !info.bounding_params.valid &&
+      GetJpegSize(data, size, &height, &width)) {
+    if (scale_jitter_type_ == INCEPTION_STYLE && !is_test_) {
+      // Even if no crop is found, the crop must not be chosen again after
+      // decoding.
+      *crop_chosen = true;
+      has_roi = RandomSizedCrop<Context>(height, width, randgen, &roi);
+    }
+    for (int r = kMaxDecodeReduction; r > 1; r /= 2) {
+      // The decoded image is ceil(height / r) x ceil(width / r).
+      if (has_roi ? (roi.height / r >= crop_ && roi.width / r >= crop_)
+                  : (scale_ > 0 && std::min(height, width) / r >= scale_)) {
+        reduction = r;
+        break;
+      }
     }
   }
-  return inception_scale_jitter;
+
+  cv::Mat src;
+  // count the number of exceptions from opencv imdecode
+  try {
+    // We use a cv::Mat to wrap the encoded data so we do not need a copy.
+    src = cv::imdecode(
+        cv::Mat(1, size, CV_8UC1, const_cast<char*>(data)),
+        DecodeFlags(color_, reduction));
+    if (src.rows == 0 || src.cols == 0) {
+      batch->num_decode_errors++;
+      return cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
+    }
+  } catch (cv::Exception& e) {
+    batch->num_decode_errors++;
+    return cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
+  }
+
+  if (has_roi) {
+    // Apply the crop to the scaled down image.
+    const int x = roi.x / reduction;
+    const int y = roi.y / reduction;
+    const cv::Rect scaled_roi(
+        x,
+        y,
+        std::max(1, std::min(roi.width / reduction, src.cols - x)),
+        std::max(1, std::min(roi.height / reduction, src.rows - y)));
+    cv::Mat scaled_img;
+    cv::resize(
+        src(scaled_roi),
+        scaled_img,
+        cv::Size(crop_, crop_),
+        0,
+        0,
+        cv::INTER_AREA);
+    src = scaled_img;
+    *inception_scale_jitter = true;
+  }
+  return src;
 }
 
 template <class Context>
@@ -451,6 +644,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     cv::Mat* img,
     PerImageArg& info,
     int item_id,
+    PrefetchedBatch* batch,
     std::mt19937* randgen) {
   //
   // recommend using --caffe2_use_fatal_for_enforce=1 when using ImageInputOp
@@ -458,6 +652,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   // CAFFE_ENFORCE are silently dropped by the thread worker functions
   //
   cv::Mat src;
+  bool crop_chosen = false;
+  bool inception_scale_jitter = false;
 
   // Use the default information for images
   info = default_arg_;
@@ -466,26 +662,17 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     CaffeDatum datum;
     CAFFE_ENFORCE(datum.ParseFromString(value));
 
-    prefetched_label_.mutable_data<int>()[item_id] = datum.label();
+    batch->label.mutable_data<int>()[item_id] = datum.label();
     if (datum.encoded()) {
       // encoded image in datum.
-      // count the number of exceptions from opencv imdecode
-      try {
-        src = cv::imdecode(
-            cv::Mat(
-                1,
-                datum.data().size(),
-                CV_8UC1,
-                const_cast<char*>(datum.data().data())),
-            color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
-        if (src.rows == 0 || src.cols == 0) {
-          num_decode_errors_in_batch_++;
-          src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
-        }
-      } catch (cv::Exception& e) {
-        num_decode_errors_in_batch_++;
-        src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
-      }
+      src = DecodeImage(
+          datum.data().data(),
+          datum.data().size(),
+          info,
+          randgen,
+          &crop_chosen,
+          &inception_scale_jitter,
+          batch);
     } else {
       // Raw image in datum.
       CAFFE_ENFORCE(datum.channels() == 3 || datum.channels() == 1);
@@ -542,25 +729,14 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
       // encoded image string.
       DCHECK_EQ(image_proto.string_data_size(), 1);
       const string& encoded_image_str = image_proto.string_data(0);
-      int encoded_size = encoded_image_str.size();
-      // We use a cv::Mat to wrap the encoded str so we do not need a copy.
-      // count the number of exceptions from opencv imdecode
-      try {
-        src = cv::imdecode(
-            cv::Mat(
-                1,
-                &encoded_size,
-                CV_8UC1,
-                const_cast<char*>(encoded_image_str.data())),
-            color_ ? cv::IMREAD_COLOR : cv::IMREAD_GRAYSCALE);
-        if (src.rows == 0 || src.cols == 0) {
-          num_decode_errors_in_batch_++;
-          src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
-        }
-      } catch (cv::Exception& e) {
-        num_decode_errors_in_batch_++;
-        src = cv::Mat::zeros(cv::Size(224, 224), CV_8UC3);
-      }
+      src = DecodeImage(
+          encoded_image_str.data(),
+          encoded_image_str.size(),
+          info,
+          randgen,
+          &crop_chosen,
+          &inception_scale_jitter,
+          batch);
     } else if (image_proto.data_type() == TensorProto::BYTE) {
       // raw image content.
       int src_c = (image_proto.dims_size() == 3) ? image_proto.dims(2) : 1;
@@ -582,11 +758,11 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     if (label_proto.data_type() == TensorProto::FLOAT) {
       if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
         DCHECK_EQ(label_proto.float_data_size(), 1);
-        prefetched_label_.mutable_data<float>()[item_id] =
+        batch->label.mutable_data<float>()[item_id] =
             label_proto.float_data(0);
       } else if (label_type_ == MULTI_LABEL_SPARSE) {
         float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+            batch->label.mutable_data<float>() + item_id * num_labels_;
         memset(label_data, 0, sizeof(float) * num_labels_);
         for (int i = 0; i < label_proto.float_data_size(); ++i) {
           label_data[(int)label_proto.float_data(i)] = 1.0;
@@ -594,7 +770,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
       } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
         const TensorProto& weight_proto = protos.protos(2);
         float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+            batch->label.mutable_data<float>() + item_id * num_labels_;
         memset(label_data, 0, sizeof(float) * num_labels_);
         for (int i = 0; i < label_proto.float_data_size(); ++i) {
           label_data[(int)label_proto.float_data(i)] =
@@ -604,7 +780,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
           label_type_ == MULTI_LABEL_DENSE || label_type_ == EMBEDDING_LABEL) {
         CAFFE_ENFORCE(label_proto.float_data_size() == num_labels_);
         float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+            batch->label.mutable_data<float>() + item_id * num_labels_;
         for (int i = 0; i < label_proto.float_data_size(); ++i) {
           label_data[i] = label_proto.float_data(i);
         }
@@ -614,11 +790,11 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
     } else if (label_proto.data_type() == TensorProto::INT32) {
       if (label_type_ == SINGLE_LABEL || label_type_ == SINGLE_LABEL_WEIGHTED) {
         DCHECK_EQ(label_proto.int32_data_size(), 1);
-        prefetched_label_.mutable_data<int>()[item_id] =
+        batch->label.mutable_data<int>()[item_id] =
             label_proto.int32_data(0);
       } else if (label_type_ == MULTI_LABEL_SPARSE) {
         int* label_data =
-            prefetched_label_.mutable_data<int>() + item_id * num_labels_;
+            batch->label.mutable_data<int>() + item_id * num_labels_;
         memset(label_data, 0, sizeof(int) * num_labels_);
         for (int i = 0; i < label_proto.int32_data_size(); ++i) {
           label_data[label_proto.int32_data(i)] = 1;
@@ -626,7 +802,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
       } else if (label_type_ == MULTI_LABEL_WEIGHTED_SPARSE) {
         const TensorProto& weight_proto = protos.protos(2);
         float* label_data =
-            prefetched_label_.mutable_data<float>() + item_id * num_labels_;
+            batch->label.mutable_data<float>() + item_id * num_labels_;
         memset(label_data, 0, sizeof(float) * num_labels_);
         for (int i = 0; i < label_proto.int32_data_size(); ++i) {
           label_data[label_proto.int32_data(i)] = weight_proto.float_data(i);
@@ -635,7 +811,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
           label_type_ == MULTI_LABEL_DENSE || label_type_ == EMBEDDING_LABEL) {
         CAFFE_ENFORCE(label_proto.int32_data_size() == num_labels_);
         int* label_data =
-            prefetched_label_.mutable_data<int>() + item_id * num_labels_;
+            batch->label.mutable_data<int>() + item_id * num_labels_;
         for (int i = 0; i < label_proto.int32_data_size(); ++i) {
           label_data[i] = label_proto.int32_data(i);
         }
@@ -650,7 +826,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
       auto additional_output_proto = additional_output_protos[i];
       if (additional_output_proto.data_type() == TensorProto::FLOAT) {
         float* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<float>() +
+            batch->additional_outputs[i].template mutable_data<float>() +
             item_id * additional_output_proto.float_data_size();
 
         for (int j = 0; j < additional_output_proto.float_data_size(); ++j) {
@@ -658,7 +834,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
         }
       } else if (additional_output_proto.data_type() == TensorProto::INT32) {
         int* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<int>() +
+            batch->additional_outputs[i].template mutable_data<int>() +
             item_id * additional_output_proto.int32_data_size();
 
         for (int j = 0; j < additional_output_proto.int32_data_size(); ++j) {
@@ -666,7 +842,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
         }
       } else if (additional_output_proto.data_type() == TensorProto::INT64) {
         int64_t* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<int64_t>() +
+            batch->additional_outputs[i].template mutable_data<int64_t>() +
             item_id * additional_output_proto.int64_data_size();
 
         for (int j = 0; j < additional_output_proto.int64_data_size(); ++j) {
@@ -674,7 +850,7 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
         }
       } else if (additional_output_proto.data_type() == TensorProto::UINT8) {
         uint8_t* additional_output =
-            prefetched_additional_outputs_[i].template mutable_data<uint8_t>() +
+            batch->additional_outputs[i].template mutable_data<uint8_t>() +
             item_id * additional_output_proto.int32_data_size();
 
         for (int j = 0; j < additional_output_proto.int32_data_size(); ++j) {
@@ -733,9 +909,8 @@ bool ImageInputOp<Context>::GetImageAndLabelAndInfoFromDBValue(
   }
 
   cv::Mat scaled_img;
-  bool inception_scale_jitter = false;
   if (scale_jitter_type_ == INCEPTION_STYLE) {
-    if (!is_test_) {
+    if (!is_test_ && !crop_chosen) {
       // Inception-stype scale jittering is only used for training
       inception_scale_jitter =
           RandomSizedCropping<Context>(img, crop_, randgen);
@@ -1083,7 +1258,19 @@ void ImageInputOp<Context>::DecodeAndTransform(
     float* image_data,
     int item_id,
     const int channels,
+    PrefetchedBatch* batch,
     std::size_t thread_index) {
+  // Count the image as decoded even if decoding throws, which the thread
+  // pool swallows, so that Prefetch() doesn't wait for it forever.
+  struct FinishImage {
+    PrefetchedBatch* batch;
+    ~FinishImage() {
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      if (--batch->num_pending == 0) {
+        batch->done.notify_all();
+      }
+    }
+  } finish_image{batch};
   CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
 
   std::bernoulli_distribution mirror_this_image(0.5f);
@@ -1092,8 +1279,8 @@ void ImageInputOp<Context>::DecodeAndTransform(
   cv::Mat img;
   // Decode the image
   PerImageArg info;
-  CHECK(
-      GetImageAndLabelAndInfoFromDBValue(value, &img, info, item_id, randgen));
+  CHECK(GetImageAndLabelAndInfoFromDBValue(
+      value, &img, info, item_id, batch, randgen));
   // Factor out the image transformation
   TransformImage<Context>(
       img,
@@ -1122,7 +1309,19 @@ void ImageInputOp<Context>::DecodeAndTransposeOnly(
     uint8_t* image_data,
     int item_id,
     const int channels,
+    PrefetchedBatch* batch,
     std::size_t thread_index) {
+  // Count the image as decoded even if decoding throws, which the thread
+  // pool swallows, so that Prefetch() doesn't wait for it forever.
+  struct FinishImage {
+    PrefetchedBatch* batch;
+    ~FinishImage() {
+      std::lock_guard<std::mutex> lock(batch->mutex);
+      if (--batch->num_pending == 0) {
+        batch->done.notify_all();
+      }
+    }
+  } finish_image{batch};
   CAFFE_ENFORCE((int)thread_index < num_decode_threads_);
 
   std::bernoulli_distribution mirror_this_image(0.5f);
@@ -1131,8 +1330,8 @@ void ImageInputOp<Context>::DecodeAndTransposeOnly(
   cv::Mat img;
   // Decode the image
   PerImageArg info;
-  CHECK(
-      GetImageAndLabelAndInfoFromDBValue(value, &img, info, item_id, randgen));
+  CHECK(GetImageAndLabelAndInfoFromDBValue(
+      value, &img, info, item_id, batch, randgen));
 
   // Factor out the image transformation
   CropTransposeImage<Context>(
@@ -1147,28 +1346,31 @@ void ImageInputOp<Context>::DecodeAndTransposeOnly(
 }
 
 template <class Context>
-bool ImageInputOp<Context>::Prefetch() {
-  if (!owned_reader_.get()) {
-    // if we are not owning the reader, we will get the reader pointer from
-    // input. Otherwise the constructor should have already set the reader
-    // pointer.
-    reader_ = &OperatorBase::Input<db::DBReader>(0);
-  }
+void ImageInputOp<Context>::StartBatch(PrefetchedBatch* batch) {
   const int channels = color_ ? 3 : 1;
-  // Call mutable_data() once to allocate the underlying memory.
-  if (gpu_transform_) {
-    // we'll transfer up in int8, then convert later
-    prefetched_image_.mutable_data<uint8_t>();
+  // Allocate the underlying memory once.
+  ReinitializeTensor(
+      &batch->image,
+      {int64_t(batch_size_),
+       int64_t(crop_),
+       int64_t(crop_),
+       int64_t(channels)},
+      // with gpu_transform, we'll transfer up in int8, then convert later
+      gpu_transform_ ? at::dtype<uint8_t>().device(CPU)
+                     : at::dtype<float>().device(CPU));
+  std::vector<int64_t> label_sizes;
+  if (label_type_ != SINGLE_LABEL && label_type_ != SINGLE_LABEL_WEIGHTED) {
+    label_sizes =
+        std::vector<int64_t>{int64_t(batch_size_), int64_t(num_labels_)};
   } else {
-    prefetched_image_.mutable_data<float>();
+    label_sizes = std::vector<int64_t>{batch_size_};
   }
-
-  prefetched_label_.mutable_data<int>();
+  batch->num_decode_errors = 0;
+  batch->num_pending = batch_size_;
   // Prefetching handled with a thread pool of "decode_threads" threads.
 
   for (int item_id = 0; item_id < batch_size_; ++item_id) {
     std::string key, value;
-    cv::Mat img;
 
     // read data
     reader_->Read(&key, &value);
@@ -1176,15 +1378,18 @@ bool ImageInputOp<Context>::Prefetch() {
     // determine label type based on first item
     if (item_id == 0) {
       if (use_caffe_datum_) {
-        prefetched_label_.mutable_data<int>();
+        ReinitializeTensor(
+            &batch->label, label_sizes, at::dtype<int>().device(CPU));
       } else {
         TensorProtos protos;
         CAFFE_ENFORCE(protos.ParseFromString(value));
         TensorProto_DataType labeldt = protos.protos(1).data_type();
         if (labeldt == TensorProto::INT32) {
-          prefetched_label_.mutable_data<int>();
+          ReinitializeTensor(
+              &batch->label, label_sizes, at::dtype<int>().device(CPU));
         } else if (labeldt == TensorProto::FLOAT) {
-          prefetched_label_.mutable_data<float>();
+          ReinitializeTensor(
+              &batch->label, label_sizes, at::dtype<float>().device(CPU));
         } else {
           LOG(FATAL) << "Unsupported label type.";
         }
@@ -1195,19 +1400,19 @@ bool ImageInputOp<Context>::Prefetch() {
           auto sizes =
               std::vector<int64_t>({batch_size_, additional_output_sizes_[i]});
           if (additional_output_proto.data_type() == TensorProto::FLOAT) {
-            prefetched_additional_outputs_[i] =
+            batch->additional_outputs[i] =
                 caffe2::empty(sizes, at::dtype<float>().device(CPU));
           } else if (
               additional_output_proto.data_type() == TensorProto::INT32) {
-            prefetched_additional_outputs_[i] =
+            batch->additional_outputs[i] =
                 caffe2::empty(sizes, at::dtype<int>().device(CPU));
           } else if (
               additional_output_proto.data_type() == TensorProto::INT64) {
-            prefetched_additional_outputs_[i] =
+            batch->additional_outputs[i] =
                 caffe2::empty(sizes, at::dtype<int64_t>().device(CPU));
           } else if (
               additional_output_proto.data_type() == TensorProto::UINT8) {
-            prefetched_additional_outputs_[i] =
+            batch->additional_outputs[i] =
                 caffe2::empty(sizes, at::dtype<uint8_t>().device(CPU));
           } else {
             LOG(FATAL) << "Unsupported output type.";
@@ -1220,7 +1425,7 @@ bool ImageInputOp<Context>::Prefetch() {
     // TODO: support color jitter and color lighting in gpu_transform
     if (gpu_transform_) {
       // output of decode will still be int8
-      uint8_t* image_data = prefetched_image_.mutable_data<uint8_t>() +
+      uint8_t* image_data = batch->image.mutable_data<uint8_t>() +
           crop_ * crop_ * channels * item_id;
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransposeOnly,
@@ -1229,9 +1434,10 @@ bool ImageInputOp<Context>::Prefetch() {
           image_data,
           item_id,
           channels,
+          batch,
           std::placeholders::_1));
     } else {
-      float* image_data = prefetched_image_.mutable_data<float>() +
+      float* image_data = batch->image.mutable_data<float>() +
           crop_ * crop_ * channels * item_id;
       thread_pool_->runTaskWithID(std::bind(
           &ImageInputOp<Context>::DecodeAndTransform,
@@ -1240,20 +1446,50 @@ bool ImageInputOp<Context>::Prefetch() {
           image_data,
           item_id,
           channels,
+          batch,
           std::placeholders::_1));
     }
   }
-  thread_pool_->waitWorkComplete();
+}
+
+template <class Context>
+bool ImageInputOp<Context>::Prefetch() {
+  if (!owned_reader_.get()) {
+    // if we are not owning the reader, we will get the reader pointer from
+    // input. Otherwise the constructor should have already set the reader
+    // pointer.
+    reader_ = &OperatorBase::Input<db::DBReader>(0);
+  }
+
+  // Keep prefetch_depth batches decoding. The batch returned by the last
+  // call has been copied out by now, so its slot can be reused.
+  while (num_batches_in_flight_ < prefetch_depth_) {
+    StartBatch(
+        batches_[(next_batch_ + num_batches_in_flight_) % prefetch_depth_]
+            .get());
+    ++num_batches_in_flight_;
+  }
+  PrefetchedBatch* batch = batches_[next_batch_].get();
+  {
+    std::unique_lock<std::mutex> lock(batch->mutex);
+    batch->done.wait(lock, [batch] { return batch->num_pending == 0; });
+  }
+  next_batch_ = (next_batch_ + 1) % prefetch_depth_;
+  --num_batches_in_flight_;
 
   // we allow to get at most max_decode_error_ratio from
   // opencv imdecode until raising a runtime exception
-  if ((float)num_decode_errors_in_batch_ / batch_size_ >
+  if ((float)batch->num_decode_errors / batch_size_ >
       max_decode_error_ratio_) {
     throw std::runtime_error(
         "max_decode_error_ratio exceeded " +
         c10::to_string(max_decode_error_ratio_));
   }
 
+  std::swap(prefetched_image_, batch->image);
+  std::swap(prefetched_label_, batch->label);
+  std::swap(prefetched_additional_outputs_, batch->additional_outputs);
+
   // If the context is not CPUContext, we will need to do a copy in the
   // prefetch function as well.
   auto device = at::device(Context::GetDeviceType());
@@ -1272,8 +1508,6 @@ bool ImageInputOp<Context>::Prefetch() {
     }
   }
 
-  num_decode_errors_in_batch_ = 0;
-
   return true;
 }
 
@@ -15,10 +15,52 @@
  */
 
 #include "profile_observer.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+#include "caffe2/core/flags.h"
 #include "caffe2/core/logging.h"
 
+C10_DEFINE_double(
+    caffe2_profile_observer_peak_gflops,
+    0,
+    "The peak GFLOP/s of the machine, used by the roofline summary of "
+    "ProfileObserver. 0 leaves the ops unclassified.");
+C10_DEFINE_double(
+    caffe2_profile_observer_peak_gbps,
+    0,
+    "The peak memory bandwidth of the machine in GB/s, used by the roofline "
+    "summary of ProfileObserver. 0 leaves the ops unclassified.");
+
 namespace caffe2 {
 
+namespace {
+
+// Infers the cost of the last run of `op` from its schema and the current
+// shapes of its inputs.
+bool inferCost(const OperatorBase* op, OpSchema::Cost* cost) {
+  if (!op->has_debug_def() || !op->isLegacyOperator()) {
+    return false;
+  }
+  const auto& def = op->debug_def();
+  const OpSchema* schema = OpSchemaRegistry::Schema(def.type());
+  if (!schema || !schema->HasCostInferenceFunction()) {
+    return false;
+  }
+  try {
+    *cost = schema->InferCost(def, op->InputTensorShapes());
+  } catch (const std::exception& e) {
+    VLOG(1) << "Could not infer the cost of " << def.type() << ": "
+            << e.what();
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
 void ProfileOperatorObserver::Dump() const {
   static std::mutex loggingMutex;
   std::lock_guard<std::mutex> lock(loggingMutex);
@@ -70,6 +112,12 @@ void ProfileOperatorObserver::Start() {
 void ProfileOperatorObserver::Stop() {
   run_time_ = timer_.MilliSeconds() - start_time_;
   Dump();
+  if (netObserver_) {
+    OpSchema::Cost cost;
+    bool costed = inferCost(subject_, &cost);
+    netObserver_->recordOperator(
+        subject_->debug_def().type(), run_time_, costed ? &cost : nullptr);
+  }
 }
 
 std::unique_ptr<ObserverBase<OperatorBase>> ProfileOperatorObserver::rnnCopy(
@@ -79,4 +127,99 @@ std::unique_ptr<ObserverBase<OperatorBase>> ProfileOperatorObserver::rnnCopy(
       new ProfileOperatorObserver(
           subject, netObserver_, net_position_, rnn_order));
 }
+
+ProfileObserver::~ProfileObserver() {
+  std::string summary = roofline();
+  if (!summary.empty()) {
+    LOG(INFO) << summary;
+  }
+}
+
+void ProfileObserver::recordOperator(
+    const std::string& type,
+    float run_time_ms,
+    const OpSchema::Cost* cost) {
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  auto& stats = opTypeStats_[type];
+  ++stats.runs;
+  stats.time_ms += run_time_ms;
+  if (cost) {
+    ++stats.costed_runs;
+    stats.costed_time_ms += run_time_ms;
+    stats.flops += cost->flops;
+    stats.bytes_read += cost->bytes_read;
+    stats.bytes_written += cost->bytes_written;
+  }
+}
+
+std::map<std::string, ProfileOpTypeStats> ProfileObserver::getOpTypeStats()
+    const {
+  std::lock_guard<std::mutex> lock(statsMutex_);
+  return opTypeStats_;
+}
+
+std::string ProfileObserver::roofline() const {
+  auto opTypeStats = getOpTypeStats();
+  if (opTypeStats.empty()) {
+    return "";
+  }
+  std::vector<std::pair<std::string, ProfileOpTypeStats>> sorted(
+      opTypeStats.begin(), opTypeStats.end());
+  std::sort(
+      sorted.begin(),
+      sorted.end(),
+      [](const std::pair<std::string, ProfileOpTypeStats>& a,
+         const std::pair<std::string, ProfileOpTypeStats>& b) {
+        return a.second.time_ms > b.second.time_ms;
+      });
+
+  const double peakGflops = FLAGS_caffe2_profile_observer_peak_gflops;
+  const double peakGbps = FLAGS_caffe2_profile_observer_peak_gbps;
+  const bool classify = peakGflops > 0 && peakGbps > 0;
+  // the arithmetic intensity from which the ops can reach the peak flops
+  const double ridge = classify ? peakGflops / peakGbps : 0;
+
+  std::stringstream ss;
+  ss << "--------- Roofline summary of net " << netName_ << " ---------\n";
+  ss << std::left << std::setw(32) << "op type" << std::right << std::setw(10)
+     << "calls" << std::setw(14) << "total ms" << std::setw(12) << "GFLOP/s"
+     << std::setw(12) << "GB/s" << std::setw(12) << "flops/byte";
+  if (classify) {
+    ss << std::setw(10) << "bound" << std::setw(12) << "% of roof";
+  }
+  ss << "\n";
+  ss << std::fixed << std::setprecision(3);
+  for (const auto& entry : sorted) {
+    const auto& stats = entry.second;
+    ss << std::left << std::setw(32) << entry.first << std::right
+       << std::setw(10) << stats.runs << std::setw(14) << stats.time_ms;
+    const uint64_t bytes = stats.bytes_read + stats.bytes_written;
+    if (stats.costed_runs == 0 || stats.costed_time_ms <= 0 || bytes == 0) {
+      // no cost inference, or the ops ran too fast to be timed
+      ss << std::setw(12) << "-" << std::setw(12) << "-" << std::setw(12)
+         << "-";
+      if (classify) {
+        ss << std::setw(10) << "-" << std::setw(12) << "-";
+      }
+      ss << "\n";
+      continue;
+    }
+    // flops per millisecond / 1e6 are GFLOP/s
+    const double gflops = stats.flops / stats.costed_time_ms / 1e6;
+    const double gbps = bytes / stats.costed_time_ms / 1e6;
+    const double intensity = static_cast<double>(stats.flops) / bytes;
+    ss << std::setw(12) << gflops << std::setw(12) << gbps << std::setw(12)
+       << intensity;
+    if (classify) {
+      const double attainable = std::min(peakGflops, intensity * peakGbps);
+      // ops that do no flops are measured against the bandwidth instead
+      const double achieved = attainable > 0 ? 100 * gflops / attainable
+                                             : 100 * gbps / peakGbps;
+      ss << std::setw(10) << (intensity < ridge ? "memory" : "compute")
+         << std::setw(12) << achieved;
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
 } // namespace caffe2
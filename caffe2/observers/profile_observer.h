@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <map>
+#include <mutex>
 #include <unordered_map>
 
 #include "caffe2/core/common.h"
@@ -36,6 +38,21 @@ namespace caffe2 {
  **/
 
 class ProfileObserver;
+
+/**
+ * The time spent in the operators of one type, and for the runs whose cost
+ * the operator schema could infer, the work done in that time.
+ **/
+struct ProfileOpTypeStats {
+  int64_t runs = 0;
+  float time_ms = 0.0f;
+  int64_t costed_runs = 0;
+  float costed_time_ms = 0.0f;
+  uint64_t flops = 0;
+  uint64_t bytes_read = 0;
+  uint64_t bytes_written = 0;
+};
+
 class ProfileCounter {
  public:
   explicit ProfileCounter() {}
@@ -101,13 +118,35 @@ class CAFFE2_API ProfileObserver final : public OperatorAttachingNetObserver<
   explicit ProfileObserver(NetBase* subject)
       : OperatorAttachingNetObserver<ProfileOperatorObserver, ProfileObserver>(
             subject,
-            this) {}
+            this),
+        netName_(subject->Name()) {}
+  ~ProfileObserver() override;
 
   void Start() override{};
   void Stop() override{};
 
+  // Called by the operator observers after every run, `cost` is null when
+  // the cost of the run could not be inferred.
+  void recordOperator(
+      const std::string& type,
+      float run_time_ms,
+      const OpSchema::Cost* cost);
+
+  std::map<std::string, ProfileOpTypeStats> getOpTypeStats() const;
+
+  // A table of the op types by total time, with the achieved GFLOP/s, GB/s
+  // and arithmetic intensity. With --caffe2_profile_observer_peak_gflops and
+  // --caffe2_profile_observer_peak_gbps it also tells whether the ops are
+  // memory or compute bound, and how close they get to the roofline.
+  std::string roofline() const;
+
  private:
   vector<const ProfileOperatorObserver*> operator_observers_;
+
+  // kept, the net is gone by the time the summary is logged
+  const std::string netName_;
+  mutable std::mutex statsMutex_;
+  std::map<std::string, ProfileOpTypeStats> opTypeStats_;
 };
 
 } // namespace caffe2
@@ -0,0 +1,140 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/net.h"
+#include "caffe2/core/observer.h"
+#include "caffe2/core/operator.h"
+#include "profile_observer.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+
+C10_DECLARE_double(caffe2_profile_observer_peak_gflops);
+C10_DECLARE_double(caffe2_profile_observer_peak_gbps);
+
+namespace caffe2 {
+
+namespace {
+
+class ProfiledSleepOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+  bool Run(int /* unused */) override {
+    StartAllObservers();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    StopAllObservers();
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(ProfiledSleepOp, ProfiledSleepOp);
+REGISTER_CPU_OPERATOR(UncostedSleepOp, ProfiledSleepOp);
+
+// two flops per input element, every element is read once and written once
+OPERATOR_SCHEMA(ProfiledSleepOp)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .CostInferenceFunction(
+        [](const OperatorDef& /* unused */, const vector<TensorShape>& in) {
+          struct OpSchema::Cost c;
+          uint64_t size = 1;
+          for (auto d : in[0].dims()) {
+            size *= d;
+          }
+          c.flops = 2 * size;
+          c.bytes_read = size * sizeof(float);
+          c.bytes_written = size * sizeof(float);
+          return c;
+        });
+
+OPERATOR_SCHEMA(UncostedSleepOp).NumInputs(1).NumOutputs(1);
+
+unique_ptr<NetBase> CreateNetTestHelper(Workspace* ws) {
+  NetDef net_def;
+  net_def.set_name("profiled");
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("ProfiledSleepOp");
+    op.add_input("in");
+    op.add_output("hidden");
+  }
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("ProfiledSleepOp");
+    op.add_input("in");
+    op.add_output("hidden2");
+  }
+  {
+    auto& op = *(net_def.add_op());
+    op.set_type("UncostedSleepOp");
+    op.add_input("in");
+    op.add_output("out");
+  }
+  net_def.add_external_input("in");
+  net_def.add_external_output("out");
+
+  return CreateNet(net_def, ws);
+}
+} // namespace
+
+TEST(ProfileObserverTest, OpTypeStats) {
+  Workspace ws;
+  auto* in = BlobGetMutableTensor(ws.CreateBlob("in"), CPU);
+  in->Resize(10, 100);
+  in->mutable_data<float>();
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  auto net_ob = caffe2::make_unique<ProfileObserver>(net.get());
+  const auto* ob = net_ob.get();
+  net->AttachObserver(std::move(net_ob));
+  net->Run();
+  net->Run();
+
+  auto stats = ob->getOpTypeStats();
+  ASSERT_EQ(stats.size(), 2u);
+  const auto& costed = stats.at("ProfiledSleepOp");
+  EXPECT_EQ(costed.runs, 4);
+  EXPECT_EQ(costed.costed_runs, 4);
+  EXPECT_EQ(costed.flops, 4u * 2 * 1000);
+  EXPECT_EQ(costed.bytes_read, 4u * 4 * 1000);
+  EXPECT_EQ(costed.bytes_written, 4u * 4 * 1000);
+  EXPECT_GE(costed.time_ms, 40);
+  EXPECT_EQ(costed.costed_time_ms, costed.time_ms);
+
+  const auto& uncosted = stats.at("UncostedSleepOp");
+  EXPECT_EQ(uncosted.runs, 2);
+  EXPECT_EQ(uncosted.costed_runs, 0);
+  EXPECT_EQ(uncosted.flops, 0u);
+}
+
+TEST(ProfileObserverTest, Roofline) {
+  Workspace ws;
+  auto* in = BlobGetMutableTensor(ws.CreateBlob("in"), CPU);
+  in->Resize(10, 100);
+  in->mutable_data<float>();
+  unique_ptr<NetBase> net(CreateNetTestHelper(&ws));
+  auto net_ob = caffe2::make_unique<ProfileObserver>(net.get());
+  const auto* ob = net_ob.get();
+  EXPECT_EQ(ob->roofline(), "");
+  net->AttachObserver(std::move(net_ob));
+  net->Run();
+
+  auto summary = ob->roofline();
+  LOG(INFO) << summary;
+  EXPECT_NE(summary.find("profiled"), std::string::npos);
+  // sorted by total time, the two costed ops took twice as long
+  auto costed = summary.find("ProfiledSleepOp");
+  auto uncosted = summary.find("UncostedSleepOp");
+  ASSERT_NE(costed, std::string::npos);
+  ASSERT_NE(uncosted, std::string::npos);
+  EXPECT_LT(costed, uncosted);
+  EXPECT_EQ(summary.find("memory"), std::string::npos);
+
+  // at 0.25 flops per byte, the ops are memory bound
+  FLAGS_caffe2_profile_observer_peak_gflops = 1000;
+  FLAGS_caffe2_profile_observer_peak_gbps = 100;
+  summary = ob->roofline();
+  FLAGS_caffe2_profile_observer_peak_gflops = 0;
+  FLAGS_caffe2_profile_observer_peak_gbps = 0;
+  EXPECT_NE(summary.find("memory"), std::string::npos);
+  EXPECT_EQ(summary.find("compute"), std::string::npos);
+}
+} // namespace caffe2
@@ -5,6 +5,7 @@
 #include "caffe2/core/operator.h"
 #include "caffe2/operators/conv_op_shared.h"
 #include "caffe2/operators/conv_pool_op_base.h"
+#include "caffe2/operators/relu_op.h"
 
 C10_DECLARE_bool(caffe2_force_shared_col_buffer);
 
@@ -28,9 +29,35 @@ class ConvOp final : public ConvPoolOpBase<Context> {
     if (FLAGS_caffe2_force_shared_col_buffer || shared_buffer_) {
       createSharedBuffer<Context>(ws_);
     }
+
+    const auto activation = this->template GetSingleArgument<std::string>(
+        "activation", "identity");
+    CAFFE_ENFORCE(
+        activation == "identity" || activation == "Relu",
+        "unsupported activation type \"",
+        activation,
+        "\"");
+    relu_ = activation == "Relu";
   }
   ~ConvOp() {}
 
+  bool RunOnDevice() override {
+    if (!ConvPoolOpBase<Context>::RunOnDevice()) {
+      return false;
+    }
+    // Fused by the CPU fusion pass, see fuseBiasActivation() in
+    // caffe2/opt/fusion.h
+    if (relu_) {
+      auto* Y = Output(0);
+      ReluFunctor<Context>()(
+          Y->numel(),
+          Y->template data<T>(),
+          Y->template mutable_data<T>(),
+          &context_);
+    }
+    return true;
+  }
+
   bool RunOnDeviceWithOrderNCHW() override;
   bool RunOnDeviceWithOrderNHWC() override;
 
@@ -59,6 +86,8 @@ class ConvOp final : public ConvPoolOpBase<Context> {
   Tensor bias_multiplier_{Context::GetDeviceType()};
   Tensor img_shape_device_{Context::GetDeviceType()};
   Tensor col_buffer_shape_device_{Context::GetDeviceType()};
+  // Apply a Relu to the output, for inference only.
+  bool relu_;
   // Input: X, W, b
   // Output: Y
   INPUT_TAGS(INPUT, FILTER, BIAS);
@@ -184,6 +184,9 @@ Y:
     .Arg(
         "float16_compute",
         "*(type: bool; default: False)* Whether to use float-16 compute kernel.")
+    .Arg(
+        "activation",
+        "*(type: string; default: \"identity\")* An activation applied to $Y$, either \"identity\" or \"Relu\". Set by the CPU fusion pass, for inference only.")
     .Input(
         0,
         "X",
@@ -4,6 +4,7 @@
 #include <c10/util/Optional.h>
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/operators/relu_op.h"
 #include "caffe2/utils/conversions.h"
 #include "caffe2/utils/math.h"
 
@@ -27,7 +28,16 @@ class FullyConnectedOp final : public Operator<Context> {
         axis_(this->template GetSingleArgument<int32_t>("axis", 1)),
         axis_w_(this->template GetSingleArgument<int32_t>("axis_w", 1)),
         float16_compute_(
-            this->template GetSingleArgument<bool>("float16_compute", false)) {}
+            this->template GetSingleArgument<bool>("float16_compute", false)) {
+    const auto activation = this->template GetSingleArgument<std::string>(
+        "activation", "identity");
+    CAFFE_ENFORCE(
+        activation == "identity" || activation == "Relu",
+        "unsupported activation type \"",
+        activation,
+        "\"");
+    relu_ = activation == "Relu";
+  }
   ~FullyConnectedOp() {}
 
   template <
@@ -171,6 +181,16 @@ class FullyConnectedOp final : public Operator<Context> {
         &context_,
         math_type);
 
+    // Applied while Y is still in cache, see fuseBiasActivation() in
+    // caffe2/opt/fusion.h
+    if (relu_) {
+      ReluFunctor<Context>()(
+          M * N,
+          Y->template data<T_Y>(),
+          Y->template mutable_data<T_Y>(),
+          &context_);
+    }
+
 #ifdef DNNLOWP_MEASURE_TIME_BREAKDOWN
     /* if (VLOG_IS_ON(3)) */
     {
@@ -201,6 +221,8 @@ class FullyConnectedOp final : public Operator<Context> {
   c10::optional<Tensor> bias_multiplier_;
 
   bool float16_compute_;
+  // Apply a Relu to the output, for inference only.
+  bool relu_;
 };
 
 template <
@@ -0,0 +1,104 @@
+#include "caffe2/operators/fused_elementwise_op.h"
+
+#include <algorithm>
+
+#include "caffe2/operators/abs_op.h"
+#include "caffe2/operators/exp_op.h"
+#include "caffe2/operators/log_op.h"
+#include "caffe2/operators/negative_op.h"
+#include "caffe2/operators/relu_op.h"
+#include "caffe2/operators/rsqrt_op.h"
+#include "caffe2/operators/sigmoid_op.h"
+#include "caffe2/operators/sqr_op.h"
+#include "caffe2/operators/sqrt_op.h"
+#include "caffe2/operators/tanh_op.h"
+
+namespace caffe2 {
+
+namespace {
+
+// 16KB of floats, small enough for the block to stay in L1 through the chain
+constexpr int kBlockSize = 4096;
+
+} // namespace
+
+FusedElementwiseOp::FusedElementwiseOp(
+    const OperatorDef& operator_def,
+    Workspace* ws)
+    : Operator<CPUContext>(operator_def, ws) {
+  const auto ops = this->GetRepeatedArgument<std::string>("ops");
+  CAFFE_ENFORCE(!ops.empty(), "FusedElementwise needs at least one op");
+  for (const auto& op : ops) {
+    auto it = kernels().find(op);
+    CAFFE_ENFORCE(
+        it != kernels().end(),
+        "Op ",
+        op,
+        " can't be fused by FusedElementwise");
+    chain_.push_back(it->second);
+  }
+}
+
+bool FusedElementwiseOp::RunOnDevice() {
+  const auto& X = Input(0);
+  auto* Y = Output(0, X.sizes(), at::dtype<float>());
+  const float* X_data = X.data<float>();
+  float* Y_data = Y->template mutable_data<float>();
+  const int N = X.numel();
+  for (int i = 0; i < N; i += kBlockSize) {
+    const int n = std::min(kBlockSize, N - i);
+    // the first op reads X, the others run in place on Y
+    chain_[0](n, X_data + i, Y_data + i, &context_);
+    for (size_t j = 1; j < chain_.size(); ++j) {
+      chain_[j](n, Y_data + i, Y_data + i, &context_);
+    }
+  }
+  return true;
+}
+
+bool FusedElementwiseOp::IsFusable(const std::string& type) {
+  return kernels().count(type);
+}
+
+const std::map<std::string, FusedElementwiseOp::Kernel>&
+FusedElementwiseOp::kernels() {
+  // The CPU versions of these ops are all float only, run in place and
+  // don't depend on the shape of X.
+  static const std::map<std::string, Kernel> kernels{
+      {"Abs", AbsFunctor<CPUContext>()},
+      {"Exp", ExpFunctor<CPUContext>()},
+      {"Log", LogFunctor<CPUContext>()},
+      {"Negative", NegativeFunctor<CPUContext>()},
+      {"Relu", ReluFunctor<CPUContext>()},
+      {"Rsqrt", RsqrtFunctor<CPUContext>()},
+      {"Sigmoid", SigmoidFunctor<CPUContext>()},
+      {"Sqr", SqrFunctor<CPUContext>()},
+      {"Sqrt", SqrtFunctor<CPUContext>()},
+      {"Tanh", TanhFunctor<CPUContext>()},
+  };
+  return kernels;
+}
+
+REGISTER_CPU_OPERATOR(FusedElementwise, FusedElementwiseOp);
+
+OPERATOR_SCHEMA(FusedElementwise)
+    .NumInputs(1)
+    .NumOutputs(1)
+    .AllowInplace({{0, 0}})
+    .IdenticalTypeAndShape()
+    .SetDoc(R"DOC(
+Applies a chain of unary elementwise ops to the input tensor in a single pass
+over it, so that the intermediate results stay in cache. The ops are given by
+name, in the order they are applied, e.g. `ops=["Exp", "Sigmoid"]` computes
+`Sigmoid(Exp(X))`.
+
+Created by the CPU fusion pass of the predictor from chains of Abs, Exp, Log,
+Negative, Relu, Rsqrt, Sigmoid, Sqr, Sqrt and Tanh ops.
+)DOC")
+    .Arg("ops", "*(type: [string])* The ops of the chain, in order.")
+    .Input(0, "X", "*(type: Tensor`<float>`)* Input tensor.")
+    .Output(0, "Y", "*(type: Tensor`<float>`)* Output tensor.");
+
+SHOULD_NOT_DO_GRADIENT(FusedElementwise);
+
+} // namespace caffe2
@@ -0,0 +1,38 @@
+#ifndef CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+#define CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "caffe2/core/context.h"
+#include "caffe2/core/operator.h"
+
+namespace caffe2 {
+
+// Applies a chain of unary elementwise ops to X in a single pass. X is
+// processed block by block, every op of the chain running on a block before
+// the next one is read, so the intermediate results never leave the cache.
+// Created by fuseElementwiseChains() in caffe2/opt/fusion.h.
+class CAFFE2_API FusedElementwiseOp final : public Operator<CPUContext> {
+ public:
+  USE_OPERATOR_FUNCTIONS(CPUContext);
+  FusedElementwiseOp(const OperatorDef& operator_def, Workspace* ws);
+
+  bool RunOnDevice() override;
+
+  // Whether ops of the given type can be part of the chain.
+  static bool IsFusable(const std::string& type);
+
+ private:
+  using Kernel = std::function<bool(int, const float*, float*, CPUContext*)>;
+
+  static const std::map<std::string, Kernel>& kernels();
+
+  std::vector<Kernel> chain_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_OPERATORS_FUSED_ELEMENTWISE_OP_H_
@@ -10,12 +10,21 @@ namespace caffe2 {
 // generic fashion. Otherwise it'd break schema declaration check.
 // TODO(dzhulgakov): remove _STR when all lengths ops are off generic version.
 
-using SparseLengthsSumOp =
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, at::Half>, 0, 0>;
-using SparseLengthsWeightedSumOp =
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, at::Half>, 1, 0>;
-using SparseLengthsMeanOp =
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, at::Half>, 0, 1>;
+using SparseLengthsSumOp = CPUSparseLengthsReductionOp<
+    float,
+    TensorTypes<float, at::Half, at::BFloat16>,
+    0,
+    0>;
+using SparseLengthsWeightedSumOp = CPUSparseLengthsReductionOp<
+    float,
+    TensorTypes<float, at::Half, at::BFloat16>,
+    1,
+    0>;
+using SparseLengthsMeanOp = CPUSparseLengthsReductionOp<
+    float,
+    TensorTypes<float, at::Half, at::BFloat16>,
+    0,
+    1>;
 REGISTER_CPU_OPERATOR(SparseLengthsSum, SparseLengthsSumOp);
 REGISTER_CPU_OPERATOR(SparseLengthsWeightedSum, SparseLengthsWeightedSumOp);
 REGISTER_CPU_OPERATOR(SparseLengthsMean, SparseLengthsMeanOp);
@@ -52,7 +61,12 @@ SparseWeightedSum
 
 REGISTER_CPU_OPERATOR_STR(
     "SparseLengthsPositionalWeightedSum",
-    CPUSparseLengthsReductionOp<float, TensorTypes<float, at::Half>, 1, 0, 1>);
+    CPUSparseLengthsReductionOp<
+        float,
+        TensorTypes<float, at::Half, at::BFloat16>,
+        1,
+        0,
+        1>);
 
 template <typename Def>
 string FormatDoc() {
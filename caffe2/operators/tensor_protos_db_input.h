@@ -28,7 +28,6 @@ class TensorProtosDBInput final : public PrefetchOperator<Context> {
   int batch_size_;
   bool shape_inferred_ = false;
   string key_;
-  string value_;
 };
 
 template <class Context>
@@ -47,9 +46,8 @@ bool TensorProtosDBInput<Context>::Prefetch() {
   if (batch_size_ == 0) {
     // We do not need to construct a batch. As a result, we will simply
     // deserialize everything into the target prefetched blob.
-    reader.Read(&key_, &value_);
     TensorProtos protos;
-    CAFFE_ENFORCE(protos.ParseFromString(value_));
+    reader.Read(&key_, &protos);
     CAFFE_ENFORCE(protos.protos_size() == OutputSize());
     for (int i = 0; i < protos.protos_size(); ++i) {
       if (protos.protos(i).has_device_detail()) {
@@ -63,9 +61,8 @@ bool TensorProtosDBInput<Context>::Prefetch() {
     }
   } else {
     for (int item_id = 0; item_id < batch_size_; ++item_id) {
-      reader.Read(&key_, &value_);
       TensorProtos protos;
-      CAFFE_ENFORCE(protos.ParseFromString(value_));
+      reader.Read(&key_, &protos);
       CAFFE_ENFORCE(protos.protos_size() == OutputSize());
       // Note: shape_inferred_ is ignored, we'll always get dimensions from
       // proto
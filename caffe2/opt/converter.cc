@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <limits>
 
 #include "caffe2/core/logging.h"
@@ -502,7 +503,12 @@ caffe2::NetDef convertToCaffe2Proto(
   auto predictNet = caffe2::NetDef();
   // We copy the old net rather than mutate it.
   predictNet.CopyFrom(oldNet);
-  predictNet.mutable_op()->Clear();
+  convertToCaffe2Proto(m, &predictNet);
+  return predictNet;
+}
+
+void convertToCaffe2Proto(repr::NNModule& m, caffe2::NetDef* predictNet) {
+  predictNet->mutable_op()->Clear();
 
   repr::nn::coalesceInsertedDataDependencies(&m);
 
@@ -553,7 +559,7 @@ caffe2::NetDef convertToCaffe2Proto(
       }
 
       // Save the operator to the net.
-      *predictNet.add_op() = op;
+      predictNet->add_op()->Swap(&op);
     }
   }
 
@@ -561,47 +567,44 @@ caffe2::NetDef convertToCaffe2Proto(
   std::vector<std::string> oldExternalInputs;
   std::vector<std::string> oldExternalOutputs;
 
-  for (const auto& inputName : predictNet.external_input()) {
+  for (const auto& inputName : predictNet->external_input()) {
     oldExternalInputs.emplace_back(inputName);
   }
-  for (const auto& outputName : predictNet.external_output()) {
+  for (const auto& outputName : predictNet->external_output()) {
     oldExternalOutputs.emplace_back(outputName);
   }
 
   auto newExternalInputs = mergeExternalTensors(m.inputs, oldExternalInputs);
   auto newExternalOutputs = mergeExternalTensors(m.outputs, oldExternalOutputs);
 
-  predictNet.clear_external_input();
-  predictNet.clear_external_output();
+  predictNet->clear_external_input();
+  predictNet->clear_external_output();
 
   for (const auto& inputName : newExternalInputs) {
-    predictNet.add_external_input(inputName);
+    predictNet->add_external_input(inputName);
   }
 
   for (const auto& outputName : newExternalOutputs) {
-    predictNet.add_external_output(outputName);
-  }
-
-  return predictNet;
-}
-
-void pushOpToFront(caffe2::OperatorDef& op, caffe2::NetDef* net) {
-  *net->add_op() = op;
-  google::protobuf::RepeatedPtrField<caffe2::OperatorDef>* op_list(
-      net->mutable_op());
-  // Reverse iterate, swapping new element in front each time
-  for (int i(net->op_size() - 1); i > 0; --i) {
-    op_list->SwapElements(i, i - 1);
+    predictNet->add_external_output(outputName);
   }
 }
 
 void injectDataEdgeIndicators(caffe2::NetDef* net) {
+  // The Declares go in front in the reverse order of the inputs. They are
+  // appended, reversed and rotated to the front all together, rather than
+  // pushed to the front one at a time, which is quadratic.
+  const auto opCount = net->op_size();
   for (const auto& input : net->external_input()) {
-    caffe2::OperatorDef op;
-    op.set_type("Declare");
-    op.add_output(input);
-    pushOpToFront(op, net);
-  }
+    auto* op = net->add_op();
+    op->set_type("Declare");
+    op->add_output(input);
+  }
+  auto* opList = net->mutable_op();
+  std::reverse(opList->pointer_begin() + opCount, opList->pointer_end());
+  std::rotate(
+      opList->pointer_begin(),
+      opList->pointer_begin() + opCount,
+      opList->pointer_end());
   for (const auto& output : net->external_output()) {
     caffe2::OperatorDef op;
     op.set_type("Export");
@@ -615,18 +618,20 @@ void injectDataEdgeIndicators(caffe2::NetDef* net) {
 void removeDataEdgeIndicators(caffe2::NetDef* net) {
   google::protobuf::RepeatedPtrField<caffe2::OperatorDef>* op_list(
       net->mutable_op());
+  // The remaining ops are moved to the front in order, and the indicators
+  // deleted at once at the end.
+  int kept = 0;
   for (auto i = 0; i < net->op_size(); ++i) {
-    auto op = net->op(i);
+    const auto& op = net->op(i);
     if (op.type() == "Declare") {
       net->add_external_input(op.output(0));
     } else if (op.type() == "Export") {
       net->add_external_output(op.input(0));
     } else {
-      continue;
+      op_list->SwapElements(i, kept++);
     }
-    // Note that this compensates for modifying the list inplace
-    op_list->DeleteSubrange(i--, 1);
   }
+  op_list->DeleteSubrange(kept, net->op_size() - kept);
 }
 
 } // namespace caffe2
@@ -31,6 +31,10 @@ CAFFE2_API caffe2::NetDef convertToCaffe2Proto(nom::repr::NNModule&);
 // are not reflected in changes to external_input or external_output.
 CAFFE2_API caffe2::NetDef convertToCaffe2Proto(nom::repr::NNModule&, const caffe2::NetDef& oldNet);
 
+// Same as above, but replaces the ops of `net` with those of the NNModule
+// in place, rather than copying the old net with all of its ops first.
+CAFFE2_API void convertToCaffe2Proto(nom::repr::NNModule&, caffe2::NetDef* net);
+
 // Use these functions instead of the registry directly.
 CAFFE2_API std::unique_ptr<nom::repr::NeuralNetOperator> convertToNeuralNetOperator(
     const caffe2::OperatorDef& op);
@@ -1,3 +1,6 @@
+#include <unordered_set>
+#include <vector>
+
 #include "caffe2/core/logging.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/passes.h"
@@ -9,32 +12,52 @@ using namespace nom;
 using namespace nom::repr;
 
 void deadCodeElim(NNModule* nn) {
-  // Iteratively remove unconsumed non-external outputs.
-  bool changed = false;
-  do {
-    changed = false;
-    for (const auto& node : nn->dataFlow.getMutableNodes()) {
-      NOM_REQUIRE_OR_CONT(nn::is<repr::NeuralNetOperator>(node));
-
-      bool isUsed = false;
-      for (const auto& output : nn::getOutputs(node)) {
-        if (nn::hasConsumer(output) || nn->outputs.count(output)) {
-          isUsed = true;
-          break;
-        }
+  // Remove unconsumed non-external outputs, and the ops that produce them.
+  // This can leave the producers of the inputs of a removed op unused, so
+  // they are visited again, rather than every op of the net.
+  std::vector<NNGraph::NodeRef> worklist;
+  for (const auto& node : nn->dataFlow.getMutableNodes()) {
+    if (nn::is<repr::NeuralNetOperator>(node)) {
+      worklist.emplace_back(node);
+    }
+  }
+  std::unordered_set<NNGraph::NodeRef> queued(
+      worklist.begin(), worklist.end());
+
+  while (!worklist.empty()) {
+    auto node = worklist.back();
+    worklist.pop_back();
+    queued.erase(node);
+
+    bool isUsed = false;
+    for (const auto& output : nn::getOutputs(node)) {
+      if (nn::hasConsumer(output) || nn->outputs.count(output)) {
+        isUsed = true;
+        break;
+      }
+    }
+
+    NOM_REQUIRE_OR_CONT(!isUsed);
+
+    std::vector<NNGraph::NodeRef> producers;
+    for (const auto& input : nn::getInputs(node)) {
+      if (nn::hasProducer(input)) {
+        producers.emplace_back(nn::getProducer(input));
       }
+    }
 
-      NOM_REQUIRE_OR_CONT(!isUsed);
+    // No outputs are used, delete them and the node itself.
+    for (const auto& output : nn::getOutputs(node)) {
+      nn->dataFlow.deleteNode(output);
+    }
+    nn->dataFlow.deleteNode(node);
 
-      // No outputs are used, delete them and the node itself.
-      for (const auto& output : nn::getOutputs(node)) {
-        nn->dataFlow.deleteNode(output);
+    for (const auto& producer : producers) {
+      if (queued.insert(producer).second) {
+        worklist.emplace_back(producer);
       }
-      nn->dataFlow.deleteNode(node);
-      changed = true;
-      break;
     }
-  } while (changed);
+  }
 }
 
 REGISTER_OPT_PASS_FROM_FUNC(DeadCodeElim, deadCodeElim);
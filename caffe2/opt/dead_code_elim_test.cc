@@ -55,3 +55,24 @@ TEST(DeadCodeElim, PartiallyUsedNoElim) {
   auto optimized_net = caffe2::convertToCaffe2Proto(nn, net);
   EXPECT_EQ(optimized_net.op().size(), 1);
 }
+
+TEST(DeadCodeElim, ChainElim) {
+  caffe2::NetDef net;
+  // Removing the last op leaves the ones before it unused in turn, apart
+  // from the one producing the external output.
+  std::vector<std::string> blobs = {"X", "Y", "Z", "W", "V"};
+  for (size_t i = 0; i + 1 < blobs.size(); ++i) {
+    caffe2::OperatorDef* def = net.add_op();
+    def->set_type("Fake");
+    def->add_input(blobs[i]);
+    def->add_output(blobs[i + 1]);
+  }
+  net.add_external_output("Y");
+
+  auto nn = caffe2::convertToNNModule(net);
+  auto pass = caffe2::OptimizationPassRegistry()->Create("DeadCodeElim", &nn);
+  pass->run();
+  caffe2::convertToCaffe2Proto(nn, &net);
+  EXPECT_EQ(net.op().size(), 1);
+  EXPECT_EQ(net.op(0).output(0), "Y");
+}
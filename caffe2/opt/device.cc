@@ -1,7 +1,15 @@
 #include "caffe2/opt/device.h"
 #include "caffe2/core/logging.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/operator_schema.h"
+#include "caffe2/core/types.h"
 #include "nomnigraph/Graph/Algorithms.h"
 
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
 using namespace nom;
 using namespace nom::repr;
 
@@ -143,5 +151,359 @@ void insertCopies(
   }
 }
 
+namespace {
+
+// Edmonds-Karp would do, but Dinic keeps large nets fast.
+class MinCut {
+ public:
+  explicit MinCut(int nodes) : edges_(nodes), level_(nodes), next_(nodes) {}
+
+  int addNode() {
+    edges_.emplace_back();
+    level_.push_back(0);
+    next_.push_back(0);
+    return static_cast<int>(edges_.size()) - 1;
+  }
+
+  void addEdge(int from, int to, double capacity) {
+    edges_[from].push_back({to, capacity, static_cast<int>(edges_[to].size())});
+    edges_[to].push_back({from, 0, static_cast<int>(edges_[from].size()) - 1});
+  }
+
+  // Runs the max flow from `source` to `sink`, and returns for every node
+  // whether it stays on the side of `source` in the minimum cut.
+  std::vector<bool> solve(int source, int sink) {
+    while (buildLevels(source, sink)) {
+      std::fill(next_.begin(), next_.end(), 0);
+      while (augment(source, sink, std::numeric_limits<double>::max()) >
+             kEpsilon) {
+      }
+    }
+    buildLevels(source, sink);
+    std::vector<bool> source_side(edges_.size());
+    for (size_t i = 0; i < edges_.size(); ++i) {
+      source_side[i] = level_[i] >= 0;
+    }
+    return source_side;
+  }
+
+ private:
+  struct Edge {
+    int to;
+    double capacity;
+    int reverse;
+  };
+
+  static constexpr double kEpsilon = 1e-12;
+
+  bool buildLevels(int source, int sink) {
+    std::fill(level_.begin(), level_.end(), -1);
+    std::queue<int> frontier;
+    level_[source] = 0;
+    frontier.push(source);
+    while (!frontier.empty()) {
+      int node = frontier.front();
+      frontier.pop();
+      for (const auto& edge : edges_[node]) {
+        if (edge.capacity > kEpsilon && level_[edge.to] < 0) {
+          level_[edge.to] = level_[node] + 1;
+          frontier.push(edge.to);
+        }
+      }
+    }
+    return level_[sink] >= 0;
+  }
+
+  double augment(int node, int sink, double flow) {
+    if (node == sink) {
+      return flow;
+    }
+    for (int& i = next_[node]; i < static_cast<int>(edges_[node].size());
+         ++i) {
+      Edge& edge = edges_[node][i];
+      if (edge.capacity <= kEpsilon || level_[edge.to] != level_[node] + 1) {
+        continue;
+      }
+      double pushed = augment(edge.to, sink, std::min(flow, edge.capacity));
+      if (pushed > kEpsilon) {
+        edge.capacity -= pushed;
+        edges_[edge.to][edge.reverse].capacity += pushed;
+        return pushed;
+      }
+    }
+    return 0;
+  }
+
+  std::vector<std::vector<Edge>> edges_;
+  std::vector<int> level_;
+  std::vector<int> next_;
+};
+
+constexpr double MinCut::kEpsilon;
+
+uint64_t shapeBytes(const TensorShape& shape) {
+  if (shape.unknown_shape()) {
+    return 0;
+  }
+  uint64_t elements = 1;
+  for (const auto dim : shape.dims()) {
+    elements *= std::max<int64_t>(dim, 0);
+  }
+  return elements * DataTypeToTypeMeta(shape.data_type()).itemsize();
+}
+
+// A value of a blob, written by `producer` (or fed to the net when it is -1)
+// and read by `consumers` until the blob is written again.
+struct BlobVersion {
+  BlobVersion(std::string name, int producer)
+      : name(std::move(name)), producer(producer) {}
+
+  std::string name;
+  int producer;
+  std::vector<int> consumers;
+  bool external_output{false};
+};
+
+std::string gpuName(const std::string& name) {
+  return name + "_gpu";
+}
+
+} // namespace
+
+NetDef placeOperatorsByCost(
+    const NetDef& net,
+    const CaffeMap<std::string, TensorShape>& input_shapes,
+    std::function<bool(const OperatorDef&)> gpu_supported,
+    const PlacementCostModel& model) {
+  NetDef shaped_net = net;
+  CaffeMap<std::string, TensorShape> blob_desc = input_shapes;
+  std::unordered_map<std::string, TensorShape> shapes;
+  for (const auto& shape :
+       InferBlobShapesAndTypes(blob_desc, {&shaped_net}).shapes()) {
+    shapes.emplace(shape.name(), shape);
+  }
+  auto blobBytes = [&shapes](const std::string& name) -> uint64_t {
+    auto it = shapes.find(name);
+    return it == shapes.end() ? 0 : shapeBytes(it->second);
+  };
+
+  const int num_ops = net.op_size();
+  std::vector<double> cpu_sec(num_ops);
+  std::vector<double> gpu_sec(num_ops);
+  std::vector<bool> on_gpu_allowed(num_ops);
+  for (int i = 0; i < num_ops; ++i) {
+    const auto& op = net.op(i);
+    OpSchema::Cost cost;
+    bool has_cost = false;
+    const auto* schema = OpSchemaRegistry::Schema(op.type());
+    if (schema && schema->HasCostInferenceFunction()) {
+      std::vector<TensorShape> input_tensor_shapes;
+      for (const auto& input : op.input()) {
+        auto it = shapes.find(input);
+        if (it == shapes.end() || it->second.unknown_shape()) {
+          break;
+        }
+        input_tensor_shapes.push_back(it->second);
+      }
+      if (input_tensor_shapes.size() == static_cast<size_t>(op.input_size())) {
+        try {
+          cost = schema->InferCost(op, input_tensor_shapes);
+          has_cost = true;
+        } catch (const std::exception& e) {
+          VLOG(1) << "Failed to infer the cost of " << op.type() << ": "
+                  << e.what();
+        }
+      }
+    }
+    if (!has_cost) {
+      // Treat the operator as memory bound.
+      for (const auto& input : op.input()) {
+        cost.bytes_read += blobBytes(input);
+      }
+      for (const auto& output : op.output()) {
+        cost.bytes_written += blobBytes(output);
+      }
+    }
+    const double bytes = cost.bytes_read + cost.bytes_written;
+    cpu_sec[i] = cost.flops / model.cpu_flops_per_sec +
+        bytes / model.cpu_bytes_per_sec;
+    gpu_sec[i] = model.gpu_launch_sec + cost.flops / model.gpu_flops_per_sec +
+        bytes / model.gpu_bytes_per_sec;
+    on_gpu_allowed[i] = gpu_supported(op);
+  }
+
+  // Follow the values of every blob through the net.
+  std::vector<BlobVersion> versions;
+  std::unordered_map<std::string, int> current_version;
+  for (int i = 0; i < num_ops; ++i) {
+    const auto& op = net.op(i);
+    for (const auto& input : op.input()) {
+      auto it = current_version.find(input);
+      if (it == current_version.end()) {
+        it = current_version.emplace(input, versions.size()).first;
+        versions.emplace_back(input, -1);
+      }
+      auto& consumers = versions[it->second].consumers;
+      if (consumers.empty() || consumers.back() != i) {
+        consumers.push_back(i);
+      }
+    }
+    for (const auto& output : op.output()) {
+      current_version[output] = versions.size();
+      versions.emplace_back(output, i);
+    }
+  }
+  for (const auto& output : net.external_output()) {
+    auto it = current_version.find(output);
+    if (it != current_version.end()) {
+      versions[it->second].external_output = true;
+    }
+  }
+
+  // The CPU is the source side of the cut and the GPU the sink side: every
+  // edge cut adds its capacity (a running time) to the total. An operator
+  // pays its GPU time when cut from the source, and its CPU time when cut
+  // from the sink.
+  double infinity = 1;
+  for (int i = 0; i < num_ops; ++i) {
+    infinity += cpu_sec[i] + gpu_sec[i];
+  }
+  auto transferSec = [&](const BlobVersion& version) {
+    return model.transfer_latency_sec +
+        blobBytes(version.name) / model.transfer_bytes_per_sec;
+  };
+  for (const auto& version : versions) {
+    infinity += 2 * transferSec(version);
+  }
+
+  const int source = 0;
+  const int sink = 1;
+  MinCut graph(num_ops + 2);
+  auto opNode = [](int op) { return op + 2; };
+  for (int i = 0; i < num_ops; ++i) {
+    graph.addEdge(source, opNode(i), on_gpu_allowed[i] ? gpu_sec[i] : infinity);
+    graph.addEdge(opNode(i), sink, cpu_sec[i]);
+  }
+  // A value is copied once to the other device, however many of its consumers
+  // run there: each direction goes through an auxiliary node that every such
+  // consumer pulls to its side, which cuts the single edge between the
+  // auxiliary node and the producer.
+  for (const auto& version : versions) {
+    const double transfer = transferSec(version);
+    const int producer =
+        version.producer < 0 ? source : opNode(version.producer);
+    const int to_gpu = graph.addNode();
+    graph.addEdge(producer, to_gpu, transfer);
+    for (const auto consumer : version.consumers) {
+      graph.addEdge(to_gpu, opNode(consumer), infinity);
+    }
+    if (version.producer < 0) {
+      continue;
+    }
+    const int to_cpu = graph.addNode();
+    graph.addEdge(to_cpu, producer, transfer);
+    for (const auto consumer : version.consumers) {
+      graph.addEdge(opNode(consumer), to_cpu, infinity);
+    }
+    if (version.external_output && model.outputs_on_cpu) {
+      graph.addEdge(source, to_cpu, infinity);
+    }
+  }
+  const auto source_side = graph.solve(source, sink);
+
+  // Rewrite the net, copying every value to the other device the first time
+  // an operator there reads it.
+  NetDef placed = net;
+  placed.clear_op();
+  struct Residency {
+    bool cpu{true};
+    bool gpu{false};
+  };
+  std::unordered_map<std::string, Residency> residency;
+  auto addCopy = [&](const std::string& name, bool to_gpu) {
+    auto* copy = placed.add_op();
+    copy->set_type(to_gpu ? "CopyCPUToGPU" : "CopyGPUToCPU");
+    copy->add_input(to_gpu ? name : gpuName(name));
+    copy->add_output(to_gpu ? gpuName(name) : name);
+    copy->mutable_device_option()->set_device_type(PROTO_CUDA);
+    copy->mutable_device_option()->set_device_id(model.gpu_id);
+  };
+  int gpu_ops = 0;
+  int copies = 0;
+  for (int i = 0; i < num_ops; ++i) {
+    const bool on_gpu = !source_side[opNode(i)];
+    OperatorDef op = net.op(i);
+    for (int j = 0; j < op.input_size(); ++j) {
+      auto& resident = residency[op.input(j)];
+      if (on_gpu) {
+        if (!resident.gpu) {
+          addCopy(op.input(j), /*to_gpu=*/true);
+          resident.gpu = true;
+          ++copies;
+        }
+        op.set_input(j, gpuName(op.input(j)));
+      } else if (!resident.cpu) {
+        addCopy(op.input(j), /*to_gpu=*/false);
+        resident.cpu = true;
+        ++copies;
+      }
+    }
+    for (int j = 0; j < op.output_size(); ++j) {
+      auto& resident = residency[op.output(j)];
+      resident.cpu = !on_gpu;
+      resident.gpu = on_gpu;
+      if (on_gpu) {
+        op.set_output(j, gpuName(op.output(j)));
+      }
+    }
+    auto* device_option = op.mutable_device_option();
+    if (on_gpu) {
+      device_option->set_device_type(PROTO_CUDA);
+      device_option->set_device_id(model.gpu_id);
+      ++gpu_ops;
+    } else {
+      device_option->set_device_type(PROTO_CPU);
+      device_option->clear_device_id();
+    }
+    *placed.add_op() = std::move(op);
+  }
+  for (int i = 0; i < placed.external_output_size(); ++i) {
+    const auto& output = placed.external_output(i);
+    auto it = residency.find(output);
+    if (it == residency.end() || it->second.cpu) {
+      continue;
+    }
+    if (model.outputs_on_cpu) {
+      addCopy(output, /*to_gpu=*/false);
+      ++copies;
+    } else {
+      placed.set_external_output(i, gpuName(output));
+    }
+  }
+  VLOG(1) << "Placed " << gpu_ops << " of " << num_ops
+          << " operators on the GPU, with " << copies << " copies";
+  return placed;
+}
+
+NetDef placeOperatorsByCost(
+    const NetDef& net,
+    const CaffeMap<std::string, TensorShape>& input_shapes,
+    const PlacementCostModel& model) {
+  auto* registries = gDeviceTypeRegistry();
+  auto it = registries->find(CUDA);
+  if (it == registries->end()) {
+    return placeOperatorsByCost(
+        net, input_shapes, [](const OperatorDef&) { return false; }, model);
+  }
+  OperatorRegistry* cuda_registry = it->second;
+  return placeOperatorsByCost(
+      net,
+      input_shapes,
+      [cuda_registry](const OperatorDef& op) {
+        return cuda_registry->Has(op.type());
+      },
+      model);
+}
+
 } // namespace opt
 } // namespace caffe2
@@ -1,6 +1,10 @@
 #include "caffe2/core/common.h"
+#include "caffe2/proto/caffe2_pb.h"
 #include "nomnigraph/Representations/NeuralNet.h"
 
+#include <functional>
+#include <string>
+
 namespace caffe2 {
 namespace opt {
 
@@ -10,5 +14,50 @@ CAFFE2_API void insertCopies(
     std::function<nom::repr::NNGraph::NodeRef(nom::repr::NNGraph&)> copyToFn,
     std::function<nom::repr::NNGraph::NodeRef(nom::repr::NNGraph&)> copyFromFn);
 
+/// The throughputs and latencies `placeOperatorsByCost` estimates the running
+/// time of operators and copies with. The transfer figures should be measured
+/// on the target machine, e.g. by timing CopyCPUToGPU on a large blob.
+struct CAFFE2_API PlacementCostModel {
+  double cpu_flops_per_sec{1e11};
+  double cpu_bytes_per_sec{2e10};
+  double gpu_flops_per_sec{1e13};
+  double gpu_bytes_per_sec{5e11};
+  // Fixed cost of launching an operator on the GPU.
+  double gpu_launch_sec{1e-5};
+  double transfer_bytes_per_sec{1e10};
+  // Fixed cost of a copy between the host and the GPU.
+  double transfer_latency_sec{1e-5};
+  // The GPU the operators placed on the GPU run on.
+  int gpu_id{0};
+  // Whether the external outputs of the net must end up on the CPU.
+  bool outputs_on_cpu{true};
+};
+
+/// Assigns each operator of `net` to the CPU or to the GPU so as to minimize
+/// the estimated running time of the net, counting the copies between the
+/// two, and returns the net with the device options set and CopyCPUToGPU /
+/// CopyGPUToCPU operators inserted at the resulting cuts.
+///
+/// Operators are costed with their schema's cost inference function over the
+/// shapes inferred from `input_shapes` (the shapes of the external inputs),
+/// or by the size of their inputs and outputs when they have none. Since the
+/// executors run the operators of a net one after the other, the makespan is
+/// the sum of these costs, which is minimized exactly with a minimum s-t cut.
+/// Only the operators `gpu_supported` accepts may go to the GPU. The external
+/// inputs are expected on the CPU. Blobs on the GPU are renamed with a `_gpu`
+/// suffix.
+CAFFE2_API NetDef placeOperatorsByCost(
+    const NetDef& net,
+    const CaffeMap<std::string, TensorShape>& input_shapes,
+    std::function<bool(const OperatorDef&)> gpu_supported,
+    const PlacementCostModel& model = PlacementCostModel());
+
+/// Same as above, letting the operators with a CUDA implementation registered
+/// go to the GPU.
+CAFFE2_API NetDef placeOperatorsByCost(
+    const NetDef& net,
+    const CaffeMap<std::string, TensorShape>& input_shapes,
+    const PlacementCostModel& model = PlacementCostModel());
+
 } // namespace opt
 } // namespace caffe2
@@ -1,4 +1,5 @@
 #include "caffe2/core/common.h"
+#include "caffe2/core/operator_schema.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/device.h"
 
@@ -75,3 +76,78 @@ TEST(DeviceTest, InsertCopies) {
   // 9 ops of this pattern becomes 15
   EXPECT_EQ(proto.op().size(), 15);
 }
+
+namespace {
+
+caffe2::NetDef fcReluNet() {
+  caffe2::NetDef net;
+  auto* fc = net.add_op();
+  fc->set_type("FC");
+  fc->add_input("X");
+  fc->add_input("W");
+  fc->add_input("b");
+  fc->add_output("Y");
+  auto* relu = net.add_op();
+  relu->set_type("Relu");
+  relu->add_input("Y");
+  relu->add_output("Z");
+  net.add_external_input("X");
+  net.add_external_input("W");
+  net.add_external_input("b");
+  net.add_external_output("Z");
+  return net;
+}
+
+} // namespace
+
+TEST(DeviceTest, PlaceOperatorsByCostMovesLargeOperatorsToGPU) {
+  caffe2::CaffeMap<std::string, caffe2::TensorShape> shapes;
+  shapes["X"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{1024, 1024}, caffe2::TensorProto::FLOAT);
+  shapes["W"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{1024, 1024}, caffe2::TensorProto::FLOAT);
+  shapes["b"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{1024}, caffe2::TensorProto::FLOAT);
+
+  auto placed = caffe2::opt::placeOperatorsByCost(
+      fcReluNet(), shapes, [](const caffe2::OperatorDef&) { return true; });
+
+  // The FC is worth the copies of its inputs, and the Relu then runs next to
+  // it rather than copying Y back.
+  std::vector<std::string> types;
+  for (const auto& op : placed.op()) {
+    types.push_back(op.type());
+  }
+  EXPECT_EQ(
+      types,
+      (std::vector<std::string>{"CopyCPUToGPU",
+                                "CopyCPUToGPU",
+                                "CopyCPUToGPU",
+                                "FC",
+                                "Relu",
+                                "CopyGPUToCPU"}));
+  EXPECT_EQ(placed.op(3).device_option().device_type(), caffe2::PROTO_CUDA);
+  EXPECT_EQ(placed.op(3).input(0), "X_gpu");
+  EXPECT_EQ(placed.op(4).device_option().device_type(), caffe2::PROTO_CUDA);
+  EXPECT_EQ(placed.op(5).input(0), "Z_gpu");
+  EXPECT_EQ(placed.op(5).output(0), "Z");
+}
+
+TEST(DeviceTest, PlaceOperatorsByCostKeepsSmallOperatorsOnCPU) {
+  caffe2::CaffeMap<std::string, caffe2::TensorShape> shapes;
+  shapes["X"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{2, 4}, caffe2::TensorProto::FLOAT);
+  shapes["W"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{4, 4}, caffe2::TensorProto::FLOAT);
+  shapes["b"] = caffe2::CreateTensorShape(
+      std::vector<int64_t>{4}, caffe2::TensorProto::FLOAT);
+
+  auto placed = caffe2::opt::placeOperatorsByCost(
+      fcReluNet(), shapes, [](const caffe2::OperatorDef&) { return true; });
+
+  ASSERT_EQ(placed.op_size(), 2);
+  for (const auto& op : placed.op()) {
+    EXPECT_EQ(op.device_option().device_type(), caffe2::PROTO_CPU);
+  }
+  EXPECT_EQ(placed.op(1).output(0), "Z");
+}
@@ -1,7 +1,13 @@
 #include "caffe2/opt/fusion.h"
+
+#include <unordered_map>
+#include <unordered_set>
+
 #include "caffe2/core/logging.h"
+#include "caffe2/operators/fused_elementwise_op.h"
 #include "caffe2/opt/converter.h"
 #include "caffe2/opt/passes.h"
+#include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
 namespace opt {
@@ -15,34 +21,32 @@ using namespace nom;
 // m)}{\sqrt{\sigma + \epsilon}} + b_{bn}$$ or
 // $$ W' = W\frac{s}{\sqrt{\sigma + \epsilon}}$$
 // $$ b' = (b_{conv} - m)\frac{s}{\sqrt{\sigma + \epsilon}} + b_{bn}$$
-bool fuseConvBNHelper(repr::NNModule* nn, caffe2::Workspace* ws) {
+bool fuseConvBNHelper(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    repr::Conv* conv,
+    repr::NNGraph::NodeRef convNode) {
   size_t convOrder = 0;
-  for (auto node_pair : repr::nn::dataIterator<repr::Conv>(nn->dataFlow)) {
-    repr::NNGraph::NodeRef convNode;
-    repr::Conv* conv;
-    std::tie(conv, convNode) = node_pair;
-
-    auto output = repr::nn::getOutputs(convNode).front();
-    auto consumers = repr::nn::getConsumers(output);
-    NOM_REQUIRE_OR_CONT(consumers.size() == 1);
+  auto output = repr::nn::getOutputs(convNode).front();
+  auto consumers = repr::nn::getConsumers(output);
+  NOM_REQUIRE_OR_RET_FALSE(consumers.size() == 1);
 
-    auto consumer = consumers.front();
-    NOM_REQUIRE_OR_CONT(repr::nn::is<repr::BatchNormalization>(consumer));
+  auto consumer = consumers.front();
+  NOM_REQUIRE_OR_RET_FALSE(repr::nn::is<repr::BatchNormalization>(consumer));
 
-    auto bnNode = consumer;
-    auto bn = repr::nn::get<repr::BatchNormalization>(bnNode);
-    auto bnOutputs = nn::getOutputs(bnNode);
-    NOM_REQUIRE_OR_CONT(bnOutputs.size() == 1);
-    auto bnOutput = bnOutputs.front();
+  auto bnNode = consumer;
+  auto bn = repr::nn::get<repr::BatchNormalization>(bnNode);
+  auto bnOutputs = nn::getOutputs(bnNode);
+  NOM_REQUIRE_OR_RET_FALSE(bnOutputs.size() == 1);
+  auto bnOutput = bnOutputs.front();
 
-    auto convInputs = repr::nn::getInputs(convNode);
-    if (convInputs.size() < 2) {
-      continue;
-    }
+  auto convInputs = repr::nn::getInputs(convNode);
+  if (convInputs.size() < 2) {
+    return false;
+  }
 
-    auto bnInputs = repr::nn::getInputs(bnNode);
-    CAFFE_ENFORCE(
-        bnInputs.size() >= 5, "Invalid batch normalization input size");
+  auto bnInputs = repr::nn::getInputs(bnNode);
+  CAFFE_ENFORCE(bnInputs.size() >= 5, "Invalid batch normalization input size");
 
 #define EXPOSE_TENSOR_DATA(name, index, inputs)                                \
   auto name = repr::nn::get<repr::Tensor>(inputs[index]);                      \
@@ -50,76 +54,438 @@ bool fuseConvBNHelper(repr::NNModule* nn, caffe2::Workspace* ws) {
   auto name##Tensor = BlobGetMutableTensor(ws->GetBlob(name->getName()), CPU); \
   auto name##Data = name##Tensor->mutable_data<float>();
 
-    EXPOSE_TENSOR_DATA(filter, 1, convInputs);
-
-    EXPOSE_TENSOR_DATA(scale, 1, bnInputs);
-    EXPOSE_TENSOR_DATA(biasBN, 2, bnInputs);
-    EXPOSE_TENSOR_DATA(mean, 3, bnInputs);
-    EXPOSE_TENSOR_DATA(variance, 4, bnInputs);
-
-    if (convInputs.size() == 2) {
-      NOM_REQUIRE_OR_CONT(conv->getMutableAnnotation() != nullptr);
-      auto annotation =
-          dyn_cast<caffe2::Caffe2Annotation>(conv->getMutableAnnotation());
-      NOM_REQUIRE_OR_CONT(annotation != nullptr);
-      auto op = annotation->getOperatorDef();
-      auto convName = op.name();
-
-      while (true) {
-        auto convBiasName = convName + "_bias" + to_string(convOrder);
-        if (!ws->HasBlob(convBiasName)) {
-          auto convBiasTensor = make_unique<repr::Tensor>(convBiasName);
-          convBiasTensor->setType(repr::Tensor::DataType::Float);
-          auto convBiasNode = nn->dataFlow.createNode(
-              unique_dyn_cast<repr::NeuralNetData>(convBiasTensor));
-          nn->inputs.insert(convBiasNode);
-          nn->dataFlow.createEdge(convBiasNode, convNode);
-
-          auto* blob = ws->CreateBlob(convBiasName);
-          caffe2::TensorCPU* tensor = BlobGetMutableTensor(blob, caffe2::CPU);
-          CHECK_NOTNULL(tensor);
-          // Get output channel
-          size_t c = filterTensor->dim32(0);
-          tensor->Resize(c);
-          float* tensor_data = tensor->mutable_data<float>();
-          memset(tensor_data, 0, tensor->nbytes());
-          break;
-        }
-        convOrder++;
+  EXPOSE_TENSOR_DATA(filter, 1, convInputs);
+
+  EXPOSE_TENSOR_DATA(scale, 1, bnInputs);
+  EXPOSE_TENSOR_DATA(biasBN, 2, bnInputs);
+  EXPOSE_TENSOR_DATA(mean, 3, bnInputs);
+  EXPOSE_TENSOR_DATA(variance, 4, bnInputs);
+
+  if (convInputs.size() == 2) {
+    NOM_REQUIRE_OR_RET_FALSE(conv->getMutableAnnotation() != nullptr);
+    auto annotation =
+        dyn_cast<caffe2::Caffe2Annotation>(conv->getMutableAnnotation());
+    NOM_REQUIRE_OR_RET_FALSE(annotation != nullptr);
+    auto op = annotation->getOperatorDef();
+    auto convName = op.name();
+
+    while (true) {
+      auto convBiasName = convName + "_bias" + to_string(convOrder);
+      if (!ws->HasBlob(convBiasName)) {
+        auto convBiasTensor = make_unique<repr::Tensor>(convBiasName);
+        convBiasTensor->setType(repr::Tensor::DataType::Float);
+        auto convBiasNode = nn->dataFlow.createNode(
+            unique_dyn_cast<repr::NeuralNetData>(convBiasTensor));
+        nn->inputs.insert(convBiasNode);
+        nn->dataFlow.createEdge(convBiasNode, convNode);
+
+        auto* blob = ws->CreateBlob(convBiasName);
+        caffe2::TensorCPU* tensor = BlobGetMutableTensor(blob, caffe2::CPU);
+        CHECK_NOTNULL(tensor);
+        // Get output channel
+        size_t c = filterTensor->dim32(0);
+        tensor->Resize(c);
+        float* tensor_data = tensor->mutable_data<float>();
+        memset(tensor_data, 0, tensor->nbytes());
+        break;
       }
+      convOrder++;
     }
+  }
 
-    convInputs = repr::nn::getInputs(convNode);
-    EXPOSE_TENSOR_DATA(biasConv, 2, convInputs);
+  convInputs = repr::nn::getInputs(convNode);
+  EXPOSE_TENSOR_DATA(biasConv, 2, convInputs);
 
 #undef EXPOSE_TENSOR_DATA
 
-    // Assume M{CHW,HWC}
-    auto chwDim = filterTensor->size_from_dim(1);
-    for (auto c = 0; c < filterTensor->dim32(0); ++c) {
-      float coeff =
-          scaleData[c] / std::sqrt(varianceData[c] + bn->getEpsilon());
-      for (auto i = 0; i < chwDim; ++i) {
-        filterData[c * chwDim + i] *= coeff;
-      }
-      auto bias = (biasConvData[c] - meanData[c]) * coeff + biasBNData[c];
-      biasConvData[c] = bias;
+  // Assume M{CHW,HWC}
+  auto chwDim = filterTensor->size_from_dim(1);
+  for (auto c = 0; c < filterTensor->dim32(0); ++c) {
+    float coeff = scaleData[c] / std::sqrt(varianceData[c] + bn->getEpsilon());
+    for (auto i = 0; i < chwDim; ++i) {
+      filterData[c * chwDim + i] *= coeff;
     }
-
-    nn->dataFlow.deleteNode(output);
-    nn->dataFlow.createEdge(convNode, bnOutput);
-    nn->dataFlow.deleteNode(bnNode);
-    return true;
+    auto bias = (biasConvData[c] - meanData[c]) * coeff + biasBNData[c];
+    biasConvData[c] = bias;
   }
-  return false;
+
+  nn->dataFlow.deleteNode(output);
+  nn->dataFlow.createEdge(convNode, bnOutput);
+  nn->dataFlow.deleteNode(bnNode);
+  return true;
 }
 
 void fuseConvBN(nom::repr::NNModule* nn, caffe2::Workspace* ws) {
-  while (fuseConvBNHelper(nn, ws)) {
+  // Fusing a BN only changes the Conv it is fused into, which may then be
+  // followed by another BN. Every Conv is visited once, instead of scanning
+  // the whole net again after each fusion.
+  for (auto node_pair : repr::nn::dataIterator<repr::Conv>(nn->dataFlow)) {
+    while (fuseConvBNHelper(nn, ws, node_pair.first, node_pair.second)) {
+    }
   }
 }
 
 REGISTER_WS_OPT_PASS_FROM_FUNC(FuseConvBN, fuseConvBN);
 
+namespace {
+
+const caffe2::OperatorDef* getOperatorDef(const repr::NeuralNetOperator* op) {
+  const auto* annotation = op->getAnnotation();
+  if (!annotation || !isa<Caffe2Annotation>(annotation)) {
+    return nullptr;
+  }
+  const auto* c2Annotation = dyn_cast<Caffe2Annotation>(annotation);
+  if (!c2Annotation->hasOperatorDef()) {
+    return nullptr;
+  }
+  return &c2Annotation->getOperatorDef();
+}
+
+const caffe2::OperatorDef* getOperatorDef(repr::NNGraph::NodeRef node) {
+  if (!repr::nn::is<repr::NeuralNetOperator>(node)) {
+    return nullptr;
+  }
+  return getOperatorDef(repr::nn::get<repr::NeuralNetOperator>(node));
+}
+
+// Only the default CPU operators know the fused ops and arguments.
+bool isDefaultCPUOp(const caffe2::OperatorDef* def) {
+  return def && def->engine().empty() &&
+      def->device_option().device_type() == caffe2::PROTO_CPU;
+}
+
+// The float tensor in `ws` of a blob that no op of the net writes.
+const TensorCPU* getParameter(
+    caffe2::Workspace* ws,
+    repr::NNGraph::NodeRef node) {
+  if (repr::nn::hasProducer(node)) {
+    return nullptr;
+  }
+  const auto* blob = ws->GetBlob(repr::nn::getName(node));
+  if (!blob || !BlobIsTensorType(*blob, CPU)) {
+    return nullptr;
+  }
+  const auto& tensor = blob->Get<TensorCPU>();
+  if (!tensor.IsType<float>()) {
+    return nullptr;
+  }
+  return &tensor;
+}
+
+// Y = FC(X, W, b0), Z = Add(Y, b) => Z = FC(X, W, b0 + b)
+// Y = Conv(X, W[, b0]), Z = Add(Y, b) => Z = Conv(X, W, [b0 +] b)
+bool foldBiasAddHelper(
+    repr::NNModule* nn,
+    caffe2::Workspace* ws,
+    repr::NNGraph::NodeRef node) {
+  size_t biasOrder = 0;
+  const bool isConv = repr::nn::is<repr::Conv>(node);
+  NOM_REQUIRE_OR_RET_FALSE(isDefaultCPUOp(getOperatorDef(node)));
+
+  auto inputs = repr::nn::getInputs(node);
+  auto outputs = repr::nn::getOutputs(node);
+  NOM_REQUIRE_OR_RET_FALSE(inputs.size() >= 2 && outputs.size() == 1);
+  auto output = outputs.front();
+  NOM_REQUIRE_OR_RET_FALSE(!nn->outputs.count(output));
+  auto consumers = repr::nn::getConsumers(output);
+  NOM_REQUIRE_OR_RET_FALSE(consumers.size() == 1);
+
+  auto addNode = consumers.front();
+  const auto* addDef = getOperatorDef(addNode);
+  NOM_REQUIRE_OR_RET_FALSE(addDef && addDef->type() == "Add");
+  NOM_REQUIRE_OR_RET_FALSE(isDefaultCPUOp(addDef));
+  auto addInputs = repr::nn::getInputs(addNode);
+  auto addOutputs = repr::nn::getOutputs(addNode);
+  NOM_REQUIRE_OR_RET_FALSE(addInputs.size() == 2 && addInputs[0] == output);
+  NOM_REQUIRE_OR_RET_FALSE(addOutputs.size() == 1);
+  auto addOutput = addOutputs.front();
+  // FC and Conv can't run in place
+  NOM_REQUIRE_OR_RET_FALSE(
+      repr::nn::getName(addOutput) != repr::nn::getName(inputs[0]));
+
+  // The bias has to be broadcast along the output channels: the second
+  // axis of NCHW outputs, the last one otherwise.
+  ArgumentHelper addArgs(*addDef);
+  NOM_REQUIRE_OR_RET_FALSE(
+      addArgs.GetSingleArgument<int>("broadcast", 0) == 1);
+  const bool nchw = isConv &&
+      repr::nn::get<repr::Conv>(node)->getLayout() !=
+          repr::NeuralNetOperator::NNLayout::NHWC;
+  NOM_REQUIRE_OR_RET_FALSE(
+      addArgs.GetSingleArgument<int>("axis", -1) == (nchw ? 1 : -1));
+
+  const auto* bias = getParameter(ws, addInputs[1]);
+  NOM_REQUIRE_OR_RET_FALSE(bias && bias->dim() == 1);
+  const TensorCPU* oldBias = nullptr;
+  if (inputs.size() > 2) {
+    oldBias = getParameter(ws, inputs[2]);
+    NOM_REQUIRE_OR_RET_FALSE(oldBias && oldBias->numel() == bias->numel());
+  } else {
+    // only Conv can go without a bias
+    const auto* filter = getParameter(ws, inputs[1]);
+    NOM_REQUIRE_OR_RET_FALSE(filter && filter->dim() > 0);
+    NOM_REQUIRE_OR_RET_FALSE(filter->dim32(0) == bias->numel());
+  }
+
+  // The biases may be shared with other ops, the sum goes in a new blob.
+  std::string newBiasName;
+  do {
+    newBiasName =
+        repr::nn::getName(addInputs[1]) + "_fused" + to_string(biasOrder++);
+  } while (ws->HasBlob(newBiasName));
+  auto* newBias = BlobGetMutableTensor(ws->CreateBlob(newBiasName), CPU);
+  newBias->Resize(bias->numel());
+  auto* newBiasData = newBias->mutable_data<float>();
+  const auto* biasData = bias->data<float>();
+  const auto* oldBiasData = oldBias ? oldBias->data<float>() : nullptr;
+  for (int64_t i = 0; i < bias->numel(); ++i) {
+    newBiasData[i] = biasData[i] + (oldBiasData ? oldBiasData[i] : 0);
+  }
+
+  auto newBiasTensor = make_unique<repr::Tensor>(newBiasName);
+  newBiasTensor->setType(repr::Tensor::DataType::Float);
+  auto newBiasNode = nn->dataFlow.createNode(
+      unique_dyn_cast<repr::NeuralNetData>(newBiasTensor));
+  nn->inputs.insert(newBiasNode);
+  if (oldBias) {
+    // Keeps the bias third among the inputs
+    auto edge = nn->dataFlow.getEdgeIfExists(inputs[2], node);
+    edge->setTail(newBiasNode);
+    inputs[2]->removeOutEdge(edge);
+    newBiasNode->addOutEdge(edge);
+  } else {
+    nn->dataFlow.createEdge(newBiasNode, node);
+  }
+
+  nn->dataFlow.deleteNode(addNode);
+  nn->dataFlow.replaceInEdges(output, addOutput);
+  nn->dataFlow.deleteNode(output);
+  return true;
+}
+
+template <typename OperationT>
+void fuseRelu(repr::NNModule* nn) {
+  // The output of the op goes away, it can't be an output of the net.
+  std::unordered_set<const repr::NeuralNetOperator*> externalOutputOps;
+  for (auto output : nn->outputs) {
+    if (repr::nn::hasProducer(output)) {
+      externalOutputOps.insert(repr::nn::get<repr::NeuralNetOperator>(
+          repr::nn::getProducer(output)));
+    }
+  }
+
+  auto should_fuse = [&externalOutputOps](const OperationT& op) {
+    const auto* def = getOperatorDef(&op);
+    return !externalOutputOps.count(&op) && isDefaultCPUOp(def) &&
+        !ArgumentHelper::HasArgument(*def, "activation");
+  };
+
+  auto postprocess = [](repr::NNGraph::NodeRef node) {
+    auto* op = getOrAddCaffe2Annotation(node)->getMutableOperatorDef();
+    auto* arg = op->add_arg();
+    arg->set_name("activation");
+    arg->set_s("Relu");
+  };
+
+  fuseActivation<OperationT, repr::Relu>(nn, should_fuse, postprocess);
+}
+
+// The type of the unary op run by the default CPU operators that `node` is,
+// or an empty string.
+std::string getFusableType(repr::NNGraph::NodeRef node) {
+  const auto* def = getOperatorDef(node);
+  if (!isDefaultCPUOp(def) || !FusedElementwiseOp::IsFusable(def->type()) ||
+      repr::nn::getInputs(node).size() != 1 ||
+      repr::nn::getOutputs(node).size() != 1) {
+    return "";
+  }
+  return def->type();
+}
+
+// The op that continues the chain of `node`, if the output of `node` is
+// read by it alone.
+repr::NNGraph::NodeRef getNextInChain(
+    repr::NNModule* nn,
+    repr::NNGraph::NodeRef node) {
+  auto output = repr::nn::getOutputs(node).front();
+  if (nn->outputs.count(output)) {
+    return nullptr;
+  }
+  auto consumers = repr::nn::getConsumers(output);
+  if (consumers.size() != 1 || getFusableType(consumers.front()).empty()) {
+    return nullptr;
+  }
+  return consumers.front();
+}
+
+// Concat and Split take the same arguments for the axis.
+int getConcatSplitAxis(const caffe2::OperatorDef& def) {
+  ArgumentHelper args(def);
+  if (args.HasArgument("axis")) {
+    return args.GetSingleArgument<int>("axis", -1);
+  }
+  return args.GetSingleArgument<std::string>("order", "NCHW") == "NHWC" ? 3
+                                                                        : 1;
+}
+
+} // namespace
+
+void fuseBiasActivation(repr::NNModule* nn, caffe2::Workspace* ws) {
+  if (ws) {
+    // Folding an Add only changes the FC or Conv it is folded into, which
+    // may then be followed by another Add. Every FC and Conv is visited once.
+    std::vector<repr::NNGraph::NodeRef> nodes;
+    for (auto node : nn->dataFlow.getMutableNodes()) {
+      if (repr::nn::is<repr::Conv>(node) || repr::nn::is<repr::FC>(node)) {
+        nodes.push_back(node);
+      }
+    }
+    for (auto node : nodes) {
+      while (foldBiasAddHelper(nn, ws, node)) {
+      }
+    }
+  }
+  fuseRelu<repr::FC>(nn);
+  fuseRelu<repr::Conv>(nn);
+}
+
+void fuseElementwiseChains(repr::NNModule* nn) {
+  std::vector<repr::NNGraph::NodeRef> heads;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    NOM_REQUIRE_OR_CONT(!getFusableType(node).empty());
+    auto input = repr::nn::getInputs(node).front();
+    if (repr::nn::hasProducer(input)) {
+      auto producer = repr::nn::getProducer(input);
+      NOM_REQUIRE_OR_CONT(
+          getFusableType(producer).empty() ||
+          getNextInChain(nn, producer) != node);
+    }
+    heads.push_back(node);
+  }
+
+  for (auto head : heads) {
+    std::vector<repr::NNGraph::NodeRef> chain{head};
+    while (auto next = getNextInChain(nn, chain.back())) {
+      chain.push_back(next);
+    }
+    NOM_REQUIRE_OR_CONT(chain.size() > 1);
+
+    auto fusedNode = nn->dataFlow.createNode(
+        make_unique<repr::GenericOperator>("FusedElementwise"));
+    auto* fusedOp =
+        getOrAddCaffe2Annotation(fusedNode)->getMutableOperatorDef();
+    fusedOp->mutable_device_option()->CopyFrom(
+        getOperatorDef(head)->device_option());
+    auto* ops = fusedOp->add_arg();
+    ops->set_name("ops");
+    for (auto node : chain) {
+      ops->add_strings(getFusableType(node));
+    }
+
+    auto input = repr::nn::getInputs(chain.front()).front();
+    auto output = repr::nn::getOutputs(chain.back()).front();
+    std::vector<repr::NNGraph::NodeRef> intermediates;
+    for (size_t i = 0; i + 1 < chain.size(); ++i) {
+      intermediates.push_back(repr::nn::getOutputs(chain[i]).front());
+    }
+    for (auto node : chain) {
+      nn->dataFlow.deleteNode(node);
+    }
+    for (auto node : intermediates) {
+      nn->dataFlow.deleteNode(node);
+    }
+    nn->dataFlow.createEdge(input, fusedNode);
+    nn->dataFlow.createEdge(fusedNode, output);
+  }
+}
+
+void eliminateConcatSplit(repr::NNModule* nn) {
+  // The consumers of the Split are made to read the Concat inputs by name,
+  // which is only safe if nothing writes these blobs again.
+  std::unordered_map<std::string, int> versions;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    if (repr::nn::is<repr::NeuralNetData>(node)) {
+      ++versions[repr::nn::getName(node)];
+    }
+  }
+
+  std::vector<repr::NNGraph::NodeRef> splits;
+  for (auto node : nn->dataFlow.getMutableNodes()) {
+    const auto* def = getOperatorDef(node);
+    if (def && def->type() == "Split") {
+      splits.push_back(node);
+    }
+  }
+
+  for (auto splitNode : splits) {
+    const auto* splitDef = getOperatorDef(splitNode);
+    auto splitInputs = repr::nn::getInputs(splitNode);
+    auto splitOutputs = repr::nn::getOutputs(splitNode);
+    // Split by the split_info of the Concat, so the pieces are the inputs.
+    NOM_REQUIRE_OR_CONT(splitInputs.size() == 2);
+    NOM_REQUIRE_OR_CONT(repr::nn::hasProducer(splitInputs[0]));
+    auto concatNode = repr::nn::getProducer(splitInputs[0]);
+    const auto* concatDef = getOperatorDef(concatNode);
+    NOM_REQUIRE_OR_CONT(concatDef && concatDef->type() == "Concat");
+    auto concatInputs = repr::nn::getInputs(concatNode);
+    auto concatOutputs = repr::nn::getOutputs(concatNode);
+    NOM_REQUIRE_OR_CONT(
+        concatOutputs.size() == 2 && concatOutputs[0] == splitInputs[0] &&
+        concatOutputs[1] == splitInputs[1]);
+    NOM_REQUIRE_OR_CONT(concatInputs.size() == splitOutputs.size());
+
+    NOM_REQUIRE_OR_CONT(
+        getConcatSplitAxis(*concatDef) == getConcatSplitAxis(*splitDef));
+    NOM_REQUIRE_OR_CONT(
+        ArgumentHelper(*concatDef).GetSingleArgument<int>("add_axis", 0) ==
+        ArgumentHelper(*splitDef).GetSingleArgument<int>("add_axis", 0));
+    NOM_REQUIRE_OR_CONT(
+        concatDef->device_option().device_type() ==
+        splitDef->device_option().device_type());
+
+    bool renamable = true;
+    for (size_t i = 0; i < splitOutputs.size(); ++i) {
+      if (nn->outputs.count(splitOutputs[i]) ||
+          versions[repr::nn::getName(concatInputs[i])] != 1) {
+        renamable = false;
+      }
+    }
+    NOM_REQUIRE_OR_CONT(renamable);
+
+    for (size_t i = 0; i < splitOutputs.size(); ++i) {
+      repr::nn::replaceAllUsesWith(splitOutputs[i], concatInputs[i]);
+    }
+    nn->dataFlow.deleteNode(splitNode);
+    for (auto output : splitOutputs) {
+      nn->dataFlow.deleteNode(output);
+    }
+
+    bool concatUsed = false;
+    for (auto output : concatOutputs) {
+      if (repr::nn::hasConsumer(output) || nn->outputs.count(output)) {
+        concatUsed = true;
+      }
+    }
+    if (!concatUsed) {
+      nn->dataFlow.deleteNode(concatNode);
+      for (auto output : concatOutputs) {
+        nn->dataFlow.deleteNode(output);
+      }
+    }
+  }
+}
+
+void fuseCPUOps(repr::NNModule* nn, caffe2::Workspace* ws) {
+  eliminateConcatSplit(nn);
+  // before the chains, which could take the Relus
+  fuseBiasActivation(nn, ws);
+  fuseElementwiseChains(nn);
+}
+
+REGISTER_WS_OPT_PASS_FROM_FUNC(FuseBiasActivation, fuseBiasActivation);
+REGISTER_OPT_PASS_FROM_FUNC(FuseElementwiseChains, fuseElementwiseChains);
+REGISTER_OPT_PASS_FROM_FUNC(EliminateConcatSplit, eliminateConcatSplit);
+REGISTER_WS_OPT_PASS_FROM_FUNC(FuseCPUOps, fuseCPUOps);
+
 } // namespace opt
 } // namespace caffe2
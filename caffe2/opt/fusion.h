@@ -27,6 +27,22 @@ using namespace nom;
 
 CAFFE2_API void fuseConvBN(repr::NNModule* nn, caffe2::Workspace* ws);
 
+// Fusions for nets run by the default CPU operators, see fuseCPUOps().
+//
+// fuseBiasActivation folds broadcast Adds of a constant bias into the bias of
+// the preceding FC or Conv, and Relus into the FC or Conv themselves. With a
+// null workspace only the Relus are fused, the biases have to be read.
+CAFFE2_API void fuseBiasActivation(repr::NNModule* nn, caffe2::Workspace* ws);
+// Replaces chains of unary elementwise ops, where every op is the only
+// consumer of the previous one, with a single FusedElementwise op.
+CAFFE2_API void fuseElementwiseChains(repr::NNModule* nn);
+// Removes the Splits of a Concat output by its split_info, the consumers of
+// the Split then read the Concat inputs directly. The Concat is removed too
+// if nothing else reads its outputs.
+CAFFE2_API void eliminateConcatSplit(repr::NNModule* nn);
+// All of the above, enabled in the predictor by optimization level 2.
+CAFFE2_API void fuseCPUOps(repr::NNModule* nn, caffe2::Workspace* ws);
+
 // Generic activation fusion helper.
 //
 // \tparam OperationT The operator to be fused.
@@ -0,0 +1,205 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/test_utils.h"
+#include "caffe2/opt/converter.h"
+#include "caffe2/opt/fusion.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+using namespace caffe2::testing;
+
+namespace {
+
+void fillRandom(
+    const std::string& name,
+    const std::vector<int64_t>& shape,
+    caffe2::Workspace* ws) {
+  auto* tensor = createTensor(name, ws);
+  tensor->Resize(shape);
+  randomFill(tensor->mutable_data<float>(), tensor->numel(), -1.0, 1.0);
+}
+
+// Runs `net` before and after fuseCPUOps, and checks that the outputs match.
+caffe2::NetDef fuseAndCompare(
+    const caffe2::NetDef& net,
+    const std::vector<std::string>& outputs,
+    caffe2::Workspace* ws) {
+  CAFFE_ENFORCE(ws->RunNetOnce(net));
+  std::vector<caffe2::Tensor> expected;
+  for (const auto& output : outputs) {
+    expected.push_back(getTensor(*ws, output).Clone());
+    ws->RemoveBlob(output);
+  }
+
+  auto nn = caffe2::convertToNNModule(net);
+  caffe2::opt::fuseCPUOps(&nn, ws);
+  auto optimized_net = caffe2::convertToCaffe2Proto(nn, net);
+
+  CAFFE_ENFORCE(ws->RunNetOnce(optimized_net));
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    const auto& actual = getTensor(*ws, outputs[i]);
+    EXPECT_EQ(actual.sizes().vec(), expected[i].sizes().vec());
+    for (int64_t j = 0; j < actual.numel(); ++j) {
+      EXPECT_NEAR(
+          actual.data<float>()[j], expected[i].data<float>()[j], 1e-5);
+    }
+  }
+  return optimized_net;
+}
+
+} // namespace
+
+TEST(FuseCPUOps, FCBiasRelu) {
+  caffe2::Workspace ws;
+  fillRandom("X", {5, 8}, &ws);
+  fillRandom("W", {6, 8}, &ws);
+  fillRandom("b", {6}, &ws);
+  fillRandom("c", {6}, &ws);
+
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("FC", {"X", "W", "b"}, {"Y"})
+      .newOp("Add", {"Y", "c"}, {"Z"})
+      .addArgument("broadcast", 1)
+      .newOp("Relu", {"Z"}, {"out"})
+      .externalInputs({"X", "W", "b", "c"})
+      .externalOutputs({"out"});
+
+  auto optimized_net = fuseAndCompare(net, {"out"}, &ws);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& fc = optimized_net.op(0);
+  EXPECT_EQ(fc.type(), "FC");
+  EXPECT_EQ(fc.output(0), "out");
+  EXPECT_NE(fc.input(2), "b");
+  EXPECT_EQ(
+      caffe2::ArgumentHelper(fc).GetSingleArgument<std::string>(
+          "activation", ""),
+      "Relu");
+}
+
+TEST(FuseCPUOps, ConvBiasRelu) {
+  caffe2::Workspace ws;
+  fillRandom("X", {2, 3, 6, 6}, &ws);
+  fillRandom("W", {4, 3, 3, 3}, &ws);
+  fillRandom("c", {4}, &ws);
+
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Conv", {"X", "W"}, {"Y"})
+      .addArgument("kernel", 3)
+      .newOp("Add", {"Y", "c"}, {"Z"})
+      .addArgument("broadcast", 1)
+      .addArgument("axis", 1)
+      .newOp("Relu", {"Z"}, {"Z"})
+      .externalInputs({"X", "W", "c"})
+      .externalOutputs({"Z"});
+
+  auto optimized_net = fuseAndCompare(net, {"Z"}, &ws);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  EXPECT_EQ(optimized_net.op(0).type(), "Conv");
+  EXPECT_EQ(optimized_net.op(0).input().size(), 3);
+}
+
+TEST(FuseCPUOps, NoBiasFoldAlongWrongAxis) {
+  caffe2::Workspace ws;
+  fillRandom("X", {2, 3, 6, 6}, &ws);
+  fillRandom("W", {4, 3, 1, 1}, &ws);
+  fillRandom("c", {6}, &ws);
+
+  // c is broadcast along the width, not the channels
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Conv", {"X", "W"}, {"Y"})
+      .addArgument("kernel", 1)
+      .newOp("Add", {"Y", "c"}, {"out"})
+      .addArgument("broadcast", 1)
+      .externalInputs({"X", "W", "c"})
+      .externalOutputs({"out"});
+
+  auto optimized_net = fuseAndCompare(net, {"out"}, &ws);
+  EXPECT_EQ(optimized_net.op().size(), 2);
+}
+
+TEST(FuseCPUOps, ElementwiseChain) {
+  caffe2::Workspace ws;
+  // more than one block of FusedElementwise
+  fillRandom("X", {3, 5000}, &ws);
+
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Exp", {"X"}, {"A"})
+      .newOp("Sigmoid", {"A"}, {"B"})
+      .newOp("Sqr", {"B"}, {"B"})
+      .newOp("Tanh", {"B"}, {"out"})
+      .externalInputs({"X"})
+      .externalOutputs({"out"});
+
+  auto optimized_net = fuseAndCompare(net, {"out"}, &ws);
+  ASSERT_EQ(optimized_net.op().size(), 1);
+  const auto& op = optimized_net.op(0);
+  EXPECT_EQ(op.type(), "FusedElementwise");
+  EXPECT_EQ(op.input(0), "X");
+  EXPECT_EQ(op.output(0), "out");
+  EXPECT_EQ(
+      caffe2::ArgumentHelper(op).GetRepeatedArgument<std::string>("ops"),
+      std::vector<std::string>({"Exp", "Sigmoid", "Sqr", "Tanh"}));
+}
+
+TEST(FuseCPUOps, ElementwiseChainKeepsExternalOutputs) {
+  caffe2::Workspace ws;
+  fillRandom("X", {10}, &ws);
+
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Exp", {"X"}, {"A"})
+      .newOp("Sigmoid", {"A"}, {"B"})
+      .newOp("Tanh", {"B"}, {"out"})
+      .externalInputs({"X"})
+      .externalOutputs({"A", "out"});
+
+  auto optimized_net = fuseAndCompare(net, {"A", "out"}, &ws);
+  ASSERT_EQ(optimized_net.op().size(), 2);
+  EXPECT_EQ(optimized_net.op(0).type(), "Exp");
+  EXPECT_EQ(optimized_net.op(1).type(), "FusedElementwise");
+}
+
+TEST(FuseCPUOps, ConcatSplit) {
+  caffe2::Workspace ws;
+  fillRandom("A", {4, 3}, &ws);
+  fillRandom("B", {4, 5}, &ws);
+
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Concat", {"A", "B"}, {"C", "C_info"})
+      .newOp("Split", {"C", "C_info"}, {"D", "E"})
+      .newOp("Relu", {"D"}, {"F"})
+      .newOp("Sigmoid", {"E"}, {"G"})
+      .externalInputs({"A", "B"})
+      .externalOutputs({"F", "G"});
+
+  auto optimized_net = fuseAndCompare(net, {"F", "G"}, &ws);
+  ASSERT_EQ(optimized_net.op().size(), 2);
+  for (const auto& op : optimized_net.op()) {
+    EXPECT_NE(op.type(), "Concat");
+    EXPECT_NE(op.type(), "Split");
+  }
+}
+
+TEST(FuseCPUOps, ConcatSplitKeepsOverwrittenInputs) {
+  caffe2::Workspace ws;
+  fillRandom("A", {4, 3}, &ws);
+  fillRandom("B", {4, 5}, &ws);
+
+  // A is written again before D is read, D can't be renamed to A
+  caffe2::NetDef net;
+  NetMutator(&net)
+      .newOp("Concat", {"A", "B"}, {"C", "C_info"})
+      .newOp("Split", {"C", "C_info"}, {"D", "E"})
+      .newOp("Sigmoid", {"A"}, {"A"})
+      .newOp("Relu", {"D"}, {"F"})
+      .externalInputs({"A", "B"})
+      .externalOutputs({"A", "E", "F"});
+
+  auto optimized_net = fuseAndCompare(net, {"A", "E", "F"}, &ws);
+  EXPECT_EQ(optimized_net.op().size(), 4);
+}
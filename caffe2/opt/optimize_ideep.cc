@@ -191,6 +191,163 @@ bool removeStopGradientForInference(repr::NNModule* nn, caffe2::Workspace* ws) {
   return false;
 }
 
+// Follows the input of an FP32 op back to the INT8 tensor it was converted
+// from, by an Int8Dequantize possibly followed by an NHWC2NCHW. Returns
+// nullptr if there is no such tensor or a conversion output has other
+// consumers, otherwise the conversions and their outputs are added to
+// deadNodes.
+repr::NNGraph::NodeRef getInt8Input(
+    repr::NNGraph::NodeRef input,
+    vector<repr::NNGraph::NodeRef>& deadNodes) {
+  auto tensor = input;
+  bool order_switched = false;
+  while (repr::nn::hasProducer(tensor)) {
+    auto producerNode = repr::nn::getProducer(tensor);
+    auto producer = repr::nn::get<repr::NeuralNetOperator>(producerNode);
+    if (!repr::nn::hasSingleOutputAndConsumer(producerNode) ||
+        !isOnIdeepDevice(*producer)) {
+      return nullptr;
+    }
+    deadNodes.push_back(producerNode);
+    deadNodes.push_back(tensor);
+
+    auto producerInput = repr::nn::getInputs(producerNode).front();
+    if (isOpType(producerNode, "Int8Dequantize")) {
+      return producerInput;
+    }
+    if (order_switched || !isOpType(producerNode, "NHWC2NCHW")) {
+      return nullptr;
+    }
+    order_switched = true;
+    tensor = producerInput;
+  }
+  return nullptr;
+}
+
+// Follows the output of an FP32 op to the INT8 tensor it is converted to, by
+// an Int8Quantize possibly preceded by an NCHW2NHWC. Returns nullptr if there
+// is no such tensor or an output has other consumers, otherwise the output,
+// the conversions and their outputs but the last are added to deadNodes.
+repr::NNGraph::NodeRef getInt8Output(
+    repr::NNGraph::NodeRef output,
+    vector<repr::NNGraph::NodeRef>& deadNodes,
+    repr::NNGraph::NodeRef& quantizeNode) {
+  auto tensor = output;
+  bool order_switched = false;
+  while (true) {
+    auto consumers = repr::nn::getConsumers(tensor);
+    if (consumers.size() != 1) {
+      return nullptr;
+    }
+    auto consumerNode = consumers.front();
+    auto consumer = repr::nn::get<repr::NeuralNetOperator>(consumerNode);
+    if (repr::nn::getOutputs(consumerNode).size() != 1 ||
+        !isOnIdeepDevice(*consumer)) {
+      return nullptr;
+    }
+    deadNodes.push_back(tensor);
+    deadNodes.push_back(consumerNode);
+
+    auto consumerOutput = repr::nn::getOutputs(consumerNode).front();
+    if (isOpType(consumerNode, "Int8Quantize")) {
+      quantizeNode = consumerNode;
+      return consumerOutput;
+    }
+    if (order_switched || !isOpType(consumerNode, "NCHW2NHWC")) {
+      return nullptr;
+    }
+    order_switched = true;
+    tensor = consumerOutput;
+  }
+}
+
+bool fuseInt8Ops(repr::NNModule* nn, caffe2::Workspace* ws) {
+  // An FP32 op whose inputs are dequantized and whose output is quantized
+  // right after is replaced by its INT8 counterpart, so that the tensors of
+  // INT8 regions are neither converted to FP32 nor reordered between INT8
+  // ops. The concat can requantize its inputs, the other ops keep the scale
+  // of their input.
+  static const std::map<string, string> int8_ops = {
+      {"Concat", "Int8Concat"},
+      {"Sum", "Int8Sum"},
+      {"Relu", "Int8Relu"},
+      {"MaxPool", "Int8MaxPool"},
+      {"AveragePool", "Int8AveragePool"},
+      {"ChannelShuffle", "Int8ChannelShuffle"},
+      {"Transpose", "Int8Transpose"},
+  };
+
+  auto allNodes = nn->dataFlow.getMutableNodes();
+  for (int i = 0; i < allNodes.size(); ++i) {
+    auto opNode = allNodes[i];
+    if (opNode == nullptr || !repr::nn::is<repr::NeuralNetOperator>(opNode)) {
+      continue;
+    }
+
+    auto op = repr::nn::get<repr::NeuralNetOperator>(opNode);
+    auto it = int8_ops.find(getOpDef(*op).type());
+    if (it == int8_ops.end() || !isOnIdeepDevice(*op)) {
+      continue;
+    }
+
+    auto inputs = repr::nn::getInputs(opNode);
+    auto outputs = repr::nn::getOutputs(opNode);
+    if (inputs.empty() || outputs.empty() ||
+        (it->second == "Int8Sum" && inputs.size() < 2)) {
+      continue;
+    }
+
+    vector<repr::NNGraph::NodeRef> deadNodes;
+    vector<repr::NNGraph::NodeRef> int8Inputs;
+    for (auto input : inputs) {
+      auto int8Input = getInt8Input(input, deadNodes);
+      if (int8Input == nullptr) {
+        break;
+      }
+      int8Inputs.push_back(int8Input);
+    }
+    if (int8Inputs.size() != inputs.size()) {
+      continue;
+    }
+
+    // The other outputs, as the split info of Concat, must be unused
+    bool other_outputs_used = false;
+    for (int j = 1; j < outputs.size(); ++j) {
+      if (repr::nn::hasConsumer(outputs[j])) {
+        other_outputs_used = true;
+        break;
+      }
+    }
+    if (other_outputs_used) {
+      continue;
+    }
+
+    repr::NNGraph::NodeRef quantizeNode = nullptr;
+    auto int8Output = getInt8Output(outputs.front(), deadNodes, quantizeNode);
+    if (int8Output == nullptr) {
+      continue;
+    }
+
+    auto quantize = repr::nn::get<repr::NeuralNetOperator>(quantizeNode);
+    moveOpArg(ws, "Y_scale", quantize, op);
+    moveOpArg(ws, "Y_zero_point", quantize, op);
+
+    auto* opDef = getMutableOpDef(*op);
+    opDef->set_type(it->second);
+    opDef->set_engine("DNNLOWP");
+
+    for (int j = 0; j < inputs.size(); ++j) {
+      nn->dataFlow.replaceOutEdges(inputs[j], int8Inputs[j]);
+    }
+    nn->dataFlow.replaceInEdges(outputs.front(), int8Output);
+    for (auto node : deadNodes) {
+      nn->dataFlow.deleteNode(node);
+    }
+    return true;
+  }
+  return false;
+}
+
 bool fuseConvBNAndAffCh(repr::NNModule* nn, caffe2::Workspace* ws) {
   for (auto node_pair : repr::nn::dataIterator<repr::Conv>(nn->dataFlow)) {
     bool no_bias = false;
@@ -974,6 +1131,7 @@ void preConvertFiltersFormat(repr::NNModule* nn, caffe2::Workspace* ws) {
 using Fuser = bool (*)(repr::NNModule* nn, caffe2::Workspace* ws);
 static Fuser fusers[] = {
     removeStopGradientForInference,
+    fuseInt8Ops,
     fuseConvBNAndAffCh,
     fuseConvSum,
     fuseActivation,
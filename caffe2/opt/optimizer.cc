@@ -9,6 +9,11 @@ namespace opt {
 
 void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
   switch (level) {
+    case 2:
+      opt::fuseConvBN(nn, ws);
+      // after fuseConvBN, to fuse the activations of the folded Convs too
+      opt::fuseCPUOps(nn, ws);
+      break;
     case 1:
       opt::fuseConvBN(nn, ws);
     case 0:
@@ -19,6 +24,7 @@ void workspaceOptimizations(nom::repr::NNModule* nn, Workspace* ws, int level) {
 
 void graphOptimzations(nom::repr::NNModule* nn, int level) {
   switch (level) {
+    case 2:
     case 1:
 #ifdef USE_NNPACK 
       opt::addNNPACK(nn, false);
@@ -34,13 +40,19 @@ NetDef optimize(NetDef net, Workspace* ws, int level) {
   auto nn = convertToNNModule(net);
   graphOptimzations(&nn, level);
   workspaceOptimizations(&nn, ws, level);
-  return convertToCaffe2Proto(nn, net);
+  convertToCaffe2Proto(nn, &net);
+  return net;
 }
 
 NetDef optimize(NetDef net, int level) {
   auto nn = convertToNNModule(net);
   graphOptimzations(&nn, level);
-  return convertToCaffe2Proto(nn, net);
+  if (level >= 2) {
+    // without a workspace, the biases are not folded
+    opt::fuseCPUOps(&nn, nullptr);
+  }
+  convertToCaffe2Proto(nn, &net);
+  return net;
 }
 
 } // namespace opt
@@ -8,6 +8,8 @@
 namespace caffe2 {
 namespace opt {
 
+// Level 1 runs the default passes, level 2 also the fusions for the default
+// CPU operators of fuseCPUOps() in caffe2/opt/fusion.h.
 CAFFE2_API NetDef optimize(NetDef net, Workspace* ws, int level = 1);
 CAFFE2_API NetDef optimize(NetDef net, int level = 1);
 
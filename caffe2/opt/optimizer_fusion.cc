@@ -0,0 +1,259 @@
+#include "caffe2/opt/optimizer_fusion.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+namespace opt {
+
+namespace {
+
+struct FusionRule {
+  const char* type;
+  const char* fused_type;
+  int num_inputs;
+  int num_outputs;
+  // (input, output) pairs that have to be in place
+  std::vector<std::pair<int, int>> inplace;
+};
+
+const std::vector<FusionRule>& fusionRules() {
+  static const std::vector<FusionRule> rules = {
+      {"MomentumSGDUpdate",
+       "MultiTensorMomentumSGDUpdate",
+       4,
+       3,
+       {{0, 0}, {1, 1}, {3, 2}}},
+      {"Adam", "MultiTensorAdam", 6, 3, {{0, 0}, {1, 1}, {2, 2}}},
+      {"Lars", "MultiTensorLars", 5, 1, {}},
+  };
+  return rules;
+}
+
+const FusionRule* findRule(const OperatorDef& op) {
+  for (const auto& rule : fusionRules()) {
+    if (op.type() != rule.type || op.input_size() != rule.num_inputs ||
+        op.output_size() != rule.num_outputs) {
+      continue;
+    }
+    bool inplace = true;
+    for (const auto& io : rule.inplace) {
+      inplace = inplace && op.input(io.first) == op.output(io.second);
+    }
+    if (inplace && op.control_input_size() == 0) {
+      return &rule;
+    }
+  }
+  return nullptr;
+}
+
+// Ops with the same key can be fused.
+std::string fusionKey(const OperatorDef& op) {
+  std::vector<std::string> args;
+  for (const auto& arg : op.arg()) {
+    std::string serialized;
+    arg.SerializeToString(&serialized);
+    args.push_back(serialized);
+  }
+  std::sort(args.begin(), args.end());
+  std::string key = op.type() + '\0' + op.engine() + '\0';
+  if (op.has_device_option()) {
+    std::string device;
+    op.device_option().SerializeToString(&device);
+    key += device;
+  }
+  for (const auto& arg : args) {
+    key += '\0' + arg;
+  }
+  return key;
+}
+
+// A set of op indices.
+class OpSet {
+ public:
+  explicit OpSet(size_t size) : words_((size + 63) / 64, 0) {}
+
+  void insert(size_t i) {
+    words_[i / 64] |= uint64_t(1) << (i % 64);
+  }
+
+  bool contains(size_t i) const {
+    return words_[i / 64] & (uint64_t(1) << (i % 64));
+  }
+
+  void merge(const OpSet& other) {
+    for (size_t i = 0; i < words_.size(); ++i) {
+      words_[i] |= other.words_[i];
+    }
+  }
+
+ private:
+  std::vector<uint64_t> words_;
+};
+
+} // namespace
+
+NetDef fuseOptimizerOps(const NetDef& net) {
+  const int num_ops = net.op_size();
+
+  // The dependencies between the ops through their blobs: an op depends on
+  // the last writer of its inputs, and on the readers and the last writer of
+  // its outputs.
+  std::vector<std::vector<int>> successors(num_ops);
+  std::unordered_map<std::string, int> last_writer;
+  std::unordered_map<std::string, std::vector<int>> readers;
+  for (int i = 0; i < num_ops; ++i) {
+    const auto& op = net.op(i);
+    for (const auto& input : op.input()) {
+      auto it = last_writer.find(input);
+      if (it != last_writer.end()) {
+        successors[it->second].push_back(i);
+      }
+    }
+    for (const auto& output : op.output()) {
+      auto it = last_writer.find(output);
+      if (it != last_writer.end()) {
+        successors[it->second].push_back(i);
+      }
+      for (int reader : readers[output]) {
+        if (reader != i) {
+          successors[reader].push_back(i);
+        }
+      }
+      readers[output].clear();
+      last_writer[output] = i;
+    }
+    for (const auto& input : op.input()) {
+      if (std::find(op.output().begin(), op.output().end(), input) ==
+          op.output().end()) {
+        readers[input].push_back(i);
+      }
+    }
+  }
+
+  // The ops every op reaches through its successors, which come after it.
+  std::vector<OpSet> reachable(num_ops, OpSet(num_ops));
+  for (int i = num_ops - 1; i >= 0; --i) {
+    for (int successor : successors[i]) {
+      reachable[i].insert(successor);
+      reachable[i].merge(reachable[successor]);
+    }
+  }
+
+  // Groups of independent ops with the same key, first fit.
+  std::vector<std::vector<int>> groups;
+  std::map<std::string, std::vector<int>> groups_by_key;
+  std::vector<int> group_of(num_ops, -1);
+  for (int i = 0; i < num_ops; ++i) {
+    if (findRule(net.op(i)) == nullptr) {
+      continue;
+    }
+    auto& candidates = groups_by_key[fusionKey(net.op(i))];
+    for (int group : candidates) {
+      bool independent = true;
+      for (int member : groups[group]) {
+        independent = independent && !reachable[member].contains(i);
+      }
+      if (independent) {
+        group_of[i] = group;
+        groups[group].push_back(i);
+        break;
+      }
+    }
+    if (group_of[i] == -1) {
+      group_of[i] = groups.size();
+      candidates.push_back(groups.size());
+      groups.push_back({i});
+    }
+  }
+
+  // Every op is a node of the fused net, and the ops of a group share one.
+  std::vector<int> node_of(num_ops);
+  std::vector<int> first_op;
+  std::vector<int> group_node(groups.size(), -1);
+  for (int i = 0; i < num_ops; ++i) {
+    if (group_of[i] != -1 && group_node[group_of[i]] != -1) {
+      node_of[i] = group_node[group_of[i]];
+      continue;
+    }
+    node_of[i] = first_op.size();
+    if (group_of[i] != -1) {
+      group_node[group_of[i]] = first_op.size();
+    }
+    first_op.push_back(i);
+  }
+  const int num_nodes = first_op.size();
+  if (num_nodes == num_ops) {
+    return net;
+  }
+
+  std::vector<std::set<int>> node_successors(num_nodes);
+  std::vector<int> num_predecessors(num_nodes, 0);
+  for (int i = 0; i < num_ops; ++i) {
+    for (int successor : successors[i]) {
+      const int from = node_of[i];
+      const int to = node_of[successor];
+      if (from != to && node_successors[from].insert(to).second) {
+        ++num_predecessors[to];
+      }
+    }
+  }
+
+  // Topological order of the nodes, preferring the original order.
+  std::set<int> ready;
+  for (int node = 0; node < num_nodes; ++node) {
+    if (num_predecessors[node] == 0) {
+      ready.insert(node);
+    }
+  }
+  std::vector<int> order;
+  while (!ready.empty()) {
+    const int node = *ready.begin();
+    ready.erase(ready.begin());
+    order.push_back(node);
+    for (int successor : node_successors[node]) {
+      if (--num_predecessors[successor] == 0) {
+        ready.insert(successor);
+      }
+    }
+  }
+  if (int(order.size()) != num_nodes) {
+    LOG(WARNING) << "Not fusing the optimizer ops of net " << net.name()
+                 << ", as the fused ops would depend on each other";
+    return net;
+  }
+
+  NetDef fused_net = net;
+  fused_net.clear_op();
+  for (int node : order) {
+    const int i = first_op[node];
+    const auto& op = net.op(i);
+    if (group_of[i] == -1 || groups[group_of[i]].size() == 1) {
+      *fused_net.add_op() = op;
+      continue;
+    }
+    auto* fused = fused_net.add_op();
+    *fused = op;
+    fused->set_type(findRule(op)->fused_type);
+    fused->clear_input();
+    fused->clear_output();
+    for (int member : groups[group_of[i]]) {
+      for (const auto& input : net.op(member).input()) {
+        fused->add_input(input);
+      }
+      for (const auto& output : net.op(member).output()) {
+        fused->add_output(output);
+      }
+    }
+  }
+  return fused_net;
+}
+
+} // namespace opt
+} // namespace caffe2
@@ -0,0 +1,24 @@
+#ifndef CAFFE2_OPT_OPTIMIZER_FUSION_H_
+#define CAFFE2_OPT_OPTIMIZER_FUSION_H_
+
+#include "caffe2/core/common.h"
+#include "caffe2/proto/caffe2_pb.h"
+
+namespace caffe2 {
+namespace opt {
+
+// Replaces the per-parameter MomentumSGDUpdate, Adam and Lars ops of a
+// training net with their multi-tensor variants in caffe2/sgd, which update
+// many parameters in a few kernel launches on the GPU.
+//
+// Ops are fused if they have the same type, arguments, engine and device,
+// update their parameters in place, and neither depends on the other through
+// the blobs of the net. The ops are then reordered as little as the
+// dependencies of the fused ops allow. Nets in which fusing would create a
+// cycle between the fused ops are returned unchanged.
+CAFFE2_API NetDef fuseOptimizerOps(const NetDef& net);
+
+} // namespace opt
+} // namespace caffe2
+
+#endif // CAFFE2_OPT_OPTIMIZER_FUSION_H_
@@ -0,0 +1,123 @@
+#include "caffe2/core/common.h"
+#include "caffe2/core/test_utils.h"
+#include "caffe2/opt/optimizer_fusion.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+using namespace caffe2::testing;
+
+namespace {
+
+// Fills the blobs of a MomentumSGDUpdate of every parameter, and a shared
+// learning rate.
+void fillMomentumSGDBlobs(int num_params, caffe2::Workspace* ws) {
+  for (int i = 0; i < num_params; ++i) {
+    for (const auto& prefix : {"param", "grad", "momentum"}) {
+      auto* tensor = createTensor(prefix + c10::to_string(i), ws);
+      tensor->Resize(3 + i, 2);
+      randomFill(tensor->mutable_data<float>(), tensor->numel(), -1.0, 1.0);
+    }
+  }
+  fillTensor<float>({1}, {0.1f}, createTensor("lr", ws));
+  fillTensor<float>({1}, {0.0f}, createTensor("wd", ws));
+  fillTensor<float>({1}, {1.0f}, createTensor("trust", ws));
+  fillTensor<float>({1}, {10.0f}, createTensor("lr_max", ws));
+}
+
+// Adds the Lars, learning rate and MomentumSGDUpdate ops of parameter i.
+void addMomentumSGDOps(int i, NetMutator* mutator) {
+  const auto index = c10::to_string(i);
+  mutator
+      ->newOp(
+          "Lars",
+          {"param" + index, "grad" + index, "wd", "trust", "lr_max"},
+          {"lars" + index})
+      .addArgument("offset", 0.1f)
+      .newOp("Mul", {"lars" + index, "lr"}, {"lr" + index})
+      .addArgument("broadcast", 1)
+      .newOp(
+          "MomentumSGDUpdate",
+          {"grad" + index, "momentum" + index, "lr" + index, "param" + index},
+          {"grad" + index, "momentum" + index, "param" + index})
+      .addArgument("momentum", 0.9f);
+}
+
+caffe2::NetDef momentumSGDNet(int num_params) {
+  caffe2::NetDef net;
+  NetMutator mutator(&net);
+  for (int i = 0; i < num_params; ++i) {
+    addMomentumSGDOps(i, &mutator);
+  }
+  return net;
+}
+
+// Runs `net` before and after fuseOptimizerOps on the same blobs, and checks
+// that the parameters and momentums match.
+caffe2::NetDef fuseAndCompare(const caffe2::NetDef& net, int num_params) {
+  caffe2::Workspace ws;
+  fillMomentumSGDBlobs(num_params, &ws);
+  caffe2::Workspace fused_ws;
+  for (const auto& name : ws.Blobs()) {
+    createTensor(name, &fused_ws)->CopyFrom(getTensor(ws, name));
+  }
+
+  auto fused_net = caffe2::opt::fuseOptimizerOps(net);
+  CAFFE_ENFORCE(ws.RunNetOnce(net));
+  CAFFE_ENFORCE(fused_ws.RunNetOnce(fused_net));
+  for (int i = 0; i < num_params; ++i) {
+    for (const auto& prefix : {"param", "momentum"}) {
+      const auto name = prefix + c10::to_string(i);
+      const auto& expected = getTensor(ws, name);
+      const auto& actual = getTensor(fused_ws, name);
+      for (int64_t j = 0; j < actual.numel(); ++j) {
+        EXPECT_NEAR(
+            actual.data<float>()[j], expected.data<float>()[j], 1e-5);
+      }
+    }
+  }
+  return fused_net;
+}
+
+} // namespace
+
+TEST(FuseOptimizerOps, LarsMomentumSGD) {
+  const auto fused_net = fuseAndCompare(momentumSGDNet(3), 3);
+  // The Lars ops, the Muls of the learning rates, and the updates.
+  ASSERT_EQ(fused_net.op().size(), 5);
+  EXPECT_EQ(fused_net.op(0).type(), "MultiTensorLars");
+  EXPECT_EQ(fused_net.op(0).output_size(), 3);
+  for (int i = 1; i < 4; ++i) {
+    EXPECT_EQ(fused_net.op(i).type(), "Mul");
+  }
+  EXPECT_EQ(fused_net.op(4).type(), "MultiTensorMomentumSGDUpdate");
+  EXPECT_EQ(fused_net.op(4).input_size(), 12);
+  EXPECT_EQ(fused_net.op(4).output_size(), 9);
+}
+
+TEST(FuseOptimizerOps, KeepsDependentUpdates) {
+  // The learning rate of the second parameter is computed from the updated
+  // first parameter, and the updates can't be fused.
+  caffe2::NetDef net;
+  NetMutator mutator(&net);
+  addMomentumSGDOps(0, &mutator);
+  mutator.newOp("SumElements", {"param0"}, {"lr"}).addArgument("average", 1);
+  addMomentumSGDOps(1, &mutator);
+
+  const auto fused_net = fuseAndCompare(net, 2);
+  int updates = 0;
+  for (const auto& op : fused_net.op()) {
+    EXPECT_NE(op.type(), "MultiTensorMomentumSGDUpdate");
+    updates += op.type() == "MomentumSGDUpdate";
+  }
+  EXPECT_EQ(updates, 2);
+}
+
+TEST(FuseOptimizerOps, KeepsDifferentArguments) {
+  auto net = momentumSGDNet(2);
+  net.mutable_op(5)->mutable_arg(0)->set_f(0.5f);
+  const auto fused_net = fuseAndCompare(net, 2);
+  for (const auto& op : fused_net.op()) {
+    EXPECT_NE(op.type(), "MultiTensorMomentumSGDUpdate");
+  }
+}
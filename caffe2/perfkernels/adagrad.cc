@@ -71,7 +71,30 @@ void rowwise_adagrad_update__base(
   internal::rowwise_adagrad_update_inlined(N, w, w_n, g, h, h_n, epsilon, lr);
 }
 
+void rowwise_adagrad_bf16_update__base(
+    int N,
+    at::BFloat16* w,
+    at::BFloat16* /* w_n */, // prefetch ptr
+    const float* g,
+    float* h,
+    float* /* h_n */, // prefetch ptr
+    float epsilon,
+    float lr) {
+  float final_sum = 0.0f;
+  for (auto i = 0; i < N; ++i) {
+    final_sum += g[i] * g[i];
+  }
+  final_sum /= N;
+
+  float hi = *h = *h + final_sum;
+  float float_step = lr / (std::sqrt(hi) + epsilon);
+  for (auto i = 0; i < N; ++i) {
+    w[i] = static_cast<float>(w[i]) + g[i] * float_step;
+  }
+}
+
 // version without prefetching
+decltype(adagrad_update__base) adagrad_update__avx512;
 decltype(adagrad_update__base) adagrad_update__avx_f16c;
 void adagrad_update(
     int N,
@@ -83,10 +106,12 @@ void adagrad_update(
     float epsilon,
     float decay,
     float lr) {
+  AVX512_DO(adagrad_update, N, w, g, h, nw, nh, epsilon, decay, lr);
   AVX_F16C_DO(adagrad_update, N, w, g, h, nw, nh, epsilon, decay, lr);
   BASE_DO(adagrad_update, N, w, g, h, nw, nh, epsilon, decay, lr);
 }
 
+decltype(adagrad_update_prefetch__base) adagrad_update_prefetch__avx512;
 decltype(adagrad_update_prefetch__base) adagrad_update_prefetch__avx_f16c;
 void adagrad_update_prefetch(
     int N,
@@ -106,6 +131,20 @@ void adagrad_update_prefetch(
 
     float epsilon,
     float lr) {
+  AVX512_DO(
+      adagrad_update_prefetch,
+      N,
+      w,
+      w_n,
+      g,
+      h,
+      h_n,
+      nw,
+      nw_n,
+      nh,
+      nh_n,
+      epsilon,
+      lr);
   AVX_F16C_DO(
       adagrad_update_prefetch,
       N,
@@ -183,6 +222,7 @@ void adagrad_fp16_update_prefetch(
       lr);
 }
 
+decltype(rowwise_adagrad_update__base) rowwise_adagrad_update__avx512;
 decltype(rowwise_adagrad_update__base) rowwise_adagrad_update__avx_f16c;
 void rowwise_adagrad_update(
     int N,
@@ -196,12 +236,29 @@ void rowwise_adagrad_update(
 
     float epsilon,
     float lr) {
+  AVX512_DO(rowwise_adagrad_update, N, w, w_n, g, h, h_n, epsilon, lr);
   AVX_F16C_DO(rowwise_adagrad_update, N, w, w_n, g, h, h_n, epsilon, lr);
   BASE_DO(rowwise_adagrad_update, N, w, w_n, g, h, h_n, epsilon, lr);
 }
 
+// Version with prefetching for embeddings stored as bfloat16
+decltype(rowwise_adagrad_bf16_update__base) rowwise_adagrad_bf16_update__avx512;
+void rowwise_adagrad_bf16_update(
+    int N,
+    at::BFloat16* w,
+    at::BFloat16* w_n, // prefetch ptr
+    const float* g,
+    float* h,
+    float* h_n, // prefetch ptr
+    float epsilon,
+    float lr) {
+  AVX512_DO(rowwise_adagrad_bf16_update, N, w, w_n, g, h, h_n, epsilon, lr);
+  BASE_DO(rowwise_adagrad_bf16_update, N, w, w_n, g, h, h_n, epsilon, lr);
+}
+
 SPARSE_ADAGRAD_SPECIALIZATION(int32_t, base);
 
+decltype(sparse_adagrad_int32_t__base) sparse_adagrad_int32_t__avx512;
 decltype(sparse_adagrad_int32_t__base) sparse_adagrad_int32_t__avx_f16c;
 template <>
 int sparse_adagrad(
@@ -216,6 +273,19 @@ int sparse_adagrad(
     float* nh,
     float epsilon,
     float lr) {
+  AVX512_DO(
+      sparse_adagrad_int32_t,
+      num_rows,
+      block_size,
+      param_size,
+      w,
+      g,
+      h,
+      indices,
+      nw,
+      nh,
+      epsilon,
+      lr);
   AVX_F16C_DO(
       sparse_adagrad_int32_t,
       num_rows,
@@ -246,6 +316,7 @@ int sparse_adagrad(
 
 SPARSE_ADAGRAD_SPECIALIZATION(int64_t, base);
 
+decltype(sparse_adagrad_int64_t__base) sparse_adagrad_int64_t__avx512;
 decltype(sparse_adagrad_int64_t__base) sparse_adagrad_int64_t__avx_f16c;
 template <>
 int sparse_adagrad(
@@ -260,6 +331,19 @@ int sparse_adagrad(
     float* nh,
     float epsilon,
     float lr) {
+  AVX512_DO(
+      sparse_adagrad_int64_t,
+      num_rows,
+      block_size,
+      param_size,
+      w,
+      g,
+      h,
+      indices,
+      nw,
+      nh,
+      epsilon,
+      lr);
   AVX_F16C_DO(
       sparse_adagrad_int64_t,
       num_rows,
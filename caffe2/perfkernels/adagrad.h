@@ -5,6 +5,7 @@
 #define CAFFE2_PERFKERNELS_ADAGRAD_H_USE_INTRINSIC
 #include <immintrin.h>
 #endif
+#include <c10/util/BFloat16.h>
 #include <c10/util/Half.h>
 
 namespace caffe2 {
@@ -245,6 +246,21 @@ void rowwise_adagrad_update(
     float epsilon,
     float lr);
 
+// Version with prefetching for embeddings stored as bfloat16, the moments are
+// float. The updated weights are rounded to the nearest bfloat16.
+void rowwise_adagrad_bf16_update(
+    int N,
+    at::BFloat16* w,
+    at::BFloat16* w_n, // prefetch ptr
+
+    const float* g,
+
+    float* h,
+    float* h_n, // prefetch ptr
+
+    float epsilon,
+    float lr);
+
 // version without prefetching
 void adagrad_update(
     int N,
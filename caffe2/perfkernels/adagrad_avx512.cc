@@ -0,0 +1,222 @@
+#include "caffe2/perfkernels/adagrad.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <immintrin.h>
+
+namespace caffe2 {
+
+namespace {
+
+// Scalar bfloat16 conversions for the leftovers. Deliberately not the inline
+// functions of c10/util/BFloat16.h, see perfkernels/common.h.
+inline float bf16_to_float(at::BFloat16 x) {
+  uint32_t bits = static_cast<uint32_t>(x.x) << 16;
+  float result;
+  std::memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+inline at::BFloat16 float_to_bf16(float x) {
+  at::BFloat16 result;
+  if (std::isnan(x)) {
+    result.x = 0x7FC0;
+    return result;
+  }
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  // round to nearest, ties to even
+  bits += 0x7FFF + ((bits >> 16) & 1);
+  result.x = static_cast<uint16_t>(bits >> 16);
+  return result;
+}
+
+inline __m512 load_bf16(const at::BFloat16* p) {
+  return _mm512_castsi512_ps(_mm512_slli_epi32(
+      _mm512_cvtepu16_epi32(
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))),
+      16));
+}
+
+inline void store_bf16(at::BFloat16* p, __m512 v) {
+  __m512i bits = _mm512_castps_si512(v);
+  __m512i lsb =
+      _mm512_and_si512(_mm512_srli_epi32(bits, 16), _mm512_set1_epi32(1));
+  __m512i rounded =
+      _mm512_add_epi32(bits, _mm512_add_epi32(lsb, _mm512_set1_epi32(0x7FFF)));
+  // NaNs stay quiet NaNs instead of rounding over to infinity
+  __mmask16 ordered = _mm512_cmp_ps_mask(v, v, _CMP_ORD_Q);
+  rounded = _mm512_mask_blend_epi32(
+      ordered, _mm512_set1_epi32(0x7FC00000), rounded);
+  _mm256_storeu_si256(
+      reinterpret_cast<__m256i*>(p),
+      _mm512_cvtepi32_epi16(_mm512_srli_epi32(rounded, 16)));
+}
+
+} // namespace
+
+// version without prefetching
+void adagrad_update__avx512(
+    int N,
+    const float* w,
+    const float* g,
+    const float* h,
+    float* nw,
+    float* nh,
+    float epsilon,
+    float decay,
+    float lr) {
+  constexpr int kSize = 16;
+  auto i = 0;
+  for (; i + kSize <= N; i += kSize) {
+    __m512 gi = _mm512_loadu_ps(g + i);
+    __m512 hi = _mm512_loadu_ps(h + i);
+    __m512 wi = _mm512_loadu_ps(w + i);
+
+    __m512 nhi =
+        _mm512_fmadd_ps(_mm512_set1_ps(decay), hi, _mm512_mul_ps(gi, gi));
+    _mm512_storeu_ps(nh + i, nhi);
+    __m512 vtmp = _mm512_div_ps(
+        gi, _mm512_add_ps(_mm512_sqrt_ps(nhi), _mm512_set1_ps(epsilon)));
+    _mm512_storeu_ps(nw + i, _mm512_fmadd_ps(_mm512_set1_ps(lr), vtmp, wi));
+  }
+
+  for (; i < N; ++i) {
+    float gi = g[i];
+    float hi = nh[i] = decay * h[i] + gi * gi;
+    nw[i] = w[i] + lr * gi / (std::sqrt(hi) + epsilon);
+  }
+}
+
+void adagrad_update_prefetch__avx512(
+    int N,
+    const float* w,
+    const float* w_n, // prefetch ptr
+
+    const float* g,
+
+    const float* h,
+    const float* h_n, // prefetch ptr
+
+    float* nw,
+    float* nw_n, // prefetch ptr
+
+    float* nh,
+    float* nh_n, // prefetch ptr
+
+    float epsilon,
+    float lr) {
+  constexpr int kSize = 16;
+  auto i = 0;
+  for (; i + kSize <= N; i += kSize) {
+    _mm_prefetch(reinterpret_cast<const char*>(&w_n[i]), _MM_HINT_T0);
+    _mm_prefetch(reinterpret_cast<const char*>(&h_n[i]), _MM_HINT_T0);
+    _mm_prefetch(reinterpret_cast<const char*>(&nw_n[i]), _MM_HINT_T0);
+    _mm_prefetch(reinterpret_cast<const char*>(&nh_n[i]), _MM_HINT_T0);
+
+    __m512 gi = _mm512_loadu_ps(g + i);
+    __m512 hi = _mm512_loadu_ps(h + i);
+    __m512 wi = _mm512_loadu_ps(w + i);
+
+    __m512 nhi = _mm512_fmadd_ps(gi, gi, hi);
+    _mm512_storeu_ps(nh + i, nhi);
+    __m512 vtmp = _mm512_div_ps(
+        gi, _mm512_add_ps(_mm512_sqrt_ps(nhi), _mm512_set1_ps(epsilon)));
+    _mm512_storeu_ps(nw + i, _mm512_fmadd_ps(_mm512_set1_ps(lr), vtmp, wi));
+  }
+
+  internal::adagrad_update_base_inlined(
+      N - i, w + i, g + i, h + i, nw + i, nh + i, 1.0f, epsilon, lr);
+}
+
+void rowwise_adagrad_update__avx512(
+    int N,
+    float* w,
+    float* w_n, // prefetch ptr
+
+    const float* g,
+
+    float* h,
+    float* h_n, // prefetch ptr
+
+    float epsilon,
+    float lr) {
+  constexpr int kSize = 16;
+  auto i = 0;
+  _mm_prefetch(reinterpret_cast<const char*>(h_n), _MM_HINT_T0);
+  __m512 partial_sum = _mm512_setzero_ps();
+  for (; i + kSize <= N; i += kSize) {
+    __m512 gi = _mm512_loadu_ps(g + i);
+    partial_sum = _mm512_fmadd_ps(gi, gi, partial_sum);
+  }
+  float final_sum = _mm512_reduce_add_ps(partial_sum);
+  for (; i < N; ++i) {
+    final_sum += g[i] * g[i];
+  }
+  final_sum /= N;
+
+  float hi = *h = *h + final_sum;
+  float float_step = lr / (std::sqrt(hi) + epsilon);
+
+  __m512 step = _mm512_set1_ps(float_step);
+  for (i = 0; i + kSize <= N; i += kSize) {
+    _mm_prefetch(reinterpret_cast<const char*>(&w_n[i]), _MM_HINT_T0);
+
+    __m512 gi = _mm512_loadu_ps(g + i);
+    __m512 wi = _mm512_loadu_ps(w + i);
+
+    _mm512_storeu_ps(w + i, _mm512_fmadd_ps(gi, step, wi));
+  }
+
+  for (; i < N; ++i) {
+    float gi = g[i];
+    w[i] = w[i] + gi * float_step;
+  }
+}
+
+void rowwise_adagrad_bf16_update__avx512(
+    int N,
+    at::BFloat16* w,
+    at::BFloat16* w_n, // prefetch ptr
+    const float* g,
+    float* h,
+    float* h_n, // prefetch ptr
+    float epsilon,
+    float lr) {
+  constexpr int kSize = 16;
+  auto i = 0;
+  _mm_prefetch(reinterpret_cast<const char*>(h_n), _MM_HINT_T0);
+  __m512 partial_sum = _mm512_setzero_ps();
+  for (; i + kSize <= N; i += kSize) {
+    __m512 gi = _mm512_loadu_ps(g + i);
+    partial_sum = _mm512_fmadd_ps(gi, gi, partial_sum);
+  }
+  float final_sum = _mm512_reduce_add_ps(partial_sum);
+  for (; i < N; ++i) {
+    final_sum += g[i] * g[i];
+  }
+  final_sum /= N;
+
+  float hi = *h = *h + final_sum;
+  float float_step = lr / (std::sqrt(hi) + epsilon);
+
+  __m512 step = _mm512_set1_ps(float_step);
+  for (i = 0; i + kSize <= N; i += kSize) {
+    _mm_prefetch(reinterpret_cast<const char*>(&w_n[i]), _MM_HINT_T0);
+
+    __m512 gi = _mm512_loadu_ps(g + i);
+    __m512 wi = load_bf16(w + i);
+
+    store_bf16(w + i, _mm512_fmadd_ps(gi, step, wi));
+  }
+
+  for (; i < N; ++i) {
+    w[i] = float_to_bf16(bf16_to_float(w[i]) + g[i] * float_step);
+  }
+}
+
+SPARSE_ADAGRAD_SPECIALIZATION(int32_t, avx512);
+SPARSE_ADAGRAD_SPECIALIZATION(int64_t, avx512);
+
+} // namespace caffe2
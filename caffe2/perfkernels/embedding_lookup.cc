@@ -105,6 +105,9 @@ static bool EmbeddingLookupGenericSlow(
   decltype(                                                                                        \
       EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL##__base)     \
       EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL##__avx2_fma; \
+  decltype(                                                                                        \
+      EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL##__base)     \
+      EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL##__avx512;   \
   bool                                                                                             \
       EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL(             \
           const int64_t block_size,                                                                \
@@ -123,6 +126,19 @@ static bool EmbeddingLookupGenericSlow(
     } else {                                                                                       \
       CAFFE_ENFORCE(scale_bias == nullptr, "scale_bias must be nullptr");                          \
     }                                                                                              \
+    AVX512_DO(                                                                                     \
+        EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL,           \
+        block_size,                                                                                \
+        output_size,                                                                               \
+        index_size,                                                                                \
+        data_size,                                                                                 \
+        input,                                                                                     \
+        indices,                                                                                   \
+        lengths,                                                                                   \
+        weights,                                                                                   \
+        scale_bias,                                                                                \
+        normalize_by_lengths,                                                                      \
+        out);                                                                                      \
     AVX2_FMA_DO(                                                                                   \
         EmbeddingLookup_##IndexType##_##InTypeName##_##OutType##_##IS_WEIGHT_POSITIONAL,           \
         block_size,                                                                                \
@@ -208,6 +224,8 @@ EMBEDDING_SPECIALIZATION(int32_t, half, at::Half, float, false);
 EMBEDDING_SPECIALIZATION(int64_t, half, at::Half, float, false);
 EMBEDDING_SPECIALIZATION(int32_t, uint8_t, uint8_t, float, false);
 EMBEDDING_SPECIALIZATION(int64_t, uint8_t, uint8_t, float, false);
+EMBEDDING_SPECIALIZATION(int32_t, bfloat16, at::BFloat16, float, false);
+EMBEDDING_SPECIALIZATION(int64_t, bfloat16, at::BFloat16, float, false);
 
 EMBEDDING_SPECIALIZATION(int32_t, float, float, float, true);
 EMBEDDING_SPECIALIZATION(int64_t, float, float, float, true);
@@ -215,6 +233,8 @@ EMBEDDING_SPECIALIZATION(int32_t, half, at::Half, float, true);
 EMBEDDING_SPECIALIZATION(int64_t, half, at::Half, float, true);
 EMBEDDING_SPECIALIZATION(int32_t, uint8_t, uint8_t, float, true);
 EMBEDDING_SPECIALIZATION(int64_t, uint8_t, uint8_t, float, true);
+EMBEDDING_SPECIALIZATION(int32_t, bfloat16, at::BFloat16, float, true);
+EMBEDDING_SPECIALIZATION(int64_t, bfloat16, at::BFloat16, float, true);
 
 #undef EMBEDDING_SPECIALIZATION
 
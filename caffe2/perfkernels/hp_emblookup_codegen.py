@@ -4,14 +4,72 @@ import argparse
 import sys
 
 
-sizeof = {"float": 4, "at::Half": 2, "uint8_t": 1}
+sizeof = {"float": 4, "at::Half": 2, "at::BFloat16": 2, "uint8_t": 1}
+
+# vector register and intrinsic prefix of each ISA, and the suffix of the
+# generated kernels dispatched to by perfkernels/common.h
+isas = {
+    "avx2": {"width": 8, "reg": "__m256", "mm": "_mm256", "suffix": "__avx2_fma"},
+    "avx512": {"width": 16, "reg": "__m512", "mm": "_mm512", "suffix": "__avx512"},
+}
+
+
+def bf16_to_ps(isa, addr, indent):
+    # bfloat16 is the upper half of a float, widen and shift into place
+    if isa == "avx2":
+        return (
+            "_mm256_castsi256_ps(_mm256_slli_epi32(\n"
+            + indent + "    _mm256_cvtepu16_epi32(_mm_loadu_si128(\n"
+            + indent + "        reinterpret_cast<const __m128i*>(" + addr + "))),\n"
+            + indent + "    16))"
+        )
+    return (
+        "_mm512_castsi512_ps(_mm512_slli_epi32(\n"
+        + indent + "    _mm512_cvtepu16_epi32(_mm256_loadu_si256(\n"
+        + indent + "        reinterpret_cast<const __m256i*>(" + addr + "))),\n"
+        + indent + "    16))"
+    )
 
 
 def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
     def compute(regid, InType, use_weights, isa, prefetch):
         code = []
 
-        if InType == "float":
+        if InType == "at::BFloat16":
+            code.append(
+                "        vop%d = %s_fmadd_ps(\n"
+                "            vwgt,\n"
+                "            %s,\n"
+                "            vop%d);"
+                % (
+                    regid,
+                    isas[isa]["mm"],
+                    bf16_to_ps(isa, "ip + (%d)" % regid, "            "),
+                    regid,
+                )
+            )
+        elif isa == "avx512" and InType == "float":
+            code.append(
+                "        vop%d = _mm512_fmadd_ps(vwgt, _mm512_loadu_ps(ip + (%d)), vop%d);"  # noqa
+                % (regid, regid, regid)
+            )
+        elif isa == "avx512" and InType == "at::Half":
+            code.append(
+                "        vop%d = _mm512_fmadd_ps(\n"
+                "            vwgt,\n"
+                "            _mm512_cvtph_ps(\n"
+                "                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(ip + (%d)))),\n"  # noqa
+                "            vop%d);" % (regid, regid, regid)
+            )
+        elif isa == "avx512" and InType == "uint8_t":
+            code.append(
+                "        vop%d = _mm512_fmadd_ps(\n"
+                "            vwgt,\n"
+                "            _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(\n"
+                "                _mm_loadu_si128(reinterpret_cast<const __m128i*>(ip + (%d))))),\n"  # noqa
+                "            _mm512_add_ps(vop%d, vbio));" % (regid, regid, regid)
+            )
+        elif InType == "float":
             code.append(
                 "        vop%d = _mm256_fmadd_ps(vwgt, _mm256_loadu_ps(ip + (%d)), vop%d);"  # noqa
                 % (regid, regid, regid)
@@ -48,6 +106,10 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
 
         return code
 
+    width = isas[isa]["width"]
+    reg = isas[isa]["reg"]
+    mm = isas[isa]["mm"]
+
     code = []
     code.append("    // unrolling " + str(uf) + " times")
     code.append(
@@ -57,8 +119,8 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
     )
     code.append("      " + OutType + "* op = &out[rangeIndex * block_size];")
     for i in range(0, uf):
-        j = 8 * i
-        code.append("      __m256 vop" + str(j) + " = _mm256_setzero_ps();")
+        j = width * i
+        code.append("      " + reg + " vop" + str(j) + " = " + mm + "_setzero_ps();")
 
     # inner loop
     if use_offsets:
@@ -113,7 +175,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
         else:
             code.append("        bio = wgt * scale_bias[2 * idx + 1];")
             code.append("        wgt = wgt * scale_bias[2 * idx];")
-        code.append("        __m256 vbio = _mm256_set1_ps(bio);")
+        code.append("        " + reg + " vbio = " + mm + "_set1_ps(bio);")
     else:
         code.append("        " + OutType + " wgt = 1.f;")
         code.append("        if (weights) {")
@@ -121,7 +183,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
             "          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];"  # noqa
         )
         code.append("        }")
-    code.append("        __m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append("        " + reg + " vwgt = " + mm + "_set1_ps(wgt);")
 
     code.append("        const {}* ip = &input[idx * fused_block_size];".format(InType))
     code.append(
@@ -143,7 +205,7 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
     )
 
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         cachelinesize = 64
         byteoffset = sizeof[InType] * j
         prefetch = (byteoffset % cachelinesize) == 0
@@ -155,20 +217,20 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
     else:
         code.append("      if (!normalize_by_lengths || lengths[rangeIndex] == 0) {")
     for i in range(0, uf):
-        j = 8 * i
-        code.append("        _mm256_storeu_ps(&op[" + str(j) + "], vop" + str(j) + ");")
+        j = width * i
+        code.append("        " + mm + "_storeu_ps(&op[" + str(j) + "], vop" + str(j) + ");")
     code.append("      } else {")
     # inv of length
     if use_offsets:
-        code.append("        __m256 vlen_inv = _mm256_set1_ps(1.0f / length);")
+        code.append("        " + reg + " vlen_inv = " + mm + "_set1_ps(1.0f / length);")
     else:
-        code.append("        __m256 vlen_inv = _mm256_set1_ps(1.0f / lengths[rangeIndex]);")
+        code.append("        " + reg + " vlen_inv = " + mm + "_set1_ps(1.0f / lengths[rangeIndex]);")
     for i in range(0, uf):
-        j = 8 * i
+        j = width * i
         code.append(
-            "        _mm256_storeu_ps(&op["
+            "        " + mm + "_storeu_ps(&op["
             + str(j)
-            + "], _mm256_mul_ps("
+            + "], " + mm + "_mul_ps("
             + "vop"
             + str(j)
             + ", vlen_inv));"
@@ -182,7 +244,49 @@ def unroll(uf, IndexType, InType, OutType, use_weights, isa, fused, use_offsets)
 def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
     def compute(InType, use_weights, isa):
         code = []
-        if InType == "float":
+        if InType == "at::BFloat16":
+            code.append(
+                "          %s_storeu_ps(\n"
+                "              &op[j],\n"
+                "              %s_fmadd_ps(\n"
+                "                  vwgt,\n"
+                "                  %s,\n"
+                "                  %s_loadu_ps(&op[j])));"
+                % (
+                    isas[isa]["mm"],
+                    isas[isa]["mm"],
+                    bf16_to_ps(isa, "&ip[j]", "                  "),
+                    isas[isa]["mm"],
+                )
+            )
+        elif isa == "avx512" and InType == "float":
+            code.append(
+                "          _mm512_storeu_ps(\n"
+                "              &op[j],\n"
+                "              _mm512_fmadd_ps(\n"
+                "                  vwgt, _mm512_loadu_ps(&ip[j]), _mm512_loadu_ps(&op[j])));"  # noqa
+            )
+        elif isa == "avx512" and InType == "at::Half":
+            code.append(
+                "          _mm512_storeu_ps(\n"
+                "              &op[j],\n"
+                "              _mm512_fmadd_ps(\n"
+                "                  vwgt,\n"
+                "                  _mm512_cvtph_ps(_mm256_loadu_si256(\n"
+                "                      reinterpret_cast<const __m256i*>(&ip[j]))),\n"
+                "                  _mm512_loadu_ps(&op[j])));"
+            )
+        elif isa == "avx512" and InType == "uint8_t":
+            code.append(
+                "          _mm512_storeu_ps(\n"
+                "              &op[j],\n"
+                "              _mm512_fmadd_ps(\n"
+                "                  vwgt,\n"
+                "                  _mm512_cvtepi32_ps(_mm512_cvtepu8_epi32(_mm_loadu_si128(\n"  # noqa
+                "                      reinterpret_cast<const __m128i*>(&ip[j])))),\n"
+                "                  _mm512_add_ps(_mm512_loadu_ps(&op[j]), vbio)));"
+            )
+        elif InType == "float":
             code.append(
                 "          _mm256_storeu_ps(\n"
                 "              &op[j],\n"
@@ -219,6 +323,10 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
 
         return code
 
+    width = isas[isa]["width"]
+    reg = isas[isa]["reg"]
+    mm = isas[isa]["mm"]
+
     code = []
     if InType == "at::Half":
         code.append("    alignas(64) at::Half vtmp1[8] = {0};")
@@ -231,8 +339,8 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
 
     # initialize to 0
     code.append("      int64_t j = 0;")
-    code.append("      for (; j + 8 <= block_size; j += 8) {")
-    code.append("        _mm256_storeu_ps(op + j, _mm256_setzero_ps());")
+    code.append("      for (; j + %d <= block_size; j += %d) {" % (width, width))
+    code.append("        " + mm + "_storeu_ps(op + j, " + mm + "_setzero_ps());")
     code.append("      }")
     code.append("      for (; j < block_size; j++) {")
     code.append("        op[j] = 0.0f;")
@@ -291,7 +399,7 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
         else:
             code.append("        bio = wgt * scale_bias[2 * idx + 1];")
             code.append("        wgt = wgt * scale_bias[2 * idx];")
-        code.append("        __m256 vbio = _mm256_set1_ps(bio);")
+        code.append("        " + reg + " vbio = " + mm + "_set1_ps(bio);")
     else:
         code.append("        " + OutType + " wgt = 1.f;")
         code.append("        if (weights) {")
@@ -299,7 +407,7 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
             "          wgt = weights[IS_WEIGHT_POSITIONAL ? (dataInd - start) : dataInd];"  # noqa
         )
         code.append("        }")
-    code.append("        __m256 vwgt = _mm256_set1_ps(wgt);")
+    code.append("        " + reg + " vwgt = " + mm + "_set1_ps(wgt);")
 
     code.append("        const {}* ip = &input[idx * fused_block_size];".format(InType))
     code.append(
@@ -321,7 +429,7 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
 
     # compute and store main loop
     code.append("        j = 0;")
-    code.append("        for (; j + 8 <= block_size; j += 8) {")
+    code.append("        for (; j + %d <= block_size; j += %d) {" % (width, width))
     code.extend(compute(InType, use_weights, isa))
     code.append("        }")
     # leftover
@@ -335,6 +443,14 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
             "              _mm256_cvtph_ps(*(reinterpret_cast<const __m128i*>(vtmp1)));"
         )
         code.append("          op[j] = std::fma(wgt, ((float*)(&vtmp2))[0], op[j]);")
+    elif InType == "at::BFloat16":
+        code.append(
+            "          op[j] = std::fma(\n"
+            "              wgt,\n"
+            "              _mm_cvtss_f32(_mm_castsi128_ps(\n"
+            "                  _mm_slli_epi32(_mm_cvtsi32_si128(ip[j].x), 16))),\n"
+            "              op[j]);"
+        )
     elif InType == "uint8_t":
         code.append("          op[j] = std::fma(wgt, (float)ip[j], bio + op[j]);")
     else:
@@ -350,12 +466,12 @@ def generic(IndexType, InType, OutType, use_weights, isa, fused, use_offsets):
     else:
         code.append("      if (normalize_by_lengths && lengths[rangeIndex]) {")
         code.append("        float len_inv = 1.0f / lengths[rangeIndex];")
-    code.append("        __m256 vlen_inv = _mm256_set1_ps(len_inv);")
+    code.append("        " + reg + " vlen_inv = " + mm + "_set1_ps(len_inv);")
     code.append("        j = 0;")
-    code.append("        for (; j + 8 <= block_size; j += 8) {")
+    code.append("        for (; j + %d <= block_size; j += %d) {" % (width, width))
     code.append(
-        "          _mm256_storeu_ps(\n"
-        "              &op[j], _mm256_mul_ps(_mm256_loadu_ps(&op[j]), vlen_inv));"
+        "          " + mm + "_storeu_ps(\n"
+        "              &op[j], " + mm + "_mul_ps(" + mm + "_loadu_ps(&op[j]), vlen_inv));"
     )
     code.append("        }")
     code.append("        for (; j < block_size; j++) {")
@@ -373,19 +489,16 @@ parser = argparse.ArgumentParser()
 parser.add_argument("-f", "--filename", help="file name")
 parser.add_argument("--fused", action="store_true")
 parser.add_argument("--use-offsets", action="store_true")
+parser.add_argument("--isa", choices=sorted(isas.keys()), default="avx2")
 opts = parser.parse_args()
 if opts.filename:
     filename = opts.filename
-elif opts.fused:
-    if opts.use_offsets:
-        filename = "embedding_lookup_fused_8bit_rowwise_idx_avx2.cc"
-    else:
-        filename = "embedding_lookup_fused_8bit_rowwise_avx2.cc"
 else:
-    if opts.use_offsets:
-        filename = "embedding_lookup_idx_avx2.cc"
-    else:
-        filename = "embedding_lookup_avx2.cc"
+    filename = "embedding_lookup{}{}_{}.cc".format(
+        "_fused_8bit_rowwise" if opts.fused else "",
+        "_idx" if opts.use_offsets else "",
+        opts.isa,
+    )
 
 options = [
     ["int32_t", "int", "float", "float", "float", "float"],
@@ -395,6 +508,11 @@ options = [
     ["int32_t", "int", "uint8_t", "uint8_t", "float", "float"],
     ["int64_t", "int64_t", "uint8_t", "uint8_t", "float", "float"],
 ]
+if not opts.fused:
+    options += [
+        ["int32_t", "int", "bfloat16", "at::BFloat16", "float", "float"],
+        ["int64_t", "int64_t", "bfloat16", "at::BFloat16", "float", "float"],
+    ]
 
 code = []
 # includes
@@ -405,6 +523,8 @@ code.append("//// BY {}".format(sys.argv[0]))
 code.append("//// DO NOT MODIFY!!!")
 code.append("//// --------------------------\n")
 
+if not opts.fused:
+    code.append("#include <c10/util/BFloat16.h>")
 code.append("#include <c10/util/Half.h>")
 code.append("#include <immintrin.h>")
 
@@ -422,7 +542,7 @@ for o in options:
         fn_base = "{}EmbeddingLookup_{}_{}_{}".format(
             prefix, IndexTypeName, InTypeName, OutTypeName
         )
-    suffix = "__avx2_fma"
+    suffix = isas[opts.isa]["suffix"]
     fn = "static bool " + fn_base + suffix
     code.append(fn + "(")
 
@@ -458,17 +578,24 @@ for o in options:
 
     # code.append("printf(\"calling " + fn + "\\n\");");
 
-    code.append("  if (block_size == 128) {")
-    code += unroll(16, IndexType, InType, OutType, True, "AVX2", opts.fused, opts.use_offsets)
-    code.append("  } else if (block_size == 64) {")
-    code += unroll(8, IndexType, InType, OutType, True, "AVX2", opts.fused, opts.use_offsets)
-    code.append("  } else if (block_size == 32) {")
-    code += unroll(4, IndexType, InType, OutType, True, "AVX2", opts.fused, opts.use_offsets)
-    code.append("  } else if (block_size == 16) {")
-    code += unroll(2, IndexType, InType, OutType, True, "AVX2", opts.fused, opts.use_offsets)
+    width = isas[opts.isa]["width"]
+    for i, block_size in enumerate([128, 64, 32, 16]):
+        code.append(
+            "  {}if (block_size == {}) {{".format("" if i == 0 else "} else ", block_size)
+        )
+        code += unroll(
+            block_size // width,
+            IndexType,
+            InType,
+            OutType,
+            True,
+            opts.isa,
+            opts.fused,
+            opts.use_offsets,
+        )
     code.append("  } else {")
     code.append("    // generic code")
-    code += generic(IndexType, InType, OutType, True, "AVX2", opts.fused, opts.use_offsets)
+    code += generic(IndexType, InType, OutType, True, opts.isa, opts.fused, opts.use_offsets)
     code.append("  }")
     code.append("  return dataInd == index_size;")
 
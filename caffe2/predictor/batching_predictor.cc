@@ -0,0 +1,268 @@
+#include "caffe2/predictor/batching_predictor.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace caffe2 {
+
+namespace {
+
+int64_t itemsPerExample(at::IntArrayRef dims) {
+  int64_t items = 1;
+  for (size_t d = 1; d < dims.size(); ++d) {
+    items *= dims[d];
+  }
+  return items;
+}
+
+void copyItems(const TypeMeta& meta, const void* src, void* dst, size_t n) {
+  if (meta.copy()) {
+    meta.copy()(src, dst, n);
+  } else {
+    std::memcpy(dst, src, n * meta.itemsize());
+  }
+}
+
+// Copies the contiguous `src` of sizes `src_dims` into the front of every
+// dimension of the contiguous `dst` of (elementwise not smaller) sizes
+// `dst_dims`, from dimension `dim` on.
+void copyPadded(
+    const TypeMeta& meta,
+    const char* src,
+    at::IntArrayRef src_dims,
+    char* dst,
+    at::IntArrayRef dst_dims,
+    size_t dim) {
+  if (dim + 1 == src_dims.size()) {
+    copyItems(meta, src, dst, src_dims[dim]);
+    return;
+  }
+  int64_t src_stride = meta.itemsize();
+  int64_t dst_stride = meta.itemsize();
+  for (size_t d = dim + 1; d < src_dims.size(); ++d) {
+    src_stride *= src_dims[d];
+    dst_stride *= dst_dims[d];
+  }
+  for (int64_t i = 0; i < src_dims[dim]; ++i) {
+    copyPadded(
+        meta,
+        src + i * src_stride,
+        src_dims,
+        dst + i * dst_stride,
+        dst_dims,
+        dim + 1);
+  }
+}
+
+} // namespace
+
+BatchingPredictor::BatchingPredictor(
+    std::unique_ptr<Predictor> predictor,
+    Options options)
+    : predictor_(std::move(predictor)),
+      options_(options),
+      thread_(&BatchingPredictor::loop, this) {
+  CAFFE_ENFORCE(predictor_);
+  CAFFE_ENFORCE_GE(options_.max_batch_size, 1);
+}
+
+BatchingPredictor::~BatchingPredictor() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+}
+
+void BatchingPredictor::runAsync(TensorList inputs, Callback callback) {
+  CAFFE_ENFORCE(!inputs.empty(), "A request needs at least one input");
+  const int64_t batch_size = inputs.front().dim() > 0 ? inputs.front().size(0) : 0;
+  for (const auto& input : inputs) {
+    CAFFE_ENFORCE(
+        input.dim() > 0 && input.size(0) == batch_size,
+        "All inputs of a request need the same size of their first dimension");
+    CAFFE_ENFORCE(input.is_contiguous());
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    queue_.push_back(Request{std::move(inputs),
+                             std::move(callback),
+                             batch_size,
+                             std::chrono::steady_clock::now()});
+    queued_examples_ += batch_size;
+  }
+  cv_.notify_one();
+}
+
+bool BatchingPredictor::operator()(
+    const TensorList& inputs,
+    TensorList* outputs) {
+  TensorList shared;
+  for (const auto& input : inputs) {
+    shared.emplace_back(input.UnsafeSharedInstance());
+  }
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  bool result = false;
+  runAsync(std::move(shared), [&](bool success, TensorList request_outputs) {
+    std::lock_guard<std::mutex> guard(mutex);
+    result = success;
+    *outputs = std::move(request_outputs);
+    done = true;
+    // Notified under the lock, as the waiting caller destroys cv once it
+    // sees done.
+    cv.notify_one();
+  });
+  std::unique_lock<std::mutex> lock(mutex);
+  cv.wait(lock, [&] { return done; });
+  return result;
+}
+
+void BatchingPredictor::loop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    if (queue_.empty()) {
+      if (stop_) {
+        return;
+      }
+      cv_.wait(lock);
+      continue;
+    }
+    const auto deadline = queue_.front().enqueued + options_.max_delay;
+    if (!stop_ && queued_examples_ < options_.max_batch_size &&
+        std::chrono::steady_clock::now() < deadline) {
+      cv_.wait_until(lock, deadline);
+      continue;
+    }
+    auto batch = takeBatch();
+    lock.unlock();
+    runBatch(batch);
+    lock.lock();
+  }
+}
+
+bool BatchingPredictor::canBatch(const Request& first, const Request& other)
+    const {
+  if (first.inputs.size() != other.inputs.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < first.inputs.size(); ++i) {
+    const auto& a = first.inputs[i];
+    const auto& b = other.inputs[i];
+    if (a.dtype() != b.dtype() || a.dim() != b.dim()) {
+      return false;
+    }
+    if (!options_.pad_inputs &&
+        !std::equal(a.sizes().begin() + 1, a.sizes().end(), b.sizes().begin() + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<BatchingPredictor::Request> BatchingPredictor::takeBatch() {
+  std::vector<Request> batch;
+  int64_t examples = 0;
+  while (!queue_.empty()) {
+    auto& next = queue_.front();
+    if (!batch.empty() &&
+        (examples + next.batch_size > options_.max_batch_size ||
+         !canBatch(batch.front(), next))) {
+      break;
+    }
+    examples += next.batch_size;
+    queued_examples_ -= next.batch_size;
+    batch.push_back(std::move(next));
+    queue_.pop_front();
+  }
+  return batch;
+}
+
+void BatchingPredictor::runBatch(std::vector<Request>& batch) {
+  std::vector<TensorList> outputs(batch.size());
+  bool success = false;
+  try {
+    TensorList inputs;
+    int64_t examples = 0;
+    for (const auto& request : batch) {
+      examples += request.batch_size;
+    }
+    if (batch.size() == 1) {
+      for (const auto& input : batch.front().inputs) {
+        inputs.emplace_back(input.UnsafeSharedInstance());
+      }
+    } else {
+      for (size_t i = 0; i < batch.front().inputs.size(); ++i) {
+        const auto& meta = batch.front().inputs[i].dtype();
+        std::vector<int64_t> dims = batch.front().inputs[i].sizes().vec();
+        bool padded = false;
+        for (const auto& request : batch) {
+          const auto sizes = request.inputs[i].sizes();
+          for (size_t d = 1; d < dims.size(); ++d) {
+            padded |= sizes[d] != dims[d];
+            dims[d] = std::max(dims[d], sizes[d]);
+          }
+        }
+        dims[0] = examples;
+        Tensor input(dims, CPU);
+        char* data = static_cast<char*>(input.raw_mutable_data(meta));
+        if (padded && !meta.copy()) {
+          std::memset(data, 0, input.nbytes());
+        }
+        const int64_t example_bytes = itemsPerExample(dims) * meta.itemsize();
+        for (const auto& request : batch) {
+          const auto& src = request.inputs[i];
+          if (padded) {
+            copyPadded(
+                meta,
+                static_cast<const char*>(src.raw_data()),
+                src.sizes(),
+                data,
+                dims,
+                0);
+          } else {
+            copyItems(meta, src.raw_data(), data, src.numel());
+          }
+          data += request.batch_size * example_bytes;
+        }
+        inputs.emplace_back(std::move(input));
+      }
+    }
+
+    TensorList batch_outputs;
+    success = (*predictor_)(inputs, &batch_outputs);
+    if (success) {
+      for (const auto& output : batch_outputs) {
+        CAFFE_ENFORCE(
+            output.dim() > 0 && output.size(0) == examples,
+            "Batched outputs need the examples along their first dimension");
+        const auto& meta = output.dtype();
+        const int64_t example_items = itemsPerExample(output.sizes());
+        const char* data = static_cast<const char*>(output.raw_data());
+        for (size_t r = 0; r < batch.size(); ++r) {
+          std::vector<int64_t> dims = output.sizes().vec();
+          dims[0] = batch[r].batch_size;
+          Tensor request_output(dims, CPU);
+          copyItems(
+              meta,
+              data,
+              request_output.raw_mutable_data(meta),
+              batch[r].batch_size * example_items);
+          data += batch[r].batch_size * example_items * meta.itemsize();
+          outputs[r].emplace_back(std::move(request_output));
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to run a batch of " << batch.size()
+               << " requests: " << e.what();
+    success = false;
+  }
+  for (size_t r = 0; r < batch.size(); ++r) {
+    batch[r].callback(success, success ? std::move(outputs[r]) : TensorList());
+  }
+}
+
+} // namespace caffe2
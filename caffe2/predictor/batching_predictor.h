@@ -0,0 +1,96 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "caffe2/predictor/predictor.h"
+
+namespace caffe2 {
+
+/**
+ * Runs the requests of concurrent callers of a Predictor in batches.
+ *
+ * Every input of a request has the examples of the request along its first
+ * dimension. Requests queued at the same time are concatenated along that
+ * dimension, up to `max_batch_size` examples, and run through the net at
+ * once; the outputs, which need the examples along their first dimension as
+ * well, are split back into those of every request. A batch is run as soon
+ * as it is full, or once its oldest request waited `max_delay`, so a single
+ * request is delayed by at most that much.
+ *
+ * Only requests whose inputs have the same types and, but for the first
+ * dimension, the same sizes are batched, unless `pad_inputs` is set: then
+ * inputs differing in their other sizes are zero padded at the end of every
+ * dimension to the largest of them, e.g. variable length sequences to the
+ * longest one. The outputs of padded requests are returned as computed for
+ * the padded inputs.
+ *
+ * The wrapped Predictor is only run from the batching thread.
+ */
+class CAFFE2_API BatchingPredictor {
+ public:
+  using TensorList = Predictor::TensorList;
+  using Callback = std::function<void(bool success, TensorList outputs)>;
+
+  struct Options {
+    // The largest number of examples run through the net at once. Requests
+    // larger than that are run on their own.
+    int64_t max_batch_size = 32;
+    // How long a request may wait for others to batch it with.
+    std::chrono::microseconds max_delay{1000};
+    // Whether to zero pad inputs of different sizes to batch them.
+    bool pad_inputs = false;
+  };
+
+  BatchingPredictor(std::unique_ptr<Predictor> predictor, Options options);
+
+  // Runs the requests still queued, then stops the batching thread.
+  ~BatchingPredictor();
+
+  // Queues a request and returns right away. `callback` is called from the
+  // batching thread with the outputs of this request alone, which it owns.
+  void runAsync(TensorList inputs, Callback callback);
+
+  // Queues a request and waits for its outputs. Returns true on success.
+  bool operator()(const TensorList& inputs, TensorList* outputs);
+
+  const Predictor& predictor() const {
+    return *predictor_;
+  }
+
+ private:
+  struct Request {
+    TensorList inputs;
+    Callback callback;
+    int64_t batch_size;
+    std::chrono::steady_clock::time_point enqueued;
+  };
+
+  void loop();
+
+  // Takes the requests at the front of the queue that can be run together.
+  // Must be called with mutex_ held and a non-empty queue.
+  std::vector<Request> takeBatch();
+
+  bool canBatch(const Request& first, const Request& other) const;
+
+  void runBatch(std::vector<Request>& batch);
+
+  const std::unique_ptr<Predictor> predictor_;
+  const Options options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<Request> queue_;
+  int64_t queued_examples_ = 0;
+  bool stop_ = false;
+
+  std::thread thread_;
+};
+
+} // namespace caffe2
@@ -0,0 +1,180 @@
+#include "caffe2/core/tensor.h"
+#include "caffe2/predictor/batching_predictor.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        type: "dag"
+        external_input: "data"
+        external_input: "W"
+        external_input: "b"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W"
+          input: "b"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+// y = data * W^T + b with all of W and b 2, so every y is 2 * sum(data) + 2
+const char* initSpec = R"DOC(
+        name: "init"
+        type: "dag"
+        op {
+          type: "ConstantFill"
+          output: "W"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(
+      TextFormat::ParseFromString(value, &def),
+      "Failed to parse NetDef with value: ",
+      value);
+  return def;
+}
+
+std::unique_ptr<BatchingPredictor> makeBatchingPredictor(
+    BatchingPredictor::Options options) {
+  return caffe2::make_unique<BatchingPredictor>(
+      caffe2::make_unique<Predictor>(
+          makePredictorConfig(parseNetDef(initSpec), parseNetDef(predictSpec))),
+      options);
+}
+
+// A (rows, cols) input with the value `value` everywhere.
+BatchingPredictor::TensorList makeInput(int64_t rows, int64_t cols, float value) {
+  Tensor data({rows, cols}, CPU);
+  std::fill(
+      data.mutable_data<float>(), data.mutable_data<float>() + data.numel(), value);
+  BatchingPredictor::TensorList inputs;
+  inputs.emplace_back(std::move(data));
+  return inputs;
+}
+
+void expectOutput(
+    const BatchingPredictor::TensorList& outputs,
+    int64_t rows,
+    float expected) {
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(outputs.front().dim(), 2);
+  EXPECT_EQ(outputs.front().size(0), rows);
+  EXPECT_EQ(outputs.front().size(1), 10);
+  for (int64_t i = 0; i < outputs.front().numel(); ++i) {
+    EXPECT_FLOAT_EQ(outputs.front().data<float>()[i], expected);
+  }
+}
+
+} // namespace
+
+TEST(BatchingPredictorTest, ConcurrentRequests) {
+  BatchingPredictor::Options options;
+  options.max_batch_size = 4;
+  auto predictor = makeBatchingPredictor(options);
+
+  std::vector<std::thread> threads;
+  std::atomic<int> successes{0};
+  for (int t = 0; t < 8; ++t) {
+    threads.emplace_back([&, t] {
+      const int64_t rows = 1 + t % 2;
+      BatchingPredictor::TensorList outputs;
+      ASSERT_TRUE((*predictor)(makeInput(rows, 4, t), &outputs));
+      expectOutput(outputs, rows, 2 * 4 * t + 2);
+      ++successes;
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(successes, 8);
+}
+
+TEST(BatchingPredictorTest, PaddedRequests) {
+  BatchingPredictor::Options options;
+  options.max_batch_size = 3;
+  options.max_delay = std::chrono::seconds(10);
+  options.pad_inputs = true;
+  auto predictor = makeBatchingPredictor(options);
+
+  // Run as a single full batch, with the first input padded to 4 columns.
+  std::mutex mutex;
+  std::vector<BatchingPredictor::TensorList> outputs(2);
+  std::vector<bool> successes(2, false);
+  predictor->runAsync(
+      makeInput(1, 3, 1), [&](bool success, BatchingPredictor::TensorList out) {
+        std::lock_guard<std::mutex> guard(mutex);
+        successes[0] = success;
+        outputs[0] = std::move(out);
+      });
+  predictor->runAsync(
+      makeInput(2, 4, 1), [&](bool success, BatchingPredictor::TensorList out) {
+        std::lock_guard<std::mutex> guard(mutex);
+        successes[1] = success;
+        outputs[1] = std::move(out);
+      });
+  // Waits for the queued requests.
+  predictor.reset();
+
+  EXPECT_TRUE(successes[0]);
+  EXPECT_TRUE(successes[1]);
+  expectOutput(outputs[0], 1, 2 * 3 + 2);
+  expectOutput(outputs[1], 2, 2 * 4 + 2);
+}
+
+TEST(BatchingPredictorTest, IncompatibleRequestsRunSeparately) {
+  BatchingPredictor::Options options;
+  options.max_delay = std::chrono::seconds(10);
+  auto predictor = makeBatchingPredictor(options);
+
+  // Without padding, the (1, 3) input isn't batched with the others, and
+  // fails on its own.
+  std::mutex mutex;
+  std::vector<bool> successes;
+  for (int64_t cols : {4, 3, 4}) {
+    predictor->runAsync(
+        makeInput(1, cols, 1), [&](bool success, BatchingPredictor::TensorList) {
+          std::lock_guard<std::mutex> guard(mutex);
+          successes.push_back(success);
+        });
+  }
+  predictor.reset();
+
+  EXPECT_EQ(successes, std::vector<bool>({true, false, true}));
+}
+
+} // namespace caffe2
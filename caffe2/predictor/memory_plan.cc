@@ -0,0 +1,152 @@
+#include "caffe2/predictor/memory_plan.h"
+
+#include <algorithm>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "caffe2/core/memonger.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/types.h"
+#include "caffe2/opt/shape_info.h"
+
+namespace caffe2 {
+
+namespace {
+
+size_t alignUp(size_t nbytes) {
+  return (nbytes + gAlignment - 1) / gAlignment * gAlignment;
+}
+
+// The arena stays alive as long as any tensor still points into it, e.g. an
+// output the caller holds on to past the Predictor.
+void releaseArena(void* ctx) {
+  delete static_cast<std::shared_ptr<at::DataPtr>*>(ctx);
+}
+
+} // namespace
+
+void planStaticMemory(
+    PredictorConfig* config,
+    const ShapeInfoMap& input_shapes,
+    const BoundShapeSpec& spec) {
+  CAFFE_ENFORCE(config && config->predict_net && config->ws);
+  const NetDef& net = *config->predict_net;
+  Workspace* ws = config->ws.get();
+
+  // Inputs and parameters are never planned, outputs keep their names.
+  std::set<std::string> static_blobs;
+  std::unordered_set<std::string> unplanned;
+  for (const auto& name : ws->Blobs()) {
+    static_blobs.insert(name);
+    unplanned.insert(name);
+  }
+  for (const auto& name : net.external_input()) {
+    static_blobs.insert(name);
+    unplanned.insert(name);
+  }
+  for (const auto& name : net.external_output()) {
+    static_blobs.insert(name);
+  }
+  NetDef optimized = memonger::optimize_inference_net(net, static_blobs);
+  CAFFE_ENFORCE_EQ(optimized.op_size(), net.op_size());
+
+  ShapeInfoMap shapes = input_shapes;
+  for (const auto& name : net.external_input()) {
+    const auto* blob = ws->GetBlob(name);
+    if (!shapes.count(name) && blob && BlobIsTensorType(*blob, CPU)) {
+      shapes.emplace(name, getShapeInfoFromBlob(blob));
+    }
+  }
+  BoundShapeInferencer inferencer(spec);
+  inferencer.InferBoundShapeAndType(net, shapes, ws);
+  const auto& shape_info = inferencer.shape_info();
+
+  // Shapes are inferred on the original net, whose outputs memonger renamed
+  // in place.
+  auto plan = std::make_shared<MemoryPlan>();
+  std::unordered_map<std::string, size_t> slot_of;
+  for (int i = 0; i < net.op_size(); ++i) {
+    const auto& op = net.op(i);
+    CAFFE_ENFORCE_EQ(optimized.op(i).output_size(), op.output_size());
+    for (int j = 0; j < op.output_size(); ++j) {
+      const auto& name = optimized.op(i).output(j);
+      if (unplanned.count(name)) {
+        continue;
+      }
+      const auto it = shape_info.find(op.output(j));
+      bool known = it != shape_info.end() && !it->second.is_quantized &&
+          !it->second.shape.unknown_shape() &&
+          it->second.shape.data_type() != TensorProto_DataType_UNDEFINED;
+      TypeMeta meta;
+      size_t nbytes = 0;
+      if (known) {
+        meta = DataTypeToTypeMeta(it->second.shape.data_type());
+        int64_t numel = 1;
+        for (const auto d : it->second.shape.dims()) {
+          numel *= d;
+        }
+        nbytes = numel * meta.itemsize();
+        known = !meta.placementNew();
+      }
+      auto slot = slot_of.find(name);
+      if (slot != slot_of.end()) {
+        // A blob changing its type at runtime would be reallocated anyway.
+        known = known && plan->slots[slot->second].meta == meta;
+      }
+      if (!known) {
+        unplanned.insert(name);
+        continue;
+      }
+      if (slot == slot_of.end()) {
+        slot_of.emplace(name, plan->slots.size());
+        plan->slots.push_back(MemoryPlan::Slot{name, meta, 0, nbytes});
+      } else {
+        auto& planned = plan->slots[slot->second];
+        planned.nbytes = std::max(planned.nbytes, nbytes);
+      }
+    }
+  }
+
+  std::vector<MemoryPlan::Slot> slots;
+  for (auto& slot : plan->slots) {
+    if (unplanned.count(slot.blob)) {
+      continue;
+    }
+    slot.offset = plan->arena_nbytes;
+    plan->arena_nbytes += alignUp(slot.nbytes);
+    slots.push_back(slot);
+  }
+  plan->slots = std::move(slots);
+  VLOG(1) << "Planned " << plan->slots.size() << " blobs in an arena of "
+          << plan->arena_nbytes << " bytes, leaving " << unplanned.size()
+          << " blobs unplanned";
+
+  *config->predict_net = std::move(optimized);
+  config->memory_plan = std::move(plan);
+}
+
+void applyMemoryPlan(const MemoryPlan& plan, Workspace* ws) {
+  if (!plan.arena_nbytes) {
+    return;
+  }
+  auto arena = std::make_shared<at::DataPtr>(
+      GetCPUAllocator()->allocate(plan.arena_nbytes));
+  char* base = static_cast<char*>(arena->get());
+  for (const auto& slot : plan.slots) {
+    auto* tensor = BlobGetMutableTensor(ws->CreateBlob(slot.blob), CPU);
+    tensor->Resize(slot.nbytes / slot.meta.itemsize());
+    // Later resizes within the slot keep the storage, see
+    // caffe2_keep_on_shrink.
+    tensor->ShareExternalPointer(
+        at::DataPtr(
+            base + slot.offset,
+            new std::shared_ptr<at::DataPtr>(arena),
+            &releaseArena,
+            at::Device(CPU)),
+        slot.meta,
+        slot.nbytes);
+  }
+}
+
+} // namespace caffe2
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "caffe2/core/workspace.h"
+#include "caffe2/opt/bound_shape_inferencer.h"
+#include "caffe2/predictor/predictor_config.h"
+
+namespace caffe2 {
+
+/**
+ * A static placement of the activations of a predict net in one arena.
+ *
+ * Every slot is a fixed, aligned range of the arena that backs a single blob
+ * of the (memongered) predict net. Blobs that memonger shares between
+ * activations with disjoint lifetimes use a single slot, sized for the
+ * largest of them.
+ */
+struct CAFFE2_API MemoryPlan {
+  struct Slot {
+    std::string blob;
+    TypeMeta meta;
+    size_t offset;
+    size_t nbytes;
+  };
+
+  std::vector<Slot> slots;
+  size_t arena_nbytes = 0;
+};
+
+/**
+ * Plans the activation memory of `config->predict_net` ahead of time.
+ *
+ * Shares the blobs of the predict net with memonger, then infers the bound
+ * shapes of all of its activations from the shapes of `input_shapes`, the
+ * parameters in `config->ws` and the bounds of `spec`, and lays them out in
+ * one arena. `config->predict_net` is replaced by the memongered net and the
+ * plan is stored in `config->memory_plan`, so every Predictor created from
+ * the config preallocates one arena for its workspace. As long as the inputs
+ * stay within the bounds, running the net then doesn't allocate memory for
+ * the planned blobs.
+ *
+ * Activations of unknown shape, or of types that need construction, are left
+ * out of the plan and allocated as before.
+ */
+CAFFE2_API void planStaticMemory(
+    PredictorConfig* config,
+    const ShapeInfoMap& input_shapes,
+    const BoundShapeSpec& spec);
+
+// Allocates the arena of `plan` and backs its blobs in `ws` with it.
+CAFFE2_API void applyMemoryPlan(const MemoryPlan& plan, Workspace* ws);
+
+} // namespace caffe2
@@ -0,0 +1,164 @@
+#include "caffe2/core/tensor.h"
+#include "caffe2/predictor/memory_plan.h"
+#include "caffe2/predictor/predictor.h"
+#include "caffe2/utils/proto_utils.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+namespace caffe2 {
+
+namespace {
+
+const char* predictSpec = R"DOC(
+        name: "predict"
+        external_input: "data"
+        external_input: "W1"
+        external_input: "b1"
+        external_input: "W2"
+        external_input: "b2"
+        external_output: "y"
+        op {
+          input: "data"
+          input: "W1"
+          input: "b1"
+          output: "h"
+          type: "FC"
+        }
+        op {
+          input: "h"
+          output: "r"
+          type: "Relu"
+        }
+        op {
+          input: "r"
+          input: "W2"
+          input: "b2"
+          output: "y"
+          type: "FC"
+        }
+)DOC";
+
+const char* initSpec = R"DOC(
+        name: "init"
+        op {
+          type: "ConstantFill"
+          output: "W1"
+          arg {
+            name: "shape"
+            ints: 8
+            ints: 4
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b1"
+          arg {
+            name: "shape"
+            ints: 8
+          }
+          arg {
+            name: "value"
+            f: -1.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "W2"
+          arg {
+            name: "shape"
+            ints: 10
+            ints: 8
+          }
+          arg {
+            name: "value"
+            f: 2.0
+          }
+        }
+        op {
+          type: "ConstantFill"
+          output: "b2"
+          arg {
+            name: "shape"
+            ints: 10
+          }
+          arg {
+            name: "value"
+            f: 1.0
+          }
+        }
+)DOC";
+
+NetDef parseNetDef(const std::string& value) {
+  NetDef def;
+  CAFFE_ENFORCE(
+      TextFormat::ParseFromString(value, &def),
+      "Failed to parse NetDef with value: ",
+      value);
+  return def;
+}
+
+Predictor::TensorList makeInput(int64_t rows, float value) {
+  Tensor data({rows, 4}, CPU);
+  std::fill(
+      data.mutable_data<float>(), data.mutable_data<float>() + data.numel(), value);
+  Predictor::TensorList inputs;
+  inputs.emplace_back(std::move(data));
+  return inputs;
+}
+
+} // namespace
+
+TEST(MemoryPlanTest, PlannedActivationsKeepTheirStorage) {
+  auto config =
+      makePredictorConfig(parseNetDef(initSpec), parseNetDef(predictSpec));
+  ShapeInfoMap input_shapes;
+  ShapeInfo data_info;
+  data_info.dim_type = ShapeInfo::DimType::BATCH;
+  data_info.shape.add_dims(16);
+  data_info.shape.add_dims(4);
+  data_info.shape.set_data_type(TensorProto_DataType_FLOAT);
+  input_shapes.emplace("data", data_info);
+  planStaticMemory(&config, input_shapes, BoundShapeSpec(16, 16));
+
+  ASSERT_TRUE(config.memory_plan);
+  const auto& plan = *config.memory_plan;
+  // Both activations and the output, each of at most 16 x 10 floats.
+  ASSERT_FALSE(plan.slots.empty());
+  EXPECT_LE(plan.slots.size(), 3);
+  for (const auto& slot : plan.slots) {
+    EXPECT_EQ(slot.offset % gAlignment, 0);
+    EXPECT_LE(slot.offset + slot.nbytes, plan.arena_nbytes);
+  }
+
+  Predictor predictor(config);
+  std::vector<const void*> planned;
+  for (const auto& slot : plan.slots) {
+    planned.push_back(
+        predictor.ws()->GetBlob(slot.blob)->Get<TensorCPU>().raw_data());
+  }
+
+  // Every h is 4 * 2 - 1 = 7, and every y 8 * 2 * 7 + 1.
+  for (int64_t rows : {16, 3, 8}) {
+    Predictor::TensorList outputs;
+    ASSERT_TRUE(predictor(makeInput(rows, 2), &outputs));
+    ASSERT_EQ(outputs.size(), 1);
+    EXPECT_EQ(outputs.front().size(0), rows);
+    EXPECT_EQ(outputs.front().size(1), 10);
+    for (int64_t i = 0; i < outputs.front().numel(); ++i) {
+      EXPECT_FLOAT_EQ(outputs.front().data<float>()[i], 8 * 2 * 7 + 1);
+    }
+    for (size_t s = 0; s < plan.slots.size(); ++s) {
+      EXPECT_EQ(
+          predictor.ws()->GetBlob(plan.slots[s].blob)->Get<TensorCPU>().raw_data(),
+          planned[s]);
+    }
+  }
+}
+
+} // namespace caffe2
@@ -1,6 +1,7 @@
 #include "caffe2/predictor/predictor.h"
 #include <unordered_set>
 #include "caffe2/core/init.h"
+#include "caffe2/predictor/memory_plan.h"
 
 namespace caffe2 {
 
@@ -50,6 +51,9 @@ Predictor::Predictor(PredictorConfig config) : config_(std::move(config)) {
       BlobGetMutableTensor(blob, CPU);
     }
   }
+  if (config_.memory_plan) {
+    applyMemoryPlan(*config_.memory_plan, config_.ws.get());
+  }
   CAFFE_ENFORCE(config_.ws->CreateNet(config_.predict_net));
 }
 
@@ -94,4 +94,13 @@ PredictorConfig makePredictorConfig(
   return config;
 }
 
+size_t shareParameters(PredictorConfig* config, SharedTensorStore* store) {
+  CAFFE_ENFORCE(config && config->ws);
+  CAFFE_ENFORCE(store);
+  if (!config->parameter_names.empty()) {
+    return store->ShareBlobs(config->ws.get(), config->parameter_names);
+  }
+  return store->ShareBlobs(config->ws.get(), config->ws->LocalBlobs());
+}
+
 } // namespace caffe2
@@ -1,6 +1,7 @@
 #pragma once
 #include <memory>
 
+#include "caffe2/core/shared_tensor_store.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
 #include "caffe2/proto/metanet.pb.h"
@@ -14,6 +15,8 @@ namespace caffe2 {
  */
 using PredictorParameters = std::map<std::string, std::shared_ptr<Blob>>;
 
+struct MemoryPlan;
+
 /**
  * Stores parameters nessasary for creating a PredictorInterface object.
  */
@@ -39,6 +42,10 @@ struct CAFFE2_API PredictorConfig {
   // tensor. Once tensor support intrusive_ptr, we'll get rid of this and use
   // parameters to construct Workspace
   std::shared_ptr<Workspace> ws;
+
+  // Optional static placement of the activations of predict_net, see
+  // planStaticMemory() in memory_plan.h.
+  std::shared_ptr<const MemoryPlan> memory_plan;
 };
 
 CAFFE2_API Workspace makeWorkspace(std::shared_ptr<PredictorParameters> parameters);
@@ -48,6 +55,9 @@ CAFFE2_API PredictorConfig makePredictorConfig(
     Workspace* parent = nullptr,
     bool run_init = true);
 
+// `optimization` is the level of opt::optimize() run on run_net, 2 fuses the
+// FC/Conv biases and activations, the chains of elementwise ops and the
+// Concat/Split pairs of nets run on CPU.
 CAFFE2_API PredictorConfig makePredictorConfig(
     const NetDef& init_net,
     const NetDef& run_net,
@@ -55,4 +65,12 @@ CAFFE2_API PredictorConfig makePredictorConfig(
     bool run_init = true,
     int optimization = 1);
 
+// Replaces the parameters in config->ws by the identical ones already in
+// `store` and adds the others to it, so that the predictors of models sharing
+// some of their weights hold a single copy of them. parameter_names are
+// shared when set, all the blobs of config->ws otherwise. Should be called
+// before the Predictor is created. Returns the number of bytes saved.
+CAFFE2_API size_t
+shareParameters(PredictorConfig* config, SharedTensorStore* store);
+
 } // namespace caffe2
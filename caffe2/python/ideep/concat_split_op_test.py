@@ -7,7 +7,9 @@ import numpy as np
 import hypothesis.strategies as st
 import unittest
 import caffe2.python.hypothesis_test_util as hu
+from caffe2.proto import caffe2_pb2
 from caffe2.python import core, workspace
+from caffe2.python.transformations import optimizeForMKLDNN
 from hypothesis import given, settings
 import caffe2.python.ideep_test_util as mu
 
@@ -156,6 +158,111 @@ class TestConcatSplitOps(hu.HypothesisTestCase):
             print(np.max(np.abs(inf1 - inf0)))
             self.assertTrue(False)
 
+    @given(size=st.integers(7, 9),
+           input_channels=st.lists(st.integers(1, 4), min_size=2, max_size=4),
+           batch_size=st.integers(1, 3),
+           **mu.gcs)
+    def test_int8_concat(self, size, input_channels, batch_size, gc, dc):
+        Xs = [np.random.rand(batch_size, c, size, size).astype(np.float32)
+              for c in input_channels]
+        Y = np.concatenate(Xs, axis=1)
+        Y_scale = Y.max() / 0xFF
+
+        # Concat between INT8 ops, as in a model quantized op by op.
+        net = caffe2_pb2.NetDef()
+        for i, X in enumerate(Xs):
+            workspace.FeedBlob("X_{}".format(i), X, dc[1])
+            net.op.extend([
+                core.CreateOperator(
+                    "NCHW2NHWC",
+                    ["X_{}".format(i)],
+                    ["X_{}_nhwc".format(i)],
+                    device_option=dc[1]
+                ),
+                core.CreateOperator(
+                    "Int8Quantize",
+                    ["X_{}_nhwc".format(i)],
+                    ["X_{}_quantized".format(i)],
+                    engine="DNNLOWP",
+                    device_option=dc[1],
+                    Y_zero_point=0,
+                    Y_scale=X.max() / 0xFF,
+                ),
+                core.CreateOperator(
+                    "Int8Dequantize",
+                    ["X_{}_quantized".format(i)],
+                    ["X_{}_dequantized".format(i)],
+                    engine="DNNLOWP",
+                    device_option=dc[1],
+                ),
+                core.CreateOperator(
+                    "NHWC2NCHW",
+                    ["X_{}_dequantized".format(i)],
+                    ["X_{}_nchw".format(i)],
+                    device_option=dc[1]
+                ),
+            ])
+        net.op.extend([
+            core.CreateOperator(
+                "Concat",
+                ["X_{}_nchw".format(i) for i in range(len(Xs))],
+                ["Y", "split_info"],
+                axis=1,
+                device_option=dc[1]
+            ),
+            core.CreateOperator(
+                "NCHW2NHWC",
+                ["Y"],
+                ["Y_nhwc"],
+                device_option=dc[1]
+            ),
+            core.CreateOperator(
+                "Int8Quantize",
+                ["Y_nhwc"],
+                ["Y_quantized"],
+                engine="DNNLOWP",
+                device_option=dc[1],
+                Y_zero_point=0,
+                Y_scale=Y_scale,
+            ),
+            core.CreateOperator(
+                "Int8Dequantize",
+                ["Y_quantized"],
+                ["Y_out_nhwc"],
+                engine="DNNLOWP",
+                device_option=dc[1],
+            ),
+            core.CreateOperator(
+                "NHWC2NCHW",
+                ["Y_out_nhwc"],
+                ["Y_out"],
+                device_option=dc[1]
+            ),
+        ])
+
+        workspace.RunNetOnce(net)
+        Y_ref = workspace.FetchBlob("Y_out")
+
+        net_opt = core.Net("net")
+        net_opt.Proto().CopyFrom(net)
+        optimizeForMKLDNN(net_opt)
+        op_types = [op.type for op in net_opt.Proto().op]
+        self.assertIn("Int8Concat", op_types)
+        self.assertNotIn("Concat", op_types)
+        self.assertNotIn("NHWC2NCHW", op_types)
+        workspace.RunNetOnce(net_opt.Proto())
+        Y_out = workspace.FetchBlob("Y_out")
+
+        # Inputs are requantized to the scale of the output once, instead of
+        # going through FP32.
+        MSE = np.square(np.subtract(Y_ref, Y_out)).mean()
+        if MSE > 0.005 or np.square(np.subtract(Y, Y_out)).mean() > 0.005:
+            print(Y_ref.flatten())
+            print(Y_out.flatten())
+            print(np.max(np.abs(Y_out - Y_ref)))
+            print("MSE", MSE)
+            self.assertTrue(False)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -237,7 +237,8 @@ def create_test(output_dir, width, height, default_bound, minsize, crop, means,
 
 def run_test(
         size_tuple, means, stds, label_type, num_labels, is_test, scale_jitter_type,
-        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None):
+        color_jitter, color_lighting, dc, validator, output1=None, output2_size=None,
+        prefetch_depth=1):
     # TODO: Does not test on GPU and does not test use_gpu_transform
     # WARNING: Using ModelHelper automatically does NHWC to NCHW
     # transformation if needed.
@@ -300,7 +301,8 @@ def run_test(
                 output_sizes=output_sizes,
                 scale_jitter_type=scale_jitter_type,
                 color_jitter=color_jitter,
-                color_lighting=color_lighting
+                color_lighting=color_lighting,
+                prefetch_depth=prefetch_depth
             )
 
             imageop.device_option.CopyFrom(device_option)
@@ -365,12 +367,13 @@ class TestImport(hu.HypothesisTestCase):
         scale_jitter_type=st.integers(min_value=0, max_value=1),
         color_jitter=st.integers(min_value=0, max_value=1),
         color_lighting=st.integers(min_value=0, max_value=1),
+        prefetch_depth=st.integers(min_value=1, max_value=3),
         **hu.gcs)
     @settings(verbosity=Verbosity.verbose)
     def test_imageinput(
             self, size_tuple, means, stds, label_type,
             num_labels, is_test, scale_jitter_type, color_jitter, color_lighting,
-            gc, dc):
+            prefetch_depth, gc, dc):
         def validator(expected_images, device_option, count_images):
             self.validate_image_and_label(
                 expected_images, device_option, count_images, label_type,
@@ -378,7 +381,8 @@ class TestImport(hu.HypothesisTestCase):
         # End validator
         run_test(
             size_tuple, means, stds, label_type, num_labels, is_test,
-            scale_jitter_type, color_jitter, color_lighting, dc, validator)
+            scale_jitter_type, color_jitter, color_lighting, dc, validator,
+            prefetch_depth=prefetch_depth)
     # End test_imageinput
 
     @given(size_tuple=st.tuples(
@@ -427,6 +431,67 @@ class TestImport(hu.HypothesisTestCase):
             validator, output1, output2_size)
     # End test_imageinput
 
+    @given(width=st.integers(min_value=256, max_value=1024),
+           height=st.integers(min_value=256, max_value=1024),
+           scale_jitter_type=st.integers(min_value=0, max_value=1),
+           **hu.gcs_cpu_only)
+    @settings(verbosity=Verbosity.verbose, max_examples=10)
+    def test_imageinput_dct_scaled_decode(
+            self, width, height, scale_jitter_type, gc, dc):
+        out_dir = tempfile.mkdtemp()
+        count_images = 2
+        env = lmdb.open(out_dir, map_size=1 << 40, subdir=True)
+        with env.begin(write=True) as txn:
+            for index in range(count_images):
+                # A smooth image, which decodes to about the same at any scale
+                y, x = np.mgrid[0:height, 0:width]
+                img_array = np.stack(
+                    [x * 255 // width, y * 255 // height,
+                     (x + y) * 255 // (width + height)],
+                    axis=2).astype(np.uint8)
+                img_str = six.BytesIO()
+                Image.fromarray(img_array).save(img_str, 'JPEG', quality=95)
+                tensor_protos = caffe2_pb2.TensorProtos()
+                image_tensor = tensor_protos.protos.add()
+                image_tensor.data_type = 4  # string data
+                image_tensor.string_data.append(img_str.getvalue())
+                label_tensor = tensor_protos.protos.add()
+                label_tensor.data_type = 2  # int32 data
+                label_tensor.int32_data.append(index)
+                txn.put('{}'.format(index).encode('ascii'),
+                        tensor_protos.SerializeToString())
+
+        results = []
+        for dct_scaled_decode in [0, 1]:
+            with hu.temp_workspace():
+                reader_net = core.Net('reader')
+                reader_net.CreateDB([], 'DB', db=out_dir, db_type="lmdb")
+                workspace.RunNetOnce(reader_net)
+                imageop = core.CreateOperator(
+                    'ImageInput',
+                    ['DB'],
+                    ['data', 'label'],
+                    batch_size=count_images,
+                    color=3,
+                    scale=64,
+                    crop=56,
+                    is_test=1 - scale_jitter_type,
+                    scale_jitter_type=scale_jitter_type,
+                    dct_scaled_decode=dct_scaled_decode,
+                    prefetch_depth=2,
+                )
+                imageop.device_option.CopyFrom(dc[0])
+                workspace.RunOperatorOnce(imageop)
+                results.append(workspace.FetchBlob('data'))
+                np.testing.assert_array_equal(
+                    workspace.FetchBlob('label'), np.arange(count_images))
+
+        self.assertEqual(results[0].shape, results[1].shape)
+        if scale_jitter_type == 0:
+            # Central crops of the images scaled to the same size
+            self.assertLess(np.abs(results[0] - results[1]).mean(), 8)
+        shutil.rmtree(out_dir)
+
 
 if __name__ == '__main__':
     import unittest
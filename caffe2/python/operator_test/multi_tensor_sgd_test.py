@@ -0,0 +1,115 @@
+from __future__ import absolute_import
+from __future__ import division
+from __future__ import print_function
+from __future__ import unicode_literals
+
+from caffe2.python import core, workspace
+import caffe2.python.hypothesis_test_util as hu
+
+from hypothesis import given
+import hypothesis.strategies as st
+import numpy as np
+import unittest
+
+
+class TestMultiTensorSGD(hu.HypothesisTestCase):
+    def _run_and_compare(self, ops, fused_op, inputs, outputs, gc,
+                         cpu_inputs=()):
+        # Runs the per-tensor ops and the fused op on the same inputs, and
+        # checks that they compute the same outputs.
+        results = []
+        for net_ops in [ops, [fused_op]]:
+            workspace.ResetWorkspace()
+            for name, value in inputs.items():
+                device_option = hu.cpu_do if name in cpu_inputs else gc
+                workspace.FeedBlob(name, value, device_option)
+            for op in net_ops:
+                op.device_option.CopyFrom(gc)
+                self.assertTrue(workspace.RunOperatorOnce(op))
+            results.append([workspace.FetchBlob(name) for name in outputs])
+        for expected, actual in zip(*results):
+            np.testing.assert_allclose(expected, actual, rtol=1e-5, atol=1e-6)
+
+    @given(sizes=st.lists(st.integers(1, 100000), min_size=1, max_size=40),
+           nesterov=st.booleans(),
+           **hu.gcs)
+    def test_multi_tensor_momentum_sgd(self, sizes, nesterov, gc, dc):
+        inputs = {}
+        ops = []
+        fused_inputs = []
+        fused_outputs = []
+        for i, size in enumerate(sizes):
+            names = [n + str(i) for n in ["grad", "momentum", "lr", "param"]]
+            for name in names:
+                inputs[name] = np.random.rand(
+                    1 if name.startswith("lr") else size).astype(np.float32)
+            outputs = [names[0], names[1], names[3]]
+            ops.append(core.CreateOperator(
+                "MomentumSGDUpdate", names, outputs,
+                momentum=0.9, nesterov=int(nesterov)))
+            fused_inputs += names
+            fused_outputs += outputs
+
+        fused_op = core.CreateOperator(
+            "MultiTensorMomentumSGDUpdate", fused_inputs, fused_outputs,
+            momentum=0.9, nesterov=int(nesterov))
+        self._run_and_compare(ops, fused_op, inputs, fused_outputs, gc)
+
+    @given(sizes=st.lists(st.integers(1, 100000), min_size=1, max_size=40),
+           ITER=st.integers(min_value=0, max_value=10000),
+           **hu.gcs)
+    def test_multi_tensor_adam(self, sizes, ITER, gc, dc):
+        inputs = {}
+        ops = []
+        fused_inputs = []
+        fused_outputs = []
+        cpu_inputs = []
+        for i, size in enumerate(sizes):
+            names = [n + str(i) for n in
+                     ["param", "mom1", "mom2", "grad", "lr", "iter"]]
+            for name in names[:4]:
+                inputs[name] = np.random.rand(size).astype(np.float32)
+            inputs[names[4]] = np.random.rand(1).astype(np.float32)
+            inputs[names[5]] = np.array([ITER + i], dtype=np.int64)
+            cpu_inputs.append(names[5])
+            outputs = names[:3]
+            ops.append(core.CreateOperator(
+                "Adam", names, outputs, beta1=0.9, beta2=0.999, epsilon=1e-5))
+            fused_inputs += names
+            fused_outputs += outputs
+
+        fused_op = core.CreateOperator(
+            "MultiTensorAdam", fused_inputs, fused_outputs,
+            beta1=0.9, beta2=0.999, epsilon=1e-5)
+        self._run_and_compare(
+            ops, fused_op, inputs, fused_outputs, gc, cpu_inputs)
+
+    @given(sizes=st.lists(st.integers(1, 100000), min_size=1, max_size=40),
+           offset=st.floats(min_value=0, max_value=100),
+           **hu.gcs)
+    def test_multi_tensor_lars(self, sizes, offset, gc, dc):
+        inputs = {}
+        ops = []
+        fused_inputs = []
+        fused_outputs = []
+        for i, size in enumerate(sizes):
+            names = [n + str(i) for n in ["X", "dX", "wd", "trust", "lr_max"]]
+            inputs[names[0]] = np.random.rand(size).astype(np.float32)
+            inputs[names[1]] = np.random.rand(size).astype(np.float32)
+            inputs[names[2]] = np.array([1e-4], dtype=np.float32)
+            inputs[names[3]] = np.random.rand(1).astype(np.float32)
+            inputs[names[4]] = np.random.rand(1).astype(np.float32)
+            output = "rescale_factor" + str(i)
+            ops.append(core.CreateOperator(
+                "Lars", names, [output], offset=offset, lr_min=1e-7))
+            fused_inputs += names
+            fused_outputs.append(output)
+
+        fused_op = core.CreateOperator(
+            "MultiTensorLars", fused_inputs, fused_outputs,
+            offset=offset, lr_min=1e-7)
+        self._run_and_compare(ops, fused_op, inputs, fused_outputs, gc)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -165,6 +165,57 @@ class TestReBatchingQueue(TestCase):
                 workspace.FetchBlob(tensors[idx])[:5]
             )
 
+    def test_rebatching_queue_buckets(self):
+        LENGTHS = [1, 5, 2, 6, 1, 7, 2, 3]
+
+        net = core.Net('net')
+        queue = net.CreateRebatchingQueue(
+            [], 'bucketed_queue', capacity=len(LENGTHS), num_blobs=2,
+            bucket_boundaries=[2, 4], length_blob=0, max_staleness_ms=0
+        )
+        for idx, length in enumerate(LENGTHS):
+            sequence = net.GivenTensorFill(
+                [], 1, shape=[length], values=[idx + 1.0] * length
+            )
+            index = net.GivenTensorIntFill([], 1, shape=[], values=[idx])
+            net.EnqueueRebatchingQueue([queue, sequence, index], [])
+
+        # buckets: [0, 2, 4, 6], [7], [1, 3, 5]
+        results = [
+            net.DequeueRebatchingQueue([queue], 2, num_elements=4),
+            net.DequeueRebatchingQueue([queue], 2, num_elements=4),
+            net.DequeueRebatchingQueue([queue], 2, num_elements=4),
+        ]
+        net.CloseRebatchingQueue([queue], 0)
+        stats = net.StatRegistryExport([], ['keys', 'values', 'ts'])
+
+        workspace.RunNetOnce(net)
+
+        def fetch(result):
+            return [workspace.FetchBlob(blob) for blob in result]
+
+        # the full bucket first, then the oldest element
+        sequences, indices = fetch(results[0])
+        npt.assert_array_equal(indices, [0, 2, 4, 6])
+        npt.assert_array_equal(
+            sequences, [[1, 0], [3, 3], [5, 0], [7, 7]]
+        )
+        sequences, indices = fetch(results[1])
+        npt.assert_array_equal(indices, [1, 3, 5])
+        npt.assert_array_equal(sequences[:, 5:], [[0, 0], [4, 0], [6, 6]])
+        sequences, indices = fetch(results[2])
+        npt.assert_array_equal(indices, [7])
+        npt.assert_array_equal(sequences, [[8, 8, 8]])
+
+        keys, values = fetch(stats[:2])
+        values = {
+            key.decode('utf-8'): value for key, value in zip(keys, values)
+        }
+        self.assertEqual(values['bucketed_queue/dequeued_batches'], 3)
+        self.assertEqual(values['bucketed_queue/partial_batches'], 2)
+        self.assertEqual(values['bucketed_queue/valid_length'], sum(LENGTHS))
+        self.assertEqual(values['bucketed_queue/padded_length'], 8 + 21 + 3)
+
     @given(
         num_producers=st.integers(1, 5),
         num_consumers=st.integers(1, 5),
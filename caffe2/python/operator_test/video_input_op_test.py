@@ -159,6 +159,49 @@ class VideoInputOpTest(unittest.TestCase):
         os.remove(temp_list)
         shutil.rmtree(video_db_dir)
 
+    def test_rgb_with_sparse_uniform_sampling(self):
+        random_label = np.random.randint(0, 100)
+        clip_per_video = np.random.randint(2, 11)
+        VIDEO = "/mnt/vol/gfsdataswarm-oregon/users/trandu/sample.avi"
+        if not os.path.exists(VIDEO):
+            raise unittest.SkipTest('Missing data')
+        temp_list = tempfile.NamedTemporaryFile(delete=False).name
+        line_str = '{} 0 {}\n'.format(VIDEO, random_label)
+        self.create_a_list(temp_list, line_str, 16)
+        video_db_dir = tempfile.mkdtemp()
+
+        self.create_video_db(temp_list, video_db_dir)
+        model = model_helper.ModelHelper(name="Video Loader from LMDB")
+        reader = model.CreateDB("sample", db=video_db_dir, db_type="lmdb")
+
+        # build the model
+        model.net.VideoInput(
+            reader,
+            ["data", "label"],
+            name="data",
+            batch_size=3,
+            clip_per_video=clip_per_video,
+            crop_size=112,
+            scale_w=171,
+            scale_h=128,
+            length_rgb=8,
+            sampling_rate_rgb=2,
+            decode_type=1,
+            sparse_sampling=True,
+            video_res_type=0)
+
+        workspace.RunNetOnce(model.param_init_net)
+        workspace.RunNetOnce(model.net)
+        data = workspace.FetchBlob("data")
+        label = workspace.FetchBlob("label")
+
+        np.testing.assert_equal(label, random_label)
+        np.testing.assert_equal(
+            data.shape, [3 * clip_per_video, 3, 8, 112, 112]
+        )
+        os.remove(temp_list)
+        shutil.rmtree(video_db_dir)
+
     # test optical flow
     def test_optical_flow_with_temporal_jittering(self):
         random_label = np.random.randint(0, 100)
@@ -25,6 +25,7 @@
 #include "caffe2/opt/mobile.h"
 #include "caffe2/opt/onnxifi_transformer.h"
 #include "caffe2/opt/optimize_ideep.h"
+#include "caffe2/opt/optimizer_fusion.h"
 #include "caffe2/opt/passes.h"
 #include "caffe2/predictor/emulator/data_filler.h"
 #include "caffe2/predictor/predictor.h"
@@ -1809,6 +1810,17 @@ void addGlobalMethods(py::module& m) {
     return py::bytes(out);
   });
 
+  m.def("transform_fuseOptimizerOps", [](py::bytes def) {
+    caffe2::NetDef proto;
+    CAFFE_ENFORCE(ParseProtoFromLargeString(def.cast<std::string>(), &proto));
+
+    auto new_proto = opt::fuseOptimizerOps(proto);
+
+    std::string out;
+    new_proto.SerializeToString(&out);
+    return py::bytes(out);
+  });
+
   m.def("transform_fuseNNPACKConvRelu", [](py::bytes def) {
     caffe2::NetDef proto;
     CAFFE_ENFORCE(ParseProtoFromLargeString(def.cast<std::string>(), &proto));
@@ -56,3 +56,9 @@ def fuseConvBN(net):
     net.Proto().ParseFromString(
         C.transform_fuseConvBN(net.Proto().SerializeToString())
     )
+
+
+def fuseOptimizerOps(net):
+    net.Proto().ParseFromString(
+        C.transform_fuseOptimizerOps(net.Proto().SerializeToString())
+    )
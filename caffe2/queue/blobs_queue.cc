@@ -69,6 +69,7 @@ bool BlobsQueue::blockingRead(
   // Decrease queue balance before reading to indicate queue read pressure
   // is being increased (-ve queue balance indicates more reads than writes)
   CAFFE_EVENT(stats_, queue_balance, -1);
+  Timer waitTimer;
   if (timeout_secs > 0) {
     std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
     cv_.wait_for(
@@ -76,6 +77,7 @@ bool BlobsQueue::blockingRead(
   } else {
     cv_.wait(g, [this, canRead]() { return closing_ || canRead(); });
   }
+  CAFFE_EVENT(stats_, read_wait_time_ns, waitTimer.NanoSeconds());
   if (!canRead()) {
     if (timeout_secs > 0 && !closing_) {
       LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
@@ -97,6 +99,7 @@ bool BlobsQueue::blockingRead(
   CAFFE_SDT(queue_read_end, name, (void*)this, writer_ - reader_);
   CAFFE_EVENT(stats_, queue_dequeued_records);
   ++reader_;
+  CAFFE_EVENT(stats_, queue_occupancy, writer_ - reader_);
   cv_.notify_all();
   CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
   return true;
@@ -130,7 +133,9 @@ bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
   // Increase queue balance before writing to indicate queue write pressure is
   // being increased (+ve queue balance indicates more writes than reads)
   CAFFE_EVENT(stats_, queue_balance, 1);
+  Timer waitTimer;
   cv_.wait(g, [this]() { return closing_ || canWrite(); });
+  CAFFE_EVENT(stats_, write_wait_time_ns, waitTimer.NanoSeconds());
   if (!canWrite()) {
     CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
     return false;
@@ -141,6 +146,25 @@ bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
   return true;
 }
 
+size_t BlobsQueue::blockingReadMany(
+    const std::vector<std::vector<Blob*>>& records,
+    float timeout_secs) {
+  size_t read = 0;
+  while (read < records.size() && blockingRead(records[read], timeout_secs)) {
+    ++read;
+  }
+  return read;
+}
+
+size_t BlobsQueue::blockingWriteMany(
+    const std::vector<std::vector<Blob*>>& records) {
+  size_t written = 0;
+  while (written < records.size() && blockingWrite(records[written])) {
+    ++written;
+  }
+  return written;
+}
+
 void BlobsQueue::close() {
   closing_ = true;
 
@@ -167,6 +191,7 @@ void BlobsQueue::doWrite(const std::vector<Blob*>& inputs) {
   CAFFE_SDT(
       queue_write_end, name, (void*)this, reader_ + queue_.size() - writer_);
   ++writer_;
+  CAFFE_EVENT(stats_, queue_occupancy, writer_ - reader_);
   cv_.notify_all();
 }
 
@@ -30,31 +30,32 @@ class CAFFE2_API BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
       bool enforceUniqueName,
       const std::vector<std::string>& fieldNames = {});
 
-  ~BlobsQueue() {
+  virtual ~BlobsQueue() {
     close();
   }
 
-  bool blockingRead(
+  virtual bool blockingRead(
       const std::vector<Blob*>& inputs,
       float timeout_secs = 0.0f);
-  bool tryWrite(const std::vector<Blob*>& inputs);
-  bool blockingWrite(const std::vector<Blob*>& inputs);
-  void close();
+  virtual bool tryWrite(const std::vector<Blob*>& inputs);
+  virtual bool blockingWrite(const std::vector<Blob*>& inputs);
+  // Batched versions of blockingRead and blockingWrite, for one record per
+  // element of `records`. Return the number of records read or written
+  // before the queue was closed (or the read timed out).
+  virtual size_t blockingReadMany(
+      const std::vector<std::vector<Blob*>>& records,
+      float timeout_secs = 0.0f);
+  virtual size_t blockingWriteMany(
+      const std::vector<std::vector<Blob*>>& records);
+  virtual void close();
   size_t getNumBlobs() const {
     return numBlobs_;
   }
 
- private:
-  bool canWrite();
-  void doWrite(const std::vector<Blob*>& inputs);
-
+ protected:
   std::atomic<bool> closing_{false};
 
   size_t numBlobs_;
-  std::mutex mutex_; // protects all variables in the class.
-  std::condition_variable cv_;
-  int64_t reader_{0};
-  int64_t writer_{0};
   std::vector<std::vector<Blob*>> queue_;
   const std::string name_;
 
@@ -65,6 +66,20 @@ class CAFFE2_API BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
     CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
     CAFFE_AVG_EXPORTED_STAT(read_time_ns);
     CAFFE_AVG_EXPORTED_STAT(write_time_ns);
+    // time spent blocked on an empty or full queue
+    CAFFE_AVG_EXPORTED_STAT(read_wait_time_ns);
+    CAFFE_AVG_EXPORTED_STAT(write_wait_time_ns);
+    // records in the queue after every read and write
+    CAFFE_AVG_EXPORTED_STAT(queue_occupancy);
   } stats_;
+
+ private:
+  bool canWrite();
+  void doWrite(const std::vector<Blob*>& inputs);
+
+  std::mutex mutex_; // protects all variables in the class.
+  std::condition_variable cv_;
+  int64_t reader_{0};
+  int64_t writer_{0};
 };
 } // namespace caffe2
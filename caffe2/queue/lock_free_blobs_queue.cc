@@ -0,0 +1,276 @@
+#include "caffe2/queue/lock_free_blobs_queue.h"
+
+#include "caffe2/core/blob_stats.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/stats.h"
+#include "caffe2/core/timer.h"
+
+namespace caffe2 {
+
+LockFreeBlobsQueue::LockFreeBlobsQueue(
+    Workspace* ws,
+    const std::string& queueName,
+    size_t capacity,
+    size_t numBlobs,
+    bool enforceUniqueName,
+    const std::vector<std::string>& fieldNames)
+    : BlobsQueue(
+          ws,
+          queueName,
+          capacity,
+          numBlobs,
+          enforceUniqueName,
+          fieldNames),
+      capacity_(capacity),
+      sequences_(new std::atomic<int64_t>[capacity]) {
+  CAFFE_ENFORCE_GT(capacity, 0);
+  // slot i is written first at position i
+  for (int64_t i = 0; i < capacity_; ++i) {
+    sequences_[i].store(i, std::memory_order_relaxed);
+  }
+}
+
+bool LockFreeBlobsQueue::blockingRead(
+    const std::vector<Blob*>& inputs,
+    float timeout_secs) {
+  return readMany(&inputs, 1, timeout_secs) == 1;
+}
+
+bool LockFreeBlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
+  return writeMany(&inputs, 1, false) == 1;
+}
+
+bool LockFreeBlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
+  return writeMany(&inputs, 1, true) == 1;
+}
+
+size_t LockFreeBlobsQueue::blockingReadMany(
+    const std::vector<std::vector<Blob*>>& records,
+    float timeout_secs) {
+  return readMany(records.data(), records.size(), timeout_secs);
+}
+
+size_t LockFreeBlobsQueue::blockingWriteMany(
+    const std::vector<std::vector<Blob*>>& records) {
+  return writeMany(records.data(), records.size(), true);
+}
+
+void LockFreeBlobsQueue::close() {
+  closing_ = true;
+
+  std::lock_guard<std::mutex> g(wait_mutex_);
+  readers_cv_.notify_all();
+  writers_cv_.notify_all();
+}
+
+size_t LockFreeBlobsQueue::readMany(
+    const std::vector<Blob*>* records,
+    size_t count,
+    float timeout_secs) {
+  Timer readTimer;
+  auto keeper = this->shared_from_this();
+  // Decrease queue balance before reading to indicate queue read pressure
+  // is being increased (-ve queue balance indicates more reads than writes)
+  CAFFE_EVENT(stats_, queue_balance, -static_cast<int64_t>(count));
+  std::chrono::steady_clock::time_point deadline;
+  if (timeout_secs > 0) {
+    deadline = std::chrono::steady_clock::now() +
+        std::chrono::milliseconds(int(timeout_secs * 1000));
+  }
+  auto canRead = [this]() {
+    auto pos = head_.load();
+    return closing_ || sequences_[pos % capacity_].load() > pos;
+  };
+
+  for (size_t r = 0; r < count; ++r) {
+    CAFFE_ENFORCE(records[r].size() >= numBlobs_);
+  }
+
+  size_t read = 0;
+  while (read < count) {
+    read += tryReadMany(records + read, count - read);
+    if (read == count) {
+      break;
+    }
+    if (closing_) {
+      // records written before the queue was closed are still read
+      read += tryReadMany(records + read, count - read);
+      break;
+    }
+    Timer waitTimer;
+    bool ready = wait(
+        readers_cv_,
+        waiting_readers_,
+        canRead,
+        timeout_secs > 0 ? &deadline : nullptr);
+    CAFFE_EVENT(stats_, read_wait_time_ns, waitTimer.NanoSeconds());
+    if (!ready) {
+      LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
+      break;
+    }
+  }
+  CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+  return read;
+}
+
+size_t LockFreeBlobsQueue::writeMany(
+    const std::vector<Blob*>* records,
+    size_t count,
+    bool blocking) {
+  Timer writeTimer;
+  auto keeper = this->shared_from_this();
+  auto canWrite = [this]() {
+    auto pos = tail_.load();
+    return closing_ || sequences_[pos % capacity_].load() >= pos;
+  };
+
+  for (size_t r = 0; r < count; ++r) {
+    CAFFE_ENFORCE(records[r].size() >= numBlobs_);
+  }
+
+  size_t written = 0;
+  while (written < count) {
+    written += tryWriteMany(records + written, count - written);
+    if (written == count || !blocking || closing_) {
+      break;
+    }
+    Timer waitTimer;
+    wait(writers_cv_, waiting_writers_, canWrite, nullptr);
+    CAFFE_EVENT(stats_, write_wait_time_ns, waitTimer.NanoSeconds());
+  }
+  if (written > 0) {
+    // Increase queue balance to indicate queue write pressure is being
+    // increased (+ve queue balance indicates more writes than reads)
+    CAFFE_EVENT(stats_, queue_balance, written);
+    CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
+  }
+  return written;
+}
+
+size_t LockFreeBlobsQueue::tryReadMany(
+    const std::vector<Blob*>* records,
+    size_t count) {
+  int64_t pos = head_.load(std::memory_order_relaxed);
+  int64_t claimed = 0;
+  while (true) {
+    // the positions from pos on that were written
+    claimed = 0;
+    while (claimed < static_cast<int64_t>(count) &&
+           sequences_[(pos + claimed) % capacity_].load(
+               std::memory_order_acquire) == pos + claimed + 1) {
+      ++claimed;
+    }
+    if (claimed == 0) {
+      if (sequences_[pos % capacity_].load(std::memory_order_acquire) <=
+          pos) {
+        // empty
+        return 0;
+      }
+      // another reader took pos
+      pos = head_.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (head_.compare_exchange_weak(
+            pos, pos + claimed, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  for (int64_t r = 0; r < claimed; ++r) {
+    const auto slot = (pos + r) % capacity_;
+    auto& result = queue_[slot];
+    const auto& inputs = records[r];
+    for (size_t i = 0; i < result.size(); ++i) {
+      auto bytes = BlobStat::sizeBytes(*result[i]);
+      CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+      using std::swap;
+      swap(*(inputs[i]), *(result[i]));
+    }
+    CAFFE_EVENT(stats_, queue_dequeued_records);
+    // the slot is written next one lap later
+    sequences_[slot].store(pos + r + capacity_, std::memory_order_release);
+  }
+  CAFFE_EVENT(stats_, queue_occupancy, occupancy());
+  notify(writers_cv_, waiting_writers_);
+  return claimed;
+}
+
+size_t LockFreeBlobsQueue::tryWriteMany(
+    const std::vector<Blob*>* records,
+    size_t count) {
+  int64_t pos = tail_.load(std::memory_order_relaxed);
+  int64_t claimed = 0;
+  while (true) {
+    // the positions from pos on whose slots were read
+    claimed = 0;
+    while (claimed < static_cast<int64_t>(count) &&
+           sequences_[(pos + claimed) % capacity_].load(
+               std::memory_order_acquire) == pos + claimed) {
+      ++claimed;
+    }
+    if (claimed == 0) {
+      if (sequences_[pos % capacity_].load(std::memory_order_acquire) < pos) {
+        // full
+        return 0;
+      }
+      // another writer took pos
+      pos = tail_.load(std::memory_order_relaxed);
+      continue;
+    }
+    if (tail_.compare_exchange_weak(
+            pos, pos + claimed, std::memory_order_relaxed)) {
+      break;
+    }
+  }
+
+  for (int64_t r = 0; r < claimed; ++r) {
+    const auto slot = (pos + r) % capacity_;
+    auto& result = queue_[slot];
+    const auto& inputs = records[r];
+    for (size_t i = 0; i < result.size(); ++i) {
+      using std::swap;
+      swap(*(inputs[i]), *(result[i]));
+    }
+    sequences_[slot].store(pos + r + 1, std::memory_order_release);
+  }
+  CAFFE_EVENT(stats_, queue_occupancy, occupancy());
+  notify(readers_cv_, waiting_readers_);
+  return claimed;
+}
+
+bool LockFreeBlobsQueue::wait(
+    std::condition_variable& cv,
+    std::atomic<int>& waiting,
+    const std::function<bool()>& ready,
+    const std::chrono::steady_clock::time_point* deadline) {
+  std::unique_lock<std::mutex> g(wait_mutex_);
+  // Announce the wait before checking the queue again, see notify()
+  ++waiting;
+  bool result = true;
+  if (deadline) {
+    result = cv.wait_until(g, *deadline, ready);
+  } else {
+    cv.wait(g, ready);
+  }
+  --waiting;
+  return result;
+}
+
+void LockFreeBlobsQueue::notify(
+    std::condition_variable& cv,
+    std::atomic<int>& waiting) {
+  // Orders the sequence number stores of the caller before the check, so
+  // either a waiter sees the new record or we see the waiter.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (waiting.load() > 0) {
+    std::lock_guard<std::mutex> g(wait_mutex_);
+    cv.notify_all();
+  }
+}
+
+int64_t LockFreeBlobsQueue::occupancy() const {
+  return tail_.load(std::memory_order_relaxed) -
+      head_.load(std::memory_order_relaxed);
+}
+
+} // namespace caffe2
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+#include "caffe2/queue/blobs_queue.h"
+
+namespace caffe2 {
+
+// A BlobsQueue whose readers and writers don't take a lock unless they have
+// to wait for an empty or full queue.
+//
+// Modelled as a bounded multi-producer, multi-consumer ring: every slot has a
+// sequence number telling the position it can next be written or read at, and
+// readers and writers claim positions by advancing their counter with a CAS.
+// Batched reads and writes claim all the consecutive positions they can at
+// once. As in BlobsQueue, records are moved in and out of the queue by
+// swapping blobs, without copying their tensors.
+class CAFFE2_API LockFreeBlobsQueue : public BlobsQueue {
+ public:
+  LockFreeBlobsQueue(
+      Workspace* ws,
+      const std::string& queueName,
+      size_t capacity,
+      size_t numBlobs,
+      bool enforceUniqueName,
+      const std::vector<std::string>& fieldNames = {});
+
+  ~LockFreeBlobsQueue() override {
+    close();
+  }
+
+  bool blockingRead(const std::vector<Blob*>& inputs, float timeout_secs = 0.0f)
+      override;
+  bool tryWrite(const std::vector<Blob*>& inputs) override;
+  bool blockingWrite(const std::vector<Blob*>& inputs) override;
+  size_t blockingReadMany(
+      const std::vector<std::vector<Blob*>>& records,
+      float timeout_secs = 0.0f) override;
+  size_t blockingWriteMany(
+      const std::vector<std::vector<Blob*>>& records) override;
+  void close() override;
+
+ private:
+  // Read or write the `count` records at `records`, and return how many
+  // were. Blocking reads give up after `timeout_secs` if positive.
+  size_t readMany(
+      const std::vector<Blob*>* records,
+      size_t count,
+      float timeout_secs);
+  size_t writeMany(
+      const std::vector<Blob*>* records,
+      size_t count,
+      bool blocking);
+
+  // Read or write up to `count` records without blocking.
+  size_t tryReadMany(const std::vector<Blob*>* records, size_t count);
+  size_t tryWriteMany(const std::vector<Blob*>* records, size_t count);
+
+  // Waits for the other side to make progress, until `deadline` if given.
+  // Returns false on a timeout.
+  bool wait(
+      std::condition_variable& cv,
+      std::atomic<int>& waiting,
+      const std::function<bool()>& ready,
+      const std::chrono::steady_clock::time_point* deadline);
+  void notify(std::condition_variable& cv, std::atomic<int>& waiting);
+
+  int64_t occupancy() const;
+
+  const int64_t capacity_;
+  std::unique_ptr<std::atomic<int64_t>[]> sequences_;
+  // next positions to read and write, on their own cache lines
+  alignas(64) std::atomic<int64_t> head_{0};
+  alignas(64) std::atomic<int64_t> tail_{0};
+
+  // only used to sleep on an empty or full queue
+  std::mutex wait_mutex_;
+  std::condition_variable readers_cv_;
+  std::condition_variable writers_cv_;
+  std::atomic<int> waiting_readers_{0};
+  std::atomic<int> waiting_writers_{0};
+};
+
+} // namespace caffe2
@@ -3,6 +3,7 @@
 #include <memory>
 #include "blobs_queue.h"
 #include "caffe2/core/operator.h"
+#include "caffe2/queue/lock_free_blobs_queue.h"
 #include "caffe2/utils/math.h"
 
 namespace caffe2 {
@@ -24,12 +25,18 @@ class CreateBlobsQueueOp final : public Operator<Context> {
         GetSingleArgument("enforce_unique_name", false);
     const auto fieldNames =
         OperatorBase::template GetRepeatedArgument<std::string>("field_names");
+    const auto lockFree = GetSingleArgument("lock_free", false);
     CAFFE_ENFORCE_EQ(this->OutputSize(), 1);
     auto queuePtr = Operator<Context>::Outputs()[0]
                         ->template GetMutable<std::shared_ptr<BlobsQueue>>();
     CAFFE_ENFORCE(queuePtr);
-    *queuePtr = std::make_shared<BlobsQueue>(
-        ws_, name, capacity, numBlobs, enforceUniqueName, fieldNames);
+    if (lockFree) {
+      *queuePtr = std::make_shared<LockFreeBlobsQueue>(
+          ws_, name, capacity, numBlobs, enforceUniqueName, fieldNames);
+    } else {
+      *queuePtr = std::make_shared<BlobsQueue>(
+          ws_, name, capacity, numBlobs, enforceUniqueName, fieldNames);
+    }
     return true;
   }
 
@@ -130,23 +137,27 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
   bool dequeueMany(std::shared_ptr<BlobsQueue>& queue) {
     auto size = queue->getNumBlobs();
 
-    if (blobs_.size() != size) {
-      blobs_.resize(size);
-      blobPtrs_.resize(size);
-      for (int col = 0; col < size; ++col) {
-        blobPtrs_.at(col) = &blobs_.at(col);
+    if (blobs_.size() != numRecords_ * size) {
+      blobs_.resize(numRecords_ * size);
+      records_.assign(numRecords_, std::vector<Blob*>(size));
+      for (int i = 0; i < numRecords_; ++i) {
+        for (int col = 0; col < size; ++col) {
+          records_.at(i).at(col) = &blobs_.at(i * size + col);
+        }
       }
     }
 
+    // if we read at least one record, status is still true
+    const auto numRead = queue->blockingReadMany(records_);
+    if (numRead == 0) {
+      return false;
+    }
+
     const int kTensorGrowthPct = 40;
-    for (int i = 0; i < numRecords_; ++i) {
-      if (!queue->blockingRead(blobPtrs_)) {
-        // if we read at least one record, status is still true
-        return i > 0;
-      }
+    for (int i = 0; i < numRead; ++i) {
       for (int col = 0; col < size; ++col) {
         auto* out = this->Output(col);
-        const auto& in = blobPtrs_.at(col)->template Get<Tensor>();
+        const auto& in = records_.at(i).at(col)->template Get<Tensor>();
         if (i == 0) {
           out->CopyFrom(in);
         } else {
@@ -195,7 +206,7 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
  private:
   int numRecords_;
   std::vector<Blob> blobs_;
-  std::vector<Blob*> blobPtrs_;
+  std::vector<std::vector<Blob*>> records_;
 };
 
 template <typename Context>
@@ -1,15 +1,21 @@
 #include "rebatching_queue.h"
 #include "caffe2/utils/smart_tensor_printer.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace caffe2 {
 
 namespace {
 
-// This concat function will always create a new first dimension to concat
+// This concat function will always create a new first dimension to concat.
+// With `pad`, the inputs can differ in their own first dimension, and are
+// padded to the longest one.
 void concat(
     CPUContext& context,
     const std::vector<std::vector<TensorCPU>>& inputs,
-    const std::vector<TensorCPU*>& outputs) {
+    const std::vector<TensorCPU*>& outputs,
+    bool pad = false) {
   CAFFE_ENFORCE(!inputs.empty());
 
   const auto& inputZero = inputs[0];
@@ -22,6 +28,13 @@ void concat(
   for (size_t i = 0; i < numTensors; ++i) {
     SmartTensorPrinter::PrintTensor(inputZero.at(i));
     outputDims[i] = inputZero.at(i).sizes().vec();
+    if (pad && !outputDims[i].empty()) {
+      for (const auto& row : inputs) {
+        CAFFE_ENFORCE_EQ(row.size(), numTensors);
+        CAFFE_ENFORCE_EQ(row[i].dim(), outputDims[i].size());
+        outputDims[i][0] = std::max(outputDims[i][0], row[i].size(0));
+      }
+    }
     outputDims[i].insert(outputDims[i].begin(), numRows);
   }
 
@@ -41,24 +54,32 @@ void concat(
       CAFFE_ENFORCE(inputZero[j].meta() == input.dtype());
       CAFFE_ENFORCE_EQ(inputZero[j].itemsize(), input.itemsize());
       CAFFE_ENFORCE_EQ(inputZero[j].ndim(), input.dim());
-      for (int k = 0; k < input.dim(); ++k) {
+      for (int k = pad ? 1 : 0; k < input.dim(); ++k) {
         CAFFE_ENFORCE_EQ(input.sizes()[k], inputZero[j].size(k));
       }
 
+      // Without padding, the rows are exactly as large as the inputs
+      const auto rowSize = outputs[j]->size_from_dim(1);
+
       // Skip empty tensors
-      if (input.numel() == 0) {
-        continue;
+      if (input.numel() > 0) {
+        context.CopyItemsToCPU(
+            input.dtype(),
+            input.numel(),
+            input.raw_data() /* src */,
+            destinations[j] /* dst */
+        );
       }
 
-      context.CopyItemsToCPU(
-          input.dtype(),
-          input.numel(),
-          input.raw_data() /* src */,
-          destinations[j] /* dst */
-      );
+      // Non-POD types are default constructed by raw_mutable_data()
+      if (rowSize > input.numel() && !input.dtype().placementNew()) {
+        memset(
+            (char*)destinations[j] + input.numel() * input.itemsize(),
+            0,
+            (rowSize - input.numel()) * input.itemsize());
+      }
 
-      destinations[j] =
-          (char*)destinations[j] + input.numel() * input.itemsize();
+      destinations[j] = (char*)destinations[j] + rowSize * input.itemsize();
     }
   }
 }
@@ -231,4 +252,204 @@ void RebatchingQueue::close() {
   cvEmpty_.notify_all();
   cvOverflow_.notify_all();
 }
+
+BucketedRebatchingQueue::BucketedRebatchingQueue(
+    const std::string& name,
+    size_t capacity,
+    size_t numBlobs,
+    size_t lengthBlob,
+    const std::vector<int64_t>& bucketBoundaries,
+    int64_t maxStalenessMs)
+    : RebatchingQueue(capacity, numBlobs),
+      lengthBlob_(lengthBlob),
+      bucketBoundaries_(bucketBoundaries),
+      maxStaleness_(maxStalenessMs),
+      buckets_(bucketBoundaries.size() + 1),
+      stats_(name) {
+  CAFFE_ENFORCE_GT(capacity, 0);
+  CAFFE_ENFORCE_LT(lengthBlob, numBlobs);
+  CAFFE_ENFORCE_GE(maxStalenessMs, 0);
+  CAFFE_ENFORCE(
+      std::is_sorted(bucketBoundaries_.begin(), bucketBoundaries_.end()),
+      "The bucket boundaries have to be sorted");
+
+  std::vector<std::string> bucketNames;
+  for (size_t i = 0; i < buckets_.size(); ++i) {
+    bucketNames.push_back("bucket_" + c10::to_string(i));
+  }
+  stats_.bucket_dequeued_elements.setDetails(bucketNames);
+}
+
+size_t BucketedRebatchingQueue::numBuckets() const {
+  return buckets_.size();
+}
+
+float BucketedRebatchingQueue::paddingEfficiency() const {
+  std::lock_guard<std::mutex> g(mutex_);
+  return paddedLength_ > 0 ? float(validLength_) / paddedLength_ : 1.0f;
+}
+
+size_t BucketedRebatchingQueue::bucketOf(
+    const std::vector<TensorCPU>& tensors) const {
+  CAFFE_ENFORCE_EQ(tensors.size(), numBlobs_);
+  const auto& lengthTensor = tensors[lengthBlob_];
+  CAFFE_ENFORCE_GT(
+      lengthTensor.dim(), 0, "The length blob can't hold scalar elements");
+  return std::lower_bound(
+             bucketBoundaries_.begin(),
+             bucketBoundaries_.end(),
+             lengthTensor.size(0)) -
+      bucketBoundaries_.begin();
+}
+
+bool BucketedRebatchingQueue::enqueue(
+    std::vector<std::vector<TensorCPU>> splittedInputs) {
+  std::vector<size_t> buckets;
+  buckets.reserve(splittedInputs.size());
+  for (const auto& tensors : splittedInputs) {
+    buckets.push_back(bucketOf(tensors));
+  }
+
+  size_t idx = 0;
+  for (;;) {
+    if (idx >= splittedInputs.size()) {
+      break;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      cvOverflow_.wait(
+          lock, [this] { return size_ < capacity() || isClosed_; });
+
+      if (isClosed_) {
+        return false;
+      }
+
+      const auto now = Clock::now();
+      do {
+        buckets_[buckets[idx]].push_back(
+            Element{std::move(splittedInputs[idx]), now});
+        ++idx;
+        ++size_;
+      } while (size_ < capacity() && idx < splittedInputs.size());
+    }
+
+    cvEmpty_.notify_all();
+  }
+
+  return true;
+}
+
+int BucketedRebatchingQueue::pickBucket(
+    size_t numElements,
+    bool* partial,
+    Clock::time_point* deadline) const {
+  int full = -1;
+  int oldest = -1;
+  int largest = -1;
+  for (int i = 0; i < buckets_.size(); ++i) {
+    const auto& bucket = buckets_[i];
+    if (bucket.empty()) {
+      continue;
+    }
+    const auto enqueueTime = bucket.front().enqueueTime;
+    if (bucket.size() >= numElements &&
+        (full < 0 || enqueueTime < buckets_[full].front().enqueueTime)) {
+      full = i;
+    }
+    if (oldest < 0 || enqueueTime < buckets_[oldest].front().enqueueTime) {
+      oldest = i;
+    }
+    if (largest < 0 || bucket.size() > buckets_[largest].size()) {
+      largest = i;
+    }
+  }
+
+  *partial = false;
+  if (full >= 0) {
+    return full;
+  }
+  if (oldest < 0) {
+    return -1;
+  }
+
+  *partial = true;
+  if (isClosed_) {
+    return oldest;
+  }
+  // No writer can fill up a bucket anymore
+  if (size_ >= capacity()) {
+    return largest;
+  }
+  const auto due = buckets_[oldest].front().enqueueTime + maxStaleness_;
+  if (Clock::now() >= due) {
+    return oldest;
+  }
+  *deadline = due;
+  return -1;
+}
+
+bool BucketedRebatchingQueue::dequeue(
+    CPUContext& context,
+    size_t numElements,
+    const std::vector<TensorCPU*>& outputs) {
+  CAFFE_ENFORCE_GT(numElements, 0);
+
+  std::vector<std::vector<TensorCPU>> results;
+  results.reserve(numElements);
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    int bucket = -1;
+    bool partial = false;
+    for (;;) {
+      Clock::time_point deadline;
+      bucket = pickBucket(numElements, &partial, &deadline);
+      if (bucket >= 0) {
+        break;
+      }
+      if (size_ == 0) {
+        // We only want to stop reading if the queue is empty and closed
+        if (isClosed_) {
+          return false;
+        }
+        cvEmpty_.wait(lock);
+      } else {
+        cvEmpty_.wait_until(lock, deadline);
+      }
+    }
+
+    auto& elements = buckets_[bucket];
+    int64_t validLength = 0;
+    int64_t maxLength = 0;
+    while (!elements.empty() && results.size() < numElements) {
+      results.push_back(std::move(elements.front().tensors));
+      elements.pop_front();
+      const auto length = results.back()[lengthBlob_].size(0);
+      validLength += length;
+      maxLength = std::max(maxLength, length);
+    }
+    size_ -= results.size();
+
+    const int64_t paddedLength = maxLength * results.size();
+    validLength_ += validLength;
+    paddedLength_ += paddedLength;
+
+    CAFFE_EVENT(stats_, dequeued_batches);
+    if (partial) {
+      CAFFE_EVENT(stats_, partial_batches);
+    }
+    CAFFE_EVENT(stats_, bucket_dequeued_elements, results.size(), bucket);
+    CAFFE_EVENT(stats_, valid_length, validLength);
+    CAFFE_EVENT(stats_, padded_length, paddedLength);
+  }
+
+  cvOverflow_.notify_all();
+
+  concat(context, results, outputs, true);
+
+  return true;
+}
 } // caffe2
@@ -1,7 +1,9 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <queue>
@@ -21,7 +23,7 @@ class RebatchingQueue {
  public:
   RebatchingQueue(size_t capacity, size_t numBlobs);
 
-  ~RebatchingQueue();
+  virtual ~RebatchingQueue();
 
   bool enqueueOne(
       CPUContext& context,
@@ -31,7 +33,7 @@ class RebatchingQueue {
       CPUContext& context,
       const std::vector<const TensorCPU*>& inputs);
 
-  bool dequeue(
+  virtual bool dequeue(
       CPUContext& context,
       size_t numElements,
       const std::vector<TensorCPU*>& outputs);
@@ -44,11 +46,8 @@ class RebatchingQueue {
 
   void close();
 
- private:
-  bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs);
-
-  bool canWrite() const;
-  bool canRead() const;
+ protected:
+  virtual bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs);
 
   const size_t capacity_;
   const size_t numBlobs_;
@@ -57,12 +56,96 @@ class RebatchingQueue {
 
   bool isClosed_{false};
 
-  uint64_t head_{0};
-  uint64_t tail_{0};
-
   std::condition_variable cvEmpty_;
   std::condition_variable cvOverflow_;
 
+ private:
+  bool canWrite() const;
+  bool canRead() const;
+
+  uint64_t head_{0};
+  uint64_t tail_{0};
+
   std::vector<std::vector<TensorCPU>> queue_;
 };
+
+// A RebatchingQueue for elements of different lengths, e.g. sequences, that
+// batches elements of similar lengths together.
+//
+// The length of an element is the first dimension of its `lengthBlob`
+// component. Elements are staged in buckets by length: bucket i holds the
+// lengths in (bucketBoundaries[i - 1], bucketBoundaries[i]], and the last
+// bucket the lengths above all boundaries. Every dequeued batch comes from a
+// single bucket, and the components whose first dimension differs between
+// the elements of a batch are padded to the longest of them, with zeros for
+// POD types.
+//
+// A batch is dequeued once its bucket holds `numElements` elements. A smaller
+// one is dequeued from the bucket with the oldest element once that element
+// waited `maxStalenessMs`, or the queue is closed, and from the largest
+// bucket when the queue is full.
+class BucketedRebatchingQueue : public RebatchingQueue {
+ public:
+  BucketedRebatchingQueue(
+      const std::string& name,
+      size_t capacity,
+      size_t numBlobs,
+      size_t lengthBlob,
+      const std::vector<int64_t>& bucketBoundaries,
+      int64_t maxStalenessMs);
+
+  bool dequeue(
+      CPUContext& context,
+      size_t numElements,
+      const std::vector<TensorCPU*>& outputs) override;
+
+  size_t numBuckets() const;
+
+  // The fraction of the length dimension of the dequeued batches that isn't
+  // padding, over the lifetime of the queue.
+  float paddingEfficiency() const;
+
+ protected:
+  bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs) override;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Element {
+    std::vector<TensorCPU> tensors;
+    Clock::time_point enqueueTime;
+  };
+
+  size_t bucketOf(const std::vector<TensorCPU>& tensors) const;
+
+  // Returns the bucket to dequeue from, or -1 if no batch is ready. Sets
+  // `partial` if the batch won't be full, and `deadline` to the time a
+  // partial batch gets ready if none is.
+  int pickBucket(
+      size_t numElements,
+      bool* partial,
+      Clock::time_point* deadline) const;
+
+  const size_t lengthBlob_;
+  const std::vector<int64_t> bucketBoundaries_;
+  const std::chrono::milliseconds maxStaleness_;
+
+  // guarded by mutex_
+  std::vector<std::deque<Element>> buckets_;
+  size_t size_{0};
+  int64_t validLength_{0};
+  int64_t paddedLength_{0};
+
+  struct BucketStats {
+    CAFFE_STAT_CTOR(BucketStats);
+    CAFFE_EXPORTED_STAT(dequeued_batches);
+    // batches dequeued before their bucket held numElements elements
+    CAFFE_EXPORTED_STAT(partial_batches);
+    CAFFE_DETAILED_EXPORTED_STAT(bucket_dequeued_elements);
+    // summed length of the dequeued elements, and of the padded batches;
+    // their ratio is the padding efficiency
+    CAFFE_EXPORTED_STAT(valid_length);
+    CAFFE_EXPORTED_STAT(padded_length);
+  } stats_;
+};
 } // caffe2
@@ -26,7 +26,22 @@ Creates the Queue.
     .Arg("num_blobs", "Number of input tensors the queue will support")
     .Arg(
         "capacity",
-        "Maximal number of elements the queue can hold at any given point");
+        "Maximal number of elements the queue can hold at any given point")
+    .Arg(
+        "bucket_boundaries",
+        "If set, the queue batches elements of similar lengths together: "
+        "bucket i holds the lengths in (bucket_boundaries[i - 1], "
+        "bucket_boundaries[i]], one more bucket the longer ones. Every "
+        "dequeued batch comes from a single bucket, and is padded to its "
+        "longest element.")
+    .Arg(
+        "length_blob",
+        "With bucket_boundaries, the component whose first dimension is the "
+        "length of an element. Default 0.")
+    .Arg(
+        "max_staleness_ms",
+        "With bucket_boundaries, how long an element waits for its bucket to "
+        "fill up a batch before a smaller batch is dequeued. Default 100.");
 
 OPERATOR_SCHEMA(CloseRebatchingQueue)
     .NumInputs(1)
@@ -62,6 +77,10 @@ Dequeue Tensors from the Queue.
 If the Queue is closed this might return less elements than asked.
 If num_elements > 1 the returned elements will be concatenated into one
 tensor per component.
+If the queue was created with bucket_boundaries, the returned elements have
+similar lengths, the components that differ in their first dimension are
+padded with zeros to the longest element, and fewer than num_elements
+elements might be returned once max_staleness_ms passed.
 )DOC")
     .Input(0, "rebatching_queue", "object representing the queue")
     .Input(1, "tensor", "First tensor to enqueue")
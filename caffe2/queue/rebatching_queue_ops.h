@@ -12,10 +12,22 @@ class CreateRebatchingQueueOp : public Operator<CPUContext> {
       : Operator(operator_def, ws) {}
 
   bool RunOnDevice() override {
+    const auto capacity = OperatorBase::GetSingleArgument<int>("capacity", 1);
+    const auto numBlobs = OperatorBase::GetSingleArgument<int>("num_blobs", 1);
+    if (OperatorBase::HasArgument("bucket_boundaries")) {
+      *OperatorBase::Output<RebatchingQueuePtr>(0) =
+          RebatchingQueuePtr(new BucketedRebatchingQueue(
+              debug_def().output(0),
+              capacity,
+              numBlobs,
+              OperatorBase::GetSingleArgument<int>("length_blob", 0),
+              OperatorBase::GetRepeatedArgument<int64_t>("bucket_boundaries"),
+              OperatorBase::GetSingleArgument<int64_t>(
+                  "max_staleness_ms", 100)));
+      return true;
+    }
     *OperatorBase::Output<RebatchingQueuePtr>(0) =
-        RebatchingQueuePtr(new RebatchingQueue(
-            OperatorBase::GetSingleArgument<int>("capacity", 1),
-            OperatorBase::GetSingleArgument<int>("num_blobs", 1)));
+        RebatchingQueuePtr(new RebatchingQueue(capacity, numBlobs));
     return true;
   }
 };
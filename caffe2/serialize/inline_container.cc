@@ -13,6 +13,7 @@
 #include "caffe2/serialize/file_adapter.h"
 #include "caffe2/serialize/inline_container.h"
 #include "caffe2/serialize/istream_adapter.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
 #include "caffe2/serialize/read_adapter_interface.h"
 
 #include "miniz.h"
@@ -52,7 +53,7 @@ size_t PyTorchStreamReader::read(uint64_t pos, char* buf, size_t n) {
 
 PyTorchStreamReader::PyTorchStreamReader(const std::string& file_name)
     : ar_(caffe2::make_unique<mz_zip_archive>()),
-      in_(caffe2::make_unique<FileAdapter>(file_name)) {
+      in_(caffe2::make_unique<MmapFileAdapter>(file_name)) {
   init();
 }
 
@@ -130,6 +131,15 @@ void PyTorchStreamReader::init() {
       ", but the maximum supported version for reading is ",
       kMaxSupportedFileFormatVersion,
       ". Your PyTorch installation may be too old.");
+
+  if (version_ >= kProducedAlignedFileFormatVersion) {
+    at::DataPtr alignment_ptr;
+    size_t alignment_size;
+    std::tie(alignment_ptr, alignment_size) = getRecord("alignment");
+    std::string alignment(
+        static_cast<const char*>(alignment_ptr.get()), alignment_size);
+    record_alignment_ = caffe2::stoull(alignment);
+  }
 }
 
 void PyTorchStreamReader::valid(const char* what, const char* info) {
@@ -148,7 +158,11 @@ constexpr int MZ_ZIP_LOCAL_DIR_HEADER_SIZE = 30;
 constexpr int MZ_ZIP_LDH_FILENAME_LEN_OFS = 26;
 constexpr int MZ_ZIP_LDH_EXTRA_LEN_OFS = 28;
 
-static std::string getPadding(size_t cursor, const std::string& filename, size_t size) {
+static std::string getPadding(
+    size_t cursor,
+    const std::string& filename,
+    size_t size,
+    uint64_t alignment) {
   size_t start = cursor + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename.size() + sizeof(mz_uint16) * 2;
   if (size >= MZ_UINT32_MAX || cursor >= MZ_UINT32_MAX) {
     start += sizeof(mz_uint16) * 2;
@@ -159,8 +173,8 @@ static std::string getPadding(size_t cursor, const std::string& filename, size_t
       start += sizeof(mz_uint64);
     }
   }
-  size_t mod = start % kFieldAlignment;
-  size_t next_offset = (mod == 0) ? start : (start + kFieldAlignment - mod);
+  size_t mod = start % alignment;
+  size_t next_offset = (mod == 0) ? start : (start + alignment - mod);
   size_t padding_size = next_offset - start;
   std::string buf(padding_size + 4, 'Z');
   // zip extra encoding (key, size_of_extra_bytes)
@@ -192,12 +206,46 @@ size_t PyTorchStreamReader::getRecordID(const std::string& name) {
   return result;
 }
 
+static int64_t read_le_16(uint8_t* buf) {
+  return buf[0] + (buf[1] << 8);
+}
+
+// offset of the data of the record whose local header is at
+// local_header_ofs
+static size_t dataOffset(ReadAdapterInterface& in, uint64_t local_header_ofs) {
+  uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
+  in.read(
+      local_header_ofs,
+      local_header,
+      MZ_ZIP_LOCAL_DIR_HEADER_SIZE,
+      "reading file header");
+  size_t filename_len = read_le_16(local_header + MZ_ZIP_LDH_FILENAME_LEN_OFS);
+  size_t extra_len = read_le_16(local_header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
+  return local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len + extra_len;
+}
+
 // return dataptr, size
 std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string& name) {
   size_t key = getRecordID(name);
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), key, &stat);
   valid("retrieving file meta-data for ", name.c_str());
+
+  // Records that are stored uncompressed and aligned (everything written by
+  // PyTorchStreamWriter is) are returned without a copy if the adapter can
+  // alias them, e.g. when the archive is memory mapped. Note that unlike
+  // extraction, aliasing doesn't verify the CRC of the record.
+  if (stat.m_method == 0 && !stat.m_is_encrypted &&
+      stat.m_comp_size == stat.m_uncomp_size) {
+    size_t offset = dataOffset(*in_, stat.m_local_header_ofs);
+    if (offset % kFieldAlignment == 0) {
+      at::DataPtr alias = in_->alias(offset, stat.m_uncomp_size);
+      if (alias) {
+        return std::make_tuple(std::move(alias), stat.m_uncomp_size);
+      }
+    }
+  }
+
   void * ptr = malloc(stat.m_uncomp_size);
   mz_zip_reader_extract_to_mem(ar_.get(), key, ptr, stat.m_uncomp_size, 0);
   valid("reading file ", name.c_str());
@@ -206,23 +254,11 @@ std::tuple<at::DataPtr, size_t> PyTorchStreamReader::getRecord(const std::string
   return std::make_tuple(std::move(retval), stat.m_uncomp_size);
 }
 
-static int64_t read_le_16(uint8_t* buf) {
-  return buf[0] + (buf[1] << 8);
-}
-
 size_t PyTorchStreamReader::getRecordOffset(const std::string& name) {
   mz_zip_archive_file_stat stat;
   mz_zip_reader_file_stat(ar_.get(), getRecordID(name), &stat);
   valid("retrieving file meta-data for ", name.c_str());
-  uint8_t local_header[MZ_ZIP_LOCAL_DIR_HEADER_SIZE];
-  in_->read(
-      stat.m_local_header_ofs,
-      local_header,
-      MZ_ZIP_LOCAL_DIR_HEADER_SIZE,
-      "reading file header");
-  size_t filename_len = read_le_16(local_header + MZ_ZIP_LDH_FILENAME_LEN_OFS);
-  size_t extra_len = read_le_16(local_header + MZ_ZIP_LDH_EXTRA_LEN_OFS);
-  return stat.m_local_header_ofs + MZ_ZIP_LOCAL_DIR_HEADER_SIZE + filename_len + extra_len;
+  return dataOffset(*in_, stat.m_local_header_ofs);
 }
 
 
@@ -248,14 +284,19 @@ size_t ostream_write_func(
   return ret;
 }
 
-PyTorchStreamWriter::PyTorchStreamWriter(std::string file_name)
-    : archive_name_(basename(file_name)) {
+PyTorchStreamWriter::PyTorchStreamWriter(
+    std::string file_name,
+    uint64_t alignment)
+    : alignment_(alignment), archive_name_(basename(file_name)) {
   setup(file_name);
 }
 
 PyTorchStreamWriter::PyTorchStreamWriter(
-    const std::function<size_t(const void*, size_t)>& writer_func)
-    : archive_name_("archive"), writer_func_(writer_func) {
+    const std::function<size_t(const void*, size_t)>& writer_func,
+    uint64_t alignment)
+    : alignment_(alignment),
+      archive_name_("archive"),
+      writer_func_(writer_func) {
   setup(archive_name_);
 }
 
@@ -267,6 +308,16 @@ void PyTorchStreamWriter::setup(const string& file_name) {
   if (archive_name_.size() == 0) {
     CAFFE_THROW("invalid file name: ", file_name);
   }
+  if (alignment_ < kFieldAlignment || alignment_ > kMaxFieldAlignment ||
+      (alignment_ & (alignment_ - 1)) != 0) {
+    CAFFE_THROW(
+        "invalid record alignment ",
+        alignment_,
+        ", expected a power of two between ",
+        kFieldAlignment,
+        " and ",
+        kMaxFieldAlignment);
+  }
   if (!writer_func_) {
     file_stream_.open(
         file_name,
@@ -285,8 +336,17 @@ void PyTorchStreamWriter::setup(const string& file_name) {
   valid("initializing archive ", file_name.c_str());
 
   std::ostringstream version;
-  version << kProducedFileFormatVersion << "\n";
+  if (alignment_ == kFieldAlignment) {
+    version << kProducedFileFormatVersion << "\n";
+  } else {
+    version << kProducedAlignedFileFormatVersion << "\n";
+  }
   writeRecord("version", version.str().c_str(), version.str().size());
+  if (alignment_ != kFieldAlignment) {
+    std::ostringstream alignment;
+    alignment << alignment_ << "\n";
+    writeRecord("alignment", alignment.str().c_str(), alignment.str().size());
+  }
 }
 
 void PyTorchStreamWriter::writeRecord(
@@ -297,7 +357,8 @@ void PyTorchStreamWriter::writeRecord(
   AT_ASSERT(!finalized_);
   AT_ASSERT(!archive_name_plus_slash_.empty());
   std::string full_name = archive_name_plus_slash_ + name;
-  std::string padding = getPadding(ar_->m_archive_size, full_name, size);
+  std::string padding =
+      getPadding(ar_->m_archive_size, full_name, size, alignment_);
   uint32_t flags = compress ? MZ_BEST_COMPRESSION : 0;
   mz_zip_writer_add_mem_ex_v2(
       ar_.get(),
@@ -41,7 +41,9 @@ typedef struct mz_zip_archive mz_zip_archive;
 // 1. All files are stored uncompressed.
 // 2. All files in the archive are aligned to 64 byte boundaries such that
 //    it is possible to mmap the entire file and get an aligned pointer to
-//    tensor data.
+//    tensor data. A larger alignment (e.g. the page size) can be requested,
+//    in which case an `alignment` record is added and the archive is
+//    written as version 3.
 // 3. We universally write in ZIP64 format for consistency.
 
 // The PyTorchStreamReader also provides additional properties:
@@ -51,6 +53,9 @@ typedef struct mz_zip_archive mz_zip_archive;
 // 2. It provides a getRecordOffset function which returns the offset into the
 //    raw file where file data lives. If the file was written with PyTorchStreamWriter
 //    it is guarenteed to be 64 byte aligned.
+// 3. When reading from a file name, the file is memory mapped, and getRecord
+//    returns uncompressed, aligned records without copying them: the DataPtr
+//    points into the mapping (see MmapFileAdapter).
 
 // PyTorchReader/Writer handle checking the version number on the archive format
 // and ensure that all files are written to a archive_name directory so they
@@ -90,11 +95,18 @@ namespace caffe2 {
 namespace serialize {
 
 constexpr uint64_t kMinSupportedFileFormatVersion = 0x1L;
-constexpr uint64_t kMaxSupportedFileFormatVersion = 0x2L;
+constexpr uint64_t kMaxSupportedFileFormatVersion = 0x3L;
 constexpr uint64_t kProducedFileFormatVersion = 0x1L;
+// Version 3 archives have an "alignment" record holding the boundary (a
+// multiple of kFieldAlignment) that the data of every record is aligned to.
+// The writer only produces it when asked for an alignment other than the
+// default, so that archives stay readable by older readers.
+constexpr uint64_t kProducedAlignedFileFormatVersion = 0x3L;
 
 // Writer-specific constants
 constexpr uint64_t kFieldAlignment = 64;
+// Padding is stored in a zip extra field, whose length is 16 bits.
+constexpr uint64_t kMaxFieldAlignment = 32768;
 
 class CAFFE2_API PyTorchStreamReader final {
  public:
@@ -111,6 +123,11 @@ class CAFFE2_API PyTorchStreamReader final {
   uint64_t version() const {
     return version_;
   }
+  // Boundary that the data of every record in the archive is aligned to, if
+  // the archive was written by PyTorchStreamWriter.
+  uint64_t recordAlignment() const {
+    return record_alignment_;
+  }
  private:
   void init();
   size_t read(uint64_t pos, char* buf, size_t n);
@@ -124,13 +141,20 @@ class CAFFE2_API PyTorchStreamReader final {
   std::string archive_name_plus_slash_;
   std::unique_ptr<ReadAdapterInterface> in_;
   int64_t version_;
+  uint64_t record_alignment_ = kFieldAlignment;
 };
 
 class CAFFE2_API PyTorchStreamWriter final {
  public:
-  explicit PyTorchStreamWriter(std::string archive_name);
+  // `alignment` is the boundary that the data of every record starts on. It
+  // must be a power of two between kFieldAlignment and kMaxFieldAlignment,
+  // e.g. the page size to allow O_DIRECT reads of the records.
+  explicit PyTorchStreamWriter(
+      std::string archive_name,
+      uint64_t alignment = kFieldAlignment);
   explicit PyTorchStreamWriter(
-      const std::function<size_t(const void*, size_t)>& writer_func);
+      const std::function<size_t(const void*, size_t)>& writer_func,
+      uint64_t alignment = kFieldAlignment);
 
   void writeRecord(
       const std::string& name,
@@ -153,6 +177,7 @@ class CAFFE2_API PyTorchStreamWriter final {
   void setup(const string& file_name);
   void valid(const char* what, const char* info = "");
   size_t current_pos_ = 0;
+  uint64_t alignment_;
   std::unique_ptr<mz_zip_archive> ar_;
   std::string archive_name_;
   std::string archive_name_plus_slash_;
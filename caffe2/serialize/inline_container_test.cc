@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 
 #include "caffe2/serialize/inline_container.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
 
 namespace caffe2 {
 namespace serialize {
@@ -63,6 +64,79 @@ TEST(PyTorchStreamWriterAndReader, SaveAndLoad) {
   ASSERT_EQ(memcmp(the_file.c_str() + off2, data2.data(), data2.size()), 0);
 }
 
+TEST(PyTorchStreamWriterAndReader, PageAlignment) {
+  constexpr int64_t kPageSize = 4096;
+  std::ostringstream oss;
+  PyTorchStreamWriter writer(
+      [&](const void* b, size_t n) -> size_t {
+        oss.write(static_cast<const char*>(b), n);
+        return oss ? n : 0;
+      },
+      kPageSize);
+  std::array<char, 127> data1;
+  for (int i = 0; i < data1.size(); ++i) {
+    data1[i] = data1.size() - i;
+  }
+  writer.writeRecord("key1", data1.data(), data1.size());
+  writer.writeRecord("key2", data1.data(), data1.size());
+  writer.writeEndOfFile();
+
+  std::string the_file = oss.str();
+  std::istringstream iss(the_file);
+  PyTorchStreamReader reader(&iss);
+  ASSERT_EQ(reader.version(), kProducedAlignedFileFormatVersion);
+  ASSERT_EQ(reader.recordAlignment(), kPageSize);
+  for (const char* key : {"key1", "key2"}) {
+    at::DataPtr data_ptr;
+    int64_t size;
+    std::tie(data_ptr, size) = reader.getRecord(key);
+    ASSERT_EQ(size, data1.size());
+    ASSERT_EQ(memcmp(data_ptr.get(), data1.data(), data1.size()), 0);
+    ASSERT_EQ(reader.getRecordOffset(key) % kPageSize, 0);
+  }
+
+  ASSERT_ANY_THROW(PyTorchStreamWriter(
+      [](const void* b, size_t n) -> size_t { return n; }, 100));
+}
+
+TEST(PyTorchStreamWriterAndReader, LoadMmapped) {
+  const std::string file_name = "mmapped.zip";
+  std::array<char, 127> data1;
+  for (int i = 0; i < data1.size(); ++i) {
+    data1[i] = data1.size() - i;
+  }
+  {
+    PyTorchStreamWriter writer(file_name);
+    writer.writeRecord("key1", data1.data(), data1.size());
+    std::array<char, 4096> zeros{};
+    writer.writeRecord("key2", zeros.data(), zeros.size(), /*compress=*/true);
+    writer.writeEndOfFile();
+  }
+
+  at::DataPtr data_ptr;
+  at::DataPtr compressed_ptr;
+  int64_t size;
+  {
+    PyTorchStreamReader reader(file_name);
+    std::tie(data_ptr, size) = reader.getRecord("key1");
+    ASSERT_EQ(size, data1.size());
+    // stored records alias the mapping, so they don't own their data
+    ASSERT_NE(data_ptr.get(), data_ptr.get_context());
+    ASSERT_EQ(reinterpret_cast<uintptr_t>(data_ptr.get()) % kFieldAlignment, 0);
+
+    // compressed records are extracted into their own buffer
+    std::tie(compressed_ptr, size) = reader.getRecord("key2");
+    ASSERT_EQ(size, 4096);
+    ASSERT_EQ(compressed_ptr.get(), compressed_ptr.get_context());
+  }
+  // the records stay valid after the reader is gone
+  ASSERT_EQ(memcmp(data_ptr.get(), data1.data(), data1.size()), 0);
+  ASSERT_EQ(static_cast<char*>(compressed_ptr.get())[4095], 0);
+  data_ptr.clear();
+  compressed_ptr.clear();
+  std::remove(file_name.c_str());
+}
+
 } // namespace
 } // namespace serialize
 } // namespace caffe2
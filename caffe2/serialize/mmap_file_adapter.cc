@@ -0,0 +1,127 @@
+#include "caffe2/serialize/mmap_file_adapter.h"
+
+#include <cstring>
+
+#include <c10/util/Exception.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace caffe2 {
+namespace serialize {
+
+struct MmapFileAdapter::Mapping {
+  char* data = nullptr;
+  size_t size = 0;
+
+  ~Mapping() {
+    if (data == nullptr) {
+      return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+  }
+};
+
+MmapFileAdapter::MmapFileAdapter(const std::string& file_name)
+    : mapping_(std::make_shared<Mapping>()) {
+#ifdef _WIN32
+  HANDLE file = CreateFileA(
+      file_name.c_str(),
+      GENERIC_READ,
+      FILE_SHARE_READ,
+      nullptr,
+      OPEN_EXISTING,
+      FILE_ATTRIBUTE_NORMAL,
+      nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    AT_ERROR("open file failed, file path: ", file_name);
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    AT_ERROR("getting the size of file failed, file path: ", file_name);
+  }
+  mapping_->size = static_cast<size_t>(size.QuadPart);
+  if (mapping_->size > 0) {
+    HANDLE handle =
+        CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (handle != nullptr) {
+      mapping_->data = static_cast<char*>(
+          MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, mapping_->size));
+      CloseHandle(handle);
+    }
+  }
+  CloseHandle(file);
+#else
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd == -1) {
+    AT_ERROR("open file failed, file path: ", file_name);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    AT_ERROR("getting the size of file failed, file path: ", file_name);
+  }
+  mapping_->size = static_cast<size_t>(st.st_size);
+  if (mapping_->size > 0) {
+    void* ptr = mmap(
+        nullptr,
+        mapping_->size,
+        PROT_READ | PROT_WRITE,
+        MAP_PRIVATE,
+        fd,
+        0);
+    if (ptr != MAP_FAILED) {
+      mapping_->data = static_cast<char*>(ptr);
+    }
+  }
+  // the mapping stays valid after the descriptor is closed
+  close(fd);
+#endif
+  if (mapping_->size > 0 && mapping_->data == nullptr) {
+    AT_ERROR("mapping file failed, file path: ", file_name);
+  }
+}
+
+size_t MmapFileAdapter::size() const {
+  return mapping_->size;
+}
+
+size_t MmapFileAdapter::read(uint64_t pos, void* buf, size_t n, const char* what)
+    const {
+  if (pos > mapping_->size || n > mapping_->size - pos) {
+    AT_ERROR("mmap reader failed: ", what, ", reading past the end of file.");
+  }
+  std::memcpy(buf, mapping_->data + pos, n);
+  return n;
+}
+
+static void deleteMapping(void* ctx) {
+  delete static_cast<std::shared_ptr<MmapFileAdapter::Mapping>*>(ctx);
+}
+
+at::DataPtr MmapFileAdapter::alias(uint64_t pos, size_t n) const {
+  if (pos > mapping_->size || n > mapping_->size - pos) {
+    return at::DataPtr();
+  }
+  return at::DataPtr(
+      mapping_->data + pos,
+      new std::shared_ptr<Mapping>(mapping_),
+      deleteMapping,
+      at::kCPU);
+}
+
+MmapFileAdapter::~MmapFileAdapter() {}
+
+} // namespace serialize
+} // namespace caffe2
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "c10/macros/Macros.h"
+#include "caffe2/serialize/read_adapter_interface.h"
+
+namespace caffe2 {
+namespace serialize {
+
+// Reads a file by mapping it into memory. Besides avoiding a copy on every
+// read(), this lets PyTorchStreamReader hand out records that alias the
+// mapping (see alias()), so tensor storages loaded from an uncompressed
+// archive point straight into the page cache and are only paged in when
+// touched.
+//
+// The file is mapped copy-on-write: writes to aliased records are never
+// written back to the file. Records handed out by alias() keep the mapping
+// alive after the adapter is destroyed.
+class CAFFE2_API MmapFileAdapter final : public ReadAdapterInterface {
+ public:
+  C10_DISABLE_COPY_AND_ASSIGN(MmapFileAdapter);
+  explicit MmapFileAdapter(const std::string& file_name);
+  size_t size() const override;
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override;
+  at::DataPtr alias(uint64_t pos, size_t n) const override;
+  ~MmapFileAdapter();
+
+  struct Mapping;
+
+ private:
+  std::shared_ptr<Mapping> mapping_;
+};
+
+} // namespace serialize
+} // namespace caffe2
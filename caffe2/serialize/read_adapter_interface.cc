@@ -3,6 +3,10 @@
 namespace caffe2 {
 namespace serialize {
 
+at::DataPtr ReadAdapterInterface::alias(uint64_t pos, size_t n) const {
+  return at::DataPtr();
+}
+
 ReadAdapterInterface::~ReadAdapterInterface() {}
 
 } // namespace serialize
@@ -237,6 +237,18 @@ class SparseAdagradOp final : public Operator<Context> {
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
 
+inline void rowwise_adagrad_update(
+    int N,
+    at::BFloat16* w,
+    at::BFloat16* w_n, // prefetch ptr
+    const float* g,
+    float* h,
+    float* h_n, // prefetch ptr
+    float epsilon,
+    float lr) {
+  rowwise_adagrad_bf16_update(N, w, w_n, g, h, h_n, epsilon, lr);
+}
+
 template <typename T, class Context>
 class RowWiseSparseAdagradOp final : public Operator<Context> {
  public:
@@ -259,12 +271,20 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
 
   template <typename SIndex>
   bool DoRunWithType() {
+    // Parameters may also be stored as bfloat16, moments and gradients are
+    // always float.
+    return DispatchHelper<TensorTypes2<T, at::BFloat16>, SIndex>::call(
+        this, Input(PARAM));
+  }
+
+  template <typename SIndex, typename TParam>
+  bool DoRunWithType2() {
     const auto* lr = Input(LR).template data<T>();
     const auto* indices = Input(INDICES).template data<SIndex>();
     const auto* gradIn = Input(GRAD).template data<T>();
-    const auto* paramIn = Input(PARAM).template data<T>();
     const auto* momentIn = Input(MOMENT_1).template data<T>();
-    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<T>();
+    // param and moment are updated in place, see the schema
+    auto* paramOut = Output(OUTPUT_PARAM)->template mutable_data<TParam>();
     auto* momentOut = Output(OUTPUT_MOMENT_1)->template mutable_data<T>();
 
     auto n = Input(INDICES).numel();
@@ -276,10 +296,10 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
 
     for (auto i = 0; i < n; ++i) {
       auto idx = indices[i];
-      if (block_size == 1) {
+      if (block_size == 1 && std::is_same<TParam, float>::value) {
         float gi = gradIn[i];
         float hi = momentOut[idx] = momentIn[idx] + gi * gi;
-        paramOut[idx] = paramIn[idx] + lr[0] * gi / (std::sqrt(hi) + epsilon_);
+        paramOut[idx] += lr[0] * gi / (std::sqrt(hi) + epsilon_);
       } else {
         auto offsetI = i * block_size;
         auto offsetIdx = idx * block_size;
@@ -305,21 +325,18 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
             i);
 #endif
 
-        const float* w = paramIn + offsetIdx;
-        const float* g = gradIn + offsetI;
-        const float* h = momentIn + idx;
-        float* nw = paramOut + offsetIdx;
-        float* nh = momentOut + idx;
-        float hs = 0.;
-        for (auto j = 0; j < block_size; ++j) {
-          float gj = g[j];
-          hs += gj * gj;
-        }
-        float hi = nh[0] = h[0] + hs / block_size;
-        float step = lr[0] / (std::sqrt(hi) + epsilon_);
-        for (auto j = 0; j < block_size; ++j) {
-          nw[j] = w[j] + g[j] * step;
-        }
+        const int prefdist_T0 = 16;
+        auto i_pref = (i < n - prefdist_T0) ? i + prefdist_T0 : i;
+        auto idx_pref = indices[i_pref];
+        rowwise_adagrad_update(
+            block_size,
+            paramOut + offsetIdx,
+            paramOut + idx_pref * block_size,
+            gradIn + offsetI,
+            momentOut + idx,
+            momentOut + idx_pref,
+            epsilon_,
+            lr[0]);
       }
     }
     return true;
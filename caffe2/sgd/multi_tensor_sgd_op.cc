@@ -0,0 +1,159 @@
+#include "caffe2/sgd/multi_tensor_sgd_op.h"
+
+#include <cmath>
+
+#include "caffe2/utils/math.h"
+
+namespace caffe2 {
+
+template <>
+void MultiTensorMomentumSGDUpdateOp<float, CPUContext>::Update(
+    int num_tensors) {
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    const int out = i * kOutputsPerTensor;
+    momentum_sgd_update<CPUContext>(
+        Input(in + GRAD).numel(),
+        Input(in + GRAD).template data<float>(),
+        Input(in + MOMENTUM).template data<float>(),
+        Output(out + OUTPUT_GRAD)->template mutable_data<float>(),
+        Output(out + OUTPUT_MOMENTUM)->template mutable_data<float>(),
+        Input(in + LR).template data<float>(),
+        momentum_,
+        nesterov_,
+        Output(out + OUTPUT_PARAM)->template mutable_data<float>(),
+        &context_);
+  }
+}
+
+template <>
+void MultiTensorAdamOp<float, CPUContext>::Update(int num_tensors) {
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    const int out = i * kOutputsPerTensor;
+    adam_compute<CPUContext>(
+        Input(in + GRAD).numel(),
+        Input(in + PARAM).template data<float>(),
+        Input(in + GRAD).template data<float>(),
+        Input(in + MOMENT_1).template data<float>(),
+        Input(in + MOMENT_2).template data<float>(),
+        Output(out + OUTPUT_PARAM)->template mutable_data<float>(),
+        Output(out + OUTPUT_MOMENT_1)->template mutable_data<float>(),
+        Output(out + OUTPUT_MOMENT_2)->template mutable_data<float>(),
+        beta1_,
+        beta2_,
+        epsilon_,
+        corrections_[i],
+        Input(in + LR).template data<float>(),
+        &context_);
+  }
+}
+
+template <>
+void MultiTensorLarsOp<float, CPUContext>::ComputeLearningRates(
+    int num_tensors) {
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    const auto N = Input(in + X).numel();
+    float X_norm = 0;
+    float dX_norm = 0;
+    math::SumSqr(N, Input(in + X).template data<float>(), &X_norm, &context_);
+    math::SumSqr(
+        N, Input(in + DX).template data<float>(), &dX_norm, &context_);
+    X_norm = std::sqrt(X_norm);
+    dX_norm = std::sqrt(dX_norm);
+
+    float val = 1.0;
+    if (X_norm > 0) {
+      val = Input(in + TRUST).template data<float>()[0] /
+          (dX_norm / X_norm + Input(in + WD).template data<float>()[0] +
+           offset_);
+    }
+    Output(i)->template mutable_data<float>()[0] = fmaxf(
+        fminf(val, Input(in + LR_MAX).template data<float>()[0]), lr_min_);
+  }
+}
+
+REGISTER_CPU_OPERATOR(
+    MultiTensorMomentumSGDUpdate,
+    MultiTensorMomentumSGDUpdateOp<float, CPUContext>);
+OPERATOR_SCHEMA(MultiTensorMomentumSGDUpdate)
+    .NumInputsOutputs([](int in, int out) {
+      return in > 0 && in % 4 == 0 && out == in / 4 * 3;
+    })
+    .EnforceInplace([](int in, int out) {
+      // (grad, momentum, lr, param) -> (grad, momentum, param)
+      return in / 4 == out / 3 && in % 4 != 2 &&
+          out % 3 == (in % 4 == 3 ? 2 : in % 4);
+    })
+    .SetDoc(R"DOC(
+
+Performs the MomentumSGDUpdate of a list of parameters. Given the inputs
+(grad, m, lr, param) of every parameter, one after the other, and the arguments
+(momentum, nesterov), computes the outputs (grad, m, param) of every parameter
+like MomentumSGDUpdate, in place.
+
+The GPU implementation updates all parameters with one kernel launch per few
+dozen parameters.
+
+)DOC")
+    .Arg("momentum", "Momentum hyperparameter.")
+    .Arg("nesterov", "(boolean) Whether to use Nesterov Accelerated Gradient.");
+SHOULD_NOT_DO_GRADIENT(MultiTensorMomentumSGDUpdate);
+
+REGISTER_CPU_OPERATOR(MultiTensorAdam, MultiTensorAdamOp<float, CPUContext>);
+OPERATOR_SCHEMA(MultiTensorAdam)
+    .NumInputsOutputs([](int in, int out) {
+      return in > 0 && in % 6 == 0 && out == in / 6 * 3;
+    })
+    .EnforceInplace([](int in, int out) {
+      // (param, m1, m2, grad, lr, iter) -> (param, m1, m2)
+      return in / 6 == out / 3 && in % 6 < 3 && in % 6 == out % 3;
+    })
+    .DeviceInferenceFunction([](const OperatorDef& def) {
+      auto op_device =
+          def.has_device_option() ? def.device_option() : DeviceOption();
+      vector<DeviceOption> in_dev(def.input_size(), op_device);
+      vector<DeviceOption> out_dev(def.output_size(), op_device);
+      // ITER inputs live on CPU
+      for (int i = 5; i < def.input_size(); i += 6) {
+        in_dev[i] = DeviceOption();
+      }
+      return std::make_pair(in_dev, out_dev);
+    })
+    .SetDoc(R"DOC(
+
+Performs the Adam update of a list of parameters. Given the inputs
+(param, m1, m2, grad, lr, iter) of every parameter, one after the other,
+computes the outputs (param, m1, m2) of every parameter like Adam, in place.
+The optional effective gradient output of Adam is not supported.
+
+The GPU implementation updates all parameters with one kernel launch per few
+dozen parameters.
+
+)DOC")
+    .Arg("beta1", "Default 0.9")
+    .Arg("beta2", "Default 0.999")
+    .Arg("epsilon", "Default 1e-5");
+SHOULD_NOT_DO_GRADIENT(MultiTensorAdam);
+
+REGISTER_CPU_OPERATOR(MultiTensorLars, MultiTensorLarsOp<float, CPUContext>);
+OPERATOR_SCHEMA(MultiTensorLars)
+    .NumInputsOutputs([](int in, int out) {
+      return in > 0 && in % 5 == 0 && out == in / 5;
+    })
+    .SetDoc(R"DOC(
+
+Computes the Lars rescaled learning rate of a list of parameters. Given the
+inputs (X, dX, wd, trust, lr_max) of every parameter, one after the other,
+outputs the lr_rescaled of every parameter like Lars.
+
+The GPU implementation computes the norms of all parameters and gradients with
+one kernel launch per few dozen parameters.
+
+)DOC")
+    .Arg("offset", "rescaling offset parameter")
+    .Arg("lr_min", "minimum learning rate for clipping");
+SHOULD_NOT_DO_GRADIENT(MultiTensorLars);
+
+} // namespace caffe2
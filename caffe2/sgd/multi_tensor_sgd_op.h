@@ -0,0 +1,135 @@
+#pragma once
+
+#include "caffe2/core/operator.h"
+#include "caffe2/sgd/adam_op.h"
+#include "caffe2/sgd/momentum_sgd_op.h"
+
+namespace caffe2 {
+
+// Multi-tensor variants of the dense optimizer ops, which update a list of
+// parameters at once. The inputs and outputs are those of the single tensor
+// op, repeated for every parameter, and the outputs have to be in place.
+// On the GPU, all parameters are updated by a few kernel launches instead of
+// one or more per parameter.
+
+template <typename T, class Context>
+class MultiTensorMomentumSGDUpdateOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorMomentumSGDUpdateOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        momentum_(this->template GetSingleArgument<T>("momentum", 0.0)),
+        nesterov_(this->template GetSingleArgument<int>("nesterov", 0)) {}
+
+  bool RunOnDevice() override {
+    auto device_type = Context::GetDeviceType();
+    CAFFE_ENFORCE_EQ(InputSize() % kInputsPerTensor, 0);
+    const int num_tensors = InputSize() / kInputsPerTensor;
+    CAFFE_ENFORCE_EQ(OutputSize(), num_tensors * kOutputsPerTensor);
+    for (int i = 0; i < num_tensors; ++i) {
+      const int in = i * kInputsPerTensor;
+      CAFFE_ENFORCE(OperatorBase::InputIsTensorType(in + GRAD, device_type));
+      CAFFE_ENFORCE(
+          OperatorBase::InputIsTensorType(in + MOMENTUM, device_type));
+      CAFFE_ENFORCE_EQ(Input(in + LR).numel(), 1);
+      CAFFE_ENFORCE_EQ(Input(in + GRAD).numel(), Input(in + MOMENTUM).numel());
+      CAFFE_ENFORCE_EQ(Input(in + GRAD).numel(), Input(in + PARAM).numel());
+    }
+    Update(num_tensors);
+    return true;
+  }
+
+ private:
+  void Update(int num_tensors);
+
+  T momentum_{0.9};
+  bool nesterov_;
+  enum { GRAD, MOMENTUM, LR, PARAM, kInputsPerTensor };
+  enum { OUTPUT_GRAD, OUTPUT_MOMENTUM, OUTPUT_PARAM, kOutputsPerTensor };
+};
+
+template <typename T, class Context>
+class MultiTensorAdamOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorAdamOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        beta1_(this->template GetSingleArgument<float>("beta1", 0.9f)),
+        beta2_(this->template GetSingleArgument<float>("beta2", 0.999f)),
+        epsilon_(this->template GetSingleArgument<float>("epsilon", 1e-5f)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(InputSize() % kInputsPerTensor, 0);
+    const int num_tensors = InputSize() / kInputsPerTensor;
+    CAFFE_ENFORCE_EQ(OutputSize(), num_tensors * kOutputsPerTensor);
+    corrections_.resize(num_tensors);
+    for (int i = 0; i < num_tensors; ++i) {
+      const int in = i * kInputsPerTensor;
+      // Iter live on the CPU
+      CAFFE_ENFORCE(OperatorBase::InputIsTensorType(in + ITER, CPU));
+      CAFFE_ENFORCE_EQ(Input(in + LR).numel(), 1);
+      CAFFE_ENFORCE_EQ(Input(in + GRAD).numel(), Input(in + PARAM).numel());
+      CAFFE_ENFORCE_EQ(Input(in + GRAD).numel(), Input(in + MOMENT_1).numel());
+      CAFFE_ENFORCE_EQ(Input(in + GRAD).numel(), Input(in + MOMENT_2).numel());
+
+      const auto iter = OperatorBase::Input<Tensor>(in + ITER, CPU)
+                            .template data<int64_t>()[0];
+      const auto t = iter + 1;
+      corrections_[i] = std::sqrt(T(1.) - std::pow(beta2_, t)) /
+          (T(1.) - std::pow(beta1_, t));
+    }
+    Update(num_tensors);
+    return true;
+  }
+
+ private:
+  void Update(int num_tensors);
+
+  T beta1_{0.9};
+  T beta2_{0.999};
+  T epsilon_{1e-8};
+  // the bias correction of every parameter, by its iteration
+  std::vector<T> corrections_;
+  enum { PARAM, MOMENT_1, MOMENT_2, GRAD, LR, ITER, kInputsPerTensor };
+  enum { OUTPUT_PARAM, OUTPUT_MOMENT_1, OUTPUT_MOMENT_2, kOutputsPerTensor };
+};
+
+template <typename T, class Context>
+class MultiTensorLarsOp final : public Operator<Context> {
+ public:
+  USE_OPERATOR_CONTEXT_FUNCTIONS;
+  MultiTensorLarsOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<Context>(operator_def, ws),
+        offset_(this->template GetSingleArgument<float>("offset", 0.5)),
+        lr_min_(this->template GetSingleArgument<float>("lr_min", 0.02)) {}
+
+  bool RunOnDevice() override {
+    CAFFE_ENFORCE_EQ(InputSize() % kInputsPerTensor, 0);
+    const int num_tensors = InputSize() / kInputsPerTensor;
+    CAFFE_ENFORCE_EQ(OutputSize(), num_tensors);
+    CAFFE_ENFORCE_GE(offset_, 0);
+    CAFFE_ENFORCE_GE(lr_min_, 0);
+    for (int i = 0; i < num_tensors; ++i) {
+      const int in = i * kInputsPerTensor;
+      CAFFE_ENFORCE(
+          Input(in + X).numel() == Input(in + DX).numel(),
+          "Gradient size doesn't match parameter size.");
+      Output(i, vector<int64_t>{1}, at::dtype<T>());
+    }
+    ComputeLearningRates(num_tensors);
+    return true;
+  }
+
+ private:
+  // Computes the rescaled learning rate of every parameter, see LarsOp.
+  void ComputeLearningRates(int num_tensors);
+
+  T offset_;
+  T lr_min_;
+
+  // the l2 norms of the parameters and their gradients
+  Tensor norms_;
+  enum { X, DX, WD, TRUST, LR_MAX, kInputsPerTensor };
+};
+
+} // namespace caffe2
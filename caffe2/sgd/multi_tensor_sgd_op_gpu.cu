@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <array>
+
+#include "caffe2/core/common_gpu.h"
+#include "caffe2/core/context_gpu.h"
+#include "caffe2/sgd/multi_tensor_sgd_op.h"
+#include "caffe2/utils/math.h"
+
+#include <cub/block/block_reduce.cuh>
+
+namespace caffe2 {
+
+namespace {
+
+// Every block of a multi-tensor kernel processes a chunk of one tensor. The
+// pointers and sizes of the tensors are passed as a kernel argument, which is
+// limited to 4KB, so a launch covers up to kMaxTensors tensors and
+// kMaxBlocks chunks.
+constexpr int kChunkSize = 65536;
+constexpr int kMaxTensors = 36;
+constexpr int kMaxBlocks = 320;
+
+template <int kDepth>
+struct TensorListMetadata {
+  float* ptrs[kDepth][kMaxTensors];
+  const float* lr[kMaxTensors];
+  float scale[kMaxTensors];
+  int sizes[kMaxTensors];
+  // the index of the tensor among all tensors of the op
+  int index[kMaxTensors];
+  unsigned char block_to_tensor[kMaxBlocks];
+  int block_to_chunk[kMaxBlocks];
+};
+
+// The tensors of a multi-tensor op, with kDepth pointers per tensor, e.g. the
+// parameter and its moments.
+template <int kDepth>
+struct TensorList {
+  std::vector<std::array<float*, kDepth>> ptrs;
+  std::vector<const float*> lr;
+  std::vector<float> scale;
+  std::vector<int> sizes;
+};
+
+template <int kDepth, typename Functor>
+__global__ void MultiTensorApplyKernel(
+    const TensorListMetadata<kDepth> meta,
+    const Functor functor) {
+  const int tensor = meta.block_to_tensor[blockIdx.x];
+  const int begin = meta.block_to_chunk[blockIdx.x] * kChunkSize;
+  const int end = min(begin + kChunkSize, meta.sizes[tensor]);
+  for (int i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    functor(meta, tensor, i);
+  }
+}
+
+// Launches kernel(meta, functor) with one block per chunk of the tensors, in
+// as few launches as the metadata allows.
+template <int kDepth, typename Functor, typename Kernel>
+void MultiTensorApply(
+    const TensorList<kDepth>& tensors,
+    const Functor& functor,
+    Kernel kernel,
+    CUDAContext* context) {
+  TensorListMetadata<kDepth> meta;
+  int num_tensors = 0;
+  int num_blocks = 0;
+  for (int t = 0; t < tensors.sizes.size(); ++t) {
+    const int size = tensors.sizes[t];
+    if (size == 0) {
+      continue;
+    }
+    int slot = num_tensors++;
+    for (int d = 0; d < kDepth; ++d) {
+      meta.ptrs[d][slot] = tensors.ptrs[t][d];
+    }
+    meta.lr[slot] = tensors.lr.empty() ? nullptr : tensors.lr[t];
+    meta.scale[slot] = tensors.scale.empty() ? 1.0f : tensors.scale[t];
+    meta.sizes[slot] = size;
+    meta.index[slot] = t;
+
+    const int num_chunks = (size + kChunkSize - 1) / kChunkSize;
+    for (int chunk = 0; chunk < num_chunks; ++chunk) {
+      meta.block_to_tensor[num_blocks] = slot;
+      meta.block_to_chunk[num_blocks] = chunk;
+      ++num_blocks;
+      const bool last_chunk = chunk == num_chunks - 1;
+      if (num_blocks == kMaxBlocks ||
+          (num_tensors == kMaxTensors && last_chunk)) {
+        kernel<<<
+            num_blocks,
+            CAFFE_CUDA_NUM_THREADS,
+            0,
+            context->cuda_stream()>>>(meta, functor);
+        num_blocks = 0;
+        if (last_chunk) {
+          num_tensors = 0;
+        } else {
+          // the remaining chunks of the tensor go to the next launch
+          for (int d = 0; d < kDepth; ++d) {
+            meta.ptrs[d][0] = meta.ptrs[d][slot];
+          }
+          meta.lr[0] = meta.lr[slot];
+          meta.scale[0] = meta.scale[slot];
+          meta.sizes[0] = meta.sizes[slot];
+          meta.index[0] = meta.index[slot];
+          slot = 0;
+          num_tensors = 1;
+        }
+      }
+    }
+  }
+  if (num_blocks > 0) {
+    kernel<<<num_blocks, CAFFE_CUDA_NUM_THREADS, 0, context->cuda_stream()>>>(
+        meta, functor);
+  }
+}
+
+// (grad, momentum, param), see MomentumSGDKernel
+template <bool nesterov>
+struct MomentumSGDFunctor {
+  float momentum;
+
+  __device__ void operator()(
+      const TensorListMetadata<3>& meta,
+      const int tensor,
+      const int i) const {
+    float* g = meta.ptrs[0][tensor];
+    float* m = meta.ptrs[1][tensor];
+    float* param = meta.ptrs[2][tensor];
+    const float LR = meta.lr[tensor][0];
+    if (nesterov) {
+      const float mi = m[i];
+      const float mi_new = momentum * mi + LR * g[i];
+      m[i] = mi_new;
+      g[i] = fmaf(momentum, mi_new - mi, mi_new);
+    } else {
+      const float adjusted_gradient = LR * g[i] + momentum * m[i];
+      m[i] = adjusted_gradient;
+      g[i] = adjusted_gradient;
+    }
+    param[i] -= g[i];
+  }
+};
+
+// (param, grad, moment_1, moment_2), with the bias correction as the scale,
+// see AdamCompute
+struct AdamFunctor {
+  float beta1;
+  float beta2;
+  float eps_hat;
+
+  __device__ void operator()(
+      const TensorListMetadata<4>& meta,
+      const int tensor,
+      const int i) const {
+    float* w = meta.ptrs[0][tensor];
+    const float* g = meta.ptrs[1][tensor];
+    float* m = meta.ptrs[2][tensor];
+    float* v = meta.ptrs[3][tensor];
+    float gi = g[i];
+    float mi = m[i] = m[i] * beta1 + gi * (1 - beta1);
+    float vi = v[i] = v[i] * beta2 + gi * gi * (1 - beta2);
+    w[i] += meta.lr[tensor][0] * meta.scale[tensor] * mi /
+        (sqrtf(vi) + eps_hat);
+  }
+};
+
+// Accumulates the sums of squares of the chunks of (X, dX) into
+// norms[2 * index] and norms[2 * index + 1]. Launched by MultiTensorApply(),
+// with the norms as the functor.
+__global__ void MultiTensorSumSqrKernel(
+    const TensorListMetadata<2> meta,
+    float* norms) {
+  typedef cub::BlockReduce<float, CAFFE_CUDA_NUM_THREADS> BlockReduce;
+  __shared__ typename BlockReduce::TempStorage temp_storage;
+  const int tensor = meta.block_to_tensor[blockIdx.x];
+  const int begin = meta.block_to_chunk[blockIdx.x] * kChunkSize;
+  const int end = min(begin + kChunkSize, meta.sizes[tensor]);
+  const float* X = meta.ptrs[0][tensor];
+  const float* dX = meta.ptrs[1][tensor];
+  float X_sum = 0;
+  float dX_sum = 0;
+  for (int i = begin + threadIdx.x; i < end; i += blockDim.x) {
+    X_sum += X[i] * X[i];
+    dX_sum += dX[i] * dX[i];
+  }
+  X_sum = BlockReduce(temp_storage).Sum(X_sum);
+  __syncthreads();
+  dX_sum = BlockReduce(temp_storage).Sum(dX_sum);
+  if (threadIdx.x == 0) {
+    atomicAdd(&norms[2 * meta.index[tensor]], X_sum);
+    atomicAdd(&norms[2 * meta.index[tensor] + 1], dX_sum);
+  }
+}
+
+struct LarsParams {
+  const float* wd[kMaxTensors];
+  const float* trust[kMaxTensors];
+  const float* lr_max[kMaxTensors];
+  float* lr_rescaled[kMaxTensors];
+};
+
+// see ComputeLearningRateKernel in lars_op_gpu.cu
+__global__ void MultiTensorLarsLearningRateKernel(
+    const int num_tensors,
+    const LarsParams params,
+    const float* norms,
+    const float offset,
+    const float lr_min) {
+  CUDA_1D_KERNEL_LOOP(i, num_tensors) {
+    const float X_norm = sqrtf(norms[2 * i]);
+    const float dX_norm = sqrtf(norms[2 * i + 1]);
+    float val = 1.0;
+    if (X_norm > 0) {
+      val = *params.trust[i] / (dX_norm / X_norm + *params.wd[i] + offset);
+    }
+    *params.lr_rescaled[i] = fmaxf(fminf(val, *params.lr_max[i]), lr_min);
+  }
+}
+
+} // namespace
+
+template <>
+void MultiTensorMomentumSGDUpdateOp<float, CUDAContext>::Update(
+    int num_tensors) {
+  TensorList<3> tensors;
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    const int out = i * kOutputsPerTensor;
+    tensors.ptrs.push_back(
+        {Output(out + OUTPUT_GRAD)->template mutable_data<float>(),
+         Output(out + OUTPUT_MOMENTUM)->template mutable_data<float>(),
+         Output(out + OUTPUT_PARAM)->template mutable_data<float>()});
+    tensors.lr.push_back(Input(in + LR).template data<float>());
+    tensors.sizes.push_back(Input(in + GRAD).numel());
+  }
+  if (nesterov_) {
+    MultiTensorApply(
+        tensors,
+        MomentumSGDFunctor<true>{momentum_},
+        MultiTensorApplyKernel<3, MomentumSGDFunctor<true>>,
+        &context_);
+  } else {
+    MultiTensorApply(
+        tensors,
+        MomentumSGDFunctor<false>{momentum_},
+        MultiTensorApplyKernel<3, MomentumSGDFunctor<false>>,
+        &context_);
+  }
+}
+
+template <>
+void MultiTensorAdamOp<float, CUDAContext>::Update(int num_tensors) {
+  TensorList<4> tensors;
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    const int out = i * kOutputsPerTensor;
+    tensors.ptrs.push_back(
+        {Output(out + OUTPUT_PARAM)->template mutable_data<float>(),
+         const_cast<float*>(Input(in + GRAD).template data<float>()),
+         Output(out + OUTPUT_MOMENT_1)->template mutable_data<float>(),
+         Output(out + OUTPUT_MOMENT_2)->template mutable_data<float>()});
+    tensors.lr.push_back(Input(in + LR).template data<float>());
+    tensors.scale.push_back(corrections_[i]);
+    tensors.sizes.push_back(Input(in + GRAD).numel());
+  }
+  MultiTensorApply(
+      tensors,
+      AdamFunctor{beta1_, beta2_, epsilon_},
+      MultiTensorApplyKernel<4, AdamFunctor>,
+      &context_);
+}
+
+template <>
+void MultiTensorLarsOp<float, CUDAContext>::ComputeLearningRates(
+    int num_tensors) {
+  ReinitializeTensor(
+      &norms_,
+      {2 * num_tensors},
+      at::dtype<float>().device(CUDA));
+  float* norms = norms_.template mutable_data<float>();
+  math::Set<float, CUDAContext>(2 * num_tensors, 0, norms, &context_);
+
+  TensorList<2> tensors;
+  for (int i = 0; i < num_tensors; ++i) {
+    const int in = i * kInputsPerTensor;
+    tensors.ptrs.push_back(
+        {const_cast<float*>(Input(in + X).template data<float>()),
+         const_cast<float*>(Input(in + DX).template data<float>())});
+    tensors.sizes.push_back(Input(in + X).numel());
+  }
+  MultiTensorApply(tensors, norms, MultiTensorSumSqrKernel, &context_);
+
+  for (int begin = 0; begin < num_tensors; begin += kMaxTensors) {
+    const int n = std::min(kMaxTensors, num_tensors - begin);
+    LarsParams params;
+    for (int j = 0; j < n; ++j) {
+      const int in = (begin + j) * kInputsPerTensor;
+      params.wd[j] = Input(in + WD).template data<float>();
+      params.trust[j] = Input(in + TRUST).template data<float>();
+      params.lr_max[j] = Input(in + LR_MAX).template data<float>();
+      params.lr_rescaled[j] = Output(begin + j)->template mutable_data<float>();
+    }
+    MultiTensorLarsLearningRateKernel<<<
+        1,
+        CAFFE_CUDA_NUM_THREADS,
+        0,
+        context_.cuda_stream()>>>(
+        n, params, norms + 2 * begin, offset_, lr_min_);
+  }
+}
+
+REGISTER_CUDA_OPERATOR(
+    MultiTensorMomentumSGDUpdate,
+    MultiTensorMomentumSGDUpdateOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(
+    MultiTensorAdam,
+    MultiTensorAdamOp<float, CUDAContext>);
+REGISTER_CUDA_OPERATOR(MultiTensorLars, MultiTensorLarsOp<float, CUDAContext>);
+
+} // namespace caffe2
@@ -1,6 +1,7 @@
 #include <caffe2/video/video_decoder.h>
 #include <assert.h>
 #include <caffe2/core/logging.h>
+#include <algorithm>
 #include <mutex>
 #include <random>
 
@@ -118,6 +119,29 @@ void VideoDecoder::ResizeAndKeepAspectRatio(
   }
 }
 
+bool VideoDecoder::seekToFrame(
+    AVFormatContext* inputContext,
+    AVStream* videoStream,
+    int videoStreamIndex,
+    AVCodecContext* videoCodecContext,
+    int64_t currentTs,
+    int64_t targetTs) {
+  // only seek if there is a key frame between the current frame and the
+  // target, otherwise decoding on is cheaper than going back to the key frame
+  int entry =
+      av_index_search_timestamp(videoStream, targetTs, AVSEEK_FLAG_BACKWARD);
+  if (entry < 0 || videoStream->index_entries[entry].timestamp <= currentTs) {
+    return false;
+  }
+  if (av_seek_frame(
+          inputContext, videoStreamIndex, targetTs, AVSEEK_FLAG_BACKWARD) <
+      0) {
+    return false;
+  }
+  avcodec_flush_buffers(videoCodecContext);
+  return true;
+}
+
 void VideoDecoder::decodeLoop(
     const string& videoName,
     VideoIOContext& ioctx,
@@ -424,6 +448,43 @@ void VideoDecoder::decodeLoop(
       mustDecodeAll = true;
     }
 
+    /* with sparse sampling, only the frames of the sampled clips are
+     * converted, stored as ranges [first, last) of frame indices */
+    std::vector<std::pair<int, int>> sparseRanges;
+    int sparseRange = 0;
+    // the range decoding last tried to seek to
+    int sparseSeekRange = -1;
+    double frameDuration = 0;
+    long int stream_start_ts = 0;
+    if (params.sparse_sampling_ &&
+        params.decode_type_ == DecodeType::DO_UNIFORM_SMP &&
+        !params.getAudio_ && !params.keyFrames_ &&
+        params.num_of_required_frame_ > 0 && videoStream_->duration > 0 &&
+        videoStream_->nb_frames >= params.num_of_required_frame_) {
+      frameDuration =
+          double(videoStream_->duration) / videoStream_->nb_frames;
+      if (videoStream_->start_time != AV_NOPTS_VALUE) {
+        stream_start_ts = videoStream_->start_time;
+      }
+      std::vector<int> clipStarts = GetClipStartFrames(
+          videoStream_->nb_frames,
+          params.num_of_required_frame_,
+          params.clip_per_video_,
+          params.clip_start_positions_);
+      std::vector<int> sortedStarts(clipStarts);
+      std::sort(sortedStarts.begin(), sortedStarts.end());
+      for (int start : sortedStarts) {
+        int end = start + params.num_of_required_frame_;
+        if (!sparseRanges.empty() && start <= sparseRanges.back().second) {
+          sparseRanges.back().second =
+              std::max(sparseRanges.back().second, end);
+        } else {
+          sparseRanges.emplace_back(start, end);
+        }
+      }
+      callback.clipsSampled(clipStarts);
+    }
+
     int gotPicture = 0;
     int eof = 0;
     int selectiveDecodedFrames = 0;
@@ -505,6 +566,42 @@ void VideoDecoder::decodeLoop(
           long int frame_ts =
               av_frame_get_best_effort_timestamp(videoStreamFrame_);
           timestamp = frame_ts * av_q2d(videoStream_->time_base);
+          if (!sparseRanges.empty()) {
+            if (frame_ts == AV_NOPTS_VALUE) {
+              av_free_packet(&packet);
+              continue;
+            }
+            // frames are skipped by seeking, so derive the index of the
+            // frame from its timestamp
+            frameIndex =
+                int(round((frame_ts - stream_start_ts) / frameDuration));
+            while (sparseRange < sparseRanges.size() &&
+                   frameIndex >= sparseRanges[sparseRange].second) {
+              sparseRange++;
+            }
+            if (sparseRange == sparseRanges.size()) {
+              // past the last clip
+              av_free_packet(&packet);
+              break;
+            }
+            if (frameIndex < sparseRanges[sparseRange].first) {
+              // between two clips, skip the frame without converting it
+              if (sparseSeekRange != sparseRange) {
+                sparseSeekRange = sparseRange;
+                seekToFrame(
+                    inputContext,
+                    videoStream_,
+                    videoStreamIndex_,
+                    videoCodecContext_,
+                    frame_ts,
+                    stream_start_ts +
+                        (long int)(sparseRanges[sparseRange].first *
+                                   frameDuration));
+              }
+              av_free_packet(&packet);
+              continue;
+            }
+          }
           if ((frame_ts >= start_ts && !mustDecodeAll) || mustDecodeAll) {
             /* process current frame if:
              * 1) We are not doing selective decoding and mustDecodeAll
@@ -704,6 +801,24 @@ void FreeDecodedData(
   sampledAudio.clear();
 }
 
+std::vector<int> GetClipStartFrames(
+    const int num_frames,
+    const int num_of_required_frame,
+    const int clip_per_video,
+    const std::vector<int>& clip_start_positions) {
+  if (clip_start_positions.size() > 0) {
+    return clip_start_positions;
+  }
+  float sample_stepsz = (clip_per_video <= 1)
+      ? 0
+      : (float(num_frames - num_of_required_frame) / (clip_per_video - 1));
+  std::vector<int> clip_starts;
+  for (int i = 0; i < clip_per_video; i++) {
+    clip_starts.push_back(floor(i * sample_stepsz));
+  }
+  return clip_starts;
+}
+
 bool DecodeMultipleClipsFromVideo(
     const char* video_buffer,
     const std::string& video_filename,
@@ -761,38 +876,42 @@ bool DecodeMultipleClipsFromVideo(
   }
   height = sampledFrames[0]->height_;
   width = sampledFrames[0]->width_;
-  float sample_stepsz = (clip_per_video <= 1)
-      ? 0
-      : (float(sampledFrames.size() - params.num_of_required_frame_) /
-         (clip_per_video - 1));
+  // with sparse sampling the decoder picks the clips, and only decodes
+  // their frames
+  const bool sparse = !callback.clip_start_frames.empty();
+  const std::vector<int> clip_starts = sparse
+      ? callback.clip_start_frames
+      : GetClipStartFrames(
+            sampledFrames.size(),
+            params.num_of_required_frame_,
+            clip_per_video,
+            clip_start_positions);
 
   int image_size = 3 * height * width;
   int clip_size = params.num_of_required_frame_ * image_size;
   // get the RGB frames for each clip
-  if (clip_start_positions.size() > 0) {
-    for (int i = 0; i < clip_start_positions.size(); i++) {
-      unsigned char* buffer_rgb_ptr = new unsigned char[clip_size];
-      int clip_start = clip_start_positions[i];
-      for (int j = 0; j < params.num_of_required_frame_; j++) {
-        memcpy(
-            buffer_rgb_ptr + j * image_size,
-            (unsigned char*)sampledFrames[j + clip_start]->data_.get(),
-            image_size * sizeof(unsigned char));
-      }
-      buffer_rgb.push_back(buffer_rgb_ptr);
+  for (int clip_start : clip_starts) {
+    if (sparse) {
+      // find the first decoded frame of the clip
+      auto it = std::lower_bound(
+          sampledFrames.begin(),
+          sampledFrames.end(),
+          clip_start,
+          [](const std::unique_ptr<DecodedFrame>& frame, int index) {
+            return frame->index_ < index;
+          });
+      clip_start = std::min(
+          int(it - sampledFrames.begin()),
+          int(sampledFrames.size()) - params.num_of_required_frame_);
     }
-  } else {
-    for (int i = 0; i < clip_per_video; i++) {
-      unsigned char* buffer_rgb_ptr = new unsigned char[clip_size];
-      int clip_start = floor(i * sample_stepsz);
-      for (int j = 0; j < params.num_of_required_frame_; j++) {
-        memcpy(
-            buffer_rgb_ptr + j * image_size,
-            (unsigned char*)sampledFrames[j + clip_start]->data_.get(),
-            image_size * sizeof(unsigned char));
-      }
-      buffer_rgb.push_back(buffer_rgb_ptr);
+    unsigned char* buffer_rgb_ptr = new unsigned char[clip_size];
+    for (int j = 0; j < params.num_of_required_frame_; j++) {
+      memcpy(
+          buffer_rgb_ptr + j * image_size,
+          (unsigned char*)sampledFrames[j + clip_start]->data_.get(),
+          image_size * sizeof(unsigned char));
     }
+    buffer_rgb.push_back(buffer_rgb_ptr);
   }
   FreeDecodedData(sampledFrames, sampledAudio);
 
@@ -115,6 +115,17 @@ class Params {
   int decode_type_ = DecodeType::DO_TMP_JITTER;
   int num_of_required_frame_ = -1;
 
+  // params for sparse sampling with DecodeType::DO_UNIFORM_SMP
+  // instead of converting every frame of the video, only the frames of the
+  // clip_per_video_ clips that DecodeMultipleClipsFromVideo samples are
+  // converted, and the decoder seeks to the key frame before a clip when
+  // there is one between the current frame and the clip. Falls back to
+  // decoding all frames if the duration or frame count of the video is
+  // unknown.
+  bool sparse_sampling_ = false;
+  int clip_per_video_ = 1;
+  std::vector<int> clip_start_positions_;
+
   // intervals_ control variable sampling fps between different timestamps
   // intervals_ must be ordered strictly ascending by timestamps
   // the first interval must have a timestamp of zero
@@ -429,6 +440,9 @@ class Callback {
       std::unique_ptr<DecodedAudio> /*decoded audio data*/) {}
   virtual void videoDecodingStarted(const VideoMeta& /*videoMeta*/) {}
   virtual void videoDecodingEnded(double /*lastFrameTimestamp*/) {}
+  // called with the first frame of every clip when sampling sparsely, in
+  // which case the index_ of the decoded frames is their index in the video
+  virtual void clipsSampled(const std::vector<int>& /*clipStartFrames*/) {}
   virtual ~Callback() {}
 };
 
@@ -469,6 +483,14 @@ class VideoDecoder {
       Callback& callback,
       const Params& params);
 
+  bool seekToFrame(
+      AVFormatContext* inputContext,
+      AVStream* videoStream,
+      int videoStreamIndex,
+      AVCodecContext* videoCodecContext,
+      int64_t currentTs,
+      int64_t targetTs);
+
   void decodeLoop(
       const std::string& videoName,
       VideoIOContext& ioctx,
@@ -481,6 +503,15 @@ void FreeDecodedData(
     std::vector<std::unique_ptr<DecodedFrame>>& sampledFrames,
     std::vector<std::unique_ptr<DecodedAudio>>& sampledAudio);
 
+// Returns the first frame of every clip to sample from a video of
+// num_frames frames: clip_start_positions if given, otherwise
+// clip_per_video clips spread uniformly over the video.
+std::vector<int> GetClipStartFrames(
+    const int num_frames,
+    const int num_of_required_frame,
+    const int clip_per_video,
+    const std::vector<int>& clip_start_positions);
+
 bool DecodeMultipleClipsFromVideo(
     const char* video_buffer,
     const std::string& video_filename,
@@ -498,6 +529,7 @@ class CallbackImpl : public Callback {
  public:
   std::vector<std::unique_ptr<DecodedFrame>> frames;
   std::vector<std::unique_ptr<DecodedAudio>> audio_samples;
+  std::vector<int> clip_start_frames;
 
   explicit CallbackImpl() {
     clear();
@@ -505,6 +537,7 @@ class CallbackImpl : public Callback {
 
   void clear() {
     FreeDecodedData(frames, audio_samples);
+    clip_start_frames.clear();
   }
 
   void frameDecoded(std::unique_ptr<DecodedFrame> frame) override {
@@ -518,6 +551,10 @@ class CallbackImpl : public Callback {
   void videoDecodingStarted(const VideoMeta& /*videoMeta*/) override {
     clear();
   }
+
+  void clipsSampled(const std::vector<int>& clipStartFrames) override {
+    clip_start_frames = clipStartFrames;
+  }
 };
 
 } // namespace caffe2
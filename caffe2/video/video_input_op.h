@@ -106,6 +106,7 @@ class VideoInputOp final : public PrefetchOperator<Context> {
   int flow_data_type_;
   int flow_alg_type_;
   int decode_type_;
+  bool sparse_sampling_;
   int video_res_type_;
   bool do_flow_aggregation_;
   bool image_as_input_;
@@ -270,7 +271,8 @@ void VideoInputOp<Context>::CheckParamsAndPrint() {
   } else if (decode_type_ == DecodeType::USE_START_FRM) {
     LOG(INFO) << "    Use start_frm for decoding";
   } else if (decode_type_ == DecodeType::DO_UNIFORM_SMP) {
-    LOG(INFO) << "    Do uniformly sampling";
+    LOG(INFO) << "    Do uniformly sampling"
+              << (sparse_sampling_ ? ", only decoding the sampled clips" : "");
   } else {
     LOG(ERROR) << "    Unknown video decoding type";
   }
@@ -339,6 +341,9 @@ VideoInputOp<Context>::VideoInputOp(
           OperatorBase::template GetSingleArgument<int>("flow_alg_type", 0)),
       decode_type_(
           OperatorBase::template GetSingleArgument<int>("decode_type", 0)),
+      sparse_sampling_(OperatorBase::template GetSingleArgument<bool>(
+          "sparse_sampling",
+          false)),
       video_res_type_(
           OperatorBase::template GetSingleArgument<int>("video_res_type", 0)),
       do_flow_aggregation_(OperatorBase::template GetSingleArgument<bool>(
@@ -692,6 +697,9 @@ bool VideoInputOp<Context>::GetClipsAndLabelsFromDBValue(
   params.outputHeight_ = scale_h_;
   params.decode_type_ = decode_type_;
   params.num_of_required_frame_ = num_of_required_frame_;
+  params.sparse_sampling_ = sparse_sampling_;
+  params.clip_per_video_ = clip_per_video_;
+  params.clip_start_positions_ = clip_start_positions_;
 
   if (jitter_scales_.size() > 0) {
     int select_idx =
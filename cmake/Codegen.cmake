@@ -119,6 +119,14 @@ if (INTERN_BUILD_ATEN_OPS)
     ENDIF(MSVC)
   ENDIF(CXX_AVX2_FOUND)
 
+  # Same requirements as the AVX-512 perfkernels: avx512f, avx512dq and
+  # avx512vl (see MiscCheck.cmake).
+  IF(CXX_AVX2_FOUND AND CAFFE2_COMPILER_SUPPORTS_AVX512_EXTENSIONS AND NOT MSVC)
+    SET(CMAKE_CXX_FLAGS "${CMAKE_CXX_FLAGS} -DHAVE_AVX512_CPU_DEFINITION")
+    LIST(APPEND CPU_CAPABILITY_NAMES "AVX512")
+    LIST(APPEND CPU_CAPABILITY_FLAGS "${OPT_FLAG} -mavx512f -mavx512dq -mavx512vl -mavx2 -mfma")
+  ENDIF()
+
   list(LENGTH CPU_CAPABILITY_NAMES NUM_CPU_CAPABILITY_NAMES)
   math(EXPR NUM_CPU_CAPABILITY_NAMES "${NUM_CPU_CAPABILITY_NAMES}-1")
 
@@ -52,6 +52,7 @@ function (caffe2_print_configuration_summary)
   if(${USE_CUDA})
     message(STATUS "    CUDA static link    : ${CAFFE2_STATIC_LINK_CUDA}")
     message(STATUS "    USE_CUDNN           : ${USE_CUDNN}")
+    message(STATUS "    USE_CUPTI           : ${USE_CUPTI}")
     message(STATUS "    CUDA version        : ${CUDA_VERSION}")
     if(${USE_CUDNN})
       message(STATUS "    cuDNN version       : ${CUDNN_VERSION}")
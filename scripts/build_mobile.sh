@@ -41,6 +41,12 @@ CMAKE_ARGS+=("-DUSE_LEVELDB=OFF")
 CMAKE_ARGS+=("-DUSE_MPI=OFF")
 CMAKE_ARGS+=("-DUSE_OPENMP=OFF")
 
+# Only register the operators of the yaml list generated by
+# scripts/gen_selected_op_list.py
+if [ -n "${SELECTED_OP_LIST:-}" ]; then
+  CMAKE_ARGS+=("-DSELECTED_OP_LIST=$(cd $(dirname $SELECTED_OP_LIST); pwd -P)/$(basename $SELECTED_OP_LIST)")
+fi
+
 # Only toggle if VERBOSE=1
 if [ "${VERBOSE:-}" == '1' ]; then
   CMAKE_ARGS+=("-DCMAKE_VERBOSE_MAKEFILE=1")
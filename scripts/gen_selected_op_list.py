@@ -0,0 +1,35 @@
+#!/usr/bin/env python
+"""
+Writes the operators that one or more TorchScript models call to a yaml file,
+to be passed to a mobile build to only register these operators:
+
+    python scripts/gen_selected_op_list.py model1.pt model2.pt -o ops.yaml
+    SELECTED_OP_LIST=ops.yaml scripts/build_mobile.sh
+"""
+
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+import argparse
+
+import torch
+import yaml
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Generate the operator list of TorchScript models')
+    parser.add_argument('models', nargs='+', help='paths of the saved models')
+    parser.add_argument('-o', '--output', required=True,
+                        help='path of the yaml file to write')
+    args = parser.parse_args()
+
+    op_names = set()
+    for path in args.models:
+        op_names.update(torch.jit.export_opnames(torch.jit.load(path)))
+
+    with open(args.output, 'w') as f:
+        yaml.safe_dump(sorted(op_names), f, default_flow_style=False)
+
+
+if __name__ == '__main__':
+    main()
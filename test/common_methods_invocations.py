@@ -421,6 +421,15 @@ def method_tests():
         ('cumsum', (S, S, S), (1,), 'dim1', (), [0]),
         ('cumsum', (S, S, S), (1,), 'dim1_cast', (), [0], (), ident, {'dtype': torch.float64}),
         ('cumsum', (), (0,), 'dim0_scalar', (), [0]),
+        ('logcumsumexp', (S, S, S), (0,), 'dim0', (), [0]),
+        ('logcumsumexp', (S, S, S), (1,), 'dim1', (), [0]),
+        ('logcumsumexp', (), (0,), 'dim0_scalar', (), [0]),
+        ('cummax', (S, S, S), (0,), 'dim0', (), [0]),
+        ('cummax', (S, S, S), (1,), 'dim1', (), [0]),
+        ('cummax', (), (0,), 'dim0_scalar', (), [0]),
+        ('cummin', (S, S, S), (0,), 'dim0', (), [0]),
+        ('cummin', (S, S, S), (1,), 'dim1', (), [0]),
+        ('cummin', (), (0,), 'dim0_scalar', (), [0]),
         ('cumprod', (S, S, S), (0,)),
         ('cumprod', (S, S, S), (1,), 'dim1', (), [0]),
         ('cumprod', (), (0,), 'scalar'),
@@ -4,6 +4,8 @@
 
 #include <test/cpp/api/support.h>
 
+#include <thread>
+
 using namespace torch::autograd;
 
 #define ASSERT_VARIABLE_EQ(a,b) ASSERT_TRUE(torch::allclose((a),(b)))
@@ -610,6 +612,32 @@ TEST(CustomAutogradTest, HookNone) {
   ASSERT_TRUE(was_called);
 }
 
+TEST(AutogradAPITests, NodePoolTest) {
+  // a freed block is handed out again for a request of the same size class
+  void* block = detail::node_pool_allocate(200);
+  detail::node_pool_free(block, 200);
+  void* reused = detail::node_pool_allocate(250);
+  ASSERT_EQ(block, reused);
+  detail::node_pool_free(reused, 250);
+
+  // graphs built on one thread can be freed on another one
+  Variable x = torch::randn({2, 2}, torch::requires_grad());
+  Variable res;
+  std::thread builder([&]() {
+    res = simple_fn(x, x);
+    for (int i = 0; i < 100; i++) {
+      res = res * 1.01;
+    }
+  });
+  builder.join();
+  res.sum().backward();
+  ASSERT_TRUE(x.grad().defined());
+  std::thread releaser([&]() { res.reset(); });
+  releaser.join();
+  auto y = simple_fn(x, x);
+  y.sum().backward();
+}
+
 // TODO add these tests if needed
 // test_once_differentiable
 // test_sparse_backward
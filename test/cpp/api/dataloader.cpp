@@ -9,6 +9,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <fstream>
 #include <future>
 #include <iostream>
 #include <iterator>
@@ -18,6 +20,7 @@
 #include <stdexcept>
 #include <string>
 #include <thread>
+#include <set>
 #include <unordered_set>
 #include <vector>
 
@@ -688,6 +691,49 @@ TEST(DataTest, QueueClearEmptiesTheQueue) {
   ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
 }
 
+TEST(DataTest, MPSCQueuePushAndPopFromSameThread) {
+  torch::data::detail::MPSCQueue<int> queue(3);
+  ASSERT_EQ(queue.capacity(), 4);
+  for (int i = 0; i < 10; ++i) {
+    queue.push(i);
+    queue.push(i + 1);
+    ASSERT_EQ(queue.pop(), i);
+    ASSERT_EQ(queue.pop(), i + 1);
+  }
+  ASSERT_THROWS_WITH(
+      queue.pop(10 * kMillisecond),
+      "Timeout in DataLoader queue while waiting for next batch "
+      "(timeout was 10 ms)");
+  queue.push(1);
+  queue.push(2);
+  ASSERT_EQ(queue.clear(), 2);
+  ASSERT_THROWS_WITH(queue.pop(1 * kMillisecond), "Timeout");
+}
+
+TEST(DataTest, MPSCQueueKeepsTheOrderOfEveryProducer) {
+  // More values than the queue holds, so that producers wait for the
+  // consumer, and the consumer for them.
+  const int kProducers = 8;
+  const int kValues = 1000;
+  torch::data::detail::MPSCQueue<std::pair<int, int>> queue(2);
+  std::vector<std::thread> producers;
+  for (int p = 0; p < kProducers; ++p) {
+    producers.emplace_back([&queue, p] {
+      for (int i = 0; i < kValues; ++i) {
+        queue.push({p, i});
+      }
+    });
+  }
+  std::vector<int> next(kProducers, 0);
+  for (int i = 0; i < kProducers * kValues; ++i) {
+    auto value = queue.pop();
+    ASSERT_EQ(value.second, next.at(value.first)++);
+  }
+  for (auto& producer : producers) {
+    producer.join();
+  }
+}
+
 TEST(DataTest, DataShuttleCanPushAndPopJob) {
   torch::data::detail::DataShuttle<int, int> shuttle;
   shuttle.push_job(1);
@@ -1030,6 +1076,9 @@ TEST(DataLoaderTest, DataLoaderOptionsDefaultAsExpected) {
   ASSERT_EQ(full_options.max_jobs, 0);
   ASSERT_FALSE(full_options.timeout.has_value());
   ASSERT_TRUE(full_options.enforce_ordering);
+  ASSERT_FALSE(full_options.pin_memory);
+  ASSERT_FALSE(full_options.prefetch_device.has_value());
+  ASSERT_EQ(full_options.prefetch_batches, 2);
 }
 
 TEST(DataLoaderTest, DataLoaderOptionsCoalesceOptionalValues) {
@@ -1039,6 +1088,98 @@ TEST(DataLoaderTest, DataLoaderOptionsCoalesceOptionalValues) {
   ASSERT_EQ(full_options.max_jobs, 2 * 10);
 }
 
+TEST(DataLoaderTest, DataLoaderOptionsPrefetchDeviceImpliesPinMemory) {
+  auto partial_options = DataLoaderOptions().prefetch_device(torch::kCUDA);
+  FullDataLoaderOptions full_options(partial_options);
+  ASSERT_TRUE(full_options.pin_memory);
+}
+
+struct RangeDataset : public datasets::Dataset<RangeDataset> {
+  torch::data::Example<> get(size_t i) {
+    return {torch::full({3}, static_cast<double>(i)),
+            torch::tensor(static_cast<int64_t>(i))};
+  }
+  torch::optional<size_t> size() const noexcept {
+    return 100;
+  }
+};
+
+TEST(DataLoaderTest, PinMemoryCollatesIntoPinnedMemory_CUDA) {
+  for (size_t workers : {0, 2}) {
+    auto data_loader = torch::data::make_data_loader(
+        RangeDataset().map(transforms::Stack<>()),
+        torch::data::samplers::SequentialSampler(100),
+        DataLoaderOptions(10).workers(workers).pin_memory(true));
+    int64_t batch_index = 0;
+    for (auto& batch : *data_loader) {
+      ASSERT_TRUE(batch.data.is_pinned());
+      ASSERT_TRUE(batch.target.is_pinned());
+      ASSERT_EQ(batch.data.sizes(), (std::vector<int64_t>{10, 3}));
+      ASSERT_EQ(batch.target[0].item<int64_t>(), 10 * batch_index++);
+    }
+    ASSERT_EQ(batch_index, 10);
+  }
+}
+
+TEST(DataLoaderTest, PinMemoryPinsUncollatedBatches_CUDA) {
+  auto data_loader = torch::data::make_data_loader(
+      RangeDataset(), DataLoaderOptions(4).pin_memory(true));
+  for (auto& batch : *data_loader) {
+    ASSERT_EQ(batch.size(), 4);
+    for (auto& example : batch) {
+      ASSERT_TRUE(example.data.is_pinned());
+    }
+  }
+}
+
+TEST(DataLoaderTest, PrefetchDeviceReturnsBatchesOnDevice_CUDA) {
+  for (size_t workers : {0, 2}) {
+    auto data_loader = torch::data::make_data_loader(
+        RangeDataset().map(transforms::Stack<>()),
+        torch::data::samplers::SequentialSampler(100),
+        DataLoaderOptions(10).workers(workers).prefetch_device(
+            torch::Device(torch::kCUDA, 0)));
+    // Iterate twice to check that batches in flight don't leak across epochs.
+    for (size_t epoch = 0; epoch < 2; ++epoch) {
+      int64_t batch_index = 0;
+      for (auto& batch : *data_loader) {
+        ASSERT_TRUE(batch.data.is_cuda());
+        ASSERT_TRUE(batch.target.is_cuda());
+        auto expected = torch::arange(10 * batch_index, 10 * (batch_index + 1));
+        ASSERT_TRUE(batch.target.cpu().equal(expected));
+        ASSERT_TRUE(batch.data.select(1, 0).cpu().equal(
+            expected.to(torch::kFloat)));
+        ++batch_index;
+      }
+      ASSERT_EQ(batch_index, 10);
+    }
+  }
+}
+
+TEST(DataLoaderTest, DevicePrefetcherCopiesIteratorBatchesToDevice_CUDA) {
+  auto data_loader = torch::data::make_data_loader(
+      RangeDataset().map(transforms::Stack<>()),
+      torch::data::samplers::SequentialSampler(100),
+      DataLoaderOptions(10).workers(2));
+  using Batch = decltype(data_loader)::element_type::BatchType;
+  torch::data::DevicePrefetcher<Batch> prefetcher(
+      data_loader->begin(),
+      data_loader->end(),
+      torch::kCUDA,
+      /*batches_in_flight=*/3);
+  ASSERT_EQ(prefetcher.device(), torch::Device(torch::kCUDA, 0));
+  int64_t batch_index = 0;
+  for (auto& batch : prefetcher) {
+    ASSERT_TRUE(batch.data.is_cuda());
+    ASSERT_TRUE(batch.target.is_cuda());
+    auto expected = torch::arange(10 * batch_index, 10 * (batch_index + 1));
+    ASSERT_TRUE(batch.target.cpu().equal(expected));
+    ++batch_index;
+  }
+  ASSERT_EQ(batch_index, 10);
+  ASSERT_FALSE(prefetcher.next().has_value());
+}
+
 TEST(DataLoaderTest, MakeDataLoaderDefaultsAsExpected) {
   auto data_loader = torch::data::make_data_loader(
       DummyDataset().map(transforms::Lambda<int>([](int x) { return x + 1; })));
@@ -2302,4 +2443,214 @@ TEST(DataLoaderTest, CustomPreprocessPolicy) {
       }
     }
   }
-}
\ No newline at end of file
+}
+/// Writes record file shards of the given sizes next to a temporary file,
+/// numbering the examples consecutively, and removes them when destroyed.
+struct RecordFileShards {
+  explicit RecordFileShards(const std::vector<size_t>& shard_sizes) {
+    int64_t next = 0;
+    for (size_t shard_size : shard_sizes) {
+      paths.push_back(base.name + ".shard" + std::to_string(paths.size()));
+      datasets::RecordFileWriter writer(paths.back());
+      for (size_t i = 0; i < shard_size; ++i, ++next) {
+        writer.write({torch::full({2, 3}, static_cast<double>(next)),
+                      torch::tensor(next)});
+      }
+      writer.close();
+    }
+  }
+  ~RecordFileShards() {
+    for (const auto& path : paths) {
+      std::remove(path.c_str());
+    }
+  }
+
+  c10::TempFile base = c10::make_tempfile();
+  std::vector<std::string> paths;
+};
+
+TEST(DataTest, RecordFileDatasetReadsAcrossShards) {
+  RecordFileShards shards({3, 0, 5});
+  datasets::RecordFileDataset dataset(shards.paths);
+  ASSERT_EQ(dataset.size().value(), 8);
+  ASSERT_EQ(dataset.shards().size(), 3);
+  for (size_t i = 0; i < 8; ++i) {
+    auto example = dataset.get(i);
+    ASSERT_EQ(example.data.sizes(), (std::vector<int64_t>{2, 3}));
+    ASSERT_EQ(example.data.scalar_type(), torch::kFloat);
+    ASSERT_TRUE(example.data.eq(static_cast<double>(i)).all().item<bool>());
+    ASSERT_EQ(example.target.dim(), 0);
+    ASSERT_EQ(example.target.item<int64_t>(), i);
+      ASSERT_EQ(reinterpret_cast<uintptr_t>(example.data.data_ptr()) % 64, 0);
+  }
+  ASSERT_THROWS_WITH(dataset.get(8), "out of range");
+}
+
+TEST(DataTest, RecordFileViewsOutliveTheDataset) {
+  RecordFileShards shards({2});
+  torch::Tensor data;
+  {
+    datasets::RecordFileDataset dataset(shards.paths);
+    data = dataset.get(1).data;
+  }
+  // Writes only touch the private copy of the mapped page.
+  data.add_(1);
+  ASSERT_TRUE(data.eq(2).all().item<bool>());
+  datasets::RecordFileDataset dataset(shards.paths);
+  ASSERT_TRUE(dataset.get(1).data.eq(1).all().item<bool>());
+}
+
+TEST(DataTest, RecordFileRejectsOtherFiles) {
+  auto tempfile = c10::make_tempfile();
+  std::ofstream(tempfile.name) << "not a record file, but long enough to "
+                                  "hold a footer";
+  ASSERT_THROWS_WITH(
+      datasets::RecordFile(tempfile.name), "is not a record file");
+}
+
+TEST(DataLoaderTest, RecordFileDatasetWithDistributedSampler) {
+  RecordFileShards shards({4, 6});
+  const size_t num_replicas = 2;
+  std::vector<int64_t> seen;
+  for (size_t rank = 0; rank < num_replicas; ++rank) {
+    auto data_loader = torch::data::make_data_loader(
+        datasets::RecordFileDataset(shards.paths).map(transforms::Stack<>()),
+        samplers::DistributedSequentialSampler(10, num_replicas, rank),
+        DataLoaderOptions(5));
+    for (auto& batch : *data_loader) {
+      ASSERT_EQ(batch.data.size(0), 5);
+      for (int64_t i = 0; i < batch.target.numel(); ++i) {
+        seen.push_back(batch.target[i].item<int64_t>());
+      }
+    }
+  }
+  std::sort(seen.begin(), seen.end());
+  std::vector<int64_t> expected(10);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(seen, expected);
+}
+
+TEST(DataLoaderTest, RecordFileChunkReaderReadsOneShardPerChunk) {
+  RecordFileShards shards({4, 6, 2});
+  datasets::RecordFileChunkReader reader(shards.paths);
+  ASSERT_EQ(reader.chunk_count(), 3);
+  ASSERT_EQ(reader.read_chunk(1).size(), 6);
+  ASSERT_EQ(reader.read_chunk(1).front().target.item<int64_t>(), 4);
+
+  samplers::SequentialSampler sampler(0);
+  auto dataset = datasets::make_shared_dataset<datasets::ChunkDataset<
+      datasets::RecordFileChunkReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>>(
+      reader, sampler, sampler, datasets::ChunkDatasetOptions(1, 4));
+  auto data_loader = torch::data::make_data_loader(
+      dataset, DataLoaderOptions(4).workers(0));
+  std::vector<int64_t> seen;
+  for (auto& batch : *data_loader) {
+    for (auto& example : batch) {
+      seen.push_back(example.target.item<int64_t>());
+    }
+  }
+  std::vector<int64_t> expected(12);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(seen, expected);
+}
+
+TEST(DataLoaderTest, ChunkDatasetStealsChunksOfSlowGroups) {
+  // The first chunk is slow to read, so the second preloader finds the other
+  // chunks of the group unclaimed and reads them in the meantime.
+  struct SlowFirstChunkReader : DummyChunkDataReader {
+    BatchType read_chunk(size_t chunk_index) override {
+      if (chunk_index == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      }
+      return DummyChunkDataReader::read_chunk(chunk_index);
+    }
+  };
+  const size_t batch_size = 5;
+  samplers::SequentialSampler sampler(0);
+  auto dataset = datasets::make_shared_dataset<datasets::ChunkDataset<
+      SlowFirstChunkReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>>(
+      SlowFirstChunkReader(),
+      sampler,
+      sampler,
+      datasets::ChunkDatasetOptions(2, batch_size, 100, 3));
+  auto data_loader = torch::data::make_data_loader(
+      dataset, DataLoaderOptions(batch_size).workers(0));
+
+  std::vector<int> result;
+  for (auto& batch : *data_loader) {
+    result.insert(result.end(), batch.begin(), batch.end());
+  }
+  // The group is still put together in chunk order.
+  std::vector<int> expected(35);
+  std::iota(expected.begin(), expected.end(), 0);
+  ASSERT_EQ(result, expected);
+
+  auto stats = (*dataset).stats();
+  ASSERT_EQ(stats.chunks_loaded, 3);
+  ASSERT_LE(stats.chunks_stolen, 2);
+  ASSERT_EQ(stats.queued_batches, 0);
+}
+
+TEST(DataLoaderTest, ChunkDatasetAdaptsPreloadersAndCacheSize) {
+  const size_t batch_size = 5;
+  const size_t cache_size = 5;
+  samplers::SequentialSampler sampler(0);
+  auto dataset = datasets::make_shared_dataset<datasets::ChunkDataset<
+      DummyChunkDataReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>>(
+      DummyChunkDataReader(),
+      sampler,
+      sampler,
+      datasets::ChunkDatasetOptions(1, batch_size, cache_size)
+          .max_preloader_count(3)
+          .max_cache_size(4 * cache_size));
+  auto data_loader = torch::data::make_data_loader(
+      dataset, DataLoaderOptions(batch_size).workers(0));
+
+  for (size_t epoch = 0; epoch < 2; ++epoch) {
+    std::multiset<int> result;
+    for (auto& batch : *data_loader) {
+      result.insert(batch.begin(), batch.end());
+      auto stats = (*dataset).stats();
+      ASSERT_LE(stats.preloader_count, 3);
+      ASSERT_GE(stats.cache_size, cache_size);
+      ASSERT_LE(stats.cache_size, 4 * cache_size);
+    }
+    std::vector<int> expected(35);
+    std::iota(expected.begin(), expected.end(), 0);
+    ASSERT_EQ(std::vector<int>(result.begin(), result.end()), expected);
+
+    auto stats = (*dataset).stats();
+    ASSERT_EQ(stats.chunks_loaded, 3);
+    ASSERT_EQ(stats.preloader_count, 0);
+    ASSERT_EQ(stats.queued_examples, 0);
+  }
+}
+
+TEST(DataTest, ChunkDatasetRejectsInvalidAdaptiveBounds) {
+  DummyChunkDataReader data_reader;
+  samplers::SequentialSampler sampler(0);
+  using Dataset = datasets::ChunkDataset<
+      DummyChunkDataReader,
+      samplers::SequentialSampler,
+      samplers::SequentialSampler>;
+  ASSERT_THROWS_WITH(
+      Dataset(
+          data_reader,
+          sampler,
+          sampler,
+          datasets::ChunkDatasetOptions(2, 1).max_preloader_count(1)),
+      "max_preloader_count is less than preloader_count");
+  ASSERT_THROWS_WITH(
+      Dataset(
+          data_reader,
+          sampler,
+          sampler,
+          datasets::ChunkDatasetOptions(1, 1, 10).max_cache_size(5)),
+      "max_cache_size is less than cache_size");
+}
@@ -291,3 +291,106 @@ TEST_F(ParallelTest, DataParallelNumericalEquivalence_MultiCUDA) {
       }
     }
 }
+
+TEST_F(ParallelTest, PersistentDataParallelKeepsItsReplicas_MultiCUDA) {
+  auto m = Linear(3, 2);
+  parallel::PersistentDataParallel<Linear> dp(m);
+  ASSERT_EQ(dp.replicas().size(), torch::cuda::device_count());
+
+  auto replicas = dp.replicas();
+  auto input = torch::ones({10, 3});
+  for (int i = 0; i < 2; ++i) {
+    auto output = dp.forward(input);
+    ASSERT_EQ(output.sizes(), std::vector<int64_t>({10, 2}));
+    ASSERT_TRUE(output.device().is_cuda());
+    ASSERT_EQ(output.device().index(), 0);
+    for (size_t j = 0; j < replicas.size(); ++j) {
+      ASSERT_EQ(dp.replicas()[j].get(), replicas[j].get());
+    }
+  }
+
+  // Modifying a parameter of the module updates the replicas.
+  {
+    torch::NoGradGuard guard;
+    m->weight.fill_(2);
+    m->bias.fill_(1);
+  }
+  auto output = dp.forward(input);
+  ASSERT_TRUE(output.allclose(torch::full({10, 2}, 7, output.options())));
+  for (const auto& replica : dp.replicas()) {
+    ASSERT_TRUE(replica->weight.to(torch::kCPU).allclose(
+        torch::full({2, 3}, 2)));
+  }
+}
+
+TEST_F(ParallelTest, PersistentDataParallelRethrowsException_MultiCUDA) {
+  struct M : torch::nn::Cloneable<M> {
+    void reset() override {}
+    torch::Tensor forward(torch::Tensor input) {
+      throw std::runtime_error("Badness!");
+    }
+  };
+
+  parallel::PersistentDataParallel<std::shared_ptr<M>> dp(
+      std::make_shared<M>());
+  auto input = torch::ones({10, 3});
+  ASSERT_THROWS_WITH(dp.forward(input), "Badness!");
+  ASSERT_THROWS_WITH(dp.forward(input), "Badness!");
+}
+
+TEST_F(ParallelTest, PersistentDataParallelNumericalEquivalence_MultiCUDA) {
+  struct M : torch::nn::Cloneable<M> {
+    M() {
+      reset();
+    }
+
+    void reset() override {
+      conv = register_module("conv",
+          torch::nn::Conv2d(torch::nn::Conv2dOptions(2, 2, /*kernel_size=*/2)));
+      fc = register_module("fc", torch::nn::Linear(8, 2));
+    }
+
+    torch::Tensor forward(torch::Tensor x) {
+      x = conv->forward(x);
+      x = torch::relu(x);
+      x = x.view({-1, 8});
+      x = fc->forward(x);
+      return torch::log_softmax(x, /*dim=*/1);
+    }
+
+    torch::nn::Conv2d conv{nullptr};
+    torch::nn::Linear fc{nullptr};
+  };
+
+  auto model = std::make_shared<M>();
+  auto model_dp = std::dynamic_pointer_cast<M>(model->clone());
+  model->to(torch::Device(torch::kCUDA, 0));
+  parallel::PersistentDataParallel<std::shared_ptr<M>> dp(model_dp);
+
+  // The optimizers live across the iterations, so the replicas only see the
+  // steps through sync().
+  torch::optim::SGD optim(model->parameters(), torch::optim::SGDOptions(0.1));
+  torch::optim::SGD optim_dp(
+      model_dp->parameters(), torch::optim::SGDOptions(0.1));
+  auto input = torch::ones({16, 2, 3, 3});
+  for (int i = 0; i < 3; ++i) {
+    input += i;
+
+    optim.zero_grad();
+    auto output = model->forward(input.to(torch::Device(torch::kCUDA, 0)));
+    torch::mse_loss(output, torch::zeros_like(output)).backward();
+    optim.step();
+
+    optim_dp.zero_grad();
+    auto output_dp = dp.forward(input);
+    torch::mse_loss(output_dp, torch::zeros_like(output_dp)).backward();
+    optim_dp.step();
+
+    auto params = model->parameters();
+    auto params_dp = model_dp->parameters();
+    ASSERT_EQ(params.size(), params_dp.size());
+    for (size_t j = 0; j < params.size(); ++j) {
+      ASSERT_TRUE(torch::allclose(params[j], params_dp[j]));
+    }
+  }
+}
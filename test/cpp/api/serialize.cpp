@@ -461,3 +461,159 @@ TEST(SerializeTest, UnserializableSubmoduleIsIgnoredWhenLoadingModule) {
   // serialization.
   ASSERT_EQ(output, 5);  
 }
+
+TEST(SerializeTest, Streaming) {
+  torch::manual_seed(0);
+
+  auto model = xor_model();
+  auto optimizer = torch::optim::Adagrad(
+      model->parameters(), torch::optim::AdagradOptions(1.0));
+  auto x = model->forward<torch::Tensor>(torch::randn({4, 2})).sum();
+  x.backward();
+  optimizer.step();
+
+  // Small chunks, so that every weight is split across records.
+  auto tempfile = c10::make_tempfile();
+  {
+    OutputArchive archive(tempfile.name, StreamingOptions().chunk_size(16));
+    ASSERT_TRUE(archive.is_streaming());
+    model->save(archive);
+    archive.write("step", c10::IValue(42));
+    archive.write("values", c10::IValue(std::vector<int64_t>{1, 2, 3}));
+    ASSERT_THROWS_WITH(
+        archive.save_to(tempfile.name), "completed by finish()");
+    archive.finish();
+    ASSERT_THROWS_WITH(archive.finish(), "already finished");
+  }
+
+  auto model2 = xor_model();
+  const auto weight = model2->named_parameters()["0.weight"];
+  InputArchive archive;
+  archive.load_from(tempfile.name);
+  ASSERT_TRUE(archive.is_lazy());
+  model2->load(archive);
+  for (const auto& parameter : model->named_parameters()) {
+    ASSERT_TRUE(
+        parameter->allclose(model2->named_parameters()[parameter.key()]));
+  }
+  // Tensors of the same shape are read into in place.
+  ASSERT_TRUE(model2->named_parameters()["0.weight"].is_same(weight));
+
+  c10::IValue step, values;
+  archive.read("step", step);
+  archive.read("values", values);
+  ASSERT_EQ(step.toInt(), 42);
+  ASSERT_EQ(values.toIntListRef().vec(), (std::vector<int64_t>{1, 2, 3}));
+  ASSERT_THROWS_WITH(archive.read("bad_key", step), "No such serialized IValue");
+
+  InputArchive nested;
+  ASSERT_TRUE(archive.try_read("0", nested));
+  ASSERT_FALSE(archive.try_read("1", nested));
+  torch::Tensor bias;
+  ASSERT_THROWS_WITH(
+      nested.read("bias", bias, /*is_buffer=*/true),
+      "Expected deserialized tensor for key 'bias'");
+  nested.read("bias", bias);
+  ASSERT_TRUE(bias.allclose(model[0]->named_parameters()["bias"]));
+}
+
+TEST(SerializeTest, StreamingOptim) {
+  torch::manual_seed(0);
+
+  auto model = Linear(5, 2);
+  auto optimizer = torch::optim::SGD(
+      model->parameters(), torch::optim::SGDOptions(1e-1).momentum(0.9));
+  auto step = [&]() {
+    optimizer.zero_grad();
+    model->forward(torch::ones({3, 5})).sum().backward();
+    optimizer.step();
+  };
+  step();
+
+  std::string serialized;
+  {
+    OutputArchive archive(
+        [&](const void* buf, size_t n) {
+          serialized.append(reinterpret_cast<const char*>(buf), n);
+          return n;
+        },
+        StreamingOptions());
+    optimizer.save(archive);
+    archive.finish();
+  }
+
+  auto model2 = Linear(5, 2);
+  torch::NoGradGuard guard;
+  for (size_t i = 0; i < model->parameters().size(); ++i) {
+    model2->parameters()[i].copy_(model->parameters()[i]);
+  }
+  auto optimizer2 = torch::optim::SGD(
+      model2->parameters(), torch::optim::SGDOptions(1e-1).momentum(0.9));
+  InputArchive archive;
+  archive.load_from(serialized.data(), serialized.size());
+  optimizer2.load(archive);
+  ASSERT_EQ(optimizer.iteration(), optimizer2.iteration());
+}
+
+TEST(SerializeTest, Streaming_CUDA) {
+  torch::manual_seed(0);
+
+  auto x = torch::randn({100, 37}, torch::kCUDA);
+  auto empty = torch::empty({0, 3}, torch::kCUDA);
+  std::stringstream stream;
+  {
+    OutputArchive archive(
+        [&](const void* buf, size_t n) {
+          stream.write(reinterpret_cast<const char*>(buf), n);
+          return n;
+        },
+        StreamingOptions().chunk_size(1000).staging_buffers(3));
+    archive.write("x", x);
+    archive.write("empty", empty, /*is_buffer=*/true);
+    archive.finish();
+  }
+
+  InputArchive archive;
+  archive.load_from(stream);
+  torch::Tensor y, y_cpu, y_empty;
+  archive.read("x", y);
+  ASSERT_TRUE(y.is_cuda());
+  ASSERT_TRUE(x.equal(y));
+  archive.read("empty", y_empty, /*is_buffer=*/true);
+  ASSERT_EQ(y_empty.sizes().vec(), empty.sizes().vec());
+
+  InputArchive cpu_archive;
+  cpu_archive.load_from(stream, torch::kCPU);
+  cpu_archive.read("x", y_cpu);
+  ASSERT_FALSE(y_cpu.is_cuda());
+  ASSERT_TRUE(x.cpu().equal(y_cpu));
+}
+
+TEST(SerializeTest, AsyncCheckpoint) {
+  torch::manual_seed(0);
+
+  auto model = Linear(5, 2);
+  auto expected = model->weight.clone();
+  auto tempfile = c10::make_tempfile();
+
+  AsyncCheckpointer checkpointer(AsyncCheckpointOptions().max_pending(1));
+  auto written = checkpointer.save(model, tempfile.name);
+  ASSERT_LE(checkpointer.pending(), 1);
+  // Later changes don't make it into the checkpoint.
+  {
+    torch::NoGradGuard guard;
+    model->weight.fill_(3);
+  }
+  written.get();
+  ASSERT_EQ(checkpointer.pending(), 0);
+
+  auto model2 = Linear(5, 2);
+  torch::load(model2, tempfile.name);
+  ASSERT_TRUE(model2->weight.allclose(expected));
+
+  auto failed = checkpointer.save(
+      model, [](const void*, size_t) -> size_t { throw std::runtime_error("disk full"); });
+  ASSERT_THROWS_WITH(failed.get(), "disk full");
+  ASSERT_THROWS_WITH(checkpointer.wait(), "disk full");
+  checkpointer.wait();
+}
@@ -3,6 +3,7 @@
 #include <ATen/ATen.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_container.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_context.h>
+#include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_req.h>
 #include <torch/csrc/distributed/autograd/rpc_messages/rpc_with_autograd.h>
 #include <torch/csrc/distributed/autograd/utils.h>
 #include <torch/torch.h>
@@ -48,3 +49,28 @@ TEST_F(DistAutogradTest, TestSendFunctionInvalidInputs) {
   send_function->setGrads({in1, torch::autograd::Variable()});
   EXPECT_THROW(send_function->apply({}), c10::Error);
 }
+
+TEST_F(DistAutogradTest, TestCoalescedPropagateGradientsReq) {
+  std::vector<PropagateGradientsReq::Entry> entries;
+  entries.push_back({3, {torch::ones({2}), torch::zeros({3, 3})}});
+  entries.push_back({5, {}});
+  entries.push_back({7, {torch::full({1}, 2.0)}});
+  PropagateGradientsReq request(42, entries);
+
+  auto message = std::move(request).toMessage();
+  ASSERT_EQ(message.tensors().size(), 3);
+  auto deserialized = PropagateGradientsReq::fromMessage(message);
+
+  ASSERT_EQ(deserialized->getAutogradContextId(), 42);
+  const auto& deserializedEntries = deserialized->getEntries();
+  ASSERT_EQ(deserializedEntries.size(), entries.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    ASSERT_EQ(
+        deserializedEntries[i].autogradMessageId,
+        entries[i].autogradMessageId);
+    ASSERT_EQ(deserializedEntries[i].grads.size(), entries[i].grads.size());
+    for (size_t j = 0; j < entries[i].grads.size(); j++) {
+      ASSERT_TRUE(deserializedEntries[i].grads[j].equal(entries[i].grads[j]));
+    }
+  }
+}
@@ -260,5 +260,53 @@ void testDifferentiateWithRequiresGrad() {
       ->run(*grad_spec.df);
 }
 
+void testDifferentiateWithRecompute() {
+  // Builds graph a * b * a + b, whose backward captures a * b
+  const auto build_graph = []() {
+    auto graph = std::make_shared<Graph>();
+    const auto type = TensorType::create(
+        at::ScalarType::Float, at::kCPU, {2, 3, 4}, {12, 4, 1});
+    auto* a = graph->addInput()->setType(type);
+    auto* b = graph->addInput()->setType(type);
+    auto* ab = graph->insert(aten::mul, {a, b});
+    auto* aba = graph->insert(aten::mul, {ab, a});
+    graph->registerOutput(graph->insert(aten::add, {aba, b}));
+    for (Node* n : graph->nodes()) {
+      for (Value* output : n->outputs()) {
+        if (output->type()->isSubtypeOf(TensorType::get())) {
+          output->setType(type);
+        }
+      }
+    }
+    return graph;
+  };
+
+  auto graph = build_graph();
+  auto grad_spec = differentiate(graph);
+  ASSERT_EQ(grad_spec.recomputed_bytes, 0);
+
+  const auto prev_budget = getAutodiffRecomputeBudget().load();
+  getAutodiffRecomputeBudget() = 0;
+  auto recompute_graph = build_graph();
+  auto recompute_spec = differentiate(recompute_graph);
+  getAutodiffRecomputeBudget() = prev_budget;
+
+  // a * b is recomputed from the captured a and b instead of being captured
+  ASSERT_EQ(
+      recompute_spec.recomputed_bytes,
+      static_cast<int64_t>(2 * 3 * 4 * sizeof(float)));
+  ASSERT_EQ(recompute_spec.recompute_flops, 2 * 3 * 4);
+  ASSERT_EQ(
+      recompute_spec.df_input_captured_inputs,
+      grad_spec.df_input_captured_inputs);
+  ASSERT_EQ(
+      recompute_spec.df_input_captured_outputs.size(),
+      grad_spec.df_input_captured_outputs.size() - 1);
+  testing::FileCheck()
+      .check("aten::mul")
+      ->check("prim::GradOf")
+      ->run(*recompute_spec.df);
+}
+
 } // namespace jit
 } // namespace torch
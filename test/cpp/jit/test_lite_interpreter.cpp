@@ -74,5 +74,42 @@ void testLiteInterpreterConv() {
   AT_ASSERT(outputref.dim() == output.dim());
   AT_ASSERT(outputref[0][0][0][0].item<int>() == output[0][0][0][0].item<int>());
 }
+
+void testLiteInterpreterWeightCompression() {
+  script::Module m("m");
+  m.register_parameter("weight", torch::randn({64, 32}), false);
+  m.register_parameter("bias", torch::randn({64}), false);
+  m.define(R"(
+    def forward(self, input):
+      return torch.mm(self.weight, input) + self.bias.unsqueeze(1)
+  )");
+
+  std::vector<IValue> inputs;
+  inputs.push_back(torch::randn({32, 4}));
+  auto outputref = m.forward(inputs).toTensor();
+
+  std::stringstream uncompressed;
+  m._save_for_mobile(uncompressed);
+  size_t uncompressed_size = uncompressed.str().size();
+
+  for (auto compression :
+       {WeightCompression::FP16, WeightCompression::INT8_ROWWISE}) {
+    std::stringstream ss;
+    m._save_for_mobile(ss, {}, compression);
+    AT_ASSERT(ss.str().size() < uncompressed_size);
+
+    mobile::Module bc = _load_for_mobile(ss);
+    auto bcinputs = inputs;
+    auto output = bc.run_method("forward", bcinputs).toTensor();
+    AT_ASSERT(output.allclose(outputref, 0.1, 0.5));
+
+    // the full loader decodes them too, the bias is kept as is
+    std::istringstream in(ss.str());
+    auto loaded = load(in);
+    AT_ASSERT(loaded.get_parameter("bias").equal(m.get_parameter("bias")));
+    AT_ASSERT(loaded.get_parameter("weight").allclose(
+        m.get_parameter("weight"), 0, 0.05));
+  }
+}
 } // namespace torch
 } // namespace jit
@@ -809,6 +809,61 @@ void testRecordFunction() {
 
   autograd::profiler::popCallback();
   autograd::profiler::popCallback();
+
+  // test per-callback sampling and captured inputs
+  int half_cb_ctr = 0;
+  int never_cb_ctr = 0;
+  int shapes_cb_ctr = 0;
+  autograd::profiler::CallbackConfig half_config;
+  half_config.sampling_prob = 0.5;
+  autograd::profiler::pushCallback(
+      [&half_cb_ctr](const autograd::profiler::RecordFunction& fn) {
+        if (std::string(fn.name().str()) == "test") {
+          ++half_cb_ctr;
+        }
+      },
+      [](const autograd::profiler::RecordFunction&) {},
+      half_config);
+  autograd::profiler::CallbackConfig never_config;
+  never_config.sampling_prob = 0.0;
+  never_config.needs_inputs = true;
+  autograd::profiler::pushCallback(
+      [&never_cb_ctr](const autograd::profiler::RecordFunction&) {
+        ++never_cb_ctr;
+      },
+      [](const autograd::profiler::RecordFunction&) {},
+      never_config);
+  autograd::profiler::CallbackConfig shapes_config;
+  shapes_config.needs_shapes = true;
+  autograd::profiler::pushCallback(
+      [&shapes_cb_ctr](const autograd::profiler::RecordFunction& fn) {
+        if (std::string(fn.name().str()) == "test") {
+          ++shapes_cb_ctr;
+          // Only the callback that never runs needs the inputs
+          TORCH_CHECK(fn.inputs().empty());
+          TORCH_CHECK(fn.inputSizes().size() == 1);
+          TORCH_CHECK(fn.inputSizes()[0] == std::vector<int64_t>({1, 2, 3}));
+        }
+      },
+      [](const autograd::profiler::RecordFunction&) {},
+      shapes_config);
+
+  run_test_function();
+  TORCH_CHECK(half_cb_ctr > 0 && half_cb_ctr < 1000);
+  TORCH_CHECK(never_cb_ctr == 0);
+  TORCH_CHECK(shapes_cb_ctr == 1000);
+
+  {
+    autograd::profiler::RecordFunctionGuard disabled(false);
+    TORCH_CHECK(!autograd::profiler::hasCallbacks());
+    run_test_function();
+  }
+  TORCH_CHECK(shapes_cb_ctr == 1000);
+  TORCH_CHECK(autograd::profiler::hasCallbacks());
+
+  autograd::profiler::popCallback();
+  autograd::profiler::popCallback();
+  autograd::profiler::popCallback();
 }
 
 class TestThreadLocalDebugInfo
@@ -1057,6 +1112,35 @@ void testInsertAndEliminateRedundantGuards() {
   ASSERT_EQ(num_guards, 2);
 }
 
+void testEliminateGuardsOnSymbolicSizes() {
+  static const auto symbolic_example = R"JIT(
+  def symbolic(x, y):
+    a = torch.relu(x)
+    b = a.view(y.size())
+    c = b.exp() + y.expand([y.size(0), y.size(1)])
+    return c.reshape([y.size(1), y.size(0)])
+  )JIT";
+
+  auto cu = compile(symbolic_example);
+  auto& fun = cu->get_function("symbolic");
+  auto pr = ProfilingRecord::instrumentGraph(fun.graph());
+  auto x = at::randn({3, 2}, at::kCPU);
+  auto y = at::randn({2, 3}, at::kCPU);
+  auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+  auto stack = createStack({v(x), v(y)});
+  Code cd(pr->profiled_graph_);
+  InterpreterState is{cd};
+  is.run(stack);
+  auto copy = pr->profiled_graph_->copy();
+  InsertGuards(copy);
+  // all the shapes are functions of the shapes of x and y
+  EliminateRedundantGuards(copy);
+  auto nodes = copy->block()->nodes();
+  auto is_guard = [](Node* n) { return n->kind() == prim::Guard; };
+  auto num_guards = std::count_if(nodes.begin(), nodes.end(), is_guard);
+  ASSERT_EQ(num_guards, 2);
+}
+
 void testInsertBailOuts() {
   static const auto basic_example = R"JIT(
   def basic_loop(x, y):
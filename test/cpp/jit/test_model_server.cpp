@@ -0,0 +1,138 @@
+#include <test/cpp/jit/test_base.h>
+#include <torch/csrc/autograd/generated/variable_factories.h>
+#include <torch/csrc/jit/model_server.h>
+
+#include <atomic>
+#include <thread>
+
+// Tests go in torch::jit
+namespace torch {
+namespace jit {
+
+namespace {
+
+script::Module addModule(int64_t b) {
+  script::Module m("m");
+  m.register_parameter("b", torch::full({}, b), false);
+  m.define(R"(
+    def forward(self, x):
+      return x + self.b
+  )");
+  return m;
+}
+
+void waitFor(const std::atomic<bool>& flag) {
+  while (!flag) {
+    std::this_thread::yield();
+  }
+}
+
+} // namespace
+
+void testModelServer() {
+  using Status = ModelServer::Status;
+  ModelServer::Options options;
+  options.workers_per_priority = {1, 2};
+  ModelServer server(options);
+
+  ModelServer::ModelOptions high;
+  high.priority = 0;
+  server.addModel("high", addModule(1), high);
+  ModelServer::ModelOptions low;
+  low.priority = 1;
+  low.max_concurrency = 2;
+  server.addModel("low", addModule(2), low);
+
+  auto result = server.run("high", {torch::zeros({2})});
+  ASSERT_TRUE(result.status == Status::OK);
+  ASSERT_TRUE(result.output.toTensor().equal(torch::ones({2})));
+
+  // The callbacks run on the workers, they only count the right results.
+  constexpr int kRequests = 20;
+  std::atomic<int> done{0};
+  std::atomic<int> right{0};
+  for (int i = 0; i < kRequests; ++i) {
+    const bool to_high = i % 2;
+    server.runAsync(
+        to_high ? "high" : "low",
+        {torch::full({2}, i)},
+        [&done, &right, i, to_high](ModelServer::Result result) {
+          if (result.status == Status::OK &&
+              result.output.toTensor().equal(
+                  torch::full({2}, i + (to_high ? 1 : 2)))) {
+            right++;
+          }
+          done++;
+        });
+  }
+  while (done < kRequests) {
+    std::this_thread::yield();
+  }
+  ASSERT_EQ(right.load(), kRequests);
+  auto metrics = server.metrics("high");
+  ASSERT_EQ(metrics.completed, 1 + kRequests / 2);
+  ASSERT_EQ(metrics.queued, 0);
+  ASSERT_EQ(metrics.running, 0);
+  ASSERT_TRUE(metrics.latencyPercentile(0.5) <= metrics.max_latency);
+
+  // A request past its deadline is not run.
+  result = server.run(
+      "low",
+      {torch::zeros({2})},
+      ModelServer::Clock::now() - std::chrono::seconds(1));
+  ASSERT_TRUE(result.status == Status::EXPIRED);
+  ASSERT_EQ(server.metrics("low").expired, 1);
+
+  // Errors of the model are returned.
+  result = server.run("low", {torch::zeros({2}), torch::zeros({2})});
+  ASSERT_TRUE(result.status == Status::FAILED);
+  ASSERT_FALSE(result.error.empty());
+  ASSERT_EQ(server.metrics("low").failed, 1);
+}
+
+void testModelServerAdmission() {
+  using Status = ModelServer::Status;
+  ModelServer::Options options;
+  options.workers_per_priority = {1};
+  std::atomic<int> ok{0};
+  std::atomic<int> rejected{0};
+  auto count = [&ok, &rejected](ModelServer::Result result) {
+    if (result.status == Status::OK) {
+      ok++;
+    } else if (result.status == Status::REJECTED) {
+      rejected++;
+    }
+  };
+  {
+    ModelServer server(options);
+    ModelServer::ModelOptions model_options;
+    model_options.max_queue_size = 2;
+    server.addModel("m", addModule(1), model_options);
+
+    // Keep the only worker in the callback of the first request.
+    std::atomic<bool> blocked{false};
+    std::atomic<bool> release{false};
+    server.runAsync(
+        "m",
+        {torch::zeros({2})},
+        [&](ModelServer::Result result) {
+          count(std::move(result));
+          blocked = true;
+          waitFor(release);
+        });
+    waitFor(blocked);
+
+    for (int i = 0; i < 5; ++i) {
+      server.runAsync("m", {torch::zeros({2})}, count);
+    }
+    ASSERT_EQ(rejected.load(), 3);
+    ASSERT_EQ(server.metrics("m").rejected, 3);
+    ASSERT_EQ(server.metrics("m").queued, 2);
+    release = true;
+  }
+  // The queued requests run before the server stops.
+  ASSERT_EQ(ok.load(), 3);
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,73 @@
+#include <test/cpp/jit/test_base.h>
+#include <ATen/Parallel.h>
+#include <torch/csrc/autograd/generated/variable_factories.h>
+#include <torch/csrc/jit/shared_weights.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+// Tests go in torch::jit
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Runs a task on the inter-op pool, false if it didn't run within a few
+// seconds.
+bool launchAndWait() {
+  auto done = std::make_shared<std::atomic<bool>>(false);
+  at::launch([done]() { *done = true; });
+  for (int i = 0; i < 10000 && !*done; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return *done;
+}
+
+} // namespace
+
+void testSharedWeights() {
+#ifndef _WIN32
+  script::Module m("m");
+  m.register_parameter("weight", torch::randn({8, 8}), false);
+  m.register_buffer("bias", torch::randn({8}));
+  script::Module child("child");
+  child.register_parameter("weight", torch::randn({8, 8}), false);
+  m.register_module("child", child);
+  m.define(R"(
+    def forward(self, x):
+      return self.child.weight.mm(self.weight.mm(x)) + self.bias
+  )");
+
+  auto x = torch::randn({8, 8});
+  auto expected = m.forward({x}).toTensor();
+  const void* weight_data = m.get_parameter("weight").data_ptr();
+
+  // 2 weights of 256 bytes and a bias rounded up to 64 bytes
+  ASSERT_EQ(shareWeightsReadOnly(m), 2 * 8 * 8 * 4 + 64);
+  ASSERT_TRUE(m.get_parameter("weight").data_ptr() != weight_data);
+  ASSERT_TRUE(m.forward({x}).toTensor().equal(expected));
+
+  // The forked child gets the same weights, and a new inter-op pool in place
+  // of the one started here, whose threads are not forked.
+  ASSERT_TRUE(launchAndWait());
+  pid_t pid = fork();
+  if (pid == 0) {
+    bool ok = m.forward({x}).toTensor().equal(expected) && launchAndWait();
+    _exit(ok ? 0 : 1);
+  }
+  ASSERT_TRUE(pid > 0);
+  int status = 0;
+  ASSERT_EQ(waitpid(pid, &status, 0), pid);
+  ASSERT_TRUE(WIFEXITED(status));
+  ASSERT_EQ(WEXITSTATUS(status), 0);
+#endif
+}
+
+} // namespace jit
+} // namespace torch
@@ -22,6 +22,7 @@ namespace jit {
   _(SchemaMatching)                    \
   _(Differentiate)                     \
   _(DifferentiateWithRequiresGrad)     \
+  _(DifferentiateWithRecompute)        \
   _(FromQualString)                    \
   _(InternedStrings)                   \
   _(IValue)                            \
@@ -48,6 +49,7 @@ namespace jit {
   _(ClassParser)                       \
   _(Profiler)                          \
   _(InsertAndEliminateRedundantGuards) \
+  _(EliminateGuardsOnSymbolicSizes)    \
   _(InsertBailOuts)                    \
   _(PeepholeOptimize)                  \
   _(RecordFunction)                    \
@@ -64,8 +66,12 @@ namespace jit {
   _(CustomFusionNestedBlocks)          \
   _(ClassDerive)                       \
   _(Inliner)                           \
+  _(ModelServer)                       \
+  _(ModelServerAdmission)              \
+  _(SharedWeights)                     \
   _(LiteInterpreterAdd)                \
-  _(LiteInterpreterConv)
+  _(LiteInterpreterConv)               \
+  _(LiteInterpreterWeightCompression)
 
 #define TH_FORALL_TESTS_CUDA(_) \
   _(ArgumentSpec)               \
@@ -72,6 +72,15 @@ def _all_contexts_cleaned_up(num_contexts, timeout_seconds=10):
 from torch.autograd import Function
 from torch.autograd.function import once_differentiable
 
+def _make_linear_stage(seed):
+    torch.manual_seed(seed)
+    return torch.nn.Linear(4, 4)
+
+
+def _stage_param_grads(stage):
+    return [param.grad for param in stage.local_value().parameters()]
+
+
 class SimulateBackwardError(Function):
     @staticmethod
     def forward(ctx, input):
@@ -749,6 +758,37 @@ class DistAutogradTest(object):
 
                 local_grads = self._verify_backwards(exec_mode, [r1, r2, r3, r4], context_id, local_grads, t1, t2)
 
+    @dist_init(setup_model_parallel=True)
+    def test_pipeline_executor(self):
+        workers = ['worker{}'.format((self.rank + i) % self.world_size)
+                   for i in (1, 2)]
+        stages = [rpc.remote(worker, _make_linear_stage, args=(self.rank + i,))
+                  for i, worker in enumerate(workers)]
+        local_stages = [_make_linear_stage(self.rank + i) for i in range(2)]
+        model = torch.nn.Sequential(*local_stages)
+
+        inputs = torch.rand(8, 4)
+        targets = torch.rand(8, 4)
+
+        def loss_fn(output, target):
+            return (output - target).pow(2).sum()
+
+        pipeline = rpc.pipeline.PipelineExecutor(stages, chunks=4)
+        losses = pipeline.run(inputs, targets, loss_fn)
+        self.assertEqual(len(losses), 4)
+
+        loss = loss_fn(model(inputs), targets)
+        loss.backward()
+        self.assertEqual(sum(losses), loss.detach())
+        for stage, local_stage in zip(stages, local_stages):
+            grads = rpc.rpc_sync(stage.owner(), _stage_param_grads, args=(stage,))
+            for grad, param in zip(grads, local_stage.parameters()):
+                self.assertEqual(grad, param.grad)
+
+        output = pipeline.forward(inputs)
+        self.assertFalse(output.requires_grad)
+        self.assertEqual(output, model(inputs).detach())
+
 
 if __name__ == '__main__':
     unittest.main()
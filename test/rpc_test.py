@@ -97,6 +97,10 @@ def my_tensor_function(a, b):
     return a + b
 
 
+def return_tensors(*tensors):
+    return tensors
+
+
 def my_complex_tensor_function(list_input, tensor_class_input, dict_input):
     res = list_input[0]
     for t in list_input:
@@ -176,6 +180,16 @@ def raise_func():
     raise ValueError("Expected error")
 
 
+@rpc.functions.batch(max_batch_size=4, window_ms=50)
+def batched_add(xs, ys):
+    return [x + y for x, y in zip(xs, ys)]
+
+
+@rpc.functions.batch(max_batch_size=4, window_ms=50)
+def batched_wrong_size(xs):
+    return xs[:1] + xs
+
+
 # load_tests from common_utils is used to automatically filter tests for
 # sharding on sandcastle. This line silences flake warnings
 load_tests = load_tests
@@ -405,6 +419,25 @@ class RpcTest(object):
         )
         self.assertEqual(fut.wait(), torch.ones(n, n) * 2)
 
+    @dist_init(setup_model_parallel=True)
+    def test_batched_function(self):
+        futs = [
+            rpc.rpc_async(
+                "worker0", batched_add, args=(torch.ones(2, 2) * i, self.rank)
+            )
+            for i in range(10)
+        ]
+        for i, fut in enumerate(futs):
+            self.assertEqual(fut.wait(), torch.ones(2, 2) * i + self.rank)
+        # called locally, a batched function runs a batch of one
+        self.assertEqual(batched_add(1, 2), 3)
+
+    @dist_init(setup_model_parallel=True)
+    def test_batched_function_returning_wrong_number_of_results(self):
+        fut = rpc.rpc_async("worker0", batched_wrong_size, args=(self.rank,))
+        with self.assertRaisesRegex(Exception, "results for a batch of"):
+            fut.wait()
+
     @dist_init(setup_model_parallel=True)
     def test_nonzero(self):
         n = self.rank + 1
@@ -602,6 +635,27 @@ class RpcTest(object):
         )
         self.assertEqual(ret, my_complex_tensor_function(a, b, c))
 
+    @dist_init(setup_model_parallel=True)
+    def test_py_tensors_layouts(self):
+        n = self.rank + 1
+        dst_rank = n % self.world_size
+        tensors = (
+            torch.arange(4 * n * n, dtype=torch.int64).view(2 * n, 2 * n).t(),
+            torch.ones(100, n)[n:n + 2],
+            torch.empty(0, n),
+            torch.tensor([True, False]),
+            torch.sparse_coo_tensor([[0, n]], [1., 2.], (n + 1,)),
+            torch.ones(n, requires_grad=True),
+        )
+        ret = rpc.rpc_sync(
+            "worker{}".format(dst_rank), return_tensors, args=tensors
+        )
+        self.assertEqual(len(ret), len(tensors))
+        for received, sent in zip(ret, tensors):
+            self.assertEqual(received.dtype, sent.dtype)
+            self.assertEqual(received.layout, sent.layout)
+            self.assertEqual(received, sent)
+
     @dist_init(setup_model_parallel=True)
     def test_py_nested_pickle(self):
         n = self.rank + 1
@@ -1,8 +1,10 @@
 import contextlib
 import gc
+import json
 import sys
 import math
 import tempfile
+import threading
 import time
 import unittest
 import warnings
@@ -518,6 +520,44 @@ class TestAutograd(TestCase):
         z.backward(torch.ones(5, 5))
         self.assertEqual(y.grad.data, (x.data + 1) * 4)
 
+    def test_batched_grad_hook(self):
+        params = [torch.ones(3, requires_grad=True) for _ in range(5)]
+        calls = []
+
+        def hook(indices, grads):
+            calls.append(list(indices))
+            for i, grad in zip(indices, grads):
+                self.assertIs(grad, params[i].grad)
+                grad.mul_(2)
+
+        handle = torch.autograd.register_batched_grad_hook(params, hook)
+        sum(p * (i + 1) for i, p in enumerate(params)).sum().backward()
+        self.assertEqual(len(calls), 1)
+        self.assertEqual(sorted(calls[0]), list(range(5)))
+        for i, p in enumerate(params):
+            self.assertEqual(p.grad, torch.full((3,), 2 * (i + 1)))
+
+        # Only the tensors that got a gradient are passed
+        del calls[:]
+        (params[1] + params[3]).sum().backward()
+        self.assertEqual([sorted(c) for c in calls], [[1, 3]])
+
+        handle.remove()
+        del calls[:]
+        params[0].sum().backward()
+        self.assertEqual(calls, [])
+
+        handle = torch.autograd.register_batched_grad_hook(params, hook, batch_size=2)
+        sum(params).sum().backward()
+        self.assertEqual([len(c) for c in calls], [2, 2, 1])
+        self.assertEqual(sorted(sum(calls, [])), list(range(5)))
+        del handle
+        params[0].sum().backward()
+        self.assertEqual(len(calls), 3)
+
+        with self.assertRaisesRegex(RuntimeError, "leaf tensors"):
+            torch.autograd.register_batched_grad_hook([params[0] * 2], hook)
+
     def test_hooks_cpp(self):
         # Tests hooks for autograd function implemented in C++
         bn = torch.nn.BatchNorm1d(5, affine=False)
@@ -2532,6 +2572,48 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_sampling_profiler(self):
+        x = torch.randn(10, 10)
+
+        config = torch.autograd.SamplingProfilerConfig()
+        config.sampling_period = 1
+        torch.autograd._enable_sampling_profiler(config)
+        try:
+            y = x * 2 + 4
+        finally:
+            samples = torch.autograd._disable_sampling_profiler()
+        names = [samples.names[r.name_id] for r in samples.ranges]
+        self.assertEqual(names, ['mul', 'add'])
+        self.assertLessEqual(samples.ranges[0].end_ns, samples.ranges[1].start_ns)
+        self.assertEqual(samples.dropped, 0)
+
+        config.sampling_period = 10
+        config.buffer_size = 16
+        torch.autograd._enable_sampling_profiler(config)
+        try:
+            for _ in range(1000):
+                y = x + 1
+            samples = torch.autograd._drain_sampling_profiler()
+        finally:
+            torch.autograd._disable_sampling_profiler()
+        self.assertGreater(len(samples.ranges) + samples.dropped, 0)
+        self.assertLess(len(samples.ranges) + samples.dropped, 1000)
+        self.assertLessEqual(len(samples.ranges), 16)
+
+    def test_trace_streamer(self):
+        x = torch.randn(10, 10)
+        with tempfile.NamedTemporaryFile(mode='r') as f:
+            streamer = torch.autograd._TraceStreamer(f.name, flush_interval_ms=1)
+            try:
+                y = x * 2
+                time.sleep(0.01)
+                y = y + 4
+            finally:
+                streamer.stop()
+            trace = json.load(f)
+        names = [e['name'] for e in trace if e['ph'] == 'X']
+        self.assertEqual(names, ['mul', 'add'])
+
     def test_profiler_aggregation_fake(self):
         events = EventList()
         id = [0]
@@ -3046,6 +3128,30 @@ class TestAutograd(TestCase):
                     out.backward()
             self.assertIn('MyFunc.apply', str(w[0].message))
 
+    def test_anomaly_detect_fast(self):
+        class MyFunc(Function):
+            @staticmethod
+            def forward(ctx, inp):
+                return inp.clone()
+
+            @staticmethod
+            def backward(ctx, gO):
+                return gO / 0  # Generate infs
+
+        inp = torch.rand(10, requires_grad=True)
+        with self.assertRaisesRegex(RuntimeError, "Function 'MyFuncBackward' returned nan or inf values in its 0th output."):
+            with warnings.catch_warnings(record=True) as w:
+                with detect_anomaly(fast=True):
+                    out = MyFunc.apply(inp).mul(2)
+                    out.sum().backward()
+            self.assertIn('MyFunc.apply', str(w[0].message))
+        self.assertFalse(torch._C._is_anomaly_fast())
+
+        # Functions whose outputs are finite don't fail
+        with detect_anomaly(fast=True):
+            out = inp.mul(2).exp()
+            out.sum().backward()
+
     @skipIfNoLapack
     def test_symeig_no_eigenvectors(self):
         A = torch.tensor([[1., 2.], [2., 4.]], dtype=torch.float32, requires_grad=True)
@@ -3268,6 +3374,109 @@ for shape in [(1,), ()]:
         self.assertEqual(order.count("Reentrant"), 10)
         self.assertEqual(order[-1], "MyFunction")
 
+    def test_inline_cpu_backward(self):
+        threads = []
+
+        class RecordThread(Function):
+            @staticmethod
+            def forward(ctx, x):
+                return x.clone()
+
+            @staticmethod
+            def backward(ctx, grad):
+                threads.append(threading.current_thread())
+                return grad
+
+        class Reenter(Function):
+            @staticmethod
+            def forward(ctx, x):
+                with torch.enable_grad():
+                    ctx.x = Variable(x.data, requires_grad=True)
+                    ctx.output_var = RecordThread.apply(ctx.x * 2)
+                return ctx.output_var.detach()
+
+            @staticmethod
+            def backward(ctx, grad_output):
+                with torch.enable_grad():
+                    ctx.output_var.sum().backward()
+                return ctx.x.grad * grad_output
+
+        class RaiseError(Function):
+            @staticmethod
+            def forward(ctx, x):
+                return x.clone()
+
+            @staticmethod
+            def backward(ctx, grad):
+                raise RuntimeError("Simulate error in backward")
+
+        def run():
+            x = torch.randn(5, 5, requires_grad=True)
+            w = torch.randn(5, requires_grad=True)
+            out = Reenter.apply(RecordThread.apply(x) * w).sum()
+            dw, = torch.autograd.grad(out, w, retain_graph=True)
+            out.backward()
+            return x.grad, dw
+
+        torch.manual_seed(0)
+        expected = run()
+        self.assertNotIn(threading.current_thread(), threads)
+
+        prev = torch._C._is_inline_cpu_backward_enabled()
+        torch._C._set_inline_cpu_backward_enabled(True)
+        try:
+            threads = []
+            torch.manual_seed(0)
+            self.assertEqual(run(), expected)
+            self.assertEqual(set(threads), {threading.current_thread()})
+
+            a = torch.randn(3, requires_grad=True)
+            with self.assertRaisesRegex(RuntimeError, "Simulate error"):
+                RaiseError.apply(a).sum().backward()
+        finally:
+            torch._C._set_inline_cpu_backward_enabled(prev)
+
+    def test_parallel_cpu_backward(self):
+        class Reenter(Function):
+            @staticmethod
+            def forward(ctx, x):
+                with torch.enable_grad():
+                    ctx.x = Variable(x.data, requires_grad=True)
+                    ctx.output_var = (ctx.x * 3).tanh()
+                return ctx.output_var.detach()
+
+            @staticmethod
+            def backward(ctx, grad_output):
+                with torch.enable_grad():
+                    ctx.output_var.sum().backward()
+                return ctx.x.grad * grad_output
+
+        def run():
+            x = torch.randn(8, 8, requires_grad=True)
+            w = torch.randn(8, 8, requires_grad=True)
+            towers = []
+            for i in range(16):
+                h = x.mm(w) * (i + 1)
+                for _ in range(4):
+                    h = h.sigmoid() + h
+                towers.append(Reenter.apply(h) if i % 4 == 0 else h)
+            out = torch.stack(towers).sum()
+            dx, = torch.autograd.grad(out, x, retain_graph=True)
+            out.backward()
+            return dx, x.grad, w.grad
+
+        torch.manual_seed(0)
+        expected = run()
+
+        prev = torch._C._get_num_cpu_backward_threads()
+        torch._C._set_num_cpu_backward_threads(4)
+        try:
+            for _ in range(5):
+                torch.manual_seed(0)
+                self.assertEqual(run(), expected)
+        finally:
+            torch._C._set_num_cpu_backward_threads(prev)
+
     @slowTest
     def test_checkpointing(self):
         num_inp = 2000
@@ -23,7 +23,8 @@ from torch import nn
 import torch.nn.functional as F
 import torch.distributed as c10d
 import torch.distributed as dist
-from torch.nn.parallel import DistributedDataParallel
+from torch.nn.parallel import DistributedDataParallel, ShardedEmbedding
+from torch.distributed.optim import ZeroRedundancyOptimizer
 
 from common_distributed import MultiProcessTestCase, \
     requires_gloo, requires_nccl, requires_nccl_version, \
@@ -323,6 +324,62 @@ class PrefixTCPStoreTest(TestCase, StoreTestBase):
         return c10d.PrefixStore(self.prefix, self.tcpstore)
 
 
+def create_sharded_tcp_store(addr):
+    """
+    Creates a sharded TCP store. Retries if the chosen port is already in use.
+    """
+    ports = []
+    for _ in range(10):
+        try:
+            port = common.find_free_port()
+            ports.append(port)
+            return c10d.ShardedTCPStore(addr, port, 1, True), port
+        except RuntimeError as error:
+            if str(error) == "Address already in use":
+                continue
+            raise
+    raise RuntimeError("Unable to find free port (tried %s)" % ", ".join(ports))
+
+
+class ShardedTCPStoreTest(TestCase, StoreTestBase):
+    def _create_store(self):
+        store, _ = create_sharded_tcp_store('localhost')
+        store.set_timeout(timedelta(seconds=300))
+        return store
+
+    def test_multi_set_get(self):
+        store = self._create_store()
+        store.multi_set(["a", "b"], ["1", "2"])
+        self.assertEqual([b"2", b"1"], store.multi_get(["b", "a"]))
+
+    def test_compare_set(self):
+        store = self._create_store()
+        self.assertEqual(b"", store.compare_set("key", "old", "new"))
+        self.assertEqual(b"first", store.compare_set("key", "", "first"))
+        self.assertEqual(b"first", store.compare_set("key", "old", "new"))
+        self.assertEqual(b"new", store.compare_set("key", "first", "new"))
+
+    def test_proxy(self):
+        store, port = create_sharded_tcp_store('localhost')
+        proxy = c10d.ShardedTCPStoreProxy('localhost', port, 0)
+        client = c10d.ShardedTCPStore('localhost', proxy.port, 1, False)
+        client.set("key", "value")
+        client.barrier("barrier", 1)
+        self.assertEqual(b"value", store.get("key"))
+        self.assertEqual(b"value", client.get("key"))
+
+
+class PrefixShardedTCPStoreTest(TestCase, StoreTestBase):
+    def setUp(self):
+        super(PrefixShardedTCPStoreTest, self).setUp()
+        self.tcpstore, _ = create_sharded_tcp_store('localhost')
+        self.prefix = "test_prefix"
+        self.tcpstore.set_timeout(timedelta(seconds=300))
+
+    def _create_store(self):
+        return c10d.PrefixStore(self.prefix, self.tcpstore)
+
+
 class RendezvousTest(TestCase):
     def test_unknown_handler(self):
         with self.assertRaisesRegex(RuntimeError, "^No rendezvous handler"):
@@ -799,6 +856,21 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
         inputs = [torch.tensor([i + self.rank]).cuda() for i in range(1000)]
         self._test_allreduce_stress(inputs)
 
+    @skip_if_not_multigpu
+    @skip_if_rocm
+    def test_allreduce_pipelined_cuda(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        opts = self.opts()
+        # 10 chunks of 24 elements and a last one of 10
+        opts.cuda_pipeline_chunk_bytes = 24 * 4
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, opts)
+
+        input = (torch.arange(250, dtype=torch.float32) + self.rank).cuda()
+        pg.allreduce([input]).wait()
+        expected = (torch.arange(250, dtype=torch.float32) * self.world_size +
+                    self.world_size * (self.world_size - 1) / 2)
+        self.assertEqual(expected, input.cpu())
+
     def test_allreduce_coalesced_checks(self):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
@@ -1014,6 +1086,130 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
     def test_scatter_basics_cuda(self):
         self._test_scatter_basics(lambda t: t.clone().cuda())
 
+    def _test_alltoall_basics(self, fn):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        # Equal splits
+        input = fn(torch.arange(self.world_size) + self.rank * self.world_size)
+        output = fn(torch.full([self.world_size], -1, dtype=torch.int64))
+        pg.alltoall_base(output, input, [], []).wait()
+        expected = torch.arange(self.world_size) * self.world_size + self.rank
+        self.assertEqual(expected, output.cpu())
+
+        # Rank i sends i + j + 1 rows with value 10 * i + j to rank j
+        input_splits = [self.rank + j + 1 for j in range(self.world_size)]
+        input = fn(torch.cat([
+            torch.full([n, 2], 10 * self.rank + j, dtype=torch.int64)
+            for j, n in enumerate(input_splits)]))
+        output = fn(torch.full([sum(input_splits), 2], -1, dtype=torch.int64))
+        pg.alltoall_base(output, input, input_splits, input_splits).wait()
+        expected = torch.cat([
+            torch.full([n, 2], 10 * j + self.rank, dtype=torch.int64)
+            for j, n in enumerate(input_splits)])
+        self.assertEqual(expected, output.cpu())
+
+    def test_alltoall_basics(self):
+        self._test_alltoall_basics(lambda t: t.clone())
+
+    @skip_if_not_multigpu
+    @skip_if_rocm
+    def test_alltoall_basics_cuda(self):
+        self._test_alltoall_basics(lambda t: t.clone().cuda())
+
+    def test_reduce_scatter_basics(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        # Rank i contributes (i + 1) * (j + 1) to the output of rank j
+        inputs = [[
+            torch.full([2, 3], float((self.rank + 1) * (j + 1)))
+            for j in range(self.world_size)]]
+        output = torch.zeros([2, 3])
+        pg.reduce_scatter([output], inputs).wait()
+        total = self.world_size * (self.world_size + 1) / 2
+        self.assertEqual(torch.full([2, 3], total * (self.rank + 1)), output)
+
+        opts = c10d.ReduceScatterOptions()
+        opts.reduceOp = c10d.ReduceOp.MAX
+        pg.reduce_scatter([output], inputs, opts).wait()
+        self.assertEqual(
+            torch.full([2, 3], float(self.world_size * (self.rank + 1))), output)
+
+        with self.assertRaisesRegex(ValueError, "Incorrect input list size"):
+            pg.reduce_scatter([output], [inputs[0][:1]])
+
+    def test_alltoall_list(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        inputs = [
+            torch.full([self.rank + j + 1], 10 * self.rank + j)
+            for j in range(self.world_size)]
+        outputs = [
+            torch.full([self.rank + j + 1], -1.0)
+            for j in range(self.world_size)]
+        pg.alltoall(outputs, inputs).wait()
+        for j in range(self.world_size):
+            self.assertEqual(
+                torch.full([self.rank + j + 1], 10 * j + self.rank), outputs[j])
+
+    def test_alltoall_checks(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+        t = torch.zeros([self.world_size + 1])
+
+        with self.assertRaisesRegex(ValueError, "does not divide equally"):
+            pg.alltoall_base(t, t, [], [])
+
+        with self.assertRaisesRegex(ValueError, "not equal to group size"):
+            pg.alltoall_base(t, t, [1], [1])
+
+        with self.assertRaisesRegex(ValueError, "requires input and output lists"):
+            pg.alltoall([t], [t])
+
+    def _test_sharded_embedding(self, sharding):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts())
+
+        num_embeddings, embedding_dim = 10, 5
+        torch.manual_seed(0)
+        table = torch.randn(num_embeddings, embedding_dim)
+        inputs = [torch.randint(num_embeddings, (3, 4))
+                  for _ in range(self.world_size)]
+
+        embedding = ShardedEmbedding(
+            num_embeddings, embedding_dim, sharding=sharding,
+            owner=self.world_size - 1, process_group=pg)
+        if sharding == 'column_wise':
+            start = sum(embedding.column_split_sizes[:self.rank])
+            shard = (slice(None), slice(start, start + embedding.weight.size(1)))
+        else:
+            shard = slice(embedding.row_offsets[self.rank],
+                          embedding.row_offsets[self.rank + 1])
+        with torch.no_grad():
+            embedding.weight.copy_(table[shard])
+
+        output = embedding(inputs[self.rank])
+        self.assertEqual(output, F.embedding(inputs[self.rank], table))
+
+        # Every shard accumulates the gradients of the lookups of all ranks.
+        (output * (self.rank + 1)).sum().backward()
+        self.assertTrue(embedding.weight.grad.is_sparse)
+        full_table = table.clone().requires_grad_()
+        sum(F.embedding(input, full_table).sum() * (r + 1)
+            for r, input in enumerate(inputs)).backward()
+        self.assertEqual(embedding.weight.grad.to_dense(), full_table.grad[shard])
+
+    def test_sharded_embedding_table_wise(self):
+        self._test_sharded_embedding('table_wise')
+
+    def test_sharded_embedding_row_wise(self):
+        self._test_sharded_embedding('row_wise')
+
+    def test_sharded_embedding_column_wise(self):
+        self._test_sharded_embedding('column_wise')
+
     def _test_scatter_stress(self, inputs, fn):
         store = c10d.FileStore(self.file_name, self.world_size)
         pg = c10d.ProcessGroupGloo(store, self.rank, self.world_size, self.opts(threads=8))
@@ -1473,6 +1669,69 @@ class ProcessGroupGlooTest(MultiProcessTestCase):
             self.assertEqual(torch.full(size, float(i * self.world_size)), tensor)
 
 
+@requires_gloo()
+@unittest.skipIf(TEST_WITH_TSAN, "TSAN is not fork-safe since we're forking in a multi-threaded environment")
+class ProcessGroupHierarchicalTest(MultiProcessTestCase):
+    def setUp(self):
+        super(ProcessGroupHierarchicalTest, self).setUp()
+        self._fork_processes()
+
+    def _create_process_group(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+
+        def create_gloo(store, rank, size):
+            opts = c10d.ProcessGroupGloo.Options()
+            opts.devices = [c10d.ProcessGroupGloo.create_device(interface=LOOPBACK)]
+            opts.timeout = 5.0
+            return c10d.ProcessGroupGloo(store, rank, size, opts)
+
+        # Pretend ranks {0, 2} and {1, 3} live on the same node, so that
+        # local ranks differ from the global rank order.
+        opts = c10d.ProcessGroupHierarchical.Options()
+        opts.hostname = "node{}".format(self.rank % 2)
+        opts.use_reduce_scatter = False
+        pg = c10d.ProcessGroupHierarchical(
+            store, self.rank, self.world_size, create_gloo, opts)
+        self.assertEqual(2, pg.num_nodes())
+        self.assertEqual(2, pg.local_size())
+        self.assertEqual(self.rank % 2, pg.node_index())
+        self.assertEqual(self.rank // 2, pg.local_rank())
+        return pg
+
+    def test_allreduce(self):
+        pg = self._create_process_group()
+        # An odd number of elements exercises the chunk padding.
+        tensor = torch.arange(7, dtype=torch.float).view(7, 1) * (self.rank + 1)
+        pg.allreduce(tensor).wait()
+        self.assertEqual(torch.arange(7, dtype=torch.float).view(7, 1) * 10, tensor)
+
+        tensor = torch.tensor([float(self.rank)])
+        opts = c10d.AllreduceOptions()
+        opts.reduceOp = c10d.ReduceOp.MAX
+        pg.allreduce([tensor], opts).wait()
+        self.assertEqual(torch.tensor([3.0]), tensor)
+
+    def test_broadcast(self):
+        pg = self._create_process_group()
+        for root in range(self.world_size):
+            tensor = torch.tensor([float(self.rank)])
+            opts = c10d.BroadcastOptions()
+            opts.rootRank = root
+            pg.broadcast([tensor], opts).wait()
+            self.assertEqual(torch.tensor([float(root)]), tensor)
+
+    def test_allgather(self):
+        pg = self._create_process_group()
+        outputs = [[torch.zeros(2) for _ in range(self.world_size)]]
+        pg.allgather(outputs, [torch.full([2], float(self.rank))]).wait()
+        for rank, output in enumerate(outputs[0]):
+            self.assertEqual(torch.full([2], float(rank)), output)
+
+    def test_barrier(self):
+        pg = self._create_process_group()
+        pg.barrier().wait()
+
+
 @requires_nccl()
 class ProcessGroupNCCLTest(TestCase):
     MAIN_PROCESS_RANK = 0
@@ -1741,6 +2000,30 @@ class ProcessGroupNCCLTest(TestCase):
                     torch.tensor([float(i * (i + 1) / 2)]),
                     tensors_list[i - 2][j])
 
+    def test_trace(self):
+        os.environ["NCCL_TRACE_BUFFER_SIZE"] = "2"
+        try:
+            store = c10d.FileStore(self.file.name, self.world_size)
+            pg = c10d.ProcessGroupNCCL(store, self.rank, self.world_size)
+        finally:
+            del os.environ["NCCL_TRACE_BUFFER_SIZE"]
+
+        tensors = [torch.ones(2, 3).cuda(i) for i in range(self.num_gpus)]
+        pg.broadcast(tensors).wait()
+        pg.allreduce(tensors).wait()
+        pg.allreduce(tensors).wait()
+        torch.cuda.synchronize()
+
+        # The buffer keeps the last two collectives.
+        trace = pg.dump_trace()
+        self.assertNotIn("BROADCAST", trace)
+        self.assertIn("#1 ALLREDUCE Float in 2x3 out 2x3", trace)
+        self.assertIn("#2 ALLREDUCE Float in 2x3 out 2x3", trace)
+        self.assertNotIn("not started", trace)
+
+        # A single process has no stragglers.
+        self.assertEqual("", pg.report_stragglers())
+
 
 class Net(nn.Module):
     def __init__(self):
@@ -2760,7 +3043,59 @@ class DistributedDataParallelTest(MultiProcessTestCase):
             loss.backward()
 
     @requires_gloo()
-    def test_sparse_gradients(self):
+    def test_zero_redundancy_optimizer(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size)
+
+        # Ensure initialized weights and inputs are identical across processes
+        torch.manual_seed(1337)
+
+        vanilla_model = Net()
+        # Small buckets, so that parameters span several buckets and shards.
+        ddp_model = DistributedDataParallel(
+            copy.deepcopy(vanilla_model),
+            process_group=process_group,
+            bucket_cap_mb=0.001,
+        )
+        vanilla_optimizer = torch.optim.Adam(vanilla_model.parameters(), lr=0.01)
+        optimizer = ZeroRedundancyOptimizer(ddp_model, torch.optim.Adam, lr=0.01)
+
+        mult = 4
+        batch_size = mult * self.world_size
+        criterion = nn.CrossEntropyLoss()
+        input = torch.randn([batch_size, 2])
+        target = torch.randint(0, 4, [batch_size])
+
+        # The buckets are rebuilt after the first iteration, so the optimizer
+        # state is resharded.
+        for _ in range(3):
+            vanilla_optimizer.zero_grad()
+            optimizer.zero_grad()
+            criterion(vanilla_model(input), target).backward()
+            partial_input = input.split(mult)[self.rank]
+            partial_target = target.split(mult)[self.rank]
+            criterion(ddp_model(partial_input), partial_target).backward()
+            vanilla_optimizer.step()
+            optimizer.step()
+
+        optimizer.synchronize()
+        for p, q in zip(vanilla_model.parameters(), ddp_model.parameters()):
+            self.assertEqual(p, q, prec=1e-5)
+
+        # The consolidated state matches the state of the vanilla optimizer.
+        state_dict = optimizer.state_dict()
+        for i, p in enumerate(vanilla_model.parameters()):
+            self.assertEqual(
+                vanilla_optimizer.state[p]['exp_avg'],
+                state_dict['state'][i]['exp_avg'],
+                prec=1e-5)
+            self.assertEqual(
+                vanilla_optimizer.state[p]['step'], state_dict['state'][i]['step'])
+        optimizer.load_state_dict(state_dict)
+        self.assertEqual(state_dict['state'][0]['exp_avg'],
+                         optimizer.state_dict()['state'][0]['exp_avg'])
+
+    def _test_sparse_gradients(self, density_threshold=None):
         store = c10d.FileStore(self.file_name, self.world_size)
         process_group = c10d.ProcessGroupGloo(store, self.rank, self.world_size)
 
@@ -2780,6 +3115,8 @@ class DistributedDataParallelTest(MultiProcessTestCase):
             copy.deepcopy(vanilla_model),
             process_group=process_group,
         )
+        if density_threshold is not None:
+            ddp_model.use_sparse_allgather(density_threshold)
 
         mult = 2
         batch_size = mult * self.world_size
@@ -2800,6 +3137,16 @@ class DistributedDataParallelTest(MultiProcessTestCase):
         ddp_parameter = next(ddp_model.parameters())
         self.assertEqual(vanilla_parameter.grad, ddp_parameter.grad)
 
+    def test_sparse_gradients(self):
+        self._test_sparse_gradients()
+
+    def test_sparse_gradients_allgather(self):
+        self._test_sparse_gradients(density_threshold=1.0)
+
+    def test_sparse_gradients_allgather_dense(self):
+        # Every gradient is denser than the threshold
+        self._test_sparse_gradients(density_threshold=0.0)
+
 
 class ReducerModule(nn.Module):
     def __init__(self):
@@ -2854,13 +3201,13 @@ class ReducerTest(TestCase):
         buckets = [list(indices) for _, indices in group_by_type]
         dist.Reducer(parameters, buckets, self.process_group)
 
-    def _create_reducer_for_models(self, models):
+    def _create_reducer_for_models(self, models, **kwargs):
         parameters = [list(model.parameters()) for model in models]
         group_by_type = groupby(
             range(len(parameters[0])),
             key=lambda i: parameters[0][i].type())
         buckets = [list(indices) for _, indices in group_by_type]
-        return dist.Reducer(parameters, buckets, self.process_group)
+        return dist.Reducer(parameters, buckets, self.process_group, **kwargs)
 
     def test_forward_backward_single_replica(self):
         batch_size = 10
@@ -2934,6 +3281,124 @@ class ReducerTest(TestCase):
             output.backward()
             optimizer.step()
 
+    def _run_iteration(self, model, reducer, batch_size=10):
+        loss = nn.CrossEntropyLoss()
+        input = torch.rand([batch_size, 2], dtype=torch.double)
+        target = torch.LongTensor([random.randrange(4) for _ in range(batch_size)])
+        output = loss(model(input), target)
+        reducer.prepare_for_backward(output)
+        output.backward()
+
+    def test_rebuild_buckets(self):
+        model = self._create_mixed_precision_model()
+        reducer = self._create_reducer_for_models([model])
+
+        # Nothing to rebuild until a backward pass has been recorded.
+        self.assertFalse(reducer.rebuild_buckets())
+        self._run_iteration(model, reducer)
+        self.assertTrue(reducer.rebuild_buckets())
+        self.assertFalse(reducer.rebuild_buckets())
+
+        # Reduction still produces gradients with the rebuilt buckets.
+        for parameter in model.parameters():
+            parameter.grad = None
+        self._run_iteration(model, reducer)
+        for parameter in model.parameters():
+            self.assertIsNotNone(parameter.grad)
+
+    def test_autotune_bucket_size(self):
+        model = self._create_mixed_precision_model()
+        reducer = self._create_reducer_for_models([model])
+        candidates = [64, 256, 1024]
+        reducer.autotune_bucket_size(candidates, 2)
+        for _ in range(12):
+            reducer.rebuild_buckets()
+            self._run_iteration(model, reducer)
+        self.assertIn(reducer.get_bucket_bytes_cap(), candidates)
+        self.assertFalse(reducer.rebuild_buckets())
+
+    def test_gradient_as_bucket_view(self):
+        torch.manual_seed(0)
+        model = self._create_mixed_precision_model()
+        reference = copy.deepcopy(model)
+        reducer = self._create_reducer_for_models(
+            [model], gradient_as_bucket_view=True)
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+        reference_optimizer = torch.optim.SGD(reference.parameters(), lr=0.1)
+        loss = nn.CrossEntropyLoss()
+        grads = None
+        for i in range(3):
+            input = torch.rand([10, 2], dtype=torch.double)
+            target = torch.LongTensor([random.randrange(4) for _ in range(10)])
+            optimizer.zero_grad()
+            reference_optimizer.zero_grad()
+            output = loss(model(input, use_fc3=(i > 0)), target)
+            reducer.prepare_for_backward(output)
+            output.backward()
+            loss(reference(input, use_fc3=(i > 0)), target).backward()
+            for p, q in zip(model.parameters(), reference.parameters()):
+                if q.grad is None:
+                    q.grad = torch.zeros_like(q)
+                self.assertEqual(p.grad, q.grad)
+            # After the first iteration, gradients stay in the buckets.
+            if grads is not None:
+                for p, grad in zip(model.parameters(), grads):
+                    self.assertTrue(p.grad is grad)
+            grads = [p.grad for p in model.parameters()]
+            optimizer.step()
+            reference_optimizer.step()
+
+    def _run_iteration_with_comm_hook(self, register_hook):
+        torch.manual_seed(0)
+        model = ReducerModule()
+        reference = copy.deepcopy(model)
+        reducer = self._create_reducer_for_models([model])
+        register_hook(reducer)
+        input = torch.rand([10, 2])
+        target = torch.LongTensor([random.randrange(4) for _ in range(10)])
+        loss = nn.CrossEntropyLoss()
+        output = loss(model(input), target)
+        reducer.prepare_for_backward(output)
+        output.backward()
+        loss(reference(input), target).backward()
+        return model, reference
+
+    def test_fp16_compress_hook(self):
+        model, reference = self._run_iteration_with_comm_hook(
+            lambda reducer: reducer.register_fp16_compress_hook(self.process_group))
+        for p, q in zip(model.parameters(), reference.parameters()):
+            self.assertEqual(p.grad, q.grad, prec=1e-3)
+
+    def test_topk_compress_hook(self):
+        # Sending all elements reproduces the uncompressed gradient.
+        model, reference = self._run_iteration_with_comm_hook(
+            lambda reducer: reducer.register_topk_compress_hook(self.process_group, 1.0))
+        for p, q in zip(model.parameters(), reference.parameters()):
+            self.assertEqual(p.grad, q.grad)
+
+    def test_powersgd_hook(self):
+        # A full rank approximation reproduces the uncompressed gradient.
+        model, reference = self._run_iteration_with_comm_hook(
+            lambda reducer: reducer.register_powersgd_hook(self.process_group, 64))
+        for p, q in zip(model.parameters(), reference.parameters()):
+            self.assertEqual(p.grad, q.grad, prec=1e-4)
+
+    def test_reduce_scatter_hook(self):
+        # A single process owns the whole bucket.
+        model, reference = self._run_iteration_with_comm_hook(
+            lambda reducer: reducer.register_reduce_scatter_hook(self.process_group))
+        for p, q in zip(model.parameters(), reference.parameters()):
+            self.assertEqual(p.grad, q.grad)
+
+    def test_get_bucket_indices(self):
+        model = self._create_mixed_precision_model()
+        reducer = self._create_reducer_for_models([model])
+        parameters = list(model.parameters())
+        expected = [
+            list(indices) for _, indices in groupby(
+                range(len(parameters)), key=lambda i: parameters[i].type())]
+        self.assertEqual(expected, reducer.get_bucket_indices())
+
 
 class ComputeBucketAssignmentTest(TestCase):
     def test_single_limit_single_dtype(self):
@@ -3210,6 +3675,51 @@ class CommTest(MultiProcessTestCase):
         self._test_broadcast_coalesced(process_group, device)
 
 
+
+class ReformTest(MultiProcessTestCase):
+    def setUp(self):
+        super(ReformTest, self).setUp()
+        self._fork_processes()
+
+    def tearDown(self):
+        super(ReformTest, self).tearDown()
+        try:
+            os.remove(self.file_name)
+        except OSError:
+            pass
+
+    @property
+    def world_size(self):
+        return 3
+
+    @requires_gloo()
+    def test_reform_process_group_gloo(self):
+        store = c10d.FileStore(self.file_name, self.world_size)
+        c10d.init_process_group(
+            backend='gloo', store=store, rank=self.rank, world_size=self.world_size)
+        torch.manual_seed(1337)
+        ddp_model = DistributedDataParallel(nn.Linear(2, 2))
+
+        # The last process leaves, the others carry on without it.
+        if self.rank == self.world_size - 1:
+            return
+        rank = c10d.reform_process_group(settle_time=timedelta(seconds=2))
+        self.assertEqual(rank, self.rank)
+        self.assertEqual(c10d.get_rank(), self.rank)
+        self.assertEqual(c10d.get_world_size(), self.world_size - 1)
+
+        tensor = torch.ones(2)
+        c10d.all_reduce(tensor)
+        self.assertEqual(tensor, torch.full([2], float(self.world_size - 1)))
+
+        ddp_model.reform()
+        input = torch.full([4, 2], float(self.rank + 1))
+        ddp_model(input).sum().backward()
+        # The gradient of the weight is the average of the inputs' sums
+        expected = torch.full([2, 2], 4 * 1.5)
+        self.assertEqual(ddp_model.module.weight.grad, expected)
+
+
 if __name__ == '__main__':
     assert not torch.cuda._initialized, "test_distributed must not have initialized CUDA context on main process"
 
@@ -3,6 +3,7 @@ import io
 import tempfile
 import unittest
 import sys
+import itertools
 from itertools import repeat
 import os
 from contextlib import contextmanager
@@ -275,6 +276,25 @@ class TestCuda(TestCase):
         for _ in self._test_memory_stats_generator(self):
             self._check_memory_stat_consistency()
 
+    def test_memory_history(self):
+        torch.cuda.record_memory_history(True, trace_max_entries=4)
+        try:
+            x = torch.empty(1024 * 1024, device="cuda")
+            blocks = [b for s in torch.cuda.memory_snapshot()
+                      for b in s["blocks"] if "history" in b]
+            self.assertEqual(len(blocks), 1)
+            del x
+            for _ in range(3):
+                torch.empty(10, device="cuda")
+        finally:
+            torch.cuda.record_memory_history(False)
+
+        trace = torch.cuda.memory_trace()
+        # only the 4 most recent of the 8 alloc / free events are kept
+        self.assertEqual(len(trace), 4)
+        self.assertEqual([e["action"] for e in trace], ["alloc", "free"] * 2)
+        self.assertTrue(all("history" in e for e in trace))
+
     def test_cuda_get_device_name(self):
         # Testing the behaviour with None as an argument
         current_device = torch.cuda.current_device()
@@ -513,6 +533,23 @@ class TestCuda(TestCase):
         x /= 2
         self.assertEqual(x.sum(), 2**29)
 
+    def test_elementwise_vectorized_alignment(self):
+        # Contiguous operands go through vectorized loads and stores when they
+        # are aligned, and element by element otherwise; the lengths cover the
+        # elements left over after the last full vector.
+        for dtype in [torch.half, torch.float, torch.double, torch.int16]:
+            base = torch.arange(64, device='cuda').to(dtype)
+            other = base.flip(0)
+            for offset, n in itertools.product(range(3), [1, 3, 8, 17, 61]):
+                x = base[offset:offset + n]
+                y = other[:n]
+                x_ref, y_ref = x.cpu().double(), y.cpu().double()
+                self.assertEqual((x + y).cpu(), (x_ref + y_ref).to(dtype))
+                out = torch.empty(n + 1, dtype=dtype, device='cuda')[1:]
+                torch.mul(x, y, out=out)
+                self.assertEqual(out.cpu(), (x_ref * y_ref).to(dtype))
+                self.assertEqual(x.neg().cpu(), x_ref.neg().to(dtype))
+
     def _test_broadcast(self, input):
         if not TEST_MULTIGPU:
             raise unittest.SkipTest("only one GPU detected")
@@ -937,6 +974,67 @@ class TestCuda(TestCase):
             torch.cuda.default_stream(torch.device('cpu'))
 
     @skipCUDANonDefaultStreamIf(True)
+    def test_autocast_policies(self):
+        x = torch.randn(8, 8, device='cuda')
+        h = x.half()
+        with torch.cuda.amp.autocast():
+            self.assertEqual(torch.mm(x, x).dtype, torch.half)
+            self.assertEqual(torch.softmax(h, 0).dtype, torch.float)
+            self.assertEqual(h.sum().dtype, torch.float)
+            self.assertEqual(torch.cat([h, x]).dtype, torch.float)
+            self.assertEqual(torch.cat([h, h]).dtype, torch.half)
+            # not in any policy
+            self.assertEqual((x + x).dtype, torch.float)
+            self.assertEqual(torch.mm(x.cpu(), x.cpu()).dtype, torch.float)
+            with torch.cuda.amp.autocast(enabled=False):
+                self.assertEqual(torch.mm(x, x).dtype, torch.float)
+            self.assertEqual(torch.mm(x, x).dtype, torch.half)
+        self.assertFalse(torch._C.is_autocast_enabled())
+        self.assertEqual(torch.mm(x, x).dtype, torch.float)
+
+    def test_autocast_backward(self):
+        x = torch.randn(8, 8, device='cuda')
+        w = torch.randn(8, 8, device='cuda', requires_grad=True)
+        with torch.cuda.amp.autocast():
+            # the second use of the weight reuses its cached cast
+            out = torch.mm(torch.mm(x, w), w)
+            loss = out.sum()
+        self.assertEqual(out.dtype, torch.half)
+        self.assertEqual(loss.dtype, torch.float)
+        loss.backward()
+        self.assertEqual(w.grad.dtype, torch.float)
+
+        w_ref = w.detach().clone().requires_grad_()
+        torch.mm(torch.mm(x, w_ref), w_ref).sum().backward()
+        self.assertEqual(w.grad, w_ref.grad, prec=0.5)
+
+    def test_grad_scaler(self):
+        param = torch.ones(4, device='cuda', requires_grad=True)
+        optimizer = torch.optim.SGD([param], lr=1.0)
+        scaler = torch.cuda.amp.GradScaler(init_scale=4.0, growth_interval=2)
+
+        def train_step(loss_fn):
+            optimizer.zero_grad()
+            scaler.scale(loss_fn(param)).backward()
+            self.assertEqual(param.grad, torch.full_like(param, 4.0))
+            ret = scaler.step(optimizer)
+            scaler.update()
+            return ret
+
+        train_step(lambda p: p.sum())
+        self.assertEqual(param, torch.zeros_like(param))
+        self.assertEqual(scaler.get_scale(), 4.0)
+        train_step(lambda p: p.sum())
+        self.assertEqual(param, torch.full_like(param, -1.0))
+        self.assertEqual(scaler.get_scale(), 8.0)
+
+        optimizer.zero_grad()
+        scaler.scale(param.sum() * float('inf')).backward()
+        self.assertIsNone(scaler.step(optimizer))
+        scaler.update()
+        self.assertEqual(param, torch.full_like(param, -1.0))
+        self.assertEqual(scaler.get_scale(), 4.0)
+
     def test_streams(self):
         default_stream = torch.cuda.current_stream()
         user_stream = torch.cuda.Stream()
@@ -1409,6 +1507,69 @@ class TestCuda(TestCase):
 
         self.assertNotEqual(try_realloc.data_ptr(), data_ptr)
 
+    def test_stream_group(self):
+        cycles_per_ms = get_cycles_per_ms()
+        s1 = torch.cuda.Stream()
+        s2 = torch.cuda.Stream()
+        torch.cuda.set_stream_group(s1, 142)
+        torch.cuda.set_stream_group(s2, 142)
+        try:
+            with torch.cuda.stream(s1):
+                a = torch.zeros(1024, device='cuda')
+                torch.cuda._sleep(int(50 * cycles_per_ms))
+                a.add_(1)
+                total = a.sum()
+                ptr = a.data_ptr()
+                del a
+
+            # the block freed on s1 is reused on s2 without waiting on the
+            # host, and the write on s2 is ordered after the uses on s1
+            with torch.cuda.stream(s2):
+                b = torch.empty(1024, device='cuda')
+                self.assertEqual(b.data_ptr(), ptr, 'allocation not re-used')
+                b.fill_(5)
+
+            torch.cuda.synchronize()
+            self.assertEqual(total.item(), 1024)
+        finally:
+            torch.cuda.set_stream_group(s1, -1)
+            torch.cuda.set_stream_group(s2, -1)
+
+    def test_deferred_launch(self):
+        def bookkeeping(x, y, counts):
+            total = torch.zeros(x.size(), device='cuda')
+            for i in range(10):
+                # chains of ops reading the results of the previous ones
+                total = total + x * y - 0.5
+                total.mul_(1.5).div_(y)
+                counts += 1
+                total = 2 / (total + 3)
+            # a kernel that can't be deferred, and a broadcast op
+            norm = total.sum()
+            total = total * norm.expand_as(total) + x.t().t()
+            return total, counts, total.max().item()
+
+        x = torch.randn(8, 8, device='cuda')
+        y = torch.rand(8, 8, device='cuda') + 1
+        expected = bookkeeping(x, y, torch.zeros(4, dtype=torch.long, device='cuda'))
+        with torch.cuda.deferred_launch():
+            self.assertTrue(torch._C._cuda_deferred_launch_enabled())
+            result = bookkeeping(x, y, torch.zeros(4, dtype=torch.long, device='cuda'))
+        self.assertFalse(torch._C._cuda_deferred_launch_enabled())
+        self.assertEqual(result, expected)
+
+        # the queue is flushed before ops on another stream read the results
+        stream = torch.cuda.Stream()
+        with torch.cuda.deferred_launch():
+            a = torch.ones(16, device='cuda')
+            for _ in range(100):
+                a.add_(1)
+            stream.wait_stream(torch.cuda.current_stream())
+            with torch.cuda.stream(stream):
+                b = a * 2
+            torch.cuda.current_stream().wait_stream(stream)
+            self.assertEqual(b.tolist(), [202] * 16)
+
     def test_noncontiguous_pinned_memory(self):
         # See issue #3266
         x = torch.arange(0, 10).view((2, 5))
@@ -1433,6 +1594,27 @@ class TestCuda(TestCase):
         self.assertNotEqual(t.data_ptr(), ptr, 'allocation re-used too soon')
         self.assertEqual(list(gpu_tensor), [1])
 
+    def test_host_memory_stats(self):
+        before = torch.cuda.host_memory_stats()
+        t = torch.empty(1000, dtype=torch.uint8).pin_memory()
+        stats = torch.cuda.host_memory_stats()
+        self.assertEqual(stats["allocation.small_pool.allocated"],
+                         before["allocation.small_pool.allocated"] + 1)
+        self.assertEqual(stats["active.small_pool.current"],
+                         before["active.small_pool.current"] + 1)
+        self.assertEqual(stats["allocated_bytes.small_pool.current"],
+                         before["allocated_bytes.small_pool.current"] + 1000)
+        # blocks are rounded up to a power of two
+        self.assertEqual(stats["active_bytes.small_pool.current"],
+                         before["active_bytes.small_pool.current"] + 1024)
+        self.assertGreaterEqual(stats["reserved_bytes.all.current"],
+                                stats["active_bytes.all.current"])
+
+        del t
+        stats = torch.cuda.host_memory_stats()
+        self.assertEqual(stats["allocation.small_pool.current"],
+                         before["allocation.small_pool.current"])
+
     @unittest.skipIf(not TEST_MULTIGPU, "only one GPU detected")
     def test_caching_pinned_memory_multi_gpu(self):
         # checks that the events preventing pinned memory from being re-used
@@ -448,6 +448,27 @@ class TestJit(JitTestCase):
         self.assertTrue(m2.b0.is_shared())
         self.assertEqual(m2.b0.storage().data_ptr(), m2.p0.storage().data_ptr())
 
+    @unittest.skipIf(not RUN_CUDA, "restore device requires CUDA")
+    def test_restore_parallel_on_cuda(self):
+        class Foo(torch.jit.ScriptModule):
+            def __init__(self):
+                super(Foo, self).__init__()
+                # larger than a single staging buffer
+                self.p0 = nn.Parameter(torch.randn(3, 1024, 1024))
+                self.p1 = nn.Parameter(torch.randn(7, dtype=torch.double))
+                self.register_buffer('b0', torch.arange(5))
+
+        m = Foo()
+        for num_threads in [0, 1, 4]:
+            torch._C._jit_set_tensor_load_threads(num_threads)
+            try:
+                m2 = self.getExportImportCopy(m, map_location=torch.device('cuda:0'))
+            finally:
+                torch._C._jit_set_tensor_load_threads(4)
+            for t, t2 in zip(m.state_dict().values(), m2.state_dict().values()):
+                self.assertTrue(t2.is_cuda)
+                self.assertEqual(t, t2.cpu())
+
     def test_typeas_trace_check(self):
         a = torch.tensor([0.4], requires_grad=True)
         b = torch.tensor([0.7], requires_grad=True)
@@ -1068,6 +1089,26 @@ graph(%x : Tensor,
         test_module(M, 'prim::CallFunction(', 1)
         test_module(M2, 'prim::CallMethod[name="forward"]', 0)
 
+        class M3(torch.nn.Module):
+            def __init__(self):
+                super(M3, self).__init__()
+                self.linear = torch.nn.Linear(5, 5)
+                self.relu = torch.nn.ReLU()
+
+            def forward(self, x):
+                return self.relu(self.linear(x))
+
+        # The output of linear is not observed when it's followed by relu
+        m = torch.jit.script(M3()).copy()
+        observer = torch.jit.script(Observer())
+        qconfig_dict = {'': QConfig(activation=observer._c, weight=observer._c)}
+        torch._C._jit_pass_insert_observers(m._c, "forward", qconfig_dict, True)
+        FileCheck().check('ClassType<Linear> = prim::GetAttr[name="linear"]') \
+                   .check_next('prim::CallMethod[name="forward"]') \
+                   .check_not('ClassType<Observer> = prim::GetAttr[name="observer_for_') \
+                   .check('prim::CallMethod[name="forward"]') \
+                   .run(str(get_forward_graph(m._c)))
+
     @_tmp_donotuse_dont_inline_everything
     def test_insert_observers_weight_dtype(self):
         class M(torch.nn.Module):
@@ -1227,6 +1268,40 @@ graph(%packed_params_module, %a, %a_scale, %a_zero_point, %a_dtype, %r_scale, %r
         %r = aten::matmul(%a_dequant, %w_dequant_t)
         %r_quant = aten::quantize_per_tensor(%r, %r_scale, %r_zero_point, %r_dtype)
         %r_dequant = aten::dequantize(%r_quant)
+        return (%r_dequant)""",
+            # aten::conv2d - aten::relu --> quantized::conv2d_relu
+            """
+graph(%packed_params_module, %a, %a_scale, %a_zero_point, %a_dtype,
+%r_scale, %r_zero_point, %r_dtype, %stride, %padding, %dilation, %groups):
+        %a_quant = aten::quantize_per_tensor(%a, %a_scale, %a_zero_point, %a_dtype)
+        %a_dequant = aten::dequantize(%a_quant)
+        %packed_params = prim::GetAttr[name="_packed_params"](%packed_params_module)
+        %w_quant : Tensor, %b : Tensor? = quantized::conv_unpack(%packed_params)
+        %w_dequant = aten::dequantize(%w_quant)
+        # CHECK: quantized::conv2d_relu
+        # CHECK-NOT: aten::conv2d
+        # CHECK-NOT: aten::relu
+        %conv_out = aten::conv2d(%a_dequant, %w_dequant, %b, %stride, %padding, %dilation, %groups)
+        %r = aten::relu(%conv_out)
+        %r_quant = aten::quantize_per_tensor(%r, %r_scale, %r_zero_point, %r_dtype)
+        %r_dequant = aten::dequantize(%r_quant)
+        return (%r_dequant)""",
+            # addmm - aten::relu_ -> quantized::linear_relu
+            """
+graph(%packed_params_module, %a, %a_scale, %a_zero_point, %a_dtype, %r_scale, %r_zero_point, %r_dtype, %4):
+        %a_quant = aten::quantize_per_tensor(%a, %a_scale, %a_zero_point, %a_dtype)
+        %a_dequant = aten::dequantize(%a_quant)
+        %packed_params = prim::GetAttr[name="_packed_params"](%packed_params_module)
+        %w_quant : Tensor, %b : Tensor? = quantized::linear_unpack(%packed_params)
+        %w_dequant = aten::dequantize(%w_quant)
+        %w_dequant_t = aten::t(%w_dequant)
+        # CHECK: quantized::linear_relu
+        # CHECK-NOT: aten::addmm
+        # CHECK-NOT: aten::relu_
+        %linear_out = aten::addmm(%b, %a_dequant, %w_dequant_t, %4, %4)
+        %r = aten::relu_(%linear_out)
+        %r_quant = aten::quantize_per_tensor(%r, %r_scale, %r_zero_point, %r_dtype)
+        %r_dequant = aten::dequantize(%r_quant)
         return (%r_dequant)"""
         ]
         for input_str in input_strs:
@@ -1234,6 +1309,86 @@ graph(%packed_params_module, %a, %a_scale, %a_zero_point, %a_dtype, %r_scale, %r
             torch._C._jit_pass_quant_fusion(graph)
             FileCheck().run(input_str, graph)
 
+    def test_freeze_module(self):
+        class Sub(torch.nn.Module):
+            def __init__(self):
+                super(Sub, self).__init__()
+                self.weight = torch.nn.Parameter(torch.randn(4, 4))
+
+            def forward(self, x):
+                return torch.mm(x, self.weight.t().contiguous())
+
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.sub = Sub()
+                self.bias = torch.nn.Parameter(torch.randn(4))
+
+            def forward(self, x):
+                y = self.sub(x)
+                if self.training:
+                    y = torch.dropout(y, 0.5, True)
+                return y + self.bias * 2
+
+        m = torch.jit.script(M())
+        with self.assertRaisesRegex(RuntimeError, "eval mode"):
+            torch._C._freeze_module(m._c)
+
+        m.eval()
+        frozen = torch._C._freeze_module(m._c)
+        # the weight transformations and the training branch are folded
+        FileCheck().check_not("prim::GetAttr").check_not("aten::t") \
+            .check_not("prim::If").check("aten::mm").check_not("aten::mul") \
+            .run(str(get_forward_graph(frozen)))
+
+        x = torch.randn(3, 4)
+        self.assertEqual(get_forward(frozen)(x), m(x))
+
+    def test_module_constant_pooling(self):
+        class Sub(torch.nn.Module):
+            def __init__(self):
+                super(Sub, self).__init__()
+                # not a buffer, so traced as a constant
+                self.mask = torch.ones(4, 4)
+
+            def forward(self, x):
+                return x * self.mask
+
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.a = Sub()
+                self.b = Sub()
+
+            def forward(self, x):
+                return self.a(x) + self.b(x)
+
+        x = torch.randn(4, 4)
+        m = torch.jit.trace(M(), x)
+        expected = m(x)
+        stats = torch._C._jit_pass_module_constant_pooling(m._c)
+        self.assertGreaterEqual(stats['pooled_tensors'], 1)
+        self.assertEqual(stats['saved_bytes'], 4 * 4 * 4)
+        self.assertEqual(m(x), expected)
+
+    def test_hoist_loop_invariants(self):
+        def fn(x, y, n):
+            # type: (Tensor, Tensor, int) -> Tensor
+            z = x
+            for _ in range(n):
+                z = z + x * y
+                z.add_(1)
+            return z
+
+        scripted = torch.jit.script(fn)
+        graph = scripted.graph
+        # x * y and the constants of the body
+        self.assertGreaterEqual(torch._C._jit_pass_hoist_loop_invariants(graph), 1)
+        FileCheck().check("aten::mul").check("prim::Loop").check("aten::add") \
+            .check("aten::add_").run(str(graph))
+        x, y = torch.randn(3), torch.randn(3)
+        self.assertEqual(scripted(x, y, 3), fn(x, y, 3))
+
     @_tmp_donotuse_dont_inline_everything
     def test_foldbn_trivial(self):
         # Test trivial case
@@ -1370,6 +1525,57 @@ graph(%input, %weight):
             torch._C._jit_pass_fuse_linear(graph)
             FileCheck().run(input_str, graph)
 
+    def test_fuse_transformer_ops(self):
+        input_strs = ["""
+graph(%input, %bias):
+    # CHECK-NOT: aten::add
+    # CHECK-NOT: aten::gelu
+    # CHECK: aten::_fused_bias_gelu
+    %alpha : int = prim::Constant[value=1]()
+    %biased = aten::add(%input, %bias, %alpha)
+    %res = aten::gelu(%biased)
+    return (%res)""", """
+graph(%input, %residual, %shape : int[], %weight, %bias, %eps : float, %cudnn_enable : bool):
+    # CHECK-NOT: aten::add
+    # CHECK-NOT: aten::layer_norm
+    # CHECK: aten::_fused_add_layer_norm
+    %alpha : int = prim::Constant[value=1]()
+    %sum = aten::add(%input, %residual, %alpha)
+    %res = aten::layer_norm(%sum, %shape, %weight, %bias, %eps, %cudnn_enable)
+    return (%res)""", """
+graph(%input, %bias, %residual, %p : float, %train : bool):
+    # CHECK-NOT: aten::add
+    # CHECK-NOT: aten::dropout
+    # CHECK: aten::_fused_bias_dropout_add
+    %alpha : int = prim::Constant[value=1]()
+    %biased = aten::add(%input, %bias, %alpha)
+    %dropped = aten::dropout(%biased, %p, %train)
+    %res = aten::add(%dropped, %residual, %alpha)
+    return (%res)""", """
+graph(%input, %bias):
+    # CHECK: aten::add
+    # CHECK: aten::gelu
+    # CHECK-NOT: aten::_fused_bias_gelu
+    %alpha : int = prim::Constant[value=2]()
+    %biased = aten::add(%input, %bias, %alpha)
+    %res = aten::gelu(%biased)
+    return (%res)"""]
+        for input_str in input_strs:
+            graph = parse_ir(input_str)
+            torch._C._jit_pass_fuse_transformer_ops(graph)
+            FileCheck().run(input_str, graph)
+
+        def bert_tail(x, bias, residual, weight):
+            h = F.gelu(x + bias)
+            return F.layer_norm(h + residual, [8], weight, bias)
+
+        scripted = torch.jit.script(bert_tail)
+        graph = scripted.graph
+        torch._C._jit_pass_inline(graph)
+        torch._C._jit_pass_constant_propagation(graph)
+        torch._C._jit_pass_fuse_transformer_ops(graph)
+        FileCheck().check("aten::_fused_bias_gelu").check("aten::_fused_add_layer_norm").run(graph)
+
     @_tmp_donotuse_dont_inline_everything
     def test_fold_quantize(self):
         class M(torch.nn.Module):
@@ -1619,6 +1825,81 @@ graph(%Ra, %Rb):
         torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
         FileCheck().check("Double(4, 3, 8, 5)").run(str(graph))
 
+    def test_plan_static_memory(self):
+        def fn(x, y):
+            a = torch.mm(x, y)
+            b = torch.tanh(a)
+            c = b * a
+            d = torch.mm(c, y)
+            return d + x
+
+        x = torch.randn(4, 4)
+        y = torch.randn(4, 4)
+
+        graph = torch.jit.script(fn).graph
+        torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
+        torch._C._jit_pass_plan_static_memory(graph)
+        # a, b, c and d are planned, the returned value must not be
+        FileCheck().check_count("prim::MemoryArena", 1, exactly=True) \
+            .check_count("prim::ArenaTensor", 4, exactly=True) \
+            .run(str(graph))
+
+        planned = torch._C._create_function_from_graph("forward", graph)
+        # the second run reuses the arena of the first
+        for _ in range(2):
+            self.assertEqual(planned(x, y), fn(x, y))
+
+    def test_use_inplace_ops(self):
+        def fn(x, y):
+            a = torch.mm(x, y)
+            b = torch.relu(a)
+            c = b * y
+            d = torch.sigmoid(x)
+            return torch.cat([torch.tanh(c), torch.add(d, y)], 1)
+
+        x = torch.randn(4, 4)
+        y = torch.randn(4, 4)
+
+        graph = torch.jit.script(fn).graph
+        torch._C._jit_pass_complete_shape_analysis(graph, (x, y), False)
+        torch._C._jit_pass_use_inplace_ops(graph)
+        # a and b are dead after relu and mul, the inputs of cat are written
+        # into slices of its result
+        FileCheck().check("aten::relu_").check("aten::mul_") \
+            .check_count("aten::narrow", 2, exactly=True).check_not("aten::cat") \
+            .run(str(graph))
+
+        inplace = torch._C._create_function_from_graph("forward", graph)
+        self.assertEqual(inplace(x, y), fn(x, y))
+
+    def test_parallelize_branches(self):
+        def fn(x, w1, w2, w3):
+            a = torch.mm(torch.relu(torch.mm(x, w1)), w1)
+            b = torch.mm(torch.tanh(torch.mm(x, w2)), w2)
+            c = torch.mm(torch.sigmoid(torch.mm(x, w3)), w3)
+            return torch.cat([a, b, c], 1)
+
+        inputs = [torch.randn(4, 4) for _ in range(4)]
+        graph = torch.jit.script(fn).graph
+        torch._C._jit_pass_parallelize_branches(graph)
+        # the last tower keeps running on the calling thread
+        FileCheck().check_count("prim::fork", 2, exactly=True) \
+            .check_count("aten::wait", 2, exactly=True).check("aten::cat") \
+            .run(str(graph))
+
+        parallel = torch._C._create_function_from_graph("forward", graph)
+        self.assertEqual(parallel(*inputs), fn(*inputs))
+
+        def mutates_input(x, w):
+            a = torch.mm(x, w)
+            b = torch.mm(w, x)
+            x.add_(1)
+            return a + b
+
+        graph = torch.jit.script(mutates_input).graph
+        torch._C._jit_pass_parallelize_branches(graph)
+        FileCheck().check_not("prim::fork").run(str(graph))
+
     # TODO: update verify to work with GraphExecutors
     @unittest.skip("verify needs to be updated to work with GraphExecutors")
     def test_verify(self):
@@ -5297,6 +5578,175 @@ a")
             # this triggers 2 bailouts
             self.assertEqual(def_in_one_branch(a, True), 3.0)
 
+    def test_profiling_graph_executor_shape_buckets(self):
+        @torch.jit.script
+        def fn(x):
+            return (x * 2 + 1).relu()
+
+        def check(length, profiled):
+            x = torch.randn(length, 5)
+            graph_str = str(fn.graph_for(x))
+            if profiled:
+                FileCheck().check("prim::profile").run(graph_str)
+            else:
+                FileCheck().check_not("prim::profile").run(graph_str)
+            self.assertEqual(fn(x), (x * 2 + 1).relu())
+
+        with enable_profiling_mode():
+            torch._C._jit_set_profiling_plan_cache_size(2)
+            try:
+                # 3 and 4 share a bucket, and its optimized plan
+                check(3, profiled=True)
+                check(4, profiled=False)
+                check(7, profiled=True)
+                check(8, profiled=False)
+                check(3, profiled=False)
+                # evicts the bucket of 7 and 8
+                check(16, profiled=True)
+                check(8, profiled=True)
+            finally:
+                torch._C._jit_set_profiling_plan_cache_size(1)
+
+    @unittest.skipIf(not RUN_CUDA, "requires CUDA")
+    def test_cuda_graphs_mode(self):
+        @torch.jit.script
+        def fn(x, y):
+            return (x * y + x).relu().sum(1)
+
+        @torch.jit.script
+        def drop(x):
+            return torch.nn.functional.dropout(x, 0.5, training=True)
+
+        torch._C._jit_set_cuda_graphs_mode(True)
+        try:
+            with torch.no_grad():
+                # warms up, captures and replays each shape
+                for _ in range(3):
+                    for length in [3, 8]:
+                        x = torch.randn(length, 5, device='cuda')
+                        y = torch.randn(length, 5, device='cuda')
+                        self.assertEqual(fn(x, y), (x * y + x).relu().sum(1))
+
+                x = torch.ones(64, 64, device='cuda')
+                masks = [drop(x) != 0 for _ in range(4)]
+                self.assertFalse(masks[-1].eq(masks[-2]).all())
+        finally:
+            torch._C._jit_set_cuda_graphs_mode(False)
+
+    def test_pass_timings(self):
+        @torch.jit.script
+        def fn(x):
+            return (x * 2 + 1).relu()
+
+        torch._C._jit_reset_pass_timings()
+        torch._C._jit_set_pass_timing_mode(True)
+        try:
+            fn(torch.randn(3, 4))
+        finally:
+            torch._C._jit_set_pass_timing_mode(False)
+        timings = {name: (count, total_ns) for name, count, total_ns in torch._C._jit_get_pass_timings()}
+        self.assertIn('ConstantPropagation', timings)
+        self.assertGreaterEqual(timings['EliminateDeadCode'][0], 2)
+        self.assertTrue(all(total_ns >= 0 for _, total_ns in timings.values()))
+
+        torch._C._jit_reset_pass_timings()
+        self.assertEqual(torch._C._jit_get_pass_timings(), [])
+
+    def test_compile_time_budget(self):
+        @torch.jit.script
+        def fn(x):
+            return x + 2 * 3
+
+        x = torch.randn(3, 4)
+        old_budget = torch._C._jit_get_compile_time_budget()
+        torch._C._jit_set_compile_time_budget(0)
+        try:
+            # constant propagation is skipped over budget
+            FileCheck().check("aten::mul").run(str(fn.graph_for(x)))
+            for _ in range(9):
+                self.assertEqual(fn(x), x + 6)
+            # and the plan is recompiled with it once hot
+            FileCheck().check_not("aten::mul").run(str(fn.graph_for(x)))
+            self.assertEqual(fn(x), x + 6)
+        finally:
+            torch._C._jit_set_compile_time_budget(old_budget)
+
+    def test_compile_methods_in_parallel(self):
+        class M(torch.jit.ScriptModule):
+            @torch.jit.script_method
+            def forward(self, x):
+                return self.double(x) + 1
+
+            @torch.jit.script_method
+            def double(self, x):
+                return x * 2
+
+        m = M()
+        x = torch.randn(3, 4)
+        m._c._compile_methods_in_parallel({'forward': (x,), 'double': (x,)})
+        self.assertEqual(len(m.get_debug_state().execution_plans), 1)
+        self.assertEqual(m(x), x * 2 + 1)
+        self.assertEqual(m.double(x), x * 2)
+        self.assertEqual(len(m.get_debug_state().execution_plans), 1)
+
+        with self.assertRaisesRegex(RuntimeError, "Expected a value of type"):
+            m._c._compile_methods_in_parallel({'forward': ("not a tensor",)})
+
+    def test_save_optimized_plans(self):
+        class M(torch.jit.ScriptModule):
+            @torch.jit.script_method
+            def forward(self, x, y):
+                return (x * y + x).relu()
+
+        m = M()
+        x, y = torch.randn(3, 4), torch.randn(3, 4)
+        m(x, y)
+        self.assertEqual(len(m.get_debug_state().execution_plans), 1)
+
+        torch._C._jit_set_save_optimized_plans(True)
+        try:
+            buffer = io.BytesIO()
+            torch.jit.save(m, buffer)
+        finally:
+            torch._C._jit_set_save_optimized_plans(False)
+        buffer.seek(0)
+        archive = zipfile.ZipFile(buffer)
+        self.assertTrue(any(name.endswith('optimized_plans.pkl') for name in archive.namelist()))
+
+        buffer.seek(0)
+        loaded = torch.jit.load(buffer)
+        # the plan is there before the first run
+        self.assertEqual(len(loaded.get_debug_state().execution_plans), 1)
+        self.assertEqual(str(loaded.graph_for(x, y)), str(m.graph_for(x, y)))
+        self.assertEqual(loaded(x, y), m(x, y))
+
+        # plans that were not saved are not restored
+        buffer = io.BytesIO()
+        torch.jit.save(m, buffer)
+        buffer.seek(0)
+        loaded = torch.jit.load(buffer)
+        self.assertEqual(len(loaded.get_debug_state().execution_plans), 0)
+
+    def test_export_opnames(self):
+        class Sub(torch.jit.ScriptModule):
+            @torch.jit.script_method
+            def forward(self, x):
+                return x.relu()
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.sub = Sub()
+
+            @torch.jit.script_method
+            def forward(self, x, y):
+                return self.sub(x * y + x)
+
+        op_names = torch.jit.export_opnames(M())
+        self.assertIn('aten::add.Tensor', op_names)
+        self.assertIn('aten::mul.Tensor', op_names)
+        self.assertIn('aten::relu', op_names)
+
 
     def test_resize_input_ops(self):
         # resize_ and resize_as resize the input tensor. because our shape analysis
@@ -10820,6 +11270,22 @@ a")
         # and shape analysis dtype is the same.
         FileCheck().check("Double(*, *)").check_not("Float(*, *)").run(randint.graph_for())
 
+    def test_mm_batching_independent(self):
+        def heads(x1, x2, x3, x4, w1, w2, w3, w4, b):
+            return (torch.mm(x1, w1), torch.nn.functional.linear(x2, w2, b),
+                    torch.matmul(x3, w3), torch.mm(x4, w4))
+
+        sheads = torch.jit.script(heads)
+        xs = [torch.randn(3, 4) for _ in range(4)]
+        ws = [torch.randn(4, 5), torch.randn(5, 4), torch.randn(4, 5), torch.randn(4, 5)]
+        inputs = xs + ws + [torch.randn(5)]
+        self.assertEqual(sheads(*inputs), heads(*inputs))
+        FileCheck().check("prim::MMBatchIndependent").run(str(sheads.graph_for(*inputs)))
+
+        # products of different shapes run one by one
+        inputs[3] = torch.randn(2, 4)
+        self.assertEqual(sheads(*inputs), heads(*inputs))
+
     def test_erase_number_types(self):
         def func(a):
             b = 7 + 1 + 3
@@ -10910,6 +11376,21 @@ a")
             .check("prim::Loop").check("aten::sub").run(str(graph))
         self.checkScript(fn, (torch.tensor(10),))
 
+    def test_loop_unrolling_large_body(self):
+        def fn(x):
+            y = x
+            for i in range(60):
+                y = y * x + i
+                y = y - x * i
+                y = y * 2 - x
+            return y
+
+        graph = torch.jit.script(fn).graph
+        self.run_pass('loop_unrolling', graph)
+        # too many nodes to unroll all the iterations
+        FileCheck().check("prim::Loop").run(str(graph))
+        self.checkScript(fn, (torch.tensor(3),))
+
     def test_loop_unroll_unused_counter(self):
         def fn(x):
             y = 0
@@ -15176,6 +15657,30 @@ a")
         self.assertEqual(m.int64_max, imported.int64_max)
         self.assertEqual(m.int64_min, imported.int64_min)
 
+    def test_serialization_big_containers(self):
+        # More than 256 memoized strings, so LONG_BINPUT/LONG_BINGET are used,
+        # and strings of all lengths around the size of the pickler's buffer
+        vocab = {'w' * (i % 300) + str(i): i for i in range(1000)}
+        tensors = {str(i): torch.full((2,), i) for i in range(300)}
+
+        class M(torch.jit.ScriptModule):
+            def __init__(self):
+                super(M, self).__init__()
+                self.vocab = torch.jit.Attribute(vocab, Dict[str, int])
+                self.tensors = torch.jit.Attribute(tensors, Dict[str, torch.Tensor])
+                self.keys = torch.jit.Attribute(list(vocab.keys()) * 2, List[str])
+                self.ints = torch.jit.Attribute(list(range(-5000, 5000, 7)), List[int])
+                self.floats = torch.jit.Attribute([i / 7.0 for i in range(1000)], List[float])
+                self.bools = torch.jit.Attribute([i % 3 == 0 for i in range(1000)], List[bool])
+
+            @torch.jit.script_method
+            def forward(self):
+                return self.vocab, self.tensors, self.keys, self.ints, self.floats, self.bools
+
+        m = M()
+        imported = self.getExportImportCopy(m)
+        self.assertEqual(m(), imported())
+
     def test_script_scope(self):
         scripted = torch.jit.script(torch.nn.functional.pad)
 
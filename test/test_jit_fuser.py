@@ -3,6 +3,11 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
 import unittest
 import torch
 import torch.nn as nn
@@ -46,6 +51,121 @@ class TestFuser(JitTestCase):
     def test_abs_cuda(self):
         self._test_fused_abs(device="cuda")
 
+    def _test_fused_row_reductions(self, device):
+        def softmax(x, y):
+            return torch.softmax(x * y, dim=-1) + torch.log_softmax(x + y, dim=-1)
+
+        def layer_norm(x, w, b):
+            return F.gelu(torch.layer_norm(x + 1, [16], w, b, 1e-5, False)) * 2
+
+        def broadcast_softmax(x, y):
+            return torch.softmax(x, dim=-1) + y
+
+        x = torch.randn(8, 16, device=device)
+        y = torch.rand(16, device=device) + 0.5
+        w = torch.randn(16, device=device)
+        b = torch.randn(16, device=device)
+
+        # -inf doesn't contribute to the normalization
+        x_inf = x.clone()
+        x_inf[0, 3] = float('-inf')
+        ge = self.checkScript(softmax, (x_inf, y))
+        self.assertAllFused(ge.graph_for(x_inf, y))
+
+        ge = self.checkScript(layer_norm, (x, w, b))
+        if device == 'cpu':
+            # On CUDA, layer_norm is decomposed before fusion
+            self.assertAllFused(ge.graph_for(x, w, b))
+
+        # Rows of x are broadcast, the fused kernel can't normalize them
+        self.checkScript(broadcast_softmax, (torch.randn(8, 1, device=device), x))
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @enable_cpu_fuser
+    def test_row_reductions_cpu(self):
+        self._test_fused_row_reductions('cpu')
+
+    @unittest.skipIf(not RUN_CUDA, "requires CUDA")
+    def test_row_reductions_cuda(self):
+        self._test_fused_row_reductions('cuda')
+
+    def _test_disk_cache(self, device):
+        # The cache directory is read once per process, so run in a child
+        script = dedent('''
+            import torch
+            torch._C._jit_override_can_fuse_on_cpu(True)
+
+            @torch.jit.script
+            def func(x):
+                return x.abs() * 2
+
+            a = torch.randn(5, device="{}")
+            for _ in range(3):
+                assert torch.equal(func(a), a.abs() * 2)
+        ''').format(device)
+        cache_dir = tempfile.mkdtemp()
+        try:
+            env = os.environ.copy()
+            env['PYTORCH_FUSER_CACHE_DIR'] = cache_dir
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            entries = sorted(os.listdir(cache_dir))
+            self.assertEqual(len(entries), 2)
+            self.assertTrue(entries[1].endswith('.key'))
+            # A second process loads the cached kernel
+            mtime = os.path.getmtime(os.path.join(cache_dir, entries[0]))
+            subprocess.check_call([sys.executable, '-c', script], env=env)
+            self.assertEqual(sorted(os.listdir(cache_dir)), entries)
+            self.assertEqual(os.path.getmtime(os.path.join(cache_dir, entries[0])), mtime)
+        finally:
+            shutil.rmtree(cache_dir)
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    def test_disk_cache_cpu(self):
+        self._test_disk_cache('cpu')
+
+    @unittest.skipIf(not RUN_CUDA, "requires CUDA")
+    def test_disk_cache_cuda(self):
+        self._test_disk_cache('cuda')
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    def test_async_compile_cpu(self):
+        # The setting is read once per process, so run in a child. The results
+        # are the same before and after the kernel is ready.
+        script = dedent('''
+            import time
+            import torch
+            torch._C._jit_override_can_fuse_on_cpu(True)
+
+            @torch.jit.script
+            def func(x):
+                return x.abs() * 2
+
+            a = torch.randn(5)
+            for _ in range(100):
+                assert torch.equal(func(a), a.abs() * 2)
+                time.sleep(0.05)
+        ''')
+        env = os.environ.copy()
+        env['PYTORCH_FUSER_ASYNC_COMPILE'] = '1'
+        subprocess.check_call([sys.executable, '-c', script], env=env)
+
+    @unittest.skipIf(IS_SANDCASTLE, "NYI: fuser CPU support for Sandcastle")
+    @enable_cpu_fuser
+    def test_contiguous_kernel_cpu(self):
+        code = '''
+        graph(%0 : Float(*, *), %1 : Float(*, *)):
+            %2 : Float(*, *) = aten::mul(%0, %1)
+            %3 : Float(*, *) = aten::relu(%2)
+            return (%3)
+        '''
+        graph = torch._C.parse_ir(code)
+        x = torch.rand(4, 6)
+        y = torch.rand(4, 6)
+        code = torch._C._jit_fuser_get_fused_kernel_code(graph, [x, y])
+        FileCheck().check('t0_data[linearIndex]').check('t2_data[linearIndex]').run(code)
+        code = torch._C._jit_fuser_get_fused_kernel_code(graph, [x, y.t().contiguous().t()])
+        FileCheck().check_not('linearIndex]').run(code)
+
     @unittest.skipIf(not RUN_CUDA, "requires CUDA")
     def test_zero_element_tensors(self):
         def decode(sin_t, cos_t):
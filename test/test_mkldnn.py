@@ -12,6 +12,7 @@ skipIfNoTorchVision = unittest.skipIf(not HAS_TORCHVISION, "no torchvision")
 
 import torch
 import torch.jit
+from torch.testing import FileCheck
 from torch.utils import mkldnn as mkldnn_utils
 from common_utils import TestCase, run_tests, TemporaryFileName
 
@@ -122,6 +123,64 @@ class TestMkldnn(TestCase):
                 self._test_serialization(mkldnn_conv2d, (x.to_mkldnn(),))
                 self._test_tracing(mkldnn_conv2d, (x.to_mkldnn(),))
 
+    def test_conv2d_fused(self):
+        for groups in [1, 4]:
+            N = torch.randint(3, 10, (1,)).item()
+            C = torch.randint(1, 3, (1,)).item() * groups
+            M = torch.randint(1, 3, (1,)).item() * groups
+            x = torch.randn(N, C, 56, 56, dtype=torch.float32) * 10
+            conv2d = torch.nn.Conv2d(in_channels=C,
+                                     out_channels=M,
+                                     kernel_size=3,
+                                     padding=1,
+                                     groups=groups).float()
+            args = (conv2d.padding, conv2d.stride, conv2d.dilation, groups)
+            with torch.no_grad():
+                y = conv2d(x)
+                other = torch.randn_like(y)
+                for residual in [None, other]:
+                    for fuse_relu in [True, False]:
+                        expected = y if residual is None else y + residual
+                        if fuse_relu:
+                            expected = torch.relu(expected)
+                        self.assertEqual(
+                            expected,
+                            torch.mkldnn_convolution_fused(
+                                x.to_mkldnn(), conv2d.weight.to_mkldnn(),
+                                conv2d.bias.to_mkldnn(), *args,
+                                other=None if residual is None else residual.to_mkldnn(),
+                                fuse_relu=fuse_relu).to_dense())
+
+    def test_conv2d_weight_cache(self):
+        x = torch.randn(2, 4, 16, 16, dtype=torch.float32)
+        conv2d = torch.nn.Conv2d(4, 8, kernel_size=3).float()
+        weight = conv2d.weight.detach().to_mkldnn()
+        bias = conv2d.bias.detach().to_mkldnn()
+        with torch.no_grad():
+            for _ in range(2):
+                self.assertEqual(
+                    conv2d(x),
+                    torch.conv2d(x.to_mkldnn(), weight, bias).to_dense())
+            # modifying the weight in place invalidates its reordered copy
+            weight.zero_()
+            self.assertEqual(
+                conv2d.bias.view(1, 8, 1, 1).expand(2, 8, 14, 14),
+                torch.conv2d(x.to_mkldnn(), weight, bias).to_dense())
+
+    def test_to_mkldnn_fuses_relu(self):
+        model = torch.nn.Sequential(
+            torch.nn.Conv2d(3, 8, kernel_size=3),
+            torch.nn.ReLU(),
+            torch.nn.Conv2d(8, 8, kernel_size=3),
+        ).float()
+        x = torch.randn(2, 3, 32, 32, dtype=torch.float32)
+        mkldnn_model = mkldnn_utils.to_mkldnn(copy.deepcopy(model))
+        self.assertTrue(mkldnn_model[0].fuse_relu)
+        self.assertIsInstance(mkldnn_model[1], torch.nn.Identity)
+        self.assertFalse(mkldnn_model[2].fuse_relu)
+        with torch.no_grad():
+            self.assertEqual(model(x), mkldnn_model(x.to_mkldnn()).to_dense())
+
     def test_relu(self):
         x = torch.randn((4, 5), dtype=torch.float32) * 10
         self.assertEqual(torch.relu(x), torch.relu(x.to_mkldnn()).to_dense())
@@ -407,6 +466,40 @@ class TestMkldnn(TestCase):
         self.assertTrue(m(x).is_mkldnn)
         self.assertTrue(m(x.to_mkldnn()).is_mkldnn)
 
+    def test_convert_to_mkldnn_pass(self):
+        class ConvBlock(torch.nn.Module):
+            def __init__(self):
+                super(ConvBlock, self).__init__()
+                self.conv = torch.nn.Conv2d(3, 8, kernel_size=3, padding=1)
+                self.bn = torch.nn.BatchNorm2d(8)
+                self.pool = torch.nn.AdaptiveAvgPool2d((1, 1))
+                self.fc = torch.nn.Linear(8, 4)
+
+            def forward(self, x):
+                y = self.bn(self.conv(x))
+                y += self.conv(x)
+                y = torch.relu_(y)
+                return self.fc(torch.flatten(self.pool(y), 1))
+
+        model = ConvBlock().float().eval()
+        x = torch.randn(2, 3, 16, 16, dtype=torch.float32)
+        with torch.no_grad():
+            traced = torch.jit.trace(model, x)
+            torch._C._jit_pass_convert_to_mkldnn(traced.graph)
+            # the activations stay MKL-DNN tensors from the input to the
+            # pooling, whose output is flattened by a dense op
+            FileCheck().check("aten::to_mkldnn").check("aten::conv2d") \
+                .check_not("aten::to_dense").check("aten::batch_norm") \
+                .check_not("aten::to_dense").check("aten::add") \
+                .check_not("aten::to_dense").check("aten::relu") \
+                .check_not("aten::to_dense").check("aten::adaptive_avg_pool2d") \
+                .check("aten::to_dense").check("aten::flatten") \
+                .check("aten::to_mkldnn").check("aten::linear") \
+                .check("aten::to_dense").run(str(traced.graph))
+            FileCheck().check_not("aten::relu_").check_not("aten::add_") \
+                .run(str(traced.graph))
+            self.assertEqual(model(x), traced(x))
+
     def _test_imagenet_model(self, model):
         model = model.train(False).float()
         mkldnn_model = mkldnn_utils.to_mkldnn(copy.deepcopy(model))
@@ -73,6 +73,18 @@ def receive_and_send_sum(queue, out_queue, event, tp, count, size=5):
     event.wait()
 
 
+def receive_pooled_and_send_sum(queue, out_queue, event, tp, count, size=5):
+    mp.set_cuda_ipc_pooling(True)
+    s = torch.full([size], 0).type(tp)
+    for i in range(count):
+        t = queue.get()
+        s += t
+        del t
+    torch.cuda.ipc_collect()
+    out_queue.put(s)
+    event.wait()
+
+
 def receive_and_send(queue, out_queue, event, count):
     for i in range(count):
         t = queue.get()
@@ -167,6 +179,16 @@ def fs_sharing():
         mp.set_sharing_strategy(prev_strategy)
 
 
+@contextlib.contextmanager
+def arena_sharing():
+    prev_strategy = mp.get_sharing_strategy()
+    mp.set_sharing_strategy('shared_arena')
+    try:
+        yield
+    finally:
+        mp.set_sharing_strategy(prev_strategy)
+
+
 class leak_checker(object):
 
     def __init__(self, test_case):
@@ -336,6 +358,46 @@ class TestMultiprocessing(TestCase):
         with fs_sharing():
             self._test_pool(repeat=TEST_REPEATS)
 
+    @unittest.skipIf(IS_WINDOWS, "shared_arena strategy is not supported on Windows")
+    @unittest.skipIf(TEST_WITH_ASAN,
+                     "seems to hang with ASAN, see https://github.com/pytorch/pytorch/issues/5326")
+    def test_arena_sharing(self):
+        with arena_sharing():
+            self._test_sharing(repeat=TEST_REPEATS)
+
+    @unittest.skipIf(IS_WINDOWS, "shared_arena strategy is not supported on Windows")
+    def test_arena_preserve_sharing(self):
+        with arena_sharing():
+            self._test_preserve_sharing(repeat=TEST_REPEATS)
+
+    @unittest.skipIf(IS_WINDOWS, "shared_arena strategy is not supported on Windows")
+    def test_arena_pool(self):
+        with arena_sharing():
+            self._test_pool(repeat=TEST_REPEATS)
+
+    @unittest.skipIf(IS_WINDOWS, "shared_arena strategy is not supported on Windows")
+    def test_arena_recycling(self):
+        with arena_sharing():
+            s = torch.FloatStorage._new_shared(1000)
+            ptr = s.data_ptr()
+            del s
+            s = torch.FloatStorage._new_shared(1000)
+            self.assertEqual(s.data_ptr(), ptr)
+
+            # a block received by another process is only recycled once the
+            # receiver frees it too
+            s.fill_(3)
+            metadata = s._share_arena_()
+            s._shared_incref()
+            received = torch.FloatStorage._new_shared_arena(*metadata)._shared_decref()
+            self.assertEqual(received.tolist(), [3] * 1000)
+            del s
+            other = torch.FloatStorage._new_shared(1000)
+            self.assertNotEqual(other.data_ptr(), ptr)
+            del received
+            s = torch.FloatStorage._new_shared(1000)
+            self.assertEqual(s.data_ptr(), ptr)
+
     @unittest.skipIf(not HAS_SHM_FILES, "don't not how to check if shm files exist")
     def test_fs(self):
         def queue_put():
@@ -410,6 +472,37 @@ class TestMultiprocessing(TestCase):
         p2.join(1)
         p3.join(1)
 
+    @unittest.skipIf(NO_MULTIPROCESSING_SPAWN, "Disabled for environments that \
+                     don't support multiprocessing with spawn start method")
+    @unittest.skipIf(not TEST_CUDA_IPC, 'CUDA IPC not available')
+    def test_cuda_send_many_pooled(self, size=5, count=10000):
+        ctx = mp.get_context('spawn')
+        q1 = ctx.Queue()
+        q2 = ctx.Queue()
+        e1 = ctx.Event()
+        e2 = ctx.Event()
+        p1 = ctx.Process(target=send_and_delete_tensors, args=(q1, e1, torch.cuda.LongTensor, count, size))
+        p2 = ctx.Process(target=receive_pooled_and_send_sum, args=(q1, q2, e2, torch.cuda.LongTensor, count, size))
+        p1.start()
+        p2.start()
+        result = q2.get()
+        self.assertEqual(result, torch.full([size], count * (count - 1) // 2).type(torch.cuda.LongTensor))
+        del result
+        e1.set()
+        e2.set()
+        p1.join(1)
+        p2.join(1)
+
+    @unittest.skipIf(not torch.cuda.is_available(), 'CUDA not available')
+    def test_cuda_ipc_pooling_flag(self):
+        self.assertFalse(mp.get_cuda_ipc_pooling())
+        mp.set_cuda_ipc_pooling(True)
+        try:
+            self.assertTrue(mp.get_cuda_ipc_pooling())
+        finally:
+            mp.set_cuda_ipc_pooling(False)
+        self.assertFalse(mp.get_cuda_ipc_pooling())
+
     @unittest.skipIf(NO_MULTIPROCESSING_SPAWN, "Disabled for environments that \
                      don't support multiprocessing with spawn start method")
     @unittest.skipIf(not TEST_CUDA_IPC, 'CUDA IPC not available')
@@ -816,6 +909,11 @@ if __name__ == "__main__":
         with fs_sharing():
             self._test_is_shared()
 
+    @unittest.skipIf(IS_WINDOWS, "shared_arena strategy is not supported on Windows")
+    def test_arena_is_shared(self):
+        with arena_sharing():
+            self._test_is_shared()
+
     @unittest.skipIf(not torch.cuda.is_available(), 'CUDA not available')
     def test_is_shared_cuda(self):
         t = torch.randn(5, 5).cuda()
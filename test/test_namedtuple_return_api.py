@@ -12,7 +12,7 @@ aten_native_yaml = os.path.join(path, '../aten/src/ATen/native/native_functions.
 all_operators_with_namedtuple_return = {
     'max', 'min', 'median', 'mode', 'kthvalue', 'svd', 'symeig', 'eig',
     'qr', 'geqrf', 'solve', 'slogdet', 'sort', 'topk', 'lstsq',
-    'triangular_solve'
+    'triangular_solve', 'cummax', 'cummin'
 }
 
 
@@ -54,6 +54,8 @@ class TestNamedTupleAPI(unittest.TestCase):
         operators = [
             op(operators=['max', 'min', 'median', 'mode', 'sort', 'topk'], input=(0,),
                names=('values', 'indices'), hasout=True),
+            op(operators=['cummax', 'cummin'], input=(0,),
+               names=('values', 'indices'), hasout=True),
             op(operators=['kthvalue'], input=(1, 0),
                names=('values', 'indices'), hasout=True),
             op(operators=['svd'], input=(), names=('U', 'S', 'V'), hasout=True),
@@ -7,6 +7,7 @@ import unittest
 import itertools
 import warnings
 import pickle
+import tempfile
 from copy import deepcopy
 from itertools import repeat, product
 from functools import reduce
@@ -41,7 +42,7 @@ from common_nn import NNTestCase, ModuleTest, CriterionTest, TestBase, \
     ctcloss_reference, new_module_tests
 from common_device_type import instantiate_device_type_tests, dtypes, \
     dtypesIfCUDA, skipCUDAIfNoCudnn, skipCUDAIfCudnnVersionLessThan, onlyCUDA, \
-    skipCUDAIfRocm, skipCUDAIf
+    skipCUDAIfRocm, skipCUDAIf, onlyCPU
 
 from torch.nn import MultiheadAttention
 
@@ -2759,6 +2760,95 @@ class TestNN(NNTestCase):
         self.assertEqual(out, ref_out)
         self.assertEqual(input.grad, ref_input.grad)
 
+    def _test_nhwc_cpu(self, module, input_size):
+        input = torch.randn(input_size, dtype=torch.double)
+        input = input.contiguous(memory_format=torch.channels_last).requires_grad_()
+        ref_input = input.detach().clone().contiguous().requires_grad_(True)
+        ref_module = deepcopy(module)
+
+        out = module(input)
+        ref_out = ref_module(ref_input)
+        grad = torch.randn_like(ref_out)
+        out.backward(grad)
+        ref_out.backward(grad)
+
+        self.assertTrue(out.is_contiguous(memory_format=torch.channels_last))
+        self.assertTrue(ref_out.is_contiguous())
+        self.assertEqual(out, ref_out)
+        self.assertEqual(input.grad, ref_input.grad)
+        for p, ref_p in zip(module.parameters(), ref_module.parameters()):
+            self.assertEqual(p.grad, ref_p.grad)
+
+    def test_conv_nhwc_cpu(self):
+        for kernel_size, stride, padding, groups in [(1, 1, 0, 1), (1, 2, 0, 1), (3, 1, 1, 1),
+                                                     (3, 2, 1, 2), (5, 2, 2, 4), (2, 1, 0, 8)]:
+            for bias in [True, False]:
+                conv = nn.Conv2d(8, 16, kernel_size, stride=stride, padding=padding,
+                                 groups=groups, bias=bias).double()
+                self._test_nhwc_cpu(conv, (2, 8, 9, 7))
+
+    def _test_conv_inference_cpu(self, input_size, out_channels, kernel_size, prec, **kwargs):
+        # without grad, the CPU picks the Winograd or implicit GEMM kernels;
+        # with it, the reference is computed in double by thnn_conv2d
+        x = torch.randn(input_size)
+        w = torch.randn(out_channels, input_size[1], kernel_size, kernel_size)
+        b = torch.randn(out_channels)
+        expected = F.conv2d(x.double().requires_grad_(), w.double(), b.double(), **kwargs)
+        for bias in [b, None]:
+            if bias is None:
+                expected = expected - b.double().view(1, -1, 1, 1)
+            with torch.no_grad():
+                result = F.conv2d(x, w, bias, **kwargs)
+            self.assertEqual(result.double(), expected.detach(), prec)
+
+    def test_conv_winograd3x3_cpu(self):
+        # 4x4 output tiles, with partial tiles at the borders
+        self._test_conv_inference_cpu((2, 16, 21, 19), 24, 3, 1e-3, padding=1)
+        # 2x2 output tiles
+        self._test_conv_inference_cpu((3, 16, 7, 6), 16, 3, 1e-3)
+
+    def test_conv_implicit_gemm_cpu(self):
+        # large enough column buffers, with bands of output rows that don't
+        # divide the output
+        self._test_conv_inference_cpu((1, 4, 306, 306), 8, 7, 1e-3)
+        self._test_conv_inference_cpu((1, 4, 611, 613), 4, 7, 1e-3, stride=2, padding=3)
+
+    def test_pooling_nhwc_cpu(self):
+        for module in [nn.MaxPool2d(3, stride=2, padding=1),
+                       nn.MaxPool2d(2, dilation=2, ceil_mode=True),
+                       nn.AvgPool2d(3, stride=2, padding=1),
+                       nn.AvgPool2d(3, stride=2, padding=1, count_include_pad=False),
+                       nn.AvgPool2d(2, ceil_mode=True, divisor_override=3)]:
+            self._test_nhwc_cpu(module, (2, 8, 9, 7))
+
+    def test_batchnorm_nhwc_cpu(self):
+        bn = nn.BatchNorm2d(8).double()
+        self._test_nhwc_cpu(bn, (2, 8, 9, 7))
+        bn.eval()
+        self._test_nhwc_cpu(bn, (2, 8, 9, 7))
+
+    def test_batchnorm_stats_cpu(self):
+        # the statistics of every layout against var_mean, for inputs that are
+        # reduced serially and in parallel
+        for dtype in [torch.float, torch.double]:
+            for shape in [(2, 8, 9, 7), (64, 3, 33, 35), (5, 19), (4096, 16)]:
+                x = torch.randn(shape, dtype=dtype) * 3 + 5
+                dims = [0] + list(range(2, x.dim()))
+                var, mean = torch.var_mean(x.double(), dims, unbiased=False)
+                inputs = [x, x.transpose(0, 1).contiguous().transpose(0, 1)]
+                if x.dim() == 4:
+                    inputs.append(x.contiguous(memory_format=torch.channels_last))
+                for input in inputs:
+                    running_mean = torch.zeros(shape[1], dtype=dtype)
+                    running_var = torch.ones(shape[1], dtype=dtype)
+                    out = F.batch_norm(input, running_mean, running_var, training=True, momentum=1.0, eps=0)
+                    n = x.numel() / shape[1]
+                    self.assertEqual(running_mean, mean.to(dtype), prec=1e-5)
+                    self.assertEqual(running_var, (var * n / (n - 1)).to(dtype), prec=1e-4)
+                    stats_shape = [1, shape[1]] + [1] * (x.dim() - 2)
+                    expected = (x.double() - mean.view(stats_shape)) / var.view(stats_shape).sqrt()
+                    self.assertEqual(out, expected.to(dtype), prec=1e-4)
+
     @unittest.skipIf(not TEST_MULTIGPU, "multi-GPU not supported")
     def test_broadcast_double_backwards_gpu(self):
         tensors = (torch.randn(4, 4, device='cuda', requires_grad=True),
@@ -3120,6 +3210,36 @@ class TestNN(NNTestCase):
             # but it should work with the same type
             nn.functional.conv2d(inputs.float(), weights.float(), bias.float())
 
+    @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
+    @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
+    def test_cudnn_save_load_convolution_algorithms(self):
+        conv = nn.Conv2d(3, 5, 3).cuda()
+        input = torch.randn(2, 3, 11, 13, device='cuda', requires_grad=True)
+        with torch.backends.cudnn.flags(enabled=True, benchmark=True):
+            conv(input).sum().backward()
+
+        with tempfile.NamedTemporaryFile() as f:
+            saved = torch.backends.cudnn.save_convolution_algorithms(f.name)
+            # forward, backward data and backward filter at least
+            self.assertGreaterEqual(saved, 3)
+            self.assertEqual(torch.backends.cudnn.load_convolution_algorithms(f.name), saved)
+
+            with open(f.name) as saved_file:
+                lines = saved_file.readlines()
+            header = lines[0].split(' ')
+            header[2] = '0'  # another cuDNN version
+            with open(f.name, 'w') as saved_file:
+                saved_file.writelines([' '.join(header)] + lines[1:])
+            with warnings.catch_warnings(record=True) as w:
+                warnings.simplefilter("always")
+                self.assertEqual(torch.backends.cudnn.load_convolution_algorithms(f.name), 0)
+            self.assertEqual(len(w), 1)
+
+            with open(f.name, 'w') as saved_file:
+                saved_file.write('not an algorithm file\n')
+            with self.assertRaisesRegex(RuntimeError, "not a cuDNN convolution algorithm file"):
+                torch.backends.cudnn.load_convolution_algorithms(f.name)
+
     @unittest.skipIf(not TEST_CUDA, 'CUDA not available')
     @unittest.skipIf(not TEST_CUDNN, 'CUDNN not available')
     @skipIfRocm
@@ -4731,6 +4851,57 @@ class TestNN(NNTestCase):
             self.assertEqual(output1, output2)
             self.assertEqual(hidden1, hidden2)
 
+    def test_rnn_fused_inference_cpu(self):
+        # Without grad, LSTM and GRU layers run through fused CPU kernels;
+        # they must give the same results as the unfused cells.
+        for mode, bidirectional, bias, dtype in product(
+                ['GRU', 'LSTM'], [False, True], [False, True], [torch.float, torch.double]):
+            rnn = getattr(nn, mode)(11, 13, 2, bias=bias, bidirectional=bidirectional).to(dtype)
+            input = torch.randn(7, 5, 11, dtype=dtype)
+            num_directions = 2 if bidirectional else 1
+            hx = torch.randn(2 * num_directions, 5, 13, dtype=dtype)
+            if mode == 'LSTM':
+                hx = (hx, torch.randn_like(hx))
+            output1, hidden1 = rnn(input, hx)
+            with torch.no_grad():
+                output2, hidden2 = rnn(input, hx)
+            prec = 1e-5 if dtype == torch.float else 1e-10
+            self.assertEqual(output1, output2, prec=prec)
+            self.assertEqual(hidden1, hidden2, prec=prec)
+
+    def test_rnn_inference_workspace_cpu(self):
+        # Calls without grad reuse the buffers of the previous ones, which
+        # must not change the outputs these returned.
+        for mode, batch_first in product(['GRU', 'LSTM'], [False, True]):
+            rnn = getattr(nn, mode)(11, 13, 2, bidirectional=True, batch_first=batch_first)
+            inputs = [torch.randn(5, 7, 11), torch.randn(5, 3, 11), torch.randn(2, 9, 11)]
+            expected = [rnn(input)[0].detach() for input in inputs]
+            with torch.no_grad():
+                outputs = [rnn(input)[0] for input in inputs]
+                outputs.append(rnn(inputs[0])[0])
+            expected.append(expected[0])
+            for output, e in zip(outputs, expected):
+                self.assertEqual(output, e, prec=1e-5)
+
+    def test_rnn_fused_packed_inference_cpu(self):
+        # Without grad, packed sequences run through the fused CPU kernels
+        # over the shrinking batch of every step, which must give the same
+        # results as the unfused cells.
+        lengths = [6, 6, 4, 3, 1]
+        for mode, bidirectional in product(['GRU', 'LSTM'], [False, True]):
+            rnn = getattr(nn, mode)(11, 13, 2, bidirectional=bidirectional)
+            input = rnn_utils.pack_padded_sequence(torch.randn(6, 5, 11), lengths)
+            num_directions = 2 if bidirectional else 1
+            hx = torch.randn(2 * num_directions, 5, 13)
+            if mode == 'LSTM':
+                hx = (hx, torch.randn_like(hx))
+            output1, hidden1 = rnn(input, hx)
+            with torch.no_grad():
+                output2, hidden2 = rnn(input, hx)
+            self.assertEqual(output1.data, output2.data, prec=1e-5)
+            self.assertEqual(output1.batch_sizes, output2.batch_sizes)
+            self.assertEqual(hidden1, hidden2, prec=1e-5)
+
     def _test_RNN_cpu_vs_cudnn(self, dropout, dtype=torch.double):
 
         def forward_backward(cuda, rnn, input_val, hx_val, grad_output, grad_hy, weights_val):
@@ -5139,6 +5310,39 @@ class TestNN(NNTestCase):
                 _test_gelu(n, m, torch.float64, True)
                 _test_gelu(n, m, torch.float64, False)
 
+    def test_fused_transformer_ops(self):
+        for dtype in [torch.float32, torch.float64]:
+            for shape in [(3, 1), (2, 5, 13), (4, 768)]:
+                x = torch.randn(shape, dtype=dtype)
+                residual = torch.randn(shape, dtype=dtype)
+                bias = torch.randn(shape[-1], dtype=dtype)
+                weight = torch.randn(shape[-1], dtype=dtype)
+                prec = 1e-4 if dtype == torch.float32 else 1e-8
+
+                self.assertEqual(torch._fused_bias_gelu(x, bias), F.gelu(x + bias), prec)
+                self.assertEqual(torch._fused_bias_gelu(x[..., ::2], bias[::2]),
+                                 F.gelu(x[..., ::2] + bias[::2]), prec)
+                for affine in [None, (weight, bias)]:
+                    w, b = affine if affine else (None, None)
+                    self.assertEqual(
+                        torch._fused_add_layer_norm(x, residual, shape[-1:], w, b, 1e-5),
+                        F.layer_norm(x + residual, shape[-1:], w, b, 1e-5), prec)
+                self.assertEqual(torch._fused_bias_dropout_add(x, bias, residual, 0.5, False),
+                                 x + bias + residual, prec)
+
+        # The unfused ops run where the fused kernel doesn't apply.
+        x = torch.randn(4, 6, requires_grad=True)
+        bias = torch.randn(6, requires_grad=True)
+        torch._fused_bias_gelu(x, bias).sum().backward()
+        x_ref = x.detach().requires_grad_()
+        bias_ref = bias.detach().requires_grad_()
+        F.gelu(x_ref + bias_ref).sum().backward()
+        self.assertEqual(x.grad, x_ref.grad)
+        self.assertEqual(bias.grad, bias_ref.grad)
+        self.assertEqual(torch._fused_bias_gelu(x, torch.ones(4, 1)), F.gelu(x + torch.ones(4, 1)))
+        out = torch._fused_bias_dropout_add(torch.ones(100, 100), torch.zeros(100), torch.zeros(100, 100), 0.5, True)
+        self.assertTrue(((out == 0) | (out == 2)).all())
+
 
     def test_bce_loss_always_nonnegative(self):
         target = torch.ones(5)
@@ -6408,6 +6612,36 @@ class TestNN(NNTestCase):
             out_t_5 = m(in_t_9[:, :, :5, :5])
         self.assertEqual(out_t_9[:, :, :15, :15], out_t_5)
 
+    def test_upsampling2d_backward_wide(self):
+        # rows wider than a vector register and several planes per thread
+        input = torch.randn(2, 3, 9, 21, dtype=torch.double, requires_grad=True)
+        for size in [(5, 11), (13, 43)]:
+            gradcheck(lambda x: F.interpolate(x, size, mode='nearest'), [input])
+            for align_corners in [True, False]:
+                for mode in ['bilinear', 'bicubic']:
+                    gradcheck(lambda x: F.interpolate(x, size, mode=mode, align_corners=align_corners), [input])
+
+    def test_grid_sample_backward_split_rows(self):
+        # with fewer samples than threads, the rows of the grid are processed
+        # in parallel, which must not change the gradients
+        input = torch.randn(1, 3, 20, 30, dtype=torch.double, requires_grad=True)
+        grid = torch.rand(1, 70, 80, 2, dtype=torch.double).mul_(2.2).sub_(1.1).requires_grad_()
+        num_threads = torch.get_num_threads()
+        for mode in ['bilinear', 'nearest']:
+            grad_output = torch.randn(1, 3, 70, 80, dtype=torch.double)
+            grads = []
+            for threads in [1, max(num_threads, 4)]:
+                try:
+                    torch.set_num_threads(threads)
+                    F.grid_sample(input, grid, mode=mode, align_corners=False).backward(grad_output)
+                finally:
+                    torch.set_num_threads(num_threads)
+                grads.append((input.grad, grid.grad))
+                input.grad = None
+                grid.grad = None
+            self.assertEqual(grads[0][0], grads[1][0])
+            self.assertEqual(grads[0][1], grads[1][1])
+
     def test_upsamplingNearest3d(self):
         m = nn.Upsample(size=4, mode='nearest')
         in_t = torch.ones(1, 1, 2, 2, 2)
@@ -8412,6 +8646,34 @@ class TestNNDeviceType(NNTestCase):
         F.conv_transpose2d(x, torch.randn(16, 1, 1, 1, device=device))
         F.conv2d(x, torch.randn(1, 16, 1, 1, device=device))
 
+    @onlyCUDA
+    @dtypes(torch.float, torch.double)
+    def test_masked_softmax_dropout(self, device, dtype):
+        scores = torch.randn(2, 3, 5, 70, device=device, dtype=dtype)
+        bool_mask = torch.rand(2, 1, 1, 70, device=device) < 0.3
+        bool_mask[1] = True  # rows left out entirely
+        additive_mask = torch.zeros(bool_mask.shape, device=device, dtype=dtype).masked_fill_(bool_mask, -float('inf'))
+        for mask in [bool_mask, additive_mask]:
+            out, softmax, _ = torch._masked_softmax_dropout(scores, mask, 0.)
+            expected = torch.softmax(scores.masked_fill(bool_mask, -float('inf')), -1)
+            expected = expected.masked_fill(bool_mask, 0)
+            self.assertEqual(out, expected)
+            self.assertEqual(softmax, expected)
+
+            # the gradient of the unfused ops with the dropout mask the
+            # result shows
+            p = 0.4
+            x = scores.clone().requires_grad_()
+            out, softmax, _ = torch._masked_softmax_dropout(x, mask, p)
+            keep = (out != 0).to(dtype)
+            self.assertEqual(out, softmax * keep / (1 - p))
+            grad = torch.randn_like(out)
+            out.backward(grad)
+            x_ref = scores.clone().requires_grad_()
+            ref = torch.softmax(x_ref.masked_fill(bool_mask, -float('inf')), -1)
+            (torch.where(bool_mask, torch.zeros_like(ref), ref) * keep / (1 - p)).backward(grad)
+            self.assertEqual(x.grad, x_ref.grad.masked_fill(bool_mask, 0))
+
     def _ordered_sequence(self, tensor_type):
         """Create ordered list of random sequences"""
         seqs = [tensor_type(random.randint(1, 6))
@@ -8857,6 +9119,72 @@ class TestNNDeviceType(NNTestCase):
         offset[-1] = 100
         self.assertRaises(ValueError, lambda: es(input.view(-1), offset))
 
+    @onlyCPU
+    @dtypes(torch.float, torch.double)
+    def test_embedding_bag_many_bags(self, device, dtype):
+        # Enough bags of different (and zero) lengths to be split between
+        # threads, with more rows in a bag than the kernels prefetch ahead.
+        num_weights, D = 1000, 37
+        lengths = torch.randint(0, 40, (300,))
+        lengths[::7] = 0
+        offsets = torch.cat([torch.zeros(1, dtype=torch.long), lengths.cumsum(0)[:-1]])
+        input = torch.randint(0, num_weights, (int(lengths.sum()),))
+        # a transposed weight takes the path for non-contiguous rows
+        for weight in (torch.randn(num_weights, D, dtype=dtype),
+                       torch.randn(D, num_weights, dtype=dtype).t()):
+            for mode in ('sum', 'mean', 'max'):
+                output = F.embedding_bag(input, weight, offsets, mode=mode)
+                bags = []
+                for offset, length in zip(offsets.tolist(), lengths.tolist()):
+                    rows = weight[input[offset:offset + length]]
+                    if length == 0:
+                        bags.append(torch.zeros(D, dtype=dtype))
+                    elif mode == 'sum':
+                        bags.append(rows.sum(0))
+                    elif mode == 'mean':
+                        bags.append(rows.mean(0))
+                    else:
+                        bags.append(rows.max(0)[0])
+                self.assertEqual(output, torch.stack(bags), prec=dtype2prec[dtype])
+
+        for mode in ('sum', 'mean'):
+            weight = torch.randn(num_weights, D, dtype=dtype, requires_grad=True)
+            sparse_weight = weight.detach().requires_grad_()
+            grad = torch.randn(len(offsets), D, dtype=dtype)
+            F.embedding_bag(input, weight, offsets, mode=mode).backward(grad)
+            F.embedding_bag(input, sparse_weight, offsets, mode=mode,
+                            sparse=True).backward(grad)
+            self.assertTrue(sparse_weight.grad.is_coalesced())
+            self.assertEqual(sparse_weight.grad._nnz(), input.unique().numel())
+            self.assertEqual(sparse_weight.grad.to_dense(), weight.grad,
+                             prec=dtype2prec[dtype])
+
+    @dtypes(torch.float, torch.double)
+    def test_segment_reduce(self, device, dtype):
+        num_weights, D = 50, 7
+        lengths = torch.tensor([3, 0, 1, 4, 2], dtype=torch.int32, device=device)
+        offsets = torch.cat([lengths.new_zeros(1), lengths.cumsum(0)[:-1].int()])
+        indices = torch.randint(0, num_weights, (int(lengths.sum()),),
+                                dtype=torch.int32, device=device)
+        data = torch.randn(num_weights, D, dtype=dtype, device=device)
+        weights = torch.randn(indices.numel(), dtype=dtype, device=device)
+        for mode, name in enumerate(('sum', 'mean', 'max')):
+            expected = F.embedding_bag(indices.long(), data, offsets.long(), mode=name)
+            self.assertEqual(torch.segment_reduce(data, indices, offsets, mode), expected)
+            self.assertEqual(torch.sparse_lengths_reduce(data, indices, lengths, mode), expected)
+        expected = F.embedding_bag(indices.long(), data, offsets.long(), mode='sum',
+                                   per_sample_weights=weights)
+        self.assertEqual(torch.sparse_lengths_reduce(data, indices, lengths, 0, weights), expected)
+
+        data.requires_grad_()
+        torch.sparse_lengths_reduce(data, indices, lengths, 1).sum().backward()
+        self.assertEqual(data.grad.sum(), (lengths > 0).sum().to(dtype) * D)
+
+        with self.assertRaisesRegex(RuntimeError, "lengths must sum"):
+            torch.sparse_lengths_reduce(data, indices, lengths[:-1])
+        with self.assertRaisesRegex(RuntimeError, "only supported with the sum mode"):
+            torch.segment_reduce(data, indices, offsets, 1, weights)
+
     @dtypesIfCUDA(torch.half, torch.float, torch.double)
     @dtypes(torch.float, torch.double)
     def test_embedding_bag_device(self, device, dtype):
@@ -138,6 +138,60 @@ class TestQuantizedOps(TestCase):
             qY_hat = op(qX)
             self.assertEqual(qY, qY_hat, message="{} relu failed".format(name))
 
+    """Tests the correctness of the quantized sigmoid, leaky_relu and hardswish
+    ops, which map every quantized value through a lookup table."""
+    @given(X=hu.tensor(shapes=hu.array_shapes(1, 5, 1, 5),
+                       qparams=hu.qparams(dtypes=[torch.quint8, torch.qint8])))
+    def test_qelementwise_lut(self, X):
+        X, (scale, zero_point, torch_type) = X
+        X = torch.from_numpy(X)
+        qX = torch.quantize_per_tensor(X, scale=scale, zero_point=zero_point,
+                                       dtype=torch_type)
+        dqX = qX.dequantize()
+
+        sigmoid_zero_point = 0 if torch_type == torch.quint8 else -128
+        ops_under_test = [
+            ('sigmoid', lambda qx: torch.sigmoid(qx),
+             torch.sigmoid(dqX), 1.0 / 256, sigmoid_zero_point),
+            ('leaky_relu', lambda qx: F.leaky_relu(qx, 0.1),
+             F.leaky_relu(dqX, 0.1), scale, zero_point),
+            ('hardswish',
+             lambda qx: torch.ops.quantized.hardswish(qx, 0.05, 10),
+             dqX * F.relu6(dqX + 3) / 6, 0.05, 10),
+        ]
+        for name, op, Y, Y_scale, Y_zero_point in ops_under_test:
+            qY = torch.quantize_per_tensor(Y, scale=Y_scale, zero_point=Y_zero_point,
+                                           dtype=torch_type)
+            qY_hat = op(qX)
+            self.assertEqual(qY_hat.q_scale(), Y_scale)
+            self.assertEqual(qY_hat.q_zero_point(), Y_zero_point)
+            # Allow for a different rounding of values halfway between two
+            # quantized values.
+            self.assertEqual(qY.int_repr(), qY_hat.int_repr(), prec=1,
+                             message="{} failed".format(name))
+
+    """Tests the correctness of the quantized::batch_norm op."""
+    @given(X=hu.tensor(shapes=hu.array_shapes(2, 4, 1, 5),
+                       qparams=hu.qparams(dtypes=[torch.quint8, torch.qint8])),
+           use_affine=st.booleans())
+    def test_qbatch_norm(self, X, use_affine):
+        X, (scale, zero_point, torch_type) = X
+        X = torch.from_numpy(X)
+        C = X.size(1)
+        mean = torch.randn(C)
+        var = torch.rand(C) + 0.1
+        weight = torch.randn(C) if use_affine else None
+        bias = torch.randn(C) if use_affine else None
+        qX = torch.quantize_per_tensor(X, scale=scale, zero_point=zero_point,
+                                       dtype=torch_type)
+        Y = F.batch_norm(qX.dequantize(), mean, var, weight, bias, eps=1e-5)
+        Y_scale, Y_zero_point = _calculate_dynamic_qparams(Y, torch_type)
+        qY = torch.quantize_per_tensor(Y, scale=Y_scale, zero_point=Y_zero_point,
+                                       dtype=torch_type)
+        qY_hat = torch.ops.quantized.batch_norm(
+            qX, weight, bias, mean, var, 1e-5, Y_scale, Y_zero_point)
+        self.assertEqual(qY.int_repr(), qY_hat.int_repr(), prec=1)
+
     """Tests the correctness of the scalar addition."""
     @no_deadline
     @given(A=hu.tensor(shapes=hu.array_shapes(1, 4, 1, 5),
@@ -979,6 +1033,111 @@ class TestQuantizedOps(TestCase):
         self.assertEqual(qX.equal(qX2), equal_ref(qX, qX2))
 
 
+class TestQuantizedEmbeddingBag(TestCase):
+    def _test_embedding_bag(self, bits, num_embeddings, embedding_dim,
+                            num_offsets, mode, per_sample_weights, index_dtype):
+        prepack = {8: torch.ops.quantized.embedding_bag_byte_prepack,
+                   4: torch.ops.quantized.embedding_bag_4bit_prepack}[bits]
+        unpack = {8: torch.ops.quantized.embedding_bag_byte_unpack,
+                  4: torch.ops.quantized.embedding_bag_4bit_unpack}[bits]
+        embedding_bag = {8: torch.ops.quantized.embedding_bag_byte,
+                         4: torch.ops.quantized.embedding_bag_4bit}[bits]
+
+        weight = torch.randn(num_embeddings, embedding_dim)
+        packed = prepack(weight)
+        dequantized = unpack(packed)
+        self.assertEqual(dequantized.size(), weight.size())
+        # Every value is at most half a quantization step away.
+        step = (weight.max(1, keepdim=True)[0] - weight.min(1, keepdim=True)[0]) / (2 ** bits - 1)
+        self.assertTrue(((dequantized - weight).abs() <= step / 2 + 1e-2).all())
+
+        indices = torch.randint(0, num_embeddings, (3 * num_offsets,), dtype=index_dtype)
+        offsets = torch.sort(torch.randint(0, indices.numel() + 1, (num_offsets,)))[0]
+        offsets[0] = 0
+        weights = torch.rand(indices.numel()) if per_sample_weights else None
+
+        result = embedding_bag(packed, indices, offsets, mode, weights)
+        expected = F.embedding_bag(indices.long(), dequantized, offsets,
+                                   mode=['sum', 'mean'][mode],
+                                   per_sample_weights=weights)
+        self.assertEqual(result, expected, prec=1e-4)
+
+    @given(num_embeddings=st.integers(1, 20),
+           embedding_dim=st.integers(1, 32),
+           num_offsets=st.integers(1, 10),
+           mode=st.sampled_from([0, 1]),
+           per_sample_weights=st.booleans(),
+           index_dtype=st.sampled_from([torch.int32, torch.int64]))
+    def test_embedding_bag_byte(self, num_embeddings, embedding_dim,
+                                num_offsets, mode, per_sample_weights,
+                                index_dtype):
+        assume(mode == 0 or not per_sample_weights)
+        self._test_embedding_bag(8, num_embeddings, embedding_dim, num_offsets,
+                                 mode, per_sample_weights, index_dtype)
+
+    @given(num_embeddings=st.integers(1, 20),
+           embedding_dim=st.integers(1, 16).map(lambda d: 2 * d),
+           num_offsets=st.integers(1, 10),
+           mode=st.sampled_from([0, 1]),
+           per_sample_weights=st.booleans(),
+           index_dtype=st.sampled_from([torch.int32, torch.int64]))
+    def test_embedding_bag_4bit(self, num_embeddings, embedding_dim,
+                                num_offsets, mode, per_sample_weights,
+                                index_dtype):
+        assume(mode == 0 or not per_sample_weights)
+        self._test_embedding_bag(4, num_embeddings, embedding_dim, num_offsets,
+                                 mode, per_sample_weights, index_dtype)
+
+    @given(bits=st.sampled_from([8, 4]),
+           num_embeddings=st.integers(1, 20),
+           embedding_dim=st.integers(1, 16).map(lambda d: 2 * d),
+           half_output=st.booleans(),
+           index_dtype=st.sampled_from([torch.int32, torch.int64]))
+    def test_embedding_lookup(self, bits, num_embeddings, embedding_dim,
+                              half_output, index_dtype):
+        prepack = {8: torch.ops.quantized.embedding_bag_byte_prepack,
+                   4: torch.ops.quantized.embedding_bag_4bit_prepack}[bits]
+        unpack = {8: torch.ops.quantized.embedding_bag_byte_unpack,
+                  4: torch.ops.quantized.embedding_bag_4bit_unpack}[bits]
+        lookup = {8: torch.ops.quantized.embedding_byte,
+                  4: torch.ops.quantized.embedding_4bit}[bits]
+
+        packed = prepack(torch.randn(num_embeddings, embedding_dim))
+        indices = torch.randint(0, num_embeddings, (3, 5), dtype=index_dtype)
+        result = lookup(packed, indices, half_output)
+        expected = F.embedding(indices.long(), unpack(packed))
+        self.assertEqual(result.dtype, torch.half if half_output else torch.float)
+        self.assertEqual(result.size(), (3, 5, embedding_dim))
+        self.assertEqual(result.float(), expected, prec=1e-2 if half_output else 1e-5)
+
+        with self.assertRaisesRegex(RuntimeError, "indices must be in"):
+            lookup(packed, torch.tensor([num_embeddings]))
+
+    def test_embedding_bag_errors(self):
+        packed = torch.ops.quantized.embedding_bag_byte_prepack(torch.randn(4, 3))
+        with self.assertRaisesRegex(RuntimeError, "out of bounds"):
+            torch.ops.quantized.embedding_bag_byte(
+                packed, torch.tensor([0, 4]), torch.tensor([0]))
+        with self.assertRaisesRegex(RuntimeError, "only supported for mode='sum'"):
+            torch.ops.quantized.embedding_bag_byte(
+                packed, torch.tensor([0, 1]), torch.tensor([0]), 1,
+                torch.ones(2))
+        with self.assertRaisesRegex(RuntimeError, "even embedding dimension"):
+            torch.ops.quantized.embedding_bag_4bit_prepack(torch.randn(4, 3))
+
+    def test_embedding_bag_script(self):
+        @torch.jit.script
+        def lookup(packed, indices, offsets):
+            return torch.ops.quantized.embedding_bag_byte(packed, indices, offsets, 1)
+
+        weight = torch.randn(10, 8)
+        packed = torch.ops.quantized.embedding_bag_byte_prepack(weight)
+        indices = torch.tensor([1, 2, 4, 5, 4, 3, 2, 9])
+        offsets = torch.tensor([0, 4])
+        self.assertEqual(lookup(packed, indices, offsets),
+                         torch.ops.quantized.embedding_bag_byte(packed, indices, offsets, 1))
+
+
 @unittest.skipUnless('fbgemm' in torch.backends.quantized.supported_engines,
                      " Quantized operations require FBGEMM. FBGEMM is only optimized for CPUs"
                      " with instruction set support avx2 or newer.")
@@ -1527,6 +1686,54 @@ class TestQNNPackOps(TestCase):
             qY = torch.quantize_per_tensor(Y, scale=scale, zero_point=zero_point, dtype=torch_type)
             self.assertEqual(qY, qY_hat)
 
+    """Tests the correctness of the quantized::sigmoid (qnnpack) op."""
+    @given(X=hu.tensor(shapes=hu.array_shapes(1, 5, 1, 5),
+                       qparams=hu.qparams(dtypes=torch.quint8)))
+    def test_qnnpack_sigmoid(self, X):
+        with override_quantized_engine('qnnpack'):
+            X, (scale, zero_point, torch_type) = X
+            X = torch.from_numpy(X)
+            qX = torch.quantize_per_tensor(X, scale=scale, zero_point=zero_point, dtype=torch_type)
+            qY_hat = torch.sigmoid(qX)
+            qY = torch.quantize_per_tensor(torch.sigmoid(qX.dequantize()), scale=1.0 / 256,
+                                           zero_point=0, dtype=torch_type)
+            self.assertEqual(qY.int_repr(), qY_hat.int_repr(), prec=1)
+
+    """Tests the correctness of the quantized::conv_transpose2d (qnnpack) op."""
+    @given(batch_size=st.integers(1, 3),
+           groups=st.integers(1, 2),
+           in_channels_per_group=st.integers(1, 8),
+           out_channels_per_group=st.integers(1, 8),
+           height=st.integers(2, 8),
+           width=st.integers(2, 8),
+           kernel=st.integers(1, 3),
+           stride=st.integers(1, 2),
+           padding=st.integers(0, 1),
+           use_bias=st.booleans())
+    def test_qnnpack_conv_transpose2d(self, batch_size, groups, in_channels_per_group,
+                                      out_channels_per_group, height, width, kernel,
+                                      stride, padding, use_bias):
+        with override_quantized_engine('qnnpack'):
+            in_channels = in_channels_per_group * groups
+            X = torch.rand(batch_size, in_channels, height, width)
+            W = torch.randn(in_channels, out_channels_per_group, kernel, kernel)
+            b = torch.randn(out_channels_per_group * groups) if use_bias else None
+            qX = torch.quantize_per_tensor(X, scale=1.0 / 255, zero_point=0, dtype=torch.quint8)
+            W_scale, W_zp = _calculate_dynamic_qparams(W, torch.qint8)
+            qW = torch.quantize_per_tensor(W, scale=W_scale, zero_point=W_zp, dtype=torch.qint8)
+
+            Y = F.conv_transpose2d(qX.dequantize(), qW.dequantize(), b, stride=stride,
+                                   padding=padding, groups=groups)
+            Y_scale, Y_zp = _calculate_dynamic_qparams(Y, torch.quint8)
+            # QNNPACK requires the input and weight scales to be smaller than
+            # the output scale.
+            assume(qX.q_scale() * qW.q_scale() < Y_scale)
+            qY = torch.quantize_per_tensor(Y, scale=Y_scale, zero_point=Y_zp, dtype=torch.quint8)
+            qY_hat = torch.ops.quantized.conv_transpose2d(
+                qX, qW, b, [stride, stride], [padding, padding], [0, 0], [1, 1],
+                groups, Y_scale, Y_zp)
+            self.assertEqual(qY.int_repr(), qY_hat.int_repr(), prec=1)
+
     """Tests the correctness of the quantized::add (qnnpack) op."""
     @settings(suppress_health_check=(HealthCheck.filter_too_much,))
     @given(A=hu.tensor(shapes=hu.array_shapes(1, 5, 1, 5),
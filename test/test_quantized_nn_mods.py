@@ -197,6 +197,33 @@ class DynamicModuleAPITest(QuantizationTestCase):
         # Smoke test extra_repr
         self.assertTrue('QuantizedLinear' in str(quantized_float_linear))
 
+    @unittest.skipUnless('fbgemm' in torch.backends.quantized.supported_engines,
+                         " Quantized operations require FBGEMM. FBGEMM is only optimized for CPUs"
+                         " with instruction set support avx2 or newer.")
+    def test_linear_per_channel_relu_api(self):
+        """test per channel weights and fused ReLU for nn.quantized.dynamic.Linear"""
+        X = torch.randn(4, 16)
+        for fuse_relu in [False, True]:
+            float_linear = torch.nn.Linear(16, 8)
+            if fuse_relu:
+                float_module = torch.nn.intrinsic.LinearReLU(float_linear, torch.nn.ReLU())
+                qlinear_cls = nnqd.LinearReLU
+                qlinear_op = torch.ops.quantized.linear_relu_dynamic
+            else:
+                float_module = float_linear
+                qlinear_cls = nnqd.Linear
+                qlinear_op = torch.ops.quantized.linear_dynamic
+            float_module.qconfig = torch.quantization.per_channel_dynamic_qconfig
+            prepare_dynamic(float_module)
+            Z_ref = float_module(X)
+            qlinear = qlinear_cls.from_float(float_module)
+            self.assertEqual(qlinear.weight().qscheme(), torch.per_channel_affine)
+            Z_dq = qlinear(X)
+            self.assertEqual(Z_dq, Z_ref, prec=0.1)
+            if fuse_relu:
+                self.assertTrue((Z_dq >= 0).all())
+            self.assertEqual(Z_dq, qlinear_op(X, qlinear._packed_params))
+
 
 class ModuleAPITest(QuantizationTestCase):
     def test_relu(self):
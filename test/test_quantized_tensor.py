@@ -147,6 +147,27 @@ class TestQuantizedTensor(TestCase):
         self.assertTrue(np.allclose(qr.int_repr(), quantize_c(r, scales, zero_points)))
         self.assertTrue(np.allclose(r.numpy(), rqr.numpy(), atol=2 / np.min(scales.numpy())))
 
+    def test_qtensor_quantize_per_channel_4d(self):
+        r = torch.rand(2, 17, 5, 3, dtype=torch.float) * 4 - 2
+        scales = torch.rand(17, dtype=torch.double) * 0.02 + 0.01
+        zero_points = torch.randint(-5, 5, (17,), dtype=torch.long)
+        s = scales.numpy().reshape(1, 17, 1, 1)
+        z = zero_points.numpy().reshape(1, 17, 1, 1)
+        for dtype, quant_min, quant_max in [(torch.quint8, 0, 255),
+                                            (torch.qint8, -128, 127),
+                                            (torch.qint32, -2 ** 31, 2 ** 31 - 1)]:
+            zp = zero_points + (10 if dtype == torch.quint8 else 0)
+            zn = z + (10 if dtype == torch.quint8 else 0)
+            ref = np.clip(np.round(r.numpy() / s) + zn, quant_min, quant_max)
+            for memory_format in [torch.contiguous_format, torch.channels_last]:
+                x = r.contiguous(memory_format=memory_format)
+                qx = torch.quantize_per_channel(x, scales, zp, 1, dtype)
+                self.assertTrue(qx.is_contiguous(memory_format=memory_format))
+                self.assertTrue(np.allclose(qx.int_repr().numpy(), ref))
+                rqx = qx.dequantize()
+                self.assertTrue(rqx.is_contiguous(memory_format=memory_format))
+                self.assertTrue(np.allclose(rqx.numpy(), (ref - zn) * s, atol=1e-6))
+
     def test_qtensor_permute(self):
         r = torch.rand(10, 30, 2, 2, dtype=torch.float) * 4 - 2
         scale = 0.02
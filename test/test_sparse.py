@@ -902,6 +902,22 @@ class TestSparse(TestCase):
         test_shape(10, 100, 0, 0)
         test_shape(10, 100, 0, 20)
 
+    def test_mm_coalesced_reuse(self):
+        x = self._gen_sparse(2, 20, [10, 100])[0].coalesce()
+        # the CSR form computed by the first product is reused by the next ones,
+        # a single column takes the matrix-vector path
+        for dk in [1, 30]:
+            y = torch.randn(100, dk, device=self.device)
+            for _ in range(2):
+                self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
+        # changing the indices drops the cached CSR form
+        other = self._gen_sparse(2, 20, [10, 100])[0].coalesce()
+        x.add_(other)
+        self.assertTrue(x.is_coalesced())
+        y = torch.randn(100, 30, device=self.device)
+        self.assertEqual(torch.mm(x, y), torch.mm(self.safeToDense(x), y))
+
     @cpu_only
     def test_saddmm(self):
         def test_shape(di, dj, dk, nnz):
@@ -1509,6 +1525,28 @@ class TestSparse(TestCase):
 
         self.assertFalse(z._indices().numel() != 2 and z.is_coalesced())
 
+    @cpu_only
+    def test_coalesce_add_large(self):
+        # enough entries to be coalesced and added by several threads
+        def gen(nnz):
+            i = torch.randint(0, 1000, (2, nnz), device=self.device)
+            v = torch.randn(nnz, 3, dtype=self.value_dtype, device=self.device)
+            return self.sparse_tensor(i, v, torch.Size([1000, 1000, 3]))
+
+        x = gen(200000)
+        y = x.coalesce()
+        self.assertTrue(y.is_coalesced())
+        flat = y._indices()[0] * 1000 + y._indices()[1]
+        self.assertTrue((flat[1:] > flat[:-1]).all())
+        self.assertEqual(y.to_dense(), x.to_dense())
+
+        z = gen(50000).coalesce()
+        for a, b in [(y, z), (z, y)]:
+            r = a + b
+            self.assertTrue(r.is_coalesced())
+            self.assertEqual(r._nnz(), r.coalesce()._nnz())
+            self.assertEqual(r.to_dense(), a.to_dense() + b.to_dense())
+
     @cuda_only
     def test_storage_not_null(self):
         x = torch.cuda.sparse.FloatTensor(2)
@@ -1,5 +1,9 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
 
+import json
+import os
+import tempfile
+
 import torch
 from torch.utils import ThroughputBenchmark
 from torch.testing import assert_allclose
@@ -68,6 +72,56 @@ class TestThroughputBenchmark(TestCase):
         print(stats)
 
 
+    def make_bench(self, Module):
+        module = Module(10, 5, 15)
+        bench = ThroughputBenchmark(module)
+        bench.add_input(torch.randn(8, 10), torch.randn(8, 10))
+        return bench
+
+    def check_stats(self, stats, num_iters):
+        self.assertEqual(stats.num_iters, num_iters)
+        self.assertGreater(stats.latency_p50_ms, 0)
+        self.assertLessEqual(stats.latency_p50_ms, stats.latency_p90_ms)
+        self.assertLessEqual(stats.latency_p90_ms, stats.latency_p99_ms)
+        self.assertLessEqual(stats.latency_p99_ms, stats.latency_p999_ms)
+        self.assertGreater(stats.total_time_seconds, 0)
+
+    def test_percentiles_and_json(self):
+        bench = self.make_bench(TwoLayerNet)
+        stats = bench.benchmark(num_calling_threads=2, num_warmup_iters=10, num_iters=200)
+        self.check_stats(stats, 200)
+        if stats.thread_cpu_time_ms:
+            self.assertEqual(len(stats.thread_cpu_time_ms), 2)
+
+        fd, path = tempfile.mkstemp(suffix='.json')
+        os.close(fd)
+        try:
+            dumped = stats.to_json(path)
+            with open(path) as f:
+                result = json.load(f)
+        finally:
+            os.remove(path)
+        self.assertEqual(result, json.loads(dumped))
+        self.assertEqual(result['num_iters'], 200)
+        self.assertEqual(result['config']['num_calling_threads'], 2)
+        self.assertEqual(result['latency_p99_ms'], stats.latency_p99_ms)
+
+    def test_open_loop(self):
+        bench = self.make_bench(TwoLayerNet)
+        stats = bench.benchmark(num_calling_threads=2, num_warmup_iters=10, num_iters=100,
+                                target_qps=1000.)
+        self.check_stats(stats, 100)
+        # the arrivals of 100 requests at 1000 qps take about 0.1s
+        self.assertGreater(stats.total_time_seconds, 0.02)
+
+    def test_benchmark_concurrently(self):
+        benches = [self.make_bench(TwoLayerNet), self.make_bench(TwoLayerNetModule)]
+        results = ThroughputBenchmark.benchmark_concurrently(
+            benches, num_calling_threads=2, num_warmup_iters=10, num_iters=100)
+        self.assertEqual(len(results), 2)
+        for stats in results:
+            self.check_stats(stats, 100)
+
     def test_script_module(self):
         self.linear_test(TwoLayerNet)
 
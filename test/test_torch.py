@@ -790,6 +790,55 @@ class _TestTorchMixin(object):
         _test_mv(torch.randint(0, 100, (100, 100), dtype=torch.int64), torch.randint(0, 100, (100, ), dtype=torch.int64))
         _test_mv(torch.randn(100, 100, dtype=torch.float32).bfloat16(), torch.randn(100, dtype=torch.float32).bfloat16())
 
+    def test_bfloat16_cpu_kernels(self):
+        # 1027 elements cover both the vectorized loop and its tail
+        x = torch.randn(1027).bfloat16()
+        y = torch.randn(1027).bfloat16()
+        pos = x.abs() + 0.5
+
+        def check(bf16_res, float_res, prec=1e-2):
+            # relative to the result, bfloat16 keeps 8 significant bits
+            self.assertEqual(bf16_res.dtype, torch.bfloat16)
+            err = (bf16_res.float() - float_res).abs() / float_res.abs().clamp(min=1)
+            self.assertLessEqual(err.max().item(), prec)
+
+        check(x + y, x.float() + y.float())
+        check(torch.add(x, y, alpha=2), x.float() + 2 * y.float())
+        check(x * y, x.float() * y.float())
+        check(x / pos, x.float() / pos.float())
+        check(x.abs(), x.float().abs())
+        check(x.neg(), x.float().neg())
+        check(x.frac(), x.float().frac())
+        check(x.clamp(-0.5, 0.5), x.float().clamp(-0.5, 0.5))
+        check(x.sigmoid(), x.float().sigmoid())
+        check(pos.reciprocal(), pos.float().reciprocal())
+        check(pos.rsqrt(), pos.float().rsqrt())
+        for op in ['exp', 'tanh', 'sin', 'cos', 'floor', 'ceil', 'trunc', 'erf']:
+            check(getattr(x, op)(), getattr(x.float(), op)(), 2e-2)
+        for op in ['log', 'sqrt', 'log2', 'log1p']:
+            check(getattr(pos, op)(), getattr(pos.float(), op)(), 2e-2)
+
+        m = torch.randn(37, 67).bfloat16()
+        check(m.sum(1), m.float().sum(1), 0.1)
+        check(m[:, :4].prod(1), m[:, :4].float().prod(1))
+        check(m.max(1)[0], m.float().max(1)[0])
+        check(m.min(1)[0], m.float().min(1)[0])
+        check(torch.softmax(m, 1), torch.softmax(m.float(), 1))
+        check(torch.log_softmax(m, 1), torch.log_softmax(m.float(), 1), 5e-2)
+
+        ln = torch.nn.LayerNorm(67)
+        check(torch.layer_norm(m, (67,), ln.weight.bfloat16(), ln.bias.bfloat16()),
+              torch.layer_norm(m.float(), (67,), ln.weight, ln.bias), 5e-2)
+
+        # the products accumulate in float, the result is rounded once
+        a = torch.randn(31, 130).bfloat16()
+        b = torch.randn(130, 19).bfloat16()
+        c = torch.randn(31, 19).bfloat16()
+        check(a.mm(b), a.float().mm(b.float()), 0.1)
+        check(a.t().t().mm(b.t().contiguous().t()), a.float().mm(b.float()), 0.1)
+        check(torch.addmm(c, a, b, beta=0.5, alpha=2),
+              torch.addmm(c.float(), a.float(), b.float(), beta=0.5, alpha=2), 0.2)
+
     def test_numpy_args(self):
         x1 = torch.randn(10)
         x2 = torch.randn(10)
@@ -1478,6 +1527,54 @@ class _TestTorchMixin(object):
                 n_astensor[0][2] = 250.9
                 self.assertNotEqual(torch.tensor(n, device='cuda'), n_astensor)
 
+    def test_as_tensor_buffer(self):
+        import array
+
+        # the dtype is inferred from the items, as for sequences
+        b = bytearray([1, 2, 250])
+        self.assertEqual(torch.tensor(b), torch.tensor([1, 2, 250]))
+        self.assertEqual(torch.tensor(b).dtype, torch.int64)
+        a = array.array('f', [1.5, -2, 3])
+        self.assertEqual(torch.tensor(a).dtype, torch.get_default_dtype())
+        self.assertEqual(torch.tensor(a), torch.tensor([1.5, -2, 3]))
+
+        # doesn't copy with the dtype of the buffer
+        t = torch.as_tensor(b, dtype=torch.uint8)
+        t[0] = 7
+        self.assertEqual(b[0], 7)
+        t = torch.as_tensor(a, dtype=torch.float32)
+        t[1] = 4
+        self.assertEqual(a[1], 4)
+        t = torch.as_tensor(memoryview(a)[::2], dtype=torch.float32)
+        self.assertEqual(t, torch.tensor([1.5, 3]))
+        t[1] = 5
+        self.assertEqual(a[2], 5)
+
+        # torch.tensor and other dtypes copy
+        t = torch.tensor(a, dtype=torch.float32)
+        t[0] = 0
+        self.assertEqual(a[0], 1.5)
+        t = torch.as_tensor(array.array('i', [1, 2, 3]), dtype=torch.float64)
+        self.assertEqual(t, torch.tensor([1., 2., 3.], dtype=torch.float64))
+
+        if TEST_NUMPY:
+            n = np.random.rand(4, 5, 6)
+            self.assertEqual(torch.as_tensor(memoryview(n), dtype=torch.float64), torch.from_numpy(n))
+            self.assertEqual(torch.tensor(memoryview(n[:, 1])), torch.from_numpy(n[:, 1]).float())
+
+    @unittest.skipIf(not TEST_NUMPY, "Numpy not found")
+    def test_tensor_from_list_of_ndarrays(self):
+        arrays = [np.random.rand(3, 4) for _ in range(5)]
+        self.assertEqual(torch.tensor(arrays), torch.from_numpy(np.stack(arrays)).float())
+        self.assertEqual(torch.tensor(arrays, dtype=torch.float64), torch.from_numpy(np.stack(arrays)))
+        ints = [[np.arange(4, dtype=np.int32) + i, np.arange(4, dtype=np.int32)] for i in range(3)]
+        self.assertEqual(torch.tensor(ints), torch.from_numpy(np.array(ints)))
+        self.assertEqual(torch.tensor(ints).dtype, torch.int32)
+        # arrays of other shapes are still stored element by element
+        self.assertEqual(torch.tensor([np.arange(2), [2, 3]]), torch.tensor([[0, 1], [2, 3]]))
+        with self.assertRaisesRegex(ValueError, "expected sequence of length"):
+            torch.tensor([np.arange(2), np.arange(3)])
+
     def test_renorm(self):
         m1 = torch.randn(10, 5)
         res1 = torch.Tensor()
@@ -1863,6 +1960,43 @@ class _TestTorchMixin(object):
         self.assertIsOrdered('descending', x, res2val, res2ind,
                              'random with NaNs')
 
+    def test_sort_large_slices(self):
+        # slices long enough to take the radix sort path on CPU, sorted along
+        # a non-contiguous dimension
+        for dtype in [torch.uint8, torch.int8, torch.int16, torch.int32,
+                      torch.int64, torch.float, torch.double]:
+            x = torch.randint(-100, 100, (3, 2000)).to(dtype)
+            if dtype.is_floating_point:
+                x = x / 7
+                x[0][5] = float('NaN')
+                x[2][1000] = float('inf')
+                x[1][17] = float('-inf')
+            for descending in (False, True):
+                xt = x.t()
+                val, ind = xt.sort(0, descending)
+                self.assertEqual(xt.gather(0, ind), val, 0)
+                for j in range(x.size(0)):
+                    col = val[:, j]
+                    col = col[col == col]
+                    if descending:
+                        self.assertTrue((col[:-1] >= col[1:]).all())
+                    else:
+                        self.assertTrue((col[:-1] <= col[1:]).all())
+                    self.assertEqual(ind[:, j].sort()[0], torch.arange(x.size(1)), 0)
+            if dtype.is_floating_point:
+                self.assertTrue(math.isnan(x.sort(1)[0][0][-1]))
+                self.assertTrue(math.isnan(x.sort(1, True)[0][0][0]))
+
+    def test_topk_small_k(self):
+        # k * 64 <= n selects the bounded heap path on CPU
+        x = torch.randn(4, 1000)
+        x[1][10] = float('NaN')
+        for largest in (True, False):
+            val, ind = x.topk(5, 1, largest, True)
+            sval, sind = x.sort(1, largest)
+            self.assertEqual(val, sval[:, :5], 0)
+            self.assertEqual(x.gather(1, ind), val, 0)
+
     def test_topk(self):
         def topKViaSort(t, k, dim, dir):
             sorted, indices = t.sort(dim, dir)
@@ -2261,6 +2395,35 @@ class _TestTorchMixin(object):
     def test_fft_ifft_rfft_irfft(self):
         self._test_fft_ifft_rfft_irfft(self)
 
+    @unittest.skipIf(not TEST_MKL, "PyTorch is built without MKL support")
+    def test_mkl_fft_plan_cache(self):
+        cache = torch.backends.mkl.fft_plan_cache
+        max_size = cache.max_size
+        try:
+            cache.clear()
+            self.assertEqual(cache.size, 0)
+            x = torch.randn(4, 16, dtype=torch.double)
+            expected = x.rfft(1)
+            # the same geometry reuses the descriptor of the first call
+            self.assertEqual(x.rfft(1), expected)
+            self.assertEqual(cache.size, 1)
+            x.rfft(1, normalized=True)
+            x.rfft(2)
+            self.assertEqual(cache.size, 3)
+
+            # shrinking evicts the least recently used descriptors
+            cache.max_size = 1
+            self.assertEqual(cache.size, 1)
+            self.assertEqual(x.rfft(1), expected)
+            cache.max_size = 0
+            self.assertEqual(cache.size, 0)
+            self.assertEqual(x.rfft(1), expected)
+            self.assertEqual(cache.size, 0)
+            with self.assertRaisesRegex(RuntimeError, "must be non-negative"):
+                cache.max_size = -1
+        finally:
+            cache.max_size = max_size
+
     @unittest.skip("Not implemented yet")
     def test_conv2(self):
         x = torch.rand(math.floor(torch.uniform(50, 100)), math.floor(torch.uniform(50, 100)))
@@ -2608,6 +2771,16 @@ class _TestTorchMixin(object):
             dest2[idx[i]] = dest2[idx[i]] + src[i]
         self.assertEqual(dest, dest2)
 
+        # duplicate indices, non-contiguous tensors and an inner dimension
+        dest = torch.randn(4, 5, 6).transpose(0, 2)
+        src = torch.randn(6, 10, 4)[:, ::2]
+        idx = torch.LongTensor([0, 2, 0, 3])
+        dest2 = dest.clone()
+        dest.index_add_(2, idx, src)
+        for i in range(idx.size(0)):
+            dest2[:, :, idx[i]] += src[:, :, i]
+        self.assertEqual(dest, dest2)
+
     def test_t(self):
         # Test 0D tensors
         x = torch.randn(())
@@ -3514,6 +3687,56 @@ class _TestTorchMixin(object):
         self.assertEqual(v.storage()[0], v.data[0][0])
         self.assertEqual(v.storage()[14], v.data[2][4])
 
+    def test_arg_parser_overload_cache(self):
+        torch._C._reset_arg_parser_stats()
+        x = torch.ones(3)
+        y = torch.full((3,), 2.)
+        # alternate between overloads with the same argument types, where
+        # some of them are told apart by the values of the arguments only
+        for _ in range(3):
+            self.assertEqual(x.add(y), torch.full((3,), 3.))
+            self.assertEqual(x.add(2), torch.full((3,), 3.))
+            self.assertEqual(x.add(torch.tensor(2.)), torch.full((3,), 3.))
+            self.assertEqual(x.add(y, alpha=2), torch.full((3,), 5.))
+            self.assertEqual(torch.pow(2, y), torch.full((3,), 4.))
+            self.assertEqual(torch.pow(y, torch.tensor(3.)), torch.full((3,), 8.))
+            self.assertEqual(torch.pow(y, 2), torch.full((3,), 4.))
+            self.assertEqual(x.view(3, 1).shape, (3, 1))
+            self.assertEqual(x.view((1, 3)).shape, (1, 3))
+        stats = torch._C._get_arg_parser_stats()
+        self.assertTrue(all(len(entry) == 3 for entry in stats))
+        self.assertTrue(any(fast > 0 for _, fast, _ in stats))
+        self.assertGreater(sum(slow for _, _, slow in stats), 0)
+
+    def test_small_storage(self):
+        # tensors of up to 64 bytes keep their data inside the storage object
+        x = torch.tensor([1., 2., 3.])
+        s = x.storage()
+        del x
+        self.assertEqual(s.tolist(), [1., 2., 3.])
+
+        # growing the storage moves the data out of the inline buffer
+        x = torch.arange(4, dtype=torch.float)
+        x.resize_(100)
+        self.assertEqual(x[:4], torch.arange(4, dtype=torch.float))
+        x.fill_(1)
+        self.assertEqual(x.sum(), 100)
+
+        # the data survives moving the storage into shared memory
+        x = torch.tensor([5, 6], dtype=torch.long)
+        y = x[1:]
+        x.share_memory_()
+        self.assertTrue(x.is_shared())
+        x.add_(1)
+        self.assertEqual(y, torch.tensor([7]))
+
+        if TEST_NUMPY:
+            x = torch.tensor(2.5)
+            a = x.numpy()
+            a *= 2
+            self.assertEqual(x.item(), 5.)
+        self.assertEqual(torch.empty(16, dtype=torch.float).fill_(3).sum(), 48)
+
     def test_deepcopy(self):
         from copy import deepcopy
         a = torch.randn(5, 5)
@@ -5334,6 +5557,19 @@ tensor([[[1., 1., 1.,  ..., 1., 1., 1.],
         t2 = torch.from_numpy(t.numpy().transpose())
         self.assertEqual(t1, t2)
 
+    def test_big_permute(self):
+        # every element size, with dimensions that don't divide the tiles
+        for dtype in [torch.uint8, torch.half, torch.int32, torch.float, torch.int64, torch.double]:
+            t = torch.randint(0, 100, (3, 17, 70, 45)).to(dtype)
+            for dims in [(0, 2, 3, 1), (0, 3, 1, 2), (3, 1, 0, 2), (1, 0, 3, 2)]:
+                t1 = t.permute(*dims).contiguous()
+                t2 = torch.from_numpy(t.double().numpy().transpose(dims)).to(dtype)
+                self.assertEqual(t1, t2)
+            # strided views
+            t1 = t[:, ::2].transpose(1, 3).contiguous()
+            t2 = torch.from_numpy(t.double().numpy()[:, ::2].transpose(0, 3, 2, 1)).to(dtype)
+            self.assertEqual(t1, t2)
+
     def test_inplace_division(self):
         t = torch.rand(5, 5)
         id_before = id(t)
@@ -5394,6 +5630,134 @@ tensor([[[1., 1., 1.,  ..., 1., 1., 1.],
     def test_parallel_info(self):
         torch.__config__.parallel_info()
 
+    def test_lazy_clone(self):
+        enabled = torch.is_lazy_clone_enabled()
+        torch.set_lazy_clone_enabled(True)
+        try:
+            # writes to either tensor don't show in the other one
+            x = torch.arange(10.)
+            y = x.clone()
+            y.add_(1)
+            self.assertEqual(x, torch.arange(10.))
+            self.assertEqual(y, torch.arange(1., 11.))
+            x = torch.arange(10.)
+            y = x.clone()
+            x.mul_(2)
+            self.assertEqual(x, torch.arange(0., 20., 2))
+            self.assertEqual(y, torch.arange(10.))
+
+            # the clone of a tensor gone takes its memory
+            x = torch.arange(10.)
+            data_ptr = x.data_ptr()
+            y = x.clone()
+            del x
+            self.assertEqual(y.data_ptr(), data_ptr)
+
+            # so does the tensor of a clone gone
+            x = torch.randn(3, 4).t()
+            data_ptr = x.data_ptr()
+            y = x.clone(memory_format=torch.preserve_format)
+            self.assertEqual(y.stride(), x.stride())
+            del y
+            self.assertEqual(x.data_ptr(), data_ptr)
+
+            # a clone changing the layout copies eagerly
+            x = torch.randn(3, 4).t()
+            y = x.clone()
+            self.assertTrue(y.is_contiguous())
+            self.assertEqual(x, y)
+
+            # clones of clones
+            x = torch.arange(6.)
+            y = x.clone()
+            z = y.clone()
+            z[0] = 5
+            y[1] = 7
+            self.assertEqual(x, torch.arange(6.))
+            self.assertEqual(y.tolist(), [0., 7., 2., 3., 4., 5.])
+            self.assertEqual(z.tolist(), [5., 1., 2., 3., 4., 5.])
+        finally:
+            torch.set_lazy_clone_enabled(enabled)
+
+    def test_bind_to_numa_node_invalid(self):
+        # fails whether or not NUMA is available, without binding the thread
+        with self.assertRaises(RuntimeError):
+            torch.bind_to_numa_node(-1)
+        with self.assertRaises(RuntimeError):
+            torch.bind_to_numa_node(1 << 20)
+
+    def test_metrics(self):
+        import threading
+        import torch.utils.metrics as metrics
+        self.assertTrue(metrics.is_enabled())
+
+        def add_calls():
+            return metrics.snapshot()[1].get('add', (0, 0.0))[0]
+
+        x = torch.randn(10)
+        before = add_calls()
+        for _ in range(5):
+            x + x
+        self.assertEqual(add_calls() - before, 5)
+
+        # the calls of a thread are kept once it exits
+        before = add_calls()
+        t = threading.Thread(target=lambda: [x + x for _ in range(3)])
+        t.start()
+        t.join()
+        self.assertEqual(add_calls() - before, 3)
+
+        metrics.set_enabled(False)
+        try:
+            before = add_calls()
+            x + x
+            self.assertEqual(add_calls(), before)
+        finally:
+            metrics.set_enabled(True)
+
+        text = metrics.prometheus_text()
+        self.assertIn('# TYPE torch_op_calls_total counter', text)
+        self.assertIn('torch_op_calls_total{op="add"} ', text)
+        self.assertIn('torch_parallel_for_inline_total ', text)
+
+    def test_metrics_time_sampling_interval(self):
+        import torch.utils.metrics as metrics
+        interval = metrics.get_time_sampling_interval()
+        try:
+            metrics.set_time_sampling_interval(1)
+            x = torch.randn(10)
+            # calls counted down from the previous interval come first
+            for _ in range(interval + 1):
+                x + x
+            self.assertGreater(metrics.snapshot()[1]['add'][1], 0)
+            with self.assertRaises(RuntimeError):
+                metrics.set_time_sampling_interval(-1)
+        finally:
+            metrics.set_time_sampling_interval(interval)
+
+    def test_parallel_profile(self):
+        import torch.utils.metrics as metrics
+        self.assertFalse(metrics.is_parallel_profiling_enabled())
+        metrics.reset_parallel_profile()
+        metrics.set_parallel_profiling_enabled(True)
+        try:
+            x = torch.randn(1 << 20)
+            for _ in range(3):
+                x.sum()
+        finally:
+            metrics.set_parallel_profiling_enabled(False)
+        profile = {entry.op: entry for entry in metrics.parallel_profile()}
+        if torch.get_num_threads() > 1:
+            entry = profile['sum']
+            self.assertGreaterEqual(entry.regions, 3)
+            self.assertGreaterEqual(entry.tasks, 2 * entry.regions)
+            self.assertGreater(entry.busy_seconds, 0)
+            self.assertGreaterEqual(entry.imbalance, 1)
+            self.assertIn('sum', metrics.parallel_profile_report())
+
+        metrics.reset_parallel_profile()
+        self.assertEqual(metrics.parallel_profile(), [])
+
     @slowTest
     def test_slow_test(self):
         # Just a smoketest to make sure our slowTest decorator works.
@@ -9186,6 +9550,28 @@ class TestTorchDeviceType(TestCase):
             alias_samples = torch._multinomial_alias_draw(prob_table, alias_table, MAX_SAMPLES)
             self.assertEqual(alias_samples.unique(), probs.nonzero().squeeze(-1))
 
+    @onlyCPU
+    def test_multinomial_alias_draw_reproducible(self, device):
+        probs = torch.softmax(torch.randn(1000, dtype=torch.double), 0)
+        alias_table, prob_table = torch._multinomial_alias_setup(probs)
+        n_samples = 100000
+        num_threads = torch.get_num_threads()
+        samples = []
+        for threads in [1, max(num_threads, 4)]:
+            try:
+                torch.set_num_threads(threads)
+                gen = torch.Generator().manual_seed(1234)
+                samples.append(torch._multinomial_alias_draw(prob_table, alias_table, n_samples, generator=gen))
+            finally:
+                torch.set_num_threads(num_threads)
+        self.assertEqual(samples[0], samples[1])
+        # the generator advances, so that the next draws are different
+        self.assertNotEqual(torch._multinomial_alias_draw(prob_table, alias_table, n_samples, generator=gen),
+                            samples[0])
+        self.assertTrue(((samples[0] >= 0) & (samples[0] < 1000)).all())
+        counts = torch.bincount(samples[0], minlength=1000).double() / n_samples
+        self.assertLess((counts - probs).abs().sum().item(), 0.1)
+
     @skipCUDAIfNoMagma
     @skipCPUIfNoLapack
     def test_lapack_empty(self, device):
@@ -9863,6 +10249,94 @@ class TestTorchDeviceType(TestCase):
                                              [0, 0, 0],
                                              [1, 1, 1]]))
 
+    @unittest.skipIf(not TEST_NUMPY, 'Numpy not found')
+    def test_cumsum_cumprod_scan_paths(self, device):
+        def reference(x, dim, op):
+            x = x.double().transpose(dim, -1)
+            out = x.clone()
+            for k in range(1, x.size(-1)):
+                out[..., k] = op(out[..., k - 1], x[..., k])
+            return out.transpose(dim, -1)
+
+        # adjacent slices, strided slices and non-contiguous inputs
+        x = torch.rand(7, 33, 5, device=device) + 0.5
+        for dim in range(x.dim()):
+            for t in [x, x.transpose(0, 2)]:
+                self.assertEqual(torch.cumsum(t, dim), reference(t, dim, torch.add).float())
+                self.assertEqual(torch.cumprod(t, dim), reference(t, dim, torch.mul).float())
+
+        # slices long enough to be scanned block-wise
+        x = torch.randint(-3, 4, (3, 100000), device=device)
+        expected = torch.from_numpy(np.cumsum(x.cpu().numpy(), 1))
+        self.assertEqual(torch.cumsum(x, 1).cpu(), expected)
+        self.assertEqual(torch.cumsum(x.t(), 0).cpu(), expected.t())
+        x = torch.rand(100000, device=device, dtype=torch.double)
+        self.assertEqual(torch.cumsum(x, 0)[-1], x.sum(), 1e-6)
+
+        # in-place
+        x = torch.rand(50, 50, device=device)
+        expected = torch.cumsum(x, 0)
+        torch.cumsum(x, 0, out=x)
+        self.assertEqual(x, expected)
+
+    @onlyCPU
+    @dtypes(torch.float, torch.double)
+    def test_logcumsumexp(self, device, dtype):
+        x = torch.randn(5, 40, device=device, dtype=dtype)
+        for dim in range(x.dim()):
+            expected = torch.stack([torch.logsumexp(x.narrow(dim, 0, k + 1), dim)
+                                    for k in range(x.size(dim))], dim)
+            self.assertEqual(x.logcumsumexp(dim), expected)
+
+        x = torch.tensor([-inf, -inf, 1., inf, 2., nan, 3.], device=device, dtype=dtype)
+        res = torch.logcumsumexp(x, 0)
+        self.assertEqual(res[:2], torch.tensor([-inf, -inf], dtype=dtype))
+        self.assertEqual(res[2], 1.)
+        self.assertEqual(res[3:5], torch.tensor([inf, inf], dtype=dtype))
+        self.assertTrue(torch.isnan(res[5:]).all())
+
+        x = torch.randn(1000, device=device, dtype=dtype) * 100
+        self.assertEqual(torch.logcumsumexp(x, 0)[-1], torch.logsumexp(x, 0))
+
+    @onlyCPU
+    def test_cummax_cummin(self, device):
+        def reference(x, dim, is_max):
+            x = x.transpose(dim, -1)
+            values = x.clone()
+            indices = torch.zeros_like(x, dtype=torch.long)
+            best = x[..., 0].clone()
+            best_idx = torch.zeros_like(best, dtype=torch.long)
+            for k in range(x.size(-1)):
+                cur = x[..., k]
+                take = (cur >= best) if is_max else (cur <= best)
+                take = (take | torch.isnan(cur)) & ~torch.isnan(best)
+                best = torch.where(take, cur, best)
+                best_idx = torch.where(take, torch.full_like(best_idx, k), best_idx)
+                values[..., k] = best
+                indices[..., k] = best_idx
+            return values.transpose(dim, -1), indices.transpose(dim, -1)
+
+        x = torch.randint(0, 5, (6, 20, 3), device=device).float()
+        x[2, 7, 1] = nan
+        for dim in range(x.dim()):
+            for t in [x, x.transpose(0, 2)]:
+                for op, is_max in [(torch.cummax, True), (torch.cummin, False)]:
+                    values, indices = op(t, dim)
+                    expected_values, expected_indices = reference(t, dim, is_max)
+                    self.assertEqual(values, expected_values, allow_inf=True)
+                    self.assertEqual(indices, expected_indices)
+
+        x = torch.tensor([1, 3, 3, 2, 5], device=device)
+        self.assertEqual(x.cummax(0)[0], torch.tensor([1, 3, 3, 3, 5]))
+        self.assertEqual(x.cummax(0)[1], torch.tensor([0, 1, 2, 2, 4]))
+        self.assertEqual(x.cummin(0)[1], torch.tensor([0, 0, 0, 0, 0]))
+        b = torch.tensor([False, True, False], device=device)
+        self.assertEqual(b.cummax(0)[0], torch.tensor([False, True, True]))
+
+        s = torch.tensor(2., device=device)
+        self.assertEqual(s.cummax(0)[0], s)
+        self.assertEqual(s.cummin(0)[1], torch.tensor(0))
+
     def test_std_mean(self, device):
         x = torch.rand(100, 50, 20, device=device)
         for dim in range(x.dim()):
@@ -10370,6 +10844,76 @@ class TestTorchDeviceType(TestCase):
         c = torch.zeros(3)
         self.assertRaises(IndexError, lambda: a.index_copy_(dim=1, index=torch.tensor([3]), source=c))
 
+    def test_foreach_ops(self, device):
+        # more tensors and chunks than one launch processes, and an empty tensor
+        sizes = [(100,), (3, 70000), (0,), (1,)] * 40
+        for dtype in [torch.float, torch.double]:
+            xs = [torch.randn(size, device=device, dtype=dtype) for size in sizes]
+            ys = [torch.randn(size, device=device, dtype=dtype) for size in sizes]
+            zs = [torch.rand(size, device=device, dtype=dtype) + 1 for size in sizes]
+            expected = [(x * 2 + 0.5 * y + 3) + 0.1 * y * z + 0.2 * y / z for x, y, z in zip(xs, ys, zs)]
+            results = [x.clone() for x in xs]
+            torch._foreach_mul_(results, 2)
+            torch._foreach_add_(results, ys, alpha=0.5)
+            torch._foreach_add_(results, 3)
+            torch._foreach_addcmul_(results, ys, zs, 0.1)
+            torch._foreach_addcdiv_(results, ys, zs, 0.2)
+            for result, e in zip(results, expected):
+                self.assertEqual(result, e)
+            for result, z in zip(torch._foreach_sqrt(zs), zs):
+                self.assertEqual(result, z.sqrt())
+            # the tensors are still processed when one isn't contiguous
+            non_contiguous = torch.randn(70000, 3, device=device, dtype=dtype).t()
+            expected = non_contiguous * 2
+            results = [x.clone() for x in xs] + [non_contiguous]
+            torch._foreach_mul_(results, 2)
+            self.assertEqual(results[-1], expected)
+
+    def test_fused_optimizer_steps(self, device):
+        sizes = [(100,), (3, 70000), (1,)]
+        params = [torch.randn(size, device=device) for size in sizes]
+        grads = [torch.randn(size, device=device) for size in sizes]
+        exp_avgs = [torch.randn(size, device=device) for size in sizes]
+        exp_avg_sqs = [torch.rand(size, device=device) for size in sizes]
+        results = [(p.clone(), m.clone(), v.clone()) for p, m, v in zip(params, exp_avgs, exp_avg_sqs)]
+        torch._fused_adam_([r[0] for r in results], grads, [r[1] for r in results], [r[2] for r in results],
+                           0.1, 0.9, 0.999, 1e-8, 0.01, 3)
+        for p, g, m, v, r in zip(params, grads, exp_avgs, exp_avg_sqs, results):
+            g = g + 0.01 * p
+            m = 0.9 * m + 0.1 * g
+            v = 0.999 * v + 0.001 * g * g
+            p = p - 0.1 / (1 - 0.9 ** 3) * m / ((v / (1 - 0.999 ** 3)).sqrt() + 1e-8)
+            self.assertEqual(r, (p, m, v))
+
+        for nesterov in [False, True]:
+            results = [(p.clone(), m.clone()) for p, m in zip(params, exp_avgs)]
+            torch._fused_sgd_([r[0] for r in results], grads, [r[1] for r in results], 0.1, 0.9, 0.5, 0.01, nesterov)
+            for p, g, b, r in zip(params, grads, exp_avgs, results):
+                g = g + 0.01 * p
+                b = 0.9 * b + 0.5 * g
+                p = p - 0.1 * (g + 0.9 * b if nesterov else b)
+                self.assertEqual(r, (p, b))
+
+    @onlyCUDA
+    def test_index_put_accumulate_duplicates(self, device):
+        # many duplicates of a few destinations and a destination with a
+        # single entry, indexing one dimension and two of them
+        for dtype in [torch.float, torch.double]:
+            indices = torch.cat((torch.randint(0, 3, (1000,)), torch.tensor([7])))
+            dst = torch.randn(8, 3, 70, dtype=dtype)
+            values = torch.randn(indices.numel(), 3, 70, dtype=dtype)
+            expected = dst.clone().index_put_((indices,), values, accumulate=True)
+            result = dst.to(device).index_put_((indices.to(device),), values.to(device), accumulate=True)
+            self.assertEqual(result.cpu(), expected)
+            again = dst.to(device).index_put_((indices.to(device),), values.to(device), accumulate=True)
+            self.assertEqual(again, result, 0)
+
+            rows = torch.randint(0, 3, indices.shape)
+            values = torch.randn(indices.numel(), 70, dtype=dtype)
+            expected = dst.clone().index_put_((indices, rows), values, accumulate=True)
+            result = dst.to(device).index_put_((indices.to(device), rows.to(device)), values.to(device), accumulate=True)
+            self.assertEqual(result.cpu(), expected)
+
     def test_index_fill(self, device):
         for dt in torch.testing.get_all_dtypes():
             if dt == torch.half or dt == torch.bfloat16:
@@ -10456,6 +11000,31 @@ class TestTorchDeviceType(TestCase):
                                             [False, True, False, True, False],
                                             [True, False, True, False, True]], device=device))
 
+    def test_scatter_gather_large(self, device):
+        # enough rows, or long enough rows, to be split over threads, with
+        # duplicate indices, against index_put_ and index_add_
+        for dtype in [torch.float, torch.double, torch.int64]:
+            src = torch.randint(0, 10, (300000,), device=device).to(dtype)
+            index = torch.randint(0, 100, (300000,), device=device)
+            res = torch.zeros(100, dtype=dtype, device=device).scatter_add_(0, index, src)
+            expected = torch.zeros(100, dtype=dtype, device=device).index_put_((index,), src, accumulate=True)
+            self.assertEqual(res, expected, 0)
+
+            src = torch.randint(0, 10, (5000, 16), device=device).to(dtype)
+            index = torch.randint(0, 50, (5000,), device=device)
+            expanded = index.unsqueeze(1).expand(5000, 16)
+            res = torch.zeros(50, 16, dtype=dtype, device=device).scatter_add_(0, expanded, src)
+            expected = torch.zeros(50, 16, dtype=dtype, device=device).index_add_(0, index, src)
+            self.assertEqual(res, expected, 0)
+
+            # gather and index_select of non-contiguous tensors
+            x = torch.randint(0, 10, (40, 30, 20), device=device).to(dtype).transpose(0, 2)
+            index = torch.randint(0, 30, (50,), device=device)
+            res = x.index_select(1, index)
+            self.assertEqual(res, x.contiguous().index_select(1, index), 0)
+            self.assertEqual(res, x.gather(1, index.view(1, 50, 1).expand(20, 50, 40)), 0)
+            self.assertEqual(res, x[:, index], 0)
+
     def test_masked_scatter_bool_tensor(self, device):
         src = torch.tensor([True, True, True], device=device)
         dst = torch.tensor([False, False, False], device=device)
@@ -10500,6 +11069,29 @@ class TestTorchDeviceType(TestCase):
         warn = 'masked_select received a mask with dtype torch.uint8,'
         self.assertEqual(str(w[0].message)[0:53], str(warn))
 
+    def test_masked_select_discontiguous(self, device):
+        for size in (10, 200):
+            vals = torch.rand(size, size, device=device)
+            mask = torch.full((size, size), False, dtype=torch.bool, device=device)
+            mask[:, ::2] = True
+            vals_list = (vals, vals.t())
+            mask_list = (mask, mask.t())
+            out_dc = torch.empty(size * size, device=device)[::2]
+            for v, m in product(vals_list, mask_list):
+                if m.is_contiguous():
+                    expected = v[:, ::2].clone().view(-1)
+                else:
+                    expected = v[::2].clone().view(-1)
+                out = torch.masked_select(v, m)
+                self.assertEqual(out, expected, 0)
+                torch.masked_select(v, m, out=out_dc)
+                self.assertEqual(out_dc, expected, 0)
+
+        # the mask is broadcast against the values
+        vals = torch.rand(3, 4, device=device)
+        mask = torch.tensor([True, False, True, True], device=device)
+        self.assertEqual(vals.masked_select(mask), vals[:, mask].contiguous().view(-1), 0)
+
     def test_masked_fill_bool_tensor(self, device):
         dst = torch.tensor([True, False, True], device=device)
         mask = torch.tensor([False, True, False], device=device)
@@ -11208,6 +11800,29 @@ class TestTorchDeviceType(TestCase):
                         self.assertEqual(var1, var2)
                         self.assertEqual(mean1, mean2)
 
+    @dtypes(torch.float, torch.double)
+    def test_var_mean_large(self, device, dtype):
+        # long contiguous, strided and outer reductions, which are reduced in
+        # blocks and in parallel
+        x = torch.randn(300, 257, dtype=dtype, device=device) * 2 + 10
+        ref = x.double()
+        for input, ref_input in [(x, ref), (x.t(), ref.t()), (x[:, ::3], ref[:, ::3])]:
+            for dim in [None, 0, 1]:
+                for unbiased in [False, True]:
+                    if dim is None:
+                        var, mean = torch.var_mean(input, unbiased=unbiased)
+                        std = input.std(unbiased=unbiased)
+                        expected_var = ref_input.var(unbiased=unbiased)
+                        expected_mean = ref_input.mean()
+                    else:
+                        var, mean = torch.var_mean(input, dim, unbiased=unbiased)
+                        std = input.std(dim, unbiased=unbiased)
+                        expected_var = ref_input.var(dim, unbiased=unbiased)
+                        expected_mean = ref_input.mean(dim)
+                    self.assertEqual(var, expected_var.to(dtype), prec=1e-4)
+                    self.assertEqual(mean, expected_mean.to(dtype), prec=1e-4)
+                    self.assertEqual(std, expected_var.sqrt().to(dtype), prec=1e-4)
+
     # passes on ROCm w/ python 2.7, fails w/ python 3.6
     @skipCUDAIfRocm
     # stft -> rfft -> _fft -> _fft_with_size -> _fft_mkl
@@ -11790,6 +12405,33 @@ class TestTorchDeviceType(TestCase):
         self.assertEqual(top1, top2)
         self.assertEqual(idx1, idx2)
 
+    @onlyCUDA
+    @dtypes(torch.uint8, torch.int32, torch.int64, torch.float, torch.double)
+    def test_sort_segments_cuda(self, device, dtype):
+        # short rows are sorted several per block, long rows by the segmented
+        # radix sort
+        for rows, cols in [(4096, 3), (4096, 20), (4096, 200), (7, 5000)]:
+            x = torch.randint(0, 100, (rows, cols), device=device).to(dtype)
+            if dtype.is_floating_point:
+                x[0][1] = float('nan')
+                x[-1][0] = -float('nan')
+                x[1][2] = -float('inf')
+            for descending in [False, True]:
+                val, ind = x.sort(1, descending)
+                self.assertEqual(x.gather(1, ind), val, 0)
+                expected = x.cpu().sort(1, descending)[0]
+                self.assertTrue(((val.cpu() == expected) | (val.cpu() != val.cpu())).all())
+                self.assertEqual(val.cpu() != val.cpu(), expected != expected)
+                self.assertEqual(x.argsort(1, descending), ind)
+                # the sorted values along a non-contiguous dimension
+                self.assertEqual(x.t().sort(0, descending)[0].t(), val)
+
+            k = min(cols, 10)
+            top, top_ind = x.topk(k, 1)
+            self.assertEqual(x.gather(1, top_ind), top, 0)
+            expected = x.cpu().topk(k, 1)[0]
+            self.assertEqual(top.cpu() != top.cpu(), expected != expected)
+
     def test_is_signed(self, device):
         self.assertEqual(torch.IntTensor(5).to(device).is_signed(), True)
         self.assertEqual(torch.ByteTensor(5).to(device).is_signed(), False)
@@ -11985,6 +12627,27 @@ class TestTorchDeviceType(TestCase):
         self.assertEqual(z_inverse, expected_z_inverse)
         self.assertEqual(z_counts, expected_z_counts)
 
+    def test_unique_large(self, device):
+        # large enough for the parallel CPU versions
+        for dtype in [torch.int64, torch.int32, torch.float]:
+            x = torch.randint(-1000, 1000, (300000,), device=device).to(dtype)
+            x_unique, x_inverse, x_counts = torch.unique(x, return_inverse=True, return_counts=True)
+            self.assertEqual(x_unique[x_inverse], x)
+            self.assertEqual(x_counts.sum().item(), x.numel())
+            self.assertEqual(sorted(x_unique.tolist()), sorted(set(x.tolist())))
+
+            x_unique, x_inverse, x_counts = torch.unique(x, sorted=True, return_inverse=True, return_counts=True)
+            expected_unique = x.sort()[0].unique_consecutive()
+            self.assertEqual(x_unique, expected_unique)
+            self.assertEqual(x_unique[x_inverse], x)
+            self.assertEqual(x_counts, torch.bincount(x.long() + 1000)[expected_unique.long() + 1000])
+
+            z = x.sort()[0]
+            z_unique, z_inverse, z_counts = torch.unique_consecutive(z, return_inverse=True, return_counts=True)
+            self.assertEqual(z_unique, expected_unique)
+            self.assertEqual(z_unique[z_inverse], z)
+            self.assertEqual(z_counts, x_counts)
+
     @dtypesIfCUDA(torch.half, torch.float, torch.double)
     @dtypes(torch.float, torch.double)
     def test_erfinv(self, device, dtype):
@@ -12043,6 +12706,33 @@ class TestTorchDeviceType(TestCase):
         z = from_dlpack(to_dlpack(x))
         self.assertEqual(z, x)
 
+    def test_dlpack_protocol(self, device):
+        x = torch.randn(4, 5, device=device)
+        self.assertEqual(x.__dlpack_device__(),
+                         (2, x.get_device()) if x.is_cuda else (1, 0))
+        z = from_dlpack(x)
+        self.assertEqual(z, x)
+        self.assertEqual(z.data_ptr(), x.data_ptr())
+
+        # Strided tensors cross without a copy.
+        y = x.t()[1:]
+        z = from_dlpack(y)
+        self.assertEqual(z, y)
+        self.assertEqual(z.stride(), y.stride())
+        self.assertEqual(z.data_ptr(), y.data_ptr())
+
+    @onlyCUDA
+    def test_dlpack_stream(self, device):
+        x = torch.zeros(1 << 20, device=device)
+        s = torch.cuda.Stream()
+        torch.cuda._sleep(50000000)
+        x.fill_(1)
+        dlpack = x.__dlpack__(stream=s.cuda_stream)
+        with torch.cuda.stream(s):
+            y = from_dlpack(dlpack) * 2
+        s.synchronize()
+        self.assertEqual(y, torch.full_like(x, 2))
+
     @onlyCUDA
     def test_pin_memory_from_constructor(self, device):
         def _get_like(t, **kwargs):
@@ -13049,6 +13739,27 @@ class TestTorchDeviceType(TestCase):
             self.assertRaises(RuntimeError, lambda: torch.bmm(b1, b2.cuda()))
             self.assertRaises(RuntimeError, lambda: torch.bmm(b1.cuda(), b2))
 
+    @onlyCPU
+    @dtypes(torch.float, torch.double)
+    def test_bmm_small_strided(self, device, dtype):
+        # the (batch * heads, length, head_size) views of an attention layer
+        batch, length, heads, head_size = 3, 13, 4, 17
+        q = torch.randn(batch, length, heads, head_size, dtype=dtype, device=device)
+        k = torch.randn(batch, length, heads, head_size, dtype=dtype, device=device)
+        q = q.transpose(1, 2).reshape(batch * heads, length, head_size)
+        k = k.permute(0, 2, 3, 1)[:, :, :, :length - 2].reshape(batch * heads, head_size, length - 2)
+        for b1, b2 in [(q, k), (q.transpose(1, 2)[:, :9], q[:, :, 2:11]), (q[::2, 1:], k[::2, :, 1:])]:
+            res = torch.bmm(b1, b2)
+            res2 = torch.stack([torch.mm(b1[i], b2[i]) for i in range(b1.size(0))])
+            self.assertEqual(res, res2)
+
+            out = torch.full_like(res.transpose(0, 1), float('nan')).transpose(0, 1)
+            torch.bmm(b1, b2, out=out)
+            self.assertEqual(out, res2)
+
+            base = torch.randn_like(res2)
+            self.assertEqual(torch.baddbmm(base, b1, b2, beta=.5, alpha=2), base * .5 + res2 * 2)
+
     @onlyCPU
     @dtypes(torch.float)
     def test_addbmm(self, device, dtype):
@@ -13242,6 +13953,28 @@ class TestTorchDeviceType(TestCase):
         self.assertRaises(RuntimeError, lambda: torch.cat([]))
         self.assertRaisesRegex(TypeError, 'got None', lambda: torch.cat([x, None]))
 
+    @dtypes(torch.uint8, torch.float, torch.double)
+    def test_cat_many_small(self, device, dtype):
+        # many inputs of different sizes along each dimension, with empty ones
+        # skipped, and more inputs than the CUDA kernel takes per launch
+        for dim in range(3):
+            sizes = [3, 4, 5]
+            inputs = []
+            for i in range(1100):
+                sizes[dim] = i % 4
+                inputs.append(torch.randint(0, 100, sizes, device=device).to(dtype))
+            if dim == 0:
+                inputs.insert(7, torch.empty(0, device=device, dtype=dtype))
+            result = torch.cat(inputs, dim)
+            nonempty = [t for t in inputs if t.dim() == 3]
+            self.assertEqual(result.size(dim), sum(t.size(dim) for t in nonempty))
+            offset = 0
+            for t in nonempty:
+                self.assertEqual(result.narrow(dim, offset, t.size(dim)), t, 0)
+                offset += t.size(dim)
+        x = [torch.randint(0, 100, (7,), device=device).to(dtype) for _ in range(1000)]
+        self.assertEqual(torch.stack(x), torch.cat(x).view(1000, 7), 0)
+
     @onlyCPU
     def test_cat_scalars(self, device):
         x = torch.tensor(0, device=device)
@@ -13372,6 +14105,21 @@ class TestDevicePrecision(TestCase):
         self.assertEqual(x.sum(dim=(-1, -2)).cpu(), y.sum(dim=(-1, -2)))
         self.assertEqual(x.sum(dim=(1, 3)).cpu(), y.sum(dim=(1, 3)))
 
+    @dtypes(torch.float, torch.double)
+    def test_reduction_layouts(self, device, dtype):
+        # reduced dims that don't coalesce, permuted views and few outputs of
+        # large reductions, which are split over the input
+        nchw = torch.randn(4, 8, 36, 40, dtype=dtype, device=device)
+        inputs = [nchw, nchw.permute(0, 2, 3, 1), nchw.transpose(1, 3), nchw[:, :, ::2]]
+        for x in inputs:
+            ref = x.double()
+            for dim in [(0, 2), (0, 3), (2, 3), (1, 2), (0, 1, 3), (1,), (3,)]:
+                self.assertEqual(x.sum(dim), ref.sum(dim).to(dtype), prec=1e-3)
+                self.assertEqual(x.mean(dim), ref.mean(dim).to(dtype), prec=1e-5)
+                self.assertEqual(torch.max_values(x, dim), torch.max_values(x.contiguous(), dim), prec=0)
+                self.assertEqual(x.norm(dim=dim), ref.norm(dim=dim).to(dtype), prec=1e-3)
+            self.assertEqual(x.prod(0), ref.prod(0).to(dtype), prec=1e-5)
+
     def test_device_serialization(self, device):
         x = torch.randn(4, 4, device=device)
 
@@ -11,6 +11,7 @@ import torch.nn as nn
 import torch.utils.data
 import torch.cuda
 from torch.utils.checkpoint import checkpoint, checkpoint_sequential
+from torch.utils.checkpoint import recompute_saved_tensors, offload_saved_tensors
 import torch.hub as hub
 from torch.autograd._functions.utils import prepare_onnx_paddings
 from torch.autograd._functions.utils import check_onnx_broadcast
@@ -271,6 +272,55 @@ class TestCheckpoint(TestCase):
 
             self.assertEqual(grad_with_checkpointing, grad_no_checkpointing)
 
+    def test_recompute_saved_tensors(self):
+        model = nn.Sequential(nn.Linear(10, 20), nn.Tanh(), nn.Dropout(), nn.Linear(20, 5))
+        calls = []
+
+        def run_fn(input):
+            calls.append(None)
+            return model(input).sigmoid()
+
+        inp = torch.randn(8, 10, requires_grad=True)
+        state = torch.get_rng_state()
+        out = run_fn(inp).sum()
+        grads = torch.autograd.grad(out, [inp] + list(model.parameters()))
+
+        torch.set_rng_state(state)
+        calls = []
+        out = recompute_saved_tensors(run_fn, inp).sum()
+        self.assertEqual(len(calls), 1)
+        recomputed_grads = torch.autograd.grad(
+            out, [inp] + list(model.parameters()), retain_graph=True)
+        self.assertEqual(len(calls), 2)
+        self.assertEqual(recomputed_grads, grads)
+        # the recomputed tensors stay around for another backward
+        self.assertEqual(torch.autograd.grad(out, inp)[0], grads[0])
+        self.assertEqual(len(calls), 2)
+
+        def different_fn(input):
+            if len(calls) > 2:
+                return input * 2
+            return run_fn(input)
+
+        out = recompute_saved_tensors(different_fn, inp).sum()
+        with self.assertRaisesRegex(RuntimeError, "has to repeat the forward"):
+            out.backward()
+
+    @unittest.skipIf(not HAS_CUDA, 'No CUDA')
+    def test_offload_saved_tensors(self):
+        model = nn.Sequential(nn.Linear(100, 100), nn.ReLU(), nn.Linear(100, 10)).cuda()
+        inp = torch.randn(64, 100, device='cuda', requires_grad=True)
+        model(inp).sum().backward()
+        grads = [inp.grad.clone()] + [p.grad.clone() for p in model.parameters()]
+
+        inp.grad = None
+        model.zero_grad()
+        with offload_saved_tensors():
+            out = model(inp).sum()
+        out.backward()
+        offloaded_grads = [inp.grad] + [p.grad for p in model.parameters()]
+        self.assertEqual(offloaded_grads, grads)
+
     def test_checkpoint_non_tensor(self):
 
         def run_fn(tensor1, tensor2):
@@ -18,6 +18,9 @@ struct TORCH_API ${op} : public ${superclass} {
   void release_variables() override {
     ${release_variables}
   }
+  void prefetch_variables() override {
+    ${prefetch_variables}
+  }
   ${will_release_variables}
   ${saved_variables}
   ${saved_list_sizes}
@@ -125,6 +128,7 @@ def process_function(func):
     env = {}
     saved_variables = []
     release_variables = []
+    prefetch_variables = []
     saved_list_sizes = []
     unpack = []
     asserts = []
@@ -145,6 +149,7 @@ def process_function(func):
             saved_variables.append('SavedVariable {}_;'.format(name))
             release_variables.append('{}_.reset_data();'.format(name))
             release_variables.append('{}_.reset_grad_function();'.format(name))
+            prefetch_variables.append('{}_.prefetch();'.format(name))
             ptr = 'shared_from_this()' if is_output else ''
             unpack.append('auto {} = {}_.unpack({});'.format(name, name, ptr))
         elif arg['type'] == 'TensorList':
@@ -154,6 +159,7 @@ def process_function(func):
             # Because the SavedVariable owns a tensor and a grad_fn, removing the SavedVariable makes them go away as well.
             release_variables.append('{}_.clear();'.format(name))
             release_variables.append('{}_released_ = true;'.format(name))
+            prefetch_variables.append('for (auto& v : {}_) v.prefetch();'.format(name))
             unpack.append('auto {} = unpack_list({}_);'.format(name, name))
             asserts.append('TORCH_CHECK(!{}_released_, ERR_BACKWARD_TWICE);'.format(name))
         elif arg['type'] == 'IntArrayRef':
@@ -169,6 +175,7 @@ def process_function(func):
         save_arg(arg, is_output=True)
     env['saved_variables'] = saved_variables
     env['release_variables'] = release_variables
+    env['prefetch_variables'] = prefetch_variables
     env['saved_list_sizes'] = saved_list_sizes
     env['asserts'] = asserts
 
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <numeric>
 #include <functional>
+#include <limits>
 
 // ${generated_comment}
 
@@ -425,6 +426,32 @@ Tensor cumsum_backward(const Tensor & x, int64_t dim) {
   return ret;
 }
 
+Tensor logcumsumexp_backward(const Tensor & grad, const Tensor & self, const Tensor & result, int64_t dim) {
+  if (grad.dim() == 0 || grad.numel() == 0) {
+    return grad;
+  }
+  // grad_self[j] = sum_{i >= j} grad[i] * exp(self[j] - result[i]), which is
+  // evaluated in log space with a reversed logcumsumexp. The logarithms need
+  // a positive argument, so the positive and negative parts of grad are
+  // accumulated separately.
+  auto reverse_logcumsumexp = [dim](const Tensor & t) {
+    return at::logcumsumexp(t.flip({dim}), dim).flip({dim});
+  };
+  auto neg_inf = at::full({}, -std::numeric_limits<double>::infinity(), grad.options());
+  auto log_grad_pos = at::where(grad > 0, grad.log(), neg_inf);
+  auto log_grad_neg = at::where(grad < 0, (-grad).log(), neg_inf);
+  auto grad_pos = (reverse_logcumsumexp(log_grad_pos - result) + self).exp();
+  auto grad_neg = (reverse_logcumsumexp(log_grad_neg - result) + self).exp();
+  return grad_pos - grad_neg;
+}
+
+Tensor cummaxmin_backward(const Tensor & grad, const Tensor & self, const Tensor & indices, int64_t dim) {
+  if (self.dim() == 0) {
+    return grad;
+  }
+  return at::zeros_like(self).scatter_add_(dim, indices, grad);
+}
+
 Tensor logsumexp_backward(Tensor grad, const Tensor & self, Tensor result, IntArrayRef dim, bool keepdim) {
   if (!keepdim && self.dim() != 0) {
     grad = unsqueeze_multiple(grad, dim, self.sizes().size());
@@ -53,6 +53,7 @@ libtorch_sources = [
     "torch/csrc/distributed/autograd/utils.cpp",
     "torch/csrc/distributed/autograd/context/dist_autograd_container.cpp",
     "torch/csrc/distributed/autograd/context/dist_autograd_context.cpp",
+    "torch/csrc/distributed/autograd/context/gradient_coalescer.cpp",
     "torch/csrc/distributed/autograd/engine/dist_engine.cpp",
     "torch/csrc/distributed/autograd/functions/recvrpc_backward.cpp",
     "torch/csrc/distributed/autograd/functions/sendrpc_backward.cpp",
@@ -86,9 +87,13 @@ libtorch_sources = [
     "torch/csrc/jit/pickler.cpp",
     "torch/csrc/jit/unpickler.cpp",
     "torch/csrc/jit/graph_executor.cpp",
+    "torch/csrc/jit/model_server.cpp",
     "torch/csrc/jit/import.cpp",
+    "torch/csrc/jit/plan_serialization.cpp",
     "torch/csrc/jit/import_legacy.cpp",
     "torch/csrc/jit/pickle.cpp",
+    "torch/csrc/jit/weight_compression.cpp",
+    "torch/csrc/jit/shared_weights.cpp",
     "torch/csrc/jit/import_export_helpers.cpp",
     "torch/csrc/jit/instruction.cpp",
     "torch/csrc/jit/interpreter.cpp",
@@ -111,9 +116,12 @@ libtorch_sources = [
     "torch/csrc/jit/passes/common_subexpression_elimination.cpp",
     "torch/csrc/jit/passes/constant_propagation.cpp",
     "torch/csrc/jit/passes/constant_pooling.cpp",
+    "torch/csrc/jit/passes/module_constant_pooling.cpp",
+    "torch/csrc/jit/passes/convert_to_mkldnn.cpp",
     "torch/csrc/jit/passes/create_autodiff_subgraphs.cpp",
     "torch/csrc/jit/passes/dead_code_elimination.cpp",
     "torch/csrc/jit/passes/erase_number_types.cpp",
+    "torch/csrc/jit/passes/freeze_module.cpp",
     "torch/csrc/jit/passes/graph_fuser.cpp",
     "torch/csrc/jit/passes/guard_elimination.cpp",
     "torch/csrc/jit/passes/inline_autodiff_subgraphs.cpp",
@@ -127,15 +135,19 @@ libtorch_sources = [
     "torch/csrc/jit/passes/lower_grad_of.cpp",
     "torch/csrc/jit/passes/lower_graph.cpp",
     "torch/csrc/jit/passes/lower_tuples.cpp",
+    "torch/csrc/jit/passes/memory_planning.cpp",
+    "torch/csrc/jit/passes/parallelize_branches.cpp",
     "torch/csrc/jit/passes/peephole.cpp",
     "torch/csrc/jit/passes/python_print.cpp",
     "torch/csrc/jit/passes/quantization.cpp",
     "torch/csrc/jit/passes/fuse_linear.cpp",
+    "torch/csrc/jit/passes/fuse_transformer_ops.cpp",
     "torch/csrc/jit/passes/remove_expands.cpp",
     "torch/csrc/jit/passes/requires_grad_analysis.cpp",
     "torch/csrc/jit/passes/shape_analysis.cpp",
     "torch/csrc/jit/passes/specialize_autogradzero.cpp",
     "torch/csrc/jit/passes/subgraph_rewrite.cpp",
+    "torch/csrc/jit/passes/use_inplace_ops.cpp",
     "torch/csrc/jit/passes/utils/subgraph_utils.cpp",
     "torch/csrc/jit/passes/utils/memory_dag.cpp",
     "torch/csrc/jit/print_handler.cpp",
@@ -164,6 +176,7 @@ libtorch_sources = [
     "torch/csrc/jit/script/module.cpp",
     "torch/csrc/jit/tracer.cpp",
     "torch/csrc/jit/fuser/kernel_cache.cpp",
+    "torch/csrc/jit/fuser/disk_cache.cpp",
     "torch/csrc/jit/fuser/compiler.cpp",
     "torch/csrc/jit/fuser/executor.cpp",
     "torch/csrc/jit/fuser/codegen.cpp",
@@ -204,6 +217,7 @@ def add_torch_libs():
     torch_cpp_srcs = [
         "torch/csrc/api/src/cuda.cpp",  # this just forwards stuff, no real CUDA
         "torch/csrc/api/src/data/datasets/mnist.cpp",
+        "torch/csrc/api/src/data/datasets/record_file.cpp",
         "torch/csrc/api/src/data/samplers/distributed.cpp",
         "torch/csrc/api/src/data/samplers/random.cpp",
         "torch/csrc/api/src/data/samplers/sequential.cpp",
@@ -247,6 +261,7 @@ def add_torch_libs():
         "torch/csrc/api/src/optim/rmsprop.cpp",
         "torch/csrc/api/src/optim/serialize.cpp",
         "torch/csrc/api/src/optim/sgd.cpp",
+        "torch/csrc/api/src/serialize/async-checkpoint.cpp",
         "torch/csrc/api/src/serialize/input-archive.cpp",
         "torch/csrc/api/src/serialize/output-archive.cpp",
     ]
@@ -284,6 +299,7 @@ def add_torch_libs():
         "torch/csrc/autograd/python_variable_indexing.cpp",
         "torch/csrc/distributed/autograd/init.cpp",
         "torch/csrc/distributed/c10d/comm.cpp",
+        "torch/csrc/distributed/c10d/comm_hooks.cpp",
         "torch/csrc/distributed/c10d/init.cpp",
         "torch/csrc/distributed/c10d/reducer.cpp",
         "torch/csrc/distributed/rpc/init.cpp",
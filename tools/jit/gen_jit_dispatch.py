@@ -263,7 +263,25 @@ def argument_order(decl):
     return decl.get('jit_argument_order') or list(range(len(decl['arguments'])))
 
 
-def gen_jit_dispatch(declarations, out, template_path, disable_autograd=False):
+def load_op_list(path):
+    """Loads a selected op list: a yaml list of operator names, e.g. the
+    output of torch.jit.export_opnames(). An entry without overload name,
+    "aten::add", selects all the overloads of the operator."""
+    import yaml
+    with open(path, 'r') as f:
+        op_list = yaml.load(f, Loader=yaml.SafeLoader)
+    return set(str(op) for op in op_list or [])
+
+
+def is_selected_op(decl, selected_op_list):
+    name = 'aten::' + (decl['name'][:-4] if is_out_variant(decl) else decl['name'])
+    if name in selected_op_list:
+        return True
+    overload_name = decl['overload_name']
+    return overload_name != '' and '{}.{}'.format(name, overload_name) in selected_op_list
+
+
+def gen_jit_dispatch(declarations, out, template_path, disable_autograd=False, selected_op_list=None):
     REGISTER_ATEN_OPS_CPP = CodeTemplate.from_file(template_path + '/register_aten_ops.cpp')
 
     ops = []
@@ -337,11 +355,13 @@ def gen_jit_dispatch(declarations, out, template_path, disable_autograd=False):
                                              lvalues=lvalues)
         return constructor
 
-    def filter_decls(jit_decls, disable_autograd):
+    def filter_decls(jit_decls, disable_autograd, selected_op_list):
         result = []
         for decl in jit_decls:
             if disable_autograd and is_backward_op(decl):
                 continue
+            if selected_op_list is not None and not is_selected_op(decl, selected_op_list):
+                continue
             result.append(decl)
         return result
 
@@ -431,7 +451,7 @@ def gen_jit_dispatch(declarations, out, template_path, disable_autograd=False):
                 additional_jit_decls.append(decl_copy)
 
     jit_decls.extend(additional_jit_decls)
-    jit_decls = filter_decls(jit_decls, disable_autograd)
+    jit_decls = filter_decls(jit_decls, disable_autograd, selected_op_list)
 
     # Group and sort the generated snippets to ensure that the
     # generation is deterministic
@@ -572,8 +592,12 @@ def main():
                         help='path to output directory')
     parser.add_argument('template_path', metavar='TEMPLATE_PATH',
                         help='path to templates directory')
+    parser.add_argument('--selected-op-list', metavar='OP_LIST',
+                        help='path to a yaml list of the operators to register, all when omitted')
     args = parser.parse_args()
-    gen_jit_dispatch(args.declarations, args.out, args.template_path)
+    selected_op_list = load_op_list(args.selected_op_list) if args.selected_op_list else None
+    gen_jit_dispatch(args.declarations, args.out, args.template_path,
+                     selected_op_list=selected_op_list)
 
 
 if __name__ == '__main__':
@@ -24,12 +24,13 @@ def generate_code(ninja_global=None,
                   nn_path=None,
                   install_dir=None,
                   subset=None,
-                  disable_autograd=False):
+                  disable_autograd=False,
+                  selected_op_list_path=None):
     # cwrap depends on pyyaml, so we can't import it earlier
     root = os.path.dirname(os.path.dirname(os.path.dirname(os.path.abspath(__file__))))
     sys.path.insert(0, root)
     from tools.autograd.gen_autograd import gen_autograd, gen_autograd_python
-    from tools.jit.gen_jit_dispatch import gen_jit_dispatch
+    from tools.jit.gen_jit_dispatch import gen_jit_dispatch, load_op_list
 
     # Build ATen based Variable classes
     autograd_gen_dir = install_dir or 'torch/csrc/autograd/generated'
@@ -52,7 +53,8 @@ def generate_code(ninja_global=None,
             declarations_path or DECLARATIONS_PATH,
             jit_gen_dir,
             'tools/jit/templates',
-            disable_autograd=disable_autograd)
+            disable_autograd=disable_autograd,
+            selected_op_list=load_op_list(selected_op_list_path) if selected_op_list_path else None)
 
 
 def main():
@@ -71,6 +73,11 @@ def main():
         action='store_true',
         help='It can skip generating autograd related code when the flag is set',
     )
+    parser.add_argument(
+        '--selected-op-list-path',
+        help='Path to a yaml list of the operators to register in the JIT, e.g. the output of '
+             'torch.jit.export_opnames(). All operators are registered when omitted.',
+    )
     options = parser.parse_args()
     generate_code(
         options.ninja_global,
@@ -79,6 +86,7 @@ def main():
         options.install_dir,
         options.subset,
         options.disable_autograd,
+        options.selected_op_list_path,
     )
 
 
@@ -663,6 +663,11 @@ type as :attr:`self`.
 
     Unlike `copy_()`, this function is recorded in the computation graph. Gradients
     propagating to the cloned tensor will propagate to the original tensor.
+
+.. note::
+
+    With :func:`torch.set_lazy_clone_enabled`, the copy of a CPU tensor with
+    the layout of :attr:`self` is deferred until either tensor is used.
 """)
 
 add_docstr_all('contiguous',
@@ -761,6 +766,20 @@ Args:
         Otherwise, the argument has no effect. Default: ``False``.
 """)
 
+add_docstr_all('cummax',
+               r"""
+cummax(dim) -> (Tensor, Tensor)
+
+See :func:`torch.cummax`
+""")
+
+add_docstr_all('cummin',
+               r"""
+cummin(dim) -> (Tensor, Tensor)
+
+See :func:`torch.cummin`
+""")
+
 add_docstr_all('cumprod',
                r"""
 cumprod(dim, dtype=None) -> Tensor
@@ -1580,6 +1599,13 @@ returned distribution:
     f(x) = \dfrac{1}{x \sigma \sqrt{2\pi}}\ e^{-\frac{(\ln x - \mu)^2}{2\sigma^2}}
 """)
 
+add_docstr_all('logcumsumexp',
+               r"""
+logcumsumexp(dim) -> Tensor
+
+See :func:`torch.logcumsumexp`
+""")
+
 add_docstr_all('logsumexp',
                r"""
 logsumexp(dim, keepdim=False) -> Tensor
@@ -540,7 +540,10 @@ as_tensor(data, dtype=None, device=None) -> Tensor
 Convert the data into a `torch.Tensor`. If the data is already a `Tensor` with the same `dtype` and `device`,
 no copy will be performed, otherwise a new `Tensor` will be returned with computational graph retained if data
 `Tensor` has ``requires_grad=True``. Similarly, if the data is an ``ndarray`` of the corresponding `dtype` and
-the `device` is the cpu, no copy will be performed.
+the `device` is the cpu, no copy will be performed. The same holds for other objects implementing the buffer
+protocol, like ``memoryview``, ``bytearray`` and ``array.array``, whose items are of the corresponding `dtype`.
+As for sequences, the `dtype` of such an object is inferred from its items as Python numbers, so it has to be
+given to avoid a copy.
 
 Args:
     {data}
@@ -1316,6 +1319,68 @@ Example::
             [-1.2329,  1.9883,  1.0551]])
 """.format(**common_args))
 
+add_docstr(torch.cummax,
+           r"""
+cummax(input, dim, out=None) -> (Tensor, LongTensor)
+
+Returns a namedtuple ``(values, indices)`` where ``values`` is the cumulative
+maximum of elements of :attr:`input` in the dimension :attr:`dim` and
+``indices`` is the index location of each maximum value found in the
+dimension :attr:`dim`. Ties are resolved to the latest index, and a NaN is
+propagated from its first occurrence on.
+
+.. math::
+    y_i = max(x_1, x_2, x_3, \dots, x_i)
+
+Args:
+    {input}
+    dim  (int): the dimension to do the operation over
+    out (tuple, optional): the result tuple of two output tensors (values, indices)
+
+Example::
+
+    >>> a = torch.randn(10)
+    >>> a
+    tensor([-0.3449, -1.5447,  0.0685, -1.5104, -1.1706,  0.2259,  1.4696, -1.3284,
+             1.9946, -0.8209])
+    >>> torch.cummax(a, dim=0)
+    torch.return_types.cummax(
+        values=tensor([-0.3449, -0.3449,  0.0685,  0.0685,  0.0685,  0.2259,  1.4696,  1.4696,
+             1.9946,  1.9946]),
+        indices=tensor([0, 0, 2, 2, 2, 5, 6, 6, 8, 8]))
+""".format(**reduceops_common_args))
+
+add_docstr(torch.cummin,
+           r"""
+cummin(input, dim, out=None) -> (Tensor, LongTensor)
+
+Returns a namedtuple ``(values, indices)`` where ``values`` is the cumulative
+minimum of elements of :attr:`input` in the dimension :attr:`dim` and
+``indices`` is the index location of each minimum value found in the
+dimension :attr:`dim`. Ties are resolved to the latest index, and a NaN is
+propagated from its first occurrence on.
+
+.. math::
+    y_i = min(x_1, x_2, x_3, \dots, x_i)
+
+Args:
+    {input}
+    dim  (int): the dimension to do the operation over
+    out (tuple, optional): the result tuple of two output tensors (values, indices)
+
+Example::
+
+    >>> a = torch.randn(10)
+    >>> a
+    tensor([-0.2284, -0.6628,  0.0975,  0.2680, -1.3298, -0.4220, -0.3885,  1.1762,
+             0.9165,  1.6684])
+    >>> torch.cummin(a, dim=0)
+    torch.return_types.cummin(
+        values=tensor([-0.2284, -0.6628, -0.6628, -0.6628, -1.3298, -1.3298, -1.3298, -1.3298,
+            -1.3298, -1.3298]),
+        indices=tensor([0, 1, 1, 1, 4, 4, 4, 4, 4, 4]))
+""".format(**reduceops_common_args))
+
 add_docstr(torch.cumprod,
            r"""
 cumprod(input, dim, out=None, dtype=None) -> Tensor
@@ -2245,6 +2310,46 @@ Returns the number of threads used for inter-op parallelism on CPU
 (e.g. in JIT interpreter)
 """)
 
+add_docstr(torch.bind_to_numa_node,
+           r"""
+bind_to_numa_node(int)
+
+Binds the calling thread and the memory it allocates to a NUMA node, and
+makes the intra-op and inter-op parallel work it launches run on threads of
+that node. To run a model replica per socket, call it at the start of the
+thread (or process) that runs each replica. The intra-op parallelism then uses
+the cores of one node by default.
+Only supported on Linux builds with NUMA support, and the work of other
+threads is only kept on their node with the native parallel backend (see
+:func:`torch.__config__.parallel_info`).
+""")
+
+add_docstr(torch.set_lazy_clone_enabled,
+           r"""
+set_lazy_clone_enabled(mode) -> None
+
+Sets whether :meth:`~Tensor.clone` of a CPU tensor defers the copy. The clone
+shares the memory of the tensor until either of them is used, then whichever
+is used first gets the memory if the other one is gone and a copy of it
+otherwise, so that clones that are never used, or that outlive the tensor
+they were cloned from, copy nothing. Clones that would change the layout of
+the tensor, or of views that don't cover their whole storage, are still done
+eagerly. Disabled by default, since memory written through a pointer obtained
+before the clone, e.g. by a NumPy array sharing the memory of the tensor, is
+seen by the clone too.
+
+Args:
+    mode (bool): whether to defer the copy of clones
+""")
+
+add_docstr(torch.is_lazy_clone_enabled,
+           r"""
+is_lazy_clone_enabled() -> bool
+
+Returns whether :meth:`~Tensor.clone` of a CPU tensor defers the copy, see
+:func:`torch.set_lazy_clone_enabled`.
+""")
+
 add_docstr(torch.gt,
            r"""
 gt(input, other, out=None) -> Tensor
@@ -2752,6 +2857,32 @@ Example::
     tensor([4.0])
 """.format(**factory_common_args))
 
+add_docstr(torch.logcumsumexp,
+           r"""
+logcumsumexp(input, dim, out=None) -> Tensor
+
+Returns the logarithm of the cumulative summation of the exponentiation of
+elements of :attr:`input` in the dimension :attr:`dim`. The computation is
+numerically stabilized.
+
+For summation index :math:`j` given by `dim` and other indices :math:`i`, the result is
+
+    .. math::
+        \text{{logcumsumexp}}(x)_{{ij}} = \log \sum\limits_{{j=0}}^{{i}} \exp(x_{{ij}})
+
+Args:
+    {input}
+    dim  (int): the dimension to do the operation over
+    {out}
+
+Example::
+
+    >>> a = torch.randn(10)
+    >>> torch.logcumsumexp(a, dim=0)
+    tensor([-0.4227, -0.3591,  0.6888,  0.9065,  1.6107,  1.8998,  2.0112,  2.0672,
+             2.2708,  2.5117])
+""".format(**reduceops_common_args))
+
 add_docstr(torch.logsumexp,
            r"""
 logsumexp(input, dim, keepdim=False, out=None)
@@ -157,6 +157,44 @@ def grad(outputs, inputs, grad_outputs=None, retain_graph=None, create_graph=Fal
         inputs, allow_unused)
 
 
+def register_batched_grad_hook(tensors, hook, batch_size=0):
+    r"""Registers a hook called with the gradients of many tensors at once.
+
+    Registering a hook on each of many tensors, e.g. on all the parameters of
+    a model, costs a Python call for each of them in every backward pass. The
+    hook registered here is instead called as::
+
+        hook(indices, grads) -> None
+
+    where ``grads`` are the ``.grad`` attributes of the tensors
+    ``tensors[i] for i in indices``, once their gradients were accumulated.
+    It is called when ``batch_size`` gradients are ready, and at the end of
+    the backward pass for the remaining ones. The hook may modify the
+    gradients in place.
+
+    The returned handle keeps the hook registered, the hook is removed when
+    ``handle.remove()`` is called or when the handle is deleted.
+
+    Arguments:
+        tensors (sequence of Tensor): leaf tensors that require grad.
+        hook (callable): the function called with the batches of gradients.
+        batch_size (int, optional): The number of gradients passed to each
+            call of ``hook``. ``0`` calls it once at the end of the backward
+            pass. Default: ``0``.
+
+    Example::
+
+        >>> params = list(model.parameters())
+        >>> def log_norms(indices, grads):
+        ...     for i, grad in zip(indices, grads):
+        ...         print(i, grad.norm())
+        >>> handle = torch.autograd.register_batched_grad_hook(params, log_norms)
+    """
+    if batch_size < 0:
+        raise ValueError("batch_size must be non-negative, got {}".format(batch_size))
+    return torch.autograd._BatchedGradHook(list(tensors), hook, batch_size)
+
+
 # This function applies in case of gradient checkpointing for memory
 # optimization. Currently, for gradient checkpointing, we only support imperative
 # backwards call i.e. torch.autograd.backward() and the torch.autograd.grad() won't
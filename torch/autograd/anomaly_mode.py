@@ -14,6 +14,17 @@ class detect_anomaly(object):
         This mode should be enabled only for debugging as the different tests
         will slow down your program execution.
 
+    With ``fast=True``, the overhead is low enough for production training:
+    the traceback of the forward pass is recorded as the code object and line
+    of each frame, and only formatted for the function that fails, and the
+    outputs of the backward functions are each reduced without waiting for
+    the result. The backward pass then raises an error when it ends, for the
+    first function that returned "nan" or "inf" values.
+
+    Arguments:
+        fast (bool, optional): Whether to use the low overhead mode
+            described above. Default: ``False``.
+
     Example:
 
         >>> import torch
@@ -65,14 +76,18 @@ class detect_anomaly(object):
 
     """
 
-    def __init__(self):
+    def __init__(self, fast=False):
         self.prev = torch.is_anomaly_enabled()
+        self.prev_fast = torch._C._is_anomaly_fast()
+        self.fast = fast
 
     def __enter__(self):
         torch.set_anomaly_enabled(True)
+        torch._C._set_anomaly_fast(self.fast)
 
     def __exit__(self, *args):
         torch.set_anomaly_enabled(self.prev)
+        torch._C._set_anomaly_fast(self.prev_fast)
         return False
 
 
@@ -88,16 +103,21 @@ class set_detect_anomaly(object):
     Arguments:
         mode (bool): Flag whether to enable anomaly detection (``True``),
                      or disable (``False``).
+        fast (bool, optional): Whether to use the low overhead mode of
+                     ``detect_anomaly``. Default: ``False``.
 
     """
 
-    def __init__(self, mode):
+    def __init__(self, mode, fast=False):
         self.prev = torch.is_anomaly_enabled()
+        self.prev_fast = torch._C._is_anomaly_fast()
         torch.set_anomaly_enabled(mode)
+        torch._C._set_anomaly_fast(fast)
 
     def __enter__(self):
         pass
 
     def __exit__(self, *args):
         torch.set_anomaly_enabled(self.prev)
+        torch._C._set_anomaly_fast(self.prev_fast)
         return False
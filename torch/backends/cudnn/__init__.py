@@ -168,6 +168,32 @@ def flags(enabled=False, benchmark=False, deterministic=False, verbose=False):
             set_flags(orig_flags[0], orig_flags[1], orig_flags[2], orig_flags[3])
 
 
+def save_convolution_algorithms(path):
+    r"""Writes the convolution algorithms cuDNN picked so far to the file at
+    ``path``, and returns how many there were.
+
+    With ``torch.backends.cudnn.benchmark = True``, the first convolution of
+    every new shape runs cudnnFind to pick the fastest algorithm, which can
+    take seconds per shape. Saving the algorithms picked after warming up and
+    loading them with :func:`load_convolution_algorithms` lets other processes
+    skip that.
+    """
+    return torch._C._cudnn_save_convolution_algorithms(path)
+
+
+def load_convolution_algorithms(path):
+    r"""Loads the convolution algorithms saved with
+    :func:`save_convolution_algorithms`, and returns how many the file had.
+
+    The loaded algorithms are used for convolutions with exactly the same
+    parameters, where no algorithm was picked for those yet; all other
+    convolutions still run cudnnFind when benchmarking. A file saved with
+    another cuDNN version or on another kind of GPU is ignored with a warning,
+    and 0 is returned.
+    """
+    return torch._C._cudnn_load_convolution_algorithms(path)
+
+
 class CuDNNHandle:
     def __init__(self):
         ptr = ctypes.c_void_p()
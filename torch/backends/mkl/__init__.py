@@ -4,3 +4,30 @@ import torch
 def is_available():
     r"""Returns whether PyTorch is built with MKL support."""
     return torch._C.has_mkl
+
+
+class MKLFFTPlanCache(object):
+    r"""
+    Represents the LRU cache of committed MKL FFT descriptors used by FFT
+    methods (e.g., :func:`torch.fft`) on CPU tensors. The attributes `size` and
+    `max_size`, and method `clear`, can fetch and/ or change properties of the
+    C++ cache.
+    """
+
+    @property
+    def size(self):
+        return torch._mkl_fft_get_plan_cache_size()
+
+    @property
+    def max_size(self):
+        return torch._mkl_fft_get_plan_cache_max_size()
+
+    @max_size.setter
+    def max_size(self, value):
+        torch._mkl_fft_set_plan_cache_max_size(value)
+
+    def clear(self):
+        return torch._mkl_fft_clear_plan_cache()
+
+
+fft_plan_cache = MKLFFTPlanCache()
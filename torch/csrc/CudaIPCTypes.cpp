@@ -1,6 +1,8 @@
 #ifdef USE_CUDA
 #include <torch/csrc/CudaIPCTypes.h>
 #include <TH/THAllocator.h>
+#include <atomic>
+#include <list>
 #include <map>
 #include <mutex>
 #include <random>
@@ -221,11 +223,215 @@ at::DataPtr GetNewRefCountedSentData(void* data, at::Device device) {
   return at::DataPtr(data, sent_data, CudaIPCSentDataDelete, device);
 }
 
+// Note [CUDA IPC pooled mode]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// By default every storage received from another process closes its
+// cudaIpcMemHandle_t once the last storage of the segment is freed, and
+// releases its reference counter by synchronizing its stream and mapping the
+// counters file of the producer again. Passing many small tensors then costs
+// a cudaIpcOpenMemHandle, a stream synchronization and a shm_open for each of
+// them.
+//
+// In the pooled mode, which is set on the receiving side, the last
+// CUDA_IPC_RETAINED_SEGMENTS segments stay open, so the storages cut from a
+// segment of the producer's caching allocator only map it once, the counters
+// files of the producer stay mapped, and the releases are deferred: the freed
+// storage records an event on its stream and the counters of all the storages
+// whose events have completed are decremented together, without blocking,
+// whenever a storage is received or freed. torch.cuda.ipc_collect() waits for
+// the pending releases and closes the retained segments.
+namespace {
+
+struct CudaIPCPendingRelease {
+  std::string ref_counter_handle;
+  int64_t ref_counter_offset;
+  cudaEvent_t event;
+};
+
+struct CudaIPCReceivedEntities {
+  std::mutex mutex_;
+  std::atomic<bool> pooling_;
+  // most recently used first
+  std::list<std::pair<std::string, std::shared_ptr<void>>> retained_segments_;
+  std::list<std::pair<std::string, at::DataPtr>> ref_counter_files_;
+  std::vector<CudaIPCPendingRelease> pending_releases_;
+
+  CudaIPCReceivedEntities() : pooling_(false) {}
+
+  // Must be called with mutex_ held. Returns nullptr if the producer has
+  // already removed the file.
+  int64_t* ref_counter(const std::string& handle, int64_t offset) {
+    for (auto it = ref_counter_files_.begin(); it != ref_counter_files_.end();
+         ++it) {
+      if (it->first == handle) {
+        ref_counter_files_.splice(
+            ref_counter_files_.begin(), ref_counter_files_, it);
+        return static_cast<int64_t*>(ref_counter_files_.front().second.get()) +
+            offset;
+      }
+    }
+    int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
+    at::DataPtr sptr;
+    try {
+      sptr = THRefcountedMapAllocator::makeDataPtr(
+          handle.c_str(),
+          flags,
+          sizeof(int64_t) * CUDA_IPC_REF_COUNTER_FILE_SIZE,
+          nullptr);
+    } catch (c10::Error& err) {
+      // Already warned inside of producer process
+      return nullptr;
+    }
+    ref_counter_files_.emplace_front(handle, std::move(sptr));
+    if (ref_counter_files_.size() > CUDA_IPC_MAPPED_REF_COUNTER_FILES) {
+      ref_counter_files_.pop_back();
+    }
+    return static_cast<int64_t*>(ref_counter_files_.front().second.get()) +
+        offset;
+  }
+
+  void release(const std::string& handle, int64_t offset) {
+    int64_t* counter = ref_counter(handle, offset);
+    if (counter) {
+      *counter -= 1;
+    }
+  }
+
+  // Must be called with mutex_ held. Errors are ignored: this also runs at
+  // exit, when the CUDA runtime may already be shut down, and a failed event
+  // can't hold the memory back anyway.
+  void flush(bool wait) {
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_releases_.size(); i++) {
+      auto& pending = pending_releases_[i];
+      cudaError_t status = wait ? cudaEventSynchronize(pending.event)
+                                : cudaEventQuery(pending.event);
+      if (status == cudaErrorNotReady) {
+        if (kept != i) {
+          pending_releases_[kept] = std::move(pending);
+        }
+        kept++;
+        continue;
+      }
+      cudaEventDestroy(pending.event);
+      release(pending.ref_counter_handle, pending.ref_counter_offset);
+    }
+    pending_releases_.resize(kept);
+    cudaGetLastError();
+  }
+};
+
+// Leaked, so that the storages and segments freed during the static
+// destruction of other modules never see it destroyed.
+CudaIPCReceivedEntities& cuda_ipc_received_entities() {
+  static CudaIPCReceivedEntities* entities = new CudaIPCReceivedEntities();
+  return *entities;
+}
+
+// The producer keeps the blocks of the pending releases in limbo until they
+// are released, so they are waited for when the process exits.
+struct CudaIPCPendingReleasesFlusher {
+  ~CudaIPCPendingReleasesFlusher() {
+    auto& entities = cuda_ipc_received_entities();
+    std::lock_guard<std::mutex> lock(entities.mutex_);
+    entities.flush(/*wait=*/true);
+  }
+};
+
+CudaIPCPendingReleasesFlusher cuda_ipc_pending_releases_flusher;
+
+} // namespace
+
+void CudaIPCSetPooling(bool enabled) {
+  cuda_ipc_received_entities().pooling_ = enabled;
+}
+
+bool CudaIPCPoolingEnabled() {
+  return cuda_ipc_received_entities().pooling_;
+}
+
+std::shared_ptr<void> CudaIPCGetRetainedSegment(const std::string& handle) {
+  auto& entities = cuda_ipc_received_entities();
+  std::shared_ptr<void> evicted;
+  std::lock_guard<std::mutex> lock(entities.mutex_);
+  auto& segments = entities.retained_segments_;
+  for (auto it = segments.begin(); it != segments.end(); ++it) {
+    if (it->first == handle) {
+      segments.splice(segments.begin(), segments, it);
+      return segments.front().second;
+    }
+  }
+  std::shared_ptr<void> segment =
+      c10::cuda::CUDACachingAllocator::getIpcDevPtr(handle);
+  segments.emplace_front(handle, segment);
+  if (segments.size() > CUDA_IPC_RETAINED_SEGMENTS) {
+    // closed after the lock is released
+    evicted = std::move(segments.back().second);
+    segments.pop_back();
+  }
+  return segment;
+}
+
+void CudaIPCReleaseCounter(
+    const std::string& ref_counter_handle,
+    int64_t ref_counter_offset) {
+  auto& entities = cuda_ipc_received_entities();
+  std::lock_guard<std::mutex> lock(entities.mutex_);
+  entities.release(ref_counter_handle, ref_counter_offset);
+}
+
+void CudaIPCReleaseCounterAfterStream(
+    const std::string& ref_counter_handle,
+    int64_t ref_counter_offset,
+    int64_t device) {
+  auto& entities = cuda_ipc_received_entities();
+  at::cuda::CUDAGuard device_guard(device);
+  auto stream = c10::cuda::getCurrentCUDAStream(device);
+  cudaEvent_t event;
+  std::lock_guard<std::mutex> lock(entities.mutex_);
+  // Called from storage deleters, so it must not throw; without an event the
+  // stream is synchronized as in the default mode.
+  if (cudaEventCreateWithFlags(&event, cudaEventDisableTiming) != cudaSuccess) {
+    cudaGetLastError();
+    cudaStreamSynchronize(stream);
+    entities.release(ref_counter_handle, ref_counter_offset);
+    return;
+  }
+  if (cudaEventRecord(event, stream) != cudaSuccess) {
+    cudaGetLastError();
+    cudaEventDestroy(event);
+    cudaStreamSynchronize(stream);
+    entities.release(ref_counter_handle, ref_counter_offset);
+    return;
+  }
+  entities.pending_releases_.push_back(
+      CudaIPCPendingRelease{ref_counter_handle, ref_counter_offset, event});
+  entities.flush(
+      /*wait=*/entities.pending_releases_.size() >=
+      CUDA_IPC_MAXIMUM_PENDING_RELEASES);
+}
+
+void CudaIPCFlushReleases(bool wait) {
+  auto& entities = cuda_ipc_received_entities();
+  std::lock_guard<std::mutex> lock(entities.mutex_);
+  if (!entities.pending_releases_.empty()) {
+    entities.flush(wait);
+  }
+}
+
 bool CudaIPCCollect() {
   bool freed_memory = cuda_ipc_global_entities.CudaIPCSentDataLimbo_.collect();
   if (cuda_ipc_global_entities.CudaIPCSentDataLimbo_.size() == 0) {
     cuda_ipc_global_entities.safe_clean_current_file();
   }
+  // Release what this process holds of the other processes' memory
+  std::list<std::pair<std::string, std::shared_ptr<void>>> retained_segments;
+  {
+    auto& entities = cuda_ipc_received_entities();
+    std::lock_guard<std::mutex> lock(entities.mutex_);
+    entities.flush(/*wait=*/true);
+    retained_segments.swap(entities.retained_segments_);
+  }
   return freed_memory;
 }
 
@@ -13,6 +13,26 @@ namespace torch {
 
 bool CudaIPCCollect();
 
+// See Note [CUDA IPC pooled mode]
+void CudaIPCSetPooling(bool enabled);
+bool CudaIPCPoolingEnabled();
+// Opens the segment of a received cudaIpcMemHandle_t, keeping the last
+// CUDA_IPC_RETAINED_SEGMENTS of them open after their storages are freed.
+std::shared_ptr<void> CudaIPCGetRetainedSegment(const std::string& handle);
+// Decrements a reference counter of the producer through a cached mapping of
+// its file, at once or after the work queued so far on the current stream of
+// `device` has finished.
+void CudaIPCReleaseCounter(
+    const std::string& ref_counter_handle,
+    int64_t ref_counter_offset);
+void CudaIPCReleaseCounterAfterStream(
+    const std::string& ref_counter_handle,
+    int64_t ref_counter_offset,
+    int64_t device);
+// Performs the deferred counter releases whose streams have caught up, or all
+// of them if `wait` is set.
+void CudaIPCFlushReleases(bool wait);
+
 struct CudaIPCReceivedData final {
   explicit CudaIPCReceivedData(std::shared_ptr<void> shared_ptr)
       : shared_ptr_(std::move(shared_ptr)) {}
@@ -58,6 +78,13 @@ constexpr int64_t CUDA_IPC_WARN_AFTER_X_BLOCKS_IN_LIMBO = 1000;
 // And to give us leeway, we picked 1000 as it gives us enough events to share
 // tensors effectively.
 constexpr int64_t CUDA_IPC_MAXIMUM_EVENTS_TO_USE = 1000;
+// Bounds of the receiving side caches of the pooled mode. A retained segment
+// keeps the memory of the producer alive even after the producer freed it, so
+// few of them are kept.
+constexpr size_t CUDA_IPC_RETAINED_SEGMENTS = 16;
+constexpr size_t CUDA_IPC_MAPPED_REF_COUNTER_FILES = 16;
+// Deferred releases are waited for once there are that many pending.
+constexpr size_t CUDA_IPC_MAXIMUM_PENDING_RELEASES = 1024;
 
 // All to be deleted data blocks with non zero reference counter goes there
 struct CudaIPCSentDataLimbo final {
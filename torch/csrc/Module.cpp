@@ -10,6 +10,7 @@
 #include <libshm.h>
 #include <TH/TH.h>
 #include <c10/util/Logging.h>
+#include <c10/util/Metrics.h>
 #include <ATen/ATen.h>
 #include <ATen/ExpandUtils.h>
 #include <ATen/dlpack.h>
@@ -32,6 +33,7 @@
 #include <torch/csrc/autograd/generated/python_nn_functions.h>
 #include <torch/csrc/autograd/python_legacy_variable.h>
 #include <torch/csrc/autograd/python_variable.h>
+#include <torch/csrc/autograd/record_function.h>
 #include <torch/csrc/multiprocessing/init.h>
 #include <torch/csrc/tensor/python_tensor.h>
 #include <torch/csrc/utils/tensor_dtypes.h>
@@ -40,6 +42,7 @@
 #include <torch/csrc/utils/tensor_memoryformats.h>
 #include <torch/csrc/utils/tensor_qschemes.h>
 #include <torch/csrc/utils/tensor_numpy.h>
+#include <torch/csrc/utils/python_arg_parser.h>
 #include <torch/csrc/jit/python_tracer.h>
 #include <torch/csrc/jit/init.h>
 #include <torch/csrc/jit/python_ir.h>
@@ -50,6 +53,7 @@
 
 #ifdef USE_CUDNN
 #include <cudnn.h>
+#include <ATen/native/cudnn/ConvAlgorithmCache.h>
 #endif
 
 #ifdef USE_DISTRIBUTED
@@ -191,6 +195,160 @@ static PyObject * THPModule_setNumInteropThreads(PyObject *module, PyObject *arg
   Py_RETURN_NONE;
 }
 
+static PyObject * THPModule_bindToNUMANode(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "bind_to_numa_node expects an int, "
+          "but got %s", THPUtils_typename(arg));
+  at::bind_to_numa_node((int)THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_metricsEnabled(PyObject *module, PyObject *noargs)
+{
+  if (c10::metrics::isEnabled()) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+static PyObject * THPModule_setMetricsEnabled(PyObject *module, PyObject *arg)
+{
+  THPUtils_assert(PyBool_Check(arg), "_set_metrics_enabled expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  c10::metrics::setEnabled(arg == Py_True);
+  Py_RETURN_NONE;
+}
+
+static PyObject * THPModule_setMetricsTimeSamplingInterval(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(arg), "_set_metrics_time_sampling_interval "
+          "expects an int, but got %s", THPUtils_typename(arg));
+  c10::metrics::setTimeSamplingInterval(THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_metricsTimeSamplingInterval(PyObject *module, PyObject *noargs)
+{
+  return PyLong_FromLongLong(c10::metrics::getTimeSamplingInterval());
+}
+
+// Returns ({counter name: value}, {op name: (calls, estimated seconds)})
+static PyObject * THPModule_metricsSnapshot(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  c10::metrics::Snapshot snapshot;
+  {
+    pybind11::gil_scoped_release no_gil;
+    snapshot = c10::metrics::snapshot();
+  }
+  py::dict counters;
+  for (const auto& counter : snapshot.counters) {
+    counters[py::str(counter.name)] = counter.value;
+  }
+  py::dict ops;
+  for (const auto& op : snapshot.ops) {
+    ops[py::str(op.name)] = py::make_tuple(op.calls, op.estimated_seconds());
+  }
+  return py::make_tuple(counters, ops).release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_metricsPrometheusText(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  std::string text;
+  {
+    pybind11::gil_scoped_release no_gil;
+    text = c10::metrics::prometheusText();
+  }
+  return THPUtils_packString(text);
+  END_HANDLE_TH_ERRORS
+}
+
+static bool parallel_profiling_callbacks_pushed = false;
+
+// Also tracks the operator running on every thread, to which the parallel
+// regions are attributed, with RecordFunction callbacks
+static PyObject * THPModule_setParallelProfilingEnabled(PyObject *module, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "_set_parallel_profiling_enabled expects "
+          "a bool, but got %s", THPUtils_typename(arg));
+  namespace profiler = torch::autograd::profiler;
+  const bool enabled = arg == Py_True;
+  if (enabled && !parallel_profiling_callbacks_pushed) {
+    profiler::pushCallback(
+        [](const profiler::RecordFunction& fn) {
+          at::internal::set_parallel_profile_op(fn.name().str());
+        },
+        [](const profiler::RecordFunction& fn) {
+          at::internal::set_parallel_profile_op(
+              fn.parent() ? fn.parent()->name().str() : nullptr);
+        });
+    parallel_profiling_callbacks_pushed = true;
+  }
+  at::set_parallel_profiling_enabled(enabled);
+  if (!enabled && parallel_profiling_callbacks_pushed) {
+    profiler::popCallback();
+    parallel_profiling_callbacks_pushed = false;
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_parallelProfilingEnabled(PyObject *module, PyObject *noargs)
+{
+  if (at::internal::is_parallel_profiling_enabled()) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+}
+
+// Returns [(op, regions, inline calls, grain size sum, tasks, wall seconds,
+// busy seconds, join wait seconds, imbalance)]
+static PyObject * THPModule_parallelProfile(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  std::vector<at::ParallelProfileEntry> profile;
+  {
+    pybind11::gil_scoped_release no_gil;
+    profile = at::parallel_profile();
+  }
+  py::list entries;
+  for (const auto& entry : profile) {
+    entries.append(py::make_tuple(
+        entry.op, entry.calls, entry.inline_calls, entry.grain_size_sum,
+        entry.tasks, 1e-9 * entry.wall_ns, 1e-9 * entry.busy_ns,
+        1e-9 * entry.join_wait_ns, entry.imbalance()));
+  }
+  return entries.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_parallelProfileReport(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  std::string report;
+  {
+    pybind11::gil_scoped_release no_gil;
+    report = at::parallel_profile_report();
+  }
+  return THPUtils_packString(report);
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPModule_resetParallelProfile(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  at::reset_parallel_profile();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THPModule_setDefaultTensorType(PyObject *_unused, PyObject *type)
 {
   HANDLE_TH_ERRORS
@@ -316,6 +474,29 @@ static PyObject *THPModule_getBackcompatBroadcastWarn(PyObject *module, PyObject
   else Py_RETURN_FALSE;
 }
 
+static PyObject *THPModule_getArgParserStats(PyObject *module, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  auto stats = torch::PythonArgParser::stats();
+  THPObjectPtr result(PyList_New(stats.size()));
+  if (!result) throw python_error();
+  for (size_t i = 0; i < stats.size(); i++) {
+    PyObject* entry = Py_BuildValue("(sKK)", std::get<0>(stats[i]).c_str(),
+        (unsigned long long)std::get<1>(stats[i]),
+        (unsigned long long)std::get<2>(stats[i]));
+    if (!entry) throw python_error();
+    PyList_SET_ITEM(result.get(), i, entry);
+  }
+  return result.release();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject *THPModule_resetArgParserStats(PyObject *module, PyObject *noargs)
+{
+  torch::PythonArgParser::reset_stats();
+  Py_RETURN_NONE;
+}
+
 static PyObject *THPModule_setBackcompatKeepdimWarn(PyObject *module, PyObject *arg) {
   THPUtils_assert(PyBool_Check(arg), "set_backcompat_keepdim_warn expects a bool, "
           "but got %s", THPUtils_typename(arg));
@@ -446,6 +627,20 @@ PyObject *THPModule_deterministicCuDNN(PyObject *_unused, PyObject *noargs)
   else Py_RETURN_FALSE;
 }
 
+PyObject *THPModule_setLazyCloneEnabled(PyObject *_unused, PyObject *arg)
+{
+  THPUtils_assert(PyBool_Check(arg), "set_lazy_clone_enabled expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  at::globalContext().setLazyClone(arg == Py_True);
+  Py_RETURN_NONE;
+}
+
+PyObject *THPModule_lazyCloneEnabled(PyObject *_unused, PyObject *noargs)
+{
+  if (at::globalContext().lazyClone()) Py_RETURN_TRUE;
+  else Py_RETURN_FALSE;
+}
+
 PyObject *THPModule_setBenchmarkCuDNN(PyObject *_unused, PyObject *arg)
 {
   THPUtils_assert(PyBool_Check(arg), "set_benchmark_cudnn expects a bool, "
@@ -531,12 +726,26 @@ static PyMethodDef TorchMethods[] = {
   {"_parallel_info",    (PyCFunction)THPModule_parallelInfo, METH_NOARGS, nullptr},
   {"_set_backcompat_broadcast_warn", (PyCFunction)THPModule_setBackcompatBroadcastWarn, METH_O, nullptr},
   {"_get_backcompat_broadcast_warn", (PyCFunction)THPModule_getBackcompatBroadcastWarn, METH_NOARGS, nullptr},
+  {"_get_arg_parser_stats", (PyCFunction)THPModule_getArgParserStats, METH_NOARGS, nullptr},
+  {"_reset_arg_parser_stats", (PyCFunction)THPModule_resetArgParserStats, METH_NOARGS, nullptr},
   {"_set_backcompat_keepdim_warn", (PyCFunction)THPModule_setBackcompatKeepdimWarn, METH_O, nullptr},
   {"_get_backcompat_keepdim_warn", (PyCFunction)THPModule_getBackcompatKeepdimWarn, METH_NOARGS, nullptr},
   {"get_num_threads", (PyCFunction)THPModule_getNumThreads,     METH_NOARGS,  nullptr},
   {"set_num_threads", (PyCFunction)THPModule_setNumThreads,     METH_O,       nullptr},
   {"get_num_interop_threads", (PyCFunction)THPModule_getNumInteropThreads,     METH_NOARGS,  nullptr},
   {"set_num_interop_threads", (PyCFunction)THPModule_setNumInteropThreads,     METH_O,       nullptr},
+  {"bind_to_numa_node", (PyCFunction)THPModule_bindToNUMANode,     METH_O,       nullptr},
+  {"_metrics_enabled", (PyCFunction)THPModule_metricsEnabled, METH_NOARGS,  nullptr},
+  {"_set_metrics_enabled", (PyCFunction)THPModule_setMetricsEnabled, METH_O,  nullptr},
+  {"_metrics_time_sampling_interval", (PyCFunction)THPModule_metricsTimeSamplingInterval, METH_NOARGS,  nullptr},
+  {"_set_metrics_time_sampling_interval", (PyCFunction)THPModule_setMetricsTimeSamplingInterval, METH_O,  nullptr},
+  {"_metrics_snapshot", (PyCFunction)THPModule_metricsSnapshot, METH_NOARGS,  nullptr},
+  {"_metrics_prometheus_text", (PyCFunction)THPModule_metricsPrometheusText, METH_NOARGS,  nullptr},
+  {"_set_parallel_profiling_enabled", (PyCFunction)THPModule_setParallelProfilingEnabled, METH_O,  nullptr},
+  {"_parallel_profiling_enabled", (PyCFunction)THPModule_parallelProfilingEnabled, METH_NOARGS,  nullptr},
+  {"_parallel_profile", (PyCFunction)THPModule_parallelProfile, METH_NOARGS,  nullptr},
+  {"_parallel_profile_report", (PyCFunction)THPModule_parallelProfileReport, METH_NOARGS,  nullptr},
+  {"_reset_parallel_profile", (PyCFunction)THPModule_resetParallelProfile, METH_NOARGS,  nullptr},
   {"_get_cudnn_enabled", (PyCFunction)THPModule_userEnabledCuDNN, METH_NOARGS,     nullptr},
   {"_set_cudnn_enabled", (PyCFunction)THPModule_setUserEnabledCuDNN, METH_O,  nullptr},
   {"_get_mkldnn_enabled", (PyCFunction)THPModule_userEnabledMkldnn, METH_NOARGS,     nullptr},
@@ -548,6 +757,8 @@ static PyMethodDef TorchMethods[] = {
   {"_to_dlpack",      (PyCFunction)THPModule_toDLPack,          METH_O,       nullptr},
   {"_from_dlpack",    (PyCFunction)THPModule_fromDLPack,        METH_O,       nullptr},
   {"set_flush_denormal", (PyCFunction)THPModule_setFlushDenormal, METH_O,     nullptr},
+  {"set_lazy_clone_enabled", (PyCFunction)THPModule_setLazyCloneEnabled, METH_O,  nullptr},
+  {"is_lazy_clone_enabled", (PyCFunction)THPModule_lazyCloneEnabled, METH_NOARGS,  nullptr},
   {"get_default_dtype", (PyCFunction)THPModule_getDefaultDtype, METH_NOARGS,  nullptr},
   {"_get_default_device", (PyCFunction)THPModule_getDefaultDevice, METH_NOARGS,   nullptr},
   {"_get_qengine", (PyCFunction)THPModule_qEngine, METH_NOARGS, nullptr},
@@ -600,8 +811,30 @@ static PyObject * THCUDNN_cudnn_version(PyObject *self, PyObject *args)
   return PyLong_FromLong(CUDNN_VERSION);
 }
 
+static PyObject * THCUDNN_saveConvolutionAlgorithms(PyObject *self, PyObject *path)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(path), "path must be a string, but got %s",
+      THPUtils_typename(path));
+  return PyLong_FromLongLong(
+      at::native::cudnn_save_convolution_algorithms(THPUtils_unpackString(path)));
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THCUDNN_loadConvolutionAlgorithms(PyObject *self, PyObject *path)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkString(path), "path must be a string, but got %s",
+      THPUtils_typename(path));
+  return PyLong_FromLongLong(
+      at::native::cudnn_load_convolution_algorithms(THPUtils_unpackString(path)));
+  END_HANDLE_TH_ERRORS
+}
+
 static PyMethodDef _THCUDNN_methods[] = {
   {"_cudnn_version", (PyCFunction)THCUDNN_cudnn_version, METH_VARARGS, nullptr},
+  {"_cudnn_save_convolution_algorithms", (PyCFunction)THCUDNN_saveConvolutionAlgorithms, METH_O, nullptr},
+  {"_cudnn_load_convolution_algorithms", (PyCFunction)THCUDNN_loadConvolutionAlgorithms, METH_O, nullptr},
   {nullptr}
 };
 
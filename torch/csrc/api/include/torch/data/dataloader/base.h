@@ -1,7 +1,9 @@
 #pragma once
 
 #include <torch/data/dataloader_options.h>
+#include <torch/data/device_prefetcher.h>
 #include <torch/data/detail/data_shuttle.h>
+#include <torch/data/detail/device_transfer.h>
 #include <torch/data/detail/sequencers.h>
 #include <torch/data/iterator.h>
 #include <torch/data/samplers/random.h>
@@ -37,6 +39,7 @@ class DataLoaderBase {
       std::unique_ptr<Dataset> main_thread_dataset = nullptr)
       : options_(std::move(options)),
         main_thread_dataset_(std::move(main_thread_dataset)),
+        shuttle_(options_.max_jobs),
         sequencer_(new_sequencer()) {}
 
   virtual ~DataLoaderBase() {
@@ -139,6 +142,9 @@ class DataLoaderBase {
     shuttle_.drain();
     sequence_number_ = 0;
     sequencer_ = new_sequencer();
+    if (to_device_) {
+      to_device_->clear();
+    }
     prefetch();
   }
 
@@ -163,6 +169,22 @@ class DataLoaderBase {
   /// is exhausted. This operation will block until a batch is available if one
   /// is still expected.
   optional<BatchType> next() {
+    if (!options_.prefetch_device) {
+      return next_host_batch();
+    }
+    // Keep `prefetch_batches` copies in flight behind the batch returned now.
+    if (!to_device_) {
+      to_device_ = torch::make_unique<DevicePrefetcher<BatchType>>(
+          [this] { return this->next_host_batch(); },
+          *options_.prefetch_device,
+          options_.prefetch_batches);
+    }
+    return to_device_->next();
+  }
+
+  /// Returns the next batch of data as produced by the dataset (and pinned, if
+  /// `pin_memory` is set), without any transfer to `prefetch_device`.
+  optional<BatchType> next_host_batch() {
     if (options_.workers > 0) {
       while (optional<Result> result = this->pop_result()) {
         if (result->exception) {
@@ -173,11 +195,24 @@ class DataLoaderBase {
         }
       }
     } else if (auto batch_request = get_batch_request()) {
-      return this->main_thread_dataset_->get_batch(std::move(*batch_request));
+      return load_batch(*this->main_thread_dataset_, std::move(*batch_request));
     }
     return nullopt;
   }
 
+  /// Fetches the batch for `batch_request` from `dataset`, pinning it if the
+  /// `pin_memory` option is set.
+  optional<BatchType> load_batch(
+      Dataset& dataset,
+      BatchRequestType batch_request) {
+    detail::PinnedCollationGuard guard(options_.pin_memory);
+    optional<BatchType> batch = dataset.get_batch(std::move(batch_request));
+    if (options_.pin_memory && batch) {
+      batch = detail::pin_batch(std::move(*batch));
+    }
+    return batch;
+  }
+
   /// The function that worker threads run.
   void worker_thread(Dataset& dataset) {
     while (true) {
@@ -186,7 +221,7 @@ class DataLoaderBase {
         break;
       }
       try {
-        auto batch = dataset.get_batch(std::move(*job.batch_request));
+        auto batch = load_batch(dataset, std::move(*job.batch_request));
         shuttle_.push_result({std::move(batch), job.sequence_number});
       } catch (...) {
         shuttle_.push_result({std::current_exception(), job.sequence_number});
@@ -241,6 +276,9 @@ class DataLoaderBase {
 
   /// True if the DataLoader has joined its worker threads.
   bool joined_ = false;
+
+  /// Copies the batches to `prefetch_device` ahead of time, if it is set.
+  std::unique_ptr<DevicePrefetcher<BatchType>> to_device_;
 };
 } // namespace data
 } // namespace torch
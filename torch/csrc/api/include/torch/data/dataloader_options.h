@@ -37,6 +37,21 @@ struct DataLoaderOptions {
   /// Whether to omit the last batch if it contains less than `batch_size`
   /// examples.
   TORCH_ARG(bool, drop_last) = false;
+
+  /// Whether to return batches in pinned (page-locked) host memory, from which
+  /// they can be copied to a GPU asynchronously. Collations that support it
+  /// (like `transforms::Stack`) write each batch into a pinned buffer directly;
+  /// other batches are copied into pinned memory by the thread loading them.
+  TORCH_ARG(bool, pin_memory) = false;
+
+  /// If set, batches are copied to this device ahead of time, on a side
+  /// stream, so that the copies overlap with the work done on the batches
+  /// already returned. Implies `pin_memory`.
+  TORCH_ARG(optional<Device>, prefetch_device);
+
+  /// The number of batches to keep in flight to `prefetch_device`, in addition
+  /// to the one being returned.
+  TORCH_ARG(size_t, prefetch_batches) = 2;
 };
 
 /// Like `DataLoaderOptions`, but without any unconfigured state.
@@ -52,7 +67,10 @@ struct FullDataLoaderOptions {
         max_jobs(options.max_jobs().value_or(2 * workers)),
         timeout(options.timeout()),
         enforce_ordering(options.enforce_ordering()),
-        drop_last(options.drop_last()) {}
+        drop_last(options.drop_last()),
+        pin_memory(options.pin_memory() || options.prefetch_device()),
+        prefetch_device(options.prefetch_device()),
+        prefetch_batches(options.prefetch_batches()) {}
 
   size_t batch_size;
   size_t workers;
@@ -60,6 +78,9 @@ struct FullDataLoaderOptions {
   optional<std::chrono::milliseconds> timeout;
   bool enforce_ordering;
   bool drop_last;
+  bool pin_memory;
+  optional<Device> prefetch_device;
+  size_t prefetch_batches;
 };
 } // namespace data
 } // namespace torch
@@ -4,6 +4,10 @@
 #include <torch/csrc/utils/memory.h>
 #include <torch/data/datasets/stateful.h>
 #include <torch/data/samplers.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <queue>
 #include <thread>
 
@@ -35,12 +39,48 @@ class ChunkDataReader {
   virtual void reset() = 0;
 };
 
+/// Counters describing how well the preloaders of a `ChunkDataset` keep up
+/// with its consumers, accumulated since the last `reset()`.
+struct ChunkDatasetStats {
+  /// The number of batches and examples currently cached.
+  size_t queued_batches = 0;
+  size_t queued_examples = 0;
+
+  /// The current capacity of the cache, in examples.
+  size_t cache_size = 0;
+
+  /// The number of preloader threads currently running.
+  size_t preloader_count = 0;
+
+  /// How often, and for how long in total, `get_batch()` had to wait for
+  /// preloaders to fill the cache.
+  size_t consumer_stalls = 0;
+  std::chrono::nanoseconds consumer_stall_time{0};
+
+  /// How often, and for how long in total, preloaders had to wait for room in
+  /// a full cache.
+  size_t preloader_stalls = 0;
+  std::chrono::nanoseconds preloader_stall_time{0};
+
+  /// The number of chunks read, and how many of those were read by a
+  /// preloader on behalf of another one that claimed them (see
+  /// `cross_chunk_shuffle_count`).
+  size_t chunks_loaded = 0;
+  size_t chunks_stolen = 0;
+};
+
 namespace detail {
 /// BatchDataBuffer manages a queue of UnwrappedBatchData. After a new chunk is
 /// loaded, BatchDataBuffer splits it into small batches and push them into the
 /// queue. When get_batch is called from data loader, it pops cached batches and
 /// return. If the cache is empty, it either waits to load more chunks or return
 /// null if all chunks are loaded.
+///
+/// The capacity of the queue adapts between `queue_capacity` and
+/// `max_queue_capacity`: it grows by one batch every time a reader has to wait
+/// for data, and shrinks by one batch every time a writer has to wait for
+/// room, so that bursty chunk reads are absorbed without holding on to more
+/// memory than needed.
 template <
     typename UnwrappedBatch,
     typename ExampleSampler = samplers::RandomSampler>
@@ -53,22 +93,41 @@ class BatchDataBuffer {
   BatchDataBuffer(
       size_t batch_size,
       ExampleSampler& example_sampler,
-      size_t queue_capacity)
+      size_t queue_capacity,
+      size_t max_queue_capacity = 0)
       : batch_size_(batch_size),
         example_sampler_(example_sampler),
-        queue_capacity_(queue_capacity) {}
+        queue_capacity_(queue_capacity),
+        min_queue_capacity_(queue_capacity),
+        max_queue_capacity_(std::max(queue_capacity, max_queue_capacity)) {}
 
   /// Return batch data from the queue. Called from the ChunkDataset main
-  /// thread.
-  BatchType get_batch() {
+  /// thread. If `stalled` is given, it is set to whether the call had to wait
+  /// for data.
+  BatchType get_batch(bool* stalled = nullptr) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
-    cv_read_.wait(lock, [this] {
+    auto ready = [this] {
       // wait till there is available data in the queue or if all chunks are
       // loaded (i.e. the dataset is exhausted for this epoch)
       return (
           this->total_example_count_in_queue_ >= batch_size_ ||
           this->stop_);
-    });
+    };
+    const bool must_wait = !ready();
+    if (must_wait) {
+      const auto start = std::chrono::steady_clock::now();
+      cv_read_.wait(lock, ready);
+      ++consumer_stalls_;
+      consumer_stall_time_ += std::chrono::steady_clock::now() - start;
+      if (queue_capacity_ < max_queue_capacity_) {
+        queue_capacity_ =
+            std::min(queue_capacity_ + batch_size_, max_queue_capacity_);
+        cv_write_.notify_all();
+      }
+    }
+    if (stalled != nullptr) {
+      *stalled = must_wait && !stop_;
+    }
     if (batch_queue_.empty()) {
       AT_ASSERT(stop_);
       // All batches have been retrieved. Return an empty batch.
@@ -89,18 +148,14 @@ class BatchDataBuffer {
   }
 
   /// Push preloaded chunks to batch queue. Called from the ChunkDataset worker
-  /// threads.
-  void add_chunk_data(UnwrappedBatchType data) {
+  /// threads. Returns whether the call had to wait for room in the queue.
+  bool add_chunk_data(UnwrappedBatchType data) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
-    cv_write_.wait(lock, [this] {
-      // stop loading if we have preloaded enough data.
-      return this->total_example_count_in_queue_ < this->queue_capacity_ ||
-          this->stop_;
-    });
+    const bool stalled = wait_for_room(lock);
     if (stop_) {
       // When stop_ is true, it means no further chunk loading is necessary.
       // Return without any further processing.
-      return;
+      return stalled;
     }
 
     auto data_size = data.size();
@@ -147,18 +202,14 @@ class BatchDataBuffer {
     total_example_count_in_queue_ += data_size;
     lock.unlock();
     cv_read_.notify_all();
+    return stalled;
   }
 
   /// Push exceptions thrown during preloading into batch queue. Called from
   /// the ChunkDataset worker threads.
   void add_chunk_data(std::exception_ptr e_ptr) {
     std::unique_lock<std::mutex> lock(queue_mutex_);
-    cv_write_.wait(lock, [this] {
-      // stop loading if we have preloaded enough data.
-      return (
-        this->total_example_count_in_queue_ < this->queue_capacity_ ||
-        this->stop_);
-    });
+    wait_for_room(lock);
     if (stop_){
       // When stop_ is true, it means this current thread needs to be tore down,
       // the batch buffer will be discarded, so no need to enqueue any new
@@ -193,6 +244,41 @@ class BatchDataBuffer {
     // notify all readers too.
     cv_read_.notify_all();
   }
+
+  /// Fills in the queue related fields of `stats`.
+  void fill_stats(ChunkDatasetStats& stats) {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    stats.queued_batches = batch_queue_.size();
+    stats.queued_examples = total_example_count_in_queue_;
+    stats.cache_size = queue_capacity_;
+    stats.consumer_stalls = consumer_stalls_;
+    stats.consumer_stall_time = consumer_stall_time_;
+    stats.preloader_stalls = preloader_stalls_;
+    stats.preloader_stall_time = preloader_stall_time_;
+  }
+
+  /// Blocks a writer until there is room in the queue or the buffer is
+  /// stopped, shrinking the queue if it had to wait. Returns whether it had to
+  /// wait.
+  bool wait_for_room(std::unique_lock<std::mutex>& lock) {
+    auto has_room = [this] {
+      // stop loading if we have preloaded enough data.
+      return this->total_example_count_in_queue_ < this->queue_capacity_ ||
+          this->stop_;
+    };
+    if (has_room()) {
+      return false;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    cv_write_.wait(lock, has_room);
+    ++preloader_stalls_;
+    preloader_stall_time_ += std::chrono::steady_clock::now() - start;
+    if (queue_capacity_ > min_queue_capacity_) {
+      queue_capacity_ =
+          std::max(queue_capacity_ - batch_size_, min_queue_capacity_);
+    }
+    return true;
+  }
   /// The batch size is needed to create batches from the chunk data. Similar to
   /// regular dataloader where the batches are created with prefetches,
   /// BatchDataBuffer perform the batch creation using the provided batch size.
@@ -231,6 +317,16 @@ class BatchDataBuffer {
   // configurable maximun number of elements the queue can hold at one time.
   size_t queue_capacity_;
 
+  // bounds within which queue_capacity_ adapts to stalls.
+  size_t min_queue_capacity_;
+  size_t max_queue_capacity_;
+
+  // stall counters, see ChunkDatasetStats.
+  size_t consumer_stalls_ = 0;
+  std::chrono::nanoseconds consumer_stall_time_{0};
+  size_t preloader_stalls_ = 0;
+  std::chrono::nanoseconds preloader_stall_time_{0};
+
   // When set to true, it wakes the writer threads from the wait and exit current
   // function call. This is needed when ChunkDataSet.Reset is called while the
   // previous epoch is not exhausted yet. When ChunkDataset is waiting its
@@ -290,6 +386,19 @@ struct ChunkDatasetOptions {
   // penalty when this value is greater than 1, as we need to do extra merge
   // between multiple chunks before performing example sampling.
   TORCH_ARG(size_t, cross_chunk_shuffle_count) = 1;
+
+  /// The maximum number of preloader threads. When larger than
+  /// `preloader_count`, one more preloader is started (up to this many)
+  /// every time `get_batch` has to wait for data, and each of these extra
+  /// preloaders exits again as soon as it has to wait for room in the cache.
+  /// Defaults to `preloader_count`, i.e. a fixed number of preloaders.
+  TORCH_ARG(optional<size_t>, max_preloader_count);
+
+  /// The maximum capacity of the cache. When larger than `cache_size`, the
+  /// cache grows by one batch every time `get_batch` has to wait for data, and
+  /// shrinks back by one batch (down to `cache_size`) every time a preloader
+  /// has to wait for room. Defaults to `cache_size`, i.e. a fixed capacity.
+  TORCH_ARG(optional<size_t>, max_cache_size);
 };
 
 /// A stateful dataset that support hierarchical sampling and prefetching of
@@ -330,7 +439,16 @@ class ChunkDataset final
         preprocessing_policy_(preprocessing_policy),
         quit_worker_(false),
         running_preloaders_(0),
-        load_checkpoint_(false) {}
+        load_checkpoint_(false) {
+    TORCH_CHECK(
+        options_.max_preloader_count().value_or(options_.preloader_count()) >=
+            options_.preloader_count(),
+        "max_preloader_count is less than preloader_count.");
+    TORCH_CHECK(
+        options_.max_cache_size().value_or(options_.cache_size()) >=
+            options_.cache_size(),
+        "max_cache_size is less than cache_size.");
+  }
 
   virtual ~ChunkDataset() {
     // stop batch buffer first.
@@ -354,7 +472,12 @@ class ChunkDataset final
       "The requested batch size does not match with the initialized batch size.\n"
       " The requested batch size is ", batch_size,
       ", while the dataset is created with batch size equal to ", options_.batch_size());
-    return batch_buffer_->get_batch();
+    bool stalled = false;
+    auto batch = batch_buffer_->get_batch(&stalled);
+    if (stalled) {
+      maybe_add_preloader();
+    }
+    return batch;
   }
 
   /// Helper method around get_batch as `batch_size` is not strictly necessary
@@ -385,11 +508,16 @@ class ChunkDataset final
         detail::BatchDataBuffer<UnwrappedBatchType, ExampleSamplerType>>(
         options_.batch_size(),
         example_sampler_,
-        options_.cache_size());
+        options_.cache_size(),
+        options_.max_cache_size().value_or(options_.cache_size()));
+    open_chunk_groups_.clear();
+    chunks_loaded_ = 0;
+    chunks_stolen_ = 0;
 
     // create new workers for this new epoch.
     quit_worker_ = false;
 
+    std::lock_guard<std::mutex> lock(preloader_mutex_);
     AT_ASSERT(running_preloaders_ == 0);
     running_preloaders_ = options_.preloader_count();
     for (size_t i = 0; i < options_.preloader_count(); ++i) {
@@ -397,6 +525,19 @@ class ChunkDataset final
     }
   }
 
+  /// Returns the current queue depth, cache size and preloader count, and the
+  /// stall and chunk counters accumulated since the last `reset()`.
+  ChunkDatasetStats stats() const {
+    ChunkDatasetStats stats;
+    if (batch_buffer_) {
+      batch_buffer_->fill_stats(stats);
+    }
+    stats.preloader_count = running_preloaders_.load();
+    stats.chunks_loaded = chunks_loaded_.load();
+    stats.chunks_stolen = chunks_stolen_.load();
+    return stats;
+  }
+
   /// size is not used for chunk dataset.
   optional<size_t> size() const override {
     return torch::nullopt;
@@ -420,22 +561,115 @@ class ChunkDataset final
   }
 
  private:
+  /// The chunks claimed together for cross-chunk shuffling. The preloader
+  /// claiming the group reads its chunks in order, but as long as some of
+  /// them are unclaimed, idle preloaders steal and read them concurrently, so
+  /// that one slow chunk read doesn't hold up all the others of the group.
+  struct ChunkGroup {
+    explicit ChunkGroup(std::vector<size_t> indices)
+        : chunk_indices(std::move(indices)),
+          chunks(chunk_indices.size()),
+          unread(chunk_indices.size()) {}
+
+    std::vector<size_t> chunk_indices;
+    std::vector<UnwrappedBatchType> chunks;
+    // guarded by chunk_index_guard_
+    size_t next_unclaimed = 0;
+    // guarded by mutex
+    size_t unread;
+    std::exception_ptr exception;
+    std::mutex mutex;
+    std::condition_variable all_read;
+  };
+
+  /// Claims the next unread chunk of `group`, or returns false if all of
+  /// them are claimed. Must be called with `chunk_index_guard_` held.
+  bool claim_chunk(ChunkGroup& group, size_t& slot) {
+    if (group.next_unclaimed == group.chunk_indices.size()) {
+      return false;
+    }
+    slot = group.next_unclaimed++;
+    if (group.next_unclaimed == group.chunk_indices.size()) {
+      auto it = std::find_if(
+          open_chunk_groups_.begin(),
+          open_chunk_groups_.end(),
+          [&](const std::shared_ptr<ChunkGroup>& open) {
+            return open.get() == &group;
+          });
+      if (it != open_chunk_groups_.end()) {
+        open_chunk_groups_.erase(it);
+      }
+    }
+    return true;
+  }
+
+  /// Reads the chunk at `slot` of `group` into it.
+  void read_chunk(ChunkGroup& group, size_t slot) {
+    std::exception_ptr exception;
+    try {
+      group.chunks[slot] = chunk_reader_.read_chunk(group.chunk_indices[slot]);
+    } catch (...) {
+      exception = std::current_exception();
+    }
+    ++chunks_loaded_;
+    {
+      std::lock_guard<std::mutex> lock(group.mutex);
+      if (exception && !group.exception) {
+        group.exception = exception;
+      }
+      --group.unread;
+    }
+    group.all_read.notify_all();
+  }
+
   /// running on worker thread to preload chunk data.
   void preloader(size_t id) {
     while (!quit_worker_.load()) {
       try {
-        std::vector<size_t> chunk_idx;
+        std::shared_ptr<ChunkGroup> group;
+        size_t slot = 0;
+        bool stolen = false;
         {
           std::lock_guard<std::mutex> lock(chunk_index_guard_);
-          if (auto chunk_sampler_result = chunk_sampler_.next(this->options_.cross_chunk_shuffle_count())) {
-            chunk_idx = chunk_sampler_result.value();
+          if (!open_chunk_groups_.empty()) {
+            group = open_chunk_groups_.front();
+            stolen = claim_chunk(*group, slot);
+            AT_ASSERT(stolen);
+          } else if (auto chunk_sampler_result = chunk_sampler_.next(this->options_.cross_chunk_shuffle_count())) {
+            group = std::make_shared<ChunkGroup>(
+                std::move(chunk_sampler_result.value()));
+            if (group->chunk_indices.size() > 1) {
+              open_chunk_groups_.push_back(group);
+            }
+            claim_chunk(*group, slot);
           } else {
             break;
           }
         }
-        UnwrappedBatchType data = chunk_reader_.read_chunk(chunk_idx[0]);
-        for (size_t i = 1; i < chunk_idx.size(); ++i) {
-          auto chunk_data = chunk_reader_.read_chunk(chunk_idx[i]);
+        read_chunk(*group, slot);
+        if (stolen) {
+          ++chunks_stolen_;
+          continue;
+        }
+        while (true) {
+          {
+            std::lock_guard<std::mutex> lock(chunk_index_guard_);
+            if (!claim_chunk(*group, slot)) {
+              break;
+            }
+          }
+          read_chunk(*group, slot);
+        }
+        {
+          std::unique_lock<std::mutex> lock(group->mutex);
+          group->all_read.wait(lock, [&] { return group->unread == 0; });
+          if (group->exception) {
+            std::rethrow_exception(group->exception);
+          }
+        }
+        UnwrappedBatchType data = std::move(group->chunks[0]);
+        for (size_t i = 1; i < group->chunks.size(); ++i) {
+          auto& chunk_data = group->chunks[i];
           std::move(
               chunk_data.begin(), chunk_data.end(), std::back_inserter(data));
         }
@@ -443,12 +677,17 @@ class ChunkDataset final
           preprocessing_policy_(data);
         }
         if (!data.empty()) { // skip empty chunks.
-          batch_buffer_->add_chunk_data(std::move(data));
+          const bool stalled = batch_buffer_->add_chunk_data(std::move(data));
+          if (stalled && id >= options_.preloader_count()) {
+            // Preloaders are outpacing the consumers; retire this extra one.
+            break;
+          }
         }
       } catch (...) {
         batch_buffer_->add_chunk_data(std::current_exception());
       }
     }
+    std::lock_guard<std::mutex> lock(preloader_mutex_);
     AT_ASSERT(running_preloaders_.load() > 0);
     --running_preloaders_;
     if (running_preloaders_.load() == 0) {
@@ -457,11 +696,33 @@ class ChunkDataset final
     }
   }
 
+  /// Starts one more preloader if consumers are waiting on the current ones
+  /// and `max_preloader_count` allows it.
+  void maybe_add_preloader() {
+    const size_t max_preloaders =
+        options_.max_preloader_count().value_or(options_.preloader_count());
+    std::lock_guard<std::mutex> lock(preloader_mutex_);
+    // Once all preloaders are done, they have run out of chunks to load.
+    if (quit_worker_.load() || running_preloaders_.load() == 0 ||
+        running_preloaders_.load() >= max_preloaders) {
+      return;
+    }
+    ++running_preloaders_;
+    const size_t id = preload_threads_.size();
+    preload_threads_.emplace_back([this, id]() { this->preloader(id); });
+  }
+
   /// Block the current thread until the workers finish execution and exit.
   void free_workers() {
     if (!quit_worker_.load()) {
-      quit_worker_ = true;
-      for (auto& worker_thread : preload_threads_) {
+      std::vector<std::thread> threads;
+      {
+        // Don't let get_batch() start new preloaders past this point.
+        std::lock_guard<std::mutex> lock(preloader_mutex_);
+        quit_worker_ = true;
+        threads.swap(preload_threads_);
+      }
+      for (auto& worker_thread : threads) {
         worker_thread.join();
       }
     }
@@ -508,9 +769,21 @@ class ChunkDataset final
   // indicates that the chunk loading is completed.
   std::atomic<size_t> running_preloaders_;
 
-  // mutex to synchronize chunk sampler next() call.
+  // mutex to synchronize chunk sampler next() call, and chunk claims from
+  // open_chunk_groups_.
   mutable std::mutex chunk_index_guard_;
 
+  // chunk groups with chunks nobody has claimed yet, oldest first.
+  std::deque<std::shared_ptr<ChunkGroup>> open_chunk_groups_;
+
+  // guards preload_threads_ and the exit of preloaders against new preloaders
+  // being started by get_batch().
+  std::mutex preloader_mutex_;
+
+  // see ChunkDatasetStats.
+  std::atomic<size_t> chunks_loaded_{0};
+  std::atomic<size_t> chunks_stolen_{0};
+
   // boolean value to indicate whether we need to load the checkpoint for chunk_sampler_.
   bool load_checkpoint_;
 };
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <torch/data/datasets/base.h>
+#include <torch/data/datasets/chunk.h>
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace datasets {
+namespace detail {
+struct MappedFile;
+} // namespace detail
+
+/// Writes `Example<>`s to a record file, which can then be read back with a
+/// `RecordFile`, a `RecordFileDataset` or a `RecordFileChunkReader`.
+///
+/// A record file holds the raw bytes of the data and target tensor of every
+/// example, each aligned to 64 bytes, followed by an index footer with the
+/// dtype, shape and offset of every tensor. Large datasets are usually split
+/// into several such files (shards) that are written independently.
+class TORCH_API RecordFileWriter {
+ public:
+  /// Creates (or truncates) the record file at `path`.
+  explicit RecordFileWriter(const std::string& path);
+
+  /// Calls `close()` if it was not called yet.
+  ~RecordFileWriter();
+
+  /// Appends an example. Both tensors are written in contiguous form and
+  /// must be defined and dense.
+  void write(const Example<>& example);
+
+  /// Writes the index footer and closes the file. No more examples may be
+  /// written afterwards.
+  void close();
+
+ private:
+  struct IndexEntry {
+    int64_t dtype;
+    std::vector<int64_t> sizes;
+    int64_t offset;
+  };
+
+  void write_tensor(const Tensor& tensor);
+  void write_int64(int64_t value);
+
+  std::string path_;
+  std::ofstream stream_;
+  int64_t position_ = 0;
+  std::vector<IndexEntry> index_;
+  bool closed_ = false;
+};
+
+/// One memory-mapped record file, giving random access to its examples.
+///
+/// The tensors returned by `get()` are views into the mapping rather than
+/// copies. The mapping is private and copy-on-write, so writing to one of
+/// them only copies the pages written to and never changes the file. It stays
+/// alive for as long as any of these tensors (or a copy of the `RecordFile`)
+/// does.
+class TORCH_API RecordFile {
+ public:
+  /// Maps the record file at `path` and reads its index footer.
+  explicit RecordFile(const std::string& path);
+
+  /// Returns a view of the example at `index`.
+  Example<> get(size_t index) const;
+
+  /// Returns the number of examples in the file.
+  size_t size() const noexcept;
+
+  /// Returns the path the file was opened from.
+  const std::string& path() const noexcept;
+
+ private:
+  struct TensorEntry {
+    ScalarType dtype;
+    std::vector<int64_t> sizes;
+    int64_t offset;
+  };
+
+  Tensor view(const TensorEntry& entry) const;
+
+  std::string path_;
+  std::shared_ptr<detail::MappedFile> file_;
+  // a data and a target entry per example
+  std::vector<TensorEntry> entries_;
+};
+
+/// A map-style dataset over one or several record file shards, indexed as if
+/// the shards were concatenated in the given order.
+///
+/// Being sized and random access, it works with all samplers; for example a
+/// `samplers::DistributedRandomSampler(dataset.size().value(), world_size,
+/// rank)` gives every rank its own subset of the examples. Because `get()`
+/// returns views into the mapping, only the pages of the examples actually
+/// sampled are ever read from disk.
+class TORCH_API RecordFileDataset : public Dataset<RecordFileDataset> {
+ public:
+  /// Maps all of the record files at `paths`.
+  explicit RecordFileDataset(const std::vector<std::string>& paths);
+
+  /// Returns the `Example` at the given `index`.
+  Example<> get(size_t index) override;
+
+  /// Returns the total number of examples in all the shards.
+  optional<size_t> size() const override;
+
+  /// Returns the mapped shards.
+  const std::vector<RecordFile>& shards() const noexcept;
+
+ private:
+  std::vector<RecordFile> shards_;
+  // the index of the first example of every shard, plus the total size
+  std::vector<size_t> offsets_;
+};
+
+/// A `ChunkDataReader` for record files, where each shard is one chunk.
+///
+/// To split the shards between ranks, pass a distributed sampler as the chunk
+/// sampler of the `ChunkDataset`, e.g.
+/// `samplers::DistributedRandomSampler(reader.chunk_count(), world_size,
+/// rank)`.
+class TORCH_API RecordFileChunkReader : public ChunkDataReader<Example<>> {
+ public:
+  using BatchType = ChunkType;
+
+  /// Maps all of the record files at `paths`.
+  explicit RecordFileChunkReader(const std::vector<std::string>& paths);
+
+  /// Returns views of all the examples in the shard at `chunk_index`.
+  ChunkType read_chunk(size_t chunk_index) override;
+
+  /// Returns the number of shards.
+  size_t chunk_count() override;
+
+  /// Does nothing, since reading a chunk does not change any state.
+  void reset() override;
+
+ private:
+  std::vector<RecordFile> shards_;
+};
+} // namespace datasets
+} // namespace data
+} // namespace torch
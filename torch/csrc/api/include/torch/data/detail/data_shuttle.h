@@ -1,5 +1,6 @@
 #pragma once
 
+#include <torch/data/detail/mpsc_queue.h>
 #include <torch/data/detail/queue.h>
 #include <torch/types.h>
 
@@ -25,6 +26,12 @@ namespace detail {
 template <typename Job, typename Result>
 class DataShuttle {
  public:
+  /// Constructs the `DataShuttle` to hold at most `max_results` results that
+  /// the main thread hasn't popped yet, usually the maximum number of jobs in
+  /// flight. Workers with a result beyond that wait for the main thread.
+  explicit DataShuttle(size_t max_results = kDefaultMaxResults)
+      : results_(max_results) {}
+
   /// Pushes a new job. Called by the main thread.
   void push_job(Job job) {
     new_jobs_.push(std::move(job));
@@ -78,8 +85,11 @@ class DataShuttle {
   /// The number of in-flight jobs.
   /// NOTE: Not atomic because only manipulated by the main thread.
   size_t in_flight_jobs_ = 0;
-  /// The queue for results of finished jobs.
-  Queue<Result> results_;
+  /// The queue for results of finished jobs, which all the workers push to
+  /// and only the main thread pops from.
+  MPSCQueue<Result> results_;
+
+  static constexpr size_t kDefaultMaxResults = 64;
 };
 
 } // namespace detail
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/core/Event.h>
+#include <c10/core/Stream.h>
+#include <c10/core/StreamGuard.h>
+#include <c10/core/impl/VirtualGuardImpl.h>
+#include <c10/util/Exception.h>
+
+#include <utility>
+#include <vector>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// Whether collations running on the current thread should allocate their
+/// output in pinned (page-locked) host memory. Set by the DataLoader on its
+/// worker threads (or the main thread, without workers) when the `pin_memory`
+/// option is enabled, so that e.g. `transforms::Stack` writes each batch
+/// straight into a pinned buffer instead of the DataLoader copying it there
+/// afterwards. Pinned buffers come out of the caching host allocator, which
+/// keeps freed blocks around and only hands them out again once the copies
+/// reading from them have finished.
+inline bool& collate_into_pinned_memory() {
+  static thread_local bool enabled = false;
+  return enabled;
+}
+
+/// RAII guard setting `collate_into_pinned_memory()` for its lifetime.
+struct PinnedCollationGuard {
+  explicit PinnedCollationGuard(bool enabled)
+      : prev_(collate_into_pinned_memory()) {
+    collate_into_pinned_memory() = enabled;
+  }
+  ~PinnedCollationGuard() {
+    collate_into_pinned_memory() = prev_;
+  }
+
+ private:
+  bool prev_;
+};
+
+/// Stacks `tensors` along a new first dimension, into pinned memory if
+/// `collate_into_pinned_memory()` is set.
+inline Tensor stack_batch(const std::vector<Tensor>& tensors) {
+  if (!collate_into_pinned_memory() || tensors.empty() ||
+      !tensors.front().device().is_cpu()) {
+    return torch::stack(tensors);
+  }
+  std::vector<int64_t> sizes = {static_cast<int64_t>(tensors.size())};
+  const auto example_sizes = tensors.front().sizes();
+  sizes.insert(sizes.end(), example_sizes.begin(), example_sizes.end());
+  auto batch =
+      torch::empty(sizes, tensors.front().options().pinned_memory(true));
+  torch::stack_out(batch, tensors, /*dim=*/0);
+  return batch;
+}
+
+/// Copies the tensors of one batch to `device` on a side stream, so that the
+/// copies overlap with whatever the current stream of `device` is running.
+///
+/// The destination tensors are allocated while the current stream is the
+/// calling one, so the caching allocator associates their memory with the
+/// stream that will consume (and eventually free) them. The side stream waits
+/// for everything enqueued on the current stream before the copies start,
+/// which makes it safe to write into memory the allocator just recycled, and
+/// `finish()` returns an event the current stream must wait on before using
+/// the batch.
+class BatchCopier {
+ public:
+  BatchCopier(Device device, c10::Stream side_stream)
+      : device_(device), side_stream_(side_stream), impl_(device.type()) {
+    c10::Event allocated(device_.type());
+    allocated.record(impl_.getStream(device_));
+    allocated.block(side_stream_);
+  }
+
+  Tensor operator()(const Tensor& tensor) {
+    if (!tensor.defined() || tensor.device() == device_) {
+      return tensor;
+    }
+    auto copy = torch::empty(
+        tensor.sizes(), tensor.options().device(device_).pinned_memory(false));
+    c10::StreamGuard guard(side_stream_);
+    copy.copy_(tensor, /*non_blocking=*/true);
+    return copy;
+  }
+
+  c10::Event finish() {
+    c10::Event copied(device_.type());
+    copied.record(side_stream_);
+    return copied;
+  }
+
+ private:
+  Device device_;
+  c10::Stream side_stream_;
+  c10::impl::VirtualGuardImpl impl_;
+};
+
+/// Applies `function` to every tensor in a batch. Batches may be tensors,
+/// `Example`s of transferable types, or vectors of transferable types.
+template <typename Function>
+Tensor map_batch(Tensor tensor, Function& function);
+template <typename Data, typename Function>
+Example<Data, example::NoTarget> map_batch(
+    Example<Data, example::NoTarget> example,
+    Function& function);
+template <typename Data, typename Target, typename Function>
+Example<Data, Target> map_batch(
+    Example<Data, Target> example,
+    Function& function);
+template <typename T, typename Function>
+std::vector<T> map_batch(std::vector<T> batch, Function& function);
+
+template <typename T, typename Function>
+T map_batch(T batch, Function& function) {
+  TORCH_CHECK(
+      false,
+      "The pin_memory and prefetch_device DataLoader options only support "
+      "batches made of tensors, Examples and vectors thereof");
+  return batch;
+}
+
+template <typename Function>
+Tensor map_batch(Tensor tensor, Function& function) {
+  return function(tensor);
+}
+
+template <typename Data, typename Function>
+Example<Data, example::NoTarget> map_batch(
+    Example<Data, example::NoTarget> example,
+    Function& function) {
+  return {map_batch(std::move(example.data), function)};
+}
+
+template <typename Data, typename Target, typename Function>
+Example<Data, Target> map_batch(
+    Example<Data, Target> example,
+    Function& function) {
+  return {map_batch(std::move(example.data), function),
+          map_batch(std::move(example.target), function)};
+}
+
+template <typename T, typename Function>
+std::vector<T> map_batch(std::vector<T> batch, Function& function) {
+  for (auto& element : batch) {
+    element = map_batch(std::move(element), function);
+  }
+  return batch;
+}
+
+/// Returns `batch` with all of its CPU tensors in pinned memory. Tensors that
+/// were collated into pinned memory already are returned as they are.
+template <typename Batch>
+Batch pin_batch(Batch batch) {
+  auto pin = [](const Tensor& tensor) {
+    if (!tensor.defined() || !tensor.device().is_cpu() || tensor.is_pinned()) {
+      return tensor;
+    }
+    return tensor.pin_memory();
+  };
+  return map_batch(std::move(batch), pin);
+}
+
+} // namespace detail
+} // namespace data
+} // namespace torch
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace torch {
+namespace data {
+namespace detail {
+
+/// A bounded, multi-producer single-consumer queue on a ring buffer.
+///
+/// Producers claim a slot by incrementing a shared position and publish their
+/// value through the sequence number of the slot, so that neither side takes
+/// a lock while the queue is neither empty nor full. Only a consumer finding
+/// the queue empty, or a producer finding it full, goes to sleep on a
+/// condition variable (a futex on Linux), and the other side only takes the
+/// mutex to wake it up when it knows someone is sleeping.
+///
+/// This is the queue the `DataLoader` worker threads hand their results to
+/// the main thread with. As for `Queue`, its behavior is tailored to this use
+/// case: only one thread may call `pop()` and `clear()`.
+template <typename T>
+class MPSCQueue {
+ public:
+  /// Constructs the queue to hold at most `capacity` values, rounded up to a
+  /// power of two. Producers pushing to a full queue block until the consumer
+  /// pops a value.
+  explicit MPSCQueue(size_t capacity) {
+    capacity_ = 1;
+    while (capacity_ < capacity) {
+      capacity_ *= 2;
+    }
+    mask_ = capacity_ - 1;
+    slots_.reset(new Slot[capacity_]);
+    for (size_t i = 0; i < capacity_; ++i) {
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MPSCQueue(const MPSCQueue&) = delete;
+  MPSCQueue& operator=(const MPSCQueue&) = delete;
+
+  /// Pushes a new value to the back of the queue, waking up the consumer if
+  /// it is waiting inside a call to `pop()`. Called by any thread.
+  void push(T value) {
+    const size_t position = claim_position();
+    Slot& slot = slots_[position & mask_];
+    slot.value = std::move(value);
+    slot.sequence.store(position + 1, std::memory_order_release);
+    wake(consumer_waiting_, consumer_cv_);
+  }
+
+  /// Blocks until at least one element is ready to be popped from the front of
+  /// the queue. An optional `timeout` in seconds can be used to limit the time
+  /// spent waiting for an element. If the wait times out, an exception is
+  /// raised.
+  T pop(optional<std::chrono::milliseconds> timeout = nullopt) {
+    Slot& slot = slots_[dequeue_position_ & mask_];
+    if (!ready(slot)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      consumer_waiting_.store(true);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      auto is_ready = [this, &slot] { return this->ready(slot); };
+      bool woken = true;
+      if (timeout) {
+        woken = consumer_cv_.wait_for(lock, *timeout, is_ready);
+      } else {
+        consumer_cv_.wait(lock, is_ready);
+      }
+      consumer_waiting_.store(false);
+      if (!woken) {
+        // clang-format off
+        AT_ERROR(
+            "Timeout in DataLoader queue while waiting for next batch"
+            " (timeout was ", timeout->count(), " ms)");
+        // clang-format on
+      }
+    }
+    T value = std::move(*slot.value);
+    slot.value = nullopt;
+    slot.sequence.store(
+        dequeue_position_ + capacity_, std::memory_order_release);
+    ++dequeue_position_;
+    wake(producers_waiting_, producers_cv_);
+    return value;
+  }
+
+  /// Empties the queue and returns the number of elements that were present at
+  /// the start of the function. Called by the consumer.
+  size_t clear() {
+    size_t size = 0;
+    while (ready(slots_[dequeue_position_ & mask_])) {
+      pop();
+      ++size;
+    }
+    return size;
+  }
+
+  /// The number of values the queue holds at most.
+  size_t capacity() const noexcept {
+    return capacity_;
+  }
+
+ private:
+  struct Slot {
+    /// `position + 1` once the value of the push at `position` is published,
+    /// and `position` while the slot is free for the push at `position`.
+    std::atomic<size_t> sequence;
+    optional<T> value;
+  };
+
+  bool ready(const Slot& slot) const {
+    return slot.sequence.load(std::memory_order_acquire) ==
+        dequeue_position_ + 1;
+  }
+
+  /// Positions wrap around, so they are compared by their difference.
+  static std::ptrdiff_t distance(size_t from, size_t to) {
+    return static_cast<std::ptrdiff_t>(to - from);
+  }
+
+  /// Claims the next position to push to, waiting for the consumer to free
+  /// its slot if the queue is full.
+  size_t claim_position() {
+    size_t position = enqueue_position_.load(std::memory_order_relaxed);
+    for (int spins = 0;; ++spins) {
+      Slot& slot = slots_[position & mask_];
+      const size_t sequence = slot.sequence.load(std::memory_order_acquire);
+      if (sequence == position) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          return position;
+        }
+      } else if (distance(position, sequence) < 0) {
+        // The slot still holds the value pushed a lap ago: the queue is full.
+        if (spins < kSpinsBeforeWaiting) {
+          std::this_thread::yield();
+        } else {
+          std::unique_lock<std::mutex> lock(mutex_);
+          producers_waiting_.fetch_add(1);
+          std::atomic_thread_fence(std::memory_order_seq_cst);
+          producers_cv_.wait(lock, [&slot, position] {
+            return distance(
+                       position,
+                       slot.sequence.load(std::memory_order_acquire)) >= 0;
+          });
+          producers_waiting_.fetch_sub(1);
+        }
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      } else {
+        // Another producer claimed the position first.
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /// Wakes up the threads waiting on `cv`, if `waiting` says there are any.
+  template <typename Waiting>
+  void wake(const Waiting& waiting, std::condition_variable& cv) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load()) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv.notify_all();
+    }
+  }
+
+  static constexpr int kSpinsBeforeWaiting = 64;
+
+  size_t capacity_;
+  size_t mask_;
+  std::unique_ptr<Slot[]> slots_;
+  std::atomic<size_t> enqueue_position_{0};
+  /// Only touched by the consumer.
+  size_t dequeue_position_ = 0;
+
+  std::mutex mutex_;
+  std::atomic<bool> consumer_waiting_{false};
+  std::condition_variable consumer_cv_;
+  std::atomic<int> producers_waiting_{0};
+  std::condition_variable producers_cv_;
+};
+
+template <typename T>
+constexpr int MPSCQueue<T>::kSpinsBeforeWaiting;
+} // namespace detail
+} // namespace data
+} // namespace torch
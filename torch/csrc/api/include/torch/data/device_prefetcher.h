@@ -0,0 +1,173 @@
+#pragma once
+
+#include <torch/data/detail/device_transfer.h>
+#include <torch/data/iterator.h>
+#include <torch/types.h>
+
+#include <torch/csrc/utils/memory.h>
+
+#include <c10/core/Event.h>
+#include <c10/core/Stream.h>
+#include <c10/core/impl/VirtualGuardImpl.h>
+#include <c10/util/Exception.h>
+
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <utility>
+
+namespace torch {
+namespace data {
+
+/// Copies the batches of a host-side batch source to a device ahead of time,
+/// keeping `batches_in_flight` copies running on a side stream behind the
+/// batch being consumed.
+///
+/// The source can be any pair of `DataLoader` iterators, or a function
+/// returning the next batch (or `nullopt` once it is exhausted). Batches may be
+/// tensors, `Example`s or vectors thereof. Their CPU tensors are pinned first
+/// (unless they already are, e.g. with the `pin_memory` DataLoader option), so
+/// that the copies from them are asynchronous.
+///
+/// Each device tensor is allocated while the calling thread's current stream
+/// is the current one, so the caching allocator ties its memory to that
+/// stream and no `recordStream()` call is needed for the side stream writing
+/// into it. In turn, batches must be used on the stream that was current when
+/// calling `next()`: it is made to wait on the copies of a batch before
+/// `next()` returns it, without blocking the host.
+///
+/// \rst
+/// .. code-block:: cpp
+///
+///   auto loader = torch::data::make_data_loader(dataset, options);
+///   torch::data::DevicePrefetcher<Batch> prefetcher(
+///       loader->begin(), loader->end(), torch::kCUDA);
+///   for (auto& batch : prefetcher) {
+///     // `batch` lives on the current CUDA device.
+///   }
+/// \endrst
+template <typename Batch>
+class DevicePrefetcher {
+ public:
+  using BatchType = Batch;
+  using BatchProducer = std::function<optional<Batch>()>;
+
+  /// Prefetches the batches returned by `next_batch` to `device`.
+  DevicePrefetcher(
+      BatchProducer next_batch,
+      Device device,
+      size_t batches_in_flight = 2)
+      : next_batch_(std::move(next_batch)),
+        device_(with_index(device)),
+        batches_in_flight_(batches_in_flight),
+        stream_(c10::impl::VirtualGuardImpl(device_.type())
+                    .getStreamFromPool(device_)) {}
+
+  /// Prefetches the batches from `begin` up to `end` (e.g. the iterators of a
+  /// `DataLoader`) to `device`.
+  DevicePrefetcher(
+      Iterator<Batch> begin,
+      Iterator<Batch> end,
+      Device device,
+      size_t batches_in_flight = 2)
+      : DevicePrefetcher(
+            IteratorRange{std::move(begin), std::move(end)},
+            device,
+            batches_in_flight) {}
+
+  DevicePrefetcher(const DevicePrefetcher&) = delete;
+  DevicePrefetcher& operator=(const DevicePrefetcher&) = delete;
+
+  /// Returns the next batch, resident on the device, or an empty `optional`
+  /// once the source is exhausted. Starts the copies of the batches behind it
+  /// first, so that they run while the returned one is consumed.
+  optional<Batch> next() {
+    while (in_flight_.size() <= batches_in_flight_) {
+      auto batch = next_batch_();
+      if (!batch) {
+        break;
+      }
+      auto pinned = detail::pin_batch(std::move(*batch));
+      detail::BatchCopier copier(device_, stream_);
+      auto copy = detail::map_batch(std::move(pinned), copier);
+      in_flight_.push_back({std::move(copy), copier.finish()});
+    }
+    if (in_flight_.empty()) {
+      return nullopt;
+    }
+    InFlightBatch ready = std::move(in_flight_.front());
+    in_flight_.pop_front();
+    ready.copied.block(
+        c10::impl::VirtualGuardImpl(device_.type()).getStream(device_));
+    return std::move(ready.batch);
+  }
+
+  /// Discards the batches copied ahead of time. Their memory goes back to the
+  /// caching allocator once the copies into it have finished.
+  void clear() {
+    in_flight_.clear();
+  }
+
+  /// Returns an iterator over the remaining device-resident batches. Like the
+  /// iterators of a `DataLoader`, it may only be incremented and dereferenced.
+  Iterator<Batch> begin() {
+    return Iterator<Batch>(torch::make_unique<detail::ValidIterator<Batch>>(
+        [this] { return this->next(); }));
+  }
+
+  /// Returns the sentinel iterator comparing equal to an iterator of `begin()`
+  /// once the source is exhausted.
+  Iterator<Batch> end() {
+    return Iterator<Batch>(
+        torch::make_unique<detail::SentinelIterator<Batch>>());
+  }
+
+  /// The device batches are copied to.
+  Device device() const noexcept {
+    return device_;
+  }
+
+  /// The side stream the copies run on.
+  c10::Stream stream() const noexcept {
+    return stream_;
+  }
+
+ private:
+  /// Returns `device`, with the current device of its type filled in if it has
+  /// no index.
+  static Device with_index(Device device) {
+    if (!device.has_index()) {
+      device = c10::impl::VirtualGuardImpl(device.type()).getDevice();
+    }
+    return device;
+  }
+
+  /// Adapts a pair of iterators to a `BatchProducer`.
+  struct IteratorRange {
+    optional<Batch> operator()() {
+      if (begin == end) {
+        return nullopt;
+      }
+      Batch batch = std::move(*begin);
+      ++begin;
+      return batch;
+    }
+    Iterator<Batch> begin;
+    Iterator<Batch> end;
+  };
+
+  /// A batch whose copy to the device may still be running, along with the
+  /// event marking the end of that copy.
+  struct InFlightBatch {
+    Batch batch;
+    c10::Event copied;
+  };
+
+  BatchProducer next_batch_;
+  Device device_;
+  size_t batches_in_flight_;
+  c10::Stream stream_;
+  std::deque<InFlightBatch> in_flight_;
+};
+} // namespace data
+} // namespace torch
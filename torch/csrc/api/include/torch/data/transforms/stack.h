@@ -1,5 +1,6 @@
 #pragma once
 
+#include <torch/data/detail/device_transfer.h>
 #include <torch/data/example.h>
 #include <torch/data/transforms/collate.h>
 #include <torch/types.h>
@@ -16,6 +17,8 @@ struct Stack;
 
 /// A `Collation` for `Example<Tensor, Tensor>` types that stacks all data
 /// tensors into one tensor, and all target (label) tensors into one tensor.
+/// When loaded by a DataLoader with `pin_memory` enabled, the stacked tensors
+/// are written straight into pinned memory.
 template <>
 struct Stack<Example<>> : public Collation<Example<>> {
   Example<> apply_batch(std::vector<Example<>> examples) override {
@@ -26,7 +29,7 @@ struct Stack<Example<>> : public Collation<Example<>> {
       data.push_back(std::move(example.data));
       targets.push_back(std::move(example.target));
     }
-    return {torch::stack(data), torch::stack(targets)};
+    return {detail::stack_batch(data), detail::stack_batch(targets)};
   }
 };
 
@@ -41,7 +44,7 @@ struct Stack<TensorExample>
     for (auto& example : examples) {
       data.push_back(std::move(example.data));
     }
-    return torch::stack(data);
+    return detail::stack_batch(data);
   }
 };
 } // namespace transforms
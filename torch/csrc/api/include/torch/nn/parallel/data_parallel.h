@@ -9,16 +9,22 @@
 #include <torch/csrc/autograd/functions/utils.h>
 #ifdef USE_CUDA
 #include <torch/csrc/cuda/comm.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
 #endif
 #include <ATen/core/functional.h>
+#include <ATen/core/grad_mode.h>
 
 #include <ATen/Device.h>
 #include <ATen/Parallel.h>
 #include <c10/core/TensorOptions.h>
+#include <c10/core/thread_pool.h>
 #include <c10/util/Exception.h>
+#include <c10/util/thread_name.h>
 
 #include <cstddef>
 #include <exception>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <vector>
@@ -287,6 +293,272 @@ Tensor data_parallel(
 #endif
 }
 
+/// Evaluates a module in parallel across several devices like
+/// `data_parallel()`, but keeps its replicas, and a worker thread and a CUDA
+/// stream per device, from one call to the next instead of cloning the module
+/// and spawning the threads on every call.
+///
+/// The module is moved to the first device and replicated once. Before every
+/// `forward()`, `sync()` broadcasts the parameters and buffers of the module to
+/// the replicas if any of them changed since the last broadcast, which is told
+/// from their version counters, so that the steps of an optimizer are picked
+/// up. Gradients flow back into the parameters of the module as with
+/// `data_parallel()`. Parameters and buffers must not be added to or removed
+/// from the module once it is wrapped.
+///
+/// Each replica runs `forward()` on the worker thread of its device, with the
+/// stream of that device current. The worker streams wait for the work queued
+/// on the current streams of their devices before the input is scattered, and
+/// the current streams wait for the worker streams before the outputs are
+/// gathered, so that the caller sees the same ordering as with
+/// `data_parallel()`.
+///
+/// \rst
+/// .. code-block:: cpp
+///
+///   torch::nn::parallel::PersistentDataParallel<torch::nn::Linear> parallel(
+///       torch::nn::Linear(10, 5));
+///   torch::optim::SGD optimizer(parallel.module()->parameters(), 0.1);
+///   for (auto& batch : *data_loader) {
+///     optimizer.zero_grad();
+///     auto loss = parallel.forward(batch.data).sum();
+///     loss.backward();
+///     optimizer.step();
+///   }
+/// \endrst
+template <typename ModuleType>
+class PersistentDataParallel {
+ public:
+  explicit PersistentDataParallel(
+      ModuleType module,
+      optional<std::vector<Device>> devices = nullopt,
+      optional<Device> output_device = nullopt,
+      int64_t dim = 0)
+      : module_(std::move(module)), dim_(dim) {
+    if (devices) {
+      devices_ = std::move(*devices);
+    } else {
+      const auto device_count = torch::cuda::device_count();
+      TORCH_CHECK(
+          device_count > 0,
+          "Expected at least one CUDA device to be available");
+      devices_.reserve(device_count);
+      for (size_t index = 0; index < device_count; ++index) {
+        devices_.emplace_back(kCUDA, index);
+      }
+    }
+    TORCH_CHECK(!devices_.empty(), "Expected at least one device");
+    output_device_ = output_device ? *output_device : devices_.front();
+
+    module_->to(devices_.front());
+    if (devices_.size() == 1) {
+      replicas_.push_back(module_);
+      return;
+    }
+#ifdef USE_CUDA
+    for (const auto& device : devices_) {
+      TORCH_CHECK(
+          device.is_cuda(),
+          "PersistentDataParallel expects CUDA devices, but got ",
+          device);
+    }
+    replicas_ = replicate(module_, devices_);
+    record_versions();
+    for (const auto& device : devices_) {
+      streams_.push_back(at::cuda::getStreamFromPool(
+          /*isHighPriority=*/false, device.index()));
+      workers_.emplace_back(new c10::ThreadPool(
+          /*pool_size=*/1, /*numa_node_id=*/-1, []() {
+            c10::setThreadName("DataParallel");
+          }));
+    }
+    ready_events_.resize(devices_.size());
+    done_events_.resize(devices_.size());
+#else
+    AT_ERROR("data_parallel not supported without CUDA");
+#endif
+  }
+
+  /// Evaluates the module with `input`, split along `dim` across the devices,
+  /// and returns the outputs concatenated along `dim` on the output device.
+  Tensor forward(Tensor input) {
+    if (devices_.size() == 1) {
+      input = input.to(devices_.front());
+      return module_->forward(std::move(input)).to(output_device_);
+    }
+
+#ifdef USE_CUDA
+    sync();
+
+    // The worker streams wait for the broadcast and for the input.
+    for (size_t i = 0; i < devices_.size(); ++i) {
+      ready_events_[i].record(
+          at::cuda::getCurrentCUDAStream(devices_[i].index()));
+      ready_events_[i].block(streams_[i]);
+    }
+    if (input.is_cuda()) {
+      at::cuda::CUDAEvent input_ready;
+      input_ready.record(at::cuda::getCurrentCUDAStream(input.get_device()));
+      for (const auto& stream : streams_) {
+        input_ready.block(stream);
+      }
+    }
+
+    std::vector<c10::optional<at::cuda::CUDAStream>> streams(
+        streams_.begin(), streams_.end());
+    autograd::Scatter scatter(devices_, /*chunk_sizes=*/nullopt, dim_, streams);
+    auto inputs = fmap<Tensor>(scatter.apply({std::move(input)}));
+
+    const bool grad_mode = at::GradMode::is_enabled();
+    std::vector<std::future<Tensor>> futures;
+    futures.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      auto promise = std::make_shared<std::promise<Tensor>>();
+      futures.push_back(promise->get_future());
+      workers_[i]->run([this, i, grad_mode, promise, &inputs]() {
+        try {
+          // Grad mode is thread local.
+          at::AutoGradMode grad_mode_guard(grad_mode);
+          at::cuda::CUDAStreamGuard stream_guard(streams_[i]);
+          auto output = replicas_[i]->forward(inputs[i]).to(devices_[i]);
+          done_events_[i].record(streams_[i]);
+          promise->set_value(std::move(output));
+        } catch (...) {
+          promise->set_exception(std::current_exception());
+        }
+      });
+    }
+
+    // As with parallel_apply(), the first exception is rethrown once all the
+    // replicas are done.
+    std::vector<Tensor> outputs(futures.size());
+    std::exception_ptr exception;
+    for (size_t i = 0; i < futures.size(); ++i) {
+      try {
+        outputs[i] = futures[i].get();
+        done_events_[i].block(
+            at::cuda::getCurrentCUDAStream(devices_[i].index()));
+      } catch (...) {
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+
+    // The memory the replicas allocated on the worker streams is only reused
+    // by the next call, whose worker streams first wait for the gather below,
+    // so it doesn't need to be recorded on the current streams.
+    return autograd::Gather(output_device_, dim_)
+        .apply(fmap<autograd::Variable>(std::move(outputs)))
+        .front();
+#else
+    AT_ERROR("data_parallel not supported without CUDA");
+    return Tensor();
+#endif
+  }
+
+  /// Broadcasts the parameters and buffers of the module to the replicas if
+  /// any of them was modified or replaced since the last broadcast. Called by
+  /// `forward()`.
+  void sync() {
+#ifdef USE_CUDA
+    if (devices_.size() == 1 || !changed()) {
+      return;
+    }
+    auto tensors = tensors_of(module_);
+    std::vector<int64_t> device_indices;
+    device_indices.reserve(devices_.size());
+    for (const auto& device : devices_) {
+      device_indices.push_back(device.index());
+    }
+    at::NoGradGuard no_grad;
+    auto copies = torch::cuda::broadcast_coalesced(
+        tensors, device_indices, kBroadcastBufferSize);
+    for (size_t i = 0; i < replicas_.size(); ++i) {
+      auto replica_tensors = tensors_of(replicas_[i]);
+      TORCH_CHECK(
+          replica_tensors.size() == tensors.size(),
+          "The parameters or buffers of a module wrapped in "
+          "PersistentDataParallel must not be added or removed");
+      for (size_t j = 0; j < tensors.size(); ++j) {
+        // set_data() keeps the gradient edges of the replicas, see
+        // [Replicating Modules]
+        replica_tensors[j].set_data(copies[i][j]);
+      }
+    }
+    record_versions();
+#endif
+  }
+
+  /// The wrapped module, which lives on the first device.
+  const ModuleType& module() const {
+    return module_;
+  }
+
+  /// The replica of each device; the first one is the module itself when
+  /// there is a single device.
+  const std::vector<ModuleType>& replicas() const {
+    return replicas_;
+  }
+
+  const std::vector<Device>& devices() const {
+    return devices_;
+  }
+
+ private:
+  // The one of DistributedDataParallel in Python
+  static constexpr size_t kBroadcastBufferSize = 10 * 1024 * 1024;
+
+  static std::vector<Tensor> tensors_of(const ModuleType& module) {
+    auto tensors = module->parameters();
+    auto buffers = module->buffers();
+    tensors.insert(tensors.end(), buffers.begin(), buffers.end());
+    return tensors;
+  }
+
+  bool changed() const {
+    auto tensors = tensors_of(module_);
+    if (tensors.size() != versions_.size()) {
+      return true;
+    }
+    for (size_t i = 0; i < tensors.size(); ++i) {
+      if (tensors[i].unsafeGetTensorImpl() != versions_[i].first ||
+          tensors[i]._version() != versions_[i].second) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void record_versions() {
+    versions_.clear();
+    for (const auto& tensor : tensors_of(module_)) {
+      versions_.emplace_back(
+          tensor.unsafeGetTensorImpl(), tensor._version());
+    }
+  }
+
+  ModuleType module_;
+  std::vector<Device> devices_;
+  Device output_device_{kCPU};
+  int64_t dim_;
+  std::vector<ModuleType> replicas_;
+  // The parameters and buffers of the module as of the last broadcast
+  std::vector<std::pair<const c10::TensorImpl*, int64_t>> versions_;
+#ifdef USE_CUDA
+  std::vector<at::cuda::CUDAStream> streams_;
+  std::vector<std::unique_ptr<c10::ThreadPool>> workers_;
+  std::vector<at::cuda::CUDAEvent> ready_events_;
+  std::vector<at::cuda::CUDAEvent> done_events_;
+#endif
+};
+
+template <typename ModuleType>
+constexpr size_t PersistentDataParallel<ModuleType>::kBroadcastBufferSize;
+
 } // namespace parallel
 } // namespace nn
 } // namespace torch
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <torch/arg.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/serialize/output-archive.h>
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace torch {
+namespace serialize {
+namespace detail {
+struct CheckpointJob;
+} // namespace detail
+
+/// Options for an `AsyncCheckpointer`.
+struct TORCH_API AsyncCheckpointOptions {
+  /// The number of checkpoints that may be snapshotted but not yet written.
+  /// `save()` blocks while this many are pending, so that at most this many
+  /// snapshots are held in host memory.
+  TORCH_ARG(size_t, max_pending) = 1;
+};
+
+/// Saves checkpoints from a background thread.
+///
+/// `save()` snapshots the tensors of the value into host memory and returns
+/// a future that becomes ready once the checkpoint has been written, so that
+/// training only waits for the snapshot and not for the file. Each tensor on
+/// the GPU is copied into pinned memory with a non-blocking copy on the
+/// current stream of its device, so the copy is ordered before any later work
+/// that overwrites the tensor and nothing synchronizes with the GPU on the
+/// calling thread. The background thread waits for the copies before it
+/// writes the archive. Tensors on the CPU are cloned by `save()`.
+///
+/// Checkpoints are written in the order they were saved. Only tensors in the
+/// archive (parameters, buffers, tensor and tensor list values) are
+/// snapshotted, any other value is serialized from the background thread.
+///
+/// \rst
+/// .. code-block:: cpp
+///
+///   torch::serialize::AsyncCheckpointer checkpointer;
+///   for (size_t step = 0; step < steps; ++step) {
+///     train_step(model, optimizer);
+///     if (step % 1000 == 0) {
+///       checkpointer.save(model, "model-" + std::to_string(step) + ".pt");
+///     }
+///   }
+///   checkpointer.wait();
+/// \endrst
+class TORCH_API AsyncCheckpointer {
+ public:
+  explicit AsyncCheckpointer(AsyncCheckpointOptions options = {});
+
+  /// Waits for all pending checkpoints.
+  ~AsyncCheckpointer();
+
+  AsyncCheckpointer(const AsyncCheckpointer&) = delete;
+  AsyncCheckpointer& operator=(const AsyncCheckpointer&) = delete;
+
+  /// Snapshots the given `value` and writes it to the file at `filename` in
+  /// the background. There must be an overload of `operator<<` between
+  /// `OutputArchive` and `Value`, as for `torch::save()`.
+  template <typename Value>
+  std::shared_future<void> save(const Value& value, std::string filename) {
+    auto archive = make_archive(value);
+    return save(
+        std::move(archive),
+        [filename](OutputArchive& archive) { archive.save_to(filename); });
+  }
+
+  /// Snapshots the given `value` and writes it with `writer_func` in the
+  /// background. `writer_func` is called from the background thread.
+  template <typename Value>
+  std::shared_future<void> save(
+      const Value& value,
+      std::function<size_t(const void*, size_t)> writer_func) {
+    auto archive = make_archive(value);
+    return save(
+        std::move(archive),
+        [writer_func](OutputArchive& archive) { archive.save_to(writer_func); });
+  }
+
+  /// Snapshots the tensors of `archive` and calls `save_to` with the archive
+  /// from the background thread. The archive cannot be a streaming one.
+  std::shared_future<void> save(
+      OutputArchive archive,
+      std::function<void(OutputArchive&)> save_to);
+
+  /// Waits until all checkpoints saved so far have been written. Rethrows the
+  /// error of the first one that failed to be written since the last `wait()`.
+  void wait();
+
+  /// The number of checkpoints that have been saved but not yet written.
+  size_t pending() const;
+
+ private:
+  template <typename Value>
+  static OutputArchive make_archive(const Value& value) {
+    OutputArchive archive(std::make_shared<jit::script::CompilationUnit>());
+    archive << value;
+    return archive;
+  }
+
+  void run();
+
+  AsyncCheckpointOptions options_;
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::unique_ptr<detail::CheckpointJob>> jobs_;
+  size_t pending_ = 0;
+  std::exception_ptr error_;
+  bool shutdown_ = false;
+  std::thread thread_;
+};
+} // namespace serialize
+} // namespace torch
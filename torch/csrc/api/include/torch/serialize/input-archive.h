@@ -15,6 +15,12 @@ namespace at {
 class Tensor;
 } // namespace at
 
+namespace caffe2 {
+namespace serialize {
+class PyTorchStreamReader;
+} // namespace serialize
+} // namespace caffe2
+
 namespace torch {
 using at::Tensor;
 namespace jit {
@@ -26,6 +32,10 @@ struct Module;
 
 namespace torch {
 namespace serialize {
+namespace detail {
+struct LazyArchive;
+struct LazyNode;
+} // namespace detail
 
 /// A recursive representation of tensors that can be deserialized from a file
 /// or stream. In most cases, users should not have to interact with this class,
@@ -69,9 +79,21 @@ class TORCH_API InputArchive final {
   /// nested data.
   void read(const std::string& key, InputArchive& archive);
 
+  /// Whether the archive was loaded from a streaming archive, see below.
+  bool is_lazy() const {
+    return lazy_ != nullptr;
+  }
+
   /// Loads the `InputArchive` from a serialized representation stored in the
   /// file at `filename`. Storage are remapped using device option. If device
   /// is not specified, the module is loaded to the original device.
+  ///
+  /// An archive written by a streaming `OutputArchive` is loaded lazily: only
+  /// its index is read here, and a tensor is read in chunks when it is read
+  /// from this archive. A defined tensor of the same dtype and shape on the
+  /// target device is read into in place, without any other copy of it. The
+  /// source of a lazy archive (the stream or data below) has to outlive the
+  /// archive and the archives read from it.
   void load_from(const std::string& filename,
       c10::optional<torch::Device> device = c10::nullopt);
 
@@ -101,7 +123,15 @@ class TORCH_API InputArchive final {
   }
 
  private:
+  /// Loads the archive lazily if `reader` holds a streaming archive, returns
+  /// false otherwise.
+  bool load_lazy(
+      std::unique_ptr<caffe2::serialize::PyTorchStreamReader> reader,
+      c10::optional<torch::Device> device);
+
   jit::script::Module module_;
+  std::shared_ptr<detail::LazyArchive> lazy_;
+  const detail::LazyNode* node_ = nullptr;
 };
 } // namespace serialize
 } // namespace torch
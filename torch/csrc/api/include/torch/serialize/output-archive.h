@@ -1,8 +1,12 @@
 #pragma once
 
+#include <torch/arg.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 #include <torch/csrc/jit/script/module.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <iosfwd>
 #include <memory>
 #include <string>
@@ -23,11 +27,45 @@ struct Module;
 
 namespace torch {
 namespace serialize {
+namespace detail {
+struct CheckpointJob;
+struct StreamingWriter;
+} // namespace detail
+
+/// Options for an `OutputArchive` that streams its tensors into the archive
+/// as they are written.
+struct TORCH_API StreamingOptions {
+  /// Tensors are stored in records of at most this many bytes, and tensors on
+  /// the GPU are copied to the host through pinned buffers of this size.
+  TORCH_ARG(size_t, chunk_size) = 64 << 20;
+  /// The number of pinned staging buffers. While one chunk is written out,
+  /// the copies of the next ones from the GPU are already in flight.
+  TORCH_ARG(size_t, staging_buffers) = 2;
+  /// The boundary the data of every record starts on, see
+  /// `caffe2::serialize::PyTorchStreamWriter`.
+  TORCH_ARG(uint64_t, alignment) = 64;
+};
+
 class TORCH_API OutputArchive final {
  public:
   explicit OutputArchive(std::shared_ptr<jit::script::CompilationUnit> cu);
   explicit OutputArchive() : cu_(std::make_shared<jit::script::CompilationUnit>()) {}
 
+  /// Creates an `OutputArchive` that writes every tensor to the file at
+  /// `filename` as soon as it is written to the archive, instead of building
+  /// the whole archive in memory. Nested archives are written out when they
+  /// are written into this one, so saving only ever holds references to the
+  /// tensors and `options().staging_buffers()` chunks of their data. Call
+  /// `finish()` to complete the file. Such an archive is loaded lazily by
+  /// `InputArchive::load_from()`, see there.
+  OutputArchive(const std::string& filename, StreamingOptions options);
+
+  /// Creates an `OutputArchive` that streams its tensors to the given writer
+  /// function, see above.
+  OutputArchive(
+      const std::function<size_t(const void*, size_t)>& writer_func,
+      StreamingOptions options);
+
   // Move is allowed.
   OutputArchive(OutputArchive&&) = default;
   OutputArchive& operator=(OutputArchive&&) = default;
@@ -66,6 +104,16 @@ class TORCH_API OutputArchive final {
   /// given writer function.
   void save_to(const std::function<size_t(const void*, size_t)>& func);
 
+  /// Whether this archive streams its tensors, see
+  /// `OutputArchive(const std::string&, StreamingOptions)`.
+  bool is_streaming() const {
+    return streaming_ != nullptr;
+  }
+
+  /// Writes the index of a streaming archive and completes it. Nothing can be
+  /// written to the archive afterwards.
+  void finish();
+
   /// Forwards all arguments to `write()`.
   /// Useful for generic code that can be re-used for both `OutputArchive` and
   /// `InputArchive` (where `operator()` forwards to `read()`).
@@ -75,8 +123,11 @@ class TORCH_API OutputArchive final {
   }
 
  private:
+  friend struct detail::CheckpointJob;
+
   std::shared_ptr<jit::script::CompilationUnit> cu_;
   jit::script::Module module_;
+  std::shared_ptr<detail::StreamingWriter> streaming_;
 };
 } // namespace serialize
 } // namespace torch
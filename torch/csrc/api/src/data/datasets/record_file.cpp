@@ -0,0 +1,316 @@
+#include <torch/data/datasets/record_file.h>
+
+#include <torch/data/example.h>
+#include <torch/types.h>
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace torch {
+namespace data {
+namespace datasets {
+namespace detail {
+
+/// A private, copy-on-write mapping of a whole file. Without `mmap`, the file
+/// is read into memory instead.
+struct MappedFile {
+  explicit MappedFile(const std::string& path) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    TORCH_CHECK(fd >= 0, "Error opening record file at ", path);
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+      ::close(fd);
+      TORCH_CHECK(false, "Error reading the size of record file ", path);
+    }
+    size = file_stat.st_size;
+    if (size > 0) {
+      data = ::mmap(
+          nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, /*offset=*/0);
+    }
+    ::close(fd);
+    TORCH_CHECK(data != MAP_FAILED, "Error mapping record file ", path);
+#else
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    TORCH_CHECK(stream, "Error opening record file at ", path);
+    size = stream.tellg();
+    buffer.resize(size);
+    stream.seekg(0);
+    TORCH_CHECK(
+        stream.read(buffer.data(), size), "Error reading record file ", path);
+    data = buffer.data();
+#endif
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (data != nullptr && data != MAP_FAILED) {
+      ::munmap(data, size);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  char* bytes() const {
+    return static_cast<char*>(data);
+  }
+
+  void* data = nullptr;
+  size_t size = 0;
+#ifdef _WIN32
+  std::vector<char> buffer;
+#endif
+};
+} // namespace detail
+
+namespace {
+// The last bytes of a record file are the offset of the index footer, the
+// number of examples and this magic number.
+constexpr uint64_t kRecordFileMagic = 0x31454c4946524354; // "TCRFILE1"
+constexpr int64_t kTrailerSize = 3 * sizeof(int64_t);
+// Tensors start at multiples of this, like in the CUDA caching allocator,
+// which is enough for every vectorized CPU kernel.
+constexpr int64_t kRecordAlignment = 64;
+
+int64_t read_int64(const char* bytes, int64_t& position, int64_t end) {
+  TORCH_CHECK(
+      position + static_cast<int64_t>(sizeof(int64_t)) <= end,
+      "Record file index is truncated");
+  int64_t value;
+  std::memcpy(&value, bytes + position, sizeof value);
+  position += sizeof value;
+  return value;
+}
+} // namespace
+
+RecordFileWriter::RecordFileWriter(const std::string& path)
+    : path_(path), stream_(path, std::ios::binary | std::ios::trunc) {
+  TORCH_CHECK(stream_, "Error creating record file at ", path);
+}
+
+RecordFileWriter::~RecordFileWriter() {
+  if (!closed_) {
+    try {
+      close();
+    } catch (...) {
+      // Destructors must not throw; the file is simply left incomplete.
+    }
+  }
+}
+
+void RecordFileWriter::write(const Example<>& example) {
+  TORCH_CHECK(!closed_, "Cannot write to a closed record file");
+  write_tensor(example.data);
+  write_tensor(example.target);
+}
+
+void RecordFileWriter::write_tensor(const Tensor& tensor) {
+  TORCH_CHECK(
+      tensor.defined() && tensor.layout() == kStrided,
+      "Record files can only hold defined, dense tensors");
+  auto contiguous = tensor.to(kCPU).contiguous();
+  const int64_t padding =
+      (kRecordAlignment - position_ % kRecordAlignment) % kRecordAlignment;
+  static const char zeros[kRecordAlignment] = {};
+  stream_.write(zeros, padding);
+  position_ += padding;
+  index_.push_back({static_cast<int64_t>(contiguous.scalar_type()),
+                    contiguous.sizes().vec(),
+                    position_});
+  const int64_t nbytes = contiguous.numel() * contiguous.element_size();
+  stream_.write(static_cast<const char*>(contiguous.data_ptr()), nbytes);
+  position_ += nbytes;
+  TORCH_CHECK(stream_, "Error writing to record file ", path_);
+}
+
+void RecordFileWriter::write_int64(int64_t value) {
+  stream_.write(reinterpret_cast<const char*>(&value), sizeof value);
+  position_ += sizeof value;
+}
+
+void RecordFileWriter::close() {
+  TORCH_CHECK(!closed_, "Record file ", path_, " is already closed");
+  closed_ = true;
+  const int64_t index_offset = position_;
+  for (const auto& entry : index_) {
+    write_int64(entry.dtype);
+    write_int64(entry.sizes.size());
+    for (int64_t size : entry.sizes) {
+      write_int64(size);
+    }
+    write_int64(entry.offset);
+  }
+  write_int64(index_offset);
+  write_int64(index_.size() / 2);
+  write_int64(static_cast<int64_t>(kRecordFileMagic));
+  stream_.close();
+  TORCH_CHECK(stream_, "Error writing to record file ", path_);
+}
+
+RecordFile::RecordFile(const std::string& path)
+    : path_(path), file_(std::make_shared<detail::MappedFile>(path)) {
+  const char* bytes = file_->bytes();
+  const int64_t file_size = file_->size;
+  TORCH_CHECK(
+      file_size >= kTrailerSize, path, " is too small to be a record file");
+  int64_t position = file_size - kTrailerSize;
+  const int64_t index_offset = read_int64(bytes, position, file_size);
+  const int64_t count = read_int64(bytes, position, file_size);
+  const uint64_t magic = read_int64(bytes, position, file_size);
+  TORCH_CHECK(
+      magic == kRecordFileMagic,
+      path,
+      " is not a record file (or was written on a machine of different "
+      "endianness)");
+  TORCH_CHECK(
+      index_offset >= 0 && index_offset <= file_size - kTrailerSize &&
+          count >= 0,
+      "Corrupt index footer in record file ",
+      path);
+
+  const int64_t index_end = file_size - kTrailerSize;
+  position = index_offset;
+  entries_.reserve(2 * count);
+  for (int64_t i = 0; i < 2 * count; ++i) {
+    TensorEntry entry;
+    const int64_t dtype = read_int64(bytes, position, index_end);
+    TORCH_CHECK(
+        dtype >= 0 &&
+            dtype < static_cast<int64_t>(ScalarType::NumOptions),
+        "Invalid dtype in record file ",
+        path);
+    entry.dtype = static_cast<ScalarType>(dtype);
+    const int64_t dim = read_int64(bytes, position, index_end);
+    TORCH_CHECK(dim >= 0, "Invalid tensor shape in record file ", path);
+    int64_t numel = 1;
+    for (int64_t d = 0; d < dim; ++d) {
+      entry.sizes.push_back(read_int64(bytes, position, index_end));
+      TORCH_CHECK(
+          entry.sizes.back() >= 0, "Invalid tensor shape in record file ", path);
+      numel *= entry.sizes.back();
+    }
+    entry.offset = read_int64(bytes, position, index_end);
+    const int64_t nbytes = numel * c10::elementSize(entry.dtype);
+    TORCH_CHECK(
+        entry.offset >= 0 && entry.offset + nbytes <= index_offset,
+        "Tensor data out of bounds in record file ",
+        path);
+    entries_.push_back(std::move(entry));
+  }
+}
+
+Tensor RecordFile::view(const TensorEntry& entry) const {
+  // Every view holds on to the mapping, which is only unmapped once the last
+  // view (and this `RecordFile`) is gone.
+  auto file = file_;
+  return torch::from_blob(
+      file_->bytes() + entry.offset,
+      entry.sizes,
+      [file](void*) mutable { file.reset(); },
+      TensorOptions().dtype(entry.dtype));
+}
+
+Example<> RecordFile::get(size_t index) const {
+  TORCH_CHECK(
+      index < size(),
+      "Index ",
+      index,
+      " is out of range for record file ",
+      path_,
+      " of size ",
+      size());
+  return {view(entries_[2 * index]), view(entries_[2 * index + 1])};
+}
+
+size_t RecordFile::size() const noexcept {
+  return entries_.size() / 2;
+}
+
+const std::string& RecordFile::path() const noexcept {
+  return path_;
+}
+
+RecordFileDataset::RecordFileDataset(const std::vector<std::string>& paths) {
+  TORCH_CHECK(!paths.empty(), "RecordFileDataset needs at least one shard");
+  shards_.reserve(paths.size());
+  offsets_.push_back(0);
+  for (const auto& path : paths) {
+    shards_.emplace_back(path);
+    offsets_.push_back(offsets_.back() + shards_.back().size());
+  }
+}
+
+Example<> RecordFileDataset::get(size_t index) {
+  TORCH_CHECK(
+      index < offsets_.back(),
+      "Index ",
+      index,
+      " is out of range for RecordFileDataset of size ",
+      offsets_.back());
+  // The shard holding `index` is the last one starting at or before it.
+  auto next_shard =
+      std::upper_bound(offsets_.begin(), offsets_.end(), index);
+  const size_t shard = std::distance(offsets_.begin(), next_shard) - 1;
+  return shards_[shard].get(index - offsets_[shard]);
+}
+
+optional<size_t> RecordFileDataset::size() const {
+  return offsets_.back();
+}
+
+const std::vector<RecordFile>& RecordFileDataset::shards() const noexcept {
+  return shards_;
+}
+
+RecordFileChunkReader::RecordFileChunkReader(
+    const std::vector<std::string>& paths) {
+  shards_.reserve(paths.size());
+  for (const auto& path : paths) {
+    shards_.emplace_back(path);
+  }
+}
+
+RecordFileChunkReader::ChunkType RecordFileChunkReader::read_chunk(
+    size_t chunk_index) {
+  TORCH_CHECK(
+      chunk_index < shards_.size(),
+      "Chunk index ",
+      chunk_index,
+      " is out of range for ",
+      shards_.size(),
+      " record file shards");
+  const RecordFile& shard = shards_[chunk_index];
+  ChunkType examples;
+  examples.reserve(shard.size());
+  for (size_t i = 0; i < shard.size(); ++i) {
+    examples.push_back(shard.get(i));
+  }
+  return examples;
+}
+
+size_t RecordFileChunkReader::chunk_count() {
+  return shards_.size();
+}
+
+void RecordFileChunkReader::reset() {}
+
+} // namespace datasets
+} // namespace data
+} // namespace torch
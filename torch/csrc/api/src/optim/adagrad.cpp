@@ -7,6 +7,8 @@
 #include <ATen/ATen.h>
 
 #include <functional>
+#include <map>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -17,6 +19,8 @@ AdagradOptions::AdagradOptions(double learning_rate)
 /// Adapted from
 /// https://github.com/pytorch/pytorch/blob/master/torch/optim/adagrad.py
 void Adagrad::step() {
+  // the parameters updated together, by step count
+  std::map<int64_t, std::vector<size_t>> steps;
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
     if (!p.grad().defined()) {
@@ -29,15 +33,25 @@ void Adagrad::step() {
     }
 
     buffer_at(step_buffers, i) += 1.0;
-    const auto clr = options.learning_rate() /
-        (1.0 + (buffer_at(step_buffers, i) - 1.0) * options.lr_decay());
+    buffer_at(sum_buffers, i);
+    steps[buffer_at(step_buffers, i)].push_back(i);
+  }
 
-    auto& sum = buffer_at(sum_buffers, i);
-    sum.addcmul_(p.grad(), p.grad(), 1.0);
-    const auto std = buffer_at(sum_buffers, i).sqrt().add_(1e-10);
+  for (const auto& step : steps) {
+    const auto clr = options.learning_rate() /
+        (1.0 + (step.first - 1.0) * options.lr_decay());
 
+    std::vector<Tensor> params, grads, sums;
+    for (size_t i : step.second) {
+      params.push_back(parameters_[i]);
+      grads.push_back(parameters_[i].grad());
+      sums.push_back(sum_buffers[i]);
+    }
     NoGradGuard guard;
-    p.addcdiv_(p.grad(), std, -clr);
+    torch::_foreach_addcmul_(sums, grads, grads, 1.0);
+    auto stds = torch::_foreach_sqrt(sums);
+    torch::_foreach_add_(stds, 1e-10);
+    torch::_foreach_addcdiv_(params, grads, stds, -clr);
   }
 }
 
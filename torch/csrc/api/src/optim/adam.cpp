@@ -9,6 +9,8 @@
 
 #include <cmath>
 #include <functional>
+#include <map>
+#include <vector>
 
 namespace torch {
 namespace optim {
@@ -16,21 +18,28 @@ AdamOptions::AdamOptions(double learning_rate)
     : learning_rate_(learning_rate) {}
 
 void Adam::step() {
+  // the parameters updated by one _fused_adam_ call per step count
+  std::map<int64_t, std::vector<size_t>> fused_steps;
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
     if (!p.grad().defined()) {
       continue;
     }
 
+    auto& exp_average = buffer_at(exp_average_buffers, i);
+    auto& exp_average_sq = buffer_at(exp_average_sq_buffers, i);
+
+    buffer_at(step_buffers, i) += 1;
+    if (!options.amsgrad()) {
+      fused_steps[buffer_at(step_buffers, i)].push_back(i);
+      continue;
+    }
+
     if (options.weight_decay() > 0) {
       NoGradGuard guard;
       p.grad() = p.grad() + options.weight_decay() * p;
     }
 
-    auto& exp_average = buffer_at(exp_average_buffers, i);
-    auto& exp_average_sq = buffer_at(exp_average_sq_buffers, i);
-
-    buffer_at(step_buffers, i) += 1;
     const auto bias_correction1 =
         1 - std::pow(options.beta1(), buffer_at(step_buffers, i));
     const auto bias_correction2 =
@@ -40,14 +49,9 @@ void Adam::step() {
     exp_average_sq.mul_(options.beta2())
         .addcmul_(p.grad(), p.grad(), 1 - options.beta2());
 
-    Tensor denom;
-    if (options.amsgrad()) {
-      auto& max_exp_average_sq = buffer_at(max_exp_average_sq_buffers, i);
-      max_exp_average_sq = torch::max(max_exp_average_sq, exp_average_sq);
-      denom = max_exp_average_sq / bias_correction2;
-    } else {
-      denom = exp_average_sq / bias_correction2;
-    }
+    auto& max_exp_average_sq = buffer_at(max_exp_average_sq_buffers, i);
+    max_exp_average_sq = torch::max(max_exp_average_sq, exp_average_sq);
+    Tensor denom = max_exp_average_sq / bias_correction2;
 
     const auto step_size =
         options.learning_rate() / bias_correction1;
@@ -55,6 +59,28 @@ void Adam::step() {
     NoGradGuard guard;
     p.addcdiv_(exp_average, denom.sqrt() + options.eps(), -step_size);
   }
+
+  for (const auto& fused_step : fused_steps) {
+    std::vector<Tensor> params, grads, exp_averages, exp_average_sqs;
+    for (size_t i : fused_step.second) {
+      params.push_back(parameters_[i]);
+      grads.push_back(parameters_[i].grad());
+      exp_averages.push_back(exp_average_buffers[i]);
+      exp_average_sqs.push_back(exp_average_sq_buffers[i]);
+    }
+    NoGradGuard guard;
+    torch::_fused_adam_(
+        params,
+        grads,
+        exp_averages,
+        exp_average_sqs,
+        options.learning_rate(),
+        options.beta1(),
+        options.beta2(),
+        options.eps(),
+        options.weight_decay(),
+        fused_step.first);
+  }
 }
 
 void Adam::save(serialize::OutputArchive& archive) const {
@@ -10,41 +10,42 @@
 #include <ATen/ATen.h>
 
 #include <functional>
+#include <vector>
 
 namespace torch {
 namespace optim {
 SGDOptions::SGDOptions(double learning_rate) : learning_rate_(learning_rate) {}
 
 void SGD::step() {
+  std::vector<Tensor> params, grads, buffers;
   for (size_t i = 0; i < parameters_.size(); ++i) {
     Tensor p = parameters_.at(i);
 
     if (!p.grad().defined()) {
       continue;
     }
-
-    auto update = p.grad();
-
-    if (options.weight_decay() > 0) {
-      NoGradGuard guard;
-      update += options.weight_decay() * p;
-    }
-
+    params.push_back(p);
+    grads.push_back(p.grad());
     if (options.momentum() != 0) {
-      const auto dampening = iteration_ == 0 ? 1 : 1 - options.dampening();
-      auto& momentum = buffer_at(momentum_buffers, i);
-      momentum = (options.momentum() * momentum) + (dampening * update);
-      if (options.nesterov()) {
-        // See github.com/lisa-lab/pylearn2/pull/136#issuecomment-10381617
-        // for notes on this implementation of nesterov momentum.
-        update += options.momentum() * momentum;
-      } else {
-        update = momentum;
-      }
+      buffers.push_back(buffer_at(momentum_buffers, i));
     }
+  }
 
+  if (!params.empty()) {
+    // the momentum buffers start at zero, so that they are the first update
+    const auto dampening = iteration_ == 0 ? 1 : 1 - options.dampening();
     NoGradGuard guard;
-    p.add_(-options.learning_rate() * update);
+    // See github.com/lisa-lab/pylearn2/pull/136#issuecomment-10381617
+    // for notes on the implementation of nesterov momentum.
+    torch::_fused_sgd_(
+        params,
+        grads,
+        buffers,
+        options.learning_rate(),
+        options.momentum(),
+        dampening,
+        options.weight_decay(),
+        options.nesterov());
   }
   iteration_ += 1;
 }
@@ -0,0 +1,212 @@
+#include <torch/serialize/async-checkpoint.h>
+
+#include <torch/types.h>
+#include <torch/utils.h>
+
+#include <torch/csrc/jit/script/module.h>
+#include <torch/csrc/utils/memory.h>
+
+#include <c10/util/Exception.h>
+
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+namespace torch {
+namespace serialize {
+namespace detail {
+
+struct CheckpointJob {
+  OutputArchive archive;
+  std::function<void(OutputArchive&)> save_to;
+  std::promise<void> done;
+#ifdef USE_CUDA
+  // One event per device, recorded after the copies from that device.
+  std::vector<at::cuda::CUDAEvent> copied;
+#endif
+
+  CheckpointJob(
+      OutputArchive archive_,
+      std::function<void(OutputArchive&)> save_to_)
+      : archive(std::move(archive_)), save_to(std::move(save_to_)) {}
+
+  void snapshot() {
+    std::vector<at::Device> devices;
+    snapshot_module(archive.module_, devices);
+#ifdef USE_CUDA
+    for (const auto& device : devices) {
+      c10::cuda::CUDAGuard device_guard(device);
+      copied.emplace_back();
+      copied.back().record(at::cuda::getCurrentCUDAStream());
+    }
+#endif
+  }
+
+  void write() {
+#ifdef USE_CUDA
+    for (auto& event : copied) {
+      event.synchronize();
+    }
+#endif
+    save_to(archive);
+  }
+
+ private:
+  static Tensor snapshot_tensor(
+      const Tensor& tensor,
+      std::vector<at::Device>& devices) {
+    if (!tensor.defined()) {
+      return tensor;
+    }
+    torch::NoGradGuard guard;
+    Tensor copy;
+    if (tensor.is_cuda()) {
+      copy = torch::empty(
+          tensor.sizes(),
+          tensor.options().device(torch::kCPU).pinned_memory(true));
+      copy.copy_(tensor, /*non_blocking=*/true);
+      if (std::find(devices.begin(), devices.end(), tensor.device()) ==
+          devices.end()) {
+        devices.push_back(tensor.device());
+      }
+    } else {
+      copy = tensor.clone();
+    }
+    copy.set_requires_grad(tensor.requires_grad());
+    return copy;
+  }
+
+  // Replaces the tensors in the slots of `module` and its submodules by their
+  // snapshots, so the archive no longer refers to the tensors being trained.
+  static void snapshot_module(
+      const jit::script::Module& module,
+      std::vector<at::Device>& devices) {
+    const auto object = module.module_object();
+    for (size_t i = 0; i < module.num_slots(); ++i) {
+      const auto slot = object->getSlot(i);
+      if (module.entity_type(i) == jit::script::EntityType::MODULE) {
+        snapshot_module(jit::script::Module(slot.toObject()), devices);
+      } else if (slot.isTensor()) {
+        object->setSlot(i, snapshot_tensor(slot.toTensor(), devices));
+      } else if (slot.isTensorList()) {
+        c10::List<at::Tensor> copies;
+        for (const at::Tensor& tensor : slot.toTensorListRef()) {
+          copies.push_back(snapshot_tensor(tensor, devices));
+        }
+        object->setSlot(i, std::move(copies));
+      }
+    }
+  }
+};
+
+} // namespace detail
+
+AsyncCheckpointer::AsyncCheckpointer(AsyncCheckpointOptions options)
+    : options_(std::move(options)) {
+  TORCH_CHECK(
+      options_.max_pending() > 0,
+      "An AsyncCheckpointer needs to allow at least one pending checkpoint");
+  thread_ = std::thread([this] { run(); });
+}
+
+AsyncCheckpointer::~AsyncCheckpointer() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  cv_.notify_all();
+  thread_.join();
+}
+
+std::shared_future<void> AsyncCheckpointer::save(
+    OutputArchive archive,
+    std::function<void(OutputArchive&)> save_to) {
+  TORCH_CHECK(
+      !archive.is_streaming(),
+      "A streaming archive cannot be checkpointed asynchronously");
+  {
+    // Backpressure: the snapshot isn't taken before there is room for it.
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return pending_ < options_.max_pending(); });
+    ++pending_;
+  }
+  auto job = torch::make_unique<detail::CheckpointJob>(
+      std::move(archive), std::move(save_to));
+  std::shared_future<void> future = job->done.get_future().share();
+  try {
+    job->snapshot();
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+    }
+    cv_.notify_all();
+    throw;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    jobs_.push_back(std::move(job));
+  }
+  cv_.notify_all();
+  return future;
+}
+
+void AsyncCheckpointer::wait() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait(lock, [this] { return pending_ == 0; });
+  if (error_) {
+    auto error = error_;
+    error_ = nullptr;
+    std::rethrow_exception(error);
+  }
+}
+
+size_t AsyncCheckpointer::pending() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return pending_;
+}
+
+void AsyncCheckpointer::run() {
+  while (true) {
+    std::unique_ptr<detail::CheckpointJob> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      // Pending checkpoints are still written on shutdown.
+      cv_.wait(lock, [this] { return shutdown_ || !jobs_.empty(); });
+      if (jobs_.empty()) {
+        return;
+      }
+      job = std::move(jobs_.front());
+      jobs_.pop_front();
+    }
+    std::exception_ptr error;
+    try {
+      job->write();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    // The snapshot is released before the checkpoint counts as written.
+    auto done = std::move(job->done);
+    job.reset();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      --pending_;
+      if (error && !error_) {
+        error_ = error;
+      }
+    }
+    cv_.notify_all();
+    if (error) {
+      done.set_exception(error);
+    } else {
+      done.set_value();
+    }
+  }
+}
+} // namespace serialize
+} // namespace torch
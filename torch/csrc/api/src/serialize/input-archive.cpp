@@ -4,21 +4,243 @@
 #include <torch/utils.h>
 
 #include <torch/csrc/jit/import.h>
+#include <torch/csrc/jit/pickle.h>
 #include <torch/csrc/jit/script/module.h>
+#include <torch/csrc/utils/memory.h>
+#include <caffe2/serialize/inline_container.h>
 #include <caffe2/serialize/read_adapter_interface.h>
 #include <c10/util/Exception.h>
+#include <c10/util/StringUtil.h>
 
+#include <algorithm>
+#include <cstring>
 #include <istream>
 #include <memory>
 #include <string>
+#include <tuple>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace torch {
 namespace serialize {
+namespace detail {
+
+// See Note [Streaming archives]
+constexpr int64_t kStreamingVersion = 1;
+constexpr const char* kStreamingIndexRecord = "streaming_index.pkl";
+
+struct LazyEntry {
+  std::string kind;
+  std::vector<int64_t> tensor_ids;
+  std::string record;
+};
+
+struct LazyNode {
+  std::unordered_map<std::string, LazyEntry> entries;
+  std::unordered_map<std::string, std::unique_ptr<LazyNode>> children;
+};
+
+struct LazyTensor {
+  at::ScalarType dtype;
+  std::vector<int64_t> sizes;
+  bool requires_grad;
+  torch::Device device;
+  int64_t chunk_numel;
+};
+
+struct LazyArchive {
+  LazyArchive(
+      std::unique_ptr<caffe2::serialize::PyTorchStreamReader> reader_,
+      const c10::IValue& index,
+      c10::optional<torch::Device> device_)
+      : reader(std::move(reader_)), device(std::move(device_)) {
+    const auto& elements = index.toTuple()->elements();
+    TORCH_CHECK(
+        elements.at(0).toInt() == kStreamingVersion,
+        "Unsupported version ",
+        elements.at(0).toInt(),
+        " of a streaming archive");
+    for (const auto& tensor : elements.at(1).toTuple()->elements()) {
+      const auto& fields = tensor.toTuple()->elements();
+      tensors.push_back(
+          {static_cast<at::ScalarType>(fields.at(0).toInt()),
+           int_vector(fields.at(1)),
+           fields.at(2).toBool(),
+           torch::Device(fields.at(3).toStringRef()),
+           fields.at(4).toInt()});
+    }
+    for (const auto& entry : elements.at(2).toTuple()->elements()) {
+      const auto& fields = entry.toTuple()->elements();
+      const auto& path = fields.at(0).toTuple()->elements();
+      LazyNode* node = &root;
+      for (size_t i = 0; i + 1 < path.size(); ++i) {
+        auto& child = node->children[path[i].toStringRef()];
+        if (!child) {
+          child = torch::make_unique<LazyNode>();
+        }
+        node = child.get();
+      }
+      node->entries[path.back().toStringRef()] = {
+          fields.at(1).toStringRef(),
+          int_vector(fields.at(2)),
+          fields.at(3).toStringRef()};
+    }
+  }
+
+  const LazyTensor& tensor_info(int64_t id) const {
+    TORCH_CHECK(
+        id >= 0 && static_cast<size_t>(id) < tensors.size(),
+        "Invalid tensor ", id, " in a streaming archive");
+    return tensors[id];
+  }
+
+  torch::Device target_device(const LazyTensor& info) const {
+    return device ? *device : info.device;
+  }
+
+  // Whether tensor `id` can be read into `tensor` in place.
+  bool can_read_into(int64_t id, const Tensor& tensor) const {
+    if (id < 0 || !tensor.defined()) {
+      return false;
+    }
+    const auto& info = tensor_info(id);
+    return tensor.scalar_type() == info.dtype &&
+        tensor.sizes() == at::IntArrayRef(info.sizes) &&
+        tensor.device() == target_device(info) && tensor.is_contiguous();
+  }
+
+  void read_into(int64_t id, Tensor& tensor) {
+    const auto& info = tensor_info(id);
+    torch::NoGradGuard guard;
+    auto flat = tensor.view({-1});
+    const int64_t numel = flat.numel();
+    const size_t itemsize = tensor.itemsize();
+    for (int64_t chunk = 0, offset = 0; offset < numel;
+         ++chunk, offset += info.chunk_numel) {
+      const int64_t chunk_numel = std::min(info.chunk_numel, numel - offset);
+      at::DataPtr data;
+      size_t size;
+      std::tie(data, size) = reader->getRecord(
+          "tensors/" + c10::to_string(id) + "/" + c10::to_string(chunk));
+      TORCH_CHECK(
+          size == chunk_numel * itemsize,
+          "Corrupted chunk ", chunk, " of tensor ", id,
+          " in a streaming archive");
+      flat.narrow(0, offset, chunk_numel)
+          .copy_(torch::from_blob(
+              data.get(), {chunk_numel}, torch::TensorOptions(info.dtype)));
+    }
+  }
+
+  Tensor read_tensor(int64_t id) {
+    if (id < 0) {
+      return Tensor();
+    }
+    const auto& info = tensor_info(id);
+    auto tensor = torch::empty(
+        info.sizes,
+        torch::TensorOptions(info.dtype).device(target_device(info)));
+    read_into(id, tensor);
+    tensor.set_requires_grad(info.requires_grad);
+    return tensor;
+  }
+
+  c10::IValue read_value(const LazyEntry& entry) {
+    if (entry.kind != "value") {
+      return read_tensor(entry.tensor_ids.at(0));
+    }
+    std::vector<at::Tensor> tensor_table;
+    tensor_table.reserve(entry.tensor_ids.size());
+    for (const auto id : entry.tensor_ids) {
+      tensor_table.push_back(read_tensor(id));
+    }
+    at::DataPtr data;
+    size_t size;
+    std::tie(data, size) = reader->getRecord(entry.record);
+    return jit::unpickle(
+        static_cast<const char*>(data.get()),
+        size,
+        /*class_resolver=*/nullptr,
+        &tensor_table);
+  }
+
+  static std::vector<int64_t> int_vector(const c10::IValue& tuple) {
+    std::vector<int64_t> values;
+    for (const auto& value : tuple.toTuple()->elements()) {
+      values.push_back(value.toInt());
+    }
+    return values;
+  }
+
+  std::unique_ptr<caffe2::serialize::PyTorchStreamReader> reader;
+  c10::optional<torch::Device> device;
+  std::vector<LazyTensor> tensors;
+  LazyNode root;
+};
+
+} // namespace detail
+
+namespace {
+using caffe2::serialize::ReadAdapterInterface;
+
+class DataAdapter : public ReadAdapterInterface {
+ public:
+  DataAdapter(const char* data, size_t size) : data_(data), size_(size) {}
+  size_t size() const override {
+    return size_;
+  }
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override {
+    (void)what;
+    if (pos >= size_) {
+      return 0;
+    }
+    size_t nread = std::min(static_cast<size_t>(pos) + n, size_) - pos;
+    memcpy(buf, data_ + pos, nread);
+    return nread;
+  }
+
+ private:
+  const char* data_;
+  size_t size_;
+};
+
+// Holds copies of the functions, a lazy archive keeps reading through them.
+class FuncAdapter : public ReadAdapterInterface {
+ public:
+  FuncAdapter(
+      std::function<size_t(uint64_t, void*, size_t)> read_func,
+      std::function<size_t(void)> size_func)
+      : read_func_(std::move(read_func)), size_func_(std::move(size_func)) {}
+  size_t size() const override {
+    return size_func_();
+  }
+  size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
+      const override {
+    (void)what;
+    return read_func_(pos, buf, n);
+  }
+
+ private:
+  std::function<size_t(uint64_t, void*, size_t)> read_func_;
+  std::function<size_t(void)> size_func_;
+};
+} // namespace
 
 InputArchive::InputArchive() {}
 
 void InputArchive::read(const std::string& key, c10::IValue& ivalue) {
+  if (lazy_) {
+    auto entry = node_->entries.find(key);
+    TORCH_CHECK(
+        entry != node_->entries.end() && entry->second.kind != "parameter",
+        "No such serialized IValue '",
+        key,
+        "'");
+    ivalue = lazy_->read_value(entry->second);
+    return;
+  }
   if (auto named_attr = module_.find_attribute(key)) {
     ivalue = *named_attr;
   } else {
@@ -34,17 +256,37 @@ bool InputArchive::try_read(
     const std::string& key,
     Tensor& tensor,
     bool is_buffer) {
-  auto param = module_.find_parameter(key);
-  auto buffer = module_.find_buffer(key);
-  if (!param && !buffer) return false;
+  Tensor read_tensor;
+  if (lazy_) {
+    auto entry = node_->entries.find(key);
+    if (entry == node_->entries.end() || entry->second.kind == "value") {
+      return false;
+    }
+    // clang-format off
+    TORCH_CHECK(
+        (entry->second.kind == "buffer") == is_buffer,
+        "Expected deserialized tensor for key '", key,
+        "' to ", is_buffer ? "not " : "", "be a buffer, but it was not");
+    // clang-format on
+    const int64_t id = entry->second.tensor_ids.at(0);
+    if (lazy_->can_read_into(id, tensor)) {
+      lazy_->read_into(id, tensor);
+      return true;
+    }
+    read_tensor = lazy_->read_tensor(id);
+  } else {
+    auto param = module_.find_parameter(key);
+    auto buffer = module_.find_buffer(key);
+    if (!param && !buffer) return false;
 
-  // clang-format off
-  auto read_tensor = is_buffer ? *buffer : *param;
-  TORCH_CHECK(
-      bool(buffer) == is_buffer,
-      "Expected deserialized tensor for key '", key,
-      "' to ", is_buffer ? "not " : "", "be a buffer, but it was not");
-  // clang-format on
+    // clang-format off
+    read_tensor = is_buffer ? *buffer : *param;
+    TORCH_CHECK(
+        bool(buffer) == is_buffer,
+        "Expected deserialized tensor for key '", key,
+        "' to ", is_buffer ? "not " : "", "be a buffer, but it was not");
+    // clang-format on
+  }
   if (tensor.defined()) {
     torch::NoGradGuard guard;
     if (tensor.device() != read_tensor.device()) {
@@ -70,6 +312,15 @@ void InputArchive::read(
 }
 
 bool InputArchive::try_read(const std::string& key, InputArchive& archive) {
+  if (lazy_) {
+    auto child = node_->children.find(key);
+    if (child == node_->children.end()) {
+      return false;
+    }
+    archive.lazy_ = lazy_;
+    archive.node_ = child->second.get();
+    return true;
+  }
   if (auto named_module = module_.find_module(key)) {
     archive.module_ = std::move(*named_module);
     return true;
@@ -84,13 +335,40 @@ void InputArchive::read(const std::string& key, InputArchive& archive) {
     "No such serialized submodule: '", key, "'");
 }
 
+bool InputArchive::load_lazy(
+    std::unique_ptr<caffe2::serialize::PyTorchStreamReader> reader,
+    c10::optional<torch::Device> device) {
+  if (!reader->hasRecord(detail::kStreamingIndexRecord)) {
+    return false;
+  }
+  at::DataPtr data;
+  size_t size;
+  std::tie(data, size) = reader->getRecord(detail::kStreamingIndexRecord);
+  const auto index =
+      jit::unpickle(static_cast<const char*>(data.get()), size);
+  lazy_ = std::make_shared<detail::LazyArchive>(
+      std::move(reader), index, std::move(device));
+  node_ = &lazy_->root;
+  return true;
+}
+
 void InputArchive::load_from(const std::string& filename,
     c10::optional<torch::Device> device /*= c10::nullopt*/) {
+  if (load_lazy(
+          torch::make_unique<caffe2::serialize::PyTorchStreamReader>(filename),
+          device)) {
+    return;
+  }
   module_ = torch::jit::load(filename, std::move(device));
 }
 
 void InputArchive::load_from(std::istream& stream,
     c10::optional<torch::Device> device /*= c10::nullopt*/) {
+  if (load_lazy(
+          torch::make_unique<caffe2::serialize::PyTorchStreamReader>(&stream),
+          device)) {
+    return;
+  }
   module_ = torch::jit::load(stream, std::move(device));
 }
 
@@ -98,55 +376,29 @@ void InputArchive::load_from(
     const char* data,
     size_t size,
     c10::optional<torch::Device> device /*= c10::nullopt*/) {
-  using caffe2::serialize::ReadAdapterInterface;
-  class OurAdapter : public ReadAdapterInterface {
-  public:
-    OurAdapter(const char* data, size_t size)
-      : data_(data), size_(size) {
-    }
-    size_t size() const override { return size_; }
-    size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
-      const override {
-      (void) what;
-      if (pos >= size_) {
-        return 0;
-      }
-      size_t nread = std::min(static_cast<size_t>(pos) + n, size_) - pos;
-      memcpy(buf, data_ + pos, nread);
-      return nread;
-    }
-  private:
-    const char* data_;
-    size_t size_;
-  };
-  std::unique_ptr<OurAdapter> adapter(new OurAdapter(data, size));
-  module_ = torch::jit::load(std::move(adapter), std::move(device));
+  if (load_lazy(
+          torch::make_unique<caffe2::serialize::PyTorchStreamReader>(
+              torch::make_unique<DataAdapter>(data, size)),
+          device)) {
+    return;
+  }
+  module_ = torch::jit::load(
+      torch::make_unique<DataAdapter>(data, size), std::move(device));
 }
 
 void InputArchive::load_from(
     const std::function<size_t(uint64_t, void*, size_t)>& read_func,
     const std::function<size_t(void)>& size_func,
     c10::optional<torch::Device> device /*= c10::nullopt*/) {
-  using caffe2::serialize::ReadAdapterInterface;
-  class OurAdapter : public ReadAdapterInterface {
-  public:
-    OurAdapter(const std::function<size_t(uint64_t, void*, size_t)>& read_func,
-               const std::function<size_t(void)>& size_func)
-      : read_func_(read_func),
-        size_func_(size_func) {
-    }
-    size_t size() const override { return size_func_(); }
-    size_t read(uint64_t pos, void* buf, size_t n, const char* what = "")
-      const override {
-      (void)what;
-      return read_func_(pos, buf, n);
-    }
-  private:
-    const std::function<size_t(uint64_t, void*, size_t)>& read_func_;
-    const std::function<size_t(void)>& size_func_;
-  };
-  std::unique_ptr<OurAdapter> adapter(new OurAdapter(read_func, size_func));
-  module_ = torch::jit::load(std::move(adapter), std::move(device));
+  if (load_lazy(
+          torch::make_unique<caffe2::serialize::PyTorchStreamReader>(
+              torch::make_unique<FuncAdapter>(read_func, size_func)),
+          device)) {
+    return;
+  }
+  module_ = torch::jit::load(
+      torch::make_unique<FuncAdapter>(read_func, size_func),
+      std::move(device));
 }
 
 } // namespace serialize
@@ -4,21 +4,285 @@
 #include <torch/utils.h>
 
 #include <torch/csrc/jit/export.h>
+#include <torch/csrc/jit/pickle.h>
 #include <torch/csrc/jit/script/module.h>
+#include <torch/csrc/utils/memory.h>
 
+#include <caffe2/serialize/inline_container.h>
 #include <c10/util/Exception.h>
+#include <c10/util/StringUtil.h>
 
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/Exceptions.h>
+#include <c10/cuda/CUDAGuard.h>
+#endif
+
+#include <algorithm>
+#include <complex>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <vector>
 
 namespace torch {
 namespace serialize {
+namespace detail {
+
+// Note [Streaming archives]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~
+// A streaming OutputArchive doesn't build a module to export at the end, it
+// writes every tensor into the PyTorchStreamWriter when the tensor is
+// written to the archive. The data of tensor <id> is stored in the records
+// `tensors/<id>/<chunk>` of `chunk_numel` elements each (the last one may be
+// shorter), because miniz can only add a record from a single buffer and
+// neither saving nor loading should need a host copy of a whole tensor. Any
+// other IValue is pickled into the record `values/<n>.pkl`, with the tensors
+// it contains in its tensor table and written as tensor records.
+//
+// The index of the archive is pickled into the record `streaming_index.pkl`
+// by finish(). It is the tuple
+//
+//   (version, tensors, entries)
+//
+// with one tuple `(dtype, sizes, requires_grad, device, chunk_numel)` in
+// `tensors` per tensor and one tuple `(path, kind, tensor_ids, record)` in
+// `entries` per key, where `path` is the tuple of the keys of the nested
+// archives and the key of the entry, and `kind` is "parameter", "buffer" or
+// "value". An undefined tensor has the id -1. Only tuples, ints, bools and
+// strings are used so that the index round trips through the unpickler
+// without any type information.
+//
+// InputArchive::load_from() reads this index only, and reads the records of
+// a tensor when the tensor is read from the archive.
+constexpr int64_t kStreamingVersion = 1;
+constexpr const char* kStreamingIndexRecord = "streaming_index.pkl";
+
+struct StreamingWriter {
+  StreamingWriter(
+      std::unique_ptr<caffe2::serialize::PyTorchStreamWriter> writer,
+      StreamingOptions options)
+      : writer_(std::move(writer)), options_(std::move(options)) {
+    // A chunk holds at least one element.
+    TORCH_CHECK(
+        options_.chunk_size() >= sizeof(std::complex<double>),
+        "The chunk size of a streaming archive must be at least ",
+        sizeof(std::complex<double>),
+        " bytes");
+    TORCH_CHECK(
+        options_.staging_buffers() > 0,
+        "A streaming archive needs at least one staging buffer");
+  }
+
+  void write_tensor_entry(
+      const std::vector<std::string>& path,
+      const Tensor& tensor,
+      bool is_buffer) {
+    const int64_t id = write_tensor(tensor);
+    write_entry(path, is_buffer ? "buffer" : "parameter", {id}, "");
+  }
+
+  void write_value(
+      const std::vector<std::string>& path,
+      const c10::IValue& ivalue) {
+    // Like a tensor attribute of a module, see Module::find_buffer().
+    if (ivalue.isTensor()) {
+      write_tensor_entry(path, ivalue.toTensor(), /*is_buffer=*/true);
+      return;
+    }
+    std::vector<at::Tensor> tensor_table;
+    const auto data = jit::pickle(ivalue, &tensor_table);
+    const std::string record = "values/" + c10::to_string(num_values_++) + ".pkl";
+    writer_->writeRecord(record, data.data(), data.size());
+    std::vector<int64_t> ids;
+    ids.reserve(tensor_table.size());
+    for (const auto& tensor : tensor_table) {
+      ids.push_back(write_tensor(tensor));
+    }
+    write_entry(path, "value", ids, record);
+  }
+
+  void write_module(
+      std::vector<std::string>& path,
+      const jit::script::Module& module) {
+    for (size_t i = 0; i < module.num_slots(); ++i) {
+      path.push_back(module.type()->getAttributeName(i));
+      const auto slot = module.module_object()->getSlot(i);
+      switch (module.entity_type(i)) {
+        case jit::script::EntityType::PARAMETER:
+          write_tensor_entry(path, slot.toTensor(), /*is_buffer=*/false);
+          break;
+        case jit::script::EntityType::MODULE:
+          write_module(path, jit::script::Module(slot.toObject()));
+          break;
+        default:
+          write_value(path, slot);
+      }
+      path.pop_back();
+    }
+  }
+
+  void finish() {
+    TORCH_CHECK(!finished_, "This streaming archive was already finished");
+    const auto index = c10::ivalue::Tuple::create(
+        {c10::IValue(kStreamingVersion),
+         c10::ivalue::Tuple::create(std::move(tensors_)),
+         c10::ivalue::Tuple::create(std::move(entries_))});
+    const auto data = jit::pickle(index);
+    writer_->writeRecord(kStreamingIndexRecord, data.data(), data.size());
+    writer_->writeEndOfFile();
+    finished_ = true;
+#ifdef USE_CUDA
+    staging_.clear();
+#endif
+  }
+
+ private:
+  static std::string record_name(int64_t id, size_t chunk) {
+    return "tensors/" + c10::to_string(id) + "/" + c10::to_string(chunk);
+  }
+
+  static c10::IValue int_tuple(const std::vector<int64_t>& values) {
+    return c10::ivalue::Tuple::create(
+        std::vector<c10::IValue>(values.begin(), values.end()));
+  }
+
+  void write_entry(
+      const std::vector<std::string>& path,
+      const std::string& kind,
+      const std::vector<int64_t>& tensor_ids,
+      const std::string& record) {
+    TORCH_CHECK(!finished_, "This streaming archive was already finished");
+    entries_.emplace_back(c10::ivalue::Tuple::create(
+        {c10::ivalue::Tuple::create(
+             std::vector<c10::IValue>(path.begin(), path.end())),
+         c10::IValue(kind),
+         int_tuple(tensor_ids),
+         c10::IValue(record)}));
+  }
+
+  int64_t write_tensor(const Tensor& tensor) {
+    TORCH_CHECK(!finished_, "This streaming archive was already finished");
+    if (!tensor.defined()) {
+      return -1;
+    }
+    TORCH_CHECK(
+        tensor.layout() == at::kStrided && !tensor.is_quantized(),
+        "Only dense tensors can be written to a streaming archive");
+    torch::NoGradGuard guard;
+    const int64_t id = tensors_.size();
+    const auto data = tensor.contiguous();
+    const size_t itemsize = data.itemsize();
+    const int64_t chunk_numel = options_.chunk_size() / itemsize;
+    const size_t chunk_bytes = chunk_numel * itemsize;
+    const size_t nbytes = data.nbytes();
+    const size_t num_chunks = (nbytes + chunk_bytes - 1) / chunk_bytes;
+    const char* ptr = static_cast<const char*>(data.data_ptr());
+
+    if (data.is_cuda()) {
+#ifdef USE_CUDA
+      // The chunks go through the ring of pinned staging buffers, the copy of
+      // the chunk in a buffer is waited for only when the buffer is needed
+      // again or the tensor is done.
+      c10::cuda::CUDAGuard device_guard(data.device());
+      const auto stream = at::cuda::getCurrentCUDAStream();
+      while (staging_.size() < options_.staging_buffers()) {
+        staging_.push_back(at::empty(
+            {static_cast<int64_t>(options_.chunk_size())},
+            at::TensorOptions(at::kByte).pinned_memory(true)));
+      }
+      std::vector<at::cuda::CUDAEvent> copied(staging_.size());
+      size_t num_written = 0;
+      auto write_next = [&]() {
+        const size_t slot = num_written % staging_.size();
+        const size_t offset = num_written * chunk_bytes;
+        copied[slot].synchronize();
+        writer_->writeRecord(
+            record_name(id, num_written),
+            staging_[slot].data_ptr(),
+            std::min(chunk_bytes, nbytes - offset));
+        ++num_written;
+      };
+      for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        if (chunk - num_written == staging_.size()) {
+          write_next();
+        }
+        const size_t slot = chunk % staging_.size();
+        const size_t offset = chunk * chunk_bytes;
+        AT_CUDA_CHECK(cudaMemcpyAsync(
+            staging_[slot].data_ptr(),
+            ptr + offset,
+            std::min(chunk_bytes, nbytes - offset),
+            cudaMemcpyDeviceToHost,
+            stream));
+        copied[slot].record(stream);
+      }
+      while (num_written < num_chunks) {
+        write_next();
+      }
+#else
+      AT_ERROR("Cannot stream a CUDA tensor in a build without CUDA");
+#endif
+    } else {
+      for (size_t chunk = 0; chunk < num_chunks; ++chunk) {
+        const size_t offset = chunk * chunk_bytes;
+        writer_->writeRecord(
+            record_name(id, chunk),
+            ptr + offset,
+            std::min(chunk_bytes, nbytes - offset));
+      }
+    }
+
+    tensors_.emplace_back(c10::ivalue::Tuple::create(
+        {c10::IValue(static_cast<int64_t>(data.scalar_type())),
+         int_tuple(data.sizes().vec()),
+         c10::IValue(tensor.requires_grad()),
+         c10::IValue(tensor.device().str()),
+         c10::IValue(chunk_numel)}));
+    return id;
+  }
+
+  std::unique_ptr<caffe2::serialize::PyTorchStreamWriter> writer_;
+  StreamingOptions options_;
+  std::vector<c10::IValue> tensors_;
+  std::vector<c10::IValue> entries_;
+  size_t num_values_ = 0;
+  bool finished_ = false;
+#ifdef USE_CUDA
+  std::vector<at::Tensor> staging_;
+#endif
+};
+
+} // namespace detail
+
 OutputArchive::OutputArchive(std::shared_ptr<jit::script::CompilationUnit> cu)
     : cu_(std::move(cu)),
       module_("__torch__.Module", cu_, /*shouldMangle=*/true) {}
 
+OutputArchive::OutputArchive(
+    const std::string& filename,
+    StreamingOptions options)
+    : cu_(std::make_shared<jit::script::CompilationUnit>()),
+      streaming_(std::make_shared<detail::StreamingWriter>(
+          torch::make_unique<caffe2::serialize::PyTorchStreamWriter>(
+              filename, options.alignment()),
+          options)) {}
+
+OutputArchive::OutputArchive(
+    const std::function<size_t(const void*, size_t)>& writer_func,
+    StreamingOptions options)
+    : cu_(std::make_shared<jit::script::CompilationUnit>()),
+      streaming_(std::make_shared<detail::StreamingWriter>(
+          torch::make_unique<caffe2::serialize::PyTorchStreamWriter>(
+              writer_func, options.alignment()),
+          options)) {}
+
 void OutputArchive::write(const std::string& key, const c10::IValue& ivalue) {
+  if (streaming_) {
+    streaming_->write_value({key}, ivalue);
+    return;
+  }
   module_.register_attribute(key, ivalue.type(), ivalue);
 }
 
@@ -26,26 +290,46 @@ void OutputArchive::write(
     const std::string& key,
     const Tensor& tensor,
     bool is_buffer) {
+  if (streaming_) {
+    streaming_->write_tensor_entry({key}, tensor, is_buffer);
+    return;
+  }
   module_.register_parameter(key, tensor, is_buffer);
 }
 
 void OutputArchive::write(
     const std::string& key,
     OutputArchive& nested_archive) {
+  TORCH_CHECK(
+      !nested_archive.streaming_,
+      "A streaming archive cannot be nested in another archive");
+  if (streaming_) {
+    std::vector<std::string> path = {key};
+    streaming_->write_module(path, nested_archive.module_);
+    return;
+  }
   module_.register_module(key, nested_archive.module_);
 }
 
 void OutputArchive::save_to(const std::string& filename) {
+  TORCH_CHECK(!streaming_, "A streaming archive is completed by finish()");
   jit::ExportModule(module_, filename);
 }
 
 void OutputArchive::save_to(std::ostream& stream) {
+  TORCH_CHECK(!streaming_, "A streaming archive is completed by finish()");
   jit::ExportModule(module_, stream);
 }
 
 void OutputArchive::save_to(
     const std::function<size_t(const void*, size_t)>& func) {
+  TORCH_CHECK(!streaming_, "A streaming archive is completed by finish()");
   jit::ExportModule(module_, func);
 }
+
+void OutputArchive::finish() {
+  TORCH_CHECK(streaming_, "finish() can only be called on a streaming archive");
+  streaming_->finish();
+}
 } // namespace serialize
 } // namespace torch
@@ -12,8 +12,21 @@ struct TORCH_API AnomalyMode {
     _enabled = enabled;
   }
 
+  // In fast mode, the forward stacks are recorded as compact frame ids that
+  // are only formatted for the function that fails, and the outputs of the
+  // backward functions are checked for nan and inf values without
+  // synchronizing after each of them: the error is raised when the backward
+  // pass ends, for the first function that returned such values.
+  static bool is_fast() {
+    return _fast;
+  }
+  static void set_fast(bool fast) {
+    _fast = fast;
+  }
+
 private:
   static bool _enabled;
+  static bool _fast;
 };
 
 
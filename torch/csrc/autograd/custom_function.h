@@ -143,6 +143,7 @@ struct CppNode : public Node {
   std::vector<VariableInfo> output_info_;
 
   void release_variables() override;
+  void prefetch_variables() override;
 
   void set_ctx_grad_fn(const std::shared_ptr<Node> &node);
   void save_variables_to_ctx();
@@ -180,7 +181,7 @@ typename std::enable_if<std::is_same<T, Variable>::value, T>::type to_output_typ
 template<class T>
 template<typename X, typename... Args>
 auto Function<T>::apply(Args&&... args) -> c10::guts::enable_if_t<std::is_same<X,T>::value, forward_t<X,Args...>> {
-  std::shared_ptr<CppNode<T>> node(new CppNode<T>(), deleteNode);
+  std::shared_ptr<CppNode<T>> node(new CppNode<T>(), deleteNode, NodeAllocator<CppNode<T>>());
   variable_list input_vars;
 
   const size_t num_inputs = sizeof...(Args);
@@ -299,6 +300,13 @@ void CppNode<T>::release_variables() {
   ctx_.has_freed_buffers_ = true;
 }
 
+template<class T>
+void CppNode<T>::prefetch_variables() {
+  for (const auto& var : ctx_.saved_variables_) {
+    var.prefetch();
+  }
+}
+
 template<class T>
 void CppNode<T>::save_variables_to_ctx() {
   ctx_.save_variables();
@@ -18,6 +18,7 @@
 #include <c10/core/StreamGuard.h>
 
 #include <atomic>
+#include <cmath>
 #include <condition_variable>
 #include <cstdint>
 #include <functional>
@@ -53,6 +54,10 @@ static thread_local bool checkpoint_valid = true;
 // engine thread affinity to the device can break this invariant, and we depend
 // on it in a few places (e.g. AccumulateGrad function).
 
+// True for the threads of the CPU backward pool, which have no worker_device
+// of their own. See Note [Parallel CPU backward]
+static thread_local bool is_cpu_pool_thread = false;
+
 // Number of nested reentrant backwards calls currently on this thread
 static thread_local int current_depth = 0;
 // Total nested reentrant backwards calls over all threads for workder_device
@@ -80,8 +85,12 @@ struct ReadyQueue {
   std::priority_queue<NodeTask, std::vector<NodeTask>, CompareNodeTaskTime> heap_;
   // To notify threads waiting on the ReadyQueue of available tasks on the heap_
   std::condition_variable not_empty_;
-  // To protect read and writes to heap_
+  // To protect read and writes to heap_ and waiting_
   std::mutex mutex_;
+  // Number of threads blocked in pop(). Pushes only notify not_empty_ when
+  // somebody is waiting, which saves a futex wake per node while the worker
+  // is busy working through a long chain of small functions.
+  int waiting_ = 0;
 
   // incrementOutstandingTasks indicates whether or not we should increment
   // 'outstanding_tasks_' for the associated GraphTask. This should mostly
@@ -90,6 +99,7 @@ struct ReadyQueue {
   void push(NodeTask item, bool incrementOutstandingTasks = true);
   void pushShutdownTask();
   NodeTask pop();
+  bool empty();
 };
 
 // Note [Reentrant backwards]
@@ -151,11 +161,51 @@ struct ReadyQueue {
 // the leaf streams with the default streams is sufficient to implement
 // the historic behavior.
 
+// Note [Inline CPU backward]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Handing every node over to the CPU worker thread costs a lock, a
+// condition variable wakeup and a context switch, which for graphs made of
+// many tiny CPU functions (embedding lookups, small elementwise ops) can be
+// more than the functions themselves. When inline CPU backward is enabled,
+// a backward() called from a non-worker thread on a graph in which every
+// function takes CPU gradients runs entirely on the calling thread, from a
+// ready queue private to its GraphTask, and never touches the device
+// threads.
+//
+// This relaxes the guarantee described above that a function's apply is
+// never entered concurrently: two threads running backward inline through
+// a shared leaf would both run its AccumulateGrad. That's why the mode is
+// opt-in, for programs that don't run backward from several threads at once.
+static std::atomic<bool> inline_cpu_backward_enabled{false};
+
+// Note [Parallel CPU backward]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// With a single CPU worker, the towers of a wide graph are differentiated
+// one after another. When num_cpu_backward_threads is set, the CPU functions
+// of a backward pass started from a non-worker thread are instead queued on
+// cpu_pool_queue_, from which that many pool threads pop work as soon as the
+// dependency counts of compute_dependencies say it's ready. Everything that is
+// shared between the functions of a GraphTask (dependencies_, not_ready_ and
+// the InputBuffers in it, captured_vars_, leaf_streams) is only touched with
+// the GraphTask's mutex held, so accumulating gradients stays safe.
+//
+// Pool threads don't have a worker_device, so a reentrant backward started
+// from one of them behaves like one started by a user thread: it blocks until
+// its GraphTask is done rather than going back to the shared queue (where it
+// couldn't tell which thread is waiting for which task). That nested task
+// isn't given to the pool, but to the regular CPU worker, so a pool full of
+// blocked threads can't deadlock it.
+//
+// As with Note [Inline CPU backward], this gives up on a function's apply
+// never being entered concurrently, for functions shared by backward passes
+// running at the same time.
+
 int NodeTask::getReentrantDepth() const {
   return base_->reentrant_depth_;
 }
 
 auto ReadyQueue::push(NodeTask item, bool incrementOutstandingTasks) -> void {
+  bool notify;
   {
     // Lock mutex for writing to heap_
     std::lock_guard<std::mutex> lock(mutex_);
@@ -163,8 +213,11 @@ auto ReadyQueue::push(NodeTask item, bool incrementOutstandingTasks) -> void {
       ++item.base_->outstanding_tasks_;
     }
     heap_.push(std::move(item));
+    notify = waiting_ > 0;
+  }
+  if (notify) {
+    not_empty_.notify_one();
   }
-  not_empty_.notify_one();
 }
 
 auto ReadyQueue::pushShutdownTask() -> void {
@@ -178,12 +231,21 @@ auto ReadyQueue::pushShutdownTask() -> void {
 auto ReadyQueue::pop() -> NodeTask {
   // Lock mutex for accesses to heap_
   std::unique_lock<std::mutex> lock(mutex_);
-  not_empty_.wait(lock, [this]{ return !heap_.empty(); });
+  if (heap_.empty()) {
+    ++waiting_;
+    not_empty_.wait(lock, [this]{ return !heap_.empty(); });
+    --waiting_;
+  }
   // NOLINTNEXTLINE(cppcoreguidelines-pro-type-const-cast)
   auto task = std::move(const_cast<NodeTask&>(heap_.top())); heap_.pop();
   return task;
 }
 
+auto ReadyQueue::empty() -> bool {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return heap_.empty();
+}
+
 // This limit is based on the default python recursion limit which is 1000
 Engine::Engine() : max_recursion_depth_(100) {}
 
@@ -196,10 +258,17 @@ Engine::~Engine() {
     std::lock_guard<std::mutex> lock(queue->mutex_);
     noBackward =  noBackward && queue->heap_.empty();
   }
+  if (cpu_pool_queue_) {
+    std::lock_guard<std::mutex> lock(cpu_pool_queue_->mutex_);
+    noBackward = noBackward && cpu_pool_queue_->heap_.empty();
+  }
   if (noBackward) {
     for (auto& queue : ready_queues_) {
      queue->pushShutdownTask();
     }
+    for (int i = 0; i < cpu_pool_size_; ++i) {
+      cpu_pool_queue_->pushShutdownTask();
+    }
   }
   // Othewise threads are leaked
 }
@@ -213,7 +282,7 @@ void Engine::set_device(int device) {
   //
   // Don't use DeviceGuard here because its destructor may be called before the
   // device is reset. This is fine because the device is thread local.
-  if (device != -1) {
+  if (device >= 0) {
     for (size_t i = 0; i < static_cast<size_t>(c10::DeviceType::COMPILE_TIME_MAX_DEVICE_TYPES); i++) {
       auto* impl = c10::impl::device_guard_impl_registry[i].load();
       if (impl && device < impl->deviceCount()) {
@@ -243,7 +312,11 @@ auto Engine::thread_init(int device) -> void {
   // We don't have any good reason to prefer one or the other, so we've
   // arbitrarily picked to colocate devices.  Maybe the other approach is
   // better.
-  set_device(device);
+  if (device == CPU_POOL_DEVICE) {
+    is_cpu_pool_thread = true;
+  } else {
+    set_device(device);
+  }
   thread_main(nullptr);
 }
 
@@ -262,7 +335,8 @@ auto Engine::thread_init(int device) -> void {
 // It's all ok and is handled right now, but it should be accounted for
 // in case this code is to be changed.
 auto Engine::thread_main(GraphTask *graph_task) -> void {
-  auto queue = ready_queues_[worker_device + 1];
+  auto queue = is_cpu_pool_thread ? cpu_pool_queue_
+                                  : ready_queues_[worker_device + 1];
   // Why the test on graph_task->outstanding_tasks_?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks_ > 0) {
@@ -504,16 +578,34 @@ auto Engine::evaluate_function(NodeTask& task) -> void {
   }
 
   int num_outputs = outputs.size();
-  if (num_outputs == 0) { // Note: doesn't acquire the mutex
+  if (num_outputs == 0) {
     // Records leaf stream (if applicable)
     // See note "Streaming backwards"
     if (opt_parent_stream) {
+      std::lock_guard<std::mutex> lock(task.base_->mutex_);
       task.base_->leaf_streams.emplace(*opt_parent_stream);
     }
     return;
   }
 
-  if (AnomalyMode::is_enabled()) {
+  if (AnomalyMode::is_enabled() && AnomalyMode::is_fast()) {
+    // A single reduction per output, that isn't waited for. Summing in
+    // double only overflows if the output already has infinite values.
+    AutoGradMode grad_mode(false);
+    std::vector<GraphTask::AnomalyCheck> checks;
+    for (int i = 0; i < num_outputs; ++i) {
+      auto& output = outputs[i];
+      if (output.defined() && !output.is_sparse() &&
+          output.is_floating_point()) {
+        at::OptionalDeviceGuard guard(device_of(output));
+        checks.push_back({task.fn_, i, output.sum(at::kDouble)});
+      }
+    }
+    std::lock_guard<std::mutex> lock(task.base_->mutex_);
+    for (auto& check : checks) {
+      task.base_->anomaly_checks_.push_back(std::move(check));
+    }
+  } else if (AnomalyMode::is_enabled()) {
     AutoGradMode grad_mode(false);
     for (int i = 0; i < num_outputs; ++i) {
       auto& output = outputs[i];
@@ -562,13 +654,21 @@ auto Engine::evaluate_function(NodeTask& task) -> void {
 
       // Accumulates into buffer
       const auto opt_next_stream = next.function->stream(c10::DeviceType::CUDA);
+
+      // Its first gradient is here, so start bringing back what the function
+      // saved on the stream it'll run on. See Note [Offloading and
+      // recomputing saved variables]
+      {
+        c10::OptionalStreamGuard next_stream_guard{opt_next_stream};
+        next.function->prefetch_variables();
+      }
       input_buffer.add(next.input_nr,
                        std::move(output),
                        opt_parent_stream,
                        opt_next_stream);
 
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue(*task.base_, input_buffer.device());
         queue.push(NodeTask(task.base_, next.function, std::move(input_buffer)));
       } else {
         not_ready.emplace(next.function.get(), std::move(input_buffer));
@@ -584,7 +684,7 @@ auto Engine::evaluate_function(NodeTask& task) -> void {
                        opt_parent_stream,
                        opt_next_stream);
       if (is_ready) {
-        auto& queue = ready_queue(input_buffer.device());
+        auto& queue = ready_queue(*task.base_, input_buffer.device());
         queue.push(NodeTask(task.base_, next.function, std::move(input_buffer)));
         not_ready.erase(not_ready_it);
       }
@@ -652,9 +752,67 @@ auto Engine::execute(const edge_list& roots,
   if (!outputs.empty()) {
     graph_task.init_to_execute(*graph_root, outputs);
   }
+  if (is_inline_cpu_backward_enabled() && worker_device == NO_DEVICE &&
+      takes_only_cpu_inputs(graph_task, inputs)) {
+    return execute_inline(graph_task, graph_root);
+  }
+  // See Note [Parallel CPU backward]
+  int num_cpu_threads = num_cpu_backward_threads();
+  if (num_cpu_threads > 0 && worker_device == NO_DEVICE &&
+      !is_cpu_pool_thread) {
+    std::call_once(start_threads_flag_, &Engine::start_threads, this);
+    start_cpu_pool_threads(num_cpu_threads);
+    graph_task.parallel_cpu_ = true;
+  }
   return execute_with_graph_task(graph_task, graph_root);
 }
 
+// Whether all the gradients flowing through graph_task are on the CPU,
+// according to the metadata the functions recorded in forward.
+bool Engine::takes_only_cpu_inputs(
+    const GraphTask& graph_task,
+    const variable_list& inputs) {
+  for (const auto& input : inputs) {
+    if (input.defined() && !input.device().is_cpu()) {
+      return false;
+    }
+  }
+  for (const auto& entry : graph_task.dependencies_) {
+    const Node* fn = entry.first;
+    for (uint32_t i = 0; i < fn->num_inputs(); ++i) {
+      if (!fn->input_metadata(i).device().is_cpu()) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// See Note [Inline CPU backward]
+variable_list Engine::execute_inline(
+    GraphTask& graph_task,
+    std::shared_ptr<Node> graph_root) {
+  ReadyQueue queue;
+  graph_task.inline_queue_ = &queue;
+  queue.push(NodeTask(&graph_task, std::move(graph_root), InputBuffer(0)));
+
+  AutoGradMode grad_mode(graph_task.grad_mode_);
+  while (!queue.empty()) {
+    NodeTask task = queue.pop();
+    if (!graph_task.has_error_.load()) {
+      try {
+        evaluate_function(task);
+      } catch (std::exception& e) {
+        thread_on_exception(task, e);
+      }
+    }
+    --graph_task.outstanding_tasks_;
+  }
+  graph_task.inline_queue_ = nullptr;
+
+  return graph_task_exec_post_processing(graph_task);
+}
+
 void Engine::enqueue_blocked_task_on_cpu(NodeTask task) {
   std::call_once(start_threads_flag_, &Engine::start_threads, this);
   ready_queue(at::kCPU).push(
@@ -668,7 +826,7 @@ variable_list Engine::execute_with_graph_task(
   // Lock mutex for GraphTask.
   std::unique_lock<std::mutex> lock(graph_task.mutex_);
 
-  ready_queue(at::kCPU).push(NodeTask(&graph_task, std::move(graph_root), InputBuffer(0)));
+  ready_queue(graph_task, at::kCPU).push(NodeTask(&graph_task, std::move(graph_root), InputBuffer(0)));
 
   // Not a worker
   if (worker_device == NO_DEVICE) {
@@ -697,6 +855,10 @@ variable_list Engine::execute_with_graph_task(
     --total_depth;
   }
 
+  return graph_task_exec_post_processing(graph_task);
+}
+
+variable_list Engine::graph_task_exec_post_processing(GraphTask& graph_task) {
   // Check for an exception while running backwards
   if (graph_task.has_error_.load()) {
     std::rethrow_exception(graph_task.exception_);
@@ -732,9 +894,52 @@ variable_list Engine::execute_with_graph_task(
     }
   }
 
+  if (!graph_task.anomaly_checks_.empty()) {
+    check_anomalies(graph_task);
+  }
+
   return graph_task.captured_vars_;
 }
 
+// Raises the error of fast anomaly mode for the first function that returned
+// nan or inf values. There is one synchronization per device for the whole
+// backward pass, after the leaf streams were synced with the default streams.
+void Engine::check_anomalies(GraphTask& graph_task) {
+  AutoGradMode grad_mode(false);
+  auto& checks = graph_task.anomaly_checks_;
+  std::vector<bool> finite(checks.size(), true);
+  std::vector<bool> done(checks.size(), false);
+  for (size_t i = 0; i < checks.size(); ++i) {
+    if (done[i]) {
+      continue;
+    }
+    std::vector<size_t> indices;
+    std::vector<at::Tensor> sums;
+    for (size_t j = i; j < checks.size(); ++j) {
+      if (!done[j] && checks[j].sum_.device() == checks[i].sum_.device()) {
+        indices.push_back(j);
+        sums.push_back(checks[j].sum_);
+        done[j] = true;
+      }
+    }
+    auto values = at::stack(sums).cpu();
+    auto data = values.data_ptr<double>();
+    for (size_t k = 0; k < indices.size(); ++k) {
+      finite[indices[k]] = std::isfinite(data[k]);
+    }
+  }
+  for (size_t i = 0; i < checks.size(); ++i) {
+    if (!finite[i]) {
+      auto& fn = *checks[i].fn_;
+      fn.metadata()->print_stack();
+      std::stringstream ss;
+      ss << "Function '" << fn.name() << "' returned nan or inf values in its "
+         << checks[i].output_nr_ << "th output.";
+      throw std::runtime_error(ss.str());
+    }
+  }
+}
+
 // note that when python is present, this base engine will be overriden
 // with a PythonEngine. Because this typically happens before get_default_engine
 // is called, this base engine will never be created.
@@ -763,6 +968,26 @@ bool Engine::is_checkpoint_valid() {
   return checkpoint_valid;
 }
 
+void Engine::set_inline_cpu_backward_enabled(bool enabled) {
+  inline_cpu_backward_enabled.store(enabled);
+}
+
+bool Engine::is_inline_cpu_backward_enabled() {
+  return inline_cpu_backward_enabled.load();
+}
+
+void Engine::set_num_cpu_backward_threads(int num_threads) {
+  TORCH_CHECK(
+      num_threads >= 0,
+      "number of CPU backward threads must be non-negative, got ",
+      num_threads);
+  num_cpu_backward_threads_.store(num_threads);
+}
+
+int Engine::num_cpu_backward_threads() const {
+  return num_cpu_backward_threads_.load();
+}
+
 auto Engine::ready_queue(at::Device device) -> ReadyQueue& {
   // See Note [Allocating GPUs to autograd threads]
   if (device.type() == at::kCPU) {
@@ -772,6 +997,17 @@ auto Engine::ready_queue(at::Device device) -> ReadyQueue& {
   }
 }
 
+auto Engine::ready_queue(const GraphTask& graph_task, at::Device device)
+    -> ReadyQueue& {
+  if (graph_task.inline_queue_) {
+    return *graph_task.inline_queue_;
+  }
+  if (graph_task.parallel_cpu_ && device.type() == at::kCPU) {
+    return *cpu_pool_queue_;
+  }
+  return ready_queue(device);
+}
+
 // See Note [Allocating GPUs to autograd threads]
 // NB: This would become obsolete if we truly allocated a CPU thread
 // per device, rather than colocate.
@@ -796,6 +1032,8 @@ auto Engine::start_threads() -> void {
   for (auto& queue : ready_queues_)
     queue.reset(new ReadyQueue());
 
+  cpu_pool_queue_ = std::make_shared<ReadyQueue>();
+
   thread_pool_shared_ = std::make_shared<ThreadPoolShared>();
 
   for (int i = 0; i < num_threads; ++i) {
@@ -804,6 +1042,17 @@ auto Engine::start_threads() -> void {
   }
 }
 
+// The pool only ever grows: threads started for a larger setting keep serving
+// cpu_pool_queue_ when num_cpu_backward_threads is lowered again, only setting
+// it to 0 stops handing work to the pool.
+void Engine::start_cpu_pool_threads(int num_threads) {
+  std::lock_guard<std::mutex> lock(cpu_pool_mutex_);
+  for (; cpu_pool_size_ < num_threads; ++cpu_pool_size_) {
+    std::thread t(&Engine::thread_init, this, CPU_POOL_DEVICE);
+    t.detach();
+  }
+}
+
 void Engine::add_thread_pool_task(GraphTask *graph_task) {
   std::unique_lock<std::mutex> lck(thread_pool_shared_->mutex_);
   // There may already be some items on the graphtasks_queue_ added by other
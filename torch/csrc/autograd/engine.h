@@ -33,6 +33,9 @@ void validate_outputs(
 
 // NB: -1 indicates the CPU worker!
 static constexpr int NO_DEVICE = -2;
+// Passed to thread_init for the threads of the CPU backward pool, which
+// otherwise count as non-worker threads. See Note [Parallel CPU backward]
+static constexpr int CPU_POOL_DEVICE = -3;
 
 // GraphTask holds metadata needed for a single execution of backward()
 struct GraphTask {
@@ -80,6 +83,22 @@ struct GraphTask {
   std::shared_ptr<at::ThreadLocalDebugInfoBase> debug_info_ =
       at::getThreadLocalDebugInfo();
   std::unordered_set<c10::Stream> leaf_streams;
+  // Set while the whole task runs on the thread that called execute, see
+  // Note [Inline CPU backward]. Ready functions are queued here instead of on
+  // the device queues.
+  ReadyQueue* inline_queue_ = nullptr;
+  // Whether the CPU functions of this task are spread over the CPU backward
+  // pool, see Note [Parallel CPU backward]
+  bool parallel_cpu_ = false;
+
+  // The outputs of the functions that ran in fast anomaly mode, reduced to
+  // a scalar that is checked when the task ends, in execution order.
+  struct AnomalyCheck {
+    std::shared_ptr<Node> fn_;
+    int output_nr_;
+    at::Tensor sum_;
+  };
+  std::vector<AnomalyCheck> anomaly_checks_;
 
   void init_to_execute(Node& graph_root, const edge_list& outputs);
 
@@ -177,10 +196,30 @@ struct TORCH_API Engine {
 
   bool is_checkpoint_valid();
 
+  // Lets backward run on the calling thread for CPU-only graphs, see
+  // Note [Inline CPU backward] in engine.cpp
+  static void set_inline_cpu_backward_enabled(bool enabled);
+  static bool is_inline_cpu_backward_enabled();
+
+  // Number of threads that run the CPU functions of backward passes started
+  // from non-worker threads, 0 to use the single CPU worker. See
+  // Note [Parallel CPU backward] in engine.cpp
+  void set_num_cpu_backward_threads(int num_threads);
+  int num_cpu_backward_threads() const;
+
 protected:
   void compute_dependencies(Node* root, GraphTask& task);
   void evaluate_function(NodeTask& task);
+  bool takes_only_cpu_inputs(
+      const GraphTask& graph_task,
+      const variable_list& inputs);
+  variable_list execute_inline(
+      GraphTask& graph_task,
+      std::shared_ptr<Node> graph_root);
+  variable_list graph_task_exec_post_processing(GraphTask& graph_task);
+  void check_anomalies(GraphTask& graph_task);
   ReadyQueue& ready_queue(at::Device device);
+  ReadyQueue& ready_queue(const GraphTask& graph_task, at::Device device);
   ReadyQueue& ready_queue_by_index(int device_index);
   void start_threads();
   virtual void thread_init(int device);
@@ -189,11 +228,19 @@ protected:
   void reentrant_thread_init();
   void add_thread_pool_task(GraphTask *graph_task);
   void set_device(int device);
+  void start_cpu_pool_threads(int num_threads);
 
   // Ensures ready_queues_ are initialized only once
   std::once_flag start_threads_flag_;
   // Safe to read ready_queues_ without synchronization after intialization
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues_;
+  // Shared by all the threads of the CPU backward pool, created together with
+  // ready_queues_
+  std::shared_ptr<ReadyQueue> cpu_pool_queue_;
+  std::atomic<int> num_cpu_backward_threads_{0};
+  // To protect cpu_pool_size_, the number of pool threads started so far
+  std::mutex cpu_pool_mutex_;
+  int cpu_pool_size_ = 0;
   std::vector<std::function<void()>> final_callbacks_;
   // To protect reads and writes to final_callbacks_
   std::mutex post_callbacks_lock_;
@@ -6,8 +6,10 @@
 #include <ATen/ATen.h>
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <memory>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <utility>
@@ -15,6 +17,81 @@
 
 namespace torch { namespace autograd {
 
+namespace detail {
+
+namespace {
+
+// Node pool size classes are multiples of 64 bytes up to 1 KiB, which
+// covers the generated backward functions and the control blocks of the
+// shared_ptrs owning them. Blocks of a size class are always allocated with
+// the full class size so that any thread can reuse them. Each thread keeps at
+// most kMaxCachedBytes of free blocks per size class.
+constexpr size_t kSizeClassBytes = 64;
+constexpr size_t kNumSizeClasses = 16;
+constexpr size_t kMaxCachedBytes = 256 * 1024;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct ThreadNodePool {
+  std::array<FreeBlock*, kNumSizeClasses> free_blocks{};
+  std::array<size_t, kNumSizeClasses> num_free_blocks{};
+
+  ~ThreadNodePool();
+};
+
+// Graph objects can be freed by other thread_locals after the pool of their
+// thread is gone; they then go straight back to the system.
+thread_local bool pool_destroyed = false;
+thread_local ThreadNodePool pool;
+
+ThreadNodePool::~ThreadNodePool() {
+  pool_destroyed = true;
+  for (auto block : free_blocks) {
+    while (block) {
+      FreeBlock* next = block->next;
+      ::operator delete(block);
+      block = next;
+    }
+  }
+}
+
+} // namespace
+
+void* node_pool_allocate(size_t size) {
+  const size_t size_class = (std::max<size_t>(size, 1) - 1) / kSizeClassBytes;
+  if (size_class >= kNumSizeClasses) {
+    return ::operator new(size);
+  }
+  if (pool_destroyed || !pool.free_blocks[size_class]) {
+    return ::operator new((size_class + 1) * kSizeClassBytes);
+  }
+  FreeBlock*& head = pool.free_blocks[size_class];
+  FreeBlock* block = head;
+  head = block->next;
+  --pool.num_free_blocks[size_class];
+  return block;
+}
+
+void node_pool_free(void* ptr, size_t size) {
+  if (!ptr) {
+    return;
+  }
+  const size_t size_class = (std::max<size_t>(size, 1) - 1) / kSizeClassBytes;
+  if (size_class >= kNumSizeClasses || pool_destroyed ||
+      pool.num_free_blocks[size_class] * (size_class + 1) * kSizeClassBytes >= kMaxCachedBytes) {
+    ::operator delete(ptr);
+    return;
+  }
+  auto block = static_cast<FreeBlock*>(ptr);
+  block->next = pool.free_blocks[size_class];
+  pool.free_blocks[size_class] = block;
+  ++pool.num_free_blocks[size_class];
+}
+
+} // namespace detail
+
 /// Monotonically incrementing (thread local!) counter to supply sequence
 /// numbers.
 thread_local uint64_t Function_next_sequence_nr_ = 0;
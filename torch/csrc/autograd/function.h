@@ -37,6 +37,41 @@ using IndexRange = std::pair<size_t, size_t>;
 // Custom deleter to prevent stack overflows.
 TORCH_API void deleteNode(Node* function);
 
+namespace detail {
+// Allocation of autograd graph objects from thread-local free lists of a few
+// size classes (see function.cpp). Blocks freed on another thread than the
+// one that allocated them go to the free lists of the freeing thread.
+TORCH_API void* node_pool_allocate(size_t size);
+TORCH_API void node_pool_free(void* ptr, size_t size);
+} // namespace detail
+
+/// A std allocator drawing from the node pool, e.g. for the control blocks
+/// of the shared_ptrs owning Nodes:
+/// `std::shared_ptr<T>(new T(...), deleteNode, NodeAllocator<T>())`.
+template <typename T>
+struct NodeAllocator {
+  using value_type = T;
+  NodeAllocator() = default;
+  template <typename U>
+  NodeAllocator(const NodeAllocator<U>&) {}
+  T* allocate(size_t n) {
+    return static_cast<T*>(detail::node_pool_allocate(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, size_t n) {
+    detail::node_pool_free(ptr, n * sizeof(T));
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const NodeAllocator<T>&, const NodeAllocator<U>&) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const NodeAllocator<T>&, const NodeAllocator<U>&) {
+  return false;
+}
+
 ///~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 ///                               Node
 ///~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -110,6 +145,16 @@ struct TORCH_API Node : std::enable_shared_from_this<Node> {
   Node& operator=(Node&& other) = delete;
   virtual ~Node() = default;
 
+  /// Nodes are created and freed for every differentiable op, so they come
+  /// from the node pool instead of the general purpose allocator. The sized
+  /// delete receives the size of the most derived type.
+  static void* operator new(size_t size) {
+    return detail::node_pool_allocate(size);
+  }
+  static void operator delete(void* ptr, size_t size) {
+    detail::node_pool_free(ptr, size);
+  }
+
   /// Evaluates the function on the given inputs and returns the result of the
   /// function call.
   variable_list operator()(variable_list&& inputs) {
@@ -310,6 +355,11 @@ struct TORCH_API Node : std::enable_shared_from_this<Node> {
   /// Releases saved variables if the operation won't be reused.
   virtual void release_variables() {}
 
+  /// Starts bringing back the saved variables that were offloaded, called by
+  /// the engine once the first gradient for this function is available. See
+  /// Note [Offloading and recomputing saved variables]
+  virtual void prefetch_variables() {}
+
   /// Called before an apply if `release_variables()` is going to be called.
   /// Allows larger ops like `InterpreterAutogradFunction` to incrementally
   /// release variables as they run.
@@ -78,6 +78,9 @@ auto AccumulateGrad::apply(variable_list&& grads) -> variable_list {
       // In all of these three cases, `grad_variable += new_grad` is a valid operation
       // which adds `new_grad` to `grad_variable` in place. `grad_variable` is thus
       // still referring to the same tensor after the operation.
+      // The DDP Reducer relies on this when grads are views into its gradient
+      // buckets (see `gradient_as_bucket_view` in reducer.h): accumulation then
+      // writes straight into the tensor that is reduced.
       grad_variable += new_grad;
     }
   } else {
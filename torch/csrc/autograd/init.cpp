@@ -1,11 +1,16 @@
 #include <torch/csrc/python_headers.h>
 
+#include <ATen/autocast_mode.h>
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/utils/pybind.h>
+#include <torch/csrc/utils/python_numbers.h>
+#include <torch/csrc/autograd/engine.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/autograd/python_function.h>
 #include <torch/csrc/autograd/function.h>
+#include <torch/csrc/autograd/python_hook.h>
+#include <torch/csrc/autograd/saved_variable.h>
 
 PyObject* THPAutograd_initExtension(PyObject* _unused, PyObject *unused) {
   using namespace torch::autograd::profiler;
@@ -51,9 +56,96 @@ PyObject* THPAutograd_initExtension(PyObject* _unused, PyObject *unused) {
   m.def("_enable_profiler", enableProfiler);
   m.def("_disable_profiler", disableProfiler);
 
+  py::class_<SamplingProfilerConfig>(m, "SamplingProfilerConfig")
+      .def(py::init<>())
+      .def_readwrite("sampling_period", &SamplingProfilerConfig::sampling_period)
+      .def_readwrite("burst_us", &SamplingProfilerConfig::burst_us)
+      .def_readwrite("interval_us", &SamplingProfilerConfig::interval_us)
+      .def_readwrite("buffer_size", &SamplingProfilerConfig::buffer_size)
+      .def_readwrite(
+          "record_kernels", &SamplingProfilerConfig::record_kernels);
+
+  py::class_<SampledRange>(m, "SampledRange")
+      .def_readonly("name_id", &SampledRange::name_id)
+      .def_readonly("thread_id", &SampledRange::thread_id)
+      .def_readonly("correlation_id", &SampledRange::correlation_id)
+      .def_readonly("start_ns", &SampledRange::start_ns)
+      .def_readonly("end_ns", &SampledRange::end_ns);
+
+  py::class_<KernelRange>(m, "KernelRange")
+      .def_readonly("name", &KernelRange::name)
+      .def_readonly("correlation_id", &KernelRange::correlation_id)
+      .def_readonly("device", &KernelRange::device)
+      .def_readonly("stream", &KernelRange::stream)
+      .def_readonly("start_ns", &KernelRange::start_ns)
+      .def_readonly("end_ns", &KernelRange::end_ns);
+
+  py::class_<SampledRanges>(m, "SampledRanges")
+      .def_readonly("ranges", &SampledRanges::ranges)
+      .def_readonly("names", &SampledRanges::names)
+      .def_readonly("kernels", &SampledRanges::kernels)
+      .def_readonly("dropped", &SampledRanges::dropped);
+
+  m.def("_enable_sampling_profiler", enableSamplingProfiler);
+  m.def("_drain_sampling_profiler", drainSamplingProfiler);
+  m.def("_disable_sampling_profiler", disableSamplingProfiler);
+
+  py::class_<TraceStreamer>(m, "_TraceStreamer")
+      .def(
+          py::init<std::string, SamplingProfilerConfig, int64_t>(),
+          py::arg("filename"),
+          py::arg("config") = TraceStreamer::defaultConfig(),
+          py::arg("flush_interval_ms") = 100)
+      .def("stop", &TraceStreamer::stop);
+
   m.def("_push_range", [](std::string name) { pushRange(std::move(name)); });
   m.def("_pop_range", []() { popRange(); });
 
+  // See Note [Offloading and recomputing saved variables]
+  using torch::autograd::RecomputeRegion;
+  using torch::autograd::SavedVariableMode;
+  m.def("_set_saved_variable_offload", SavedVariableMode::set_offload_min_bytes);
+  m.def("_get_saved_variable_offload", SavedVariableMode::offload_min_bytes);
+  py::class_<RecomputeRegion, std::shared_ptr<RecomputeRegion>>(
+      m, "_RecomputeRegion")
+      .def(py::init([](py::function recompute) {
+        // the region may be destroyed on an engine thread without the GIL
+        std::shared_ptr<py::object> fn(
+            new py::object(std::move(recompute)), [](py::object* fn) {
+              pybind11::gil_scoped_acquire gil;
+              delete fn;
+            });
+        return std::make_shared<RecomputeRegion>([fn]() {
+          pybind11::gil_scoped_acquire gil;
+          try {
+            (*fn)();
+          } catch (py::error_already_set& e) {
+            e.restore();
+            throw python_error();
+          }
+        });
+      }));
+  m.def("_set_recompute_region", [](py::object region) {
+    SavedVariableMode::set_recompute_region(
+        region.is_none() ? nullptr
+                         : region.cast<std::shared_ptr<RecomputeRegion>>());
+  });
+  m.def("_get_recompute_region", []() -> py::object {
+    auto region = SavedVariableMode::recompute_region();
+    return region ? py::cast(region) : py::none();
+  });
+
+  using torch::autograd::PyBatchedGradHook;
+  py::class_<PyBatchedGradHook, std::shared_ptr<PyBatchedGradHook>>(
+      m, "_BatchedGradHook")
+      .def(py::init([](std::vector<torch::autograd::Variable> tensors,
+                       py::function callback,
+                       size_t batch_size) {
+        return std::make_shared<PyBatchedGradHook>(
+            callback.ptr(), std::move(tensors), batch_size);
+      }))
+      .def("remove", &PyBatchedGradHook::remove);
+
   Py_RETURN_TRUE;
 }
 
@@ -79,6 +171,33 @@ static PyObject * is_grad_enabled(PyObject* _unused, PyObject *arg) {
   END_HANDLE_TH_ERRORS
 }
 
+static PyObject * set_autocast_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!PyBool_Check(arg)) {
+    throw TypeError("enabled must be a bool (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  at::autocast::set_enabled(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * is_autocast_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (at::autocast::is_enabled()) {
+    Py_RETURN_TRUE;
+  } else {
+    Py_RETURN_FALSE;
+  }
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * clear_autocast_cache(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  at::autocast::clear_cache();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 static PyObject * set_anomaly_mode_enabled(PyObject* _unused, PyObject *arg) {
   HANDLE_TH_ERRORS
   if (!PyBool_Check(arg)) {
@@ -99,12 +218,77 @@ static PyObject * is_anomaly_mode_enabled(PyObject* _unused, PyObject *arg) {
   END_HANDLE_TH_ERRORS
 }
 
+static PyObject * set_anomaly_mode_fast(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!PyBool_Check(arg)) {
+    throw TypeError("fast must be a bool (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  AnomalyMode::set_fast(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * is_anomaly_mode_fast(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (AnomalyMode::is_fast()) {
+    Py_RETURN_TRUE;
+  } else {
+    Py_RETURN_FALSE;
+  }
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * set_inline_cpu_backward_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!PyBool_Check(arg)) {
+    throw TypeError("enabled must be a bool (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  Engine::set_inline_cpu_backward_enabled(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * is_inline_cpu_backward_enabled(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (Engine::is_inline_cpu_backward_enabled()) {
+    Py_RETURN_TRUE;
+  } else {
+    Py_RETURN_FALSE;
+  }
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * set_num_cpu_backward_threads(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  if (!THPUtils_checkLong(arg)) {
+    throw TypeError("num_threads must be an int (got %s)", Py_TYPE(arg)->tp_name);
+  }
+  Engine::get_default_engine().set_num_cpu_backward_threads(THPUtils_unpackLong(arg));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * get_num_cpu_backward_threads(PyObject* _unused, PyObject *arg) {
+  HANDLE_TH_ERRORS
+  return THPUtils_packInt64(Engine::get_default_engine().num_cpu_backward_threads());
+  END_HANDLE_TH_ERRORS
+}
+
 // autograd methods on torch._C
 static PyMethodDef methods[] = {
   {"set_grad_enabled", (PyCFunction)set_grad_enabled, METH_O, nullptr},
   {"is_grad_enabled", (PyCFunction)is_grad_enabled, METH_NOARGS, nullptr},
+  {"set_autocast_enabled", (PyCFunction)set_autocast_enabled, METH_O, nullptr},
+  {"is_autocast_enabled", (PyCFunction)is_autocast_enabled, METH_NOARGS, nullptr},
+  {"clear_autocast_cache", (PyCFunction)clear_autocast_cache, METH_NOARGS, nullptr},
   {"set_anomaly_enabled", (PyCFunction)set_anomaly_mode_enabled, METH_O, nullptr},
   {"is_anomaly_enabled", (PyCFunction)is_anomaly_mode_enabled, METH_NOARGS, nullptr},
+  {"_set_anomaly_fast", (PyCFunction)set_anomaly_mode_fast, METH_O, nullptr},
+  {"_is_anomaly_fast", (PyCFunction)is_anomaly_mode_fast, METH_NOARGS, nullptr},
+  {"_set_inline_cpu_backward_enabled", (PyCFunction)set_inline_cpu_backward_enabled, METH_O, nullptr},
+  {"_is_inline_cpu_backward_enabled", (PyCFunction)is_inline_cpu_backward_enabled, METH_NOARGS, nullptr},
+  {"_set_num_cpu_backward_threads", (PyCFunction)set_num_cpu_backward_threads, METH_O, nullptr},
+  {"_get_num_cpu_backward_threads", (PyCFunction)get_num_cpu_backward_threads, METH_NOARGS, nullptr},
   {nullptr, nullptr, 0, nullptr}
 };
 
@@ -1,11 +1,16 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/jit/code_template.h>
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <list>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace torch { namespace autograd { namespace profiler {
@@ -128,31 +133,19 @@ void enableProfiler(ProfilerConfig config) {
     throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
 
+  CallbackConfig callback_config;
+  callback_config.needs_shapes = config.report_input_shapes;
   pushCallback(
       [config](const RecordFunction& fn) {
         auto* msg = (fn.seqNr() >= 0) ? ", seq = " : "";
         if (config.report_input_shapes) {
-          std::vector<std::vector<int64_t>> inputSizes;
-          inputSizes.reserve(fn.inputs().size());
-          for (const c10::IValue& input : fn.inputs()) {
-            if (!input.isTensor()) {
-              inputSizes.emplace_back();
-              continue;
-            }
-            const at::Tensor& tensor = input.toTensor();
-            if (tensor.defined()) {
-              inputSizes.push_back(input.toTensor().sizes().vec());
-            } else {
-              inputSizes.emplace_back();
-            }
-          }
-          pushRangeImpl(fn.name(), msg, fn.seqNr(), std::move(inputSizes));
+          pushRangeImpl(fn.name(), msg, fn.seqNr(), fn.inputSizes());
         } else {
           pushRangeImpl(fn.name(), msg, fn.seqNr(), {});
         }
       },
       [](const RecordFunction& /* unused */) { popRange(); },
-      config.report_input_shapes);
+      callback_config);
   state = new_state;
 
   if(state == ProfilerState::CUDA) {
@@ -226,6 +219,331 @@ double Event::cuda_elapsed_us(const Event & e) {
 
 CUDAStubs::~CUDAStubs() = default;
 
+namespace {
+
+// Written by the owning thread and drained by drainSamplingProfiler(), which
+// holds sample_buffers_mutex, so there is a single producer and consumer.
+struct SampleBuffer {
+  SampleBuffer(size_t capacity, uint16_t thread_id, uint64_t session)
+      : ranges(capacity), thread_id(thread_id), session(session) {}
+
+  void push(const SampledRange& range) {
+    const uint64_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == ranges.size()) {
+      dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    ranges[head % ranges.size()] = range;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  void drain(std::vector<SampledRange>& out) {
+    uint64_t tail = tail_.load(std::memory_order_relaxed);
+    const uint64_t head = head_.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+      out.push_back(ranges[tail % ranges.size()]);
+    }
+    tail_.store(head, std::memory_order_release);
+  }
+
+  std::vector<SampledRange> ranges;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<size_t> dropped{0};
+  const uint16_t thread_id;
+  const uint64_t session;
+  // Ranges started but not ended yet on the owning thread. The start time
+  // is negative for calls outside a burst.
+  struct OpenRange {
+    uint32_t name_id;
+    uint64_t correlation_id;
+    int64_t start_ns;
+  };
+  std::vector<OpenRange> open;
+  uint64_t num_ranges = 0;
+};
+
+bool sampling_enabled = false;
+double sampling_previous_probability = 1.0;
+int64_t sampling_start_ns = 0;
+int64_t sampling_burst_ns = 0;
+int64_t sampling_interval_ns = 0;
+size_t sampling_buffer_size = 0;
+bool sampling_record_kernels = false;
+std::atomic<uint64_t> sampling_session{0};
+
+uint16_t next_sampling_thread_id = 0;
+std::mutex sample_buffers_mutex;
+std::list<std::shared_ptr<SampleBuffer>> sample_buffers;
+thread_local std::shared_ptr<SampleBuffer> sample_buffer;
+
+SampleBuffer& getSampleBuffer() {
+  const uint64_t session = sampling_session.load(std::memory_order_relaxed);
+  if (!sample_buffer || sample_buffer->session != session) {
+    std::lock_guard<std::mutex> guard(sample_buffers_mutex);
+    const uint16_t id = sample_buffer ? sample_buffer->thread_id
+                                      : next_sampling_thread_id++;
+    sample_buffer =
+        std::make_shared<SampleBuffer>(sampling_buffer_size, id, session);
+    sample_buffers.emplace_front(sample_buffer);
+  }
+  return *sample_buffer;
+}
+
+// Interned names are never freed, so that ids and the pointers handed out
+// stay valid.
+struct NameTable {
+  std::mutex mutex;
+  std::unordered_map<std::string, uint32_t> ids;
+  std::deque<std::string> names;
+};
+
+NameTable& nameTable() {
+  static NameTable* table = new NameTable();
+  return *table;
+}
+
+uint32_t internName(const char* name) {
+  // Most names are string literals, so cache the id of every pointer seen
+  // by this thread. Owned names may reuse an address, hence the strcmp
+  // against the interned copy.
+  static thread_local std::
+      unordered_map<const char*, std::pair<uint32_t, const char*>>
+          cache;
+  auto it = cache.find(name);
+  if (it != cache.end() && std::strcmp(it->second.second, name) == 0) {
+    return it->second.first;
+  }
+  auto& table = nameTable();
+  std::lock_guard<std::mutex> guard(table.mutex);
+  auto id_it = table.ids.find(name);
+  if (id_it == table.ids.end()) {
+    id_it = table.ids.emplace(name, table.names.size()).first;
+    table.names.emplace_back(name);
+  }
+  const uint32_t id = id_it->second;
+  cache[name] = std::make_pair(id, table.names[id].c_str());
+  return id;
+}
+
+void startSampledRange(const RecordFunction& fn) {
+  auto& buffer = getSampleBuffer();
+  const int64_t now = getTime();
+  if (sampling_burst_ns > 0 &&
+      (now - sampling_start_ns) % sampling_interval_ns >= sampling_burst_ns) {
+    buffer.open.push_back({0, 0, -1});
+    return;
+  }
+  // Unique across threads, and never 0.
+  const uint64_t correlation_id =
+      (static_cast<uint64_t>(buffer.thread_id) + 1) << 40 | ++buffer.num_ranges;
+  if (sampling_record_kernels) {
+    cuda_stubs->pushCorrelationId(correlation_id);
+  }
+  buffer.open.push_back({internName(fn.name().str()), correlation_id, now});
+}
+
+void endSampledRange(const RecordFunction& /* unused */) {
+  auto& buffer = getSampleBuffer();
+  // The range started before the profiler was enabled.
+  if (buffer.open.empty()) {
+    return;
+  }
+  const auto open = buffer.open.back();
+  buffer.open.pop_back();
+  if (open.start_ns >= 0) {
+    if (sampling_record_kernels) {
+      cuda_stubs->popCorrelationId();
+    }
+    buffer.push({open.name_id,
+                 buffer.thread_id,
+                 open.correlation_id,
+                 open.start_ns,
+                 getTime()});
+  }
+}
+
+} // namespace
+
+void enableSamplingProfiler(SamplingProfilerConfig config) {
+  TORCH_CHECK(!sampling_enabled, "sampling profiler is already enabled");
+  TORCH_CHECK(config.buffer_size > 0, "buffer_size must be positive");
+  if (config.burst_us > 0) {
+    TORCH_CHECK(
+        config.interval_us >= config.burst_us,
+        "interval_us must be at least burst_us");
+  } else {
+    TORCH_CHECK(
+        config.sampling_period >= 1, "sampling_period must be at least 1");
+  }
+  if (config.record_kernels) {
+    TORCH_CHECK(
+        cuda_stubs->kernelTracingEnabled(),
+        "Can't record kernels - PyTorch was compiled without CUPTI");
+    cuda_stubs->enableKernelTracing();
+  }
+  sampling_record_kernels = config.record_kernels;
+
+  {
+    std::lock_guard<std::mutex> guard(sample_buffers_mutex);
+    sample_buffers.clear();
+  }
+  sampling_buffer_size = config.buffer_size;
+  sampling_burst_ns = config.burst_us * 1000;
+  sampling_interval_ns = config.interval_us * 1000;
+  sampling_start_ns = getTime();
+  sampling_session.fetch_add(1);
+
+  sampling_previous_probability = getSamplingProbability();
+  setSamplingProbability(
+      config.burst_us > 0 ? 1.0 : 1.0 / config.sampling_period);
+  pushCallback(
+      startSampledRange,
+      endSampledRange,
+      /* needs_inputs */ false,
+      /* sampled */ true);
+  sampling_enabled = true;
+}
+
+SampledRanges drainSamplingProfiler() {
+  TORCH_CHECK(sampling_enabled, "sampling profiler is not enabled");
+  SampledRanges result;
+  {
+    std::lock_guard<std::mutex> guard(sample_buffers_mutex);
+    for (auto it = sample_buffers.begin(); it != sample_buffers.end();) {
+      auto& buffer = *it;
+      buffer->drain(result.ranges);
+      result.dropped += buffer->dropped.exchange(0);
+      // GC buffers that are not held by any threads
+      if (buffer.use_count() == 1) {
+        it = sample_buffers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  if (sampling_record_kernels) {
+    cuda_stubs->drainKernels(result.kernels);
+  }
+  auto& table = nameTable();
+  std::lock_guard<std::mutex> guard(table.mutex);
+  result.names.assign(table.names.begin(), table.names.end());
+  return result;
+}
+
+SampledRanges disableSamplingProfiler() {
+  TORCH_CHECK(sampling_enabled, "sampling profiler is not enabled");
+  popCallback();
+  setSamplingProbability(sampling_previous_probability);
+  auto result = drainSamplingProfiler();
+  if (sampling_record_kernels) {
+    cuda_stubs->disableKernelTracing();
+    sampling_record_kernels = false;
+  }
+  sampling_enabled = false;
+  return result;
+}
+
+TraceStreamer::TraceStreamer(
+    const std::string& filename,
+    SamplingProfilerConfig config,
+    int64_t flush_interval_ms)
+    : out_(filename), flush_interval_ms_(flush_interval_ms) {
+  TORCH_CHECK(out_, "could not open file ", filename);
+  TORCH_CHECK(flush_interval_ms > 0, "flush_interval_ms must be positive");
+  enableSamplingProfiler(config);
+  start_ns_ = getTime();
+  out_ << "[\n";
+  thread_ = std::thread(&TraceStreamer::run, this);
+}
+
+TraceStreamer::~TraceStreamer() {
+  stop();
+}
+
+void TraceStreamer::stop() {
+  if (stopped_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_requested_ = true;
+  }
+  cv_.notify_one();
+  thread_.join();
+  stopped_ = true;
+  write(disableSamplingProfiler());
+  out_ << "\n]\n";
+  out_.close();
+}
+
+void TraceStreamer::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_), [&] {
+      return stop_requested_;
+    });
+    if (stop_requested_) {
+      return;
+    }
+    lock.unlock();
+    write(drainSamplingProfiler());
+    lock.lock();
+  }
+}
+
+static void writeJSONString(std::ostream& out, const char* str) {
+  out << '"';
+  for (; *str; ++str) {
+    const char c = *str;
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) < 0x20) {
+      out << ' ';
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void TraceStreamer::write(const SampledRanges& ranges) {
+  auto separator = [&] {
+    if (!first_) {
+      out_ << ",\n";
+    }
+    first_ = false;
+  };
+  for (const auto& range : ranges.ranges) {
+    separator();
+    out_ << "{\"name\": ";
+    writeJSONString(out_, ranges.names.at(range.name_id).c_str());
+    out_ << ", \"ph\": \"X\", \"ts\": " << (range.start_ns - start_ns_) / 1000.0
+         << ", \"dur\": " << (range.end_ns - range.start_ns) / 1000.0
+         << ", \"tid\": " << range.thread_id
+         << ", \"pid\": \"CPU Functions\", \"args\": {\"correlation\": "
+         << range.correlation_id << "}}";
+  }
+  for (const auto& kernel : ranges.kernels) {
+    separator();
+    out_ << "{\"name\": ";
+    writeJSONString(out_, kernel.name.c_str());
+    out_ << ", \"ph\": \"X\", \"ts\": " << (kernel.start_ns - start_ns_) / 1000.0
+         << ", \"dur\": " << (kernel.end_ns - kernel.start_ns) / 1000.0
+         << ", \"tid\": \"stream " << kernel.stream << "\""
+         << ", \"pid\": \"GPU " << kernel.device
+         << "\", \"args\": {\"correlation\": " << kernel.correlation_id
+         << "}}";
+  }
+  if (ranges.dropped > 0) {
+    separator();
+    out_ << "{\"name\": \"dropped " << ranges.dropped
+         << " ranges\", \"ph\": \"i\", \"s\": \"g\", \"ts\": "
+         << (getTime() - start_ns_) / 1000.0 << ", \"pid\": \"CPU Functions\"}";
+  }
+  out_.flush();
+}
+
 
 static jit::CodeTemplate event_template(R"(
 {
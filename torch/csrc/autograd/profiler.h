@@ -8,6 +8,9 @@
 #include <string>
 #include <sstream>
 #include <forward_list>
+#include <fstream>
+#include <condition_variable>
+#include <thread>
 #include <tuple>
 #include <ATen/ATen.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
@@ -25,6 +28,18 @@ struct Node;
 
 namespace profiler {
 
+// A kernel execution reported by CUPTI, with times on the getTime() clock.
+struct TORCH_API KernelRange {
+  std::string name;
+  // SampledRange::correlation_id of the range that launched the kernel, or
+  // 0 if it wasn't launched while recording a range.
+  uint64_t correlation_id;
+  int device;
+  uint32_t stream;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
 struct TORCH_API CUDAStubs {
   virtual void record(int* device, CUDAEventStub* event, int64_t* cpu_ns) {
     fail();
@@ -51,6 +66,27 @@ struct TORCH_API CUDAStubs {
   virtual void synchronize() {
     fail();
   }
+  // Kernel tracing, only available when built with USE_CUPTI. Kernels
+  // launched between pushCorrelationId and popCorrelationId on the same
+  // thread are reported with that correlation id.
+  virtual bool kernelTracingEnabled() {
+    return false;
+  }
+  virtual void enableKernelTracing() {
+    fail();
+  }
+  virtual void disableKernelTracing() {
+    fail();
+  }
+  virtual void pushCorrelationId(uint64_t id) {
+    fail();
+  }
+  virtual void popCorrelationId() {
+    fail();
+  }
+  virtual void drainKernels(std::vector<KernelRange>& out) {
+    fail();
+  }
   virtual ~CUDAStubs();
 
 private:
@@ -229,6 +265,88 @@ TORCH_API void enableProfiler(ProfilerConfig);
 TORCH_API thread_event_lists disableProfiler();
 
 
+// The sampling profiler records only a sample of the RecordFunction calls,
+// so that it is cheap enough to stay enabled on production traffic. Calls
+// are either sampled with probability 1 / `sampling_period` (using the
+// sampled callbacks of record_function.h, which share a global sampling
+// probability), or, if `burst_us` is set, all calls starting in the first
+// `burst_us` microseconds of every `interval_us` microseconds are recorded.
+//
+// Names are interned, and every thread writes its samples into a lock-free
+// ring buffer of `buffer_size` entries, which drainSamplingProfiler()
+// empties. Samples are dropped (and counted) while a buffer is full.
+//
+// With `record_kernels`, the CUDA kernels launched by the sampled ranges are
+// traced with CUPTI and reported with the correlation id of their range.
+struct TORCH_API SamplingProfilerConfig {
+  int64_t sampling_period = 1000;
+  int64_t burst_us = 0;
+  int64_t interval_us = 0;
+  size_t buffer_size = 64 * 1024;
+  bool record_kernels = false;
+};
+
+struct TORCH_API SampledRange {
+  uint32_t name_id;
+  uint16_t thread_id;
+  uint64_t correlation_id;
+  int64_t start_ns;
+  int64_t end_ns;
+};
+
+struct TORCH_API SampledRanges {
+  std::vector<SampledRange> ranges;
+  // All interned names, indexed by SampledRange::name_id. Ids stay valid
+  // across drains.
+  std::vector<std::string> names;
+  // Kernels that completed since the last drain, if `record_kernels` is set.
+  std::vector<KernelRange> kernels;
+  size_t dropped = 0;
+};
+
+// NOTE: like enableProfiler, these are **NOT THREAD SAFE**, and the two
+// profilers must be disabled in the reverse order they were enabled.
+TORCH_API void enableSamplingProfiler(SamplingProfilerConfig);
+TORCH_API SampledRanges drainSamplingProfiler();
+TORCH_API SampledRanges disableSamplingProfiler();
+
+// Runs the sampling profiler (recording every call by default) and streams
+// its ranges and kernels to a Chrome trace file while profiling runs, which
+// chrome://tracing and the Perfetto UI can open. A background thread drains
+// the buffers every `flush_interval_ms`, so the buffers only need to hold
+// the ranges of one interval. Kernels carry the correlation id of the range
+// that launched them in their "args".
+struct TORCH_API TraceStreamer {
+  TraceStreamer(
+      const std::string& filename,
+      SamplingProfilerConfig config = defaultConfig(),
+      int64_t flush_interval_ms = 100);
+  ~TraceStreamer();
+
+  // Writes the remaining events and closes the file.
+  void stop();
+
+  static SamplingProfilerConfig defaultConfig() {
+    SamplingProfilerConfig config;
+    config.sampling_period = 1;
+    return config;
+  }
+
+ private:
+  void run();
+  void write(const SampledRanges& ranges);
+
+  std::ofstream out_;
+  const int64_t flush_interval_ms_;
+  int64_t start_ns_;
+  bool first_ = true;
+  bool stopped_ = false;
+  bool stop_requested_ = false;
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+
 // Usage:
 //   {
 //     RecordProfile guard("filename.trace");
@@ -1,8 +1,14 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <c10/cuda/CUDAGuard.h>
 #include <nvToolsExt.h>
+#ifdef USE_CUPTI
+#include <cupti.h>
+#endif
 
+#include <cstdlib>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 namespace torch { namespace autograd { namespace profiler {
 
@@ -17,6 +23,125 @@ static inline void cudaCheck(cudaError_t result, const char * file, int line) {
 }
 #define TORCH_CUDA_CHECK(result) cudaCheck(result,__FILE__,__LINE__);
 
+#ifdef USE_CUPTI
+static inline void cuptiCheck(CUptiResult result, const char * file, int line) {
+  if(result != CUPTI_SUCCESS) {
+    const char* msg = nullptr;
+    cuptiGetResultString(result, &msg);
+    std::stringstream ss;
+    ss << file << ":" << line << ": " << msg;
+    throw std::runtime_error(ss.str());
+  }
+}
+#define TORCH_CUPTI_CHECK(result) cuptiCheck(result,__FILE__,__LINE__);
+
+// CUPTI hands activity records over in buffers that we allocate and it
+// fills asynchronously. Kernel records only carry CUPTI's correlation id, so
+// the external correlation records (emitted when a kernel is launched while
+// a correlation id is pushed) are kept to map it to the profiler's ids.
+struct KernelTracer {
+  static constexpr size_t kBufferSize = 8 * 1024 * 1024;
+
+  std::mutex mutex;
+  std::vector<KernelRange> kernels;
+  // CUPTI correlation id -> profiler correlation id, for the records of the
+  // current and the previous drain, since a kernel may complete (and be
+  // reported) after the drain that followed its launch.
+  std::unordered_map<uint32_t, uint64_t> external_ids;
+  std::unordered_map<uint32_t, uint64_t> previous_external_ids;
+  // Difference between getTime() and the CUPTI timestamps.
+  int64_t clock_offset_ns = 0;
+
+  static KernelTracer& get() {
+    static KernelTracer tracer;
+    return tracer;
+  }
+
+  static void CUPTIAPI bufferRequested(
+      uint8_t** buffer, size_t* size, size_t* max_num_records) {
+    *buffer = static_cast<uint8_t*>(std::malloc(kBufferSize));
+    *size = *buffer ? kBufferSize : 0;
+    *max_num_records = 0;
+  }
+
+  static void CUPTIAPI bufferCompleted(
+      CUcontext /* unused */,
+      uint32_t /* unused */,
+      uint8_t* buffer,
+      size_t /* unused */,
+      size_t valid_size) {
+    auto& tracer = get();
+    std::lock_guard<std::mutex> guard(tracer.mutex);
+    CUpti_Activity* record = nullptr;
+    while (cuptiActivityGetNextRecord(buffer, valid_size, &record) ==
+           CUPTI_SUCCESS) {
+      if (record->kind == CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL) {
+        auto kernel = reinterpret_cast<CUpti_ActivityKernel4*>(record);
+        // The CUPTI correlation id is replaced when draining.
+        tracer.kernels.push_back(
+            {kernel->name,
+             kernel->correlationId,
+             static_cast<int>(kernel->deviceId),
+             kernel->streamId,
+             static_cast<int64_t>(kernel->start) + tracer.clock_offset_ns,
+             static_cast<int64_t>(kernel->end) + tracer.clock_offset_ns});
+      } else if (record->kind == CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION) {
+        auto correlation =
+            reinterpret_cast<CUpti_ActivityExternalCorrelation*>(record);
+        tracer.external_ids[correlation->correlationId] =
+            correlation->externalId;
+      }
+    }
+    std::free(buffer);
+  }
+
+  void enable() {
+    uint64_t timestamp;
+    TORCH_CUPTI_CHECK(cuptiGetTimestamp(&timestamp));
+    clock_offset_ns = getTime() - static_cast<int64_t>(timestamp);
+    TORCH_CUPTI_CHECK(
+        cuptiActivityRegisterCallbacks(bufferRequested, bufferCompleted));
+    TORCH_CUPTI_CHECK(
+        cuptiActivityEnable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+    TORCH_CUPTI_CHECK(
+        cuptiActivityEnable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION));
+  }
+
+  void disable() {
+    TORCH_CUPTI_CHECK(
+        cuptiActivityDisable(CUPTI_ACTIVITY_KIND_CONCURRENT_KERNEL));
+    TORCH_CUPTI_CHECK(
+        cuptiActivityDisable(CUPTI_ACTIVITY_KIND_EXTERNAL_CORRELATION));
+    TORCH_CUPTI_CHECK(cuptiActivityFlushAll(0));
+    std::lock_guard<std::mutex> guard(mutex);
+    kernels.clear();
+    external_ids.clear();
+    previous_external_ids.clear();
+  }
+
+  void drain(std::vector<KernelRange>& out) {
+    TORCH_CUPTI_CHECK(cuptiActivityFlushAll(0));
+    std::lock_guard<std::mutex> guard(mutex);
+    for (auto& kernel : kernels) {
+      const auto cupti_id = static_cast<uint32_t>(kernel.correlation_id);
+      auto it = external_ids.find(cupti_id);
+      if (it != external_ids.end()) {
+        kernel.correlation_id = it->second;
+      } else {
+        auto previous_it = previous_external_ids.find(cupti_id);
+        kernel.correlation_id = previous_it != previous_external_ids.end()
+            ? previous_it->second
+            : 0;
+      }
+      out.push_back(std::move(kernel));
+    }
+    kernels.clear();
+    previous_external_ids = std::move(external_ids);
+    external_ids.clear();
+  }
+};
+#endif
+
 struct CUDAMethods : public CUDAStubs {
   void record(int* device, CUDAEventStub* event, int64_t* cpu_ns) override {
     TORCH_CUDA_CHECK(cudaGetDevice(device));
@@ -55,6 +180,29 @@ struct CUDAMethods : public CUDAStubs {
   bool enabled() override {
     return true;
   }
+#ifdef USE_CUPTI
+  bool kernelTracingEnabled() override {
+    return true;
+  }
+  void enableKernelTracing() override {
+    KernelTracer::get().enable();
+  }
+  void disableKernelTracing() override {
+    KernelTracer::get().disable();
+  }
+  void pushCorrelationId(uint64_t id) override {
+    cuptiActivityPushExternalCorrelationId(
+        CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0, id);
+  }
+  void popCorrelationId() override {
+    uint64_t id;
+    cuptiActivityPopExternalCorrelationId(
+        CUPTI_EXTERNAL_CORRELATION_KIND_CUSTOM0, &id);
+  }
+  void drainKernels(std::vector<KernelRange>& out) override {
+    KernelTracer::get().drain(out);
+  }
+#endif
 
 };
 
@@ -6,12 +6,91 @@
 #include <torch/csrc/utils/object_ptr.h>
 #include <torch/csrc/utils/python_strings.h>
 
+#include <frameobject.h>
+
 #include <iostream>
+#include <vector>
 
 namespace torch { namespace autograd {
 
+namespace {
+
+// The frames of the forward stacks recorded in fast mode, innermost first.
+// A stack is valid until the ring wraps around it. Protected by the GIL.
+struct FrameRing {
+  static constexpr uint64_t kCapacity = 1 << 16;
+
+  struct Frame {
+    PyObject* code;
+    int line;
+  };
+
+  FrameRing() : frames(kCapacity, Frame{nullptr, 0}), next(0) {}
+
+  bool contains(uint64_t begin) const {
+    return next - begin <= kCapacity;
+  }
+
+  std::vector<Frame> frames;
+  // The number of frames ever pushed
+  uint64_t next;
+};
+
+FrameRing& frame_ring() {
+  // Leaked, as the code objects can't be released at exit
+  static FrameRing* ring = new FrameRing();
+  return *ring;
+}
+
+// Formats the frames like traceback.format_stack, the source lines being only
+// read now. Returns a new reference.
+PyObject* format_frames(uint64_t begin, uint64_t end) {
+  auto& ring = frame_ring();
+  THPObjectPtr entries(PyList_New(0));
+  if (!entries) {
+    throw python_error();
+  }
+  for (uint64_t i = end; i > begin; --i) {
+    const auto& frame = ring.frames[(i - 1) % FrameRing::kCapacity];
+    auto code = reinterpret_cast<PyCodeObject*>(frame.code);
+    THPObjectPtr entry(Py_BuildValue(
+        "(OiOO)", code->co_filename, frame.line, code->co_name, Py_None));
+    if (!entry || PyList_Append(entries.get(), entry.get())) {
+      throw python_error();
+    }
+  }
+  THPObjectPtr mod(PyImport_ImportModule("traceback"));
+  if (!mod) {
+    throw python_error();
+  }
+  THPObjectPtr list(
+      PyObject_CallMethod(mod.get(), "format_list", "O", entries.get()));
+  if (!list) {
+    throw python_error();
+  }
+  return list.release();
+}
+
+} // namespace
+
 void PyAnomalyMetadata::store_stack() {
   AutoGIL gil;
+  if (AnomalyMode::is_fast()) {
+    // Only a reference to the code object and the line of each frame
+    auto& ring = frame_ring();
+    frames_begin_ = ring.next;
+    for (PyFrameObject* frame = PyEval_GetFrame(); frame;
+         frame = frame->f_back) {
+      auto& slot = ring.frames[ring.next++ % FrameRing::kCapacity];
+      Py_INCREF(frame->f_code);
+      Py_XDECREF(slot.code);
+      slot.code = reinterpret_cast<PyObject*>(frame->f_code);
+      slot.line = PyFrame_GetLineNumber(frame);
+    }
+    frames_end_ = ring.next;
+    return;
+  }
+
   THPObjectPtr mod(PyImport_ImportModule("traceback"));
   if (!mod) {
     throw python_error();
@@ -35,6 +114,16 @@ void PyAnomalyMetadata::print_stack() {
 
   // PyDict_GetItemString returns a borrowed reference
   PyObject* stack(PyDict_GetItemString(dict(), ANOMALY_TRACE_KEY));
+  THPObjectPtr frames;
+  if (!stack && frames_end_ > frames_begin_) {
+    if (!frame_ring().contains(frames_begin_)) {
+      AT_WARN("The forward pass information was overwritten by more recent "
+              "functions in fast anomaly mode.");
+      return;
+    }
+    frames = format_frames(frames_begin_, frames_end_);
+    stack = frames.get();
+  }
   if (!stack) {
     AT_WARN("No forward pass information available. Enable detect anomaly "
             "during forward pass for more information.");
@@ -4,6 +4,8 @@
 #include <torch/csrc/python_headers.h>
 #include <torch/csrc/utils/auto_gil.h>
 
+#include <cstdint>
+
 namespace torch { namespace autograd {
 
 struct PyAnomalyMetadata : public AnomalyMetadata {
@@ -26,6 +28,10 @@ struct PyAnomalyMetadata : public AnomalyMetadata {
 
 private:
   PyObject* dict_;
+  // The position of the stack in the frame ring of fast mode, see
+  // store_stack()
+  uint64_t frames_begin_ = 0;
+  uint64_t frames_end_ = 0;
 };
 
 }}
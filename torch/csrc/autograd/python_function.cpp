@@ -648,7 +648,7 @@ PyObject *THPFunction_do_forward(THPFunction *self, PyObject *_inputs)
       "https://pytorch.org/docs/stable/notes/extending.html#extending-torch-autograd");
   } else {
     Py_INCREF(self);
-    cdata = std::shared_ptr<PyNode>(new PyNode(THPObjectPtr((PyObject*)self)), deleteNode);
+    cdata = std::shared_ptr<PyNode>(new PyNode(THPObjectPtr((PyObject*)self)), deleteNode, NodeAllocator<PyNode>());
     self->cdata = cdata;
   }
   cdata->set_next_edges(std::move(input_info.next_edges));
@@ -686,7 +686,7 @@ PyObject *THPFunction_apply(PyObject *cls, PyObject *inputs)
   if (!ctx_obj) return nullptr;
   THPFunction* ctx = (THPFunction*)ctx_obj.get();
 
-  auto cdata = std::shared_ptr<PyNode>(new PyNode(std::move(ctx_obj)), deleteNode);
+  auto cdata = std::shared_ptr<PyNode>(new PyNode(std::move(ctx_obj)), deleteNode, NodeAllocator<PyNode>());
   ctx->cdata = cdata;
 
   // Prepare inputs and allocate context (grad fn)
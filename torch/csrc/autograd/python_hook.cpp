@@ -3,8 +3,11 @@
 #include <sstream>
 
 #include <torch/csrc/THP.h>
+#include <torch/csrc/autograd/engine.h>
+#include <torch/csrc/autograd/functions/accumulate_grad.h>
 #include <torch/csrc/autograd/python_variable.h>
 #include <torch/csrc/utils/auto_gil.h>
+#include <torch/csrc/utils/memory.h>
 #include <torch/csrc/utils/object_ptr.h>
 #include <torch/csrc/utils/python_strings.h>
 #include <torch/csrc/Exceptions.h>
@@ -87,6 +90,126 @@ auto PyFunctionPostHook::operator()(
   return unwrap_variables(outputs.get());
 }
 
+namespace {
+
+// Calls a function after the gradient accumulator has run
+struct LambdaPostHook : public FunctionPostHook {
+  explicit LambdaPostHook(std::function<void()> fn) : fn_(std::move(fn)) {}
+
+  variable_list operator()(
+      const variable_list& outputs,
+      const variable_list& /* unused */) override {
+    fn_();
+    return outputs;
+  }
+
+  std::function<void()> fn_;
+};
+
+} // namespace
+
+PyBatchedGradHook::PyBatchedGradHook(
+    PyObject* callback,
+    variable_list tensors,
+    size_t batch_size)
+  : callback_(callback)
+  , batch_size_(batch_size)
+{
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    TORCH_CHECK(
+        tensors[i].is_leaf() && tensors[i].requires_grad(),
+        "batched gradient hooks can only be registered on leaf tensors that "
+        "require grad, but tensor ", i, " is not one");
+  }
+  for (size_t i = 0; i < tensors.size(); ++i) {
+    // The accumulator is only held weakly by the tensor, keep it alive so
+    // that it and its hook are reused by every backward pass.
+    auto grad_accumulator = tensors[i].grad_accumulator();
+    hook_keys_.push_back(grad_accumulator->add_post_hook(
+        torch::make_unique<LambdaPostHook>([this, i] { record(i); })));
+    grad_accumulators_.push_back(std::move(grad_accumulator));
+  }
+  Py_INCREF(callback_);
+}
+
+PyBatchedGradHook::~PyBatchedGradHook() {
+  AutoGIL gil;
+  remove();
+}
+
+void PyBatchedGradHook::remove() {
+  for (size_t i = 0; i < grad_accumulators_.size(); ++i) {
+    grad_accumulators_[i]->del_post_hook(hook_keys_[i]);
+  }
+  grad_accumulators_.clear();
+  hook_keys_.clear();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.clear();
+  }
+  Py_CLEAR(callback_);
+}
+
+void PyBatchedGradHook::record(size_t index) {
+  // The callback may drop the last reference to this hook
+  auto self = shared_from_this();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+      // The rest of the batch is flushed when the backward pass ends. This
+      // may be queued more than once per pass, the extra calls are no-ops.
+      std::weak_ptr<PyBatchedGradHook> weak_self = self;
+      Engine::get_default_engine().queue_callback([weak_self] {
+        if (auto self = weak_self.lock()) {
+          self->flush();
+        }
+      });
+    }
+    pending_.push_back(index);
+    if (batch_size_ == 0 || pending_.size() < batch_size_) {
+      return;
+    }
+  }
+  flush();
+}
+
+void PyBatchedGradHook::flush() {
+  std::vector<size_t> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ready.swap(pending_);
+  }
+  if (ready.empty()) {
+    return;
+  }
+
+  // The accumulators and the callback are only released with the GIL held
+  AutoGIL gil;
+  if (!callback_) {
+    return;
+  }
+  THPObjectPtr indices(PyList_New(ready.size()));
+  if (!indices) throw python_error();
+  THPObjectPtr grads(PyList_New(ready.size()));
+  if (!grads) throw python_error();
+  for (size_t i = 0; i < ready.size(); ++i) {
+    auto& accumulator =
+        static_cast<AccumulateGrad&>(*grad_accumulators_.at(ready[i]));
+    PyObject* index = PyLong_FromSize_t(ready[i]);
+    if (!index) throw python_error();
+    PyList_SET_ITEM(indices.get(), i, index);
+    PyObject* grad = THPVariable_Wrap(accumulator.variable.grad());
+    if (!grad) throw python_error();
+    PyList_SET_ITEM(grads.get(), i, grad);
+  }
+  // The callback may remove this hook
+  THPObjectPtr callback(callback_);
+  Py_INCREF(callback.get());
+  THPObjectPtr res(PyObject_CallFunctionObjArgs(
+      callback.get(), indices.get(), grads.get(), nullptr));
+  if (!res) throw python_error();
+}
+
 }} // namespace torch::autograd
 
 
@@ -1,9 +1,14 @@
 #pragma once
 
 #include <torch/csrc/python_headers.h>
+#include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/function_hook.h>
 #include <torch/csrc/utils/object_ptr.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace torch { namespace autograd {
 
 struct PyFunctionPreHook : public FunctionPreHook {
@@ -21,4 +26,40 @@ struct PyFunctionPostHook : public FunctionPostHook {
   PyObject* dict;
 };
 
+// Calls a single Python function with the gradients of many leaf tensors,
+// instead of one call, and one acquisition of the GIL, for each of them.
+//
+// The gradients are accumulated into .grad as usual, and the indices of the
+// tensors whose .grad is ready are collected. The callback is called as
+// `callback(indices, grads)` once `batch_size` indices are collected, and when
+// the backward pass ends for the rest. A batch_size of 0 means only at the end
+// of the backward pass. The return value of the callback is ignored, it may
+// modify the gradients in place.
+//
+// Like the DDP Reducer, this keeps the gradient accumulators of the tensors
+// alive, and the hooks are removed when it is destroyed.
+struct PyBatchedGradHook
+    : public std::enable_shared_from_this<PyBatchedGradHook> {
+  PyBatchedGradHook(
+      PyObject* callback,
+      variable_list tensors,
+      size_t batch_size);
+  ~PyBatchedGradHook();
+
+  // Removes the hooks and releases the callback and the tensors
+  void remove();
+
+ private:
+  void record(size_t index);
+  void flush();
+
+  PyObject* callback_;
+  const size_t batch_size_;
+  std::vector<std::shared_ptr<Node>> grad_accumulators_;
+  std::vector<uintptr_t> hook_keys_;
+  // To protect pending_
+  std::mutex mutex_;
+  std::vector<size_t> pending_;
+};
+
 }} // namespace torch::autograd
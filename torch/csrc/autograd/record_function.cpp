@@ -2,6 +2,7 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/utils/memory.h>
 #include <cstdlib>
+#include <limits>
 #include <random>
 
 namespace torch {
@@ -10,6 +11,9 @@ namespace profiler {
 
 namespace {
 
+// RecordFunction observes the calls of the thread, see RecordFunctionGuard.
+thread_local bool record_function_enabled = true;
+
 class CallbackManager {
  public:
   void setSamplingProbability(double prob) {
@@ -20,6 +24,7 @@ class CallbackManager {
       sampling_prop_set = true;
     }
     sampling_prob = prob;
+    ++sampling_generation;
   }
 
   double getSamplingProbability() {
@@ -27,69 +32,179 @@ class CallbackManager {
   }
 
   bool shouldRunSampledCallbacks() {
-    return (num_sampled_callbacks > 0) &&
-        (!sampling_prop_set || (sample_zero_one() < sampling_prob));
+    if (num_sampled_callbacks == 0) {
+      return false;
+    }
+    if (!sampling_prop_set) {
+      return true;
+    }
+    // Instead of drawing a number for every call, draw the number of calls
+    // to skip before the next sampled one (geometrically distributed), so
+    // that skipped calls only cost a decrement.
+    static thread_local uint64_t generation = 0;
+    static thread_local int64_t calls_to_skip = 0;
+    if (generation != sampling_generation) {
+      generation = sampling_generation;
+      calls_to_skip = sample_calls_to_skip(sampling_prob);
+    }
+    if (calls_to_skip > 0) {
+      --calls_to_skip;
+      return false;
+    }
+    calls_to_skip = sample_calls_to_skip(sampling_prob);
+    return true;
+  }
+
+  uint64_t sampleCallbacks() {
+    uint64_t active = always_active_mask;
+    if (global_sampled_mask && shouldRunSampledCallbacks()) {
+      active |= global_sampled_mask;
+    }
+    if (!own_sampled_callbacks.empty()) {
+      // As for the global probability, each callback with its own
+      // probability skips a geometrically distributed number of calls.
+      static thread_local uint64_t generation = 0;
+      static thread_local std::vector<int64_t> calls_to_skip;
+      if (generation != callbacks_generation) {
+        generation = callbacks_generation;
+        calls_to_skip.assign(callbacks.size(), 0);
+        for (auto idx : own_sampled_callbacks) {
+          calls_to_skip[idx] =
+              sample_calls_to_skip(callbacks[idx].config.sampling_prob);
+        }
+      }
+      for (auto idx : own_sampled_callbacks) {
+        if (calls_to_skip[idx] > 0) {
+          --calls_to_skip[idx];
+        } else {
+          active |= uint64_t(1) << idx;
+          calls_to_skip[idx] =
+              sample_calls_to_skip(callbacks[idx].config.sampling_prob);
+        }
+      }
+    }
+    return active;
   }
 
   void pushCallback(
       RecordFunctionCallback start,
       RecordFunctionCallback end,
-      bool needs_inputs,
+      const CallbackConfig& config,
       bool sampled) {
-    start_callbacks.push_back(std::move(start));
-    end_callbacks.push_back(std::move(end));
-    if (callback_needs_inputs > 0 || needs_inputs) {
-      ++callback_needs_inputs;
-    }
-    is_callback_sampled.push_back(sampled);
+    TORCH_CHECK(
+        callbacks.size() < kMaxCallbacks,
+        "At most ", kMaxCallbacks, " RecordFunction callbacks can be pushed");
+    TORCH_CHECK(
+        config.sampling_prob >= 0.0 && config.sampling_prob <= 1.0,
+        "Invalid sampling probability of a RecordFunction callback: ",
+        config.sampling_prob);
+    Callback callback;
+    callback.start = std::move(start);
+    callback.end = std::move(end);
+    callback.config = config;
+    callback.sampled = sampled;
+    callbacks.push_back(std::move(callback));
     if (sampled) {
       ++num_sampled_callbacks;
     }
+    updateMasks();
   }
 
   void popCallback() {
-    if (start_callbacks.empty()) {
+    if (callbacks.empty()) {
       throw std::runtime_error("Empty callbacks stack");
     }
-    start_callbacks.pop_back();
-    end_callbacks.pop_back();
-    if (callback_needs_inputs > 0) {
-      --callback_needs_inputs;
-    }
-    if (is_callback_sampled.back()) {
+    if (callbacks.back().sampled) {
       --num_sampled_callbacks;
     }
-    is_callback_sampled.pop_back();
+    callbacks.pop_back();
+    updateMasks();
   }
 
   bool hasCallbacks() {
-    return !start_callbacks.empty();
+    return record_function_enabled && !callbacks.empty();
   }
 
   bool needsInputs() {
-    return callback_needs_inputs > 0;
+    return (needs_inputs_mask | needs_shapes_mask) != 0;
   }
 
   bool hasNonSampledCallbacks() {
-    return num_sampled_callbacks < start_callbacks.size();
+    return num_sampled_callbacks < callbacks.size();
   }
 
-  std::vector<RecordFunctionCallback> start_callbacks;
-  std::vector<RecordFunctionCallback> end_callbacks;
-  std::vector<bool> is_callback_sampled;
+  static constexpr size_t kMaxCallbacks = 64;
+
+  struct Callback {
+    RecordFunctionCallback start;
+    RecordFunctionCallback end;
+    CallbackConfig config;
+    // Runs with the global sampling probability
+    bool sampled = false;
+  };
+
+  std::vector<Callback> callbacks;
   size_t num_sampled_callbacks = 0;
-  size_t callback_needs_inputs = 0;
   bool sampling_prop_set = false;
   double sampling_prob = 1.0;
+  // Incremented when the probability changes, to reset the per-thread
+  // number of calls to skip.
+  uint64_t sampling_generation = 1;
+
+  // One bit per callback, see sampleCallbacks().
+  uint64_t always_active_mask = 0;
+  uint64_t global_sampled_mask = 0;
+  uint64_t needs_inputs_mask = 0;
+  uint64_t needs_shapes_mask = 0;
+  uint64_t needs_names_mask = 0;
+  std::vector<size_t> own_sampled_callbacks;
+  // Incremented when the callbacks change, to reset the per-thread numbers
+  // of calls to skip of the callbacks with their own probability.
+  uint64_t callbacks_generation = 1;
+
+  void updateMasks() {
+    always_active_mask = 0;
+    global_sampled_mask = 0;
+    needs_inputs_mask = 0;
+    needs_shapes_mask = 0;
+    needs_names_mask = 0;
+    own_sampled_callbacks.clear();
+    for (size_t idx = 0; idx < callbacks.size(); ++idx) {
+      const auto& callback = callbacks[idx];
+      const uint64_t bit = uint64_t(1) << idx;
+      if (callback.sampled) {
+        global_sampled_mask |= bit;
+      } else if (callback.config.sampling_prob < 1.0) {
+        own_sampled_callbacks.push_back(idx);
+      } else {
+        always_active_mask |= bit;
+      }
+      if (callback.config.needs_inputs) {
+        needs_inputs_mask |= bit;
+      }
+      if (callback.config.needs_shapes) {
+        needs_shapes_mask |= bit;
+      }
+      if (callback.config.needs_names) {
+        needs_names_mask |= bit;
+      }
+    }
+    ++callbacks_generation;
+  }
 
-  static double sample_zero_one() {
+  static int64_t sample_calls_to_skip(double prob) {
+    if (prob <= 0.0) {
+      return std::numeric_limits<int64_t>::max();
+    }
     static thread_local auto gen =
         torch::make_unique<std::mt19937>(std::random_device()());
-    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    std::geometric_distribution<int64_t> dist(prob);
     return dist(*gen);
   }
 };
 
+constexpr size_t CallbackManager::kMaxCallbacks;
+
 // thread_local_func_ points to the currently active RecordFunction.
 thread_local RecordFunction* thread_local_func_ = nullptr;
 
@@ -112,13 +227,31 @@ bool shouldRunSampledCallbacks() {
   return manager().shouldRunSampledCallbacks();
 }
 
+uint64_t sampleCallbacks() {
+  return manager().sampleCallbacks();
+}
+
+bool needsInputs(uint64_t active_callbacks) {
+  return (active_callbacks &
+      (manager().needs_inputs_mask | manager().needs_shapes_mask)) != 0;
+}
+
 void pushCallback(
     RecordFunctionCallback start,
     RecordFunctionCallback end,
     bool needs_inputs,
     bool sampled) {
+  CallbackConfig config;
+  config.needs_inputs = needs_inputs;
+  manager().pushCallback(std::move(start), std::move(end), config, sampled);
+}
+
+void pushCallback(
+    RecordFunctionCallback start,
+    RecordFunctionCallback end,
+    const CallbackConfig& config) {
   manager().pushCallback(
-      std::move(start), std::move(end), needs_inputs, sampled);
+      std::move(start), std::move(end), config, /* sampled */ false);
 }
 
 void popCallback() {
@@ -137,8 +270,53 @@ bool hasNonSampledCallbacks() {
   return manager().hasNonSampledCallbacks();
 }
 
+RecordFunctionGuard::RecordFunctionGuard(bool enabled)
+    : prev_enabled_(record_function_enabled) {
+  record_function_enabled = enabled;
+}
+
+RecordFunctionGuard::~RecordFunctionGuard() {
+  record_function_enabled = prev_enabled_;
+}
+
+bool RecordFunction::activate() {
+  if (!callbacks_sampled_) {
+    active_callbacks_ = hasCallbacks() ? sampleCallbacks() : 0;
+    callbacks_sampled_ = true;
+  }
+  return active_callbacks_ != 0;
+}
+
+void RecordFunction::setInputSizes(c10::ArrayRef<c10::IValue> args) {
+  if (!(active_callbacks_ & manager().needs_shapes_mask)) {
+    return;
+  }
+  input_sizes_.reserve(args.size());
+  for (const auto& arg : args) {
+    if (arg.isTensor() && arg.toTensor().defined()) {
+      input_sizes_.push_back(arg.toTensor().sizes().vec());
+    } else {
+      input_sizes_.emplace_back();
+    }
+  }
+}
+
+void RecordFunction::setInputs(c10::ArrayRef<c10::IValue> args) {
+  setInputSizes(args);
+  if (active_callbacks_ & manager().needs_inputs_mask) {
+    inputs_ = args.vec();
+  }
+}
+
+void RecordFunction::setInputs(std::vector<c10::IValue>&& args) {
+  setInputSizes(args);
+  if (active_callbacks_ & manager().needs_inputs_mask) {
+    inputs_ = std::move(args);
+  }
+}
+
 void RecordFunction::before(const char* name, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!activate()) {
     return;
   }
   AT_ASSERT(!initialized_);
@@ -150,7 +328,7 @@ void RecordFunction::before(const char* name, int64_t sequence_nr) {
 }
 
 void RecordFunction::before(std::string name, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!activate()) {
     return;
   }
   AT_ASSERT(!initialized_);
@@ -162,12 +340,17 @@ void RecordFunction::before(std::string name, int64_t sequence_nr) {
 }
 
 void RecordFunction::before(Node* fn, int64_t sequence_nr) {
-  if (!hasCallbacks()) {
+  if (!activate()) {
     return;
   }
   AT_ASSERT(!initialized_);
   fn_ = fn;
-  name_ = StringView(fn->name());
+  // Building the name of a Node allocates, and is only done if needed
+  if (active_callbacks_ & manager().needs_names_mask) {
+    name_ = StringView(fn->name());
+  } else {
+    name_ = StringView("");
+  }
   sequence_nr_ = (sequence_nr >= 0) ? sequence_nr : fn->sequence_nr();
 
   initialized_ = true;
@@ -178,9 +361,10 @@ void RecordFunction::processCallbacks() {
   parent_ = thread_local_func_;
   thread_local_func_ = this;
 
-  for (size_t idx = 0; idx < manager().start_callbacks.size(); ++idx) {
-    if (!manager().is_callback_sampled[idx] || run_sampled_) {
-      manager().start_callbacks[idx](*this);
+  const auto& callbacks = manager().callbacks;
+  for (size_t idx = 0; idx < callbacks.size(); ++idx) {
+    if (active_callbacks_ & (uint64_t(1) << idx)) {
+      callbacks[idx].start(*this);
     }
   }
 }
@@ -191,9 +375,10 @@ RecordFunction::~RecordFunction() {
 
 void RecordFunction::end() {
   if (initialized_) {
-    for (size_t idx = 0; idx < manager().end_callbacks.size(); ++idx) {
-      if (!manager().is_callback_sampled[idx] || run_sampled_) {
-        manager().end_callbacks[idx](*this);
+    const auto& callbacks = manager().callbacks;
+    for (size_t idx = 0; idx < callbacks.size(); ++idx) {
+      if (active_callbacks_ & (uint64_t(1) << idx)) {
+        callbacks[idx].end(*this);
       }
     }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ATen/core/ivalue.h>
+#include <c10/util/Metrics.h>
 #include <c10/util/SmallVector.h>
 #include <torch/csrc/WindowsTorchApiMacro.h>
 
@@ -61,7 +62,10 @@ struct TORCH_API RecordFunction {
       F fn,
       c10::ArrayRef<c10::IValue> args,
       int64_t current_sequence_nr = -1) {
-    inputs_ = args.vec();
+    if (!activate()) {
+      return;
+    }
+    setInputs(args);
     before(fn, current_sequence_nr);
   }
 
@@ -70,7 +74,10 @@ struct TORCH_API RecordFunction {
       F fn,
       std::vector<c10::IValue>&& args,
       int64_t current_sequence_nr = -1) {
-    inputs_ = std::move(args);
+    if (!activate()) {
+      return;
+    }
+    setInputs(std::move(args));
     before(fn, current_sequence_nr);
   }
 
@@ -81,6 +88,7 @@ struct TORCH_API RecordFunction {
     return fn_;
   }
 
+  // Empty for autograd Nodes if no callback observing the call needs names
   inline const StringView& name() const {
     return name_;
   }
@@ -89,51 +97,93 @@ struct TORCH_API RecordFunction {
     return sequence_nr_;
   }
 
+  // Only captured if a callback observing the call needs inputs
   const std::vector<c10::IValue>& inputs() const {
     return inputs_;
   }
 
+  // The sizes of the tensor inputs, and empty sizes for the other inputs.
+  // Only captured if a callback observing the call needs shapes
+  const std::vector<std::vector<int64_t>>& inputSizes() const {
+    return input_sizes_;
+  }
+
   inline const RecordFunction* parent() const {
     return parent_;
   }
 
-  void setRunSampled(bool run_sampled) {
-    run_sampled_ = run_sampled;
+  // Runs the callbacks of `active_callbacks`, drawn by sampleCallbacks(),
+  // instead of drawing them in before()
+  void setActiveCallbacks(uint64_t active_callbacks) {
+    active_callbacks_ = active_callbacks;
+    callbacks_sampled_ = true;
   }
 
   void end();
 
  private:
+  // Draws the callbacks observing the call if they weren't set, and returns
+  // whether there are any
+  bool activate();
+  void setInputs(c10::ArrayRef<c10::IValue> args);
+  void setInputs(std::vector<c10::IValue>&& args);
+  void setInputSizes(c10::ArrayRef<c10::IValue> args);
   void processCallbacks();
 
   Node* fn_ = nullptr;
   StringView name_;
   int64_t sequence_nr_ = -1;
   std::vector<c10::IValue> inputs_;
+  std::vector<std::vector<int64_t>> input_sizes_;
   // parent_ points to the parent RecordFunction and must out live this.
   RecordFunction* parent_ = nullptr;
 
   bool initialized_ = false;
-  bool run_sampled_ = false;
+  bool callbacks_sampled_ = false;
+  uint64_t active_callbacks_ = 0;
 };
 
+// Whether a callback is registered and RecordFunction is enabled on the
+// thread, the check every call starts with
 TORCH_API bool hasCallbacks();
 TORCH_API bool needsInputs();
 TORCH_API bool hasNonSampledCallbacks();
 
+// The probability of the callbacks pushed with `sampled` set
 TORCH_API void setSamplingProbability(double);
 TORCH_API double getSamplingProbability();
 
 TORCH_API bool shouldRunSampledCallbacks();
 
+// Draws the callbacks that observe a call, one bit per callback in the order
+// they were pushed. Calls with none exit before capturing anything.
+TORCH_API uint64_t sampleCallbacks();
+// Whether one of `active_callbacks` needs the inputs or their shapes
+TORCH_API bool needsInputs(uint64_t active_callbacks);
+
+// Disables RecordFunction on the thread in a scope, e.g. for threads whose
+// ops must not be observed, so that their calls exit right away
+struct TORCH_API RecordFunctionGuard {
+  explicit RecordFunctionGuard(bool enabled = true);
+  ~RecordFunctionGuard();
+
+  RecordFunctionGuard(const RecordFunctionGuard&) = delete;
+  RecordFunctionGuard& operator=(const RecordFunctionGuard&) = delete;
+
+ private:
+  bool prev_enabled_;
+};
+
 // optional argument - function's seq_no
+// The call is also counted by the metrics registry, see c10/util/Metrics.h
 #define RECORD_FUNCTION(fn, inputs, ...) \
+  c10::metrics::OpScope metrics_scope(fn); \
   torch::autograd::profiler::RecordFunction guard; \
   if (torch::autograd::profiler::hasCallbacks()) { \
-    auto run_sampled = torch::autograd::profiler::shouldRunSampledCallbacks(); \
-    if (run_sampled || torch::autograd::profiler::hasNonSampledCallbacks()) { \
-      guard.setRunSampled(run_sampled); \
-      if (torch::autograd::profiler::needsInputs()) { \
+    auto active_callbacks = torch::autograd::profiler::sampleCallbacks(); \
+    if (active_callbacks) { \
+      guard.setActiveCallbacks(active_callbacks); \
+      if (torch::autograd::profiler::needsInputs(active_callbacks)) { \
         guard.before(fn, inputs, ##__VA_ARGS__); \
       } else { \
         guard.before(fn, ##__VA_ARGS__); \
@@ -141,6 +191,21 @@ TORCH_API bool shouldRunSampledCallbacks();
     } \
   }
 
+// What a callback needs from the calls it observes, and how many calls it
+// observes. A call only captures what the callbacks observing it need.
+struct TORCH_API CallbackConfig {
+  // RecordFunction::inputs()
+  bool needs_inputs = false;
+  // RecordFunction::inputSizes()
+  bool needs_shapes = false;
+  // RecordFunction::name() of autograd Nodes, which is built on every call;
+  // the names of ops cost nothing
+  bool needs_names = true;
+  // The callback observes each call with this probability, drawn per
+  // callback and thread before the call captures anything
+  double sampling_prob = 1.0;
+};
+
 // WARNING: all calls to pushCallback/popCallback are not thread safe and
 // must not overlap with other code execution
 using RecordFunctionCallback = std::function<void(const RecordFunction&)>;
@@ -149,6 +214,11 @@ TORCH_API void pushCallback(
     RecordFunctionCallback end = [](const RecordFunction&){},
     bool needs_inputs = false,
     bool sampled = false);
+// At most 64 callbacks can be pushed
+TORCH_API void pushCallback(
+    RecordFunctionCallback start,
+    RecordFunctionCallback end,
+    const CallbackConfig& config);
 TORCH_API void popCallback();
 
 } // namespace profiler
@@ -4,8 +4,11 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/variable.h>
 #include <torch/csrc/autograd/anomaly_mode.h>
+#include <torch/csrc/autograd/grad_mode.h>
 
 #include <ATen/Tensor.h>
+#include <c10/core/Event.h>
+#include <c10/core/impl/VirtualGuardImpl.h>
 
 #include <cstdint>
 #include <list>
@@ -14,6 +17,161 @@
 
 namespace torch { namespace autograd {
 
+// Note [Offloading and recomputing saved variables]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// A SavedVariable normally keeps its data alive from forward until the Node
+// that saved it runs, which is what bounds activation memory. Two thread local
+// modes let it hand the data over to a SavedVariableStash instead:
+//
+//  - Offloading: CUDA tensors above a size threshold are copied to pinned
+//    host memory on the current stream. When the engine hands the first
+//    gradient to a Node, it calls prefetch_variables() on it, on the stream
+//    the Node will run on, which starts the copy back to the device, so that
+//    it overlaps with whatever else backward does before the Node is ready.
+//
+//  - Recomputation: variables saved inside of a RecomputeRegion don't keep
+//    any data, just their index in the region. The first unpack of any of
+//    them runs the region's recompute function, which repeats the region's
+//    forward, and collects the variables that forward saves, in order, as the
+//    data of the region's saved variables. Unpacking happens in the Node's
+//    apply, on whichever engine thread runs it, so with parallel CPU backward
+//    recomputing regions overlaps with the rest of the backward pass.
+
+static thread_local int64_t offload_min_bytes = -1;
+static thread_local std::shared_ptr<RecomputeRegion> current_region;
+// The region whose recompute function is running on this thread
+static thread_local RecomputeRegion* recomputing_region = nullptr;
+
+int64_t SavedVariableMode::offload_min_bytes() {
+  return autograd::offload_min_bytes;
+}
+
+void SavedVariableMode::set_offload_min_bytes(int64_t min_bytes) {
+  autograd::offload_min_bytes = min_bytes;
+}
+
+std::shared_ptr<RecomputeRegion> SavedVariableMode::recompute_region() {
+  return current_region;
+}
+
+void SavedVariableMode::set_recompute_region(
+    std::shared_ptr<RecomputeRegion> region) {
+  current_region = std::move(region);
+}
+
+namespace {
+
+struct OffloadedTensor final : SavedVariableStash {
+  explicit OffloadedTensor(const at::Tensor& data)
+      : device_(data.device()),
+        offloaded_(data.device().type()),
+        prefetched_(data.device().type()) {
+    at::AutoNonVariableTypeMode non_var_type_mode(true);
+    c10::impl::VirtualGuardImpl impl(device_.type());
+    host_ = at::empty(
+        data.sizes(), data.options().device(at::kCPU).pinned_memory(true));
+    host_.copy_(data, /*non_blocking=*/true);
+    offloaded_.record(impl.getStream(device_));
+  }
+
+  void prefetch() override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (device_copy_.defined()) {
+      return;
+    }
+    at::AutoNonVariableTypeMode non_var_type_mode(true);
+    c10::impl::VirtualGuardImpl impl(device_.type());
+    auto stream = impl.getStream(device_);
+    offloaded_.block(stream);
+    device_copy_ = host_.to(device_, /*non_blocking=*/true);
+    prefetched_.record(stream);
+  }
+
+  at::Tensor get() override {
+    prefetch();
+    c10::impl::VirtualGuardImpl impl(device_.type());
+    prefetched_.block(impl.getStream(device_));
+    return device_copy_;
+  }
+
+ private:
+  at::Device device_;
+  at::Tensor host_;
+  // Recorded after the copies to and back from the host were enqueued
+  c10::Event offloaded_;
+  c10::Event prefetched_;
+  at::Tensor device_copy_;
+  // To protect device_copy_
+  std::mutex mutex_;
+};
+
+struct RecomputedTensor final : SavedVariableStash {
+  RecomputedTensor(std::shared_ptr<RecomputeRegion> region, size_t index)
+      : region_(std::move(region)), index_(index) {}
+
+  at::Tensor get() override {
+    return region_->get(index_);
+  }
+
+ private:
+  std::shared_ptr<RecomputeRegion> region_;
+  size_t index_;
+};
+
+// Runs a recompute function with the thread's modes reset, so that only the
+// regions nested in the one being recomputed apply.
+struct RecomputingGuard {
+  explicit RecomputingGuard(RecomputeRegion* region)
+      : prev_recomputing_(recomputing_region),
+        prev_region_(std::move(current_region)),
+        prev_offload_min_bytes_(offload_min_bytes) {
+    recomputing_region = region;
+    current_region = nullptr;
+    offload_min_bytes = -1;
+  }
+
+  ~RecomputingGuard() {
+    recomputing_region = prev_recomputing_;
+    current_region = std::move(prev_region_);
+    offload_min_bytes = prev_offload_min_bytes_;
+  }
+
+  RecomputeRegion* prev_recomputing_;
+  std::shared_ptr<RecomputeRegion> prev_region_;
+  int64_t prev_offload_min_bytes_;
+};
+
+} // namespace
+
+size_t RecomputeRegion::add_saved_variable() {
+  return num_saved_++;
+}
+
+void RecomputeRegion::record(const at::Tensor& data) {
+  recomputed_.push_back(data);
+}
+
+at::Tensor RecomputeRegion::get(size_t index) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!done_) {
+    recomputed_.clear();
+    {
+      RecomputingGuard guard(this);
+      AutoGradMode grad_mode(true);
+      recompute_();
+    }
+    TORCH_CHECK(
+        recomputed_.size() == num_saved_,
+        "Recomputing a region saved ",
+        recomputed_.size(),
+        " variables for backward, but its forward saved ",
+        num_saved_,
+        ". The recompute function has to repeat the forward of the region.");
+    done_ = true;
+  }
+  return recomputed_.at(index);
+}
+
 SavedVariable::SavedVariable(const Variable& variable, bool is_output, bool is_inplace_view) {
   if (variable.defined()) {
     was_default_constructed_ = false;
@@ -33,11 +191,26 @@ SavedVariable::SavedVariable(const Variable& variable, bool is_output, bool is_i
     }
     version_counter_ = variable.version_counter();
     saved_version_ = version_counter_.current_version();
+
+    // See Note [Offloading and recomputing saved variables]
+    if (current_region) {
+      stash_ = std::make_shared<RecomputedTensor>(
+          current_region, current_region->add_saved_variable());
+      data_.reset();
+    } else if (recomputing_region) {
+      recomputing_region->record(data_);
+    } else if (
+        offload_min_bytes >= 0 && data_.is_cuda() &&
+        data_.layout() == at::kStrided &&
+        static_cast<int64_t>(data_.nbytes()) >= offload_min_bytes) {
+      stash_ = std::make_shared<OffloadedTensor>(data_);
+      data_.reset();
+    }
   }
 }
 
 Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
-  if (!data_.defined()) {
+  if (!data_.defined() && !stash_) {
     if (!was_default_constructed_) {
       throw std::runtime_error(ERR_BACKWARD_TWICE);
     }
@@ -57,8 +230,10 @@ Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
   if (saved_version_ != version_counter_.current_version()) {
     std::stringstream message;
     message << "one of the variables needed for gradient computation has been "
-        "modified by an inplace operation: [" << data_.type().toString() << " "
-        << data_.sizes() << "]";
+        "modified by an inplace operation";
+    if (data_.defined()) {
+      message << ": [" << data_.type().toString() << " " << data_.sizes() << "]";
+    }
     if (grad_fn) {
         message << ", which is output " << output_nr_
             << " of " << grad_fn->name() << ",";
@@ -81,11 +256,12 @@ Variable SavedVariable::unpack(std::shared_ptr<Node> saved_for) const {
   // NB: saved views are unpacked as normal Variables (not views) even though
   // they still share the same storage. This works only because we never call
   // in-place functions on unpacked variables.
+  at::Tensor data = stash_ ? stash_->get() : data_;
   Variable var;
   if (grad_fn) {
-    var = make_variable(data_, Edge(std::move(grad_fn), output_nr_));
+    var = make_variable(data, Edge(std::move(grad_fn), output_nr_));
   } else {
-    var = make_variable(data_, requires_grad_);
+    var = make_variable(data, requires_grad_);
   }
   var.set_version_counter(saved_version_);
 
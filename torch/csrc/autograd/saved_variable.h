@@ -5,7 +5,10 @@
 #include <ATen/ATen.h>
 
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 namespace torch { namespace autograd {
 
@@ -14,6 +17,53 @@ struct Node;
 
 TORCH_API extern const char* ERR_BACKWARD_TWICE;
 
+/// Where a `SavedVariable` keeps its data when it doesn't hold on to it
+/// itself. See Note [Offloading and recomputing saved variables]
+struct TORCH_API SavedVariableStash {
+  virtual ~SavedVariableStash() = default;
+  /// Starts bringing the data back ahead of `get()`, e.g. with an asynchronous
+  /// copy on the current stream. Safe to call any number of times.
+  virtual void prefetch() {}
+  virtual at::Tensor get() = 0;
+};
+
+/// A region of forward whose saved variables are dropped, and recreated the
+/// first time one of them is unpacked by calling `recompute`, which has to
+/// repeat the forward of the region with grad mode enabled.
+struct TORCH_API RecomputeRegion {
+  explicit RecomputeRegion(std::function<void()> recompute)
+      : recompute_(std::move(recompute)) {}
+
+  /// Reserves the index of the next variable saved inside of the region.
+  size_t add_saved_variable();
+  /// Returns the data of the index-th variable saved inside of the region,
+  /// running `recompute` if it hasn't been run yet.
+  at::Tensor get(size_t index);
+  /// Called for every variable saved while `recompute` runs.
+  void record(const at::Tensor& data);
+
+ private:
+  std::function<void()> recompute_;
+  size_t num_saved_ = 0;
+  std::vector<at::Tensor> recomputed_;
+  bool done_ = false;
+  // To protect recomputed_ and done_ while recompute_ runs
+  std::mutex mutex_;
+};
+
+/// Thread local settings deciding how the `SavedVariable`s created on a thread
+/// keep their data.
+struct TORCH_API SavedVariableMode {
+  /// CUDA tensors of at least this many bytes are moved to pinned host memory
+  /// until backward. -1, the default, disables offloading.
+  static int64_t offload_min_bytes();
+  static void set_offload_min_bytes(int64_t min_bytes);
+
+  /// The region in which new saved variables are recomputed, if any.
+  static std::shared_ptr<RecomputeRegion> recompute_region();
+  static void set_recompute_region(std::shared_ptr<RecomputeRegion> region);
+};
+
 /// A snapshot of a variable at a certain version. A `SavedVariable` stores
 /// enough information to reconstruct a variable from a certain point in time.
 class TORCH_API SavedVariable {
@@ -28,7 +78,16 @@ class TORCH_API SavedVariable {
   /// circular reference.
   Variable unpack(std::shared_ptr<Node> saved_for = nullptr) const;
 
+  /// Starts bringing back data that was offloaded, called by the engine ahead
+  /// of running the Node that saved this variable.
+  void prefetch() const {
+    if (stash_) {
+      stash_->prefetch();
+    }
+  }
+
   void reset_data() {
+    stash_.reset();
     return data_.reset();
   }
 
@@ -38,6 +97,8 @@ class TORCH_API SavedVariable {
 
  private:
   at::Tensor data_;
+  // Set instead of data_ when the data is offloaded or recomputed
+  std::shared_ptr<SavedVariableStash> stash_;
 
   // The gradient function associated with this node. If has_grad_fn
   // is false, then this is a leaf node. Note that the grad_fn is not saved if
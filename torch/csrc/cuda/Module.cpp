@@ -6,6 +6,8 @@
 #include <TH/TH.h>
 #include <ATen/ATen.h>
 #include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/DeferredLaunch.h>
 #include <ATen/CUDAGenerator.h>
 #include <c10/cuda/CUDAFunctions.h>
 #include <c10/cuda/CUDACachingAllocator.h>
@@ -154,6 +156,7 @@ PyObject * THCPModule_cudaHostAllocator(PyObject *_unused, PyObject *noargs)
 PyObject * THCPModule_cudaSynchronize(PyObject *_unused, PyObject *noargs)
 {
   HANDLE_TH_ERRORS
+  at::cuda::flush_deferred_launches();
   THCudaCheck(cudaDeviceSynchronize());
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
@@ -167,6 +170,74 @@ PyObject * THCPModule_cudaIPCCollect(PyObject *_unused, PyObject *noargs)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_cudaIPCSetPooling(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "_cuda_ipc_set_pooling expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  torch::CudaIPCSetPooling(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_cudaIPCPoolingEnabled(PyObject *_unused, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  if (torch::CudaIPCPoolingEnabled()) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_setDeferredLaunchEnabled(PyObject *_unused, PyObject *arg)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyBool_Check(arg), "_cuda_set_deferred_launch_enabled expects a bool, "
+          "but got %s", THPUtils_typename(arg));
+  at::cuda::set_deferred_launch_enabled(arg == Py_True);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_deferredLaunchEnabled(PyObject *_unused, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  if (at::cuda::is_deferred_launch_enabled()) {
+    Py_RETURN_TRUE;
+  }
+  Py_RETURN_FALSE;
+  END_HANDLE_TH_ERRORS
+}
+
+PyObject * THCPModule_flushDeferredLaunches(PyObject *_unused, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  at::cuda::flush_deferred_launches();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+// Makes the raw cudaStream_t handle of a DLPack consumer wait for the work
+// queued so far on the current stream, without blocking the host. The
+// handles 1 and 2 of the protocol are cudaStreamLegacy and
+// cudaStreamPerThread, which the runtime accepts as they are.
+PyObject * THCPModule_streamWaitCurrentStream(PyObject *_unused, PyObject *obj)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(obj), "invalid stream handle");
+  auto handle = reinterpret_cast<cudaStream_t>(
+      static_cast<uintptr_t>(THPUtils_unpackLong(obj)));
+  auto current = at::cuda::getCurrentCUDAStream();
+  if (handle != current.stream()) {
+    at::cuda::CUDAEvent event;
+    event.record(current);
+    AT_CUDA_CHECK(cudaStreamWaitEvent(handle, event.event(), 0));
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THCPModule_cudaSleep(PyObject *_unused, PyObject *cycles)
 {
   HANDLE_TH_ERRORS
@@ -270,6 +341,7 @@ PyObject * THCPModule_memoryStats(PyObject *_unused, PyObject *arg)
   py::dict result;
   result["num_alloc_retries"] = stats.num_alloc_retries;
   result["num_ooms"] = stats.num_ooms;
+  result["largest_free_block_bytes"] = stats.largest_free_block_bytes;
   result["allocation"] = statArrayToDict(stats.allocation);
   result["segment"] = statArrayToDict(stats.segment);
   result["active"] = statArrayToDict(stats.active);
@@ -283,6 +355,50 @@ PyObject * THCPModule_memoryStats(PyObject *_unused, PyObject *arg)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_hostMemoryStats(PyObject *_unused, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  using c10::cuda::CUDACachingAllocator::StatType;
+  using c10::cuda::CUDACachingAllocator::Stat;
+  using c10::cuda::CUDACachingAllocator::StatArray;
+
+  const auto statToDict = [](const Stat& stat) {
+    py::dict dict;
+
+    dict["current"] = stat.current;
+    dict["peak"] = stat.peak;
+    dict["allocated"] = stat.allocated;
+    dict["freed"] = stat.freed;
+    return dict;
+  };
+
+  const auto statArrayToDict = [=](const StatArray& statArray) {
+    const std::array<const char*, static_cast<size_t>(StatType::NUM_TYPES)> statTypeNames = {
+      "all", "small_pool", "large_pool"
+    };
+    py::dict dict;
+    for (size_t i = 0; i < statTypeNames.size(); ++i) {
+      dict[statTypeNames[i]] = statToDict(statArray[i]);
+    }
+    return dict;
+  };
+
+  const THCCachingHostAllocatorStats stats = THCCachingHostAllocator_getStats();
+
+  py::dict result;
+  result["num_alloc_retries"] = stats.num_alloc_retries;
+  result["num_ooms"] = stats.num_ooms;
+  result["allocation"] = statArrayToDict(stats.allocation);
+  result["segment"] = statArrayToDict(stats.segment);
+  result["active"] = statArrayToDict(stats.active);
+  result["allocated_bytes"] = statArrayToDict(stats.allocated_bytes);
+  result["reserved_bytes"] = statArrayToDict(stats.reserved_bytes);
+  result["active_bytes"] = statArrayToDict(stats.active_bytes);
+
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject * THCPModule_resetAccumulatedMemoryStats(PyObject *_unused, PyObject *arg)
 {
   HANDLE_TH_ERRORS
@@ -314,6 +430,7 @@ PyObject * THCPModule_memorySnapshot(PyObject *_unused, PyObject *noargs)
     py::dict segmentDict;
     segmentDict["device"] = segmentInfo.device;
     segmentDict["address"] = segmentInfo.address;
+    segmentDict["stream"] = segmentInfo.stream;
     segmentDict["total_size"] = segmentInfo.total_size;
     segmentDict["allocated_size"] = segmentInfo.allocated_size;
     segmentDict["active_size"] = segmentInfo.active_size;
@@ -324,6 +441,9 @@ PyObject * THCPModule_memorySnapshot(PyObject *_unused, PyObject *noargs)
       py::dict blockDict;
       blockDict["size"] = blockInfo.size;
       blockDict["state"] = (blockInfo.allocated ? "active_allocated" : (blockInfo.active ? "active_pending_free" : "inactive"));
+      if (blockInfo.history) {
+        blockDict["history"] = *blockInfo.history;
+      }
       blocks.append(blockDict);
     }
     segmentDict["blocks"] = blocks;
@@ -342,6 +462,63 @@ PyObject * THCPModule_memorySnapshot(PyObject *_unused, PyObject *noargs)
   END_HANDLE_TH_ERRORS
 }
 
+PyObject * THCPModule_recordMemoryHistory(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  PyObject* enabled = nullptr;
+  Py_ssize_t trace_max_entries = 0;
+  if (!PyArg_ParseTuple(args, "On", &enabled, &trace_max_entries)) {
+    throw python_error();
+  }
+  THPUtils_assert(trace_max_entries >= 0, "trace_max_entries must be non-negative");
+  c10::cuda::CUDACachingAllocator::recordHistory(
+      PyObject_IsTrue(enabled), static_cast<size_t>(trace_max_entries));
+  END_HANDLE_TH_ERRORS
+  Py_RETURN_NONE;
+}
+
+PyObject * THCPModule_setStreamGroup(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  unsigned long long bits = 0;
+  long long group = 0;
+  if (!PyArg_ParseTuple(args, "KL", &bits, &group)) {
+    throw python_error();
+  }
+  auto stream = at::cuda::CUDAStream::unpack(static_cast<uint64_t>(bits));
+  c10::cuda::CUDACachingAllocator::setStreamGroup(stream.stream(), group);
+  END_HANDLE_TH_ERRORS
+  Py_RETURN_NONE;
+}
+
+PyObject * THCPModule_memoryTrace(PyObject *_unused, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+
+  using c10::cuda::CUDACachingAllocator::TraceEntry;
+
+  const std::array<const char*, 6> actionNames = {
+    "alloc", "free", "segment_alloc", "segment_free", "segment_map", "segment_unmap"
+  };
+
+  py::list result;
+  for (const auto& entry : c10::cuda::CUDACachingAllocator::allocationTrace()) {
+    py::dict entryDict;
+    entryDict["action"] = actionNames.at(entry.action);
+    entryDict["device"] = entry.device;
+    entryDict["address"] = entry.address;
+    entryDict["size"] = entry.size;
+    entryDict["stream"] = entry.stream;
+    if (entry.history) {
+      entryDict["history"] = *entry.history;
+    }
+    result.append(entryDict);
+  }
+
+  return result.release().ptr();
+  END_HANDLE_TH_ERRORS
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // Cuda module initialization
 ////////////////////////////////////////////////////////////////////////////////
@@ -463,9 +640,19 @@ static struct PyMethodDef _THCPModule_methods[] = {
   {"_cuda_resetAccumulatedMemoryStats", (PyCFunction) THCPModule_resetAccumulatedMemoryStats, METH_O, nullptr},
   {"_cuda_resetPeakMemoryStats", (PyCFunction) THCPModule_resetPeakMemoryStats, METH_O,  nullptr},
   {"_cuda_memorySnapshot", (PyCFunction) THCPModule_memorySnapshot, METH_NOARGS, nullptr},
+  {"_cuda_hostMemoryStats", (PyCFunction) THCPModule_hostMemoryStats, METH_NOARGS, nullptr},
+  {"_cuda_recordMemoryHistory", (PyCFunction) THCPModule_recordMemoryHistory, METH_VARARGS, nullptr},
+  {"_cuda_memoryTrace", (PyCFunction) THCPModule_memoryTrace, METH_NOARGS, nullptr},
+  {"_cuda_setStreamGroup", (PyCFunction) THCPModule_setStreamGroup, METH_VARARGS, nullptr},
   {"_cuda_cudaHostAllocator", (PyCFunction)THCPModule_cudaHostAllocator, METH_NOARGS, nullptr},
   {"_cuda_synchronize", (PyCFunction)THCPModule_cudaSynchronize, METH_NOARGS, nullptr},
   {"_cuda_ipc_collect", (PyCFunction)THCPModule_cudaIPCCollect, METH_NOARGS, nullptr},
+  {"_cuda_ipc_set_pooling", (PyCFunction)THCPModule_cudaIPCSetPooling, METH_O, nullptr},
+  {"_cuda_ipc_pooling_enabled", (PyCFunction)THCPModule_cudaIPCPoolingEnabled, METH_NOARGS, nullptr},
+  {"_cuda_set_deferred_launch_enabled", (PyCFunction)THCPModule_setDeferredLaunchEnabled, METH_O, nullptr},
+  {"_cuda_deferred_launch_enabled", (PyCFunction)THCPModule_deferredLaunchEnabled, METH_NOARGS, nullptr},
+  {"_cuda_flush_deferred_launches", (PyCFunction)THCPModule_flushDeferredLaunches, METH_NOARGS, nullptr},
+  {"_cuda_stream_wait_current_stream", (PyCFunction)THCPModule_streamWaitCurrentStream, METH_O, nullptr},
   {"_cuda_sleep", (PyCFunction)THCPModule_cudaSleep, METH_O, nullptr},
   {"_cuda_lock_mutex",   (PyCFunction)THCPModule_cudaLockMutex,   METH_NOARGS,  nullptr},
   {"_cuda_unlock_mutex", (PyCFunction)THCPModule_cudaUnlockMutex, METH_NOARGS,  nullptr},
@@ -9,6 +9,8 @@
 
 #include <ATen/ATen.h>
 #include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDACachingAllocator.h>
 #include <c10/cuda/CUDAGuard.h>
 #include <c10/util/Optional.h>
 #include <torch/csrc/autograd/variable.h>
@@ -98,6 +100,16 @@ std::vector<Tensor> broadcast(const Tensor& tensor, IntArrayRef devices) {
 //
 // Similarly for reduce_add_coalesced, when the output are newly created
 // Variables.
+
+// NOTE [ Pipelined broadcast_coalesced ]
+//
+// The dense buckets are flattened on a side stream of devices[0] while the
+// buckets before them are broadcast on the current streams, so that copying
+// bucket i + 1 into its flat buffer overlaps with sending bucket i. The side
+// stream waits once for the work queued on the current stream, which produced
+// the inputs, and the current stream waits for the flattening of each bucket
+// right before broadcasting it. Unflattening only makes views of the received
+// buffers, so it doesn't queue any work.
 tensor_list2d broadcast_coalesced(TensorList tensors, IntArrayRef devices, size_t buffer_size) {
   if (!std::all_of(tensors.begin(), tensors.end(),
                    [&](const at::Tensor& t) { return t.get_device() == devices[0]; })) {
@@ -114,6 +126,17 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntArrayRef devices, size_
 
   unique_type_checker type_checker;
   at::cuda::CUDAGuard device_guard(devices[0]);
+
+  // See NOTE [ Pipelined broadcast_coalesced ]
+  at::cuda::CUDAStream current_stream = at::cuda::getCurrentCUDAStream(devices[0]);
+  at::cuda::CUDAStream flatten_stream = at::cuda::getStreamFromPool(false, devices[0]);
+  {
+    at::cuda::CUDAEvent inputs_ready;
+    inputs_ready.record(current_stream);
+    inputs_ready.block(flatten_stream);
+  }
+  at::cuda::CUDAEvent flattened;
+
   for (auto & chunk : utils::take_tensors(tensors, buffer_size)) {
     auto & type = chunk.type();
     type_checker.show(type);
@@ -136,8 +159,22 @@ tensor_list2d broadcast_coalesced(TensorList tensors, IntArrayRef devices, size_
         }
       }
     } else {
-      std::vector<Tensor> results = broadcast(utils::flatten_dense_tensors(chunk.tensors),
-                                              devices);
+      Tensor flat;
+      {
+        at::cuda::CUDAStreamGuard stream_guard(flatten_stream);
+        // The inputs are used on the side stream, and the flat buffer
+        // allocated there is used on the current stream.
+        for (auto & t : chunk.tensors) {
+          c10::cuda::CUDACachingAllocator::recordStream(
+              t.storage().data(), flatten_stream);
+        }
+        flat = utils::flatten_dense_tensors(chunk.tensors);
+        c10::cuda::CUDACachingAllocator::recordStream(
+            flat.storage().data(), current_stream);
+        flattened.record(flatten_stream);
+      }
+      flattened.block(current_stream);
+      std::vector<Tensor> results = broadcast(flat, devices);
       for (size_t i = 1, num_devices = devices.size(); i < num_devices; ++i) {
         device_guard.set_index(devices[i]);
         auto & device_outputs = outputs[i];
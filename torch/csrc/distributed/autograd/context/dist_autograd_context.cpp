@@ -6,7 +6,8 @@ namespace distributed {
 namespace autograd {
 
 DistAutogradContext::DistAutogradContext(int64_t contextId)
-    : contextId_(contextId) {}
+    : contextId_(contextId),
+      gradientCoalescer_(std::make_shared<GradientCoalescer>(contextId)) {}
 
 int64_t DistAutogradContext::contextId() const {
   return contextId_;
@@ -98,12 +99,25 @@ void DistAutogradContext::addOutstandingRpc(
   outStandingRpcs_.push_back(futureMessage);
 }
 
+void DistAutogradContext::sendGradients(
+    rpc::worker_id_t to,
+    int64_t autogradMessageId,
+    std::vector<torch::autograd::Variable> grads) {
+  gradientCoalescer_->send(to, autogradMessageId, std::move(grads));
+}
+
 void DistAutogradContext::clearAndWaitForOutstandingRpcs() {
   // Copy futures under lock, but wait for them outside the lock.
   std::unique_lock<std::mutex> lock(lock_);
   auto outStandingRpcs = std::move(outStandingRpcs_);
   lock.unlock();
 
+  // The local backward pass is done, so there is no point in holding back
+  // any gradients any longer.
+  auto sentGradients = gradientCoalescer_->flushAndTakeSent();
+  outStandingRpcs.insert(
+      outStandingRpcs.end(), sentGradients.begin(), sentGradients.end());
+
   for (const auto& outStandingRpc : outStandingRpcs) {
     outStandingRpc->wait();
   }
@@ -2,6 +2,7 @@
 
 #include <ATen/core/Dict.h>
 #include <torch/csrc/autograd/engine.h>
+#include <torch/csrc/distributed/autograd/context/gradient_coalescer.h>
 #include <torch/csrc/distributed/autograd/functions/recvrpc_backward.h>
 #include <torch/csrc/distributed/autograd/functions/sendrpc_backward.h>
 #include <torch/csrc/distributed/rpc/future_message.h>
@@ -51,6 +52,15 @@ class TORCH_API DistAutogradContext {
   void addOutstandingRpc(
       const std::shared_ptr<rpc::FutureMessage>& futureMessage);
 
+  // Sends the gradients for the 'recv' function with the given autograd
+  // message id to the worker with id `to`, possibly coalesced with others
+  // for the same worker (see GradientCoalescer). The RPC is waited for like
+  // the outstanding ones.
+  void sendGradients(
+      rpc::worker_id_t to,
+      int64_t autogradMessageId,
+      std::vector<torch::autograd::Variable> grads);
+
   // Returns all gradients.
   const c10::Dict<torch::Tensor, torch::Tensor> getGradients() const;
 
@@ -116,6 +126,11 @@ class TORCH_API DistAutogradContext {
   // successfully only if all these futures are done and are successfull.
   std::vector<std::shared_ptr<rpc::FutureMessage>> outStandingRpcs_;
 
+  // Sends the gradients of the 'recv' functions of this context. Shared with
+  // the thread flushing it at the end of its coalescing window, which must
+  // not keep it alive.
+  std::shared_ptr<GradientCoalescer> gradientCoalescer_;
+
   // Lock to protect concurrent modification of the context.
   mutable std::mutex lock_;
 };
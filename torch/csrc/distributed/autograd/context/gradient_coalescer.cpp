@@ -0,0 +1,177 @@
+#include <torch/csrc/distributed/autograd/context/gradient_coalescer.h>
+#include <c10/util/Logging.h>
+#include <torch/csrc/distributed/rpc/rpc_agent.h>
+
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+namespace torch {
+namespace distributed {
+namespace autograd {
+
+using torch::autograd::Variable;
+
+constexpr size_t GradientCoalescer::kSmallGradientsBytes;
+constexpr size_t GradientCoalescer::kMaxPendingBytes;
+constexpr std::chrono::microseconds GradientCoalescer::kCoalescingWindow;
+
+namespace {
+
+size_t gradientsBytes(const std::vector<Variable>& grads) {
+  size_t bytes = 0;
+  for (const auto& grad : grads) {
+    bytes += grad.numel() * grad.element_size();
+  }
+  return bytes;
+}
+
+// A single background thread flushing coalescers at the end of their
+// coalescing window. Since all windows have the same length, deadlines are
+// scheduled in order and a FIFO queue is enough.
+class FlushThread {
+ public:
+  static FlushThread& getInstance() {
+    static FlushThread instance;
+    return instance;
+  }
+
+  void schedule(std::weak_ptr<GradientCoalescer> coalescer) {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      queue_.emplace_back(
+          std::chrono::steady_clock::now() +
+              GradientCoalescer::kCoalescingWindow,
+          std::move(coalescer));
+    }
+    cv_.notify_one();
+  }
+
+  ~FlushThread() {
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      stop_ = true;
+    }
+    cv_.notify_one();
+    thread_.join();
+  }
+
+ private:
+  FlushThread() : thread_(&FlushThread::run, this) {}
+
+  void run() {
+    std::unique_lock<std::mutex> lock(lock_);
+    while (!stop_) {
+      if (queue_.empty()) {
+        cv_.wait(lock);
+        continue;
+      }
+      if (std::chrono::steady_clock::now() < queue_.front().first) {
+        cv_.wait_until(lock, queue_.front().first);
+        continue;
+      }
+      auto coalescer = queue_.front().second.lock();
+      queue_.pop_front();
+      lock.unlock();
+      // The context (and with it the coalescer) may be gone already.
+      if (coalescer) {
+        try {
+          coalescer->flush();
+        } catch (const std::exception& e) {
+          LOG(ERROR) << "Failed to send coalesced gradients: " << e.what();
+        }
+      }
+      lock.lock();
+    }
+  }
+
+  std::deque<std::pair<
+      std::chrono::steady_clock::time_point,
+      std::weak_ptr<GradientCoalescer>>>
+      queue_;
+  bool stop_ = false;
+  std::mutex lock_;
+  std::condition_variable cv_;
+  std::thread thread_;
+};
+
+} // namespace
+
+GradientCoalescer::GradientCoalescer(int64_t contextId)
+    : contextId_(contextId) {}
+
+void GradientCoalescer::send(
+    rpc::worker_id_t to,
+    int64_t autogradMessageId,
+    std::vector<Variable> grads) {
+  const size_t bytes = gradientsBytes(grads);
+  if (bytes >= kSmallGradientsBytes) {
+    std::vector<PropagateGradientsReq::Entry> entries;
+    entries.push_back({autogradMessageId, std::move(grads)});
+    sendNow(to, std::move(entries));
+    return;
+  }
+
+  std::vector<PropagateGradientsReq::Entry> full;
+  bool scheduleFlush = false;
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    auto& pending = pending_[to];
+    pending.entries.push_back({autogradMessageId, std::move(grads)});
+    pending.bytes += bytes;
+    if (pending.bytes >= kMaxPendingBytes) {
+      full = std::move(pending.entries);
+      pending_.erase(to);
+    } else if (!flushScheduled_) {
+      flushScheduled_ = scheduleFlush = true;
+    }
+  }
+  if (!full.empty()) {
+    sendNow(to, std::move(full));
+  }
+  if (scheduleFlush) {
+    FlushThread::getInstance().schedule(shared_from_this());
+  }
+}
+
+std::unordered_map<rpc::worker_id_t, GradientCoalescer::Pending>
+GradientCoalescer::takePending() {
+  std::lock_guard<std::mutex> guard(lock_);
+  flushScheduled_ = false;
+  auto pending = std::move(pending_);
+  pending_.clear();
+  return pending;
+}
+
+void GradientCoalescer::flush() {
+  // Held until the RPCs are recorded in sent_, so flushAndTakeSent() can't
+  // miss those of a concurrent flush from the background thread.
+  std::lock_guard<std::mutex> guard(flushLock_);
+  for (auto& entry : takePending()) {
+    sendNow(entry.first, std::move(entry.second.entries));
+  }
+}
+
+std::vector<std::shared_ptr<rpc::FutureMessage>> GradientCoalescer::
+    flushAndTakeSent() {
+  flush();
+  std::lock_guard<std::mutex> guard(lock_);
+  auto sent = std::move(sent_);
+  sent_.clear();
+  return sent;
+}
+
+void GradientCoalescer::sendNow(
+    rpc::worker_id_t to,
+    std::vector<PropagateGradientsReq::Entry> entries) {
+  PropagateGradientsReq gradCall(contextId_, std::move(entries));
+  auto rpcAgent = rpc::RpcAgent::getDefaultRpcAgent();
+  auto futureMessage = rpcAgent->send(
+      rpcAgent->getWorkerInfo(to), std::move(gradCall).toMessage());
+  std::lock_guard<std::mutex> guard(lock_);
+  sent_.push_back(std::move(futureMessage));
+}
+
+} // namespace autograd
+} // namespace distributed
+} // namespace torch
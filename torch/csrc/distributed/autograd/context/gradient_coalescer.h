@@ -0,0 +1,82 @@
+#pragma once
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_req.h>
+#include <torch/csrc/distributed/rpc/future_message.h>
+#include <torch/csrc/distributed/rpc/types.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace torch {
+namespace distributed {
+namespace autograd {
+
+// Sends the gradients of the 'recv' functions of one autograd context to the
+// nodes that sent the corresponding RPCs, coalescing small ones for the same
+// node into a single PropagateGradientsReq.
+//
+// Gradients smaller than kSmallGradientsBytes are held back until either
+// kMaxPendingBytes are pending for their destination, or kCoalescingWindow
+// passed since the first of them was held back, at which point a background
+// thread sends them. The deadline matters for correctness: the backward pass
+// of another node may depend on the gradients held back, so they can't wait
+// for the local backward pass to finish.
+class TORCH_API GradientCoalescer
+    : public std::enable_shared_from_this<GradientCoalescer> {
+ public:
+  static constexpr size_t kSmallGradientsBytes = 64 * 1024;
+  static constexpr size_t kMaxPendingBytes = 1024 * 1024;
+  static constexpr std::chrono::microseconds kCoalescingWindow{500};
+
+  explicit GradientCoalescer(int64_t contextId);
+
+  // Sends (or holds back) the gradients for the 'recv' function with the
+  // given autograd message id to the worker with id `to`.
+  void send(
+      rpc::worker_id_t to,
+      int64_t autogradMessageId,
+      std::vector<torch::autograd::Variable> grads);
+
+  // Sends all the gradients held back so far.
+  void flush();
+
+  // Sends all the gradients held back so far and returns the futures of all
+  // the RPCs sent since the last call, to wait for them.
+  std::vector<std::shared_ptr<rpc::FutureMessage>> flushAndTakeSent();
+
+ private:
+  struct Pending {
+    std::vector<PropagateGradientsReq::Entry> entries;
+    size_t bytes = 0;
+  };
+
+  // Sends `entries` to `to` in a single RPC. Must be called without lock_.
+  void sendNow(
+      rpc::worker_id_t to,
+      std::vector<PropagateGradientsReq::Entry> entries);
+
+  std::unordered_map<rpc::worker_id_t, Pending> takePending();
+
+  const int64_t contextId_;
+
+  std::unordered_map<rpc::worker_id_t, Pending> pending_;
+
+  // Whether a flush at the end of the coalescing window is scheduled.
+  bool flushScheduled_ = false;
+
+  std::vector<std::shared_ptr<rpc::FutureMessage>> sent_;
+
+  std::mutex lock_;
+
+  // Serializes flushes.
+  std::mutex flushLock_;
+};
+
+} // namespace autograd
+} // namespace distributed
+} // namespace torch
@@ -1,9 +1,11 @@
 #include <queue>
 
+#include <ATen/Parallel.h>
 #include <torch/csrc/autograd/functions/accumulate_grad.h>
 #include <torch/csrc/autograd/input_buffer.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_container.h>
 #include <torch/csrc/distributed/autograd/engine/dist_engine.h>
+#include <torch/csrc/distributed/rpc/utils.h>
 
 namespace torch {
 namespace distributed {
@@ -196,9 +198,10 @@ void DistEngine::runEngineAndAccumulateGradients(
   }
 }
 
-void DistEngine::executeSendFunction(
+std::shared_ptr<rpc::FutureMessage> DistEngine::executeSendFunction(
     DistAutogradContext& autogradContext,
     const std::shared_ptr<Node>& sendFunction) {
+  auto future = std::make_shared<rpc::FutureMessage>();
   std::unique_lock<std::mutex> lock(initializedContextIdsLock_);
   if (initializedContextIds_.find(autogradContext.contextId()) ==
       initializedContextIds_.end()) {
@@ -216,17 +219,27 @@ void DistEngine::executeSendFunction(
     engine_.enqueue_blocked_task_on_cpu(torch::autograd::NodeTask(
         graphTask.get(), sendFunction, torch::autograd::InputBuffer(0)));
 
-    // Run the autograd engine.
-    runEngineAndAccumulateGradients(autogradContext, dummyRoot, outputEdges);
-
-    // Wait for all of the outstanding rpcs to complete.
-    autogradContext.clearAndWaitForOutstandingRpcs();
+    // Run the autograd engine, and wait for all of the outstanding rpcs to
+    // complete, without holding on to the calling RPC thread.
+    at::launch([this, &autogradContext, dummyRoot, outputEdges, future]() {
+      try {
+        runEngineAndAccumulateGradients(
+            autogradContext, dummyRoot, outputEdges);
+        autogradContext.clearAndWaitForOutstandingRpcs();
+      } catch (const std::exception& e) {
+        future->markCompleted(rpc::createExceptionResponse(e, 0));
+        return;
+      }
+      future->markCompleted();
+    });
   } else {
     lock.unlock();
     auto graphTask = autogradContext.retrieveGraphTask();
     engine_.enqueue_blocked_task_on_cpu(torch::autograd::NodeTask(
         graphTask.get(), sendFunction, torch::autograd::InputBuffer(0)));
+    future->markCompleted();
   }
+  return future;
 }
 
 void DistEngine::execute(const variable_list& roots) {
@@ -7,6 +7,7 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/functions/basic_ops.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_context.h>
+#include <torch/csrc/distributed/rpc/future_message.h>
 
 namespace torch {
 namespace distributed {
@@ -38,7 +39,15 @@ class TORCH_API DistEngine {
   // This method is used to kick off the autograd computation on a node when it
   // receives gradients from the corresponding 'recv' method on another node.
   // The gradients are accumulated in the provided autograd context.
-  void executeSendFunction(
+  //
+  // The first send function of a context starts the local backward pass,
+  // which runs on another thread, so that the thread delivering the gradients
+  // can go on serving RPCs meanwhile (including those delivering gradients for
+  // the other send functions). The returned future completes once this
+  // backward pass and the RPCs it made are done, with an empty message or an
+  // EXCEPTION message if any of them failed. For the other send functions, it
+  // is completed already.
+  std::shared_ptr<rpc::FutureMessage> executeSendFunction(
       DistAutogradContext& autogradContext,
       const std::shared_ptr<torch::autograd::Node>& sendFunction);
 
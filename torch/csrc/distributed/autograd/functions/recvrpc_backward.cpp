@@ -1,7 +1,5 @@
 #include <torch/csrc/distributed/autograd/functions/recvrpc_backward.h>
 #include <ATen/core/functional.h>
-#include <torch/csrc/distributed/autograd/rpc_messages/propagate_gradients_req.h>
-#include <torch/csrc/distributed/rpc/rpc_agent.h>
 
 namespace torch {
 namespace distributed {
@@ -30,18 +28,13 @@ variable_list RecvRpcBackward::apply(variable_list&& grads) {
     }
   }
 
-  // Send the gradients over the wire and record the future in the autograd
-  // context.
-  PropagateGradientsReq gradCall(autogradMetadata_, outputGrads);
-
-  // Send the gradients over to the appropriate node (we don't need the worker
-  // name only the id, so use a placeholder "foo").
-  auto rpcAgent = rpc::RpcAgent::getDefaultRpcAgent();
-  auto futureMessage = rpcAgent->send(
-      rpcAgent->getWorkerInfo(fromWorkerId_), std::move(gradCall).toMessage());
-
-  // Record the future in the context.
-  autogradContext_.addOutstandingRpc(futureMessage);
+  // Send the gradients over the wire to the appropriate node. The context
+  // records the RPC as outstanding, and may coalesce it with the gradients of
+  // other 'recv' functions for the same node.
+  autogradContext_.sendGradients(
+      fromWorkerId_,
+      autogradMetadata_.autogradMessageId,
+      std::move(outputGrads));
 
   // 'recv' function sends the gradients over the wire using RPC, it doesn't
   // need to return anything for any downstream autograd function.
@@ -12,18 +12,33 @@ using torch::autograd::Variable;
 PropagateGradientsReq::PropagateGradientsReq(
     const AutogradMetadata& autogradMetadata,
     std::vector<Variable> grads)
-    : autogradMetadata_(autogradMetadata), grads_(std::move(grads)) {}
+    : autogradContextId_(autogradMetadata.autogradContextId) {
+  entries_.push_back({autogradMetadata.autogradMessageId, std::move(grads)});
+}
+
+PropagateGradientsReq::PropagateGradientsReq(
+    int64_t autogradContextId,
+    std::vector<Entry> entries)
+    : autogradContextId_(autogradContextId), entries_(std::move(entries)) {}
 
 Message PropagateGradientsReq::toMessage() && {
   std::vector<at::IValue> ivalues;
-  // Add all the grad tensors.
-  for (const auto& grad : grads_) {
-    ivalues.emplace_back(grad);
+  // Add all the grad tensors, entry by entry.
+  for (const auto& entry : entries_) {
+    for (const auto& grad : entry.grads) {
+      ivalues.emplace_back(grad);
+    }
+  }
+
+  // Then the message id and number of grads of every entry.
+  for (const auto& entry : entries_) {
+    ivalues.emplace_back(entry.autogradMessageId);
+    ivalues.emplace_back(static_cast<int64_t>(entry.grads.size()));
   }
 
-  // Now add autograd metadata.
-  ivalues.emplace_back(autogradMetadata_.autogradContextId);
-  ivalues.emplace_back(autogradMetadata_.autogradMessageId);
+  // Now add the number of entries and the autograd context id.
+  ivalues.emplace_back(static_cast<int64_t>(entries_.size()));
+  ivalues.emplace_back(autogradContextId_);
 
   // Now pickle using JIT pickler.
   std::vector<torch::Tensor> tensorTable;
@@ -43,37 +58,43 @@ std::unique_ptr<PropagateGradientsReq> PropagateGradientsReq::fromMessage(
   auto payload_size = message.payload().size();
   IValue tuple =
       jit::unpickle(payload, payload_size, nullptr, &message.tensors());
-  std::vector<at::IValue> tupleElements = tuple.toTuple()->elements();
+  const std::vector<at::IValue>& tupleElements = tuple.toTuple()->elements();
 
-  // Build PropagateGradientsReq.
+  // Retrieve the autograd context id and the number of entries.
   TORCH_INTERNAL_ASSERT(tupleElements.size() >= 2);
-
-  // Build AutogradMetadata.
-  int64_t autogradContextId, autogradMessageId;
-  autogradMessageId = tupleElements.back().toInt();
-  tupleElements.pop_back();
-  autogradContextId = tupleElements.back().toInt();
-  tupleElements.pop_back();
-
-  AutogradMetadata autogradMetadata(autogradContextId, autogradMessageId);
-
-  // Retrieve the gradient tensors.
-  std::vector<Variable> grads(tupleElements.size());
-  for (size_t i = 0; i < tupleElements.size(); i++) {
-    grads[i] = tupleElements[i].toTensor();
+  const int64_t autogradContextId = tupleElements.back().toInt();
+  const int64_t numEntries = tupleElements[tupleElements.size() - 2].toInt();
+  TORCH_INTERNAL_ASSERT(
+      numEntries >= 0 &&
+      tupleElements.size() >= 2 + 2 * static_cast<size_t>(numEntries));
+
+  // Build the entries, whose grads come first, in order.
+  const size_t headerStart = tupleElements.size() - 2 - 2 * numEntries;
+  std::vector<Entry> entries(numEntries);
+  size_t gradIndex = 0;
+  for (int64_t i = 0; i < numEntries; i++) {
+    entries[i].autogradMessageId = tupleElements[headerStart + 2 * i].toInt();
+    const int64_t numGrads = tupleElements[headerStart + 2 * i + 1].toInt();
+    TORCH_INTERNAL_ASSERT(
+        numGrads >= 0 && gradIndex + numGrads <= headerStart);
+    entries[i].grads.reserve(numGrads);
+    for (int64_t j = 0; j < numGrads; j++) {
+      entries[i].grads.emplace_back(tupleElements[gradIndex++].toTensor());
+    }
   }
+  TORCH_INTERNAL_ASSERT(gradIndex == headerStart);
 
   return std::unique_ptr<PropagateGradientsReq>(
-      new PropagateGradientsReq(autogradMetadata, grads));
+      new PropagateGradientsReq(autogradContextId, std::move(entries)));
 }
 
-const AutogradMetadata& PropagateGradientsReq::getAutogradMetadata() {
-  return autogradMetadata_;
+int64_t PropagateGradientsReq::getAutogradContextId() const {
+  return autogradContextId_;
 }
 
-const std::vector<torch::autograd::Variable>& PropagateGradientsReq::
-    getGrads() {
-  return grads_;
+const std::vector<PropagateGradientsReq::Entry>& PropagateGradientsReq::
+    getEntries() const {
+  return entries_;
 }
 
 } // namespace autograd
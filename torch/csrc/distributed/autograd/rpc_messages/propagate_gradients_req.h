@@ -11,16 +11,26 @@ namespace autograd {
 
 // Used to propagate gradients from one node to another during a distributed
 // backwards pass. This RPC call is invoked when we hit a `recv` autograd
-// function during backward pass execution.
+// function during backward pass execution. To save round trips, a single
+// request may carry the gradients of several `recv` functions of the same
+// autograd context, which all sent their RPC to the same node.
 class TORCH_API PropagateGradientsReq : public rpc::RpcCommandBase {
  public:
+  // The gradients for the 'send' function of one autograd message id.
+  struct Entry {
+    int64_t autogradMessageId;
+    std::vector<torch::autograd::Variable> grads;
+  };
+
   PropagateGradientsReq(
       const AutogradMetadata& autogradMetadata,
       std::vector<torch::autograd::Variable> grads);
 
-  const AutogradMetadata& getAutogradMetadata();
+  PropagateGradientsReq(int64_t autogradContextId, std::vector<Entry> entries);
+
+  int64_t getAutogradContextId() const;
 
-  const std::vector<torch::autograd::Variable>& getGrads();
+  const std::vector<Entry>& getEntries() const;
 
   // Serialization and deserialization methods.
   rpc::Message toMessage() && override;
@@ -28,8 +38,8 @@ class TORCH_API PropagateGradientsReq : public rpc::RpcCommandBase {
       const rpc::Message& message);
 
  private:
-  AutogradMetadata autogradMetadata_;
-  std::vector<torch::autograd::Variable> grads_;
+  int64_t autogradContextId_;
+  std::vector<Entry> entries_;
 };
 
 } // namespace autograd
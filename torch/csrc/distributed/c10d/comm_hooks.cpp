@@ -0,0 +1,228 @@
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <ATen/CPUGenerator.h>
+#include <c10/util/Exception.h>
+
+namespace c10d {
+
+CommHookFuture::CommHookFuture(std::vector<at::Tensor> result)
+    : completed_(true), result_(std::move(result)) {}
+
+CommHookFuture::CommHookFuture(
+    std::vector<std::shared_ptr<ProcessGroup::Work>> works,
+    Continuation then)
+    : works_(std::move(works)), then_(std::move(then)), completed_(false) {}
+
+std::vector<at::Tensor> CommHookFuture::wait() {
+  if (!completed_) {
+    for (auto& work : works_) {
+      work->wait();
+    }
+    result_ = then_();
+    works_.clear();
+    then_ = nullptr;
+    completed_ = true;
+  }
+  return result_;
+}
+
+FP16CompressHook::FP16CompressHook(std::shared_ptr<ProcessGroup> process_group)
+    : process_group_(std::move(process_group)) {}
+
+std::shared_ptr<CommHookFuture> FP16CompressHook::runHook(GradBucket& bucket) {
+  auto tensors = bucket.tensors;
+  const bool compress = std::all_of(
+      tensors.begin(), tensors.end(), [](const at::Tensor& tensor) {
+        return tensor.scalar_type() == at::kFloat ||
+            tensor.scalar_type() == at::kDouble;
+      });
+  if (!compress) {
+    auto work = process_group_->allreduce(tensors);
+    return std::make_shared<CommHookFuture>(
+        std::vector<std::shared_ptr<ProcessGroup::Work>>{std::move(work)},
+        [tensors] { return tensors; });
+  }
+
+  std::vector<at::Tensor> compressed;
+  compressed.reserve(tensors.size());
+  for (const auto& tensor : tensors) {
+    compressed.push_back(tensor.to(at::kHalf));
+  }
+  auto work = process_group_->allreduce(compressed);
+  return std::make_shared<CommHookFuture>(
+      std::vector<std::shared_ptr<ProcessGroup::Work>>{std::move(work)},
+      [tensors, compressed] {
+        for (size_t i = 0; i < tensors.size(); i++) {
+          tensors[i].copy_(compressed[i]);
+        }
+        return tensors;
+      });
+}
+
+TopKCompressHook::TopKCompressHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    double ratio)
+    : process_group_(std::move(process_group)), ratio_(ratio) {
+  AT_ASSERTM(
+      ratio_ > 0 && ratio_ <= 1, "Expected a compression ratio in (0, 1].");
+}
+
+std::shared_ptr<CommHookFuture> TopKCompressHook::runHook(GradBucket& bucket) {
+  AT_ASSERTM(
+      bucket.tensors.size() == 1,
+      "Top-k gradient compression only supports a single model replica.");
+  auto tensor = bucket.tensors[0];
+  const auto numel = tensor.numel();
+  const auto k = std::min<int64_t>(
+      numel, std::max<int64_t>(1, static_cast<int64_t>(numel * ratio_)));
+
+  // Add what was held back in previous iterations (error feedback).
+  auto& residual = residuals_[bucket.index];
+  if (!residual.defined() || residual.numel() != numel) {
+    residual = at::zeros_like(tensor);
+  }
+  tensor.add_(residual);
+
+  auto indices = std::get<1>(tensor.abs().topk(
+      k, /* dim */ 0, /* largest */ true, /* sorted */ false));
+  auto values = tensor.index_select(0, indices);
+  residual.copy_(tensor);
+  residual.index_fill_(0, indices, 0);
+
+  // Every process selects different indices, so gather all (value, index)
+  // pairs and sum them into a dense tensor.
+  const auto size = process_group_->getSize();
+  std::vector<std::vector<at::Tensor>> gathered_values(1);
+  std::vector<std::vector<at::Tensor>> gathered_indices(1);
+  for (int i = 0; i < size; i++) {
+    gathered_values[0].push_back(at::empty_like(values));
+    gathered_indices[0].push_back(at::empty_like(indices));
+  }
+  std::vector<at::Tensor> input_values = {values};
+  std::vector<at::Tensor> input_indices = {indices};
+  std::vector<std::shared_ptr<ProcessGroup::Work>> works = {
+      process_group_->allgather(gathered_values, input_values),
+      process_group_->allgather(gathered_indices, input_indices),
+  };
+  return std::make_shared<CommHookFuture>(
+      std::move(works),
+      [tensor,
+       gathered_values,
+       gathered_indices,
+       input_values,
+       input_indices]() mutable {
+        tensor.zero_();
+        for (size_t i = 0; i < gathered_values[0].size(); i++) {
+          tensor.index_add_(0, gathered_indices[0][i], gathered_values[0][i]);
+        }
+        return std::vector<at::Tensor>{tensor};
+      });
+}
+
+ReduceScatterHook::ReduceScatterHook(
+    std::shared_ptr<ProcessGroup> process_group)
+    : process_group_(std::move(process_group)) {}
+
+std::shared_ptr<CommHookFuture> ReduceScatterHook::runHook(
+    GradBucket& bucket) {
+  AT_ASSERTM(
+      bucket.tensors.size() == 1,
+      "Reduce-scatter of gradients only supports a single model replica.");
+  auto tensor = bucket.tensors[0];
+  const auto numel = tensor.numel();
+  const auto size = process_group_->getSize();
+  const auto rank = process_group_->getRank();
+  const auto shard_numel = (numel + size - 1) / size;
+
+  // Pad the flat bucket to `size` shards of the same size.
+  auto padded = at::zeros({shard_numel * size}, tensor.options());
+  padded.narrow(0, 0, numel).copy_(tensor);
+  std::vector<std::vector<at::Tensor>> inputs = {padded.chunk(size)};
+  std::vector<at::Tensor> outputs = {at::empty({shard_numel}, tensor.options())};
+  auto work = process_group_->reduce_scatter(outputs, inputs);
+
+  const auto offset = std::min<int64_t>(rank * shard_numel, numel);
+  const auto length = std::min<int64_t>(shard_numel, numel - offset);
+  return std::make_shared<CommHookFuture>(
+      std::vector<std::shared_ptr<ProcessGroup::Work>>{std::move(work)},
+      [tensor, inputs, outputs, offset, length] {
+        tensor.narrow(0, offset, length)
+            .copy_(outputs[0].narrow(0, 0, length));
+        return std::vector<at::Tensor>{tensor};
+      });
+}
+
+PowerSGDHook::PowerSGDHook(
+    std::shared_ptr<ProcessGroup> process_group,
+    int64_t matrix_approximation_rank,
+    uint64_t seed)
+    : process_group_(std::move(process_group)),
+      matrix_approximation_rank_(matrix_approximation_rank),
+      seed_(seed) {
+  AT_ASSERTM(
+      matrix_approximation_rank_ > 0,
+      "Expected a positive matrix approximation rank.");
+}
+
+std::shared_ptr<CommHookFuture> PowerSGDHook::runHook(GradBucket& bucket) {
+  AT_ASSERTM(
+      bucket.tensors.size() == 1,
+      "PowerSGD gradient compression only supports a single model replica.");
+  auto tensor = bucket.tensors[0];
+  const auto numel = tensor.numel();
+  const auto cols = static_cast<int64_t>(
+      std::ceil(std::sqrt(static_cast<double>(numel))));
+  const auto rows = (numel + cols - 1) / cols;
+  const auto rank =
+      std::min(matrix_approximation_rank_, std::min(rows, cols));
+
+  // Half precision matrix products aren't supported everywhere.
+  auto options = tensor.options().dtype(
+      tensor.scalar_type() == at::kDouble ? at::kDouble : at::kFloat);
+
+  auto& state = states_[bucket.index];
+  if (!state.residual.defined() || state.residual.numel() != numel) {
+    state.residual = at::zeros({numel}, options);
+    // Q must start out identical on all processes.
+    auto generator = at::detail::createCPUGenerator(seed_ + bucket.index);
+    state.q = at::randn(
+                  {cols, rank},
+                  generator.get(),
+                  options.device(at::kCPU))
+                  .to(tensor.device());
+  }
+
+  // Add what was held back in previous iterations (error feedback), and pad
+  // the flat bucket to a rows x cols matrix.
+  auto input =
+      tensor.to(options.dtype(), /* non_blocking */ false, /* copy */ true);
+  input.add_(state.residual);
+  auto matrix = at::zeros({rows * cols}, options);
+  matrix.narrow(0, 0, numel).copy_(input);
+  matrix = matrix.view({rows, cols});
+
+  std::vector<at::Tensor> p = {matrix.mm(state.q)};
+  auto work = process_group_->allreduce(p);
+  auto process_group = process_group_;
+  return std::make_shared<CommHookFuture>(
+      std::vector<std::shared_ptr<ProcessGroup::Work>>{std::move(work)},
+      [tensor, input, matrix, p, process_group, numel, &state]() mutable {
+        // The allreduced P spans the column space of the summed gradient.
+        // Orthogonalize it and project the gradient onto it to get Q.
+        auto p_orth = std::get<0>(at::qr(p[0]));
+        std::vector<at::Tensor> q = {matrix.t().mm(p_orth)};
+        process_group->allreduce(q)->wait();
+        state.q = q[0];
+
+        auto approximation =
+            p_orth.mm(q[0].t()).view({-1}).narrow(0, 0, numel);
+        state.residual = input - approximation;
+        tensor.copy_(approximation);
+        return std::vector<at::Tensor>{tensor};
+      });
+}
+
+} // namespace c10d
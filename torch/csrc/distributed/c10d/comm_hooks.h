@@ -0,0 +1,136 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include <ATen/ATen.h>
+#include <c10d/ProcessGroup.hpp>
+
+namespace c10d {
+
+// The flattened gradients of a single bucket, one tensor per model replica.
+// By the time a communication hook sees them they have already been divided
+// by the process group size, so summing them across processes yields the
+// averaged gradient.
+struct GradBucket {
+  size_t index;
+  std::vector<at::Tensor> tensors;
+};
+
+// Handle to the asynchronous reduction started by a communication hook.
+// The Reducer calls `wait` in `finalize_backward` to obtain the reduced
+// bucket tensors (one per model replica).
+class CommHookFuture {
+ public:
+  using Continuation = std::function<std::vector<at::Tensor>()>;
+
+  // A future that has already completed with the specified result.
+  explicit CommHookFuture(std::vector<at::Tensor> result);
+
+  // A future that completes when all `works` have completed. The
+  // continuation then runs on the thread calling `wait` and produces the
+  // result. It may itself launch and wait on further collectives.
+  CommHookFuture(
+      std::vector<std::shared_ptr<ProcessGroup::Work>> works,
+      Continuation then);
+
+  // Blocks until the result is available and returns it. Subsequent calls
+  // return the same result.
+  std::vector<at::Tensor> wait();
+
+ protected:
+  std::vector<std::shared_ptr<ProcessGroup::Work>> works_;
+  Continuation then_;
+  bool completed_;
+  std::vector<at::Tensor> result_;
+};
+
+// A communication hook replaces the allreduce of a bucket's flattened dense
+// gradients. It is called from `mark_bucket_ready` in the order in which
+// buckets are reduced, which is the same on every process, so hooks may
+// issue collectives on the process group. Buckets holding a sparse gradient
+// bypass the hook.
+class CommHookInterface {
+ public:
+  virtual ~CommHookInterface() = default;
+
+  virtual std::shared_ptr<CommHookFuture> runHook(GradBucket& bucket) = 0;
+};
+
+// Casts the bucket to half precision for the allreduce, halving the number
+// of bytes on the wire. Buckets that are not float or double are reduced
+// without compression.
+class FP16CompressHook : public CommHookInterface {
+ public:
+  explicit FP16CompressHook(std::shared_ptr<ProcessGroup> process_group);
+
+  std::shared_ptr<CommHookFuture> runHook(GradBucket& bucket) override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> process_group_;
+};
+
+// Sends only the `ratio` fraction of bucket elements with the largest
+// magnitude, as (value, index) pairs gathered from all processes. The part
+// of the gradient that was not sent is kept per bucket and added to the
+// next iteration's gradient (error feedback), so every update is
+// eventually applied. Only supports a single model replica.
+class TopKCompressHook : public CommHookInterface {
+ public:
+  TopKCompressHook(std::shared_ptr<ProcessGroup> process_group, double ratio);
+
+  std::shared_ptr<CommHookFuture> runHook(GradBucket& bucket) override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> process_group_;
+  double ratio_;
+  std::unordered_map<size_t, at::Tensor> residuals_;
+};
+
+// Reduce-scatters the bucket instead of allreducing it. With S the number of
+// bucket elements divided by the process group size, rounded up, elements
+// [rank * S, (rank + 1) * S) of the result hold their sum across processes,
+// while the other elements keep this process's own gradient. This is the
+// communication of a sharded optimizer, in which every process only updates
+// the elements it owns (see `torch.distributed.optim.ZeroRedundancyOptimizer`).
+// Only supports a single model replica.
+class ReduceScatterHook : public CommHookInterface {
+ public:
+  explicit ReduceScatterHook(std::shared_ptr<ProcessGroup> process_group);
+
+  std::shared_ptr<CommHookFuture> runHook(GradBucket& bucket) override;
+
+ protected:
+  std::shared_ptr<ProcessGroup> process_group_;
+};
+
+// PowerSGD: views the bucket as a (nearly) square matrix M and reduces a
+// rank `matrix_approximation_rank` approximation P * Q^T instead, found by
+// a single step of power iteration warm started from the previous
+// iteration's Q. Two allreduces of O((rows + cols) * rank) elements each
+// replace one allreduce of rows * cols elements. Like TopKCompressHook it
+// uses error feedback and only supports a single model replica.
+class PowerSGDHook : public CommHookInterface {
+ public:
+  PowerSGDHook(
+      std::shared_ptr<ProcessGroup> process_group,
+      int64_t matrix_approximation_rank,
+      uint64_t seed = 0);
+
+  std::shared_ptr<CommHookFuture> runHook(GradBucket& bucket) override;
+
+ protected:
+  struct State {
+    at::Tensor residual;
+    at::Tensor q;
+  };
+
+  std::shared_ptr<ProcessGroup> process_group_;
+  int64_t matrix_approximation_rank_;
+  uint64_t seed_;
+  std::unordered_map<size_t, State> states_;
+};
+
+} // namespace c10d
@@ -16,13 +16,18 @@
 #endif
 
 #include <c10d/PrefixStore.hpp>
+#include <c10d/ProcessGroupHierarchical.hpp>
+#include <c10d/ShardedTCPStore.hpp>
 #include <c10d/TCPStore.hpp>
 #include <pybind11/chrono.h>
+#include <pybind11/functional.h>
 
 #include <torch/csrc/Exceptions.h>
 #include <torch/csrc/distributed/c10d/comm.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 #include <torch/csrc/distributed/c10d/ddp.h>
 #include <torch/csrc/distributed/c10d/reducer.h>
+#include <torch/csrc/utils/memory.h>
 #include <torch/csrc/utils/object_ptr.h>
 #include <torch/csrc/utils/pybind.h>
 
@@ -64,11 +69,15 @@ PyObject* c10d_init(PyObject* _unused) {
               std::vector<std::vector<torch::autograd::Variable>>,
               std::vector<std::vector<size_t>>,
               std::shared_ptr<::c10d::ProcessGroup>,
-              std::vector<std::vector<bool>>>(),
+              std::vector<std::vector<bool>>,
+              int64_t,
+              bool>(),
           py::arg("replicas"),
           py::arg("bucket_indices"),
           py::arg("process_group"),
-          py::arg("expect_sparse_gradients") = std::vector<std::vector<bool>>())
+          py::arg("expect_sparse_gradients") = std::vector<std::vector<bool>>(),
+          py::arg("bucket_bytes_cap") = ::c10d::kDefaultBucketBytesCap,
+          py::arg("gradient_as_bucket_view") = false)
       .def(
           "initialize_buckets",
           &::c10d::Reducer::initialize_buckets,
@@ -82,7 +91,71 @@ PyObject* c10d_init(PyObject* _unused) {
           [](::c10d::Reducer& reducer, const torch::autograd::Variable& output)
               -> void { reducer.prepare_for_backward({output}); },
           py::call_guard<py::gil_scoped_release>())
-      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats);
+      .def("get_backward_stats", &::c10d::Reducer::get_backward_stats)
+      .def(
+          "rebuild_buckets",
+          &::c10d::Reducer::rebuild_buckets,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "autotune_bucket_size",
+          &::c10d::Reducer::autotune_bucket_size,
+          py::arg("candidates"),
+          py::arg("iterations"),
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "use_sparse_allgather",
+          &::c10d::Reducer::use_sparse_allgather,
+          py::arg("density_threshold"),
+          py::call_guard<py::gil_scoped_release>())
+      .def("get_bucket_bytes_cap", &::c10d::Reducer::get_bucket_bytes_cap)
+      .def(
+          "get_bucket_indices",
+          &::c10d::Reducer::get_bucket_indices,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "register_fp16_compress_hook",
+          [](::c10d::Reducer& reducer,
+             std::shared_ptr<::c10d::ProcessGroup> process_group) {
+            reducer.register_comm_hook(
+                torch::make_unique<::c10d::FP16CompressHook>(
+                    std::move(process_group)));
+          },
+          py::arg("process_group"))
+      .def(
+          "register_topk_compress_hook",
+          [](::c10d::Reducer& reducer,
+             std::shared_ptr<::c10d::ProcessGroup> process_group,
+             double ratio) {
+            reducer.register_comm_hook(
+                torch::make_unique<::c10d::TopKCompressHook>(
+                    std::move(process_group), ratio));
+          },
+          py::arg("process_group"),
+          py::arg("ratio"))
+      .def(
+          "register_powersgd_hook",
+          [](::c10d::Reducer& reducer,
+             std::shared_ptr<::c10d::ProcessGroup> process_group,
+             int64_t matrix_approximation_rank,
+             uint64_t seed) {
+            reducer.register_comm_hook(
+                torch::make_unique<::c10d::PowerSGDHook>(
+                    std::move(process_group),
+                    matrix_approximation_rank,
+                    seed));
+          },
+          py::arg("process_group"),
+          py::arg("matrix_approximation_rank"),
+          py::arg("seed") = 0)
+      .def(
+          "register_reduce_scatter_hook",
+          [](::c10d::Reducer& reducer,
+             std::shared_ptr<::c10d::ProcessGroup> process_group) {
+            reducer.register_comm_hook(
+                torch::make_unique<::c10d::ReduceScatterHook>(
+                    std::move(process_group)));
+          },
+          py::arg("process_group"));
 
   py::enum_<::c10d::ReduceOp>(module, "ReduceOp", R"(
 An enum-like class for available reduction operations: ``SUM``, ``PRODUCT``,
@@ -142,6 +215,10 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def_readwrite("reduceOp", &::c10d::ReduceScatterOptions::reduceOp)
       .def_readwrite("timeout", &::c10d::ReduceScatterOptions::timeout);
 
+  py::class_<::c10d::AllToAllOptions>(module, "AllToAllOptions")
+      .def(py::init<>())
+      .def_readwrite("timeout", &::c10d::AllToAllOptions::timeout);
+
   py::class_<::c10d::BarrierOptions>(module, "BarrierOptions")
       .def(py::init<>())
       .def_readwrite("timeout", &::c10d::BarrierOptions::timeout);
@@ -197,6 +274,66 @@ They are used in specifying strategies for reduction collectives, e.g.,
   shared_ptr_class_<::c10d::TCPStore>(module, "TCPStore", store)
       .def(py::init<const std::string&, int, int, bool>());
 
+  shared_ptr_class_<::c10d::ShardedTCPStore>(module, "ShardedTCPStore", store)
+      .def(py::init<const std::string&, int, int, bool>())
+      .def(
+          "multi_set",
+          [](::c10d::ShardedTCPStore& store,
+             const std::vector<std::string>& keys,
+             const std::vector<std::string>& values) {
+            std::vector<std::vector<uint8_t>> values_;
+            for (const auto& value : values) {
+              values_.emplace_back(value.begin(), value.end());
+            }
+            store.multiSet(keys, values_);
+          },
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "multi_get",
+          [](::c10d::ShardedTCPStore& store,
+             const std::vector<std::string>& keys) {
+            std::vector<std::vector<uint8_t>> values;
+            {
+              py::gil_scoped_release release;
+              values = store.multiGet(keys);
+            }
+            std::vector<py::bytes> values_;
+            for (const auto& value : values) {
+              values_.emplace_back(
+                  reinterpret_cast<const char*>(value.data()), value.size());
+            }
+            return values_;
+          })
+      .def(
+          "compare_set",
+          [](::c10d::ShardedTCPStore& store,
+             const std::string& key,
+             const std::string& expected,
+             const std::string& desired) {
+            std::vector<uint8_t> value;
+            {
+              py::gil_scoped_release release;
+              value = store.compareSet(
+                  key,
+                  std::vector<uint8_t>(expected.begin(), expected.end()),
+                  std::vector<uint8_t>(desired.begin(), desired.end()));
+            }
+            return py::bytes(
+                reinterpret_cast<const char*>(value.data()), value.size());
+          })
+      .def(
+          "barrier",
+          [](::c10d::ShardedTCPStore& store,
+             const std::string& key,
+             int worldSize) { store.barrier(key, worldSize); },
+          py::call_guard<py::gil_scoped_release>());
+
+  py::class_<::c10d::ShardedTCPStoreProxy>(module, "ShardedTCPStoreProxy")
+      .def(
+          py::init<const std::string&, int, int>(),
+          py::call_guard<py::gil_scoped_release>())
+      .def_property_readonly("port", &::c10d::ShardedTCPStoreProxy::port);
+
   shared_ptr_class_<::c10d::PrefixStore>(module, "PrefixStore", store)
       .def(py::init<const std::string&, ::c10d::Store&>());
 
@@ -385,6 +522,24 @@ They are used in specifying strategies for reduction collectives, e.g.,
               py::arg("input_tensor"),
               py::call_guard<py::gil_scoped_release>())
 
+          .def(
+              "alltoall_base",
+              &::c10d::ProcessGroup::alltoall_base,
+              py::arg("output_tensor"),
+              py::arg("input_tensor"),
+              py::arg("output_split_sizes"),
+              py::arg("input_split_sizes"),
+              py::arg("opts") = ::c10d::AllToAllOptions(),
+              py::call_guard<py::gil_scoped_release>())
+
+          .def(
+              "alltoall",
+              &::c10d::ProcessGroup::alltoall,
+              py::arg("output_tensors"),
+              py::arg("input_tensors"),
+              py::arg("opts") = ::c10d::AllToAllOptions(),
+              py::call_guard<py::gil_scoped_release>())
+
           .def(
               "send",
               &::c10d::ProcessGroup::send,
@@ -412,6 +567,39 @@ They are used in specifying strategies for reduction collectives, e.g.,
               py::arg("opts") = ::c10d::BarrierOptions(),
               py::call_guard<py::gil_scoped_release>());
 
+  auto processGroupHierarchical =
+      shared_ptr_class_<::c10d::ProcessGroupHierarchical>(
+          module, "ProcessGroupHierarchical", processGroup);
+
+  shared_ptr_class_<::c10d::ProcessGroupHierarchical::Options>(
+      processGroupHierarchical, "Options")
+      .def(py::init<>())
+      .def_readwrite(
+          "hostname", &::c10d::ProcessGroupHierarchical::Options::hostname)
+      .def_readwrite(
+          "use_reduce_scatter",
+          &::c10d::ProcessGroupHierarchical::Options::useReduceScatter);
+
+  // The factory function is only called from the constructor, which runs
+  // with the GIL held, and is not retained afterwards.
+  processGroupHierarchical
+      .def(
+          py::init<
+              const std::shared_ptr<::c10d::Store>&,
+              int,
+              int,
+              ::c10d::ProcessGroupHierarchical::CreateProcessGroupFn,
+              ::c10d::ProcessGroupHierarchical::Options>(),
+          py::arg("store"),
+          py::arg("rank"),
+          py::arg("size"),
+          py::arg("create_process_group"),
+          py::arg("options") = ::c10d::ProcessGroupHierarchical::Options())
+      .def("node_index", &::c10d::ProcessGroupHierarchical::getNodeIndex)
+      .def("num_nodes", &::c10d::ProcessGroupHierarchical::getNumNodes)
+      .def("local_rank", &::c10d::ProcessGroupHierarchical::getLocalRank)
+      .def("local_size", &::c10d::ProcessGroupHierarchical::getLocalSize);
+
 #ifdef USE_C10D_GLOO
   auto processGroupGloo = shared_ptr_class_<::c10d::ProcessGroupGloo>(
       module, "ProcessGroupGloo", processGroup);
@@ -423,7 +611,10 @@ They are used in specifying strategies for reduction collectives, e.g.,
       .def(py::init<>())
       .def_readwrite("devices", &::c10d::ProcessGroupGloo::Options::devices)
       .def_readwrite("timeout", &::c10d::ProcessGroupGloo::Options::timeout)
-      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads);
+      .def_readwrite("threads", &::c10d::ProcessGroupGloo::Options::threads)
+      .def_readwrite(
+          "cuda_pipeline_chunk_bytes",
+          &::c10d::ProcessGroupGloo::Options::cudaPipelineChunkBytes);
 
   processGroupGloo.def_static(
       "create_device",
@@ -493,7 +684,17 @@ They are used in specifying strategies for reduction collectives, e.g.,
           py::arg("rank"),
           py::arg("size"),
           py::arg("timeout") = std::chrono::milliseconds(
-              ::c10d::ProcessGroupNCCL::kProcessGroupNCCLOpTimeoutMillis));
+              ::c10d::ProcessGroupNCCL::kProcessGroupNCCLOpTimeoutMillis))
+      .def(
+          "dump_trace",
+          &::c10d::ProcessGroupNCCL::dumpTrace,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "report_stragglers",
+          &::c10d::ProcessGroupNCCL::reportStragglers,
+          py::arg("timeout") = std::chrono::milliseconds(
+              ::c10d::ProcessGroupNCCL::kProcessGroupNCCLOpTimeoutMillis),
+          py::call_guard<py::gil_scoped_release>());
 #endif
 
 #ifdef USE_C10D_MPI
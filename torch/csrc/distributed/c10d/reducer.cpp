@@ -1,5 +1,6 @@
 #include <torch/csrc/distributed/c10d/reducer.h>
 
+#include <algorithm>
 #include <functional>
 
 #include <c10/util/Exception.h>
@@ -42,7 +43,9 @@ Reducer::Reducer(
     std::vector<std::vector<torch::autograd::Variable>> replicas,
     std::vector<std::vector<size_t>> bucket_indices,
     std::shared_ptr<c10d::ProcessGroup> process_group,
-    std::vector<std::vector<bool>> expect_sparse_gradients)
+    std::vector<std::vector<bool>> expect_sparse_gradients,
+    int64_t bucket_bytes_cap,
+    bool gradient_as_bucket_view)
     : replicas_(std::move(replicas)),
       process_group_(std::move(process_group)),
       expect_sparse_gradients_(std::move(expect_sparse_gradients)),
@@ -50,7 +53,15 @@ Reducer::Reducer(
       require_finalize_(false),
       next_bucket_(0),
       has_marked_unused_parameters_(false),
-      backward_stats_base_(0) {
+      backward_stats_base_(0),
+      bucket_bytes_cap_(bucket_bytes_cap),
+      gradient_as_bucket_view_(gradient_as_bucket_view),
+      has_rebuilt_bucket_(false),
+      autotune_iterations_(0),
+      autotune_index_(0),
+      autotune_measured_(0),
+      autotune_elapsed_(0),
+      last_prepare_time_(0) {
   AT_ASSERTM(replicas_.size() >= 1, "Expected at least one model replica.");
   AT_ASSERTM(replicas_[0].size() >= 1, "Expected at least one parameter.");
 
@@ -191,6 +202,11 @@ void Reducer::mark_variable_ready_dense(VariableIndex index) {
   auto bucket_view = replica.contents.narrow(0, offset, length);
   auto& grad = variable.grad();
   if (grad.defined()) {
+    // With bucket views, the gradient was accumulated in place.
+    if (gradient_as_bucket_view_ &&
+        grad.is_same(replica.bucket_views[bucket_index.intra_bucket_index])) {
+      return;
+    }
     // Ensure that the gradient type matches the bucket type.
     AT_ASSERTM(
         grad.type() == bucket_view.type(),
@@ -199,13 +215,17 @@ void Reducer::mark_variable_ready_dense(VariableIndex index) {
         ", got ",
         grad.type());
     // Assert that the grad tensor and the bucket don't share storage.
-    // If they did, we could avoid the copy altogether.
-    // The reason for not doing this is that existing code calls
-    // `detach_` from `zero_grad`, which is incompatible with views.
+    // Grads that are bucket views were handled above.
     AT_ASSERT(!grad.is_alias_of(bucket_view));
     AT_ASSERT(grad.device() == bucket_view.device());
     AT_ASSERT(grad.numel() == bucket_view.numel());
     bucket_view.copy_(grad.view({-1}), /* non_blocking */ true);
+    // The gradient was undefined before this backward pass, or replaced by
+    // one that isn't accumulated in place (e.g. with `create_graph=True`).
+    // Accumulate into the bucket from now on.
+    if (gradient_as_bucket_view_) {
+      grad = replica.bucket_views[bucket_index.intra_bucket_index];
+    }
   } else {
     bucket_view.zero_();
   }
@@ -270,6 +290,14 @@ void Reducer::mark_variable_ready(VariableIndex index) {
   backward_stats_[replica_index][variable_index] =
       current_time_in_nanos() - backward_stats_base_;
 
+  // Record the order in which gradients are ready until the buckets have
+  // been rebuilt. Only the first backward pass is kept; the order is the
+  // same for all model replicas, so we only look at the first one.
+  if (!has_rebuilt_bucket_ && replica_index == 0 &&
+      rebuilt_param_indices_.size() < replicas_[0].size()) {
+    rebuilt_param_indices_.push_back(variable_index);
+  }
+
   // Any time we mark a variable ready (be it in line due to unused parameters,
   // or via an autograd hook), we require a call to the finalize function. If
   // this doesn't happen before the next iteration (or call to
@@ -365,7 +393,17 @@ void Reducer::mark_bucket_ready(size_t bucket_index) {
       //
       tensors.push_back(replica.contents);
     }
-    bucket.work = process_group_->allreduce(tensors);
+    if (comm_hook_ && !bucket.expect_sparse_gradient) {
+      GradBucket grad_bucket{next_bucket_, std::move(tensors)};
+      bucket.future_work = comm_hook_->runHook(grad_bucket);
+      bucket.work = nullptr;
+    } else if (sparse_allgather_ && bucket.expect_sparse_gradient) {
+      start_sparse_allgather(bucket);
+      bucket.future_work = nullptr;
+    } else {
+      bucket.work = process_group_->allreduce(tensors);
+      bucket.future_work = nullptr;
+    }
   }
 }
 
@@ -459,6 +497,10 @@ void Reducer::initialize_buckets(
         // is not recommended (or sometimes even possible) to mix and match.
         replica.contents = torch::autograd::make_variable(
             at::empty({static_cast<long>(offset)}, options));
+
+        if (gradient_as_bucket_view_) {
+          initialize_bucket_views(replica);
+        }
       }
 
       // Add bucket replica to enclosing bucket.
@@ -482,6 +524,32 @@ void Reducer::initialize_buckets(
   }
 }
 
+void Reducer::initialize_bucket_views(BucketReplica& replica) {
+  // Existing code calls `detach_` from `zero_grad`, which is incompatible
+  // with views. The bucket views are therefore made from the tensor data of
+  // the contents: they share its storage without being autograd views.
+  const auto contents = replica.contents.tensor_data();
+  replica.bucket_views.clear();
+  replica.bucket_views.reserve(replica.variables.size());
+  for (size_t intra_bucket_index = 0;
+       intra_bucket_index < replica.variables.size();
+       intra_bucket_index++) {
+    auto& variable = replica.variables[intra_bucket_index];
+    const auto offset = replica.offsets[intra_bucket_index];
+    const auto length = replica.lengths[intra_bucket_index];
+    replica.bucket_views.push_back(torch::autograd::make_variable(
+        contents.narrow(0, offset, length).view(variable.sizes())));
+
+    // Grads computed before the buckets were (re)built move into them.
+    auto& grad = variable.grad();
+    if (grad.defined() && !grad.is_sparse()) {
+      auto& bucket_view = replica.bucket_views.back();
+      bucket_view.copy_(grad);
+      grad = bucket_view;
+    }
+  }
+}
+
 // Traverse the autograd graph starting at the specified output.
 // All parameters for which we have a pointer to their gradient accumulation
 // functions, but don't show up in the autograd graph will be marked ready for
@@ -522,6 +590,15 @@ void Reducer::prepare_for_backward(
   expect_autograd_hooks_ = true;
   next_bucket_ = 0;
   backward_stats_base_ = current_time_in_nanos();
+
+  // Time the iteration that just finished if we're autotuning and the
+  // current candidate bucket size was in effect for all of it.
+  if (autotune_index_ < autotune_candidates_.size() &&
+      last_prepare_time_ != 0) {
+    autotune_elapsed_ += backward_stats_base_ - last_prepare_time_;
+    autotune_measured_++;
+  }
+  last_prepare_time_ = backward_stats_base_;
   for (auto& bucket : buckets_) {
     for (auto& replica : bucket.replicas) {
       replica.pending = replica.variables.size();
@@ -581,11 +658,17 @@ void Reducer::finalize_bucket_dense(Bucket& bucket) {
          intra_bucket_index < replica.variables.size();
          intra_bucket_index++) {
       auto& variable = replica.variables[intra_bucket_index];
+      auto& grad = variable.grad();
+      // The contents already are the grads, apart from the grads that
+      // weren't defined: those of the parameters that went unused.
+      if (gradient_as_bucket_view_) {
+        grad = replica.bucket_views[intra_bucket_index];
+        continue;
+      }
       const auto offset = replica.offsets[intra_bucket_index];
       const auto length = replica.lengths[intra_bucket_index];
       auto bucket_view =
           replica.contents.narrow(0, offset, length).view(variable.sizes());
-      auto& grad = variable.grad();
       if (!grad.defined()) {
         grad = at::empty(bucket_view.sizes(), bucket_view.options());
       }
@@ -597,6 +680,12 @@ void Reducer::finalize_bucket_dense(Bucket& bucket) {
 // A bucket with a single sparse tensor doesn't need to be unflattened,
 // but merely assigned to the corresponding variable its grad.
 void Reducer::finalize_bucket_sparse(Bucket& bucket) {
+  if (sparse_allgather_) {
+    auto& variable = bucket.replicas.front().variables.front();
+    variable.grad() =
+        torch::autograd::make_variable(finish_sparse_allgather(bucket));
+    return;
+  }
   const auto result = bucket.work->result();
   AT_ASSERT(bucket.replicas.size() == result.size());
   for (size_t i = 0; i < bucket.replicas.size(); i++) {
@@ -609,6 +698,72 @@ void Reducer::finalize_bucket_sparse(Bucket& bucket) {
   }
 }
 
+void Reducer::start_sparse_allgather(Bucket& bucket) {
+  // Duplicate indices are merged before they are sent.
+  auto& contents = bucket.replicas.front().contents;
+  contents = contents.coalesce();
+  const auto options = contents._indices().options();
+  std::vector<at::Tensor> nnz = {at::full({1}, contents._nnz(), options)};
+  bucket.sparse_nnz.clear();
+  for (int i = 0; i < process_group_->getSize(); i++) {
+    bucket.sparse_nnz.push_back(at::empty({1}, options));
+  }
+  std::vector<std::vector<at::Tensor>> outputs = {bucket.sparse_nnz};
+  bucket.work = process_group_->allgather(outputs, nnz);
+}
+
+at::Tensor Reducer::finish_sparse_allgather(Bucket& bucket) {
+  const auto& contents = bucket.replicas.front().contents;
+  const auto nnz = at::cat(bucket.sparse_nnz).cpu();
+  const auto nnz_data = nnz.data_ptr<int64_t>();
+  const auto world_size = nnz.numel();
+  const auto max_nnz = nnz.max().item<int64_t>();
+  const auto total_nnz = nnz.sum().item<int64_t>();
+
+  // Indices gathered from different processes may repeat, so this is an
+  // upper bound of the density of the result. Every process computes the
+  // same one.
+  const int64_t sparse_size =
+      at::prod_intlist(contents.sizes().slice(0, contents.sparse_dim()));
+  if (sparse_size > 0 &&
+      static_cast<double>(total_nnz) / sparse_size > sparse_density_threshold_) {
+    std::vector<at::Tensor> dense = {contents.to_dense()};
+    process_group_->allreduce(dense)->wait();
+    return dense.front().to_sparse(contents.sparse_dim());
+  }
+
+  // Processes allgather tensors of the same size, pad them to the largest.
+  const auto pad = [&](const at::Tensor& tensor, int64_t dim) {
+    auto sizes = tensor.sizes().vec();
+    sizes[dim] = max_nnz;
+    auto padded = at::zeros(sizes, tensor.options());
+    padded.narrow(dim, 0, tensor.size(dim)).copy_(tensor);
+    return padded;
+  };
+  std::vector<at::Tensor> indices = {pad(contents._indices(), 1)};
+  std::vector<at::Tensor> values = {pad(contents._values(), 0)};
+  std::vector<std::vector<at::Tensor>> all_indices(1);
+  std::vector<std::vector<at::Tensor>> all_values(1);
+  for (int64_t i = 0; i < world_size; i++) {
+    all_indices[0].push_back(at::empty_like(indices[0]));
+    all_values[0].push_back(at::empty_like(values[0]));
+  }
+  auto indices_work = process_group_->allgather(all_indices, indices);
+  auto values_work = process_group_->allgather(all_values, values);
+  indices_work->wait();
+  values_work->wait();
+  for (int64_t i = 0; i < world_size; i++) {
+    all_indices[0][i] = all_indices[0][i].narrow(1, 0, nnz_data[i]);
+    all_values[0][i] = all_values[0][i].narrow(0, 0, nnz_data[i]);
+  }
+  return at::_sparse_coo_tensor_unsafe(
+             at::cat(all_indices[0], 1),
+             at::cat(all_values[0], 0),
+             contents.sizes(),
+             contents.options())
+      .coalesce();
+}
+
 void Reducer::finalize_backward() {
   // No longer expect autograd hooks to fire after this function returns.
   AT_ASSERT(expect_autograd_hooks_);
@@ -623,6 +778,20 @@ void Reducer::finalize_backward() {
 
   // Wait for asynchronous reduction to complete and unflatten contents.
   for (auto& bucket : buckets_) {
+    if (bucket.future_work) {
+      const auto result = bucket.future_work->wait();
+      AT_ASSERT(result.size() == bucket.replicas.size());
+      for (size_t i = 0; i < result.size(); i++) {
+        auto& contents = bucket.replicas[i].contents;
+        if (!result[i].is_same(contents)) {
+          contents.copy_(result[i]);
+        }
+      }
+      bucket.future_work = nullptr;
+      finalize_bucket_dense(bucket);
+      continue;
+    }
+
     AT_ASSERT(bucket.work);
     bucket.work->wait();
     if (bucket.expect_sparse_gradient) {
@@ -633,6 +802,209 @@ void Reducer::finalize_backward() {
   }
 }
 
+std::vector<std::vector<size_t>> Reducer::compute_rebuilt_bucket_indices()
+    const {
+  std::vector<at::Tensor> tensors;
+  std::vector<bool> expect_sparse_gradient;
+  tensors.reserve(rebuilt_param_indices_.size());
+  expect_sparse_gradient.reserve(rebuilt_param_indices_.size());
+  for (const auto variable_index : rebuilt_param_indices_) {
+    tensors.push_back(replicas_[0][variable_index]);
+    expect_sparse_gradient.push_back(
+        expect_sparse_gradients_[0][variable_index]);
+  }
+
+  // Like the initial assignment, allow for a single small bucket holding the
+  // gradients that are ready first, so that reduction starts early.
+  const std::vector<size_t> bucket_size_limits = {
+      static_cast<size_t>(
+          std::min(kDefaultFirstBucketBytes, bucket_bytes_cap_)),
+      static_cast<size_t>(bucket_bytes_cap_),
+  };
+  auto bucket_indices = compute_bucket_assignment_by_size(
+      tensors, bucket_size_limits, expect_sparse_gradient);
+
+  // The assignment refers to positions in the ready order. Buckets are
+  // sorted by the earliest gradient they hold, so they are also ready in
+  // consecutive order. Map positions back to variable indices.
+  for (auto& bucket : bucket_indices) {
+    for (auto& index : bucket) {
+      index = rebuilt_param_indices_[index];
+    }
+  }
+  return bucket_indices;
+}
+
+bool Reducer::maybe_advance_autotuning() {
+  if (autotune_index_ >= autotune_candidates_.size()) {
+    return false;
+  }
+
+  // Start measuring the first candidate.
+  if (autotune_results_.empty() &&
+      bucket_bytes_cap_ != autotune_candidates_[autotune_index_]) {
+    bucket_bytes_cap_ = autotune_candidates_[autotune_index_];
+    autotune_measured_ = 0;
+    autotune_elapsed_ = 0;
+    last_prepare_time_ = 0;
+    return true;
+  }
+
+  if (autotune_measured_ < autotune_iterations_) {
+    return false;
+  }
+
+  // Every process must switch bucket sizes at the same time and pick the
+  // same winner, so average the measurement across processes.
+  at::Tensor result = at::full(
+      {1},
+      static_cast<double>(autotune_elapsed_) / autotune_measured_,
+      at::TensorOptions().dtype(at::kDouble));
+  std::vector<at::Tensor> tensors = {
+      result.to(replicas_[0][0].device())};
+  process_group_->allreduce(tensors)->wait();
+  autotune_results_.push_back(
+      tensors[0].cpu().item<double>() / process_group_->getSize());
+
+  autotune_index_++;
+  autotune_measured_ = 0;
+  autotune_elapsed_ = 0;
+  last_prepare_time_ = 0;
+
+  const auto previous_bucket_bytes_cap = bucket_bytes_cap_;
+  if (autotune_index_ < autotune_candidates_.size()) {
+    bucket_bytes_cap_ = autotune_candidates_[autotune_index_];
+  } else {
+    const auto best = std::min_element(
+        autotune_results_.begin(), autotune_results_.end());
+    bucket_bytes_cap_ =
+        autotune_candidates_[best - autotune_results_.begin()];
+  }
+  return bucket_bytes_cap_ != previous_bucket_bytes_cap;
+}
+
+bool Reducer::rebuild_buckets() {
+  std::vector<std::vector<size_t>> bucket_indices;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AT_ASSERTM(
+        !expect_autograd_hooks_,
+        "`rebuild_buckets` must NOT be called during autograd execution.");
+
+    // Nothing to do until a full backward pass has been recorded.
+    const auto variable_count = replicas_[0].size();
+    if (rebuilt_param_indices_.size() < variable_count) {
+      return false;
+    }
+
+    bool changed = false;
+    if (!has_rebuilt_bucket_) {
+      // Gradient ready order may differ between processes, but buckets
+      // must be identical everywhere. Use the order observed by rank 0.
+      at::Tensor order = at::empty(
+          {static_cast<int64_t>(variable_count)},
+          at::TensorOptions().dtype(at::kLong));
+      auto order_accessor = order.accessor<int64_t, 1>();
+      for (size_t i = 0; i < variable_count; i++) {
+        order_accessor[i] = rebuilt_param_indices_[i];
+      }
+      std::vector<at::Tensor> tensors = {order.to(replicas_[0][0].device())};
+      process_group_->broadcast(tensors)->wait();
+      const auto synced_order = tensors[0].cpu();
+      const auto synced_accessor = synced_order.accessor<int64_t, 1>();
+      std::vector<bool> seen(variable_count, false);
+      for (size_t i = 0; i < variable_count; i++) {
+        const auto variable_index = static_cast<size_t>(synced_accessor[i]);
+        AT_ASSERTM(
+            variable_index < variable_count && !seen[variable_index],
+            "Gradient ready order from rank 0 is not a permutation ",
+            "of the model parameters.");
+        seen[variable_index] = true;
+        rebuilt_param_indices_[i] = variable_index;
+      }
+      has_rebuilt_bucket_ = true;
+      changed = true;
+
+      // Iterations timed with the initial buckets don't count.
+      autotune_measured_ = 0;
+      autotune_elapsed_ = 0;
+      last_prepare_time_ = 0;
+    }
+
+    if (maybe_advance_autotuning()) {
+      changed = true;
+    }
+    if (!changed) {
+      return false;
+    }
+    bucket_indices = compute_rebuilt_bucket_indices();
+  }
+
+  initialize_buckets(std::move(bucket_indices));
+  return true;
+}
+
+std::vector<std::vector<size_t>> Reducer::get_bucket_indices() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<std::vector<size_t>> bucket_indices(buckets_.size());
+  for (size_t bucket_index = 0; bucket_index < buckets_.size();
+       bucket_index++) {
+    bucket_indices[bucket_index].resize(
+        buckets_[bucket_index].replicas[0].variables.size());
+  }
+  for (size_t variable_index = 0; variable_index < variable_locators_.size();
+       variable_index++) {
+    const auto& locator = variable_locators_[variable_index];
+    bucket_indices[locator.bucket_index][locator.intra_bucket_index] =
+        variable_index;
+  }
+  return bucket_indices;
+}
+
+void Reducer::register_comm_hook(
+    std::unique_ptr<CommHookInterface> comm_hook) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AT_ASSERTM(
+      !expect_autograd_hooks_,
+      "`register_comm_hook` must NOT be called during autograd execution.");
+  AT_ASSERTM(
+      comm_hook_ == nullptr,
+      "A communication hook can only be registered once.");
+  comm_hook_ = std::move(comm_hook);
+}
+
+void Reducer::use_sparse_allgather(double density_threshold) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AT_ASSERTM(
+      !expect_autograd_hooks_,
+      "`use_sparse_allgather` must NOT be called during autograd execution.");
+  AT_ASSERTM(
+      replicas_.size() == 1,
+      "Sparse gradients can only be allgathered for single-device modules.");
+  AT_ASSERTM(
+      density_threshold >= 0, "The density threshold must not be negative.");
+  sparse_allgather_ = true;
+  sparse_density_threshold_ = density_threshold;
+}
+
+void Reducer::autotune_bucket_size(
+    std::vector<int64_t> candidates,
+    size_t iterations) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  AT_ASSERTM(!candidates.empty(), "Expected at least one bucket size.");
+  AT_ASSERTM(iterations > 0, "Expected a positive number of iterations.");
+  for (const auto candidate : candidates) {
+    AT_ASSERTM(candidate > 0, "Bucket sizes must be positive.");
+  }
+  autotune_candidates_ = std::move(candidates);
+  autotune_results_.clear();
+  autotune_iterations_ = iterations;
+  autotune_index_ = 0;
+  autotune_measured_ = 0;
+  autotune_elapsed_ = 0;
+  last_prepare_time_ = 0;
+}
+
 namespace {
 
 // Tensors may be coalesced into buckets. Buckets must contain tensors of
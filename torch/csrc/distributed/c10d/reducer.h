@@ -10,20 +10,36 @@
 #include <c10d/ProcessGroup.hpp>
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/distributed/c10d/comm_hooks.h>
 
 namespace c10d {
 
+constexpr int64_t kDefaultFirstBucketBytes = 1024 * 1024;
+constexpr int64_t kDefaultBucketBytesCap = 25 * 1024 * 1024;
+
 class Reducer {
  public:
   // The constructor takes a list of variables for every model replica.
   // The bucket assignment for this reducer is specified as a list of
   // buckets, each of which is specified as a list of indices into the
   // variables list for **a single replica** (i.e. `variables[0]`).
+  // The bucket size limit is used when buckets are rebuilt at runtime
+  // (see `rebuild_buckets`).
+  //
+  // If `gradient_as_bucket_view` is set, the grad of every parameter in a
+  // dense bucket is made a view into the flat bucket contents once it is
+  // first computed. From then on, gradient accumulation writes straight into
+  // the tensor that is reduced, and neither is the gradient copied into the
+  // bucket before reduction, nor the result copied back after it. The grads
+  // of a bucket are laid out back to back, in the order returned by
+  // `get_bucket_indices`.
   explicit Reducer(
       std::vector<std::vector<torch::autograd::Variable>> replicas,
       std::vector<std::vector<size_t>> bucket_indices,
       std::shared_ptr<c10d::ProcessGroup> process_group,
-      std::vector<std::vector<bool>> expect_sparse_gradients);
+      std::vector<std::vector<bool>> expect_sparse_gradients,
+      int64_t bucket_bytes_cap = kDefaultBucketBytesCap,
+      bool gradient_as_bucket_view = false);
 
   ~Reducer() noexcept(false);
 
@@ -47,6 +63,57 @@ class Reducer {
     return backward_stats_;
   }
 
+  // The order in which parameters are listed rarely matches the order in
+  // which autograd produces their gradients, so the initial buckets may
+  // wait on each other. The reducer records the order in which gradients
+  // become ready in the first backward pass. Calling this function after
+  // that pass reassigns the buckets to match the recorded order (as seen by
+  // rank 0, so that all processes agree), and, while bucket size
+  // autotuning is active, switches to the next candidate bucket size.
+  //
+  // This is a collective call and must be made by all processes at the same
+  // point, outside of autograd execution (e.g. at the start of `forward`).
+  // Returns true if the bucket assignment was changed.
+  bool rebuild_buckets();
+
+  // Try every bucket size limit in `candidates` for `iterations` iterations
+  // each, and keep the one for which the iteration time (the time between
+  // successive calls to `prepare_for_backward`, averaged over all processes)
+  // was lowest. Because reductions overlap with gradient computation, this
+  // time only grows with the part of communication that is NOT hidden
+  // behind the backward pass, which is what the bucket size trades off:
+  // small buckets start reducing early but pay per-call latency, large
+  // buckets amortize latency but leave more work after the final gradient.
+  // Trials are driven by `rebuild_buckets`.
+  void autotune_bucket_size(std::vector<int64_t> candidates, size_t iterations);
+
+  // Replace the allreduce of dense buckets by the specified communication
+  // hook (see comm_hooks.h), e.g. to compress gradients before they are
+  // sent. Must be called before the first backward pass, and at most once.
+  void register_comm_hook(std::unique_ptr<CommHookInterface> comm_hook);
+
+  // Reduce sparse gradients with an allgather of their coalesced indices and
+  // values, merged by every process, instead of the allreduce of the process
+  // group, which not every backend supports for sparse tensors. The number
+  // of non-zero entries is allgathered first (overlapping with the backward
+  // pass), so that every process can tell the density of the reduced
+  // gradient, i.e. the fraction of its sparse entries that are set, before
+  // the indices are sent. Gradients denser than `density_threshold` are
+  // allreduced as dense tensors instead. The reduced gradients stay sparse
+  // either way. Must be called before the first backward pass, and only
+  // supports single-device modules.
+  void use_sparse_allgather(double density_threshold);
+
+  // Returns the bucket size limit currently used for bucket assignment.
+  int64_t get_bucket_bytes_cap() const {
+    return bucket_bytes_cap_;
+  }
+
+  // Returns the current bucket assignment, in the format taken by
+  // `initialize_buckets`. The variables of a bucket are listed in the order
+  // in which their gradients are laid out in the flattened bucket.
+  std::vector<std::vector<size_t>> get_bucket_indices();
+
  protected:
   // Forward declaration.
   struct Bucket;
@@ -89,8 +156,24 @@ class Reducer {
 
   void finalize_bucket_sparse(Bucket& replica);
 
+  // Coalesces the gradient of a sparse bucket and starts the allgather of
+  // its number of non-zero entries (see `use_sparse_allgather`).
+  void start_sparse_allgather(Bucket& bucket);
+
+  // Gathers and merges the gradients of a sparse bucket whose number of
+  // non-zero entries were allgathered, or allreduces them as dense tensors.
+  at::Tensor finish_sparse_allgather(Bucket& bucket);
+
   void finalize_backward();
 
+  // Computes a bucket assignment for `bucket_bytes_cap_` that follows the
+  // gradient ready order in `rebuilt_param_indices_`.
+  std::vector<std::vector<size_t>> compute_rebuilt_bucket_indices() const;
+
+  // Moves on to the next autotuning candidate once the current one has been
+  // measured for enough iterations. Returns true if the bucket size changed.
+  bool maybe_advance_autotuning();
+
   // A bucket replica represents [1..N] gradients to be reduced,
   // with the same dtype, on the same device.
   //
@@ -115,6 +198,10 @@ class Reducer {
     std::vector<size_t> offsets;
     std::vector<size_t> lengths;
 
+    // Per-variable views into the flat bucket contents tensor, with the sizes
+    // of the variables. Only set if the grads are bucket views.
+    std::vector<at::Tensor> bucket_views;
+
     // Number of tensors to be added before this bucket is complete.
     // This is reset to `variables.size()` every iteration.
     size_t pending;
@@ -140,9 +227,16 @@ class Reducer {
     // Keep work handle around when this set of buckets is being reduced.
     std::shared_ptr<c10d::ProcessGroup::Work> work;
 
+    // Set instead of `work` if the bucket is reduced by a communication hook.
+    std::shared_ptr<CommHookFuture> future_work;
+
     // If this bucket should expect a single sparse gradient.
     // Implies: replicas[i].variables.size() == 1.
     bool expect_sparse_gradient = false;
+
+    // Number of non-zero entries of the sparse gradient in every process,
+    // filled by `work` when sparse gradients are allgathered.
+    std::vector<at::Tensor> sparse_nnz;
   };
 
   std::vector<Bucket> buckets_;
@@ -166,6 +260,41 @@ class Reducer {
   // the point in time buckets were ready, or ideal bucket assignment/ordering.
   int64_t backward_stats_base_;
   std::vector<std::vector<int64_t>> backward_stats_;
+
+  // Optional replacement for the allreduce of dense buckets.
+  std::unique_ptr<CommHookInterface> comm_hook_;
+
+  // Bucket size limit used when computing a new bucket assignment.
+  int64_t bucket_bytes_cap_;
+
+  // Whether the grads of dense buckets are views into their contents.
+  const bool gradient_as_bucket_view_;
+
+  // Whether sparse gradients are allgathered, and the density above which
+  // they are allreduced as dense tensors instead.
+  bool sparse_allgather_ = false;
+  double sparse_density_threshold_ = 1.0;
+
+  // Makes the bucket views of a dense bucket replica, and the grads that are
+  // already defined views, keeping their values.
+  void initialize_bucket_views(BucketReplica& replica);
+
+  // Indices of the variables of the first model replica in the order their
+  // gradients were ready in the first backward pass, and whether buckets
+  // have since been rebuilt to match it.
+  std::vector<size_t> rebuilt_param_indices_;
+  bool has_rebuilt_bucket_;
+
+  // Bucket size autotuning state. The candidate at `autotune_index_` is
+  // used for bucket assignment until it has been timed for
+  // `autotune_iterations_` iterations.
+  std::vector<int64_t> autotune_candidates_;
+  std::vector<double> autotune_results_;
+  size_t autotune_iterations_;
+  size_t autotune_index_;
+  size_t autotune_measured_;
+  int64_t autotune_elapsed_;
+  int64_t last_prepare_time_;
 };
 
 std::vector<std::vector<size_t>> compute_bucket_assignment_by_size(
@@ -11,57 +11,156 @@ namespace rpc {
 
 namespace {
 
-// Write the message into the given ostream
-std::string serialize(const Message& message) {
-  // We cast const void* to void* here because we need to create a tensor using
-  // that memory space. If is fine as that tensor stays function-local, and will
-  // not be modified during its lifetime.
-  auto payload = const_cast<void*>( // NOLINT
-      static_cast<const void*>(message.payload().data()));
-  auto payload_size = message.payload().size();
-
-  // getting tensor table from the message
-  std::vector<torch::Tensor> tensors = message.tensors();
-  // append payload as a tensor
-  tensors.push_back(torch::from_blob(payload, payload_size, {torch::kChar}));
-  // append id and autograd metadata as a tensor
-  tensors.push_back(torch::tensor({message.id()}, {torch::kInt64}));
-
-  // optional: estimate output size, to avoid some unnecessary resizing.
-  static constexpr size_t kBaseOverhead = 2048;
-  static constexpr size_t kPerTensor = 128;
-  size_t estimate = kBaseOverhead;
-  for (const auto& t : tensors) {
-    estimate += t.nbytes() + kPerTensor;
-  }
+// Preamble of every message: rank, payload size, message type, message id,
+// channel and the number of items in the tensor metadata.
+constexpr int64_t kPreambleSize = 6;
+
+// How a tensor travels. Strided, non-quantized tensors are sent as their raw
+// contiguous data; anything else is pickled on its own.
+enum TensorEncoding : int64_t {
+  kRawTensor = 0,
+  kPickledTensor = 1,
+};
+
+struct TensorMeta {
+  TensorEncoding encoding;
+  // raw tensors only
+  at::ScalarType dtype;
+  c10::Device device;
+  bool requiresGrad;
+  std::vector<int64_t> sizes;
+  // pickled tensors only
+  int64_t nbytes;
+};
+
+bool canSendRaw(const torch::Tensor& tensor) {
+  return tensor.layout() == torch::kStrided && !tensor.is_quantized();
+}
 
-  std::string out;
-  out.reserve(estimate);
-  torch::save(tensors, [&](const void* buf, size_t n) -> size_t {
-    out.append(static_cast<const char*>(buf), n);
-    return n;
-  });
-  return out;
+// A kByte tensor over the memory of a contiguous CPU tensor. It does not keep
+// that memory alive, the caller has to.
+torch::Tensor asBytes(const torch::Tensor& tensor) {
+  return torch::from_blob(
+      tensor.data_ptr(), {(int64_t)tensor.nbytes()}, {torch::kByte});
 }
 
-Message deserialize(MessageType type, const void* buf, size_t size) {
-  std::vector<torch::Tensor> tensors;
+// Encodes the metadata of the message's tensors into `meta` and returns the
+// buffers to send for them, in order. Tensors that already are contiguous and
+// on the CPU are sent from their own memory, without any copy.
+std::vector<torch::Tensor> prepareTensors(
+    const Message& message,
+    std::vector<int64_t>& meta,
+    std::vector<std::string>& pickled) {
+  std::vector<torch::Tensor> buffers;
+  pickled.reserve(message.tensors().size());
+  for (const auto& tensor : message.tensors()) {
+    if (!canSendRaw(tensor)) {
+      pickled.emplace_back();
+      std::string& out = pickled.back();
+      torch::save(
+          std::vector<torch::Tensor>{tensor},
+          [&](const void* buf, size_t n) -> size_t {
+            out.append(static_cast<const char*>(buf), n);
+            return n;
+          });
+      meta.push_back(kPickledTensor);
+      meta.push_back(out.size());
+      buffers.push_back(torch::from_blob(
+          (void*)out.data(), {(int64_t)out.size()}, {torch::kByte}));
+      continue;
+    }
+    meta.push_back(kRawTensor);
+    meta.push_back(static_cast<int64_t>(tensor.scalar_type()));
+    meta.push_back(static_cast<int64_t>(tensor.device().type()));
+    meta.push_back(tensor.device().index());
+    meta.push_back(tensor.requires_grad());
+    meta.push_back(tensor.dim());
+    meta.insert(meta.end(), tensor.sizes().begin(), tensor.sizes().end());
+    torch::Tensor data = tensor.to(torch::kCPU).contiguous();
+    if (data.nbytes() > 0) {
+      buffers.push_back(std::move(data));
+    }
+  }
+  return buffers;
+}
 
-  torch::load(tensors, static_cast<const char*>(buf), size);
+std::vector<TensorMeta> parseTensorMeta(const torch::Tensor& tensorMeta) {
+  std::vector<TensorMeta> result;
+  if (!tensorMeta.defined()) {
+    return result;
+  }
+  const int64_t* it = tensorMeta.data_ptr<int64_t>();
+  const int64_t* end = it + tensorMeta.numel();
+  while (it < end) {
+    TensorMeta meta{TensorEncoding(*it++),
+                    at::ScalarType::Undefined,
+                    c10::Device(c10::DeviceType::CPU),
+                    false,
+                    {},
+                    0};
+    if (meta.encoding == kPickledTensor) {
+      meta.nbytes = *it++;
+    } else {
+      TORCH_INTERNAL_ASSERT(meta.encoding == kRawTensor);
+      meta.dtype = static_cast<at::ScalarType>(*it++);
+      auto deviceType = static_cast<c10::DeviceType>(*it++);
+      auto deviceIndex = static_cast<c10::DeviceIndex>(*it++);
+      meta.device = c10::Device(deviceType, deviceIndex);
+      meta.requiresGrad = *it++;
+      int64_t dim = *it++;
+      meta.sizes.assign(it, it + dim);
+      it += dim;
+    }
+    result.push_back(std::move(meta));
+  }
+  TORCH_CHECK(it == end, "Failed to deserialize the tensors of a message.");
+  return result;
+}
 
-  TORCH_CHECK(tensors.size() >= 2, "Failed to deserialize a message.");
-  auto idTensor = std::move(tensors.back());
-  tensors.pop_back();
-  auto payloadTensor = std::move(tensors.back());
-  tensors.pop_back();
+// Allocates the buffers that the tensors of a message will be received into.
+std::vector<torch::Tensor> allocateBuffers(
+    const std::vector<TensorMeta>& metas) {
+  std::vector<torch::Tensor> buffers;
+  buffers.reserve(metas.size());
+  for (const auto& meta : metas) {
+    if (meta.encoding == kPickledTensor) {
+      buffers.push_back(torch::empty({meta.nbytes}, {torch::kByte}));
+    } else {
+      buffers.push_back(torch::empty(meta.sizes, {meta.dtype}));
+    }
+  }
+  return buffers;
+}
 
-  TORCH_INTERNAL_ASSERT(1, idTensor.numel());
-  int64_t id = idTensor.storage().data<int64_t>()[0];
+Message deserialize(RecvWork& work) {
+  const char* data = static_cast<const char*>(work.payload_.storage().data());
+  std::vector<char> payload(data, data + work.payload_.numel());
 
-  const char* data = static_cast<const char*>(payloadTensor.storage().data());
-  std::vector<char> payload(data, data + payloadTensor.numel());
+  auto metas = parseTensorMeta(work.tensorMeta_);
+  TORCH_CHECK(
+      metas.size() == work.buffers_.size(), "Failed to deserialize a message.");
+  std::vector<torch::Tensor> tensors;
+  tensors.reserve(metas.size());
+  for (size_t i = 0; i < metas.size(); ++i) {
+    torch::Tensor& buffer = work.buffers_[i];
+    if (metas[i].encoding == kPickledTensor) {
+      std::vector<torch::Tensor> loaded;
+      torch::load(
+          loaded, static_cast<const char*>(buffer.data_ptr()), metas[i].nbytes);
+      TORCH_CHECK(loaded.size() == 1, "Failed to deserialize a message.");
+      tensors.push_back(std::move(loaded[0]));
+      continue;
+    }
+    torch::Tensor tensor = metas[i].device.is_cpu()
+        ? std::move(buffer)
+        : buffer.to(metas[i].device);
+    if (metas[i].requiresGrad) {
+      tensor.set_requires_grad(true);
+    }
+    tensors.push_back(std::move(tensor));
+  }
 
-  return Message(std::move(payload), std::move(tensors), type, id);
+  return Message(std::move(payload), std::move(tensors), work.type_, work.id_);
 }
 
 } // namespace
@@ -117,7 +216,8 @@ void ProcessGroupAgent::collectNames() {
 ProcessGroupAgent::ProcessGroupAgent(
     std::string workerName,
     std::shared_ptr<c10d::ProcessGroup> pg,
-    int numSendRecvThreads)
+    int numSendRecvThreads,
+    int numChannelsPerPeer)
     : RpcAgent(
           WorkerInfo(std::move(workerName), pg->getRank()),
           c10::guts::make_unique<RequestCallbackImpl>()),
@@ -125,8 +225,15 @@ ProcessGroupAgent::ProcessGroupAgent(
       sendCounts_(pg_->getSize()),
       recvCounts_(pg_->getSize()),
       nextId_(0),
-      sendMutexes_(pg_->getSize()),
+      numChannelsPerPeer_(numChannelsPerPeer),
+      preambleMutexes_(pg_->getSize()),
+      channelMutexes_(pg_->getSize() * numChannelsPerPeer),
+      nextChannel_(0),
       threadPool_(numSendRecvThreads) {
+  TORCH_CHECK(
+      numChannelsPerPeer_ > 0,
+      "ProcessGroupAgent needs at least one channel per peer, but got ",
+      numChannelsPerPeer_);
   collectNames();
   TORCH_CHECK(
       nameMap_.size() > 1,
@@ -300,41 +407,73 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
   // NB: this can be changed to use a native move capture when moved to C++14
   threadPool_.run(std::bind(
       [&](const SendWork& work) {
-        std::string serializedPayload = serialize(work.message_);
-
-        std::vector<torch::Tensor> preamble = {torch::tensor(
-            {(int64_t)pg_->getRank(),
-             (int64_t)serializedPayload.length(),
-             (int64_t)work.message_.type()},
-            {torch::kLong})};
-
-        // ProcessGroup is not thread-safe when sending with the same tag, hence
-        // the lock
-        std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
+        const Message& message = work.message_;
         const auto& dst = work.to_.id_;
 
-        if (work.message_.isShutdown()) {
-          pendingSends.reserve(1);
+        if (message.isShutdown()) {
+          std::vector<torch::Tensor> preamble = {
+              torch::zeros({kPreambleSize}, {torch::kLong})};
+          preamble[0][0] = (int64_t)pg_->getRank();
+          preamble[0][2] = (int64_t)message.type();
+          std::shared_ptr<c10d::ProcessGroup::Work> pendingSend;
           {
-            std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
-            pendingSends.emplace_back(
-                pg_->send(preamble, dst, dst /* channelTag */));
+            std::lock_guard<std::mutex> guard(preambleMutexes_[dst]);
+            pendingSend = pg_->send(preamble, dst, dst /* channelTag */);
           }
-        } else {
-          std::vector<torch::Tensor> payload = {torch::from_blob(
-              (void*)serializedPayload.c_str(),
-              serializedPayload.length(),
-              {torch::kChar})};
-          pendingSends.reserve(2);
+          pendingSend->wait();
+          return;
+        }
+
+        std::vector<int64_t> meta;
+        std::vector<std::string> pickled;
+        std::vector<torch::Tensor> buffers =
+            prepareTensors(message, meta, pickled);
+        int channel = nextChannel_++ % numChannelsPerPeer_;
+
+        std::vector<torch::Tensor> preamble = {
+            torch::tensor({(int64_t)pg_->getRank(),
+                           (int64_t)message.payload().size(),
+                           (int64_t)message.type(),
+                           message.id(),
+                           (int64_t)channel,
+                           (int64_t)meta.size()},
+                          {torch::kLong})};
+
+        std::vector<std::vector<torch::Tensor>> body;
+        body.reserve(buffers.size() + 2);
+        if (!meta.empty()) {
+          body.push_back({torch::from_blob(
+              meta.data(), {(int64_t)meta.size()}, {torch::kInt64})});
+        }
+        if (!message.payload().empty()) {
+          // We cast const void* to void* here because we need to create a
+          // tensor using that memory space. It is fine as that tensor is only
+          // read by the ProcessGroup while the message is alive.
+          auto payload = const_cast<void*>( // NOLINT
+              static_cast<const void*>(message.payload().data()));
+          body.push_back({torch::from_blob(
+              payload, {(int64_t)message.payload().size()}, {torch::kChar})});
+        }
+        for (const auto& buffer : buffers) {
+          body.push_back({asBytes(buffer)});
+        }
 
-          sendCounts_.increment(dst);
+        sendCounts_.increment(dst);
 
+        // See Note [RPC Channels]
+        std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingSends;
+        pendingSends.reserve(body.size() + 1);
+        {
+          std::lock_guard<std::mutex> channelGuard(
+              channelMutexes_[dst * numChannelsPerPeer_ + channel]);
           {
-            std::lock_guard<std::mutex> guard(sendMutexes_[dst]);
+            std::lock_guard<std::mutex> guard(preambleMutexes_[dst]);
             pendingSends.emplace_back(
                 pg_->send(preamble, dst, dst /* channelTag */));
-            pendingSends.emplace_back(
-                pg_->send(payload, dst, dst /* channelTag */));
+          }
+          const int tag = channelTag(dst, channel);
+          for (auto& tensors : body) {
+            pendingSends.emplace_back(pg_->send(tensors, dst, tag));
           }
         }
         for (auto& pendingSend : pendingSends) {
@@ -347,11 +486,18 @@ void ProcessGroupAgent::enqueueSend(SendWork work) {
 void ProcessGroupAgent::enqueueRecv(RecvWork work) {
   threadPool_.run(std::bind(
       [&](RecvWork& work) {
-        torch::Tensor& payload = work.payload_;
-        Message message =
-            deserialize(work.type_, payload.storage().data(), payload.numel());
+        for (auto& pendingRecv : work.pendingRecvs_) {
+          pendingRecv->wait();
+        }
+        Message message = deserialize(work);
         if (message.isRequest()) {
-          send(work.from_, cb_->operator()(message));
+          auto futureResponse = cb_->operator()(message);
+          // Requests processed asynchronously are responded to from whichever
+          // thread completes them, so that they don't hold on to this one.
+          const WorkerInfo from = work.from_;
+          futureResponse->addCallback([this, from](const Message& response) {
+            send(from, Message(response));
+          });
         } else if (message.isResponse()) {
           auto id = message.id();
           std::shared_ptr<FutureMessage> fm = nullptr;
@@ -379,15 +525,20 @@ void ProcessGroupAgent::enqueueRecv(RecvWork work) {
 }
 
 void ProcessGroupAgent::listenLoop() {
+  const int rank = pg_->getRank();
   while (true) {
-    // rank, tensor size, message type
-    std::vector<torch::Tensor> preamble = {torch::empty({3}, {torch::kInt64})};
-    pg_->recvAnysource(preamble, pg_->getRank())->wait();
+    // rank, payload size, message type, message id, channel, metadata size
+    std::vector<torch::Tensor> preamble = {
+        torch::empty({kPreambleSize}, {torch::kInt64})};
+    pg_->recvAnysource(preamble, rank)->wait();
     int64_t* preamble_items = preamble.front().storage().data<int64_t>();
 
     auto srcRank = preamble_items[0];
     auto size = preamble_items[1];
     MessageType type = MessageType(preamble_items[2]);
+    auto id = preamble_items[3];
+    auto channel = preamble_items[4];
+    auto metaSize = preamble_items[5];
 
     if (type == MessageType::SHUTDOWN) {
       // FIXME: This LOG also prints warnings no InitGoogleLogging() was invoked
@@ -398,10 +549,41 @@ void ProcessGroupAgent::listenLoop() {
       return;
     }
 
-    std::vector<torch::Tensor> tensors = {torch::empty({size}, {torch::kChar})};
-    pg_->recv(tensors, srcRank, pg_->getRank())->wait();
+    // The tensor metadata is tiny and needed to allocate the buffers, so it is
+    // waited for here. Everything else is only posted, in the order it was
+    // sent in, and waited for by a worker thread. See Note [RPC Channels]
+    const int tag = channelTag(rank, channel);
+    torch::Tensor tensorMeta;
+    if (metaSize > 0) {
+      std::vector<torch::Tensor> metaTensors = {
+          torch::empty({metaSize}, {torch::kInt64})};
+      pg_->recv(metaTensors, srcRank, tag)->wait();
+      tensorMeta = std::move(metaTensors[0]);
+    }
+    std::vector<torch::Tensor> buffers =
+        allocateBuffers(parseTensorMeta(tensorMeta));
+
+    std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingRecvs;
+    pendingRecvs.reserve(buffers.size() + 1);
+    std::vector<torch::Tensor> payload = {torch::empty({size}, {torch::kChar})};
+    if (size > 0) {
+      pendingRecvs.emplace_back(pg_->recv(payload, srcRank, tag));
+    }
+    for (const auto& buffer : buffers) {
+      if (buffer.nbytes() > 0) {
+        std::vector<torch::Tensor> bytes = {asBytes(buffer)};
+        pendingRecvs.emplace_back(pg_->recv(bytes, srcRank, tag));
+      }
+    }
 
-    enqueueRecv(RecvWork(allWorkerInfo_[srcRank], type, std::move(tensors[0])));
+    enqueueRecv(RecvWork(
+        allWorkerInfo_[srcRank],
+        type,
+        id,
+        std::move(payload[0]),
+        std::move(tensorMeta),
+        std::move(buffers),
+        std::move(pendingRecvs)));
   }
 }
 
@@ -22,15 +22,35 @@ struct SendWork {
   Message message_;
 };
 
-// SendWork wraps a Message and RecvWork wraps a Tensor. The difference here is
-// to allow us to run serialization/deserialization in the worker threads.
+// SendWork wraps a Message and RecvWork wraps the receives that are still in
+// flight for one. The difference here is to allow us to wait for the tensor
+// data and run deserialization in the worker threads, so that the listener
+// thread can move on to the next message while a large one is arriving.
 struct RecvWork {
-  RecvWork(const WorkerInfo& from, MessageType type, torch::Tensor&& payload)
-      : from_(from), type_(type), payload_(payload) {}
+  RecvWork(
+      const WorkerInfo& from,
+      MessageType type,
+      int64_t id,
+      torch::Tensor&& payload,
+      torch::Tensor&& tensorMeta,
+      std::vector<torch::Tensor>&& buffers,
+      std::vector<std::shared_ptr<c10d::ProcessGroup::Work>>&& pendingRecvs)
+      : from_(from),
+        type_(type),
+        id_(id),
+        payload_(payload),
+        tensorMeta_(tensorMeta),
+        buffers_(buffers),
+        pendingRecvs_(pendingRecvs) {}
 
   const WorkerInfo& from_;
   const MessageType type_;
+  const int64_t id_;
   torch::Tensor payload_;
+  // how to turn each of the buffers back into one of the message's tensors
+  torch::Tensor tensorMeta_;
+  std::vector<torch::Tensor> buffers_;
+  std::vector<std::shared_ptr<c10d::ProcessGroup::Work>> pendingRecvs_;
 };
 
 class ProcessGroupAgent : public RpcAgent {
@@ -38,7 +58,8 @@ class ProcessGroupAgent : public RpcAgent {
   ProcessGroupAgent(
       std::string workerName,
       std::shared_ptr<c10d::ProcessGroup> pg,
-      int numSendRecvThreads = 4);
+      int numSendRecvThreads = 4,
+      int numChannelsPerPeer = 2);
 
   const WorkerInfo& getWorkerInfo(const std::string& workerName) const override;
 
@@ -116,9 +137,30 @@ class ProcessGroupAgent : public RpcAgent {
   MessageCounter recvCounts_;
 
   std::atomic<int64_t> nextId_;
-  // one mutex per ProcessGroup rank, as ProcessGroup::send is not thread-safe
-  // when using the same tag.
-  std::vector<std::mutex> sendMutexes_;
+  // Note [RPC Channels]
+  // ~~~~~~~~~~~~~~~~~~~
+  //
+  // A message is a preamble, sent with the destination rank as its tag, and
+  // a body sent over one of numChannelsPerPeer_ channels to that destination,
+  // each using a tag of its own. The body is the metadata of the tensors, the
+  // pickled payload and then the data of every tensor as a separate buffer,
+  // straight out of the tensor's memory.
+  //
+  // ProcessGroup::send is not thread-safe when using the same tag, so there
+  // is one mutex per channel plus one per destination for the preambles.
+  // Holding a channel mutex until the whole body has been posted keeps the
+  // bodies on a channel in the order of their preambles, which is the order
+  // in which the listener posts the receives for them. Messages on
+  // different channels don't wait for each other.
+  int channelTag(int dst, int channel) const {
+    return pg_->getSize() * (channel + 1) + dst;
+  }
+
+  const int numChannelsPerPeer_;
+  std::vector<std::mutex> preambleMutexes_;
+  // numChannelsPerPeer_ mutexes for each destination rank
+  std::vector<std::mutex> channelMutexes_;
+  std::atomic<uint64_t> nextChannel_;
   std::thread listenerThread_;
   // A threadPool that processing both SendWork and RecvWork. There are two
   // motivations for adding a ThreadPool:
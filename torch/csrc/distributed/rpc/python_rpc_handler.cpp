@@ -24,6 +24,7 @@ PythonRpcHandler::PythonRpcHandler() {
   pyRunFunction_ = getFunction(module, "_run_function");
   pyLoadReturnValue_ = getFunction(module, "_load_return_value");
   pySerialize_ = getFunction(module, "serialize");
+  pyPendingResult_ = module.attr("_PendingResult");
 }
 
 void PythonRpcHandler::cleanup() {
@@ -31,6 +32,7 @@ void PythonRpcHandler::cleanup() {
   pyRunFunction_ = py::none();
   pyLoadReturnValue_ = py::none();
   pySerialize_ = py::none();
+  pyPendingResult_ = py::none();
 }
 
 PythonRpcHandler& PythonRpcHandler::getInstance() {
@@ -66,6 +68,40 @@ py::object PythonRpcHandler::runPythonUDF(
       py::bytes(serializedObj.payload_), serializedObj.tensors_);
 }
 
+void PythonRpcHandler::runPythonUDFAsync(
+    const std::vector<char>& pickledPayload,
+    const std::vector<torch::Tensor>& requestTensorTable,
+    UDFCallback done) {
+  AutoGIL ag;
+  runPickledPythonUDFAsync(
+      py::bytes(pickledPayload.data(), pickledPayload.size()),
+      requestTensorTable,
+      std::move(done));
+}
+
+void PythonRpcHandler::runPythonUDFAsync(
+    const SerializedPyObj& serializedObj,
+    UDFCallback done) {
+  AutoGIL ag;
+  runPickledPythonUDFAsync(
+      py::bytes(serializedObj.payload_),
+      serializedObj.tensors_,
+      std::move(done));
+}
+
+void PythonRpcHandler::runPickledPythonUDFAsync(
+    const py::bytes& pickledPayload,
+    const std::vector<torch::Tensor>& requestTensorTable,
+    UDFCallback done) {
+  py::object result = pyRunFunction_(pickledPayload, requestTensorTable);
+  if (!py::isinstance(result, pyPendingResult_)) {
+    done(result);
+    return;
+  }
+  result.attr("add_done_callback")(py::cpp_function(
+      [done](const py::object& value) { done(value); }));
+}
+
 SerializedPyObj PythonRpcHandler::serialize(const py::object& obj) {
   AutoGIL ag;
   py::tuple t = pySerialize_(obj);
@@ -33,6 +33,19 @@ class PYBIND11_EXPORT PythonRpcHandler {
   // Run a pickled Python UDF and return the result py::object
   py::object runPythonUDF(const SerializedPyObj& serializedObj);
 
+  // Run a pickled Python UDF and call `done` with its result, with the GIL
+  // held. Functions wrapped with `torch.distributed.rpc.functions.batch` are
+  // run later, together with other requests for them, so `done` may be called
+  // after this returns, from another thread.
+  using UDFCallback = std::function<void(const py::object&)>;
+  void runPythonUDFAsync(
+      const std::vector<char>& pickledPayload,
+      const std::vector<torch::Tensor>& requestTensorTable,
+      UDFCallback done);
+  void runPythonUDFAsync(
+      const SerializedPyObj& serializedObj,
+      UDFCallback done);
+
   // Serialized a py::object into a string
   SerializedPyObj serialize(const py::object& obj);
 
@@ -63,6 +76,11 @@ class PYBIND11_EXPORT PythonRpcHandler {
   PythonRpcHandler(PythonRpcHandler&&) = delete;
   PythonRpcHandler& operator=(PythonRpcHandler&&) = delete;
 
+  void runPickledPythonUDFAsync(
+      const py::bytes& pickledPayload,
+      const std::vector<torch::Tensor>& requestTensorTable,
+      UDFCallback done);
+
   // Ref to `torch.distributed.rpc.internal._run_function`.
   py::object pyRunFunction_;
 
@@ -71,6 +89,9 @@ class PYBIND11_EXPORT PythonRpcHandler {
 
   // Ref to `torch.distributed.rpc.internal.serialize`.
   py::object pySerialize_;
+
+  // Ref to `torch.distributed.rpc.internal._PendingResult`.
+  py::object pyPendingResult_;
 };
 
 } // namespace rpc
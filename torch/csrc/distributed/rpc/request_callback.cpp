@@ -1,6 +1,7 @@
 #include <torch/csrc/distributed/rpc/request_callback.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_container.h>
 #include <torch/csrc/distributed/autograd/utils.h>
+#include <torch/csrc/distributed/rpc/utils.h>
 
 namespace torch {
 namespace distributed {
@@ -10,16 +11,6 @@ using namespace torch::distributed::autograd;
 
 namespace {
 
-Message createException(const Message& request, const std::exception& e) {
-  const char* err = e.what();
-  std::vector<char> payload(err, err + strlen(err));
-  return Message(
-      std::move(payload),
-      std::vector<torch::Tensor>(),
-      MessageType::EXCEPTION,
-      request.id());
-}
-
 // When request message has autograd info, processMessage() will set up valid
 // current context id properly. This struct is used to clean up current context
 // id after processMessage() is done.
@@ -37,7 +28,8 @@ struct ClearAutogradContextGuard {
 
 } // anonymous namespace
 
-Message RequestCallback::operator()(Message& request) const {
+std::shared_ptr<FutureMessage> RequestCallback::operator()(
+    Message& request) const {
   // For a recv thread, current context id should be invalid outside
   // processMessage().
   ClearAutogradContextGuard guard;
@@ -46,7 +38,9 @@ Message RequestCallback::operator()(Message& request) const {
   } catch (std::exception& e) {
     LOG(ERROR) << "Received error while processing request type "
                << request.type() << ": " << e.what();
-    return createException(request, e);
+    auto futureResponse = std::make_shared<FutureMessage>();
+    futureResponse->markCompleted(createExceptionResponse(e, request.id()));
+    return futureResponse;
   }
 }
 
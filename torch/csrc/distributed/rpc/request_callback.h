@@ -1,5 +1,6 @@
 #pragma once
 
+#include <torch/csrc/distributed/rpc/future_message.h>
 #include <torch/csrc/distributed/rpc/message.h>
 
 namespace torch {
@@ -11,8 +12,9 @@ namespace rpc {
 // implement this interface to perform the actual business logic.
 class TORCH_API RequestCallback {
  public:
-  // Invoke the callback.
-  Message operator()(Message& request) const;
+  // Invoke the callback. The returned future is completed with the response
+  // once the request has been processed, which may happen after this returns.
+  std::shared_ptr<FutureMessage> operator()(Message& request) const;
 
   virtual ~RequestCallback() {}
 
@@ -20,11 +22,13 @@ class TORCH_API RequestCallback {
   // RpcAgent implementation should invoke ``RequestCallback`` to process
   // received requests. There is no restriction on the implementation's
   // threading model. This function takes an rvalue reference of the Message
-  // object. It is expected to return the response message or message
-  // containing an exception. Different rpc agent implementations are expected
-  // to ensure delivery of the response/exception based on their implementation
-  // specific mechanisms.
-  virtual Message processMessage(Message& request) const = 0;
+  // object. It is expected to return a future of the response message or
+  // message containing an exception, and must not block waiting for work
+  // that completes asynchronously. Different rpc agent implementations are
+  // expected to ensure delivery of the response/exception based on their
+  // implementation specific mechanisms once the future completes.
+  virtual std::shared_ptr<FutureMessage> processMessage(
+      Message& request) const = 0;
 };
 
 } // namespace rpc
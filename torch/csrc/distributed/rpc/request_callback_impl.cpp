@@ -1,4 +1,5 @@
 #include <torch/csrc/distributed/rpc/request_callback_impl.h>
+#include <ATen/Parallel.h>
 #include <c10/util/C++17.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_container.h>
 #include <torch/csrc/distributed/autograd/context/dist_autograd_context.h>
@@ -21,6 +22,7 @@
 #include <torch/csrc/distributed/rpc/script_remote_call.h>
 #include <torch/csrc/distributed/rpc/script_resp.h>
 #include <torch/csrc/distributed/rpc/utils.h>
+#include <torch/csrc/utils/auto_gil.h>
 
 namespace torch {
 namespace distributed {
@@ -28,9 +30,108 @@ namespace rpc {
 
 using namespace torch::distributed::autograd;
 
-Message RequestCallbackImpl::processRpc(
+namespace {
+
+std::shared_ptr<FutureMessage> completedFuture(Message message, int64_t id) {
+  message.setId(id);
+  auto future = std::make_shared<FutureMessage>();
+  future->markCompleted(std::move(message));
+  return future;
+}
+
+// Completes `future` with the response `toMessage` makes of the value of
+// `jitFuture` once that is done, or with the error of `jitFuture` or
+// `toMessage`. Lets script functions return a Future as their result (e.g. of
+// an RPC they issued themselves) without blocking an agent thread on it.
+void completeOnValue(
+    c10::intrusive_ptr<c10::ivalue::Future> jitFuture,
+    std::shared_ptr<FutureMessage> future,
+    int64_t id,
+    std::function<Message(IValue)> toMessage) {
+  jitFuture->addCallback([jitFuture, future, id, toMessage]() {
+    // Callbacks run with the lock of jitFuture held, which value() takes too.
+    at::launch([jitFuture, future, id, toMessage]() {
+      Message response;
+      try {
+        response = toMessage(jitFuture->value());
+        response.setId(id);
+      } catch (std::exception& e) {
+        response = createExceptionResponse(e, id);
+      }
+      future->markCompleted(std::move(response));
+    });
+  });
+}
+
+// Returns a future completed with `response` once all of `futures` are, or
+// with the first error among them.
+std::shared_ptr<FutureMessage> whenAllCompleted(
+    const std::vector<std::shared_ptr<FutureMessage>>& futures,
+    Message response,
+    int64_t id) {
+  struct State {
+    std::mutex mutex;
+    size_t remaining;
+    Message response;
+  };
+  auto state = std::make_shared<State>();
+  state->remaining = futures.size();
+  state->response = std::move(response);
+  state->response.setId(id);
+
+  auto future = std::make_shared<FutureMessage>();
+  if (futures.empty()) {
+    future->markCompleted(std::move(state->response));
+    return future;
+  }
+  for (const auto& f : futures) {
+    f->addCallback([state, future, id](const Message& message) {
+      std::unique_lock<std::mutex> lock(state->mutex);
+      if (message.type() == MessageType::EXCEPTION &&
+          state->response.type() != MessageType::EXCEPTION) {
+        state->response = message;
+        state->response.setId(id);
+      }
+      if (--state->remaining == 0) {
+        Message done = std::move(state->response);
+        lock.unlock();
+        future->markCompleted(std::move(done));
+      }
+    });
+  }
+  return future;
+}
+
+// Runs with the autograd context of a FORWARD_AUTOGRAD_REQ as the current
+// one, on threads that may already have another one.
+struct AutogradContextGuard {
+  explicit AutogradContextGuard(int64_t contextId) {
+    auto& container = DistAutogradContainer::getInstance();
+    if (container.hasValidContext()) {
+      prevContextId_ = container.currentContext().contextId();
+      container.clearCurrentContext();
+    }
+    container.setCurrentContextId(contextId);
+  }
+
+  ~AutogradContextGuard() {
+    auto& container = DistAutogradContainer::getInstance();
+    container.clearCurrentContext();
+    if (prevContextId_ != -1) {
+      container.setCurrentContextId(prevContextId_);
+    }
+  }
+
+ private:
+  int64_t prevContextId_ = -1;
+};
+
+} // namespace
+
+std::shared_ptr<FutureMessage> RequestCallbackImpl::processRpc(
     RpcCommandBase& rpc,
-    MessageType messageType) const {
+    MessageType messageType,
+    int64_t id) const {
   // TODO: RpcCommandBase should have an abstract execute() method that we can
   // call here instead of having another switch statement here. Even better we
   // could have abstract classes RpcRequest and RpcResp which inherit from
@@ -52,16 +153,42 @@ Message RequestCallbackImpl::processRpc(
           "size ",
           stack.size());
 
-      return std::move(ScriptResp(std::move(stack.front()))).toMessage();
+      if (!stack.front().isFuture()) {
+        return completedFuture(
+            std::move(ScriptResp(std::move(stack.front()))).toMessage(), id);
+      }
+      auto future = std::make_shared<FutureMessage>();
+      completeOnValue(stack.front().toFuture(), future, id, [](IValue value) {
+        return std::move(ScriptResp(std::move(value))).toMessage();
+      });
+      return future;
     }
     case MessageType::PYTHON_CALL: {
       auto& pyCall = static_cast<PythonUDFCall&>(rpc);
-      std::vector<torch::Tensor> responseTensorTable;
-      auto payload = PythonRpcHandler::getInstance().generatePythonUDFResult(
-          pyCall.pickledPayload(), pyCall.tensors(), responseTensorTable);
-      return std::move(PythonUDFResp(
-                           std::move(payload), std::move(responseTensorTable)))
-          .toMessage();
+      auto future = std::make_shared<FutureMessage>();
+      auto& handler = PythonRpcHandler::getInstance();
+      handler.runPythonUDFAsync(
+          pyCall.pickledPayload(),
+          pyCall.tensors(),
+          [future, id, &handler](const py::object& result) {
+            Message response;
+            try {
+              SerializedPyObj serialized = handler.serialize(result);
+              std::vector<char> payload(
+                  serialized.payload_.begin(), serialized.payload_.end());
+              response = std::move(PythonUDFResp(
+                                       std::move(payload),
+                                       std::move(serialized.tensors_)))
+                             .toMessage();
+              response.setId(id);
+            } catch (std::exception& e) {
+              response = createExceptionResponse(e, id);
+            }
+            // Sending the response doesn't need the GIL.
+            AutoNoGIL no_gil;
+            future->markCompleted(std::move(response));
+          });
+      return future;
     }
     case MessageType::SCRIPT_REMOTE_CALL: {
       auto& src = static_cast<ScriptRemoteCall&>(rpc);
@@ -69,7 +196,6 @@ Message RequestCallbackImpl::processRpc(
 
       auto ownerRRef = ctx.getOrCreateOwnerRRef<IValue>(src.retRRefId());
 
-      // TODO: make this asynchronous
       // src is only alive within this block, use reference to avoid copy
       auto& stack = src.stackRef();
       src.op()->getOperation()(stack);
@@ -80,9 +206,25 @@ Message RequestCallbackImpl::processRpc(
           "size ",
           stack.size());
 
-      ownerRRef->setValue(std::move(stack.front()));
-      ctx.addForkOfOwner(src.retRRefId(), src.retForkId());
-      return std::move(RemoteRet(src.retRRefId(), src.retForkId())).toMessage();
+      auto rrefId = src.retRRefId();
+      auto forkId = src.retForkId();
+      if (!stack.front().isFuture()) {
+        ownerRRef->setValue(std::move(stack.front()));
+        ctx.addForkOfOwner(rrefId, forkId);
+        return completedFuture(
+            std::move(RemoteRet(rrefId, forkId)).toMessage(), id);
+      }
+      auto future = std::make_shared<FutureMessage>();
+      completeOnValue(
+          stack.front().toFuture(),
+          future,
+          id,
+          [ownerRRef, rrefId, forkId](IValue value) {
+            ownerRRef->setValue(std::move(value));
+            RRefContext::getInstance().addForkOfOwner(rrefId, forkId);
+            return std::move(RemoteRet(rrefId, forkId)).toMessage();
+          });
+      return future;
     }
     case MessageType::PYTHON_REMOTE_CALL: {
       auto& prc = static_cast<PythonRemoteCall&>(rpc);
@@ -93,10 +235,23 @@ Message RequestCallbackImpl::processRpc(
 
       auto ownerRRef = ctx.getOrCreateOwnerRRef<py::object>(rrefId);
 
-      ownerRRef->setValue(
-          PythonRpcHandler::getInstance().runPythonUDF(prc.serializedPyObj()));
-      ctx.addForkOfOwner(rrefId, forkId);
-      return std::move(RemoteRet(rrefId, forkId)).toMessage();
+      auto future = std::make_shared<FutureMessage>();
+      PythonRpcHandler::getInstance().runPythonUDFAsync(
+          prc.serializedPyObj(),
+          [future, id, ownerRRef, rrefId, forkId](const py::object& result) {
+            Message response;
+            try {
+              ownerRRef->setValue(py::object(result));
+              RRefContext::getInstance().addForkOfOwner(rrefId, forkId);
+              response = std::move(RemoteRet(rrefId, forkId)).toMessage();
+              response.setId(id);
+            } catch (std::exception& e) {
+              response = createExceptionResponse(e, id);
+            }
+            AutoNoGIL no_gil;
+            future->markCompleted(std::move(response));
+          });
+      return future;
     }
     case MessageType::SCRIPT_RREF_FETCH_CALL: {
       auto& srf = static_cast<ScriptRRefFetchCall&>(rpc);
@@ -104,7 +259,8 @@ Message RequestCallbackImpl::processRpc(
       // TODO: make this asynchronous
       std::shared_ptr<OwnerRRef<IValue>> rref =
           ctx.getOrCreateOwnerRRef<IValue>(srf.rrefId());
-      return std::move(ScriptRRefFetchRet({rref->getValue()})).toMessage();
+      return completedFuture(
+          std::move(ScriptRRefFetchRet({rref->getValue()})).toMessage(), id);
     }
     case MessageType::PYTHON_RREF_FETCH_CALL: {
       auto& prf = static_cast<PythonRRefFetchCall&>(rpc);
@@ -114,25 +270,26 @@ Message RequestCallbackImpl::processRpc(
           ctx.getOrCreateOwnerRRef<py::object>(prf.rrefId());
       SerializedPyObj result =
           PythonRpcHandler::getInstance().serialize(rref->getValue());
-      return std::move(PythonRRefFetchRet(result.toIValues())).toMessage();
+      return completedFuture(
+          std::move(PythonRRefFetchRet(result.toIValues())).toMessage(), id);
     }
     case MessageType::RREF_USER_DELETE: {
       auto& rud = static_cast<RRefUserDelete&>(rpc);
       auto& ctx = RRefContext::getInstance();
       ctx.delForkOfOwner(rud.rrefId(), rud.forkId());
-      return std::move(RRefAck()).toMessage();
+      return completedFuture(std::move(RRefAck()).toMessage(), id);
     }
     case MessageType::RREF_CHILD_ACCEPT: {
       auto& rca = static_cast<RRefChildAccept&>(rpc);
       auto& ctx = RRefContext::getInstance();
       ctx.delPendingChild(rca.forkId());
-      return std::move(RRefAck()).toMessage();
+      return completedFuture(std::move(RRefAck()).toMessage(), id);
     }
     case MessageType::RREF_FORK_REQUEST: {
       auto& rfr = static_cast<RRefForkRequest&>(rpc);
       auto& ctx = RRefContext::getInstance();
       ctx.addForkOfOwner(rfr.rrefId(), rfr.forkId());
-      return std::move(RRefAck()).toMessage();
+      return completedFuture(std::move(RRefAck()).toMessage(), id);
     }
     case MessageType::FORWARD_AUTOGRAD_REQ: {
       auto& rpcWithAutograd = static_cast<RpcWithAutograd&>(rpc);
@@ -155,36 +312,54 @@ Message RequestCallbackImpl::processRpc(
 
       // Process the original RPC.
       auto wrappedMessageType = rpcWithAutograd.wrappedMessageType();
-      auto wrappedRpcResponse =
-          processRpc(rpcWithAutograd.wrappedRpc(), wrappedMessageType);
+      auto wrappedRpcResponse = processRpc(
+          rpcWithAutograd.wrappedRpc(), wrappedMessageType, id);
 
-      return getMessageWithAutograd(
-          rpcWithAutograd.fromWorkerId(),
-          std::move(wrappedRpcResponse),
-          MessageType::FORWARD_AUTOGRAD_RESP);
+      auto future = std::make_shared<FutureMessage>();
+      auto fromWorkerId = rpcWithAutograd.fromWorkerId();
+      auto contextId = autogradContext->contextId();
+      wrappedRpcResponse->addCallback(
+          [future, fromWorkerId, contextId, id](const Message& response) {
+            Message responseWithAutograd;
+            try {
+              AutogradContextGuard contextGuard(contextId);
+              responseWithAutograd = getMessageWithAutograd(
+                  fromWorkerId,
+                  Message(response),
+                  MessageType::FORWARD_AUTOGRAD_RESP);
+              responseWithAutograd.setId(id);
+            } catch (std::exception& e) {
+              responseWithAutograd = createExceptionResponse(e, id);
+            }
+            future->markCompleted(std::move(responseWithAutograd));
+          });
+      return future;
     }
     case MessageType::BACKWARD_AUTOGRAD_REQ: {
       auto& gradientsCall = static_cast<PropagateGradientsReq&>(rpc);
-      const auto& autogradMetadata = gradientsCall.getAutogradMetadata();
 
       // Retrieve the appropriate autograd context.
       auto& autogradContext =
           DistAutogradContainer::getInstance().retrieveContext(
-              autogradMetadata.autogradContextId);
+              gradientsCall.getAutogradContextId());
 
-      // Lookup the appropriate 'send' function to enqueue.
-      std::shared_ptr<SendRpcBackward> sendFunction =
-          autogradContext.retrieveSendFunction(
-              autogradMetadata.autogradMessageId);
+      // The request may carry the gradients of several 'send' functions.
+      std::vector<std::shared_ptr<FutureMessage>> futures;
+      for (const auto& entry : gradientsCall.getEntries()) {
+        // Lookup the appropriate 'send' function to enqueue.
+        std::shared_ptr<SendRpcBackward> sendFunction =
+            autogradContext.retrieveSendFunction(entry.autogradMessageId);
 
-      // Attach the gradients to the send function.
-      sendFunction->setGrads(gradientsCall.getGrads());
+        // Attach the gradients to the send function.
+        sendFunction->setGrads(entry.grads);
 
-      // Now execute the autograd graph using the "distributed engine."
-      DistEngine::getInstance().executeSendFunction(
-          autogradContext, sendFunction);
+        // Now execute the autograd graph using the "distributed engine."
+        futures.push_back(DistEngine::getInstance().executeSendFunction(
+            autogradContext, sendFunction));
+      }
 
-      return std::move(PropagateGradientsResp()).toMessage();
+      return whenAllCompleted(
+          futures, std::move(PropagateGradientsResp()).toMessage(), id);
     }
     case MessageType::CLEANUP_AUTOGRAD_CONTEXT_REQ: {
       auto& cleanupContextReq = static_cast<CleanupAutogradContextReq&>(rpc);
@@ -195,7 +370,8 @@ Message RequestCallbackImpl::processRpc(
       // to clean up their context.
       DistAutogradContainer::getInstance().releaseContextIfPresent(
           cleanupContextId);
-      return std::move(CleanupAutogradContextResp()).toMessage();
+      return completedFuture(
+          std::move(CleanupAutogradContextResp()).toMessage(), id);
     }
     default: {
       TORCH_INTERNAL_ASSERT(
@@ -204,11 +380,10 @@ Message RequestCallbackImpl::processRpc(
   }
 }
 
-Message RequestCallbackImpl::processMessage(Message& request) const {
+std::shared_ptr<FutureMessage> RequestCallbackImpl::processMessage(
+    Message& request) const {
   std::unique_ptr<RpcCommandBase> rpc = deserializeRequest(request);
-  auto responseMessage = processRpc(*rpc, request.type());
-  responseMessage.setId(request.id());
-  return responseMessage;
+  return processRpc(*rpc, request.type(), request.id());
 }
 
 } // namespace rpc
@@ -10,10 +10,15 @@ namespace rpc {
 
 class TORCH_API RequestCallbackImpl : public RequestCallback {
  public:
-  Message processMessage(Message& request) const override;
+  std::shared_ptr<FutureMessage> processMessage(
+      Message& request) const override;
 
  private:
-  Message processRpc(RpcCommandBase& rpc, MessageType messageType) const;
+  // Processes `rpc` and returns a future of the response to request `id`.
+  std::shared_ptr<FutureMessage> processRpc(
+      RpcCommandBase& rpc,
+      MessageType messageType,
+      int64_t id) const;
 };
 
 } // namespace rpc
@@ -15,6 +15,16 @@ namespace torch {
 namespace distributed {
 namespace rpc {
 
+Message createExceptionResponse(const std::exception& e, int64_t id) {
+  const char* err = e.what();
+  std::vector<char> payload(err, err + strlen(err));
+  return Message(
+      std::move(payload),
+      std::vector<torch::Tensor>(),
+      MessageType::EXCEPTION,
+      id);
+}
+
 std::unique_ptr<RpcCommandBase> deserializeRequest(const Message& request) {
   switch (request.type()) {
     case MessageType::SCRIPT_CALL: {
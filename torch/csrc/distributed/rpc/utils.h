@@ -16,6 +16,10 @@ TORCH_API std::unique_ptr<RpcCommandBase> deserializeRequest(
 TORCH_API std::unique_ptr<RpcCommandBase> deserializeResponse(
     const Message& response);
 
+// Creates the EXCEPTION message sent back in place of the response to request
+// `id` when processing it failed with `e`.
+TORCH_API Message createExceptionResponse(const std::exception& e, int64_t id);
+
 } // namespace rpc
 } // namespace distributed
 } // namespace torch
@@ -15,6 +15,9 @@ static PyObject * THPStorage_(sharedDecref)(THPStorage *self, PyObject *noargs)
   if (ctx) {
     ctx->decref();
   }
+#ifndef _WIN32
+  THSharedArena::decref(storage->data_ptr());
+#endif
 #endif
   Py_INCREF(self);
   return (PyObject *)self;
@@ -30,6 +33,9 @@ static PyObject * THPStorage_(sharedIncref)(THPStorage *self, PyObject *noargs)
   if (ctx) {
     ctx->incref();
   }
+#ifndef _WIN32
+  THSharedArena::incref(storage->data_ptr());
+#endif
 #endif
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
@@ -128,6 +134,97 @@ static PyObject * THPStorage_(newSharedFilename)(PyObject *_unused, PyObject *ar
   END_HANDLE_TH_ERRORS
 }
 
+#ifndef _WIN32
+static THWStorage* THPStorage_(newArenaStorage)(ptrdiff_t size)
+{
+  return THWStorage_(newWithDataAndAllocator)(
+      THSharedArena::allocate(size * sizeof(scalar_t)), size, /* allocator */ nullptr);
+}
+
+static PyObject * THPStorage_(pyNewArenaStorage)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  long long size;
+  if (!PyArg_ParseTuple(args, "L", &size)) {
+    return nullptr;
+  }
+  return THPStorage_(New)(THPStorage_(newArenaStorage)(size));
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(shareArena)(THPStorage *self, PyObject *noargs)
+{
+  HANDLE_TH_ERRORS
+  THWStorage *storage = self->cdata;
+  std::string manager_handle;
+  std::string segment_handle;
+  size_t segment_size;
+  size_t offset;
+  // Storage is already in an arena, just return its location
+  if (!THSharedArena::describe(storage->data_ptr(), &manager_handle, &segment_handle, &segment_size, &offset)) {
+    THWStoragePtr new_storage(THPStorage_(newArenaStorage)(storage->numel()));
+    THWStorage_(copy)(new_storage, storage);
+    THWStorage_(swap)(storage, new_storage);
+    bool in_arena = THSharedArena::describe(
+        storage->data_ptr(), &manager_handle, &segment_handle, &segment_size, &offset);
+    AT_ASSERT(in_arena);
+  }
+
+  THPObjectPtr _manager_handle(PyBytes_FromString(manager_handle.c_str()));
+  if (!_manager_handle) return nullptr;
+  THPObjectPtr _segment_handle(PyBytes_FromString(segment_handle.c_str()));
+  if (!_segment_handle) return nullptr;
+  THPObjectPtr _segment_size(PyLong_FromSize_t(segment_size));
+  if (!_segment_size) return nullptr;
+  THPObjectPtr _offset(PyLong_FromSize_t(offset));
+  if (!_offset) return nullptr;
+  THPObjectPtr size(PyLong_FromLong(storage->numel()));
+  if (!size) return nullptr;
+
+  THPObjectPtr tuple(PyTuple_New(5));
+  if (!tuple) return nullptr;
+  PyTuple_SET_ITEM(tuple.get(), 0, _manager_handle.release());
+  PyTuple_SET_ITEM(tuple.get(), 1, _segment_handle.release());
+  PyTuple_SET_ITEM(tuple.get(), 2, _segment_size.release());
+  // Offset(in bytes) of the data of the storage in the segment
+  PyTuple_SET_ITEM(tuple.get(), 3, _offset.release());
+  PyTuple_SET_ITEM(tuple.get(), 4, size.release());
+  return tuple.release();
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(newSharedArena)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyTuple_GET_SIZE(args) == 5, "tuple of 5 items expected");
+  PyObject *_manager_handle = PyTuple_GET_ITEM(args, 0);
+  PyObject *_segment_handle = PyTuple_GET_ITEM(args, 1);
+  PyObject *_segment_size = PyTuple_GET_ITEM(args, 2);
+  PyObject *_offset = PyTuple_GET_ITEM(args, 3);
+  PyObject *_size = PyTuple_GET_ITEM(args, 4);
+  if (!PyBytes_Check(_manager_handle) || !PyBytes_Check(_segment_handle) ||
+      !THPUtils_checkLong(_segment_size) || !THPUtils_checkLong(_offset) || !THPUtils_checkLong(_size)) {
+    THPUtils_invalidArguments(args, nullptr, "_new_shared in shared arena mode", 1,
+        "(bytes manager_handle, bytes segment_handle, int segment_size, int offset_bytes, int size)");
+    return nullptr;
+  }
+  const char *manager_handle = PyBytes_AS_STRING(_manager_handle);
+  const char *segment_handle = PyBytes_AS_STRING(_segment_handle);
+  size_t segment_size = (size_t)THPUtils_unpackLong(_segment_size);
+  size_t offset = (size_t)THPUtils_unpackLong(_offset);
+  int64_t size = THPUtils_unpackLong(_size);
+  THPUtils_assert(offset + size * sizeof(scalar_t) <= segment_size,
+      "storage of %lld bytes at offset %lld is out of its shared memory segment",
+      (long long)(size * sizeof(scalar_t)), (long long)offset);
+  return THPStorage_(New)(
+          THWStorage_(newWithDataAndAllocator)(
+            THSharedArena::receive(manager_handle, segment_handle, segment_size, offset),
+            size,
+            /* allocator */ nullptr));
+  END_HANDLE_TH_ERRORS
+}
+#endif
+
 static THWStorage* THPStorage_(newFdStorage)(ptrdiff_t size)
 {
   int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM |
@@ -237,14 +334,13 @@ static PyObject * THPStorage_(shareCuda)(THPStorage *self, PyObject *noargs)
   THPObjectPtr _event_sync_required(Py_None);
   Py_INCREF(Py_None);
   if (THWStorage_(data)(LIBRARY_STATE storage)) {
-    size_t base_size;
-    void *base_ptr = c10::cuda::CUDACachingAllocator::getBaseAllocation(THWStorage_(data)(LIBRARY_STATE storage), &base_size);
-    ptrdiff_t offset_bytes = (char*)storage->data<scalar_t>() - (char*)base_ptr;
-
-    cudaIpcMemHandle_t handle;
-    THCudaCheck(cudaIpcGetMemHandle(&handle, base_ptr));
+    // The handle of the segment containing the storage is only computed the
+    // first time one of its storages is shared.
+    size_t offset_bytes;
+    std::string handle = c10::cuda::CUDACachingAllocator::getIpcMemHandle(
+        THWStorage_(data)(LIBRARY_STATE storage), &offset_bytes);
 
-    _handle = PyBytes_FromStringAndSize((char *)&handle, CUDA_IPC_HANDLE_SIZE);
+    _handle = PyBytes_FromStringAndSize(handle.data(), CUDA_IPC_HANDLE_SIZE);
     _offset_bytes = PyLong_FromSsize_t((Py_ssize_t)offset_bytes);
 
     // Put Storage Data behind new ref counting context
@@ -312,6 +408,10 @@ static PyObject * THPStorage_(releaseIPCCounter)(PyObject *_unused, PyObject *ar
   std::string ref_counter_handle = PyBytes_AS_STRING(_ref_counter);
   ptrdiff_t ref_counter_offset =
       (ptrdiff_t)THPUtils_unpackLong(_ref_counter_offset);
+  if (torch::CudaIPCPoolingEnabled()) {
+    torch::CudaIPCReleaseCounter(ref_counter_handle, ref_counter_offset);
+    Py_RETURN_NONE;
+  }
   // We don't want to break existing code, so resource deletion is best
   // effort basis. Exception expected if producer process terminated
   // before consumer released data.
@@ -372,6 +472,10 @@ static PyObject * THPStorage_(newSharedCuda)(PyObject *_unused, PyObject *args)
 
   int64_t device = THPUtils_unpackLong(_device);
   at::cuda::CUDAGuard device_guard(device);
+  const bool pooling = torch::CudaIPCPoolingEnabled();
+  if (pooling) {
+    torch::CudaIPCFlushReleases(/*wait=*/false);
+  }
 
 #ifndef __HIP_PLATFORM_HCC__
   if (PyObject_IsTrue(_event_sync_required)) {
@@ -390,7 +494,9 @@ static PyObject * THPStorage_(newSharedCuda)(PyObject *_unused, PyObject *args)
 #endif
 
   std::string s_handle = THPStorage_(bytesAsHandleString)(_handle);
-  std::shared_ptr<void> basePtr = c10::cuda::CUDACachingAllocator::getIpcDevPtr(s_handle);
+  std::shared_ptr<void> basePtr = pooling
+      ? torch::CudaIPCGetRetainedSegment(s_handle)
+      : c10::cuda::CUDACachingAllocator::getIpcDevPtr(s_handle);
 
   // Offset the basePtr to reconstruct the real storage
   // devPtr = basePtr + storage_offset
@@ -402,8 +508,14 @@ static PyObject * THPStorage_(newSharedCuda)(PyObject *_unused, PyObject *args)
 
   auto c = new torch::CudaIPCReceivedData(std::move(basePtr));
   auto sp = std::shared_ptr<void>(
-      (void*)c, [ref_counter_handle, ref_counter_offset, device](void* ptr) {
+      (void*)c, [ref_counter_handle, ref_counter_offset, device, pooling](void* ptr) {
         delete static_cast<torch::CudaIPCReceivedData*>(ptr);
+        if (pooling) {
+          // See Note [CUDA IPC pooled mode]
+          torch::CudaIPCReleaseCounterAfterStream(
+              ref_counter_handle, ref_counter_offset, device);
+          return;
+        }
         // Sync default stream to make sure all operations related to the storage is
         // finished (otherwise another process may reuse memory and corrupt
         // data)
@@ -518,9 +630,17 @@ PyObject * THPStorage_(isShared)(THPStorage *self, PyObject *noargs)
   if (THMapAllocator::fromDataPtr(self->cdata->data_ptr()) ||
       THManagedMapAllocator::fromDataPtr(self->cdata->data_ptr())) {
     Py_RETURN_TRUE;
-  } else {
-    Py_RETURN_FALSE;
   }
+#ifndef _WIN32
+  std::string manager_handle;
+  std::string segment_handle;
+  size_t segment_size;
+  size_t offset;
+  if (THSharedArena::describe(self->cdata->data_ptr(), &manager_handle, &segment_handle, &segment_size, &offset)) {
+    Py_RETURN_TRUE;
+  }
+#endif
+  Py_RETURN_FALSE;
 #endif
 }
 
@@ -537,6 +657,11 @@ static PyMethodDef THPStorage_(sharingMethods)[] = {
   {"_share_filename_", (PyCFunction)THPStorage_(shareFilename), METH_NOARGS, nullptr},
   {"_new_shared_filename", (PyCFunction)(void(*)(void))THPStorage_(newSharedFilename), METH_VARARGS | METH_STATIC, nullptr},
   {"_new_using_filename", (PyCFunction)(void(*)(void))THPStorage_(pyNewFilenameStorage), METH_VARARGS | METH_STATIC, nullptr},
+#ifndef _WIN32
+  {"_share_arena_", (PyCFunction)THPStorage_(shareArena), METH_NOARGS, nullptr},
+  {"_new_shared_arena", (PyCFunction)(void(*)(void))THPStorage_(newSharedArena), METH_VARARGS | METH_STATIC, nullptr},
+  {"_new_using_arena", (PyCFunction)(void(*)(void))THPStorage_(pyNewArenaStorage), METH_VARARGS | METH_STATIC, nullptr},
+#endif
 #endif
   {"_weak_ref", (PyCFunction)THPStorage_(weakRef), METH_NOARGS, nullptr},
   {"_free_weak_ref", (PyCFunction)(void(*)(void))THPStorage_(freeWeakRef), METH_O | METH_STATIC, nullptr},
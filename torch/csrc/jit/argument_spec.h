@@ -80,7 +80,10 @@ struct ArgumentSpec {
   }
 
   void addOptional(const IValue& input) {
-    bool is_present = !input.isNone();
+    addOptionalPresence(!input.isNone());
+  }
+
+  void addOptionalPresence(bool is_present) {
     optional_presence.push_back(is_present);
     hash_code = hash_combine(hash_code, is_present);
   }
@@ -108,6 +111,26 @@ struct ArgumentSpec {
     combineHash(arg);
   }
 
+  // Adds a tensor with the given properties, e.g. to restore a serialized
+  // spec. The properties of undefined tensors are ignored.
+  void addTensorInfo(
+      bool defined,
+      bool requires_grad,
+      int dim,
+      int device,
+      at::ScalarType type) {
+    tensor_args.emplace_back();
+    auto& arg = tensor_args.back();
+    std::memset(&arg, 0, sizeof(ArgumentInfo));
+    if ((arg.defined_ = defined)) {
+      arg.requires_grad_ = requires_grad;
+      arg.dim_ = dim;
+      arg.device_ = device;
+      arg.type_ = static_cast<unsigned>(type);
+    }
+    combineHash(arg);
+  }
+
   void combineHash(const ArgumentInfo& arg) {
     ArgumentInfo::plain_data_type arg_data;
     std::memcpy(&arg_data, &arg, sizeof(ArgumentInfo));
@@ -11,8 +11,10 @@
 #include <torch/csrc/jit/script/compiler.h>
 #include <torch/csrc/jit/symbolic_script.h>
 #include <c10/util/Exception.h>
+#include <c10/util/Metrics.h>
 
 #include <algorithm>
+#include <limits>
 #include <memory>
 
 namespace torch {
@@ -607,6 +609,182 @@ static void deduplicateSizeCaptures(
   }
 }
 
+static std::atomic<int64_t> autodiff_recompute_budget{-1};
+
+std::atomic<int64_t>& getAutodiffRecomputeBudget() {
+  return autodiff_recompute_budget;
+}
+
+static c10::metrics::Counter recomputed_bytes_counter(
+    "torch_jit_autodiff_recomputed_bytes_total",
+    "Bytes of intermediates backward graphs recompute instead of capturing them");
+static c10::metrics::Counter recompute_flops_counter(
+    "torch_jit_autodiff_recompute_flops_total",
+    "Elementwise operations added to backward graphs to recompute intermediates");
+
+// The operations per element of recomputing the output of `n`, if it's a
+// cheap elementwise op
+static c10::optional<int64_t> recomputeCostPerElement(const Node* n) {
+  static OperatorSet arithmetic_ops = {
+      "aten::relu(Tensor self) -> Tensor",
+      "aten::neg(Tensor self) -> Tensor",
+      "aten::add(Tensor self, Tensor other, *, Scalar alpha) -> Tensor",
+      "aten::add(Tensor self, Scalar other, Scalar alpha) -> Tensor",
+      "aten::sub(Tensor self, Tensor other, *, Scalar alpha) -> Tensor",
+      "aten::sub(Tensor self, Scalar other, Scalar alpha) -> Tensor",
+      "aten::mul(Tensor self, Tensor other) -> Tensor",
+      "aten::mul(Tensor self, Scalar other) -> Tensor",
+      "aten::div(Tensor self, Tensor other) -> Tensor",
+      "aten::div(Tensor self, Scalar other) -> Tensor",
+  };
+  // counted as a handful of arithmetic operations each
+  static OperatorSet transcendental_ops = {
+      "aten::sigmoid(Tensor self) -> Tensor",
+      "aten::tanh(Tensor self) -> Tensor",
+      "aten::exp(Tensor self) -> Tensor",
+      "aten::log(Tensor self) -> Tensor",
+      "aten::gelu(Tensor self) -> Tensor",
+  };
+  if (arithmetic_ops.find(n)) {
+    return 1;
+  }
+  if (transcendental_ops.find(n)) {
+    return 8;
+  }
+  return c10::nullopt;
+}
+
+static c10::optional<int64_t> tensorNumel(const Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || !type->numel()) {
+    return c10::nullopt;
+  }
+  return static_cast<int64_t>(*type->numel());
+}
+
+static int64_t tensorBytes(const Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  auto numel = tensorNumel(v);
+  if (!numel || !type->scalarType()) {
+    return 0;
+  }
+  return *numel * static_cast<int64_t>(elementSize(*type->scalarType()));
+}
+
+// Recomputes the intermediates captured for the reverse block that are the
+// outputs of cheap elementwise ops of captured values, until the bytes of
+// the captured intermediates fit in getAutodiffRecomputeBudget(). As the
+// inputs are captured anyway, recomputation only removes captures.
+static void recomputeCheapCaptures(
+    Gradient& grad_desc,
+    ReverseDetails& rev_info) {
+  const int64_t budget = getAutodiffRecomputeBudget().load();
+  if (budget < 0) {
+    return;
+  }
+  auto& graph = *grad_desc.f;
+  Block* primal_block = graph.block();
+  Block* reverse_block = rev_info.reverse_block;
+  const auto captures = getReverseCaptures(grad_desc);
+  const value_set captured(captures.begin(), captures.end());
+  const value_set primal_inputs(graph.inputs().begin(), graph.inputs().end());
+  const value_set primal_outputs(graph.outputs().begin(), graph.outputs().end());
+
+  struct Candidate {
+    Value* value;
+    int64_t bytes;
+    int64_t flops;
+  };
+  std::vector<Candidate> candidates;
+  int64_t captured_bytes = 0;
+  for (Value* capture : captures) {
+    // inputs and outputs are kept alive anyway
+    if (primal_inputs.count(capture) || primal_outputs.count(capture)) {
+      continue;
+    }
+    const int64_t bytes = tensorBytes(capture);
+    captured_bytes += bytes;
+    Node* n = capture->node();
+    const auto cost = recomputeCostPerElement(n);
+    if (!cost || n->owningBlock() != primal_block) {
+      continue;
+    }
+    const bool inputs_captured =
+        std::all_of(n->inputs().begin(), n->inputs().end(), [&](Value* v) {
+          return captured.count(v) || v->node()->kind() == prim::Constant;
+        });
+    if (inputs_captured) {
+      candidates.push_back(
+          {capture, bytes, tensorNumel(capture).value_or(0) * *cost});
+    }
+  }
+
+  // Cheapest per byte saved first, those of unknown sizes last
+  const auto flops_per_byte = [](const Candidate& c) {
+    return c.bytes > 0 ? static_cast<double>(c.flops) / c.bytes
+                       : std::numeric_limits<double>::infinity();
+  };
+  std::stable_sort(
+      candidates.begin(),
+      candidates.end(),
+      [&](const Candidate& a, const Candidate& b) {
+        return flops_per_byte(a) < flops_per_byte(b);
+      });
+  value_set recompute;
+  for (const Candidate& c : candidates) {
+    if (budget > 0 && captured_bytes <= budget) {
+      break;
+    }
+    recompute.insert(c.value);
+    captured_bytes -= c.bytes;
+    grad_desc.recomputed_bytes += c.bytes;
+    grad_desc.recompute_flops += c.flops;
+  }
+  if (recompute.empty()) {
+    return;
+  }
+
+  // Clone the ops at the start of the reverse block, in topological order,
+  // the recomputed inputs of an op replaced by their clones
+  value_map recomputed;
+  Node* insert_after = nullptr;
+  for (Value* capture : captures) {
+    if (!recompute.count(capture)) {
+      continue;
+    }
+    Node* clone = graph.createClone(capture->node(), [&](Value* v) {
+      auto it = recomputed.find(v);
+      return it != recomputed.end() ? it->second : v;
+    });
+    if (insert_after) {
+      clone->insertAfter(insert_after);
+    } else {
+      reverse_block->prependNode(clone);
+    }
+    insert_after = clone;
+    recomputed[capture] = clone->output();
+    GRAPH_UPDATE(
+        "Recomputing ", capture->debugName(), " in the backward: ", *clone);
+    const auto uses = capture->uses();
+    for (const Use& use : uses) {
+      if (use.user->owningBlock() != primal_block && use.user != clone) {
+        use.user->replaceInput(use.offset, clone->output());
+      }
+    }
+    liftConstants(clone, reverse_block);
+  }
+  GRAPH_DEBUG(
+      "Recomputing ",
+      recompute.size(),
+      " intermediates in the backward saves ",
+      grad_desc.recomputed_bytes,
+      " bytes of captures for ",
+      grad_desc.recompute_flops,
+      " operations");
+  recomputed_bytes_counter.add(grad_desc.recomputed_bytes);
+  recompute_flops_counter.add(grad_desc.recompute_flops);
+}
+
 static void eliminateDeadCode(ReverseDetails& rev_info) {
   // addReverseInline has to call gradientForNode if *any* of the inputs
   // require grad, but it will emit vjps for *all* inputs. Use DCE to remove
@@ -650,6 +828,7 @@ static void Optimize(Gradient& grad_desc, ReverseDetails& rev_info) {
   // multiple times. Make sure we deduplicate them before lifting.
   EliminateCommonSubexpression(grad_desc.f);
   deduplicateSizeCaptures(grad_desc, rev_info);
+  recomputeCheapCaptures(grad_desc, rev_info);
   eliminateDeadCode(rev_info);
 }
 
@@ -5,6 +5,7 @@
 
 #include <ATen/ATen.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
 
@@ -66,6 +67,12 @@ struct Gradient {
   // vjp for inp_idx-th input of f.
   std::vector<size_t> df_output_vjps; // Offsets into f's inputs.
 
+  // The bytes of intermediates df recomputes instead of capturing them, and
+  // the elementwise operations recomputing them takes, see
+  // getAutodiffRecomputeBudget(). Sizes that aren't known count as 0.
+  int64_t recomputed_bytes = 0;
+  int64_t recompute_flops = 0;
+
   // How to use gradient to implement a differentiable autograd function:
   // When running f:
   //   - Unwrap input Variables
@@ -89,6 +96,14 @@ struct Gradient {
 };
 TORCH_API Gradient differentiate(std::shared_ptr<Graph>& graph);
 
+// The bytes of intermediates differentiate() may capture for df before it
+// recomputes cheap elementwise ones in df instead, cheapest per byte first,
+// e.g. the output of a sigmoid whose input is captured anyway. Only
+// intermediates whose inputs df captures anyway are recomputed, so that no
+// new captures are needed. -1, the default, disables recomputation, and 0
+// recomputes every intermediate that can be.
+TORCH_API std::atomic<int64_t>& getAutodiffRecomputeBudget();
+
 // can we take a derivative of this node symbolically?
 TORCH_API bool isDifferentiable(Node* n);
 TORCH_API bool isDifferentiable(Graph& g);
@@ -11,8 +11,10 @@
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/python_print.h>
 #include <torch/csrc/jit/pickle.h>
+#include <torch/csrc/jit/plan_serialization.h>
 #include <torch/csrc/jit/source_range_serialization.h>
 #include <torch/csrc/jit/instruction.h>
+#include <torch/csrc/jit/weight_compression.h>
 
 #include <caffe2/core/types.h>
 #include <caffe2/proto/caffe2_pb.h>
@@ -541,11 +543,15 @@ class ScriptModuleSerializer {
   void serialize(
       const script::Module& module,
       const script::ExtraFilesMap& extra_files,
-      bool bytecode_format) {
+      bool bytecode_format,
+      WeightCompression weight_compression) {
     C10_LOG_API_USAGE_ONCE("torch.script.save");
     writeExtraFiles(module, extra_files);
     // Serialize the model object
-    writeArchive("data", module.module_object());
+    writeArchive("data", module.module_object(), weight_compression);
+    if (getSaveOptimizedPlans()) {
+      writeArchive("optimized_plans", exportOptimizedPlans(module));
+    }
     // Then we werialize all code info.
     writeCode(module.type());
     // The tensor constants from the code are written to a separate archive
@@ -559,7 +565,13 @@ class ScriptModuleSerializer {
   }
 
  private:
-  void writeArchive(const std::string& archive_name, const IValue& value) {
+  // With `weight_compression`, the float storages that compressedRowSize()
+  // selects are written compressed and listed in the "weight_compression"
+  // archive.
+  void writeArchive(
+      const std::string& archive_name,
+      const IValue& value,
+      WeightCompression weight_compression = WeightCompression::NONE) {
     std::vector<char> data;
     // Vector to capture the run-time class types during pickling the IValues
     std::vector<c10::ClassTypePtr> memorizedClassTypes;
@@ -574,12 +586,34 @@ class ScriptModuleSerializer {
     data_pickle.stop();
     size_t i = 0;
     std::string prefix = archive_name + "/";
+    std::vector<IValue> compressed;
     for (const auto& td : data_pickle.tensorData()) {
-      std::string fname = prefix + std::to_string(i++);
-      writer_.writeRecord(fname, td.data(), td.sizeInBytes());
+      std::string key = std::to_string(i++);
+      std::string fname = prefix + key;
+      int64_t row_size = compressedRowSize(td.tensor(), weight_compression);
+      if (row_size > 0) {
+        std::string record = compressWeights(
+            reinterpret_cast<const float*>(td.data()),
+            td.numel(),
+            row_size,
+            weight_compression);
+        writer_.writeRecord(fname, record.data(), record.size());
+        compressed.emplace_back(c10::ivalue::Tuple::create(
+            {key,
+             toString(weight_compression),
+             static_cast<int64_t>(td.numel()),
+             row_size}));
+      } else {
+        writer_.writeRecord(fname, td.data(), td.sizeInBytes());
+      }
     }
     std::string fname = archive_name + ".pkl";
     writer_.writeRecord(fname, data.data(), data.size());
+    if (!compressed.empty()) {
+      writeArchive(
+          kWeightCompressionArchive,
+          c10::ivalue::Tuple::create(std::move(compressed)));
+    }
 
     // serialize all the captured run-time class types
     for (const c10::ClassTypePtr& wroteType : memorizedClassTypes) {
@@ -977,31 +1011,70 @@ void ExportModule(
     const script::Module& module,
     std::ostream& out,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    WeightCompression weight_compression) {
   ScriptModuleSerializer serializer(
     [&](const void* buf, size_t nbytes) -> size_t {
       out.write(static_cast<const char *>(buf), nbytes);
       return !out ? 0 : nbytes;
     });
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, weight_compression);
 }
 
 void ExportModule(
     const script::Module& module,
     const std::string& filename,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    WeightCompression weight_compression) {
   ScriptModuleSerializer serializer(filename);
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, weight_compression);
 }
 
 void ExportModule(
     const script::Module& module,
     const std::function<size_t(const void*, size_t)>& writer_func,
     const script::ExtraFilesMap& extra_files,
-    bool bytecode_format) {
+    bool bytecode_format,
+    WeightCompression weight_compression) {
   ScriptModuleSerializer serializer(writer_func);
-  serializer.serialize(module, extra_files, bytecode_format);
+  serializer.serialize(
+      module, extra_files, bytecode_format, weight_compression);
+}
+
+namespace {
+void collectOpNames(Block* block, std::set<std::string>& names) {
+  for (Node* node : block->nodes()) {
+    if (auto schema = node->maybeSchema()) {
+      const auto& name = schema->operator_name();
+      names.insert(
+          name.overload_name.empty() ? name.name
+                                     : name.name + "." + name.overload_name);
+    }
+    for (Block* sub_block : node->blocks()) {
+      collectOpNames(sub_block, names);
+    }
+  }
+}
+
+void collectOpNames(
+    const script::Module& module,
+    std::set<std::string>& names) {
+  for (const auto& method : module.get_methods()) {
+    collectOpNames(method.graph()->block(), names);
+  }
+  for (const auto& submodule : module.get_modules()) {
+    collectOpNames(submodule.module, names);
+  }
+}
+} // namespace
+
+std::vector<std::string> export_opnames(const script::Module& module) {
+  std::set<std::string> names;
+  collectOpNames(module, names);
+  return std::vector<std::string>(names.begin(), names.end());
 }
 
 } // namespace jit
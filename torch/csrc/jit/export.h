@@ -2,6 +2,7 @@
 
 #include <torch/csrc/jit/ir.h>
 #include <torch/csrc/jit/script/module.h>
+#include <torch/csrc/jit/weight_compression.h>
 #include <torch/csrc/onnx/onnx.h>
 
 #include <ostream>
@@ -45,19 +46,27 @@ TORCH_API void ExportModule(
     const script::Module& module,
     std::ostream& out,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    WeightCompression weight_compression = WeightCompression::NONE);
 
 TORCH_API void ExportModule(
     const script::Module& module,
     const std::string& filename,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    WeightCompression weight_compression = WeightCompression::NONE);
 
 TORCH_API void ExportModule(
     const script::Module& module,
     const std::function<size_t(const void*, size_t)>& writer_func,
     const script::ExtraFilesMap& metadata = script::ExtraFilesMap(),
-    bool bytecode_format = false);
+    bool bytecode_format = false,
+    WeightCompression weight_compression = WeightCompression::NONE);
+
+// The operators the methods of `module` and of its submodules call, as
+// "<name>.<overload name>", sorted. Used to select the operators of a
+// mobile build, see SELECTED_OP_LIST in CMakeLists.txt.
+TORCH_API std::vector<std::string> export_opnames(const script::Module& module);
 
 // Surrounding system can install an additional hook to produce extra files
 // with metadata based on environment every time a module is serialized.
@@ -1,8 +1,13 @@
 #include <torch/csrc/jit/function.h>
 #include <torch/csrc/jit/passes/inliner.h>
 
+#include <ATen/Parallel.h>
+#include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/jit/script/error_report.h>
 
+#include <condition_variable>
+#include <exception>
+
 namespace torch {
 namespace jit {
 namespace {
@@ -76,5 +81,41 @@ void preoptimizeGraph(std::shared_ptr<Graph>& graph) {
   Inline(*graph);
 }
 
+void compileInParallel(std::vector<std::pair<Function*, Stack>> calls) {
+  for (auto& call : calls) {
+    call.first->get_executor();
+  }
+
+  // The plans are specialized to the grad mode, which is thread local.
+  const bool grad_mode = autograd::GradMode::is_enabled();
+  std::mutex mutex;
+  std::condition_variable finished;
+  size_t pending = calls.size();
+  std::exception_ptr error;
+  for (auto& call : calls) {
+    at::launch([&]() {
+      std::exception_ptr call_error;
+      try {
+        autograd::AutoGradMode guard(grad_mode);
+        call.first->get_executor().getPlanFor(call.second);
+      } catch (...) {
+        call_error = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (call_error && !error) {
+        error = call_error;
+      }
+      if (--pending == 0) {
+        finished.notify_all();
+      }
+    });
+  }
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock, [&] { return pending == 0; });
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 } // namespace jit
 } // namespace torch
@@ -133,5 +133,15 @@ struct TORCH_API Function {
   // before a call to setSchema
   mutable std::unique_ptr<FunctionSchema> schema_;
 };
+
+// Compiles the plans that calling each function with the inputs it is paired
+// with would compile, concurrently on the inter-op thread pool, so that the
+// first calls of many independent functions don't pay for their
+// optimizations one after the other. The functions are defined serially
+// first, as defining one can define the functions it calls. The first error
+// is rethrown once all the compilations finished. Must not be called from
+// the inter-op thread pool, which it waits on.
+TORCH_API void compileInParallel(
+    std::vector<std::pair<Function*, Stack>> calls);
 } // namespace jit
 } // namespace torch
@@ -11,6 +11,7 @@
 #include <torch/csrc/jit/fuser/cpu/resource_strings.h>
 #include <torch/csrc/jit/fuser/cuda/resource_strings.h>
 
+#include <algorithm>
 #include <cmath>
 #include <cstdint>
 #include <iostream>
@@ -29,6 +30,15 @@ size_t ${tensor}_dimIndex${d} = ${tensor}_linearIndex ${mod_sizes};
 ${tensor}_offset += ${tensor}_dimIndex${d} ${times_stride};
 )");
 
+// Template for a pass over the current row in kernels with row reductions
+static auto row_loop = CodeTemplate(R"(
+for (IndexType colIndex = ${colStart}; colIndex < rowSize; colIndex += ${colStep}) {
+  IndexType linearIndex = rowIndex * rowSize + colIndex;
+  ${tensorOffsets}
+  ${loopBody}
+}
+)");
+
 static std::string valueName(const Value* n) {
   return "n" + c10::to_string(n->unique());
 }
@@ -208,6 +218,9 @@ static std::string encodeRHS(const Node* n) {
       {aten::round, {"roundf(${0})", "round(${0})"}},
       {aten::trunc, {"truncf(${0})", "trunc(${0})"}},
       {aten::frac, {"fracf(${0})", "frac(${0})"}},
+      {aten::gelu,
+       {"${0} * 0.5f * (1.f + erff(${0} * 0.70710678118654752f))",
+        "${0} * 0.5 * (1. + erf(${0} * 0.70710678118654752))"}},
       {aten::reciprocal, {"1.f/(${0})", "1./(${0})"}},
       {aten::neg, "-${0}"},
       // simple binary
@@ -286,6 +299,78 @@ static std::string encodeRHS(const Node* n) {
   }
 }
 
+bool isRowReduction(const Node* n) {
+  return n->kind() == aten::softmax || n->kind() == aten::log_softmax ||
+      n->kind() == aten::layer_norm;
+}
+
+// The code implementing a row reduction. The statistics of the row are
+// accumulated in a pass over the row, and then used to compute every element
+// of the output.
+struct RowReductionCode {
+  // Declares the statistics, once per row
+  std::string init;
+  // Adds an element of the row to the statistics
+  std::string accumulate;
+  // Combines the statistics of the lanes of a warp (CUDA only)
+  std::string combine;
+  // Computes derived statistics after the pass
+  std::string finalize;
+  // The value of an element of the output
+  std::string rhs;
+};
+
+static RowReductionCode encodeRowReduction(const Node* n) {
+  const auto outtype = n->output()->type()->expect<TensorType>()->scalarType();
+  TORCH_INTERNAL_ASSERT(outtype);
+  const auto operand = [&](const Value* v) {
+    return typeCastedValueName(v->type(), *outtype, valueName(v));
+  };
+
+  TemplateEnv env;
+  env.s("type", calcScalarTypeName(*outtype));
+  env.s("stats", valueName(n->output()));
+  env.s("input", operand(n->input(0)));
+
+  RowReductionCode code;
+  if (n->kind() == aten::layer_norm) {
+    env.s("eps", operand(n->namedInput(attr::eps)));
+    code.init = format(
+        "${type} ${stats}_count = 0, ${stats}_mean = 0, ${stats}_m2 = 0;\n",
+        env);
+    code.accumulate = format(
+        "welfordAccumulate(${stats}_count, ${stats}_mean, ${stats}_m2, ${input});\n",
+        env);
+    code.combine = format(
+        "welfordWarpReduce(${stats}_count, ${stats}_mean, ${stats}_m2);\n",
+        env);
+    code.finalize = format(
+        "const ${type} ${stats}_rstd = layerNormRstd(${stats}_count, ${stats}_m2, ${eps});\n",
+        env);
+    code.rhs = format("(${input} - ${stats}_mean) * ${stats}_rstd", env);
+    const Value* weight = n->namedInput(attr::weight);
+    if (!weight->mustBeNone()) {
+      code.rhs += " * " + operand(weight);
+    }
+    const Value* bias = n->namedInput(attr::bias);
+    if (!bias->mustBeNone()) {
+      code.rhs += " + " + operand(bias);
+    }
+  } else {
+    code.init =
+        format("${type} ${stats}_max = NEG_INFINITY, ${stats}_sum = 0;\n", env);
+    code.accumulate =
+        format("softmaxAccumulate(${stats}_max, ${stats}_sum, ${input});\n", env);
+    code.combine = format("softmaxWarpReduce(${stats}_max, ${stats}_sum);\n", env);
+    if (n->kind() == aten::softmax) {
+      code.rhs = format("exp(${input} - ${stats}_max) / ${stats}_sum", env);
+    } else {
+      code.rhs = format("${input} - ${stats}_max - log(${stats}_sum)", env);
+    }
+  }
+  return code;
+}
+
 static void emitIndexingFor(
     std::ostream& out,
     const std::string& tensor,
@@ -310,6 +395,12 @@ static void emitIndexingFor(
   }
 }
 
+// True if the tensor is indexed by the linear index of the map (after
+// contiguity compression, it has a single dimension of stride 1).
+static bool isFullyContiguous(const TensorDesc& desc) {
+  return desc.nDim() == 0 || (desc.nDim() == 1 && desc.lastIsContiguous());
+}
+
 // TODO: handle cases where we need to generate > 2^32 element tensors
 std::string generateKernel(
     const std::string& name,
@@ -323,11 +414,43 @@ std::string generateKernel(
       "IndexType",
       "unsigned int"); // Note: not uint32_t to avoid including cstdint
 
-  std::stringstream body;
+  // Note: kernels with row reductions are generated as several passes over
+  //  every row, which recompute the statements reading the inputs and
+  //  computing intermediate values. Constants and scalar inputs are only
+  //  computed once per row.
+  const bool has_row_reduction = std::any_of(
+      graph.nodes().begin(), graph.nodes().end(), isRowReduction);
+
+  std::stringstream loads;
+  std::stringstream row_prelude;
+  std::vector<std::string> statements;
+  std::vector<std::pair<size_t, RowReductionCode>> row_reductions;
+  std::stringstream writes;
   std::stringstream tensorOffsets;
+  std::stringstream tensorPointers;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
 
+  // Note: CPU kernels whose tensors are all fully contiguous read and write
+  //  them through the linear index, with pointers that don't alias, so that
+  //  the compiler can vectorize the loop. Outputs are always freshly
+  //  allocated, inputs can alias each other since they are only read. These
+  //  kernels are instantiated for the ArgSpecs of contiguous inputs only.
+  const bool contiguous = !use_cuda && !has_row_reduction &&
+      std::all_of(inputs.begin(), inputs.end(),
+                  [](const std::pair<const Value*, const c10::optional<TensorDesc>>& input) {
+                    return !input.second || isFullyContiguous(*input.second);
+                  }) &&
+      std::all_of(outputs.begin(), outputs.end(),
+                  [](const std::pair<const Value*, const TensorDesc>& output) {
+                    return isFullyContiguous(output.second);
+                  });
+  const auto tensorAccess = [&](size_t formal) {
+    const std::string tensor = "t" + c10::to_string(formal);
+    return contiguous ? tensor + "_data[linearIndex]"
+                      : tensor + ".data[" + tensor + "_offset]";
+  };
+
   // Lambda for writing arguments
   auto emitFormal = [&](const Value* n, const TensorDesc& desc) {
     env.d(
@@ -339,10 +462,18 @@ std::string generateKernel(
           c10::to_string(
               formals.size()); // can't be unique() because Param may be an output
       const auto nDim = desc.nDim();
-      emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
       env.s("tensor", tensor);
       env.d("nDim", nDim);
       env.s("scalar_type", scalarTypeName(desc.scalar_type));
+      if (contiguous) {
+        // Inputs come first and are only read
+        env.s("const", formals.size() < inputs.size() ? "const " : "");
+        tensorPointers << format(
+            "${const}${scalar_type}* RESTRICT ${tensor}_data = ${tensor}.data;\n",
+            env);
+      } else {
+        emitIndexingFor(tensorOffsets, tensor, nDim, desc.lastIsContiguous());
+      }
       formals.push_back(
           format("const TensorInfo<${scalar_type},${nDim}> ${tensor}", env));
       argument_loads.push_back(format(
@@ -385,6 +516,14 @@ std::string generateKernel(
     emitFormal(output.first, output.second);
   }
 
+  // Row reductions also take the size of the rows
+  if (has_row_reduction) {
+    env.d("formal_index", formals.size() + 1);
+    formals.push_back("IndexType rowSize");
+    argument_loads.push_back(
+        format("*static_cast<IndexType*>(args[${formal_index}])", env));
+  }
+
   // Acquires input values
   bool has_half_tensor = false;
   size_t formal_count = 0;
@@ -414,14 +553,18 @@ std::string generateKernel(
           env.s("access", format("__ldg(&t${formal}.data[t${formal}_offset])", env));
         }
       } else {
-        env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+        env.s("access", tensorAccess(formal_count - 1));
       }
       env.s("lhs_type", calcScalarTypeName(input.second.value().scalar_type));
     } else {
       env.s("access", format("s${formal}", env));
       env.s("lhs_type", variableType(input.first->type()));
     }
-    body << format("${lhs_type} ${node} = ${access};\n", env);
+    if (has_row_reduction && !input.second.has_value()) {
+      row_prelude << format("${lhs_type} ${node} = ${access};\n", env);
+    } else {
+      loads << format("${lhs_type} ${node} = ${access};\n", env);
+    }
   }
 
   bool has_random = false;
@@ -449,6 +592,11 @@ std::string generateKernel(
     //  - Math function rules
     if (n->kind() == prim::Constant) {
       const auto val = toIValue(n->output()).value();
+      // Note: int lists (the normalized shape of layer_norm) are only read
+      //  while generating the code
+      if (val.isIntList()) {
+        continue;
+      }
       std::string rhs;
       if (val.isDouble()) {
         rhs = scalarValue(val.toDouble());
@@ -461,19 +609,28 @@ std::string generateKernel(
       env.s("node", valueName(n->output()));
       env.s("rhs", rhs);
       env.s("lhs_type", variableType(n->output()->type()));
+    } else if (isRowReduction(n)) {
+      row_reductions.emplace_back(statements.size(), encodeRowReduction(n));
+      env.s("node", valueName(n->output()));
+      env.s("rhs", row_reductions.back().second.rhs);
+      env.s("lhs_type", variableType(n->output()->type()));
     } else {
       env.s("node", valueName(n->output()));
       env.s("rhs", encodeRHS(n));
       env.s("lhs_type", variableType(n->output()->type()));
     }
 
-    body << format("${lhs_type} ${node} = ${rhs};\n", env);
+    if (has_row_reduction && n->kind() == prim::Constant) {
+      row_prelude << format("${lhs_type} ${node} = ${rhs};\n", env);
+    } else {
+      statements.push_back(format("${lhs_type} ${node} = ${rhs};\n", env));
+    }
   }
 
   // Generates writes to output tensors
   for (const auto& output : outputs) {
-    env.d("formal", formal_count++);
-    env.s("access", format("t${formal}.data[t${formal}_offset]", env));
+    env.d("formal", formal_count);
+    env.s("access", tensorAccess(formal_count++));
     env.s("node", valueName(output.first));
 
     // Acquires and converts (if needed) outputs
@@ -481,13 +638,53 @@ std::string generateKernel(
     const auto is_half = (output.second.scalar_type == at::ScalarType::Half);
     if (is_half) {
       AT_ASSERT(use_cuda);
-      body << format("${access} = __float2half(${node});\n", env);
+      writes << format("${access} = __float2half(${node});\n", env);
       has_half_tensor = true;
     } else {
-      body << format("${access} = ${node};\n", env);
+      writes << format("${access} = ${node};\n", env);
     }
   }
 
+  std::stringstream body;
+  if (!has_row_reduction) {
+    body << loads.str();
+    for (const auto& statement : statements) {
+      body << statement;
+    }
+    body << writes.str();
+  } else {
+    // Note: random numbers would differ between the passes over a row, the
+    //  graph fuser doesn't fuse them with row reductions.
+    TORCH_INTERNAL_ASSERT(!has_random);
+    TemplateEnv loop_env;
+    loop_env.s("colStart", use_cuda ? "lane" : "0");
+    loop_env.s("colStep", use_cuda ? "WARP_SIZE" : "1");
+    loop_env.s("tensorOffsets", tensorOffsets.str());
+    const auto emitRowLoop = [&](size_t num_statements,
+                                 const std::string& tail) {
+      std::stringstream loop_body;
+      loop_body << loads.str();
+      for (size_t i = 0; i < num_statements; ++i) {
+        loop_body << statements[i];
+      }
+      loop_body << tail;
+      loop_env.s("loopBody", loop_body.str());
+      body << row_loop.format(loop_env);
+    };
+
+    body << row_prelude.str();
+    for (const auto& reduction : row_reductions) {
+      const RowReductionCode& code = reduction.second;
+      body << code.init;
+      emitRowLoop(reduction.first, code.accumulate);
+      if (use_cuda) {
+        body << code.combine;
+      }
+      body << code.finalize;
+    }
+    emitRowLoop(statements.size(), writes.str());
+  }
+
   // Includes headers
   // Note: CUDA kernels support halfs and random generation, CPU kernels do not
   if (has_half_tensor) {
@@ -496,6 +693,17 @@ std::string generateKernel(
     env.s("HalfHeader", "");
   }
 
+  if (!has_row_reduction) {
+    env.s("RowReductionHeader", "");
+  } else if (use_cuda) {
+    env.s(
+        "RowReductionHeader",
+        std::string(cuda::warp_support_literal) +
+            cuda::row_reduction_support_literal);
+  } else {
+    env.s("RowReductionHeader", cpu::row_reduction_support_literal);
+  }
+
   if (has_random) {
     env.s("RandHeader", cuda::rand_support_literal);
     env.s("RandParam", cuda::rand_param);
@@ -508,15 +716,26 @@ std::string generateKernel(
 
   // Insantiates the CUDA or CPU-specific templates
   env.s("tensorOffsets", tensorOffsets.str());
+  env.s("tensorPointers", tensorPointers.str());
   env.s("kernelBody", body.str());
   env.v("formals", formals);
   env.v("argument_loads", argument_loads);
   std::string code_string;
   if (use_cuda) {
     env.s("type_declarations", cuda::type_declarations_template.format(env));
-    code_string = cuda::cuda_compilation_unit_template.format(env);
+    code_string = has_row_reduction
+        ? cuda::cuda_row_compilation_unit_template.format(env)
+        : cuda::cuda_compilation_unit_template.format(env);
   } else {
     env.s("type_declarations", cpu::type_declarations_template.format(env));
+    if (has_row_reduction) {
+      env.s("kernelDefinition", cpu::cpu_row_kernel_template.format(env));
+    } else if (contiguous) {
+      env.s(
+          "kernelDefinition", cpu::cpu_contiguous_kernel_template.format(env));
+    } else {
+      env.s("kernelDefinition", cpu::cpu_kernel_template.format(env));
+    }
     code_string = cpu::cpu_compilation_unit_template.format(env);
   }
 
@@ -15,6 +15,10 @@ namespace torch {
 namespace jit {
 namespace fuser {
 
+// Returns true if the node reduces its input over the last dimension and
+// broadcasts the result back over it (see isRowReduction() in graph_fuser.cpp)
+TORCH_API bool isRowReduction(const Node* n);
+
 // Creates a CPU or CUDA kernel for the given graph.
 // Returns the C++ or CUDA string implementing the kernel.
 TORCH_API std::string generateKernel(
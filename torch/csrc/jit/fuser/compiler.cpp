@@ -2,6 +2,7 @@
 
 #include <ATen/ATen.h>
 #include <ATen/core/jit_type.h>
+#include <c10/core/thread_pool.h>
 #include <c10/util/Exception.h>
 #include <torch/csrc/jit/code_template.h>
 #include <torch/csrc/jit/fuser/codegen.h>
@@ -75,6 +76,14 @@ int debugFuser() {
   return debug_fusion;
 }
 
+bool asyncCompilationEnabled() {
+  static const bool enabled = [] {
+    const char* env = getenv("PYTORCH_FUSER_ASYNC_COMPILE");
+    return env && std::string(env) == "1";
+  }();
+  return enabled;
+}
+
 // If the given node is used once by a chunk node, returns that node.
 // Returns nullptr otherwise.
 static const Node* usedInFusedChunk(const Value* input) {
@@ -162,6 +171,33 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
       std::back_inserter(spec.inputBroadcastGroups()));
 }
 
+static void setRowReductions(KernelSpec& spec) {
+  for (const Node* n : spec.graph()->nodes()) {
+    if (!isRowReduction(n)) {
+      continue;
+    }
+    std::vector<std::vector<int64_t>> param_dependencies;
+    int64_t dim = -1;
+    int64_t row_size = -1;
+    if (n->kind() == aten::layer_norm) {
+      row_size = n->get<std::vector<int64_t>>(attr::normalized_shape)->at(0);
+      for (const Value* param :
+           {n->namedInput(attr::weight), n->namedInput(attr::bias)}) {
+        if (!param->mustBeNone()) {
+          param_dependencies.push_back(getInputDependencies(param));
+        }
+      }
+    } else {
+      dim = n->get<int64_t>(attr::dim).value();
+    }
+    spec.rowReductions().emplace_back(
+        getInputDependencies(n->input(0)),
+        std::move(param_dependencies),
+        dim,
+        row_size);
+  }
+}
+
 // Performs "upfront" compilation where storage is known but shapes are not.
 // Currently identifies how to expand all tensors so that all intermediate
 // tensors are the same shape, simplifying code generation.
@@ -171,9 +207,12 @@ static void setInputBroadcastGroups(KernelSpec& spec) {
 // or their descendants are involved in, which means that in a DAG of
 // pointwise operations all tensors are expandable to the (single) output.
 // Note: The logic is slightly complicated by concatenation and chunking.
+// Row reductions are recorded so that the executor can check their sizes,
+// which are only known at runtime.
 static void upfrontCompilation(KernelSpec& spec) {
   setInputBroadcastGroups(spec);
   setInputChunkDescriptors(spec);
+  setRowReductions(spec);
 }
 
 int64_t registerFusion(const Node* fusion_group) {
@@ -296,6 +335,33 @@ std::shared_ptr<FusedKernel> compileKernel(
       spec.hasRandom());
 }
 
+// A single thread compiles the kernels, one at a time, so that compilation
+// doesn't compete with the rest of the process for more than one core.
+// Note: the pool is created after the kernel cache, so it is destroyed, and
+// waits for the running compilation, before the specs it references are.
+static c10::ThreadPool& compilationPool() {
+  static c10::ThreadPool pool(1);
+  return pool;
+}
+
+void compileKernelAsync(
+    const KernelSpec& spec,
+    const ArgSpec& arg_spec,
+    const std::vector<int64_t>& map_size,
+    const at::Device device) {
+  if (!spec.markPending(arg_spec)) {
+    return;
+  }
+  compilationPool().run([&spec, arg_spec, map_size, device] {
+    try {
+      spec.cacheKernel(arg_spec, compileKernel(spec, arg_spec, map_size, device));
+    } catch (const std::exception& e) {
+      std::cerr << "warning: pytorch jit fuser failed to compile a kernel, "
+                << "the unfused graph will run instead: " << e.what() << "\n";
+    }
+  });
+}
+
 } // namespace fuser
 } // namespace jit
 } // namespace torch
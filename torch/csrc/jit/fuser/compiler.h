@@ -29,6 +29,20 @@ TORCH_API std::shared_ptr<FusedKernel> compileKernel(
     const std::vector<int64_t>& map_size,
     const at::Device device);
 
+// Compiles the kernel as compileKernel() does, on a background thread, and
+// caches it in spec when done. Does nothing if the kernel is already being
+// compiled.
+TORCH_API void compileKernelAsync(
+    const KernelSpec& spec,
+    const ArgSpec& arg_spec,
+    const std::vector<int64_t>& map_size,
+    const at::Device device);
+
+// Whether CPU kernels are compiled in the background, with the unfused graph
+// running until they are ready. Enabled by setting
+// PYTORCH_FUSER_ASYNC_COMPILE=1.
+TORCH_API bool asyncCompilationEnabled();
+
 TORCH_API size_t nCompiledKernels();
 
 TORCH_API int debugFuser();
@@ -4,12 +4,15 @@
 #include <torch/csrc/jit/code_template.h>
 #include <torch/csrc/jit/fuser/compiler.h>
 #include <torch/csrc/jit/fuser/cpu/temp_file.h>
+#include <torch/csrc/jit/fuser/disk_cache.h>
 #include <torch/csrc/utils/memory.h>
 
 #ifdef _MSC_VER
 #include <torch/csrc/jit/fuser/cpu/msvc_arch.h>
 #endif
 
+#include <array>
+#include <cstdio>
 #include <cstdlib>
 #include <iostream>
 #include <sstream>
@@ -38,12 +41,14 @@ static const std::string so_template = temp_dir + "pytorch_fuserXXXXXX.dll";
 static const std::string cpp_template = temp_dir + "pytorch_fuserXXXXXX.cpp";
 static const std::string check_exists_string = "where \"${program}\" > nul 2> nul";
 static std::vector<std::string> env_list;
+static const std::string so_suffix = ".dll";
 constexpr int so_suffix_len = 4;
 constexpr int cpp_suffix_len = 4;
 #else
 static const std::string so_template = "/tmp/pytorch_fuserXXXXXX.so";
 static const std::string cpp_template = "/tmp/pytorch_fuserXXXXXX.cpp";
 static const std::string check_exists_string = "which '${program}' > /dev/null";
+static const std::string so_suffix = ".so";
 constexpr int so_suffix_len = 3;
 constexpr int cpp_suffix_len = 4;
 #endif
@@ -185,6 +190,28 @@ struct CompilerConfig {
     }
   }
 
+  // Identifies the compiler for the kernel disk cache.
+  const std::string& version() {
+    if (version_.empty()) {
+#ifdef _MSC_VER
+      const char* tools_version = getenv("VCToolsVersion");
+      version_ = cxx + " " + (tools_version ? tools_version : "");
+#else
+      version_ = cxx;
+      const std::string cmd = "\"" + cxx + "\" --version 2>&1";
+      FILE* pipe = popen(cmd.c_str(), "r");
+      if (pipe) {
+        std::array<char, 128> buffer;
+        while (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
+          version_ += buffer.data();
+        }
+        pclose(pipe);
+      }
+#endif
+    }
+    return version_;
+  }
+
   ~CompilerConfig() = default;
 
   #ifdef _MSC_VER
@@ -195,6 +222,9 @@ struct CompilerConfig {
     const std::string openmp_flags = "-fopenmp";
   #endif
   bool openmp = true;
+
+ private:
+  std::string version_;
 };
 
 static CompilerConfig& getConfig() {
@@ -290,18 +320,38 @@ FusedKernelCPU::FusedKernelCPU(
           std::move(chunk_desc),
           std::move(concat_desc),
           has_random) {
-  TempFile so_file(so_template, so_suffix_len);
-  TempFile cpp_file(cpp_template, cpp_suffix_len);
-  cpp_file.write(code_);
-  cpp_file.sync();
+  std::string cache_key;
+  c10::optional<std::string> cached_so;
+  if (diskCacheEnabled()) {
+    auto& config = getConfig();
+    std::ostringstream key;
+    key << config.version() << "\n"
+        << compile_string << (config.openmp ? config.openmp_flags : "")
+        << "\n" << code_;
+    cache_key = key.str();
+    cached_so = lookupCachedKernel(cache_key, so_suffix);
+  }
+  if (cached_so) {
+    so_lib = make_unique<at::DynamicLibrary>(cached_so->c_str());
+  } else {
+    TempFile so_file(so_template, so_suffix_len);
+    TempFile cpp_file(cpp_template, cpp_suffix_len);
+    cpp_file.write(code_);
+    cpp_file.sync();
 #ifdef _MSC_VER
-  so_file.close();
-  cpp_file.close();
+    so_file.close();
+    cpp_file.close();
 #endif
-  runCompiler(cpp_file.name(), so_file.name());
-  if (debugFuser() >= 2)
-    disas(so_file.name());
-  so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+    runCompiler(cpp_file.name(), so_file.name());
+    if (debugFuser() >= 2)
+      disas(so_file.name());
+    if (diskCacheEnabled()) {
+      if (auto binary = readKernelFile(so_file.name())) {
+        storeCachedKernel(cache_key, so_suffix, *binary);
+      }
+    }
+    so_lib = make_unique<at::DynamicLibrary>(so_file.name().c_str());
+  }
 #pragma GCC diagnostic ignored "-Wpedantic"
   kernel =
       reinterpret_cast<void (*)(uint32_t, void**)>(so_lib->sym(name_.c_str()));
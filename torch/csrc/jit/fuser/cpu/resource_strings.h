@@ -53,6 +53,8 @@ float fracf(float x) {
 
 ${type_declarations}
 
+${RowReductionHeader}
+
 #ifdef _MSC_VER
 template<size_t n> struct int_of_size;
 
@@ -71,12 +73,29 @@ using int_same_size_t = typename int_of_size<sizeof(T)>::type;
 
 #define IndexTypeLoop int_same_size_t<IndexType>
 #define ToIndexTypeLoop(x) static_cast<IndexTypeLoop>(x)
+#define RESTRICT __restrict
 #else
 #define IndexTypeLoop IndexType
 #define ToIndexTypeLoop(x) x
+#define RESTRICT __restrict__
 #endif
 
 #define OMP_THRESHOLD 100000
+${kernelDefinition}
+
+#ifdef _WIN32
+#define JIT_API __declspec(dllexport)
+#else
+#define JIT_API
+#endif
+
+extern "C"
+JIT_API void ${kernelName}(IndexType totalElements, void ** args) {
+  ${kernelName}_kernel(totalElements ${,argument_loads});
+}
+)");
+
+static auto cpu_kernel_template = CodeTemplate(R"(
 static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
   #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
   for (IndexTypeLoop linearIndex = 0;
@@ -88,19 +107,68 @@ static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
       ${kernelBody}
     }
 }
+)");
 
-#ifdef _WIN32
-#define JIT_API __declspec(dllexport)
-#else
-#define JIT_API
-#endif
+// Kernels whose tensors are all contiguous index them with linearIndex
+// directly (see generateKernel() in codegen.cpp).
+static auto cpu_contiguous_kernel_template = CodeTemplate(R"(
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+  ${tensorPointers}
+  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
+  for (IndexTypeLoop linearIndex = 0;
+        linearIndex < ToIndexTypeLoop(totalElements);
+        linearIndex += 1) {
+      // calculate the results
+      ${kernelBody}
+    }
+}
+)");
 
-extern "C"
-JIT_API void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+// Kernels containing row reductions process the map one row (the last
+// dimension) at a time. The body makes one pass over the row per reduction,
+// followed by a final pass computing the outputs.
+static auto cpu_row_kernel_template = CodeTemplate(R"(
+static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+  const IndexType totalRows = totalElements / rowSize;
+  #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
+  for (IndexTypeLoop rowIndex = 0;
+        rowIndex < ToIndexTypeLoop(totalRows);
+        rowIndex += 1) {
+      ${kernelBody}
+    }
 }
 )");
 
+// Helpers accumulating the statistics of row reductions:
+//  - softmax keeps the running maximum and the sum of exp(x - maximum)
+//    (-inf elements don't contribute, while NaNs poison the sum)
+//  - layer_norm uses Welford's algorithm to accumulate the mean and the sum
+//    of squared differences from the mean
+constexpr auto row_reduction_support_literal = R"(
+template <typename T>
+inline void softmaxAccumulate(T& max, T& sum, T x) {
+  if (x > max) {
+    sum = sum * exp(max - x) + 1;
+    max = x;
+  } else if (x != NEG_INFINITY) {
+    sum += exp(x - max);
+  }
+}
+
+template <typename T>
+inline void welfordAccumulate(T& count, T& mean, T& m2, T x) {
+  count += 1;
+  const T delta = x - mean;
+  mean += delta / count;
+  m2 += delta * (x - mean);
+}
+
+template <typename T>
+inline T layerNormRstd(T count, T m2, T eps) {
+  return 1 / sqrt(m2 / count + eps);
+}
+)";
+
 } // namespace cpu
 } // namespace fuser
 } // namespace jit
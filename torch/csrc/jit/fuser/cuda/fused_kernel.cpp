@@ -1,5 +1,6 @@
 #include <torch/csrc/jit/fuser/cuda/fused_kernel.h>
 #include <torch/csrc/jit/fuser/compiler.h>
+#include <torch/csrc/jit/fuser/disk_cache.h>
 
 #include <ATen/ATen.h>
 #include <ATen/cuda/CUDAContext.h>
@@ -64,6 +65,35 @@ static void getMajorMinor(
   }
 }
 
+static std::vector<char> compileToPTX(
+    const std::string& code,
+    const std::vector<const char*>& args) {
+  // Creates the NVRTC program
+  nvrtcProgram program;
+  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcCreateProgram(
+      &program, code.c_str(), nullptr, 0, nullptr, nullptr));
+
+  const auto result =
+      nvrtc().nvrtcCompileProgram(program, args.size(), args.data());
+  if (result != NVRTC_SUCCESS) {
+    size_t logsize;
+    nvrtc().nvrtcGetProgramLogSize(program, &logsize);
+    std::vector<char> log(logsize);
+    nvrtc().nvrtcGetProgramLog(program, log.data());
+    std::stringstream cu;
+    cu << log.data();
+    throw std::runtime_error(cu.str());
+  }
+  ResourceGuard holdProgram(
+      [&] { AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcDestroyProgram(&program)); });
+  AT_CUDA_NVRTC_CHECK(result);
+  size_t ptx_size;
+  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcGetPTXSize(program, &ptx_size));
+  std::vector<char> ptx(ptx_size);
+  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcGetPTX(program, ptx.data()));
+  return ptx;
+}
+
 // Compiles the specified kernel and stores the metadata required to run it
 FusedKernelCUDA::FusedKernelCUDA(
     int16_t device,
@@ -103,11 +133,6 @@ FusedKernelCUDA::FusedKernelCUDA(
   int major, minor;
   getMajorMinor(prop_, major, minor);
 
-  // Creates the NVRTC program
-  nvrtcProgram program;
-  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcCreateProgram(
-      &program, code_.c_str(), nullptr, 0, nullptr, nullptr));
-
 #ifdef __HIP_PLATFORM_HCC__
   std::vector<const char*> args = {};
 #else
@@ -116,24 +141,30 @@ FusedKernelCUDA::FusedKernelCUDA(
   const std::vector<const char*> args = {
       "--std=c++11", compute.c_str(), "-default-device"};
 #endif
-  const auto result =
-      nvrtc().nvrtcCompileProgram(program, args.size(), args.data());
-  if (result != NVRTC_SUCCESS) {
-    size_t logsize;
-    nvrtc().nvrtcGetProgramLogSize(program, &logsize);
-    std::vector<char> log(logsize);
-    nvrtc().nvrtcGetProgramLog(program, log.data());
-    std::stringstream cu;
-    cu << log.data();
-    throw std::runtime_error(cu.str());
+
+  // The PTX only depends on the code, the NVRTC version and the arguments
+  // (which hold the architecture), so it can be reused across processes.
+  // NVRTC doesn't produce cubins, but the driver caches the PTX JIT itself.
+  std::string cache_key;
+  if (diskCacheEnabled()) {
+    int nvrtc_major, nvrtc_minor;
+    AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+    std::ostringstream key;
+    key << "nvrtc " << nvrtc_major << "." << nvrtc_minor << "\n";
+    for (const char* arg : args) {
+      key << arg << " ";
+    }
+    key << "\n" << code_;
+    cache_key = key.str();
+    if (auto ptx = loadCachedKernel(cache_key, ".ptx")) {
+      ptx_.assign(ptx->begin(), ptx->end());
+    }
+  }
+  if (ptx_.empty()) {
+    ptx_ = compileToPTX(code_, args);
+    storeCachedKernel(
+        cache_key, ".ptx", std::string(ptx_.begin(), ptx_.end()));
   }
-  ResourceGuard holdProgram(
-      [&] { AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcDestroyProgram(&program)); });
-  AT_CUDA_NVRTC_CHECK(result);
-  size_t ptx_size;
-  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcGetPTXSize(program, &ptx_size));
-  ptx_.resize(ptx_size);
-  AT_CUDA_NVRTC_CHECK(nvrtc().nvrtcGetPTX(program, ptx_.data()));
 
   AT_CUDA_DRIVER_CHECK(nvrtc().cuModuleLoadData(&module_, ptx_.data()));
   AT_CUDA_DRIVER_CHECK(
@@ -182,6 +182,106 @@ void ${kernelName}(IndexType totalElements, ${formals} ${RandParam}) {
 }
 )");
 
+// Kernels containing row reductions process the map one row (the last
+// dimension) at a time, with the lanes of a warp splitting every row between
+// them. The body makes one pass over the row per reduction, combining the
+// statistics of the lanes at the end of every pass, followed by a final pass
+// computing the outputs.
+static auto cuda_row_compilation_unit_template = CodeTemplate(R"(
+${type_declarations}
+${RowReductionHeader}
+
+extern "C" __global__
+void ${kernelName}(IndexType totalElements, ${formals}) {
+  const IndexType totalRows = totalElements / rowSize;
+  const IndexType lane = threadIdx.x % WARP_SIZE;
+  for (IndexType rowIndex = (blockIdx.x * blockDim.x + threadIdx.x) / WARP_SIZE;
+        rowIndex < totalRows;
+        rowIndex += gridDim.x * blockDim.x / WARP_SIZE) {
+      ${kernelBody}
+    }
+}
+)");
+
+#ifdef __HIP_PLATFORM_HCC__
+constexpr auto warp_support_literal = R"(
+#define WARP_SIZE 64
+
+template <typename T>
+__device__ inline T warpShflXor(T value, int laneMask) {
+  return __shfl_xor(value, laneMask);
+}
+)";
+#else
+constexpr auto warp_support_literal = R"(
+#define WARP_SIZE 32
+
+template <typename T>
+__device__ inline T warpShflXor(T value, int laneMask) {
+  return __shfl_xor_sync(0xffffffff, value, laneMask);
+}
+)";
+#endif
+
+// Helpers accumulating the statistics of row reductions, see the CPU
+// resource strings. The warp reductions leave every lane with the statistics
+// of the whole row.
+constexpr auto row_reduction_support_literal = R"(
+template <typename T>
+__device__ inline void softmaxAccumulate(T& max, T& sum, T x) {
+  if (x > max) {
+    sum = sum * exp(max - x) + 1;
+    max = x;
+  } else if (x != NEG_INFINITY) {
+    sum += exp(x - max);
+  }
+}
+
+template <typename T>
+__device__ inline void softmaxWarpReduce(T& max, T& sum) {
+  for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+    const T other_max = warpShflXor(max, offset);
+    const T other_sum = warpShflXor(sum, offset);
+    if (other_max > max) {
+      sum = sum * exp(max - other_max) + other_sum;
+      max = other_max;
+    } else if (other_sum != 0) {
+      sum += other_sum * exp(other_max - max);
+    }
+  }
+}
+
+template <typename T>
+__device__ inline void welfordAccumulate(T& count, T& mean, T& m2, T x) {
+  count += 1;
+  const T delta = x - mean;
+  mean += delta / count;
+  m2 += delta * (x - mean);
+}
+
+template <typename T>
+__device__ inline void welfordWarpReduce(T& count, T& mean, T& m2) {
+  for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+    const T other_count = warpShflXor(count, offset);
+    const T other_mean = warpShflXor(mean, offset);
+    const T other_m2 = warpShflXor(m2, offset);
+    const T total = count + other_count;
+    if (total > 0) {
+      const T delta = other_mean - mean;
+      const T factor = other_count / total;
+      mean += delta * factor;
+      m2 += other_m2 + delta * delta * count * factor;
+      count = total;
+    }
+  }
+}
+
+template <typename T>
+__device__ inline T layerNormRstd(T count, T m2, T eps) {
+  return 1 / sqrt(m2 / count + eps);
+}
+)";
+
 // This snippet enables half support in the jit. Following the pattern for
 // reductions, fp16 input data is immediately upconverted to float
 // with __half2float(). All mathematical operations are done on float
@@ -0,0 +1,151 @@
+#include <torch/csrc/jit/fuser/disk_cache.h>
+#include <torch/csrc/jit/fuser/compiler.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+
+// Bump when the format of the entries changes.
+static const std::string kCacheVersion = "1";
+
+static const std::string& cacheDir() {
+  static const std::string dir = [] {
+    const char* dir_env = getenv("PYTORCH_FUSER_CACHE_DIR");
+    if (!dir_env || *dir_env == '\0') {
+      return std::string();
+    }
+#ifdef _WIN32
+    _mkdir(dir_env);
+#else
+    mkdir(dir_env, 0777);
+#endif
+    return std::string(dir_env);
+  }();
+  return dir;
+}
+
+bool diskCacheEnabled() {
+  return !cacheDir().empty();
+}
+
+// FNV-1a, which unlike std::hash is the same in every build.
+static uint64_t hashKey(const std::string& key) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (const char c : key) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Entries are stored as <hash><suffix>, next to a <hash><suffix>.key file
+// holding the full key, which guards against hash collisions and is only
+// written once the binary is complete.
+static std::string cachePath(
+    const std::string& key,
+    const std::string& suffix) {
+  std::ostringstream path;
+  path << cacheDir() << "/" << std::hex << hashKey(kCacheVersion + "\n" + key)
+       << suffix;
+  return path.str();
+}
+
+c10::optional<std::string> readKernelFile(const std::string& path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return c10::nullopt;
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  if (!file) {
+    return c10::nullopt;
+  }
+  return contents.str();
+}
+
+// Writes to a temporary file first and renames it, so that readers never
+// see a partial file.
+static bool writeFileAtomic(
+    const std::string& path,
+    const std::string& contents) {
+#ifdef _WIN32
+  const auto pid = _getpid();
+#else
+  const auto pid = getpid();
+#endif
+  const std::string tmp_path = path + ".tmp" + std::to_string(pid);
+  {
+    std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), contents.size());
+    if (!file) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(tmp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+c10::optional<std::string> lookupCachedKernel(
+    const std::string& key,
+    const std::string& suffix) {
+  if (!diskCacheEnabled()) {
+    return c10::nullopt;
+  }
+  const std::string path = cachePath(key, suffix);
+  const auto cached_key = readKernelFile(path + ".key");
+  if (!cached_key || *cached_key != key) {
+    return c10::nullopt;
+  }
+  if (debugFuser()) {
+    std::cerr << "fuser: found cached kernel " << path << "\n";
+  }
+  return path;
+}
+
+c10::optional<std::string> loadCachedKernel(
+    const std::string& key,
+    const std::string& suffix) {
+  const auto path = lookupCachedKernel(key, suffix);
+  if (!path) {
+    return c10::nullopt;
+  }
+  return readKernelFile(*path);
+}
+
+void storeCachedKernel(
+    const std::string& key,
+    const std::string& suffix,
+    const std::string& binary) {
+  if (!diskCacheEnabled()) {
+    return;
+  }
+  const std::string path = cachePath(key, suffix);
+  if (!writeFileAtomic(path, binary) || !writeFileAtomic(path + ".key", key)) {
+    if (debugFuser()) {
+      std::cerr << "fuser: failed to cache kernel " << path << "\n";
+    }
+  }
+}
+
+} // namespace fuser
+} // namespace jit
+} // namespace torch
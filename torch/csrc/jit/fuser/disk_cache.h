@@ -0,0 +1,45 @@
+#pragma once
+
+#include <c10/util/Optional.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <string>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+
+// A persistent cache of compiled kernels, shared between processes, so that
+// only the first process to run a fusion pays for its compilation. It is
+// enabled by setting PYTORCH_FUSER_CACHE_DIR to a directory.
+//
+// Entries are looked up by a key that must contain everything that
+// determines the compiler's output: the generated source, the target
+// architecture, the compiler command and its version. Entries are written
+// atomically, so processes can share the directory safely.
+
+TORCH_API bool diskCacheEnabled();
+
+// Returns the path of the binary cached for key, if there is one.
+TORCH_API c10::optional<std::string> lookupCachedKernel(
+    const std::string& key,
+    const std::string& suffix);
+
+// Returns the contents of the binary cached for key, if there is one.
+TORCH_API c10::optional<std::string> loadCachedKernel(
+    const std::string& key,
+    const std::string& suffix);
+
+// Caches a binary for key. Failures are ignored, since the kernel can always
+// be compiled again.
+TORCH_API void storeCachedKernel(
+    const std::string& key,
+    const std::string& suffix,
+    const std::string& binary);
+
+// Reads a whole file, e.g. a freshly compiled binary to cache.
+TORCH_API c10::optional<std::string> readKernelFile(const std::string& path);
+
+} // namespace fuser
+} // namespace jit
+} // namespace torch
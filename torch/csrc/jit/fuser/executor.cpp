@@ -93,6 +93,41 @@ static c10::optional<std::vector<int64_t>> canRunKernel(
   return map_size;
 }
 
+// Row reductions are computed over the last dimension of the map size, which
+// is only correct if it is the dimension they reduce, and if none of their
+// operands were broadcast along it.
+static bool canRunRowReductions(
+    const KernelSpec& spec,
+    at::TensorList args,
+    const std::vector<int64_t>& map_size) {
+  if (map_size.empty()) {
+    return false;
+  }
+  const auto row_size = map_size.back();
+  for (const auto& reduction : spec.rowReductions()) {
+    if (reduction.rowSize() != -1 && reduction.rowSize() != row_size) {
+      return false;
+    }
+    const auto input_size =
+        getMapSize(spec, args, reduction.inputDependencies());
+    if (!input_size || input_size->empty() ||
+        input_size->back() != row_size) {
+      return false;
+    }
+    const int64_t ndim = input_size->size();
+    if (at::maybe_wrap_dim(reduction.dim(), ndim) != ndim - 1) {
+      return false;
+    }
+    for (const auto& param_dependencies : reduction.paramDependencies()) {
+      const auto param_size = getMapSize(spec, args, param_dependencies);
+      if (!param_size || *param_size != std::vector<int64_t>{row_size}) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 // Arguments are expanded to a common shape, referred to as the "map size,"
 // (see above).
 // Note: Arguments are mutated by this call, although map_size is restored
@@ -192,6 +227,7 @@ void launchFusion(
     const at::Device device,
     const at::ArrayRef<at::Tensor>& inputs,
     const at::ArrayRef<IValue>& all_inputs,
+    const bool has_row_reduction,
     std::vector<at::Tensor>& outputs) {
   // Fails if fusion and given inputs disagree
   AT_ASSERT(inputs.size() == fusion.inputDesc().size());
@@ -240,9 +276,13 @@ void launchFusion(
   std::vector<char> buffer(maxPossibleBufferSize);
   char* buffer_next = buffer.data();
 
+  // Kernels containing row reductions also take the size of the rows, which
+  // is the size of the last dimension of the map.
+  uint32_t row_size = map_size.empty() ? 1 : map_size.back();
+
   // A vector of arguments to the kernel (numel, *input_desc_s, *output_desc_s)
   std::vector<void*> arguments;
-  arguments.reserve(3 + scalar_inputs.size() + flat_inputs_size + flat_outputs_size);
+  arguments.reserve(4 + scalar_inputs.size() + flat_inputs_size + flat_outputs_size);
   arguments.push_back(&numel);
 
   auto addTensorInfoRaw = [&](const TensorDesc& desc,
@@ -313,6 +353,9 @@ void launchFusion(
       }
     }
   }
+  if (has_row_reduction) {
+    arguments.push_back(&row_size);
+  }
   // Skip launching the kernel for zero-element tensor inputs
   // launches are skipped, empty zero-sized output is returned
   if (numel > 0) {
@@ -362,6 +405,9 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
   // Tries to run fallback if map size can't be computed
   if (!maybe_map_size)
     return false;
+  if (spec.hasRowReduction() &&
+      !canRunRowReductions(spec, inputs, *maybe_map_size))
+    return false;
   if (spec.hasRandom()) {
     bool hasBroadcast = shouldExpandArgs(spec, inputs, *maybe_map_size);
     if (hasBroadcast)
@@ -372,6 +418,12 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
   // Retrieves the kernel, compiling (and caching) if necessary
   ArgSpec arg_spec{inputs, device.index()};
   auto maybe_kernel = spec.findKernel(arg_spec);
+  if (!maybe_kernel && device.is_cpu() && !code_out &&
+      asyncCompilationEnabled()) {
+    // Runs the unfused graph until the kernel is ready
+    compileKernelAsync(spec, arg_spec, *maybe_map_size, device);
+    return false;
+  }
   if (!maybe_kernel) {
     const auto kernel = compileKernel(spec, arg_spec, *maybe_map_size, device);
     spec.cacheKernel(arg_spec, kernel);
@@ -385,7 +437,13 @@ bool runFusion(const int64_t key, Stack& stack, std::string* code_out) {
 
   // Launches fusion
   std::vector<at::Tensor> outputs;
-  launchFusion(*(*maybe_kernel), device, inputs, all_inputs, outputs);
+  launchFusion(
+      *(*maybe_kernel),
+      device,
+      inputs,
+      all_inputs,
+      spec.hasRowReduction(),
+      outputs);
 
   // Updates stack
   drop(stack, spec.nInputs());
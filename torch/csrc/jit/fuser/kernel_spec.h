@@ -14,6 +14,7 @@
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace torch {
@@ -41,6 +42,46 @@ struct TORCH_API PartitionInfo {
   int64_t dim_;
 };
 
+// Helper struct describing a row reduction (see isRowReduction() in
+// codegen.h): the inputs its operands depend on and the sizes it expects.
+// Note: created during upfront compilation. At runtime the executor checks
+// that the reduction covers exactly the last dimension of the map size, and
+// falls back to the unfused graph otherwise.
+struct TORCH_API RowReductionInfo {
+  RowReductionInfo(
+      std::vector<int64_t> _inputDependencies,
+      std::vector<std::vector<int64_t>> _paramDependencies,
+      const int64_t _dim,
+      const int64_t _rowSize)
+      : inputDependencies_{std::move(_inputDependencies)},
+        paramDependencies_{std::move(_paramDependencies)},
+        dim_{_dim},
+        rowSize_{_rowSize} {};
+
+  // Inputs the reduced operand depends on
+  const std::vector<int64_t>& inputDependencies() const {
+    return inputDependencies_;
+  }
+  // Inputs each of the 1-dimensional (affine) parameters depends on
+  const std::vector<std::vector<int64_t>>& paramDependencies() const {
+    return paramDependencies_;
+  }
+  // Reduced dimension of the operand, may be negative
+  int64_t dim() const {
+    return dim_;
+  }
+  // Expected size of the reduced dimension, or -1 if any size is accepted
+  int64_t rowSize() const {
+    return rowSize_;
+  }
+
+ private:
+  std::vector<int64_t> inputDependencies_;
+  std::vector<std::vector<int64_t>> paramDependencies_;
+  int64_t dim_;
+  int64_t rowSize_;
+};
+
 // "Kernel Specification." - Contains device-independent fusion information.
 // Each kernel specification contains a map of instantiated generated functions
 // that implement some or most of its functionality. Multiple generated
@@ -64,6 +105,7 @@ struct TORCH_API KernelSpec {
         nTensorInputs_{},
         inputBroadcastGroups_{},
         inputChunks_{},
+        rowReductions_{},
         has_random_{false},
         kernels_{} {
     for (const auto& n : graph_->nodes()) {
@@ -109,9 +151,19 @@ struct TORCH_API KernelSpec {
     return inputChunks_;
   }
 
+  std::vector<RowReductionInfo>& rowReductions() {
+    return rowReductions_;
+  }
+  const std::vector<RowReductionInfo>& rowReductions() const {
+    return rowReductions_;
+  }
+
   bool hasRandom() const {
     return has_random_;
   }
+  bool hasRowReduction() const {
+    return !rowReductions_.empty();
+  }
 
   // Cache functions
   c10::optional<std::shared_ptr<FusedKernel>> findKernel(
@@ -126,6 +178,14 @@ struct TORCH_API KernelSpec {
       const {
     std::lock_guard<std::mutex> guard{mutex_};
     kernels_.emplace(arg_spec, kernel);
+    pending_.erase(arg_spec);
+  }
+  // Records that a kernel for arg_spec is being compiled in the background.
+  // Returns false if one already was. Kernels that fail to compile stay
+  // pending, so that they aren't compiled again.
+  bool markPending(const ArgSpec& arg_spec) const {
+    std::lock_guard<std::mutex> guard{mutex_};
+    return pending_.insert(arg_spec).second;
   }
 
  private:
@@ -136,11 +196,13 @@ struct TORCH_API KernelSpec {
   uint64_t nTensorInputs_;
   std::vector<std::vector<int64_t>> inputBroadcastGroups_;
   std::vector<PartitionInfo> inputChunks_;
+  std::vector<RowReductionInfo> rowReductions_;
   bool has_random_;
   mutable std::mutex mutex_;
   mutable std::
       unordered_map<ArgSpec, std::shared_ptr<FusedKernel>, torch::hash<ArgSpec>>
           kernels_;
+  mutable std::unordered_set<ArgSpec, torch::hash<ArgSpec>> pending_;
 };
 
 } // namespace fuser
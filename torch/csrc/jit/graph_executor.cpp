@@ -2,6 +2,7 @@
 
 #include <ATen/core/ivalue.h>
 #include <c10/util/Exception.h>
+#include <c10/util/Metrics.h>
 #include <torch/csrc/autograd/grad_mode.h>
 #include <torch/csrc/jit/argument_spec.h>
 #include <torch/csrc/jit/autodiff.h>
@@ -11,6 +12,7 @@
 #include <torch/csrc/jit/ir.h>
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/pass_manager.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
 #include <torch/csrc/jit/passes/batch_mm.h>
 #include <torch/csrc/jit/passes/canonicalize_ops.h>
 #include <torch/csrc/jit/passes/common_subexpression_elimination.h>
@@ -26,6 +28,7 @@
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_grad_of.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/parallelize_branches.h>
 #include <torch/csrc/jit/passes/peephole.h>
 #include <torch/csrc/jit/passes/quantization.h>
 #include <torch/csrc/jit/passes/remove_expands.h>
@@ -41,6 +44,14 @@
 #include <torch/csrc/autograd/function.h>
 #include <torch/csrc/jit/script/logging.h>
 
+#ifdef USE_CUDA
+#include <ATen/cuda/CUDAEvent.h>
+#include <ATen/cuda/CUDAGraph.h>
+#include <c10/cuda/CUDAGuard.h>
+#endif
+
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <iterator>
 #include <memory>
@@ -76,6 +87,70 @@ thread_local std::weak_ptr<Graph> last_executed_optimized_graph;
 std::shared_ptr<Graph> lastExecutedOptimizedGraph() {
   return last_executed_optimized_graph.lock();
 }
+
+static std::atomic<bool> parallel_branches_mode{false};
+std::atomic<bool>& getParallelBranchesMode() {
+  return parallel_branches_mode;
+}
+
+static std::atomic<bool> cuda_graphs_mode{false};
+std::atomic<bool>& getCUDAGraphsMode() {
+  return cuda_graphs_mode;
+}
+
+static std::atomic<int64_t> compile_time_budget{-1};
+std::atomic<int64_t>& getCompileTimeBudget() {
+  return compile_time_budget;
+}
+
+namespace {
+
+// The runs of a plan compiled over budget after which it is recompiled with
+// all the optimizations.
+constexpr size_t kRunsBeforeFullOptimization = 10;
+
+c10::metrics::Counter over_budget_plans_counter(
+    "torch_jit_compile_over_budget_plans_total",
+    "Plans compiled without some optimizations because the compile-time "
+    "budget ran out");
+
+// Runs `pass` under a PassTimer named `name`.
+template <typename F>
+void timed(const char* name, F&& pass) {
+  PassTimer timer(name);
+  pass();
+}
+
+// Tracks the compile-time budget of a plan, see getCompileTimeBudget().
+class CompileDeadline {
+ public:
+  explicit CompileDeadline(int64_t budget_ms)
+      : enabled_(budget_ms >= 0),
+        deadline_(
+            std::chrono::steady_clock::now() +
+            std::chrono::milliseconds(std::max<int64_t>(budget_ms, 0))) {}
+
+  // Whether an optional pass may still run. Once the deadline has passed,
+  // no other pass may.
+  bool allows() {
+    if (enabled_ && !expired_ &&
+        std::chrono::steady_clock::now() > deadline_) {
+      expired_ = true;
+    }
+    return !expired_;
+  }
+
+  bool expired() const {
+    return expired_;
+  }
+
+ private:
+  const bool enabled_;
+  const std::chrono::steady_clock::time_point deadline_;
+  bool expired_ = false;
+};
+
+} // namespace
 namespace {
 
 using tensor_list = std::vector<at::Tensor>;
@@ -464,6 +539,187 @@ GraphExecutor* getGradExecutor(Operation& op) {
 }
 } // namespace detail
 
+// Note [CUDA graphs in the graph executor]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// With getCUDAGraphsMode() set, a plan run without gradients on CUDA tensors
+// of a single device is captured into a CUDA graph once per complete argument
+// spec. The later runs with the same sizes and strides copy their inputs into
+// the tensors the capture ran on, replay the graph with one launch and return
+// copies of its outputs, so that they don't pay for dispatching and launching
+// every kernel of the plan again. The first run of a spec runs the plan as
+// usual, which initializes the libraries that can't be initialized during a
+// capture, e.g. cuBLAS. Plans that write to their inputs, fork, return
+// anything but tensors or fail to be captured, e.g. because they synchronize
+// with the host, just keep running the usual way.
+//
+// The memory of a capture stays reserved until the executor is destroyed or
+// captures another plan for the spec, which the profiling executor does once
+// it optimized the graph it profiled.
+#ifdef USE_CUDA
+namespace {
+
+struct CapturedPlan {
+  // held while a run uses the static inputs and outputs
+  std::mutex mutex;
+  // the plan captured, a run of another one captures it again
+  std::shared_ptr<Graph> graph;
+  bool capturable = false;
+  bool warmed_up = false;
+  std::unique_ptr<at::cuda::CUDAGraph> cuda_graph;
+  // the tensors the capture ran on
+  std::vector<at::Tensor> static_inputs;
+  std::vector<at::Tensor> static_outputs;
+  // recorded once the outputs of a replay are copied, so that the next run,
+  // maybe on another stream, doesn't overwrite the static inputs early
+  at::cuda::CUDAEvent replayed;
+
+  void reset() {
+    static_inputs.clear();
+    static_outputs.clear();
+    cuda_graph.reset();
+  }
+};
+
+bool forks(Block* block) {
+  for (Node* node : block->nodes()) {
+    if (node->kind() == prim::fork) {
+      return true;
+    }
+    for (Block* sub_block : node->blocks()) {
+      if (forks(sub_block)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+bool isCapturable(const ExecutionPlan& plan) {
+  // a replay would write to the static inputs instead, and the forked work
+  // runs in another thread than the one capturing
+  if (forks(plan.graph->block()) ||
+      AliasDb(plan.graph).hasOutputWriters(plan.graph->param_node())) {
+    return false;
+  }
+  for (const Value* output : plan.graph->outputs()) {
+    if (!output->type()->isSubtypeOf(TensorType::get())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool capture(
+    CapturedPlan& captured,
+    const ExecutionPlan& plan,
+    at::ArrayRef<IValue> inputs) {
+  Stack static_stack;
+  for (const IValue& input : inputs) {
+    const at::Tensor& tensor = input.toTensor();
+    captured.static_inputs.push_back(
+        at::empty_strided(tensor.sizes(), tensor.strides(), tensor.options()));
+    static_stack.emplace_back(captured.static_inputs.back());
+  }
+  captured.cuda_graph.reset(new at::cuda::CUDAGraph());
+  try {
+    captured.cuda_graph->capture_begin();
+    InterpreterState(plan.code).run(static_stack);
+    captured.cuda_graph->capture_end();
+  } catch (const std::exception&) {
+    // The run that follows reports the error if it wasn't about capturing.
+    captured.reset();
+    return false;
+  }
+  for (IValue& output : static_stack) {
+    captured.static_outputs.push_back(output.toTensor());
+  }
+  return true;
+}
+
+} // namespace
+
+struct CapturedPlans {
+  std::unordered_map<CompleteArgumentSpec, std::unique_ptr<CapturedPlan>>
+      plans;
+};
+
+bool GraphExecutorImplBase::runCaptured(
+    const ExecutionPlan& plan,
+    Stack& stack) {
+  if (!getCUDAGraphsMode() || autograd::GradMode::is_enabled() ||
+      getParallelBranchesMode() || num_inputs == 0) {
+    return false;
+  }
+  auto inputs = last(stack, num_inputs);
+  int64_t device = -1;
+  for (const IValue& input : inputs) {
+    if (!input.isTensor()) {
+      return false;
+    }
+    const at::Tensor& tensor = input.toTensor();
+    if (!tensor.defined() || !tensor.is_cuda() ||
+        !tensor.is_non_overlapping_and_dense() ||
+        (device != -1 && tensor.get_device() != device)) {
+      return false;
+    }
+    device = tensor.get_device();
+  }
+
+  CompleteArgumentSpec spec(/*with_grad=*/false, inputs);
+  CapturedPlan* captured;
+  {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    if (!captured_plans) {
+      captured_plans = std::make_shared<CapturedPlans>();
+    }
+    auto& entry = captured_plans->plans[spec];
+    if (!entry) {
+      entry.reset(new CapturedPlan());
+    }
+    captured = entry.get();
+  }
+
+  std::lock_guard<std::mutex> lock(captured->mutex);
+  if (captured->graph != plan.graph) {
+    captured->reset();
+    captured->graph = plan.graph;
+    captured->capturable = isCapturable(plan);
+    captured->warmed_up = false;
+  }
+  if (!captured->capturable) {
+    return false;
+  }
+  if (!captured->warmed_up) {
+    captured->warmed_up = true;
+    return false;
+  }
+
+  at::cuda::CUDAGuard device_guard(device);
+  auto stream = at::cuda::getCurrentCUDAStream();
+  captured->replayed.block(stream);
+  if (!captured->cuda_graph && !capture(*captured, plan, inputs)) {
+    captured->capturable = false;
+    return false;
+  }
+  for (size_t i = 0; i < num_inputs; ++i) {
+    captured->static_inputs[i].copy_(inputs[i].toTensor());
+  }
+  captured->cuda_graph->replay();
+  drop(stack, num_inputs);
+  for (const at::Tensor& output : captured->static_outputs) {
+    stack.emplace_back(output.clone());
+  }
+  captured->replayed.record(stream);
+  return true;
+}
+#else
+bool GraphExecutorImplBase::runCaptured(
+    const ExecutionPlan& /*plan*/,
+    Stack& /*stack*/) {
+  return false;
+}
+#endif
+
 void GraphExecutorImplBase::run(Stack& stack) {
   TORCH_CHECK(
       stack.size() >= num_inputs,
@@ -477,7 +733,9 @@ void GraphExecutorImplBase::run(Stack& stack) {
       logging::runtime_counters::GRAPH_EXECUTOR_INVOCATIONS, 1.0);
 
   ExecutionPlan plan = getPlanFor(stack);
-  InterpreterState(plan.code).run(stack);
+  if (!runCaptured(plan, stack)) {
+    InterpreterState(plan.code).run(stack);
+  }
   last_executed_optimized_graph = plan.graph;
 }
 
@@ -498,6 +756,21 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
                                       : getOrCompileFallback();
   }
 
+  std::vector<std::pair<ArgumentSpec, ExecutionPlan>> getCompiledPlans()
+      override {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    return {plan_cache.begin(), plan_cache.end()};
+  }
+
+  bool addCompiledPlan(
+      const ArgumentSpec& spec,
+      std::shared_ptr<Graph> optimized_graph) override {
+    std::lock_guard<std::mutex> lock(compile_mutex);
+    // a plan compiled here already is as good
+    plan_cache.emplace(spec, ExecutionPlan(std::move(optimized_graph)));
+    return true;
+  }
+
   GraphExecutorState getDebugState() override {
     GraphExecutorState state;
     state.graph = graph.get();
@@ -523,7 +796,8 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
     return fallback;
   }
 
-  const ExecutionPlan& getOrCompile(const Stack& stack) {
+  // Returns a copy, as plans compiled over budget are replaced in the cache.
+  ExecutionPlan getOrCompile(const Stack& stack) {
     // outside lock guard, to minimize the time holding the lock on the fast
     // path ArgumentSpec even computes its hashCode here.
     ArgumentSpec spec =
@@ -534,9 +808,22 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
       if (it != plan_cache.end()) {
         logging::getLogger()->addStatValue(
             logging::runtime_counters::EXECUTION_PLAN_CACHE_HIT, 1.0);
+        auto over_budget = over_budget_runs.find(spec);
+        if (over_budget != over_budget_runs.end() &&
+            ++over_budget->second >= kRunsBeforeFullOptimization) {
+          // The plan is hot enough to be worth the passes that were skipped.
+          over_budget_runs.erase(over_budget);
+          GRAPH_DEBUG("Recompiling a hot plan compiled over budget");
+          it->second = compileSpec(spec, /*budget_ms=*/-1);
+        }
         return it->second;
       }
-      auto plan = compileSpec(spec);
+      bool over_budget = false;
+      auto plan = compileSpec(spec, getCompileTimeBudget(), &over_budget);
+      if (over_budget) {
+        over_budget_plans_counter.add();
+        over_budget_runs.emplace(spec, 0);
+      }
       auto r = plan_cache.emplace(std::move(spec), std::move(plan));
       logging::getLogger()->addStatValue(
           logging::runtime_counters::EXECUTION_PLAN_CACHE_MISS, 1.0);
@@ -544,66 +831,100 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
     }
   }
 
-  ExecutionPlan compileSpec(const ArgumentSpec& spec) {
+  // Skips the optional passes left once `budget_ms` are spent, and sets
+  // `over_budget` if it did.
+  ExecutionPlan compileSpec(
+      const ArgumentSpec& spec,
+      int64_t budget_ms,
+      bool* over_budget = nullptr) {
+    CompileDeadline deadline(budget_ms);
     auto opt_graph = graph->copy();
     SOURCE_DUMP("Optimizing the following function:", opt_graph);
     arg_spec_creator_.specializeTypes(*opt_graph, spec);
 
     // Phase 0. Inline functions, then clean up any artifacts that the inliner
     //          left in that may inhibit optimization
-    Inline(*opt_graph);
-    specializeAutogradZero(*opt_graph);
-    LowerSimpleTuples(opt_graph);
-    ConstantPooling(opt_graph);
+    timed("Inline", [&] { Inline(*opt_graph); });
+    timed("specializeAutogradZero", [&] {
+      specializeAutogradZero(*opt_graph);
+    });
+    timed("LowerSimpleTuples", [&] { LowerSimpleTuples(opt_graph); });
+    timed("ConstantPooling", [&] { ConstantPooling(opt_graph); });
 
     // Phase 1. Specialize to input definedness (this is very important for
     //          gradient graphs), and run required passes to bring the graph
     //          to an executable form.
     runRequiredPasses(opt_graph);
 
+    // The passes from here on only optimize the graph, so they are skipped
+    // once the compile-time budget is spent.
+
     // Phase 2. Propagate detailed information about the spec through the
     //          graph (enabled more specializations in later passes).
     //          Shape propagation sometimes depends on certain arguments being
     //          constants, and constant propagation doesn't need shape
     //          information anyway, so it's better to run it first.
-    ConstantPropagation(opt_graph);
-    PropagateInputShapes(opt_graph);
-    PropagateRequiresGrad(opt_graph);
+    if (deadline.allows()) {
+      timed("ConstantPropagation", [&] { ConstantPropagation(opt_graph); });
+      timed("PropagateInputShapes", [&] { PropagateInputShapes(opt_graph); });
+      timed("PropagateRequiresGrad", [&] { PropagateRequiresGrad(opt_graph); });
+    }
 
     // Phase 3. Run differentiable optimizations (i.e. simple graph rewrites
     //          that we can still execute using autograd).
-    runOptimization(opt_graph);
+    if (deadline.allows()) {
+      runOptimization(opt_graph);
+    }
 
     // Phase 4. If this graph will be differentiated, we need to slice out the
     //          symbolically differentiable subgraphs for further optimizations.
     // Phase 5. Apply non-differentiable optimizations to the graphs we've found
     //          (or the whole grpah if we know we won't need its derivative).
-    if (needsGradient(opt_graph)) {
-      auto diff_nodes = CreateAutodiffSubgraphs(
-          opt_graph,
-          autodiff_subgraph_inlining ? autodiffSubgraphNodeThreshold : 1);
+    // Without autodiff subgraphs, autograd differentiates the graph as is.
+    const bool optimize = deadline.allows();
+    if (optimize && needsGradient(opt_graph)) {
+      std::vector<Node*> diff_nodes;
+      timed("CreateAutodiffSubgraphs", [&] {
+        diff_nodes = CreateAutodiffSubgraphs(
+            opt_graph,
+            autodiff_subgraph_inlining ? autodiffSubgraphNodeThreshold : 1);
+      });
       for (Node* dnode : diff_nodes) {
         auto diff_graph = std::move(dnode->g(attr::Subgraph));
-        Gradient gradient = differentiate(diff_graph);
+        Gradient gradient;
+        timed("differentiate", [&] { gradient = differentiate(diff_graph); });
         // Run post differentiation optimizations, Autodiff will replace some
         // parts of graph with new graph, these new graphs usually consists of
         // control flows and miss shape information on nodes, so we run shape
         // prop and differentiable optimizations to ensure the graph is
-        // optimized
-        PropagateInputShapes(gradient.f);
-        runOptimization(gradient.f);
-        // run non diff optimization on the forward graph
-        runNondiffOptimization(gradient.f);
+        // optimized. Every subgraph has to be differentiated, but these are
+        // optional.
+        if (deadline.allows()) {
+          timed("PropagateInputShapes", [&] {
+            PropagateInputShapes(gradient.f);
+          });
+          runOptimization(gradient.f);
+          // run non diff optimization on the forward graph
+          runNondiffOptimization(gradient.f);
+        }
         packGradient(gradient, dnode);
       }
-      InlineAutodiffSubgraphs(
-          opt_graph,
-          autodiff_subgraph_inlining ? autodiffSubgraphInlineThreshold : 1);
-    } else {
+      timed("InlineAutodiffSubgraphs", [&] {
+        InlineAutodiffSubgraphs(
+            opt_graph,
+            autodiff_subgraph_inlining ? autodiffSubgraphInlineThreshold : 1);
+      });
+    } else if (optimize) {
       runNondiffOptimization(opt_graph);
+      if (getParallelBranchesMode()) {
+        timed("ParallelizeBranches", [&] { ParallelizeBranches(opt_graph); });
+      }
     }
     // Make sure there are no leftovers from any passes.
-    EliminateDeadCode(opt_graph);
+    timed("EliminateDeadCode", [&] { EliminateDeadCode(opt_graph); });
+    if (over_budget) {
+      *over_budget = deadline.expired();
+    }
     return ExecutionPlan(opt_graph);
   }
 
@@ -617,6 +938,9 @@ struct GraphExecutorImpl : public GraphExecutorImplBase {
   // Mapping from argument configurations to optimized versions of the graph
   // that are specialized to the spec.
   std::unordered_map<ArgumentSpec, ExecutionPlan> plan_cache;
+
+  // The runs so far of the plans in plan_cache compiled over budget.
+  std::unordered_map<ArgumentSpec, size_t> over_budget_runs;
 };
 
 GraphExecutor::GraphExecutor(std::shared_ptr<Graph> graph)
@@ -642,15 +966,26 @@ GraphExecutorState GraphExecutor::getDebugState() {
   return pImpl->getDebugState();
 }
 
+std::vector<std::pair<ArgumentSpec, ExecutionPlan>> GraphExecutor::
+    getCompiledPlans() {
+  return pImpl->getCompiledPlans();
+}
+
+bool GraphExecutor::addCompiledPlan(
+    const ArgumentSpec& spec,
+    std::shared_ptr<Graph> optimized_graph) {
+  return pImpl->addCompiledPlan(spec, std::move(optimized_graph));
+}
+
 void runRequiredPasses(const std::shared_ptr<Graph>& g) {
-  LowerGradOf(*g);
+  timed("LowerGradOf", [&] { LowerGradOf(*g); });
   // implicit inserted expand nodes are not necessarily always valid
   // when used inside script methods that might have unstable shapes
   // we remove the implicitly created ones, and have shape analysis
   // add valid expand nodes when the shapes are stable
-  RemoveExpands(g);
-  CanonicalizeOps(g);
-  EliminateDeadCode(g);
+  timed("RemoveExpands", [&] { RemoveExpands(g); });
+  timed("CanonicalizeOps", [&] { CanonicalizeOps(g); });
+  timed("EliminateDeadCode", [&] { EliminateDeadCode(g); });
 }
 
 void packGradient(const Gradient& gradient, Node* dnode) {
@@ -695,40 +1030,44 @@ bool needsGradient(const std::shared_ptr<const Graph>& graph) {
 void runNondiffOptimization(std::shared_ptr<Graph>& graph) {
   // run custom passes that different backends can register
   for (const auto& pass : getCustomPasses()) {
-    pass(graph);
+    timed("CustomPass", [&] { pass(graph); });
   }
   // decomposition pass, decompose certain ops that will be used in the
   // following passes (like batchmm and jit fusion)
-  DecomposeOps(graph);
+  timed("DecomposeOps", [&] { DecomposeOps(graph); });
 
   // TupleConstruct / TupleUnpack pairs can still be present at this point
   // and must be removed for fusion.
-  LowerSimpleTuples(graph);
+  timed("LowerSimpleTuples", [&] { LowerSimpleTuples(graph); });
 
   // Rewrite subgraphs with many MMs into expressions that batch them.
-  BatchMM(graph);
+  timed("BatchMM", [&] { BatchMM(graph); });
 
   // Fuse the dequant - op - quant patterns into quantized ops
-  QuantFusion(graph);
+  timed("QuantFusion", [&] { QuantFusion(graph); });
 
-  FuseGraph(graph);
+  timed("FuseGraph", [&] { FuseGraph(graph); });
 }
 
 void runOptimization(std::shared_ptr<Graph>& graph) {
   // Basic graph preprocessing to eliminate noise.
-  EliminateDeadCode(graph);
-  EliminateCommonSubexpression(graph);
-  ConstantPooling(graph);
+  timed("EliminateDeadCode", [&] { EliminateDeadCode(graph); });
+  timed("EliminateCommonSubexpression", [&] {
+    EliminateCommonSubexpression(graph);
+  });
+  timed("ConstantPooling", [&] { ConstantPooling(graph); });
 
-  PeepholeOptimize(graph);
-  ConstantPropagation(graph);
+  timed("PeepholeOptimize", [&] { PeepholeOptimize(graph); });
+  timed("ConstantPropagation", [&] { ConstantPropagation(graph); });
 
   // Unroll small loops, and eliminate expressions that are the same at every
   // iteration.
-  UnrollLoops(graph);
-  EliminateCommonSubexpression(graph);
+  timed("UnrollLoops", [&] { UnrollLoops(graph); });
+  timed("EliminateCommonSubexpression", [&] {
+    EliminateCommonSubexpression(graph);
+  });
 
-  CheckInplace(graph);
+  timed("CheckInplace", [&] { CheckInplace(graph); });
 }
 
 } // namespace jit
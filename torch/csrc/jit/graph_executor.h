@@ -48,6 +48,16 @@ struct TORCH_API GraphExecutor {
   }
   std::shared_ptr<Graph> graph() const;
   GraphExecutorState getDebugState();
+  // The optimized plans compiled so far, with the specs of the inputs they
+  // are specialized to. Empty for executors that don't key plans on
+  // ArgumentSpecs.
+  std::vector<std::pair<ArgumentSpec, ExecutionPlan>> getCompiledPlans();
+  // Adds a plan for the inputs of `spec` that another executor of the same
+  // graph compiled, e.g. in another process. Returns false if this executor
+  // can't use it.
+  bool addCompiledPlan(
+      const ArgumentSpec& spec,
+      std::shared_ptr<Graph> optimized_graph);
 
  private:
   std::shared_ptr<GraphExecutorImplBase> pImpl;
@@ -62,6 +72,27 @@ TORCH_API std::shared_ptr<Graph> lastExecutedOptimizedGraph();
 
 TORCH_API std::atomic<bool> &getProfilingMode();
 
+// The number of shape buckets the profiling executor keeps optimized plans
+// for, least recently used first out. With at most 1, the graph is profiled
+// and optimized once, and inputs of other shapes bail out of that plan.
+TORCH_API std::atomic<size_t>& getProfilingPlanCacheSize();
+
+// When set, graphs that don't need gradients run their independent branches
+// concurrently, see passes/parallelize_branches.h
+TORCH_API std::atomic<bool>& getParallelBranchesMode();
+
+// When set, graphs that don't need gradients and run on CUDA tensors are
+// captured into CUDA graphs and replayed, see Note [CUDA graphs in the graph
+// executor]
+TORCH_API std::atomic<bool>& getCUDAGraphsMode();
+
+// The milliseconds the graph executor may spend optimizing a plan. Once they
+// are spent, the remaining optional passes are skipped, and the plan is only
+// recompiled with all of them after it has run a few times, so that cold
+// graphs don't pay for optimizations they won't amortize. -1, the default,
+// means no budget.
+TORCH_API std::atomic<int64_t>& getCompileTimeBudget();
+
 struct TORCH_API GraphOptimizerEnabledGuard {
   GraphOptimizerEnabledGuard(bool state)
       : old_state_(getGraphExecutorOptimize()) {
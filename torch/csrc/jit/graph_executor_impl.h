@@ -41,6 +41,10 @@ bool getAutodiffSubgraphInlining();
 const size_t autodiffSubgraphNodeThreshold = 2;
 const size_t autodiffSubgraphInlineThreshold = 5;
 
+// the CUDA graphs a GraphExecutor captured, see Note [CUDA graphs in the graph
+// executor]
+struct CapturedPlans;
+
 // a Graph can be created via tracing, or via a language-based frontend
 // GraphExecutor runs it. It can run the same graph on many different sizes
 // and different requires_grad states, and handles specializations for each
@@ -64,6 +68,16 @@ struct GraphExecutorImplBase {
 
   virtual ExecutionPlan getPlanFor(Stack& stack) = 0;
   virtual GraphExecutorState getDebugState() = 0;
+  // See GraphExecutor::getCompiledPlans() and GraphExecutor::addCompiledPlan()
+  virtual std::vector<std::pair<ArgumentSpec, ExecutionPlan>>
+  getCompiledPlans() {
+    return {};
+  }
+  virtual bool addCompiledPlan(
+      const ArgumentSpec& /*spec*/,
+      std::shared_ptr<Graph> /*optimized_graph*/) {
+    return false;
+  }
   virtual ~GraphExecutorImplBase() = default;
 
  protected:
@@ -82,6 +96,13 @@ struct GraphExecutorImplBase {
   // GraphExecutors can be accessed from multiple threads, so this thread needs
   // to be held every time we access the fallback or plan_cache.
   std::mutex compile_mutex;
+
+ private:
+  // Runs `plan` by replaying a CUDA graph of it if it can, returns false
+  // otherwise
+  bool runCaptured(const ExecutionPlan& plan, Stack& stack);
+
+  std::shared_ptr<CapturedPlans> captured_plans;
 };
 
 } // namespace jit
@@ -8,13 +8,16 @@
 #include <torch/csrc/jit/import_source.h>
 #include <torch/csrc/jit/ir.h>
 #include <torch/csrc/jit/pickle.h>
+#include <torch/csrc/jit/plan_serialization.h>
 #include <torch/csrc/jit/unpickler.h>
 #include <torch/csrc/jit/script/script_type_parser.h>
 #include <torch/csrc/jit/source_range_serialization.h>
+#include <torch/csrc/jit/weight_compression.h>
 
 #include "caffe2/serialize/file_adapter.h"
 #include "caffe2/serialize/inline_container.h"
 #include "caffe2/serialize/istream_adapter.h"
+#include "caffe2/serialize/mmap_file_adapter.h"
 
 #include <ATen/ATen.h>
 
@@ -28,6 +31,7 @@ namespace jit {
 
 using caffe2::serialize::FileAdapter;
 using caffe2::serialize::IStreamAdapter;
+using caffe2::serialize::MmapFileAdapter;
 using caffe2::serialize::PyTorchStreamReader;
 using caffe2::serialize::ReadAdapterInterface;
 
@@ -153,10 +157,15 @@ IValue ScriptModuleDeserializer::readArchive(const std::string& archive_name) {
   };
 
   std::string archive_name_plus_slash = archive_name + "/";
-  auto read_record = [&](const std::string& name) {
+  RecordReader read_record = [&](const std::string& name) {
     std::string ss = archive_name_plus_slash + name;
     return std::get<0>(reader_->getRecord(ss));
   };
+  if (archive_name == "data" &&
+      reader_->hasRecord(std::string(kWeightCompressionArchive) + ".pkl")) {
+    read_record = decompressingRecordReader(
+        readArchive(kWeightCompressionArchive), std::move(read_record));
+  }
 
   Unpickler unpickler(
       reader, std::move(class_resolver), std::move(obj_loader),
@@ -192,7 +201,17 @@ script::Module ScriptModuleDeserializer::deserialize(
   for (auto constant : tuple->elements()) {
     constants_table_.push_back(constant.toTensor());
   }
-  return script::Module(readArchive("data").toObject());
+  script::Module module(readArchive("data").toObject());
+  // The plans are specialized to the devices they were compiled for
+  if (reader_->hasRecord("optimized_plans.pkl") && !device_) {
+    importOptimizedPlans(
+        module,
+        readArchive("optimized_plans"),
+        [this](const c10::QualifiedName& name) {
+          return source_importer_.loadNamedType(name);
+        });
+  }
+  return module;
 }
 
 } // namespace
@@ -241,7 +260,8 @@ script::Module load(
     const std::string& filename,
     c10::optional<at::Device> device,
     script::ExtraFilesMap& extra_files) {
-  std::unique_ptr<FileAdapter> rai = caffe2::make_unique<FileAdapter>(filename);
+  std::unique_ptr<MmapFileAdapter> rai =
+      caffe2::make_unique<MmapFileAdapter>(filename);
   auto module = load(std::move(rai), device, extra_files);
   return module;
 }
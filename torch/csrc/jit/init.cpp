@@ -10,23 +10,30 @@
 #include <torch/csrc/jit/import.h>
 #include <torch/csrc/jit/irparser.h>
 #include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/pass_manager.h>
 #include <torch/csrc/jit/passes/canonicalize.h>
 #include <torch/csrc/jit/passes/canonicalize_ops.h>
 #include <torch/csrc/jit/passes/common_subexpression_elimination.h>
 #include <torch/csrc/jit/passes/constant_pooling.h>
 #include <torch/csrc/jit/passes/constant_propagation.h>
+#include <torch/csrc/jit/passes/convert_to_mkldnn.h>
 #include <torch/csrc/jit/passes/create_autodiff_subgraphs.h>
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 #include <torch/csrc/jit/passes/decompose_ops.h>
 #include <torch/csrc/jit/passes/erase_number_types.h>
+#include <torch/csrc/jit/passes/freeze_module.h>
 #include <torch/csrc/jit/passes/fuse_linear.h>
+#include <torch/csrc/jit/passes/fuse_transformer_ops.h>
 #include <torch/csrc/jit/passes/graph_fuser.h>
 #include <torch/csrc/jit/passes/inline_fork_wait.h>
 #include <torch/csrc/jit/passes/inliner.h>
 #include <torch/csrc/jit/passes/loop_unrolling.h>
 #include <torch/csrc/jit/passes/lower_graph.h>
 #include <torch/csrc/jit/passes/lower_tuples.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+#include <torch/csrc/jit/passes/module_constant_pooling.h>
 #include <torch/csrc/jit/passes/onnx.h>
+#include <torch/csrc/jit/passes/parallelize_branches.h>
 #include <torch/csrc/jit/passes/onnx/cast_all_constant_to_floating.h>
 #include <torch/csrc/jit/passes/onnx/constant_fold.h>
 #include <torch/csrc/jit/passes/onnx/fixup_onnx_loop.h>
@@ -40,7 +47,9 @@
 #include <torch/csrc/jit/passes/shape_analysis.h>
 #include <torch/csrc/jit/passes/specialize_autogradzero.h>
 #include <torch/csrc/jit/passes/subgraph_rewrite.h>
+#include <torch/csrc/jit/passes/use_inplace_ops.h>
 #include <torch/csrc/jit/passes/utils/check_alias_annotation.h>
+#include <torch/csrc/jit/plan_serialization.h>
 #include <torch/csrc/jit/print_handler.h>
 #include <torch/csrc/jit/pybind_utils.h>
 #include <torch/csrc/jit/python_arg_flatten.h>
@@ -52,6 +61,7 @@
 #include <torch/csrc/jit/script/module.h>
 #include <torch/csrc/jit/script/python_tree_views.h>
 #include <torch/csrc/jit/tracer.h>
+#include <torch/csrc/jit/unpickler.h>
 #include <torch/csrc/utils/auto_gil.h>
 
 #include <c10/macros/Export.h>
@@ -189,7 +199,9 @@ void initJITBindings(PyObject* module) {
           "_jit_pass_quant_fusion",
           [](std::shared_ptr<Graph>& g) { return QuantFusion(g); })
       .def("_jit_pass_fold_convbn", &FoldConvBatchNorm2d)
+      .def("_freeze_module", &freeze_module)
       .def("_jit_pass_fuse_linear", &FuseLinear)
+      .def("_jit_pass_fuse_transformer_ops", &FuseTransformerOps)
       .def(
           "_jit_pass_fold_quantize",
           [](script::Module& module, const std::string& method_name) {
@@ -226,6 +238,17 @@ void initJITBindings(PyObject* module) {
           "_jit_pass_remove_inplace_ops",
           [](std::shared_ptr<Graph> g) { return RemoveInplaceOps(g); })
       .def("_jit_pass_constant_pooling", ConstantPooling)
+      .def(
+          "_jit_pass_module_constant_pooling",
+          [](const script::Module& module) {
+            auto stats = PoolModuleConstants(module);
+            py::dict result;
+            result["pooled_tensors"] = stats.pooled_tensors;
+            result["saved_bytes"] = stats.saved_bytes;
+            result["hoisted_nodes"] = stats.hoisted_nodes;
+            return result;
+          })
+      .def("_jit_pass_hoist_loop_invariants", HoistLoopInvariants)
       .def(
           "_jit_pass_peephole",
           [](const std::shared_ptr<Graph>& g, bool addmm_fusion_enabled) {
@@ -304,6 +327,10 @@ void initJITBindings(PyObject* module) {
       .def("_jit_pass_fixup_onnx_loops", FixupONNXLoops)
       .def("_jit_pass_canonicalize_ops", CanonicalizeOps)
       .def("_jit_pass_decompose_ops", DecomposeOps)
+      .def("_jit_pass_plan_static_memory", PlanStaticMemory)
+      .def("_jit_pass_use_inplace_ops", UseInplaceOps)
+      .def("_jit_pass_convert_to_mkldnn", ConvertToMkldnn)
+      .def("_jit_pass_parallelize_branches", ParallelizeBranches)
       .def("_jit_pass_specialize_autogradzero", specializeAutogradZero)
       .def("_jit_override_can_fuse_on_cpu", &overrideCanFuseOnCPU)
       .def(
@@ -326,6 +353,47 @@ void initJITBindings(PyObject* module) {
       .def(
           "_jit_set_profiling_mode",
           [](bool profiling_flag) { getProfilingMode() = profiling_flag; })
+      .def(
+          "_jit_set_profiling_plan_cache_size",
+          [](size_t size) { getProfilingPlanCacheSize() = size; })
+      .def(
+          "_jit_set_save_optimized_plans",
+          [](bool enabled) { getSaveOptimizedPlans() = enabled; })
+      .def(
+          "_jit_set_parallel_branches_mode",
+          [](bool enabled) { getParallelBranchesMode() = enabled; })
+      .def(
+          "_jit_set_autodiff_recompute_budget",
+          [](int64_t budget) { getAutodiffRecomputeBudget() = budget; })
+      .def(
+          "_jit_get_autodiff_recompute_budget",
+          []() { return getAutodiffRecomputeBudget().load(); })
+      .def(
+          "_jit_set_cuda_graphs_mode",
+          [](bool enabled) { getCUDAGraphsMode() = enabled; })
+      .def(
+          "_jit_set_compile_time_budget",
+          [](int64_t budget_ms) { getCompileTimeBudget() = budget_ms; })
+      .def(
+          "_jit_get_compile_time_budget",
+          []() { return getCompileTimeBudget().load(); })
+      .def(
+          "_jit_set_pass_timing_mode",
+          [](bool enabled) { getPassTimingMode() = enabled; })
+      .def(
+          "_jit_get_pass_timings",
+          []() {
+            std::vector<std::tuple<std::string, int64_t, int64_t>> timings;
+            for (const PassTiming& timing : getPassTimings()) {
+              timings.emplace_back(
+                  timing.name, timing.count, timing.total_ns);
+            }
+            return timings;
+          })
+      .def("_jit_reset_pass_timings", &resetPassTimings)
+      .def(
+          "_jit_set_tensor_load_threads",
+          [](size_t num_threads) { getTensorLoadThreads() = num_threads; })
       .def(
           "_jit_set_inline_everything_mode",
           [](bool enabled) { script::getInlineEverythingMode() = enabled; })
@@ -382,7 +450,11 @@ void initJITBindings(PyObject* module) {
           "df_input_captured_outputs",
           [](Gradient& m) { return m.df_input_captured_outputs; })
       .def_property_readonly(
-          "df_output_vjps", [](Gradient& m) { return m.df_output_vjps; });
+          "df_output_vjps", [](Gradient& m) { return m.df_output_vjps; })
+      .def_property_readonly(
+          "recomputed_bytes", [](Gradient& m) { return m.recomputed_bytes; })
+      .def_property_readonly(
+          "recompute_flops", [](Gradient& m) { return m.recompute_flops; });
 
   py::class_<GraphExecutorState>(m, "GraphExecutorState")
       .def_property_readonly(
@@ -394,7 +466,10 @@ void initJITBindings(PyObject* module) {
           "fallback", [](GraphExecutorState& s) { return s.fallback; });
 
   py::class_<PyTorchStreamWriter>(m, "PyTorchFileWriter")
-      .def(py::init<std::string>())
+      .def(
+          py::init<std::string, uint64_t>(),
+          py::arg("file_name"),
+          py::arg("alignment") = caffe2::serialize::kFieldAlignment)
       .def(
           "write_record",
           [](PyTorchStreamWriter& self,
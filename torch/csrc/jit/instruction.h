@@ -37,7 +37,11 @@ namespace jit {
   _(TAIL_CALL, "F") /* replace current frame with function F */             \
   _(INTERFACE_CALL, "CI") /* call method X on the first argument (of N) */  \
   _(GET_ATTR, "S") /* get attribute from slot X in an Object */             \
-  _(SET_ATTR, "S") /* set attribute to slot X in an Object */
+  _(SET_ATTR, "S") /* set attribute to slot X in an Object */               \
+  /* superinstructions, only in the stream the interpreter runs */          \
+  _(OP_STORE, "OR") /* invoke operator X, store its output to register N */ \
+  _(LOAD2, "RR") /* push the values from registers X and N */               \
+  _(MOVE2, "RR") /* push the values from registers X and N, clearing them */
 
 enum OpCode : uint8_t {
 #define DEFINE_OP(op, _) op,
@@ -19,6 +19,7 @@
 
 #include <exception>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <mutex>
 #include <ostream>
@@ -29,6 +30,14 @@
 #include <utility>
 #include <vector>
 
+// Where the compiler supports it, the interpreter loop dispatches with
+// computed gotos: each handler jumps straight to the handler of the next
+// instruction, so every opcode gets its own, better predicted, indirect branch
+// instead of all of them sharing the one at the top of the switch.
+#if defined(__GNUC__) || defined(__clang__)
+#define JIT_USE_COMPUTED_GOTO
+#endif
+
 namespace torch {
 namespace jit {
 
@@ -337,6 +346,12 @@ struct CodeImpl {
   // instruction to be emitted?
   std::vector<Node*> instructions_source_;
 
+  // what the interpreter actually runs: instructions_ with common sequences
+  // fused into superinstructions (see fuseInstructions). instructions_ stays
+  // in the plain form, which is what gets exported for mobile.
+  std::vector<Instruction> run_instructions_;
+  std::vector<Node*> run_instructions_source_;
+
   std::vector<IValue> constant_table_;
   std::vector<Operation> operator_table_;
   std::vector<Function*> function_table_;
@@ -388,6 +403,7 @@ struct CodeImpl {
     // we deferred the emission of bailout blocks so they appear at the end
     // emit them now and patch up the jumps
     insertBailoutBlocks();
+    fuseInstructions();
   }
 
   const std::vector<c10::IValue>& constant_table() const {
@@ -645,6 +661,92 @@ struct CodeImpl {
           instructions_source_[block.jf_instruction_index]);
     }
   }
+
+  static bool isJump(OpCode op) {
+    return op == JF || op == JMP || op == LOOP;
+  }
+
+  // registers of a superinstruction are kept in N, which is only 16 bits
+  static bool fitsInN(int64_t reg) {
+    return reg <= std::numeric_limits<uint16_t>::max();
+  }
+
+  // Builds run_instructions_ by fusing the sequences that make up most of the
+  // dispatches of small graphs:
+  //   STORE r, MOVE r  -> (nothing), the value just stays on the stack
+  //   OP, STORE r      -> OP_STORE
+  //   LOAD a, LOAD b   -> LOAD2
+  //   MOVE a, MOVE b   -> MOVE2
+  // A sequence is only fused if none of its instructions but the first is a
+  // jump target, and jump offsets are remapped to the fused positions.
+  void fuseInstructions() {
+    size_t n = instructions_.size();
+    std::vector<bool> is_target(n + 1, false);
+    for (size_t i = 0; i < n; ++i) {
+      if (isJump(instructions_[i].op)) {
+        is_target[i + instructions_[i].X] = true;
+      }
+    }
+    auto fusable = [&](size_t i, OpCode op) {
+      return i < n && !is_target[i] && instructions_[i].op == op;
+    };
+    auto elidesStore = [&](size_t i) {
+      return fusable(i, STORE) && fusable(i + 1, MOVE) &&
+          instructions_[i].X == instructions_[i + 1].X;
+    };
+
+    // new_index[i] is where execution continues in run_instructions_ when
+    // it reaches instructions_[i]
+    std::vector<int64_t> new_index(n + 1);
+    run_instructions_.reserve(n);
+    run_instructions_source_.reserve(n);
+    auto emit = [&](const Instruction& inst, Node* source) {
+      run_instructions_.push_back(inst);
+      run_instructions_source_.push_back(source);
+    };
+    size_t i = 0;
+    while (i < n) {
+      const Instruction& inst = instructions_[i];
+      new_index[i] = run_instructions_.size();
+      if (inst.op == STORE && elidesStore(i)) {
+        new_index[i + 1] = run_instructions_.size();
+        i += 2;
+        continue;
+      }
+      if (inst.op == OP && !elidesStore(i + 1) && fusable(i + 1, STORE) &&
+          fitsInN(instructions_[i + 1].X)) {
+        new_index[i + 1] = run_instructions_.size();
+        emit(
+            Instruction(OP_STORE, inst.X, instructions_[i + 1].X),
+            instructions_source_[i]);
+        i += 2;
+        continue;
+      }
+      if ((inst.op == LOAD || inst.op == MOVE) && fusable(i + 1, inst.op) &&
+          fitsInN(instructions_[i + 1].X)) {
+        new_index[i + 1] = run_instructions_.size();
+        emit(
+            Instruction(
+                inst.op == LOAD ? LOAD2 : MOVE2,
+                inst.X,
+                instructions_[i + 1].X),
+            instructions_source_[i]);
+        i += 2;
+        continue;
+      }
+      emit(inst, instructions_source_[i]);
+      ++i;
+    }
+    new_index[n] = run_instructions_.size();
+
+    for (size_t i = 0; i < n; ++i) {
+      if (isJump(instructions_[i].op)) {
+        Instruction& jump = run_instructions_[new_index[i]];
+        jump.X = new_index[i + instructions_[i].X] - new_index[i];
+      }
+    }
+  }
+
   void emitInterfaceCall(
       std::string method_name_str,
       c10::ArrayRef<Value*> inputs) {
@@ -789,7 +891,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 
     ActiveFrame(const Frame& frame)
         : pc(frame.pc),
-          instructions(frame.function->instructions_.data()),
+          instructions(frame.function->run_instructions_.data()),
           constants(frame.function->constant_table_.data()),
           operators(frame.function->operator_table_.data()),
           functions(frame.function->function_table_.data()),
@@ -842,6 +944,23 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       stack_start_ = 0;
     }
 
+#ifdef JIT_USE_COMPUTED_GOTO
+    static void* dispatch_table[] = {
+#define DISPATCH_LABEL(op, _) &&label_##op,
+        FORALL_OPCODES(DISPATCH_LABEL)
+#undef DISPATCH_LABEL
+    };
+#define INST(op) \
+  case op:       \
+  label_##op
+#define DISPATCH()               \
+  inst = af.instructions[af.pc]; \
+  goto* dispatch_table[inst.op]
+#else
+#define INST(op) case op
+#define DISPATCH() break
+#endif
+
     ActiveFrame af(frames.back());
     try {
       while (true) {
@@ -849,62 +968,77 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
 //         frames.back().function->dump(std::cout, af.pc);
         Instruction inst = af.instructions[af.pc];
         switch (inst.op) {
-          case OP:
+          INST(OP):
+            af.operators[inst.X](stack);
+            ++af.pc;
+            DISPATCH();
+          INST(OP_STORE):
             af.operators[inst.X](stack);
+            reg(inst.N) = pop(stack);
             ++af.pc;
-            break;
-          case OPN:
+            DISPATCH();
+          INST(OPN):
             AT_ERROR("OPN is currently supported in mobile mode only.");
-            break;
-          case LOAD:
+            DISPATCH();
+          INST(LOAD):
+            stack.emplace_back(reg(inst.X));
+            ++af.pc;
+            DISPATCH();
+          INST(MOVE):
+            stack.emplace_back(std::move(reg(inst.X)));
+            ++af.pc;
+            DISPATCH();
+          INST(LOAD2):
             stack.emplace_back(reg(inst.X));
+            stack.emplace_back(reg(inst.N));
             ++af.pc;
-            break;
-          case MOVE:
+            DISPATCH();
+          INST(MOVE2):
             stack.emplace_back(std::move(reg(inst.X)));
+            stack.emplace_back(std::move(reg(inst.N)));
             ++af.pc;
-            break;
-          case STORE:
+            DISPATCH();
+          INST(STORE):
             reg(inst.X) = pop(stack);
             ++af.pc;
-            break;
-          case STOREN:
+            DISPATCH();
+          INST(STOREN):
             for (size_t i = inst.N; i > 0; --i) {
               reg(inst.X + i - 1) = pop(stack);
             }
             ++af.pc;
-            break;
-          case DROP:
+            DISPATCH();
+          INST(DROP):
             pop(stack);
             ++af.pc;
-            break;
-          case DROPR:
+            DISPATCH();
+          INST(DROPR):
             reg(inst.X) = IValue();
             ++af.pc;
-            break;
-          case LOADC:
+            DISPATCH();
+          INST(LOADC):
             stack.emplace_back(af.constants[inst.X]);
             ++af.pc;
-            break;
-          case GET_ATTR: {
+            DISPATCH();
+          INST(GET_ATTR): {
             auto userObj = pop(stack).toObject();
             auto value = userObj->getSlot(inst.X);
             push(stack, std::move(value));
             ++af.pc;
-          } break;
-          case SET_ATTR: {
+          } DISPATCH();
+          INST(SET_ATTR): {
             auto v = pop(stack);
             auto userObj = pop(stack).toObject();
             userObj->setSlot(inst.X, std::move(v));
             ++af.pc;
-          } break;
-          case JF:
+          } DISPATCH();
+          INST(JF):
             af.pc += (pop(stack).toBool()) ? 1 : inst.X;
-            break;
-          case JMP:
+            DISPATCH();
+          INST(JMP):
             af.pc += inst.X;
-            break;
-          case LOOP: {
+            DISPATCH();
+          INST(LOOP): {
             // stack: iteration_count, max_iter, cond, loop_carried_deps...
             auto frame = stack.end() - (inst.N + 1);
             int64_t trip_count = frame[0].toInt();
@@ -922,15 +1056,15 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               drop(stack, 3); // iteration_count, max_iter, cond
               af.pc += inst.X;
             }
-          } break;
-          case CALL: {
+          } DISPATCH();
+          INST(CALL): {
             const Code& code =
                 af.functions[inst.X]->get_executor().getPlanFor(stack).code;
             frames.back().pc = af.pc + 1;
             enterFrame(code, stack.size() - code.num_inputs());
             af = ActiveFrame(frames.back());
-          } break;
-          case INTERFACE_CALL: {
+          } DISPATCH();
+          INST(INTERFACE_CALL): {
             // note the hash table lookup to find the function
             // this can be more optimized if necessary, caching parts
             // of the hashing computation or storing the offset when
@@ -943,12 +1077,12 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             frames.back().pc = af.pc + 1;
             enterFrame(code, stack.size() - inst.N);
             af = ActiveFrame(frames.back());
-          } break;
-          case RET:
+          } DISPATCH();
+          INST(RET):
             if (frames.size() > 1) {
               leaveFrame();
               af = ActiveFrame(frames.back());
-              break;
+              DISPATCH();
             }
             if (future_) {
               auto num_outputs = frames.back().function->n_outputs;
@@ -960,7 +1094,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
               }
             }
             return false;
-          case WAIT: {
+          INST(WAIT): {
             auto future = stack.back().toFuture();
             if (!future->completed()) {
               getOrCreateFuture();
@@ -1007,16 +1141,18 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             stack.pop_back();
             stack.emplace_back(future->value());
             ++af.pc;
-          } break;
-          case GUARD: {
+          } DISPATCH();
+          INST(GUARD): {
             auto t = stack.back().toTensor();
             auto actual = t.defined() ? TensorType::create(t)
                                       : TensorType::get()->withUndefined();
             const TypePtr &expected = af.types[inst.X];
-            push(stack, *expected == *actual);
+            // the properties the profile doesn't specialize on, e.g. the
+            // dimensions that varied, can be anything
+            push(stack, actual->isSubtypeOf(expected));
             ++af.pc;
-          } break;
-          case TAIL_CALL: {
+          } DISPATCH();
+          INST(TAIL_CALL): {
             af.functions[inst.X]->ensure_defined();
             const Code &code =
                 af.functions[inst.X]->get_executor().getPlanFor(stack).code;
@@ -1032,7 +1168,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
             leaveFrame();
             enterFrame(code, base_pointer);
             af = ActiveFrame(frames.back());
-          } break;
+          } DISPATCH();
         }
       }
     } catch (std::exception& e) {
@@ -1041,6 +1177,8 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       handleError(ExceptionMessage(e), is_jit_exception);
       return false;
     }
+#undef INST
+#undef DISPATCH
   }
 
   void formatStackTrace(std::ostream& out) {
@@ -1049,7 +1187,7 @@ struct InterpreterStateImpl : c10::intrusive_ptr_target {
       size_t pc = (i == 0) ? frame.pc
                            : frame.pc -
               1; // make sure we report the call node, not the node after it
-      Node* node = frame.function->instructions_source_[pc];
+      Node* node = frame.function->run_instructions_source_[pc];
       if (i > 0) {
         out << "during call ";
       }
@@ -37,6 +37,9 @@ void Function::append_instruction(OpCode op, int X, int N) {
   TORCH_CHECK(isOpSupportedInMobile(op), toString(op),
               " is not supported in mobile module.");
   code_->instructions_.emplace_back(op, X, N);
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+  code_->profile_.emplace_back();
+#endif
 }
 
 void Function::append_operator(const std::string& name,
@@ -50,6 +53,7 @@ void Function::append_operator(const std::string& name,
   auto op = c10::Dispatcher::singleton().findSchema(opname);
   TORCH_CHECK(op.has_value(), opname.name, ".", opname.overload_name, " cannot be found.");
   code_->operators_.emplace_back(op);
+  code_->op_caches_.emplace_back();
 }
 
 void Function::build_vararg_operator_table() {
@@ -84,6 +88,10 @@ void Function::set_register_size(size_t size) {
   code_->register_size_ = size;
 }
 
+void Function::print_profile(std::ostream& out) const {
+  printProfile(*code_, out);
+}
+
 bool Function::run(Stack& stack) const {
   InterpreterState interp_state(code_);
   return interp_state.run(stack);
@@ -1,6 +1,7 @@
 #pragma once
 #include <ATen/core/ivalue.h>
 //#include <aten/src/Aten/core/operator_name.h>
+#include <ostream>
 #include <vector>
 
 namespace torch{
@@ -15,6 +16,9 @@ class Function{
  public:
   Function(c10::QualifiedName name);
   bool run(Stack& stack) const;
+  // Time spent in each instruction, needs a build with
+  // PYTORCH_MOBILE_INTERPRETER_PROFILING defined.
+  void print_profile(std::ostream& out) const;
   const std::string& name() const;
   const c10::QualifiedName& qualname() const;
   void append_instruction(OpCode op, int X, int N);
@@ -4,6 +4,8 @@
 #include <torch/csrc/jit/unpickler.h>
 #include <caffe2/serialize/inline_container.h>
 #include <torch/csrc/jit/instruction.h>
+#include <torch/csrc/jit/weight_compression.h>
+#include "caffe2/serialize/mmap_file_adapter.h"
 
 
 #include <fstream>
@@ -36,6 +38,7 @@ namespace torch {
 namespace jit {
 using caffe2::serialize::PyTorchStreamReader;
 using caffe2::serialize::IStreamAdapter;
+using caffe2::serialize::MmapFileAdapter;
 using caffe2::serialize::ReadAdapterInterface;
 
 OpCode parseOpCode(const char *str);
@@ -170,11 +173,18 @@ c10::IValue BytecodeDeserializer::readArchive(const std::string& archive_name) {
     return obj;
   };
 
-  auto read_record = [&](const std::string& name) {
+  RecordReader read_record = [&](const std::string& name) {
     std::stringstream ss;
     ss << archive_name << "/" << name;
     return std::get<0>(reader_->getRecord(ss.str()));
   };
+  // Compressed weights are decoded from the record, which aliases the file
+  // when it is memory mapped, so only the decoded copy takes memory.
+  if (archive_name == "data" &&
+      reader_->hasRecord(std::string(kWeightCompressionArchive) + ".pkl")) {
+    read_record = decompressingRecordReader(
+        readArchive(kWeightCompressionArchive), std::move(read_record));
+  }
 
   Unpickler unpickler(reader, std::move(class_resolver),
                       std::move(obj_loader), std::move(read_record), device_);
@@ -195,7 +205,9 @@ mobile::Module _load_for_mobile(
 mobile::Module _load_for_mobile(
     const std::string& filename,
     c10::optional<at::Device> device) {
-  std::unique_ptr<FileAdapter> rai = caffe2::make_unique<FileAdapter>(filename);
+  // Uncompressed records alias the mapping instead of being read into memory
+  std::unique_ptr<MmapFileAdapter> rai =
+      caffe2::make_unique<MmapFileAdapter>(filename);
   auto module = _load_for_mobile(std::move(rai), device);
   return module;
 }
@@ -2,6 +2,11 @@
 #include <torch/csrc/jit/mobile/function.h>
 #include <ATen/core/operator_name.h>
 
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+#include <chrono>
+#include <iomanip>
+#endif
+
 namespace torch{
 namespace jit{
 char const * toString(OpCode op);
@@ -20,6 +25,26 @@ void listConstruct(Stack& stack, int num_inputs) {
   drop(stack, num_inputs);
   push(stack, std::move(vals));
 }
+
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+// Adds the time until it is destroyed to an instruction's profile.
+class InstructionTimer {
+ public:
+  explicit InstructionTimer(InstructionProfile& profile)
+      : profile_(profile), start_(std::chrono::steady_clock::now()) {}
+
+  ~InstructionTimer() {
+    ++profile_.count;
+    profile_.total_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                             std::chrono::steady_clock::now() - start_)
+                             .count();
+  }
+
+ private:
+  InstructionProfile& profile_;
+  std::chrono::steady_clock::time_point start_;
+};
+#endif
 }
 
 bool InterpreterState::run(Stack& stack) {
@@ -35,9 +60,13 @@ bool InterpreterState::run(Stack& stack) {
 //      }
 //    }
     Instruction inst = code_->instructions_[pc];
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+    InstructionTimer timer(code_->profile_[pc]);
+#endif
     switch (inst.op) {
       case OP: {
-        c10::Dispatcher::singleton().callBoxed(*code_->operators_[inst.X], &stack);
+        c10::Dispatcher::singleton().callBoxed(
+            *code_->operators_[inst.X], &stack, &code_->op_caches_[inst.X]);
         ++pc;
       } break;
       case OPN: {
@@ -124,6 +153,38 @@ IValue& InterpreterState::reg(size_t reg) {
   return *(registers_.end() - reg);
 }
 
+void printProfile(const Code& code, std::ostream& out) {
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+  uint64_t total_ns = 0;
+  for (const auto& profile : code.profile_) {
+    total_ns += profile.total_ns;
+  }
+  out << "pc  count  total_us  avg_ns  %  instruction\n";
+  for (size_t pc = 0; pc < code.instructions_.size(); ++pc) {
+    const auto& inst = code.instructions_[pc];
+    const auto& profile = code.profile_[pc];
+    out << pc << "  " << profile.count << "  " << profile.total_ns / 1000
+        << "  " << (profile.count ? profile.total_ns / profile.count : 0)
+        << "  " << std::fixed << std::setprecision(1)
+        << (total_ns ? 100.0 * profile.total_ns / total_ns : 0.0) << "  "
+        << inst;
+    if (inst.op == OP) {
+      const auto& name = code.op_names_[inst.X];
+      out << " " << name.name;
+      if (!name.overload_name.empty()) {
+        out << "." << name.overload_name;
+      }
+    }
+    out << "\n";
+  }
+#else
+  TORCH_CHECK(
+      false,
+      "The interpreter profile needs a build with "
+      "PYTORCH_MOBILE_INTERPRETER_PROFILING defined.");
+#endif
+}
+
 } // namespace mobile
 } // namespace torch
 } // namespace jit
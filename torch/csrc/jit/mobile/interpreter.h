@@ -9,15 +9,35 @@ namespace jit{
 namespace mobile {
 using Stack = std::vector<c10::IValue>;
 using VarargFuncton = std::function<void(int, Stack&)>;
+
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+// Time spent in an instruction, over all the runs of its function. The
+// counters aren't atomic, profile runs from a single thread.
+struct InstructionProfile {
+  uint64_t count = 0;
+  uint64_t total_ns = 0;
+};
+#endif
+
 struct Code {
   std::vector<Instruction> instructions_;
   std::vector<c10::OperatorName> op_names_;
   std::vector<c10::optional<c10::OperatorHandle>> operators_;
+  // One per operator, i.e. per OP instruction. Remembers the kernel the
+  // instruction dispatched to last, see c10::DispatchCache.
+  std::vector<c10::DispatchCache> op_caches_;
   std::vector<VarargFuncton> vararg_operators_;
   std::vector<c10::IValue> constants_;
   size_t register_size_; // Aggregated output size.
+#ifdef PYTORCH_MOBILE_INTERPRETER_PROFILING
+  std::vector<InstructionProfile> profile_; // indexed like instructions_
+#endif
 };
 
+// Prints the time spent in each instruction of `code`. Only available in
+// builds with PYTORCH_MOBILE_INTERPRETER_PROFILING defined.
+void printProfile(const Code& code, std::ostream& out);
+
 struct InterpreterState {
   TORCH_API explicit InterpreterState(std::shared_ptr<Code> code);
   TORCH_API bool run(Stack& stack);
@@ -35,6 +35,13 @@ Function* Module::find_method(const std::string& basename) const {
   return nullptr;
 }
 
+void Module::print_profile(std::ostream& out) const {
+  for (auto& fn : cu_->methods()) {
+    out << fn->qualname().qualifiedName() << ":\n";
+    fn->print_profile(out);
+  }
+}
+
 } // namespace mobile
 } // namespace torch
 } // namespace jit
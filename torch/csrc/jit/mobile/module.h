@@ -23,6 +23,9 @@ class TORCH_API Module {
       : object_(object), cu_(cu) {};
   c10::IValue run_method(const std::string& method_name, Stack& stack);
   Function* find_method(const std::string& basename) const;
+  // Time spent in each instruction of the methods, needs a build with
+  // PYTORCH_MOBILE_INTERPRETER_PROFILING defined.
+  void print_profile(std::ostream& out) const;
  private:
   c10::intrusive_ptr<c10::ivalue::Object> object_;
   std::shared_ptr<CompilationUnit> cu_;
@@ -0,0 +1,264 @@
+#include <torch/csrc/jit/model_server.h>
+
+#include <ATen/Parallel.h>
+#include <ATen/core/grad_mode.h>
+#include <c10/util/Exception.h>
+#include <torch/csrc/utils/memory.h>
+
+#include <future>
+#include <numeric>
+
+namespace torch {
+namespace jit {
+
+constexpr size_t ModelServer::Metrics::kLatencyBuckets;
+
+namespace {
+
+size_t latencyBucket(std::chrono::microseconds latency) {
+  size_t bucket = 0;
+  for (auto us = latency.count(); us > 0; us >>= 1) {
+    bucket++;
+  }
+  return std::min(bucket, ModelServer::Metrics::kLatencyBuckets - 1);
+}
+
+} // namespace
+
+std::chrono::microseconds ModelServer::Metrics::latencyPercentile(
+    double p) const {
+  uint64_t total = 0;
+  for (auto count : latency_histogram) {
+    total += count;
+  }
+  const uint64_t rank = static_cast<uint64_t>(p * total);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kLatencyBuckets; ++i) {
+    seen += latency_histogram[i];
+    if (seen > rank || seen == total) {
+      return std::min(std::chrono::microseconds(int64_t(1) << i), max_latency);
+    }
+  }
+  return max_latency;
+}
+
+ModelServer::ModelServer() : ModelServer(Options()) {}
+
+ModelServer::ModelServer(Options options)
+    : workers_per_priority_(options.workers_per_priority),
+      models_by_priority_(options.workers_per_priority.size()),
+      next_model_(options.workers_per_priority.size(), 0) {
+  TORCH_CHECK(
+      !options.workers_per_priority.empty(),
+      "ModelServer needs at least one priority");
+  for (size_t priority = 0; priority < options.workers_per_priority.size();
+       ++priority) {
+    for (size_t i = 0; i < options.workers_per_priority[priority]; ++i) {
+      workers_.emplace_back(&ModelServer::loop, this, priority);
+    }
+  }
+}
+
+ModelServer::~ModelServer() {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ModelServer::addModel(const std::string& name, script::Module module) {
+  addModel(name, std::move(module), ModelOptions());
+}
+
+void ModelServer::addModel(
+    const std::string& name,
+    script::Module module,
+    ModelOptions options) {
+  TORCH_CHECK(
+      options.priority >= 0 &&
+          options.priority < static_cast<int>(models_by_priority_.size()),
+      "Model priority ",
+      options.priority,
+      " is out of range, the server has ",
+      models_by_priority_.size(),
+      " priorities");
+  TORCH_CHECK(options.max_concurrency > 0, "max_concurrency must be positive");
+  TORCH_CHECK(
+      std::accumulate(
+          workers_per_priority_.begin() + options.priority,
+          workers_per_priority_.end(),
+          size_t(0)) > 0,
+      "No worker of the server runs requests of priority ",
+      options.priority);
+  // Fail here rather than on the first request.
+  module.get_method(options.method_name);
+
+  std::lock_guard<std::mutex> guard(mutex_);
+  TORCH_CHECK(!models_.count(name), "Model ", name, " was already added");
+  auto model = torch::make_unique<Model>();
+  model->module = std::move(module);
+  model->options = std::move(options);
+  models_by_priority_[model->options.priority].push_back(model.get());
+  models_.emplace(name, std::move(model));
+}
+
+void ModelServer::runAsync(
+    const std::string& name,
+    std::vector<IValue> inputs,
+    Callback callback,
+    Clock::time_point deadline) {
+  {
+    std::lock_guard<std::mutex> guard(mutex_);
+    auto it = models_.find(name);
+    TORCH_CHECK(it != models_.end(), "Unknown model ", name);
+    Model* model = it->second.get();
+    const size_t max_queue_size = model->options.max_queue_size;
+    if (!stop_ &&
+        (max_queue_size == 0 || model->queue.size() < max_queue_size)) {
+      model->queue.push_back(Request{
+          std::move(inputs), std::move(callback), Clock::now(), deadline});
+      model->metrics.queued++;
+      callback = nullptr;
+    } else {
+      model->metrics.rejected++;
+    }
+  }
+  if (callback) {
+    callback(Result{Status::REJECTED, IValue(), ""});
+    return;
+  }
+  cv_.notify_all();
+}
+
+ModelServer::Result ModelServer::run(
+    const std::string& name,
+    std::vector<IValue> inputs,
+    Clock::time_point deadline) {
+  auto promise = std::make_shared<std::promise<Result>>();
+  auto future = promise->get_future();
+  runAsync(
+      name,
+      std::move(inputs),
+      [promise](Result result) { promise->set_value(std::move(result)); },
+      deadline);
+  return future.get();
+}
+
+ModelServer::Metrics ModelServer::metrics(const std::string& name) const {
+  std::lock_guard<std::mutex> guard(mutex_);
+  auto it = models_.find(name);
+  TORCH_CHECK(it != models_.end(), "Unknown model ", name);
+  return it->second->metrics;
+}
+
+ModelServer::Model* ModelServer::nextModel(int priority) {
+  for (int p = 0; p <= priority; ++p) {
+    auto& models = models_by_priority_[p];
+    for (size_t i = 0; i < models.size(); ++i) {
+      const size_t index = (next_model_[p] + i) % models.size();
+      Model* model = models[index];
+      if (!model->queue.empty() &&
+          model->metrics.running < model->options.max_concurrency) {
+        next_model_[p] = index + 1;
+        return model;
+      }
+    }
+  }
+  return nullptr;
+}
+
+bool ModelServer::hasQueued(int priority) const {
+  for (int p = 0; p <= priority; ++p) {
+    for (const Model* model : models_by_priority_[p]) {
+      if (!model->queue.empty()) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void ModelServer::record(
+    Model* model,
+    const Request& request,
+    Clock::time_point started,
+    Clock::time_point finished,
+    bool failed) {
+  using std::chrono::duration_cast;
+  using std::chrono::microseconds;
+  auto& metrics = model->metrics;
+  metrics.running--;
+  if (failed) {
+    metrics.failed++;
+  } else {
+    metrics.completed++;
+  }
+  metrics.total_queue_time +=
+      duration_cast<microseconds>(started - request.enqueued);
+  metrics.total_run_time += duration_cast<microseconds>(finished - started);
+  const auto latency = duration_cast<microseconds>(finished - request.enqueued);
+  metrics.max_latency = std::max(metrics.max_latency, latency);
+  metrics.latency_histogram[latencyBucket(latency)]++;
+}
+
+void ModelServer::loop(int priority) {
+  at::init_num_threads();
+  at::AutoGradMode no_grad(false);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    Model* model = nextModel(priority);
+    if (!model) {
+      // Requests queued behind the concurrency limit of their model keep the
+      // workers running until they are run too.
+      if (stop_ && !hasQueued(priority)) {
+        return;
+      }
+      cv_.wait(lock);
+      continue;
+    }
+    Request request = std::move(model->queue.front());
+    model->queue.pop_front();
+    model->metrics.queued--;
+
+    const auto started = Clock::now();
+    if (started > request.deadline) {
+      model->metrics.expired++;
+      lock.unlock();
+      request.callback(Result{Status::EXPIRED, IValue(), ""});
+      lock.lock();
+      continue;
+    }
+    model->metrics.running++;
+    lock.unlock();
+
+    Result result{Status::OK, IValue(), ""};
+    try {
+      result.output = model->module.get_method(model->options.method_name)(
+          std::move(request.inputs));
+    } catch (const std::exception& e) {
+      result.status = Status::FAILED;
+      result.error = e.what();
+    }
+    const auto finished = Clock::now();
+
+    lock.lock();
+    record(model, request, started, finished, result.status != Status::OK);
+    // The request freed a slot of the model, which idle workers may be
+    // waiting for, or waiting to shut down.
+    const bool notify = !model->queue.empty() || stop_;
+    lock.unlock();
+    if (notify) {
+      cv_.notify_all();
+    }
+    request.callback(std::move(result));
+    lock.lock();
+  }
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/script/module.h>
+
+namespace torch {
+namespace jit {
+
+// Runs the requests to many scripted modules of one process on a fixed set of
+// worker threads.
+//
+// Every model is given a priority, 0 being the highest. Each priority has
+// workers of its own, which only run the requests of that priority or of the
+// higher ones, the highest first: the requests to high priority models never
+// wait behind those to low priority ones, and can use the idle workers of the
+// lower priorities. The models of a priority are served round robin.
+//
+// Every model has a limit on the requests it runs at once, and on the
+// requests waiting for it: requests beyond that are rejected right away. A
+// request that is still queued at its deadline is dropped without being run.
+//
+// The models run with gradients disabled. Their intra-op parallelism comes
+// from the ATen thread pool, which is shared by all the workers; the total
+// number of workers times at::get_num_threads() should stay around the
+// number of cores.
+class TORCH_API ModelServer {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Status {
+    OK,
+    // The queue of the model was full, or the server is shutting down.
+    REJECTED,
+    // The deadline passed before the request could be started.
+    EXPIRED,
+    // The model threw, see Result::error.
+    FAILED,
+  };
+
+  struct Result {
+    Status status;
+    IValue output;
+    std::string error;
+  };
+
+  using Callback = std::function<void(Result result)>;
+
+  struct Options {
+    // The number of workers of every priority, from the highest.
+    std::vector<size_t> workers_per_priority{4};
+  };
+
+  struct ModelOptions {
+    int priority = 0;
+    // The most requests to the model run at once.
+    size_t max_concurrency = 1;
+    // The most requests waiting for the model, 0 for no limit.
+    size_t max_queue_size = 0;
+    std::string method_name = "forward";
+  };
+
+  struct Metrics {
+    // Latencies, from the time a request is queued to the time its output
+    // is ready, are counted in buckets of powers of two microseconds:
+    // latency_histogram[i] counts the ones in [2^(i-1), 2^i) us.
+    static constexpr size_t kLatencyBuckets = 32;
+
+    uint64_t completed = 0;
+    uint64_t failed = 0;
+    uint64_t rejected = 0;
+    uint64_t expired = 0;
+    size_t queued = 0;
+    size_t running = 0;
+    std::chrono::microseconds total_queue_time{0};
+    std::chrono::microseconds total_run_time{0};
+    std::chrono::microseconds max_latency{0};
+    std::array<uint64_t, kLatencyBuckets> latency_histogram{};
+
+    // An upper bound of the latency of the fraction `p` of the completed
+    // and failed requests, from the histogram.
+    std::chrono::microseconds latencyPercentile(double p) const;
+  };
+
+  ModelServer();
+  explicit ModelServer(Options options);
+
+  // Stops accepting requests, runs the ones still queued, then stops the
+  // workers.
+  ~ModelServer();
+
+  // Adds `module` under `name`. Models can be added while the server runs.
+  void addModel(const std::string& name, script::Module module);
+  void addModel(
+      const std::string& name,
+      script::Module module,
+      ModelOptions options);
+
+  // Queues a request and returns right away. `callback` is called from a
+  // worker, or from this thread if the request is rejected.
+  void runAsync(
+      const std::string& name,
+      std::vector<IValue> inputs,
+      Callback callback,
+      Clock::time_point deadline = Clock::time_point::max());
+
+  // Queues a request and waits for its result.
+  Result run(
+      const std::string& name,
+      std::vector<IValue> inputs,
+      Clock::time_point deadline = Clock::time_point::max());
+
+  Metrics metrics(const std::string& name) const;
+
+ private:
+  struct Request {
+    std::vector<IValue> inputs;
+    Callback callback;
+    Clock::time_point enqueued;
+    Clock::time_point deadline;
+  };
+
+  struct Model {
+    script::Module module;
+    ModelOptions options;
+    std::deque<Request> queue;
+    Metrics metrics;
+  };
+
+  void loop(int priority);
+
+  // The model whose request a worker of `priority` runs next, nullptr if
+  // none can be run. Must be called with mutex_ held.
+  Model* nextModel(int priority);
+
+  // Whether a request of `priority` or a higher one is queued. Must be called
+  // with mutex_ held.
+  bool hasQueued(int priority) const;
+
+  void record(
+      Model* model,
+      const Request& request,
+      Clock::time_point started,
+      Clock::time_point finished,
+      bool failed);
+
+  const std::vector<size_t> workers_per_priority_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, std::unique_ptr<Model>> models_;
+  // The models of every priority, and the index of the next one to serve.
+  std::vector<std::vector<Model*>> models_by_priority_;
+  std::vector<size_t> next_model_;
+  bool stop_ = false;
+
+  std::vector<std::thread> workers_;
+};
+
+} // namespace jit
+} // namespace torch
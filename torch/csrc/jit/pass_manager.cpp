@@ -1,5 +1,12 @@
 #include <torch/csrc/jit/pass_manager.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
 namespace torch {
 namespace jit {
 
@@ -12,5 +19,72 @@ RegisterPass::RegisterPass(Pass p) {
   getCustomPasses().emplace_back(std::move(p));
 }
 
+namespace {
+
+bool passTimingFromEnv() {
+  const char* env = std::getenv("PYTORCH_JIT_PASS_TIMING");
+  return env && std::strcmp(env, "1") == 0;
+}
+
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Passes take micro- to milliseconds, so a lock is cheap enough here.
+std::mutex pass_timings_mutex;
+
+std::unordered_map<std::string, PassTiming>& passTimings() {
+  static std::unordered_map<std::string, PassTiming> timings;
+  return timings;
+}
+
+} // namespace
+
+std::atomic<bool>& getPassTimingMode() {
+  static std::atomic<bool> pass_timing_mode{passTimingFromEnv()};
+  return pass_timing_mode;
+}
+
+std::vector<PassTiming> getPassTimings() {
+  std::vector<PassTiming> result;
+  {
+    std::lock_guard<std::mutex> guard(pass_timings_mutex);
+    for (const auto& entry : passTimings()) {
+      result.push_back(entry.second);
+    }
+  }
+  std::sort(
+      result.begin(),
+      result.end(),
+      [](const PassTiming& a, const PassTiming& b) {
+        return a.total_ns > b.total_ns;
+      });
+  return result;
+}
+
+void resetPassTimings() {
+  std::lock_guard<std::mutex> guard(pass_timings_mutex);
+  passTimings().clear();
+}
+
+PassTimer::PassTimer(const char* name)
+    : name_(name), start_ns_(getPassTimingMode() ? nowNs() : 0) {}
+
+PassTimer::~PassTimer() {
+  if (start_ns_ == 0) {
+    return;
+  }
+  const int64_t elapsed_ns = nowNs() - start_ns_;
+  std::lock_guard<std::mutex> guard(pass_timings_mutex);
+  PassTiming& timing = passTimings()[name_];
+  if (timing.name.empty()) {
+    timing.name = name_;
+  }
+  timing.count++;
+  timing.total_ns += elapsed_ns;
+}
+
 } // namespace jit
 } // namespace torch
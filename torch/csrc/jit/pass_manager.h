@@ -2,6 +2,11 @@
 
 #include <torch/csrc/jit/ir.h>
 
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
 /* `getCustomPasses()` returns a vector of passes that will be executed after
  * differentiation but before any fusion.  This is the de-facto location
  * for compiler backends to insert passes.
@@ -11,6 +16,11 @@
  *
  * pass_manager.h uses a Meyer's singleton
  * to store a vector of `Pass`es, which modify the IR graph in place.
+ *
+ * Passes run by the graph executor are timed with a `PassTimer` when
+ * `getPassTimingMode()` is set, and `getPassTimings()` reports how often each
+ * ran and for how long, e.g. to find the passes worth skipping under a
+ * compile-time budget (see getCompileTimeBudget() in graph_executor.h).
  */
 
 namespace torch {
@@ -25,5 +35,35 @@ struct TORCH_API RegisterPass {
   RegisterPass(Pass p);
 };
 
+// The number of runs of a pass and the time they took.
+struct PassTiming {
+  std::string name;
+  int64_t count = 0;
+  int64_t total_ns = 0;
+};
+
+// When set, PassTimers record the time of the passes they cover. Off by
+// default, or on if PYTORCH_JIT_PASS_TIMING=1 is set.
+TORCH_API std::atomic<bool>& getPassTimingMode();
+
+// The timings recorded since the last reset, longest total time first.
+TORCH_API std::vector<PassTiming> getPassTimings();
+TORCH_API void resetPassTimings();
+
+// Adds the time from its construction to its destruction to the timing of
+// the pass `name`, if pass timing is on.
+struct TORCH_API PassTimer {
+  explicit PassTimer(const char* name);
+  ~PassTimer();
+
+  PassTimer(const PassTimer&) = delete;
+  PassTimer& operator=(const PassTimer&) = delete;
+
+ private:
+  const char* name_;
+  // 0 if pass timing was off when the timer was created.
+  int64_t start_ns_;
+};
+
 } // namespace jit
 } // namespace torch
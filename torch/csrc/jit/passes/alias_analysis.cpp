@@ -323,10 +323,12 @@ void AliasDb::analyzeImpl(Node* node) {
     case prim::FusedConcat:
     case prim::MMTreeReduce:
     case prim::MMBatchSide:
+    case prim::MMBatchIndependent:
     case prim::BroadcastSizes:
     case prim::ChunkSizes:
     case prim::Function:
     case prim::CreateObject:
+    case prim::MemoryArena:
       return analyzeCreator(node);
     case prim::DictConstruct:
     case prim::ListConstruct:
@@ -356,6 +358,7 @@ void AliasDb::analyzeImpl(Node* node) {
       makePointerTo(node->output(), node->inputs().at(1));
       return;
     case prim::Guard:
+    case prim::ArenaTensor:
       makePointerTo(node->output(), node->inputs().at(0));
       return;
     case prim::CallFunction:
@@ -1233,6 +1236,7 @@ bool aliasAnalysisHasSpecialCaseFor(Symbol symbol) {
       prim::GradOf,
       prim::MMTreeReduce,
       prim::MMBatchSide,
+      prim::MMBatchIndependent,
       prim::BroadcastSizes,
       prim::ChunkSizes,
       prim::Function,
@@ -1255,6 +1259,8 @@ bool aliasAnalysisHasSpecialCaseFor(Symbol symbol) {
       aten::wait,
       prim::isinstance,
       prim::unchecked_cast,
+      prim::MemoryArena,
+      prim::ArenaTensor,
   };
 
   // Operators that should not be used by alias analysis
@@ -459,6 +459,194 @@ void BatchMMSide(Block* block, AliasDb& alias_db) {
   }
 }
 
+// Products that are independent of each other, e.g. the projections of the
+// heads of a multi-head model, can be computed by a single bmm when their
+// operands have the same shapes:
+//
+//   O1 = L1 R1, O2 = L2 R2, ...   =>   O = bmm(stack(L), stack(R)),
+//                                      O1, O2, ... = unbind(O)
+//
+// aten::mm, aten::matmul and aten::linear (through baddbmm for its bias) are
+// batched. The shapes are usually unknown when the graph is optimized, so
+// prim::MMBatchIndependent takes all the independent products of a block and
+// groups those with matching shapes when it runs. Only 2-D products that are
+// small enough for the kernel launches to cost more than stacking the
+// operands are batched, the others run one by one.
+
+// Tunable parameters.
+static constexpr size_t min_independent_batch_size = 4;
+static constexpr int64_t max_batched_mm_work = 128 * 128 * 128;
+
+bool have_same_shape_and_type(const at::Tensor& a, const at::Tensor& b) {
+  if (!a.defined() || !b.defined()) {
+    return a.defined() == b.defined();
+  }
+  return a.sizes() == b.sizes() && a.scalar_type() == b.scalar_type() &&
+      a.device() == b.device();
+}
+
+bool shape_is_fast_for_batch(
+    const at::Tensor& lhs,
+    const at::Tensor& rhs,
+    const at::Tensor& bias) {
+  return lhs.dim() == 2 && rhs.dim() == 2 &&
+      (!bias.defined() || (bias.dim() >= 1 && bias.dim() <= 2)) &&
+      lhs.size(0) * lhs.size(1) * rhs.size(1) <= max_batched_mm_work;
+}
+
+// rhs is the transposed weight for aten::linear
+at::Tensor independent_mm(
+    const at::Tensor& lhs,
+    const at::Tensor& rhs,
+    const at::Tensor& bias) {
+  if (bias.defined() && lhs.dim() == 2) {
+    return at::addmm(bias, lhs, rhs);
+  }
+  auto output = at::matmul(lhs, rhs);
+  if (bias.defined()) {
+    output.add_(bias);
+  }
+  return output;
+}
+
+RegisterOperators mm_batch_independent_reg({Operator(
+    prim::MMBatchIndependent,
+    [](const Node* node) -> Operation {
+      // the inputs are the lhses, the rhses and the biases (or None)
+      size_t num_mms = node->inputs().size() / 3;
+      return [num_mms](Stack& stack) {
+        std::vector<at::Tensor> inputs;
+        inputs.reserve(3 * num_mms);
+        for (auto it = stack.end() - 3 * num_mms; it != stack.end(); ++it) {
+          inputs.push_back(
+              it->isNone() ? at::Tensor() : std::move(*it).toTensor());
+        }
+        drop(stack, 3 * num_mms);
+        auto lhs = at::TensorList(inputs).slice(0, num_mms);
+        auto rhs = at::TensorList(inputs).slice(num_mms, num_mms);
+        auto bias = at::TensorList(inputs).slice(2 * num_mms);
+
+        std::vector<at::Tensor> outputs(num_mms);
+        for (size_t i = 0; i < num_mms; ++i) {
+          if (outputs[i].defined()) {
+            continue;
+          }
+          std::vector<size_t> batch{i};
+          if (shape_is_fast_for_batch(lhs[i], rhs[i], bias[i])) {
+            for (size_t j = i + 1; j < num_mms; ++j) {
+              if (!outputs[j].defined() &&
+                  have_same_shape_and_type(lhs[i], lhs[j]) &&
+                  have_same_shape_and_type(rhs[i], rhs[j]) &&
+                  have_same_shape_and_type(bias[i], bias[j])) {
+                batch.push_back(j);
+              }
+            }
+          }
+          if (batch.size() == 1) {
+            outputs[i] = independent_mm(lhs[i], rhs[i], bias[i]);
+            continue;
+          }
+          auto gather = [&batch](at::TensorList tensors) {
+            return at::stack(
+                fmap(batch, [&tensors](size_t k) { return tensors[k]; }), 0);
+          };
+          at::Tensor batched;
+          if (bias[i].defined()) {
+            auto batched_bias = gather(bias);
+            if (bias[i].dim() == 1) {
+              batched_bias = batched_bias.unsqueeze(1);
+            }
+            batched = at::baddbmm(batched_bias, gather(lhs), gather(rhs));
+          } else {
+            batched = at::bmm(gather(lhs), gather(rhs));
+          }
+          auto results = batched.unbind(0);
+          for (size_t k = 0; k < batch.size(); ++k) {
+            outputs[batch[k]] = std::move(results[k]);
+          }
+        }
+        stack.insert(
+            stack.end(),
+            std::make_move_iterator(outputs.begin()),
+            std::make_move_iterator(outputs.end()));
+        return 0;
+      };
+    },
+    aliasAnalysisIsSpecialCase())});
+
+bool isIndependentMMCandidate(Node* node) {
+  return node->matches("aten::mm(Tensor self, Tensor mat2) -> Tensor") ||
+      node->matches("aten::matmul(Tensor self, Tensor other) -> Tensor") ||
+      node->matches(
+          "aten::linear(Tensor input, Tensor weight, Tensor? bias=None) -> Tensor");
+}
+
+void batchIndependentMMs(Block* block, AliasDb& alias_db) {
+  std::vector<Node*> mms;
+  for (Node* node : block->nodes()) {
+    if (isIndependentMMCandidate(node)) {
+      mms.push_back(node);
+    }
+  }
+
+  // Keep the products that don't depend on an earlier one, see
+  // gatherIndependentMMUses.
+  std::vector<Node*> independent;
+  for (Node* mm : mms) {
+    bool depends = std::any_of(
+        independent.begin(), independent.end(), [&](Node* earlier) {
+          return !alias_db.couldMoveBeforeTopologically(mm, earlier);
+        });
+    if (!depends) {
+      independent.push_back(mm);
+    }
+  }
+  if (independent.size() < min_independent_batch_size) {
+    return;
+  }
+
+  for (int64_t i = static_cast<int64_t>(independent.size()) - 2; i >= 0;
+       --i) {
+    if (!alias_db.moveBeforeTopologicallyValid(
+            independent[i], independent[i + 1])) {
+      // the products moved so far are still computed correctly
+      return;
+    }
+  }
+  WithInsertPoint insert_guard{independent[0]};
+  Graph* graph = block->owningGraph();
+  std::vector<Value*> inputs;
+  for (Node* mm : independent) {
+    inputs.push_back(mm->inputs().at(0));
+  }
+  for (Node* mm : independent) {
+    inputs.push_back(
+        mm->kind() == aten::linear ? graph->insert(aten::t, {mm->input(1)})
+                                   : mm->input(1));
+  }
+  Value* none = graph->insertConstant(IValue());
+  for (Node* mm : independent) {
+    inputs.push_back(mm->kind() == aten::linear ? mm->input(2) : none);
+  }
+  Node* batch_mm = graph->insertNode(graph->create(
+      prim::MMBatchIndependent, inputs, /*num_outputs=*/independent.size()));
+  for (size_t i = 0; i < independent.size(); ++i) {
+    batch_mm->outputs().at(i)->setType(independent[i]->output()->type());
+    independent[i]->output()->replaceAllUsesWith(batch_mm->outputs().at(i));
+  }
+}
+
+void BatchMMIndependent(Block* block, AliasDb& alias_db) {
+  // The nested blocks are handled last, so that the alias analysis doesn't
+  // see the nodes inserted in them when moving the nodes of this block.
+  batchIndependentMMs(block, alias_db);
+  for (Node* node : block->nodes()) {
+    for (Block* subblock : node->blocks()) {
+      BatchMMIndependent(subblock, alias_db);
+    }
+  }
+}
+
 bool hasMutableOperators(Block* block) {
   for (auto n : block->nodes()) {
     if (n->kind().is_aten() && n->schema().is_mutable())
@@ -479,6 +667,10 @@ void BatchMM(std::shared_ptr<Graph>& graph) {
   AliasDb alias_db(graph);
   BatchMMTreeReduce(graph->block());
   BatchMMSide(graph->block(), alias_db);
+  // Drop the products batched above, and look at the graph again.
+  EliminateDeadCode(graph);
+  AliasDb independent_alias_db(graph);
+  BatchMMIndependent(graph->block(), independent_alias_db);
   EliminateDeadCode(graph);
   // It's possible that transpose rearrangements have created sequences of
   // consecutive transposes that didn't exist before.
@@ -24,6 +24,7 @@ std::unordered_set<Symbol> skip_list = {
     prim::AutogradZero,
     prim::Uninitialized,
     prim::unchecked_unwrap_optional, // TODO remove
+    prim::MemoryArena, // hands out scratch memory for the run
     // TODO (zach): we should consider skipping tensor factories in the cases
     // where the constant tensor would be large but cheap to create.
 };
@@ -0,0 +1,266 @@
+#include <torch/csrc/jit/passes/convert_to_mkldnn.h>
+
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Whether `v` may be a float CPU tensor with `dim` dimensions, if `dim` isn't
+// -1. Values whose types are unknown are assumed to be.
+bool mayBeFloatCpuTensor(Value* v, int64_t dim = -1) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type) {
+    return false;
+  }
+  if (type->scalarType() && *type->scalarType() != at::kFloat) {
+    return false;
+  }
+  if (type->device() && !type->device()->is_cpu()) {
+    return false;
+  }
+  return dim == -1 || !type->dim() || *type->dim() == static_cast<size_t>(dim);
+}
+
+bool haveSameSizes(Value* a, Value* b) {
+  auto a_type = a->type()->cast<TensorType>();
+  auto b_type = b->type()->cast<TensorType>();
+  if (!a_type || !b_type) {
+    return false;
+  }
+  auto a_sizes = a_type->sizes().concrete_sizes();
+  auto b_sizes = b_type->sizes().concrete_sizes();
+  return a_sizes && b_sizes && *a_sizes == *b_sizes;
+}
+
+// The inputs of `n` that have to be MKL-DNN tensors for `n` to run on
+// MKL-DNN, or an empty list if it can't.
+std::vector<size_t> mkldnnInputs(Node* n) {
+  if (n->matches(
+          "aten::conv2d(Tensor input, Tensor weight, Tensor? bias, int[] stride, int[] padding, int[] dilation, int groups) -> Tensor")) {
+    // Dense weights are reordered by the kernel, and cached in inference.
+    if (mayBeFloatCpuTensor(n->input(0), 4)) {
+      return {0};
+    }
+  } else if (n->matches(
+                 "aten::linear(Tensor input, Tensor weight, Tensor? bias) -> Tensor")) {
+    // mkldnn_linear needs a bias.
+    if (mayBeFloatCpuTensor(n->input(0)) && mayBeFloatCpuTensor(n->input(1)) &&
+        mayBeFloatCpuTensor(n->input(2))) {
+      return {0, 1, 2};
+    }
+  } else if (
+      n->matches("aten::relu(Tensor self) -> Tensor") ||
+      n->matches(
+          "aten::adaptive_avg_pool2d(Tensor self, int[] output_size) -> Tensor") ||
+      n->matches(
+          "aten::max_pool2d(Tensor self, int[] kernel_size, int[] stride, int[] padding, int[] dilation, bool ceil_mode) -> Tensor")) {
+    if (mayBeFloatCpuTensor(n->input(0), n->kind() == aten::relu ? -1 : 4)) {
+      return {0};
+    }
+  } else if (n->matches(
+                 "aten::avg_pool2d(Tensor self, int[] kernel_size, int[] stride, int[] padding, bool ceil_mode, bool count_include_pad, int? divisor_override) -> Tensor")) {
+    if (mayBeFloatCpuTensor(n->input(0), 4) && n->input(6)->mustBeNone()) {
+      return {0};
+    }
+  } else if (n->matches(
+                 "aten::batch_norm(Tensor input, Tensor? weight, Tensor? bias, Tensor? running_mean, Tensor? running_var, bool training, float momentum, float eps, bool cudnn_enabled) -> Tensor")) {
+    auto training = constant_as<bool>(n->input(5));
+    if (training && !*training && mayBeFloatCpuTensor(n->input(0), 4) &&
+        mayBeFloatCpuTensor(n->input(1)) && mayBeFloatCpuTensor(n->input(2)) &&
+        mayBeFloatCpuTensor(n->input(3)) && mayBeFloatCpuTensor(n->input(4))) {
+      return {0, 1, 2, 3, 4};
+    }
+  } else if (n->matches(
+                 "aten::add(Tensor self, Tensor other, *, Scalar alpha) -> Tensor")) {
+    // mkldnn_add doesn't broadcast.
+    if (mayBeFloatCpuTensor(n->input(0)) && mayBeFloatCpuTensor(n->input(1)) &&
+        haveSameSizes(n->input(0), n->input(1))) {
+      return {0, 1};
+    }
+  }
+  return {};
+}
+
+// Finds the in-place relu_ and add_ nodes whose result could be computed out
+// of place, as the tensor they write isn't read afterwards. The tensor has
+// to be the output of an op that returns a fresh tensor, so that it has no
+// aliases: an op that can run on MKL-DNN, or another of these nodes.
+void findDeadInplaceOps(
+    Block* block,
+    const AliasDb& aliasDb,
+    std::unordered_set<Node*>& dead_inplace_ops) {
+  for (Node* n : block->nodes()) {
+    for (Block* b : n->blocks()) {
+      findDeadInplaceOps(b, aliasDb, dead_inplace_ops);
+    }
+    if (!n->matches("aten::relu_(Tensor(a!) self) -> Tensor(a!)") &&
+        !n->matches(
+            "aten::add_(Tensor(a!) self, Tensor other, *, Scalar alpha) -> Tensor(a!)")) {
+      continue;
+    }
+    Value* self = n->input(0);
+    Node* producer = self->node();
+    if (producer->owningBlock() != block || producer->outputs().size() != 1 ||
+        (mkldnnInputs(producer).empty() && !dead_inplace_ops.count(producer))) {
+      continue;
+    }
+    bool dead = true;
+    for (const Use& use : self->uses()) {
+      if (use.user == n) {
+        continue;
+      }
+      // Readers before n see the tensor as it was, and mustn't return an
+      // alias of it.
+      bool aliases = false;
+      for (Value* output : use.user->outputs()) {
+        aliases = aliases || aliasDb.mayAlias(output, self);
+      }
+      if (use.user->owningBlock() != block || !use.user->isBefore(n) ||
+          aliases) {
+        dead = false;
+        break;
+      }
+    }
+    if (dead) {
+      dead_inplace_ops.insert(n);
+    }
+  }
+}
+
+// Replaces the in-place relu_ and add_ nodes found by findDeadInplaceOps by
+// relu and add, so that they can run on MKL-DNN.
+void removeDeadInplaceOps(std::shared_ptr<Graph>& graph) {
+  std::unordered_set<Node*> dead_inplace_ops;
+  {
+    AliasDb aliasDb(graph);
+    findDeadInplaceOps(graph->block(), aliasDb, dead_inplace_ops);
+  }
+  for (Node* n : dead_inplace_ops) {
+    WithInsertPoint guard(n);
+    const Symbol functional = n->kind() == aten::relu_ ? aten::relu : aten::add;
+    Node* replacement = graph->insertNode(graph->create(functional, n->inputs()));
+    replacement->setScope(n->scope());
+    replacement->output()->copyMetadata(n->output());
+    GRAPH_UPDATE("Replacing ", *n, " with ", *replacement);
+    n->output()->replaceAllUsesWith(replacement->output());
+    n->destroy();
+  }
+}
+
+class MkldnnConverter {
+ public:
+  explicit MkldnnConverter(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  void run() {
+    convertBlock(graph_->block());
+  }
+
+ private:
+  struct BlockState {
+    // The MKL-DNN tensors computed in the block, and the tensors they were
+    // converted to at the uses outside the regions.
+    std::unordered_map<Value*, Value*> dense;
+    // The MKL-DNN tensors the dense tensors used by a region were converted
+    // to, for those that aren't written to.
+    std::unordered_map<Value*, Value*> mkldnn;
+  };
+
+  Value* insertConversion(Symbol kind, Value* v, Node* before) {
+    Node* conversion = graph_->create(kind, {v});
+    conversion->insertBefore(before);
+    conversion->output()->setType(v->type());
+    return conversion->output();
+  }
+
+  // Replaces input i of `user` with a dense tensor converted before `n`, if
+  // it is an MKL-DNN tensor of the block.
+  void convertInputToDense(Node* n, Node* user, size_t i, BlockState& state) {
+    auto it = state.dense.find(user->input(i));
+    if (it == state.dense.end()) {
+      return;
+    }
+    if (!it->second) {
+      it->second = insertConversion(aten::to_dense, it->first, n);
+    }
+    user->replaceInput(i, it->second);
+  }
+
+  // Replaces the uses of MKL-DNN tensors of the block by `n`, or by the nodes
+  // of its blocks, with dense tensors converted before `n`.
+  void convertUsesToDense(Node* n, Node* user, BlockState& state) {
+    for (size_t i = 0; i < user->inputs().size(); ++i) {
+      convertInputToDense(n, user, i, state);
+    }
+    for (Block* b : user->blocks()) {
+      for (Node* inner : b->nodes()) {
+        convertUsesToDense(n, inner, state);
+      }
+      convertUsesToDense(n, b->return_node(), state);
+    }
+  }
+
+  void convertBlock(Block* block) {
+    BlockState state;
+    std::vector<Node*> nodes(block->nodes().begin(), block->nodes().end());
+    for (Node* n : nodes) {
+      const auto inputs = mkldnnInputs(n);
+      if (inputs.empty() || aliasDb_.hasOutputWriters(n)) {
+        convertUsesToDense(n, n, state);
+        for (Block* b : n->blocks()) {
+          convertBlock(b);
+        }
+        continue;
+      }
+      for (size_t i = 0; i < n->inputs().size(); ++i) {
+        Value* v = n->input(i);
+        if (std::find(inputs.begin(), inputs.end(), i) == inputs.end()) {
+          convertInputToDense(n, n, i, state);
+          continue;
+        }
+        if (state.dense.count(v)) {
+          continue;
+        }
+        auto it = state.mkldnn.find(v);
+        if (it != state.mkldnn.end()) {
+          n->replaceInput(i, it->second);
+          continue;
+        }
+        Value* converted = insertConversion(aten::to_mkldnn, v, n);
+        if (!aliasDb_.hasOutputWriters(v->node())) {
+          state.mkldnn[v] = converted;
+        }
+        n->replaceInput(i, converted);
+      }
+      GRAPH_UPDATE("Running ", *n, " on MKL-DNN tensors");
+      state.dense[n->output()] = nullptr;
+    }
+    convertUsesToDense(block->return_node(), block->return_node(), state);
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+};
+
+} // namespace
+
+void ConvertToMkldnn(std::shared_ptr<Graph>& graph) {
+  removeDeadInplaceOps(graph);
+  MkldnnConverter(graph).run();
+  EliminateDeadCode(graph);
+  GRAPH_DUMP("After ConvertToMkldnn: ", graph);
+}
+
+} // namespace jit
+} // namespace torch
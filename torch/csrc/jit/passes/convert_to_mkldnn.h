@@ -0,0 +1,33 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+#include <memory>
+
+namespace torch {
+namespace jit {
+
+// Runs the ops of an inference graph that have MKL-DNN kernels (conv2d,
+// linear, relu, max/avg pooling, batch_norm and add) on MKL-DNN tensors, so
+// that activations stay in the blocked layout MKL-DNN prefers across
+// consecutive ops, e.g.
+//
+//   %y = aten::conv2d(%x, ...)            %x_m = aten::to_mkldnn(%x)
+//   %z = aten::relu(%y)          becomes  %y_m = aten::conv2d(%x_m, ...)
+//   %w = aten::sum(%z)                    %z_m = aten::relu(%y_m)
+//                                         %z = aten::to_dense(%z_m)
+//                                         %w = aten::sum(%z)
+//
+// Conversions are only inserted where a value enters or leaves a region of
+// such ops. In-place aten::relu_ and aten::add_ of tensors that aren't used
+// afterwards are replaced by their out-of-place variants so that they can be
+// part of a region. Ops of tensors known not to be float CPU tensors, ops
+// whose outputs are mutated, and adds of tensors whose sizes aren't known to
+// be the same, as mkldnn_add doesn't broadcast, are left alone.
+//
+// The graph must only be run with the autograd disabled, as the MKL-DNN ops
+// have no derivatives.
+TORCH_API void ConvertToMkldnn(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
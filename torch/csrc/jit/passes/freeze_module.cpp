@@ -0,0 +1,156 @@
+#include <torch/csrc/jit/passes/freeze_module.h>
+
+#include <torch/csrc/autograd/variable.h>
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/common_subexpression_elimination.h>
+#include <torch/csrc/jit/passes/constant_pooling.h>
+#include <torch/csrc/jit/passes/constant_propagation.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include <torch/csrc/jit/passes/inliner.h>
+
+#include <unordered_map>
+#include <unordered_set>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Collects the names of the attributes that `block` assigns, or reads and may
+// mutate in place. Attributes are told apart by name only: an attribute of
+// one module is kept if an attribute of the same name is mutated anywhere.
+void collectMutatedAttributes(
+    Block* block,
+    const AliasDb& aliasDb,
+    std::unordered_set<std::string>& names) {
+  for (Node* n : block->nodes()) {
+    for (Block* sub_block : n->blocks()) {
+      collectMutatedAttributes(sub_block, aliasDb, names);
+    }
+    if (n->kind() == prim::SetAttr ||
+        (n->kind() == prim::GetAttr && aliasDb.hasOutputWriters(n))) {
+      names.insert(n->s(attr::name));
+    }
+  }
+}
+
+void collectMutatedAttributes(
+    const std::shared_ptr<Graph>& graph,
+    std::unordered_set<std::string>& names) {
+  AliasDb aliasDb(graph);
+  collectMutatedAttributes(graph->block(), aliasDb, names);
+}
+
+void collectMutatedAttributes(
+    const script::Module& module,
+    std::unordered_set<std::string>& names) {
+  for (const script::Method& method : module.get_methods()) {
+    collectMutatedAttributes(method.graph(), names);
+  }
+  for (const script::NameModule& child : module.get_modules()) {
+    collectMutatedAttributes(child.module, names);
+  }
+}
+
+struct AttributeFreezer {
+  AttributeFreezer(
+      std::shared_ptr<Graph> graph,
+      const script::Module& module,
+      std::unordered_set<std::string> mutated)
+      : graph_(std::move(graph)), mutated_(std::move(mutated)) {
+    objects_[graph_->inputs().at(0)] = module.module_object();
+  }
+
+  void run() {
+    freezeAttributes(graph_->block());
+  }
+
+ private:
+  void freezeAttributes(Block* block) {
+    for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+      Node* n = *it;
+      // advance the iterator, `n` may be destroyed
+      it++;
+      for (Block* sub_block : n->blocks()) {
+        freezeAttributes(sub_block);
+      }
+      if (n->kind() != prim::GetAttr) {
+        continue;
+      }
+      auto obj = objects_.find(n->input());
+      if (obj == objects_.end()) {
+        continue;
+      }
+      const std::string& name = n->s(attr::name);
+      IValue attr = obj->second->getAttr(name);
+      if (attr.isObject()) {
+        objects_[n->output()] = attr.toObject();
+        continue;
+      }
+      if (mutated_.count(name)) {
+        GRAPH_DEBUG("Not freezing mutated attribute ", name);
+        continue;
+      }
+      if (attr.isTensor() && attr.toTensor().defined()) {
+        auto tensor = autograd::as_variable_ref(attr.toTensor()).detach();
+        tensor.set_requires_grad(false);
+        attr = tensor;
+      }
+      WithInsertPoint guard(n);
+      auto constant = tryInsertConstant(*graph_, attr);
+      if (!constant) {
+        continue;
+      }
+      GRAPH_UPDATE(
+          "Freezing attribute ",
+          name,
+          " of %",
+          n->input()->debugName(),
+          " as ",
+          getHeader((*constant)->node()));
+      if (attr.isNone()) {
+        (*constant)->setType(n->output()->type());
+      }
+      n->output()->replaceAllUsesWith(*constant);
+      n->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  std::unordered_set<std::string> mutated_;
+  // the objects that values of the graph are known to hold
+  std::unordered_map<Value*, c10::intrusive_ptr<c10::ivalue::Object>>
+      objects_;
+};
+
+} // namespace
+
+script::Module freeze_module(const script::Module& module) {
+  script::Module frozen = module.clone();
+  TORCH_CHECK(
+      !frozen.is_training(),
+      "Freezing is only supported for modules in eval mode, call .eval() "
+      "before freezing");
+
+  std::shared_ptr<Graph> graph = frozen.get_method("forward").graph();
+  Inline(*graph);
+
+  std::unordered_set<std::string> mutated;
+  collectMutatedAttributes(frozen, mutated);
+  collectMutatedAttributes(graph, mutated);
+
+  AttributeFreezer(graph, frozen, std::move(mutated)).run();
+  // merge the weight transformations done several times before folding them
+  // once, then deduplicate the folded results that are still equal
+  EliminateCommonSubexpression(graph);
+  ConstantPropagation(graph);
+  ConstantPooling(graph);
+  EliminateDeadCode(graph);
+  GRAPH_DUMP("After freezing: ", graph);
+  return frozen;
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,31 @@
+/** \brief This file defines freezing of modules for inference.
+ *
+ * The pass has a python-binding and can be invoked directly, it is not part
+ * of the default optimization pipeline.
+ */
+#pragma once
+
+#include <torch/csrc/jit/script/module.h>
+
+namespace torch {
+namespace jit {
+
+/** \brief Freeze a module in eval mode for inference.
+ *
+ * Returns a clone of `module` whose forward method has its submodule calls
+ * inlined and the attributes of the module hierarchy it reads, parameters
+ * included, replaced by constants. Computations depending only on them, e.g.
+ * transposing or permuting weights and quantized::linear_prepack or
+ * quantized::conv_prepack, are then folded so they no longer run on every
+ * call, and equal results are deduplicated.
+ *
+ * Attributes that any method assigns or mutates in place keep being read from
+ * the module. The other methods of the clone are left unchanged.
+ *
+ * Prepacked weights are opaque handles to memory of this process, so a frozen
+ * module using them can't be saved and loaded again.
+ */
+TORCH_API script::Module freeze_module(const script::Module& module);
+
+} // namespace jit
+} // namespace torch
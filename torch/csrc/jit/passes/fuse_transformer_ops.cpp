@@ -0,0 +1,59 @@
+#include <torch/csrc/jit/passes/fuse_transformer_ops.h>
+#include <torch/csrc/jit/passes/subgraph_rewrite.h>
+
+namespace torch {
+namespace jit {
+
+void FuseTransformerOps(std::shared_ptr<Graph>& graph) {
+  std::string bias_dropout_add_pattern = R"IR(
+    graph(%input, %bias, %residual, %p, %train):
+        %alpha : int = prim::Constant[value=1]()
+        %biased = aten::add(%input, %bias, %alpha)
+        %dropped = aten::dropout(%biased, %p, %train)
+        %res = aten::add(%dropped, %residual, %alpha)
+        return (%res))IR";
+  std::string fused_bias_dropout_add = R"IR(
+    graph(%input, %bias, %residual, %p, %train):
+        %res = aten::_fused_bias_dropout_add(%input, %bias, %residual, %p, %train)
+        return (%res))IR";
+
+  std::string add_layer_norm_pattern = R"IR(
+    graph(%input, %residual, %shape, %weight, %bias, %eps, %cudnn_enable):
+        %alpha : int = prim::Constant[value=1]()
+        %sum = aten::add(%input, %residual, %alpha)
+        %res = aten::layer_norm(%sum, %shape, %weight, %bias, %eps, %cudnn_enable)
+        return (%res))IR";
+  std::string fused_add_layer_norm = R"IR(
+    graph(%input, %residual, %shape, %weight, %bias, %eps, %cudnn_enable):
+        %res = aten::_fused_add_layer_norm(%input, %residual, %shape, %weight, %bias, %eps)
+        return (%res))IR";
+
+  std::string bias_gelu_pattern = R"IR(
+    graph(%input, %bias):
+        %alpha : int = prim::Constant[value=1]()
+        %biased = aten::add(%input, %bias, %alpha)
+        %res = aten::gelu(%biased)
+        return (%res))IR";
+  std::string fused_bias_gelu = R"IR(
+    graph(%input, %bias):
+        %res = aten::_fused_bias_gelu(%input, %bias)
+        return (%res))IR";
+
+  // The residual add of bias + dropout + residual also matches the add of
+  // residual + LayerNorm, the former is rewritten first.
+  SubgraphRewriter bias_dropout_add_rewriter;
+  bias_dropout_add_rewriter.RegisterRewritePattern(
+      bias_dropout_add_pattern, fused_bias_dropout_add);
+  bias_dropout_add_rewriter.runOnGraph(graph);
+
+  SubgraphRewriter add_layer_norm_rewriter;
+  add_layer_norm_rewriter.RegisterRewritePattern(
+      add_layer_norm_pattern, fused_add_layer_norm);
+  add_layer_norm_rewriter.runOnGraph(graph);
+
+  SubgraphRewriter bias_gelu_rewriter;
+  bias_gelu_rewriter.RegisterRewritePattern(bias_gelu_pattern, fused_bias_gelu);
+  bias_gelu_rewriter.runOnGraph(graph);
+}
+} // namespace jit
+} // namespace torch
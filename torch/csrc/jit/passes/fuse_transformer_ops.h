@@ -0,0 +1,18 @@
+/** \brief Fusing the elementwise ops around the GELUs and LayerNorms of
+ * transformer layers
+ */
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+namespace torch {
+namespace jit {
+
+/** \brief Rewrite bias-add + GELU, residual-add + LayerNorm and bias-add +
+ * dropout + residual-add into the single fused aten ops computing them.
+ * The fused ops run one vectorized CPU kernel when they can and the original
+ * ops otherwise, so the rewrite holds for any shapes and devices.
+ */
+TORCH_API void FuseTransformerOps(std::shared_ptr<Graph>& graph);
+} // namespace jit
+} // namespace torch
@@ -12,6 +12,7 @@
 #include <torch/csrc/jit/passes/utils/subgraph_utils.h>
 #include <torch/csrc/jit/script/compiler.h>
 
+#include <algorithm>
 #include <queue>
 #include <unordered_map>
 
@@ -52,6 +53,7 @@ bool isSimpleMap(Node* node) {
       "aten::floor(Tensor self) -> Tensor",
       "aten::fmod(Tensor self, Tensor other) -> Tensor",
       "aten::frac(Tensor self) -> Tensor",
+      "aten::gelu(Tensor self) -> Tensor",
       "aten::lgamma(Tensor self) -> Tensor",
       "aten::log(Tensor self) -> Tensor",
       "aten::log10(Tensor self) -> Tensor",
@@ -119,6 +121,81 @@ bool isSimpleMap(Node* node) {
   return true;
 }
 
+// What is a row reduction?  It:
+//    - Reduces its input over the last dimension and broadcasts the result
+//      back over that dimension, so that its output has the shape of its
+//      input (e.g. softmax, or layer_norm over the last dimension)
+//    - Otherwise satisfies the restrictions of simple mappable operators
+// The fused kernel walks the map one row at a time and recomputes the
+// operators a row reduction depends on for every pass it makes over the row.
+// Whether the reduced dimension really is the last one of the map can only be
+// decided once the sizes are known, so the executor checks it before every
+// launch (see canRunRowReductions in fuser/executor.cpp).
+bool isRowReduction(Node* node) {
+  static OperatorSet row_reductions{{
+      "aten::softmax(Tensor self, int dim, int? dtype) -> Tensor",
+      "aten::log_softmax(Tensor self, int dim, int? dtype) -> Tensor",
+      "aten::layer_norm(Tensor input, int[] normalized_shape, Tensor? weight, Tensor? bias, float eps, bool cudnn_enable) -> Tensor",
+  }};
+  if (!row_reductions.find(node)) {
+    return false;
+  }
+  if (node->kind() == aten::layer_norm) {
+    const auto normalized_shape =
+        node->get<std::vector<int64_t>>(attr::normalized_shape);
+    if (!normalized_shape || normalized_shape->size() != 1) {
+      return false;
+    }
+    // The affine parameters have to be statically known to be either
+    // defined or None.
+    for (Value* param :
+         {node->namedInput(attr::weight), node->namedInput(attr::bias)}) {
+      if (!param->type()->isSubtypeOf(TensorType::get()) &&
+          !param->mustBeNone()) {
+        return false;
+      }
+    }
+  } else {
+    if (!node->is_constant(attr::dim) ||
+        !node->namedInput(attr::dtype)->mustBeNone()) {
+      return false;
+    }
+  }
+  for (Value* input : node->inputs()) {
+    if (input->type()->isSubtypeOf(TensorType::get()) ||
+        input->type()->isSubtypeOf(FloatType::get())) {
+      continue;
+    }
+    if (input->node()->kind() != prim::Constant) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Row reductions make several passes over every row, which can't be combined
+// with random number generation: every pass would draw different numbers.
+bool containsRandom(Node* node) {
+  if (node->kind() == prim::FusionGroup) {
+    auto nodes = node->g(attr::Subgraph)->nodes();
+    return std::any_of(nodes.begin(), nodes.end(), containsRandom);
+  }
+  return node->kind() == aten::rand_like;
+}
+
+bool containsRowReduction(Node* node) {
+  if (node->kind() == prim::FusionGroup) {
+    auto nodes = node->g(attr::Subgraph)->nodes();
+    return std::any_of(nodes.begin(), nodes.end(), containsRowReduction);
+  }
+  return isRowReduction(node);
+}
+
+bool canMergeRowReductions(Node* consumer, Node* producer) {
+  return !(containsRowReduction(consumer) && containsRandom(producer)) &&
+      !(containsRandom(consumer) && containsRowReduction(producer));
+}
+
 Value* broadcastSizes(at::ArrayRef<Value*> sizes) {
   AT_ASSERT(!sizes.empty());
   Graph* graph = sizes[0]->owningGraph();
@@ -207,7 +284,8 @@ struct GraphFuser {
     // are not necessarily correct.
     if (node->owningBlock() != block_)
       return false;
-    return node->kind() == prim::FusionGroup || isSimpleMap(node);
+    return node->kind() == prim::FusionGroup || isSimpleMap(node) ||
+        isRowReduction(node);
   }
 
   bool isFusableCatNode(Node* node) {
@@ -415,6 +493,7 @@ struct GraphFuser {
     // but this requires better handling of merging fusion groups so it is not
     // done now
     bool shouldFuse = isFusable(producer->node()) &&
+        canMergeRowReductions(consumer, producer->node()) &&
         // Rearrange nodes such that all uses of producer are after the
         // consumer. Fusion will rewrite those later uses to use the version of
         // producer generated by the fused blob. In this case, producer becomes
@@ -699,7 +778,10 @@ struct GraphFuser {
         chunk->inputs().begin(),
         chunk->inputs().end(),
         [&](Value* producer_for_chunk) {
+          // Row reductions can't be distributed over the chunks, which may
+          // split their rows.
           return isFusableMap(producer_for_chunk->node()) &&
+              !isRowReduction(producer_for_chunk->node()) &&
               allUsersAreThisConsumerOrCalcSizes(chunk, producer_for_chunk);
         });
     if (it == chunk->inputs().end()) {
@@ -1001,7 +1083,8 @@ struct GraphFuser {
   }
 
   bool canFuseWithConcat(Value* producer, Node* before_check) {
-    if (!isFusable(producer->node())) {
+    if (!isFusable(producer->node()) ||
+        !canMergeRowReductions(before_check, producer->node())) {
       return false;
     }
     // NB: it is important that this check happens after isFusable, which checks
@@ -129,6 +129,62 @@ struct GuardElimination {
     }
   }
 
+  bool isGuarded(Value* v) {
+    return v->node()->kind() == prim::Guard &&
+        !v->type()->expect<TensorType>()->isSummarized();
+  }
+
+  // Whether `v`, an int or a list of ints, is a function of constants and of
+  // the sizes of guarded tensors only, e.g. `y.size()` or `[x.size(0), 4]`.
+  // Such a size is the same whenever the guards pass, so are the shapes of
+  // the ops that take it, like `x.view(y.size())`.
+  bool isSymbolicSize(Value* v) {
+    auto n = v->node();
+    if (n->kind() == prim::Constant) {
+      return true;
+    }
+    if (!v->type()->isSubtypeOf(IntType::get()) &&
+        !v->type()->isSubtypeOf(ListType::ofInts())) {
+      return false;
+    }
+    switch (n->kind()) {
+      case aten::size: {
+        auto tt = n->input(0)->type()->cast<TensorType>();
+        if (!isGuarded(n->input(0)) &&
+            !(tt && tt->sizes().concrete_sizes())) {
+          return false;
+        }
+        return n->inputs().size() == 1 || isSymbolicSize(n->input(1));
+      }
+      case prim::ListConstruct:
+      case aten::add:
+      case aten::sub:
+      case aten::mul:
+      case aten::floordiv:
+      case aten::neg:
+        for (auto input : n->inputs()) {
+          if (!isSymbolicSize(input)) {
+            return false;
+          }
+        }
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  // Checks the tensor inputs of `n` like `checkInputs` and that the inputs
+  // at `size_inputs` are symbolic sizes.
+  bool checkSizedInputs(Node* n, const std::unordered_set<size_t>& size_inputs) {
+    for (auto i : size_inputs) {
+      if (!isSymbolicSize(n->input(i))) {
+        GRAPH_DEBUG("size ", n->input(i)->debugName(), " isn't symbolic");
+        return false;
+      }
+    }
+    return checkInputs(n, size_inputs);
+  }
+
   // `checkInputs` check the invariants specified in `removableGuard`
   // on inputs to `n`. The invarints must hold, or an input must
   // be a `prim::Constant` or be of `NumberType` or be included
@@ -137,8 +193,7 @@ struct GuardElimination {
     bool all_inputs_guarded = true;
     size_t i = 0;
     for (auto input : n->inputs()) {
-      if ((input->node()->kind() == prim::Guard &&
-           !input->type()->expect<TensorType>()->isSummarized()) ||
+      if (isGuarded(input) ||
           input->node()->kind() == prim::Constant ||
           input->type()->isSubtypeOf(NumberType::get()) ||
           except.count(i) != 0) {
@@ -183,6 +238,10 @@ private:
   //   Guards can be removed if all inputs are guarded and `isSummarized()`
   //   returns
   //   false or inputs are `prim::Constant`
+  // * Operations whose output shape is given by a size argument (e.g. view,
+  //   expand)
+  //   Guards can be removed if the tensor inputs are guarded and the size is
+  //   a symbolic size, see `isSymbolicSize`
   //
   bool removableGuard(Node *n) {
 
@@ -206,9 +265,27 @@ private:
     case aten::eq:
     case aten::ne:
     case aten::neg:
+    case aten::relu:
+    case aten::exp:
+    case aten::log:
+    case aten::sqrt:
+    case aten::rsqrt:
+    case aten::abs:
+    case aten::reciprocal:
+    case aten::erf:
+    case aten::where:
+    case aten::expand_as:
+    case aten::view_as:
+    case aten::reshape_as:
     case prim::ConstantChunk:
     case aten::size:
       return checkInputs(n, no_exceptions);
+    case aten::view:
+    case aten::reshape:
+    case aten::expand:
+      // the size is the second argument, expand's `implicit` the third one
+      return n->inputs().size() <= 3 &&
+          checkSizedInputs(n, std::unordered_set<size_t>{1});
     case aten::cat:
       // check that the dimension argument is constant
       return n->input(1)->node()->kind() == prim::Constant &&
@@ -223,23 +300,8 @@ private:
     // after some optimizations we might end up with two Guards back-to-back
     // which case we can remove the one whose input is also prim::Guard
     case aten::_grad_sum_to_size:
-      // skip checking size argument
-      if (checkInputs(n, std::unordered_set<size_t>{1})) {
-        auto asize = n->input(1)->node();
-        if (asize->kind() == prim::Constant) {
-          return true;
-        } else if (asize->matches("aten::size(Tensor self) -> int[]")) {
-          // aten::size is effectively a constant
-          if (asize->input()
-                  ->type()
-                  ->expect<TensorType>()
-                  ->sizes()
-                  .concrete_sizes()) {
-            return true;
-          }
-        }
-      }
-      return false;
+      // the size argument is None or an int list
+      return checkSizedInputs(n, std::unordered_set<size_t>{1});
     case prim::Guard:
       return true;
     default:
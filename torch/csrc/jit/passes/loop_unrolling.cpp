@@ -3,7 +3,10 @@
 #include <ATen/core/interned_strings.h>
 #include <c10/util/Exception.h>
 
+#include <algorithm>
+
 #include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/passes/dead_code_elimination.h>
 
 namespace torch {
@@ -11,9 +14,17 @@ namespace jit {
 
 namespace {
 
+// The unrolling decisions are based on the number of nodes in the loop body,
+// counting the nodes of nested blocks. Loops with fewer than kMaxBodyRepeats
+// constant iterations are unrolled entirely if that leaves at most
+// kMaxFullyUnrolledSize nodes. Other loops are unrolled by up to
+// kUnrollFactor, as long as the unrolled body has at most
+// kMaxUnrolledBodySize nodes.
 static constexpr int64_t kUnrollFactor = 8;
 static constexpr int64_t kMaxBodySize = 32;
 static constexpr int64_t kMaxBodyRepeats = 64;
+static constexpr int64_t kMaxUnrolledBodySize = 64;
+static constexpr int64_t kMaxFullyUnrolledSize = 256;
 
 bool isTrueConstant(Value* val) {
   c10::optional<bool> maybe_value = constant_as<bool>(val);
@@ -44,8 +55,21 @@ int64_t limitedBlockSize(Block* body, int64_t limit) {
   return limit;
 }
 
-bool isSmallBlock(Block* body) {
-  return limitedBlockSize(body, kMaxBodySize + 1) <= kMaxBodySize;
+// Nodes that run a subgraph, like fusion groups, stand for more work than
+// their size says, and copying them would compile the subgraph again for every
+// copy.
+bool hasSubgraphs(Block* body) {
+  for (Node* node : body->nodes()) {
+    if (node->hasAttribute(attr::Subgraph)) {
+      return true;
+    }
+    for (Block* subblock : node->blocks()) {
+      if (hasSubgraphs(subblock)) {
+        return true;
+      }
+    }
+  }
+  return false;
 }
 
 // XXX: This function can only be called with a loop that is guaranteed to
@@ -160,8 +184,17 @@ void replaceLoopCounter(Node* loop) {
 void unroll(Node* loop) {
   Graph* graph = loop->owningGraph();
   Block* body = loop->blocks().at(0);
-  if (!isSmallBlock(body))
+  int64_t body_size = limitedBlockSize(body, kMaxBodySize + 1);
+  if (body_size > kMaxBodySize) {
+    GRAPH_DEBUG("Not unrolling a loop with a body of more than ", kMaxBodySize,
+                " nodes:\n", *loop);
+    return;
+  }
+  if (hasSubgraphs(body)) {
+    GRAPH_DEBUG("Not unrolling a loop running subgraphs:\n", *loop);
     return;
+  }
+  body_size = std::max<int64_t>(body_size, 1);
 
   // We will be using a "mutable" counter outside of the loop instead of the
   // default one, because this will allow us to share it between the unrolled
@@ -174,7 +207,10 @@ void unroll(Node* loop) {
   // many times, then we can unroll them entirely.
   Value* trip_count = loop->inputs().at(0);
   c10::optional<int64_t> const_len = constant_as<int64_t>(trip_count);
-  if (const_len && *const_len < kMaxBodyRepeats) {
+  if (const_len && *const_len >= 0 && *const_len < kMaxBodyRepeats &&
+      *const_len * body_size <= kMaxFullyUnrolledSize) {
+    GRAPH_UPDATE("Fully unrolling ", *const_len, " iterations of a loop with a body of ",
+                 body_size, " nodes:\n", *loop);
     Block* dest = loop->addBlock();
     repeatBody(body, *const_len, dest);
     loop->eraseBlock(0);
@@ -182,6 +218,11 @@ void unroll(Node* loop) {
     return;
   }
 
+  const int64_t unroll_factor =
+      std::min(kUnrollFactor, kMaxUnrolledBodySize / body_size);
+  GRAPH_UPDATE("Unrolling ", unroll_factor, " times a loop with a body of ",
+               body_size, " nodes:\n", *loop);
+
   WithInsertPoint insert_point_guard{loop};
 
   // Clone the loop before we unroll it. The clone will become the epilogue.
@@ -193,21 +234,21 @@ void unroll(Node* loop) {
   }
 
   Block* dest = loop->addBlock();
-  repeatBody(body, kUnrollFactor, dest);
+  repeatBody(body, unroll_factor, dest);
   loop->eraseBlock(0);
   body = dest;
 
   // Change the iteration counts of both loops
   Value* iter_count = loop->inputs().at(0);
   Value* unrolled_iter_count = graph->insert(
-      aten::__round_to_zero_floordiv, {iter_count, kUnrollFactor});
+      aten::__round_to_zero_floordiv, {iter_count, unroll_factor});
   loop->replaceInput(0, unrolled_iter_count);
   loop_epilogue->replaceInput(
       0,
       graph->insert(
           aten::sub,
           {iter_count,
-           graph->insert(aten::mul, {unrolled_iter_count, kUnrollFactor})}));
+           graph->insert(aten::mul, {unrolled_iter_count, unroll_factor})}));
 }
 
 void UnrollLoops(Block* block) {
@@ -0,0 +1,287 @@
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// offsets into an arena are aligned like the CUDA caching allocator does,
+// which is also enough for every vectorized CPU kernel
+constexpr int64_t kArenaAlignment = 64;
+
+int64_t alignUp(int64_t nbytes) {
+  return (nbytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+struct PlannedTensor {
+  Value* value;
+  const Operator* out_op;
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+  at::ScalarType dtype;
+  at::Device device;
+  int64_t nbytes;
+  // inclusive range of top-level node indices the memory has to survive
+  size_t begin;
+  size_t end;
+  int64_t offset = 0;
+};
+
+} // namespace
+
+const Operator* findOutVariant(const Node* n) {
+  const FunctionSchema* schema = n->maybeSchema();
+  if (!schema || schema->is_mutable() || schema->returns().size() != 1 ||
+      schema->returns()[0].alias_info() ||
+      schema->returns()[0].type()->kind() != TypeKind::TensorType) {
+    return nullptr;
+  }
+  const auto& args = schema->arguments();
+  for (const auto& op : getAllOperatorsFor(n->kind())) {
+    const FunctionSchema& candidate = op->schema();
+    const auto& candidate_args = candidate.arguments();
+    if (candidate.overload_name() != "out" ||
+        candidate.returns().size() != 1 ||
+        candidate_args.size() != args.size() + 1 ||
+        candidate_args.back().name() != "out") {
+      continue;
+    }
+    bool same_args = true;
+    for (size_t i = 0; i < args.size(); ++i) {
+      if (candidate_args[i].name() != args[i].name() ||
+          *candidate_args[i].type() != *args[i].type()) {
+        same_args = false;
+        break;
+      }
+    }
+    if (same_args) {
+      return op.get();
+    }
+  }
+  return nullptr;
+}
+
+namespace {
+
+int64_t storageBytes(
+    const std::vector<int64_t>& sizes,
+    const std::vector<int64_t>& strides,
+    at::ScalarType dtype) {
+  int64_t storage_size = 1;
+  for (size_t i = 0; i < sizes.size(); ++i) {
+    if (sizes[i] == 0) {
+      return 0;
+    }
+    storage_size += (sizes[i] - 1) * strides[i];
+  }
+  return storage_size * c10::elementSize(dtype);
+}
+
+struct MemoryPlanner {
+  explicit MemoryPlanner(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  void run() {
+    indexNodes(graph_->block(), /*top_level=*/nullptr);
+    collectCandidates();
+    if (planned_.empty()) {
+      return;
+    }
+    computeLifetimes();
+    assignOffsets();
+    rewrite();
+    GRAPH_DUMP("After PlanStaticMemory: ", graph_);
+  }
+
+ private:
+  // Every node in the graph is mapped to the index of the top-level node it
+  // belongs to; uses inside of a sub-block keep a value alive for the whole
+  // of the node owning that block.
+  void indexNodes(Block* block, Node* top_level) {
+    for (Node* n : block->nodes()) {
+      size_t index =
+          top_level ? top_level_index_.at(top_level) : next_index_++;
+      top_level_index_[n] = index;
+      for (Value* output : n->outputs()) {
+        all_values_.push_back(output);
+      }
+      for (Block* sub_block : n->blocks()) {
+        indexNodes(sub_block, top_level ? top_level : n);
+      }
+    }
+    top_level_index_[block->return_node()] =
+        top_level ? top_level_index_.at(top_level) : next_index_++;
+  }
+
+  void collectCandidates() {
+    for (Node* n : graph_->nodes()) {
+      if (n->outputs().size() != 1 || !n->blocks().empty()) {
+        continue;
+      }
+      Value* output = n->output();
+      auto type = output->type()->cast<TensorType>();
+      if (!type || !type->isComplete()) {
+        continue;
+      }
+      const Operator* out_op = findOutVariant(n);
+      if (!out_op) {
+        continue;
+      }
+      // the arena is reused by the next run, so nothing living in it may be
+      // handed back to the caller or stored into one of the inputs
+      if (aliasDb_.mayContainAlias(output, graph_->outputs()) ||
+          aliasDb_.mayContainAlias(output, graph_->inputs())) {
+        continue;
+      }
+      std::vector<int64_t> sizes = *type->sizes().concrete_sizes();
+      std::vector<int64_t> strides = *type->strides().concrete_sizes();
+      at::ScalarType dtype = *type->scalarType();
+      int64_t nbytes = storageBytes(sizes, strides, dtype);
+      if (nbytes == 0) {
+        continue;
+      }
+      size_t index = top_level_index_.at(n);
+      planned_.push_back(PlannedTensor{output,
+                                       out_op,
+                                       std::move(sizes),
+                                       std::move(strides),
+                                       dtype,
+                                       *type->device(),
+                                       alignUp(nbytes),
+                                       index,
+                                       index});
+    }
+  }
+
+  void computeLifetimes() {
+    for (auto& planned : planned_) {
+      for (Value* v : all_values_) {
+        if (v != planned.value &&
+            !aliasDb_.mayContainAlias(planned.value, v)) {
+          continue;
+        }
+        for (const Use& use : v->uses()) {
+          planned.end =
+              std::max(planned.end, top_level_index_.at(use.user));
+        }
+      }
+    }
+  }
+
+  // Greedy by size: the largest tensors are placed first, each at the
+  // lowest offset that doesn't overlap a placed tensor whose lifetime
+  // intersects its own.
+  void assignOffsets() {
+    std::vector<PlannedTensor*> order;
+    for (auto& planned : planned_) {
+      order.push_back(&planned);
+    }
+    std::stable_sort(
+        order.begin(),
+        order.end(),
+        [](const PlannedTensor* a, const PlannedTensor* b) {
+          return a->nbytes > b->nbytes;
+        });
+
+    std::vector<PlannedTensor*> placed;
+    for (PlannedTensor* planned : order) {
+      std::vector<PlannedTensor*> conflicts;
+      for (PlannedTensor* other : placed) {
+        if (other->device == planned->device &&
+            other->begin <= planned->end && planned->begin <= other->end) {
+          conflicts.push_back(other);
+        }
+      }
+      std::sort(
+          conflicts.begin(),
+          conflicts.end(),
+          [](const PlannedTensor* a, const PlannedTensor* b) {
+            return a->offset < b->offset;
+          });
+      int64_t offset = 0;
+      for (PlannedTensor* other : conflicts) {
+        if (offset + planned->nbytes <= other->offset) {
+          break;
+        }
+        offset = std::max(offset, other->offset + other->nbytes);
+      }
+      planned->offset = offset;
+      placed.push_back(planned);
+
+      int64_t& arena_size = arena_sizes_[planned->device.str()];
+      arena_size = std::max(arena_size, offset + planned->nbytes);
+    }
+  }
+
+  void rewrite() {
+    std::unordered_map<std::string, Value*> arenas;
+    {
+      WithInsertPoint guard(*graph_->nodes().begin());
+      for (const auto& entry : arena_sizes_) {
+        Node* arena = graph_->create(prim::MemoryArena);
+        arena->i_(attr::size, entry.second);
+        arena->s_(attr::device, entry.first);
+        arena->output()->setType(TensorType::get());
+        graph_->insertNode(arena);
+        arenas[entry.first] = arena->output();
+      }
+    }
+
+    for (const auto& planned : planned_) {
+      Node* n = planned.value->node();
+      WithInsertPoint guard(n);
+      int64_t itemsize = c10::elementSize(planned.dtype);
+      Node* buffer = graph_->create(
+          prim::ArenaTensor, {arenas.at(planned.device.str())});
+      buffer->is_(attr::size, planned.sizes);
+      buffer->is_(attr::stride, planned.strides);
+      buffer->i_(attr::storage_offset, planned.offset / itemsize);
+      buffer->i_(attr::dtype, static_cast<int64_t>(planned.dtype));
+      buffer->output()->setType(planned.value->type());
+      graph_->insertNode(buffer);
+
+      std::vector<Value*> inputs = n->inputs().vec();
+      inputs.push_back(buffer->output());
+      Node* out_node = graph_->create(n->kind(), inputs);
+      out_node->output()->setType(planned.value->type());
+      out_node->setScope(n->scope());
+      graph_->insertNode(out_node);
+      TORCH_INTERNAL_ASSERT(
+          out_node->maybeOperator() == planned.out_op,
+          "expected ",
+          *n,
+          " to resolve to ",
+          planned.out_op->schema());
+      out_node->output()->copyMetadata(planned.value);
+      planned.value->replaceAllUsesWith(out_node->output());
+      n->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  std::unordered_map<Node*, size_t> top_level_index_;
+  size_t next_index_ = 0;
+  std::vector<Value*> all_values_;
+  std::vector<PlannedTensor> planned_;
+  // ordered so that the arenas are created in a deterministic order
+  std::map<std::string, int64_t> arena_sizes_;
+};
+
+} // namespace
+
+void PlanStaticMemory(std::shared_ptr<Graph>& graph) {
+  MemoryPlanner(graph).run();
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Assigns every planable intermediate tensor of the top-level block an offset
+// into one preallocated arena per device. Tensors with disjoint lifetimes
+// share memory, and the ops producing them are rewritten to their out=
+// overloads writing into views of the arena, so a run of the rewritten graph
+// does not go through the allocator for those intermediates.
+//
+// The pass needs complete tensor types (sizes, strides, dtype, device), e.g.
+// from running complete shape analysis on a representative input once. The
+// rewritten graph is only valid for inputs of exactly those shapes and is
+// meant for inference: out= overloads do not support autograd.
+TORCH_API void PlanStaticMemory(std::shared_ptr<Graph>& graph);
+
+// Finds the overload of n's operator that takes an extra trailing `out`
+// tensor and otherwise has the same arguments, e.g. aten::add.out for
+// aten::add.Tensor. Returns nullptr if there is none.
+TORCH_API const Operator* findOutVariant(const Node* n);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,202 @@
+#include <torch/csrc/jit/passes/module_constant_pooling.h>
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/constant_pooling.h>
+#include <torch/csrc/utils/hash.h>
+
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+void collectGraphs(
+    const script::Module& module,
+    std::unordered_set<Graph*>& seen,
+    std::vector<std::shared_ptr<Graph>>& graphs) {
+  for (const script::Method& method : module.get_methods()) {
+    auto graph = method.graph();
+    if (seen.insert(graph.get()).second) {
+      graphs.push_back(std::move(graph));
+    }
+  }
+  for (const script::NameModule& child : module.get_modules()) {
+    collectGraphs(child.module, seen, graphs);
+  }
+}
+
+bool isTensorConstant(const Node* node) {
+  return node->kind() == prim::Constant && node->hasAttribute(attr::value) &&
+      node->kindOf(attr::value) == AttributeKind::t;
+}
+
+// The constants of all the graphs, by type, device and sizes. Equal tensors
+// are searched for linearly among those.
+struct TensorPool {
+  using Key = std::tuple<at::ScalarType, at::Device, std::vector<int64_t>>;
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return get_hash(
+          static_cast<int>(std::get<0>(key)),
+          static_cast<int>(std::get<1>(key).type()),
+          std::get<1>(key).index(),
+          std::get<2>(key));
+    }
+  };
+
+  // Returns an equal tensor that was added before, or adds `tensor`
+  at::Tensor intern(const at::Tensor& tensor) {
+    auto& candidates = tensors_[Key(
+        tensor.scalar_type(), tensor.device(), tensor.sizes().vec())];
+    for (const auto& candidate : candidates) {
+      if (candidate.unsafeGetTensorImpl() == tensor.unsafeGetTensorImpl() ||
+          (candidate.strides() == tensor.strides() &&
+           candidate.is_sparse() == tensor.is_sparse() &&
+           candidate.requires_grad() == tensor.requires_grad() &&
+           candidate.equal(tensor))) {
+        return candidate;
+      }
+    }
+    candidates.push_back(tensor);
+    return tensor;
+  }
+
+  std::unordered_map<Key, std::vector<at::Tensor>, KeyHash> tensors_;
+};
+
+void poolTensorConstants(
+    Block* block,
+    const AliasDb& aliasDb,
+    TensorPool& pool,
+    std::unordered_map<c10::StorageImpl*, size_t>& replaced,
+    ModuleConstantPoolingStats& stats) {
+  for (Node* node : block->nodes()) {
+    for (Block* sub_block : node->blocks()) {
+      poolTensorConstants(sub_block, aliasDb, pool, replaced, stats);
+    }
+    if (!isTensorConstant(node)) {
+      continue;
+    }
+    // since the graph outputs may be mutated after they are returned, and
+    // the constants may be written to, they can't be shared
+    const at::Tensor& tensor = node->t(attr::value);
+    if (tensor.is_sparse() || aliasDb.hasWriters(node->output()) ||
+        aliasDb.mayContainAlias(
+            node->output(), node->owningGraph()->outputs())) {
+      continue;
+    }
+    at::Tensor pooled = pool.intern(tensor);
+    if (pooled.unsafeGetTensorImpl() == tensor.unsafeGetTensorImpl()) {
+      continue;
+    }
+    GRAPH_UPDATE("Pooling tensor constant of\n", *node);
+    if (tensor.has_storage() &&
+        tensor.storage().unsafeGetStorageImpl() !=
+            pooled.storage().unsafeGetStorageImpl()) {
+      replaced.emplace(
+          tensor.storage().unsafeGetStorageImpl(),
+          tensor.storage().capacity());
+    }
+    node->t_(attr::value, pooled);
+    stats.pooled_tensors++;
+  }
+}
+
+// Whether `value` is defined in `block` or in one of its sub-blocks
+bool isDefinedIn(const Value* value, const Block* block) {
+  for (const Block* b = value->node()->owningBlock(); b;
+       b = b->owningNode() ? b->owningNode()->owningBlock() : nullptr) {
+    if (b == block) {
+      return true;
+    }
+  }
+  return false;
+}
+
+size_t hoistLoopInvariants(Block* block, const AliasDb& aliasDb) {
+  size_t hoisted = 0;
+  for (auto it = block->nodes().begin(); it != block->nodes().end();) {
+    Node* node = *it;
+    // the invariants of node are moved before it, advance iterator now
+    ++it;
+    // Inner loops first, so that their invariants can then be moved out of
+    // the outer loops.
+    for (Block* sub_block : node->blocks()) {
+      hoisted += hoistLoopInvariants(sub_block, aliasDb);
+    }
+    if (node->kind() != prim::Loop) {
+      continue;
+    }
+    Block* body = node->blocks().at(0);
+    for (auto body_it = body->nodes().begin();
+         body_it != body->nodes().end();) {
+      Node* candidate = *body_it;
+      ++body_it;
+      if (!candidate->blocks().empty() || candidate->hasSideEffects() ||
+          candidate->isNondeterministic() || aliasDb.hasWriters(candidate)) {
+        continue;
+      }
+      bool invariant = true;
+      for (const Value* input : candidate->inputs()) {
+        if (isDefinedIn(input, body)) {
+          invariant = false;
+          break;
+        }
+      }
+      if (!invariant) {
+        continue;
+      }
+      GRAPH_UPDATE("Hoisting loop invariant\n", *candidate);
+      candidate->moveBefore(node);
+      hoisted++;
+    }
+  }
+  return hoisted;
+}
+
+} // namespace
+
+size_t HoistLoopInvariants(const std::shared_ptr<Graph>& graph) {
+  AliasDb aliasDb(graph);
+  return hoistLoopInvariants(graph->block(), aliasDb);
+}
+
+ModuleConstantPoolingStats PoolModuleConstants(const script::Module& module) {
+  std::unordered_set<Graph*> seen;
+  std::vector<std::shared_ptr<Graph>> graphs;
+  collectGraphs(module, seen, graphs);
+
+  ModuleConstantPoolingStats stats;
+  TensorPool pool;
+  std::unordered_map<c10::StorageImpl*, size_t> replaced;
+  for (const auto& graph : graphs) {
+    AliasDb aliasDb(graph);
+    poolTensorConstants(graph->block(), aliasDb, pool, replaced, stats);
+  }
+  for (const auto& graph : graphs) {
+    ConstantPooling(graph);
+    stats.hoisted_nodes += HoistLoopInvariants(graph);
+  }
+
+  // The pool holds the storages that are still used
+  for (const auto& entry : pool.tensors_) {
+    for (const auto& tensor : entry.second) {
+      if (tensor.has_storage()) {
+        replaced.erase(tensor.storage().unsafeGetStorageImpl());
+      }
+    }
+  }
+  for (const auto& entry : replaced) {
+    stats.saved_bytes += entry.second;
+  }
+  return stats;
+}
+
+} // namespace jit
+} // namespace torch
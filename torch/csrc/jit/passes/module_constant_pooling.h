@@ -0,0 +1,51 @@
+/** \brief This file defines passes that deduplicate work across the methods
+ * of a module.
+ *
+ * The passes have a python-binding and can be invoked directly, they are not
+ * part of the default optimization pipeline. They modify the graphs of the
+ * methods, so they should run after loading or inlining the module and before
+ * its methods are first run.
+ */
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/script/module.h>
+
+namespace torch {
+namespace jit {
+
+struct ModuleConstantPoolingStats {
+  // The number of tensor constants that were replaced by an equal constant
+  // of another, or the same, method
+  size_t pooled_tensors = 0;
+  // The bytes of the storages that are no longer used by the module's
+  // graphs. They are freed unless they are also used outside of them.
+  size_t saved_bytes = 0;
+  // The number of nodes that were moved out of loop bodies
+  size_t hoisted_nodes = 0;
+};
+
+/** \brief Pools the tensor constants of all the methods of `module` and of
+ * its submodules, then pools the constants and hoists the loop invariant
+ * computations of each graph.
+ *
+ * Tensor constants are equal if they have the same type, sizes, strides and
+ * values, e.g. position tables or masks of a traced or frozen module, which
+ * are duplicated in each method they are inlined into. Constants that may be
+ * written to or returned by their graph are not pooled.
+ */
+TORCH_API ModuleConstantPoolingStats
+PoolModuleConstants(const script::Module& module);
+
+/** \brief Moves the nodes of prim::Loop bodies whose inputs are all defined
+ * outside of the loop before the loop, and returns their number.
+ *
+ * Only the nodes that run on every iteration, i.e. that are not nested in
+ * a prim::If, and that have no side effects, no sub-blocks, are deterministic
+ * and don't alias values that are written to are moved. A moved node runs
+ * even if the loop runs no iteration, so its errors are raised then.
+ */
+TORCH_API size_t HoistLoopInvariants(const std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,255 @@
+#include <torch/csrc/jit/passes/parallelize_branches.h>
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// nodes without a schema that are known to only read their inputs
+const std::unordered_set<Symbol> unschematized_pure_ops = {
+    prim::FusionGroup,
+    prim::ListConstruct,
+    prim::ListUnpack,
+    prim::TupleConstruct,
+    prim::TupleUnpack,
+    prim::TupleIndex,
+    prim::ConstantChunk,
+    prim::GetAttr,
+};
+
+bool canRunInBranch(Node* n) {
+  if (n->kind() == prim::fork || n->kind() == aten::wait ||
+      !n->blocks().empty() || n->hasSideEffects() ||
+      n->isNondeterministic()) {
+    return false;
+  }
+  if (const FunctionSchema* schema = n->maybeSchema()) {
+    return !schema->is_mutable();
+  }
+  return unschematized_pure_ops.count(n->kind()) > 0;
+}
+
+bool launchesTensorWork(const std::vector<Node*>& branch) {
+  for (Node* n : branch) {
+    for (Value* output : n->outputs()) {
+      if (output->type()->isSubtypeOf(TensorType::get())) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// The GPU a branch works on, if its types say it works on exactly one.
+c10::optional<c10::Device> branchDevice(const std::vector<Node*>& branch) {
+  c10::optional<c10::Device> device;
+  for (Node* n : branch) {
+    for (Value* output : n->outputs()) {
+      auto type = output->type()->cast<TensorType>();
+      if (!type) {
+        continue;
+      }
+      if (!type->device() || !type->device()->is_cuda() ||
+          (device && *device != *type->device())) {
+        return c10::nullopt;
+      }
+      device = type->device();
+    }
+  }
+  return device;
+}
+
+Node* topLevelNode(Node* n, Block* block) {
+  while (n->owningBlock() != block) {
+    n = n->owningBlock()->owningNode();
+  }
+  return n;
+}
+
+struct BranchParallelizer {
+  explicit BranchParallelizer(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)) {}
+
+  void run() {
+    if (mayWriteToInputs()) {
+      return;
+    }
+    findBranches();
+    std::vector<std::vector<Node*>*> worthwhile;
+    for (auto& branch : branches_) {
+      if (launchesTensorWork(branch)) {
+        worthwhile.push_back(&branch);
+      }
+    }
+    if (worthwhile.size() < 2) {
+      return;
+    }
+    // the last branch keeps running on the calling thread, which would
+    // otherwise have nothing to do until the first join
+    worthwhile.pop_back();
+    for (std::vector<Node*>* branch : worthwhile) {
+      forkBranch(*branch);
+    }
+    GRAPH_DUMP("After ParallelizeBranches: ", graph_);
+  }
+
+ private:
+  bool mayWriteToInputs() {
+    AliasDb aliasDb(graph_);
+    ValueSet inputs(graph_->inputs().begin(), graph_->inputs().end());
+    for (Node* n : graph_->nodes()) {
+      if (aliasDb.writesToWildcard(n) || aliasDb.writesToAlias(n, inputs)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // A node starts a new branch if it only uses graph inputs and constants,
+  // and joins a branch if everything else it uses comes from that branch.
+  // Anything depending on more than one branch, or on a node that can't be
+  // part of one, stays where it is.
+  void findBranches() {
+    constexpr int64_t kNoBranch = -1;
+    for (Node* n : graph_->nodes()) {
+      if (n->kind() == prim::Constant) {
+        continue;
+      }
+      int64_t branch = kNoBranch;
+      bool joins = !canRunInBranch(n);
+      for (Value* input : n->inputs()) {
+        Node* producer = input->node();
+        if (producer->kind() == prim::Param ||
+            producer->kind() == prim::Constant) {
+          continue;
+        }
+        int64_t producer_branch = branch_of_.at(producer);
+        if (producer_branch == kNoBranch ||
+            (branch != kNoBranch && branch != producer_branch)) {
+          joins = true;
+        }
+        branch = producer_branch;
+      }
+      if (joins) {
+        branch_of_[n] = kNoBranch;
+        continue;
+      }
+      if (branch == kNoBranch) {
+        branch = branches_.size();
+        branches_.emplace_back();
+      }
+      branch_of_[n] = branch;
+      branches_[branch].push_back(n);
+    }
+  }
+
+  void forkBranch(const std::vector<Node*>& branch) {
+    std::unordered_set<Node*> in_branch(branch.begin(), branch.end());
+
+    auto subgraph = std::make_shared<Graph>();
+    std::unordered_map<Value*, Value*> env;
+    std::vector<Value*> fork_inputs;
+    auto value_map = [&](Value* v) -> Value* {
+      auto it = env.find(v);
+      if (it != env.end()) {
+        return it->second;
+      }
+      Value* mapped;
+      if (v->node()->kind() == prim::Constant) {
+        mapped = subgraph
+                     ->insertNode(subgraph->createClone(
+                         v->node(), [](Value* input) { return input; }))
+                     ->output();
+      } else {
+        mapped = subgraph->addInput()->copyMetadata(v);
+        fork_inputs.push_back(v);
+      }
+      env[v] = mapped;
+      return mapped;
+    };
+
+    std::vector<Value*> outputs;
+    Node* first_join = graph_->return_node();
+    for (Node* n : branch) {
+      Node* clone = subgraph->insertNode(subgraph->createClone(n, value_map));
+      for (size_t i = 0; i < n->outputs().size(); ++i) {
+        Value* output = n->outputs()[i];
+        env[output] = clone->outputs()[i];
+        bool escapes = false;
+        for (const Use& use : output->uses()) {
+          if (in_branch.count(use.user)) {
+            continue;
+          }
+          escapes = true;
+          Node* user = topLevelNode(use.user, graph_->block());
+          if (user->isBefore(first_join)) {
+            first_join = user;
+          }
+        }
+        if (escapes) {
+          outputs.push_back(output);
+        }
+      }
+    }
+    if (outputs.size() == 1) {
+      subgraph->registerOutput(env.at(outputs[0]));
+    } else {
+      auto mapped = fmap(outputs, [&](Value* v) { return env.at(v); });
+      subgraph->registerOutput(
+          subgraph->insertNode(subgraph->createTuple(mapped))->output());
+    }
+
+    Node* fork = graph_->create(prim::fork, fork_inputs, 1);
+    fork->g_(attr::Subgraph, subgraph);
+    fork->output()->setType(
+        FutureType::create(subgraph->outputs().at(0)->type()));
+    if (auto device = branchDevice(branch)) {
+      fork->s_(attr::device, device->str());
+    }
+    if (last_fork_) {
+      fork->insertAfter(last_fork_);
+    } else {
+      graph_->block()->prependNode(fork);
+    }
+    last_fork_ = fork;
+
+    WithInsertPoint guard(first_join);
+    Node* wait =
+        graph_->insertNode(graph_->create(aten::wait, {fork->output()}));
+    wait->output()->setType(subgraph->outputs().at(0)->type());
+    if (outputs.size() == 1) {
+      outputs[0]->replaceAllUsesWith(wait->output());
+    } else {
+      Node* unpack =
+          graph_->insertNode(graph_->createTupleUnpack(wait->output()));
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        outputs[i]->replaceAllUsesWith(unpack->outputs()[i]);
+      }
+    }
+
+    for (auto it = branch.rbegin(); it != branch.rend(); ++it) {
+      (*it)->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  std::unordered_map<Node*, int64_t> branch_of_;
+  std::vector<std::vector<Node*>> branches_;
+  Node* last_fork_ = nullptr;
+};
+
+} // namespace
+
+void ParallelizeBranches(std::shared_ptr<Graph>& graph) {
+  BranchParallelizer(graph).run();
+}
+
+} // namespace jit
+} // namespace torch
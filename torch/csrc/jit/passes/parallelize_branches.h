@@ -0,0 +1,24 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Finds independent branches in the top-level block of `graph`, i.e. groups
+// of nodes that only depend on the graph inputs, on constants and on each
+// other, and runs all but one of them concurrently through prim::fork, with
+// an aten::wait in front of the first node that joins them back together.
+//
+// Forked branches run on the inter-op thread pool. When the types say a
+// branch only works on one GPU, its fork is tagged with that device and the
+// branch gets a stream of its own from the CUDA stream pool, ordered against
+// the calling stream with events, so a dozen small GEMMs that each underfill
+// the GPU can overlap.
+//
+// Nothing is done if a node may write to the graph inputs; branches are made
+// of nodes without side effects, blocks, randomness or in-place updates.
+TORCH_API void ParallelizeBranches(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -228,14 +228,31 @@ graph(%self, %input):
     %relu = match::module[name="ReLU"](%self)
     %r = prim::CallMethod[name="forward"](%relu, %intermediate_val)
     return (%r) )";
+  std::string linear_functional_relu = R"(
+graph(%self, %input, %inplace):
+    %relu = prim::Constant[name="relu"]()
+    %linear = match::module[name="Linear"](%self)
+    %intermediate_val = prim::CallMethod[name="forward"](%linear, %input)
+    %r = prim::CallFunction(%relu, %intermediate_val, %inplace)
+    return (%r) )";
+  std::string linear_relu_module = R"(
+graph(%self, %input):
+    %linear = match::module[name="Linear"](%self)
+    %intermediate_val = prim::CallMethod[name="forward"](%linear, %input)
+    %relu = match::module[name="ReLU"](%self)
+    %r = prim::CallMethod[name="forward"](%relu, %intermediate_val)
+    return (%r) )";
   std::string matmul_add = R"(
 graph(%input, %weight, %bias, %4):
      %weight_t = aten::t(%weight)
      %intermediate_val = aten::matmul(%input, %weight_t)
      %res = aten::add_(%intermediate_val, %bias, %4)
      return (%res) )";
-  std::vector<std::string> patterns = {
-      conv_functional_relu, conv_relu_module, matmul_add};
+  std::vector<std::string> patterns = {conv_functional_relu,
+                                       conv_relu_module,
+                                       linear_functional_relu,
+                                       linear_relu_module,
+                                       matmul_add};
 
   for (const auto& pattern : patterns) {
     findIntermediateValuesInPattern(*graph, pattern);
@@ -76,6 +76,9 @@ TORCH_API script::Module InsertQuantDeQuant(
  *                                                          prepack(to_nhwc(w)),
  *                                                          prepack(to_nhwc(b))))
  *
+ * A relu between conv2d or linear and the quantization of its output is fused
+ * as well, giving quantized::conv2d_relu and quantized::linear_relu.
+ *
  * \param graph the graph we want to apply fusion
  */
 TORCH_API void QuantFusion(std::shared_ptr<Graph>& graph);
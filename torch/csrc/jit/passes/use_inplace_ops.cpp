@@ -0,0 +1,363 @@
+#include <torch/csrc/jit/passes/use_inplace_ops.h>
+
+#include <torch/csrc/jit/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/operator.h>
+#include <torch/csrc/jit/passes/alias_analysis.h>
+#include <torch/csrc/jit/passes/memory_planning.h>
+
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Ops computing every element of their output from the elements at the same
+// position of their inputs, so that the output can be written over the first
+// input while computing it.
+const std::unordered_set<Symbol>& elementwiseOps() {
+  static const std::unordered_set<Symbol> ops = {
+      aten::add,
+      aten::sub,
+      aten::mul,
+      aten::div,
+      aten::pow,
+      aten::relu,
+      aten::sigmoid,
+      aten::tanh,
+      aten::exp,
+      aten::log,
+      aten::sqrt,
+      aten::rsqrt,
+      aten::neg,
+      aten::abs,
+      aten::reciprocal,
+      aten::erf,
+      aten::clamp,
+      aten::threshold,
+      aten::hardtanh,
+      aten::leaky_relu,
+  };
+  return ops;
+}
+
+// The complete type of `v`, or nullptr if it isn't known or may require grad.
+TensorTypePtr inferenceType(Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || !type->isComplete() || type->requiresGrad().value_or(true)) {
+    return nullptr;
+  }
+  return type;
+}
+
+bool haveSameLayout(const TensorTypePtr& a, const TensorTypePtr& b) {
+  return a->sizes().concrete_sizes() == b->sizes().concrete_sizes() &&
+      a->strides().concrete_sizes() == b->strides().concrete_sizes() &&
+      a->scalarType() == b->scalarType() && a->device() == b->device();
+}
+
+// Finds the in-place variant of n's operator with the same arguments, e.g.
+// aten::add_.Tensor for aten::add.Tensor.
+const Operator* findInplaceVariant(const Node* n) {
+  const FunctionSchema* schema = n->maybeSchema();
+  if (!schema || schema->is_mutable()) {
+    return nullptr;
+  }
+  const auto& args = schema->arguments();
+  Symbol inplace =
+      Symbol::fromQualString(std::string(n->kind().toQualString()) + "_");
+  for (const auto& op : getAllOperatorsFor(inplace)) {
+    const auto& candidate_args = op->schema().arguments();
+    if (candidate_args.size() != args.size() || candidate_args.empty() ||
+        !candidate_args[0].alias_info() ||
+        !candidate_args[0].alias_info()->isWrite()) {
+      continue;
+    }
+    bool same_args = true;
+    for (size_t i = 0; i < args.size(); ++i) {
+      if (candidate_args[i].name() != args[i].name() ||
+          *candidate_args[i].type() != *args[i].type()) {
+        same_args = false;
+        break;
+      }
+    }
+    if (same_args) {
+      return op.get();
+    }
+  }
+  return nullptr;
+}
+
+// Replaces `n` by a node of the same kind whose operator is `op`, with an
+// extra trailing input for out= variants.
+void replaceWithVariant(
+    Graph* graph,
+    Node* n,
+    const Operator* op,
+    Value* out = nullptr) {
+  WithInsertPoint guard(n);
+  std::vector<Value*> inputs = n->inputs().vec();
+  if (out) {
+    inputs.push_back(out);
+  }
+  Node* variant = graph->create(
+      Symbol::fromQualString(op->schema().name()), inputs);
+  variant->setScope(n->scope());
+  graph->insertNode(variant);
+  TORCH_INTERNAL_ASSERT(
+      variant->maybeOperator() == op,
+      "expected ",
+      *n,
+      " to resolve to ",
+      op->schema());
+  variant->output()->copyMetadata(n->output());
+  n->output()->replaceAllUsesWith(variant->output());
+  n->destroy();
+}
+
+struct CatRewrite {
+  Node* cat;
+  int64_t dim;
+  std::vector<const Operator*> out_ops;
+};
+
+// Rewrites `aten::cat([f(a), g(b), ...], dim)`, where the concatenated
+// tensors are only computed for it, to run f and g by their out= variants
+// writing into slices of the result.
+struct CatRewriter {
+  explicit CatRewriter(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)) {}
+
+  void run() {
+    std::vector<CatRewrite> rewrites;
+    collect(graph_->block(), rewrites);
+    for (const auto& rewrite : rewrites) {
+      apply(rewrite);
+    }
+  }
+
+ private:
+  void collect(Block* block, std::vector<CatRewrite>& rewrites) {
+    for (Node* n : block->nodes()) {
+      for (Block* sub_block : n->blocks()) {
+        collect(sub_block, rewrites);
+      }
+      if (!n->matches("aten::cat(Tensor[] tensors, int dim=0) -> Tensor")) {
+        continue;
+      }
+      CatRewrite rewrite{n, 0, {}};
+      if (canRewrite(n, rewrite)) {
+        rewrites.push_back(std::move(rewrite));
+      }
+    }
+  }
+
+  bool canRewrite(Node* cat, CatRewrite& rewrite) {
+    Node* list = cat->input(0)->node();
+    auto type = inferenceType(cat->output());
+    auto dim = toIValue(cat->input(1));
+    if (list->kind() != prim::ListConstruct ||
+        cat->input(0)->uses().size() != 1 || !type || !dim ||
+        list->inputs().empty()) {
+      return false;
+    }
+    // the result is allocated contiguous, like cat does
+    auto sizes = *type->sizes().concrete_sizes();
+    auto strides = *type->strides().concrete_sizes();
+    int64_t expected_stride = 1;
+    for (int64_t i = static_cast<int64_t>(sizes.size()) - 1; i >= 0; --i) {
+      if (sizes[i] != 1 && strides[i] != expected_stride) {
+        return false;
+      }
+      expected_stride *= sizes[i];
+    }
+    rewrite.dim = dim->toInt();
+    if (rewrite.dim < 0) {
+      rewrite.dim += sizes.size();
+    }
+    for (Value* input : list->inputs()) {
+      Node* producer = input->node();
+      auto input_type = inferenceType(input);
+      if (input->uses().size() != 1 ||
+          producer->owningBlock() != cat->owningBlock() ||
+          producer->outputs().size() != 1 || !producer->blocks().empty() ||
+          !input_type || input_type->scalarType() != type->scalarType() ||
+          input_type->device() != type->device() ||
+          input_type->sizes().size() != sizes.size()) {
+        return false;
+      }
+      const Operator* out_op = findOutVariant(producer);
+      if (!out_op) {
+        GRAPH_DEBUG("no out= variant for ", *producer);
+        return false;
+      }
+      rewrite.out_ops.push_back(out_op);
+    }
+    return true;
+  }
+
+  void apply(const CatRewrite& rewrite) {
+    Node* cat = rewrite.cat;
+    Node* list = cat->input(0)->node();
+    auto type = cat->output()->type()->expect<TensorType>();
+
+    Node* first = list->input(0)->node();
+    for (Value* input : list->inputs()) {
+      if (input->node()->isBefore(first)) {
+        first = input->node();
+      }
+    }
+    Value* result;
+    {
+      WithInsertPoint guard(first);
+      result = graph_->insert(
+          aten::empty,
+          {*type->sizes().concrete_sizes()},
+          {NamedValue("dtype", static_cast<int64_t>(*type->scalarType())),
+           NamedValue("device", *type->device())});
+      result->setType(type);
+    }
+
+    int64_t offset = 0;
+    // the inputs of the list change while rewriting the producers
+    std::vector<Value*> inputs = list->inputs().vec();
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      Node* producer = inputs[i]->node();
+      int64_t length =
+          *inputs[i]->type()->expect<TensorType>()->sizes()[rewrite.dim];
+      Value* slice;
+      {
+        WithInsertPoint guard(producer);
+        slice = graph_->insert(
+            aten::narrow, {result, rewrite.dim, offset, length});
+      }
+      replaceWithVariant(graph_.get(), producer, rewrite.out_ops[i], slice);
+      offset += length;
+    }
+    cat->output()->replaceAllUsesWith(result);
+    cat->destroy();
+    list->destroy();
+  }
+
+  std::shared_ptr<Graph> graph_;
+};
+
+// Switches elementwise ops to their in-place variant when their first input
+// is dead afterwards.
+struct InplaceRewriter {
+  explicit InplaceRewriter(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  void run() {
+    for (Value* input : graph_->inputs()) {
+      values_.push_back(input);
+    }
+    collectValues(graph_->block());
+    // Decided on the original graph: values the rewrites make share memory
+    // are dead one after the other, so the decisions don't interfere.
+    std::vector<std::pair<Node*, const Operator*>> rewrites;
+    collect(graph_->block(), rewrites);
+    for (const auto& rewrite : rewrites) {
+      GRAPH_UPDATE("Running ", *rewrite.first, " in place");
+      replaceWithVariant(graph_.get(), rewrite.first, rewrite.second);
+    }
+  }
+
+ private:
+  void collectValues(Block* block) {
+    for (Node* n : block->nodes()) {
+      for (Value* output : n->outputs()) {
+        values_.push_back(output);
+      }
+      for (Block* sub_block : n->blocks()) {
+        for (Value* input : sub_block->inputs()) {
+          values_.push_back(input);
+        }
+        collectValues(sub_block);
+      }
+    }
+  }
+
+  void collect(
+      Block* block,
+      std::vector<std::pair<Node*, const Operator*>>& rewrites) {
+    for (Node* n : block->nodes()) {
+      for (Block* sub_block : n->blocks()) {
+        collect(sub_block, rewrites);
+      }
+      if (!elementwiseOps().count(n->kind()) || n->inputs().empty()) {
+        continue;
+      }
+      auto self_type = inferenceType(n->input(0));
+      auto output_type = inferenceType(n->output());
+      if (!self_type || !output_type ||
+          !haveSameLayout(self_type, output_type)) {
+        continue;
+      }
+      const Operator* inplace = findInplaceVariant(n);
+      if (inplace && isDeadAfter(n->input(0), n)) {
+        rewrites.emplace_back(n, inplace);
+      }
+    }
+  }
+
+  // The node of `block` that `n` is, or is nested in.
+  static Node* ancestorIn(Node* n, Block* block) {
+    while (n->owningBlock() != block) {
+      n = n->owningBlock()->owningNode();
+      if (!n) {
+        return nullptr;
+      }
+    }
+    return n;
+  }
+
+  // Whether the memory of `v` may be overwritten by `n`: nothing reads `v`,
+  // or any value that may alias it, after `n`. The memory must belong to
+  // this run of n's block, i.e. not to an input, a constant or a value of an
+  // enclosing block (which may be read by the next iteration of a loop).
+  bool isDeadAfter(Value* v, Node* n) {
+    Block* block = n->owningBlock();
+    for (Value* input : n->inputs()) {
+      if (input != v && aliasDb_.mayContainAlias(v, input)) {
+        return false;
+      }
+    }
+    for (Value* other : values_) {
+      if (other != v && !aliasDb_.mayContainAlias(v, other)) {
+        continue;
+      }
+      Node* def = other->node();
+      if (def->kind() == prim::Param || def->kind() == prim::Constant ||
+          def->owningBlock() != block) {
+        return false;
+      }
+      for (const Use& use : other->uses()) {
+        Node* user = ancestorIn(use.user, block);
+        if (!user || user == block->return_node() ||
+            (user != n && n->isBefore(user))) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  std::vector<Value*> values_;
+};
+
+} // namespace
+
+void UseInplaceOps(std::shared_ptr<Graph>& graph) {
+  CatRewriter(graph).run();
+  // after the cat rewrite, so that the alias analysis sees its out= writes
+  InplaceRewriter(graph).run();
+  GRAPH_DUMP("After UseInplaceOps: ", graph);
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <torch/csrc/jit/ir.h>
+
+#include <memory>
+
+namespace torch {
+namespace jit {
+
+// The reverse of RemoveInplaceOps, for inference graphs: reuses the memory of
+// tensors that are dead after an elementwise op by switching the op to its
+// in-place variant, e.g.
+//
+//   %b = aten::relu(%a)       becomes      %b = aten::relu_(%a)
+//
+// when nothing reads %a, or any alias of it, afterwards. An aten::cat of
+// tensors computed only for it is rewritten to compute them by their out=
+// variants into slices of the concatenated tensor.
+//
+// Like PlanStaticMemory, the pass needs complete tensor types and the graph
+// it produces is only valid for inputs of exactly those shapes. Values that
+// require grad are left alone.
+TORCH_API void UseInplaceOps(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
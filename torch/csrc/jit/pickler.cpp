@@ -213,7 +213,7 @@ void Pickler::pushString(const std::string& string) {
   auto it = memoized_strings_map_.find(string);
   if (it == memoized_strings_map_.end()) {
     pushStringImpl(string);
-    memoized_strings_map_[string] = pushNextBinPut();
+    memoized_strings_map_.emplace(string, pushNextBinPut());
   } else {
     pushBinGet(it->second);
   }
@@ -239,9 +239,14 @@ void Pickler::pushStorageOfTensor(const at::Tensor& tensor) {
   // root_key
   pushString(c10::to_string(tensor_data_.size()));
   // location
-  std::ostringstream ss;
-  ss << tensor.device();
-  pushString(ss.str());
+  if (tensor.device() == at::Device(at::kCPU)) {
+    // Skip the stream for the common case
+    pushString("cpu");
+  } else {
+    std::ostringstream ss;
+    ss << tensor.device();
+    pushString(ss.str());
+  }
   // size
   pushInt(tensor.storage().size());
   // view_metadata
@@ -255,15 +260,16 @@ void Pickler::pushStorageOfTensor(const at::Tensor& tensor) {
 }
 
 void Pickler::pushBytes(const std::string& string) {
-  static const size_t kSmallStr = 32;
-  if (string.size() <= kSmallStr &&
-      bufferPos_ + string.size() <= buffer_.size()) {
-    // Small string that fits: buffer the data.
+  if (bufferPos_ + string.size() > buffer_.size()) {
+    flush();
+  }
+  if (string.size() <= buffer_.size()) {
+    // Anything that fits is buffered, so that containers of many short
+    // strings (e.g. vocabularies) don't call writer_ once per string.
     memcpy(buffer_.data() + bufferPos_, string.data(), string.size());
     bufferPos_ += string.size();
   } else {
-    // Otherwise, first flush, then write directly.
-    flush();
+    // Otherwise, write directly.
     writer_(string.data(), string.size());
   }
 }
@@ -404,12 +410,17 @@ void Pickler::pushSpecializedList(
 
 void Pickler::pushDouble(double value) {
   AT_ASSERT(sizeof(double) == 8);
-  char* bytes = reinterpret_cast<char*>(&value);
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
 
-  push<PickleOpCode>(PickleOpCode::BINFLOAT);
+  // Pickle floats are big endian, reverse the bytes in a register (this is a
+  // single bswap) rather than pushing them one by one
+  uint64_t big_endian = 0;
   for (size_t i = 0; i < 8; ++i) {
-    push<uint8_t>(bytes[8 - i - 1]);
+    big_endian = (big_endian << 8) | ((bits >> (8 * i)) & 0xff);
   }
+  push<PickleOpCode>(PickleOpCode::BINFLOAT);
+  push<uint64_t>(big_endian);
 }
 
 void Pickler::pushLong(const std::string& data) {
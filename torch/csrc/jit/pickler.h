@@ -111,6 +111,10 @@ struct WriteableTensorData {
   size_t numel() const {
     return tensor_.storage().numel();
   }
+  // A tensor using the storage, on the CPU
+  const at::Tensor& tensor() const {
+    return tensor_;
+  }
 
  private:
   friend WriteableTensorData getWriteableTensorData(const at::Tensor& tensor);
@@ -0,0 +1,512 @@
+#include <torch/csrc/jit/plan_serialization.h>
+
+#include <c10/util/Exception.h>
+#include <torch/csrc/jit/argument_spec.h>
+#include <torch/csrc/jit/fuser/interface.h>
+#include <torch/csrc/jit/graph_executor.h>
+#include <torch/csrc/jit/graph_executor_impl.h>
+#include <torch/csrc/jit/script/script_type_parser.h>
+
+#include <sstream>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+static std::atomic<bool> save_optimized_plans{false};
+std::atomic<bool>& getSaveOptimizedPlans() {
+  return save_optimized_plans;
+}
+
+namespace {
+
+// Bumped on changes of the encoding, plans of other versions are ignored.
+constexpr int64_t kPlansVersion = 1;
+
+using Tuple = c10::ivalue::Tuple;
+
+const std::vector<IValue>& elementsOf(const IValue& value) {
+  return value.toTuple()->elements();
+}
+
+template <typename T, typename F>
+IValue encodeAll(const T& items, F encode) {
+  std::vector<IValue> elements;
+  for (const auto& item : items) {
+    elements.push_back(encode(item));
+  }
+  return Tuple::create(std::move(elements));
+}
+
+template <typename T>
+IValue encodeAll(const std::vector<T>& items) {
+  return encodeAll(items, [](const T& item) { return IValue(item); });
+}
+
+template <typename T, typename F>
+std::vector<T> decodeAll(const IValue& value, F decode) {
+  std::vector<T> items;
+  for (const auto& element : elementsOf(value)) {
+    items.push_back(decode(element));
+  }
+  return items;
+}
+
+template <typename T>
+IValue encodeOptional(const c10::optional<T>& value) {
+  return value ? IValue(*value) : IValue();
+}
+
+IValue encodeShape(const VaryingShape& shape) {
+  if (!shape.sizes()) {
+    return IValue();
+  }
+  return encodeAll(
+      *shape.sizes(),
+      [](const c10::optional<int64_t>& size) { return encodeOptional(size); });
+}
+
+VaryingShape decodeShape(const IValue& value) {
+  if (value.isNone()) {
+    return VaryingShape();
+  }
+  return VaryingShape(
+      decodeAll<c10::optional<int64_t>>(value, [](const IValue& size) {
+        return size.isNone() ? c10::optional<int64_t>()
+                             : c10::optional<int64_t>(size.toInt());
+      }));
+}
+
+IValue encodeType(const TypePtr& type) {
+  switch (type->kind()) {
+    case TypeKind::TensorType: {
+      auto tensor = type->expect<TensorType>();
+      return Tuple::create(
+          {"Tensor",
+           tensor->scalarType()
+               ? IValue(static_cast<int64_t>(*tensor->scalarType()))
+               : IValue(),
+           tensor->device() ? IValue(tensor->device()->str()) : IValue(),
+           encodeShape(tensor->sizes()),
+           encodeShape(tensor->strides()),
+           encodeOptional(tensor->requiresGrad()),
+           encodeOptional(tensor->undefined())});
+    }
+    case TypeKind::TupleType: {
+      auto tuple = type->expect<TupleType>();
+      if (tuple->name()) {
+        return Tuple::create({"Named", tuple->name()->qualifiedName()});
+      }
+      return Tuple::create({"Tuple", encodeAll(tuple->elements(), encodeType)});
+    }
+    case TypeKind::ListType:
+      return Tuple::create(
+          {"List", encodeType(type->expect<ListType>()->getElementType())});
+    case TypeKind::OptionalType:
+      return Tuple::create(
+          {"Optional",
+           encodeType(type->expect<OptionalType>()->getElementType())});
+    case TypeKind::ClassType:
+      return Tuple::create(
+          {"Named", type->expect<ClassType>()->name()->qualifiedName()});
+    case TypeKind::InterfaceType:
+      return Tuple::create(
+          {"Named", type->expect<InterfaceType>()->name()->qualifiedName()});
+    default:
+      TORCH_CHECK(
+          type->kind() != TypeKind::FunctionType,
+          "Can't serialize graphs with function values");
+      // parsed back by the TorchScript type parser
+      return Tuple::create({"Type", type->python_str()});
+  }
+}
+
+TypePtr decodeType(const IValue& value, const TypeResolver& resolver) {
+  const auto& elements = elementsOf(value);
+  const auto& kind = elements.at(0).toStringRef();
+  if (kind == "Tensor") {
+    return TensorType::create(
+        elements[1].isNone()
+            ? c10::optional<at::ScalarType>()
+            : static_cast<at::ScalarType>(elements[1].toInt()),
+        elements[2].isNone() ? c10::optional<at::Device>()
+                             : at::Device(elements[2].toStringRef()),
+        decodeShape(elements[3]),
+        decodeShape(elements[4]),
+        elements[5].isNone() ? c10::optional<bool>() : elements[5].toBool(),
+        elements[6].isNone() ? c10::optional<bool>() : elements[6].toBool());
+  } else if (kind == "Tuple") {
+    return TupleType::create(
+        decodeAll<TypePtr>(elements[1], [&resolver](const IValue& element) {
+          return decodeType(element, resolver);
+        }));
+  } else if (kind == "List") {
+    return ListType::create(decodeType(elements[1], resolver));
+  } else if (kind == "Optional") {
+    return OptionalType::create(decodeType(elements[1], resolver));
+  } else if (kind == "Named") {
+    auto type = resolver(c10::QualifiedName(elements[1].toStringRef()));
+    TORCH_CHECK(type, "Unknown type ", elements[1].toStringRef());
+    return type;
+  }
+  TORCH_CHECK(kind == "Type", "Unknown type encoding ", kind);
+  return script::ScriptTypeParser().parseType(elements[1].toStringRef());
+}
+
+IValue encodeAttribute(const Node* node, Symbol name) {
+  IValue value;
+  auto kind = node->kindOf(name);
+  switch (kind) {
+    case AttributeKind::f:
+      value = node->f(name);
+      break;
+    case AttributeKind::fs:
+      value = encodeAll(node->fs(name));
+      break;
+    case AttributeKind::i:
+      value = node->i(name);
+      break;
+    case AttributeKind::is:
+      value = encodeAll(node->is(name));
+      break;
+    case AttributeKind::s:
+      value = node->s(name);
+      break;
+    case AttributeKind::ss:
+      value = encodeAll(node->ss(name));
+      break;
+    case AttributeKind::t:
+      value = node->t(name);
+      break;
+    case AttributeKind::ts:
+      value = encodeAll(node->ts(name));
+      break;
+    case AttributeKind::g:
+      value = serializeGraph(*node->g(name));
+      break;
+    case AttributeKind::gs:
+      value = encodeAll(node->gs(name), [](const std::shared_ptr<Graph>& g) {
+        return serializeGraph(*g);
+      });
+      break;
+    case AttributeKind::ty:
+      value = encodeType(node->ty(name));
+      break;
+    case AttributeKind::tys:
+      value = encodeAll(node->tys(name), encodeType);
+      break;
+  }
+  return Tuple::create({name.toUnqualString(), toString(kind), value});
+}
+
+void decodeAttribute(
+    Node* node,
+    const IValue& attribute,
+    const TypeResolver& resolver) {
+  const auto& elements = elementsOf(attribute);
+  auto name = Symbol::attr(elements.at(0).toStringRef());
+  const auto& kind = elements.at(1).toStringRef();
+  const auto& value = elements.at(2);
+  auto decodeGraph = [&resolver](const IValue& g) {
+    return deserializeGraph(g, resolver);
+  };
+  auto decodeTypeOf = [&resolver](const IValue& type) {
+    return decodeType(type, resolver);
+  };
+  if (kind == "f") {
+    node->f_(name, value.toDouble());
+  } else if (kind == "fs") {
+    node->fs_(name, decodeAll<double>(value, [](const IValue& v) {
+      return v.toDouble();
+    }));
+  } else if (kind == "i") {
+    node->i_(name, value.toInt());
+  } else if (kind == "is") {
+    node->is_(name, decodeAll<int64_t>(value, [](const IValue& v) {
+      return v.toInt();
+    }));
+  } else if (kind == "s") {
+    node->s_(name, value.toStringRef());
+  } else if (kind == "ss") {
+    node->ss_(name, decodeAll<std::string>(value, [](const IValue& v) {
+      return v.toStringRef();
+    }));
+  } else if (kind == "t") {
+    node->t_(name, value.toTensor());
+  } else if (kind == "ts") {
+    node->ts_(name, decodeAll<at::Tensor>(value, [](const IValue& v) {
+      return v.toTensor();
+    }));
+  } else if (kind == "g") {
+    node->g_(name, decodeGraph(value));
+  } else if (kind == "gs") {
+    node->gs_(name, decodeAll<std::shared_ptr<Graph>>(value, decodeGraph));
+  } else if (kind == "ty") {
+    node->ty_(name, decodeTypeOf(value));
+  } else if (kind == "tys") {
+    node->tys_(name, decodeAll<TypePtr>(value, decodeTypeOf));
+  } else {
+    TORCH_CHECK(false, "Unknown attribute kind ", kind);
+  }
+}
+
+// Values are numbered in the order they are defined in: the inputs of a
+// block, then for every node its outputs, followed by the values of its
+// blocks.
+struct GraphEncoder {
+  IValue encodeValue(const Value* v) {
+    size_t id = ids.size();
+    ids[v] = id;
+    return Tuple::create(
+        {v->hasDebugName() ? v->debugName() : "", encodeType(v->type())});
+  }
+
+  IValue encodeInputs(const Node* node, at::ArrayRef<const Value*> inputs) {
+    std::vector<IValue> elements;
+    for (auto input : inputs) {
+      auto it = ids.find(input);
+      TORCH_INTERNAL_ASSERT(
+          it != ids.end(), "Use of an undefined value in ", *node);
+      elements.emplace_back(static_cast<int64_t>(it->second));
+    }
+    return Tuple::create(std::move(elements));
+  }
+
+  IValue encodeBlock(const Block* block) {
+    std::vector<IValue> inputs;
+    for (auto input : block->inputs()) {
+      inputs.push_back(encodeValue(input));
+    }
+    std::vector<IValue> nodes;
+    for (auto node : block->nodes()) {
+      nodes.push_back(encodeNode(node));
+    }
+    return Tuple::create(
+        {Tuple::create(std::move(inputs)),
+         Tuple::create(std::move(nodes)),
+         encodeInputs(block->return_node(), block->outputs())});
+  }
+
+  IValue encodeNode(const Node* node) {
+    // their state isn't in the graph
+    TORCH_CHECK(
+        node->kind() != prim::PythonOp && node->kind() != prim::profile,
+        "Can't serialize graphs with ",
+        node->kind().toQualString(),
+        " nodes");
+    auto inputs = encodeInputs(node, node->inputs());
+    std::vector<IValue> outputs;
+    for (auto output : node->outputs()) {
+      outputs.push_back(encodeValue(output));
+    }
+    std::vector<IValue> attributes;
+    for (auto name : node->attributeNames()) {
+      attributes.push_back(encodeAttribute(node, name));
+    }
+    std::vector<IValue> blocks;
+    for (auto block : node->blocks()) {
+      blocks.push_back(encodeBlock(block));
+    }
+    return Tuple::create(
+        {node->kind().toQualString(),
+         inputs,
+         Tuple::create(std::move(outputs)),
+         Tuple::create(std::move(attributes)),
+         Tuple::create(std::move(blocks))});
+  }
+
+  std::unordered_map<const Value*, size_t> ids;
+};
+
+struct GraphDecoder {
+  GraphDecoder(Graph* graph, const TypeResolver& resolver)
+      : graph(graph), resolver(resolver) {}
+
+  void decodeValue(Value* v, const IValue& value) {
+    const auto& elements = elementsOf(value);
+    if (!elements.at(0).toStringRef().empty()) {
+      v->setDebugName(elements[0].toStringRef());
+    }
+    v->setType(decodeType(elements.at(1), resolver));
+    values.push_back(v);
+  }
+
+  Value* valueAt(const IValue& id) {
+    return values.at(id.toInt());
+  }
+
+  void decodeBlock(Block* block, const IValue& value) {
+    const auto& elements = elementsOf(value);
+    for (const auto& input : elementsOf(elements.at(0))) {
+      decodeValue(block->addInput(), input);
+    }
+    for (const auto& node : elementsOf(elements.at(1))) {
+      block->appendNode(decodeNode(node));
+    }
+    for (const auto& output : elementsOf(elements.at(2))) {
+      block->registerOutput(valueAt(output));
+    }
+  }
+
+  Node* decodeNode(const IValue& value) {
+    const auto& elements = elementsOf(value);
+    auto node =
+        graph->create(Symbol::fromQualString(elements.at(0).toStringRef()), 0);
+    for (const auto& input : elementsOf(elements.at(1))) {
+      node->addInput(valueAt(input));
+    }
+    for (const auto& output : elementsOf(elements.at(2))) {
+      decodeValue(node->addOutput(), output);
+    }
+    for (const auto& attribute : elementsOf(elements.at(3))) {
+      decodeAttribute(node, attribute, resolver);
+    }
+    for (const auto& block : elementsOf(elements.at(4))) {
+      decodeBlock(node->addBlock(), block);
+    }
+    return node;
+  }
+
+  Graph* graph;
+  const TypeResolver& resolver;
+  std::vector<Value*> values;
+};
+
+IValue encodeSpec(const ArgumentSpec& spec) {
+  std::vector<IValue> tensors;
+  for (size_t i = 0; i < spec.numTensors(); ++i) {
+    const auto& arg = spec.tensorAt(i);
+    tensors.emplace_back(Tuple::create(
+        {arg.defined(),
+         arg.requires_grad(),
+         static_cast<int64_t>(arg.dim()),
+         static_cast<int64_t>(arg.device()),
+         static_cast<int64_t>(arg.type())}));
+  }
+  std::vector<IValue> optionals;
+  for (size_t i = 0; i < spec.numOptionals(); ++i) {
+    optionals.emplace_back(spec.isPresent(i));
+  }
+  return Tuple::create(
+      {Tuple::create(std::move(tensors)), Tuple::create(std::move(optionals))});
+}
+
+ArgumentSpec decodeSpec(const IValue& value) {
+  const auto& tensors = elementsOf(elementsOf(value).at(0));
+  const auto& optionals = elementsOf(elementsOf(value).at(1));
+  ArgumentSpec spec(tensors.size(), optionals.size());
+  for (const auto& tensor : tensors) {
+    const auto& arg = elementsOf(tensor);
+    spec.addTensorInfo(
+        arg.at(0).toBool(),
+        arg.at(1).toBool(),
+        arg.at(2).toInt(),
+        arg.at(3).toInt(),
+        static_cast<at::ScalarType>(arg.at(4).toInt()));
+  }
+  for (const auto& optional : optionals) {
+    spec.addOptionalPresence(optional.toBool());
+  }
+  return spec;
+}
+
+// The settings that change the plans GraphExecutors compile
+std::string optimizationSettings() {
+  std::ostringstream ss;
+  ss << "autodiff_subgraph_inlining=" << getAutodiffSubgraphInlining()
+     << ",parallel_branches=" << getParallelBranchesMode()
+     << ",fuse_on_cpu=" << canFuseOnCPU() << ",fuse_on_gpu=" << canFuseOnGPU();
+  return ss.str();
+}
+
+} // namespace
+
+IValue serializeGraph(const Graph& graph) {
+  return GraphEncoder().encodeBlock(graph.block());
+}
+
+std::shared_ptr<Graph> deserializeGraph(
+    const IValue& value,
+    const TypeResolver& resolver) {
+  auto graph = std::make_shared<Graph>();
+  GraphDecoder(graph.get(), resolver).decodeBlock(graph->block(), value);
+  graph->lint();
+  return graph;
+}
+
+IValue exportOptimizedPlans(const script::Module& module) {
+  std::vector<IValue> methods;
+  for (const auto& method : module.get_methods()) {
+    auto& executor = method.function().get_executor();
+    std::vector<IValue> plans;
+    for (const auto& plan : executor.getCompiledPlans()) {
+      try {
+        plans.emplace_back(Tuple::create(
+            {encodeSpec(plan.first), serializeGraph(*plan.second.graph)}));
+      } catch (const c10::Error& e) {
+        TORCH_WARN(
+            "Not saving an optimized plan of ",
+            method.name(),
+            ": ",
+            e.what_without_backtrace());
+      }
+    }
+    if (!plans.empty()) {
+      methods.emplace_back(Tuple::create(
+          {method.name(),
+           executor.graph()->toString(/*print_source_locations=*/false),
+           Tuple::create(std::move(plans))}));
+    }
+  }
+  return Tuple::create({kPlansVersion,
+                        optimizationSettings(),
+                        Tuple::create(std::move(methods))});
+}
+
+size_t importOptimizedPlans(
+    const script::Module& module,
+    const IValue& value,
+    const TypeResolver& resolver) {
+  const auto& elements = elementsOf(value);
+  if (elements.at(0).toInt() != kPlansVersion ||
+      elements.at(1).toStringRef() != optimizationSettings()) {
+    return 0;
+  }
+  size_t num_imported = 0;
+  for (const auto& method_plans : elementsOf(elements.at(2))) {
+    const auto& method_elements = elementsOf(method_plans);
+    auto method = module.find_method(method_elements.at(0).toStringRef());
+    if (!method) {
+      continue;
+    }
+    auto& executor = method->function().get_executor();
+    // plans of another version of the method
+    if (executor.graph()->toString(/*print_source_locations=*/false) !=
+        method_elements.at(1).toStringRef()) {
+      continue;
+    }
+    for (const auto& plan : elementsOf(method_elements.at(2))) {
+      const auto& plan_elements = elementsOf(plan);
+      std::shared_ptr<Graph> graph;
+      try {
+        graph = deserializeGraph(plan_elements.at(1), resolver);
+      } catch (const c10::Error& e) {
+        TORCH_WARN(
+            "Not restoring an optimized plan of ",
+            method->name(),
+            ": ",
+            e.what_without_backtrace());
+        continue;
+      }
+      if (!executor.addCompiledPlan(
+              decodeSpec(plan_elements.at(0)), std::move(graph))) {
+        return num_imported;
+      }
+      ++num_imported;
+    }
+  }
+  return num_imported;
+}
+
+} // namespace jit
+} // namespace torch
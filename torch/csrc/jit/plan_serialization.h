@@ -0,0 +1,45 @@
+#pragma once
+
+#include <ATen/core/ivalue.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/ir.h>
+#include <torch/csrc/jit/script/module.h>
+
+#include <atomic>
+#include <functional>
+
+namespace torch {
+namespace jit {
+
+// Serialization of the optimized plans GraphExecutors compile, so that a
+// process loading a module can run them without running the optimization
+// passes again.
+//
+// The plans are saved with the unoptimized graph of their method and a
+// description of the settings that affect the optimizations (fusers,
+// autodiff subgraph inlining...). They are only restored into a method with
+// the same graph, optimized with the same settings.
+
+// When set, ExportModule saves the plans compiled so far for the methods of
+// the module, in the "optimized_plans" archive. Off by default.
+TORCH_API std::atomic<bool>& getSaveOptimizedPlans();
+
+using TypeResolver = std::function<TypePtr(const c10::QualifiedName&)>;
+
+// Encodes a graph, with its types and attributes, as tuples. Throws for
+// graphs that can't be restored, e.g. with Python ops.
+TORCH_API IValue serializeGraph(const Graph& graph);
+// `resolver` looks up the named types, e.g. the module classes.
+TORCH_API std::shared_ptr<Graph> deserializeGraph(
+    const IValue& value,
+    const TypeResolver& resolver);
+
+TORCH_API IValue exportOptimizedPlans(const script::Module& module);
+// Returns the number of plans restored.
+TORCH_API size_t importOptimizedPlans(
+    const script::Module& module,
+    const IValue& value,
+    const TypeResolver& resolver);
+
+} // namespace jit
+} // namespace torch
@@ -14,6 +14,8 @@
 #include <torch/csrc/jit/passes/specialize_autogradzero.h>
 #include <torch/csrc/jit/profiling_graph_executor_impl.h>
 
+#include <algorithm>
+
 namespace torch {
 namespace jit {
 
@@ -22,6 +24,41 @@ std::atomic<bool>& getProfilingMode() {
   return profiling_mode;
 }
 
+static std::atomic<size_t> profiling_plan_cache_size{1};
+std::atomic<size_t>& getProfilingPlanCacheSize() {
+  return profiling_plan_cache_size;
+}
+
+// Drops the sizes other than 1 and the strides from the profiled types, so
+// that the guards inserted for them pass for all shapes of a ShapeBucket.
+static void makeProfiledShapesSymbolic(Block* block) {
+  for (auto n : block->nodes()) {
+    if (n->kind() == prim::profile) {
+      auto type = n->output()->type()->cast<TensorType>();
+      if (type && type->sizes().size()) {
+        std::vector<c10::optional<int64_t>> sizes;
+        for (size_t i = 0; i < *type->sizes().size(); i++) {
+          if (type->sizes()[i] == 1) {
+            sizes.push_back(1);
+          } else {
+            sizes.push_back(c10::nullopt);
+          }
+        }
+        n->output()->setType(TensorType::create(
+            type->scalarType(),
+            type->device(),
+            VaryingShape(sizes),
+            VaryingShape(sizes.size()),
+            type->requiresGrad(),
+            type->undefined()));
+      }
+    }
+    for (auto b : n->blocks()) {
+      makeProfiledShapesSymbolic(b);
+    }
+  }
+}
+
 std::shared_ptr<Graph> ProfilingGraphExecutorImpl::prepareGraph(
     const std::shared_ptr<Graph>& graph,
     Stack& stack) {
@@ -54,33 +91,97 @@ ProfilingGraphExecutorImpl::ProfilingGraphExecutorImpl(
     : GraphExecutorImplBase(graph), arg_spec_creator_(*this->graph) {}
 
 ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(Stack& stack) {
-  if (optimized_plan_) {
-    return *optimized_plan_;
+  std::lock_guard<std::mutex> lock(compile_mutex);
+  if (getProfilingPlanCacheSize() <= 1) {
+    return getPlanFor(plans_, stack, /*symbolic_shapes=*/false);
   }
+  return getPlanFor(bucketPlans(stack), stack, /*symbolic_shapes=*/true);
+}
 
-  if (!pr_) {
-    pr_ = ProfilingRecord::instrumentGraph(prepareGraph(graph, stack));
-    auto copy = pr_->graph()->copy();
+ProfilingGraphExecutorImpl::ShapeBucket ProfilingGraphExecutorImpl::
+    shapeBucketOf(const Stack& stack) const {
+  ShapeBucket bucket;
+  bucket.push_back(autograd::GradMode::is_enabled());
+  for (const IValue& input : last(stack, num_inputs)) {
+    if (!input.isTensor()) {
+      bucket.push_back(-1);
+      continue;
+    }
+    const auto& t = input.toTensor();
+    if (!t.defined()) {
+      bucket.push_back(-2);
+      continue;
+    }
+    bucket.push_back(t.dim());
+    bucket.push_back(static_cast<int64_t>(t.scalar_type()));
+    bucket.push_back(static_cast<int64_t>(t.device().type()));
+    bucket.push_back(t.device().index());
+    bucket.push_back(t.requires_grad());
+    for (auto size : t.sizes()) {
+      int64_t rounded = 1;
+      while (rounded < size) {
+        rounded *= 2;
+      }
+      bucket.push_back(size > 1 ? rounded : size);
+    }
+  }
+  return bucket;
+}
+
+ProfilingGraphExecutorImpl::ProfiledPlans& ProfilingGraphExecutorImpl::
+    bucketPlans(Stack& stack) {
+  auto bucket = shapeBucketOf(stack);
+  auto it = std::find_if(
+      bucket_plans_.begin(),
+      bucket_plans_.end(),
+      [&bucket](const std::pair<ShapeBucket, ProfiledPlans>& entry) {
+        return entry.first == bucket;
+      });
+  if (it != bucket_plans_.end()) {
+    bucket_plans_.splice(bucket_plans_.begin(), bucket_plans_, it);
+  } else {
+    bucket_plans_.emplace_front(std::move(bucket), ProfiledPlans());
+    while (bucket_plans_.size() > getProfilingPlanCacheSize()) {
+      bucket_plans_.pop_back();
+    }
+  }
+  return bucket_plans_.front().second;
+}
+
+ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(
+    ProfiledPlans& plans,
+    Stack& stack,
+    bool symbolic_shapes) {
+  if (plans.optimized_plan) {
+    return *plans.optimized_plan;
+  }
+
+  if (!plans.pr) {
+    plans.pr = ProfilingRecord::instrumentGraph(prepareGraph(graph, stack));
+    auto copy = plans.pr->graph()->copy();
     LowerGradOf(*copy);
     RemoveExpands(copy);
     CanonicalizeOps(copy);
     EliminateDeadCode(copy);
-    profiling_plan_ = ExecutionPlan(copy);
+    plans.profiling_plan = ExecutionPlan(copy);
     // fall-through
   }
 
-  if (!pr_->ready()) {
-    return *profiling_plan_;
+  if (!plans.pr->ready()) {
+    return *plans.profiling_plan;
   }
 
   // copy already has differentiableGraphs
-  auto copy = pr_->graph()->copy();
+  auto copy = plans.pr->graph()->copy();
   if (!getGraphExecutorOptimize()) {
     runRequiredPasses(copy);
-    optimized_plan_ = ExecutionPlan(copy);
-    return *optimized_plan_;
+    plans.optimized_plan = ExecutionPlan(copy);
+    return *plans.optimized_plan;
   }
 
+  if (symbolic_shapes) {
+    makeProfiledShapesSymbolic(copy->block());
+  }
   // insert bailouts
   InsertGuards(copy);
   // get rid of autograd specific ops
@@ -121,8 +222,8 @@ ExecutionPlan ProfilingGraphExecutorImpl::getPlanFor(Stack& stack) {
   }
   EliminateDeadCode(copy);
   // cache
-  optimized_plan_ = ExecutionPlan(copy);
-  return *optimized_plan_;
+  plans.optimized_plan = ExecutionPlan(copy);
+  return *plans.optimized_plan;
 }
 
 
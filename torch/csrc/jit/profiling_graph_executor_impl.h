@@ -1,6 +1,8 @@
 #pragma once
 #include <torch/csrc/jit/graph_executor_impl.h>
 
+#include <list>
+
 namespace torch {
 namespace jit {
 
@@ -12,13 +14,34 @@ struct ProfilingGraphExecutorImpl : public GraphExecutorImplBase {
   ~ProfilingGraphExecutorImpl() override = default;
 
  private:
+  // The profile of the graph and the plans built from it
+  struct ProfiledPlans {
+    std::unique_ptr<ProfilingRecord> pr;
+    c10::optional<ExecutionPlan>
+        profiling_plan; // plan to run in order to profiling the code
+    c10::optional<ExecutionPlan> optimized_plan;
+  };
+
+  // Identifies the inputs the plans of a bucket are used for: their types,
+  // ranks, which dimensions are 1, and the other dimensions rounded up to a
+  // power of two
+  using ShapeBucket = std::vector<int64_t>;
+
   std::shared_ptr<Graph> prepareGraph(
       const std::shared_ptr<Graph>& graph,
       Stack& stack);
-  std::unique_ptr<ProfilingRecord> pr_;
-  c10::optional<ExecutionPlan>
-      profiling_plan_; // plan to run in order to profiling the code
-  c10::optional<ExecutionPlan> optimized_plan_;
+  // With `symbolic_shapes`, the optimized plan only specializes on the
+  // ShapeBucket of the profiled inputs, instead of their exact shapes.
+  ExecutionPlan getPlanFor(
+      ProfiledPlans& plans,
+      Stack& stack,
+      bool symbolic_shapes);
+  ShapeBucket shapeBucketOf(const Stack& stack) const;
+  // The plans of the bucket of `stack`, most recently used first
+  ProfiledPlans& bucketPlans(Stack& stack);
+
+  ProfiledPlans plans_;
+  std::list<std::pair<ShapeBucket, ProfiledPlans>> bucket_plans_;
   ArgumentSpecCreator arg_spec_creator_;
 };
 
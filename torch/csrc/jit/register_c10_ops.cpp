@@ -47,7 +47,10 @@ IValue wrap(IValue&& ivalue) {
 // TODO This currently only handles tensors with requires_grad==False correctly.
 //      It should also handle autograd.
 Operator createOperatorFromC10(const c10::OperatorHandle& op) {
-  return Operator(op, [op](Stack& stack) {
+  // Copies of the operation, e.g. one per interpreter instruction calling
+  // it, get their own cache of the kernel they dispatch to.
+  c10::DispatchCache cache;
+  return Operator(op, [op, cache](Stack& stack) mutable {
       RECORD_FUNCTION(op.schema().name(), stack);
       const auto input_size = op.schema().arguments().size();
       const auto output_size = op.schema().returns().size();
@@ -141,10 +144,10 @@ Operator createOperatorFromC10(const c10::OperatorHandle& op) {
 #ifdef USE_STATIC_DISPATCH
       {
         at::AutoNonVariableTypeMode non_var_type_mode(true);
-        c10::Dispatcher::singleton().callBoxed(op, &stack);
+        c10::Dispatcher::singleton().callBoxed(op, &stack, &cache);
       }
 #else
-      c10::Dispatcher::singleton().callBoxed(op, &stack);
+      c10::Dispatcher::singleton().callBoxed(op, &stack, &cache);
 #endif // USE_STATIC_DISPATCH
 
       // wrap tensor outputs as variable
@@ -23,6 +23,9 @@
 #include <ATen/WrapDimUtils.h>
 #include <ATen/core/Dict.h>
 #include <ATen/core/ivalue.h>
+#include <c10/core/Event.h>
+#include <c10/core/StreamGuard.h>
+#include <c10/core/impl/VirtualGuardImpl.h>
 #include <c10/core/thread_pool.h>
 #include <c10/util/SmallVector.h>
 
@@ -231,6 +234,73 @@ int64_t normalizeIndex(int64_t idx, int64_t list_size) {
   return idx;
 }
 
+// Arenas backing one prim::MemoryArena node (see passes/memory_planning.h).
+// A run takes an arena nobody else holds: once every view handed out by a
+// previous run has been released, the pool's reference is the only one left,
+// so concurrent runs of the same graph never share an arena.
+struct ArenaPool {
+  ArenaPool(int64_t size, at::Device device) : size_(size), device_(device) {}
+
+  at::Tensor acquire() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    for (const auto& arena : arenas_) {
+      if (arena.use_count() == 1) {
+        return arena;
+      }
+    }
+    arenas_.push_back(
+        torch::empty({size_}, at::TensorOptions(device_).dtype(at::kByte)));
+    return arenas_.back();
+  }
+
+ private:
+  int64_t size_;
+  at::Device device_;
+  std::mutex mutex_;
+  std::vector<at::Tensor> arenas_;
+};
+
+// Runs a forked interpreter on a stream from the pool of `device`, so that
+// the kernels of independent branches aren't serialized on a single stream
+// (see passes/parallelize_branches.h). The branch first waits for the work
+// already queued on the calling stream, and the returned future completes
+// only once the calling stream has been made to wait for the branch's
+// kernels, so the values it returns are safe to use and free there.
+c10::intrusive_ptr<Future> forkOnStream(
+    InterpreterState forked,
+    Stack inputs,
+    c10::Device device) {
+  c10::Stream caller_stream =
+      c10::impl::VirtualGuardImpl(device.type()).getStream(device);
+  auto inputs_ready = std::make_shared<c10::Event>(device.type());
+  inputs_ready->record(caller_stream);
+
+  c10::intrusive_ptr<Future> branch_future = forked.getFuture();
+  auto future = c10::make_intrusive<Future>(branch_future->type());
+  bool grad_mode_enabled = autograd::GradMode::is_enabled();
+  at::launch([=]() {
+    c10::impl::VirtualGuardImpl impl(device.type());
+    c10::Stream stream = impl.getStreamFromPool(device);
+    c10::StreamGuard guard(stream);
+    inputs_ready->block(stream);
+    // the inputs are kept alive until the calling stream is ordered after
+    // the branch, which may still be reading them after it returned
+    Future* branch = branch_future.get();
+    branch->addCallback([=]() {
+      c10::Event done(device.type());
+      done.record(stream);
+      done.block(caller_stream);
+      try {
+        future->markCompleted(branch->value());
+      } catch (const Future::FutureError& error) {
+        future->markCompleted(Future::FutureError(error.what()));
+      }
+    });
+    InterpreterContinuation(forked, inputs, grad_mode_enabled)();
+  });
+  return future;
+}
+
 RegisterOperators reg(
     {Operator(
          prim::profile,
@@ -834,6 +904,41 @@ RegisterOperators reg(
            };
          },
          aliasAnalysisSpecialCase()),
+     Operator(
+         prim::MemoryArena,
+         [](const Node* node) -> Operation {
+           auto pool = std::make_shared<ArenaPool>(
+               node->i(attr::size), at::Device(node->s(attr::device)));
+           return [pool](Stack& stack) {
+             push(stack, pool->acquire());
+             return 0;
+           };
+         },
+         aliasAnalysisSpecialCase()),
+     Operator(
+         prim::ArenaTensor,
+         [](const Node* node) -> Operation {
+           std::vector<int64_t> sizes = node->is(attr::size);
+           std::vector<int64_t> strides = node->is(attr::stride);
+           auto dtype = static_cast<at::ScalarType>(node->i(attr::dtype));
+           int64_t byte_offset =
+               node->i(attr::storage_offset) * c10::elementSize(dtype);
+           return [sizes, strides, dtype, byte_offset](Stack& stack) {
+             at::Tensor arena = pop(stack).toTensor();
+             void* data = static_cast<uint8_t*>(arena.data_ptr()) + byte_offset;
+             // the deleter keeps the arena alive, and marked as in use, for
+             // as long as the view is
+             auto view = at::from_blob(
+                 data,
+                 sizes,
+                 strides,
+                 [arena](void*) {},
+                 arena.options().dtype(dtype));
+             push(stack, autograd::make_variable(std::move(view)));
+             return 0;
+           };
+         },
+         aliasAnalysisSpecialCase()),
      Operator(
          FunctionSchema(
              "aten::warn",
@@ -1263,7 +1368,23 @@ RegisterOperators reg(
            int n_inputs = node->inputs().size();
            AT_ASSERT(node->blocks().size() == 0);
            AT_ASSERT(node->hasAttribute(attr::Subgraph));
+           // set by ParallelizeBranches on branches of work for one GPU
+           c10::optional<c10::Device> stream_device;
+           if (node->hasAttribute(attr::device)) {
+             stream_device = c10::Device(node->s(attr::device));
+           }
            return [=](Stack& stack) {
+             if (stream_device) {
+               Stack inputs(stack.end() - n_inputs, stack.end());
+               drop(stack, n_inputs);
+               push(
+                   stack,
+                   forkOnStream(
+                       InterpreterState(code),
+                       std::move(inputs),
+                       *stream_device));
+               return 0;
+             }
              // Move inputs to a separate stack
              InterpreterState forked_interprester(code);
              InterpreterContinuation continuation(
@@ -1,6 +1,7 @@
 #include <torch/csrc/jit/script/init.h>
 
 #include <torch/csrc/Device.h>
+#include <torch/csrc/jit/export.h>
 #include <torch/csrc/jit/import.h>
 #include <torch/csrc/jit/script/compiler.h>
 #include <torch/csrc/jit/script/module.h>
@@ -579,6 +580,24 @@ void initJitScriptBindings(PyObject* module) {
           [](Module& self, const std::string& name) {
             return bool(self.find_method(name));
           })
+      .def(
+          "_compile_methods_in_parallel",
+          [](Module& self, py::dict method_inputs) {
+            std::vector<std::pair<Function*, Stack>> calls;
+            for (const auto& item : method_inputs) {
+              Method method =
+                  self.get_method(py::cast<std::string>(item.first));
+              calls.emplace_back(
+                  &method.function(),
+                  createStackForSchema(
+                      method.function().getSchema(),
+                      py::cast<py::tuple>(item.second),
+                      py::kwargs(),
+                      self.module_object()));
+            }
+            AutoNoGIL no_gil_guard;
+            compileInParallel(std::move(calls));
+          })
       .def(
           "_method_names",
           [](Module& self) {
@@ -754,6 +773,9 @@ void initJitScriptBindings(PyObject* module) {
         pp.printMethod(self.function());
         return pp.str();
       });
+  m.def("_export_opnames", [](Module& sm) {
+    return export_opnames(sm);
+  });
   m.def(
       "_jit_script_compile",
       [](const std::string& qualname,
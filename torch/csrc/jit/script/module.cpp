@@ -102,18 +102,23 @@ void Module::save(const std::string& filename, const ExtraFilesMap& extra_files)
 #endif
 }
 
-void Module::_save_for_mobile(std::ostream& out, const ExtraFilesMap& extra_files) const {
+void Module::_save_for_mobile(
+    std::ostream& out,
+    const ExtraFilesMap& extra_files,
+    WeightCompression weight_compression) const {
 #ifndef C10_MOBILE
-  ExportModule(*this, out, extra_files, true);
+  ExportModule(*this, out, extra_files, true, weight_compression);
 #else
   AT_ERROR("Saving module is not supported on mobile.");
 #endif
 }
 
-void Module::_save_for_mobile(const std::string& filename, const ExtraFilesMap& extra_files)
-    const {
+void Module::_save_for_mobile(
+    const std::string& filename,
+    const ExtraFilesMap& extra_files,
+    WeightCompression weight_compression) const {
 #ifndef C10_MOBILE
-  ExportModule(*this, filename, extra_files, true);
+  ExportModule(*this, filename, extra_files, true, weight_compression);
 #else
   AT_ERROR("Saving module is not supported on mobile.");
 #endif
@@ -7,6 +7,7 @@
 #include <torch/csrc/jit/named_value.h>
 #include <torch/csrc/jit/passes/shape_analysis.h>
 #include <torch/csrc/jit/source_range.h>
+#include <torch/csrc/jit/weight_compression.h>
 
 #include <torch/csrc/WindowsTorchApiMacro.h>
 #include <torch/csrc/api/include/torch/ordered_dict.h>
@@ -305,13 +306,17 @@ struct TORCH_API Module {
       const std::string& filename,
       const ExtraFilesMap& extra_files = ExtraFilesMap()) const;
 
+  // `weight_compression` stores the large float weights with a lossy
+  // encoding, see weight_compression.h.
   void _save_for_mobile(
       std::ostream& out,
-      const ExtraFilesMap& extra_files = ExtraFilesMap()) const;
+      const ExtraFilesMap& extra_files = ExtraFilesMap(),
+      WeightCompression weight_compression = WeightCompression::NONE) const;
 
   void _save_for_mobile(
       const std::string& filename,
-      const ExtraFilesMap& extra_files = ExtraFilesMap()) const;
+      const ExtraFilesMap& extra_files = ExtraFilesMap(),
+      WeightCompression weight_compression = WeightCompression::NONE) const;
 
   // Create a deep copy of this module.
   Module clone() const;
@@ -0,0 +1,122 @@
+#include <torch/csrc/jit/shared_weights.h>
+
+#include <c10/util/Exception.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
+namespace torch {
+namespace jit {
+
+namespace {
+
+// Offsets in the mapping are aligned for vectorized loads.
+constexpr size_t kAlignment = 64;
+
+void collectStorages(
+    const script::Module& module,
+    std::unordered_set<c10::StorageImpl*>& seen,
+    std::vector<at::Storage>& storages) {
+  for (const script::NameValue& slot : module.get_slots()) {
+    if (!slot.value.isTensor()) {
+      continue;
+    }
+    const at::Tensor& tensor = slot.value.toTensor();
+    if (!tensor.defined() || !tensor.has_storage() ||
+        tensor.device().type() != at::kCPU) {
+      continue;
+    }
+    const at::Storage& storage = tensor.storage();
+    if (storage.data() && seen.insert(storage.unsafeGetStorageImpl()).second) {
+      storages.push_back(storage);
+    }
+  }
+  for (const script::NameModule& child : module.get_modules()) {
+    collectStorages(child.module, seen, storages);
+  }
+}
+
+#ifndef _WIN32
+// Unmapped when the last storage using it is freed.
+struct Mapping {
+  Mapping(void* data, size_t size) : data(data), size(size) {}
+  ~Mapping() {
+    munmap(data, size);
+  }
+  void* const data;
+  const size_t size;
+};
+
+void deleteMappingRef(void* ctx) {
+  delete static_cast<std::shared_ptr<Mapping>*>(ctx);
+}
+#endif
+
+} // namespace
+
+size_t shareWeightsReadOnly(script::Module& module) {
+#ifdef _WIN32
+  TORCH_CHECK(false, "shareWeightsReadOnly is not supported on Windows");
+#else
+  std::unordered_set<c10::StorageImpl*> seen;
+  std::vector<at::Storage> storages;
+  collectStorages(module, seen, storages);
+
+  std::vector<size_t> offsets;
+  size_t size = 0;
+  for (const auto& storage : storages) {
+    offsets.push_back(size);
+    size += (storage.capacity() + kAlignment - 1) / kAlignment * kAlignment;
+  }
+  if (size == 0) {
+    return 0;
+  }
+
+  // An anonymous shared mapping is inherited as is by forked processes.
+  void* data = mmap(
+      nullptr,
+      size,
+      PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_ANONYMOUS,
+      /*fd=*/-1,
+      /*offset=*/0);
+  TORCH_CHECK(
+      data != MAP_FAILED,
+      "Failed to map ",
+      size,
+      " bytes of shared memory for the weights: ",
+      std::strerror(errno));
+  auto mapping = std::make_shared<Mapping>(data, size);
+  char* base = static_cast<char*>(data);
+  for (size_t i = 0; i < storages.size(); ++i) {
+    std::memcpy(base + offsets[i], storages[i].data(), storages[i].capacity());
+  }
+  TORCH_CHECK(
+      mprotect(data, size, PROT_READ) == 0,
+      "Failed to make the shared weights read-only: ",
+      std::strerror(errno));
+
+  for (size_t i = 0; i < storages.size(); ++i) {
+    auto& storage = storages[i];
+    storage.set_data_ptr(at::DataPtr(
+        base + offsets[i],
+        new std::shared_ptr<Mapping>(mapping),
+        &deleteMappingRef,
+        at::Device(at::kCPU)));
+    // The mapping can't be reallocated.
+    storage.unsafeGetStorageImpl()->set_resizable(false);
+    storage.unsafeGetStorageImpl()->set_allocator(nullptr);
+  }
+  return size;
+#endif
+}
+
+} // namespace jit
+} // namespace torch
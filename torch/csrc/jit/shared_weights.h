@@ -0,0 +1,28 @@
+#pragma once
+
+#include <torch/csrc/WindowsTorchApiMacro.h>
+#include <torch/csrc/jit/script/module.h>
+
+namespace torch {
+namespace jit {
+
+// Moves the data of the CPU tensors held by `module` and its submodules, its
+// parameters, buffers and other tensor attributes, to a single read-only
+// shared memory mapping, and returns the size of the mapping.
+//
+// This is meant for servers that load a model before forking workers: the
+// pages of the mapping are shared by all the processes forked afterwards,
+// instead of being copied by each of them as soon as it writes next to the
+// weights, e.g. to the reference counts or the allocator metadata of the
+// heap. The metadata of the tensors and storages stays on the heap, only the
+// data is mapped.
+//
+// The tensors can't be written to anymore: doing so, e.g. with an optimizer,
+// kills the process with a segmentation fault. Storages that are shared with
+// tensors outside the module are moved too.
+//
+// Only supported on POSIX systems.
+TORCH_API size_t shareWeightsReadOnly(script::Module& module);
+
+} // namespace jit
+} // namespace torch
@@ -2,8 +2,16 @@
 #include <ATen/core/Dict.h>
 #include <torch/csrc/jit/function.h>
 #include <torch/csrc/jit/pickler.h>
+#include <torch/csrc/utils/memory.h>
 #include "unpickler.h"
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
 #include <string>
+#include <thread>
 
 namespace torch {
 namespace jit {
@@ -158,8 +166,143 @@ void restoreAccurateTypeTags(const IValue& root, const TypePtr& type_tag) {
   }
 }
 
+static std::atomic<size_t> tensor_load_threads{4};
+
+std::atomic<size_t>& getTensorLoadThreads() {
+  return tensor_load_threads;
+}
+
+// Runs the reads of tensor records and their copies to CUDA on a bounded
+// pool of threads. The calls to `read_record` are serialized because the
+// stream reader is not thread-safe, but with a memory mapped archive those
+// only alias the file, and the copies out of it happen in parallel.
+class TensorLoader {
+ public:
+  // Host to device copies are staged through pinned buffers of this size.
+  static constexpr size_t kStagingSize = 4 * 1024 * 1024;
+
+  TensorLoader(
+      const std::function<at::DataPtr(const std::string&)>& read_record,
+      size_t num_threads)
+      : read_record_(read_record), num_threads_(num_threads) {}
+
+  ~TensorLoader() {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      stop_ = true;
+      queue_.clear();
+    }
+    queue_produce_cv_.notify_all();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  at::DataPtr read(const std::string& key) {
+    std::lock_guard<std::mutex> lock(read_mutex_);
+    return read_record_(key);
+  }
+
+  // Fills the contiguous tensor `dst` with the contents of record `key`.
+  void enqueue(std::string key, at::Tensor dst) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      queue_.emplace_back(std::move(key), std::move(dst));
+      pending_++;
+      if (threads_.size() < num_threads_ && threads_.size() < pending_) {
+        threads_.emplace_back(&TensorLoader::runLoop, this);
+      }
+    }
+    queue_produce_cv_.notify_one();
+  }
+
+  // Waits for all enqueued records and rethrows the first error.
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_done_cv_.wait(lock, [&] { return pending_ == 0; });
+    if (error_) {
+      std::rethrow_exception(std::exchange(error_, nullptr));
+    }
+  }
+
+ private:
+  void runLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      queue_produce_cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      auto job = std::move(queue_.front());
+      queue_.pop_front();
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        load(job.first, job.second);
+      } catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+      if (error && !error_) {
+        error_ = error;
+      }
+      if (--pending_ == 0) {
+        queue_done_cv_.notify_all();
+      }
+    }
+  }
+
+  void load(const std::string& key, at::Tensor& dst) {
+    at::DataPtr data = read(key);
+    const char* src = static_cast<const char*>(data.get());
+    const int64_t numel = dst.numel();
+    const int64_t chunk = std::max<int64_t>(
+        1, kStagingSize / dst.element_size());
+    auto staging_options = dst.options().device(at::kCPU).pinned_memory(true);
+    for (int64_t begin = 0; begin < numel; begin += chunk) {
+      const int64_t n = std::min(chunk, numel - begin);
+      // The caching host allocator doesn't hand out a staging buffer again
+      // before the copy out of it has finished, so the next chunk can be
+      // filled while this one is in flight. Waiting for the last chunk
+      // waits for all of them, as they are on the same stream.
+      auto staging = at::empty({n}, staging_options);
+      std::memcpy(
+          staging.data_ptr(),
+          src + begin * dst.element_size(),
+          n * dst.element_size());
+      const bool last = begin + n == numel;
+      dst.narrow(0, begin, n).copy_(staging, /*non_blocking=*/!last);
+    }
+  }
+
+  std::function<at::DataPtr(const std::string&)> read_record_;
+  std::mutex read_mutex_;
+
+  const size_t num_threads_;
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable queue_produce_cv_;
+  std::condition_variable queue_done_cv_;
+  std::deque<std::pair<std::string, at::Tensor>> queue_;
+  size_t pending_ = 0;
+  bool stop_ = false;
+  std::exception_ptr error_;
+};
+
+Unpickler::~Unpickler() = default;
+
+at::DataPtr Unpickler::readRecord(const std::string& key) {
+  if (tensor_loader_) {
+    return tensor_loader_->read(key);
+  }
+  return read_record_(key);
+}
+
 IValue Unpickler::parse_ivalue() {
   run();
+  if (tensor_loader_) {
+    tensor_loader_->wait();
+  }
   TORCH_CHECK(
       stack_.size() == 1,
       "Unpickler expected 1 element on the stack, but found ",
@@ -215,24 +358,15 @@ void Unpickler::setInput(size_t memo_id) {
   }
 }
 
-// emplace_back on bool vectors does not exist on some systems
-// avoid it by calling push_back for bool
-template <typename T>
-inline void append(std::vector<T>& a, T&& e) {
-  a.emplace_back(std::move(e));
-}
-template <>
-inline void append<bool>(std::vector<bool>& a, bool&& e) {
-  a.push_back(e);
-}
-
+// Builds the c10::List directly, going through a std::vector would copy
+// every element a second time.
 template <typename T>
 static IValue toSpecializedList(const IValue& generic) {
   auto ivalues = generic.toGenericListRef();
-  std::vector<T> specialized;
+  c10::List<T> specialized;
   specialized.reserve(ivalues.size());
   for (const IValue& iv : ivalues) {
-    append(specialized, iv.to<T>());
+    specialized.push_back(iv.to<T>());
   }
   return IValue(std::move(specialized));
 }
@@ -310,12 +444,10 @@ PickleOpCode Unpickler::readInstruction() {
     case PickleOpCode::TUPLE: {
       size_t start = marks_.back();
       marks_.pop_back();
-      auto tuple = c10::ivalue::Tuple::create({});
-      tuple->elements().reserve(stack_.size() - start);
       auto start_it = stack_.begin() + start;
-      for (auto it = start_it; it != stack_.end(); ++it) {
-        tuple->elements().emplace_back(*it);
-      }
+      auto tuple = c10::ivalue::Tuple::create(std::vector<IValue>(
+          std::make_move_iterator(start_it),
+          std::make_move_iterator(stack_.end())));
       stack_.erase(start_it, stack_.end());
       stack_.emplace_back(tuple);
     } break;
@@ -349,8 +481,9 @@ PickleOpCode Unpickler::readInstruction() {
       size_t start = marks_.back();
       marks_.pop_back();
       auto dict = c10::impl::GenericDict(AnyType::get(), AnyType::get());
+      dict.reserve((stack_.size() - start) / 2);
       for (size_t i = start; i < stack_.size(); i += 2) {
-        dict.insert_or_assign(stack_[i], stack_[i + 1]);
+        dict.insert_or_assign(std::move(stack_[i]), std::move(stack_[i + 1]));
       }
       stack_.erase(stack_.begin() + start, stack_.end());
       stack_.push_back(std::move(dict));
@@ -359,8 +492,10 @@ PickleOpCode Unpickler::readInstruction() {
       size_t start = marks_.back();
       marks_.pop_back();
       auto dict = stack_.at(start - 1).toGenericDict();
+      // All the items of a dict come in one SETITEMS, so this is its size
+      dict.reserve(dict.size() + (stack_.size() - start) / 2);
       for (size_t i = start; i < stack_.size(); i += 2) {
-        dict.insert_or_assign(stack_[i], stack_[i + 1]);
+        dict.insert_or_assign(std::move(stack_[i]), std::move(stack_[i + 1]));
       }
       stack_.erase(stack_.begin() + start, stack_.end());
     } break;
@@ -529,6 +664,10 @@ PickleOpCode Unpickler::readInstruction() {
         globals_.emplace_back([this, type] {
           auto val = stack_.back();
           stack_.pop_back();
+          // __setstate__ may read the tensors, so they must be loaded.
+          if (tensor_loader_ && checkHasValidSetGetState(type.type_)) {
+            tensor_loader_->wait();
+          }
           auto obj = obj_loader_(type, val);
           stack_.emplace_back(std::move(obj));
         });
@@ -563,8 +702,21 @@ PickleOpCode Unpickler::readInstruction() {
       if (device_) {
         device = *device_;
       }
-      at::DataPtr storage_ptr = read_record_(key);
       int64_t numel = args.at(4).toInt();
+      auto options = at::CPU(type).options();
+      if (device.type() == at::DeviceType::CUDA &&
+          options.backend() != c10::Backend::QuantizedCPU &&
+          getTensorLoadThreads() > 0) {
+        if (!tensor_loader_) {
+          tensor_loader_ = torch::make_unique<TensorLoader>(
+              read_record_, getTensorLoadThreads());
+        }
+        auto tensor = at::empty({numel}, options.device(device));
+        tensor_loader_->enqueue(key, tensor);
+        stack_.push_back(std::move(tensor));
+        break;
+      }
+      at::DataPtr storage_ptr = readRecord(key);
       at::Storage storage(
           at::CPU(type).typeMeta(),
           numel,
@@ -572,7 +724,6 @@ PickleOpCode Unpickler::readInstruction() {
           /*allocator=*/nullptr,
           /*resizable=*/false); // NB: we didn't set any allocator for the
                                 // tensor
-      auto options = at::CPU(type).options();
       at::Tensor tensor;
       if (options.backend() == c10::Backend::QuantizedCPU) {
         tensor = at::_empty_affine_quantized({}, options, 0, 0)
@@ -661,6 +812,7 @@ void Unpickler::readList(IValue list_ivalue) {
   marks_.pop_back();
   auto num_elements = stack_.size() - start;
   auto elements = at::ArrayRef<IValue>(stack_).slice(start);
+  // The items are erased from the stack below, they can be moved out of it
   if (list_ivalue.isIntList()) {
     auto list = std::move(list_ivalue).toIntList();
     list.reserve(num_elements);
@@ -670,8 +822,8 @@ void Unpickler::readList(IValue list_ivalue) {
   } else if (list_ivalue.isTensorList()) {
     auto list = std::move(list_ivalue).toTensorList();
     list.reserve(num_elements);
-    for (const auto& elem : elements) {
-      list.emplace_back(elem.toTensor());
+    for (size_t i = start; i < stack_.size(); ++i) {
+      list.emplace_back(std::move(stack_[i]).toTensor());
     }
   } else if (list_ivalue.isDoubleList()) {
     auto list = std::move(list_ivalue).toDoubleList();
@@ -688,8 +840,8 @@ void Unpickler::readList(IValue list_ivalue) {
   } else if (list_ivalue.isGenericList()) {
     auto list = std::move(list_ivalue).toGenericList();
     list.reserve(num_elements);
-    for (const auto& elem : elements) {
-      list.emplace_back(elem);
+    for (size_t i = start; i < stack_.size(); ++i) {
+      list.emplace_back(std::move(stack_[i]));
     }
   } else {
     AT_ERROR("Unknown IValue list kind: ", list_ivalue.tagKind());
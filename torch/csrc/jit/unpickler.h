@@ -1,10 +1,14 @@
 #pragma once
 
+#include <atomic>
+
 #include "pickler.h"
 
 namespace torch {
 namespace jit {
 
+class TensorLoader;
+
 using ClassResolver =
     std::function<c10::StrongTypePtr(const c10::QualifiedName&)>;
 
@@ -43,6 +47,8 @@ class Unpickler {
         read_record_(std::move(read_record)),
         device_(std::move(device)) {}
 
+  ~Unpickler();
+
   IValue parse_ivalue();
 
  private:
@@ -74,6 +80,7 @@ class Unpickler {
   void readList(IValue list_ivalue);
   void setInput(size_t memo_id);
   void run();
+  at::DataPtr readRecord(const std::string& key);
 
   // Returns the number of bytes read. This should statefully
   // remember the position. Don't call reader_ directly.
@@ -99,8 +106,17 @@ class Unpickler {
 
   std::function<at::DataPtr(const std::string&)> read_record_;
   c10::optional<at::Device> device_;
+  // Created when the first CUDA tensor is found, see getTensorLoadThreads().
+  std::unique_ptr<TensorLoader> tensor_loader_;
 };
 
+// Number of threads used to read tensor records and copy them to their CUDA
+// device while the rest of the archive is unpickled. The copies go through
+// pinned staging buffers, so reading a record overlaps with the host to
+// device copies of the ones before it. 0 loads every record on the calling
+// thread.
+TORCH_API std::atomic<size_t>& getTensorLoadThreads();
+
 void restoreAccurateTypeTags(const IValue& root, const c10::TypePtr& type_tag);
 
 } // namespace jit
@@ -0,0 +1,175 @@
+#include <torch/csrc/jit/weight_compression.h>
+
+#include <ATen/ATen.h>
+#include <c10/core/CPUAllocator.h>
+#include <c10/util/Exception.h>
+#include <c10/util/Half.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace torch {
+namespace jit {
+
+namespace {
+// Storages with fewer values are kept at full precision, the savings don't
+// matter and biases or batch norm statistics are more sensitive to errors.
+constexpr int64_t kMinCompressedNumel = 1024;
+
+struct CompressedRecord {
+  WeightCompression compression;
+  int64_t numel;
+  int64_t row_size;
+};
+} // namespace
+
+const char* toString(WeightCompression compression) {
+  switch (compression) {
+    case WeightCompression::NONE:
+      return "none";
+    case WeightCompression::FP16:
+      return "fp16";
+    case WeightCompression::INT8_ROWWISE:
+      return "int8_rowwise";
+  }
+  return nullptr;
+}
+
+WeightCompression parseWeightCompression(const std::string& str) {
+  if (str == "none") {
+    return WeightCompression::NONE;
+  } else if (str == "fp16") {
+    return WeightCompression::FP16;
+  } else if (str == "int8_rowwise") {
+    return WeightCompression::INT8_ROWWISE;
+  }
+  AT_ERROR("Unknown weight compression '", str, "'");
+}
+
+int64_t compressedRowSize(
+    const at::Tensor& tensor,
+    WeightCompression compression) {
+  int64_t numel = tensor.storage().numel();
+  if (compression == WeightCompression::NONE ||
+      tensor.scalar_type() != at::kFloat || tensor.is_quantized() ||
+      numel < kMinCompressedNumel) {
+    return 0;
+  }
+  // A tensor that is a view of a larger storage, or a storage shared by
+  // several tensors, is compressed as one row.
+  if (compression == WeightCompression::INT8_ROWWISE && tensor.dim() >= 2 &&
+      tensor.size(0) > 0 && tensor.numel() == numel && tensor.is_contiguous()) {
+    return numel / tensor.size(0);
+  }
+  return numel;
+}
+
+std::string compressWeights(
+    const float* data,
+    int64_t numel,
+    int64_t row_size,
+    WeightCompression compression) {
+  std::string result;
+  switch (compression) {
+    case WeightCompression::FP16: {
+      result.resize(numel * sizeof(c10::Half));
+      auto out = reinterpret_cast<c10::Half*>(&result[0]);
+      for (int64_t i = 0; i < numel; ++i) {
+        out[i] = c10::Half(data[i]);
+      }
+    } break;
+    case WeightCompression::INT8_ROWWISE: {
+      TORCH_CHECK(row_size > 0 && numel % row_size == 0);
+      // the scales and offsets of all rows, then the values
+      int64_t rows = numel / row_size;
+      result.resize(rows * 2 * sizeof(float) + numel);
+      auto scale_bias = reinterpret_cast<float*>(&result[0]);
+      auto out = reinterpret_cast<uint8_t*>(&result[rows * 2 * sizeof(float)]);
+      for (int64_t r = 0; r < rows; ++r) {
+        const float* row = data + r * row_size;
+        auto minmax = std::minmax_element(row, row + row_size);
+        float min = *minmax.first;
+        float scale = (*minmax.second - min) / 255.0f;
+        if (scale == 0 || !std::isfinite(scale)) {
+          scale = 1.0f;
+        }
+        scale_bias[2 * r] = scale;
+        scale_bias[2 * r + 1] = min;
+        for (int64_t i = 0; i < row_size; ++i) {
+          float q = std::nearbyint((row[i] - min) / scale);
+          out[r * row_size + i] =
+              static_cast<uint8_t>(std::min(255.0f, std::max(0.0f, q)));
+        }
+      }
+    } break;
+    case WeightCompression::NONE:
+      AT_ERROR("No weight compression to apply");
+  }
+  return result;
+}
+
+at::DataPtr decompressWeights(
+    const void* data,
+    int64_t numel,
+    int64_t row_size,
+    WeightCompression compression) {
+  at::DataPtr result = c10::GetCPUAllocator()->allocate(numel * sizeof(float));
+  auto out = static_cast<float*>(result.get());
+  switch (compression) {
+    case WeightCompression::FP16: {
+      auto in = static_cast<const c10::Half*>(data);
+      for (int64_t i = 0; i < numel; ++i) {
+        out[i] = static_cast<float>(in[i]);
+      }
+    } break;
+    case WeightCompression::INT8_ROWWISE: {
+      TORCH_CHECK(row_size > 0 && numel % row_size == 0);
+      int64_t rows = numel / row_size;
+      auto scale_bias = static_cast<const float*>(data);
+      auto in = static_cast<const uint8_t*>(data) + rows * 2 * sizeof(float);
+      for (int64_t r = 0; r < rows; ++r) {
+        float scale = scale_bias[2 * r];
+        float bias = scale_bias[2 * r + 1];
+        for (int64_t i = r * row_size; i < (r + 1) * row_size; ++i) {
+          out[i] = in[i] * scale + bias;
+        }
+      }
+    } break;
+    case WeightCompression::NONE:
+      AT_ERROR("No weight compression to decode");
+  }
+  return result;
+}
+
+RecordReader decompressingRecordReader(
+    const IValue& manifest,
+    RecordReader read_record) {
+  auto records =
+      std::make_shared<std::unordered_map<std::string, CompressedRecord>>();
+  for (const auto& entry : manifest.toTuple()->elements()) {
+    const auto& items = entry.toTuple()->elements();
+    TORCH_CHECK(
+        items.size() == 4,
+        "There should be four parts in a compressed weight entry.");
+    records->emplace(
+        items[0].toStringRef(),
+        CompressedRecord{parseWeightCompression(items[1].toStringRef()),
+                         items[2].toInt(),
+                         items[3].toInt()});
+  }
+  return [records, read_record](const std::string& name) {
+    at::DataPtr data = read_record(name);
+    auto it = records->find(name);
+    if (it == records->end()) {
+      return data;
+    }
+    const auto& record = it->second;
+    return decompressWeights(
+        data.get(), record.numel, record.row_size, record.compression);
+  };
+}
+
+} // namespace jit
+} // namespace torch
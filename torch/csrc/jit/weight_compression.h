@@ -0,0 +1,62 @@
+#pragma once
+
+#include <ATen/core/ivalue.h>
+#include <c10/core/Allocator.h>
+#include <torch/csrc/WindowsTorchApiMacro.h>
+
+#include <functional>
+#include <string>
+
+namespace torch {
+namespace jit {
+
+// Lossy encodings of the float weights of a serialized module, to make
+// models for mobile smaller.
+//
+// The compressed storages of the "data" archive are listed in the
+// "weight_compression" archive, a tuple of
+// (record name, encoding, number of values, row size) tuples. Loaders decode
+// them back to float storages when reading the records, so the rest of the
+// module is unchanged.
+enum class WeightCompression {
+  NONE,
+  // IEEE half precision values
+  FP16,
+  // uint8 values with a float scale and offset per row: a row holds the
+  // values of one output channel (the first dimension) of the tensor
+  INT8_ROWWISE,
+};
+
+constexpr const char* kWeightCompressionArchive = "weight_compression";
+
+TORCH_API const char* toString(WeightCompression compression);
+TORCH_API WeightCompression parseWeightCompression(const std::string& str);
+
+// The number of values per row to compress the storage of `tensor` with, or
+// 0 to keep it at full precision, e.g. for small tensors like biases.
+TORCH_API int64_t compressedRowSize(
+    const at::Tensor& tensor,
+    WeightCompression compression);
+
+TORCH_API std::string compressWeights(
+    const float* data,
+    int64_t numel,
+    int64_t row_size,
+    WeightCompression compression);
+
+// Returns a buffer of `numel` floats.
+TORCH_API at::DataPtr decompressWeights(
+    const void* data,
+    int64_t numel,
+    int64_t row_size,
+    WeightCompression compression);
+
+using RecordReader = std::function<at::DataPtr(const std::string&)>;
+
+// Wraps the record reader of the "data" archive to decode the records listed
+// in `manifest`, the "weight_compression" archive.
+TORCH_API RecordReader
+decompressingRecordReader(const IValue& manifest, RecordReader read_record);
+
+} // namespace jit
+} // namespace torch
@@ -16,11 +16,19 @@ void initThroughputBenchmarkBindings(PyObject* module) {
           "num_calling_threads", &BenchmarkConfig::num_calling_threads)
       .def_readwrite("num_worker_threads", &BenchmarkConfig::num_worker_threads)
       .def_readwrite("num_warmup_iters", &BenchmarkConfig::num_warmup_iters)
-      .def_readwrite("num_iters", &BenchmarkConfig::num_iters);
+      .def_readwrite("num_iters", &BenchmarkConfig::num_iters)
+      .def_readwrite("target_qps", &BenchmarkConfig::target_qps);
 
   py::class_<BenchmarkExecutionStats>(m, "BenchmarkExecutionStats")
       .def_readonly("latency_avg_ms", &BenchmarkExecutionStats::latency_avg_ms)
-      .def_readonly("num_iters", &BenchmarkExecutionStats::num_iters);
+      .def_readonly("num_iters", &BenchmarkExecutionStats::num_iters)
+      .def_readonly("latency_p50_ms", &BenchmarkExecutionStats::latency_p50_ms)
+      .def_readonly("latency_p90_ms", &BenchmarkExecutionStats::latency_p90_ms)
+      .def_readonly("latency_p99_ms", &BenchmarkExecutionStats::latency_p99_ms)
+      .def_readonly("latency_p999_ms", &BenchmarkExecutionStats::latency_p999_ms)
+      .def_readonly("total_time_ms", &BenchmarkExecutionStats::total_time_ms)
+      .def_readonly(
+          "thread_cpu_time_ms", &BenchmarkExecutionStats::thread_cpu_time_ms);
 
   py::class_<ThroughputBenchmark>(m, "ThroughputBenchmark", py::dynamic_attr())
       .def(py::init<jit::script::Module>())
@@ -43,7 +51,15 @@ void initThroughputBenchmarkBindings(PyObject* module) {
         // inputs and running actual inference
         AutoNoGIL no_gil_guard;
         return self.benchmark(config);
-      });
+      })
+      .def_static(
+          "benchmark_concurrently",
+          [](const std::vector<ThroughputBenchmark*>& benchmarks,
+             const std::vector<BenchmarkConfig>& configs) {
+            AutoNoGIL no_gil_guard;
+            return ThroughputBenchmark::benchmarkConcurrently(
+                benchmarks, configs);
+          });
 
 
 }
@@ -9,6 +9,7 @@
 
 #include <ATen/ATen.h>
 
+#include <algorithm>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -578,10 +579,21 @@ bool FunctionSignature::parse(PyObject* args, PyObject* kwargs, PyObject* dst[],
   return true;
 }
 
+constexpr ssize_t PythonArgParser::kMaxCachedArgs;
+constexpr size_t PythonArgParser::kCacheSize;
+
+// All the parsers, for the statistics. Parsers are static objects created
+// with the GIL held.
+static std::vector<PythonArgParser*>& all_parsers() {
+  static std::vector<PythonArgParser*> parsers;
+  return parsers;
+}
+
 PythonArgParser::PythonArgParser(std::vector<std::string> fmts, bool traceable)
  : max_args(0)
  , traceable(traceable)
 {
+  all_parsers().push_back(this);
   for (auto& fmt : fmts) {
     signatures_.emplace_back(fmt);
   }
@@ -599,12 +611,44 @@ PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject
   if (signatures_.size() == 1) {
     auto& signature = signatures_[0];
     signature.parse(args, kwargs, parsed_args, true);
+    signature.slow_path_parses++;
     return PythonArgs(0, traceable, signature, parsed_args);
   }
 
+  const ssize_t nargs = PyTuple_GET_SIZE(args);
+  const bool cacheable = (!kwargs || PyDict_Size(kwargs) == 0) && nargs <= kMaxCachedArgs;
+  if (cacheable) {
+    for (auto& entry : cache_) {
+      if (entry.nargs != nargs) {
+        continue;
+      }
+      bool hit = true;
+      for (ssize_t k = 0; k < nargs; k++) {
+        if (Py_TYPE(PyTuple_GET_ITEM(args, k)) != entry.types[k]) {
+          hit = false;
+          break;
+        }
+      }
+      if (hit) {
+        // the earlier overloads can't match, but this one may still reject
+        // the values of the arguments
+        auto& signature = signatures_[entry.signature_idx];
+        if (signature.parse(args, kwargs, parsed_args, false)) {
+          signature.fast_path_hits++;
+          return PythonArgs(entry.signature_idx, traceable, signature, parsed_args);
+        }
+        break;
+      }
+    }
+  }
+
   int i = 0;
   for (auto& signature : signatures_) {
     if (signature.parse(args, kwargs, parsed_args, false)) {
+      signature.slow_path_parses++;
+      if (cacheable && can_cache(i, args)) {
+        add_to_cache(i, args);
+      }
       return PythonArgs(i, traceable, signature, parsed_args);
     }
     i++;
@@ -613,6 +657,78 @@ PythonArgs PythonArgParser::raw_parse(PyObject* args, PyObject* kwargs, PyObject
   print_error(args, kwargs, parsed_args);
 }
 
+// Whether the signatures before signature_idx fail to parse any positional
+// arguments of the same types as `args`. That's the case unless one of them
+// could accept a Tensor argument depending on its dimension, dtype or
+// requires_grad, or an object through __index__.
+bool PythonArgParser::can_cache(int signature_idx, PyObject* args) {
+  const ssize_t nargs = PyTuple_GET_SIZE(args);
+  for (int j = 0; j < signature_idx; j++) {
+    const auto& signature = signatures_[j];
+    const bool allow_varargs_intlist = signature.max_pos_args == 1 &&
+        signature.params[0].type_ == ParameterType::INT_LIST;
+    if (allow_varargs_intlist && nargs > 0) {
+      PyObject* first = PyTuple_GET_ITEM(args, 0);
+      if (!THPUtils_checkLong(first) && !PyTuple_Check(first) && !PyList_Check(first)) {
+        return false;
+      }
+    }
+    const ssize_t num_params = std::min<ssize_t>(nargs, signature.params.size());
+    for (ssize_t k = 0; k < num_params; k++) {
+      if (!THPVariable_Check(PyTuple_GET_ITEM(args, k))) {
+        continue;
+      }
+      switch (signature.params[k].type_) {
+        case ParameterType::SCALAR:
+        case ParameterType::COMPLEX:
+        case ParameterType::DOUBLE:
+        case ParameterType::INT64:
+          return false;
+        default:
+          break;
+      }
+    }
+  }
+  return true;
+}
+
+void PythonArgParser::add_to_cache(int signature_idx, PyObject* args) {
+  auto& entry = cache_[next_cache_entry_];
+  next_cache_entry_ = (next_cache_entry_ + 1) % kCacheSize;
+  for (ssize_t k = 0; k < entry.nargs; k++) {
+    Py_DECREF(entry.types[k]);
+  }
+  entry.nargs = PyTuple_GET_SIZE(args);
+  for (ssize_t k = 0; k < entry.nargs; k++) {
+    // keep the types alive so that a new type can't reuse their address
+    entry.types[k] = Py_TYPE(PyTuple_GET_ITEM(args, k));
+    Py_INCREF(entry.types[k]);
+  }
+  entry.signature_idx = signature_idx;
+}
+
+std::vector<std::tuple<std::string, uint64_t, uint64_t>> PythonArgParser::stats() {
+  std::vector<std::tuple<std::string, uint64_t, uint64_t>> result;
+  for (auto parser : all_parsers()) {
+    for (auto& signature : parser->signatures_) {
+      if (signature.fast_path_hits > 0 || signature.slow_path_parses > 0) {
+        result.emplace_back(
+            signature.toString(), signature.fast_path_hits, signature.slow_path_parses);
+      }
+    }
+  }
+  return result;
+}
+
+void PythonArgParser::reset_stats() {
+  for (auto parser : all_parsers()) {
+    for (auto& signature : parser->signatures_) {
+      signature.fast_path_hits = 0;
+      signature.slow_path_parses = 0;
+    }
+  }
+}
+
 void PythonArgParser::print_error(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]) {
   auto num_args = PyTuple_GET_SIZE(args) + (kwargs ? PyDict_Size(kwargs) : 0);
   std::vector<int> plausible_idxs;
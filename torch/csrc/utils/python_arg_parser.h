@@ -72,6 +72,7 @@
 #include <memory>
 #include <sstream>
 #include <string>
+#include <tuple>
 #include <vector>
 
 namespace torch {
@@ -99,15 +100,39 @@ struct PythonArgParser {
   template<int N>
   inline PythonArgs parse(PyObject* args, PyObject* kwargs, ParsedArgs<N>& dst);
 
+  // Returns (signature, fast path hits, slow path parses) for every signature
+  // of every parser that was used since the last reset.
+  static std::vector<std::tuple<std::string, uint64_t, uint64_t>> stats();
+  static void reset_stats();
+
 private:
   [[noreturn]]
   void print_error(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]);
   PythonArgs raw_parse(PyObject* args, PyObject* kwargs, PyObject* parsed_args[]);
+  bool can_cache(int signature_idx, PyObject* args);
+  void add_to_cache(int signature_idx, PyObject* args);
+
+  // Overloads are tried in order, so a call with several overloads parses
+  // each of the earlier ones before reaching the matching one. Calls without
+  // keyword arguments and with at most kMaxCachedArgs positional arguments
+  // are remembered by the exact types of their arguments, and the overload
+  // they matched is tried first the next time. An entry is only created when
+  // the earlier overloads can't match arguments of those types regardless of
+  // their values.
+  static constexpr ssize_t kMaxCachedArgs = 4;
+  static constexpr size_t kCacheSize = 4;
+  struct CacheEntry {
+    ssize_t nargs = -1;
+    std::array<PyTypeObject*, kMaxCachedArgs> types{};
+    int signature_idx = -1;
+  };
 
   std::vector<FunctionSignature> signatures_;
   std::string function_name;
   ssize_t max_args;
   bool traceable;
+  std::array<CacheEntry, kCacheSize> cache_;
+  size_t next_cache_entry_ = 0;
 };
 
 struct PythonArgs {
@@ -181,6 +206,10 @@ struct FunctionSignature {
   ssize_t max_pos_args;
   bool hidden;
   bool deprecated;
+  // how often the signature matched through the overload cache of its
+  // parser or by trying it in order
+  uint64_t fast_path_hits = 0;
+  uint64_t slow_path_parses = 0;
 };
 
 struct FunctionParameter {
@@ -200,6 +200,21 @@ ScalarType infer_scalar_type(PyObject *obj) {
   AT_ERROR("Could not infer dtype of ", Py_TYPE(obj)->tp_name);
 }
 
+#ifdef USE_NUMPY
+bool numpy_array_has_sizes(PyObject* obj, IntArrayRef sizes) {
+  auto array = (PyArrayObject*)obj;
+  if (PyArray_NDIM(array) != static_cast<int>(sizes.size())) {
+    return false;
+  }
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (PyArray_DIMS(array)[i] != sizes[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+#endif
+
 void recursive_store(char* data, IntArrayRef sizes, IntArrayRef strides, int64_t dim,
                             ScalarType scalarType, int elementSize, PyObject* obj) {
   int64_t ndim = sizes.size();
@@ -208,6 +223,18 @@ void recursive_store(char* data, IntArrayRef sizes, IntArrayRef strides, int64_t
     return;
   }
 
+#ifdef USE_NUMPY
+  // An ndarray filling the remaining dimensions, like an item of a list of
+  // same-shape ndarrays, is copied in one go instead of element by element.
+  if (is_viewable_numpy_array(obj) && numpy_array_has_sizes(obj, sizes.slice(dim))) {
+    auto src = tensor_from_numpy(obj);
+    auto dst = at::from_blob(data, sizes.slice(dim), strides.slice(dim), at::device(kCPU).dtype(scalarType));
+    AutoNoGIL no_gil;
+    dst.copy_(src);
+    return;
+  }
+#endif
+
   auto n = sizes[dim];
   auto seq = THPObjectPtr(PySequence_Fast(obj, "not a sequence"));
   if (!seq) throw python_error();
@@ -224,6 +251,115 @@ void recursive_store(char* data, IntArrayRef sizes, IntArrayRef strides, int64_t
   }
 }
 
+bool is_little_endian() {
+  const uint16_t one = 1;
+  return *reinterpret_cast<const uint8_t*>(&one) == 1;
+}
+
+// The dtype of the items of a buffer with the struct module format `format`,
+// if a tensor can hold them.
+c10::optional<ScalarType> buffer_format_to_scalar_type(const char* format, Py_ssize_t itemsize) {
+  // A buffer without a format holds unsigned bytes.
+  if (!format) {
+    format = "B";
+  }
+  if (*format == '@' || *format == '=' ||
+      (*format == '<' && is_little_endian()) ||
+      ((*format == '>' || *format == '!') && !is_little_endian())) {
+    format++;
+  }
+  if (format[0] == '\0' || format[1] != '\0') {
+    return c10::nullopt;
+  }
+  switch (format[0]) {
+    case '?':
+      if (itemsize == 1) return ScalarType::Bool;
+      break;
+    case 'B':
+      if (itemsize == 1) return ScalarType::Byte;
+      break;
+    case 'b':
+    case 'h':
+    case 'i':
+    case 'l':
+    case 'q':
+    case 'n':
+      switch (itemsize) {
+        case 1: return ScalarType::Char;
+        case 2: return ScalarType::Short;
+        case 4: return ScalarType::Int;
+        case 8: return ScalarType::Long;
+      }
+      break;
+    case 'e':
+      if (itemsize == 2) return ScalarType::Half;
+      break;
+    case 'f':
+      if (itemsize == 4) return ScalarType::Float;
+      break;
+    case 'd':
+      if (itemsize == 8) return ScalarType::Double;
+      break;
+  }
+  return c10::nullopt;
+}
+
+// Python gives the items of a buffer as bools, ints and floats.
+ScalarType buffer_element_scalar_type(ScalarType buffer_scalar_type) {
+  if (at::isFloatingType(buffer_scalar_type)) {
+    return torch::tensors::get_default_scalar_type();
+  }
+  return buffer_scalar_type == ScalarType::Bool ? ScalarType::Bool : ScalarType::Long;
+}
+
+// Views the memory of an object implementing the buffer protocol, such as a
+// memoryview, bytearray, array.array or Arrow buffer, without copying it.
+// Returns an undefined tensor if obj doesn't implement it, or its items or
+// strides don't fit in a tensor.
+Tensor tensor_from_buffer(PyObject* obj) {
+  if (!PyObject_CheckBuffer(obj)) {
+    return Tensor();
+  }
+  auto buffer = new Py_buffer();
+  if (PyObject_GetBuffer(obj, buffer, PyBUF_RECORDS_RO) != 0) {
+    PyErr_Clear();
+    delete buffer;
+    return Tensor();
+  }
+  auto release = [buffer]() {
+    PyBuffer_Release(buffer);
+    delete buffer;
+  };
+
+  auto scalar_type = buffer_format_to_scalar_type(buffer->format, buffer->itemsize);
+  if (!scalar_type) {
+    release();
+    return Tensor();
+  }
+  std::vector<int64_t> sizes(buffer->ndim);
+  std::vector<int64_t> strides(buffer->ndim);
+  for (int i = 0; i < buffer->ndim; i++) {
+    // Buffer strides are in bytes, and, as for NumPy arrays, negative ones
+    // aren't supported.
+    if (buffer->strides[i] < 0 || buffer->strides[i] % buffer->itemsize != 0) {
+      release();
+      return Tensor();
+    }
+    sizes[i] = buffer->shape[i];
+    strides[i] = buffer->strides[i] / buffer->itemsize;
+  }
+  return at::from_blob(
+      buffer->buf,
+      sizes,
+      strides,
+      [buffer](void* data) {
+        AutoGIL gil;
+        PyBuffer_Release(buffer);
+        delete buffer;
+      },
+      at::device(kCPU).dtype(*scalar_type));
+}
+
 Tensor internal_new_from_data(
     c10::TensorTypeId type_id,
     at::ScalarType scalar_type,
@@ -275,6 +411,25 @@ Tensor internal_new_from_data(
   }
 #endif
 
+  bool view_buffer = !pin_memory;
+#ifdef USE_NUMPY
+  // NumPy scalars implement the buffer protocol too, but are stored like
+  // Python scalars below.
+  view_buffer = view_buffer && !PyArray_CheckScalar(data);
+#endif
+  if (view_buffer) {
+    auto buffer_tensor = tensor_from_buffer(data);
+    if (buffer_tensor.defined()) {
+      auto tensor = autograd::make_variable(buffer_tensor, /*requires_grad=*/false);
+      // As for the elements of the buffer as a sequence.
+      const auto& inferred_scalar_type = type_inference ? buffer_element_scalar_type(tensor.scalar_type()) : scalar_type;
+      auto device = device_opt.has_value() ? *device_opt : at::Device(computeDeviceType(type_id));
+      AutoNoGIL no_gil;
+      maybe_initialize_cuda(device);
+      return tensor.to(device, inferred_scalar_type, /*non_blocking=*/false, /*copy=*/copy_numpy);
+    }
+  }
+
   auto sizes = compute_sizes(data);
   ScalarType inferred_scalar_type = type_inference ? infer_scalar_type(data) : scalar_type;
   auto tensor = autograd::make_variable(at::empty(sizes, at::initialTensorOptions().dtype(inferred_scalar_type).pinned_memory(pin_memory)), /*requires_grad=*/false);
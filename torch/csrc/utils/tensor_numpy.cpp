@@ -13,6 +13,9 @@ at::Tensor tensor_from_numpy(PyObject* obj) {
 bool is_numpy_scalar(PyObject* obj) {
   throw std::runtime_error("PyTorch was compiled without NumPy support");
 }
+bool is_viewable_numpy_array(PyObject* obj) {
+  return false;
+}
 at::Tensor tensor_from_cuda_array_interface(PyObject* obj) {
     throw std::runtime_error("PyTorch was compiled without NumPy support");
 }
@@ -233,6 +236,39 @@ bool is_numpy_scalar(PyObject* obj) {
           PyArray_IsScalar(obj, Floating));
 }
 
+bool is_viewable_numpy_array(PyObject* obj) {
+  if (!PyArray_Check(obj)) {
+    return false;
+  }
+  auto array = (PyArrayObject*)obj;
+  switch (PyArray_TYPE(array)) {
+    case NPY_DOUBLE:
+    case NPY_FLOAT:
+    case NPY_HALF:
+    case NPY_INT16:
+    case NPY_INT8:
+    case NPY_UINT8:
+    case NPY_BOOL:
+      break;
+    default:
+      if (PyArray_TYPE(array) != NPY_INT && PyArray_TYPE(array) != NPY_INT32 &&
+          PyArray_TYPE(array) != NPY_LONGLONG && PyArray_TYPE(array) != NPY_INT64) {
+        return false;
+      }
+  }
+  if (!PyArray_EquivByteorders(PyArray_DESCR(array)->byteorder, NPY_NATIVE)) {
+    return false;
+  }
+  auto element_size_in_bytes = PyArray_ITEMSIZE(array);
+  for (int i = 0; i < PyArray_NDIM(array); i++) {
+    auto stride = PyArray_STRIDES(array)[i];
+    if (stride < 0 || stride % element_size_in_bytes != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 at::Tensor tensor_from_cuda_array_interface(PyObject* obj) {
   auto cuda_dict = THPObjectPtr(PyObject_GetAttrString(obj, "__cuda_array_interface__"));
   TORCH_INTERNAL_ASSERT(cuda_dict);
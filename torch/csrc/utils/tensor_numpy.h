@@ -13,6 +13,9 @@ at::ScalarType numpy_dtype_to_aten(int dtype);
 
 bool is_numpy_scalar(PyObject* obj);
 
+// Whether tensor_from_numpy can view obj.
+bool is_viewable_numpy_array(PyObject* obj);
+
 at::Tensor tensor_from_cuda_array_interface(PyObject* obj);
 
 }} // namespace torch::utils
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <random>
 #include <thread>
 
@@ -17,6 +19,12 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
   TORCH_CHECK(
       config.num_worker_threads == 1,
       "Only parallelization by callers is supported");
+  TORCH_CHECK(config.target_qps >= 0, "target_qps can't be negative");
+
+  using Clock = std::chrono::high_resolution_clock;
+  using TimePoint = std::chrono::time_point<Clock>;
+  TimePoint start_time;
+  const bool open_loop = config.target_qps > 0;
 
   // We pre-generate inputs here for each of the threads. This allows us to
   // safely move inputs out for each of the threads independently and thus avoid
@@ -43,6 +51,24 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     }
   }
 
+  // In the open-loop mode the arrival times of all the requests, relative to
+  // the start of the measurement, are drawn up front
+  std::vector<Clock::duration> arrivals;
+  if (open_loop) {
+    std::random_device seeder;
+    std::mt19937 engine(seeder());
+    std::exponential_distribution<double> interarrival_s(config.target_qps);
+    arrivals.reserve(config.num_iters);
+    double arrival_s = 0;
+    for (int64_t i = 0; i < config.num_iters; ++i) {
+      arrival_s += interarrival_s(engine);
+      arrivals.push_back(std::chrono::duration_cast<Clock::duration>(
+          std::chrono::duration<double>(arrival_s)));
+    }
+  }
+  std::vector<std::vector<float>> thread_latencies_ms(config.num_calling_threads);
+  std::vector<float> thread_cpu_time_ms(config.num_calling_threads);
+
   std::mutex m;
   std::condition_variable worker_main_cv;
   std::condition_variable main_worker_cv;
@@ -71,10 +97,25 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
         }
       }
       LOG(INFO) << "Starting forward thread " << thread_id;
-      while (num_attempted_iters.fetch_add(1) < config.num_iters) {
+      auto& latencies_ms = thread_latencies_ms[thread_id];
+      latencies_ms.reserve(config.num_iters);
+      const double cpu_start_ms = threadCpuTimeMs();
+      int64_t iter;
+      while ((iter = num_attempted_iters.fetch_add(1)) < config.num_iters) {
+        TimePoint issue_time;
+        if (open_loop) {
+          issue_time = start_time + arrivals[iter];
+          std::this_thread::sleep_until(issue_time);
+        } else {
+          issue_time = Clock::now();
+        }
         runOnce(std::move(thread_inputs[thread_id][input_iters[thread_id]]));
+        latencies_ms.push_back(
+            std::chrono::duration<float, std::milli>(Clock::now() - issue_time)
+                .count());
         ++input_iters[thread_id];
       }
+      thread_cpu_time_ms[thread_id] = threadCpuTimeMs() - cpu_start_ms;
 
       {
         std::unique_lock<std::mutex> lock(m);
@@ -87,10 +128,6 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
     });
   }
 
-  using Clock = std::chrono::high_resolution_clock;
-  using TimePoint = std::chrono::time_point<Clock>;
-  TimePoint start_time;
-
   {
     std::unique_lock<std::mutex> lock(m);
     while (initialized != config.num_calling_threads) {
@@ -121,10 +158,35 @@ BenchmarkExecutionStats BenchmarkHelper<Input, Output, Model>::benchmark(
   stats.latency_avg_ms =
       total_time_ms * config.num_calling_threads / config.num_iters;
   stats.num_iters = config.num_iters;
+  stats.total_time_ms = total_time_ms;
 
   for (auto& t : callers) {
     t.join();
   }
+
+  std::vector<float> latencies_ms;
+  latencies_ms.reserve(config.num_iters);
+  for (const auto& thread_latencies : thread_latencies_ms) {
+    latencies_ms.insert(
+        latencies_ms.end(), thread_latencies.begin(), thread_latencies.end());
+  }
+  std::sort(latencies_ms.begin(), latencies_ms.end());
+  if (open_loop && !latencies_ms.empty()) {
+    // The calling threads are idle between arrivals, so the average latency
+    // can't be derived from the total time
+    double latency_sum_ms = 0;
+    for (float latency_ms : latencies_ms) {
+      latency_sum_ms += latency_ms;
+    }
+    stats.latency_avg_ms = latency_sum_ms / latencies_ms.size();
+  }
+  stats.latency_p50_ms = latencyPercentile(latencies_ms, 0.5);
+  stats.latency_p90_ms = latencyPercentile(latencies_ms, 0.9);
+  stats.latency_p99_ms = latencyPercentile(latencies_ms, 0.99);
+  stats.latency_p999_ms = latencyPercentile(latencies_ms, 0.999);
+  if (threadCpuTimeMs() >= 0) {
+    stats.thread_cpu_time_ms = std::move(thread_cpu_time_ms);
+  }
   return stats;
 }
 
@@ -3,6 +3,14 @@
 #include <torch/csrc/jit/pybind_utils.h>
 #include <torch/csrc/utils/auto_gil.h>
 
+#include <cmath>
+#include <exception>
+#include <thread>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
 namespace torch {
 namespace throughput_benchmark {
 
@@ -56,8 +64,57 @@ BenchmarkExecutionStats ThroughputBenchmark::benchmark(
   }
 }
 
+std::vector<BenchmarkExecutionStats> ThroughputBenchmark::benchmarkConcurrently(
+    const std::vector<ThroughputBenchmark*>& benchmarks,
+    const std::vector<BenchmarkConfig>& configs) {
+  TORCH_CHECK(
+      benchmarks.size() == configs.size(),
+      "Expected a config for each of the ", benchmarks.size(),
+      " benchmarks, but got ", configs.size());
+  std::vector<BenchmarkExecutionStats> stats(benchmarks.size());
+  std::vector<std::exception_ptr> errors(benchmarks.size());
+  std::vector<std::thread> runners;
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    runners.emplace_back([&, i]() {
+      try {
+        stats[i] = benchmarks[i]->benchmark(configs[i]);
+      } catch (...) {
+        errors[i] = std::current_exception();
+      }
+    });
+  }
+  for (auto& t : runners) {
+    t.join();
+  }
+  for (const auto& error : errors) {
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+  return stats;
+}
+
 namespace detail {
 
+float latencyPercentile(const std::vector<float>& sorted_latencies_ms, double q) {
+  if (sorted_latencies_ms.empty()) {
+    return -1;
+  }
+  // nearest-rank percentile
+  auto rank = static_cast<size_t>(std::ceil(q * sorted_latencies_ms.size()));
+  return sorted_latencies_ms[std::max<size_t>(rank, 1) - 1];
+}
+
+double threadCpuTimeMs() {
+#ifndef _WIN32
+  struct timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0) {
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+  }
+#endif
+  return -1;
+}
+
 template <>
 void ScriptModuleBenchmark::runOnce(ScriptModuleInput&& input) const {
   CHECK(initialized_);
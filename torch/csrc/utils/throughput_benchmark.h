@@ -21,6 +21,18 @@ namespace throughput_benchmark {
 struct BenchmarkExecutionStats {
   float latency_avg_ms{-1};
   int64_t num_iters{-1};
+  // Latency percentiles over all the measured iterations. In the open-loop
+  // mode the latency of an iteration is counted from its scheduled arrival,
+  // so it includes the time the request waited for a free calling thread
+  float latency_p50_ms{-1};
+  float latency_p90_ms{-1};
+  float latency_p99_ms{-1};
+  float latency_p999_ms{-1};
+  // Wall time of the measured part of the benchmark
+  float total_time_ms{-1};
+  // CPU time each of the calling threads spent in the measured part of the
+  // benchmark. Empty on platforms without per-thread CPU clocks
+  std::vector<float> thread_cpu_time_ms;
 };
 
 /**
@@ -49,10 +61,22 @@ struct BenchmarkConfig {
   // Number of iterations the benchmark should run with. This number is separate
   // from the warmup iterations
   int64_t num_iters{100};
+  // If positive, the benchmark runs open-loop: requests arrive as a Poisson
+  // process with this rate (queries per second across all the calling
+  // threads) and are picked up by the first free calling thread, instead of
+  // every thread issuing its next request as soon as the previous one is done
+  double target_qps{0};
 };
 
 namespace detail {
 
+// The latency below which the given fraction of the sorted latencies lie
+float latencyPercentile(const std::vector<float>& sorted_latencies_ms, double q);
+
+// CPU time consumed by the calling thread so far, or a negative value if the
+// platform doesn't provide a per-thread CPU clock
+double threadCpuTimeMs();
+
 /**
  * A helper class to abstract out different models we test throughput of
  */
@@ -137,9 +161,10 @@ void ModuleBenchmark::addInput(py::args&& args, py::kwargs&& kwargs);
 /**
  * This class is a small c++ component responsible for executing a PyTorch
  * module under an inference server like load. It can emulate multiple calling
- * threads to a single module provided. In the future we plan to enhance this
- * component to support inter and intra-op parallelism as well as multiple
- * models running in a single process.
+ * threads to a single module provided, either in a closed loop or with
+ * open-loop Poisson arrivals, and several modules can be benchmarked
+ * concurrently in a single process. In the future we plan to enhance this
+ * component to support inter and intra-op parallelism as well.
  *
  * For current available configurations refer to the BenchmkarConfig
  * documentation
@@ -168,6 +193,12 @@ class C10_HIDDEN ThroughputBenchmark {
   // more information to the user
   BenchmarkExecutionStats benchmark(const BenchmarkConfig& config) const;
 
+  // Runs the benchmarks of several modules at the same time in this process,
+  // each with its own config, to emulate models sharing one inference server
+  static std::vector<BenchmarkExecutionStats> benchmarkConcurrently(
+      const std::vector<ThroughputBenchmark*>& benchmarks,
+      const std::vector<BenchmarkConfig>& configs);
+
  private:
   detail::ScriptModuleBenchmark script_module_;
   detail::ModuleBenchmark module_;
@@ -412,12 +412,43 @@ def ipc_collect():
         Checks if any sent CUDA tensors could be cleaned from the memory. Force
         closes shared memory file used for reference counting if there is no
         active counters. Useful when the producer process stopped actively sending
-        tensors and want to release unused memory.
+        tensors and want to release unused memory. In a process receiving CUDA
+        tensors in the pooled mode (see
+        :func:`torch.multiprocessing.set_cuda_ipc_pooling`) also waits for the
+        pending releases of received tensors and unmaps the allocations of the
+        sending processes that were kept mapped.
     """
     _lazy_init()
     return torch._C._cuda_ipc_collect()
 
 
+@contextlib.contextmanager
+def deferred_launch(enabled=True):
+    r"""Context-manager that queues elementwise ops on small CUDA tensors and
+    launches them as a single kernel, which saves the launch overhead of code
+    doing many ops on few elements, such as metrics bookkeeping.
+
+    Within the context, add, sub, mul, div and fill of contiguous float,
+    double and int64 tensors of at most 4096 elements, one of their operands
+    possibly a Python or CPU scalar, are queued on the calling thread. The
+    queue runs in order when it is full, before any other kernel or copy is
+    launched, when a stream or the device is synchronized, and when the
+    context exits. Results are the same as without the context.
+
+    Arguments:
+        enabled (bool, optional): whether to defer launches in the context.
+            Default: ``True``.
+    """
+    _lazy_init()
+    prev = torch._C._cuda_deferred_launch_enabled()
+    torch._C._cuda_set_deferred_launch_enabled(enabled)
+    try:
+        yield
+    finally:
+        torch._C._cuda_flush_deferred_launches()
+        torch._C._cuda_set_deferred_launch_enabled(prev)
+
+
 def current_stream(device=None):
     r"""Returns the currently selected :class:`Stream` for a given device.
 
@@ -558,4 +589,5 @@ torch._storage_classes.add(BFloat16Storage)
 from . import sparse
 from . import profiler
 from . import nvtx
+from . import amp
 from .streams import Stream, Event
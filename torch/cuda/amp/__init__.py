@@ -0,0 +1,4 @@
+from .autocast_mode import autocast
+from .grad_scaler import GradScaler
+
+__all__ = ['autocast', 'GradScaler']
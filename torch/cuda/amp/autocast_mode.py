@@ -0,0 +1,58 @@
+import functools
+import torch
+
+
+class autocast(object):
+    r"""Context-manager that runs the CUDA ops of the region in mixed precision.
+
+    Within the region, matmuls and convolutions cast their fp32 CUDA inputs
+    to fp16 to run on tensor cores, while the ops that need the range or the
+    precision of fp32, like reductions, softmax, norms and losses, cast their
+    fp16 inputs to fp32. Ops taking several inputs that must share a dtype,
+    like :func:`torch.cat`, run in the widest dtype among them. The other ops
+    run in the dtype of their inputs. The fp16 copies of the weights are
+    cached until the outermost region exits.
+
+    The casts are recorded by autograd, so the backward pass needs no region:
+    its ops run in the dtypes the forward pass chose. Combine it with
+    :class:`GradScaler` to keep the small fp16 gradients from underflowing.
+
+    This context manager is thread local; it will not affect computation
+    in other threads.
+
+    Also functions as a decorator.
+
+    Arguments:
+        enabled (bool, optional): whether to enable autocast in the region.
+            Default: ``True``
+
+    Example::
+
+        >>> scaler = torch.cuda.amp.GradScaler()
+        >>> for input, target in data:
+        ...     optimizer.zero_grad()
+        ...     with torch.cuda.amp.autocast():
+        ...         loss = loss_fn(model(input), target)
+        ...     scaler.scale(loss).backward()
+        ...     scaler.step(optimizer)
+        ...     scaler.update()
+    """
+    def __init__(self, enabled=True):
+        self.enabled = enabled
+
+    def __enter__(self):
+        self.prev = torch._C.is_autocast_enabled()
+        torch._C.set_autocast_enabled(self.enabled)
+
+    def __exit__(self, *args):
+        if self.enabled and not self.prev:
+            torch._C.clear_autocast_cache()
+        torch._C.set_autocast_enabled(self.prev)
+        return False
+
+    def __call__(self, func):
+        @functools.wraps(func)
+        def decorate_autocast(*args, **kwargs):
+            with self:
+                return func(*args, **kwargs)
+        return decorate_autocast
@@ -0,0 +1,142 @@
+import torch
+from collections import defaultdict
+
+
+class GradScaler(object):
+    r"""Scales the loss so that the fp16 gradients of a mixed precision
+    backward pass don't underflow, and adjusts the scale dynamically.
+
+    :meth:`scale` multiplies the loss by the scale before ``backward()``.
+    :meth:`step` divides the gradients of the parameters of an optimizer by
+    the scale and runs the optimizer, unless a gradient overflowed, in which
+    case the step is skipped. :meth:`update` then multiplies the scale by
+    ``backoff_factor`` if a step was skipped, or by ``growth_factor`` after
+    ``growth_interval`` steps in a row that weren't.
+
+    To clip or inspect the gradients before the step, call :meth:`unscale_`
+    first.
+
+    Checking the gradients for infs and NaNs only synchronizes with the host
+    once per optimizer step.
+
+    Arguments:
+        init_scale (float, optional): the initial scale. Default: ``2.**16``
+        growth_factor (float, optional): the factor the scale grows by.
+            Default: ``2.0``
+        backoff_factor (float, optional): the factor the scale shrinks by
+            when a gradient overflows. Default: ``0.5``
+        growth_interval (int, optional): the number of steps in a row without
+            overflow after which the scale grows. Default: ``2000``
+        enabled (bool, optional): if ``False``, all the methods do what they
+            would without scaling. Default: ``True``
+    """
+    def __init__(self, init_scale=2.**16, growth_factor=2.0, backoff_factor=0.5,
+                 growth_interval=2000, enabled=True):
+        if growth_factor <= 1.0:
+            raise ValueError("growth_factor must be greater than 1, got {}".format(growth_factor))
+        if not 0.0 < backoff_factor < 1.0:
+            raise ValueError("backoff_factor must be in (0, 1), got {}".format(backoff_factor))
+        self._enabled = enabled
+        self._scale = float(init_scale)
+        self._growth_factor = growth_factor
+        self._backoff_factor = backoff_factor
+        self._growth_interval = growth_interval
+        self._growth_tracker = 0
+        # whether the gradients of an optimizer were unscaled since the last
+        # update, and whether any of them overflowed
+        self._per_optimizer_states = defaultdict(lambda: {"unscaled": False, "found_inf": False})
+
+    def is_enabled(self):
+        return self._enabled
+
+    def get_scale(self):
+        return self._scale if self._enabled else 1.0
+
+    def scale(self, outputs):
+        r"""Multiplies a tensor, or an iterable of tensors, by the scale."""
+        if not self._enabled:
+            return outputs
+        if isinstance(outputs, torch.Tensor):
+            return outputs * self._scale
+        return type(outputs)(self.scale(output) for output in outputs)
+
+    def unscale_(self, optimizer):
+        r"""Divides the gradients of the parameters of ``optimizer`` by the
+        scale in place. Only call it once per optimizer between updates.
+        """
+        if not self._enabled:
+            return
+        state = self._per_optimizer_states[id(optimizer)]
+        if state["unscaled"]:
+            raise RuntimeError("unscale_() was already called on this optimizer since the last update().")
+
+        inv_scale = 1.0 / self._scale
+        # one flag per device, so that checking them syncs once per device
+        finite_per_device = {}
+        for group in optimizer.param_groups:
+            for param in group["params"]:
+                if param.grad is None:
+                    continue
+                grad = param.grad
+                if grad.is_sparse:
+                    grad = grad.coalesce()._values()
+                finite = torch.isfinite(grad).all()
+                if grad.device in finite_per_device:
+                    finite_per_device[grad.device] &= finite
+                else:
+                    finite_per_device[grad.device] = finite
+                param.grad.mul_(inv_scale)
+
+        state["found_inf"] = not all(bool(finite) for finite in finite_per_device.values())
+        state["unscaled"] = True
+
+    def step(self, optimizer, *args, **kwargs):
+        r"""Unscales the gradients of ``optimizer`` if :meth:`unscale_` wasn't
+        called, then runs ``optimizer.step(*args, **kwargs)`` unless one of
+        them is inf or NaN. Returns what ``optimizer.step`` returns, or
+        ``None`` if the step was skipped.
+        """
+        if not self._enabled:
+            return optimizer.step(*args, **kwargs)
+        state = self._per_optimizer_states[id(optimizer)]
+        if not state["unscaled"]:
+            self.unscale_(optimizer)
+        if state["found_inf"]:
+            return None
+        return optimizer.step(*args, **kwargs)
+
+    def update(self, new_scale=None):
+        r"""Adjusts the scale for the next iteration, or sets it to
+        ``new_scale`` if given.
+        """
+        if not self._enabled:
+            return
+        if new_scale is not None:
+            self._scale = float(new_scale)
+        else:
+            found_inf = any(state["found_inf"] for state in self._per_optimizer_states.values())
+            if found_inf:
+                self._scale *= self._backoff_factor
+                self._growth_tracker = 0
+            else:
+                self._growth_tracker += 1
+                if self._growth_tracker == self._growth_interval:
+                    self._scale *= self._growth_factor
+                    self._growth_tracker = 0
+        self._per_optimizer_states.clear()
+
+    def state_dict(self):
+        return {"scale": self._scale,
+                "growth_factor": self._growth_factor,
+                "backoff_factor": self._backoff_factor,
+                "growth_interval": self._growth_interval,
+                "growth_tracker": self._growth_tracker} if self._enabled else {}
+
+    def load_state_dict(self, state_dict):
+        if not self._enabled:
+            return
+        self._scale = state_dict["scale"]
+        self._growth_factor = state_dict["growth_factor"]
+        self._backoff_factor = state_dict["backoff_factor"]
+        self._growth_interval = state_dict["growth_interval"]
+        self._growth_tracker = state_dict["growth_tracker"]
@@ -115,9 +115,30 @@ def reduce_add_coalesced(inputs, destination=None, buffer_size=10485760):
                 coll.append(t.to_dense() if t.is_sparse else t)
             ref_order.append(dense_tensors[0][-1])
     itrs = [_take_tensors(tensors, buffer_size) for tensors in dense_tensors]
+    # The chunks are flattened on side streams, so that flattening the next
+    # chunk overlaps with reducing the current one. The side streams wait for
+    # the current streams, which produced the inputs, and the current streams
+    # wait for the flattening of each chunk before reducing it. See
+    # NOTE [ Pipelined broadcast_coalesced ].
+    flatten_streams = []
+    for tensors in dense_tensors:
+        if tensors:
+            device = tensors[0].get_device()
+            stream = torch.cuda.Stream(device=device)
+            stream.wait_stream(torch.cuda.current_stream(device))
+            flatten_streams.append(stream)
     # now the dense ones, which have consistent sizes
     for chunks in zip(*itrs):
-        flat_tensors = [_flatten_dense_tensors(chunk) for chunk in chunks]
+        flat_tensors = []
+        for chunk, stream in zip(chunks, flatten_streams):
+            with torch.cuda.stream(stream):
+                for t in chunk:
+                    t.record_stream(stream)
+                flat = _flatten_dense_tensors(chunk)
+            current_stream = torch.cuda.current_stream(stream.device)
+            flat.record_stream(current_stream)
+            current_stream.wait_stream(stream)
+            flat_tensors.append(flat)
         flat_result = reduce_add(flat_tensors, destination)
         for t in _unflatten_dense_tensors(flat_result, chunks[0]):
             # The unflattened tensors do not share storage, and we don't expose
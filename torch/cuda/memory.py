@@ -84,6 +84,9 @@ def memory_stats(device=None):
     - ``"num_alloc_retries"``: number of failed ``cudaMalloc`` calls that
       result in a cache flush and retry.
     - ``"num_ooms"``: number of out-of-memory errors thrown.
+    - ``"largest_free_block_bytes"``: size of the largest cached free block.
+      Comparing it with ``reserved_bytes - active_bytes`` (all cached free
+      memory) shows how fragmented the cache is.
 
     Arguments:
         device (torch.device or int, optional): selected device. Returns
@@ -94,6 +97,10 @@ def memory_stats(device=None):
         See :ref:`cuda-memory-management` for more details about GPU memory
         management.
     """
+    return _flatten_stats(memory_stats_as_nested_dict(device=device))
+
+
+def _flatten_stats(stats):
     result = []
 
     def _recurse_add_to_result(prefix, obj):
@@ -105,7 +112,6 @@ def memory_stats(device=None):
         else:
             result.append((prefix, obj))
 
-    stats = memory_stats_as_nested_dict(device=device)
     _recurse_add_to_result("", stats)
     result.sort()
 
@@ -118,6 +124,24 @@ def memory_stats_as_nested_dict(device=None):
     return torch._C._cuda_memoryStats(device)
 
 
+def host_memory_stats():
+    r"""Returns a dictionary of statistics of the caching allocator of pinned
+    host memory, used by :meth:`~torch.Tensor.pin_memory` and for the
+    asynchronous copies between host and device.
+
+    The statistics have the same layout as the ones of
+    :func:`~torch.cuda.memory_stats`, without the ``inactive_split`` ones and
+    ``largest_free_block_bytes``. Pinned blocks of up to 1MB are counted in
+    ``small_pool``, larger ones in ``large_pool``, and ``segment`` counts the
+    ``cudaHostAlloc()`` calls.
+
+    Setting the ``PYTORCH_CUDA_HOST_POOL_MB`` environment variable reserves a
+    pinned pool of that many megabytes on the first allocation, which the
+    allocator carves blocks from before calling ``cudaHostAlloc()``.
+    """
+    return _flatten_stats(torch._C._cuda_hostMemoryStats())
+
+
 def reset_accumulated_memory_stats(device=None):
     r"""Resets the "accumulated" (historical) stats tracked by the CUDA memory allocator.
 
@@ -316,6 +340,64 @@ def memory_snapshot():
     return torch._C._cuda_memorySnapshot()
 
 
+def record_memory_history(enabled=True, trace_max_entries=10000):
+    r"""Starts or stops recording the history of the CUDA memory allocator.
+
+    While recording, every allocation captures the backtrace of its caller,
+    which :func:`~torch.cuda.memory_snapshot` reports as the ``"history"`` of
+    each allocated block, and the last :attr:`trace_max_entries` allocator
+    events are kept for :func:`~torch.cuda.memory_trace`.
+
+    Capturing backtraces is slow, so this is meant for debugging memory usage
+    rather than for production runs.
+
+    Arguments:
+        enabled (bool, optional): whether to record. Enabling discards any
+            previously recorded events. Default: ``True``.
+        trace_max_entries (int, optional): number of events kept in the trace
+            ring buffer. Default: ``10000``.
+    """
+    torch._C._cuda_recordMemoryHistory(enabled, trace_max_entries)
+
+
+def set_stream_group(stream, group):
+    r"""Makes :attr:`stream` share the cached memory of the other streams of
+    :attr:`group`.
+
+    By default, a freed block is only reused by allocations on the stream it
+    was allocated on. A block freed on a stream of a group can be reused right
+    away by any stream of the group. The allocating stream waits on an event
+    recorded when the block was freed, so the reuse is ordered on the GPU
+    without synchronizing the host. This lets pipelines that allocate on
+    several streams share one cache, instead of keeping one underused cache
+    per stream.
+
+    Setting ``PYTORCH_CUDA_STREAM_ORDERED_REUSE=1`` in the environment extends
+    this to tensors used on other streams through
+    :meth:`~torch.Tensor.record_stream`: they are cached as soon as they are
+    freed, rather than once the host sees those streams finish.
+
+    Arguments:
+        stream (torch.cuda.Stream): the stream to add to the group.
+        group (int): id of the group. A negative id removes the stream from
+            its group.
+    """
+    torch._C._cuda_setStreamGroup(stream._cdata, group)
+
+
+def memory_trace():
+    r"""Returns the allocator events recorded since
+    :func:`~torch.cuda.record_memory_history` was enabled, oldest first.
+
+    Each event is a dictionary with the keys ``"action"`` (one of
+    ``"alloc"``, ``"free"``, ``"segment_alloc"``, ``"segment_free"``,
+    ``"segment_map"`` and ``"segment_unmap"``), ``"device"``, ``"address"``,
+    ``"size"`` and ``"stream"``. ``"alloc"`` and ``"free"`` events also carry the
+    ``"history"`` backtrace of the allocation.
+    """
+    return torch._C._cuda_memoryTrace()
+
+
 def memory_summary(device=None, abbreviated=False):
     r"""Returns a human-readable printout of the current memory allocator
     statistics for a given device.
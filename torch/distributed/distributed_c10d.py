@@ -1,3 +1,4 @@
+import time
 import torch
 import warnings
 from torch._six import string_classes
@@ -10,6 +11,7 @@ from .rendezvous import rendezvous, register_rendezvous_handler  # noqa: F401
 from . import (
     AllreduceOptions,
     AllreduceCoalescedOptions,
+    AllToAllOptions,
     BroadcastOptions,
     GatherOptions,
     ReduceOptions,
@@ -138,6 +140,10 @@ _default_pg_timeout = timedelta(minutes=30)
 # Process group count for default naming
 _group_count = 0
 
+# Number of times the default group was re-formed, used to give every
+# re-formation its own keys in the store
+_reform_count = 0
+
 
 def _rank_not_in_group(group):
     """
@@ -542,6 +548,83 @@ def destroy_process_group(group=group.WORLD):
         del _pg_group_ranks[pg]
 
 
+def reform_process_group(settle_time=timedelta(seconds=10),
+                         timeout=_default_pg_timeout):
+    """
+    Re-forms the default process group with the processes that call this
+    function, e.g. after some of them failed, without restarting the others.
+
+    The processes agree on the new group through the store of the default
+    group: every process that calls this function within ``settle_time`` of
+    the first one becomes a member. The members keep the order of their
+    ranks, so the member with the lowest rank becomes rank 0. A process
+    calling this function later raises an error, and must be restarted.
+
+    All the existing groups, including those created by
+    :func:`~torch.distributed.new_group`, are destroyed, and the communicators
+    of the new default group are created from scratch (for NCCL, on the first
+    collective). Objects holding a group, like
+    :class:`~torch.nn.parallel.DistributedDataParallel`, must be updated (see
+    :meth:`~torch.nn.parallel.DistributedDataParallel.reform`).
+
+    Collectives still running on the existing groups must have failed first,
+    e.g. timed out, since destroying a group waits for them.
+
+    Only supported for the ``gloo`` and ``nccl`` backends. Processes can't
+    join a group, the new group only holds members of the previous one.
+
+    Arguments:
+        settle_time (timedelta, optional): How long to wait for the members
+            of the new group after the first one called this function.
+        timeout (timedelta, optional): Timeout for operations executed
+            against the new process group.
+
+    Returns:
+        The rank of this process in the new group.
+    """
+    global _reform_count
+    global _pg_group_ranks
+    global _backend
+    global _default_pg
+
+    _check_default_pg()
+    backend = _pg_map[_default_pg][0]
+    if backend not in (Backend.GLOO, Backend.NCCL):
+        raise RuntimeError("Re-forming a process group is only supported for "
+                           "the gloo and nccl backends")
+    store = _get_default_store()
+    old_rank = _default_pg.rank()
+    # The members of the old group re-formed it as many times.
+    _reform_count += 1
+    reform_store = PrefixStore("reform/{}".format(_reform_count), store)
+
+    # The first process to join closes the membership once settle_time is
+    # over, the others (and those that are late) read it.
+    index = reform_store.add("joined", 1)
+    reform_store.set("member/{}".format(index), str(old_rank))
+    if index == 1:
+        time.sleep(settle_time.total_seconds())
+        reform_store.set("world_size", str(reform_store.add("joined", 0)))
+    world_size = int(reform_store.get("world_size"))
+    if index > world_size:
+        raise RuntimeError("Joined the re-formed process group too late")
+    members = sorted(int(reform_store.get("member/{}".format(i)))
+                     for i in range(1, world_size + 1))
+    rank = members.index(old_rank)
+
+    destroy_process_group()
+    _default_pg = _new_process_group_helper(
+        world_size,
+        rank,
+        [],
+        backend,
+        reform_store,
+        timeout=timeout)
+    _pg_group_ranks[_default_pg] = {i: i for i in range(world_size)}
+    _backend = backend
+    return rank
+
+
 def get_rank(group=group.WORLD):
     """
     Returns the rank of current process group
@@ -1398,6 +1481,101 @@ def reduce_scatter(output,
         work.wait()
 
 
+def all_to_all_single(output,
+                      input,
+                      output_split_sizes=None,
+                      input_split_sizes=None,
+                      group=group.WORLD,
+                      async_op=False):
+    """
+    Each process splits input tensor and then scatters the split list
+    to all processes in a group. Then concatenate the received tensors from all
+    the processes in the group and return single output tensor.
+
+    Arguments:
+        output (Tensor): Gathered concatenated output tensor.
+        input (Tensor): Input tensor to scatter.
+        output_split_sizes: (list[Int], optional): Output split sizes for dim 0
+            if specified None or empty, dim 0 of ``output`` tensor must divide
+            equally by ``world_size``.
+        input_split_sizes: (list[Int], optional): Input split sizes for dim 0
+            if specified None or empty, dim 0 of ``input`` tensor must divide
+            equally by ``world_size``.
+        group (ProcessGroup, optional): The process group to work on.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group.
+
+    .. note:: Only the gloo backend and, with NCCL 2.7 or newer, the nccl
+        backend support this function.
+    """
+    _check_single_tensor(output, "output")
+    _check_single_tensor(input, "input")
+    if _rank_not_in_group(group):
+        return
+
+    opts = AllToAllOptions()
+    output_split_sizes = [] if output_split_sizes is None else output_split_sizes
+    input_split_sizes = [] if input_split_sizes is None else input_split_sizes
+
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _default_pg.alltoall_base(
+            output, input, output_split_sizes, input_split_sizes, opts)
+    else:
+        work = group.alltoall_base(
+            output, input, output_split_sizes, input_split_sizes, opts)
+
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
+def all_to_all(output_tensor_list,
+               input_tensor_list,
+               group=group.WORLD,
+               async_op=False):
+    """
+    Each process scatters list of input tensors to all processes in a group and
+    return gathered list of tensors in output list.
+
+    Arguments:
+        output_tensor_list (list[Tensor]): List of tensors to be gathered one
+            per rank.
+        input_tensor_list (list[Tensor]): List of tensors to scatter one per
+            rank.
+        group (ProcessGroup, optional): The process group to work on.
+        async_op (bool, optional): Whether this op should be an async op.
+
+    Returns:
+        Async work handle, if async_op is set to True.
+        None, if not async_op or if not part of the group.
+
+    .. note:: Only the gloo backend, on CPU tensors, and, with NCCL 2.7 or
+        newer, the nccl backend support this function.
+    """
+    _check_tensor_list(output_tensor_list, "output_tensor_list")
+    _check_tensor_list(input_tensor_list, "input_tensor_list")
+    if _rank_not_in_group(group):
+        return
+
+    opts = AllToAllOptions()
+
+    if group == GroupMember.WORLD:
+        _check_default_pg()
+        work = _default_pg.alltoall(output_tensor_list, input_tensor_list, opts)
+    else:
+        work = group.alltoall(output_tensor_list, input_tensor_list, opts)
+
+    if async_op:
+        return work
+    else:
+        work.wait()
+
+
 def barrier(group=group.WORLD,
             async_op=False):
     """
@@ -0,0 +1,3 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+from .zero_redundancy_optimizer import ZeroRedundancyOptimizer  # noqa: F401
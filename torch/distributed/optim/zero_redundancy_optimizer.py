@@ -0,0 +1,297 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+import torch
+from torch.nn.parallel import DistributedDataParallel
+from torch.optim import Optimizer
+
+
+class ZeroRedundancyOptimizer(Optimizer):
+    r"""
+    Wraps an optimizer and shards its state across the processes of a
+    :class:`~torch.nn.parallel.DistributedDataParallel` module, as proposed
+    by ZeRO (https://arxiv.org/abs/1910.02054).
+
+    The gradient buckets of the module are the shard units. Every bucket is
+    split into ``world_size`` contiguous shards, and the process with rank
+    ``r`` owns shard ``r`` of every bucket. The module reduce-scatters its
+    buckets instead of allreducing them, so every process only receives the
+    reduced gradient of the elements it owns. :meth:`step` updates those
+    elements with the wrapped optimizer, which therefore only keeps state
+    (e.g. the moments of Adam) for ``1 / world_size`` of the parameters, and
+    then allgathers the updated parameters asynchronously. Every submodule
+    waits for the allgather of its own parameters right before its forward
+    runs, so the allgathers overlap with the next forward pass.
+
+    After the backward pass, the gradients of the module are only reduced on
+    the elements a process owns. Modules that span multiple devices and
+    parameters with sparse gradients aren't supported, and the module must
+    not have another communication hook.
+
+    Arguments:
+        module (DistributedDataParallel): module whose parameters to optimize.
+        optimizer_class (type): class of the wrapped optimizer, e.g.
+            :class:`torch.optim.Adam`.
+        **defaults: arguments of the wrapped optimizer, except ``params``.
+
+    Example::
+        >>> model = DistributedDataParallel(model, device_ids=[rank])
+        >>> optimizer = ZeroRedundancyOptimizer(model, torch.optim.Adam, lr=1e-3)
+        >>> loss_fn(model(input), target).backward()
+        >>> optimizer.step()
+    """
+
+    def __init__(self, module, optimizer_class, **defaults):
+        if not isinstance(module, DistributedDataParallel):
+            raise TypeError("ZeroRedundancyOptimizer expects a "
+                            "DistributedDataParallel module")
+        if len(module._module_copies) > 1:
+            raise ValueError("ZeroRedundancyOptimizer doesn't support "
+                             "multi-device modules")
+
+        self.module = module
+        self.process_group = module.process_group
+        self.rank = self.process_group.rank()
+        self.world_size = self.process_group.size()
+        self.parameters = module._bucketed_parameters
+        self.optimizer_class = optimizer_class
+        self.defaults = defaults
+        self.optim = None
+        # The allgathers started by the last step, by bucket.
+        self._pending = {}
+
+        module.register_comm_hook('reduce_scatter')
+        self._shard(module.reducer.get_bucket_indices())
+
+        indices = {id(parameter): i for i, parameter in enumerate(self.parameters)}
+        for submodule in module.module.modules():
+            owned = [indices[id(parameter)]
+                     for parameter in submodule.parameters(recurse=False)
+                     if id(parameter) in indices]
+            if owned:
+                submodule.register_forward_pre_hook(self._make_forward_pre_hook(owned))
+
+    def _make_forward_pre_hook(self, parameter_indices):
+        def hook(module, inputs):
+            if self._pending:
+                self._wait(set(self._bucket_of[i] for i in parameter_indices))
+        return hook
+
+    def _bucket_shard(self, bucket):
+        # Returns the size of the shards of the bucket, and the pieces of the
+        # shard this process owns as (parameter index, offset in parameter,
+        # offset in shard, length) tuples.
+        numel = sum(self.parameters[i].numel() for i in bucket)
+        shard_numel = (numel + self.world_size - 1) // self.world_size
+        begin = min(self.rank * shard_numel, numel)
+        end = min(begin + shard_numel, numel)
+        pieces = []
+        offset = 0
+        for i in bucket:
+            length = self.parameters[i].numel()
+            lo, hi = max(begin, offset), min(end, offset + length)
+            if lo < hi:
+                pieces.append((i, lo - offset, lo - begin, hi - lo))
+            offset += length
+        return shard_numel, pieces
+
+    def _shard(self, layout):
+        # Creates the wrapped optimizer for the shards of `layout`, keeping
+        # the hyperparameters of the previous one.
+        self.layout = layout
+        self.shards = [self._bucket_shard(bucket) for bucket in layout]
+        self._bucket_of = {}
+        shard_parameters = []
+        for index, (bucket, (shard_numel, _)) in enumerate(zip(layout, self.shards)):
+            for i in bucket:
+                self._bucket_of[i] = index
+            first = self.parameters[bucket[0]]
+            shard_parameters.append(torch.zeros(
+                [shard_numel], dtype=first.dtype, device=first.device))
+        self.shard_parameters = shard_parameters
+
+        previous = self.optim
+        self.optim = self.optimizer_class(shard_parameters, **self.defaults)
+        if previous is not None:
+            for old_group, new_group in zip(previous.param_groups, self.optim.param_groups):
+                for key, value in old_group.items():
+                    if key != 'params':
+                        new_group[key] = value
+        self.param_groups = self.optim.param_groups
+        self.state = self.optim.state
+
+    def _wait(self, bucket_indices):
+        # Copies the allgathered parameters of the buckets into the module.
+        for index in bucket_indices:
+            if index not in self._pending:
+                continue
+            work, gathered = self._pending.pop(index)
+            work.wait()
+            flat = torch.cat(gathered)
+            offset = 0
+            with torch.no_grad():
+                for i in self.layout[index]:
+                    parameter = self.parameters[i]
+                    length = parameter.numel()
+                    parameter.copy_(flat[offset:offset + length].view_as(parameter))
+                    offset += length
+
+    def synchronize(self):
+        r"""
+        Waits for the parameters updated by the last :meth:`step` to be
+        copied into the module. The forward pass of the module does this on
+        its own, so this is only needed to read the parameters otherwise.
+        """
+        self._wait(list(self._pending.keys()))
+
+    def _gather_state(self):
+        # Returns the state of every parameter, in the format of
+        # `Optimizer.state_dict`, by allgathering the state of the shards.
+        state = {}
+        for bucket, shard_parameter in zip(self.layout, self.shard_parameters):
+            shard_state = self.optim.state.get(shard_parameter, {})
+            for key in sorted(shard_state.keys()):
+                value = shard_state[key]
+                if torch.is_tensor(value) and value.shape == shard_parameter.shape:
+                    gathered = [torch.empty_like(value) for _ in range(self.world_size)]
+                    self.process_group.allgather([gathered], [value]).wait()
+                    flat = torch.cat(gathered)
+                else:
+                    flat = None
+                offset = 0
+                for i in bucket:
+                    length = self.parameters[i].numel()
+                    if flat is None:
+                        state.setdefault(i, {})[key] = value
+                    else:
+                        state.setdefault(i, {})[key] = flat[offset:offset + length].view_as(
+                            self.parameters[i]).clone()
+                    offset += length
+        return state
+
+    def _scatter_state(self, state):
+        # Sets the state of the shards from the state of every parameter.
+        self.optim.state.clear()
+        for bucket, shard_parameter, (_, pieces) in zip(
+                self.layout, self.shard_parameters, self.shards):
+            keys = set()
+            for i in bucket:
+                keys.update(state.get(i, {}).keys())
+            if not keys:
+                continue
+            shard_state = {}
+            for key in sorted(keys):
+                # Tensors shaped like their parameter are sharded, anything
+                # else (e.g. step counts) is the same for the whole bucket.
+                owner = next(i for i in bucket if key in state.get(i, {}))
+                value = state[owner][key]
+                if not torch.is_tensor(value) or value.shape != self.parameters[owner].shape:
+                    shard_state[key] = value
+                    continue
+                shard = torch.zeros_like(shard_parameter)
+                for i, parameter_offset, shard_offset, length in pieces:
+                    if key in state.get(i, {}):
+                        shard[shard_offset:shard_offset + length].copy_(
+                            state[i][key].view(-1)[parameter_offset:parameter_offset + length])
+                shard_state[key] = shard
+            self.optim.state[shard_parameter] = shard_state
+
+    def _reshard(self, layout):
+        state = self._gather_state()
+        self._shard(layout)
+        self._scatter_state(state)
+
+    def step(self, closure=None):
+        r"""
+        Performs a single optimization step on the elements this process
+        owns, and starts allgathering the updated parameters.
+
+        Arguments:
+            closure (callable, optional): A closure that reevaluates the model
+                and returns the loss.
+        """
+        loss = None
+        if closure is not None:
+            loss = closure()
+        self.synchronize()
+
+        # The module rebuilds its buckets after the first backward pass, and
+        # while autotuning the bucket size. The state follows the buckets.
+        layout = self.module.reducer.get_bucket_indices()
+        if layout != self.layout:
+            self._reshard(layout)
+
+        with torch.no_grad():
+            for shard_parameter, (_, pieces) in zip(self.shard_parameters, self.shards):
+                grad = None
+                for i, parameter_offset, shard_offset, length in pieces:
+                    parameter = self.parameters[i]
+                    shard_parameter[shard_offset:shard_offset + length].copy_(
+                        parameter.view(-1)[parameter_offset:parameter_offset + length])
+                    if parameter.grad is None:
+                        continue
+                    if parameter.grad.is_sparse:
+                        raise RuntimeError("ZeroRedundancyOptimizer doesn't support "
+                                           "sparse gradients")
+                    if grad is None:
+                        grad = torch.zeros_like(shard_parameter)
+                    grad[shard_offset:shard_offset + length].copy_(
+                        parameter.grad.view(-1)[parameter_offset:parameter_offset + length])
+                shard_parameter.grad = grad
+
+        self.optim.step()
+
+        for index, shard_parameter in enumerate(self.shard_parameters):
+            gathered = [torch.empty_like(shard_parameter) for _ in range(self.world_size)]
+            work = self.process_group.allgather([gathered], [shard_parameter.detach()])
+            self._pending[index] = (work, gathered)
+        return loss
+
+    def zero_grad(self):
+        r"""Clears the gradients of the parameters of the module."""
+        for parameter in self.parameters:
+            if parameter.grad is not None:
+                parameter.grad.detach_()
+                parameter.grad.zero_()
+
+    def add_param_group(self, param_group):
+        raise RuntimeError("ZeroRedundancyOptimizer optimizes the parameters "
+                           "of its module and doesn't take parameter groups")
+
+    def state_dict(self):
+        r"""
+        Returns the state of the optimizer for all parameters, in the format
+        of :meth:`torch.optim.Optimizer.state_dict`, with the parameters
+        indexed in the order of the module's parameters that require a
+        gradient. This is a collective call that all processes must make.
+        """
+        param_groups = []
+        for group in self.optim.param_groups:
+            packed = {key: value for key, value in group.items() if key != 'params'}
+            packed['params'] = list(range(len(self.parameters)))
+            param_groups.append(packed)
+        return {
+            'state': self._gather_state(),
+            'param_groups': param_groups,
+        }
+
+    def load_state_dict(self, state_dict):
+        r"""
+        Loads a state returned by :meth:`state_dict`, possibly from a run
+        with a different number of processes.
+
+        Arguments:
+            state_dict (dict): optimizer state returned by :meth:`state_dict`.
+        """
+        for group, saved in zip(self.optim.param_groups, state_dict['param_groups']):
+            for key, value in saved.items():
+                if key != 'params':
+                    group[key] = value
+        state = {}
+        for i, parameter_state in state_dict['state'].items():
+            parameter = self.parameters[i]
+            state[i] = {
+                key: value.to(parameter) if torch.is_tensor(value) and
+                value.shape == parameter.shape else value
+                for key, value in parameter_state.items()
+            }
+        self._scatter_state(state)
@@ -7,9 +7,11 @@ from .backend_registry import *  # noqa: F401
 
 if sys.version_info >= (3, 0):
     from . import api
+    from . import functions  # noqa: F401
     from .api import _init_rpc
     from .api import *  # noqa: F401
     import torch.distributed.autograd
+    from . import pipeline  # noqa: F401
 
     def init_model_parallel(
         self_name,
@@ -0,0 +1,38 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+from .internal import _BatchedFunction
+
+
+def batch(max_batch_size=64, window_ms=1.0):
+    r"""
+    A decorator for functions called over RPC that coalesces the calls a
+    worker receives for it within a short window into one invocation, e.g. to
+    run a model once on a batch of inputs sent by many callers.
+
+    The decorated function is called with one list per positional argument,
+    holding that argument of every coalesced call in the order the calls
+    arrived, and must return one result per call, in the same order. Each
+    caller gets back its own result. A batch runs when it holds
+    ``max_batch_size`` calls, or ``window_ms`` milliseconds after its first
+    call arrived, whichever comes first. Calls waiting for their batch don't
+    occupy an RPC thread. Keyword arguments are not supported, and the
+    function must be defined at the top level of a module, so that the
+    callee finds it by name.
+
+    Arguments:
+        max_batch_size (int): the largest number of calls run together.
+        window_ms (float): how long to wait for more calls after the first
+                           one of a batch arrived.
+
+    Example::
+
+        >>> @torch.distributed.rpc.functions.batch(max_batch_size=32)
+        >>> def infer(inputs):
+        >>>     return model(torch.stack(inputs)).unbind()
+        >>>
+        >>> # on every caller
+        >>> output = rpc.rpc_sync("server", infer, args=(input,))
+    """
+    def decorator(func):
+        return _BatchedFunction(func, max_batch_size, window_ms / 1000.0)
+    return decorator
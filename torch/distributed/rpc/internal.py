@@ -1,5 +1,6 @@
 import collections
 import copyreg
+import functools
 import io
 import pickle
 import threading
@@ -111,15 +112,127 @@ def _run_function(binary_data, tensor_table):
     Wraps any exception in ``RemoteException`` if the function raises.
     """
     python_udf = _internal_rpc_pickler.deserialize(binary_data, tensor_table)
+    if isinstance(python_udf.func, _BatchedFunction):
+        return python_udf.func._enqueue(python_udf.args, python_udf.kwargs)
     try:
         result = python_udf.func(*python_udf.args, **python_udf.kwargs)
     except Exception as e:
-        # except str = exception info + traceback string
-        except_str = "{}\n{}".format(repr(e), traceback.format_exc())
-        result = RemoteException(except_str)
+        result = _remote_exception(e)
     return result
 
 
+def _remote_exception(e):
+    # except str = exception info + traceback string
+    except_str = "{}\n{}".format(repr(e), traceback.format_exc())
+    return RemoteException(except_str)
+
+
+class _PendingResult(object):
+    r"""
+    The result of a call to a batched function that has not run yet, returned
+    by ``_run_function`` instead of the result itself. The C++ request handler
+    sends the response from the callback, once the batch ran.
+    """
+    def __init__(self):
+        self._lock = threading.Lock()
+        self._done = False
+        self._value = None
+        self._callbacks = []
+
+    def set_result(self, value):
+        with self._lock:
+            self._done = True
+            self._value = value
+            callbacks, self._callbacks = self._callbacks, []
+        for callback in callbacks:
+            callback(value)
+
+    def add_done_callback(self, callback):
+        with self._lock:
+            if not self._done:
+                self._callbacks.append(callback)
+                return
+        callback(self._value)
+
+
+class _BatchedFunction(object):
+    r"""
+    See ``torch.distributed.rpc.functions.batch``. Requests are coalesced in the
+    instance of the callee, which unpickling finds by name like any function.
+    """
+    def __init__(self, func, max_batch_size, window_s):
+        functools.update_wrapper(self, func)
+        self._func = func
+        self._max_batch_size = max_batch_size
+        self._window_s = window_s
+        self._lock = threading.Lock()
+        self._pending = []
+        self._timer = None
+
+    def __call__(self, *args):
+        # Called locally, this is a batch of one.
+        return self._func(*[[arg] for arg in args])[0]
+
+    def __reduce__(self):
+        return getattr(self, "__qualname__", self.__name__)
+
+    def _enqueue(self, args, kwargs):
+        result = _PendingResult()
+        if kwargs:
+            result.set_result(_remote_exception(TypeError(
+                "batched function {} does not take keyword arguments".format(
+                    self.__name__))))
+            return result
+        batch = None
+        with self._lock:
+            self._pending.append((args, result))
+            if len(self._pending) >= self._max_batch_size:
+                batch = self._take_batch()
+            elif self._timer is None:
+                timer = threading.Timer(
+                    self._window_s, lambda: self._flush(timer))
+                timer.daemon = True
+                self._timer = timer
+                timer.start()
+        if batch is not None:
+            self._run(batch)
+        return result
+
+    def _take_batch(self):
+        # Must be called with self._lock held.
+        batch, self._pending = self._pending, []
+        if self._timer is not None:
+            self._timer.cancel()
+            self._timer = None
+        return batch
+
+    def _flush(self, timer):
+        with self._lock:
+            # The batch this timer was started for may have filled up already.
+            if self._timer is not timer:
+                return
+            batch = self._take_batch()
+        self._run(batch)
+
+    def _run(self, batch):
+        try:
+            num_args = set(len(args) for args, _ in batch)
+            if len(num_args) != 1:
+                raise TypeError(
+                    "all calls to batched function {} in a batch must pass "
+                    "the same number of arguments".format(self.__name__))
+            batched_args = [list(arg) for arg in zip(*[args for args, _ in batch])]
+            results = list(self._func(*batched_args))
+            if len(results) != len(batch):
+                raise ValueError(
+                    "batched function {} returned {} results for a batch of "
+                    "{} calls".format(self.__name__, len(results), len(batch)))
+        except Exception as e:
+            results = [_remote_exception(e)] * len(batch)
+        for (_, pending), result in zip(batch, results):
+            pending.set_result(result)
+
+
 def _load_return_value(binary_data, tensor_table):
     r"""
     This function is exclusively called from C++.
@@ -0,0 +1,145 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+
+import concurrent.futures
+import threading
+
+import torch
+import torch.distributed.autograd as dist_autograd
+
+from . import api
+
+
+# Serializes the gradient accumulation of micro-batches finishing their
+# backward pass at the same time on the owner of a stage.
+_stage_grad_lock = threading.Lock()
+
+
+def _stage_forward(stage, input, grad_enabled):
+    with torch.set_grad_enabled(grad_enabled):
+        return stage.local_value()(input)
+
+
+def _accumulate_stage_gradients(stage, context_id):
+    r"""
+    Adds the gradients the backward pass of one micro-batch accumulated for
+    the parameters of ``stage`` in ``context_id`` to their ``grad``, before
+    the context and the gradients in it are released.
+    """
+    grads = dist_autograd.get_gradients(context_id)
+    with _stage_grad_lock:
+        for param in stage.local_value().parameters():
+            grad = grads.get(param)
+            if grad is None:
+                continue
+            if param.grad is None:
+                param.grad = grad.clone()
+            else:
+                param.grad.add_(grad)
+
+
+class PipelineExecutor(object):
+    r"""
+    Runs a model split into a chain of stages held by other workers, GPipe
+    style: every batch is split into micro-batches, which stream through the
+    stages one after the other, so that all stages work on different
+    micro-batches at the same time instead of waiting for the whole batch.
+
+    Each micro-batch runs its forward pass, the loss and its backward pass in
+    its own distributed autograd context, so the backward pass of an earlier
+    micro-batch runs interleaved with the forward passes of later ones. At most
+    ``max_in_flight`` micro-batches are between the start of their forward and
+    the end of their backward pass at a time, which bounds the activations
+    every stage keeps alive for the backward pass.
+
+    When a micro-batch finished its backward pass, the owner of every stage
+    adds the gradients of the stage's parameters to their ``grad``, so after
+    :meth:`run` these hold the sum of the gradients of all micro-batches, the
+    same as one backward pass over a loss summed over the whole batch. Like
+    with local training, zeroing them between steps is up to the caller.
+
+    Arguments:
+        stages (list): RRefs of the ``nn.Module`` s making up the model, in the
+                       order they run. Each stage is called with the output of
+                       the previous one, the first with a micro-batch of the
+                       input.
+        chunks (int): the number of micro-batches each batch is split into.
+        max_in_flight (int, optional): the largest number of micro-batches
+                                       running at once. (default: the number
+                                       of stages).
+
+    Example::
+        >>> import torch.distributed.rpc as rpc
+        >>> stages = [rpc.remote("worker1", make_first_half),
+        >>>           rpc.remote("worker2", make_second_half)]
+        >>> pipeline = rpc.pipeline.PipelineExecutor(stages, chunks=8)
+        >>> losses = pipeline.run(inputs, targets, loss_fn)
+        >>> # the gradients are in the stages' parameters now
+    """
+    def __init__(self, stages, chunks, max_in_flight=None):
+        if not stages:
+            raise ValueError("a pipeline needs at least one stage")
+        if chunks < 1:
+            raise ValueError("chunks must be at least 1, but got {}".format(chunks))
+        self.stages = list(stages)
+        self.chunks = chunks
+        self.max_in_flight = (
+            max_in_flight if max_in_flight is not None else len(self.stages))
+        if self.max_in_flight < 1:
+            raise ValueError(
+                "max_in_flight must be at least 1, but got {}".format(
+                    self.max_in_flight))
+
+    def _forward_micro_batch(self, input, grad_enabled=True):
+        # The output of every stage comes back to the caller, which sends it
+        # on to the next stage, instead of the stages calling each other and
+        # holding on to an RPC thread while the rest of the pipeline runs.
+        for stage in self.stages:
+            input = api.rpc_sync(
+                stage.owner(), _stage_forward, args=(stage, input, grad_enabled))
+        return input
+
+    def _train_micro_batch(self, input, target, loss_fn):
+        with dist_autograd.context() as context_id:
+            loss = loss_fn(self._forward_micro_batch(input), target)
+            dist_autograd.backward([loss])
+            for stage in self.stages:
+                api.rpc_sync(
+                    stage.owner(),
+                    _accumulate_stage_gradients,
+                    args=(stage, context_id))
+        return loss.detach()
+
+    def _map_micro_batches(self, function, *batches):
+        micro_batches = zip(*[batch.chunk(self.chunks) for batch in batches])
+        with concurrent.futures.ThreadPoolExecutor(self.max_in_flight) as pool:
+            futures = [pool.submit(function, *args) for args in micro_batches]
+            return [future.result() for future in futures]
+
+    def run(self, inputs, targets, loss_fn):
+        r"""
+        Runs the forward and backward pass of one batch through the pipeline.
+
+        Arguments:
+            inputs (Tensor): the input batch, split along its first dimension.
+            targets (Tensor): the targets of the batch, split the same way.
+            loss_fn (callable): called with the output of the last stage and
+                                the targets of each micro-batch, returning its
+                                scalar loss.
+
+        Returns:
+            A list with the (detached) loss of every micro-batch.
+        """
+        return self._map_micro_batches(
+            lambda input, target: self._train_micro_batch(input, target, loss_fn),
+            inputs,
+            targets)
+
+    def forward(self, inputs):
+        r"""
+        Runs a batch through the pipeline without recording any gradients and
+        returns the outputs of the last stage, concatenated along the first
+        dimension.
+        """
+        return torch.cat(self._map_micro_batches(
+            lambda input: self._forward_micro_batch(input, grad_enabled=False),
+            inputs))
@@ -166,6 +166,17 @@ def save(m, f, _extra_files=DEFAULT_EXTRA_FILES_MAP):
         ret = m.save_to_buffer(_extra_files=_extra_files)
         f.write(ret)
 
+def export_opnames(m):
+    r"""
+        Returns the names of the operators the methods of the :class:`ScriptModule`
+        ``m`` and of its submodules call, e.g. ``aten::add.Tensor``.
+
+        The lists of one or more models can be written to a yaml file and passed
+        to a mobile build as ``SELECTED_OP_LIST``, so that it only registers
+        these operators, see ``scripts/gen_selected_op_list.py``.
+    """
+    return torch._C._export_opnames(m._c)
+
 def load(f, map_location=None, _extra_files=DEFAULT_EXTRA_FILES_MAP):
     r"""
         Load a :class:`ScriptModule` or :class:`ScriptFunction` previously
@@ -0,0 +1,281 @@
+#include <c10d/CollectiveTrace.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+namespace c10d {
+
+namespace {
+
+// The number of ranks compareCollectiveTraces() reports as entering
+// collectives late.
+constexpr size_t kMaxReportedStragglers = 8;
+
+std::string sizesToString(const std::vector<int64_t>& sizes) {
+  if (sizes.empty()) {
+    return "-";
+  }
+  std::string str;
+  for (size_t i = 0; i < sizes.size(); i++) {
+    if (i > 0) {
+      str += "x";
+    }
+    str += std::to_string(sizes[i]);
+  }
+  return str;
+}
+
+std::vector<int64_t> sizesFromString(const std::string& str) {
+  std::vector<int64_t> sizes;
+  if (str == "-") {
+    return sizes;
+  }
+  std::istringstream ss(str);
+  std::string size;
+  while (std::getline(ss, size, 'x')) {
+    sizes.push_back(std::stoll(size));
+  }
+  return sizes;
+}
+
+std::string ranksToString(const std::vector<int>& ranks) {
+  std::string str;
+  for (size_t i = 0; i < ranks.size(); i++) {
+    if (i > 0) {
+      str += ", ";
+    }
+    str += std::to_string(ranks[i]);
+  }
+  return str;
+}
+
+// Formats a time since the epoch as seconds.
+std::string timeToString(int64_t micros) {
+  std::ostringstream ss;
+  ss << micros / 1000000 << "." << std::setw(6) << std::setfill('0')
+     << micros % 1000000;
+  return ss.str();
+}
+
+bool hasGPUTimes(const CollectiveTraceEntry& entry) {
+  return entry.startMicros >= 0 && entry.endMicros >= 0;
+}
+
+struct Lateness {
+  int rank = 0;
+  int64_t totalMicros = 0;
+  int64_t maxMicros = 0;
+  uint64_t maxSeq = 0;
+  size_t count = 0;
+};
+
+} // namespace
+
+std::string serializeCollectiveTrace(
+    const std::vector<CollectiveTraceEntry>& trace) {
+  std::ostringstream ss;
+  for (const auto& entry : trace) {
+    ss << entry.seq << " " << entry.opType << " " << entry.dtype << " "
+       << sizesToString(entry.inputSizes) << " "
+       << sizesToString(entry.outputSizes) << " " << entry.enqueueMicros << " "
+       << entry.startMicros << " " << entry.endMicros << "\n";
+  }
+  return ss.str();
+}
+
+std::vector<CollectiveTraceEntry> parseCollectiveTrace(const std::string& str) {
+  std::vector<CollectiveTraceEntry> trace;
+  std::istringstream lines(str);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::istringstream ss(line);
+    CollectiveTraceEntry entry;
+    std::string inputSizes;
+    std::string outputSizes;
+    ss >> entry.seq >> entry.opType >> entry.dtype >> inputSizes >>
+        outputSizes >> entry.enqueueMicros >> entry.startMicros >>
+        entry.endMicros;
+    if (ss.fail()) {
+      throw std::runtime_error("Malformed collective trace entry: " + line);
+    }
+    try {
+      entry.inputSizes = sizesFromString(inputSizes);
+      entry.outputSizes = sizesFromString(outputSizes);
+    } catch (const std::exception&) {
+      throw std::runtime_error("Malformed collective trace entry: " + line);
+    }
+    trace.push_back(std::move(entry));
+  }
+  return trace;
+}
+
+std::string formatCollectiveTrace(
+    const std::vector<CollectiveTraceEntry>& trace) {
+  std::ostringstream ss;
+  for (const auto& entry : trace) {
+    ss << "#" << entry.seq << " " << entry.opType << " " << entry.dtype
+       << " in " << sizesToString(entry.inputSizes) << " out "
+       << sizesToString(entry.outputSizes) << ", enqueued at "
+       << timeToString(entry.enqueueMicros);
+    if (entry.startMicros < 0) {
+      ss << ", not started";
+    } else {
+      ss << ", started " << entry.startMicros - entry.enqueueMicros
+         << " us later";
+      if (entry.endMicros < 0) {
+        ss << ", still running";
+      } else {
+        ss << ", ran " << entry.endMicros - entry.startMicros << " us";
+      }
+    }
+    ss << "\n";
+  }
+  return ss.str();
+}
+
+std::string compareCollectiveTraces(
+    const std::vector<std::vector<CollectiveTraceEntry>>& traces) {
+  const int size = traces.size();
+  std::ostringstream ss;
+
+  // The entries of every collective, by rank.
+  std::map<uint64_t, std::vector<const CollectiveTraceEntry*>> collectives;
+  std::vector<int> missing;
+  for (int rank = 0; rank < size; rank++) {
+    if (traces[rank].empty()) {
+      missing.push_back(rank);
+      continue;
+    }
+    for (const auto& entry : traces[rank]) {
+      auto& entries = collectives[entry.seq];
+      entries.resize(size, nullptr);
+      entries[rank] = &entry;
+    }
+  }
+  if (!missing.empty()) {
+    ss << "Ranks without a trace: " << ranksToString(missing) << "\n";
+  }
+  if (collectives.empty()) {
+    return ss.str();
+  }
+
+  // Ranks behind the others.
+  const auto lastSeq = collectives.rbegin()->first;
+  std::map<uint64_t, std::vector<int>> behind;
+  for (int rank = 0; rank < size; rank++) {
+    if (!traces[rank].empty() && traces[rank].back().seq < lastSeq) {
+      behind[traces[rank].back().seq].push_back(rank);
+    }
+  }
+  for (const auto& it : behind) {
+    ss << "Ranks " << ranksToString(it.second)
+       << " last enqueued collective #" << it.first
+       << ", the others enqueued up to #" << lastSeq << "\n";
+  }
+
+  std::vector<Lateness> lateness(size);
+  for (int rank = 0; rank < size; rank++) {
+    lateness[rank].rank = rank;
+  }
+  for (const auto& it : collectives) {
+    const auto& entries = it.second;
+    const CollectiveTraceEntry* first = nullptr;
+    int firstRank = -1;
+    bool complete = true;
+    bool gpuTimes = true;
+    std::vector<int> mismatched;
+    for (int rank = 0; rank < size; rank++) {
+      if (traces[rank].empty()) {
+        continue;
+      }
+      const auto* entry = entries[rank];
+      if (entry == nullptr) {
+        complete = false;
+        continue;
+      }
+      if (first == nullptr) {
+        first = entry;
+        firstRank = rank;
+      } else if (entry->opType != first->opType) {
+        mismatched.push_back(rank);
+      }
+      gpuTimes = gpuTimes && hasGPUTimes(*entry);
+    }
+    if (!mismatched.empty()) {
+      ss << "Collective #" << it.first << " is " << first->opType
+         << " on rank " << firstRank << ", but";
+      for (int rank : mismatched) {
+        ss << (rank == mismatched.front() ? " " : ", ")
+           << entries[rank]->opType << " on rank " << rank;
+      }
+      ss << "\n";
+    }
+
+    // Only collectives every rank with a trace has are compared, as the
+    // traces of the ranks may cover different collectives.
+    if (!complete || !mismatched.empty()) {
+      continue;
+    }
+    int64_t reference = gpuTimes ? std::numeric_limits<int64_t>::min()
+                                 : std::numeric_limits<int64_t>::max();
+    for (int rank = 0; rank < size; rank++) {
+      const auto* entry = entries[rank];
+      if (entry == nullptr) {
+        continue;
+      }
+      reference = gpuTimes
+          ? std::max(reference, entry->endMicros - entry->startMicros)
+          : std::min(reference, entry->enqueueMicros);
+    }
+    for (int rank = 0; rank < size; rank++) {
+      const auto* entry = entries[rank];
+      if (entry == nullptr) {
+        continue;
+      }
+      const auto late = gpuTimes
+          ? reference - (entry->endMicros - entry->startMicros)
+          : entry->enqueueMicros - reference;
+      auto& l = lateness[rank];
+      l.totalMicros += late;
+      l.count++;
+      if (late > l.maxMicros || l.count == 1) {
+        l.maxMicros = late;
+        l.maxSeq = it.first;
+      }
+    }
+  }
+
+  std::vector<Lateness> stragglers;
+  for (const auto& l : lateness) {
+    if (l.count > 0 && l.maxMicros > 0) {
+      stragglers.push_back(l);
+    }
+  }
+  std::sort(
+      stragglers.begin(),
+      stragglers.end(),
+      [](const Lateness& a, const Lateness& b) {
+        return a.totalMicros * static_cast<int64_t>(b.count) >
+            b.totalMicros * static_cast<int64_t>(a.count);
+      });
+  if (stragglers.size() > kMaxReportedStragglers) {
+    stragglers.resize(kMaxReportedStragglers);
+  }
+  for (const auto& l : stragglers) {
+    ss << "Rank " << l.rank << " entered " << l.count
+       << " collectives on average "
+       << l.totalMicros / static_cast<int64_t>(l.count)
+       << " us after the first rank, and collective #" << l.maxSeq << " "
+       << l.maxMicros << " us after it\n";
+  }
+  return ss.str();
+}
+
+} // namespace c10d
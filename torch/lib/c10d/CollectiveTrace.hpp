@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace c10d {
+
+// A collective recorded by the flight recorder of a process group.
+//
+// Times are in microseconds since the epoch of the system clock, or -1 if
+// unknown, e.g. if the collective hasn't started or finished on the GPU yet.
+struct CollectiveTraceEntry {
+  // The index of the collective among all collectives of the process group,
+  // which is the same on all ranks.
+  uint64_t seq = 0;
+  std::string opType;
+  std::string dtype;
+  // The sizes of the first input and output tensor.
+  std::vector<int64_t> inputSizes;
+  std::vector<int64_t> outputSizes;
+  // When the collective was enqueued, and started and finished on the GPU.
+  int64_t enqueueMicros = -1;
+  int64_t startMicros = -1;
+  int64_t endMicros = -1;
+};
+
+// Serializes a trace into a line of text per entry, e.g. to exchange traces
+// through a store.
+std::string serializeCollectiveTrace(
+    const std::vector<CollectiveTraceEntry>& trace);
+
+// Parses the output of serializeCollectiveTrace().
+std::vector<CollectiveTraceEntry> parseCollectiveTrace(const std::string& str);
+
+// Formats a trace for humans, oldest entry first.
+std::string formatCollectiveTrace(
+    const std::vector<CollectiveTraceEntry>& trace);
+
+// Compares the traces of all ranks of a process group, indexed by rank, and
+// reports:
+//
+//   - ranks without a trace, and ranks that haven't enqueued the last
+//     collectives the other ranks enqueued, which are the likely cause of a
+//     hang.
+//   - collectives of which the kind differs between ranks.
+//   - the ranks that enter collectives last, over the collectives all
+//     traces have.
+//
+// A collective finishes at about the same time on all ranks, so the rank
+// that enters a collective last is the one it runs the shortest on, and it
+// entered the collective the difference of the longest and its own duration
+// after the first rank did. This doesn't depend on the clocks of the hosts
+// agreeing. For collectives without GPU times, the enqueue times are
+// compared instead, which does.
+std::string compareCollectiveTraces(
+    const std::vector<std::vector<CollectiveTraceEntry>>& traces);
+
+} // namespace c10d
@@ -12,6 +12,14 @@
 #define ENABLE_NCCL_ERROR_CHECKING
 #endif
 
+// ncclSend() and ncclRecv() are only supported in NCCL versions 2.7+.
+#if defined(NCCL_MAJOR) && (NCCL_MAJOR == 2) && defined(NCCL_MINOR) && \
+    (NCCL_MINOR >= 7)
+#define ENABLE_NCCL_P2P_SUPPORT
+#elif defined(NCCL_MAJOR) && (NCCL_MAJOR >= 3)
+#define ENABLE_NCCL_P2P_SUPPORT
+#endif
+
 #define C10D_NCCL_CHECK(cmd)                                                \
   do {                                                                      \
     ncclResult_t error = cmd;                                               \
@@ -56,4 +56,20 @@ ProcessGroup::ProcessGroup(int rank, int size) : rank_(rank), size_(size) {
 
 ProcessGroup::~ProcessGroup() {}
 
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::alltoall_base(
+    at::Tensor& /* unused */,
+    at::Tensor& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroup does not support alltoall");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroup::alltoall(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<at::Tensor>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroup does not support alltoall");
+}
+
 } // namespace c10d
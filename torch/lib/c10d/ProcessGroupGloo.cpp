@@ -10,6 +10,8 @@
 #include <gloo/allgather.h>
 #include <gloo/allgatherv.h>
 #include <gloo/allreduce.h>
+#include <gloo/alltoall.h>
+#include <gloo/alltoallv.h>
 #include <gloo/barrier.h>
 #include <gloo/broadcast.h>
 #include <gloo/gather.h>
@@ -237,6 +239,16 @@ void setOutput(O& opts, at::Tensor& tensor, std::vector<size_t>& counts) {
   opts.setOutput(getDataPointer<T>(tensor), counts);
 }
 
+template <typename T, typename O>
+void setInput(O& opts, at::Tensor& tensor, std::vector<int64_t>& counts) {
+  opts.setInput(getDataPointer<T>(tensor), counts);
+}
+
+template <typename T, typename O>
+void setOutput(O& opts, at::Tensor& tensor, std::vector<int64_t>& counts) {
+  opts.setOutput(getDataPointer<T>(tensor), counts);
+}
+
 #ifdef USE_CUDA
 
 at::Tensor pinnedLike(at::Tensor& tensor) {
@@ -390,7 +402,9 @@ void ProcessGroupGloo::RecvWork::wait() {
 }
 
 ProcessGroupGloo::Options::Options()
-    : timeout(std::chrono::milliseconds(10 * 1000)), threads(2) {}
+    : timeout(std::chrono::milliseconds(10 * 1000)),
+      threads(2),
+      cudaPipelineChunkBytes(4 * 1024 * 1024) {}
 
 namespace {
 
@@ -541,7 +555,8 @@ ProcessGroupGloo::ProcessGroupGloo(
     : ProcessGroup(rank, size),
       store_(new GlooStore(store)),
       stop_(false),
-      collectiveCounter_(0) {
+      collectiveCounter_(0),
+      cudaPipelineChunkBytes_(options.cudaPipelineChunkBytes) {
   auto& devices = options.devices;
   if (devices.empty()) {
     throw std::runtime_error("No device(s) specified");
@@ -1199,6 +1214,109 @@ class AsyncAllreduceCUDAWork : public AsyncAllreduceWork {
   std::vector<at::cuda::CUDAEvent> events;
 };
 
+// Like AsyncAllreduceCUDAWork, but the tensors are copied to the host, reduced
+// and copied back in chunks of chunkSize elements. The copies to the host are
+// all kicked off by the constructor, on one stream, and the copies back on
+// another, so that the copies of the other chunks overlap with the allreduce
+// of a chunk.
+class AsyncPipelinedAllreduceCUDAWork : public AsyncAllreduceWork {
+ public:
+  AsyncPipelinedAllreduceCUDAWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag,
+      int64_t chunkSize)
+      : AsyncAllreduceWork(context, inputs, reduceOp, tag),
+        numel(inputs[0].numel()),
+        chunkSize(chunkSize),
+        numChunks((numel + chunkSize - 1) / chunkSize) {
+    initializeStreamsEvents(inputs, streams, events);
+
+    // The copies back wait for the caller's stream like the copies to host.
+    at::cuda::OptionalCUDAGuard device_guard;
+    h2dStreams.reserve(inputs.size());
+    for (size_t i = 0; i < inputs.size(); i++) {
+      const auto index = inputs[i].device().index();
+      device_guard.set_index(index);
+      h2dStreams.push_back(
+          at::cuda::getStreamFromPool(/* isHighPriority */ true, index));
+      events[i].block(h2dStreams[i]);
+      c10::cuda::CUDACachingAllocator::recordStream(
+          inputs[i].storage().data(), h2dStreams[i]);
+    }
+
+    // Kick off copy from CUDA tensors to pinned CPU tensors, chunk by chunk.
+    tmp.reserve(inputs.size());
+    chunkEvents.resize(inputs.size());
+    at::cuda::OptionalCUDAStreamGuard guard;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      guard.reset_stream(streams[i]);
+      tmp.push_back(pinnedLike(inputs[i]).view({-1}));
+      const auto flat = inputs[i].view({-1});
+      chunkEvents[i].resize(numChunks);
+      for (int64_t c = 0; c < numChunks; c++) {
+        tmp[i].narrow(0, c * chunkSize, chunkLength(c))
+            .copy_(flat.narrow(0, c * chunkSize, chunkLength(c)), true);
+        chunkEvents[i][c].record(streams[i]);
+      }
+    }
+  }
+
+  int64_t chunkLength(int64_t c) const {
+    return std::min(chunkSize, numel - c * chunkSize);
+  }
+
+  void run() override {
+    at::cuda::OptionalCUDAStreamGuard stream_guard;
+    std::vector<at::Tensor> chunks(inputs.size());
+    for (int64_t c = 0; c < numChunks; c++) {
+      // Synchronize with the copy of this chunk only.
+      for (size_t i = 0; i < inputs.size(); i++) {
+        chunkEvents[i][c].synchronize();
+        chunks[i] = tmp[i].narrow(0, c * chunkSize, chunkLength(c));
+      }
+
+      // Run allreduce on the host side chunks.
+      allreduce(chunks);
+
+      // Kick off copy back to the CUDA tensors, which runs while the next
+      // chunk is reduced. Only the first output in the tensor list contains
+      // the results. See https://github.com/facebookincubator/gloo/issues/152.
+      for (size_t i = 0; i < inputs.size(); i++) {
+        stream_guard.reset_stream(h2dStreams[i]);
+        inputs[i]
+            .view({-1})
+            .narrow(0, c * chunkSize, chunkLength(c))
+            .copy_(chunks[0], /* non_blocking */ true);
+      }
+    }
+
+    for (size_t i = 0; i < inputs.size(); i++) {
+      events[i].record(h2dStreams[i]);
+    }
+  }
+
+  void synchronize() override {
+    // Synchronize with the copy back to CUDA tensors.
+    at::cuda::OptionalCUDAGuard guard;
+    for (size_t i = 0; i < inputs.size(); i++) {
+      guard.set_index(inputs[i].device().index());
+      events[i].block(at::cuda::getCurrentCUDAStream());
+    }
+  }
+
+  const int64_t numel;
+  const int64_t chunkSize;
+  const int64_t numChunks;
+
+  std::vector<at::Tensor> tmp;
+  std::vector<at::cuda::CUDAStream> streams;
+  std::vector<at::cuda::CUDAStream> h2dStreams;
+  std::vector<at::cuda::CUDAEvent> events;
+  std::vector<std::vector<at::cuda::CUDAEvent>> chunkEvents;
+};
+
 class AsyncSparseAllreduceCUDAWork : public AsyncSparseAllreduceWork {
  public:
   AsyncSparseAllreduceCUDAWork(
@@ -1302,7 +1420,21 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::allreduce(
     }
 #ifdef USE_CUDA
   } else if (device.type() == at::kCUDA) {
-    if (layout == c10::kStrided) {
+    const auto chunkSize = cudaPipelineChunkBytes_ /
+        static_cast<size_t>(inputs[0].element_size());
+    const auto pipelined = layout == c10::kStrided && chunkSize > 0 &&
+        static_cast<size_t>(inputs[0].numel()) > chunkSize &&
+        std::all_of(inputs.begin(), inputs.end(), [](const at::Tensor& t) {
+          return t.is_contiguous();
+        });
+    if (pipelined) {
+      work = std::make_shared<AsyncPipelinedAllreduceCUDAWork>(
+          std::move(context),
+          inputs,
+          opts.reduceOp,
+          tag,
+          static_cast<int64_t>(chunkSize));
+    } else if (layout == c10::kStrided) {
       work = std::make_shared<AsyncAllreduceCUDAWork>(
           std::move(context), inputs, opts.reduceOp, tag);
     } else if (layout == c10::kSparse) {
@@ -2133,11 +2265,393 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::scatter(
   return work;
 }
 
+namespace {
+
+class AsyncAlltoallWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncAlltoallWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputCounts,
+      std::vector<int64_t>& inputCounts,
+      uint32_t tag)
+      : context(context),
+        outputTensor(outputTensor),
+        inputTensor(inputTensor),
+        outputCounts(std::move(outputCounts)),
+        inputCounts(std::move(inputCounts)),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  at::Tensor outputTensor;
+  at::Tensor inputTensor;
+  // The number of elements sent to and received from every rank.
+  std::vector<int64_t> outputCounts;
+  std::vector<int64_t> inputCounts;
+  const uint32_t tag;
+
+  void alltoall(at::Tensor& outputTensor, at::Tensor& inputTensor) {
+    const auto scalarType = outputTensor.scalar_type();
+    const auto equalSplits =
+        std::all_of(
+            inputCounts.begin(),
+            inputCounts.end(),
+            [this](int64_t count) { return count == inputCounts[0]; }) &&
+        inputCounts == outputCounts;
+    if (equalSplits) {
+      // Use the simpler and faster alltoall when every rank gets as much.
+      gloo::AlltoallOptions opts(context);
+      opts.setTag(tag);
+      GENERATE_ALL_TYPES(scalarType, setInput, opts, inputTensor);
+      GENERATE_ALL_TYPES(scalarType, setOutput, opts, outputTensor);
+      gloo::alltoall(opts);
+    } else {
+      gloo::AlltoallvOptions opts(context);
+      opts.setTag(tag);
+      GENERATE_ALL_TYPES(scalarType, setInput, opts, inputTensor, inputCounts);
+      GENERATE_ALL_TYPES(
+          scalarType, setOutput, opts, outputTensor, outputCounts);
+      gloo::alltoallv(opts);
+    }
+  }
+
+  void run() override {
+    alltoall(outputTensor, inputTensor);
+  }
+};
+
+// Runs alltoall on the concatenation of a list of tensors per rank and copies
+// the result back to the output list.
+class AsyncAlltoallListWork : public AsyncAlltoallWork {
+ public:
+  AsyncAlltoallListWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& outputs,
+      at::Tensor& flatOutput,
+      at::Tensor& flatInput,
+      std::vector<int64_t>& outputCounts,
+      std::vector<int64_t>& inputCounts,
+      uint32_t tag)
+      : AsyncAlltoallWork(
+            context,
+            flatOutput,
+            flatInput,
+            outputCounts,
+            inputCounts,
+            tag),
+        outputs(outputs) {}
+
+  std::vector<at::Tensor> outputs;
+
+  void run() override {
+    alltoall(outputTensor, inputTensor);
+    int64_t offset = 0;
+    for (size_t i = 0; i < outputs.size(); i++) {
+      const auto numel = outputs[i].numel();
+      outputs[i].copy_(
+          outputTensor.narrow(0, offset, numel).view(outputs[i].sizes()));
+      offset += numel;
+    }
+  }
+};
+
+#ifdef USE_CUDA
+
+class AsyncAlltoallCUDAWork : public AsyncAlltoallWork {
+ public:
+  AsyncAlltoallCUDAWork(
+      const std::shared_ptr<gloo::Context>& context,
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputCounts,
+      std::vector<int64_t>& inputCounts,
+      uint32_t tag)
+      : AsyncAlltoallWork(
+            context,
+            outputTensor,
+            inputTensor,
+            outputCounts,
+            inputCounts,
+            tag) {
+    std::vector<at::Tensor> inputs = {inputTensor};
+    std::vector<at::Tensor> outputs = {outputTensor};
+    initializeStreamsEvents(inputs, inputStreams, inputEvents);
+    initializeStreamsEvents(outputs, outputStreams, outputEvents);
+
+    // Kick off copy from CUDA tensors to pinned CPU tensors.
+    at::cuda::OptionalCUDAStreamGuard guard;
+    guard.reset_stream(inputStreams.front());
+    cpuInput = pinnedLike(inputTensor).copy_(inputTensor, true);
+    cpuOutput = pinnedLike(outputTensor);
+  }
+
+  void run() override {
+    // Synchronize with copy operations.
+    at::cuda::OptionalCUDAGuard device_guard;
+    device_guard.set_index(inputTensor.get_device());
+    AT_CUDA_CHECK(cudaStreamSynchronize(inputStreams.front()));
+    device_guard.set_index(outputTensor.get_device());
+    AT_CUDA_CHECK(cudaStreamSynchronize(outputStreams.front()));
+
+    // Run alltoall on host side tensors.
+    alltoall(cpuOutput, cpuInput);
+
+    // Kick off copy back to the CUDA tensors.
+    at::cuda::OptionalCUDAStreamGuard stream_guard;
+    stream_guard.reset_stream(outputStreams.front());
+    outputTensor.copy_(cpuOutput, /* non_blocking */ true);
+    outputEvents.front().record(outputStreams.front());
+  }
+
+  void synchronize() override {
+    // Synchronize with the copy back to CUDA tensors.
+    at::cuda::OptionalCUDAGuard guard;
+    guard.set_index(static_cast<at::DeviceIndex>(outputTensor.get_device()));
+    outputEvents.front().block(at::cuda::getCurrentCUDAStream());
+  }
+
+  at::Tensor cpuOutput;
+  std::vector<at::cuda::CUDAStream> outputStreams;
+  std::vector<at::cuda::CUDAEvent> outputEvents;
+
+  at::Tensor cpuInput;
+  std::vector<at::cuda::CUDAStream> inputStreams;
+  std::vector<at::cuda::CUDAEvent> inputEvents;
+};
+
+#endif
+
+} // namespace
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::alltoall_base(
+    at::Tensor& outputTensor,
+    at::Tensor& inputTensor,
+    std::vector<int64_t>& outputSplitSizes,
+    std::vector<int64_t>& inputSplitSizes,
+    const AllToAllOptions& /* unused */) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::alltoall_base: " + msg);
+  };
+
+  assertDense(invalidArgument, {outputTensor});
+  assertDense(invalidArgument, {inputTensor});
+  assertTypeMatch(
+      invalidArgument, outputTensor.type(), {inputTensor}, /* index */ 0);
+  if (!outputTensor.is_contiguous() || !inputTensor.is_contiguous()) {
+    invalidArgument("requires contiguous tensors");
+  }
+  const auto& device = outputTensor.device();
+  if (inputTensor.device() != device) {
+    invalidArgument("requires input and output on the same device");
+  }
+  switch (device.type()) {
+    case at::kCPU:
+#ifdef USE_CUDA
+    case at::kCUDA:
+#endif
+      break;
+    default:
+      invalidArgument("unsupported device type");
+  }
+  try {
+    checkSplitSizes(inputSplitSizes, inputTensor, size_);
+    checkSplitSizes(outputSplitSizes, outputTensor, size_);
+  } catch (const std::runtime_error& e) {
+    invalidArgument(e.what());
+  }
+
+  std::vector<int64_t> outputCounts(size_);
+  std::vector<int64_t> outputOffsets(size_);
+  std::vector<int64_t> inputCounts(size_);
+  std::vector<int64_t> inputOffsets(size_);
+  computeLengthsAndOffsets(
+      outputSplitSizes, outputTensor, &outputCounts, &outputOffsets);
+  computeLengthsAndOffsets(
+      inputSplitSizes, inputTensor, &inputCounts, &inputOffsets);
+
+  std::shared_ptr<AsyncAlltoallWork> work;
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  if (device.type() == at::kCPU) {
+    work = std::make_shared<AsyncAlltoallWork>(
+        std::move(context),
+        outputTensor,
+        inputTensor,
+        outputCounts,
+        inputCounts,
+        tag);
+#ifdef USE_CUDA
+  } else if (device.type() == at::kCUDA) {
+    work = std::make_shared<AsyncAlltoallCUDAWork>(
+        std::move(context),
+        outputTensor,
+        inputTensor,
+        outputCounts,
+        inputCounts,
+        tag);
+#endif
+  } else {
+    throw std::runtime_error("Invalid backend");
+  }
+  enqueue(work);
+  return work;
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::alltoall(
+    std::vector<at::Tensor>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const AllToAllOptions& /* unused */) {
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::alltoall: " + msg);
+  };
+
+  if (outputTensors.size() != static_cast<size_t>(size_) ||
+      inputTensors.size() != static_cast<size_t>(size_)) {
+    std::stringstream ss;
+    ss << "requires input and output lists with " << size_ << " tensors";
+    invalidArgument(ss.str());
+  }
+  assertCPU(invalidArgument, outputTensors);
+  assertCPU(invalidArgument, inputTensors);
+  assertDense(invalidArgument, outputTensors);
+  assertDense(invalidArgument, inputTensors);
+  const auto& type = inputTensors[0].type();
+  for (int i = 0; i < size_; i++) {
+    assertTypeMatch(invalidArgument, type, inputTensors, i);
+    assertTypeMatch(invalidArgument, type, outputTensors, i);
+  }
+
+  // The tensors of every rank are sent back to back in a single alltoallv.
+  std::vector<int64_t> outputCounts(size_);
+  std::vector<int64_t> inputCounts(size_);
+  std::vector<at::Tensor> flatOutputs(size_);
+  std::vector<at::Tensor> flatInputs(size_);
+  for (int i = 0; i < size_; i++) {
+    outputCounts[i] = outputTensors[i].numel();
+    inputCounts[i] = inputTensors[i].numel();
+    flatOutputs[i] = outputTensors[i].reshape({-1});
+    flatInputs[i] = inputTensors[i].reshape({-1});
+  }
+  auto flatOutput = at::cat(flatOutputs);
+  auto flatInput = at::cat(flatInputs);
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncAlltoallListWork>(
+      std::move(context),
+      outputTensors,
+      flatOutput,
+      flatInput,
+      outputCounts,
+      inputCounts,
+      tag);
+  enqueue(work);
+  return work;
+}
+
+namespace {
+
+// Gloo has no reduce-scatter in its new style API, so the inputs are
+// exchanged with an alltoall and every process reduces the chunks it
+// received. This moves as many bytes as a ring reduce-scatter.
+class AsyncReduceScatterWork : public ProcessGroupGloo::AsyncWork {
+ public:
+  AsyncReduceScatterWork(
+      const std::shared_ptr<gloo::Context>& context,
+      std::vector<at::Tensor>& outputs,
+      std::vector<std::vector<at::Tensor>>& inputs,
+      ReduceOp reduceOp,
+      uint32_t tag)
+      : context(context),
+        outputs(outputs),
+        inputs(inputs),
+        reduceOp(reduceOp),
+        tag(tag) {}
+
+  std::shared_ptr<gloo::Context> context;
+  std::vector<at::Tensor> outputs;
+  std::vector<std::vector<at::Tensor>> inputs;
+  const ReduceOp reduceOp;
+  const uint32_t tag;
+
+  void run() override {
+    auto& output = outputs[0];
+    const auto scalarType = output.scalar_type();
+    auto flatInput = newLikeFlat(inputs, 0);
+    for (size_t i = 0; i < inputs[0].size(); i++) {
+      flatInput[i].copy_(inputs[0][i]);
+    }
+    auto flatOutput = at::empty_like(flatInput);
+
+    gloo::AlltoallOptions opts(context);
+    opts.setTag(tag);
+    GENERATE_ALL_TYPES(scalarType, setInput, opts, flatInput);
+    GENERATE_ALL_TYPES(scalarType, setOutput, opts, flatOutput);
+    gloo::alltoall(opts);
+
+    switch (reduceOp) {
+      case ReduceOp::SUM:
+        output.copy_(flatOutput.sum(0));
+        break;
+      case ReduceOp::PRODUCT:
+        output.copy_(flatOutput.prod(0));
+        break;
+      case ReduceOp::MIN:
+        output.copy_(std::get<0>(flatOutput.min(0)));
+        break;
+      case ReduceOp::MAX:
+        output.copy_(std::get<0>(flatOutput.max(0)));
+        break;
+      default:
+        throw std::runtime_error("Unhandled ReduceOp");
+    }
+  }
+};
+
+} // namespace
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupGloo::reduce_scatter(
     std::vector<at::Tensor>& outputs,
     std::vector<std::vector<at::Tensor>>& inputs,
     const ReduceScatterOptions& opts) {
-  throw std::runtime_error("ProcessGroupGloo does not support reduce_scatter");
+  static auto invalidArgument = [](const std::string& msg) {
+    throw std::invalid_argument("ProcessGroupGloo::reduce_scatter: " + msg);
+  };
+
+  assertSingleElementOutput(invalidArgument, outputs);
+  assertDense(invalidArgument, outputs);
+  assertCPU(invalidArgument, outputs);
+  if (inputs.size() != 1) {
+    std::stringstream ss;
+    ss << "requires a single-element input list containing a list with "
+       << getSize() << " tensors";
+    invalidArgument(ss.str());
+  } else if (inputs[0].size() != static_cast<size_t>(getSize())) {
+    std::stringstream ss;
+    ss << "Incorrect input list size " << inputs[0].size()
+       << ". Input list size should be " << getSize()
+       << ", same as size of the process group.";
+    invalidArgument(ss.str());
+  }
+  assertTypeAndSizesMatch(
+      invalidArgument, inputs[0], outputs[0].type(), outputs[0].sizes());
+  switch (opts.reduceOp) {
+    case ReduceOp::SUM:
+    case ReduceOp::PRODUCT:
+    case ReduceOp::MIN:
+    case ReduceOp::MAX:
+      break;
+    default:
+      invalidArgument("unsupported reduction operation");
+  }
+
+  auto tag = nextTag();
+  auto context = getContext(tag);
+  auto work = std::make_shared<AsyncReduceScatterWork>(
+      std::move(context), outputs, inputs, opts.reduceOp, tag);
+  enqueue(work);
+  return work;
 }
 
 at::Tensor& checkSingleTensor(std::vector<at::Tensor>& tensors) {
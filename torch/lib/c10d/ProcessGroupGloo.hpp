@@ -125,6 +125,11 @@ class ProcessGroupGloo : public ProcessGroup {
     std::vector<std::shared_ptr<::gloo::transport::Device>> devices;
     std::chrono::milliseconds timeout;
     int threads;
+
+    // Dense CUDA allreduces of more than this many bytes are split into
+    // chunks of this size, whose copies to and from the host and whose
+    // allreduces are pipelined. Zero disables pipelining.
+    size_t cudaPipelineChunkBytes;
   };
 
   // Helper functions to create a new device object.
@@ -190,6 +195,19 @@ class ProcessGroupGloo : public ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputs,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
 
+  std::shared_ptr<ProcessGroup::Work> alltoall_base(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
+  // Only supports CPU tensors.
+  std::shared_ptr<ProcessGroup::Work> alltoall(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
   std::shared_ptr<ProcessGroup::Work> send(
       std::vector<at::Tensor>& tensors,
       int dstRank,
@@ -223,6 +241,9 @@ class ProcessGroupGloo : public ProcessGroup {
   // to match up operations during concurrent execution.
   uint32_t collectiveCounter_;
 
+  // See Options::cudaPipelineChunkBytes.
+  const size_t cudaPipelineChunkBytes_;
+
   // Returns next collective tag to use (uses collectiveCounter_).
   uint32_t nextTag();
 
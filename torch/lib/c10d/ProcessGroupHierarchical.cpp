@@ -0,0 +1,374 @@
+#include <c10d/ProcessGroupHierarchical.hpp>
+
+#include <limits.h>
+#include <unistd.h>
+
+#include <array>
+#include <stdexcept>
+#include <system_error>
+#include <unordered_map>
+
+#include <c10/core/DeviceGuard.h>
+#include <c10d/PrefixStore.hpp>
+
+namespace c10d {
+
+namespace {
+
+std::string getHostname() {
+  std::array<char, HOST_NAME_MAX + 1> buffer{};
+  auto rv = gethostname(buffer.data(), buffer.size() - 1);
+  if (rv != 0) {
+    throw std::system_error(errno, std::system_category());
+  }
+  return buffer.data();
+}
+
+void checkSingleTensor(const std::vector<at::Tensor>& tensors) {
+  if (tensors.size() != 1) {
+    throw std::runtime_error(
+        "ProcessGroupHierarchical does not support multi-GPU collectives");
+  }
+  if (tensors[0].is_sparse()) {
+    throw std::runtime_error("input tensor has to be dense");
+  }
+}
+
+} // namespace
+
+ProcessGroupHierarchical::ProcessGroupHierarchical(
+    const std::shared_ptr<Store>& store,
+    int rank,
+    int size,
+    CreateProcessGroupFn createProcessGroup,
+    Options options)
+    : ProcessGroup(rank, size),
+      store_(store),
+      options_(std::move(options)),
+      stop_(false) {
+  if (options_.hostname.empty()) {
+    options_.hostname = getHostname();
+  }
+
+  // Tell everyone where we live and find out where everyone else lives.
+  const auto& hostname = options_.hostname;
+  store_->set(
+      "hostname/" + std::to_string(rank_),
+      std::vector<uint8_t>(hostname.begin(), hostname.end()));
+  std::unordered_map<std::string, int> nodeIndices;
+  for (int i = 0; i < size_; i++) {
+    const auto value = store_->get("hostname/" + std::to_string(i));
+    const std::string peerHostname(value.begin(), value.end());
+    auto it = nodeIndices.find(peerHostname);
+    if (it == nodeIndices.end()) {
+      it = nodeIndices.emplace(peerHostname, ranks_.size()).first;
+      ranks_.emplace_back();
+    }
+    if (i == rank_) {
+      nodeIndex_ = it->second;
+      localRank_ = ranks_[it->second].size();
+    }
+    ranks_[it->second].push_back(i);
+  }
+
+  numNodes_ = ranks_.size();
+  localSize_ = ranks_[0].size();
+  for (const auto& node : ranks_) {
+    if (node.size() != static_cast<size_t>(localSize_)) {
+      throw std::invalid_argument(
+          "ProcessGroupHierarchical requires the same number of "
+          "processes on every node");
+    }
+  }
+
+  intraStore_ = std::make_shared<PrefixStore>(
+      "intra/" + std::to_string(nodeIndex_), *store_);
+  interStore_ = std::make_shared<PrefixStore>(
+      "inter/" + std::to_string(localRank_), *store_);
+  intraGroup_ = createProcessGroup(intraStore_, localRank_, localSize_);
+  interGroup_ = createProcessGroup(interStore_, nodeIndex_, numNodes_);
+
+  workerThread_ = std::thread(&ProcessGroupHierarchical::runLoop, this);
+}
+
+ProcessGroupHierarchical::~ProcessGroupHierarchical() {
+  std::unique_lock<std::mutex> lock(pgMutex_);
+  queueConsumeCV_.wait(lock, [&] { return queue_.empty(); });
+
+  // Queue is empty, signal stop
+  stop_ = true;
+
+  // Release lock to allow threads to terminate
+  lock.unlock();
+  queueProduceCV_.notify_all();
+
+  // Join the single worker thread
+  workerThread_.join();
+}
+
+void ProcessGroupHierarchical::runLoop() {
+  std::unique_lock<std::mutex> lock(pgMutex_);
+
+  while (!stop_) {
+    if (queue_.empty()) {
+      queueProduceCV_.wait(lock);
+      continue;
+    }
+
+    auto workTuple = std::move(queue_.front());
+
+    queue_.pop_front();
+
+    auto& fn = std::get<0>(workTuple);
+    auto& work = std::get<1>(workTuple);
+
+    lock.unlock();
+    queueConsumeCV_.notify_one();
+
+    try {
+      fn();
+      work->finish();
+    } catch (...) {
+      work->finish(std::current_exception());
+    }
+
+    lock.lock();
+  }
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::enqueue(
+    std::function<void()> fn) {
+  auto work = std::make_shared<WorkHierarchical>();
+  std::unique_lock<std::mutex> lock(pgMutex_);
+  queue_.push_back(std::make_tuple(std::move(fn), work));
+  lock.unlock();
+  queueProduceCV_.notify_one();
+  return work;
+}
+
+void ProcessGroupHierarchical::runAllreduce(
+    at::Tensor tensor,
+    ReduceOp reduceOp) {
+  c10::DeviceGuard guard(tensor.device());
+  const auto numel = tensor.numel();
+  if (numel == 0) {
+    return;
+  }
+
+  // Pad the flattened tensor so that it splits into one equally sized
+  // chunk per local process.
+  const auto chunkSize = (numel + localSize_ - 1) / localSize_;
+  at::Tensor flat = at::empty({chunkSize * localSize_}, tensor.options());
+  flat.narrow(0, 0, numel).copy_(tensor.reshape({-1}));
+  if (flat.numel() > numel) {
+    // The padding is discarded, zero it to keep the reduction well defined.
+    flat.narrow(0, numel, flat.numel() - numel).zero_();
+  }
+  auto chunks = flat.chunk(localSize_);
+
+  // 1. Reduce within the node, leaving this process with its chunk.
+  at::Tensor chunk;
+  if (options_.useReduceScatter) {
+    std::vector<at::Tensor> outputs = {at::empty_like(chunks[localRank_])};
+    std::vector<std::vector<at::Tensor>> inputs = {chunks};
+    ReduceScatterOptions opts;
+    opts.reduceOp = reduceOp;
+    intraGroup_->reduce_scatter(outputs, inputs, opts)->wait();
+    chunk = outputs[0];
+  } else {
+    std::vector<at::Tensor> tensors = {flat};
+    AllreduceOptions opts;
+    opts.reduceOp = reduceOp;
+    intraGroup_->allreduce(tensors, opts)->wait();
+    chunk = chunks[localRank_].clone();
+  }
+
+  // 2. Reduce the chunk across nodes.
+  {
+    std::vector<at::Tensor> tensors = {chunk};
+    AllreduceOptions opts;
+    opts.reduceOp = reduceOp;
+    interGroup_->allreduce(tensors, opts)->wait();
+  }
+
+  // 3. Share the reduced chunks within the node.
+  {
+    std::vector<std::vector<at::Tensor>> outputs = {chunks};
+    std::vector<at::Tensor> inputs = {chunk};
+    intraGroup_->allgather(outputs, inputs)->wait();
+  }
+
+  tensor.copy_(flat.narrow(0, 0, numel).view(tensor.sizes()));
+}
+
+void ProcessGroupHierarchical::runBroadcast(at::Tensor tensor, int rootRank) {
+  c10::DeviceGuard guard(tensor.device());
+  int rootNode = -1;
+  int rootLocalRank = -1;
+  for (int i = 0; i < numNodes_; i++) {
+    for (int j = 0; j < localSize_; j++) {
+      if (ranks_[i][j] == rootRank) {
+        rootNode = i;
+        rootLocalRank = j;
+      }
+    }
+  }
+
+  // 1. Send to the root's peers on other nodes.
+  std::vector<at::Tensor> tensors = {tensor};
+  if (localRank_ == rootLocalRank) {
+    BroadcastOptions opts;
+    opts.rootRank = rootNode;
+    interGroup_->broadcast(tensors, opts)->wait();
+  }
+
+  // 2. Send to everyone else within the node.
+  BroadcastOptions opts;
+  opts.rootRank = rootLocalRank;
+  intraGroup_->broadcast(tensors, opts)->wait();
+}
+
+void ProcessGroupHierarchical::runAllgather(
+    std::vector<at::Tensor> outputs,
+    at::Tensor input) {
+  c10::DeviceGuard guard(input.device());
+
+  // 1. Gather the inputs of our peers on every node.
+  std::vector<std::vector<at::Tensor>> interOutputs(1);
+  for (int i = 0; i < numNodes_; i++) {
+    interOutputs[0].push_back(at::empty_like(input));
+  }
+  {
+    std::vector<at::Tensor> inputs = {input};
+    interGroup_->allgather(interOutputs, inputs)->wait();
+  }
+
+  // 2. Gather those within the node.
+  std::vector<std::vector<at::Tensor>> intraOutputs(1);
+  std::vector<at::Tensor> intraInputs = {at::stack(interOutputs[0])};
+  for (int i = 0; i < localSize_; i++) {
+    intraOutputs[0].push_back(at::empty_like(intraInputs[0]));
+  }
+  intraGroup_->allgather(intraOutputs, intraInputs)->wait();
+
+  // intraOutputs[0][j][i] holds the input of local rank j on node i.
+  for (int i = 0; i < numNodes_; i++) {
+    for (int j = 0; j < localSize_; j++) {
+      outputs[ranks_[i][j]].copy_(intraOutputs[0][j][i]);
+    }
+  }
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::broadcast(
+    std::vector<at::Tensor>& tensors,
+    const BroadcastOptions& opts) {
+  checkSingleTensor(tensors);
+  if (opts.rootRank < 0 || opts.rootRank >= size_) {
+    throw std::invalid_argument(
+        "ProcessGroupHierarchical::broadcast: invalid root rank");
+  }
+  auto tensor = tensors[0];
+  auto rootRank = opts.rootRank;
+  return enqueue([this, tensor, rootRank] { runBroadcast(tensor, rootRank); });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allreduce(
+    std::vector<at::Tensor>& tensors,
+    const AllreduceOptions& opts) {
+  checkSingleTensor(tensors);
+  auto tensor = tensors[0];
+  auto reduceOp = opts.reduceOp;
+  return enqueue([this, tensor, reduceOp] { runAllreduce(tensor, reduceOp); });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::
+    allreduce_coalesced(
+        std::vector<at::Tensor>& /* unused */,
+        const AllreduceCoalescedOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support allreduce_coalesced");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::reduce(
+    std::vector<at::Tensor>& /* unused */,
+    const ReduceOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support reduce");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::allgather(
+    std::vector<std::vector<at::Tensor>>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const AllgatherOptions& /* unused */) {
+  checkSingleTensor(inputTensors);
+  if (outputTensors.size() != 1) {
+    throw std::runtime_error(
+        "ProcessGroupHierarchical does not support multi-GPU collectives");
+  }
+  if (outputTensors[0].size() != static_cast<size_t>(size_)) {
+    throw std::runtime_error(
+        "ProcessGroupHierarchical::allgather: expected one output tensor "
+        "per process");
+  }
+  auto input = inputTensors[0];
+  for (const auto& output : outputTensors[0]) {
+    if (output.sizes() != input.sizes() || output.type() != input.type()) {
+      throw std::runtime_error("Tensors are not equal in size or data type");
+    }
+  }
+  auto outputs = outputTensors[0];
+  return enqueue([this, outputs, input] { runAllgather(outputs, input); });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::gather(
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    std::vector<at::Tensor>& /* unused */,
+    const GatherOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support gather");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::scatter(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    const ScatterOptions& /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support scatter");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::reduce_scatter(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<std::vector<at::Tensor>>& /* unused */,
+    const ReduceScatterOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support reduce_scatter");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::send(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */,
+    int /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support send");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::recv(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */,
+    int /* unused */) {
+  throw std::runtime_error("ProcessGroupHierarchical does not support recv");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::recvAnysource(
+    std::vector<at::Tensor>& /* unused */,
+    int /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupHierarchical does not support recvAnysource");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupHierarchical::barrier(
+    const BarrierOptions& opts) {
+  return enqueue([this, opts] {
+    intraGroup_->barrier(opts)->wait();
+    interGroup_->barrier(opts)->wait();
+    intraGroup_->barrier(opts)->wait();
+  });
+}
+
+} // namespace c10d
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <c10d/ProcessGroup.hpp>
+#include <c10d/Store.hpp>
+#include <c10d/Types.hpp>
+
+namespace c10d {
+
+// ProcessGroupHierarchical runs collectives in two levels, to reduce the
+// traffic between machines when every machine hosts multiple processes.
+//
+// On construction, every process publishes its hostname to the store, and
+// processes sharing a hostname are grouped into a node. Nodes are ordered by
+// the lowest rank they host, and processes within a node by rank; this
+// yields a node index and a local rank for every process. All nodes must
+// host the same number of processes. Two kinds of sub groups are then
+// created through the user specified factory function:
+//
+//   - one intra-node group per node, holding all processes on that node;
+//   - one inter-node group per local rank, holding the processes with that
+//     local rank on every node.
+//
+// With N nodes hosting L processes each, allreduce is implemented as:
+//
+//   1. a reduce-scatter within the node, leaving every process with a
+//      reduced 1/L chunk of the tensor;
+//   2. an allreduce of that chunk within the inter-node group;
+//   3. an allgather of the chunks within the node.
+//
+// Every byte therefore crosses the network once per node instead of once
+// per process. If the intra-node backend does not implement reduce_scatter
+// (e.g. MPI), set `Options::useReduceScatter` to false to replace step 1
+// by an allreduce within the node; inter-node traffic stays the same.
+//
+// Broadcast sends the tensor to the processes with the root's local rank
+// on every node first, and then within every node. Allgather gathers across
+// nodes first and then within the node, so that every input crosses the
+// network once per remote node.
+//
+// Only single tensor collectives are supported. Operations are executed in
+// order on a single worker thread that waits on the sub group operations,
+// so CUDA tensors are expected to be used on the default stream.
+class ProcessGroupHierarchical : public ProcessGroup {
+ public:
+  using CreateProcessGroupFn = std::function<std::shared_ptr<ProcessGroup>(
+      const std::shared_ptr<Store>& store,
+      int rank,
+      int size)>;
+
+  struct Options {
+    // Name used to determine which processes share a node. Defaults to
+    // the result of gethostname(2).
+    std::string hostname;
+
+    // Use reduce_scatter within the node (see above).
+    bool useReduceScatter = true;
+  };
+
+  explicit ProcessGroupHierarchical(
+      const std::shared_ptr<Store>& store,
+      int rank,
+      int size,
+      CreateProcessGroupFn createProcessGroup,
+      Options options = Options());
+
+  virtual ~ProcessGroupHierarchical();
+
+  int getNodeIndex() const {
+    return nodeIndex_;
+  }
+
+  int getNumNodes() const {
+    return numNodes_;
+  }
+
+  int getLocalRank() const {
+    return localRank_;
+  }
+
+  int getLocalSize() const {
+    return localSize_;
+  }
+
+  std::shared_ptr<ProcessGroup::Work> broadcast(
+      std::vector<at::Tensor>& tensors,
+      const BroadcastOptions& opts = BroadcastOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceOptions& opts = AllreduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allreduce_coalesced(
+      std::vector<at::Tensor>& tensors,
+      const AllreduceCoalescedOptions& opts =
+          AllreduceCoalescedOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce(
+      std::vector<at::Tensor>& tensors,
+      const ReduceOptions& opts = ReduceOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> allgather(
+      std::vector<std::vector<at::Tensor>>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const AllgatherOptions& opts = AllgatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> gather(
+      std::vector<std::vector<at::Tensor>>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const GatherOptions& opts = GatherOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> scatter(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<std::vector<at::Tensor>>& inputTensors,
+      const ScatterOptions& opts = ScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> reduce_scatter(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<std::vector<at::Tensor>>& inputTensors,
+      const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> send(
+      std::vector<at::Tensor>& tensors,
+      int dstRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recv(
+      std::vector<at::Tensor>& tensors,
+      int srcRank,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> recvAnysource(
+      std::vector<at::Tensor>& tensors,
+      int tag) override;
+
+  std::shared_ptr<ProcessGroup::Work> barrier(
+      const BarrierOptions& opts = BarrierOptions()) override;
+
+ protected:
+  class WorkHierarchical : public ProcessGroup::Work {
+   protected:
+    friend class ProcessGroupHierarchical;
+  };
+
+  using WorkType =
+      std::tuple<std::function<void()>, std::shared_ptr<WorkHierarchical>>;
+
+  // Worker thread loop
+  void runLoop();
+
+  std::shared_ptr<ProcessGroup::Work> enqueue(std::function<void()> fn);
+
+  void runAllreduce(at::Tensor tensor, ReduceOp reduceOp);
+
+  void runBroadcast(at::Tensor tensor, int rootRank);
+
+  void runAllgather(std::vector<at::Tensor> outputs, at::Tensor input);
+
+  // Keeps the prefix stores used by the sub groups alive.
+  std::shared_ptr<Store> store_;
+  std::shared_ptr<Store> intraStore_;
+  std::shared_ptr<Store> interStore_;
+
+  Options options_;
+
+  int nodeIndex_;
+  int numNodes_;
+  int localRank_;
+  int localSize_;
+
+  // Global rank of every process, indexed by [nodeIndex][localRank].
+  std::vector<std::vector<int>> ranks_;
+
+  std::shared_ptr<ProcessGroup> intraGroup_;
+  std::shared_ptr<ProcessGroup> interGroup_;
+
+  bool stop_;
+  std::mutex pgMutex_;
+  std::thread workerThread_;
+  std::deque<WorkType> queue_;
+  std::condition_variable queueProduceCV_;
+  std::condition_variable queueConsumeCV_;
+};
+
+} // namespace c10d
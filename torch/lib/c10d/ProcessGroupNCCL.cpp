@@ -1,5 +1,6 @@
 #include <c10d/ProcessGroupNCCL.hpp>
 
+#include <algorithm>
 #include <map>
 #include <tuple>
 #include <unordered_set>
@@ -84,6 +85,17 @@ std::vector<at::Device> getDeviceList(const std::vector<at::Tensor>& tensors) {
   return res;
 }
 
+// Returns the time of the system clock in microseconds since the epoch.
+int64_t nowMicros() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+std::vector<uint8_t> toVec(const std::string& str) {
+  return std::vector<uint8_t>(str.begin(), str.end());
+}
+
 // [Sync Streams] Helper that lets the input ncclStreams to wait for the current
 // stream. NCCL communications run on ncclStreams, but input tensors are
 // allocated on different streams (i.e., current streams). Communications on
@@ -109,11 +121,29 @@ void syncStreams(
   }
 }
 
+// [Concurrent Collectives] With NCCL_COMMS_PER_DEVICE > 1, each set of
+// devices has several NCCL communicators, each with its own NCCL stream, and
+// collectives that run on different ones may overlap. Every process runs the
+// same collectives in the same order, so round robin, or the kind of the
+// collective, assigns a collective to the same communicator on all of them.
+//
+// Collectives that use the same tensor on one NCCL stream are ordered by the
+// stream, as before. A collective doesn't wait for the collectives on other
+// NCCL streams, except, after [Sync Streams], for the last one that used the
+// storage of one of its tensors: every NCCL stream records an event after
+// each collective, and a collective blocks its stream on the event of the
+// stream that used a storage last. Storages still record every NCCL stream
+// that uses them, so none is freed before all collectives using it finish.
+
 } // namespace
 
 const int64_t ProcessGroupNCCL::kWatchdogThreadSleepMillis = 100;
 constexpr int64_t kSynchronizeBusyWaitMillis = 10;
 const int64_t ProcessGroupNCCL::kProcessGroupNCCLOpTimeoutMillis = 10 * 1000;
+// How long the watchdog thread waits for the traces of the other processes
+// after a timeout. The processes that also run the timed out collective time
+// out at about the same time, and the others never do.
+constexpr int64_t kTraceTimeoutExchangeMillis = 10 * 1000;
 
 ProcessGroupNCCL::WorkNCCL::WorkNCCL(const std::vector<at::Device>& devices)
     : devices_(devices), workStartTime_(std::chrono::steady_clock::now()) {
@@ -246,6 +276,51 @@ ProcessGroupNCCL::ProcessGroupNCCL(
         std::string(NCCL_BLOCKING_WAIT));
   }
 
+  char* commsPerDevice = getenv(NCCL_COMMS_PER_DEVICE);
+  try {
+    if (commsPerDevice != nullptr) {
+      numCommsPerDevice_ = std::stoi(commsPerDevice);
+      if (numCommsPerDevice_ < 1) {
+        throw std::runtime_error(
+            "Invalid value for environment variable: " +
+            std::string(NCCL_COMMS_PER_DEVICE));
+      }
+    }
+  } catch (std::exception& e) {
+    throw std::runtime_error(
+        "Invalid value for environment variable: " +
+        std::string(NCCL_COMMS_PER_DEVICE));
+  }
+
+  char* commAssignment = getenv(NCCL_COMM_ASSIGNMENT);
+  if (commAssignment != nullptr) {
+    if (std::string(commAssignment) == "op") {
+      commAssignment_ = CommAssignment::OP;
+    } else if (std::string(commAssignment) != "round_robin") {
+      throw std::runtime_error(
+          "Invalid value for environment variable: " +
+          std::string(NCCL_COMM_ASSIGNMENT));
+    }
+  }
+
+  char* traceBufferSize = getenv(NCCL_TRACE_BUFFER_SIZE);
+  try {
+    if (traceBufferSize != nullptr) {
+      auto val = std::stoi(traceBufferSize);
+      if (val < 0) {
+        throw std::runtime_error(
+            "Invalid value for environment variable: " +
+            std::string(NCCL_TRACE_BUFFER_SIZE));
+      }
+      traceBufferSize_ = val;
+    }
+  } catch (std::exception& e) {
+    throw std::runtime_error(
+        "Invalid value for environment variable: " +
+        std::string(NCCL_TRACE_BUFFER_SIZE));
+  }
+  traceRecords_.resize(traceBufferSize_);
+
 #ifdef ENABLE_NCCL_ERROR_CHECKING
   ncclCommWatchdogThread_ =
       std::thread(&ProcessGroupNCCL::ncclCommWatchdog, this);
@@ -294,6 +369,8 @@ void ProcessGroupNCCL::ncclCommWatchdog() {
       }
     }
 
+    checkTraceTimeout();
+
     std::unique_lock<std::mutex> lock(watchdogCVMutex_);
     watchdogCV_.wait_for(
         lock,
@@ -414,6 +491,15 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
       std::make_tuple(devicesKey),
       std::make_tuple(devices.size()));
 
+  if (traceBufferSize_ > 0) {
+    // The new NCCL stream is idle, so its clock event completes right away.
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    auto& clock = traceClocks_[devicesKey];
+    clock.event.record(ncclStreams_[devicesKey][0]);
+    clock.event.synchronize();
+    clock.micros = nowMicros();
+  }
+
   // Hold the lock before modifying the cache.
   std::lock_guard<std::mutex> lock(devNCCLCommMapLock_);
 
@@ -422,6 +508,215 @@ std::vector<std::shared_ptr<NCCLComm>>& ProcessGroupNCCL::getNCCLComm(
   return devNCCLCommMap_[devicesKey];
 }
 
+std::string ProcessGroupNCCL::getCommKey(
+    const std::string& devicesKey,
+    OpType opType) {
+  if (numCommsPerDevice_ == 1) {
+    return devicesKey;
+  }
+  size_t index = commAssignment_ == CommAssignment::OP
+      ? static_cast<size_t>(opType)
+      : devCollectiveCounter_[devicesKey]++;
+  index %= numCommsPerDevice_;
+  if (index == 0) {
+    return devicesKey;
+  }
+  return devicesKey + "/" + std::to_string(index);
+}
+
+void ProcessGroupNCCL::syncTensorUse(
+    const std::string& commKey,
+    size_t i,
+    const at::Tensor& tensor) {
+  auto& lastUse = storageLastUse_[tensor.storage().data()];
+  if (!lastUse.first.empty() &&
+      (lastUse.first != commKey || lastUse.second != i)) {
+    // See [Concurrent Collectives].
+    ncclDoneEvents_[lastUse.first][lastUse.second].block(
+        ncclStreams_[commKey][i]);
+  }
+  lastUse = std::make_pair(commKey, i);
+}
+
+size_t ProcessGroupNCCL::traceStart(
+    const std::string& commKey,
+    OpType opType,
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<at::Tensor>& outputs) {
+  const auto& stream = ncclStreams_[commKey][0];
+  std::lock_guard<std::mutex> lock(traceMutex_);
+  const auto seq = collectiveSeq_++;
+  const auto index = seq % traceBufferSize_;
+  auto& record = traceRecords_[index];
+  if (record.startEvent.isCreated() &&
+      record.startEvent.device_index() != stream.device_index()) {
+    // The events of a record can only be recorded on their device.
+    record.startEvent = at::cuda::CUDAEvent(cudaEventDefault);
+    record.endEvent = at::cuda::CUDAEvent(cudaEventDefault);
+  }
+
+  auto& entry = record.entry;
+  entry.seq = seq;
+  switch (opType) {
+    case OpType::ALLREDUCE:
+      entry.opType = "ALLREDUCE";
+      break;
+    case OpType::BROADCAST:
+      entry.opType = "BROADCAST";
+      break;
+    case OpType::REDUCE:
+      entry.opType = "REDUCE";
+      break;
+    case OpType::ALLGATHER:
+      entry.opType = "ALLGATHER";
+      break;
+    case OpType::REDUCE_SCATTER:
+      entry.opType = "REDUCE_SCATTER";
+      break;
+    case OpType::ALLTOALL:
+      entry.opType = "ALLTOALL";
+      break;
+  }
+  entry.dtype = c10::toString(inputs[0].scalar_type());
+  entry.inputSizes = inputs[0].sizes().vec();
+  entry.outputSizes = outputs[0].sizes().vec();
+  entry.enqueueMicros = nowMicros();
+  entry.startMicros = -1;
+  entry.endMicros = -1;
+  record.commKey = commKey;
+  record.recorded = false;
+  record.startEvent.record(stream);
+  return index;
+}
+
+void ProcessGroupNCCL::traceEnd(size_t index) {
+  std::lock_guard<std::mutex> lock(traceMutex_);
+  auto& record = traceRecords_[index];
+  record.endEvent.record(ncclStreams_[record.commKey][0]);
+  record.recorded = true;
+}
+
+std::vector<CollectiveTraceEntry> ProcessGroupNCCL::getTraceLocked() {
+  auto toMicros = [](const TraceClock& clock,
+                     const at::cuda::CUDAEvent& event) {
+    float millis = 0;
+    AT_CUDA_CHECK(
+        cudaEventElapsedTime(&millis, clock.event.event(), event.event()));
+    return clock.micros + static_cast<int64_t>(millis * 1000);
+  };
+
+  std::vector<CollectiveTraceEntry> trace;
+  const auto first = collectiveSeq_ > traceBufferSize_
+      ? collectiveSeq_ - traceBufferSize_
+      : 0;
+  for (auto seq = first; seq < collectiveSeq_; seq++) {
+    auto& record = traceRecords_[seq % traceBufferSize_];
+    auto& entry = record.entry;
+    if (record.recorded && entry.endMicros < 0) {
+      const auto& clock = traceClocks_[record.commKey];
+      if (entry.startMicros < 0 && record.startEvent.query()) {
+        entry.startMicros = toMicros(clock, record.startEvent);
+      }
+      if (entry.startMicros >= 0 && record.endEvent.query()) {
+        entry.endMicros = toMicros(clock, record.endEvent);
+      }
+    }
+    trace.push_back(entry);
+  }
+  return trace;
+}
+
+std::vector<CollectiveTraceEntry> ProcessGroupNCCL::getTrace() {
+  std::lock_guard<std::mutex> lock(traceMutex_);
+  return getTraceLocked();
+}
+
+std::string ProcessGroupNCCL::dumpTrace() {
+  return formatCollectiveTrace(getTrace());
+}
+
+std::string ProcessGroupNCCL::reportStragglers(
+    const std::chrono::milliseconds& timeout) {
+  const auto prefix =
+      "nccl_trace/" + std::to_string(traceReportCounter_++) + "/";
+  store_->set(
+      prefix + std::to_string(rank_),
+      toVec(serializeCollectiveTrace(getTrace())));
+
+  std::vector<std::string> keys;
+  for (int rank = 0; rank < size_; rank++) {
+    keys.push_back(prefix + std::to_string(rank));
+  }
+  store_->wait(keys, timeout);
+
+  std::vector<std::vector<CollectiveTraceEntry>> traces;
+  for (const auto& key : keys) {
+    const auto value = store_->get(key);
+    traces.push_back(
+        parseCollectiveTrace(std::string(value.begin(), value.end())));
+  }
+  return compareCollectiveTraces(traces);
+}
+
+void ProcessGroupNCCL::checkTraceTimeout() {
+  std::vector<CollectiveTraceEntry> trace;
+  uint64_t timedOutSeq = 0;
+  {
+    std::lock_guard<std::mutex> lock(traceMutex_);
+    if (traceBufferSize_ == 0 || traceTimeoutReported_) {
+      return;
+    }
+    trace = getTraceLocked();
+    const auto now = nowMicros();
+    auto it = std::find_if(
+        trace.begin(),
+        trace.end(),
+        [&](const CollectiveTraceEntry& entry) {
+          return entry.endMicros < 0 &&
+              now - entry.enqueueMicros > opTimeout_.count() * 1000;
+        });
+    if (it == trace.end()) {
+      return;
+    }
+    timedOutSeq = it->seq;
+    traceTimeoutReported_ = true;
+  }
+
+  LOG(ERROR) << "Collective #" << timedOutSeq << " of rank " << rank_
+             << " has run for longer than " << opTimeout_.count()
+             << " ms. Trace of rank " << rank_ << ":\n"
+             << formatCollectiveTrace(trace);
+
+  // Only the processes that time out publish their traces, so a process
+  // that hasn't entered the collective shows up without a trace.
+  try {
+    const std::string prefix = "nccl_trace/timeout/";
+    store_->set(
+        prefix + std::to_string(rank_), toVec(serializeCollectiveTrace(trace)));
+    std::vector<std::string> keys;
+    for (int rank = 0; rank < size_; rank++) {
+      keys.push_back(prefix + std::to_string(rank));
+    }
+    try {
+      store_->wait(keys, std::chrono::milliseconds(kTraceTimeoutExchangeMillis));
+    } catch (const std::exception&) {
+      // Compare the traces that have been published.
+    }
+    std::vector<std::vector<CollectiveTraceEntry>> traces(size_);
+    for (int rank = 0; rank < size_; rank++) {
+      if (store_->check({keys[rank]})) {
+        const auto value = store_->get(keys[rank]);
+        traces[rank] =
+            parseCollectiveTrace(std::string(value.begin(), value.end()));
+      }
+    }
+    LOG(ERROR) << "Comparison of the traces of the ranks that timed out:\n"
+               << compareCollectiveTraces(traces);
+  } catch (const std::exception& e) {
+    LOG(ERROR) << "Failed to compare the traces of the ranks: " << e.what();
+  }
+}
+
 namespace {
 
 // Check that all `tensors' have the same type and shape and are distributed
@@ -514,16 +809,38 @@ template <typename Fn, typename PreProcess, typename PostProcess>
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
     std::vector<at::Tensor>& inputs,
     std::vector<at::Tensor>& outputs,
+    OpType opType,
     Fn fn,
     PreProcess pre,
-    PostProcess post) {
+    PostProcess post,
+    const std::vector<std::vector<at::Tensor>>& other) {
   const auto devices = getDeviceList(inputs);
-  const auto key = getKeyFromDevices(devices);
+  const auto key = getCommKey(getKeyFromDevices(devices), opType);
   auto& ncclComms = getNCCLComm(key, devices);
 
   // First let NCCL streams wait for input tensors allocation streams
   syncStreams(devices, ncclEvents_[key], ncclStreams_[key]);
 
+  if (numCommsPerDevice_ > 1) {
+    if (ncclDoneEvents_.find(key) == ncclDoneEvents_.end()) {
+      ncclDoneEvents_.emplace(
+          std::piecewise_construct,
+          std::make_tuple(key),
+          std::make_tuple(devices.size()));
+    }
+    // Then let them wait for the other NCCL streams that used the same
+    // tensors. See [Concurrent Collectives].
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      syncTensorUse(key, i, inputs[i]);
+      syncTensorUse(key, i, outputs[i]);
+      if (i < other.size()) {
+        for (const auto& tensor : other[i]) {
+          syncTensorUse(key, i, tensor);
+        }
+      }
+    }
+  }
+
   // Work itself will create the CUDA events on all GPUs of tensors
   auto work = initWork(devices);
 
@@ -531,6 +848,10 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
 
   pre(ncclStreams_[key]);
 
+  // See [Flight Recorder].
+  const auto traceIndex =
+      traceBufferSize_ > 0 ? traceStart(key, opType, inputs, outputs) : 0;
+
   for (size_t i = 0; i < inputs.size(); ++i) {
     gpuGuard.set_index(devices[i].index());
     at::cuda::CUDAStream& ncclStream = ncclStreams_[key][i];
@@ -557,12 +878,19 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
     }
   }
 
+  if (traceBufferSize_ > 0) {
+    traceEnd(traceIndex);
+  }
+
   post(ncclStreams_[key]);
 
   // Event should only be recorded after the ncclGroupEnd()
   for (size_t i = 0; i < inputs.size(); ++i) {
     at::cuda::CUDAStream& ncclStream = ncclStreams_[key][i];
     work->cudaEvents_[i].record(ncclStream);
+    if (numCommsPerDevice_ > 1) {
+      ncclDoneEvents_[key][i].record(ncclStream);
+    }
     work->ncclComms_[i] = ncclComms[i];
     work->blockingWait_ = blockingWait_;
     work->opTimeout_ = opTimeout_;
@@ -575,10 +903,12 @@ template <typename Fn>
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::collective(
     std::vector<at::Tensor>& inputs,
     std::vector<at::Tensor>& outputs,
+    OpType opType,
     Fn fn) {
   return collective(
       inputs,
       outputs,
+      opType,
       fn,
       [](std::vector<at::cuda::CUDAStream>&) {},
       [](std::vector<at::cuda::CUDAStream>&) {});
@@ -592,6 +922,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allreduce(
   return collective(
       tensors,
       tensors,
+      OpType::ALLREDUCE,
       [&](at::Tensor& input,
           at::Tensor& output,
           ncclComm_t comm,
@@ -622,6 +953,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::broadcast(
   return collective(
       tensors,
       tensors,
+      OpType::BROADCAST,
       [&](at::Tensor& input,
           at::Tensor& output,
           ncclComm_t comm,
@@ -645,6 +977,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce(
   return collective(
       tensors,
       tensors,
+      OpType::REDUCE,
       [&](at::Tensor& input,
           at::Tensor& output,
           ncclComm_t comm,
@@ -675,6 +1008,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
   return collective(
       inputTensors,
       outputFlattened,
+      OpType::ALLGATHER,
       [&](at::Tensor& input,
           at::Tensor& output,
           ncclComm_t comm,
@@ -702,7 +1036,8 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::allgather(
             outputTensors[i][j].copy_(outputFlattened[i][j], true);
           }
         }
-      });
+      },
+      outputTensors);
 }
 
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
@@ -718,6 +1053,7 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
   return collective(
       inputFlattened,
       outputTensors,
+      OpType::REDUCE_SCATTER,
       [&](at::Tensor& input,
           at::Tensor& output,
           ncclComm_t comm,
@@ -746,9 +1082,162 @@ std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::reduce_scatter(
           }
         }
       },
-      [&](std::vector<at::cuda::CUDAStream>& ncclStreams) {});
+      [&](std::vector<at::cuda::CUDAStream>& ncclStreams) {},
+      inputTensors);
 }
 
+#ifdef ENABLE_NCCL_P2P_SUPPORT
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::alltoall_base(
+    at::Tensor& outputTensor,
+    at::Tensor& inputTensor,
+    std::vector<int64_t>& outputSplitSizes,
+    std::vector<int64_t>& inputSplitSizes,
+    const AllToAllOptions& /* unused */) {
+  std::vector<at::Tensor> inputTensors = {inputTensor};
+  std::vector<at::Tensor> outputTensors = {outputTensor};
+  check_gpu_tensors(inputTensors);
+  check_gpu_tensors(outputTensors);
+  if (inputTensor.device() != outputTensor.device()) {
+    throw std::runtime_error(
+        "Input and output tensors to alltoall must reside on the same device");
+  }
+  checkSplitSizes(inputSplitSizes, inputTensor, size_);
+  checkSplitSizes(outputSplitSizes, outputTensor, size_);
+
+  return collective(
+      inputTensors,
+      outputTensors,
+      OpType::ALLTOALL,
+      [&](at::Tensor& input,
+          at::Tensor& output,
+          ncclComm_t comm,
+          at::cuda::CUDAStream& stream) {
+        c10::cuda::CUDACachingAllocator::recordStream(
+            output.storage().data(), stream);
+        std::vector<size_t> sendLengths(size_);
+        std::vector<size_t> sendOffsets(size_);
+        std::vector<size_t> recvLengths(size_);
+        std::vector<size_t> recvOffsets(size_);
+        computeLengthsAndOffsets(
+            inputSplitSizes, input, &sendLengths, &sendOffsets);
+        computeLengthsAndOffsets(
+            outputSplitSizes, output, &recvLengths, &recvOffsets);
+        const auto type = getNcclDataType(input.scalar_type());
+        const auto elementSize = input.element_size();
+        auto sendBuff = static_cast<char*>(input.data_ptr());
+        auto recvBuff = static_cast<char*>(output.data_ptr());
+        // The sends and receives are all issued in the NCCL group that
+        // collective() opened, so none of them blocks the others.
+        for (int r = 0; r < size_; ++r) {
+          C10D_NCCL_CHECK(ncclSend(
+              sendBuff + sendOffsets[r] * elementSize,
+              sendLengths[r],
+              type,
+              r,
+              comm,
+              stream.stream()));
+          C10D_NCCL_CHECK(ncclRecv(
+              recvBuff + recvOffsets[r] * elementSize,
+              recvLengths[r],
+              type,
+              r,
+              comm,
+              stream.stream()));
+        }
+        return ncclSuccess;
+      });
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::alltoall(
+    std::vector<at::Tensor>& outputTensors,
+    std::vector<at::Tensor>& inputTensors,
+    const AllToAllOptions& /* unused */) {
+  if (inputTensors.size() != static_cast<size_t>(size_) ||
+      outputTensors.size() != static_cast<size_t>(size_)) {
+    throw std::runtime_error(
+        "Number of input and output tensors to alltoall must equal group size");
+  }
+  const auto device = inputTensors[0].device();
+  for (size_t r = 0; r < inputTensors.size(); ++r) {
+    if (!inputTensors[r].is_cuda() || !outputTensors[r].is_cuda()) {
+      throw std::runtime_error("Tensors must be CUDA and dense");
+    }
+    if (!inputTensors[r].is_contiguous() || !outputTensors[r].is_contiguous()) {
+      throw std::runtime_error("Tensors must be contiguous");
+    }
+    if (inputTensors[r].device() != device ||
+        outputTensors[r].device() != device) {
+      throw std::runtime_error(
+          "Tensors to alltoall must all reside on the same device");
+    }
+    if (inputTensors[r].scalar_type() != inputTensors[0].scalar_type() ||
+        outputTensors[r].scalar_type() != inputTensors[0].scalar_type()) {
+      throw std::runtime_error("Tensors to alltoall must have the same type");
+    }
+  }
+
+  // The first tensors pick the device and are recorded by collective(), the
+  // others go through `other`.
+  std::vector<at::Tensor> inputs = {inputTensors[0]};
+  std::vector<at::Tensor> outputs = {outputTensors[0]};
+  std::vector<at::Tensor> others(inputTensors.begin(), inputTensors.end());
+  others.insert(others.end(), outputTensors.begin(), outputTensors.end());
+
+  return collective(
+      inputs,
+      outputs,
+      OpType::ALLTOALL,
+      [&](at::Tensor& /* unused */,
+          at::Tensor& /* unused */,
+          ncclComm_t comm,
+          at::cuda::CUDAStream& stream) {
+        for (int r = 0; r < size_; ++r) {
+          // See [Sync Streams].
+          c10::cuda::CUDACachingAllocator::recordStream(
+              inputTensors[r].storage().data(), stream);
+          c10::cuda::CUDACachingAllocator::recordStream(
+              outputTensors[r].storage().data(), stream);
+          C10D_NCCL_CHECK(ncclSend(
+              inputTensors[r].data_ptr(),
+              inputTensors[r].numel(),
+              getNcclDataType(inputTensors[r].scalar_type()),
+              r,
+              comm,
+              stream.stream()));
+          C10D_NCCL_CHECK(ncclRecv(
+              outputTensors[r].data_ptr(),
+              outputTensors[r].numel(),
+              getNcclDataType(outputTensors[r].scalar_type()),
+              r,
+              comm,
+              stream.stream()));
+        }
+        return ncclSuccess;
+      },
+      [](std::vector<at::cuda::CUDAStream>&) {},
+      [](std::vector<at::cuda::CUDAStream>&) {},
+      {others});
+}
+#else
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::alltoall_base(
+    at::Tensor& /* unused */,
+    at::Tensor& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    std::vector<int64_t>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupNCCL only supports alltoall for NCCL lib version >= 2.7.0");
+}
+
+std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::alltoall(
+    std::vector<at::Tensor>& /* unused */,
+    std::vector<at::Tensor>& /* unused */,
+    const AllToAllOptions& /* unused */) {
+  throw std::runtime_error(
+      "ProcessGroupNCCL only supports alltoall for NCCL lib version >= 2.7.0");
+}
+#endif
+
 std::shared_ptr<ProcessGroup::Work> ProcessGroupNCCL::barrier(
     const BarrierOptions& opts) {
   std::vector<at::Device> devices;
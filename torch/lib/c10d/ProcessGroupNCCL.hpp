@@ -4,6 +4,7 @@
 #include <thread>
 #include <unordered_map>
 
+#include <c10d/CollectiveTrace.hpp>
 #include <c10d/NCCLUtils.hpp>
 #include <c10d/ProcessGroup.hpp>
 #include <c10d/Store.hpp>
@@ -17,6 +18,20 @@ namespace c10d {
 // non-blocking.
 constexpr const char* NCCL_BLOCKING_WAIT = "NCCL_BLOCKING_WAIT";
 
+// Environment variable which controls how many NCCL communicators, each with
+// its own NCCL stream, a process group keeps for every set of devices.
+constexpr const char* NCCL_COMMS_PER_DEVICE = "NCCL_COMMS_PER_DEVICE";
+
+// Environment variable which controls which of these communicators a
+// collective runs on: "round_robin" (the default) cycles through them, and
+// "op" gives every kind of collective its own.
+constexpr const char* NCCL_COMM_ASSIGNMENT = "NCCL_COMM_ASSIGNMENT";
+
+// Environment variable which controls how many of the last collectives of a
+// process group its flight recorder keeps, see [Flight Recorder]. 0, the
+// default, disables it.
+constexpr const char* NCCL_TRACE_BUFFER_SIZE = "NCCL_TRACE_BUFFER_SIZE";
+
 // ProcessGroupNCCL implements NCCL bindings for c10d.
 //
 // All functions of the class are expected to be called in the same order
@@ -36,6 +51,25 @@ constexpr const char* NCCL_BLOCKING_WAIT = "NCCL_BLOCKING_WAIT";
 // either WorkNCCL::wait() or WorkNCCL::synchronize(), both achieves the same
 // functionality and are synonyms.
 //
+// By default, all NCCL calls on a set of devices are scheduled on the same
+// NCCL stream and therefore run one after the other. With
+// NCCL_COMMS_PER_DEVICE set to more than 1, independent collectives, e.g. the
+// allreduce of gradients and the allgather of embeddings, can run on
+// different communicators and streams at the same time. A collective still
+// waits for the collectives that used the same tensors before it, see
+// [Concurrent Collectives].
+//
+// [Flight Recorder] With NCCL_TRACE_BUFFER_SIZE set, the process group keeps
+// the last collectives it ran in a ring buffer: their kind, type and sizes,
+// when they were enqueued, and, from CUDA events with timing recorded around
+// them on the NCCL stream of the first device, when they started and
+// finished on the GPU. getTrace() and dumpTrace() return the collectives of
+// a process, and reportStragglers() compares them across all processes
+// through the store, to find the ranks that enter collectives late. When a
+// collective runs longer than the operation timeout, the watchdog thread
+// logs the trace of the process and the comparison with the traces of the
+// processes that also timed out.
+//
 // Also note that WorkNCCL::finishedGPUExecution() is a helper function only
 // provided by ProcessGroupNCCL to check if the NCCL operation of WorkNCCL has
 // finished execution on the GPU (not just scheduled).
@@ -182,6 +216,21 @@ class ProcessGroupNCCL : public ProcessGroup {
       std::vector<std::vector<at::Tensor>>& inputTensors,
       const ReduceScatterOptions& opts = ReduceScatterOptions()) override;
 
+  // The all-to-all collectives run as one ncclSend() and one ncclRecv() per
+  // rank in a single NCCL group, and need NCCL 2.7+ and a single GPU tensor
+  // per process.
+  std::shared_ptr<ProcessGroup::Work> alltoall_base(
+      at::Tensor& outputTensor,
+      at::Tensor& inputTensor,
+      std::vector<int64_t>& outputSplitSizes,
+      std::vector<int64_t>& inputSplitSizes,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
+  std::shared_ptr<ProcessGroup::Work> alltoall(
+      std::vector<at::Tensor>& outputTensors,
+      std::vector<at::Tensor>& inputTensors,
+      const AllToAllOptions& opts = AllToAllOptions()) override;
+
   std::shared_ptr<ProcessGroup::Work> barrier(
       const BarrierOptions& opts = BarrierOptions()) override;
 
@@ -210,6 +259,20 @@ class ProcessGroupNCCL : public ProcessGroup {
       std::vector<at::Tensor>& tensors,
       int tag) override;
 
+  // Returns the collectives in the flight recorder, oldest first. Empty
+  // unless NCCL_TRACE_BUFFER_SIZE is set.
+  std::vector<CollectiveTraceEntry> getTrace();
+
+  // Returns the collectives in the flight recorder, formatted for humans.
+  std::string dumpTrace();
+
+  // Exchanges the traces of all processes through the store and returns
+  // their comparison, see compareCollectiveTraces(). All processes must call
+  // it, like a collective.
+  std::string reportStragglers(
+      const std::chrono::milliseconds& timeout =
+          std::chrono::milliseconds(kProcessGroupNCCLOpTimeoutMillis));
+
   static const int64_t kProcessGroupNCCLOpTimeoutMillis;
 
  protected:
@@ -230,24 +293,56 @@ class ProcessGroupNCCL : public ProcessGroup {
       std::vector<at::Device> devices);
 
  private:
+  // The kinds of collectives, which pick a communicator with
+  // NCCL_COMM_ASSIGNMENT=op.
+  enum class OpType : uint8_t {
+    ALLREDUCE,
+    BROADCAST,
+    REDUCE,
+    ALLGATHER,
+    REDUCE_SCATTER,
+    ALLTOALL,
+  };
+
+  // How collectives are assigned to the communicators of a set of devices.
+  enum class CommAssignment : uint8_t { ROUND_ROBIN, OP };
+
   // Helper that encapsulates work shared across all collective communication
   // primitives.  The callbacks have the following signatures:
   //
   //    ncclResult_t fn(at::Tensor& input, at::Tensor& output,
   //                    ncclComm_t, at::cuda::CUDAStream&);
   //    void {pre,post}(std::vector<at::cuda::CUDAStream&>);
+  //
+  // `other` holds, for every device, the tensors that pre and post copy from
+  // or to on the NCCL streams, besides input and output.
   template <typename Fn>
   std::shared_ptr<ProcessGroup::Work> collective(
       std::vector<at::Tensor>& input,
       std::vector<at::Tensor>& output,
+      OpType opType,
       Fn fn);
   template <typename Fn, typename PreProcess, typename PostProcess>
   std::shared_ptr<ProcessGroup::Work> collective(
       std::vector<at::Tensor>& input,
       std::vector<at::Tensor>& output,
+      OpType opType,
       Fn fn,
       PreProcess pre,
-      PostProcess post);
+      PostProcess post,
+      const std::vector<std::vector<at::Tensor>>& other = {});
+
+  // Returns the key of the communicators a collective of opType on the
+  // devices of devicesKey runs on.
+  std::string getCommKey(const std::string& devicesKey, OpType opType);
+
+  // Makes the NCCL stream of commKey on the i-th device wait for the last
+  // collective that used the storage of tensor on another NCCL stream, and
+  // remembers that the storage is now used on this one.
+  void syncTensorUse(
+      const std::string& commKey,
+      size_t i,
+      const at::Tensor& tensor);
 
   // Checks for NCCL errors on each of the communicators and returns an
   // appropriate exception_ptr (nullptr if no errors).
@@ -265,6 +360,44 @@ class ProcessGroupNCCL : public ProcessGroup {
   // object might get destroyed before the WorkNCCL object.
   void ncclCommWatchdog();
 
+  // A collective in the flight recorder. The events are recorded on the NCCL
+  // stream of the first device, and are reused when the buffer wraps around.
+  struct TraceRecord {
+    CollectiveTraceEntry entry;
+    std::string commKey;
+    at::cuda::CUDAEvent startEvent{cudaEventDefault};
+    at::cuda::CUDAEvent endEvent{cudaEventDefault};
+    // Whether both events have been recorded for entry.
+    bool recorded = false;
+  };
+
+  // A timing event recorded on an idle NCCL stream, and the time of the
+  // system clock when it completed, which convert the times of the events of
+  // the TraceRecords on this stream to the system clock.
+  struct TraceClock {
+    at::cuda::CUDAEvent event{cudaEventDefault};
+    int64_t micros = 0;
+  };
+
+  // Adds a collective to the flight recorder and records its start event.
+  // Returns its index in traceRecords_.
+  size_t traceStart(
+      const std::string& commKey,
+      OpType opType,
+      const std::vector<at::Tensor>& inputs,
+      const std::vector<at::Tensor>& outputs);
+
+  // Records the end event of the collective at index.
+  void traceEnd(size_t index);
+
+  // The same as getTrace(), with traceMutex_ held.
+  std::vector<CollectiveTraceEntry> getTraceLocked();
+
+  // Called by the watchdog thread. Logs the trace, and the comparison with
+  // the traces of the other processes, the first time a collective runs
+  // longer than opTimeout_.
+  void checkTraceTimeout();
+
  protected:
   static const int64_t kWatchdogThreadSleepMillis;
 
@@ -320,6 +453,29 @@ class ProcessGroupNCCL : public ProcessGroup {
   // The CUDA events used to sync NCCL streams
   std::unordered_map<std::string, std::vector<at::cuda::CUDAEvent>> ncclEvents_;
 
+  // The number of NCCL communicators, and streams, for every set of devices.
+  // Communicators after the first have the key of the devices followed by
+  // "/" and their index, e.g. "0,1/1".
+  int numCommsPerDevice_ = 1;
+
+  CommAssignment commAssignment_ = CommAssignment::ROUND_ROBIN;
+
+  // The number of collectives run on every set of devices, for round robin
+  // assignment.
+  std::unordered_map<std::string, uint64_t> devCollectiveCounter_;
+
+  // The CUDA events recorded on the NCCL streams after every collective,
+  // which other NCCL streams wait for to use the same tensors. Only used
+  // with more than one communicator for every set of devices.
+  std::unordered_map<std::string, std::vector<at::cuda::CUDAEvent>>
+      ncclDoneEvents_;
+
+  // The NCCL stream, as the key of its communicators and the index of the
+  // device, that last used a storage. Entries for freed storages are never
+  // removed, which at worst makes a collective wait for an unrelated one.
+  std::unordered_map<const void*, std::pair<std::string, size_t>>
+      storageLastUse_;
+
   // Device Indexes used for all collectives in this group
   std::set<int> usedDeviceIdxs_;
 
@@ -347,8 +503,33 @@ class ProcessGroupNCCL : public ProcessGroup {
   // for the operation to complete.
   bool blockingWait_ = false;
 
-  // Timeout for operations. This is only used when blockingWait_ is enabled.
+  // Timeout for operations. This is only used when blockingWait_ is enabled,
+  // and by the flight recorder.
   std::chrono::milliseconds opTimeout_;
+
+  // The size of the ring buffer of the flight recorder, 0 if disabled.
+  size_t traceBufferSize_ = 0;
+
+  // The number of collectives run by the process group, which numbers them
+  // in the flight recorder.
+  uint64_t collectiveSeq_ = 0;
+
+  // The ring buffer of the flight recorder, where collective seq is at index
+  // seq % traceBufferSize_.
+  std::vector<TraceRecord> traceRecords_;
+
+  // The clocks of the NCCL streams, by the key of their communicators.
+  std::unordered_map<std::string, TraceClock> traceClocks_;
+
+  // The number of calls to reportStragglers(), which scopes its keys in the
+  // store.
+  uint64_t traceReportCounter_ = 0;
+
+  // Whether the watchdog thread already reported a timeout.
+  bool traceTimeoutReported_ = false;
+
+  // Mutex to guard the flight recorder, which the watchdog thread reads.
+  std::mutex traceMutex_;
 };
 
 } // namespace c10d
@@ -0,0 +1,1105 @@
+#include <c10d/ShardedTCPStore.hpp>
+
+#include <poll.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace c10d {
+
+namespace {
+
+// The queries of the protocol, which sends keys and values as TCPStore does.
+enum class QueryType : uint8_t {
+  SET,
+  GET,
+  ADD,
+  CHECK,
+  WAIT,
+  MULTI_SET,
+  MULTI_GET,
+  COMPARE_SET,
+  BARRIER,
+  BARRIER_ARRIVE,
+  WATCH,
+};
+
+enum class CheckResponseType : uint8_t { READY, NOT_READY };
+
+enum class WaitResponseType : uint8_t { STOP_WAITING };
+
+constexpr int kMaxEvents = 64;
+
+// The key counting the processes that have reached a barrier.
+std::string barrierCountKey(const std::string& key) {
+  return "barrier/" + key;
+}
+
+// The key the server sets once all processes have reached a barrier.
+std::string barrierDoneKey(const std::string& key) {
+  return "barrier_done/" + key;
+}
+
+void sendKeys(
+    int socket,
+    const std::vector<std::string>& keys,
+    bool moreData = false) {
+  SizeType nkeys = keys.size();
+  tcputil::sendBytes<SizeType>(socket, &nkeys, 1, moreData || nkeys > 0);
+  for (size_t i = 0; i < nkeys; i++) {
+    tcputil::sendString(socket, keys[i], moreData || i != nkeys - 1);
+  }
+}
+
+std::vector<std::string> recvKeys(int socket) {
+  auto nkeys = tcputil::recvValue<SizeType>(socket);
+  std::vector<std::string> keys(nkeys);
+  for (auto& key : keys) {
+    key = tcputil::recvString(socket);
+  }
+  return keys;
+}
+
+void setReceiveTimeout(int socket, const std::chrono::milliseconds& timeout) {
+  // Store::kNoTimeout is zero, which doesn't time out.
+  struct timeval timeoutTV = {
+      static_cast<time_t>(timeout.count() / 1000),
+      static_cast<suseconds_t>((timeout.count() % 1000) * 1000)};
+  SYSCHECK_ERR_RETURN_NEG1(::setsockopt(
+      socket,
+      SOL_SOCKET,
+      SO_RCVTIMEO,
+      reinterpret_cast<char*>(&timeoutTV),
+      sizeof(timeoutTV)));
+}
+
+void checkWaitResponse(int socket) {
+  auto waitResponse = tcputil::recvValue<WaitResponseType>(socket);
+  if (waitResponse != WaitResponseType::STOP_WAITING) {
+    throw std::runtime_error("Stop_waiting response is expected");
+  }
+}
+
+} // anonymous namespace
+
+namespace detail {
+
+// A connection accepted by a StoreServer. Its socket is closed once nothing
+// refers to the connection, so a waiter that still holds it never responds
+// on a socket that has been reused for another connection.
+struct Connection {
+  explicit Connection(int socket) : socket(socket) {}
+
+  ~Connection() {
+    ::close(socket);
+  }
+
+  const int socket;
+  // Waiters respond from the thread that sets the last key they await.
+  std::mutex sendMutex;
+};
+
+// A response, serialized as tcputil would send its parts, so that it is sent
+// at once by any thread.
+class Response {
+ public:
+  template <typename T>
+  Response& value(const T& value) {
+    auto bytes = reinterpret_cast<const uint8_t*>(&value);
+    buffer_.insert(buffer_.end(), bytes, bytes + sizeof(T));
+    return *this;
+  }
+
+  Response& vector(const std::vector<uint8_t>& vec) {
+    value<SizeType>(vec.size());
+    buffer_.insert(buffer_.end(), vec.begin(), vec.end());
+    return *this;
+  }
+
+  Response& string(const std::string& str) {
+    value<SizeType>(str.size());
+    buffer_.insert(buffer_.end(), str.begin(), str.end());
+    return *this;
+  }
+
+  // Unlike tcputil, doesn't raise SIGPIPE if the client has gone away.
+  void send(Connection& conn) const {
+    std::lock_guard<std::mutex> lock(conn.sendMutex);
+    size_t bytesSent = 0;
+    while (bytesSent < buffer_.size()) {
+      ssize_t n;
+      SYSCHECK_ERR_RETURN_NEG1(
+          n = ::send(
+              conn.socket,
+              buffer_.data() + bytesSent,
+              buffer_.size() - bytesSent,
+              MSG_NOSIGNAL));
+      bytesSent += n;
+    }
+  }
+
+  // For waiters, whose clients may have timed out and gone away.
+  void sendIfConnected(Connection& conn) const {
+    try {
+      send(conn);
+    } catch (const std::exception&) {
+    }
+  }
+
+ private:
+  std::vector<uint8_t> buffer_;
+};
+
+std::function<void()> stopWaiting(const std::shared_ptr<Connection>& conn) {
+  return [conn]() {
+    Response().value(WaitResponseType::STOP_WAITING).sendIfConnected(*conn);
+  };
+}
+
+// Calls release once all keys awaited are set.
+class Waiter {
+ public:
+  Waiter(size_t count, std::function<void()> release)
+      : remaining_(count), release_(std::move(release)) {}
+
+  void arrive() {
+    if (--remaining_ == 0) {
+      release_();
+    }
+  }
+
+ private:
+  std::atomic<size_t> remaining_;
+  std::function<void()> release_;
+};
+
+// The keys of a store, in shards with a lock each. Waiters are released by
+// the thread that sets the last key they await, outside of the locks.
+class KeyTable {
+ public:
+  explicit KeyTable(int numShards)
+      : shards_(static_cast<size_t>(std::max(numShards, 1))) {}
+
+  void set(const std::string& key, std::vector<uint8_t> value) {
+    auto& shard = shardFor(key);
+    std::vector<std::shared_ptr<Waiter>> waiters;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      waiters = setLocked(shard, key, std::move(value));
+    }
+    release(waiters);
+  }
+
+  // Returns false if key isn't set.
+  bool get(const std::string& key, std::vector<uint8_t>* value) {
+    auto& shard = shardFor(key);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.values.find(key);
+    if (it == shard.values.end()) {
+      return false;
+    }
+    *value = it->second;
+    return true;
+  }
+
+  int64_t add(const std::string& key, int64_t value) {
+    auto& shard = shardFor(key);
+    std::vector<std::shared_ptr<Waiter>> waiters;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.values.find(key);
+      if (it != shard.values.end()) {
+        auto buf = reinterpret_cast<const char*>(it->second.data());
+        value += std::stoll(std::string(buf, it->second.size()));
+      }
+      auto valueStr = std::to_string(value);
+      waiters = setLocked(
+          shard, key, std::vector<uint8_t>(valueStr.begin(), valueStr.end()));
+    }
+    release(waiters);
+    return value;
+  }
+
+  std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expected,
+      std::vector<uint8_t> desired) {
+    auto& shard = shardFor(key);
+    std::vector<std::shared_ptr<Waiter>> waiters;
+    std::vector<uint8_t> result;
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto it = shard.values.find(key);
+      if (it == shard.values.end() ? expected.empty()
+                                   : it->second == expected) {
+        result = desired;
+        waiters = setLocked(shard, key, std::move(desired));
+      } else if (it != shard.values.end()) {
+        result = it->second;
+      }
+    }
+    release(waiters);
+    return result;
+  }
+
+  bool check(const std::vector<std::string>& keys) {
+    return std::all_of(
+        keys.begin(), keys.end(), [this](const std::string& key) {
+          auto& shard = shardFor(key);
+          std::lock_guard<std::mutex> lock(shard.mutex);
+          return shard.values.count(key) > 0;
+        });
+  }
+
+  // Calls release once all keys are set, from this thread if they are.
+  void wait(
+      const std::vector<std::string>& keys,
+      std::function<void()> release) {
+    // The waiter awaits one more arrival than there are keys, which is only
+    // made once it awaits every key that isn't set.
+    auto waiter = std::make_shared<Waiter>(keys.size() + 1, std::move(release));
+    for (const auto& key : keys) {
+      auto& shard = shardFor(key);
+      bool isSet;
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        isSet = shard.values.count(key) > 0;
+        if (!isSet) {
+          shard.waiters[key].push_back(waiter);
+        }
+      }
+      if (isSet) {
+        waiter->arrive();
+      }
+    }
+    waiter->arrive();
+  }
+
+ private:
+  struct Shard {
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<uint8_t>> values;
+    std::unordered_map<std::string, std::vector<std::shared_ptr<Waiter>>>
+        waiters;
+  };
+
+  Shard& shardFor(const std::string& key) {
+    return shards_[std::hash<std::string>()(key) % shards_.size()];
+  }
+
+  // Must be called with the lock of shard held. Returns the waiters of key,
+  // which should be released once the lock is.
+  static std::vector<std::shared_ptr<Waiter>> setLocked(
+      Shard& shard,
+      const std::string& key,
+      std::vector<uint8_t> value) {
+    shard.values[key] = std::move(value);
+    std::vector<std::shared_ptr<Waiter>> waiters;
+    auto it = shard.waiters.find(key);
+    if (it != shard.waiters.end()) {
+      waiters.swap(it->second);
+      shard.waiters.erase(it);
+    }
+    return waiters;
+  }
+
+  static void release(const std::vector<std::shared_ptr<Waiter>>& waiters) {
+    for (const auto& waiter : waiters) {
+      waiter->arrive();
+    }
+  }
+
+  std::vector<Shard> shards_;
+};
+
+// Accepts connections on one thread and hands them out round robin to
+// numThreads threads, each waiting for requests on its own epoll instance.
+class StoreServer {
+ public:
+  StoreServer(int listenSocket, int numThreads);
+
+  virtual ~StoreServer();
+
+ protected:
+  // Must be called by the constructor of the derived class, once query() can
+  // be called.
+  void start();
+
+  // Must be called by the destructor of the derived class, before query()
+  // can't be called any more.
+  void stop();
+
+  // Serves a request on the socket of conn, which is readable. Throws to
+  // close the connection.
+  virtual void query(const std::shared_ptr<Connection>& conn) = 0;
+
+ private:
+  struct Worker {
+    int epollFd = -1;
+    std::mutex mutex;
+    std::unordered_map<int, std::shared_ptr<Connection>> connections;
+    std::thread thread;
+  };
+
+  void acceptConnections();
+  void serveConnections(Worker& worker);
+
+  const int listenSocket_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::thread acceptThread_;
+  std::vector<int> controlPipeFd_{-1, -1};
+};
+
+StoreServer::StoreServer(int listenSocket, int numThreads)
+    : listenSocket_(listenSocket) {
+  // Closing the write end of the control pipe stops all threads.
+  if (pipe(controlPipeFd_.data()) == -1) {
+    throw std::runtime_error(
+        "Failed to create the control pipe to start the StoreServer");
+  }
+  for (int i = 0; i < std::max(numThreads, 1); i++) {
+    std::unique_ptr<Worker> worker(new Worker());
+    SYSCHECK_ERR_RETURN_NEG1(worker->epollFd = ::epoll_create1(EPOLL_CLOEXEC));
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = controlPipeFd_[0];
+    SYSCHECK_ERR_RETURN_NEG1(::epoll_ctl(
+        worker->epollFd, EPOLL_CTL_ADD, controlPipeFd_[0], &event));
+    workers_.push_back(std::move(worker));
+  }
+}
+
+StoreServer::~StoreServer() {
+  stop();
+  for (auto& worker : workers_) {
+    // Closes the connections nothing else refers to.
+    worker->connections.clear();
+    ::close(worker->epollFd);
+  }
+  for (auto fd : controlPipeFd_) {
+    if (fd != -1) {
+      ::close(fd);
+    }
+  }
+  ::close(listenSocket_);
+}
+
+void StoreServer::start() {
+  for (auto& worker : workers_) {
+    worker->thread =
+        std::thread(&StoreServer::serveConnections, this, std::ref(*worker));
+  }
+  acceptThread_ = std::thread(&StoreServer::acceptConnections, this);
+}
+
+void StoreServer::stop() {
+  if (controlPipeFd_[1] != -1) {
+    // close the write end of the pipe
+    ::close(controlPipeFd_[1]);
+    controlPipeFd_[1] = -1;
+  }
+  if (acceptThread_.joinable()) {
+    acceptThread_.join();
+  }
+  for (auto& worker : workers_) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+}
+
+void StoreServer::acceptConnections() {
+  struct pollfd fds[2] = {{listenSocket_, POLLIN, 0},
+                          {controlPipeFd_[0], POLLIN, 0}};
+  size_t next = 0;
+  while (true) {
+    SYSCHECK_ERR_RETURN_NEG1(::poll(fds, 2, -1));
+    // The control pipe is closed
+    if (fds[1].revents != 0) {
+      return;
+    }
+    if (fds[0].revents == 0) {
+      continue;
+    }
+    int socket;
+    try {
+      socket = std::get<0>(tcputil::accept(listenSocket_));
+    } catch (const std::exception&) {
+      // The connection was aborted before it was accepted.
+      continue;
+    }
+    auto& worker = *workers_[next++ % workers_.size()];
+    {
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      worker.connections[socket] = std::make_shared<Connection>(socket);
+    }
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = socket;
+    SYSCHECK_ERR_RETURN_NEG1(
+        ::epoll_ctl(worker.epollFd, EPOLL_CTL_ADD, socket, &event));
+  }
+}
+
+void StoreServer::serveConnections(Worker& worker) {
+  struct epoll_event events[kMaxEvents];
+  while (true) {
+    int numEvents;
+    SYSCHECK_ERR_RETURN_NEG1(
+        numEvents = ::epoll_wait(worker.epollFd, events, kMaxEvents, -1));
+    for (int i = 0; i < numEvents; i++) {
+      const int fd = events[i].data.fd;
+      // The control pipe is closed
+      if (fd == controlPipeFd_[0]) {
+        return;
+      }
+      std::shared_ptr<Connection> conn;
+      {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        auto it = worker.connections.find(fd);
+        if (it == worker.connections.end()) {
+          continue;
+        }
+        conn = it->second;
+      }
+      try {
+        query(conn);
+      } catch (...) {
+        // As in TCPStoreDaemon, an error while serving a request most likely
+        // means the client has closed the connection, and other clients
+        // carry on.
+        ::epoll_ctl(worker.epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.connections.erase(fd);
+      }
+    }
+  }
+}
+
+// The ShardedTCPStore server.
+class MasterServer : public StoreServer {
+ public:
+  MasterServer(int listenSocket, const ShardedTCPStore::Options& options)
+      : StoreServer(listenSocket, options.numThreads),
+        table_(options.numShards) {
+    start();
+  }
+
+  ~MasterServer() override {
+    stop();
+  }
+
+ protected:
+  void query(const std::shared_ptr<Connection>& conn) override;
+
+  void barrierArrive(const std::string& key, int64_t worldSize);
+
+  KeyTable table_;
+};
+
+void MasterServer::barrierArrive(const std::string& key, int64_t worldSize) {
+  if (table_.add(barrierCountKey(key), 1) == worldSize) {
+    table_.set(barrierDoneKey(key), {});
+  }
+}
+
+void MasterServer::query(const std::shared_ptr<Connection>& conn) {
+  const int socket = conn->socket;
+  auto qt = tcputil::recvValue<QueryType>(socket);
+  switch (qt) {
+    case QueryType::SET: {
+      auto key = tcputil::recvString(socket);
+      table_.set(key, tcputil::recvVector<uint8_t>(socket));
+      break;
+    }
+    case QueryType::MULTI_SET: {
+      auto keys = recvKeys(socket);
+      std::vector<std::vector<uint8_t>> values(keys.size());
+      for (auto& value : values) {
+        value = tcputil::recvVector<uint8_t>(socket);
+      }
+      for (size_t i = 0; i < keys.size(); i++) {
+        table_.set(keys[i], std::move(values[i]));
+      }
+      break;
+    }
+    case QueryType::GET:
+    case QueryType::MULTI_GET: {
+      auto keys = qt == QueryType::GET
+          ? std::vector<std::string>{tcputil::recvString(socket)}
+          : recvKeys(socket);
+      // Gets wait on the server rather than on a WAIT query first.
+      table_.wait(keys, [this, conn, keys]() {
+        Response response;
+        for (const auto& key : keys) {
+          std::vector<uint8_t> value;
+          table_.get(key, &value);
+          response.vector(value);
+        }
+        response.sendIfConnected(*conn);
+      });
+      break;
+    }
+    case QueryType::ADD: {
+      auto key = tcputil::recvString(socket);
+      auto value = tcputil::recvValue<int64_t>(socket);
+      Response().value<int64_t>(table_.add(key, value)).send(*conn);
+      break;
+    }
+    case QueryType::CHECK: {
+      auto ready = table_.check(recvKeys(socket));
+      Response()
+          .value(
+              ready ? CheckResponseType::READY : CheckResponseType::NOT_READY)
+          .send(*conn);
+      break;
+    }
+    case QueryType::WAIT: {
+      table_.wait(recvKeys(socket), stopWaiting(conn));
+      break;
+    }
+    case QueryType::COMPARE_SET: {
+      auto key = tcputil::recvString(socket);
+      auto expected = tcputil::recvVector<uint8_t>(socket);
+      auto desired = tcputil::recvVector<uint8_t>(socket);
+      Response()
+          .vector(table_.compareSet(key, expected, std::move(desired)))
+          .send(*conn);
+      break;
+    }
+    case QueryType::BARRIER: {
+      auto key = tcputil::recvString(socket);
+      auto worldSize = tcputil::recvValue<int64_t>(socket);
+      barrierArrive(key, worldSize);
+      table_.wait({barrierDoneKey(key)}, stopWaiting(conn));
+      break;
+    }
+    case QueryType::BARRIER_ARRIVE: {
+      auto key = tcputil::recvString(socket);
+      barrierArrive(key, tcputil::recvValue<int64_t>(socket));
+      break;
+    }
+    case QueryType::WATCH: {
+      // Responds with the key once it is set.
+      auto key = tcputil::recvString(socket);
+      table_.wait({key}, [conn, key]() {
+        Response().string(key).sendIfConnected(*conn);
+      });
+      break;
+    }
+    default:
+      throw std::runtime_error("Unexpected query type");
+  }
+}
+
+// A connection to a ShardedTCPStore server, or to a proxy. Any error closes
+// the socket and the next request opens a new one, so that the response to a
+// request that has timed out never reaches a later request.
+class StoreClient {
+ public:
+  StoreClient(
+      const std::string& addr,
+      PortType port,
+      const std::chrono::milliseconds& timeout)
+      : addr_(addr), port_(port), timeout_(timeout) {
+    connect();
+  }
+
+  ~StoreClient() {
+    if (socket_ != -1) {
+      ::close(socket_);
+    }
+  }
+
+  void set(const std::string& key, const std::vector<uint8_t>& value) {
+    request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::SET, true);
+      tcputil::sendString(socket, key, true);
+      tcputil::sendVector<uint8_t>(socket, value);
+    });
+  }
+
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values) {
+    request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::MULTI_SET, true);
+      sendKeys(socket, keys, !values.empty());
+      for (size_t i = 0; i < values.size(); i++) {
+        tcputil::sendVector<uint8_t>(socket, values[i], i != values.size() - 1);
+      }
+    });
+  }
+
+  std::vector<uint8_t> get(
+      const std::string& key,
+      const std::chrono::milliseconds& timeout) {
+    return request(timeout, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::GET, true);
+      tcputil::sendString(socket, key);
+      return tcputil::recvVector<uint8_t>(socket);
+    });
+  }
+
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys,
+      const std::chrono::milliseconds& timeout) {
+    return request(timeout, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::MULTI_GET, true);
+      sendKeys(socket, keys);
+      std::vector<std::vector<uint8_t>> values(keys.size());
+      for (auto& value : values) {
+        value = tcputil::recvVector<uint8_t>(socket);
+      }
+      return values;
+    });
+  }
+
+  int64_t add(const std::string& key, int64_t value) {
+    return request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::ADD, true);
+      tcputil::sendString(socket, key, true);
+      tcputil::sendValue<int64_t>(socket, value);
+      return tcputil::recvValue<int64_t>(socket);
+    });
+  }
+
+  bool check(const std::vector<std::string>& keys) {
+    return request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::CHECK, true);
+      sendKeys(socket, keys);
+      auto checkResponse = tcputil::recvValue<CheckResponseType>(socket);
+      if (checkResponse == CheckResponseType::READY) {
+        return true;
+      } else if (checkResponse == CheckResponseType::NOT_READY) {
+        return false;
+      } else {
+        throw std::runtime_error("ready or not_ready response expected");
+      }
+    });
+  }
+
+  void wait(
+      const std::vector<std::string>& keys,
+      const std::chrono::milliseconds& timeout) {
+    request(timeout, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::WAIT, true);
+      sendKeys(socket, keys);
+      checkWaitResponse(socket);
+    });
+  }
+
+  std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expected,
+      const std::vector<uint8_t>& desired) {
+    return request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::COMPARE_SET, true);
+      tcputil::sendString(socket, key, true);
+      tcputil::sendVector<uint8_t>(socket, expected, true);
+      tcputil::sendVector<uint8_t>(socket, desired);
+      return tcputil::recvVector<uint8_t>(socket);
+    });
+  }
+
+  void barrier(
+      const std::string& key,
+      int64_t worldSize,
+      const std::chrono::milliseconds& timeout) {
+    request(timeout, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::BARRIER, true);
+      tcputil::sendString(socket, key, true);
+      tcputil::sendValue<int64_t>(socket, worldSize);
+      checkWaitResponse(socket);
+    });
+  }
+
+  // Enters a barrier without waiting for the others.
+  void barrierArrive(const std::string& key, int64_t worldSize) {
+    request(timeout_, [&](int socket) {
+      tcputil::sendValue<QueryType>(socket, QueryType::BARRIER_ARRIVE, true);
+      tcputil::sendString(socket, key, true);
+      tcputil::sendValue<int64_t>(socket, worldSize);
+    });
+  }
+
+ private:
+  void connect() {
+    socket_ = tcputil::connect(addr_, port_, /* wait= */ true, timeout_);
+    receiveTimeout_ = Store::kNoTimeout;
+  }
+
+  template <typename F>
+  auto request(const std::chrono::milliseconds& timeout, const F& f)
+      -> decltype(f(0)) {
+    if (socket_ == -1) {
+      connect();
+    }
+    try {
+      if (timeout != receiveTimeout_) {
+        setReceiveTimeout(socket_, timeout);
+        receiveTimeout_ = timeout;
+      }
+      return f(socket_);
+    } catch (...) {
+      ::close(socket_);
+      socket_ = -1;
+      throw;
+    }
+  }
+
+  const std::string addr_;
+  const PortType port_;
+  const std::chrono::milliseconds timeout_;
+  int socket_ = -1;
+  std::chrono::milliseconds receiveTimeout_;
+};
+
+// The ShardedTCPStoreProxy server. Keys known to be set are kept, without
+// their values, in a KeyTable of its own, whose waiters are the requests
+// awaiting keys.
+class ProxyServer : public StoreServer {
+ public:
+  ProxyServer(
+      int listenSocket,
+      const std::string& masterAddr,
+      PortType masterPort,
+      const ShardedTCPStore::Options& options)
+      : StoreServer(listenSocket, options.numThreads),
+        masterAddr_(masterAddr),
+        masterPort_(masterPort),
+        timeout_(options.timeout),
+        present_(options.numShards) {
+    watchSocket_ = tcputil::connect(
+        masterAddr_, masterPort_, /* wait= */ true, timeout_);
+    watchThread_ = std::thread(&ProxyServer::receiveWatched, this);
+    start();
+  }
+
+  ~ProxyServer() override {
+    stop();
+    // Wakes up the watch thread.
+    ::shutdown(watchSocket_, SHUT_RDWR);
+    watchThread_.join();
+    ::close(watchSocket_);
+  }
+
+ protected:
+  void query(const std::shared_ptr<Connection>& conn) override;
+
+  // The client of this thread, which is never used by two threads.
+  StoreClient& upstream();
+
+  // Calls release once all keys are set, watching those that aren't
+  // watched yet.
+  void awaitKeys(
+      const std::vector<std::string>& keys,
+      std::function<void()> release);
+
+  void receiveWatched();
+
+  const std::string masterAddr_;
+  const PortType masterPort_;
+  const std::chrono::milliseconds timeout_;
+
+  KeyTable present_;
+
+  std::mutex upstreamMutex_;
+  std::unordered_map<std::thread::id, std::unique_ptr<StoreClient>> upstreams_;
+
+  // The server responds to WATCH queries on this socket with keys as they
+  // are set, which watchThread_ receives.
+  int watchSocket_ = -1;
+  std::mutex watchMutex_;
+  std::unordered_set<std::string> watched_;
+  std::thread watchThread_;
+};
+
+StoreClient& ProxyServer::upstream() {
+  std::lock_guard<std::mutex> lock(upstreamMutex_);
+  auto& client = upstreams_[std::this_thread::get_id()];
+  if (!client) {
+    client.reset(new StoreClient(masterAddr_, masterPort_, timeout_));
+  }
+  return *client;
+}
+
+void ProxyServer::awaitKeys(
+    const std::vector<std::string>& keys,
+    std::function<void()> release) {
+  {
+    std::lock_guard<std::mutex> lock(watchMutex_);
+    for (const auto& key : keys) {
+      if (watched_.count(key) > 0 || present_.check({key})) {
+        continue;
+      }
+      tcputil::sendValue<QueryType>(watchSocket_, QueryType::WATCH, true);
+      tcputil::sendString(watchSocket_, key);
+      watched_.insert(key);
+    }
+  }
+  present_.wait(keys, std::move(release));
+}
+
+void ProxyServer::receiveWatched() {
+  try {
+    while (true) {
+      present_.set(tcputil::recvString(watchSocket_), {});
+    }
+  } catch (const std::exception&) {
+    // The proxy is shutting down, or the server has gone away.
+  }
+}
+
+void ProxyServer::query(const std::shared_ptr<Connection>& conn) {
+  const int socket = conn->socket;
+  auto qt = tcputil::recvValue<QueryType>(socket);
+  switch (qt) {
+    case QueryType::SET: {
+      auto key = tcputil::recvString(socket);
+      upstream().set(key, tcputil::recvVector<uint8_t>(socket));
+      break;
+    }
+    case QueryType::MULTI_SET: {
+      auto keys = recvKeys(socket);
+      std::vector<std::vector<uint8_t>> values(keys.size());
+      for (auto& value : values) {
+        value = tcputil::recvVector<uint8_t>(socket);
+      }
+      upstream().multiSet(keys, values);
+      break;
+    }
+    case QueryType::GET:
+    case QueryType::MULTI_GET: {
+      auto keys = qt == QueryType::GET
+          ? std::vector<std::string>{tcputil::recvString(socket)}
+          : recvKeys(socket);
+      // The keys are set by the time they are fetched, so the server
+      // responds right away.
+      awaitKeys(keys, [this, conn, keys]() {
+        try {
+          Response response;
+          for (const auto& value : upstream().multiGet(keys, timeout_)) {
+            response.vector(value);
+          }
+          response.send(*conn);
+        } catch (const std::exception&) {
+        }
+      });
+      break;
+    }
+    case QueryType::ADD: {
+      auto key = tcputil::recvString(socket);
+      auto value = tcputil::recvValue<int64_t>(socket);
+      Response().value<int64_t>(upstream().add(key, value)).send(*conn);
+      break;
+    }
+    case QueryType::CHECK: {
+      auto keys = recvKeys(socket);
+      auto ready = present_.check(keys);
+      if (!ready && upstream().check(keys)) {
+        ready = true;
+        for (const auto& key : keys) {
+          present_.set(key, {});
+        }
+      }
+      Response()
+          .value(
+              ready ? CheckResponseType::READY : CheckResponseType::NOT_READY)
+          .send(*conn);
+      break;
+    }
+    case QueryType::WAIT: {
+      awaitKeys(recvKeys(socket), stopWaiting(conn));
+      break;
+    }
+    case QueryType::COMPARE_SET: {
+      auto key = tcputil::recvString(socket);
+      auto expected = tcputil::recvVector<uint8_t>(socket);
+      auto desired = tcputil::recvVector<uint8_t>(socket);
+      Response()
+          .vector(upstream().compareSet(key, expected, desired))
+          .send(*conn);
+      break;
+    }
+    case QueryType::BARRIER: {
+      auto key = tcputil::recvString(socket);
+      upstream().barrierArrive(key, tcputil::recvValue<int64_t>(socket));
+      awaitKeys({barrierDoneKey(key)}, stopWaiting(conn));
+      break;
+    }
+    case QueryType::BARRIER_ARRIVE: {
+      auto key = tcputil::recvString(socket);
+      upstream().barrierArrive(key, tcputil::recvValue<int64_t>(socket));
+      break;
+    }
+    case QueryType::WATCH: {
+      // Lets proxies serve other proxies.
+      auto key = tcputil::recvString(socket);
+      awaitKeys({key}, [conn, key]() {
+        Response().string(key).sendIfConnected(*conn);
+      });
+      break;
+    }
+    default:
+      throw std::runtime_error("Unexpected query type");
+  }
+}
+
+} // namespace detail
+
+// ShardedTCPStore class methods
+ShardedTCPStore::Options::Options()
+    : numThreads(4), numShards(64), timeout(kDefaultTimeout) {}
+
+ShardedTCPStore::ShardedTCPStore(
+    const std::string& masterAddr,
+    PortType masterPort,
+    int numWorkers,
+    bool isServer,
+    Options options)
+    : Store(options.timeout),
+      isServer_(isServer),
+      numWorkers_(numWorkers),
+      initKey_("init/"),
+      regularPrefix_("/") {
+  if (isServer_) {
+    int listenSocket;
+    std::tie(listenSocket, std::ignore) = tcputil::listen(masterPort);
+    server_.reset(new detail::MasterServer(listenSocket, options));
+  }
+  client_.reset(new detail::StoreClient(masterAddr, masterPort, timeout_));
+
+  waitForWorkers_();
+}
+
+ShardedTCPStore::~ShardedTCPStore() {
+  client_.reset();
+  server_.reset();
+}
+
+void ShardedTCPStore::waitForWorkers_() {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  client_->barrierArrive(initKey_, numWorkers_);
+  // As in TCPStore, let the server block until all workers have connected,
+  // so that it serves until the very end, but no longer than the timeout.
+  if (isServer_) {
+    try {
+      client_->wait({barrierDoneKey(initKey_)}, timeout_);
+    } catch (const std::runtime_error&) {
+    }
+  }
+}
+
+std::string ShardedTCPStore::regularKey(const std::string& key) const {
+  return regularPrefix_ + key;
+}
+
+std::vector<std::string> ShardedTCPStore::regularKeys(
+    const std::vector<std::string>& keys) const {
+  std::vector<std::string> regKeys(keys.size());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    regKeys[i] = regularKey(keys[i]);
+  }
+  return regKeys;
+}
+
+void ShardedTCPStore::set(
+    const std::string& key,
+    const std::vector<uint8_t>& value) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  client_->set(regularKey(key), value);
+}
+
+std::vector<uint8_t> ShardedTCPStore::get(const std::string& key) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  return client_->get(regularKey(key), timeout_);
+}
+
+int64_t ShardedTCPStore::add(const std::string& key, int64_t value) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  return client_->add(regularKey(key), value);
+}
+
+bool ShardedTCPStore::check(const std::vector<std::string>& keys) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  return client_->check(regularKeys(keys));
+}
+
+void ShardedTCPStore::wait(const std::vector<std::string>& keys) {
+  wait(keys, timeout_);
+}
+
+void ShardedTCPStore::wait(
+    const std::vector<std::string>& keys,
+    const std::chrono::milliseconds& timeout) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  client_->wait(regularKeys(keys), timeout);
+}
+
+void ShardedTCPStore::multiSet(
+    const std::vector<std::string>& keys,
+    const std::vector<std::vector<uint8_t>>& values) {
+  if (keys.size() != values.size()) {
+    throw std::invalid_argument(
+        "multiSet expects as many values as keys, got " +
+        std::to_string(values.size()) + " values for " +
+        std::to_string(keys.size()) + " keys");
+  }
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  client_->multiSet(regularKeys(keys), values);
+}
+
+std::vector<std::vector<uint8_t>> ShardedTCPStore::multiGet(
+    const std::vector<std::string>& keys) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  return client_->multiGet(regularKeys(keys), timeout_);
+}
+
+std::vector<uint8_t> ShardedTCPStore::compareSet(
+    const std::string& key,
+    const std::vector<uint8_t>& expected,
+    const std::vector<uint8_t>& desired) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  return client_->compareSet(regularKey(key), expected, desired);
+}
+
+void ShardedTCPStore::barrier(const std::string& key, int worldSize) {
+  barrier(key, worldSize, timeout_);
+}
+
+void ShardedTCPStore::barrier(
+    const std::string& key,
+    int worldSize,
+    const std::chrono::milliseconds& timeout) {
+  std::lock_guard<std::mutex> lock(clientMutex_);
+  client_->barrier(regularKey(key), worldSize, timeout);
+}
+
+// ShardedTCPStoreProxy class methods
+ShardedTCPStoreProxy::ShardedTCPStoreProxy(
+    const std::string& masterAddr,
+    PortType masterPort,
+    PortType port,
+    ShardedTCPStore::Options options) {
+  int listenSocket;
+  std::tie(listenSocket, port_) = tcputil::listen(port);
+  server_.reset(
+      new detail::ProxyServer(listenSocket, masterAddr, masterPort, options));
+}
+
+ShardedTCPStoreProxy::~ShardedTCPStoreProxy() {}
+
+PortType ShardedTCPStoreProxy::port() const {
+  return port_;
+}
+
+} // namespace c10d
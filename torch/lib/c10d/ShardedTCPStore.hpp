@@ -0,0 +1,138 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <c10d/Store.hpp>
+#include <c10d/Utils.hpp>
+
+namespace c10d {
+
+namespace detail {
+class StoreClient;
+class StoreServer;
+} // namespace detail
+
+// A TCP store for jobs with many ranks.
+//
+// Like TCPStore, the process created with isServer = true runs the server
+// and every process connects to it. Unlike TCPStoreDaemon, the server
+// serves its connections from several threads, each waiting on its own epoll
+// instance, and keeps the keys in shards with a lock each, so neither the
+// number of connections nor the load of the other ranks slows a request down.
+// A get() waits on the server and takes a single round trip.
+//
+// On top of the Store interface it has batched multiGet() and multiSet(), an
+// atomic compareSet() and a barrier(), all served by the server in a single
+// request. With a ShardedTCPStoreProxy on every node, the processes of a
+// node connect to the proxy instead of the server, so that the server only
+// sees a handful of connections per node and every key awaited on a node is
+// awaited on the server once.
+class ShardedTCPStore : public Store {
+ public:
+  struct Options {
+    explicit Options();
+
+    // Threads serving the connections of the server, or of a proxy.
+    int numThreads;
+    // Shards of the keys of the server, each with its own lock.
+    int numShards;
+    std::chrono::milliseconds timeout;
+  };
+
+  explicit ShardedTCPStore(
+      const std::string& masterAddr,
+      PortType masterPort,
+      int numWorkers,
+      bool isServer = false,
+      Options options = Options());
+
+  virtual ~ShardedTCPStore();
+
+  void set(const std::string& key, const std::vector<uint8_t>& value) override;
+
+  std::vector<uint8_t> get(const std::string& key) override;
+
+  int64_t add(const std::string& key, int64_t value) override;
+
+  bool check(const std::vector<std::string>& keys) override;
+
+  void wait(const std::vector<std::string>& keys) override;
+
+  void wait(
+      const std::vector<std::string>& keys,
+      const std::chrono::milliseconds& timeout) override;
+
+  // Sets all keys in a single request.
+  void multiSet(
+      const std::vector<std::string>& keys,
+      const std::vector<std::vector<uint8_t>>& values);
+
+  // Waits for all keys and returns their values, in a single request.
+  std::vector<std::vector<uint8_t>> multiGet(
+      const std::vector<std::string>& keys);
+
+  // Atomically sets key to desired if its value is expected, or if it isn't
+  // set and expected is empty. Returns the value of key after the call,
+  // which is empty if it isn't set.
+  std::vector<uint8_t> compareSet(
+      const std::string& key,
+      const std::vector<uint8_t>& expected,
+      const std::vector<uint8_t>& desired);
+
+  // Returns once worldSize processes have called barrier() with key. Every
+  // key makes a barrier that can be passed once.
+  void barrier(const std::string& key, int worldSize);
+
+  void barrier(
+      const std::string& key,
+      int worldSize,
+      const std::chrono::milliseconds& timeout);
+
+ protected:
+  std::string regularKey(const std::string& key) const;
+  std::vector<std::string> regularKeys(
+      const std::vector<std::string>& keys) const;
+  void waitForWorkers_();
+
+  bool isServer_;
+  int numWorkers_;
+  const std::string initKey_;
+  const std::string regularPrefix_;
+
+  std::unique_ptr<detail::StoreServer> server_;
+  // Requests wait for their response, so they are sent one at a time.
+  std::mutex clientMutex_;
+  std::unique_ptr<detail::StoreClient> client_;
+};
+
+// Serves the ShardedTCPStore of a ShardedTCPStore server to the processes of
+// a node, which connect to it as they would to the server.
+//
+// Keys are only added to a store, never removed, so once the proxy knows a
+// key is set, it answers checks, waits and barriers without the server.
+// Gets, checks and waits for keys the proxy hasn't seen are awaited on the
+// server once for the whole node, over a single connection on which the
+// server reports keys as they are set. Everything else is forwarded to the
+// server.
+class ShardedTCPStoreProxy {
+ public:
+  explicit ShardedTCPStoreProxy(
+      const std::string& masterAddr,
+      PortType masterPort,
+      PortType port,
+      ShardedTCPStore::Options options = ShardedTCPStore::Options());
+
+  ~ShardedTCPStoreProxy();
+
+  // The port the proxy listens on, which is useful for port 0.
+  PortType port() const;
+
+ protected:
+  PortType port_;
+  std::unique_ptr<detail::StoreServer> server_;
+};
+
+} // namespace c10d
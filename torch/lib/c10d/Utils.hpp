@@ -317,6 +317,56 @@ std::vector<T*> getDataPointers(const std::vector<at::Tensor>& tensors) {
   return ptrs;
 }
 
+// Checks that splitSizes splits the first dimension of tensor across
+// groupSize ranks. Empty split sizes split it evenly.
+inline void checkSplitSizes(
+    const std::vector<int64_t>& splitSizes,
+    const at::Tensor& tensor,
+    int groupSize) {
+  if (splitSizes.size() == 0) {
+    if (tensor.dim() == 0 || tensor.size(0) % groupSize != 0) {
+      throw std::runtime_error(
+          "Tensor's dim 0 does not divide equally across group size");
+    }
+    return;
+  }
+  if (splitSizes.size() != static_cast<size_t>(groupSize)) {
+    throw std::runtime_error("Number of tensor splits not equal to group size");
+  }
+  int64_t sum = 0;
+  for (auto size : splitSizes) {
+    if (size < 0) {
+      throw std::runtime_error("Split sizes must not be negative");
+    }
+    sum += size;
+  }
+  if (sum != tensor.size(0)) {
+    throw std::runtime_error("Split sizes doesn't match total dim 0 size");
+  }
+}
+
+// Computes, in elements, the length and the offset in tensor of every split
+// of its first dimension, as checked by checkSplitSizes().
+template <typename T>
+inline void computeLengthsAndOffsets(
+    const std::vector<int64_t>& splitSizes,
+    const at::Tensor& tensor,
+    std::vector<T>* lengths,
+    std::vector<T>* offsets) {
+  const size_t groupSize = lengths->size();
+  const int64_t dim0 = tensor.dim() == 0 ? 1 : tensor.size(0);
+  const int64_t rowSize = dim0 == 0 ? 0 : tensor.numel() / dim0;
+  T offset = 0;
+  for (size_t i = 0; i < groupSize; i++) {
+    const int64_t rows = splitSizes.size() == 0
+        ? dim0 / static_cast<int64_t>(groupSize)
+        : splitSizes[i];
+    (*lengths)[i] = static_cast<T>(rows * rowSize);
+    (*offsets)[i] = offset;
+    offset += (*lengths)[i];
+  }
+}
+
 using RankType = uint32_t;
 using PortType = uint16_t;
 using SizeType = uint64_t;
@@ -0,0 +1,139 @@
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include <c10d/CollectiveTrace.hpp>
+
+namespace {
+
+c10d::CollectiveTraceEntry makeEntry(
+    uint64_t seq,
+    const std::string& opType,
+    int64_t enqueueMicros,
+    int64_t startMicros,
+    int64_t endMicros) {
+  c10d::CollectiveTraceEntry entry;
+  entry.seq = seq;
+  entry.opType = opType;
+  entry.dtype = "Float";
+  entry.inputSizes = {2, 3};
+  entry.outputSizes = {2, 3};
+  entry.enqueueMicros = enqueueMicros;
+  entry.startMicros = startMicros;
+  entry.endMicros = endMicros;
+  return entry;
+}
+
+void checkContains(const std::string& str, const std::string& expected) {
+  if (str.find(expected) == std::string::npos) {
+    throw std::runtime_error(
+        "Expected \"" + expected + "\" in \"" + str + "\"");
+  }
+}
+
+void checkNotContains(const std::string& str, const std::string& unexpected) {
+  if (str.find(unexpected) != std::string::npos) {
+    throw std::runtime_error(
+        "Didn't expect \"" + unexpected + "\" in \"" + str + "\"");
+  }
+}
+
+} // namespace
+
+void testSerialization() {
+  std::vector<c10d::CollectiveTraceEntry> trace = {
+      makeEntry(0, "ALLREDUCE", 100, 110, 150),
+      makeEntry(1, "BROADCAST", 200, -1, -1),
+  };
+  trace[1].inputSizes.clear();
+
+  const auto parsed =
+      c10d::parseCollectiveTrace(c10d::serializeCollectiveTrace(trace));
+  if (parsed.size() != trace.size()) {
+    throw std::runtime_error("Expected every entry to be parsed");
+  }
+  for (size_t i = 0; i < trace.size(); i++) {
+    if (parsed[i].seq != trace[i].seq ||
+        parsed[i].opType != trace[i].opType ||
+        parsed[i].dtype != trace[i].dtype ||
+        parsed[i].inputSizes != trace[i].inputSizes ||
+        parsed[i].outputSizes != trace[i].outputSizes ||
+        parsed[i].enqueueMicros != trace[i].enqueueMicros ||
+        parsed[i].startMicros != trace[i].startMicros ||
+        parsed[i].endMicros != trace[i].endMicros) {
+      throw std::runtime_error("Parsed entry differs from serialized one");
+    }
+  }
+
+  bool threw = false;
+  try {
+    c10d::parseCollectiveTrace("0 ALLREDUCE Float\n");
+  } catch (const std::runtime_error&) {
+    threw = true;
+  }
+  if (!threw) {
+    throw std::runtime_error("Expected malformed trace to throw");
+  }
+
+  const auto formatted = c10d::formatCollectiveTrace(trace);
+  checkContains(formatted, "#0 ALLREDUCE Float in 2x3 out 2x3");
+  checkContains(formatted, "ran 40 us");
+  checkContains(formatted, "#1 BROADCAST Float in - out 2x3");
+  checkContains(formatted, "not started");
+}
+
+void testStragglers() {
+  // Rank 2 enters every collective 30 us after the others, so they wait for
+  // it and run 30 us longer.
+  std::vector<std::vector<c10d::CollectiveTraceEntry>> traces(3);
+  for (uint64_t seq = 0; seq < 4; seq++) {
+    const int64_t base = seq * 1000;
+    traces[0].push_back(makeEntry(seq, "ALLREDUCE", base, base, base + 80));
+    traces[1].push_back(makeEntry(seq, "ALLREDUCE", base, base, base + 80));
+    traces[2].push_back(
+        makeEntry(seq, "ALLREDUCE", base + 30, base + 30, base + 80));
+  }
+  const auto report = c10d::compareCollectiveTraces(traces);
+  checkContains(
+      report,
+      "Rank 2 entered 4 collectives on average 30 us after the first rank");
+  checkNotContains(report, "Rank 0");
+  checkNotContains(report, "Rank 1");
+}
+
+void testEnqueueTimes() {
+  // Without GPU times the enqueue times are compared.
+  std::vector<std::vector<c10d::CollectiveTraceEntry>> traces(2);
+  traces[0].push_back(makeEntry(0, "ALLGATHER", 100, -1, -1));
+  traces[1].push_back(makeEntry(0, "ALLGATHER", 150, -1, -1));
+  checkContains(
+      c10d::compareCollectiveTraces(traces),
+      "Rank 1 entered 1 collectives on average 50 us after the first rank");
+}
+
+void testHangAndMismatch() {
+  std::vector<std::vector<c10d::CollectiveTraceEntry>> traces(4);
+  for (uint64_t seq = 0; seq < 3; seq++) {
+    traces[0].push_back(makeEntry(seq, "ALLREDUCE", 0, 0, 10));
+    traces[1].push_back(
+        makeEntry(seq, seq == 1 ? "BROADCAST" : "ALLREDUCE", 0, 0, 10));
+  }
+  // Rank 2 hasn't enqueued the last collective and rank 3 has no trace.
+  traces[2].push_back(makeEntry(0, "ALLREDUCE", 0, 0, 10));
+  traces[2].push_back(makeEntry(1, "ALLREDUCE", 0, 0, 10));
+  const auto report = c10d::compareCollectiveTraces(traces);
+  checkContains(report, "Ranks without a trace: 3");
+  checkContains(
+      report, "Ranks 2 last enqueued collective #1, the others enqueued up to #2");
+  checkContains(
+      report, "Collective #1 is ALLREDUCE on rank 0, but BROADCAST on rank 1");
+}
+
+int main(int argc, char** argv) {
+  testSerialization();
+  testStragglers();
+  testEnqueueTimes();
+  testHangAndMismatch();
+  std::cout << "Test succeeded" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -164,6 +164,20 @@ class AllreduceNCCLTest : public NCCLTest {
   }
 };
 
+class ConcurrentAllreduceNCCLTest : public AllreduceNCCLTest {
+ public:
+  ConcurrentAllreduceNCCLTest(const std::string& path, int worldSize)
+      : AllreduceNCCLTest(path, worldSize) {}
+
+  // Runs a second allreduce of the same tensors without waiting for the
+  // first, which runs on another communicator.
+  std::shared_ptr<c10d::ProcessGroup::Work> run() {
+    AllreduceNCCLTest::run();
+    at::cuda::CUDAMultiStreamGuard guard(streams_);
+    return pg_->allreduce(tensors_);
+  }
+};
+
 class BroadcastNCCLTest : public NCCLTest {
  public:
   BroadcastNCCLTest(const std::string& path, int worldSize)
@@ -299,6 +313,31 @@ void testAllreduce(const std::string& path, int rank, int size) {
   std::cout << "Allreduce test successful" << std::endl;
 }
 
+void testConcurrentAllreduce(const std::string& path, int rank, int size) {
+  setenv(c10d::NCCL_COMMS_PER_DEVICE, "2", 1);
+  auto test = ConcurrentAllreduceNCCLTest(path, size);
+  test.initialize(rank, size);
+  unsetenv(c10d::NCCL_COMMS_PER_DEVICE);
+  auto work = test.run();
+  // Wait for work to finish
+  test.wait(work);
+
+  // Validation
+  const int totalNumGPUs = test.numDevices() * size;
+  const auto expected = totalNumGPUs * (totalNumGPUs * (totalNumGPUs - 1)) / 2;
+  auto tensors = test.getTensors();
+  for (size_t j = 0; j < tensors.size(); j++) {
+    auto& tensor = tensors[j];
+    auto data = tensor.data_ptr<float>();
+    for (auto k = 0; k < tensor.numel(); k++) {
+      if (data[k] != expected) {
+        throw std::runtime_error("BOOM!");
+      }
+    }
+  }
+  std::cout << "Concurrent allreduce test successful" << std::endl;
+}
+
 void testBroadcast(const std::string& path, int rank, int size) {
   auto test = BroadcastNCCLTest(path, size);
   test.initialize(rank, size);
@@ -436,6 +475,7 @@ int main(int argc, char** argv) {
   TemporaryFile file;
 
   testAllreduce(file.path, rank, size);
+  testConcurrentAllreduce(file.path, rank, size);
   testBroadcast(file.path, rank, size);
   testReduce(file.path, rank, size);
   testAllgather(file.path, rank, size);
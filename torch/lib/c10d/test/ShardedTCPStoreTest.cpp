@@ -0,0 +1,224 @@
+#include <c10d/test/StoreTestCommon.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include <c10d/PrefixStore.hpp>
+#include <c10d/ShardedTCPStore.hpp>
+
+namespace {
+
+std::vector<uint8_t> toVec(const std::string& str) {
+  return std::vector<uint8_t>(str.begin(), str.end());
+}
+
+std::string toString(const std::vector<uint8_t>& vec) {
+  return std::string(vec.begin(), vec.end());
+}
+
+void checkEqual(const std::string& actual, const std::string& expected) {
+  if (actual != expected) {
+    throw std::runtime_error("Expected " + expected + ", got " + actual);
+  }
+}
+
+} // namespace
+
+void testHelper(const std::string& prefix = "") {
+  const auto numThreads = 16;
+  const auto numWorkers = numThreads + 1;
+  // The server store waits for all workers to connect
+  std::unique_ptr<c10d::ShardedTCPStore> serverTCPStore;
+  std::thread server([&serverTCPStore, numWorkers] {
+    serverTCPStore.reset(
+        new c10d::ShardedTCPStore("127.0.0.1", 29501, numWorkers, true));
+  });
+
+  // Hammer on ShardedTCPStore
+  std::vector<std::thread> threads;
+  const auto numIterations = 1000;
+  c10d::test::Semaphore sem1, sem2;
+
+  // Each thread will have a client store to send/recv data
+  std::vector<std::unique_ptr<c10d::ShardedTCPStore>> clientTCPStores;
+  std::vector<std::unique_ptr<c10d::PrefixStore>> clientStores;
+  for (auto i = 0; i < numThreads; i++) {
+    clientTCPStores.push_back(std::unique_ptr<c10d::ShardedTCPStore>(
+        new c10d::ShardedTCPStore("127.0.0.1", 29501, numWorkers, false)));
+    clientStores.push_back(std::unique_ptr<c10d::PrefixStore>(
+        new c10d::PrefixStore(prefix, *clientTCPStores[i])));
+  }
+  server.join();
+  c10d::PrefixStore serverStore(prefix, *serverTCPStore);
+
+  // Basic set/get on the server store
+  c10d::test::set(serverStore, "key0", "value0");
+  c10d::test::set(serverStore, "key1", "value1");
+  c10d::test::set(serverStore, "key2", "value2");
+  c10d::test::check(serverStore, "key0", "value0");
+  c10d::test::check(serverStore, "key1", "value1");
+  c10d::test::check(serverStore, "key2", "value2");
+
+  std::string expectedCounterRes = std::to_string(numThreads * numIterations);
+
+  for (auto i = 0; i < numThreads; i++) {
+    threads.push_back(
+        std::thread([&sem1, &sem2, &clientStores, i, &expectedCounterRes] {
+          for (auto j = 0; j < numIterations; j++) {
+            clientStores[i]->add("counter", 1);
+          }
+          // Let each thread set and get key on its client store
+          std::string key = "thread_" + std::to_string(i);
+          for (auto j = 0; j < numIterations; j++) {
+            std::string val = "thread_val_" + std::to_string(j);
+            c10d::test::set(*clientStores[i], key, val);
+            c10d::test::check(*clientStores[i], key, val);
+          }
+
+          sem1.post();
+          sem2.wait();
+          // Check the counter results
+          c10d::test::check(*clientStores[i], "counter", expectedCounterRes);
+          // Now check other threads' written data
+          for (auto j = 0; j < numThreads; j++) {
+            if (j == i) {
+              continue;
+            }
+            std::string key = "thread_" + std::to_string(i);
+            std::string val = "thread_val_" + std::to_string(numIterations - 1);
+            c10d::test::check(*clientStores[i], key, val);
+          }
+        }));
+  }
+
+  sem1.wait(numThreads);
+  sem2.post(numThreads);
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // Clear the store to test that client disconnect won't shutdown the store
+  clientStores.clear();
+  clientTCPStores.clear();
+
+  // Check that the counter has the expected value
+  c10d::test::check(serverStore, "counter", expectedCounterRes);
+
+  // Check that each threads' written data from the main thread
+  for (auto i = 0; i < numThreads; i++) {
+    std::string key = "thread_" + std::to_string(i);
+    std::string val = "thread_val_" + std::to_string(numIterations - 1);
+    c10d::test::check(serverStore, key, val);
+  }
+}
+
+void testBatchedOps() {
+  c10d::ShardedTCPStore store("127.0.0.1", 29501, 1, true);
+
+  // multiSet/multiGet
+  store.multiSet({"a", "b", "c"}, {toVec("1"), toVec("2"), toVec("3")});
+  auto values = store.multiGet({"c", "a", "b"});
+  checkEqual(toString(values[0]), "3");
+  checkEqual(toString(values[1]), "1");
+  checkEqual(toString(values[2]), "2");
+
+  // compareSet
+  checkEqual(toString(store.compareSet("cas", toVec("x"), toVec("y"))), "");
+  checkEqual(toString(store.compareSet("cas", {}, toVec("first"))), "first");
+  checkEqual(
+      toString(store.compareSet("cas", toVec("other"), toVec("second"))),
+      "first");
+  checkEqual(
+      toString(store.compareSet("cas", toVec("first"), toVec("second"))),
+      "second");
+  c10d::test::check(store, "cas", "second");
+
+  // A get waits for the key to be set
+  std::thread setter([] {
+    c10d::ShardedTCPStore client("127.0.0.1", 29501, 1, false);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    client.multiSet({"late0", "late1"}, {toVec("v0"), toVec("v1")});
+  });
+  values = store.multiGet({"late0", "late1"});
+  checkEqual(toString(values[0]), "v0");
+  checkEqual(toString(values[1]), "v1");
+  setter.join();
+
+  // A wait that times out leaves the store usable
+  bool timedOut = false;
+  try {
+    store.wait({"missing"}, std::chrono::milliseconds(100));
+  } catch (const std::runtime_error&) {
+    timedOut = true;
+  }
+  if (!timedOut) {
+    throw std::runtime_error("Expected wait to time out");
+  }
+  c10d::test::set(store, "missing", "found");
+  c10d::test::check(store, "missing", "found");
+}
+
+void testBarrierAndProxy() {
+  const auto numNodes = 2;
+  const auto numProcsPerNode = 4;
+  const auto numWorkers = numNodes * numProcsPerNode + 1;
+  c10d::ShardedTCPStore::Options options;
+  options.numThreads = 2;
+
+  std::unique_ptr<c10d::ShardedTCPStore> serverStore;
+  std::thread server([&serverStore, &options, numWorkers] {
+    serverStore.reset(new c10d::ShardedTCPStore(
+        "127.0.0.1", 29501, numWorkers, true, options));
+  });
+
+  std::vector<std::unique_ptr<c10d::ShardedTCPStoreProxy>> proxies;
+  for (auto i = 0; i < numNodes; i++) {
+    proxies.push_back(std::unique_ptr<c10d::ShardedTCPStoreProxy>(
+        new c10d::ShardedTCPStoreProxy("127.0.0.1", 29501, 0, options)));
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<int> passed(0);
+  for (auto i = 0; i < numNodes * numProcsPerNode; i++) {
+    const auto port = proxies[i / numProcsPerNode]->port();
+    threads.push_back(std::thread([i, port, numWorkers, &passed] {
+      c10d::ShardedTCPStore store("127.0.0.1", port, numWorkers, false);
+      c10d::test::set(store, "rank_" + std::to_string(i), std::to_string(i));
+      store.barrier("all_set", numNodes * numProcsPerNode);
+      // Everything set before the barrier is visible after it
+      for (auto j = 0; j < numNodes * numProcsPerNode; j++) {
+        c10d::test::check(store, "rank_" + std::to_string(j), std::to_string(j));
+      }
+      if (!store.check({"rank_0", "rank_1"})) {
+        throw std::runtime_error("Expected keys to be set");
+      }
+      store.add("passed", 1);
+      passed++;
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  server.join();
+
+  if (passed != numNodes * numProcsPerNode) {
+    throw std::runtime_error("Expected every process to pass the barrier");
+  }
+  c10d::test::check(
+      *serverStore, "passed", std::to_string(numNodes * numProcsPerNode));
+
+  proxies.clear();
+  serverStore.reset();
+}
+
+int main(int argc, char** argv) {
+  testHelper();
+  testHelper("testPrefix");
+  testBatchedOps();
+  testBarrierAndProxy();
+  std::cout << "Test succeeded" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <TH/TH.h>
+#include <libshm/libshm.h>
+
+// Note [Shared memory arena]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~
+// The file_system strategy creates, registers with the manager, maps and
+// unlinks one shared memory file per storage, and every receiving process
+// maps it again, so that handing off a batch costs a few syscalls and the page
+// faults of fresh memory on both sides.
+//
+// With the shared_arena strategy a process carves the storages it shares out
+// of a few large segments, which are files registered with the manager like
+// any other. Each block starts with a BlockHeader holding a reference count
+// shared by all processes: the storage of the allocating process holds one
+// reference, every pickling of the storage takes one on behalf of the
+// receiving process, and the receiving process keeps it (or drops it if it
+// already holds the block) until its storage is freed. A block freed by its
+// allocating process while a receiving process still uses it is recycled by a
+// later allocation once its count drops to zero. The receiving processes keep
+// the last kRetainedSegments segments mapped, so that receiving a batch from a
+// segment seen before only takes a pointer into a persistent mapping.
+//
+// The segments are advised to be backed by transparent huge pages, which
+// Linux honours for shared memory when
+// /sys/kernel/mm/transparent_hugepage/shmem_enabled is set to "advise".
+//
+// A process forked after it used the arena starts over with empty state: the
+// blocks it inherited still belong to its parent, so freeing them in the child
+// doesn't touch their reference counts.
+
+namespace {
+
+constexpr size_t kSegmentSize = 64 * 1024 * 1024;
+constexpr size_t kHugePageSize = 2 * 1024 * 1024;
+constexpr size_t kBlockAlignment = 64;
+constexpr size_t kRetainedSegments = 8;
+
+struct BlockHeader {
+  std::atomic<int64_t> refcount;
+  // size of the block in bytes, header included
+  uint64_t size;
+};
+static_assert(sizeof(BlockHeader) <= kBlockAlignment, "BlockHeader too large");
+
+size_t round_up(size_t value, size_t multiple) {
+  return (value + multiple - 1) / multiple * multiple;
+}
+
+std::string new_segment_handle() {
+  static std::random_device rd;
+  std::string handle = "/torch_arena_";
+  handle += std::to_string(getpid());
+  handle += "_";
+  handle += std::to_string(rd());
+  return handle;
+}
+
+void advise_huge_pages(void* data, size_t size) {
+#ifdef MADV_HUGEPAGE
+  uintptr_t begin = round_up(reinterpret_cast<uintptr_t>(data), kHugePageSize);
+  uintptr_t end = (reinterpret_cast<uintptr_t>(data) + size) / kHugePageSize * kHugePageSize;
+  if (begin < end) {
+    // best effort, the kernel may not support it
+    madvise(reinterpret_cast<void*>(begin), end - begin, MADV_HUGEPAGE);
+  }
+#endif
+}
+
+struct Segment {
+  Segment(const char* manager_handle, const char* filename, int flags, size_t size)
+    : mapping(THManagedMapAllocator::makeDataPtr(manager_handle, filename, flags, size)),
+      data(static_cast<char*>(mapping.get())),
+      size(size) {
+    advise_huge_pages(data, size);
+    auto ctx = THManagedMapAllocator::fromDataPtr(mapping);
+    this->manager_handle = ctx->manager_handle();
+    this->filename = ctx->filename();
+  }
+
+  BlockHeader* header(size_t offset) {
+    return reinterpret_cast<BlockHeader*>(data + offset);
+  }
+
+  at::DataPtr mapping;
+  char* data;
+  size_t size;
+  std::string manager_handle;
+  std::string filename;
+  // Unallocated ranges by offset; only used in the allocating process.
+  std::map<size_t, size_t> free_ranges;
+};
+
+// Context of the DataPtr of a block; offset is the one of its header.
+struct Block {
+  std::shared_ptr<Segment> segment;
+  size_t offset;
+  bool allocated_here;
+  uint64_t generation;
+
+  BlockHeader* header() {
+    return segment->header(offset);
+  }
+};
+
+void deleteBlock(void* ptr);
+
+class Arena {
+ public:
+  explicit Arena(uint64_t generation) : generation_(generation) {}
+
+  at::DataPtr allocate(size_t nbytes) {
+    const size_t size = kBlockAlignment + round_up(nbytes, kBlockAlignment);
+    std::lock_guard<std::mutex> lock(mutex_);
+    reclaim();
+    std::shared_ptr<Segment> segment;
+    size_t offset = 0;
+    for (auto& candidate : segments_) {
+      if (take_range(*candidate, size, &offset)) {
+        segment = candidate;
+        break;
+      }
+    }
+    if (!segment) {
+      const size_t segment_size = std::max(kSegmentSize, round_up(size, kHugePageSize));
+      const std::string handle = new_segment_handle();
+      int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE;
+      segment = std::make_shared<Segment>("", handle.c_str(), flags, segment_size);
+      segment->free_ranges.emplace(0, segment_size);
+      segments_.push_back(segment);
+      take_range(*segment, size, &offset);
+    }
+    BlockHeader* header = segment->header(offset);
+    new (&header->refcount) std::atomic<int64_t>(1);
+    header->size = size;
+    auto block = new Block{std::move(segment), offset, true, generation_};
+    return {block->segment->data + offset + kBlockAlignment, block, &deleteBlock, at::DeviceType::CPU};
+  }
+
+  at::DataPtr receive(const char* manager_handle, const char* filename, size_t segment_size, size_t offset) {
+    TORCH_CHECK(offset >= kBlockAlignment && offset <= segment_size,
+                "invalid offset ", offset, " of a shared memory arena block");
+    std::shared_ptr<Segment> segment;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      segment = received_segment(manager_handle, filename, segment_size);
+    }
+    const size_t header_offset = offset - kBlockAlignment;
+    segment->header(header_offset)->refcount++;
+    auto block = new Block{std::move(segment), header_offset, false, generation_};
+    return {block->segment->data + offset, block, &deleteBlock, at::DeviceType::CPU};
+  }
+
+  void free(Block* block) {
+    if (block->generation != generation_) {
+      // inherited through fork, see Note [Shared memory arena]
+      return;
+    }
+    if (!block->allocated_here) {
+      block->header()->refcount--;
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--block->header()->refcount == 0) {
+      release_range(block->segment, block->offset);
+    } else {
+      pending_.emplace_back(block->segment, block->offset);
+    }
+  }
+
+ private:
+  // Must be called with mutex_ held.
+  bool take_range(Segment& segment, size_t size, size_t* offset) {
+    for (auto it = segment.free_ranges.begin(); it != segment.free_ranges.end(); ++it) {
+      if (it->second >= size) {
+        *offset = it->first;
+        const size_t rest = it->second - size;
+        segment.free_ranges.erase(it);
+        if (rest > 0) {
+          segment.free_ranges.emplace(*offset + size, rest);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Must be called with mutex_ held.
+  void release_range(const std::shared_ptr<Segment>& segment, size_t offset) {
+    size_t size = segment->header(offset)->size;
+    auto& ranges = segment->free_ranges;
+    auto next = ranges.lower_bound(offset);
+    if (next != ranges.end() && offset + size == next->first) {
+      size += next->second;
+      next = ranges.erase(next);
+    }
+    if (next != ranges.begin()) {
+      auto prev = std::prev(next);
+      if (prev->first + prev->second == offset) {
+        offset = prev->first;
+        size += prev->second;
+        ranges.erase(prev);
+      }
+    }
+    ranges.emplace(offset, size);
+    // Segments made for a single large block are given back once free.
+    if (segment->size > kSegmentSize && size == segment->size) {
+      segments_.erase(std::find(segments_.begin(), segments_.end(), segment));
+    }
+  }
+
+  // Must be called with mutex_ held.
+  void reclaim() {
+    size_t kept = 0;
+    for (size_t i = 0; i < pending_.size(); i++) {
+      if (pending_[i].first->header(pending_[i].second)->refcount.load() == 0) {
+        release_range(pending_[i].first, pending_[i].second);
+      } else {
+        if (kept != i) {
+          pending_[kept] = std::move(pending_[i]);
+        }
+        kept++;
+      }
+    }
+    pending_.resize(kept);
+  }
+
+  // Must be called with mutex_ held.
+  std::shared_ptr<Segment> received_segment(const char* manager_handle, const char* filename, size_t segment_size) {
+    for (auto it = retained_.begin(); it != retained_.end(); ++it) {
+      if ((*it)->filename == filename) {
+        retained_.splice(retained_.begin(), retained_, it);
+        return retained_.front();
+      }
+    }
+    std::shared_ptr<Segment> segment;
+    auto it = received_.find(filename);
+    if (it != received_.end()) {
+      segment = it->second.lock();
+    }
+    if (!segment) {
+      int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
+      segment = std::make_shared<Segment>(manager_handle, filename, flags, segment_size);
+      received_[filename] = segment;
+    }
+    retained_.push_front(segment);
+    if (retained_.size() > kRetainedSegments) {
+      retained_.pop_back();
+      for (auto it = received_.begin(); it != received_.end();) {
+        it = it->second.expired() ? received_.erase(it) : std::next(it);
+      }
+    }
+    return segment;
+  }
+
+  std::mutex mutex_;
+  const uint64_t generation_;
+  // allocating side
+  std::vector<std::shared_ptr<Segment>> segments_;
+  // blocks freed here that other processes still use
+  std::vector<std::pair<std::shared_ptr<Segment>, size_t>> pending_;
+  // receiving side, most recently used first
+  std::list<std::shared_ptr<Segment>> retained_;
+  std::unordered_map<std::string, std::weak_ptr<Segment>> received_;
+};
+
+// The arenas are never destroyed, so that storages freed during the exit of
+// the process find them; the manager unlinks the segments once all the
+// processes using them are gone.
+std::atomic<Arena*> arena{nullptr};
+std::atomic<uint64_t> arena_generation{0};
+
+void reset_arena_after_fork() {
+  arena = new Arena(++arena_generation);
+}
+
+Arena& get_arena() {
+  static std::once_flag flag;
+  std::call_once(flag, [] {
+    arena = new Arena(arena_generation);
+    pthread_atfork(nullptr, nullptr, &reset_arena_after_fork);
+  });
+  return *arena;
+}
+
+void deleteBlock(void* ptr) {
+  std::unique_ptr<Block> block(static_cast<Block*>(ptr));
+  get_arena().free(block.get());
+}
+
+Block* block_from_data_ptr(const at::DataPtr& data_ptr) {
+  return data_ptr.cast_context<Block>(&deleteBlock);
+}
+
+} // namespace
+
+at::DataPtr THSharedArena::allocate(size_t size) {
+  return get_arena().allocate(size);
+}
+
+at::DataPtr THSharedArena::receive(const char* manager_handle, const char* segment, size_t segment_size, size_t offset) {
+  return get_arena().receive(manager_handle, segment, segment_size, offset);
+}
+
+bool THSharedArena::describe(const at::DataPtr& data_ptr, std::string* manager_handle, std::string* segment,
+                             size_t* segment_size, size_t* offset) {
+  Block* block = block_from_data_ptr(data_ptr);
+  if (!block) {
+    return false;
+  }
+  *manager_handle = block->segment->manager_handle;
+  *segment = block->segment->filename;
+  *segment_size = block->segment->size;
+  *offset = block->offset + kBlockAlignment;
+  return true;
+}
+
+void THSharedArena::incref(const at::DataPtr& data_ptr) {
+  Block* block = block_from_data_ptr(data_ptr);
+  if (block) {
+    block->header()->refcount++;
+  }
+}
+
+void THSharedArena::decref(const at::DataPtr& data_ptr) {
+  Block* block = block_from_data_ptr(data_ptr);
+  if (block) {
+    block->header()->refcount--;
+  }
+}
@@ -30,4 +30,24 @@ public:
   const char* manager_handle() const { return manager_handle_.c_str(); }
 };
 
+// Shared memory for the storages of the shared_arena sharing strategy, which
+// are sub-allocated from a few large segments per process that the receiving
+// processes keep mapped. See Note [Shared memory arena] in arena.cpp.
+class THSharedArena {
+public:
+  // A block of at least `size` bytes, recycled once the storages of this and
+  // of the receiving processes using it are freed.
+  static at::DataPtr allocate(size_t size);
+  // Maps the block at `offset` of a segment of another process, taking a
+  // reference to it.
+  static at::DataPtr receive(const char* manager_handle, const char* segment, size_t segment_size, size_t offset);
+  // Returns false if data_ptr is not a block of an arena.
+  static bool describe(const at::DataPtr& data_ptr, std::string* manager_handle, std::string* segment,
+                       size_t* segment_size, size_t* offset);
+  // Take and drop the references of the receiving processes; no-ops if
+  // data_ptr is not a block of an arena.
+  static void incref(const at::DataPtr& data_ptr);
+  static void decref(const at::DataPtr& data_ptr);
+};
+
 #endif
@@ -19,7 +19,8 @@ from .reductions import init_reductions
 import multiprocessing
 
 __all__ = ['set_sharing_strategy', 'get_sharing_strategy',
-           'get_all_sharing_strategies']
+           'get_all_sharing_strategies', 'set_cuda_ipc_pooling',
+           'get_cuda_ipc_pooling']
 
 
 from multiprocessing import *
@@ -45,12 +46,15 @@ them. This depends `mp.get_context` which was added in Python 3.4."""
 from .spawn import spawn, SpawnContext, _supports_context
 
 
-if sys.platform == 'darwin' or sys.platform == 'win32':
+if sys.platform == 'win32':
     _sharing_strategy = 'file_system'
     _all_sharing_strategies = {'file_system'}
+elif sys.platform == 'darwin':
+    _sharing_strategy = 'file_system'
+    _all_sharing_strategies = {'file_system', 'shared_arena'}
 else:
     _sharing_strategy = 'file_descriptor'
-    _all_sharing_strategies = {'file_descriptor', 'file_system'}
+    _all_sharing_strategies = {'file_descriptor', 'file_system', 'shared_arena'}
 
 
 def set_sharing_strategy(new_strategy):
@@ -75,4 +79,30 @@ def get_all_sharing_strategies():
     return _all_sharing_strategies
 
 
+def set_cuda_ipc_pooling(enabled):
+    """Sets whether CUDA tensors received by this process use the pooled mode.
+
+    In the pooled mode the CUDA allocations of the sending processes stay
+    mapped in this process after the tensors received from them are freed, and
+    the sending processes are told that received tensors were freed in
+    batches, without synchronizing their streams. This makes passing a lot of
+    small CUDA tensors between processes much cheaper, at the price of keeping
+    a few allocations of the sending processes alive for longer; call
+    :func:`torch.cuda.ipc_collect` to release them. See
+    :ref:`multiprocessing-cuda-sharing-details`.
+
+    Arguments:
+        enabled (bool): whether to use the pooled mode. Only the tensors
+            received afterwards are affected.
+    """
+    if not hasattr(torch._C, '_cuda_ipc_set_pooling'):
+        raise RuntimeError("CUDA IPC pooling requires PyTorch to be built with CUDA")
+    torch._C._cuda_ipc_set_pooling(bool(enabled))
+
+
+def get_cuda_ipc_pooling():
+    """Returns whether the pooled mode is used for received CUDA tensors."""
+    return hasattr(torch._C, '_cuda_ipc_pooling_enabled') and torch._C._cuda_ipc_pooling_enabled()
+
+
 init_reductions()
@@ -312,6 +312,15 @@ def rebuild_storage_filename(cls, manager, handle, size):
     return storage._shared_decref()
 
 
+def rebuild_storage_arena(cls, manager, handle, segment_size, offset, size):
+    storage = storage_from_cache(cls, (handle, offset))
+    if storage is None:
+        storage = cls._new_shared_arena(manager, handle, segment_size, offset, size)
+        shared_cache[(handle, offset)] = StorageWeakRef(storage)
+    # drops the reference taken for this process in reduce_storage
+    return storage._shared_decref()
+
+
 def rebuild_storage_empty(cls):
     return cls()
 
@@ -325,6 +334,11 @@ def reduce_storage(storage):
         cache_key = metadata[1]
         rebuild = rebuild_storage_filename
         storage._shared_incref()
+    elif get_sharing_strategy() == 'shared_arena':
+        metadata = storage._share_arena_()
+        cache_key = (metadata[1], metadata[3])
+        rebuild = rebuild_storage_arena
+        storage._shared_incref()
     elif storage.size() == 0:
         # This is special cased because Empty tensors
         # (with size 0) cannot be mmapped.
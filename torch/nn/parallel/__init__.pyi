@@ -2,4 +2,5 @@ from .data_parallel import DataParallel as DataParallel, data_parallel as data_p
 from .distributed import DistributedDataParallel as DistributedDataParallel
 from .parallel_apply import parallel_apply as parallel_apply
 from .replicate import replicate as repliace
+from .sharded_embedding import ShardedEmbedding as ShardedEmbedding
 from .scatter_gather import gather as gather, scatter as scatter
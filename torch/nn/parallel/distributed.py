@@ -193,6 +193,24 @@ class DistributedDataParallel(Module):
                        bucket can potentially overlap with backward computation.
                        :attr:`bucket_cap_mb` controls the bucket size in MegaBytes (MB)
                        (default: 25)
+        autotune_bucket_cap (bool): flag that enables timing a few bucket sizes
+                                    around :attr:`bucket_cap_mb` during the first
+                                    iterations and keeping the fastest one.
+                                    All processes switch bucket sizes together.
+                                    (default: ``False``)
+        gradient_as_bucket_view (bool): flag that makes the ``.grad`` of every
+                                        parameter a view into the flat bucket
+                                        it is reduced in, once it has been
+                                        computed. Gradients are then
+                                        accumulated straight into the buckets,
+                                        which saves copying them in and out
+                                        of the buckets in every iteration, and
+                                        the memory of a second copy of the
+                                        gradients. The ``.grad`` of a
+                                        parameter may thus be replaced by a
+                                        new tensor after the first backward
+                                        pass, and after the buckets are
+                                        rebuilt. (default: ``False``)
         find_unused_parameters (bool): Traverse the autograd graph of all tensors
                                        contained in the return value of the wrapped
                                        module's ``forward`` function.
@@ -230,7 +248,9 @@ class DistributedDataParallel(Module):
                  output_device=None, dim=0, broadcast_buffers=True,
                  process_group=None, bucket_cap_mb=25,
                  find_unused_parameters=False,
-                 check_reduction=False):
+                 check_reduction=False,
+                 autotune_bucket_cap=False,
+                 gradient_as_bucket_view=False):
 
         super(DistributedDataParallel, self).__init__()
 
@@ -294,6 +314,8 @@ class DistributedDataParallel(Module):
 
         # reduction bucket size
         self.bucket_bytes_cap = int(bucket_cap_mb * MB)
+        self.autotune_bucket_cap = autotune_bucket_cap
+        self.gradient_as_bucket_view = gradient_as_bucket_view
 
         # Sync params and buffers
         module_states = list(self.module.state_dict().values())
@@ -348,6 +370,10 @@ class DistributedDataParallel(Module):
             list(parameter for _, parameter in replica)
             for replica in modules_and_parameters]
 
+        # The parameters of the first replica, indexed like the variables in
+        # the reducer's bucket assignment.
+        self._bucketed_parameters = parameters[0]
+
         # Checks if a module will produce a sparse gradient.
         def produces_sparse_gradient(module):
             if isinstance(module, torch.nn.Embedding):
@@ -375,15 +401,107 @@ class DistributedDataParallel(Module):
         # Note: reverse list of buckets because we want to approximate the
         # order in which their gradients are produced, and assume they
         # are used in the forward pass in the order they are defined.
+        # The reducer replaces this assignment with one that follows the
+        # actual order after the first backward pass (see `forward`).
         self.reducer = dist.Reducer(
             parameters,
             list(reversed(bucket_indices)),
             self.process_group,
-            expect_sparse_gradient)
+            expect_sparse_gradient,
+            self.bucket_bytes_cap,
+            self.gradient_as_bucket_view)
+
+        if self.autotune_bucket_cap:
+            candidates = [self.bucket_bytes_cap // 4, self.bucket_bytes_cap // 2,
+                          self.bucket_bytes_cap, self.bucket_bytes_cap * 2,
+                          self.bucket_bytes_cap * 4]
+            self.reducer.autotune_bucket_size(
+                [c for c in candidates if c > 0], 20)
 
         # passing a handle to torch.nn.SyncBatchNorm layer
         self._passing_sync_batchnorm_handle(self._module_copies)
 
+    def register_comm_hook(self, hook, **kwargs):
+        r"""
+        Replaces the allreduce of dense gradient buckets by a communication
+        hook that compresses the gradients before they are sent. Must be
+        called before the first backward pass. All processes must register
+        the same hook with the same arguments.
+
+        Arguments:
+            hook (str): one of
+
+                * ``'fp16'``: allreduce in half precision.
+                * ``'topk'``: send only the fraction ``ratio`` (keyword
+                  argument) of elements with the largest magnitude, and carry
+                  the rest over to the next iteration.
+                * ``'powersgd'``: send a rank ``matrix_approximation_rank``
+                  (keyword argument, default: 1) approximation of every
+                  bucket, and carry the approximation error over to the next
+                  iteration. Optionally takes the ``seed`` used to initialize
+                  the approximation.
+                * ``'reduce_scatter'``: only reduce the slice of every bucket
+                  that this process updates, leaving the rest of the
+                  gradients unreduced. Registered by
+                  :class:`~torch.distributed.optim.ZeroRedundancyOptimizer`.
+
+            ``'topk'``, ``'powersgd'`` and ``'reduce_scatter'`` don't support
+            multi-device modules.
+        """
+        if hook == 'fp16':
+            self.reducer.register_fp16_compress_hook(self.process_group, **kwargs)
+        elif hook == 'topk':
+            self.reducer.register_topk_compress_hook(self.process_group, **kwargs)
+        elif hook == 'powersgd':
+            kwargs.setdefault('matrix_approximation_rank', 1)
+            self.reducer.register_powersgd_hook(self.process_group, **kwargs)
+        elif hook == 'reduce_scatter':
+            self.reducer.register_reduce_scatter_hook(self.process_group, **kwargs)
+        else:
+            raise ValueError("Unknown communication hook: {}".format(hook))
+
+    def use_sparse_allgather(self, density_threshold=0.5):
+        r"""
+        Reduces sparse gradients (e.g. of embeddings with ``sparse=True``) by
+        allgathering their coalesced indices and values, instead of using
+        the sparse allreduce of the process group, which not every backend
+        supports. Gradients whose entries are denser than
+        ``density_threshold`` across processes are allreduced as dense
+        tensors instead. The gradients stay sparse either way. Must be
+        called before the first backward pass. Only supports single-device
+        modules.
+
+        Arguments:
+            density_threshold (float): fraction of the rows of a gradient
+                that are set in any process above which it is allreduced as a
+                dense tensor (default: 0.5).
+        """
+        self.reducer.use_sparse_allgather(density_threshold)
+
+    def reform(self, process_group=None):
+        r"""
+        Switches to a new process group, e.g. one re-formed by
+        :func:`~torch.distributed.reform_process_group` after some processes
+        failed, without reloading the module: its parameters and buffers are
+        broadcast from the new rank 0, and the gradient buckets are
+        initialized again. Communication hooks must be registered again.
+        Must be called outside of the forward and backward passes, by all
+        the processes of the new group.
+
+        Arguments:
+            process_group (ProcessGroup, optional): the new group (default:
+                the default process group).
+        """
+        if process_group is None:
+            process_group = _get_default_group()
+        self.process_group = process_group
+        module_states = list(self.module.state_dict().values())
+        if len(module_states) > 0:
+            self._distributed_broadcast_coalesced(
+                module_states,
+                self.broadcast_bucket_size)
+        self._ddp_init_helper()
+
     def __getstate__(self):
         self._check_default_group()
         attrs = copy.copy(self.__dict__)
@@ -397,6 +515,8 @@ class DistributedDataParallel(Module):
         super(DistributedDataParallel, self).__setstate__(state)
         self.__dict__.setdefault('require_forward_param_sync', True)
         self.__dict__.setdefault('require_backward_grad_sync', True)
+        self.__dict__.setdefault('autotune_bucket_cap', False)
+        self.__dict__.setdefault('gradient_as_bucket_view', False)
         self._ddp_init_helper()
 
     def _check_default_group(self):
@@ -438,6 +558,12 @@ class DistributedDataParallel(Module):
             self.require_backward_grad_sync = old_require_backward_grad_sync
 
     def forward(self, *inputs, **kwargs):
+        if torch.is_grad_enabled() and self.require_backward_grad_sync:
+            # Once a backward pass has been recorded, the reducer rebuilds
+            # its buckets to follow the order gradients were ready in, and
+            # steps through bucket sizes if autotuning. This is collective.
+            self.reducer.rebuild_buckets()
+
         if self.require_forward_param_sync:
             self._sync_params()
 
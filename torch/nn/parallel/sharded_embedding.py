@@ -0,0 +1,245 @@
+import torch
+import torch.distributed as dist
+from torch.autograd import Function
+
+if dist.is_available():
+    from torch.distributed.distributed_c10d import _get_default_group
+
+from ..modules import Module
+from ..parameter import Parameter
+from .. import init
+
+
+def _alltoall(process_group, input, output_split_sizes, input_split_sizes):
+    output = input.new_empty((sum(output_split_sizes),) + input.shape[1:])
+    process_group.alltoall_base(
+        output, input, output_split_sizes, input_split_sizes).wait()
+    return output
+
+
+def _exchange_counts(process_group, counts, device):
+    r"""Sends ``counts[j]`` to rank ``j``, and returns the counts every rank
+    sent to this one."""
+    counts = torch.tensor(counts, dtype=torch.int64, device=device)
+    received = torch.empty_like(counts)
+    process_group.alltoall_base(received, counts, [], []).wait()
+    return received.tolist()
+
+
+def _sparse_grad(indices, values, size):
+    return torch.sparse_coo_tensor(indices.unsqueeze(0), values, size)
+
+
+class _RowWiseLookup(Function):
+    r"""Looks up the rows ``ids`` in a table whose rows are split across ranks.
+
+    ``ids`` are sorted by owner, ``input_split_sizes[j]`` of them being owned
+    by rank ``j``, which holds the rows starting at ``row_start`` in
+    ``weight``.
+    """
+
+    @staticmethod
+    def forward(ctx, weight, ids, input_split_sizes, process_group, row_start):
+        output_split_sizes = _exchange_counts(
+            process_group, input_split_sizes, ids.device)
+        served = _alltoall(
+            process_group, ids, output_split_sizes, input_split_sizes)
+        served -= row_start
+        rows = _alltoall(
+            process_group, weight.index_select(0, served),
+            input_split_sizes, output_split_sizes)
+        ctx.save_for_backward(served)
+        ctx.split_sizes = (input_split_sizes, output_split_sizes)
+        ctx.process_group = process_group
+        ctx.weight_size = weight.size()
+        return rows
+
+    @staticmethod
+    def backward(ctx, grad_rows):
+        served, = ctx.saved_tensors
+        input_split_sizes, output_split_sizes = ctx.split_sizes
+        # Each owner only receives the gradients of the rows it served.
+        grad = _alltoall(
+            ctx.process_group, grad_rows.contiguous(),
+            output_split_sizes, input_split_sizes)
+        return _sparse_grad(served, grad, ctx.weight_size), None, None, None, None
+
+
+class _ColumnWiseLookup(Function):
+    r"""Looks up the rows ``ids`` in a table whose columns are split across
+    ranks, rank ``j`` holding ``column_split_sizes[j]`` of them in ``weight``.
+    """
+
+    @staticmethod
+    def forward(ctx, weight, ids, process_group, column_split_sizes):
+        world_size = process_group.size()
+        num_ids = ids.numel()
+        columns = weight.size(1)
+        # Every rank serves its columns of the rows all ranks look up.
+        id_counts = _exchange_counts(
+            process_group, [num_ids] * world_size, ids.device)
+        served = _alltoall(
+            process_group, ids.repeat(world_size), id_counts,
+            [num_ids] * world_size)
+        # The slices have different widths, so they travel flattened.
+        received_sizes = [num_ids * c for c in column_split_sizes]
+        sent_sizes = [n * columns for n in id_counts]
+        parts = _alltoall(
+            process_group, weight.index_select(0, served).view(-1),
+            received_sizes, sent_sizes)
+        rows = torch.cat([
+            part.view(num_ids, c)
+            for part, c in zip(parts.split(received_sizes), column_split_sizes)
+        ], dim=1)
+        ctx.save_for_backward(served)
+        ctx.split_sizes = (received_sizes, sent_sizes)
+        ctx.process_group = process_group
+        ctx.column_split_sizes = column_split_sizes
+        ctx.weight_size = weight.size()
+        return rows
+
+    @staticmethod
+    def backward(ctx, grad_rows):
+        served, = ctx.saved_tensors
+        received_sizes, sent_sizes = ctx.split_sizes
+        grad_parts = torch.cat([
+            g.reshape(-1) for g in grad_rows.split(ctx.column_split_sizes, dim=1)])
+        grad = _alltoall(
+            ctx.process_group, grad_parts, sent_sizes, received_sizes)
+        grad = grad.view(-1, ctx.weight_size[1])
+        return _sparse_grad(served, grad, ctx.weight_size), None, None, None
+
+
+class ShardedEmbedding(Module):
+    r"""An embedding table too large for a single process, sharded across the
+    ranks of a process group.
+
+    Every rank holds a shard of the table in :attr:`weight`, and looks up its
+    own :attr:`input` in the whole table: the lookups are exchanged with the
+    ranks owning the rows through the all-to-all collective. Each rank only
+    sends the distinct indices of its input, and only receives the rows (or
+    slices of rows) for these. Backward sends the gradient of every row back
+    to the ranks owning it, where it accumulates as a sparse gradient of the
+    shard, so the shards should be updated with an optimizer supporting sparse
+    gradients (e.g. :class:`~torch.optim.SGD` or
+    :class:`~torch.optim.SparseAdam`).
+
+    Since forward and backward communicate, all the ranks of the group must
+    call them together, in the same order with respect to other collectives,
+    like the forward and backward of
+    :class:`~torch.nn.parallel.DistributedDataParallel`.
+
+    The supported sharding plans are:
+
+    - ``'table_wise'``: rank :attr:`owner` holds the whole table, for tables
+      small enough to fit on one rank (several of which can then be spread
+      over the ranks by giving them different owners).
+    - ``'row_wise'``: every rank holds a contiguous range of
+      ``ceil(num_embeddings / world_size)`` rows.
+    - ``'column_wise'``: every rank holds all the rows, but only about
+      ``embedding_dim / world_size`` of their columns; every rank then serves
+      every lookup, which balances the load of skewed accesses.
+
+    Args:
+        num_embeddings (int): size of the dictionary of embeddings
+        embedding_dim (int): the size of each embedding vector
+        sharding (string, optional): the sharding plan, one of
+            ``'table_wise'``, ``'row_wise'`` and ``'column_wise'``.
+            Default: ``'row_wise'``
+        owner (int, optional): the rank holding the table with the
+            ``'table_wise'`` plan. Default: 0
+        process_group (optional): the process group to shard the table across.
+            The backend must support the all-to-all collective. Default: the
+            default process group
+
+    Attributes:
+        weight (Tensor): the shard of the table held by this rank, of shape
+            (rows, columns) as given by the sharding plan, initialized from
+            :math:`\mathcal{N}(0, 1)`
+
+    Shape:
+        - Input: :math:`(*)`, LongTensor of arbitrary shape containing the
+          indices to extract
+        - Output: :math:`(*, H)`, where `*` is the input shape and
+          :math:`H=\text{embedding\_dim}`
+
+    Example::
+
+        >>> torch.distributed.init_process_group(backend='gloo', ...)
+        >>> embedding = nn.parallel.ShardedEmbedding(10000000, 64)
+        >>> optimizer = torch.optim.SGD(embedding.parameters(), lr=0.1)
+        >>> embedding(indices).sum().backward()
+        >>> optimizer.step()
+    """
+    __constants__ = ['num_embeddings', 'embedding_dim', 'sharding']
+
+    def __init__(self, num_embeddings, embedding_dim, sharding='row_wise',
+                 owner=0, process_group=None):
+        super(ShardedEmbedding, self).__init__()
+        if process_group is None:
+            process_group = _get_default_group()
+        self.process_group = process_group
+        self.num_embeddings = num_embeddings
+        self.embedding_dim = embedding_dim
+        self.sharding = sharding
+
+        world_size = process_group.size()
+        rank = process_group.rank()
+        if sharding == 'table_wise':
+            if not 0 <= owner < world_size:
+                raise ValueError(
+                    "owner must be a rank of the process group, but got {}"
+                    .format(owner))
+            # Rank r holds the rows from row_offsets[r] to row_offsets[r + 1].
+            self.row_offsets = ([0] * (owner + 1) +
+                                [num_embeddings] * (world_size - owner))
+        elif sharding == 'row_wise':
+            rows_per_rank = (num_embeddings + world_size - 1) // world_size
+            self.row_offsets = [min(r * rows_per_rank, num_embeddings)
+                                for r in range(world_size + 1)]
+        elif sharding == 'column_wise':
+            self.column_split_sizes = [
+                embedding_dim // world_size + (1 if r < embedding_dim % world_size else 0)
+                for r in range(world_size)]
+        else:
+            raise ValueError(
+                "sharding must be one of 'table_wise', 'row_wise' and "
+                "'column_wise', but got '{}'".format(sharding))
+
+        if sharding == 'column_wise':
+            shard_size = (num_embeddings, self.column_split_sizes[rank])
+        else:
+            shard_size = (self.row_offsets[rank + 1] - self.row_offsets[rank],
+                          embedding_dim)
+        self.weight = Parameter(torch.Tensor(*shard_size))
+        self.reset_parameters()
+
+    def reset_parameters(self):
+        init.normal_(self.weight)
+
+    def forward(self, input):
+        ids, inverse = torch.unique(
+            input.reshape(-1), sorted=True, return_inverse=True)
+        if ids.numel() > 0 and (ids[0] < 0 or ids[-1] >= self.num_embeddings):
+            raise IndexError(
+                "index out of range of the {} embeddings".format(
+                    self.num_embeddings))
+        if self.sharding == 'column_wise':
+            rows = _ColumnWiseLookup.apply(
+                self.weight, ids, self.process_group, self.column_split_sizes)
+        else:
+            # The ids are sorted, so the ids owned by each rank are contiguous.
+            offsets = torch.tensor(self.row_offsets, device=ids.device)
+            below = (ids.unsqueeze(1) < offsets).sum(0)
+            input_split_sizes = (below[1:] - below[:-1]).tolist()
+            rank = self.process_group.rank()
+            rows = _RowWiseLookup.apply(
+                self.weight, ids, input_split_sizes, self.process_group,
+                self.row_offsets[rank])
+        return rows.index_select(0, inverse).view(
+            input.shape + (self.embedding_dim,))
+
+    def extra_repr(self):
+        return '{}, {}, sharding={}, shard_size={}'.format(
+            self.num_embeddings, self.embedding_dim, self.sharding,
+            tuple(self.weight.shape))
@@ -0,0 +1,20 @@
+from ..modules import Module
+from .. import Parameter
+from ... import Tensor
+from typing import Any, Optional
+
+
+class ShardedEmbedding(Module):
+    process_group: Any = ...
+    num_embeddings: int = ...
+    embedding_dim: int = ...
+    sharding: str = ...
+    weight: Parameter = ...
+
+    # TODO type process_group once `distributed` module is stubbed
+    def __init__(self, num_embeddings: int, embedding_dim: int, sharding: str = ..., owner: int = ...,
+                 process_group: Optional[Any] = ...) -> None: ...
+
+    def reset_parameters(self) -> None: ...
+
+    def forward(self, input: Tensor) -> Tensor: ...
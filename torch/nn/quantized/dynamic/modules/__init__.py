@@ -1,9 +1,10 @@
 # @lint-ignore-every PYTHON3COMPATIMPORTS
 
-from .linear import Linear
+from .linear import Linear, LinearReLU
 from .rnn import LSTM
 
 __all__ = [
     'Linear',
+    'LinearReLU',
     'LSTM',
 ]
@@ -1,7 +1,8 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
 import torch
-from ....modules.linear import Linear as NNLinear
+import torch.nn.intrinsic as nni
 import torch.nn.quantized as nnq
+from torch.nn.quantized.modules.utils import _quantize_weight
 
 class Linear(nnq.Linear):
     r"""
@@ -20,6 +21,9 @@ class Linear(nnq.Linear):
         scale: `scale` parameter of weight Quantized Tensor, type: double
         zero_point: `zero_point` parameter for weight Quantized Tensor, type: long
 
+    The weight may be quantized per tensor or per output channel (e.g. with
+    :attr:`torch.quantization.per_channel_dynamic_qconfig`).
+
     Examples::
 
         >>> m = nn.quantized.dynamic.Linear(20, 30)
@@ -53,10 +57,14 @@ class Linear(nnq.Linear):
             mod (Module): a float module, either produced by torch.quantization
                           utilities or provided by the user
         """
-        assert type(mod) == NNLinear, 'nn.quantized.dynamic.Linear.from_float only works for nn.Linear'
+        assert type(mod) == cls._FLOAT_MODULE, 'nn.quantized.dynamic.' + cls.__name__ + \
+            '.from_float only works for ' + cls._FLOAT_MODULE.__name__
         assert hasattr(mod, 'qconfig'), 'Input float module must have qconfig defined'
-        if mod.qconfig is not None and mod.qconfig.weight is not None:
-            weight_observer = mod.qconfig.weight()
+        qconfig = mod.qconfig
+        if type(mod) == nni.LinearReLU:
+            mod = mod[0]
+        if qconfig is not None and qconfig.weight is not None:
+            weight_observer = qconfig.weight()
         else:
             # We have the circular import issues if we import the qconfig in the beginning of this file:
             # https://github.com/pytorch/pytorch/pull/24231. The current workaround is to postpone the
@@ -65,8 +73,33 @@ class Linear(nnq.Linear):
             weight_observer = default_dynamic_qconfig.weight()
         assert weight_observer.dtype == torch.qint8, 'Weight observer must have dtype torch.qint8'
         weight_observer(mod.weight)
-        wt_scale, wt_zp = weight_observer.calculate_qparams()
-        qweight = torch.quantize_per_tensor(mod.weight.float(), float(wt_scale), int(wt_zp), torch.qint8)
-        qlinear = Linear(mod.in_features, mod.out_features)
+        qweight = _quantize_weight(mod.weight.float(), weight_observer)
+        qlinear = cls(mod.in_features, mod.out_features)
         qlinear.set_weight_bias(qweight, mod.bias)
         return qlinear
+
+
+class LinearReLU(Linear):
+    r"""
+    A dynamic quantized LinearReLU module fused from Linear and ReLU modules,
+    with the ReLU applied while dequantizing the output of the GEMM.
+
+    We adopt the same interface as :class:`torch.nn.quantized.dynamic.Linear`.
+
+    Examples::
+
+        >>> m = nn.quantized.dynamic.LinearReLU(20, 30)
+        >>> input = torch.randn(128, 20)
+        >>> output = m(input)
+        >>> print(output.size())
+        torch.Size([128, 30])
+    """
+    _FLOAT_MODULE = nni.LinearReLU
+
+    def forward(self, x):
+        Y = torch.ops.quantized.linear_relu_dynamic(
+            x, self._packed_params)
+        return Y.to(x.dtype)
+
+    def _get_name(self):
+        return 'DynamicQuantizedLinearReLU'
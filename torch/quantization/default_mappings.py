@@ -46,6 +46,7 @@ DEFAULT_QAT_MODULE_MAPPING = {
 DEFAULT_DYNAMIC_MODULE_MAPPING = {
     nn.Linear: nnqd.Linear,
     nn.LSTM: nnqd.LSTM,
+    nni.LinearReLU: nnqd.LinearReLU,
 }
 
 # Whitelist for propagating the qconfig
@@ -214,6 +214,7 @@ def quantize_dynamic(model, qconfig_spec=None, dtype=torch.qint8,
             qconfig_spec = {
                 nn.Linear : default_dynamic_qconfig,
                 nn.LSTM : default_dynamic_qconfig,
+                nni.LinearReLU : default_dynamic_qconfig,
             }
         elif dtype == torch.float16:
             qconfig_spec = {
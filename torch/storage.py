@@ -114,6 +114,8 @@ class _StorageBase(object):
             pass  # CUDA doesn't use POSIX shared memory
         elif get_sharing_strategy() == 'file_system':
             self._share_filename_()
+        elif get_sharing_strategy() == 'shared_arena':
+            self._share_arena_()
         else:
             self._share_fd_()
         return self
@@ -126,6 +128,8 @@ class _StorageBase(object):
             return cls(size)
         elif get_sharing_strategy() == 'file_system':
             return cls._new_using_filename(size)
+        elif get_sharing_strategy() == 'shared_arena':
+            return cls._new_using_arena(size)
         else:
             return cls._new_using_fd(size)
 
@@ -5,6 +5,7 @@ from torch._namedtensor_internals import update_names, check_serializing_named_t
 from torch._namedtensor_internals import unzip_namedshape, single_ellipsis_index, is_ellipsis
 from collections import OrderedDict
 import torch.utils.hooks as hooks
+import torch.utils.dlpack
 import warnings
 import weakref
 from torch._six import imap
@@ -446,6 +447,35 @@ class Tensor(torch._C._TensorBase):
         else:
             return self.numpy().astype(dtype, copy=False)
 
+    def __dlpack__(self, stream=None):
+        r"""Returns a DLPack capsule sharing the memory of this tensor, for the
+        DLPack exchange protocol of :func:`torch.utils.dlpack.from_dlpack` and
+        of other libraries.
+
+        Strided tensors are exported with their strides, without a copy.
+
+        Arguments:
+            stream (int, optional): for a CUDA tensor, the raw ``cudaStream_t``
+                handle of the stream the consumer will use it on, or 1 and 2
+                for the legacy and per-thread default streams. The work queued
+                so far on the current stream of the tensor's device is ordered
+                before everything later queued on :attr:`stream`, without
+                synchronizing the host. ``None`` leaves the ordering to the
+                consumer.
+        """
+        if stream is not None and self.is_cuda:
+            with torch.cuda.device(self.device):
+                torch._C._cuda_stream_wait_current_stream(stream)
+        return torch.utils.dlpack.to_dlpack(self)
+
+    def __dlpack_device__(self):
+        r"""Returns the ``(device_type, device_id)`` pair DLPack describes the
+        device of this tensor with.
+        """
+        if self.is_cuda:
+            return (torch.utils.dlpack.kDLGPU, self.get_device())
+        return (torch.utils.dlpack.kDLCPU, 0)
+
     # Wrap Numpy array again in a suitable tensor when done, to support e.g.
     # `numpy.sin(tensor) -> tensor` or `numpy.greater(tensor, 0) -> ByteTensor`
     def __array_wrap__(self, array):
@@ -1,4 +1,5 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
+import contextlib
 import torch
 import warnings
 
@@ -155,6 +156,78 @@ def checkpoint(function, *args, **kwargs):
     return CheckpointFunction.apply(function, preserve, *args)
 
 
+def recompute_saved_tensors(function, *args, **kwargs):
+    r"""Runs :attr:`function` without keeping the tensors it saves for backward
+
+    Unlike :func:`checkpoint`, :attr:`function` runs with autograd enabled and
+    its graph is built as usual, but the tensors saved for backward inside of
+    it are dropped right away. The first time backward needs one of them,
+    :attr:`function` is run again on the same inputs and every tensor it saves
+    is handed to the nodes of the original graph. This works with
+    :func:`torch.autograd.grad`, and recomputation runs on the autograd
+    engine's threads, next to the rest of the backward pass.
+
+    .. warning::
+        :attr:`function` has to save the same tensors, in the same order, when
+        it runs again in backward. This is checked and an error raised
+        otherwise.
+
+    Args:
+        function: the part of the model to run
+        preserve_rng_state(bool, optional, default=True): Omit stashing and
+            restoring the RNG state for the recomputation.
+        args: inputs to :attr:`function`
+
+    Returns:
+        Output of running :attr:`function` on :attr:`*args`
+    """
+    # Hack to mix *args with **kwargs in a python 2.7-compliant way
+    preserve = kwargs.pop('preserve_rng_state', True)
+    if kwargs:
+        raise ValueError("Unexpected keyword arguments: " + ",".join(arg for arg in kwargs))
+
+    fwd_gpu_devices, fwd_gpu_states = [], []
+    if preserve:
+        fwd_cpu_state = torch.get_rng_state()
+        if torch.cuda._initialized:
+            fwd_gpu_devices, fwd_gpu_states = get_device_states(*args)
+
+    def recompute():
+        with torch.random.fork_rng(devices=fwd_gpu_devices, enabled=preserve):
+            if preserve:
+                torch.set_rng_state(fwd_cpu_state)
+                set_device_states(fwd_gpu_devices, fwd_gpu_states)
+            function(*detach_variable(args))
+
+    prev = torch.autograd._get_recompute_region()
+    torch.autograd._set_recompute_region(torch.autograd._RecomputeRegion(recompute))
+    try:
+        return function(*args)
+    finally:
+        torch.autograd._set_recompute_region(prev)
+
+
+@contextlib.contextmanager
+def offload_saved_tensors(min_bytes=0):
+    r"""Context manager moving CUDA tensors saved for backward to host memory
+
+    Inside of it, every CUDA tensor of at least :attr:`min_bytes` bytes that
+    autograd saves for backward is copied to pinned host memory, and the GPU
+    memory is released. During backward, the autograd engine starts copying it
+    back as soon as the first gradient for the node that needs it is
+    available, on the stream the node runs on.
+
+    Args:
+        min_bytes(int, optional, default=0): smaller tensors stay on the GPU
+    """
+    prev = torch.autograd._get_saved_variable_offload()
+    torch.autograd._set_saved_variable_offload(min_bytes)
+    try:
+        yield
+    finally:
+        torch.autograd._set_saved_variable_offload(prev)
+
+
 # TODO(sublee): When releasing PyTorch 1.3,
 # fix the function signature to not accept variadic arguments.
 # See also: https://github.com/pytorch/pytorch/issues/19260
@@ -1,20 +1,47 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
 import torch
 
-from torch._C import _from_dlpack as from_dlpack
+from torch._C import _from_dlpack
 from torch._C import _to_dlpack as to_dlpack
 
-torch._C._add_docstr(from_dlpack, r"""from_dlpack(dlpack) -> Tensor
+# DLDeviceType values of the devices a tensor can be exchanged on.
+kDLCPU = 1
+kDLGPU = 2
+
+
+def from_dlpack(ext_tensor):
+    r"""from_dlpack(ext_tensor) -> Tensor
+
+    Decodes a DLPack to a tensor.
+
+    Args:
+        ext_tensor: a PyCapsule object with the dltensor, or an object
+            implementing the ``__dlpack__`` and ``__dlpack_device__`` methods
+            of the DLPack exchange protocol (such as a tensor of another
+            library)
+
+    The tensor will share the memory with the object represented
+    in the dlpack, whatever its strides.
+    Note that each dlpack can only be consumed once.
+
+    When :attr:`ext_tensor` is a CUDA object implementing the protocol, it is
+    handed the current stream of its device, so that the producer orders its
+    pending work before the work later queued on that stream, without
+    synchronizing the host.
+    """
+    if hasattr(ext_tensor, '__dlpack__'):
+        device_type, device_id = ext_tensor.__dlpack_device__()
+        if device_type == kDLGPU:
+            stream = torch.cuda.current_stream(device_id).cuda_stream
+            # The protocol reserves 0, and asks for 1 for the legacy default
+            # stream instead.
+            dlpack = ext_tensor.__dlpack__(stream=stream if stream != 0 else 1)
+        else:
+            dlpack = ext_tensor.__dlpack__()
+    else:
+        dlpack = ext_tensor
+    return _from_dlpack(dlpack)
 
-Decodes a DLPack to a tensor.
-
-Args:
-    dlpack: a PyCapsule object with the dltensor
-
-The tensor will share the memory with the object represented
-in the dlpack.
-Note that each dlpack can only be consumed once.
-""")
 
 torch._C._add_docstr(to_dlpack, r"""to_dlpack(tensor) -> PyCapsule
 
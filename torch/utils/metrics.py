@@ -0,0 +1,124 @@
+from __future__ import absolute_import, division, print_function, unicode_literals
+from collections import namedtuple
+import torch
+
+
+def is_enabled():
+    r"""Returns whether the metrics are collected, which they are by default."""
+    return torch._C._metrics_enabled()
+
+
+def set_enabled(enabled):
+    r"""Enables or disables the collection of the metrics.
+
+    The metrics collected so far are kept.
+    """
+    torch._C._set_metrics_enabled(enabled)
+
+
+def get_time_sampling_interval():
+    r"""Returns the number of operator calls per timed call of every thread."""
+    return torch._C._metrics_time_sampling_interval()
+
+
+def set_time_sampling_interval(interval):
+    r"""Sets the number of operator calls per timed call of every thread.
+
+    Every operator call is counted but, to keep the cost of the metrics low,
+    every thread only times one of ``interval`` calls, from which the time of
+    the others is estimated. ``0`` disables the timing.
+    """
+    torch._C._set_metrics_time_sampling_interval(interval)
+
+
+def snapshot():
+    r"""Returns the metrics of the process, summed over all the threads.
+
+    Returns:
+        a tuple of a dict from counter names to their values and of a dict from
+        operator names to tuples of their number of calls and the estimated
+        number of seconds spent in them. The time of an operator includes the
+        time of the operators it calls.
+    """
+    return torch._C._metrics_snapshot()
+
+
+def prometheus_text():
+    r"""Returns the metrics of the process in the Prometheus text exposition
+    format, to be served to a Prometheus server scraping the process.
+
+    Example::
+
+        >>> print(torch.utils.metrics.prometheus_text())
+        # HELP torch_parallel_for_calls_total parallel_for and parallel_reduce calls split into several tasks
+        # TYPE torch_parallel_for_calls_total counter
+        torch_parallel_for_calls_total 12
+        ...
+        # HELP torch_op_calls_total Number of calls of an operator
+        # TYPE torch_op_calls_total counter
+        torch_op_calls_total{op="add"} 3
+        ...
+    """
+    return torch._C._metrics_prometheus_text()
+
+
+ParallelProfileEntry = namedtuple('ParallelProfileEntry', [
+    'op', 'regions', 'inline_calls', 'grain_size_sum', 'tasks',
+    'wall_seconds', 'busy_seconds', 'join_wait_seconds', 'imbalance'])
+
+
+def is_parallel_profiling_enabled():
+    r"""Returns whether the parallel regions of the CPU kernels are profiled."""
+    return torch._C._parallel_profiling_enabled()
+
+
+def set_parallel_profiling_enabled(enabled):
+    r"""Enables or disables the profiling of the parallel regions of the CPU
+    kernels, the ``parallel_for`` and ``parallel_reduce`` calls split into
+    several tasks. It is off by default, as it times every task.
+
+    The regions are attributed to the innermost operator running on the
+    thread that starts them, which is tracked with the callbacks of the
+    autograd profiler while the profiling is enabled.
+    """
+    torch._C._set_parallel_profiling_enabled(enabled)
+
+
+def parallel_profile():
+    r"""Returns the profile of the parallel regions since the last
+    :func:`reset_parallel_profile`, as a list of :class:`ParallelProfileEntry`
+    by decreasing wall time, one per operator.
+
+    Of an entry, ``regions`` is the number of parallel regions of the operator
+    and ``inline_calls`` the number of its parallel loops that ran on the
+    calling thread only. ``wall_seconds`` is the time from the start of the
+    regions to the join of their tasks, ``busy_seconds`` the time spent
+    running the tasks and ``join_wait_seconds`` the time the threads of the
+    regions spent idle, mostly waiting for the slowest task. ``imbalance``
+    is the mean over the regions of the time of their longest task over the
+    mean one.
+    """
+    return [ParallelProfileEntry(*entry) for entry in torch._C._parallel_profile()]
+
+
+def parallel_profile_report():
+    r"""Returns a table of :func:`parallel_profile`, in which the operators
+    whose parallel regions take longer than their tasks would on a single
+    thread are flagged.
+
+    Example::
+
+        >>> torch.utils.metrics.set_parallel_profiling_enabled(True)
+        >>> model(x)
+        >>> print(torch.utils.metrics.parallel_profile_report())
+        op                                 regions    inline   avg grain ...
+          aten::conv2d                          40         0       32768 ...
+        * aten::add                           2000         0       32768 ...
+        ...
+    """
+    return torch._C._parallel_profile_report()
+
+
+def reset_parallel_profile():
+    r"""Clears the profile of the parallel regions."""
+    torch._C._reset_parallel_profile()
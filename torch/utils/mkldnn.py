@@ -6,7 +6,9 @@ import torch
 class MkldnnLinear(torch.jit.ScriptModule):
     def __init__(self, dense_module):
         super(MkldnnLinear, self).__init__()
-        self.register_buffer('weight', dense_module.weight.to_mkldnn())
+        self.register_buffer(
+            'weight',
+            torch._C._nn.mkldnn_reorder_linear_weight(dense_module.weight.to_mkldnn()))
         if dense_module.bias is not None:
             self.register_buffer('bias', dense_module.bias.to_mkldnn())
         else:
@@ -21,7 +23,7 @@ class MkldnnLinear(torch.jit.ScriptModule):
 
     @torch.jit.script_method
     def __setstate__(self, state):
-        self.weight = state[0].to_mkldnn()
+        self.weight = torch._C._nn.mkldnn_reorder_linear_weight(state[0].to_mkldnn())
         self.bias = state[1].to_mkldnn()
         self.training = state[2]
 
@@ -34,15 +36,17 @@ class MkldnnLinear(torch.jit.ScriptModule):
 
 
 class MkldnnConv2d(torch.jit.ScriptModule):
-    __constants__ = ['stride', 'padding', 'dilation', 'groups']
+    __constants__ = ['stride', 'padding', 'dilation', 'groups', 'fuse_relu']
 
-    def __init__(self, dense_module):
+    def __init__(self, dense_module, fuse_relu=False):
         super(MkldnnConv2d, self).__init__()
 
         self.stride = dense_module.stride
         self.padding = dense_module.padding
         self.dilation = dense_module.dilation
         self.groups = dense_module.groups
+        # Whether a ReLU is applied to the output as an MKL-DNN post-op
+        self.fuse_relu = fuse_relu
 
         self.register_buffer('weight', dense_module.weight.to_mkldnn())
         if dense_module.bias is not None:
@@ -70,6 +74,17 @@ class MkldnnConv2d(torch.jit.ScriptModule):
 
     @torch.jit.script_method
     def forward(self, x):
+        if self.fuse_relu:
+            return torch.mkldnn_convolution_fused(
+                x,
+                self.weight,
+                self.bias,
+                self.padding,
+                self.stride,
+                self.dilation,
+                self.groups,
+                None,
+                True)
         return torch.conv2d(
             x,
             self.weight,
@@ -133,20 +148,32 @@ class MkldnnBatchNorm2d(torch.jit.ScriptModule):
 
 
 def to_mkldnn(module):
-    def m_fn(m):
+    def m_fn(m, fuse_relu):
         if isinstance(m, torch.nn.Linear):
             return MkldnnLinear(m)
         elif isinstance(m, torch.nn.Conv2d):
-            return MkldnnConv2d(m)
+            return MkldnnConv2d(m, fuse_relu)
         elif isinstance(m, torch.nn.BatchNorm2d):
             return MkldnnBatchNorm2d(m)
         else:
             return m
 
-    def m_fn_rec(m):
-        new_m = m_fn(m)
-        for name, sub_m in m.named_children():
-            setattr(new_m, name, m_fn_rec(sub_m))
+    def m_fn_rec(m, fuse_relu=False):
+        new_m = m_fn(m, fuse_relu)
+        children = list(m.named_children())
+        fused = False
+        for i, (name, sub_m) in enumerate(children):
+            if fused:
+                # The ReLU was fused into the Conv2d before it
+                setattr(new_m, name, torch.nn.Identity())
+                fused = False
+                continue
+            # A ReLU right after a Conv2d of a Sequential is fused into it
+            fused = (isinstance(m, torch.nn.Sequential) and
+                     isinstance(sub_m, torch.nn.Conv2d) and
+                     i + 1 < len(children) and
+                     isinstance(children[i + 1][1], torch.nn.ReLU))
+            setattr(new_m, name, m_fn_rec(sub_m, fused))
         return new_m
 
     return m_fn_rec(module)
@@ -1,5 +1,7 @@
 from __future__ import absolute_import, division, print_function, unicode_literals
 
+import json
+
 import torch._C
 
 def format_time(time_us=None, time_ms=None, time_s=None):
@@ -37,6 +39,31 @@ class ExecutionStats(object):
     def num_iters(self):
         return self._c_stats.num_iters
 
+    @property
+    def latency_p50_ms(self):
+        return self._c_stats.latency_p50_ms
+
+    @property
+    def latency_p90_ms(self):
+        return self._c_stats.latency_p90_ms
+
+    @property
+    def latency_p99_ms(self):
+        return self._c_stats.latency_p99_ms
+
+    @property
+    def latency_p999_ms(self):
+        return self._c_stats.latency_p999_ms
+
+    @property
+    def thread_cpu_time_ms(self):
+        '''
+        Returns the CPU time each of the calling threads spent in the measured
+        part of the benchmark, or an empty list if the platform doesn't support
+        per-thread CPU clocks
+        '''
+        return self._c_stats.thread_cpu_time_ms
+
     @property
     def iters_per_second(self):
         '''
@@ -46,17 +73,68 @@ class ExecutionStats(object):
 
     @property
     def total_time_seconds(self):
-        return self.num_iters * (
-            self.latency_avg_ms / 1000.0) / self.benchmark_config.num_calling_threads
+        return self._c_stats.total_time_ms / 1000.0
 
+    def to_dict(self):
+        '''
+        Returns the config and the statistics of the run as a dict of plain
+        Python values
+        '''
+        config = self.benchmark_config
+        return {
+            'config': {
+                'num_calling_threads': config.num_calling_threads,
+                'num_warmup_iters': config.num_warmup_iters,
+                'num_iters': config.num_iters,
+                'target_qps': config.target_qps,
+            },
+            'num_iters': self.num_iters,
+            'total_time_seconds': self.total_time_seconds,
+            'iters_per_second': self.iters_per_second,
+            'latency_avg_ms': self.latency_avg_ms,
+            'latency_p50_ms': self.latency_p50_ms,
+            'latency_p90_ms': self.latency_p90_ms,
+            'latency_p99_ms': self.latency_p99_ms,
+            'latency_p999_ms': self.latency_p999_ms,
+            'thread_cpu_time_ms': list(self.thread_cpu_time_ms),
+        }
+
+    def to_json(self, path=None):
+        '''
+        Returns the result of to_dict() serialized as JSON, and also writes it
+        to the file at `path` if given, e.g. to track regressions across runs
+        '''
+        result = json.dumps(self.to_dict(), indent=2, sort_keys=True)
+        if path is not None:
+            with open(path, 'w') as f:
+                f.write(result)
+        return result
 
     def __str__(self):
-        return '\n'.join([
+        lines = [
             "Average latency per example: " + format_time(time_ms=self.latency_avg_ms),
+            "Latency percentiles: p50 {}, p90 {}, p99 {}, p99.9 {}".format(
+                format_time(time_ms=self.latency_p50_ms),
+                format_time(time_ms=self.latency_p90_ms),
+                format_time(time_ms=self.latency_p99_ms),
+                format_time(time_ms=self.latency_p999_ms)),
             "Total number of iterations: {}".format(self.num_iters),
             "Total number of iterations per second (across all threads): {:.2f}".format(self.iters_per_second),
             "Total time: " + format_time(time_s=self.total_time_seconds)
-        ])
+        ]
+        if self.thread_cpu_time_ms:
+            lines.append("CPU time per calling thread: " + ", ".join(
+                format_time(time_ms=t) for t in self.thread_cpu_time_ms))
+        return '\n'.join(lines)
+
+
+def _make_config(num_calling_threads, num_warmup_iters, num_iters, target_qps):
+    config = torch._C.BenchmarkConfig()
+    config.num_calling_threads = num_calling_threads
+    config.num_warmup_iters = num_warmup_iters
+    config.num_iters = num_iters
+    config.target_qps = target_qps
+    return config
 
 
 class ThroughputBenchmark(object):
@@ -64,9 +142,10 @@ class ThroughputBenchmark(object):
     This class is a wrapper around a c++ component throughput_benchmark::ThroughputBenchmark
     responsible for executing a PyTorch module (nn.Module or ScriptModule)
     under an inference server like load. It can emulate multiple calling threads
-    to a single module provided. In the future we plan to enhance this component
-    to support inter and intra-op parallelism as well as multiple models
-    running in a single process.
+    to a single module provided, and several modules can be benchmarked at the
+    same time in one process with :meth:`benchmark_concurrently`. In the future
+    we plan to enhance this component to support inter and intra-op parallelism
+    as well.
 
     Please note that even though nn.Module is supported, it might incur an overhead
     from the need to hold GIL every time we execute Python code or pass around
@@ -89,7 +168,9 @@ class ThroughputBenchmark(object):
                 num_iters = 1000,
             )
         >>> print("Avg latency (ms): {}".format(stats.latency_avg_ms))
+        >>> print("p99 latency (ms): {}".format(stats.latency_p99_ms))
         >>> print("Number of iterations: {}".format(stats.num_iters))
+        >>> stats.to_json("bench_result.json")
 
     '''
 
@@ -117,7 +198,7 @@ class ThroughputBenchmark(object):
         '''
         self._benchmark.add_input(*args, **kwargs)
 
-    def benchmark(self, num_calling_threads=1, num_warmup_iters=10, num_iters=100):
+    def benchmark(self, num_calling_threads=1, num_warmup_iters=10, num_iters=100, target_qps=0.):
         '''
         Args:
             num_warmup_iters (int): Warmup iters are used to make sure we run a module
@@ -132,14 +213,37 @@ class ThroughputBenchmark(object):
                 iterations might be slightly larger. Which is reported as
                 stats.num_iters where stats is the result of this function
 
-        This function returns BenchmarkExecutionStats object which is defined via pybind11.
-        It currently has two fields:
+            target_qps (float): If positive, requests arrive as a Poisson process
+                with this many queries per second across all the calling threads
+                (open loop), and the latency of a request includes the time it
+                waited for a free calling thread. By default every thread issues
+                its next request as soon as the previous one is done (closed loop)
+
+        This function returns an ExecutionStats object wrapping the
+        BenchmarkExecutionStats object which is defined via pybind11. It has
+        the following fields:
             - num_iters - number of actual iterations the benchmark have made
-            - avg_latency_ms - average time it took to infer on one input example in milliseconds
+            - latency_avg_ms - average time it took to infer on one input example in milliseconds
+            - latency_p50_ms, latency_p90_ms, latency_p99_ms, latency_p999_ms -
+              latency percentiles in milliseconds
+            - thread_cpu_time_ms - CPU time of each calling thread in milliseconds
         '''
-        config = torch._C.BenchmarkConfig()
-        config.num_calling_threads = num_calling_threads
-        config.num_warmup_iters = num_warmup_iters
-        config.num_iters = num_iters
+        config = _make_config(num_calling_threads, num_warmup_iters, num_iters, target_qps)
         c_stats = self._benchmark.benchmark(config)
         return ExecutionStats(c_stats, config)
+
+    @staticmethod
+    def benchmark_concurrently(benchmarks, num_calling_threads=1, num_warmup_iters=10,
+                               num_iters=100, target_qps=0.):
+        '''
+        Runs the given ThroughputBenchmark objects at the same time in this
+        process, emulating several models served by one process. The arguments
+        are the same as for :meth:`benchmark` and are applied to every
+        benchmark; each of them gets its own calling threads. Returns a list with
+        an ExecutionStats object per benchmark.
+        '''
+        configs = [_make_config(num_calling_threads, num_warmup_iters, num_iters, target_qps)
+                   for _ in benchmarks]
+        c_stats = torch._C.ThroughputBenchmark.benchmark_concurrently(
+            [b._benchmark for b in benchmarks], configs)
+        return [ExecutionStats(s, config) for s, config in zip(c_stats, configs)]